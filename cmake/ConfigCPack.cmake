@@ -169,6 +169,9 @@ endif()
 if(OMNITRACE_USE_ROCPROFILER)
     list(APPEND _DEBIAN_PACKAGE_DEPENDS "rocprofiler-dev${_ROCPROFILER_SUFFIX}")
 endif()
+if(OMNITRACE_USE_ROCPROFILER_SDK)
+    list(APPEND _DEBIAN_PACKAGE_DEPENDS "rocprofiler-sdk" "comgr")
+endif()
 if(OMNITRACE_USE_MPI)
     if("${OMNITRACE_MPI_IMPL}" STREQUAL "openmpi")
         list(APPEND _DEBIAN_PACKAGE_DEPENDS "libopenmpi-dev")
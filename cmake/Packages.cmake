@@ -18,6 +18,8 @@ omnitrace_add_interface_library(omnitrace-roctracer
                                 "Provides flags and libraries for roctracer")
 omnitrace_add_interface_library(omnitrace-rocprofiler
                                 "Provides flags and libraries for rocprofiler")
+omnitrace_add_interface_library(omnitrace-rocprofiler-sdk
+                                "Provides flags and libraries for rocprofiler-sdk")
 omnitrace_add_interface_library(omnitrace-rocm-smi
                                 "Provides flags and libraries for rocm-smi")
 omnitrace_add_interface_library(
@@ -27,6 +29,8 @@ omnitrace_add_interface_library(omnitrace-bfd "Provides Binary File Descriptor (
 omnitrace_add_interface_library(omnitrace-ptl "Enables PTL support (tasking)")
 omnitrace_add_interface_library(omnitrace-papi "Enable PAPI support")
 omnitrace_add_interface_library(omnitrace-ompt "Enable OMPT support")
+omnitrace_add_interface_library(omnitrace-compression
+                                "Provides zlib and/or zstd for compressed output files")
 omnitrace_add_interface_library(omnitrace-python "Enables Python support")
 omnitrace_add_interface_library(omnitrace-elfutils "Provides ElfUtils")
 omnitrace_add_interface_library(omnitrace-perfetto "Enables Perfetto support")
@@ -40,6 +44,7 @@ set(OMNITRACE_EXTENSION_LIBRARIES
     omnitrace::omnitrace-hip
     omnitrace::omnitrace-roctracer
     omnitrace::omnitrace-rocprofiler
+    omnitrace::omnitrace-rocprofiler-sdk
     omnitrace::omnitrace-rocm-smi
     omnitrace::omnitrace-rccl
     omnitrace::omnitrace-bfd
@@ -47,6 +52,7 @@ set(OMNITRACE_EXTENSION_LIBRARIES
     omnitrace::omnitrace-ptl
     omnitrace::omnitrace-ompt
     omnitrace::omnitrace-papi
+    omnitrace::omnitrace-compression
     omnitrace::omnitrace-perfetto)
 
 target_include_directories(
@@ -119,6 +125,7 @@ endforeach()
 if(OMNITRACE_USE_HIP
    OR OMNITRACE_USE_ROCTRACER
    OR OMNITRACE_USE_ROCPROFILER
+   OR OMNITRACE_USE_ROCPROFILER_SDK
    OR OMNITRACE_USE_ROCM_SMI)
     find_package(ROCmVersion)
 
@@ -208,6 +215,23 @@ if(OMNITRACE_USE_ROCPROFILER)
     target_link_libraries(omnitrace-rocprofiler INTERFACE rocprofiler::rocprofiler)
 endif()
 
+# ----------------------------------------------------------------------------------------#
+#
+# rocprofiler-sdk
+#
+# ----------------------------------------------------------------------------------------#
+
+if(OMNITRACE_USE_ROCPROFILER_SDK)
+    # the PC sampling records and the configuration flags are in rocprofiler-sdk 0.6
+    # (ROCm 6.4). The sampled instructions are disassembled with amd_comgr
+    find_package(rocprofiler-sdk 0.6 ${omnitrace_FIND_QUIETLY} REQUIRED)
+    find_package(amd_comgr ${omnitrace_FIND_QUIETLY} REQUIRED)
+    omnitrace_target_compile_definitions(omnitrace-rocprofiler-sdk
+                                         INTERFACE OMNITRACE_USE_ROCPROFILER_SDK)
+    target_link_libraries(omnitrace-rocprofiler-sdk
+                          INTERFACE rocprofiler-sdk::rocprofiler-sdk amd_comgr)
+endif()
+
 # ----------------------------------------------------------------------------------------#
 #
 # rocm-smi
@@ -263,6 +287,35 @@ endif()
 omnitrace_target_compile_definitions(
     omnitrace-ompt INTERFACE OMNITRACE_USE_OMPT=$<BOOL:${OMNITRACE_USE_OMPT}>)
 
+# ----------------------------------------------------------------------------------------#
+#
+# Compression (zlib and zstd)
+#
+# ----------------------------------------------------------------------------------------#
+
+if(OMNITRACE_USE_ZLIB)
+    find_package(ZLIB ${omnitrace_FIND_QUIETLY} REQUIRED)
+    target_link_libraries(omnitrace-compression INTERFACE ZLIB::ZLIB)
+    omnitrace_target_compile_definitions(omnitrace-compression
+                                         INTERFACE OMNITRACE_USE_ZLIB)
+endif()
+
+if(OMNITRACE_USE_ZSTD)
+    find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+    find_library(ZSTD_LIBRARY NAMES zstd)
+    mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+    if(NOT ZSTD_INCLUDE_DIR OR NOT ZSTD_LIBRARY)
+        omnitrace_message(
+            FATAL_ERROR
+            "zstd not found. Set ZSTD_INCLUDE_DIR and ZSTD_LIBRARY or OMNITRACE_USE_ZSTD=OFF"
+            )
+    endif()
+    target_include_directories(omnitrace-compression SYSTEM INTERFACE ${ZSTD_INCLUDE_DIR})
+    target_link_libraries(omnitrace-compression INTERFACE ${ZSTD_LIBRARY})
+    omnitrace_target_compile_definitions(omnitrace-compression
+                                         INTERFACE OMNITRACE_USE_ZSTD)
+endif()
+
 # ----------------------------------------------------------------------------------------#
 #
 # ElfUtils
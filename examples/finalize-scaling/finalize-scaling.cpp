@@ -0,0 +1,82 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// spins each thread for a fixed duration so that the amount of data which is collected
+// (e.g. the number of samples per thread) and subsequently processed when the tool is
+// finalized is controlled by the number of threads and the duration
+
+std::atomic<long> total{ 0 };
+
+long
+fib(long n) __attribute__((noinline));
+
+void
+run(std::chrono::milliseconds, long) __attribute__((noinline));
+
+long
+fib(long n)
+{
+    return (n < 2) ? n : fib(n - 1) + fib(n - 2);
+}
+
+void
+run(std::chrono::milliseconds _duration, long n)
+{
+    using clock_type = std::chrono::steady_clock;
+
+    auto _end  = clock_type::now() + _duration;
+    long local = 0;
+    while(clock_type::now() < _end)
+        local += fib(n);
+    total += local;
+}
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    size_t nthread  = 4;
+    long   duration = 1000;
+    long   nfib     = 10;
+
+    if(argc > 1) nthread = atol(argv[1]);
+    if(argc > 2) duration = atol(argv[2]);
+    if(argc > 3) nfib = atol(argv[3]);
+
+    printf("\n[%s] Threads: %zu\n[%s] Duration: %li msec\n[%s] fibonacci(%li)...\n",
+           _name.c_str(), nthread, _name.c_str(), duration, _name.c_str(), nfib);
+
+    pthread_barrier_t _barrier;
+    pthread_barrier_init(&_barrier, nullptr, nthread);
+
+    // all the threads are alive at the same time
+    auto _run = [&_barrier](std::chrono::milliseconds _duration, long n) {
+        pthread_barrier_wait(&_barrier);
+        run(_duration, n);
+    };
+
+    std::vector<std::thread> threads{};
+    for(size_t i = 1; i < nthread; ++i)
+        threads.emplace_back(_run, std::chrono::milliseconds{ duration }, nfib);
+
+    _run(std::chrono::milliseconds{ duration }, nfib);
+
+    for(auto& itr : threads)
+        itr.join();
+
+    pthread_barrier_destroy(&_barrier);
+
+    printf("[%s] fibonacci(%li) total = %li\n", _name.c_str(), nfib,
+           static_cast<long>(total));
+
+    return 0;
+}
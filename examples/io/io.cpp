@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+// writes the file in blocks, syncs it and reads it back
+size_t
+run(int _idx, size_t _nblocks, size_t _block_size)
+{
+    auto _name = std::string{ "io-example-" } + std::to_string(getpid()) + "-" +
+                 std::to_string(_idx) + ".dat";
+    auto _buf  = std::vector<char>(_block_size, static_cast<char>('a' + (_idx % 26)));
+    auto _fd   = open(_name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if(_fd < 0)
+    {
+        perror("open");
+        return 0;
+    }
+
+    for(size_t i = 0; i < _nblocks; ++i)
+    {
+        if(i % 2 == 0)
+        {
+            if(write(_fd, _buf.data(), _buf.size()) < 0) perror("write");
+        }
+        else
+        {
+            struct iovec _iov[2] = { { _buf.data(), _buf.size() / 2 },
+                                     { _buf.data(), _buf.size() - _buf.size() / 2 } };
+            if(writev(_fd, _iov, 2) < 0) perror("writev");
+        }
+    }
+    fsync(_fd);
+
+    size_t _nread = 0;
+    for(size_t i = 0; i < _nblocks; ++i)
+    {
+        auto _ret = pread(_fd, _buf.data(), _buf.size(), i * _block_size);
+        if(_ret > 0) _nread += _ret;
+    }
+
+    close(_fd);
+    unlink(_name.c_str());
+    return _nread;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t _nthreads   = (argc > 1) ? std::stoul(argv[1]) : 2;
+    size_t _nblocks    = (argc > 2) ? std::stoul(argv[2]) : 256;
+    size_t _block_size = (argc > 3) ? std::stoul(argv[3]) : 65536;
+
+    auto _nread   = std::vector<size_t>(_nthreads, 0);
+    auto _threads = std::vector<std::thread>{};
+    for(size_t i = 0; i < _nthreads; ++i)
+        _threads.emplace_back(
+            [&, i]() { _nread.at(i) = run(i, _nblocks, _block_size); });
+    for(auto& itr : _threads)
+        itr.join();
+
+    size_t _total = 0;
+    for(auto itr : _nread)
+        _total += itr;
+    printf("[io-example] read %zu bytes in %zu threads\n", _total, _nthreads);
+
+    return (_total == _nthreads * _nblocks * _block_size) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2015-2020 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// launch-bound variant of the transpose example: every host thread enqueues a
+// transpose of a small matrix on its own stream as fast as possible (or at a fixed
+// interval) so the duration is dominated by the cost of each dispatch. The duration
+// of the launches is printed so tests/run-gpu-overhead-benchmark.py can compare it
+// with and without each GPU backend of omnitrace
+
+#include "hip/hip_runtime.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::mutex print_lock{};
+using auto_lock_t = std::unique_lock<std::mutex>;
+
+#define HIP_API_CALL(CALL)                                                               \
+    {                                                                                    \
+        hipError_t error_ = (CALL);                                                      \
+        if(error_ != hipSuccess)                                                         \
+        {                                                                                \
+            auto_lock_t _lk{ print_lock };                                               \
+            fprintf(stderr, "%s:%d :: HIP error : %s\n", __FILE__, __LINE__,             \
+                    hipGetErrorString(error_));                                          \
+            throw std::runtime_error("hip_api_call");                                    \
+        }                                                                                \
+    }
+
+const unsigned TILE_DIM = 32;
+__global__ void
+transpose_a(int* in, int* out, int M, int N)
+{
+    __shared__ int tile[TILE_DIM][TILE_DIM];
+
+    int idx = (blockIdx.y * blockDim.y + threadIdx.y) * M + blockIdx.x * blockDim.x +
+              threadIdx.x;
+    tile[threadIdx.y][threadIdx.x] = in[idx];
+    __syncthreads();
+    idx = (blockIdx.x * blockDim.x + threadIdx.y) * N + blockIdx.y * blockDim.y +
+          threadIdx.x;
+    out[idx] = tile[threadIdx.x][threadIdx.y];
+}
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+unsigned int        nelem     = 32;  // rows and columns of the matrix
+size_t              nstreams  = 1;
+size_t              nlaunch   = 10000;  // per stream
+size_t              ninterval = 0;      // usec between the launches of a stream
+size_t              nwarmup   = 10;
+std::atomic<size_t> ready     = { 0 };
+std::atomic<bool>   start     = { false };
+}  // namespace
+
+void
+run(hipStream_t stream)
+{
+    size_t size = sizeof(int) * nelem * nelem;
+    int*   in   = nullptr;
+    int*   out  = nullptr;
+
+    HIP_API_CALL(hipMalloc(&in, size));
+    HIP_API_CALL(hipMalloc(&out, size));
+    HIP_API_CALL(hipMemsetAsync(in, 0, size, stream));
+
+    dim3 grid(nelem / TILE_DIM, nelem / TILE_DIM, 1);
+    dim3 block(TILE_DIM, TILE_DIM, 1);
+
+    for(size_t i = 0; i < nwarmup; ++i)
+        transpose_a<<<grid, block, 0, stream>>>(in, out, nelem, nelem);
+    HIP_API_CALL(hipStreamSynchronize(stream));
+
+    ready.fetch_add(1, std::memory_order_release);
+    while(!start.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    auto _interval = std::chrono::microseconds{ ninterval };
+    auto _next     = clock_type::now();
+    for(size_t i = 0; i < nlaunch; ++i)
+    {
+        transpose_a<<<grid, block, 0, stream>>>(in, out, nelem, nelem);
+        HIP_API_CALL(hipGetLastError());
+        if(ninterval > 0)
+        {
+            _next += _interval;
+            while(clock_type::now() < _next)
+            {}
+        }
+    }
+    HIP_API_CALL(hipStreamSynchronize(stream));
+
+    HIP_API_CALL(hipFree(in));
+    HIP_API_CALL(hipFree(out));
+}
+
+int
+main(int argc, char** argv)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        auto _arg = std::string{ argv[i] };
+        if(_arg == "?" || _arg == "-h" || _arg == "--help")
+        {
+            fprintf(stderr,
+                    "usage: transpose-benchmark [NUM_ELEMENTS (%u)] [NUM_STREAMS (%zu)] "
+                    "[NUM_LAUNCHES_PER_STREAM (%zu)] [LAUNCH_INTERVAL_USEC (%zu)]\n",
+                    nelem, nstreams, nlaunch, ninterval);
+            exit(EXIT_SUCCESS);
+        }
+    }
+    if(argc > 1) nelem = atoll(argv[1]);
+    if(argc > 2) nstreams = atoll(argv[2]);
+    if(argc > 3) nlaunch = atoll(argv[3]);
+    if(argc > 4) ninterval = atoll(argv[4]);
+
+    // the matrix is a whole number of tiles
+    nelem    = ((nelem + TILE_DIM - 1) / TILE_DIM) * TILE_DIM;
+    nstreams = (nstreams == 0) ? 1 : nstreams;
+
+    printf("[transpose-benchmark] Number of elements: %u x %u\n", nelem, nelem);
+    printf("[transpose-benchmark] Number of streams: %zu\n", nstreams);
+    printf("[transpose-benchmark] Number of launches per stream: %zu\n", nlaunch);
+    printf("[transpose-benchmark] Launch interval: %zu usec\n", ninterval);
+
+    int ndevice = 0;
+    HIP_API_CALL(hipGetDeviceCount(&ndevice));
+    if(ndevice == 0)
+    {
+        fprintf(stderr, "[transpose-benchmark] No devices found\n");
+        return EXIT_FAILURE;
+    }
+    HIP_API_CALL(hipSetDevice(0));
+
+    std::vector<std::thread> _threads{};
+    std::vector<hipStream_t> _streams(nstreams);
+    for(size_t i = 0; i < nstreams; ++i)
+        HIP_API_CALL(hipStreamCreate(&_streams.at(i)));
+    for(size_t i = 0; i < nstreams; ++i)
+        _threads.emplace_back(run, _streams.at(i));
+
+    // the launches start when every thread finished its warm-up
+    while(ready.load(std::memory_order_acquire) < nstreams)
+        std::this_thread::yield();
+
+    auto _beg = clock_type::now();
+    start.store(true, std::memory_order_release);
+    for(auto& itr : _threads)
+        itr.join();
+    HIP_API_CALL(hipDeviceSynchronize());
+    auto _end = clock_type::now();
+
+    for(size_t i = 0; i < nstreams; ++i)
+        HIP_API_CALL(hipStreamDestroy(_streams.at(i)));
+    HIP_API_CALL(hipDeviceReset());
+
+    auto _elapsed =
+        std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(_end - _beg)
+            .count();
+    auto _ndispatch = nstreams * nlaunch;
+    printf("[transpose-benchmark] Dispatches: %zu, elapsed: %.0f nsec, per dispatch: "
+           "%.1f nsec\n",
+           _ndispatch, _elapsed, (_ndispatch > 0) ? _elapsed / _ndispatch : 0.0);
+
+    return 0;
+}
@@ -28,6 +28,7 @@ namespace
 {
 omnitrace_user_callbacks_t custom_callbacks   = OMNITRACE_USER_CALLBACKS_INIT;
 omnitrace_user_callbacks_t original_callbacks = OMNITRACE_USER_CALLBACKS_INIT;
+uint64_t                   partial_sum_id     = 0;
 }  // namespace
 
 int
@@ -45,6 +46,8 @@ main(int argc, char** argv)
     if(argc > 1) nfib = atol(argv[1]);
     if(argc > 2) nthread = atol(argv[2]);
     if(argc > 3) nitr = atol(argv[3]);
+    // the counter is registered before the threads record it
+    omnitrace_user_counter_register("partial_sum", nullptr, &partial_sum_id);
     omnitrace_user_pop_region("initialization");
 
     printf("[%s] Threads: %zu\n[%s] Iterations: %zu\n[%s] fibonacci(%li)...\n", argv[0],
@@ -63,10 +66,14 @@ main(int argc, char** argv)
     omnitrace_user_start_thread_trace();
     omnitrace_user_pop_region("thread_creation");
 
-    omnitrace_user_push_region("thread_wait");
+    // pre-register the region so push/pop via the handle avoid any string work
+    uint64_t thread_wait_id = 0;
+    omnitrace_user_register_region("thread_wait", &thread_wait_id);
+
+    omnitrace_user_push_region_id(thread_wait_id);
     for(auto& itr : threads)
         itr.join();
-    omnitrace_user_pop_region("thread_wait");
+    omnitrace_user_pop_region_id(thread_wait_id);
 
     run(nitr, nfib);
 
@@ -93,7 +100,10 @@ run(size_t nitr, long n)
     omnitrace_user_push_region(RUN_LABEL);
     long local = 0;
     for(size_t i = 0; i < nitr; ++i)
+    {
         local += fib(n);
+        omnitrace_user_counter_record(partial_sum_id, static_cast<double>(local));
+    }
     total += local;
     omnitrace_user_pop_region(RUN_LABEL);
 }
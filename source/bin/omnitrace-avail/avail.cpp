@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include "avail.hpp"
+#include "calibrate.hpp"
 #include "common.hpp"
 #include "common/defines.h"
 #include "component_categories.hpp"
@@ -432,8 +433,9 @@ main(int argc, char** argv)
 
     parser.start_group("OUTPUT");
 
-    std::string           _config_file = {};
-    std::set<std::string> _config_fmts = {};
+    std::string           _config_file      = {};
+    std::set<std::string> _config_fmts      = {};
+    std::string           _calibration_file = {};
 
     parser
         .add_argument({ "-G", "--generate-config" },
@@ -452,6 +454,19 @@ main(int argc, char** argv)
                 if(get_bool(_config_file, false) && !_out.empty()) _config_file = _out;
             }
         });
+    parser
+        .add_argument({ "--calibrate" },
+                      "Measure the cost of the hot operation of each backend on this "
+                      "node and write it to a calibration file (see "
+                      "OMNITRACE_CALIBRATION_FILE)")
+        .max_count(1)
+        .dtype("filename")
+        .set_default(std::string{ "omnitrace-calibration.json" })
+        .action([&_calibration_file](parser_t& _p) {
+            _calibration_file = _p.get<std::string>("calibrate");
+            if(get_bool(_calibration_file, false))
+                _calibration_file = "omnitrace-calibration.json";
+        });
     parser.add_argument({ "-F", "--config-format" }, "Configuration file format")
         .min_count(1)
         .max_count(3)
@@ -562,6 +577,19 @@ main(int argc, char** argv)
         return EXIT_SUCCESS;
     }
 
+    if(parser.exists("calibrate"))
+    {
+        try
+        {
+            calibrate(_calibration_file, calibration_iterations);
+        } catch(std::runtime_error& _e)
+        {
+            std::cerr << "[omnitrace-avail] " << _e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     if(parser.exists("markdown") && parser.exists("csv"))
     {
         std::cerr << "Error! both '--markdown' and '--csv' options cannot be specified\n";
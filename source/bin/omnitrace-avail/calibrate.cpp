@@ -0,0 +1,575 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "calibrate.hpp"
+#include "common.hpp"
+#include "defines.hpp"
+
+#include "core/calibration.hpp"
+#include "core/config.hpp"
+#include "core/gpu.hpp"
+#include "core/hip_runtime.hpp"
+#include "core/perf.hpp"
+#include "library/components/backtrace.hpp"
+#include "library/frame_pointer.hpp"
+#include "library/perf.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+#    include <roctracer.h>
+#    include <roctracer_hip.h>
+#endif
+
+#include <timemory/backends/papi.hpp>
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/components/gotcha/components.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/utility/backtrace.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/variadic/lightweight_tuple.hpp>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <linux/perf_event.h>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace
+{
+using clock_type    = std::chrono::steady_clock;
+using runner_t      = std::function<void(size_t)>;
+using make_runner_t = std::function<runner_t()>;
+
+constexpr size_t num_rounds  = 5;
+constexpr size_t stack_depth = component::backtrace::stack_depth;
+
+struct benchmark
+{
+    std::string           name        = {};
+    std::string           description = {};
+    std::function<bool()> available   = []() { return true; };
+    make_runner_t         make        = {};  // the resources are released with the runner
+    make_runner_t         baseline    = {};  // subtracted from the cost when set
+};
+
+// releases the resources of a runner, e.g. the gotcha wrapper, when the last copy of the
+// runner is destroyed
+struct scoped_teardown
+{
+    explicit scoped_teardown(std::function<void()>&& _v)
+    : func{ std::move(_v) }
+    {}
+
+    ~scoped_teardown()
+    {
+        if(func) func();
+    }
+
+    scoped_teardown(const scoped_teardown&) = delete;
+    scoped_teardown& operator=(const scoped_teardown&) = delete;
+
+    std::function<void()> func = {};
+};
+
+auto
+make_teardown(std::function<void()>&& _v)
+{
+    return std::make_shared<scoped_teardown>(std::move(_v));
+}
+
+// prevents the compiler from discarding the results
+std::atomic<uint64_t> sink = { 0 };
+
+//--------------------------------------------------------------------------------------//
+//
+//  the signal handler which unwinds the call-stack like the sampler
+//
+//--------------------------------------------------------------------------------------//
+
+enum class unwind_mode : int
+{
+    none = 0,
+    libunwind,
+    frame_pointer,
+};
+
+std::atomic<unwind_mode> handler_mode  = { unwind_mode::none };
+std::atomic<size_t>      handler_depth = { 0 };
+
+void
+signal_handler(int _signo, siginfo_t*, void* _ucontext)
+{
+    auto   _errno = errno;
+    size_t _n     = 0;
+    switch(handler_mode.load(std::memory_order_relaxed))
+    {
+        case unwind_mode::none: break;
+        case unwind_mode::libunwind:
+        {
+            for(auto itr : tim::get_unw_stack_raw<stack_depth, 0>())
+            {
+                if(itr == 0) break;
+                ++_n;
+            }
+            break;
+        }
+        case unwind_mode::frame_pointer:
+        {
+            uintptr_t _buffer[stack_depth];
+            _n = frame_pointer::unwind(_buffer, stack_depth, _signo, _ucontext);
+            break;
+        }
+    }
+    handler_depth.store(_n, std::memory_order_relaxed);
+    errno = _errno;
+}
+
+void
+raise_signal(int _signo)
+{
+    static thread_local auto _tid = ::syscall(SYS_gettid);
+    ::syscall(SYS_tgkill, getpid(), _tid, _signo);
+}
+
+// adds frames below the benchmark so the call-stack is at least the given depth. The
+// addition after the call prevents the tail-call optimization
+TIMEMORY_NOINLINE size_t
+at_depth(size_t _depth, const runner_t& _func, size_t _n)
+{
+    if(_depth <= 1) return (_func(_n), 0);
+    return at_depth(_depth - 1, _func, _n) + 1;
+}
+
+make_runner_t
+make_sample_runner(unwind_mode _mode, size_t _depth)
+{
+    return [_mode, _depth]() -> runner_t {
+        return [_mode, _depth](size_t _n) {
+            auto _signo = get_sampling_cputime_signal();
+            auto _raise = [_signo](size_t _v) {
+                for(size_t i = 0; i < _v; ++i)
+                    raise_signal(_signo);
+            };
+            handler_mode.store(_mode);
+            sink += at_depth(_depth, _raise, _n);
+            handler_mode.store(unwind_mode::none);
+        };
+    };
+}
+
+// the frame pointers are not always available, e.g. when the C library or this
+// executable are compiled without them, in which case the chain is shorter than the
+// depth of the benchmark
+bool
+has_frame_pointers(size_t _depth)
+{
+    make_sample_runner(unwind_mode::frame_pointer, _depth)()(1);
+    return handler_depth.load() >= _depth;
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//  perf and PAPI counters
+//
+//--------------------------------------------------------------------------------------//
+
+std::shared_ptr<perf::perf_event>
+open_perf_event()
+{
+    auto _pe = perf_event_attr{};
+    memset(&_pe, 0, sizeof(_pe));
+    perf::config_event(_pe, "PERF_COUNT_HW_INSTRUCTIONS");
+    _pe.exclude_kernel = 1;
+    _pe.exclude_hv     = 1;
+
+    auto _event = std::make_shared<perf::perf_event>();
+    if(_event->open(_pe) || !_event->start()) return nullptr;
+    return _event;
+}
+
+#if defined(TIMEMORY_USE_PAPI) && TIMEMORY_USE_PAPI > 0
+// returns PAPI_NULL if the event set cannot be started
+int
+start_papi_eventset()
+{
+    if(PAPI_is_initialized() == PAPI_NOT_INITED &&
+       PAPI_library_init(PAPI_VER_CURRENT) != PAPI_VER_CURRENT)
+        return PAPI_NULL;
+
+    int _evtset = PAPI_NULL;
+    if(PAPI_create_eventset(&_evtset) != PAPI_OK) return PAPI_NULL;
+    if(PAPI_add_event(_evtset, PAPI_TOT_INS) == PAPI_OK && PAPI_start(_evtset) == PAPI_OK)
+        return _evtset;
+
+    PAPI_cleanup_eventset(_evtset);
+    PAPI_destroy_eventset(&_evtset);
+    return PAPI_NULL;
+}
+
+void
+stop_papi_eventset(int _evtset)
+{
+    if(_evtset == PAPI_NULL) return;
+
+    long long _value = 0;
+    PAPI_stop(_evtset, &_value);
+    PAPI_cleanup_eventset(_evtset);
+    PAPI_destroy_eventset(&_evtset);
+}
+#endif
+
+//--------------------------------------------------------------------------------------//
+//
+//  gotcha wrapper around getppid
+//
+//--------------------------------------------------------------------------------------//
+
+struct calibrate_gotcha : tim::component::base<calibrate_gotcha, void>
+{
+    using gotcha_data = tim::component::gotcha_data;
+    using getppid_t   = pid_t (*)();
+
+    static std::string label() { return "calibrate_gotcha"; }
+
+    static auto& count()
+    {
+        static auto _v = std::atomic<size_t>{ 0 };
+        return _v;
+    }
+
+    pid_t operator()(const gotcha_data&, getppid_t _func) const
+    {
+        count().fetch_add(1, std::memory_order_relaxed);
+        return (*_func)();
+    }
+};
+
+using calibrate_gotcha_t = tim::component::gotcha<1, std::tuple<>, calibrate_gotcha>;
+using calibrate_bundle_t = tim::lightweight_tuple<calibrate_gotcha_t>;
+
+// the wrapper is active while the bundle is started
+std::shared_ptr<scoped_teardown>
+start_gotcha()
+{
+    auto _bundle = std::make_shared<calibrate_bundle_t>("omnitrace-avail-calibrate");
+    _bundle->start();
+    return make_teardown([_bundle]() { _bundle->stop(); });
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//  HIP API callback of roctracer
+//
+//--------------------------------------------------------------------------------------//
+
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+std::atomic<size_t> hip_callback_count = { 0 };
+
+void
+hip_api_callback(uint32_t, uint32_t, const void*, void*)
+{
+    hip_callback_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::shared_ptr<scoped_teardown>
+start_hip_callback()
+{
+    roctracer_enable_op_callback(ACTIVITY_DOMAIN_HIP_API, HIP_API_ID_hipGetDevice,
+                                 hip_api_callback, nullptr);
+    return make_teardown([]() {
+        roctracer_disable_op_callback(ACTIVITY_DOMAIN_HIP_API, HIP_API_ID_hipGetDevice);
+    });
+}
+
+runner_t
+make_hip_runner()
+{
+    return [](size_t _n) {
+        auto _dev = int{ 0 };
+        for(size_t i = 0; i < _n; ++i)
+            sink += (hipGetDevice(&_dev) == hipSuccess) ? _dev : 0;
+    };
+}
+#endif
+
+//--------------------------------------------------------------------------------------//
+
+runner_t
+make_getppid_runner()
+{
+    return [](size_t _n) {
+        for(size_t i = 0; i < _n; ++i)
+            sink += getppid();
+    };
+}
+
+std::vector<benchmark>
+get_benchmarks()
+{
+    auto _v = std::vector<benchmark>{};
+
+    _v.emplace_back(benchmark{
+        "region", "timemory call-graph entry of a region (push and pop)",
+        []() {
+            return get_use_timemory() &&
+                   !tracing::category_push_disabled<category::host>();
+        },
+        []() -> runner_t {
+            auto _hash = tim::add_hash_id("omnitrace-avail-calibrate");
+            return [_hash](size_t _n) {
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    tracing::push_timemory(category::host{}, _hash);
+                    tracing::pop_timemory(category::host{}, _hash);
+                }
+            };
+        } });
+
+    _v.emplace_back(benchmark{ "signal", "delivery of a timer signal to the thread",
+                               []() { return true; },
+                               []() -> runner_t {
+                                   return [](size_t _n) {
+                                       auto _signo = get_sampling_cputime_signal();
+                                       for(size_t i = 0; i < _n; ++i)
+                                           raise_signal(_signo);
+                                   };
+                               } });
+
+    for(size_t _depth : { 8, 16, 32, 64 })
+    {
+        if(_depth > stack_depth) continue;
+
+        _v.emplace_back(benchmark{
+            calibration::get_sample_name(SamplingUnwinder::LibUnwind, _depth),
+            "unwinding a call-stack with libunwind in the signal handler",
+            []() { return true; }, make_sample_runner(unwind_mode::libunwind, _depth),
+            make_sample_runner(unwind_mode::none, _depth) });
+
+        _v.emplace_back(benchmark{
+            calibration::get_sample_name(SamplingUnwinder::FramePointer, _depth),
+            "unwinding a call-stack with the frame pointers in the signal handler",
+            [_depth]() { return has_frame_pointers(_depth); },
+            make_sample_runner(unwind_mode::frame_pointer, _depth),
+            make_sample_runner(unwind_mode::none, _depth) });
+    }
+
+    _v.emplace_back(benchmark{ "perf-read",
+                               "read of a perf event counter (rdpmc when permitted)",
+                               []() { return open_perf_event() != nullptr; },
+                               []() -> runner_t {
+                                   auto _event = open_perf_event();
+                                   return [_event](size_t _n) {
+                                       for(size_t i = 0; i < _n; ++i)
+                                           sink += _event->read_count();
+                                   };
+                               } });
+
+#if defined(TIMEMORY_USE_PAPI) && TIMEMORY_USE_PAPI > 0
+    _v.emplace_back(benchmark{
+        "papi-read", "read of a PAPI event set with PAPI_TOT_INS",
+        []() {
+            auto _evtset = start_papi_eventset();
+            stop_papi_eventset(_evtset);
+            return _evtset != PAPI_NULL;
+        },
+        []() -> runner_t {
+            auto _evtset   = start_papi_eventset();
+            auto _teardown = make_teardown([_evtset]() { stop_papi_eventset(_evtset); });
+            return [_evtset, _teardown](size_t _n) {
+                long long _value = 0;
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    PAPI_read(_evtset, &_value);
+                    sink += static_cast<uint64_t>(_value);
+                }
+            };
+        } });
+#endif
+
+    _v.emplace_back(benchmark{
+        "gotcha", "dispatch of a function call through a gotcha wrapper",
+        []() {
+            auto _count = calibrate_gotcha::count().load();
+            {
+                auto _wrapper = start_gotcha();
+                sink += getppid();
+            }
+            return calibrate_gotcha::count().load() > _count;
+        },
+        []() -> runner_t {
+            auto _wrapper = start_gotcha();
+            auto _runner  = make_getppid_runner();
+            return [_wrapper, _runner](size_t _n) { _runner(_n); };
+        },
+        []() -> runner_t { return make_getppid_runner(); } });
+
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    _v.emplace_back(benchmark{
+        "hip-api-callback", "dispatch of a HIP API call to a roctracer callback",
+        []() {
+            if(gpu::hip_device_count() == 0) return false;
+            auto _count = hip_callback_count.load();
+            {
+                auto _callback = start_hip_callback();
+                make_hip_runner()(1);
+            }
+            return hip_callback_count.load() > _count;
+        },
+        []() -> runner_t {
+            auto _callback = start_hip_callback();
+            auto _runner   = make_hip_runner();
+            return [_callback, _runner](size_t _n) { _runner(_n); };
+        },
+        []() -> runner_t { return make_hip_runner(); } });
+#endif
+
+    return _v;
+}
+
+// nsec per operation of each round
+std::vector<double>
+run_rounds(const make_runner_t& _make, size_t _iterations)
+{
+    auto _runner = _make();
+    _runner(std::max<size_t>(_iterations / 10, 1));
+
+    auto _v = std::vector<double>{};
+    for(size_t i = 0; i < num_rounds; ++i)
+    {
+        auto _beg = clock_type::now();
+        _runner(_iterations);
+        auto _end = clock_type::now();
+        _v.emplace_back(std::chrono::duration<double, std::nano>(_end - _beg).count() /
+                        _iterations);
+    }
+    return _v;
+}
+
+// the baseline is measured first since the resources of the benchmark, e.g. the gotcha
+// wrapper, would affect it
+calibration::entry
+run(const benchmark& _bench, size_t _iterations)
+{
+    auto _baseline = (_bench.baseline) ? run_rounds(_bench.baseline, _iterations)
+                                       : std::vector<double>(num_rounds, 0.0);
+    auto _rounds   = run_rounds(_bench.make, _iterations);
+
+    auto _mean = [](const std::vector<double>& _v) {
+        auto _sum = 0.0;
+        for(auto itr : _v)
+            _sum += itr;
+        return _sum / _v.size();
+    };
+
+    auto _min = [](const std::vector<double>& _v) {
+        return *std::min_element(_v.begin(), _v.end());
+    };
+
+    auto _v        = calibration::entry{};
+    _v.name        = _bench.name;
+    _v.description = _bench.description;
+    _v.mean        = std::max(_mean(_rounds) - _mean(_baseline), 0.0);
+    _v.min         = std::max(_min(_rounds) - _min(_baseline), 0.0);
+    _v.count       = _iterations;
+    return _v;
+}
+}  // namespace
+}  // namespace omnitrace
+
+void
+calibrate(const std::string& _fname, size_t _iterations)
+{
+    namespace calibration = ::omnitrace::calibration;
+
+    // the regions are not written to the timemory output
+    settings::auto_output() = false;
+
+    omnitrace::thread_info::init();
+    omnitrace::frame_pointer::configure_thread();
+    omnitrace::calibrate_gotcha_t::get_initializer() = []() {
+        omnitrace::calibrate_gotcha_t::configure<0, pid_t>("getppid");
+    };
+
+    auto             _signo  = omnitrace::get_sampling_cputime_signal();
+    struct sigaction _former = {};
+    struct sigaction _action = {};
+    sigemptyset(&_action.sa_mask);
+    _action.sa_flags     = SA_RESTART | SA_SIGINFO;
+    _action.sa_sigaction = &omnitrace::signal_handler;
+    if(sigaction(_signo, &_action, &_former) != 0)
+        throw std::runtime_error(TIMEMORY_JOIN(" ", "Error installing the handler of",
+                                               "signal", _signo, ":", strerror(errno)));
+
+    auto _data      = calibration::data{};
+    _data.hostname  = calibration::get_hostname();
+    _data.timestamp = static_cast<int64_t>(std::time(nullptr));
+
+    for(const auto& itr : omnitrace::get_benchmarks())
+    {
+        if(!itr.available())
+        {
+            verbprintf(1, "Skipping '%s' :: not available\n", itr.name.c_str());
+            continue;
+        }
+
+        verbprintf(1, "Calibrating '%s'...\n", itr.name.c_str());
+        auto _entry = omnitrace::run(itr, _iterations);
+        printf("[omnitrace-avail] %-24s %10.1f nsec (min: %10.1f nsec) :: %s\n",
+               _entry.name.c_str(), _entry.mean, _entry.min, _entry.description.c_str());
+        _data.entries.emplace_back(std::move(_entry));
+    }
+
+    sigaction(_signo, &_former, nullptr);
+
+    auto _freq     = omnitrace::get_sampling_cputime_freq();
+    auto _unwinder = omnitrace::config::get_snapshot().sampling_unwinder;
+    if(auto _overhead = calibration::get_sampling_overhead(_data, _unwinder, _freq))
+    {
+        printf("[omnitrace-avail] estimated sampling overhead at %.1f interrupts/sec: "
+               "%.3f%%\n",
+               _freq, *_overhead);
+    }
+
+    if(settings::verbose() >= 0)
+        printf("[omnitrace-avail] Outputting calibration file '%s'...\n",
+               _fname.c_str());
+    calibration::write(_data, _fname);
+}
@@ -39,12 +39,15 @@
 #include <timemory/utility/join.hpp>
 
 #include <array>
+#include <cerrno>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <dirent.h>
+#include <fstream>
 #include <gnu/lib-names.h>
 #include <iostream>
 #include <regex>
@@ -77,11 +80,44 @@ to_string(bool _v)
 
 namespace
 {
-int  verbose       = 0;
-auto updated_envs  = std::set<std::string_view>{};
-auto original_envs = std::set<std::string>{};
-auto child_pids    = std::set<pid_t>{};
-auto launcher      = std::string{};
+int    verbose            = 0;
+auto   updated_envs       = std::set<std::string_view>{};
+auto   original_envs      = std::set<std::string>{};
+auto   child_pids         = std::set<pid_t>{};
+auto   launcher           = std::string{};
+int    num_jobs           = 1;
+size_t runs_per_iteration = 1;
+
+// the folder where the runs write the status of the adaptive selection (see
+// --converge). The folder is removed when omnitrace-causal exits
+struct convergence_status
+{
+    std::string directory = {};
+
+    ~convergence_status()
+    {
+        if(directory.empty()) return;
+        for(const auto& itr : get_files())
+            unlink(itr.c_str());
+        rmdir(directory.c_str());
+    }
+
+    std::vector<std::string> get_files() const
+    {
+        auto  _v   = std::vector<std::string>{};
+        auto* _dir = opendir(directory.c_str());
+        if(!_dir) return _v;
+        while(auto* _entry = readdir(_dir))
+        {
+            if(std::string_view{ _entry->d_name }.find("status") == 0)
+                _v.emplace_back(join("/", directory, _entry->d_name));
+        }
+        closedir(_dir);
+        return _v;
+    }
+};
+
+auto convergence = convergence_status{};
 
 inline signal_handler&
 get_signal_handler(int _sig)
@@ -129,6 +165,66 @@ get_verbose()
     return verbose;
 }
 
+int
+get_num_jobs()
+{
+    return std::max(num_jobs, 1);
+}
+
+size_t
+get_runs_per_iteration()
+{
+    return std::max<size_t>(runs_per_iteration, 1);
+}
+
+bool
+is_converged()
+{
+    if(convergence.directory.empty()) return false;
+
+    // each worker of the last run wrote a status file. The files are consumed so that
+    // the next check only uses the status of the next runs
+    size_t _files      = 0;
+    size_t _selections = 0;
+    size_t _converged  = 0;
+    double _max_width  = 0.0;
+    for(const auto& itr : convergence.get_files())
+    {
+        auto _ifs = std::ifstream{ itr };
+        auto _key = std::string{};
+        auto _val = double{ 0.0 };
+        while(_ifs >> _key >> _val)
+        {
+            if(_key == "selections")
+                _selections += static_cast<size_t>(_val);
+            else if(_key == "converged")
+                _converged += static_cast<size_t>(_val);
+            else if(_key == "max_half_width")
+                _max_width = std::max(_max_width, _val);
+        }
+        unlink(itr.c_str());
+        ++_files;
+    }
+
+    if(_files == 0)
+    {
+        TIMEMORY_PRINTF_WARNING(stderr,
+                                "no status of the adaptive selection was written by the "
+                                "last run. Convergence cannot be checked...\n");
+        return false;
+    }
+
+    if(verbose >= 1)
+    {
+        TIMEMORY_PRINTF_INFO(stderr,
+                             "%zu of %zu lines/functions have converged (widest 95%% "
+                             "confidence interval: +/- %.4f)...\n",
+                             _converged, _selections, _max_width);
+    }
+
+    return (_selections > 0 && _converged == _selections);
+}
+
 void
 forward_signals(const std::set<int>& _signals)
 {
@@ -541,10 +637,11 @@ parse_args(int argc, char** argv, std::vector<char*>& _env,
                       "Causal profiling mode. Function mode tends to resolve statistics "
                       "faster than line mode (due to smaller sampling space). Ideally, "
                       "use function mode first to identify a function to target and then "
-                      "switch to line mode + function scope setting")
+                      "switch to line mode + function scope setting. Kernel mode "
+                      "virtually speeds up the GPU kernels (requires roctracer)")
         .count(1)
         .dtype("string")
-        .choices({ "function", "line" })
+        .choices({ "function", "line", "kernel" })
         .choice_alias("function", { "func" })
         .action([&](parser_t& p) {
             update_env(_env, "OMNITRACE_CAUSAL_MODE", p.get<std::string>("mode"));
@@ -624,6 +721,46 @@ parse_args(int argc, char** argv, std::vector<char*>& _env,
         .dtype("int")
         .action([&](parser_t& p) { _niterations = p.get<int64_t>("iterations"); });
 
+    parser
+        .add_argument(
+            { "-j", "--jobs" },
+            "Number of concurrent workers for each run configuration. The workers share "
+            "the causal experiments: each worker evaluates a different subset of the "
+            "virtual speedups and lines and the results are merged into a single causal "
+            "output file. Within MPI applications, every rank is also a separate worker")
+        .count(1)
+        .dtype("int")
+        .action([&](parser_t& p) { num_jobs = p.get<int>("jobs"); });
+
+    parser
+        .add_argument(
+            { "--converge" },
+            "Enable the adaptive selection of the experiments "
+            "(OMNITRACE_CAUSAL_ADAPTIVE) and stop launching runs once the impact "
+            "estimate of every line/function has converged, i.e. the number of "
+            "iterations (-n) is the maximum. The convergence is checked after each "
+            "iteration over the run configurations. The optional value is the tolerance "
+            "of the half-width of the 95% confidence interval of the impact "
+            "(OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE)")
+        .min_count(0)
+        .max_count(1)
+        .dtype("tolerance")
+        .action([&](parser_t& p) {
+            auto _tol = p.get<std::string>("converge");
+            update_env(_env, "OMNITRACE_CAUSAL_ADAPTIVE", true);
+            if(!_tol.empty())
+                update_env(_env, "OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE", std::stod(_tol));
+
+            auto _dir = std::string{ "/tmp/omnitrace-causal-XXXXXX" };
+            if(!mkdtemp(_dir.data()))
+                throw std::runtime_error(
+                    join("", "omnitrace-causal was unable to create ", _dir, ": ",
+                         strerror(errno)));
+            convergence.directory = _dir;
+            update_env(_env, "OMNITRACE_CAUSAL_ADAPTIVE_STATUS",
+                       join("/", _dir, "status"));
+        });
+
     parser.start_group(
         "CAUSAL PROFILING OPTIONS (Combinatorial)",
         "Each individual argument to these options will multiply the number runs by the "
@@ -844,6 +981,7 @@ parse_args(int argc, char** argv, std::vector<char*>& _env,
 
     // make sure at least one env exists
     if(_causal_envs_tmp.empty()) _causal_envs_tmp.emplace_back();
+    runs_per_iteration = _causal_envs_tmp.size();
 
     // duplicate for the number of iterations
     _causal_envs.clear();
@@ -854,6 +992,14 @@ parse_args(int argc, char** argv, std::vector<char*>& _env,
             _causal_envs.emplace_back(itr);
     }
 
+    // a single run has nothing to stop
+    if(!convergence.directory.empty() && _causal_envs.size() == 1)
+    {
+        remove_env(_env, "OMNITRACE_CAUSAL_ADAPTIVE_STATUS");
+        rmdir(convergence.directory.c_str());
+        convergence.directory.clear();
+    }
+
     if(_generate_configs)
     {
         auto _is_omni_cfg = [](std::string_view itr) {
@@ -29,8 +29,10 @@
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <random>
 #include <sstream>
 #include <string_view>
+#include <vector>
 #include <unistd.h>
 
 int
@@ -80,7 +82,8 @@ main(int argc, char** argv)
 
     if(!_argv.empty())
     {
-        if(_causal_env.size() == 1)
+        auto _njobs = static_cast<size_t>(get_num_jobs());
+        if(_causal_env.size() == 1 && _njobs == 1)
         {
             auto _env = _base_env;
             for(const auto& eitr : _causal_env.front())
@@ -92,44 +95,83 @@ main(int argc, char** argv)
             return execvpe(_argv.front(), _argv.data(), _env.data());
         }
 
+        // the workers of a run must sample the speedups from the same random sequence
+        bool _has_seed = std::any_of(_base_env.begin(), _base_env.end(), [](char* itr) {
+            return std::string_view{ itr }.find("OMNITRACE_CAUSAL_RANDOM_SEED=") == 0;
+        });
+        auto _rng = std::random_device{};
+
         forward_signals({ SIGINT, SIGTERM, SIGQUIT });
         size_t _ncount = 0;
         size_t _width  = std::log10(_causal_env.size()) + 1;
         for(auto& citr : _causal_env)
         {
-            auto _n        = _ncount++;
-            auto _main_pid = getpid();
-            auto _pid      = fork();
-
-            if(get_verbose() >= 3)
+            auto       _n        = _ncount++;
+            auto       _main_pid = getpid();
+            auto       _pids     = std::vector<pid_t>{};
+            const auto _seed     = std::to_string((uint64_t{ _rng() } << 32) | _rng());
+            for(size_t j = 0; j < _njobs; ++j)
             {
-                TIMEMORY_PRINTF_INFO(stderr, "process %i returned %i from fork...\n",
-                                     getpid(), _pid);
-            }
+                auto _pid = fork();
 
-            if(_pid == 0)
-            {
-                auto _prefix = std::stringstream{};
-                _prefix << std::setw(_width) << std::right << _n << "/"
-                        << std::setw(_width) << std::left << _causal_env.size() << ": ["
-                        << _main_pid << " -> " << getpid() << "] ";
-
-                auto _env = _base_env;
-                for(const auto& eitr : citr)
-                    update_env(_env, eitr.first, eitr.second);
-                print_updated_environment(_env, _prefix.str());
-                print_command(_argv, _prefix.str());
-                _argv.emplace_back(nullptr);
-                _env.emplace_back(nullptr);
-                return execvpe(_argv.front(), _argv.data(), _env.data());
+                if(get_verbose() >= 3)
+                {
+                    TIMEMORY_PRINTF_INFO(stderr, "process %i returned %i from fork...\n",
+                                         getpid(), _pid);
+                }
+
+                if(_pid == 0)
+                {
+                    auto _prefix = std::stringstream{};
+                    _prefix << std::setw(_width) << std::right << _n << "/"
+                            << std::setw(_width) << std::left << _causal_env.size();
+                    if(_njobs > 1) _prefix << " (worker " << j << "/" << _njobs << ")";
+                    _prefix << ": [" << _main_pid << " -> " << getpid() << "] ";
+
+                    auto _env = _base_env;
+                    for(const auto& eitr : citr)
+                        update_env(_env, eitr.first, eitr.second);
+                    if(_njobs > 1)
+                    {
+                        const auto _worker_id   = std::to_string(j);
+                        const auto _num_workers = std::to_string(_njobs);
+                        update_env(_env, "OMNITRACE_CAUSAL_WORKER_ID", _worker_id);
+                        update_env(_env, "OMNITRACE_CAUSAL_NUM_WORKERS", _num_workers);
+                        if(!_has_seed)
+                            update_env(_env, "OMNITRACE_CAUSAL_RANDOM_SEED", _seed);
+                    }
+                    print_updated_environment(_env, _prefix.str());
+                    print_command(_argv, _prefix.str());
+                    _argv.emplace_back(nullptr);
+                    _env.emplace_back(nullptr);
+                    return execvpe(_argv.front(), _argv.data(), _env.data());
+                }
+                else
+                {
+                    add_child_pid(_pid);
+                    _pids.emplace_back(_pid);
+                }
             }
-            else
+
+            int _ret = 0;
+            for(auto _pid : _pids)
             {
-                add_child_pid(_pid);
                 auto _status = wait_pid(_pid);
-                auto _ret    = diagnose_status(_pid, _status);
+                auto _pret   = diagnose_status(_pid, _status);
                 remove_child_pid(_pid);
-                if(_ret != 0) return _ret;
+                if(_ret == 0) _ret = _pret;
+            }
+            if(_ret != 0) return _ret;
+
+            // the remaining runs would not change the estimates
+            if(_ncount < _causal_env.size() && _ncount % get_runs_per_iteration() == 0 &&
+               is_converged())
+            {
+                TIMEMORY_PRINTF_INFO(stderr,
+                                     "every impact estimate has converged after %zu of "
+                                     "%zu runs. Skipping the remaining runs...\n",
+                                     _ncount, _causal_env.size());
+                break;
             }
         }
     }
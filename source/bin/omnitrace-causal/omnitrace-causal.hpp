@@ -35,6 +35,17 @@
 int
 get_verbose();
 
+int
+get_num_jobs();
+
+/// number of run configurations in each iteration
+size_t
+get_runs_per_iteration();
+
+/// whether every impact estimate has converged after the last run (see --converge)
+bool
+is_converged();
+
 std::string
 get_realpath(const std::string&);
 
@@ -0,0 +1,198 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "attach_sampler.hpp"
+#include "core/perf_ring.hpp"
+
+#include <timemory/utility/join.hpp>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace attach_sampler
+{
+namespace
+{
+using ::timemory::join::join;
+
+// pages of the ring buffer of each thread (excluding the header page), a power of two
+constexpr size_t ring_pages = 64;
+// frequency at which the ring buffers are drained
+constexpr auto drain_interval = std::chrono::milliseconds{ 10 };
+
+struct ring
+{
+    int                   fd   = -1;
+    void*                 base = nullptr;
+    size_t                size = 0;  ///< size of the data pages
+    perf_event_mmap_page* meta = nullptr;
+};
+
+int
+perf_event_open(struct perf_event_attr* _attr, pid_t _tid)
+{
+    return static_cast<int>(syscall(__NR_perf_event_open, _attr, _tid, -1, -1, 0));
+}
+
+std::vector<pid_t>
+get_threads(pid_t _pid)
+{
+    auto  _tids = std::vector<pid_t>{};
+    auto* _dir  = opendir(join("", "/proc/", _pid, "/task").c_str());
+    if(!_dir) return _tids;
+    while(auto* _ent = readdir(_dir))
+    {
+        if(_ent->d_name[0] < '0' || _ent->d_name[0] > '9') continue;
+        _tids.emplace_back(std::stoi(_ent->d_name));
+    }
+    closedir(_dir);
+    return _tids;
+}
+
+// copies the records out of the ring buffer
+void
+drain(ring& _ring, result& _result)
+{
+    auto _word = [](const char* _body, size_t _idx) {
+        auto _v = uint64_t{ 0 };
+        memcpy(&_v, _body + (_idx * sizeof(uint64_t)), sizeof(_v));
+        return _v;
+    };
+
+    omnitrace::perf::ring::drain(
+        _ring.meta, _ring.base, _ring.size,
+        [&](const perf_event_header& _hdr, const char* _record) {
+            const auto* _body = _record + sizeof(_hdr);
+            if(_hdr.type == PERF_RECORD_SAMPLE)
+            {
+                // PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN
+                auto _nwords = (_hdr.size - sizeof(_hdr)) / sizeof(uint64_t);
+                auto _nr     = (_nwords > 2) ? _word(_body, 2) : 0;
+                auto _stack  = call_stack_t{};
+                _stack.reserve(_nr);
+                for(size_t i = 0; i < _nr && 3 + i < _nwords; ++i)
+                {
+                    // the context markers separate the kernel and user frames
+                    auto _ip = _word(_body, 3 + i);
+                    if(_ip >= PERF_CONTEXT_MAX) continue;
+                    _stack.emplace_back(_ip);
+                }
+                if(_stack.empty() && _nwords > 0) _stack.emplace_back(_word(_body, 0));
+                if(!_stack.empty()) _result.samples.emplace_back(std::move(_stack));
+            }
+            else if(_hdr.type == PERF_RECORD_LOST)
+            {
+                // id followed by the number of lost records
+                _result.lost += _word(_body, 1);
+            }
+        });
+}
+}  // namespace
+
+result
+sample(pid_t _pid, double _duration, uint64_t _freq)
+{
+    auto _attr           = perf_event_attr{};
+    _attr.size           = sizeof(_attr);
+    _attr.type           = PERF_TYPE_SOFTWARE;
+    _attr.config         = PERF_COUNT_SW_TASK_CLOCK;
+    _attr.freq           = 1;
+    _attr.sample_freq    = _freq;
+    _attr.sample_type    = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+    _attr.disabled       = 1;
+    _attr.exclude_kernel = 1;
+    _attr.exclude_hv     = 1;
+
+    // the kernel does not permit the ring buffer of an inherited per-task event so
+    // every thread has its own event and the threads created later are not sampled
+    auto _page   = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto _rings  = std::vector<ring>{};
+    auto _errnum = 0;
+    for(auto _tid : get_threads(_pid))
+    {
+        auto _ring = ring{};
+        _ring.fd   = perf_event_open(&_attr, _tid);
+        if(_ring.fd < 0)
+        {
+            _errnum = errno;
+            continue;
+        }
+        _ring.size = ring_pages * _page;
+        _ring.meta = static_cast<perf_event_mmap_page*>(mmap(nullptr, _ring.size + _page,
+                                                             PROT_READ | PROT_WRITE,
+                                                             MAP_SHARED, _ring.fd, 0));
+        if(_ring.meta == MAP_FAILED)
+        {
+            _errnum = errno;
+            close(_ring.fd);
+            continue;
+        }
+        _ring.base = reinterpret_cast<char*>(_ring.meta) + _page;
+        _rings.emplace_back(_ring);
+    }
+
+    if(_rings.empty())
+        throw std::runtime_error(join(
+            "", "unable to sample the threads of process ", _pid, ": ",
+            (_errnum != 0) ? strerror(_errnum) : "no threads",
+            " (see /proc/sys/kernel/perf_event_paranoid)"));
+
+    auto _result    = result{};
+    _result.threads = _rings.size();
+    _result.period  = 1.0 / static_cast<double>(_freq);
+
+    for(auto& itr : _rings)
+        ioctl(itr.fd, PERF_EVENT_IOC_ENABLE, 0);
+
+    auto _end = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>{ _duration });
+    while(std::chrono::steady_clock::now() < _end)
+    {
+        std::this_thread::sleep_for(drain_interval);
+        for(auto& itr : _rings)
+            drain(itr, _result);
+    }
+
+    for(auto& itr : _rings)
+    {
+        ioctl(itr.fd, PERF_EVENT_IOC_DISABLE, 0);
+        drain(itr, _result);
+        munmap(itr.meta, itr.size + _page);
+        close(itr.fd);
+    }
+
+    return _result;
+}
+}  // namespace attach_sampler
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <vector>
+
+/// samples the call-stacks of the threads of a running process with perf before
+/// omnitrace attaches to it (see --attach-sample). The process keeps running while it
+/// is sampled. The call-stacks are unwound by the kernel so the callers are only
+/// recorded for the code which maintains the frame pointers
+namespace attach_sampler
+{
+/// the instruction pointer followed by the return addresses, innermost first
+using call_stack_t = std::vector<uintptr_t>;
+
+struct result
+{
+    std::vector<call_stack_t> samples = {};
+    size_t                    threads = 0;    ///< number of threads which were sampled
+    size_t                    lost    = 0;    ///< samples lost when a buffer was full
+    double                    period  = 0.0;  ///< seconds of CPU time per sample
+};
+
+/// samples the CPU time of every thread of the process for the duration in seconds.
+/// Throws std::runtime_error if none of the threads can be sampled, e.g. when
+/// /proc/sys/kernel/perf_event_paranoid does not permit it
+result
+sample(pid_t _pid, double _duration, uint64_t _freq);
+}  // namespace attach_sampler
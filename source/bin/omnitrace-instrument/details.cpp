@@ -30,9 +30,13 @@
 #include <timemory/utility/join.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <link.h>
 #include <linux/limits.h>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 static int expect_error = NO_ERROR;
@@ -86,8 +90,11 @@ get_whole_function_names()
 std::string_view
 get_name(procedure_t* _func)
 {
-    static auto _v = std::unordered_map<procedure_t*, std::string>{};
+    static auto _v   = std::unordered_map<procedure_t*, std::string>{};
+    static auto _mtx = std::mutex{};
 
+    // the elements of an unordered_map are not relocated by an insertion
+    auto _lk = std::unique_lock<std::mutex>{ _mtx };
     auto itr = _v.find(_func);
     if(itr == _v.end())
     {
@@ -100,8 +107,10 @@ get_name(procedure_t* _func)
 std::string_view
 get_name(module_t* _module)
 {
-    static auto _v = std::unordered_map<module_t*, std::string>{};
+    static auto _v   = std::unordered_map<module_t*, std::string>{};
+    static auto _mtx = std::mutex{};
 
+    auto _lk = std::unique_lock<std::mutex>{ _mtx };
     auto itr = _v.find(_module);
     if(itr == _v.end())
     {
@@ -125,54 +134,49 @@ get_name(module_t* _module)
 symtab_func_t*
 get_symtab_function(procedure_t* _func)
 {
-    static auto _v = std::unordered_map<procedure_t*, symtab_func_t*>{};
+    static auto _v   = std::unordered_map<procedure_t*, symtab_func_t*>{};
+    static auto _mtx = std::mutex{};
 
-    auto itr = _v.find(_func);
-    if(itr == _v.end())
     {
+        auto _lk = std::unique_lock<std::mutex>{ _mtx };
+        auto itr = _v.find(_func);
+        if(itr != _v.end()) return itr->second;
+    }
+
+    // the symtab data is not modified after process_modules so the search does not
+    // need to hold the lock
+    auto _find = [_func]() -> symtab_func_t* {
         auto _name = _func->getName();
         {
             auto nitr = symtab_data.mangled_symbol_names.find(_name);
             if(nitr != symtab_data.mangled_symbol_names.end())
-            {
-                _v.emplace(_func, nitr->second->getFunction());
-                return _v.at(_func);
-            }
+                return nitr->second->getFunction();
         }
 
         for(auto& fitr : symtab_data.symbols)
         {
-            if(_name == fitr.first->getName())
-            {
-                _v.emplace(_func, fitr.first);
-                return _v.at(_func);
-            }
+            if(_name == fitr.first->getName()) return fitr.first;
         }
 
         auto _dname = _func->getDemangledName();
 
         {
             auto nitr = symtab_data.typed_func_names.find(_dname);
-            if(nitr != symtab_data.typed_func_names.end())
-            {
-                _v.emplace(_func, nitr->second);
-                return _v.at(_func);
-            }
+            if(nitr != symtab_data.typed_func_names.end()) return nitr->second;
         }
 
         {
             auto nitr = symtab_data.typed_symbol_names.find(_dname);
             if(nitr != symtab_data.typed_symbol_names.end())
-            {
-                _v.emplace(_func, nitr->second->getFunction());
-                return _v.at(_func);
-            }
+                return nitr->second->getFunction();
         }
 
-        if(_v.find(_func) == _v.end()) _v.emplace(_func, nullptr);
-    }
+        return nullptr;
+    };
 
-    return _v.at(_func);
+    auto* _value = _find();
+    auto  _lk    = std::unique_lock<std::mutex>{ _mtx };
+    return _v.emplace(_func, _value).first->second;
 }
 
 namespace
@@ -218,6 +222,7 @@ get_func_file_line_info(module_t* module, procedure_t* func)
 
     OMNITRACE_ADD_LOG_ENTRY("Getting function line info for", get_name(func));
 
+    auto _lk          = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
     auto _file_name   = get_name(module);
     auto _func_name   = get_name(func);
     auto _return_type = get_return_type(func);
@@ -754,6 +759,61 @@ error_func_fake(error_level_t level, int num, const char* const* params)
 
 using ::timemory::join::join;
 
+//======================================================================================//
+//
+//  Helpers for the concurrent analysis of the functions
+//
+std::recursive_mutex&
+get_dyninst_mutex()
+{
+    static auto _v = std::recursive_mutex{};
+    return _v;
+}
+
+void
+parallel_for(size_t _n, const std::function<void(size_t)>& _func)
+{
+    auto _nthreads = (analysis_threads == 0) ? std::thread::hardware_concurrency()
+                                             : analysis_threads;
+    _nthreads      = std::min<size_t>(std::max<size_t>(_nthreads, 1), _n);
+
+    if(_nthreads <= 1)
+    {
+        for(size_t i = 0; i < _n; ++i)
+            _func(i);
+        return;
+    }
+
+    // the first exception is rethrown on the calling thread after the workers stop
+    auto _idx       = std::atomic<size_t>{ 0 };
+    auto _err_mtx   = std::mutex{};
+    auto _exception = std::exception_ptr{};
+    auto _worker    = [&]() {
+        for(size_t i = _idx++; i < _n; i = _idx++)
+        {
+            try
+            {
+                _func(i);
+            } catch(...)
+            {
+                auto _lk = std::unique_lock<std::mutex>{ _err_mtx };
+                if(!_exception) _exception = std::current_exception();
+                _idx.store(_n);
+            }
+        }
+    };
+
+    auto _threads = std::vector<std::thread>{};
+    _threads.reserve(_nthreads - 1);
+    for(size_t i = 1; i < _nthreads; ++i)
+        _threads.emplace_back(_worker);
+    _worker();
+    for(auto& itr : _threads)
+        itr.join();
+
+    if(_exception) std::rethrow_exception(_exception);
+}
+
 //======================================================================================//
 //
 //  Read the symtab data from Dyninst
@@ -23,6 +23,8 @@
 #pragma once
 
 #include "log.hpp"
+#include "regex_set.hpp"
+#include "sampling_profile.hpp"
 
 #include <timemory/backends/process.hpp>
 #include <timemory/environment.hpp>
@@ -63,9 +65,11 @@
 #include <cstring>
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <istream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <ostream>
 #include <regex>
@@ -96,7 +100,7 @@ using string_view_t          = std::string_view;
 using stringstream_t         = std::stringstream;
 using strvec_t               = std::vector<string_t>;
 using strset_t               = std::set<string_t>;
-using regexvec_t             = std::vector<std::regex>;
+using regexvec_t             = regex_set;
 using fmodset_t              = std::set<module_function>;
 using fixed_modset_t         = std::map<fmodset_t*, bool>;
 using exec_callback_t        = BPatchExecCallback;
@@ -122,6 +126,12 @@ using object_t               = BPatch_object;
 using local_var_t            = BPatch_localVar;
 using sequence_t             = BPatch_sequence;
 using const_expr_t           = BPatch_constExpr;
+using arith_expr_t           = BPatch_arithExpr;
+using variable_expr_t        = BPatch_variableExpr;
+using address_of_expr_t      = BPatch_addressOfExpr;
+using bool_expr_t            = BPatch_boolExpr;
+using if_expr_t              = BPatch_ifExpr;
+using type_t                 = BPatch_type;
 using error_level_t          = BPatchErrorLevel;
 using snippet_handle_t       = BPatchSnippetHandle;
 using patch_pointer_t        = std::shared_ptr<patch_t>;
@@ -191,12 +201,24 @@ extern bool   loop_level_instr;
 extern bool   instr_dynamic_callsites;
 extern bool   instr_traps;
 extern bool   instr_loop_traps;
+extern bool   instr_loop_trip_counts;
+extern bool   instr_trace_gate;
 extern bool   parse_all_modules;
 extern size_t min_address_range;
 extern size_t min_loop_address_range;
 extern size_t min_instructions;
 extern size_t min_loop_instructions;
 //
+//  profile-guided settings
+//
+extern sampling_profile profile_guide;
+extern double           profile_min_fraction;
+extern double           profile_max_overhead;
+extern double           profile_call_overhead;
+extern double           attach_sample_duration;
+extern size_t           attach_sample_top;
+extern size_t           attach_sample_freq;
+//
 //  debug settings
 //
 extern bool werror;
@@ -207,9 +229,10 @@ extern int  num_log_entries;
 //
 //  instrumentation settings
 //
-extern bool simulate;
-extern bool include_uninstr;
-extern bool include_internal_linked_libs;
+extern bool   simulate;
+extern bool   include_uninstr;
+extern bool   include_internal_linked_libs;
+extern size_t analysis_threads;
 //
 //  string settings
 //
@@ -218,11 +241,13 @@ extern string_t argv0;
 extern string_t cmdv0;
 extern string_t default_components;
 extern string_t prefer_library;
+extern string_t instrument_cache_dir;
 //
 //  global variables
 //
 extern patch_pointer_t  bpatch;
 extern call_expr_t*     terminate_expr;
+extern variable_expr_t* trace_gate;
 extern snippet_vec_t    init_names;
 extern snippet_vec_t    fini_names;
 extern fmodset_t        available_module_functions;
@@ -241,6 +266,7 @@ extern regexvec_t       func_internal_include;
 extern regexvec_t       file_internal_include;
 extern regexvec_t       instruction_exclude;
 extern CodeCoverageMode coverage_mode;
+extern bool             coverage_counters;
 //
 // symtab variables
 //
@@ -317,6 +343,15 @@ consume_parameters(T&&...)
 void
 process_modules(const std::vector<module_t*>&);
 
+// serializes the Dyninst queries which create or modify state shared between the
+// functions, e.g. the flow graphs, the types, and the line info of the binary
+std::recursive_mutex&
+get_dyninst_mutex();
+
+// invokes the function for every index in [0, N) on up to analysis_threads threads
+void
+parallel_for(size_t, const std::function<void(size_t)>&);
+
 strset_t
 get_whole_function_names();
 
@@ -0,0 +1,325 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "instrument_cache.hpp"
+#include "common/defines.h"
+#include "fwd.hpp"
+#include "log.hpp"
+
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/join.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string_view>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace instrument_cache
+{
+namespace
+{
+namespace filepath = ::tim::filepath;
+using ::timemory::join::join;
+using function_key_t = std::tuple<std::string, std::string, uint64_t>;
+
+constexpr auto functions_header = std::string_view{ "omnitrace-instrument-functions\t1" };
+constexpr auto library_header   = std::string_view{ "omnitrace-instrument-library\t1" };
+
+struct cache_state
+{
+    std::string                               options        = {};
+    std::string                               functions_file = {};
+    std::map<function_key_t, function_record> previous       = {};
+    std::map<function_key_t, function_record> current        = {};
+};
+
+cache_state&
+get_state()
+{
+    static auto _v = cache_state{};
+    return _v;
+}
+
+uint64_t
+get_hash(std::string_view _v, uint64_t _hash = 0xcbf29ce484222325ULL)
+{
+    // FNV-1a
+    for(auto itr : _v)
+    {
+        _hash ^= static_cast<uint8_t>(itr);
+        _hash *= 0x100000001b3ULL;
+    }
+    return _hash;
+}
+
+std::string
+as_hex(uint64_t _v)
+{
+    auto _ss = std::stringstream{};
+    _ss << std::hex << std::setw(16) << std::setfill('0') << _v;
+    return _ss.str();
+}
+
+// the real path, modification time, and size of the file. Empty if it does not exist
+std::string
+get_file_key(const std::string& _fpath)
+{
+    auto _real = filepath::realpath(_fpath, nullptr, false);
+    struct stat _stat = {};
+    if(stat(_real.c_str(), &_stat) != 0) return std::string{};
+    return as_hex(get_hash(join(':', _real, _stat.st_mtime, _stat.st_size)));
+}
+
+// splits the line into the fields separated by tabs. Empty fields are preserved
+std::vector<std::string>
+split(const std::string& _line, size_t _max)
+{
+    auto _fields = std::vector<std::string>{};
+    auto _beg    = size_t{ 0 };
+    while(_fields.size() + 1 < _max)
+    {
+        auto _end = _line.find('\t', _beg);
+        if(_end == std::string::npos) break;
+        _fields.emplace_back(_line.substr(_beg, _end - _beg));
+        _beg = _end + 1;
+    }
+    _fields.emplace_back(_line.substr(_beg));
+    return _fields;
+}
+
+// written to a temporary file which is renamed so that a concurrent reader never sees
+// a partial entry
+void
+write_entry(const std::string& _fname, const std::string& _data)
+{
+    auto _tmp = join('.', _fname, getpid(), "tmp");
+    auto _ofs = std::ofstream{};
+    if(!filepath::open(_ofs, _tmp))
+    {
+        verbprintf(1, "[cache] Warning! unable to write '%s'\n", _tmp.c_str());
+        return;
+    }
+    _ofs << _data;
+    _ofs.close();
+    if(!_ofs || std::rename(_tmp.c_str(), _fname.c_str()) != 0)
+    {
+        verbprintf(1, "[cache] Warning! unable to write '%s'\n", _fname.c_str());
+        std::remove(_tmp.c_str());
+    }
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return !instrument_cache_dir.empty();
+}
+
+void
+set_options(int _argc, char** _argv)
+{
+    auto _ss = std::stringstream{};
+    _ss << OMNITRACE_VERSION_STRING << '\n' << OMNITRACE_GIT_REVISION << '\n';
+    for(int i = 1; i < _argc; ++i)
+        if(_argv[i]) _ss << _argv[i] << '\n';
+    for(char** itr = environ; itr && *itr; ++itr)
+    {
+        if(std::string_view{ *itr }.find("OMNITRACE_REGEX_") == 0) _ss << *itr << '\n';
+    }
+    // the decisions depend on the content of the profile
+    if(!profile_guide.filename.empty()) _ss << get_file_key(profile_guide.filename);
+    get_state().options = as_hex(get_hash(_ss.str()));
+}
+
+uint64_t
+get_function_hash(symtab_func_t* _func)
+{
+    if(!_func) return 0;
+
+    auto* _region = _func->getRegion();
+    if(!_region || !_region->getPtrToRawData()) return 0;
+
+    auto _offset = _func->getOffset();
+    auto _size   = _func->getSize();
+    if(_size == 0 || _offset < _region->getMemOffset() ||
+       (_offset - _region->getMemOffset()) + _size > _region->getDiskSize())
+        return 0;
+
+    const auto* _data = static_cast<const char*>(_region->getPtrToRawData()) +
+                        (_offset - _region->getMemOffset());
+    auto _hash = get_hash(std::string_view{ _data, _size });
+    // zero is reserved for the functions which are not hashed
+    return (_hash == 0) ? 1 : _hash;
+}
+
+std::optional<library_modules_t>
+load_library(const std::string& _fpath)
+{
+    if(!enabled()) return std::nullopt;
+
+    auto _key = get_file_key(_fpath);
+    if(_key.empty()) return std::nullopt;
+
+    auto _fname = join('/', instrument_cache_dir, "internal-libs",
+                       join('.', filepath::basename(_fpath), _key, "txt"));
+    auto _ifs   = std::ifstream{ _fname };
+    auto _line  = std::string{};
+    if(!_ifs || !std::getline(_ifs, _line) || _line != library_header)
+        return std::nullopt;
+
+    auto _modules = library_modules_t{};
+    while(std::getline(_ifs, _line))
+    {
+        auto _fields = split(_line, 3);
+        if(_fields.size() == 3 && _fields.at(0) == "module")
+            _modules.emplace_back(library_module{ _fields.at(1), _fields.at(2), {} });
+        else if(_fields.size() == 2 && _fields.at(0) == "function" && !_modules.empty())
+            _modules.back().functions.emplace(_fields.at(1));
+        else
+            return std::nullopt;
+    }
+
+    verbprintf(2, "[cache] read %zu modules of '%s' from '%s'\n", _modules.size(),
+               _fpath.c_str(), _fname.c_str());
+    return _modules;
+}
+
+void
+save_library(const std::string& _fpath, const library_modules_t& _modules)
+{
+    if(!enabled()) return;
+
+    auto _key = get_file_key(_fpath);
+    if(_key.empty()) return;
+
+    auto _ss = std::stringstream{};
+    _ss << library_header << '\n';
+    for(const auto& itr : _modules)
+    {
+        // the names are stored in tab-separated lines
+        if(itr.name.find_first_of("\t\n") != std::string::npos ||
+           itr.path.find('\n') != std::string::npos)
+            return;
+        _ss << "module\t" << itr.name << '\t' << itr.path << '\n';
+        for(const auto& fitr : itr.functions)
+        {
+            if(fitr.find('\n') != std::string::npos) return;
+            _ss << "function\t" << fitr << '\n';
+        }
+    }
+
+    write_entry(join('/', instrument_cache_dir, "internal-libs",
+                     join('.', filepath::basename(_fpath), _key, "txt")),
+                _ss.str());
+}
+
+void
+load_functions(const std::string& _binary)
+{
+    if(!enabled()) return;
+
+    auto& _state = get_state();
+    auto  _real  = filepath::realpath(_binary, nullptr, false);
+    _state.functions_file =
+        join('/', instrument_cache_dir, "functions",
+             join('.', filepath::basename(_real), as_hex(get_hash(_real)), _state.options,
+                  "txt"));
+
+    auto _ifs  = std::ifstream{ _state.functions_file };
+    auto _line = std::string{};
+    if(!_ifs || !std::getline(_ifs, _line) || _line != functions_header) return;
+
+    auto _records = std::map<function_key_t, function_record>{};
+    while(std::getline(_ifs, _line))
+    {
+        auto _fields = split(_line, 7);
+        if(_fields.size() != 7) return;
+        try
+        {
+            auto _hash   = std::stoull(_fields.at(0), nullptr, 16);
+            auto _record = function_record{ std::stoull(_fields.at(1)),
+                                            std::stoull(_fields.at(2)),
+                                            _fields.at(3) == "1", _fields.at(4) == "1" };
+            _records.emplace(function_key_t{ _fields.at(5), _fields.at(6), _hash },
+                             _record);
+        } catch(std::exception&)
+        {
+            return;
+        }
+    }
+
+    verbprintf(1, "[cache] read the decisions of %zu functions from '%s'\n",
+               _records.size(), _state.functions_file.c_str());
+    _state.previous = std::move(_records);
+}
+
+const function_record*
+find_function(const std::string& _module, const std::string& _func, uint64_t _hash)
+{
+    // only modified by load_functions so it may be searched concurrently
+    const auto& _previous = get_state().previous;
+    if(_hash == 0 || _previous.empty()) return nullptr;
+
+    auto itr = _previous.find(function_key_t{ _module, _func, _hash });
+    return (itr != _previous.end()) ? &itr->second : nullptr;
+}
+
+void
+record_function(const std::string& _module, const std::string& _func, uint64_t _hash,
+                function_record _record)
+{
+    // the names are stored in tab-separated lines
+    if(!enabled() || _hash == 0 || _module.find_first_of("\t\n") != std::string::npos ||
+       _func.find_first_of("\t\n") != std::string::npos)
+        return;
+    get_state().current[function_key_t{ _module, _func, _hash }] = _record;
+}
+
+void
+save_functions()
+{
+    auto& _state = get_state();
+    if(!enabled() || _state.functions_file.empty()) return;
+
+    auto _ss = std::stringstream{};
+    _ss << functions_header << '\n';
+    for(const auto& itr : _state.current)
+    {
+        _ss << as_hex(std::get<2>(itr.first)) << '\t' << itr.second.address_range << '\t'
+            << itr.second.num_instructions << '\t' << (itr.second.instrument ? 1 : 0)
+            << '\t' << (itr.second.coverage ? 1 : 0) << '\t' << std::get<0>(itr.first)
+            << '\t' << std::get<1>(itr.first) << '\n';
+    }
+
+    verbprintf(1, "[cache] writing the decisions of %zu functions to '%s'\n",
+               _state.current.size(), _state.functions_file.c_str());
+    write_entry(_state.functions_file, _ss.str());
+}
+}  // namespace instrument_cache
@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "fwd.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+/// persistent cache of the results of omnitrace-instrument between invocations (see
+/// --cache-dir). The cache holds the modules and functions of the internal libraries
+/// and, for every function of the instrumented binary, whether it was instrumented.
+/// A function whose bytes, name, and module are unchanged since an invocation with the
+/// same options which excluded it skips the analysis of its control flow graph and
+/// instructions
+namespace instrument_cache
+{
+struct function_record
+{
+    uint64_t address_range    = 0;
+    uint64_t num_instructions = 0;
+    bool     instrument       = false;
+    bool     coverage         = false;
+};
+
+struct library_module
+{
+    std::string           name      = {};
+    std::string           path      = {};
+    std::set<std::string> functions = {};
+};
+
+using library_modules_t = std::vector<library_module>;
+
+bool
+enabled();
+
+/// the options which affect the decisions, i.e. the command-line arguments
+/// before the "--" and the regex environment variables
+void
+set_options(int _argc, char** _argv);
+
+/// the hash of the bytes of the function in the binary or zero if not available
+uint64_t
+get_function_hash(symtab_func_t*);
+
+std::optional<library_modules_t>
+load_library(const std::string& _fpath);
+
+void
+save_library(const std::string& _fpath, const library_modules_t&);
+
+void
+load_functions(const std::string& _binary);
+
+const function_record*
+find_function(const std::string& _module, const std::string& _func, uint64_t _hash);
+
+void
+record_function(const std::string& _module, const std::string& _func, uint64_t _hash,
+                function_record);
+
+void
+save_functions();
+}  // namespace instrument_cache
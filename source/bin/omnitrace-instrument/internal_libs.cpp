@@ -29,6 +29,7 @@
 #include "common/defines.h"
 #include "core/utility.hpp"
 #include "fwd.hpp"
+#include "instrument_cache.hpp"
 #include "log.hpp"
 
 #include <timemory/components/rusage/components.hpp>
@@ -112,8 +113,7 @@ check_regex_restrictions(const ContainerT<std::string, TailT...>& _names,
                          const regexvec_t&                        _regexes)
 {
     for(const auto& nitr : _names)
-        for(const auto& ritr : _regexes)
-            if(std::regex_search(nitr, ritr)) return true;
+        if(_regexes.search(nitr)) return true;
     return false;
 }
 
@@ -442,13 +442,16 @@ get_internal_libs_data_impl()
         _data.emplace(_fpath, module_func_map_t{});
     }
 
-    auto _odata = ordered(_data);
-    for(const auto& itr : _odata)
-    {
-        symtab_t* _symtab = get_symtab_file(itr.first);
-        if(!_symtab) continue;
+    // the modules and functions of a library, read from the cache if possible
+    auto _get_modules = [](const std::string& _lib) {
+        if(auto _cached = instrument_cache::load_library(_lib)) return *_cached;
 
-        verbprintf(0, "[internal] parsing library: '%s'...\n", itr.first.c_str());
+        auto _lib_modules = instrument_cache::library_modules_t{};
+
+        symtab_t* _symtab = get_symtab_file(_lib);
+        if(!_symtab) return _lib_modules;
+
+        verbprintf(0, "[internal] parsing library: '%s'...\n", _lib.c_str());
 
         auto _wc_v = tim::component::wall_clock{};
         auto _pr_v = tim::component::peak_rss{};
@@ -460,18 +463,12 @@ get_internal_libs_data_impl()
 
         for(const auto& mitr : _modules)
         {
-            const auto& _mname = mitr->fileName();
-            const auto& _mpath = mitr->fullName();
-            // allow the user to request this library be considered for instrumentation
-            if(check_regex_restrictions(strvec_t{ _mname, _mpath },
-                                        file_internal_include))
-                continue;
-
             verbprintf(3, "[internal]     parsing module: '%s' (via '%s')...\n",
-                       _mname.c_str(), filepath::basename(itr.first));
+                       mitr->fileName().c_str(), filepath::basename(_lib));
 
-            _data[itr.first].emplace(_mpath, func_set_t{});
-            _data[itr.first].emplace(_mname, func_set_t{});
+            auto& _module = _lib_modules.emplace_back();
+            _module.name  = mitr->fileName();
+            _module.path  = mitr->fullName();
 
             auto _funcs = std::vector<symtab_func_t*>{};
             mitr->getAllFunctions(_funcs);
@@ -481,16 +478,36 @@ get_internal_libs_data_impl()
                 auto _fname = fitr->getName();
                 auto _dname = tim::demangle(_fname);
 
-                _data[itr.first][_mpath].emplace(_fname);
-                _data[itr.first][_mpath].emplace(_dname);
+                _module.functions.emplace(_fname);
+                _module.functions.emplace(_dname);
             }
         }
 
         _pr_v.stop();
         _wc_v.stop();
         verbprintf(1, "[internal] parsing library: '%s'... Done (%.3f %s, %.3f %s)\n",
-                   itr.first.c_str(), _wc_v.get(), _wc_v.display_unit().c_str(),
-                   _pr_v.get(), _pr_v.display_unit().c_str());
+                   _lib.c_str(), _wc_v.get(), _wc_v.display_unit().c_str(), _pr_v.get(),
+                   _pr_v.display_unit().c_str());
+
+        instrument_cache::save_library(_lib, _lib_modules);
+        return _lib_modules;
+    };
+
+    auto _odata = ordered(_data);
+    for(const auto& itr : _odata)
+    {
+        for(const auto& mitr : _get_modules(itr.first))
+        {
+            // allow the user to request this library be considered for instrumentation
+            if(check_regex_restrictions(strvec_t{ mitr.name, mitr.path },
+                                        file_internal_include))
+                continue;
+
+            _data[itr.first].emplace(mitr.path, func_set_t{});
+            _data[itr.first].emplace(mitr.name, func_set_t{});
+            _data[itr.first][mitr.path].insert(mitr.functions.begin(),
+                                               mitr.functions.end());
+        }
 
         // close_symtab_file(itr.first);
     }
@@ -24,15 +24,20 @@
 #include "fwd.hpp"
 
 #include <cmath>
+#include <deque>
 #include <iomanip>
+#include <mutex>
 #include <regex>
-#include <vector>
 
 namespace color = tim::log::color;
 
 namespace
 {
-std::vector<log_entry> log_entries = {};
+// the functions may be analyzed concurrently (see parallel_for). The references
+// returned by add_log_entry remain valid because a deque does not relocate its
+// elements when appending
+std::deque<log_entry> log_entries = {};
+std::mutex            log_mutex   = {};
 
 auto
 get_color_regex(std::string _v)
@@ -54,7 +59,12 @@ log_entry::log_entry(std::string _msg)
 : m_message{ std::move(_msg) }
 , m_backtrace{ tim::get_unw_stack<4, 1>() }
 {
-    if(log_ofs) *log_ofs << as_string("", "", "") << "\n";
+    if(log_ofs)
+    {
+        auto _line = as_string("", "", "");
+        auto _lk   = std::unique_lock<std::mutex>{ log_mutex };
+        *log_ofs << _line << "\n";
+    }
 }
 
 log_entry::log_entry(source_location _loc, std::string _msg)
@@ -62,7 +72,12 @@ log_entry::log_entry(source_location _loc, std::string _msg)
 , m_message{ std::move(_msg) }
 , m_backtrace{ tim::get_unw_stack<4, 1>() }
 {
-    if(log_ofs) *log_ofs << as_string("", "", "") << "\n";
+    if(log_ofs)
+    {
+        auto _line = as_string("", "", "");
+        auto _lk   = std::unique_lock<std::mutex>{ log_mutex };
+        *log_ofs << _line << "\n";
+    }
 }
 
 std::string
@@ -86,6 +101,7 @@ log_entry::as_string(const char* _color, const char* _src, const char* _end) con
 log_entry&
 log_entry::add_log_entry(log_entry&& _v)
 {
+    auto _lk = std::unique_lock<std::mutex>{ log_mutex };
     return log_entries.emplace_back(std::move(_v));
 }
 
@@ -23,6 +23,7 @@
 #include "module_function.hpp"
 #include "InstructionCategories.h"
 #include "fwd.hpp"
+#include "instrument_cache.hpp"
 #include "internal_libs.hpp"
 #include "log.hpp"
 #include "omnitrace-instrument.hpp"
@@ -56,11 +57,20 @@ module_function::update_width(const module_function& rhs)
     get_width()[2] = std::max<size_t>(get_width()[2], rhs.signature.get().length());
 }
 
+namespace
+{
+flow_graph_t*
+get_flow_graph(procedure_t* _proc)
+{
+    auto _lk = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
+    return _proc->getCFG();
+}
+}  // namespace
+
 module_function::module_function(module_t* mod, procedure_t* proc)
 : module{ mod }
 , function{ proc }
 , symtab_function{ proc->isInstrumentable() ? get_symtab_function(proc) : nullptr }
-, flow_graph{ proc->getCFG() }
 , module_name{ get_name(module) }
 , function_name{ get_name(function) }
 {
@@ -87,6 +97,23 @@ module_function::module_function(module_t* mod, procedure_t* proc)
     for(int i = 0; i <= instruction_category_t::c_NoCategory; ++i)
         instruction_types[static_cast<instruction_category_t>(i)] = 0;
 
+    if(instrument_cache::enabled())
+    {
+        function_hash = instrument_cache::get_function_hash(symtab_function);
+        const auto* _record =
+            instrument_cache::find_function(module_name, function_name, function_hash);
+        // the analysis of the functions which will be instrumented is always required
+        if(_record && _record->address_range == address_range && !_record->instrument &&
+           !_record->coverage)
+        {
+            cached           = true;
+            num_instructions = _record->num_instructions;
+            return;
+        }
+    }
+
+    flow_graph = get_flow_graph(function);
+
     if(function->isInstrumentable())
     {
         // this information is potentially not available and
@@ -95,6 +122,7 @@ module_function::module_function(module_t* mod, procedure_t* proc)
         // functions
         if(flow_graph)
         {
+            auto _lk = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
             flow_graph->getAllBasicBlocks(basic_blocks);
             flow_graph->getOuterLoops(loop_blocks);
         }
@@ -167,6 +195,13 @@ module_function::should_instrument() const
 bool
 module_function::should_coverage_instrument() const
 {
+    if(cached)
+    {
+        messages.emplace_back(2, "Skipping", "function", "cached-exclusion",
+                              function_name);
+        return false;
+    }
+
     // hard constraints
     if(!is_instrumentable()) return false;
     if(!can_instrument_entry()) return false;
@@ -205,6 +240,13 @@ module_function::should_coverage_instrument() const
 bool
 module_function::should_instrument(bool coverage) const
 {
+    if(cached)
+    {
+        messages.emplace_back(2, "Skipping", "function", "cached-exclusion",
+                              function_name);
+        return false;
+    }
+
     // hard constraints
     if(!is_instrumentable()) return false;
     if(!can_instrument_entry()) return false;
@@ -246,6 +288,9 @@ module_function::should_instrument(bool coverage) const
         if(is_visibility_constrained()) return false;
     }
 
+    // the profile supersedes the address range and number of instruction constraints
+    if(!coverage && !profile_guide.empty()) return !is_profile_constrained();
+
     if(is_address_range_constrained()) return false;
     if(is_num_instructions_constrained()) return false;
     if(is_instruction_constrained()) return false;
@@ -268,12 +313,10 @@ module_function::is_instrumentable() const
 namespace
 {
 bool
-check_regex_restrictions(const std::string& _name, const regexvec_t& _regexes)
+check_regex_restrictions(const std::string& _name, const regexvec_t& _regexes,
+                         bool _cache = true)
 {
-    // NOLINTNEXTLINE
-    for(auto& itr : _regexes)
-        if(std::regex_search(_name, itr)) return true;
-    return false;
+    return _regexes.search(_name, _cache);
 }
 }  // namespace
 
@@ -388,6 +431,7 @@ module_function::is_user_excluded() const
 bool
 module_function::is_overlapping() const
 {
+    auto            _lk = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
     procedure_vec_t _overlapping{};
     return function->findOverlapping(_overlapping);
 }
@@ -444,19 +488,26 @@ module_function::is_internal_constrained() const
     auto _module_base = _basename(module_name);
     auto _module_real = _realpath(module_name);
 
-    if(std::regex_search(module_name, std::regex{ "lib(omnitrace|timemory|perfetto)" }))
+    // compiled once instead of for every module function
+    static const auto _lib_regex = std::regex{ "lib(omnitrace|timemory|perfetto)" };
+    static const auto _src_regex =
+        std::regex{ ".*/source/lib/"
+                    "(core|common|binary|omnitrace|omnitrace-dl|"
+                    "omnitrace-user)/.*/.*\\.(h|c|cpp|hpp)$" };
+    static const auto _omni_regex = std::regex{ "9omnitrace|omnitrace(::|_)" };
+    static const auto _tim_regex  = std::regex{ "3tim|tim::|timemory(::|_)" };
+    static const auto _pftt_regex = std::regex{ "9perfetto|perfetto(::|_)" };
+
+    if(std::regex_search(module_name, _lib_regex))
         return _report("Excluding", "module", "omnitrace", 3);
-    else if(std::regex_match(module_name,
-                             std::regex{ ".*/source/lib/"
-                                         "(core|common|binary|omnitrace|omnitrace-dl|"
-                                         "omnitrace-user)/.*/.*\\.(h|c|cpp|hpp)$" }))
+    else if(std::regex_match(module_name, _src_regex))
         return _report("Excluding", "module", "omnitrace", 3);
 
-    if(std::regex_search(function_name, std::regex{ "9omnitrace|omnitrace(::|_)" }))
+    if(std::regex_search(function_name, _omni_regex))
         return _report("Excluding", "function", "omnitrace", 3);
-    else if(std::regex_search(function_name, std::regex{ "3tim|tim::|timemory(::|_)" }))
+    else if(std::regex_search(function_name, _tim_regex))
         return _report("Excluding", "function", "timemory", 3);
-    else if(std::regex_search(function_name, std::regex{ "9perfetto|perfetto(::|_)" }))
+    else if(std::regex_search(function_name, _pftt_regex))
         return _report("Excluding", "function", "perfetto", 3);
 
     if(_gnu_libs.find(module_name) != _gnu_libs.end() ||
@@ -640,6 +691,7 @@ module_function::is_overlapping_constrained() const
 bool
 module_function::contains_dynamic_callsites() const
 {
+    auto _lk = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
     if(flow_graph) return flow_graph->containsDynamicCallsites();
 
     return false;
@@ -650,6 +702,8 @@ module_function::contains_user_callsite() const
 {
     if(caller_include.empty()) return false;
 
+    auto _lk = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
+
     std::vector<BPatch_point*> call_points;
     function->getCallPoints(call_points);
     for(const auto& call_point : call_points)
@@ -708,7 +762,8 @@ module_function::is_instruction_constrained() const
             if(!_instr.empty())
             {
                 _instr = _instr.substr(1);
-                if(check_regex_restrictions(_instr, instruction_exclude))
+                // the instruction sequences are unique so the result is not cached
+                if(check_regex_restrictions(_instr, instruction_exclude, false))
                 {
                     messages.emplace_back(2, "Skipping", "function",
                                           "instruction-exclude-regex", function_name);
@@ -765,6 +820,38 @@ module_function::is_loop_num_instructions_constrained() const
     return false;
 }
 
+bool
+module_function::is_profile_constrained() const
+{
+    const auto* _entry = profile_guide.find(function_name);
+    if(!_entry) _entry = profile_guide.find(signature.get());
+    if(!_entry)
+    {
+        messages.emplace_back(3, "Skipping", "function", "not-in-profile",
+                              function_name);
+        return true;
+    }
+
+    if(_entry->inclusive < profile_min_fraction * profile_guide.total)
+    {
+        messages.emplace_back(2, "Skipping", "function", "profile-min-fraction",
+                              function_name);
+        return true;
+    }
+
+    auto _calls =
+        profile_guide.get_calls(*_entry, num_instructions, !loop_blocks.empty());
+    if(_calls * profile_call_overhead > profile_max_overhead * _entry->inclusive)
+    {
+        messages.emplace_back(2, "Skipping", "function", "profile-max-overhead",
+                              function_name);
+        return true;
+    }
+
+    messages.emplace_back(2, "Forcing", "function", "profile", function_name);
+    return false;
+}
+
 bool
 module_function::is_visibility_constrained() const
 {
@@ -868,8 +955,8 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
     auto _name       = signature.get();
     auto _trace_entr = omnitrace_call_expr(_name.c_str());
     auto _trace_exit = omnitrace_call_expr(_name.c_str());
-    auto _entr       = _trace_entr.get(_entr_trace);
-    auto _exit       = _trace_exit.get(_exit_trace);
+    auto _entr       = get_gated_snippet(_trace_entr.get(_entr_trace));
+    auto _exit       = get_gated_snippet(_trace_exit.get(_exit_trace));
 
     if(insert_instr(_addr_space, function, _entr, BPatch_entry) &&
        insert_instr(_addr_space, function, _exit, BPatch_exit))
@@ -881,7 +968,7 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
 
     for(size_t i = 0; i < loop_blocks.size(); ++i)
     {
-        if(!loop_level_instr) continue;
+        if(!loop_level_instr || instr_loop_trip_counts) continue;
         if(!flow_graph) continue;
 
         auto* itr             = loop_blocks.at(i);
@@ -919,8 +1006,8 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
 
         auto _ltrace_entr = omnitrace_call_expr(_lname.c_str());
         auto _ltrace_exit = omnitrace_call_expr(_lname.c_str());
-        auto _lentr       = _ltrace_entr.get(_entr_trace);
-        auto _lexit       = _ltrace_exit.get(_exit_trace);
+        auto _lentr       = get_gated_snippet(_ltrace_entr.get(_entr_trace));
+        auto _lexit       = get_gated_snippet(_ltrace_exit.get(_exit_trace));
 
         if(insert_instr(_addr_space, function, _lentr, BPatch_entry, flow_graph, itr,
                         instr_loop_traps) &&
@@ -936,6 +1023,60 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
     return _count;
 }
 
+size_t
+module_function::register_loop_trips(address_space_t* _addr_space, procedure_t* _reg_func,
+                                     procedure_t*                 _trip_func,
+                                     const std::vector<point_t*>& _entr_points,
+                                     uint64_t&                    _loop_id) const
+{
+    size_t _count = 0;
+
+    if(!function || !module || !flow_graph) return _count;
+
+    for(size_t i = 0; i < loop_blocks.size(); ++i)
+    {
+        auto* itr = loop_blocks.at(i);
+        auto  _lname =
+            get_loop_file_line_info(module, function, flow_graph, itr).set_loop_number(i);
+        auto _name = _lname.get();
+
+        size_t _points             = 0;
+        size_t _ntraps             = 0;
+        std::tie(_points, _ntraps) =
+            query_instr(function, BPatch_locLoopStartIter, flow_graph, itr);
+
+        if(_points == 0)
+        {
+            messages.emplace_back(3, "Skipping", "function-loop",
+                                  "no-instrumentable-loop-iteration-point", _name);
+            continue;
+        }
+        if(!instr_loop_traps && _points == _ntraps)
+        {
+            messages.emplace_back(3, "Skipping", "function-loop",
+                                  "loop-iteration-point-trap-instrumentation", _name);
+            continue;
+        }
+
+        // the trip only passes the id so the loop is registered with its label once
+        auto _trip_expr = omnitrace_call_expr(_loop_id);
+        auto _trip      = _trip_expr.get(_trip_func);
+        if(!insert_instr(_addr_space, function, _trip, BPatch_locLoopStartIter,
+                         flow_graph, itr, instr_loop_traps))
+            continue;
+
+        auto _reg_expr = omnitrace_call_expr(_name.c_str(), _loop_id);
+        auto _reg      = _reg_expr.get(_reg_func);
+        insert_instr(_addr_space, _entr_points, _reg, BPatch_entry);
+
+        messages.emplace_back(1, "Loop Instrumenting", "function", "trip-count", _name);
+        ++_loop_id;
+        ++_count;
+    }
+
+    return _count;
+}
+
 void
 module_function::register_source(address_space_t* _addr_space, procedure_t* _entr_trace,
                                  const std::vector<point_t*>& _entr_points) const
@@ -1025,3 +1166,75 @@ module_function::register_coverage(address_space_t* _addr_space,
     }
     return _count;
 }
+
+std::pair<size_t, size_t>
+module_function::register_coverage_counters(
+    address_space_t* _addr_space, procedure_t* _reg_func,
+    const std::vector<point_t*>& _entr_points) const
+{
+    std::pair<size_t, size_t> _count = { 0, 0 };
+
+    type_t* _type = _addr_space->getImage()->findType("unsigned long");
+    if(!_type)
+    {
+        messages.emplace_back(1, "Skipping", "function", "no-coverage-counter-type",
+                              function_name);
+        return _count;
+    }
+
+    // allocates a counter in the mutatee, registers it with the source code information
+    // at the start of main, and returns the snippet incrementing it
+    auto _get_counter = [&](const function_signature& _signature, size_t _addr,
+                            const std::string& _name) -> snippet_pointer_t {
+        variable_expr_t* _counter = _addr_space->malloc(*_type);
+        if(!_counter) return snippet_pointer_t{};
+
+        auto _address  = snippet_pointer_t{ new address_of_expr_t{ *_counter } };
+        auto _reg_entr = omnitrace_call_expr(_signature.m_file, _signature.m_name,
+                                             _signature.m_row.first, _addr, _name,
+                                             _address);
+        auto _reg_call = _reg_entr.get(_reg_func);
+        if(!insert_instr(_addr_space, _entr_points, _reg_call, BPatch_entry))
+            return snippet_pointer_t{};
+
+        return snippet_pointer_t{ new arith_expr_t{
+            BPatch_assign, *_counter,
+            arith_expr_t{ BPatch_plus, *_counter, const_expr_t{ 1 } } } };
+    };
+
+    switch(coverage_mode)
+    {
+        case CODECOV_FUNCTION:
+        {
+            auto _name = signature.get_coverage(false);
+            auto _incr = _get_counter(signature, start_address, _name);
+
+            if(_incr && insert_instr(_addr_space, function, _incr, BPatch_entry))
+            {
+                messages.emplace_back(1, "Code Coverage", "function", "counter", _name);
+                ++_count.first;
+            }
+            break;
+        }
+        case CODECOV_BASIC_BLOCK:
+        {
+            for(auto&& itr : get_basic_block_file_line_info(module, function))
+            {
+                auto  _start_addr = itr.second.start_address;
+                auto& _signature  = itr.second.signature;
+                auto  _name       = _signature.get_coverage(true);
+                auto  _incr       = _get_counter(_signature, _start_addr, _name);
+
+                if(_incr && insert_instr(_addr_space, _incr, BPatch_entry, itr.first))
+                {
+                    ++_count.second;
+                    messages.emplace_back(1, "Code Coverage", "basic_block", "counter",
+                                          _name);
+                }
+            }
+            break;
+        }
+        case CODECOV_NONE: break;
+    }
+    return _count;
+}
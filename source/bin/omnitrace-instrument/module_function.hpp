@@ -55,12 +55,22 @@ struct module_function
                          const std::vector<point_t*>&) const;
     std::pair<size_t, size_t> register_coverage(address_space_t* _addr_space,
                                                 procedure_t*     _entr_trace) const;
+    std::pair<size_t, size_t> register_coverage_counters(
+        address_space_t* _addr_space, procedure_t* _reg_func,
+        const std::vector<point_t*>& _entr_points) const;
 
     // instrumentation
     std::pair<size_t, size_t> operator()(address_space_t* _addr_space,
                                          procedure_t*     _entr_trace,
                                          procedure_t*     _exit_trace) const;
 
+    // counts the loop iterations (see --loop-trip-counts) and returns the number of
+    // instrumented loops. The ids of the loops are assigned from _loop_id
+    size_t register_loop_trips(address_space_t* _addr_space, procedure_t* _reg_func,
+                               procedure_t*                 _trip_func,
+                               const std::vector<point_t*>& _entr_points,
+                               uint64_t&                    _loop_id) const;
+
     // applies logic for all "is_*" and "can_*" checks below
     bool should_instrument() const;
     bool should_coverage_instrument() const;
@@ -96,6 +106,9 @@ struct module_function
     bool is_visibility_constrained() const;
     bool is_linkage_constrained() const;
 
+    // checks the inclusive time and estimated overhead in the profile (see --profile)
+    bool is_profile_constrained() const;
+
     size_t                                      start_address     = 0;
     uint64_t                                    address_range     = 0;
     uint64_t                                    num_instructions  = 0;
@@ -111,6 +124,11 @@ struct module_function
     std::map<instruction_category_t, int64_t>   instruction_types = {};
     std::vector<std::vector<instr_addr_pair_t>> instructions      = {};
 
+    // the hash of the bytes of the function and whether the analysis was skipped
+    // because a previous invocation excluded the function (see instrument_cache)
+    uint64_t function_hash = 0;
+    bool     cached        = false;
+
     mutable str_msg_vec_t messages = {};
 
     bool is_overlapping() const;  // checks if func overlaps
@@ -21,9 +21,11 @@
 // SOFTWARE.
 
 #include "omnitrace-instrument.hpp"
+#include "attach_sampler.hpp"
 #include "common/defines.h"
 #include "dl/dl.hpp"
 #include "fwd.hpp"
+#include "instrument_cache.hpp"
 #include "internal_libs.hpp"
 #include "log.hpp"
 
@@ -99,17 +101,26 @@ bool   loop_level_instr             = false;
 bool   instr_dynamic_callsites      = false;
 bool   instr_traps                  = false;
 bool   instr_loop_traps             = false;
+bool   instr_loop_trip_counts       = false;
+bool   instr_trace_gate             = true;
 bool   parse_all_modules            = false;
 size_t min_address_range            = get_default_min_address_range();  // 4096
 size_t min_loop_address_range       = get_default_min_address_range();  // 4096
 size_t min_instructions             = get_default_min_instructions();   // 1024
 size_t min_loop_instructions        = get_default_min_instructions();   // 1024
+double profile_min_fraction         = 1.0e-3;
+double profile_max_overhead         = 0.05;
+double profile_call_overhead        = 1.0e-6;
+double attach_sample_duration       = 0.0;
+size_t attach_sample_top            = 32;
+size_t attach_sample_freq           = 999;
 bool   werror                       = false;
 bool   debug_print                  = false;
 bool   instr_print                  = false;
 bool   simulate                     = false;
 bool   include_uninstr              = false;
 bool   include_internal_linked_libs = false;
+size_t analysis_threads             = 1;
 int    verbose_level   = tim::get_env<int>("OMNITRACE_VERBOSE_INSTRUMENT", 0);
 int    num_log_entries = tim::get_env<int>(
     "OMNITRACE_LOG_COUNT", tim::get_env<bool>("OMNITRACE_CI", false) ? 20 : 50);
@@ -117,11 +128,15 @@ string_t main_fname     = "main";
 string_t argv0          = {};
 string_t cmdv0          = {};
 string_t prefer_library = {};
+string_t instrument_cache_dir =
+    tim::get_env<string_t>("OMNITRACE_INSTRUMENT_CACHE_DIR", "");
+sampling_profile profile_guide = {};
 //
 //  global variables
 //
 patch_pointer_t  bpatch                        = {};
 call_expr_t*     terminate_expr                = nullptr;
+variable_expr_t* trace_gate                    = nullptr;
 snippet_vec_t    init_names                    = {};
 snippet_vec_t    fini_names                    = {};
 fmodset_t        available_module_functions    = {};
@@ -141,6 +156,7 @@ regexvec_t       func_internal_include         = {};
 regexvec_t       file_internal_include         = {};
 regexvec_t       instruction_exclude           = {};
 CodeCoverageMode coverage_mode                 = CODECOV_NONE;
+bool             coverage_counters             = false;
 
 symtab_data_s                 symtab_data        = {};
 std::set<symbol_linkage_t>    enabled_linkage    = { SL_GLOBAL, SL_LOCAL, SL_UNIQUE };
@@ -900,6 +916,19 @@ main(int argc, char** argv)
         .dtype("boolean")
         .max_count(1)
         .action([](parser_t& p) { loop_level_instr = p.get<bool>("instrument-loops"); });
+    parser
+        .add_argument({ "--loop-trip-counts" },
+                      "Instrument the loops by incrementing a per-thread trip counter at "
+                      "the start of every iteration instead of starting and stopping a "
+                      "region at the loop entry and exit. The counters are recorded by "
+                      "the sampler so the trip count and the trip rate of every loop "
+                      "appear in the perfetto trace. Implies --instrument-loops")
+        .dtype("boolean")
+        .max_count(1)
+        .action([](parser_t& p) {
+            instr_loop_trip_counts = p.get<bool>("loop-trip-counts");
+            if(instr_loop_trip_counts) loop_level_instr = true;
+        });
     parser
         .add_argument({ "-i", "--min-instructions" },
                       "If the number of instructions in a function is less than this "
@@ -934,6 +963,90 @@ main(int argc, char** argv)
         .action([](parser_t& p) {
             min_loop_address_range = p.get<size_t>("min-address-range-loop");
         });
+    parser
+        .add_argument({ "--profile" },
+                      "Timemory JSON profile of a previous run, e.g. the "
+                      "sampling_wall_clock.json of omnitrace-sample. Only the functions "
+                      "in the profile whose inclusive time and estimated overhead "
+                      "satisfy --profile-min-fraction and --profile-max-overhead are "
+                      "instrumented. The --min-instructions and --min-address-range "
+                      "heuristics are not applied to the functions in the profile")
+        .count(1)
+        .dtype("filepath")
+        .action([](parser_t& p) {
+            profile_guide = sampling_profile::load(p.get<string_t>("profile"));
+            verbprintf(0, "Loaded %zu functions from the %s profile '%s'\n",
+                       profile_guide.entries.size(), profile_guide.metric.c_str(),
+                       profile_guide.filename.c_str());
+        });
+    parser
+        .add_argument({ "--profile-min-fraction" },
+                      "Exclude the functions in the profile whose inclusive time is less "
+                      "than this fraction of the total time")
+        .count(1)
+        .dtype("double")
+        .set_default(profile_min_fraction)
+        .action([](parser_t& p) {
+            profile_min_fraction = p.get<double>("profile-min-fraction");
+        });
+    parser
+        .add_argument({ "--profile-max-overhead" },
+                      "Exclude the functions in the profile whose estimated number of "
+                      "calls times --profile-call-overhead exceeds this fraction of "
+                      "their inclusive time. When the profile is sampled, the calls are "
+                      "only estimated for the functions without loops (from the "
+                      "exclusive time and the number of instructions)")
+        .count(1)
+        .dtype("double")
+        .set_default(profile_max_overhead)
+        .action([](parser_t& p) {
+            profile_max_overhead = p.get<double>("profile-max-overhead");
+        });
+    parser
+        .add_argument({ "--profile-call-overhead" },
+                      "Estimated overhead of the instrumentation per call in seconds")
+        .count(1)
+        .dtype("double")
+        .set_default(profile_call_overhead)
+        .action([](parser_t& p) {
+            profile_call_overhead = p.get<double>("profile-call-overhead");
+        });
+    parser
+        .add_argument({ "--attach-sample" },
+                      "Requires --pid. Sample the call-stacks of the process for this "
+                      "many seconds before attaching and only instrument the "
+                      "--attach-sample-top functions with the most exclusive samples and "
+                      "their callers, i.e. --profile without a previous run. The callers "
+                      "are only sampled in the code with frame pointers. The "
+                      "--profile-min-fraction and --profile-max-overhead filters are "
+                      "applied to the sampled functions and the instrumentation cache is "
+                      "not used")
+        .count(1)
+        .dtype("double")
+        .set_default(attach_sample_duration)
+        .action([](parser_t& p) {
+            attach_sample_duration = p.get<double>("attach-sample");
+        });
+    parser
+        .add_argument({ "--attach-sample-top" },
+                      "Number of functions with the most exclusive samples which are "
+                      "instrumented with --attach-sample")
+        .count(1)
+        .dtype("int")
+        .set_default(attach_sample_top)
+        .action([](parser_t& p) {
+            attach_sample_top = p.get<size_t>("attach-sample-top");
+        });
+    parser
+        .add_argument({ "--attach-sample-freq" },
+                      "Samples per second of CPU time of each thread with "
+                      "--attach-sample")
+        .count(1)
+        .dtype("int")
+        .set_default(attach_sample_freq)
+        .action([](parser_t& p) {
+            attach_sample_freq = std::max<size_t>(p.get<size_t>("attach-sample-freq"), 1);
+        });
     parser
         .add_argument(
             { "--coverage" },
@@ -952,6 +1065,19 @@ main(int argc, char** argv)
             else
                 coverage_mode = CODECOV_NONE;
         });
+    parser
+        .add_argument({ "--coverage-counters" },
+                      "Record the code coverage by incrementing a counter which is "
+                      "allocated in the binary for every function or basic block instead "
+                      "of calling into the runtime. The counters are registered with the "
+                      "runtime once at the start of main and are only read at the end of "
+                      "the run. The increments are not atomic so the counts of the "
+                      "blocks executed concurrently by several threads may be "
+                      "underestimated")
+        .max_count(1)
+        .dtype("boolean")
+        .action(
+            [](parser_t& p) { coverage_counters = p.get<bool>("coverage-counters"); });
     parser
         .add_argument({ "--dynamic-callsites" },
                       "Force instrumentation if a function has dynamic callsites (e.g. "
@@ -983,6 +1109,17 @@ main(int argc, char** argv)
         .dtype("boolean")
         .set_default(instr_loop_traps)
         .action([](parser_t& p) { instr_loop_traps = p.get<bool>("loop-traps"); });
+    parser
+        .add_argument({ "--trace-gate" },
+                      "Load the trace gate of libomnitrace-dl before calling "
+                      "omnitrace_push_trace and omnitrace_pop_trace and skip the calls "
+                      "while it is closed, i.e. before omnitrace is initialized, after "
+                      "it is finalized and while the trace is stopped via "
+                      "omnitrace_user_stop_trace()")
+        .max_count(1)
+        .dtype("boolean")
+        .set_default(instr_trace_gate)
+        .action([](parser_t& p) { instr_trace_gate = p.get<bool>("trace-gate"); });
     parser
         .add_argument(
             { "--allow-overlapping" },
@@ -1003,6 +1140,29 @@ main(int argc, char** argv)
         .max_count(1)
         .action(
             [](parser_t& p) { parse_all_modules = p.get<bool>("parse-all-modules"); });
+    parser
+        .add_argument({ "--analysis-threads" },
+                      "Number of threads used to analyze the functions (control flow "
+                      "graph, instructions, file and line info) in the modules before "
+                      "the instrumentation is inserted. The insertion of the "
+                      "instrumentation is always serial. A value of zero uses the number "
+                      "of hardware threads")
+        .count(1)
+        .dtype("int")
+        .set_default(analysis_threads)
+        .action(
+            [](parser_t& p) { analysis_threads = p.get<size_t>("analysis-threads"); });
+    parser
+        .add_argument({ "--cache-dir" },
+                      "Directory of a cache which persists between invocations. It holds "
+                      "the functions of the internal libraries and the instrumentation "
+                      "decision of every function. The functions which were excluded by "
+                      "a previous invocation with the same options and whose bytes are "
+                      "unchanged are not analyzed again. Default is the value of "
+                      "OMNITRACE_INSTRUMENT_CACHE_DIR. Empty disables the cache")
+        .count(1)
+        .dtype("filepath")
+        .action([](parser_t& p) { instrument_cache_dir = p.get<string_t>("cache-dir"); });
 
     parser.add_argument({ "" }, "");
     parser.add_argument({ "[DYNINST OPTIONS]" }, "");
@@ -1053,6 +1213,21 @@ main(int argc, char** argv)
         return -1;
     }
 
+    if(attach_sample_duration > 0.0)
+    {
+        if(_pid < 0) errprintf(-1, "--attach-sample requires --pid\n");
+        if(!profile_guide.empty())
+            errprintf(-1, "--attach-sample and --profile are mutually exclusive\n");
+        // the functions depend on the samples, which are not part of the cache key
+        if(!instrument_cache_dir.empty())
+        {
+            verbprintf(1, "Disabling the instrumentation cache with --attach-sample\n");
+            instrument_cache_dir.clear();
+        }
+    }
+
+    instrument_cache::set_options(_argc, _argv);
+
     if(parser.exists("config"))
     {
         struct omnitrace_env_config_s
@@ -1248,7 +1423,7 @@ main(int argc, char** argv)
                                              regex_expr, "\" to regex_array@",
                                              &regex_array);
             if(!regex_expr.empty())
-                regex_array.emplace_back(std::regex(regex_expr, regex_opts));
+                regex_array.emplace_back(regex_expr, regex_opts);
         };
 
         add_regex(func_include, tim::get_env<string_t>("OMNITRACE_REGEX_INCLUDE", ""));
@@ -1402,6 +1577,25 @@ main(int argc, char** argv)
     env_vars.emplace_back(TIMEMORY_JOIN('=', "OMNITRACE_USE_CODE_COVERAGE",
                                         (coverage_mode != CODECOV_NONE) ? "ON" : "OFF"));
 
+    // the process is sampled before the attach stops it
+    auto _attach_samples = attach_sampler::result{};
+    if(attach_sample_duration > 0.0)
+    {
+        verbprintf(0, "Sampling process %i for %.3f seconds at %zu Hz...\n", _pid,
+                   attach_sample_duration, attach_sample_freq);
+        try
+        {
+            _attach_samples = attach_sampler::sample(_pid, attach_sample_duration,
+                                                     attach_sample_freq);
+        } catch(std::exception& _e)
+        {
+            errprintf(-1, "%s\n", _e.what());
+        }
+        verbprintf(0, "Sampled %zu call-stacks of %zu threads (%zu lost)\n",
+                   _attach_samples.samples.size(), _attach_samples.threads,
+                   _attach_samples.lost);
+    }
+
     addr_space = omnitrace_get_address_space(bpatch, _cmdc, _cmdv, env_vars,
                                              binary_rewrite, _pid, mutname);
 
@@ -1439,6 +1633,46 @@ main(int argc, char** argv)
     std::set<module_t*>        modules       = {};
     std::set<procedure_t*>     functions     = {};
 
+    if(attach_sample_duration > 0.0)
+    {
+        profile_guide = sampling_profile::from_samples(
+            _attach_samples.samples, _attach_samples.period, attach_sample_top,
+            [](uintptr_t _addr) {
+                auto* _func =
+                    addr_space->findFunctionByAddr(reinterpret_cast<void*>(_addr));
+                return (_func) ? std::string{ get_name(_func) } : std::string{};
+            });
+
+        if(profile_guide.empty())
+        {
+            errprintf(0,
+                      "no functions were sampled in process %i. The default "
+                      "heuristics are applied\n",
+                      _pid);
+        }
+        else
+        {
+            using entry_t = std::pair<std::string, sampling_profile::entry>;
+            auto _ranked  = std::vector<entry_t>{ profile_guide.entries.begin(),
+                                                 profile_guide.entries.end() };
+            std::sort(_ranked.begin(), _ranked.end(),
+                      [](const entry_t& _lhs, const entry_t& _rhs) {
+                          return _lhs.second.exclusive > _rhs.second.exclusive;
+                      });
+            verbprintf(0, "Selected %zu sampled functions (self %% / inclusive %%):\n",
+                       _ranked.size());
+            for(const auto& itr : _ranked)
+            {
+                verbprintf(1, "    %6.2f %% / %6.2f %% :: %s\n",
+                           100.0 * itr.second.exclusive / profile_guide.total,
+                           100.0 * itr.second.inclusive / profile_guide.total,
+                           itr.first.c_str());
+            }
+        }
+    }
+
+    instrument_cache::load_functions(mutname);
+
     if(app_modules) process_modules(*app_modules);
 
     //----------------------------------------------------------------------------------//
@@ -1472,6 +1706,38 @@ main(int argc, char** argv)
         }
     };
 
+    // the module functions are constructed concurrently, one module per task, since
+    // the construction queries the control flow graph, the instructions, and the line
+    // info of every function. The containers are only modified on this thread
+    auto _add_module_functions =
+        [&module_names, &_add_overlapping](
+            const std::map<module_t*, std::vector<procedure_t*>>& _procedures) {
+            auto _modules = std::vector<module_t*>{};
+            auto _modfns  = std::vector<std::vector<module_function>>{};
+            _modules.reserve(_procedures.size());
+            _modfns.resize(_procedures.size());
+            for(const auto& itr : _procedures)
+                _modules.emplace_back(itr.first);
+
+            parallel_for(_modules.size(), [&](size_t _idx) {
+                auto* _mod = _modules.at(_idx);
+                auto& _v   = _modfns.at(_idx);
+                _v.reserve(_procedures.at(_mod).size());
+                for(auto* itr : _procedures.at(_mod))
+                    _v.emplace_back(_mod, itr);
+            });
+
+            for(const auto& itr : _modfns)
+            {
+                for(const auto& fitr : itr)
+                {
+                    module_names.insert(fitr.module_name);
+                    _insert_module_function(available_module_functions, fitr);
+                    _add_overlapping(fitr.module, fitr.function);
+                }
+            }
+        };
+
     if(app_functions && !app_functions->empty())
     {
         for(auto* itr : *app_functions)
@@ -1484,17 +1750,13 @@ main(int argc, char** argv)
         }
         verbprintf(2, "Adding %zu procedures found in the app image...\n",
                    functions.size());
+        auto _procedures = std::map<module_t*, std::vector<procedure_t*>>{};
         for(auto* itr : functions)
         {
             if(itr->isInstrumentable() || (simulate && include_uninstr))
-            {
-                module_t* mod    = itr->getModule();
-                auto      _modfn = module_function{ mod, itr };
-                module_names.insert(_modfn.module_name);
-                _insert_module_function(available_module_functions, _modfn);
-                _add_overlapping(mod, itr);
-            }
+                _procedures[itr->getModule()].emplace_back(itr);
         }
+        _add_module_functions(_procedures);
     }
     else
     {
@@ -1511,6 +1773,7 @@ main(int argc, char** argv)
         verbprintf(2,
                    "Adding the procedures from %zu modules found in the app image...\n",
                    modules.size());
+        auto _procedures = std::map<module_t*, std::vector<procedure_t*>>{};
         for(auto* itr : modules)
         {
             auto* procedures = itr->getProcedures(include_uninstr);
@@ -1523,13 +1786,11 @@ main(int argc, char** argv)
                     if(!pitr->isInstrumentable() && !simulate && !include_uninstr)
                         continue;
                     functions.emplace(pitr);
-                    auto _modfn = module_function{ itr, pitr };
-                    module_names.insert(_modfn.module_name);
-                    _insert_module_function(available_module_functions, _modfn);
-                    _add_overlapping(itr, pitr);
+                    _procedures[itr].emplace_back(pitr);
                 }
             }
         }
+        _add_module_functions(_procedures);
     }
     else if(parse_all_modules)
     {
@@ -1705,6 +1966,17 @@ main(int argc, char** argv)
     auto* reg_src_func   = find_function(app_image, "omnitrace_register_source");
     auto* reg_cov_func   = find_function(app_image, "omnitrace_register_coverage");
     auto* set_instr_func = find_function(app_image, "omnitrace_set_instrumented");
+    auto* reg_cnt_func = find_function(app_image, "omnitrace_register_coverage_counter");
+    auto* reg_loop_func  = find_function(app_image, "omnitrace_register_loop");
+    auto* loop_trip_func = find_function(app_image, "omnitrace_loop_trip");
+
+    if(instr_trace_gate)
+    {
+        trace_gate = app_image->findVariable("omnitrace_dl_trace_gate", false);
+        if(!trace_gate)
+            verbprintf(0, "Warning! 'omnitrace_dl_trace_gate' was not found. The "
+                          "instrumentation will call into omnitrace unconditionally\n");
+    }
 
     if(!main_func && main_fname == "main") main_func = find_function(app_image, "_main");
 
@@ -1837,6 +2109,22 @@ main(int argc, char** argv)
         }
     }
 
+    if(coverage_mode != CODECOV_NONE && coverage_counters && !reg_cnt_func)
+    {
+        errprintf(-1, "could not find required function :: '%s'\n",
+                  "omnitrace_register_coverage_counter");
+    }
+
+    for(const auto& itr : { pair_t{ reg_loop_func, "omnitrace_register_loop" },
+                            pair_t{ loop_trip_func, "omnitrace_loop_trip" } })
+    {
+        if(instr_loop_trip_counts && !itr.first)
+        {
+            errprintf(-1, "could not find required function :: '%s'\n",
+                      itr.second.c_str());
+        }
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //  Find the entry/exit point of either the main (if executable) or the _init
@@ -1989,47 +2277,59 @@ main(int argc, char** argv)
     //
     //----------------------------------------------------------------------------------//
 
-    if(instr_mode != "sampling")
+    // the checks of the module functions are evaluated concurrently and the results
+    // are used to sort the module functions serially
+    struct module_function_checks
     {
-        for(const auto& itr : available_module_functions)
+        bool instrument = false;
+        bool coverage   = false;
+        bool overlap    = false;
+    };
+
+    auto _available = std::vector<const module_function*>{};
+    auto _checks    = std::vector<module_function_checks>{};
+    _available.reserve(available_module_functions.size());
+    for(const auto& itr : available_module_functions)
+        _available.emplace_back(&itr);
+    _checks.resize(_available.size());
+
+    parallel_for(_available.size(), [&](size_t _idx) {
+        const auto& itr = *_available.at(_idx);
+        // the checks are evaluated in order since they append to the messages
+        _checks.at(_idx) = {
+            (instr_mode != "sampling" && itr.should_instrument()),
+            (coverage_mode != CODECOV_NONE && itr.should_coverage_instrument()),
+            itr.is_overlapping()
+        };
+    });
+
+    // in sampling mode, we instrument either main or add init and fini callbacks
+    if(instr_mode == "sampling" && main_func)
+        _insert_module_function(instrumented_module_functions,
+                                module_function{ main_func->getModule(), main_func });
+
+    for(size_t i = 0; i < _available.size(); ++i)
+    {
+        const auto& itr = *_available.at(i);
+        const auto& _v  = _checks.at(i);
+        if(_v.instrument)
         {
-            if(itr.should_instrument())
-            {
-                _insert_module_function(instrumented_module_functions, itr);
-            }
-            else
-            {
-                _insert_module_function(excluded_module_functions, itr);
-            }
-            if(coverage_mode != CODECOV_NONE)
-            {
-                if(itr.should_coverage_instrument())
-                    _insert_module_function(coverage_module_functions, itr);
-            }
-            if(itr.is_overlapping())
-                _insert_module_function(overlapping_module_functions, itr);
+            _insert_module_function(instrumented_module_functions, itr);
         }
-    }
-    else
-    {
-        // in sampling mode, we instrument either main or add init and fini callbacks
-        if(main_func)
-            _insert_module_function(instrumented_module_functions,
-                                    module_function{ main_func->getModule(), main_func });
-
-        for(const auto& itr : available_module_functions)
+        else
         {
             _insert_module_function(excluded_module_functions, itr);
-            if(coverage_mode != CODECOV_NONE)
-            {
-                if(itr.should_coverage_instrument())
-                    _insert_module_function(coverage_module_functions, itr);
-            }
-            if(itr.is_overlapping())
-                _insert_module_function(overlapping_module_functions, itr);
         }
+        if(_v.coverage) _insert_module_function(coverage_module_functions, itr);
+        if(_v.overlap) _insert_module_function(overlapping_module_functions, itr);
+
+        instrument_cache::record_function(
+            itr.module_name, itr.function_name, itr.function_hash,
+            { itr.address_range, itr.num_instructions, _v.instrument, _v.coverage });
     }
 
+    instrument_cache::save_functions();
+
     //----------------------------------------------------------------------------------//
     //
     //  Insert the initialization and finalization routines into the main entry and
@@ -2146,10 +2446,24 @@ main(int argc, char** argv)
     {
         auto      _pass_info        = std::map<std::string, std::pair<size_t, size_t>>{};
         const int _pass_verbose_lvl = 0;
+        uint64_t  _loop_id          = 0;
+
+        if(instr_loop_trip_counts && !main_entr_points)
+        {
+            errprintf(0, "the loop trip counts require the entry points of the main "
+                         "function. The loops will not be instrumented\n");
+        }
+
         for(const auto& itr : instrumented_module_functions)
         {
             if(itr.function == main_func) continue;
             auto _count = itr(addr_space, entr_trace, exit_trace);
+            if(instr_loop_trip_counts && main_entr_points)
+            {
+                _count.second += itr.register_loop_trips(addr_space, reg_loop_func,
+                                                         loop_trip_func,
+                                                         *main_entr_points, _loop_id);
+            }
             _pass_info[itr.module_name].first += _count.first;
             _pass_info[itr.module_name].second += _count.second;
 
@@ -2183,8 +2497,17 @@ main(int argc, char** argv)
         for(const auto& itr : coverage_module_functions)
         {
             if(itr.function == main_func) continue;
-            itr.register_source(addr_space, reg_src_func, *main_entr_points);
-            auto _count = itr.register_coverage(addr_space, reg_cov_func);
+            auto _count = std::pair<size_t, size_t>{};
+            if(coverage_counters)
+            {
+                _count = itr.register_coverage_counters(addr_space, reg_cnt_func,
+                                                        *main_entr_points);
+            }
+            else
+            {
+                itr.register_source(addr_space, reg_src_func, *main_entr_points);
+                _count = itr.register_coverage(addr_space, reg_cov_func);
+            }
             _covr_info[itr.module_name].first += _count.first;
             _covr_info[itr.module_name].second += _count.second;
 
@@ -2532,6 +2855,7 @@ bool
 query_instr(procedure_t* funcToInstr, procedure_loc_t traceLoc, flow_graph_t* cfGraph,
             basic_loop_t* loopToInstrument, bool allow_traps)
 {
+    auto      _lk    = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
     module_t* module = funcToInstr->getModule();
     if(!module) return false;
 
@@ -2568,6 +2892,7 @@ std::tuple<size_t, size_t>
 query_instr(procedure_t* funcToInstr, procedure_loc_t traceLoc, flow_graph_t* cfGraph,
             basic_loop_t* loopToInstrument)
 {
+    auto      _lk    = std::unique_lock<std::recursive_mutex>{ get_dyninst_mutex() };
     module_t* module = funcToInstr->getModule();
     if(!module) return { 0, 0 };
 
@@ -2576,7 +2901,8 @@ query_instr(procedure_t* funcToInstr, procedure_loc_t traceLoc, flow_graph_t* cf
     std::vector<point_t*>* _points = nullptr;
 
     if((cfGraph && loopToInstrument) ||
-       (traceLoc == BPatch_locLoopEntry || traceLoc == BPatch_locLoopExit))
+       (traceLoc == BPatch_locLoopEntry || traceLoc == BPatch_locLoopExit ||
+        traceLoc == BPatch_locLoopStartIter))
     {
         if(!cfGraph) throw std::runtime_error("No control flow graph");
         if(!loopToInstrument) throw std::runtime_error("No loop to instrument");
@@ -2589,6 +2915,11 @@ query_instr(procedure_t* funcToInstr, procedure_loc_t traceLoc, flow_graph_t* cf
         {
             _points = cfGraph->findLoopInstPoints(BPatch_locLoopExit, loopToInstrument);
         }
+        else if(traceLoc == BPatch_locLoopStartIter)
+        {
+            _points =
+                cfGraph->findLoopInstPoints(BPatch_locLoopStartIter, loopToInstrument);
+        }
         else
         {
             throw std::runtime_error("unsupported trace location :: " +
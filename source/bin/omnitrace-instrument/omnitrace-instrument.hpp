@@ -54,7 +54,9 @@ to_lower(string_t s)
 //
 //======================================================================================//
 //
-template <typename Tp, std::enable_if_t<!std::is_same<Tp, std::string>::value, int> = 0>
+template <typename Tp, std::enable_if_t<!std::is_same<Tp, std::string>::value &&
+                                            !std::is_same<Tp, snippet_pointer_t>::value,
+                                        int> = 0>
 snippet_pointer_t
 get_snippet(Tp arg)
 {
@@ -63,6 +65,17 @@ get_snippet(Tp arg)
 //
 //======================================================================================//
 //
+// a snippet which is not a constant, e.g. the address of a variable
+template <typename Tp,
+          std::enable_if_t<std::is_same<Tp, snippet_pointer_t>::value, int> = 0>
+snippet_pointer_t
+get_snippet(Tp arg)
+{
+    return arg;
+}
+//
+//======================================================================================//
+//
 template <typename Tp, std::enable_if_t<std::is_same<Tp, std::string>::value, int> = 0>
 snippet_pointer_t
 get_snippet(const Tp& arg)
@@ -112,6 +125,20 @@ private:
 //
 //======================================================================================//
 //
+// only performs the call while the trace gate of libomnitrace-dl is open so that the
+// paused instrumentation costs a load and a branch
+inline snippet_pointer_t
+get_gated_snippet(const call_expr_pointer_t& _call)
+{
+    if(!_call) return snippet_pointer_t{};
+    if(!trace_gate) return snippet_pointer_t{ _call };
+
+    auto _cond = bool_expr_t{ BPatch_ne, *trace_gate, const_expr_t{ 0 } };
+    return snippet_pointer_t{ new if_expr_t{ _cond, *_call } };
+}
+//
+//======================================================================================//
+//
 struct omnitrace_snippet_vec
 {
     using entry_type = std::vector<omnitrace_call_expr>;
@@ -444,6 +471,9 @@ insert_instr(address_space_t* mutatee, procedure_t* funcToInstr, Tp traceFunc,
             _points = cfGraph->findLoopInstPoints(BPatch_locLoopEntry, loopToInstrument);
         else if(traceLoc == BPatch_exit)
             _points = cfGraph->findLoopInstPoints(BPatch_locLoopExit, loopToInstrument);
+        else if(traceLoc == BPatch_locLoopStartIter)
+            _points =
+                cfGraph->findLoopInstPoints(BPatch_locLoopStartIter, loopToInstrument);
     }
     else
     {
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "regex_set.hpp"
+
+#include <algorithm>
+
+namespace
+{
+bool
+is_literal(std::string_view _v, std::regex_constants::syntax_option_type _opts)
+{
+    // case-insensitive patterns can not be matched with a substring search
+    if((_opts & std::regex_constants::icase) == std::regex_constants::icase) return false;
+    return _v.find_first_of(".[]()*+?{}|^$\\\n") == std::string_view::npos;
+}
+}  // namespace
+
+void
+regex_set::emplace_back(const std::string& _pattern, syntax_t _opts)
+{
+    // always compiled so that an invalid pattern is reported when it is added
+    auto _regex = std::regex{ _pattern, _opts };
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    m_cache.clear();
+    ++m_size;
+
+    if(is_literal(_pattern, _opts))
+    {
+        m_literals.emplace_back(_pattern);
+        return;
+    }
+
+    m_patterns.emplace_back(_pattern, _opts);
+    m_regexes.emplace_back(std::move(_regex));
+    m_combined.reset();
+
+    // the patterns can only be combined when they use the same syntax options. If the
+    // combination is not possible, the regexes are searched individually
+    auto _expr = std::string{};
+    for(const auto& itr : m_patterns)
+    {
+        if(itr.second != _opts) return;
+        if(!_expr.empty()) _expr += "|";
+        _expr += "(" + itr.first + ")";
+    }
+
+    try
+    {
+        m_combined = std::regex{ _expr, _opts };
+    } catch(std::regex_error&)
+    {
+        m_combined.reset();
+    }
+}
+
+bool
+regex_set::search(const std::string& _value, bool _cache) const
+{
+    if(!_cache) return search_impl(_value);
+
+    {
+        auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+        auto itr = m_cache.find(_value);
+        if(itr != m_cache.end()) return itr->second;
+    }
+
+    auto _result = search_impl(_value);
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    if(m_cache.size() < max_cache_size) m_cache.emplace(_value, _result);
+    return _result;
+}
+
+bool
+regex_set::search_impl(const std::string& _value) const
+{
+    for(const auto& itr : m_literals)
+        if(_value.find(itr) != std::string::npos) return true;
+
+    if(m_combined) return std::regex_search(_value, *m_combined);
+
+    return std::any_of(m_regexes.begin(), m_regexes.end(), [&_value](const auto& itr) {
+        return std::regex_search(_value, itr);
+    });
+}
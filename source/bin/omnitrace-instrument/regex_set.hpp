@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// the regular expressions of an include/exclude/restrict option. The patterns without
+/// any special characters are matched with a substring search and the remaining
+/// patterns are combined into a single regex so a name is scanned at most once per
+/// set. The result is cached per name since the same module and function names are
+/// checked by several of the constraints of every module function
+class regex_set
+{
+public:
+    using syntax_t = std::regex_constants::syntax_option_type;
+
+    static constexpr size_t max_cache_size = (1 << 20);
+
+    regex_set()  = default;
+    ~regex_set() = default;
+
+    regex_set(const regex_set&) = delete;
+    regex_set& operator=(const regex_set&) = delete;
+
+    /// throws std::regex_error if the pattern is not a valid regex. Must not be
+    /// invoked concurrently with search
+    void emplace_back(const std::string& _pattern, syntax_t _opts);
+
+    bool   empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+    /// returns true if any of the patterns matches a sub-sequence of the value
+    bool search(const std::string& _value, bool _cache = true) const;
+
+private:
+    bool search_impl(const std::string& _value) const;
+
+    size_t                                        m_size     = 0;
+    std::vector<std::string>                      m_literals = {};
+    std::vector<std::pair<std::string, syntax_t>> m_patterns = {};
+    std::vector<std::regex>                       m_regexes  = {};
+    std::optional<std::regex>                     m_combined = {};
+    mutable std::mutex                            m_mutex    = {};
+    mutable std::unordered_map<std::string, bool> m_cache    = {};
+};
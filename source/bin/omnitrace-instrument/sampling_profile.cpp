@@ -0,0 +1,268 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "sampling_profile.hpp"
+
+#include <timemory/mpl/policy.hpp>
+#include <timemory/tpls/cereal/archives.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/join.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+namespace cereal = ::tim::cereal;
+using ::timemory::join::join;
+
+// upper bound on the time per instruction of a function without loops which is used
+// to estimate the minimum number of calls from its exclusive time
+constexpr double instruction_time = 1.0e-9;
+
+// seconds per unit of the "repr_data" values
+double
+get_unit_seconds(const std::string& _unit)
+{
+    static const auto _units = std::map<std::string, double>{
+        { "nsec", 1.0e-9 }, { "ns", 1.0e-9 }, { "usec", 1.0e-6 }, { "us", 1.0e-6 },
+        { "msec", 1.0e-3 }, { "ms", 1.0e-3 }, { "sec", 1.0 },     { "s", 1.0 },
+        { "min", 60.0 },    { "hr", 3600.0 },
+    };
+
+    auto itr = _units.find(_unit);
+    if(itr == _units.end())
+        throw std::runtime_error(join("", "unsupported unit of the profile: ", _unit));
+    return itr->second;
+}
+
+// removes the thread prefix and the indentation, e.g. "|0>>>   |_foo" -> "foo"
+std::string
+get_function_name(std::string _prefix)
+{
+    auto _pos = _prefix.find(">>> ");
+    if(_pos != std::string::npos) _prefix = _prefix.substr(_pos + 4);
+    _pos = _prefix.find_first_not_of(' ');
+    if(_pos != std::string::npos) _prefix = _prefix.substr(_pos);
+    if(_prefix.find("|_") == 0) _prefix = _prefix.substr(2);
+    return _prefix;
+}
+}  // namespace
+
+sampling_profile
+sampling_profile::load(const std::string& _fname)
+{
+    auto _ifs = std::ifstream{ _fname };
+    if(!_ifs) throw std::runtime_error(join("", "unable to open '", _fname, "'"));
+
+    auto _v     = sampling_profile{};
+    _v.filename = _fname;
+
+    try
+    {
+        auto ar = tim::policy::input_archive<cereal::JSONInputArchive>::get(_ifs);
+
+        ar->setNextName("timemory");
+        ar->startNode();
+
+        // the first component in the file
+        const char* _metric = ar->getNodeName();
+        if(!_metric) throw std::runtime_error("no component");
+        _v.metric  = _metric;
+        _v.sampled = (_v.metric.find("sampling_") == 0);
+
+        auto _unit = std::string{};
+        ar->setNextName(_v.metric.c_str());
+        ar->startNode();
+        (*ar)(cereal::make_nvp("unit_repr", _unit));
+
+        auto _seconds = get_unit_seconds(_unit);
+
+        ar->setNextName("ranks");
+        ar->startNode();
+        cereal::size_type _nranks = 0;
+        (*ar)(cereal::make_size_tag(_nranks));
+        for(cereal::size_type i = 0; i < _nranks; ++i)
+        {
+            ar->startNode();
+            ar->setNextName("graph");
+            ar->startNode();
+            cereal::size_type _nnodes = 0;
+            (*ar)(cereal::make_size_tag(_nnodes));
+
+            // the names of the ancestors of the current node
+            auto _stack = std::vector<std::string>{};
+            for(cereal::size_type j = 0; j < _nnodes; ++j)
+            {
+                auto     _prefix = std::string{};
+                int64_t  _depth  = 0;
+                uint64_t _laps   = 0;
+                double   _value  = 0.0;
+
+                ar->startNode();
+                (*ar)(cereal::make_nvp("prefix", _prefix),
+                      cereal::make_nvp("depth", _depth));
+                ar->setNextName("entry");
+                ar->startNode();
+                (*ar)(cereal::make_nvp("laps", _laps),
+                      cereal::make_nvp("repr_data", _value));
+                ar->finishNode();
+                ar->finishNode();
+
+                _value *= _seconds;
+
+                auto _name = get_function_name(_prefix);
+                _stack.resize(std::min<size_t>(std::max<int64_t>(_depth, 0),
+                                               _stack.size()));
+
+                auto& _entry = _v.entries[_name];
+                _entry.count += _laps;
+                _entry.exclusive += _value;
+                if(_stack.empty())
+                    _v.total += _value;
+                else
+                    _v.entries[_stack.back()].exclusive -= _value;
+
+                // the time of a recursive invocation is already included
+                if(std::find(_stack.begin(), _stack.end(), _name) == _stack.end())
+                    _entry.inclusive += _value;
+
+                _stack.emplace_back(std::move(_name));
+            }
+
+            ar->finishNode();
+            ar->finishNode();
+        }
+
+        ar->finishNode();
+        ar->finishNode();
+        ar->finishNode();
+    } catch(std::exception& _e)
+    {
+        throw std::runtime_error(
+            join("", "'", _fname, "' is not a timemory JSON profile: ", _e.what()));
+    }
+
+    return _v;
+}
+
+sampling_profile
+sampling_profile::from_samples(const std::vector<std::vector<uintptr_t>>& _samples,
+                               double _period, size_t _top,
+                               const std::function<std::string(uintptr_t)>& _resolver)
+{
+    auto _v    = sampling_profile{};
+    _v.metric  = "sampling_cpu_clock";
+    _v.sampled = true;
+    _v.total   = _samples.size() * _period;
+
+    // the names of the frames of every sample, innermost first. The return addresses
+    // point after the call instruction, which may be the first address of the next
+    // function, so the caller frames are resolved at the address before them
+    auto _names  = std::unordered_map<uintptr_t, std::string>{};
+    auto _stacks = std::vector<std::vector<const std::string*>>{};
+    auto _all    = std::unordered_map<std::string, entry>{};
+    _stacks.reserve(_samples.size());
+    for(const auto& itr : _samples)
+    {
+        auto _stack = std::vector<const std::string*>{};
+        auto _leaf  = false;
+        for(size_t i = 0; i < itr.size(); ++i)
+        {
+            auto _addr = (i == 0) ? itr.at(i) : itr.at(i) - 1;
+            auto nitr  = _names.find(_addr);
+            if(nitr == _names.end()) nitr = _names.emplace(_addr, _resolver(_addr)).first;
+            if(nitr->second.empty()) continue;
+            if(i == 0) _leaf = true;
+            _stack.emplace_back(&nitr->second);
+        }
+        if(_stack.empty()) continue;
+
+        if(_leaf)
+        {
+            auto& _entry = _all[*_stack.front()];
+            _entry.exclusive += _period;
+            _entry.count += 1;
+        }
+
+        // recursive frames are only counted once per sample
+        auto _seen = std::unordered_set<const std::string*>{};
+        for(const auto* nitr : _stack)
+        {
+            if(_seen.emplace(nitr).second) _all[*nitr].inclusive += _period;
+        }
+        _stacks.emplace_back(std::move(_stack));
+    }
+
+    using value_type = std::pair<std::string, entry>;
+    auto _ranked     = std::vector<value_type>{ _all.begin(), _all.end() };
+    std::sort(_ranked.begin(), _ranked.end(),
+              [](const value_type& _lhs, const value_type& _rhs) {
+                  if(_lhs.second.exclusive != _rhs.second.exclusive)
+                      return _lhs.second.exclusive > _rhs.second.exclusive;
+                  if(_lhs.second.inclusive != _rhs.second.inclusive)
+                      return _lhs.second.inclusive > _rhs.second.inclusive;
+                  return _lhs.first < _rhs.first;
+              });
+    if(_ranked.size() > _top) _ranked.resize(_top);
+
+    auto _selected = std::unordered_set<std::string>{};
+    for(auto& itr : _ranked)
+    {
+        _selected.emplace(itr.first);
+        _v.entries.emplace(itr.first, itr.second);
+    }
+
+    // the direct callers of the selected functions
+    for(const auto& itr : _stacks)
+    {
+        for(size_t i = 0; i + 1 < itr.size(); ++i)
+        {
+            if(*itr.at(i) == *itr.at(i + 1) || _selected.count(*itr.at(i)) == 0)
+                continue;
+            _v.entries.emplace(*itr.at(i + 1), _all.at(*itr.at(i + 1)));
+        }
+    }
+
+    return _v;
+}
+
+const sampling_profile::entry*
+sampling_profile::find(const std::string& _name) const
+{
+    auto itr = entries.find(_name);
+    return (itr != entries.end()) ? &itr->second : nullptr;
+}
+
+double
+sampling_profile::get_calls(const entry& _entry, uint64_t _num_instructions,
+                            bool _has_loops) const
+{
+    if(!sampled) return static_cast<double>(_entry.count);
+    if(_has_loops || _num_instructions == 0) return 0.0;
+    return std::max(_entry.exclusive, 0.0) / (_num_instructions * instruction_time);
+}
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// the functions of a timemory JSON profile of a previous run, e.g. the
+/// sampling_wall_clock.json of omnitrace-sample. Used to select the functions whose
+/// instrumentation is worthwhile (see --profile)
+struct sampling_profile
+{
+    struct entry
+    {
+        double   inclusive = 0.0;  ///< seconds, excluding the recursive invocations
+        double   exclusive = 0.0;  ///< seconds
+        uint64_t count     = 0;    ///< number of calls or, if sampled, of samples
+    };
+
+    /// throws std::runtime_error if the file is not a timemory JSON file
+    static sampling_profile load(const std::string& _fname);
+
+    /// the profile of the call-stacks sampled from a running process (innermost
+    /// address first, see --attach-sample): the _top functions with the most
+    /// exclusive samples, ties broken by the inclusive samples, and the functions
+    /// observed calling them. The resolver returns the name of the function at an
+    /// address or an empty string
+    static sampling_profile from_samples(
+        const std::vector<std::vector<uintptr_t>>& _samples, double _period,
+        size_t _top, const std::function<std::string(uintptr_t)>& _resolver);
+
+    bool         empty() const { return entries.empty(); }
+    const entry* find(const std::string& _name) const;
+
+    /// the estimated number of calls of the function. The count of the sampling
+    /// components is the number of samples so the calls of a function without loops
+    /// are estimated from its exclusive time and the number of instructions.
+    /// Returns zero if the number of calls can not be estimated
+    double get_calls(const entry&, uint64_t _num_instructions, bool _has_loops) const;
+
+    std::string                            filename = {};
+    std::string                            metric   = {};
+    bool                                   sampled  = false;
+    double                                 total    = 0.0;  ///< seconds
+    std::unordered_map<std::string, entry> entries  = {};
+};
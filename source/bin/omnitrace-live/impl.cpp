@@ -0,0 +1,174 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-live.hpp"
+
+#include "common/defines.h"
+
+#include <timemory/log/color.hpp>
+#include <timemory/utility/argparse.hpp>
+#include <timemory/utility/console.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace color = tim::log::color;
+using tim::log::monochrome;
+using tim::log::stream;
+
+live_config&
+get_live_config()
+{
+    static auto _v = live_config{};
+    return _v;
+}
+
+void
+parse_args(int argc, char** argv)
+{
+    using parser_t     = tim::argparse::argument_parser;
+    using parser_err_t = typename parser_t::result_type;
+
+    auto& _cfg = get_live_config();
+
+    auto parser = parser_t(argv[0]);
+
+    parser.on_error([](parser_t&, const parser_err_t& _err) {
+        stream(std::cerr, color::fatal()) << _err << "\n";
+        exit(EXIT_FAILURE);
+    });
+
+    parser.set_use_color(true);
+    parser.enable_help();
+    parser.enable_version("omnitrace-live", OMNITRACE_ARGPARSE_VERSION_INFO);
+
+    auto _cols = std::get<0>(tim::utility::console::get_columns());
+    if(_cols > parser.get_help_width() + 8)
+        parser.set_description_width(
+            std::min<int>(_cols - parser.get_help_width() - 8, 120));
+
+    parser.start_group("DEBUG OPTIONS", "");
+    parser.add_argument({ "--monochrome" }, "Disable colorized output")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) {
+            auto _monochrome = p.get<bool>("monochrome");
+            monochrome()     = _monochrome;
+            p.set_use_color(!_monochrome);
+        });
+    parser.add_argument({ "-v", "--verbose" }, "Verbose output")
+        .count(1)
+        .action([&](parser_t& p) { _cfg.verbose = p.get<int>("verbose"); });
+
+    parser.start_group("SEGMENT OPTIONS", "");
+    parser
+        .add_argument({ "-p", "--pid" },
+                      "Process ID of the application, i.e. the %pid% of the default "
+                      "OMNITRACE_LIVE_EXPORT_NAME")
+        .count(1)
+        .dtype("int")
+        .action([&](parser_t& p) {
+            _cfg.name = "/omnitrace-live-" + std::to_string(p.get<long>("pid"));
+        });
+    parser
+        .add_argument({ "-n", "--name" },
+                      "Name of the shared memory segment, i.e. the value of "
+                      "OMNITRACE_LIVE_EXPORT_NAME in the application")
+        .count(1)
+        .dtype("string")
+        .action([&](parser_t& p) {
+            _cfg.name = p.get<std::string>("name");
+            if(_cfg.name.empty() || _cfg.name.front() != '/')
+                _cfg.name.insert(_cfg.name.begin(), '/');
+        });
+    parser
+        .add_argument({ "-w", "--wait" },
+                      "Wait for the application to create the segment instead of "
+                      "failing when it does not exist")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) { _cfg.wait = p.get<bool>("wait"); });
+
+    parser.start_group("OUTPUT OPTIONS", "");
+    parser
+        .add_argument({ "-i", "--interval" },
+                      "Seconds between the outputs until the application finishes "
+                      "(default: a single output)")
+        .count(1)
+        .dtype("double")
+        .action([&](parser_t& p) {
+            _cfg.interval = std::max(p.get<double>("interval"), 0.0);
+        });
+    parser
+        .add_argument({ "-t", "--text" },
+                      "Print tables instead of the Prometheus text format")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) { _cfg.text = p.get<bool>("text"); });
+    parser
+        .add_argument({ "--top" },
+                      "Number of regions and functions in the output (default: all "
+                      "the regions and functions of the segment)")
+        .count(1)
+        .dtype("int")
+        .action([&](parser_t& p) { _cfg.top = p.get<size_t>("top"); });
+    parser
+        .add_argument({ "--port" },
+                      "Serve the Prometheus format at http://<host>:<port>/metrics "
+                      "instead of printing it. Every request reads the latest update")
+        .count(1)
+        .dtype("int")
+        .action([&](parser_t& p) {
+            auto _port = p.get<long>("port");
+            if(_port <= 0 || _port > 65535)
+            {
+                stream(std::cerr, color::fatal())
+                    << "Error! invalid port '" << _port << "'\n";
+                exit(EXIT_FAILURE);
+            }
+            _cfg.port = static_cast<uint16_t>(_port);
+        });
+
+    parser.end_group();
+
+    auto _cerr = parser.parse_args(argc, argv);
+    if(parser.exists("help") || argc == 1)
+    {
+        parser.print_help();
+        exit(EXIT_SUCCESS);
+    }
+    else if(_cerr)
+    {
+        stream(std::cerr, color::fatal()) << _cerr << "\n";
+        parser.print_help();
+        exit(EXIT_FAILURE);
+    }
+
+    if(_cfg.name.empty())
+    {
+        stream(std::cerr, color::fatal()) << "Error! --pid or --name is required\n";
+        parser.print_help();
+        exit(EXIT_FAILURE);
+    }
+}
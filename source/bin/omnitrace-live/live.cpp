@@ -0,0 +1,387 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-live.hpp"
+
+#include <timemory/log/color.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace color = tim::log::color;
+namespace live  = ::omnitrace::live_segment;
+using tim::log::stream;
+
+namespace
+{
+size_t
+get_count(uint32_t _n, size_t _max, const live_config& _cfg)
+{
+    auto _v = std::min<size_t>(_n, _max);
+    return (_cfg.top > 0) ? std::min(_v, _cfg.top) : _v;
+}
+
+double
+to_seconds(uint64_t _nsec)
+{
+    return static_cast<double>(_nsec) / 1.0e9;
+}
+
+// the names are copied from the segment so they are terminated within the entry
+std::string_view
+get_name(const char* _name)
+{
+    return std::string_view{ _name, strnlen(_name, live::name_length) };
+}
+
+// label values escape the backslash, the double-quote and the line feed
+std::string
+escape_label(std::string_view _v)
+{
+    auto _ss = std::string{};
+    _ss.reserve(_v.size());
+    for(auto itr : _v)
+    {
+        if(itr == '\\' || itr == '"')
+            _ss += { '\\', itr };
+        else if(itr == '\n')
+            _ss += "\\n";
+        else
+            _ss += itr;
+    }
+    return _ss;
+}
+
+void
+write_metadata(std::ostream& _os, std::string_view _name, std::string_view _type,
+               std::string_view _help)
+{
+    _os << "# HELP " << _name << " " << _help << "\n";
+    _os << "# TYPE " << _name << " " << _type << "\n";
+}
+
+int
+send_response(int _fd, std::string_view _status, std::string_view _body)
+{
+    auto _ss = std::stringstream{};
+    _ss << "HTTP/1.1 " << _status << "\r\n"
+        << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        << "Content-Length: " << _body.size() << "\r\n"
+        << "Connection: close\r\n\r\n"
+        << _body;
+
+    auto   _msg = _ss.str();
+    size_t _off = 0;
+    while(_off < _msg.size())
+    {
+        auto _n = send(_fd, _msg.data() + _off, _msg.size() - _off, MSG_NOSIGNAL);
+        if(_n <= 0) return -1;
+        _off += _n;
+    }
+    return 0;
+}
+}  // namespace
+
+live_mapping
+map_segment(const std::string& _name, bool _quiet)
+{
+    auto _fd = shm_open(_name.c_str(), O_RDONLY, 0);
+    if(_fd < 0)
+    {
+        if(!_quiet)
+            stream(std::cerr, color::fatal())
+                << "Error! unable to open the shared memory segment '" << _name
+                << "': " << strerror(errno) << "\n";
+        return live_mapping{};
+    }
+
+    struct stat _st = {};
+    if(fstat(_fd, &_st) != 0 || static_cast<size_t>(_st.st_size) < sizeof(live::segment))
+    {
+        // the application may still be resizing it
+        close(_fd);
+        if(!_quiet)
+            stream(std::cerr, color::fatal())
+                << "Error! '" << _name << "' is not an omnitrace live export segment\n";
+        return live_mapping{};
+    }
+
+    auto  _size = static_cast<size_t>(_st.st_size);
+    void* _addr = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    close(_fd);
+    if(_addr == MAP_FAILED)
+    {
+        if(!_quiet)
+            stream(std::cerr, color::fatal())
+                << "Error! unable to map the shared memory segment '" << _name
+                << "': " << strerror(errno) << "\n";
+        return live_mapping{};
+    }
+
+    auto _v = live_mapping{ static_cast<const live::segment*>(_addr), _size };
+    if(!live::is_valid(*_v.segment, _v.size))
+    {
+        if(!_quiet)
+            stream(std::cerr, color::fatal())
+                << "Error! '" << _name << "' is not initialized or was written by an "
+                << "incompatible version of omnitrace\n";
+        unmap_segment(_v);
+    }
+    return _v;
+}
+
+void
+unmap_segment(live_mapping& _v)
+{
+    if(_v.segment) munmap(const_cast<live::segment*>(_v.segment), _v.size);
+    _v = live_mapping{};
+}
+
+std::string
+format_prometheus(const live::segment& _seg, const live::payload& _v,
+                  const live_config& _cfg)
+{
+    auto _ss  = std::stringstream{};
+    auto _pid = std::to_string(_seg.pid);
+    _ss << std::setprecision(12);
+
+    auto _write = [&_ss, &_pid](std::string_view _name, std::string_view _label,
+                                std::string_view _value, auto _metric) {
+        _ss << _name << "{pid=\"" << _pid << "\"";
+        if(!_label.empty()) _ss << "," << _label << "=\"" << escape_label(_value) << "\"";
+        _ss << "} " << _metric << "\n";
+    };
+
+    write_metadata(_ss, "omnitrace_live_updates_total", "counter",
+                   "Number of updates of the live export");
+    _write("omnitrace_live_updates_total", {}, {}, _v.updates);
+    write_metadata(_ss, "omnitrace_live_uptime_seconds", "gauge",
+                   "Seconds since the start of the application at the last update");
+    _write("omnitrace_live_uptime_seconds", {}, {},
+           to_seconds((_v.timestamp > _seg.start) ? (_v.timestamp - _seg.start) : 0));
+    write_metadata(_ss, "omnitrace_live_finished", "gauge",
+                   "One if the last update was written at the finalization");
+    _write("omnitrace_live_finished", {}, {}, _v.finished);
+
+    auto _nregions = get_count(_v.num_regions, live::max_regions, _cfg);
+    write_metadata(_ss, "omnitrace_live_region_calls_total", "counter",
+                   "Number of completed calls of the region");
+    for(size_t i = 0; i < _nregions; ++i)
+        _write("omnitrace_live_region_calls_total", "region",
+               get_name(_v.regions[i].name), _v.regions[i].count);
+    write_metadata(_ss, "omnitrace_live_region_seconds_total", "counter",
+                   "Inclusive time of the completed calls of the region, summed over "
+                   "the threads");
+    for(size_t i = 0; i < _nregions; ++i)
+        _write("omnitrace_live_region_seconds_total", "region",
+               get_name(_v.regions[i].name), to_seconds(_v.regions[i].time));
+
+    write_metadata(_ss, "omnitrace_live_samples_total", "counter",
+                   "Number of sampling signals");
+    _write("omnitrace_live_samples_total", {}, {}, _v.samples);
+    write_metadata(_ss, "omnitrace_live_function_samples_total", "counter",
+                   "Number of samples which interrupted the function");
+    for(size_t i = 0; i < get_count(_v.num_functions, live::max_functions, _cfg); ++i)
+        _write("omnitrace_live_function_samples_total", "function",
+               get_name(_v.functions[i].name), _v.functions[i].samples);
+
+    auto _ndevices = std::min<size_t>(_v.num_devices, live::max_devices);
+    write_metadata(_ss, "omnitrace_live_device_busy_percent", "gauge",
+                   "Busy percentage of the GPU");
+    for(size_t i = 0; i < _ndevices; ++i)
+        if(_v.devices[i].busy >= 0.0)
+            _write("omnitrace_live_device_busy_percent", "device", std::to_string(i),
+                   _v.devices[i].busy);
+    write_metadata(_ss, "omnitrace_live_device_memory_bytes", "gauge",
+                   "Memory used on the GPU");
+    for(size_t i = 0; i < _ndevices; ++i)
+        if(_v.devices[i].memory >= 0)
+            _write("omnitrace_live_device_memory_bytes", "device", std::to_string(i),
+                   _v.devices[i].memory);
+    write_metadata(_ss, "omnitrace_live_device_kernels_total", "counter",
+                   "Number of kernels which completed on the GPU");
+    for(size_t i = 0; i < _ndevices; ++i)
+        _write("omnitrace_live_device_kernels_total", "device", std::to_string(i),
+               _v.devices[i].kernels);
+    write_metadata(_ss, "omnitrace_live_device_kernel_seconds_total", "counter",
+                   "Execution time of the kernels on the GPU");
+    for(size_t i = 0; i < _ndevices; ++i)
+        _write("omnitrace_live_device_kernel_seconds_total", "device",
+               std::to_string(i), to_seconds(_v.devices[i].kernel_time));
+
+    write_metadata(_ss, "omnitrace_live_comm_bytes_total", "counter",
+                   "Bytes of the MPI and RCCL operations");
+    _write("omnitrace_live_comm_bytes_total", {}, {}, _v.comm_bytes);
+    write_metadata(_ss, "omnitrace_live_comm_messages_total", "counter",
+                   "Number of MPI and RCCL operations");
+    _write("omnitrace_live_comm_messages_total", {}, {}, _v.comm_messages);
+
+    return _ss.str();
+}
+
+std::string
+format_text(const live::segment& _seg, const live::payload& _v, const live_config& _cfg)
+{
+    auto _ss = std::stringstream{};
+    _ss << std::fixed << std::setprecision(3);
+
+    _ss << "pid " << _seg.pid << " :: update " << _v.updates << " at "
+        << to_seconds((_v.timestamp > _seg.start) ? (_v.timestamp - _seg.start) : 0)
+        << " sec" << ((_v.finished) ? " (finished)" : "") << "\n";
+
+    auto _nregions = get_count(_v.num_regions, live::max_regions, _cfg);
+    if(_nregions > 0)
+    {
+        _ss << "\n" << std::setw(12) << "calls" << std::setw(14) << "time [sec]"
+            << "  region\n";
+        for(size_t i = 0; i < _nregions; ++i)
+            _ss << std::setw(12) << _v.regions[i].count << std::setw(14)
+                << to_seconds(_v.regions[i].time) << "  "
+                << get_name(_v.regions[i].name) << "\n";
+    }
+
+    auto _nfunctions = get_count(_v.num_functions, live::max_functions, _cfg);
+    if(_nfunctions > 0)
+    {
+        _ss << "\n" << std::setw(12) << "samples" << std::setw(14) << "percent"
+            << "  function\n";
+        for(size_t i = 0; i < _nfunctions; ++i)
+        {
+            auto _samples = _v.functions[i].samples;
+            _ss << std::setw(12) << _samples << std::setw(14)
+                << ((_v.samples > 0) ? (100.0 * _samples) / _v.samples : 0.0) << "  "
+                << get_name(_v.functions[i].name) << "\n";
+        }
+    }
+
+    auto _ndevices = std::min<size_t>(_v.num_devices, live::max_devices);
+    if(_ndevices > 0)
+    {
+        _ss << "\n" << std::setw(12) << "device" << std::setw(14) << "busy [%]"
+            << std::setw(14) << "memory [MB]" << std::setw(12) << "kernels"
+            << std::setw(14) << "time [sec]\n";
+        for(size_t i = 0; i < _ndevices; ++i)
+        {
+            const auto& _dev = _v.devices[i];
+            _ss << std::setw(12) << i << std::setw(14);
+            if(_dev.busy >= 0.0)
+                _ss << _dev.busy;
+            else
+                _ss << "-";
+            _ss << std::setw(14);
+            if(_dev.memory >= 0)
+                _ss << (static_cast<double>(_dev.memory) / (1024.0 * 1024.0));
+            else
+                _ss << "-";
+            _ss << std::setw(12) << _dev.kernels << std::setw(14)
+                << to_seconds(_dev.kernel_time) << "\n";
+        }
+    }
+
+    if(_v.comm_messages > 0)
+        _ss << "\ncommunication :: " << _v.comm_messages << " operations, "
+            << _v.comm_bytes << " bytes\n";
+
+    return _ss.str();
+}
+
+int
+serve(const live_mapping& _mapping, const live_config& _cfg)
+{
+    auto _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(_fd < 0)
+    {
+        stream(std::cerr, color::fatal())
+            << "Error! unable to create a socket: " << strerror(errno) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    int _reuse = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &_reuse, sizeof(_reuse));
+
+    auto _addr            = sockaddr_in{};
+    _addr.sin_family      = AF_INET;
+    _addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    _addr.sin_port        = htons(_cfg.port);
+    if(bind(_fd, reinterpret_cast<sockaddr*>(&_addr), sizeof(_addr)) != 0 ||
+       listen(_fd, 16) != 0)
+    {
+        stream(std::cerr, color::fatal()) << "Error! unable to listen on port "
+                                          << _cfg.port << ": " << strerror(errno) << "\n";
+        close(_fd);
+        return EXIT_FAILURE;
+    }
+
+    if(_cfg.verbose >= 0)
+        stream(std::cerr, color::info())
+            << "Serving pid " << _mapping.segment->pid << " at http://localhost:"
+            << _cfg.port << "/metrics...\n";
+
+    auto _payload = live::payload{};
+    while(true)
+    {
+        auto _client = accept(_fd, nullptr, nullptr);
+        if(_client < 0)
+        {
+            if(errno == EINTR) continue;
+            stream(std::cerr, color::fatal())
+                << "Error! accept failed: " << strerror(errno) << "\n";
+            break;
+        }
+
+        // a client which does not send its request does not block the other scrapes
+        auto _timeout = timeval{ 1, 0 };
+        setsockopt(_client, SOL_SOCKET, SO_RCVTIMEO, &_timeout, sizeof(_timeout));
+
+        char _buffer[1024] = {};
+        auto _n            = recv(_client, _buffer, sizeof(_buffer) - 1, 0);
+        auto _request      = std::string_view{ _buffer, (_n > 0) ? size_t(_n) : 0 };
+
+        if(_request.rfind("GET /metrics", 0) != 0 && _request.rfind("GET / ", 0) != 0)
+            send_response(_client, "404 Not Found", "not found\n");
+        else if(!live::read(*_mapping.segment, _payload))
+            send_response(_client, "503 Service Unavailable", "update in progress\n");
+        else
+            send_response(_client, "200 OK",
+                          format_prometheus(*_mapping.segment, _payload, _cfg));
+
+        close(_client);
+    }
+
+    close(_fd);
+    return EXIT_FAILURE;
+}
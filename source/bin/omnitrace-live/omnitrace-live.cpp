@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-live.hpp"
+
+#include <timemory/log/color.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace color = tim::log::color;
+namespace live  = ::omnitrace::live_segment;
+using tim::log::stream;
+
+int
+main(int argc, char** argv)
+{
+    parse_args(argc, argv);
+
+    const auto& _cfg     = get_live_config();
+    auto        _mapping = map_segment(_cfg.name, _cfg.wait);
+    while(_cfg.wait && !_mapping.segment)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+        _mapping = map_segment(_cfg.name, true);
+    }
+
+    if(!_mapping.segment) return EXIT_FAILURE;
+
+    if(_cfg.port > 0)
+    {
+        auto _ret = serve(_mapping, _cfg);
+        unmap_segment(_mapping);
+        return _ret;
+    }
+
+    auto _payload = live::payload{};
+    auto _format  = (_cfg.text) ? &format_text : &format_prometheus;
+    while(true)
+    {
+        if(!live::read(*_mapping.segment, _payload))
+        {
+            stream(std::cerr, color::fatal())
+                << "Error! unable to read a consistent update of '" << _cfg.name << "'\n";
+            unmap_segment(_mapping);
+            return EXIT_FAILURE;
+        }
+
+        std::cout << _format(*_mapping.segment, _payload, _cfg) << std::flush;
+
+        // the application removes the segment after its last update
+        if(_cfg.interval <= 0.0 || _payload.finished != 0) break;
+
+        std::this_thread::sleep_for(std::chrono::duration<double>{ _cfg.interval });
+        if(_cfg.text) std::cout << "\n";
+    }
+
+    unmap_segment(_mapping);
+    return EXIT_SUCCESS;
+}
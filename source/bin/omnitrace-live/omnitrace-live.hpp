@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "common/live_segment.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// options of reading the live export (OMNITRACE_LIVE_EXPORT=ON) of a running process
+struct live_config
+{
+    int         verbose  = 0;
+    bool        text     = false;  // human-readable instead of the Prometheus format
+    bool        wait     = false;  // wait for the segment to be created
+    size_t      top      = 0;      // regions and functions printed, zero for all
+    double      interval = 0.0;    // seconds between the outputs, zero for one output
+    uint16_t    port     = 0;      // serve GET /metrics instead of printing
+    std::string name     = {};     // name of the shared memory segment
+};
+
+void
+parse_args(int argc, char** argv);
+
+live_config&
+get_live_config();
+
+// read-only mapping of the segment of the writer. The mapping remains valid after the
+// application removed the segment at finalization
+struct live_mapping
+{
+    const omnitrace::live_segment::segment* segment = nullptr;
+    size_t                                   size    = 0;
+};
+
+// maps the segment. Returns an empty mapping if the segment does not exist or is not
+// compatible
+live_mapping
+map_segment(const std::string& _name, bool _quiet);
+
+void
+unmap_segment(live_mapping&);
+
+// the payload in the Prometheus text exposition format or as tables
+std::string
+format_prometheus(const omnitrace::live_segment::segment&,
+                  const omnitrace::live_segment::payload&, const live_config&);
+
+std::string
+format_text(const omnitrace::live_segment::segment&,
+            const omnitrace::live_segment::payload&, const live_config&);
+
+// answers GET /metrics with the Prometheus format until the process is interrupted
+int
+serve(const live_mapping&, const live_config&);
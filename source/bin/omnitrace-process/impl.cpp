@@ -0,0 +1,185 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-process.hpp"
+
+#include "common/defines.h"
+
+#include <timemory/log/color.hpp>
+#include <timemory/utility/argparse.hpp>
+#include <timemory/utility/console.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace color    = tim::log::color;
+namespace filepath = tim::filepath;
+using tim::log::monochrome;
+using tim::log::stream;
+
+namespace
+{
+constexpr auto manifest_name = "manifest.json";
+
+// a raw-<pid> folder or a folder which contains the raw-<pid> folders of several
+// processes, e.g. the output folder of an MPI job
+std::vector<std::string>
+get_raw_folders(const std::string& _path)
+{
+    if(filepath::exists(_path + "/" + manifest_name)) return { _path };
+
+    auto  _folders = std::vector<std::string>{};
+    auto* _dir     = opendir(_path.c_str());
+    if(!_dir) return _folders;
+
+    while(auto* _entry = readdir(_dir))
+    {
+        auto _name = std::string{ _entry->d_name };
+        auto _v    = _path + "/" + _name;
+        if(_name.find("raw-") != std::string::npos &&
+           filepath::exists(_v + "/" + manifest_name))
+            _folders.emplace_back(_v);
+    }
+    closedir(_dir);
+
+    std::sort(_folders.begin(), _folders.end());
+    return _folders;
+}
+}  // namespace
+
+process_config&
+get_process_config()
+{
+    static auto _v = process_config{};
+    return _v;
+}
+
+void
+parse_args(int argc, char** argv)
+{
+    using parser_t     = tim::argparse::argument_parser;
+    using parser_err_t = typename parser_t::result_type;
+
+    auto& _cfg = get_process_config();
+    _cfg.jobs  = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    auto parser = parser_t(argv[0]);
+
+    parser.on_error([](parser_t&, const parser_err_t& _err) {
+        stream(std::cerr, color::fatal()) << _err << "\n";
+        exit(EXIT_FAILURE);
+    });
+
+    parser.set_use_color(true);
+    parser.enable_help();
+    parser.enable_version("omnitrace-process", OMNITRACE_ARGPARSE_VERSION_INFO);
+
+    auto _cols = std::get<0>(tim::utility::console::get_columns());
+    if(_cols > parser.get_help_width() + 8)
+        parser.set_description_width(
+            std::min<int>(_cols - parser.get_help_width() - 8, 120));
+
+    parser.start_group("DEBUG OPTIONS", "");
+    parser.add_argument({ "--monochrome" }, "Disable colorized output")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) {
+            auto _monochrome = p.get<bool>("monochrome");
+            monochrome()     = _monochrome;
+            p.set_use_color(!_monochrome);
+        });
+    parser.add_argument({ "-v", "--verbose" }, "Verbose output")
+        .count(1)
+        .action([&](parser_t& p) { _cfg.verbose = p.get<int>("verbose"); });
+
+    parser.start_group("GENERAL OPTIONS", "");
+    parser
+        .add_argument({ "-i", "--input" },
+                      "The raw-<pid> folders written with OMNITRACE_RAW_OUTPUT=ON or the "
+                      "folders which contain them, e.g. the output folder of a MPI job")
+        .min_count(1)
+        .dtype("path")
+        .action([&](parser_t& p) {
+            for(const auto& itr : p.get<std::vector<std::string>>("input"))
+            {
+                auto _folders = get_raw_folders(itr);
+                if(_folders.empty())
+                {
+                    stream(std::cerr, color::fatal())
+                        << "Error! '" << itr << "' does not contain a raw output\n";
+                    exit(EXIT_FAILURE);
+                }
+                for(auto& fitr : _folders)
+                    _cfg.inputs.emplace_back(std::move(fitr));
+            }
+        });
+    parser
+        .add_argument({ "-o", "--output" },
+                      "Output path (default: the folder which contains the raw-<pid> "
+                      "folder, i.e. next to the output of the application)")
+        .count(1)
+        .dtype("path")
+        .action([&](parser_t& p) { _cfg.output = p.get<std::string>("output"); });
+    parser
+        .add_argument({ "-I", "--search-path" },
+                      "Folders which are searched for the binaries which are not at the "
+                      "path they were mapped from or which were modified, e.g. when the "
+                      "post-processing happens on another node. A binary is matched by "
+                      "its name and its build-id")
+        .min_count(1)
+        .dtype("path")
+        .action([&](parser_t& p) {
+            _cfg.search_path = p.get<std::vector<std::string>>("search-path");
+        });
+    parser
+        .add_argument({ "-j", "--jobs" },
+                      "Number of folders converted concurrently and of threads of the "
+                      "binary analysis (default: the number of CPUs)")
+        .count(1)
+        .dtype("int")
+        .action([&](parser_t& p) {
+            _cfg.jobs = std::max<size_t>(p.get<size_t>("jobs"), 1);
+        });
+
+    parser.end_group();
+
+    auto _cerr = parser.parse_args(argc, argv);
+    if(parser.exists("help") || argc == 1)
+    {
+        parser.print_help();
+        exit(EXIT_SUCCESS);
+    }
+    else if(_cerr)
+    {
+        stream(std::cerr, color::fatal()) << _cerr << "\n";
+        parser.print_help();
+        exit(EXIT_FAILURE);
+    }
+}
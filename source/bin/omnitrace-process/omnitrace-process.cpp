@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-process.hpp"
+
+#include <timemory/log/color.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace color = tim::log::color;
+using tim::log::stream;
+
+int
+main(int argc, char** argv)
+{
+    parse_args(argc, argv);
+
+    const auto& _cfg = get_process_config();
+    if(_cfg.inputs.empty())
+    {
+        stream(std::cerr, color::fatal()) << "Error! no raw output folder\n";
+        return EXIT_FAILURE;
+    }
+
+    if(_cfg.inputs.size() == 1) return process(_cfg.inputs.front(), _cfg, _cfg.jobs);
+
+    // omnitrace holds the output of one process so every folder (e.g. every rank of
+    // an MPI job) is converted by a child process
+    const auto _nproc   = std::min(_cfg.jobs, _cfg.inputs.size());
+    const auto _threads = std::max<size_t>(_cfg.jobs / _nproc, 1);
+
+    int  _ret     = EXIT_SUCCESS;
+    auto _running = std::map<pid_t, std::string>{};
+    auto _wait    = [&_ret, &_running]() {
+        int  _status = 0;
+        auto _pid    = waitpid(-1, &_status, 0);
+        if(_pid <= 0) return false;
+
+        auto itr = _running.find(_pid);
+        if(itr == _running.end()) return true;
+        if(!WIFEXITED(_status) || WEXITSTATUS(_status) != EXIT_SUCCESS)
+        {
+            stream(std::cerr, color::fatal())
+                << "Error! converting '" << itr->second << "' failed\n";
+            _ret = EXIT_FAILURE;
+        }
+        _running.erase(itr);
+        return true;
+    };
+
+    for(const auto& itr : _cfg.inputs)
+    {
+        while(_running.size() >= _nproc && _wait())
+        {}
+
+        auto _pid = fork();
+        if(_pid == 0)
+        {
+            std::exit(process(itr, _cfg, _threads));
+        }
+        else if(_pid < 0)
+        {
+            stream(std::cerr, color::fatal())
+                << "Error! unable to fork the conversion of '" << itr << "'\n";
+            _ret = EXIT_FAILURE;
+        }
+        else
+        {
+            _running.emplace(_pid, itr);
+        }
+    }
+
+    while(!_running.empty() && _wait())
+    {}
+
+    return _ret;
+}
@@ -0,0 +1,50 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// options of converting the raw outputs (OMNITRACE_RAW_OUTPUT=ON) of one or more
+// processes into the perfetto trace and the timemory profiles of their samples
+struct process_config
+{
+    int                      verbose     = 0;
+    size_t                   jobs        = 1;   // concurrent processes and threads
+    std::string              output      = {};  // default: parent of the raw folder
+    std::vector<std::string> search_path = {};  // folders of the relocated binaries
+    std::vector<std::string> inputs      = {};  // raw-<pid> folders
+};
+
+void
+parse_args(int argc, char** argv);
+
+process_config&
+get_process_config();
+
+// symbolizes the samples of a raw-<pid> folder and writes the perfetto and timemory
+// output of the samples. Initializes and finalizes omnitrace so there can only be one
+// call per process. _threads is the number of threads of the binary analysis
+int
+process(const std::string& _directory, const process_config&, size_t _threads);
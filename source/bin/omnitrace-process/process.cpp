@@ -0,0 +1,328 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-process.hpp"
+
+#include "api.hpp"
+#include "binary/analysis.hpp"
+#include "binary/analysis_cache.hpp"
+#include "binary/binary_info.hpp"
+#include "binary/interned_string.hpp"
+#include "core/config.hpp"
+#include "core/timemory.hpp"
+#include "library/raw_output.hpp"
+#include "library/sampling.hpp"
+
+#include <timemory/environment.hpp>
+#include <timemory/log/color.hpp>
+#include <timemory/settings/settings.hpp>
+#include <timemory/unwind/processed_entry.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace color = tim::log::color;
+using tim::log::stream;
+
+namespace
+{
+namespace binary     = ::omnitrace::binary;
+namespace filepath   = ::tim::filepath;
+namespace raw_output = ::omnitrace::raw_output;
+namespace sampling   = ::omnitrace::sampling;
+
+struct symbol_entry
+{
+    uintptr_t               low  = 0;
+    uintptr_t               high = 0;
+    unsigned int            line = 0;
+    std::string             name = {};  // mangled, demangled by the sampling
+    binary::interned_string file = {};
+};
+
+struct line_entry
+{
+    uintptr_t               low  = 0;
+    unsigned int            line = 0;
+    binary::interned_string file = {};
+};
+
+// the last entry which begins at or before the address
+template <typename Tp>
+const Tp*
+find_entry(const std::vector<Tp>& _data, uintptr_t _addr)
+{
+    auto itr = std::upper_bound(_data.begin(), _data.end(), _addr,
+                                [](uintptr_t _v, const Tp& _e) { return _v < _e.low; });
+    if(itr == _data.begin()) return nullptr;
+    return &(*(--itr));
+}
+
+// the binary mapped by the process or, when it was moved or modified, the binary of
+// the search path with the same name and key. Empty if there is none
+std::string
+find_binary(const raw_output::binary_entry& _binary, const process_config& _cfg)
+{
+    auto _matches = [&_binary](const std::string& _filename) {
+        return filepath::exists(_filename) &&
+               (_binary.key.empty() ||
+                binary::analysis_cache::get_key(_filename) == _binary.key);
+    };
+
+    if(_matches(_binary.pathname)) return _binary.pathname;
+
+    auto _name = std::string{ filepath::basename(_binary.pathname) };
+    for(const auto& itr : _cfg.search_path)
+    {
+        auto _filename = itr + "/" + _name;
+        if(_matches(_filename)) return _filename;
+    }
+    return std::string{};
+}
+
+// resolves the instruction pointers of a raw output. Like in omnitrace-sample, the
+// symbols are relative to the load address of their binary in the process
+struct symbol_resolver
+{
+    struct mapping
+    {
+        uintptr_t low    = 0;
+        uintptr_t high   = 0;
+        size_t    binary = 0;  // index in m_binaries
+
+        bool operator<(const mapping& _rhs) const { return low < _rhs.low; }
+    };
+
+    struct binary_symbols
+    {
+        std::string               filename = {};
+        std::vector<symbol_entry> symbols  = {};
+        std::vector<line_entry>   lines    = {};
+    };
+
+    // finds the binaries of the manifest and reads their symbols and line info.
+    // Returns the number of binaries which were not found
+    size_t load(const raw_output::manifest& _manifest, const process_config& _cfg)
+    {
+        size_t _missing = 0;
+        auto   _index   = std::unordered_map<std::string, size_t>{};
+        auto   _files   = std::vector<std::string>{};
+        for(const auto& itr : _manifest.binaries)
+        {
+            auto _filename = find_binary(itr, _cfg);
+            if(_filename.empty())
+            {
+                if(_cfg.verbose >= 0)
+                    stream(std::cerr, color::warning())
+                        << "Warning! '" << itr.pathname
+                        << "' was not found or is not the binary mapped by the "
+                           "process. Its samples will not be symbolized\n";
+                ++_missing;
+                continue;
+            }
+
+            if(_cfg.verbose >= 2 && _filename != itr.pathname)
+                stream(std::cerr, color::info())
+                    << "Using '" << _filename << "' for '" << itr.pathname << "'\n";
+
+            _filename = filepath::realpath(_filename, nullptr, false);
+            _index.emplace(itr.pathname, m_binaries.size());
+            m_binaries.emplace_back(binary_symbols{ _filename, {}, {} });
+            _files.emplace_back(_filename);
+        }
+
+        for(const auto& itr : _manifest.mappings)
+        {
+            auto iitr = _index.find(itr.pathname);
+            if(iitr != _index.end())
+                m_mappings.emplace_back(mapping{ itr.low, itr.high, iitr->second });
+        }
+        std::sort(m_mappings.begin(), m_mappings.end());
+
+        // the binaries are analyzed in parallel (OMNITRACE_BINARY_ANALYSIS_THREADS)
+        for(const auto& itr : binary::get_binary_info(_files, {}, true, true))
+        {
+            auto bitr = std::find_if(
+                m_binaries.begin(), m_binaries.end(),
+                [&itr](const auto& _v) { return _v.filename == itr.filename(); });
+            if(bitr == m_binaries.end()) continue;
+
+            for(const auto& sitr : itr.symbols)
+            {
+                if(sitr.func.empty() || !sitr.address.is_valid()) continue;
+                bitr->symbols.emplace_back(symbol_entry{ sitr.address.low,
+                                                         sitr.address.high, sitr.line,
+                                                         sitr.func, sitr.file });
+            }
+
+            for(const auto& ditr : itr.debug_info)
+            {
+                if(!ditr.is_valid() || ditr.end_sequence || ditr.line == 0) continue;
+                bitr->lines.emplace_back(
+                    line_entry{ ditr.address.low, ditr.line, ditr.file });
+            }
+
+            auto _cmp = [](const auto& _lhs, const auto& _rhs) {
+                return _lhs.low < _rhs.low;
+            };
+            std::sort(bitr->symbols.begin(), bitr->symbols.end(), _cmp);
+            std::sort(bitr->lines.begin(), bitr->lines.end(), _cmp);
+        }
+
+        return _missing;
+    }
+
+    std::optional<tim::unwind::processed_entry> operator()(uintptr_t _addr) const
+    {
+        auto mitr = std::upper_bound(m_mappings.begin(), m_mappings.end(),
+                                     mapping{ _addr });
+        if(mitr == m_mappings.begin()) return std::nullopt;
+        --mitr;
+        if(_addr < mitr->low || _addr >= mitr->high) return std::nullopt;
+
+        const auto& _binary = m_binaries.at(mitr->binary);
+        const auto  _offset = _addr - mitr->low;
+        const auto* _symbol = find_entry(_binary.symbols, _offset);
+        if(!_symbol || _offset >= _symbol->high) return std::nullopt;
+
+        auto _v         = tim::unwind::processed_entry{};
+        _v.address      = _addr;
+        _v.offset       = _offset - _symbol->low;
+        _v.line_address = _offset;
+        _v.name         = _symbol->name;
+        _v.location     = _symbol->file.str();
+        _v.lineno       = _symbol->line;
+
+        // the line of the address if the line info is within the function
+        const auto* _line = find_entry(_binary.lines, _offset);
+        if(_line && _line->low >= _symbol->low)
+        {
+            _v.location = _line->file.str();
+            _v.lineno   = _line->line;
+        }
+
+        if(_v.location.empty()) _v.location = _binary.filename;
+        return _v;
+    }
+
+private:
+    std::vector<binary_symbols> m_binaries = {};
+    std::vector<mapping>        m_mappings = {};
+};
+
+// the output prefix of the application, i.e. the name of the raw-<pid> folder
+// without raw-<pid>
+std::string
+get_output_prefix(const std::string& _directory, pid_t _pid)
+{
+    auto _name = std::string{ filepath::basename(_directory) };
+    auto _raw  = "raw-" + std::to_string(_pid);
+    auto _pos  = _name.rfind(_raw);
+    return (_pos == std::string::npos) ? std::string{} : _name.substr(0, _pos);
+}
+
+std::string
+get_parent_directory(std::string _directory)
+{
+    while(_directory.length() > 1 && _directory.back() == '/')
+        _directory.pop_back();
+    auto _pos = _directory.find_last_of('/');
+    if(_pos == std::string::npos) return std::string{ "." };
+    return (_pos == 0) ? std::string{ "/" } : _directory.substr(0, _pos);
+}
+}  // namespace
+
+int
+process(const std::string& _directory, const process_config& _cfg, size_t _threads)
+{
+    auto _manifest = raw_output::manifest{};
+    try
+    {
+        _manifest = raw_output::read_manifest(_directory);
+    } catch(std::exception& _e)
+    {
+        stream(std::cerr, color::fatal()) << _e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if(_cfg.verbose >= 0)
+        stream(std::cerr, color::info())
+            << "Converting the " << _manifest.threads.size() << " threads of process "
+            << _manifest.pid << " (" << _manifest.command << " on "
+            << _manifest.hostname << ") in '" << _directory << "'...\n";
+
+    auto _output = (_cfg.output.empty()) ? get_parent_directory(_directory) : _cfg.output;
+
+    // only the samples are emitted. The prefix prevents the output of this process
+    // from overwriting the output of the application, e.g. its perfetto trace
+    tim::set_env("OMNITRACE_OUTPUT_PATH", _output, 1);
+    tim::set_env("OMNITRACE_OUTPUT_PREFIX",
+                 get_output_prefix(_directory, _manifest.pid) + "samples-", 1);
+    tim::set_env("OMNITRACE_TIME_OUTPUT", "OFF", 1);
+    tim::set_env("OMNITRACE_TRACE", (_manifest.perfetto) ? "ON" : "OFF", 1);
+    tim::set_env("OMNITRACE_PROFILE", (_manifest.timemory) ? "ON" : "OFF", 1);
+    tim::set_env("OMNITRACE_VERBOSE", _cfg.verbose, 1);
+    tim::set_env("OMNITRACE_BINARY_ANALYSIS_THREADS", _threads, 1);
+    for(const auto* itr :
+        { "OMNITRACE_USE_SAMPLING", "OMNITRACE_USE_PROCESS_SAMPLING",
+          "OMNITRACE_RAW_OUTPUT", "OMNITRACE_USE_ROCTRACER", "OMNITRACE_USE_ROCPROFILER",
+          "OMNITRACE_USE_ROCM_SMI", "OMNITRACE_USE_OMPT", "OMNITRACE_USE_KOKKOSP",
+          "OMNITRACE_USE_CODE_COVERAGE", "OMNITRACE_EMERGENCY_DUMP" })
+        tim::set_env(itr, "OFF", 1);
+
+    omnitrace_init("trace", false, _manifest.command.c_str());
+    omnitrace_init_tooling();
+
+    // the output files have the pid of the application
+    tim::settings::default_process_suffix() = _manifest.pid;
+
+    auto _resolver = symbol_resolver{};
+    if(_resolver.load(_manifest, _cfg) == _manifest.binaries.size() &&
+       !_manifest.binaries.empty())
+    {
+        stream(std::cerr, color::fatal())
+            << "Error! none of the binaries of process " << _manifest.pid
+            << " were found. Use -I/--search-path to locate them\n";
+        omnitrace_finalize();
+        return EXIT_FAILURE;
+    }
+
+    auto _lookup = sampling::raw_lookup_t{ std::cref(_resolver) };
+    for(const auto& itr : _manifest.threads)
+    {
+        auto _samples = raw_output::read_samples(_directory, itr);
+        sampling::post_process_raw(itr, _samples, _lookup);
+    }
+
+    omnitrace_finalize();
+
+    return EXIT_SUCCESS;
+}
@@ -28,7 +28,9 @@
 #include "common/join.hpp"
 #include "common/setup.hpp"
 #include "core/argparse.hpp"
+#include "core/calibration.hpp"
 #include "core/config.hpp"
+#include "core/staging.hpp"
 #include "core/state.hpp"
 #include "core/timemory.hpp"
 
@@ -43,19 +45,25 @@
 #include <timemory/utility/filepath.hpp>
 #include <timemory/utility/join.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cctype>
+#include <cerrno>
 #include <chrono>
 #include <cmath>
+#include <csignal>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <fcntl.h>
 #include <iostream>
 #include <regex>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <sys/types.h>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
@@ -141,6 +149,39 @@ toggle_suppression(std::tuple<bool, bool> _inp)
 
 // disable suppression when exe loads but store original values for restoration later
 auto initial_suppression = toggle_suppression({ true, true });
+
+// the value of the setting in the environment of the command, otherwise the value of
+// the setting in this process
+std::string
+get_command_setting(const parser_data_t& _data, std::string_view _name)
+{
+    auto _prefix = join("", _name, "=");
+    for(auto* itr : _data.current)
+    {
+        if(itr != nullptr && std::string_view{ itr }.find(_prefix) == 0)
+            return std::string{ itr }.substr(_prefix.length());
+    }
+
+    auto _settings = settings::shared_instance();
+    if(!_settings) return std::string{};
+    auto itr = _settings->find(std::string{ _name });
+    return (itr != _settings->end() && itr->second) ? itr->second->as_string()
+                                                    : std::string{};
+}
+
+double
+get_command_setting(const parser_data_t& _data, std::string_view _name,
+                    double _default)
+{
+    try
+    {
+        auto _v = get_command_setting(_data, _name);
+        return (_v.empty()) ? _default : std::stod(_v);
+    } catch(std::exception&)
+    {
+        return _default;
+    }
+}
 }  // namespace
 
 void
@@ -155,6 +196,182 @@ print_command(const parser_data_t& _data, std::string_view _prefix)
     std::cerr << color::end() << std::flush;
 }
 
+void
+print_sampling_overhead(const parser_data_t& _data, std::string_view _prefix)
+{
+    namespace calibration = ::omnitrace::calibration;
+    using ::omnitrace::SamplingUnwinder;
+
+    auto _fname = get_command_setting(_data, "OMNITRACE_CALIBRATION_FILE");
+    if(_fname.empty() || _data.verbose < 0) return;
+
+    auto _get_bool = [&_data](std::string_view _name) {
+        return tim::get_bool(get_command_setting(_data, _name), false);
+    };
+
+    if(!_get_bool("OMNITRACE_USE_SAMPLING")) return;
+
+    auto _calibration = calibration::read(_fname);
+    if(!_calibration)
+    {
+        stream(std::cerr, color::warning())
+            << _prefix << "Calibration file '" << _fname << "' could not be read\n";
+        std::cerr << color::end() << std::flush;
+        return;
+    }
+
+    if(_calibration->hostname != calibration::get_hostname())
+    {
+        stream(std::cerr, color::warning())
+            << _prefix << "Calibration file '" << _fname << "' was measured on '"
+            << _calibration->hostname << "'\n";
+    }
+
+    // same defaults as the sampling signals of the library
+    auto _freq     = get_command_setting(_data, "OMNITRACE_SAMPLING_FREQ", 0.0);
+    auto _cputime  = _get_bool("OMNITRACE_SAMPLING_CPUTIME");
+    auto _realtime = _get_bool("OMNITRACE_SAMPLING_REALTIME");
+    if(!_cputime && !_realtime && !_get_bool("OMNITRACE_SAMPLING_OVERFLOW"))
+        _cputime = true;
+
+    auto _get_freq = [&_data, _freq](std::string_view _name) {
+        auto _v = get_command_setting(_data, _name, 0.0);
+        return (_v > 0.0) ? _v : _freq;
+    };
+
+    auto _rate = 0.0;
+    if(_cputime) _rate += _get_freq("OMNITRACE_SAMPLING_CPUTIME_FREQ");
+    if(_realtime) _rate += _get_freq("OMNITRACE_SAMPLING_REALTIME_FREQ");
+
+    auto _unwinder = SamplingUnwinder::LibUnwind;
+    auto _name     = get_command_setting(_data, "OMNITRACE_SAMPLING_UNWINDER");
+    if(_name == "frame-pointer")
+        _unwinder = SamplingUnwinder::FramePointer;
+    else if(_name == "auto")
+        _unwinder = SamplingUnwinder::Auto;
+
+    auto _overhead = calibration::get_sampling_overhead(*_calibration, _unwinder, _rate);
+    if(!_overhead) return;
+
+    auto _target  = get_command_setting(_data, "OMNITRACE_SAMPLING_OVERHEAD_TARGET", 0.0);
+    auto _exceeds = (_target > 0.0 && *_overhead > _target);
+    auto _color   = (_exceeds) ? color::warning() : color::info();
+
+    stream(std::cerr, _color) << _prefix << "Estimated sampling overhead: " << *_overhead
+                              << "% of the wall-time of each sampled thread at " << _rate
+                              << " interrupts/sec\n";
+    if(_exceeds)
+    {
+        auto _stride =
+            calibration::get_sampling_stride(*_calibration, _unwinder, _rate, _target);
+        stream(std::cerr, _color)
+            << _prefix << "Only every " << _stride
+            << " timer signal(s) will be sampled to stay within "
+            << "OMNITRACE_SAMPLING_OVERHEAD_TARGET=" << _target << "%\n";
+    }
+    std::cerr << color::end() << std::flush;
+}
+
+void
+start_output_drain(parser_data_t& _data, std::string_view _prefix)
+{
+    namespace staging = ::omnitrace::staging;
+
+    auto _dir =
+        staging::get_directory(get_command_setting(_data, "OMNITRACE_OUTPUT_STAGING"),
+                               get_command_setting(_data, "OMNITRACE_TMPDIR"));
+    if(_dir.empty()) return;
+
+    // the command is executed in this process (or in a child of it) so the identifier
+    // of its staging directory is known before it starts
+    auto _id   = std::to_string(getpid());
+    auto _root = staging::get_root(_dir, _id);
+
+    // the drain process reads the pipe until every process which inherited the write
+    // end, i.e. the command and its children, has exited
+    int _fd[2] = { -1, -1 };
+    if(pipe(_fd) != 0)
+    {
+        stream(std::cerr, color::warning())
+            << _prefix << "Output files will be moved at the end of the finalization: "
+            << strerror(errno) << "\n";
+        std::cerr << color::end() << std::flush;
+        return;
+    }
+
+    auto _pid = fork();
+    if(_pid == 0)
+    {
+        // detach from the session and the standard streams of the command so neither
+        // the launcher nor the command wait on it. The intermediate process exits
+        // immediately so the drain process is re-parented to init
+        setsid();
+        if(fork() != 0) _exit(EXIT_SUCCESS);
+
+        close(_fd[1]);
+        auto _null = open("/dev/null", O_RDWR);
+        if(_null >= 0)
+        {
+            for(auto itr : { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO })
+                dup2(_null, itr);
+            close(_null);
+        }
+
+        char    _buf = 0;
+        ssize_t _n   = 0;
+        do
+        {
+            _n = read(_fd[0], &_buf, sizeof(_buf));
+        } while(_n > 0 || (_n < 0 && errno == EINTR));
+        close(_fd[0]);
+
+        // in case the command closed the descriptors it inherited
+        auto _cmd_pid = static_cast<pid_t>(std::stol(_id));
+        while(kill(_cmd_pid, 0) == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+
+        staging::drain(_root, -1);
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(_fd[0]);
+    if(_pid < 0)
+    {
+        close(_fd[1]);
+        stream(std::cerr, color::warning())
+            << _prefix << "Output files will be moved at the end of the finalization: "
+            << strerror(errno) << "\n";
+        std::cerr << color::end() << std::flush;
+        return;
+    }
+
+    // the write end of the pipe remains open across the exec of the command
+    waitpid(_pid, nullptr, 0);
+
+    auto _env = join('=', staging::drain_env, _id);
+    auto _key = join("", staging::drain_env, "=");
+    auto itr  = std::find_if(_data.current.begin(), _data.current.end(), [&](char* _v) {
+        return _v != nullptr && std::string_view{ _v }.find(_key) == 0;
+    });
+    if(itr != _data.current.end())
+    {
+        free(*itr);
+        *itr = strdup(_env.c_str());
+    }
+    else
+    {
+        _data.current.emplace_back(strdup(_env.c_str()));
+    }
+
+    if(_data.verbose >= 1)
+    {
+        stream(std::cerr, color::info())
+            << _prefix << "Output files are staged in '" << _root
+            << "' and moved to their final location after the command exits\n";
+        std::cerr << color::end() << std::flush;
+    }
+}
+
 void
 prepare_command_for_run(char* _exe, parser_data_t& _data)
 {
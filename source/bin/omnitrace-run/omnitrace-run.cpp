@@ -73,6 +73,8 @@ main(int argc, char** argv)
     {
         print_updated_environment(_parse_data, "OMNITRACE: ");
         print_command(_parse_data, "OMNITRACE: ");
+        print_sampling_overhead(_parse_data, "OMNITRACE: ");
+        start_output_drain(_parse_data, "OMNITRACE: ");
         _argv.emplace_back(nullptr);
         _envp.emplace_back(nullptr);
 
@@ -40,6 +40,12 @@ print_command(const parser_data_t&, std::string_view);
 void
 print_updated_environment(parser_data_t&, std::string_view);
 
+void
+print_sampling_overhead(const parser_data_t&, std::string_view);
+
+void
+start_output_drain(parser_data_t&, std::string_view);
+
 void
 prepare_command_for_run(char*, parser_data_t&);
 
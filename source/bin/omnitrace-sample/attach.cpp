@@ -0,0 +1,752 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "omnitrace-sample.hpp"
+
+#include "api.hpp"
+#include "binary/analysis.hpp"
+#include "binary/binary_info.hpp"
+#include "binary/scope_filter.hpp"
+#include "common/join.hpp"
+#include "core/utility.hpp"
+#include "core/timemory.hpp"
+#include "library/perf.hpp"
+
+#include <timemory/environment.hpp>
+#include <timemory/log/color.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/procfs/maps.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace color = tim::log::color;
+using tim::log::stream;
+
+namespace
+{
+namespace binary   = ::omnitrace::binary;
+namespace procfs   = ::tim::procfs;
+namespace filepath = ::tim::filepath;
+
+using perf_event_t = ::omnitrace::perf::perf_event;
+using callstack_t  = std::vector<uintptr_t>;
+
+// interval between the reads of the ring buffers and the scans for new threads
+constexpr auto drain_interval = std::chrono::milliseconds{ 100 };
+
+std::atomic<bool> attach_interrupted = { false };
+
+void
+attach_signal_handler(int)
+{
+    attach_interrupted.store(true);
+}
+
+bool
+is_alive(pid_t _pid)
+{
+    return (kill(_pid, 0) == 0 || errno == EPERM);
+}
+
+std::set<pid_t>
+get_tids(pid_t _pid)
+{
+    auto  _tids = std::set<pid_t>{};
+    auto  _path = std::string{ "/proc/" } + std::to_string(_pid) + "/task";
+    auto* _dir  = opendir(_path.c_str());
+    if(!_dir) return _tids;
+
+    while(auto* _entry = readdir(_dir))
+    {
+        if(_entry->d_name[0] < '0' || _entry->d_name[0] > '9') continue;
+        _tids.emplace(static_cast<pid_t>(std::stol(_entry->d_name)));
+    }
+    closedir(_dir);
+    return _tids;
+}
+
+// the online CPUs, e.g. "0-7,16-23"
+std::set<int64_t>
+get_online_cpus()
+{
+    auto _ifs = std::ifstream{ "/sys/devices/system/cpu/online" };
+    auto _v   = std::string{};
+    if(_ifs) _ifs >> _v;
+    if(_v.empty()) _v = "0-" + std::to_string(sysconf(_SC_NPROCESSORS_ONLN) - 1);
+    return omnitrace::utility::parse_numeric_range<>(_v, "CPUs", 1L);
+}
+
+std::string
+get_command(pid_t _pid)
+{
+    auto _ifs = std::ifstream{ "/proc/" + std::to_string(_pid) + "/comm" };
+    auto _v   = std::string{};
+    if(_ifs) std::getline(_ifs, _v);
+    return _v;
+}
+
+std::string
+get_hostname()
+{
+    char _v[256] = {};
+    if(gethostname(_v, sizeof(_v) - 1) != 0) return std::string{ "localhost" };
+    return std::string{ _v };
+}
+
+// the file-backed mappings of a process
+std::vector<procfs::maps>
+get_process_maps(pid_t _pid)
+{
+    auto _filter = [](const procfs::maps& _v) {
+        return (!_v.pathname.empty() && _v.pathname.front() == '/' &&
+                filepath::exists(_v.pathname));
+    };
+    return procfs::get_contiguous_maps(_pid, _filter, false);
+}
+
+struct symbol_entry
+{
+    uintptr_t   low  = 0;
+    uintptr_t   high = 0;
+    std::string name = {};
+
+    bool operator<(const symbol_entry& _rhs) const { return low < _rhs.low; }
+};
+
+const symbol_entry*
+find_entry(const std::vector<symbol_entry>& _data, uintptr_t _addr)
+{
+    auto itr = std::upper_bound(_data.begin(), _data.end(), symbol_entry{ _addr });
+    if(itr == _data.begin()) return nullptr;
+    --itr;
+    return (_addr >= itr->low && _addr < itr->high) ? &(*itr) : nullptr;
+}
+
+// resolves the addresses of the sampled processes. Every binary is analyzed once and
+// its symbols are kept relative to the load address so they are shared by all the
+// processes which map the binary
+struct symbol_resolver
+{
+    struct mapping
+    {
+        uintptr_t low          = 0;
+        uintptr_t high         = 0;
+        uintptr_t load_address = 0;
+        size_t    binary       = 0;  // index in m_binaries
+
+        bool operator<(const mapping& _rhs) const { return low < _rhs.low; }
+    };
+
+    struct binary_symbols
+    {
+        std::string               filename = {};
+        std::string               module   = {};
+        std::vector<symbol_entry> symbols  = {};
+    };
+
+    // records the file-backed mappings of the process which are not yet known
+    void add_process(pid_t _pid)
+    {
+        auto& _mappings = m_mappings[_pid];
+        for(const auto& itr : get_process_maps(_pid))
+        {
+            auto _binary = get_binary_index(itr.pathname);
+            auto _entry  = mapping{ itr.load_address, itr.last_address,
+                                   itr.load_address, _binary };
+            if(std::find_if(_mappings.begin(), _mappings.end(), [&_entry](auto& _v) {
+                   return _v.low == _entry.low && _v.binary == _entry.binary;
+               }) == _mappings.end())
+                _mappings.emplace_back(_entry);
+        }
+        std::sort(_mappings.begin(), _mappings.end());
+    }
+
+    // reads the symbol tables of the binaries (not the line info)
+    void load()
+    {
+        auto _files = std::vector<std::string>{};
+        for(const auto& itr : m_binaries)
+            _files.emplace_back(itr.filename);
+
+        for(const auto& itr : binary::get_binary_info(_files, {}, false, true))
+        {
+            auto bitr = std::find_if(
+                m_binaries.begin(), m_binaries.end(),
+                [&itr](const auto& _v) { return _v.filename == itr.filename(); });
+            if(bitr == m_binaries.end()) continue;
+
+            for(const auto& sitr : itr.symbols)
+            {
+                if(sitr.func.empty() || !sitr.address.is_valid()) continue;
+                bitr->symbols.emplace_back(
+                    symbol_entry{ sitr.address.low, sitr.address.high, sitr.func });
+            }
+            std::sort(bitr->symbols.begin(), bitr->symbols.end());
+        }
+    }
+
+    // the function containing the address, the module containing the address if
+    // the address is not within a symbol (e.g. a stripped binary), or the address
+    std::string operator()(pid_t _pid, uintptr_t _addr) const
+    {
+        if(auto pitr = m_mappings.find(_pid); pitr != m_mappings.end())
+        {
+            auto mitr = std::upper_bound(pitr->second.begin(), pitr->second.end(),
+                                         mapping{ _addr });
+            if(mitr != pitr->second.begin())
+            {
+                --mitr;
+                if(_addr >= mitr->low && _addr < mitr->high)
+                {
+                    const auto& _binary = m_binaries.at(mitr->binary);
+                    if(const auto* _v =
+                           find_entry(_binary.symbols, _addr - mitr->load_address))
+                        return tim::demangle(_v->name);
+                    return std::string{ "[" } + _binary.module + "]";
+                }
+            }
+        }
+
+        auto _ss = std::stringstream{};
+        _ss << "0x" << std::hex << _addr;
+        return _ss.str();
+    }
+
+private:
+    size_t get_binary_index(const std::string& _filename)
+    {
+        auto itr = m_binary_index.find(_filename);
+        if(itr != m_binary_index.end()) return itr->second;
+
+        auto _filename_v = filepath::realpath(_filename, nullptr, false);
+        m_binaries.emplace_back(binary_symbols{
+            _filename_v, std::string{ filepath::basename(_filename) }, {} });
+        return (m_binary_index[_filename] = m_binaries.size() - 1);
+    }
+
+    std::vector<binary_symbols>                m_binaries     = {};
+    std::unordered_map<std::string, size_t>    m_binary_index = {};
+    std::map<pid_t, std::vector<mapping>>      m_mappings     = {};
+};
+
+// the totals of a function over the samples
+struct function_entry
+{
+    uint64_t exclusive = 0;
+    uint64_t inclusive = 0;
+};
+
+using function_list_t = std::vector<std::pair<std::string, function_entry>>;
+using thread_counts_t = std::map<pid_t, uint64_t>;
+
+struct process_profile
+{
+    pid_t           pid       = 0;
+    std::string     command   = {};
+    uint64_t        samples   = 0;
+    thread_counts_t threads   = {};
+    function_list_t functions = {};
+};
+
+struct attach_profile
+{
+    double                       duration  = 0.0;  // sec
+    uint64_t                     samples   = 0;
+    uint64_t                     lost      = 0;
+    size_t                       cpus      = 0;  // system-wide
+    std::vector<process_profile> processes = {};
+};
+
+// the samples of a process
+struct process_samples
+{
+    std::string                     command = {};
+    thread_counts_t                 threads = {};
+    std::map<callstack_t, uint64_t> stacks  = {};
+};
+
+// collects the samples of the threads of the target or, system-wide, of every
+// process on the CPUs
+struct attach_session
+{
+    explicit attach_session(const attach_config& _cfg)
+    : m_config{ _cfg }
+    {}
+
+    ~attach_session() { detach(); }
+
+    // opens a sampling perf_event for every thread which does not have one or, when
+    // sampling system-wide, one perf_event per CPU
+    size_t open()
+    {
+        return (m_config.system_wide) ? open_cpus() : open_threads();
+    }
+
+    void drain()
+    {
+        for(auto& eitr : m_events)
+        {
+            for(auto itr : *eitr.second)
+            {
+                if(itr.is_lost())
+                {
+                    ++m_lost;
+                    continue;
+                }
+                if(!itr.is_sample()) continue;
+
+                // the per-thread events do not record the pid and tid
+                auto _pid = m_config.pid;
+                auto _tid = eitr.first;
+                if(m_config.system_wide)
+                {
+                    _pid = static_cast<pid_t>(itr.get_pid());
+                    _tid = static_cast<pid_t>(itr.get_tid());
+                    if(_pid <= 0 || _pid == m_self) continue;
+                }
+
+                auto _ip      = itr.get_ip();
+                auto _stack   = callstack_t{ _ip };
+                bool _skip_ip = true;
+                for(auto ditr : itr.get_callchain())
+                {
+                    // kernel context markers, e.g. PERF_CONTEXT_USER
+                    if(ditr >= PERF_CONTEXT_MAX) continue;
+                    // skip the first instance of current IP but allow after that
+                    // since this might be a recursive call
+                    if(ditr == _ip && _skip_ip)
+                        _skip_ip = false;
+                    else
+                        _stack.emplace_back(ditr);
+                }
+
+                auto& _process = get_process(_pid);
+                _process.stacks[_stack] += 1;
+                _process.threads[_tid] += 1;
+            }
+        }
+    }
+
+    // stops and closes the perf_events: nothing remains in the target afterwards
+    void detach()
+    {
+        if(m_events.empty()) return;
+
+        for(auto& itr : m_events)
+            itr.second->stop();
+        drain();
+        m_events.clear();
+
+        // the binaries which were loaded while sampling
+        for(const auto& itr : m_processes)
+            if(is_alive(itr.first)) m_symbols.add_process(itr.first);
+    }
+
+    size_t             size() const { return m_events.size(); }
+    const std::string& get_error() const { return m_error; }
+
+    attach_profile get_profile(double _duration)
+    {
+        m_symbols.load();
+
+        auto _data     = attach_profile{};
+        _data.duration = _duration;
+        _data.lost     = m_lost;
+        _data.cpus     = (m_config.system_wide) ? m_events_opened : 0;
+
+        for(const auto& pitr : m_processes)
+        {
+            auto _process    = process_profile{};
+            _process.pid     = pitr.first;
+            _process.command = pitr.second.command;
+            _process.threads = pitr.second.threads;
+
+            auto _names     = std::unordered_map<uintptr_t, std::string>{};
+            auto _functions = std::unordered_map<std::string, function_entry>{};
+            auto _unique    = std::unordered_set<std::string>{};
+            for(const auto& itr : pitr.second.stacks)
+            {
+                _process.samples += itr.second;
+                _unique.clear();
+                for(size_t i = 0; i < itr.first.size(); ++i)
+                {
+                    auto _addr = itr.first.at(i);
+                    auto nitr  = _names.find(_addr);
+                    if(nitr == _names.end())
+                        nitr = _names.emplace(_addr, m_symbols(pitr.first, _addr)).first;
+
+                    auto& _entry = _functions[nitr->second];
+                    if(i == 0) _entry.exclusive += itr.second;
+                    if(_unique.emplace(nitr->second).second)
+                        _entry.inclusive += itr.second;
+                }
+            }
+
+            _process.functions.assign(_functions.begin(), _functions.end());
+            std::sort(_process.functions.begin(), _process.functions.end(),
+                      [](const auto& _lhs, const auto& _rhs) {
+                          if(_lhs.second.exclusive != _rhs.second.exclusive)
+                              return _lhs.second.exclusive > _rhs.second.exclusive;
+                          if(_lhs.second.inclusive != _rhs.second.inclusive)
+                              return _lhs.second.inclusive > _rhs.second.inclusive;
+                          return _lhs.first < _rhs.first;
+                      });
+
+            _data.samples += _process.samples;
+            _data.processes.emplace_back(std::move(_process));
+        }
+
+        // the busiest processes first
+        std::stable_sort(_data.processes.begin(), _data.processes.end(),
+                         [](const auto& _lhs, const auto& _rhs) {
+                             return _lhs.samples > _rhs.samples;
+                         });
+        return _data;
+    }
+
+private:
+    size_t open_threads()
+    {
+        if(m_processes.empty()) get_process(m_config.pid);
+
+        size_t _n = 0;
+        for(auto itr : get_tids(m_config.pid))
+        {
+            if(m_events.count(itr) > 0) continue;
+
+            auto _event = std::make_unique<perf_event_t>();
+            _event->set_num_pages(m_config.num_pages);
+            if(auto _err = _event->open(m_config.frequency, 0, itr, -1); _err)
+            {
+                m_error = *_err;
+                // the thread may have exited since the scan
+                continue;
+            }
+            _event->start();
+            m_events.emplace(itr, std::move(_event));
+            ++_n;
+        }
+        m_events_opened += _n;
+        return _n;
+    }
+
+    size_t open_cpus()
+    {
+        if(!m_events.empty()) return 0;
+
+        auto _cpus = (m_config.cpus.empty()) ? get_online_cpus() : m_config.cpus;
+        for(auto itr : _cpus)
+        {
+            // the CPU clock of every process which runs on the CPU
+            auto _pe = perf_event_attr{};
+            memset(&_pe, 0, sizeof(_pe));
+            _pe.type                     = PERF_TYPE_SOFTWARE;
+            _pe.config                   = PERF_COUNT_SW_CPU_CLOCK;
+            _pe.sample_type              = PERF_SAMPLE_IP | PERF_SAMPLE_TID |
+                                           PERF_SAMPLE_CALLCHAIN;
+            _pe.sample_period            = (1.0 / m_config.frequency) * 1.0e9;
+            _pe.wakeup_events            = 10;
+            _pe.exclude_idle             = 1;
+            _pe.exclude_kernel           = 1;
+            _pe.exclude_hv               = 1;
+            _pe.exclude_callchain_kernel = 1;
+
+            auto _cpu   = static_cast<int>(itr);
+            auto _event = std::make_unique<perf_event_t>();
+            _event->set_num_pages(m_config.num_pages);
+            if(auto _err = _event->open(_pe, -1, _cpu); _err)
+            {
+                m_error = *_err;
+                continue;
+            }
+            _event->start();
+            m_events.emplace(_cpu, std::move(_event));
+        }
+        m_events_opened = m_events.size();
+        return m_events.size();
+    }
+
+    // the maps are read when the process is first sampled since it may exit before
+    // the sampling ends
+    process_samples& get_process(pid_t _pid)
+    {
+        auto itr = m_processes.find(_pid);
+        if(itr != m_processes.end()) return itr->second;
+
+        m_symbols.add_process(_pid);
+        auto& _v   = m_processes[_pid];
+        _v.command = get_command(_pid);
+        return _v;
+    }
+
+    // the keys are the thread ids or, system-wide, the CPUs
+    using event_map_t = std::map<pid_t, std::unique_ptr<perf_event_t>>;
+
+    attach_config                    m_config        = {};
+    pid_t                            m_self          = getpid();
+    uint64_t                         m_lost          = 0;
+    size_t                           m_events_opened = 0;
+    std::string                      m_error         = {};
+    event_map_t                      m_events        = {};
+    std::map<pid_t, process_samples> m_processes     = {};
+    symbol_resolver                  m_symbols       = {};
+};
+
+std::string
+get_output_filename(const attach_config& _cfg, const char* _ext)
+{
+    auto _dir = (_cfg.output.empty()) ? std::string{ "omnitrace-sample-attach" }
+                                      : _cfg.output;
+    auto _name = (_cfg.system_wide) ? "node-" + get_hostname()
+                                    : "attach-" + std::to_string(_cfg.pid);
+    return omnitrace::common::join("/", _dir, _name + _ext);
+}
+
+void
+write_text(const attach_config& _cfg, const attach_profile& _data)
+{
+    auto _fname = get_output_filename(_cfg, ".txt");
+    auto ofs    = std::ofstream{};
+    if(!filepath::open(ofs, _fname))
+        throw std::runtime_error("Error opening attach output file: " + _fname);
+
+    stream(std::cerr, color::info()) << "Outputting '" << _fname << "'...\n";
+
+    ofs << "duration (sec): " << std::setprecision(3) << std::fixed << _data.duration
+        << ", samples: " << _data.samples << ", lost records: " << _data.lost;
+    if(_cfg.system_wide)
+        ofs << ", host: " << get_hostname() << ", cpus: " << _data.cpus
+            << ", processes: " << _data.processes.size();
+    ofs << "\n";
+
+    for(const auto& pitr : _data.processes)
+    {
+        ofs << "\n"
+            << "pid: " << pitr.pid << ", command: " << pitr.command
+            << ", samples: " << pitr.samples << "\n";
+
+        ofs << "\n" << std::setw(12) << "samples" << " | thread\n";
+        for(const auto& itr : pitr.threads)
+            ofs << std::setw(12) << itr.second << " | " << itr.first << "\n";
+
+        ofs << "\n"
+            << std::setw(12) << "exclusive" << " | " << std::setw(12) << "inclusive"
+            << " | " << std::setw(14) << "exclusive (%)" << " | function\n";
+        for(const auto& itr : pitr.functions)
+        {
+            auto _percent =
+                (pitr.samples > 0) ? (100.0 * itr.second.exclusive) / pitr.samples : 0.0;
+            ofs << std::setw(12) << itr.second.exclusive << " | " << std::setw(12)
+                << itr.second.inclusive << " | " << std::setw(14) << std::setprecision(2)
+                << _percent << " | " << itr.first << "\n";
+        }
+    }
+}
+
+void
+write_json(const attach_config& _cfg, const attach_profile& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("attach");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("duration_sec", _data.duration),
+              cereal::make_nvp("samples", _data.samples),
+              cereal::make_nvp("lost_records", _data.lost),
+              cereal::make_nvp("system_wide", _cfg.system_wide));
+        if(_cfg.system_wide)
+            (*ar)(cereal::make_nvp("host", get_hostname()),
+                  cereal::make_nvp("cpus", _data.cpus));
+
+        ar->setNextName("processes");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& pitr : _data.processes)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("pid", pitr.pid),
+                  cereal::make_nvp("command", pitr.command),
+                  cereal::make_nvp("samples", pitr.samples));
+
+            ar->setNextName("threads");
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : pitr.threads)
+            {
+                ar->startNode();
+                (*ar)(cereal::make_nvp("tid", itr.first),
+                      cereal::make_nvp("samples", itr.second));
+                ar->finishNode();
+            }
+            ar->finishNode();
+
+            ar->setNextName("functions");
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : pitr.functions)
+            {
+                ar->startNode();
+                (*ar)(cereal::make_nvp("function", itr.first),
+                      cereal::make_nvp("exclusive", itr.second.exclusive),
+                      cereal::make_nvp("inclusive", itr.second.inclusive));
+                ar->finishNode();
+            }
+            ar->finishNode();
+
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = get_output_filename(_cfg, ".json");
+    auto ofs    = std::ofstream{};
+    if(!filepath::open(ofs, _fname))
+        throw std::runtime_error("Error opening attach output file: " + _fname);
+
+    stream(std::cerr, color::info()) << "Outputting '" << _fname << "'...\n";
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+attach_config&
+get_attach_config()
+{
+    static auto _v = attach_config{};
+    return _v;
+}
+
+int
+attach(const attach_config& _cfg)
+{
+    if(!_cfg.system_wide && (_cfg.pid <= 0 || !is_alive(_cfg.pid)))
+    {
+        stream(std::cerr, color::fatal())
+            << "Error! process " << _cfg.pid << " does not exist\n";
+        return EXIT_FAILURE;
+    }
+
+    if(_cfg.frequency <= 0.0 || _cfg.duration <= 0.0)
+    {
+        stream(std::cerr, color::fatal())
+            << "Error! the sampling frequency and the duration must be positive\n";
+        return EXIT_FAILURE;
+    }
+
+    // the settings are only used by the binary analysis, nothing is profiled here
+    tim::set_env("OMNITRACE_INIT_TOOLING", "OFF", 1);
+    omnitrace_init_library();
+
+    auto _session = attach_session{ _cfg };
+    _session.open();
+    if(_session.size() == 0)
+    {
+        auto _target = (_cfg.system_wide) ? std::string{ "any CPU" }
+                                          : "any thread of process " +
+                                                std::to_string(_cfg.pid);
+        stream(std::cerr, color::fatal()) << "Error! unable to sample " << _target
+                                          << ": " << _session.get_error() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction _action = {};
+    sigemptyset(&_action.sa_mask);
+    _action.sa_handler = &attach_signal_handler;
+    sigaction(SIGINT, &_action, nullptr);
+    sigaction(SIGTERM, &_action, nullptr);
+
+    if(_cfg.verbose >= 0)
+    {
+        auto _target = (_cfg.system_wide)
+                           ? std::to_string(_session.size()) + " CPUs"
+                           : std::to_string(_session.size()) + " threads of process " +
+                                 std::to_string(_cfg.pid);
+        stream(std::cerr, color::info())
+            << "Sampling " << _target << " at " << _cfg.frequency
+            << " interrupts per second for " << _cfg.duration << " seconds...\n";
+    }
+
+    using clock_type = std::chrono::steady_clock;
+
+    auto _is_running = [&_cfg]() { return _cfg.system_wide || is_alive(_cfg.pid); };
+    auto _beg        = clock_type::now();
+    auto _end        = _beg + std::chrono::duration_cast<clock_type::duration>(
+                               std::chrono::duration<double>{ _cfg.duration });
+    while(!attach_interrupted.load() && clock_type::now() < _end && _is_running())
+    {
+        std::this_thread::sleep_for(
+            std::min<clock_type::duration>(drain_interval, _end - clock_type::now()));
+        _session.drain();
+        if(auto _n = _session.open(); _n > 0 && _cfg.verbose >= 1)
+            stream(std::cerr, color::info()) << "Sampling " << _n << " new threads...\n";
+    }
+
+    _session.detach();
+
+    auto _elapsed = std::chrono::duration<double>{ clock_type::now() - _beg }.count();
+    if(_cfg.verbose >= 0)
+        stream(std::cerr, color::info())
+            << "Detached after " << std::setprecision(3) << std::fixed << _elapsed
+            << " seconds\n";
+
+    auto _data = _session.get_profile(_elapsed);
+
+    write_text(_cfg, _data);
+    write_json(_cfg, _data);
+
+    return EXIT_SUCCESS;
+}
@@ -26,6 +26,7 @@
 #include "common/environment.hpp"
 #include "common/join.hpp"
 #include "common/setup.hpp"
+#include "core/utility.hpp"
 
 #include <timemory/environment.hpp>
 #include <timemory/log/color.hpp>
@@ -392,6 +393,7 @@ parse_args(int argc, char** argv, std::vector<char*>& _env)
             auto _v = p.get<int>("verbose");
             verbose = _v;
             update_env(_env, "OMNITRACE_VERBOSE", _v);
+            get_attach_config().verbose = _v;
         });
 
     parser.start_group("GENERAL OPTIONS",
@@ -413,6 +415,7 @@ parse_args(int argc, char** argv, std::vector<char*>& _env)
         .action([&](parser_t& p) {
             auto _v = p.get<std::vector<std::string>>("output");
             update_env(_env, "OMNITRACE_OUTPUT_PATH", _v.at(0));
+            get_attach_config().output = _v.at(0);
             if(_v.size() > 1) update_env(_env, "OMNITRACE_OUTPUT_PREFIX", _v.at(1));
         });
     parser
@@ -479,6 +482,33 @@ parse_args(int argc, char** argv, std::vector<char*>& _env)
         .action([&](parser_t& p) {
             update_env(_env, "OMNITRACE_TRACE_DURATION", p.get<double>("duration"));
             update_env(_env, "OMNITRACE_SAMPLING_DURATION", p.get<double>("duration"));
+            get_attach_config().duration = p.get<double>("duration");
+        });
+
+    parser.start_group("ATTACH OPTIONS",
+                       "Sample a running process or the node instead of launching a "
+                       "command. No code is injected into the processes: the threads "
+                       "or the CPUs are sampled with perf_events for '--duration' "
+                       "seconds (default: 30) at '--freq' interrupts per second "
+                       "(default: 100) and the symbolized profile is written to the "
+                       "output path");
+    parser.add_argument({ "-p", "--pid" }, "Process identifier of the running process")
+        .count(1)
+        .dtype("int")
+        .action([&](parser_t& p) { get_attach_config().pid = p.get<int>("pid"); });
+    parser
+        .add_argument({ "--system-wide" },
+                      "Sample every process on these CPUs (default: all the online CPUs) "
+                      "instead of one process and write one combined profile of the "
+                      "node. Supports integers and/or ranges")
+        .min_count(0)
+        .dtype("int or range")
+        .action([&](parser_t& p) {
+            auto _v = p.get<std::vector<std::string>>("system-wide");
+            get_attach_config().system_wide = true;
+            if(!_v.empty())
+                get_attach_config().cpus = omnitrace::utility::parse_numeric_range<>(
+                    join(array_config{ "," }, _v), "CPUs", 1L);
         });
 
     parser.start_group("TRACING OPTIONS", "Specific options controlling tracing (i.e. "
@@ -649,6 +679,7 @@ parse_args(int argc, char** argv, std::vector<char*>& _env)
         .count(1)
         .action([&](parser_t& p) {
             update_env(_env, "OMNITRACE_SAMPLING_FREQ", p.get<double>("freq"));
+            get_attach_config().frequency = p.get<double>("freq");
         });
     parser
         .add_argument(
@@ -23,6 +23,7 @@
 #include "omnitrace-sample.hpp"
 
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string_view>
 #include <unistd.h>
@@ -37,7 +38,8 @@ main(int argc, char** argv)
     {
         auto _arg = std::string_view{ argv[i] };
         if(_arg == "--" || _arg == "-?" || _arg == "-h" || _arg == "--help" ||
-           _arg == "--version")
+           _arg == "--version" || _arg == "-p" || _arg == "--pid" ||
+           _arg == "--system-wide")
             _has_double_hyphen = true;
     }
 
@@ -53,6 +55,14 @@ main(int argc, char** argv)
             _argv.emplace_back(argv[i]);
     }
 
+    if(get_attach_config().pid > 0 || get_attach_config().system_wide)
+    {
+        // the command is only informative, e.g. the command which started the process
+        if(!_argv.empty() && get_attach_config().verbose >= 1)
+            std::cerr << "Ignoring the command after '--' when attaching to a process\n";
+        return attach(get_attach_config());
+    }
+
     print_updated_environment(_env);
 
     if(!_argv.empty())
@@ -22,10 +22,28 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <set>
 #include <string>
 #include <string_view>
+#include <sys/types.h>
 #include <vector>
 
+// options of sampling a running process (omnitrace-sample -p <pid>) or every process
+// on the node (omnitrace-sample --system-wide)
+struct attach_config
+{
+    pid_t             pid         = 0;
+    bool              system_wide = false;
+    int               verbose     = 0;
+    double            duration    = 30.0;   // seconds
+    double            frequency   = 100.0;  // interrupts per second
+    size_t            num_pages   = 32;     // ring buffer pages per thread or CPU
+    std::string       output      = {};
+    std::set<int64_t> cpus        = {};  // system-wide, empty for all the online CPUs
+};
+
 std::string
 get_realpath(const std::string&);
 
@@ -49,3 +67,11 @@ remove_env(std::vector<char*>&, std::string_view);
 
 std::vector<char*>
 parse_args(int argc, char** argv, std::vector<char*>&);
+
+attach_config&
+get_attach_config();
+
+// samples the threads of a running process or, system-wide, the CPUs with perf_events,
+// without injecting any code, for the duration and writes the symbolized profile
+int
+attach(const attach_config&);
@@ -0,0 +1,441 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// measures the cost per operation of the omnitrace primitives on the hot paths for an
+// increasing number of threads. Linked against the static omnitrace library so the
+// internal functions can be called directly
+//
+//      omnitrace-benchmark [--iterations N] [--threads 1 2 4 ...] [--filter REGEX]
+//
+
+#include "api.hpp"
+#include "binary/address_multirange.hpp"
+#include "core/categories.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/containers/stable_vector.hpp"
+#include "core/containers/static_vector.hpp"
+#include "core/state.hpp"
+#include "library/components/backtrace.hpp"
+#include "library/components/callchain.hpp"
+#include "library/thread_data.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+#    include "library/roctracer.hpp"
+#endif
+
+#include <timemory/hash/types.hpp>
+#include <timemory/utility/argparse.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using clock_type    = std::chrono::steady_clock;
+using runner_t      = std::function<void(size_t)>;
+using make_runner_t = std::function<runner_t()>;
+
+struct benchmark
+{
+    std::string           name      = {};
+    std::function<bool()> available = []() { return true; };
+    make_runner_t         make      = {};  // invoked on each thread
+};
+
+struct result
+{
+    double mean = 0.0;  // nsec per operation
+    double min  = 0.0;
+    double max  = 0.0;
+};
+
+struct benchmark_tag
+{};
+
+struct benchmark_data
+{
+    uint64_t value = 0;
+};
+
+// prevents the compiler from discarding the results
+std::atomic<uint64_t> sink = { 0 };
+
+auto
+get_address_multirange()
+{
+    static auto _v = []() {
+        auto _ranges = omnitrace::binary::address_multirange{};
+        for(uintptr_t i = 0; i < 1024; ++i)
+            _ranges += omnitrace::binary::address_range{ 0x10000 + (i * 4096),
+                                                         0x10000 + (i * 4096) + 256 };
+        _ranges.freeze();
+        return _ranges;
+    }();
+    return &_v;
+}
+
+auto
+get_call_stack()
+{
+    return std::vector<uintptr_t>(omnitrace::component::callchain::stack_depth, 0x10000);
+}
+
+std::vector<benchmark>
+get_benchmarks()
+{
+    using namespace omnitrace;
+
+    auto _v = std::vector<benchmark>{};
+
+    _v.emplace_back(benchmark{
+        "push_region/pop_region", []() { return get_state() == State::Active; },
+        []() -> runner_t {
+            return [](size_t _n) {
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    omnitrace_push_region("omnitrace-benchmark");
+                    omnitrace_pop_region("omnitrace-benchmark");
+                }
+            };
+        } });
+
+    _v.emplace_back(benchmark{
+        "push_perfetto/pop_perfetto", []() { return get_use_perfetto(); },
+        []() -> runner_t {
+            return [](size_t _n) {
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    tracing::push_perfetto(category::host{}, "omnitrace-benchmark");
+                    tracing::pop_perfetto(category::host{}, "omnitrace-benchmark");
+                }
+            };
+        } });
+
+    _v.emplace_back(benchmark{
+        "push_timemory/pop_timemory", []() { return get_use_timemory(); },
+        []() -> runner_t {
+            auto _hash = tim::add_hash_id("omnitrace-benchmark");
+            return [_hash](size_t _n) {
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    tracing::push_timemory(category::host{}, _hash);
+                    tracing::pop_timemory(category::host{}, _hash);
+                }
+            };
+        } });
+
+    _v.emplace_back(benchmark{ "backtrace::sample", []() { return true; },
+                               []() -> runner_t {
+                                   return [](size_t _n) {
+                                       auto _bt = component::backtrace{};
+                                       for(size_t i = 0; i < _n; ++i)
+                                           _bt.sample(SIGPROF);
+                                       sink += _bt.size();
+                                   };
+                               } });
+
+    // without perf events on this thread, this measures the path which finds no
+    // pending records in the ring buffer
+    _v.emplace_back(benchmark{ "callchain::sample", []() { return true; },
+                               []() -> runner_t {
+                                   return [](size_t _n) {
+                                       auto _cc  = component::callchain{};
+                                       auto _sig = get_sampling_overflow_signal();
+                                       for(size_t i = 0; i < _n; ++i)
+                                           _cc.sample(_sig);
+                                       sink += _cc.size();
+                                   };
+                               } });
+
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    _v.emplace_back(benchmark{
+        "hip_api_callback",
+        []() {
+            return get_state() == State::Active &&
+                   trait::runtime_enabled<comp::roctracer>::get();
+        },
+        []() -> runner_t {
+            return [](size_t _n) {
+                static auto _cid  = std::atomic<uint64_t>{ 1 };
+                auto        _data = hip_api_data_t{};
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    _data.correlation_id = _cid++;
+                    _data.phase          = ACTIVITY_API_PHASE_ENTER;
+                    hip_api_callback(ACTIVITY_DOMAIN_HIP_API, HIP_API_ID_hipGetLastError,
+                                     &_data, nullptr);
+                    _data.phase = ACTIVITY_API_PHASE_EXIT;
+                    hip_api_callback(ACTIVITY_DOMAIN_HIP_API, HIP_API_ID_hipGetLastError,
+                                     &_data, nullptr);
+                }
+            };
+        } });
+#endif
+
+    _v.emplace_back(benchmark{
+        "thread_data<>::instance", []() { return true; },
+        []() -> runner_t {
+            return [](size_t _n) {
+                using thread_data_t = thread_data<benchmark_data, benchmark_tag>;
+                for(size_t i = 0; i < _n; ++i)
+                    ++thread_data_t::instance(construct_on_thread{})->value;
+                sink += thread_data_t::instance()->value;
+            };
+        } });
+
+    _v.emplace_back(benchmark{
+        "stable_vector::emplace_back", []() { return true; },
+        []() -> runner_t {
+            return [](size_t _n) {
+                // the vector is discarded periodically so the growth (allocation of
+                // new chunks) is included in the cost
+                for(size_t i = 0; i < _n;)
+                {
+                    auto _data = container::stable_vector<uint64_t, 1024>{};
+                    for(size_t j = 0; j < 65536 && i < _n; ++j, ++i)
+                        _data.emplace_back(i);
+                    sink += _data.size();
+                }
+            };
+        } });
+
+    _v.emplace_back(benchmark{
+        "stable_vector::append", []() { return true; },
+        []() -> runner_t {
+            return [](size_t _n) {
+                // same growth as stable_vector::emplace_back but the elements are
+                // appended in blocks of 64
+                auto _block = std::vector<uint64_t>(64, 0);
+                for(size_t i = 0; i < _n;)
+                {
+                    auto _data = container::stable_vector<uint64_t, 1024>{};
+                    for(size_t j = 0; j < 65536 && i < _n; j += 64, i += 64)
+                        _data.append(_block);
+                    sink += _data.size();
+                }
+            };
+        } });
+
+    // copies a call-stack of the maximum depth into a sample record, i.e. per element
+    // vs. in bulk
+    _v.emplace_back(benchmark{
+        "static_vector::emplace_back", []() { return true; },
+        []() -> runner_t {
+            return [](size_t _n) {
+                auto _stack  = get_call_stack();
+                auto _record = component::callchain::record{};
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    _record.data.clear();
+                    for(auto itr : _stack)
+                        _record.data.emplace_back(itr);
+                    sink += _record.data.back();
+                }
+            };
+        } });
+
+    _v.emplace_back(benchmark{
+        "static_vector::append", []() { return true; },
+        []() -> runner_t {
+            return [](size_t _n) {
+                auto _stack  = get_call_stack();
+                auto _record = component::callchain::record{};
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    _record.data.clear();
+                    _record.data.append(_stack);
+                    sink += _record.data.back();
+                }
+            };
+        } });
+
+    _v.emplace_back(benchmark{
+        "address_multirange::contains", []() { return true; },
+        []() -> runner_t {
+            const auto* _ranges = get_address_multirange();
+            return [_ranges](size_t _n) {
+                // xorshift so the addresses are not predictable
+                uint64_t _state = 0x9e3779b97f4a7c15ULL;
+                uint64_t _count = 0;
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    _state ^= _state << 13;
+                    _state ^= _state >> 7;
+                    _state ^= _state << 17;
+                    _count += _ranges->contains(0x10000 + (_state % (1024 * 4096)));
+                }
+                sink += _count;
+            };
+        } });
+
+    return _v;
+}
+
+result
+run(const benchmark& _bench, size_t _nthreads, size_t _iterations)
+{
+    auto _ready  = std::atomic<size_t>{ 0 };
+    auto _nsecs  = std::vector<double>(_nthreads, 0.0);
+    auto _worker = [&](size_t _idx) {
+        omnitrace::thread_info::init();
+        // initializes the per-thread tracing data
+        omnitrace_push_region("omnitrace-benchmark-warmup");
+        omnitrace_pop_region("omnitrace-benchmark-warmup");
+
+        auto _runner = _bench.make();
+        _runner(std::max<size_t>(_iterations / 10, 1));
+
+        // wait until every thread has warmed up
+        ++_ready;
+        while(_ready.load() < _nthreads)
+            std::this_thread::yield();
+
+        auto _beg = clock_type::now();
+        _runner(_iterations);
+        auto _end = clock_type::now();
+
+        _nsecs.at(_idx) = std::chrono::duration<double, std::nano>(_end - _beg).count();
+    };
+
+    auto _threads = std::vector<std::thread>{};
+    for(size_t i = 1; i < _nthreads; ++i)
+        _threads.emplace_back(_worker, i);
+
+    // the main thread participates so a single thread measures the main thread
+    _worker(0);
+
+    for(auto& itr : _threads)
+        itr.join();
+
+    auto _v = result{ 0.0, _nsecs.front(), _nsecs.front() };
+    for(auto itr : _nsecs)
+    {
+        _v.mean += itr / _nthreads;
+        _v.min = std::min(_v.min, itr);
+        _v.max = std::max(_v.max, itr);
+    }
+    _v.mean /= _iterations;
+    _v.min /= _iterations;
+    _v.max /= _iterations;
+    return _v;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    using parser_t     = tim::argparse::argument_parser;
+    using parser_err_t = typename parser_t::result_type;
+
+    auto _iterations = size_t{ 100000 };
+    auto _threads    = std::vector<size_t>{};
+    auto _filter     = std::string{ ".*" };
+    auto _csv        = false;
+
+    for(size_t i = 1; i <= std::min<size_t>(std::thread::hardware_concurrency(), 16);
+        i *= 2)
+        _threads.emplace_back(i);
+
+    auto parser = parser_t{ argv[0] };
+    parser.on_error([](parser_t&, const parser_err_t& _err) {
+        fprintf(stderr, "%s\n", _err.what());
+        exit(EXIT_FAILURE);
+    });
+    parser.enable_help();
+    parser.add_argument({ "-i", "--iterations" }, "Operations per thread")
+        .count(1)
+        .dtype("size_t")
+        .action([&](parser_t& p) { _iterations = p.get<size_t>("iterations"); });
+    parser.add_argument({ "-t", "--threads" }, "Number of threads for each measurement")
+        .min_count(1)
+        .dtype("size_t")
+        .action([&](parser_t& p) { _threads = p.get<std::vector<size_t>>("threads"); });
+    parser.add_argument({ "-f", "--filter" }, "Only run the benchmarks matching a regex")
+        .count(1)
+        .action([&](parser_t& p) { _filter = p.get<std::string>("filter"); });
+    parser.add_argument({ "--csv" }, "Print the results as comma-separated values")
+        .max_count(1)
+        .action([&](parser_t& p) { _csv = p.get<bool>("csv"); });
+
+    auto _err = parser.parse_args(argc, argv);
+    if(parser.exists("help"))
+    {
+        parser.print_help();
+        return EXIT_SUCCESS;
+    }
+    if(_err) return (fprintf(stderr, "%s\n", _err.what()), EXIT_FAILURE);
+
+    // time only the primitives: no samplers or background threads
+    setenv("OMNITRACE_USE_SAMPLING", "OFF", 0);
+    setenv("OMNITRACE_USE_PROCESS_SAMPLING", "OFF", 0);
+    setenv("OMNITRACE_TRACE", "ON", 0);
+    setenv("OMNITRACE_PROFILE", "ON", 0);
+    setenv("OMNITRACE_TIME_OUTPUT", "OFF", 0);
+
+    omnitrace_init_tooling();
+
+    if(_csv)
+        printf("benchmark,threads,iterations,mean_ns_per_op,min_ns_per_op,"
+               "max_ns_per_op\n");
+    else
+        printf("%-30s %8s %12s %12s %12s %12s\n", "benchmark", "threads", "iterations",
+               "ns/op", "min ns/op", "max ns/op");
+
+    auto _regex = std::regex{ _filter };
+    for(const auto& itr : get_benchmarks())
+    {
+        if(!std::regex_search(itr.name, _regex)) continue;
+        if(!itr.available())
+        {
+            if(!_csv) printf("%-30s %8s\n", itr.name.c_str(), "skipped");
+            continue;
+        }
+
+        for(auto nitr : _threads)
+        {
+            auto _v = run(itr, std::max<size_t>(nitr, 1), _iterations);
+            if(_csv)
+                printf("%s,%zu,%zu,%.3f,%.3f,%.3f\n", itr.name.c_str(), nitr,
+                       _iterations, _v.mean, _v.min, _v.max);
+            else
+                printf("%-30s %8zu %12zu %12.1f %12.1f %12.1f\n", itr.name.c_str(), nitr,
+                       _iterations, _v.mean, _v.min, _v.max);
+        }
+    }
+
+    omnitrace_finalize();
+
+    return EXIT_SUCCESS;
+}
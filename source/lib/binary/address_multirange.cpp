@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <utility>
 
@@ -52,6 +53,7 @@ address_multirange&
 address_multirange::operator+=(uintptr_t _v)
 {
     *this += std::make_pair(coarse{}, _v);
+    m_frozen = false;
 
     // for(auto&& itr : m_fine_ranges)
     //    if(itr.contains(_v)) return *this;
@@ -64,6 +66,7 @@ address_multirange&
 address_multirange::operator+=(address_range _v)
 {
     *this += std::make_pair(coarse{}, _v);
+    m_frozen = false;
 
     // for(auto&& itr : m_fine_ranges)
     //    if(itr.contains(_v)) return *this;
@@ -71,5 +74,43 @@ address_multirange::operator+=(address_range _v)
     m_fine_ranges.emplace(_v);
     return *this;
 }
+
+void
+address_multirange::freeze()
+{
+    m_lows.clear();
+    m_highs.clear();
+    m_lows.reserve(m_fine_ranges.size());
+    m_highs.reserve(m_fine_ranges.size());
+
+    auto _ranges = std::vector<std::pair<uintptr_t, uintptr_t>>{};
+    _ranges.reserve(m_fine_ranges.size());
+    for(const auto& itr : m_fine_ranges)
+    {
+        if(itr.is_range())
+            _ranges.emplace_back(itr.low, itr.high);
+        else if(itr.low < std::numeric_limits<uintptr_t>::max())
+            // a single address is equivalent to the half-open range [low, low + 1)
+            _ranges.emplace_back(itr.low, itr.low + 1);
+    }
+
+    std::sort(_ranges.begin(), _ranges.end());
+
+    // merge the overlapping and adjacent ranges
+    for(const auto& itr : _ranges)
+    {
+        if(!m_lows.empty() && itr.first <= m_highs.back())
+            m_highs.back() = std::max(m_highs.back(), itr.second);
+        else
+        {
+            m_lows.emplace_back(itr.first);
+            m_highs.emplace_back(itr.second);
+        }
+    }
+
+    m_lows.shrink_to_fit();
+    m_highs.shrink_to_fit();
+    m_frozen = true;
+}
 }  // namespace binary
 }  // namespace omnitrace
@@ -27,8 +27,10 @@
 
 #include <timemory/utility/macros.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
+#include <vector>
 
 namespace omnitrace
 {
@@ -49,6 +51,12 @@ struct address_multirange
     template <typename Tp>
     bool contains(Tp&& _v) const;
 
+    // builds merged, sorted arrays of the lower and upper bounds of the ranges which are
+    // binary searched when checking whether an address is contained. Any subsequent
+    // addition of a range discards the frozen representation
+    void freeze();
+    bool is_frozen() const { return m_frozen; }
+
     auto size() const { return m_fine_ranges.size(); }
     auto empty() const { return m_fine_ranges.empty(); }
     auto range_size() const { return m_coarse_range.size(); }
@@ -56,10 +64,33 @@ struct address_multirange
     auto get_ranges() const { return m_fine_ranges; }
 
 private:
+    bool contains_frozen(uintptr_t) const;
+
+    bool                    m_frozen       = false;
     address_range           m_coarse_range = {};
     std::set<address_range> m_fine_ranges  = {};
+    std::vector<uintptr_t>  m_lows         = {};
+    std::vector<uintptr_t>  m_highs        = {};
 };
 
+inline bool
+address_multirange::contains_frozen(uintptr_t _v) const
+{
+    size_t _n = m_lows.size();
+    if(_n == 0) return false;
+
+    // branchless search for the last lower bound which is <= the address
+    const uintptr_t* _base = m_lows.data();
+    while(_n > 1)
+    {
+        size_t _half = _n / 2;
+        _base        = (_base[_half] <= _v) ? _base + _half : _base;
+        _n -= _half;
+    }
+
+    return (*_base <= _v) && (_v < m_highs[_base - m_lows.data()]);
+}
+
 template <typename Tp>
 OMNITRACE_INLINE bool
 address_multirange::contains(Tp&& _v) const
@@ -70,6 +101,10 @@ address_multirange::contains(Tp&& _v) const
                   "Error! operator+= supports only integrals or address_ranges");
 
     if(!m_coarse_range.contains(_v)) return false;
+    if constexpr(std::is_integral<type>::value)
+    {
+        if(m_frozen) return contains_frozen(static_cast<uintptr_t>(_v));
+    }
     return std::any_of(m_fine_ranges.begin(), m_fine_ranges.end(),
                        [_v](auto&& itr) { return itr.contains(_v); });
 }
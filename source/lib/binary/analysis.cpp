@@ -31,6 +31,7 @@
 #include <bfd.h>
 
 #include "analysis.hpp"
+#include "analysis_cache.hpp"
 #include "binary_info.hpp"
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
@@ -53,12 +54,17 @@
 #include <timemory/utility/join.hpp>
 #include <timemory/utility/procfs/maps.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <dlfcn.h>
+#include <exception>
+#include <mutex>
 #include <regex>
 #include <set>
 #include <stdexcept>
+#include <thread>
 
 namespace omnitrace
 {
@@ -70,7 +76,11 @@ binary_info
 parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd,
                 bool _include_all)
 {
+    // the BFD library has global state so only one binary is read with it at a time
+    static auto _bfd_mutex = std::mutex{};
+
     auto _info = binary_info{};
+    auto _lk   = std::unique_lock<std::mutex>{ _bfd_mutex };
 
     auto& _bfd = _info.bfd;
     _bfd       = std::make_shared<bfd_file>(_name);
@@ -109,12 +119,24 @@ parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd
             << "section set size (" << _section_set.size() << ") != section map size ("
             << _section_map.size() << ")\n";
 
+        _lk.unlock();
+
         if(_process_dwarf)
         {
             std::tie(_info.debug_info, _info.ranges, _info.breakpoints) =
                 dwarf_entry::process_dwarf(_bfd->fd);
         }
 
+        // sorted once so that each symbol only visits the entries and breakpoints
+        // within its address range
+        auto _by_low = [](const dwarf_entry& _lhs, const dwarf_entry& _rhs) {
+            return _lhs.address.low < _rhs.address.low;
+        };
+        if(!std::is_sorted(_info.debug_info.begin(), _info.debug_info.end(), _by_low))
+            std::sort(_info.debug_info.begin(), _info.debug_info.end(), _by_low);
+        if(!std::is_sorted(_info.breakpoints.begin(), _info.breakpoints.end()))
+            std::sort(_info.breakpoints.begin(), _info.breakpoints.end());
+
         for(auto& itr : _info.symbols)
         {
             itr.read_dwarf_entries(_info.debug_info);
@@ -129,12 +151,106 @@ parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd
 
     return _info;
 }
+
+// reuses the line info saved by a previous run when OMNITRACE_BINARY_CACHE is enabled
+binary_info
+get_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd,
+              bool _include_all)
+{
+    if(!config::get_binary_cache())
+        return parse_line_info(_name, _process_dwarf, _process_bfd, _include_all);
+
+    auto _flags  = analysis_cache::get_flags(_process_dwarf, _process_bfd, _include_all);
+    auto _cached = analysis_cache::load(_name, _flags);
+    if(_cached) return std::move(*_cached);
+
+    auto _info = parse_line_info(_name, _process_dwarf, _process_bfd, _include_all);
+    if(_info.bfd && _info.bfd->is_good()) analysis_cache::save(_name, _flags, _info);
+    return _info;
+}
+
+// the address ranges of libomnitrace and libomnitrace-dl
+const std::set<address_range_t>&
+get_internal_address_ranges()
+{
+    static auto _v = []() {
+        auto _maps                 = ::tim::procfs::maps::iterate_program_headers();
+        auto _exclude_range_v      = std::set<address_range_t>{};
+        auto _insert_exclude_range = [&_maps,
+                                      &_exclude_range_v](const std::string& _v) {
+            auto _base_v = std::string_view{ filepath::basename(_v) };
+            auto _real_v = filepath::realpath(_v);
+            for(const auto& mitr : _maps)
+            {
+                if(std::string_view{ filepath::basename(mitr.pathname) } == _base_v ||
+                   _real_v == _v)
+                {
+                    _exclude_range_v.emplace(
+                        address_range_t{ mitr.load_address, mitr.last_address });
+                }
+            }
+        };
+
+        for(const auto& itr : binary::get_link_map("libomnitrace.so", "", ""))
+            _insert_exclude_range(itr.real());
+
+        for(const auto& itr : binary::get_link_map("libomnitrace-dl.so", "", ""))
+            _insert_exclude_range(itr.real());
+
+        return _exclude_range_v;
+    }();
+    return _v;
+}
 }  // namespace
 
+executor_t
+get_default_executor()
+{
+    return [](size_t _n, const std::function<void(size_t)>& _func) {
+        auto _nworkers = std::min<size_t>(config::get_binary_analysis_threads(), _n);
+        if(_nworkers < 2)
+        {
+            for(size_t i = 0; i < _n; ++i)
+                _func(i);
+            return;
+        }
+
+        OMNITRACE_BASIC_VERBOSE(1, "[binary] Processing %zu binaries on %zu threads...\n",
+                                _n, _nworkers);
+
+        auto _next   = std::atomic<size_t>{ 0 };
+        auto _mutex  = std::mutex{};
+        auto _failed = std::exception_ptr{};
+        auto _worker = [&]() {
+            for(size_t i = _next++; i < _n; i = _next++)
+            {
+                try
+                {
+                    _func(i);
+                } catch(...)
+                {
+                    auto _lk = std::unique_lock<std::mutex>{ _mutex };
+                    if(!_failed) _failed = std::current_exception();
+                }
+            }
+        };
+
+        auto _threads = std::vector<std::thread>{};
+        _threads.reserve(_nworkers - 1);
+        for(size_t i = 1; i < _nworkers; ++i)
+            _threads.emplace_back(_worker);
+        _worker();
+        for(auto& itr : _threads)
+            itr.join();
+
+        if(_failed) std::rethrow_exception(_failed);
+    };
+}
+
 std::vector<binary_info>
 get_binary_info(const std::vector<std::string>&  _files,
                 const std::vector<scope_filter>& _filters, bool _process_dwarf,
-                bool _process_bfd, bool _include_all)
+                bool _process_bfd, bool _include_all, const executor_t& _executor)
 {
     auto _satisfies_filter = [&_filters](auto _scope, const std::string& _value) {
         for(const auto& itr : _filters)  // NOLINT
@@ -159,8 +275,8 @@ get_binary_info(const std::vector<std::string>&  _files,
         return (filepath::exists(_path) && _satisfies_binary_filter(_path));
     };
 
-    auto _data = std::vector<binary_info>{};
-    _data.reserve(_files.size());
+    auto _filenames = std::vector<std::string>{};
+    _filenames.reserve(_files.size());
     {
         auto _exists = std::set<std::string>{};
         for(const auto& itr : _files)
@@ -169,24 +285,46 @@ get_binary_info(const std::vector<std::string>&  _files,
             if(filepath::exists(_filename) && _satisfies_binary_filter(_filename) &&
                _exists.find(_filename) == _exists.end())
             {
-                _data.emplace_back(parse_line_info(_filename, _process_dwarf,
-                                                   _process_bfd, _include_all));
+                _filenames.emplace_back(_filename);
                 _exists.emplace(_filename);
             }
         }
     }
 
+    // each binary has its own slot so the order does not depend on the executor
+    auto _data = std::vector<binary_info>(_filenames.size());
+    auto _func = [&](size_t _idx) {
+        _data.at(_idx) = get_line_info(_filenames.at(_idx), _process_dwarf, _process_bfd,
+                                       _include_all);
+    };
+
+    if(_executor)
+        _executor(_filenames.size(), _func);
+    else
+        get_default_executor()(_filenames.size(), _func);
+
     // get the memory maps
     auto _maps = procfs::get_contiguous_maps(process::get_id(), _filter, false);
+    update_mappings(_data, _maps);
+
+    return _data;
+}
 
+void
+update_mappings(std::vector<binary_info>& _data, const std::vector<procfs::maps>& _maps)
+{
     for(auto& itr : _data)
     {
+        itr.mappings.clear();
         for(const auto& mitr : _maps)
-            if(itr.bfd->name == mitr.pathname) itr.mappings.emplace_back(mitr);
+            if(itr.filename() == mitr.pathname) itr.mappings.emplace_back(mitr);
     }
 
     for(auto& itr : _data)
     {
+        for(auto& sitr : itr.symbols)
+            sitr.load_address = 0;
+
         for(const auto& mitr : itr.mappings)
         {
             auto mrange = address_range{ mitr.load_address, mitr.last_address };
@@ -200,8 +338,14 @@ get_binary_info(const std::vector<std::string>&  _files,
 
     for(auto& itr : _data)
         itr.sort();
+}
 
-    return _data;
+bool
+is_internal_ipaddr(uintptr_t _addr)
+{
+    for(const auto& itr : get_internal_address_ranges())
+        if(itr.contains(_addr)) return true;
+    return false;
 }
 
 template <bool ExcludeInternal>
@@ -219,35 +363,8 @@ lookup_ipaddr_entry(uintptr_t _addr, unw_context_t* _context_p,
 
     if constexpr(ExcludeInternal)
     {
-        static auto _exclude_range = []() {
-            auto _maps                 = ::tim::procfs::maps::iterate_program_headers();
-            auto _exclude_range_v      = std::set<address_range_t>{};
-            auto _insert_exclude_range = [&_maps,
-                                          &_exclude_range_v](const std::string& _v) {
-                auto _base_v = std::string_view{ filepath::basename(_v) };
-                auto _real_v = filepath::realpath(_v);
-                for(const auto& mitr : _maps)
-                {
-                    if(std::string_view{ filepath::basename(mitr.pathname) } == _base_v ||
-                       _real_v == _v)
-                    {
-                        _exclude_range_v.emplace(
-                            address_range_t{ mitr.load_address, mitr.last_address });
-                    }
-                }
-            };
-
-            for(const auto& itr : binary::get_link_map("libomnitrace.so", "", ""))
-                _insert_exclude_range(itr.real());
-
-            for(const auto& itr : binary::get_link_map("libomnitrace-dl.so", "", ""))
-                _insert_exclude_range(itr.real());
-
-            return _exclude_range_v;
-        }();
-
-        for(auto itr : _exclude_range)
-            if(itr.contains(_addr)) return std::optional<tim::unwind::processed_entry>{};
+        if(is_internal_ipaddr(_addr))
+            return std::optional<tim::unwind::processed_entry>{};
     }
 
     // NOLINTNEXTLINE(readability-misleading-indentation)
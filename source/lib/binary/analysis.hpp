@@ -37,6 +37,7 @@
 
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <regex>
@@ -53,10 +54,33 @@ namespace procfs = ::tim::procfs;  // NOLINT
 using bfd_file     = ::tim::unwind::bfd_file;
 using hash_value_t = ::tim::hash_value_t;
 
+/// invokes the functor for every index in [0, N), possibly concurrently, and returns
+/// once all the invocations have completed
+using executor_t = std::function<void(size_t, const std::function<void(size_t)>&)>;
+
+/// processes the binaries on OMNITRACE_BINARY_ANALYSIS_THREADS plain threads (or
+/// sequentially on the calling thread if there is one thread)
+executor_t
+get_default_executor();
+
+/// the binaries are processed independently by the executor (the default executor if
+/// none is provided). The BFD library is not thread-safe so only the DWARF processing
+/// and the cache of each binary overlap
 std::vector<binary_info>
 get_binary_info(const std::vector<std::string>&, const std::vector<scope_filter>&,
                 bool _process_dwarf = true, bool _process_bfd = true,
-                bool _include_all = false);
+                bool _include_all = false, const executor_t& _executor = {});
+
+/// assigns the memory maps of a process to the binaries and the load addresses of their
+/// symbols. get_binary_info uses the maps of the calling process; the maps of another
+/// process (e.g. procfs::get_contiguous_maps(pid, ...)) relocate the symbols into the
+/// address space of that process
+void
+update_mappings(std::vector<binary_info>&, const std::vector<procfs::maps>&);
+
+/// returns true if the instruction address is within libomnitrace or libomnitrace-dl
+bool
+is_internal_ipaddr(uintptr_t);
 
 template <bool ExcludeInternal>
 std::optional<tim::unwind::processed_entry>
@@ -0,0 +1,609 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "analysis_cache.hpp"
+#include "binary_info.hpp"
+#include "core/binary/address_range.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "dwarf_entry.hpp"
+#include "scope_filter.hpp"
+#include "symbol.hpp"
+
+#include <timemory/utility/filepath.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace binary
+{
+namespace analysis_cache
+{
+namespace
+{
+constexpr char     file_magic[8] = { 'O', 'M', 'N', 'I', 'B', 'I', 'N', 'F' };
+constexpr uint32_t file_version  = 2;
+
+// the file is the header followed by the tables in the order of the counts and the
+// string table. The symbols refer to spans of the inlines, dwarf and address tables
+struct file_header
+{
+    char     magic[8]        = {};
+    uint32_t version         = file_version;
+    uint32_t flags           = 0;
+    uint64_t variant         = 0;
+    uint64_t num_symbols     = 0;
+    uint64_t num_inlines     = 0;
+    uint64_t num_dwarf       = 0;  // debug_info followed by the dwarf info of the symbols
+    uint64_t num_ranges      = 0;
+    uint64_t num_addresses   = 0;  // breakpoints followed by those of the symbols
+    uint64_t num_debug_info  = 0;
+    uint64_t num_breakpoints = 0;
+    uint64_t strings_size    = 0;
+};
+
+struct span_record
+{
+    uint64_t begin = 0;
+    uint64_t count = 0;
+};
+
+struct symbol_record
+{
+    uint64_t    address_low  = 0;
+    uint64_t    address_high = 0;
+    uint64_t    base_address = 0;  // address and size of the bfd symbol
+    uint64_t    base_size    = 0;
+    uint64_t    name         = 0;  // offsets into the string table
+    uint64_t    func         = 0;
+    uint64_t    file         = 0;
+    span_record inlines      = {};
+    span_record dwarf        = {};
+    span_record breakpoints  = {};
+    uint32_t    line         = 0;
+    int32_t     binding      = 0;
+    int32_t     visibility   = 0;
+    uint32_t    padding      = 0;
+};
+
+struct inlined_record
+{
+    uint64_t file    = 0;
+    uint64_t func    = 0;
+    uint32_t line    = 0;
+    uint32_t padding = 0;
+};
+
+struct dwarf_record
+{
+    uint64_t address_low   = 0;
+    uint64_t address_high  = 0;
+    uint64_t file          = 0;
+    uint32_t line          = 0;
+    int32_t  col           = 0;
+    uint32_t vliw_op_index = 0;
+    uint32_t isa           = 0;
+    uint32_t discriminator = 0;
+    uint32_t flags         = 0;
+};
+
+struct range_record
+{
+    uint64_t low  = 0;
+    uint64_t high = 0;
+};
+
+static_assert(sizeof(file_header) % 8 == 0, "tables must be 8-byte aligned");
+static_assert(sizeof(symbol_record) % 8 == 0, "tables must be 8-byte aligned");
+static_assert(sizeof(inlined_record) % 8 == 0, "tables must be 8-byte aligned");
+static_assert(sizeof(dwarf_record) % 8 == 0, "tables must be 8-byte aligned");
+static_assert(sizeof(range_record) % 8 == 0, "tables must be 8-byte aligned");
+
+// bits of dwarf_record::flags
+constexpr uint32_t begin_statement_flag = (1 << 0);
+constexpr uint32_t end_sequence_flag    = (1 << 1);
+constexpr uint32_t line_block_flag      = (1 << 2);
+constexpr uint32_t prologue_end_flag    = (1 << 3);
+constexpr uint32_t epilogue_begin_flag  = (1 << 4);
+
+struct string_table
+{
+    uint64_t operator()(std::string_view _v)
+    {
+        auto _key = std::string{ _v };
+        auto itr  = offsets.find(_key);
+        if(itr != offsets.end()) return itr->second;
+        auto _offset = static_cast<uint64_t>(data.size());
+        data.append(_v.data(), _v.size());
+        data.push_back('\0');
+        offsets.emplace(std::move(_key), _offset);
+        return _offset;
+    }
+
+    std::unordered_map<std::string, uint64_t> offsets = {};
+    std::string                               data    = {};
+};
+
+template <typename Tp>
+std::string_view
+as_string_view(const Tp& _v)
+{
+    if constexpr(std::is_pointer<Tp>::value)
+        return (_v) ? std::string_view{ _v } : std::string_view{};
+    else
+        return std::string_view{ _v };
+}
+
+std::string
+as_hex(const unsigned char* _data, size_t _size)
+{
+    auto _ss = std::stringstream{};
+    _ss << std::hex << std::setfill('0');
+    for(size_t i = 0; i < _size; ++i)
+        _ss << std::setw(2) << static_cast<unsigned>(_data[i]);
+    return _ss.str();
+}
+
+// 64-bit FNV-1a so that the keys are stable across builds
+uint64_t
+get_fnv1a_hash(std::string_view _v)
+{
+    uint64_t _hash = 0xcbf29ce484222325ULL;
+    for(auto itr : _v)
+    {
+        _hash ^= static_cast<unsigned char>(itr);
+        _hash *= 0x100000001b3ULL;
+    }
+    return _hash;
+}
+
+std::string
+find_build_id(const char* _data, size_t _size)
+{
+    auto   _align = [](size_t _v) { return (_v + 3) & ~size_t{ 3 }; };
+    size_t _pos   = 0;
+    while(_pos + sizeof(Elf64_Nhdr) <= _size)
+    {
+        auto _nhdr = Elf64_Nhdr{};
+        memcpy(&_nhdr, _data + _pos, sizeof(_nhdr));
+        auto _name = _pos + sizeof(Elf64_Nhdr);
+        auto _desc = _name + _align(_nhdr.n_namesz);
+        auto _next = _desc + _align(_nhdr.n_descsz);
+        if(_next > _size) break;
+        if(_nhdr.n_type == NT_GNU_BUILD_ID && _nhdr.n_namesz == 4 &&
+           memcmp(_data + _name, "GNU", 4) == 0 && _nhdr.n_descsz > 0)
+            return as_hex(reinterpret_cast<const unsigned char*>(_data + _desc),
+                          _nhdr.n_descsz);
+        _pos = _next;
+    }
+    return std::string{};
+}
+
+// reads the NT_GNU_BUILD_ID note from the section headers of a 64-bit ELF file
+std::string
+read_build_id(int _fd, size_t _size)
+{
+    if(_size < sizeof(Elf64_Ehdr)) return std::string{};
+
+    void* _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if(_data == MAP_FAILED) return std::string{};
+
+    auto        _v    = std::string{};
+    const auto* _beg  = static_cast<const char*>(_data);
+    auto        _ehdr = Elf64_Ehdr{};
+    memcpy(&_ehdr, _beg, sizeof(_ehdr));
+    if(memcmp(_ehdr.e_ident, ELFMAG, SELFMAG) == 0 &&
+       _ehdr.e_ident[EI_CLASS] == ELFCLASS64 && _ehdr.e_shentsize == sizeof(Elf64_Shdr) &&
+       _ehdr.e_shoff > 0 && _ehdr.e_shoff <= _size &&
+       _ehdr.e_shnum <= (_size - _ehdr.e_shoff) / sizeof(Elf64_Shdr))
+    {
+        for(size_t i = 0; i < _ehdr.e_shnum && _v.empty(); ++i)
+        {
+            auto _shdr = Elf64_Shdr{};
+            memcpy(&_shdr, _beg + _ehdr.e_shoff + (i * sizeof(Elf64_Shdr)),
+                   sizeof(_shdr));
+            if(_shdr.sh_type != SHT_NOTE || _shdr.sh_offset > _size ||
+               _shdr.sh_size > _size - _shdr.sh_offset)
+                continue;
+            _v = find_build_id(_beg + _shdr.sh_offset, _shdr.sh_size);
+        }
+    }
+
+    munmap(_data, _size);
+    return _v;
+}
+
+std::string
+get_entry_filename(const std::string& _filename, uint32_t _flags, uint64_t _variant)
+{
+    auto _dir = config::get_binary_cache_dir();
+    if(_dir.empty()) return std::string{};
+    auto _key = get_key(_filename);
+    if(_key.empty()) return std::string{};
+    auto _base = JOIN('.', filepath::basename(_filename), _key, _flags);
+    if(_variant != 0)
+    {
+        auto _ss = std::stringstream{};
+        _ss << std::hex << std::setfill('0') << std::setw(16) << _variant;
+        _base = JOIN('.', _base, _ss.str());
+    }
+    return JOIN('/', _dir, JOIN('.', _base, "bin"));
+}
+
+template <typename Tp>
+void
+write_table(std::ostream& _os, const std::vector<Tp>& _v)
+{
+    if(!_v.empty())
+        _os.write(reinterpret_cast<const char*>(_v.data()),
+                  static_cast<std::streamsize>(_v.size() * sizeof(Tp)));
+}
+
+// returns the table at the offset and advances the offset or nullptr if the table
+// exceeds the size of the mapping
+template <typename Tp>
+const Tp*
+get_table(const mapping& _v, size_t& _offset, uint64_t _count)
+{
+    if(_offset > _v.size || _count > (_v.size - _offset) / sizeof(Tp)) return nullptr;
+    const auto* _table =
+        reinterpret_cast<const Tp*>(static_cast<const char*>(_v.data) + _offset);
+    _offset += _count * sizeof(Tp);
+    return _table;
+}
+
+std::optional<binary_info>
+read_entry(const std::shared_ptr<mapping>& _mapping, uint32_t _flags, uint64_t _variant)
+{
+    const auto& _map = *_mapping;
+    if(_map.size < sizeof(file_header)) return std::nullopt;
+
+    const auto* _header = static_cast<const file_header*>(_map.data);
+    if(memcmp(_header->magic, file_magic, sizeof(file_magic)) != 0 ||
+       _header->version != file_version || _header->flags != _flags ||
+       _header->variant != _variant ||
+       _header->num_debug_info > _header->num_dwarf ||
+       _header->num_breakpoints > _header->num_addresses)
+        return std::nullopt;
+
+    const auto& _hdr      = *_header;
+    size_t      _offset   = sizeof(file_header);
+    const auto* _symbols  = get_table<symbol_record>(_map, _offset, _hdr.num_symbols);
+    const auto* _inlines  = get_table<inlined_record>(_map, _offset, _hdr.num_inlines);
+    const auto* _dwarf    = get_table<dwarf_record>(_map, _offset, _hdr.num_dwarf);
+    const auto* _ranges   = get_table<range_record>(_map, _offset, _hdr.num_ranges);
+    const auto* _addrs    = get_table<uint64_t>(_map, _offset, _hdr.num_addresses);
+    const auto* _strings  = get_table<char>(_map, _offset, _hdr.strings_size);
+    auto        _nstrings = _hdr.strings_size;
+
+    if(!_symbols || !_inlines || !_dwarf || !_ranges || !_addrs || !_strings ||
+       _offset != _map.size || (_nstrings > 0 && _strings[_nstrings - 1] != '\0'))
+        return std::nullopt;
+
+    bool _valid      = true;
+    auto _get_string = [&](uint64_t _v) {
+        if(_v < _nstrings) return _strings + _v;
+        _valid = false;
+        return "";
+    };
+    auto _check_span = [&](const span_record& _v, uint64_t _size) {
+        _valid = _valid && _v.begin <= _size && _v.count <= _size - _v.begin;
+    };
+    auto _get_dwarf = [&](const dwarf_record& _v) {
+        auto _entry            = dwarf_entry{};
+        _entry.begin_statement = (_v.flags & begin_statement_flag) != 0;
+        _entry.end_sequence    = (_v.flags & end_sequence_flag) != 0;
+        _entry.line_block      = (_v.flags & line_block_flag) != 0;
+        _entry.prologue_end    = (_v.flags & prologue_end_flag) != 0;
+        _entry.epilogue_begin  = (_v.flags & epilogue_begin_flag) != 0;
+        _entry.line            = _v.line;
+        _entry.col             = _v.col;
+        _entry.vliw_op_index   = _v.vliw_op_index;
+        _entry.isa             = _v.isa;
+        _entry.discriminator   = _v.discriminator;
+        _entry.address         = address_range{ _v.address_low, _v.address_high };
+        _entry.file            = _get_string(_v.file);
+        return _entry;
+    };
+
+    auto _info  = binary_info{};
+    _info.cache = _mapping;
+
+    for(uint64_t i = 0; i < _header->num_debug_info; ++i)
+        _info.debug_info.emplace_back(_get_dwarf(_dwarf[i]));
+
+    _info.ranges.reserve(_header->num_ranges);
+    for(uint64_t i = 0; i < _header->num_ranges; ++i)
+        _info.ranges.emplace_back(address_range{ _ranges[i].low, _ranges[i].high });
+
+    _info.breakpoints.assign(_addrs, _addrs + _header->num_breakpoints);
+
+    for(uint64_t i = 0; i < _header->num_symbols && _valid; ++i)
+    {
+        const auto& _rec = _symbols[i];
+        _check_span(_rec.inlines, _header->num_inlines);
+        _check_span(_rec.dwarf, _header->num_dwarf);
+        _check_span(_rec.breakpoints, _header->num_addresses);
+        if(!_valid) break;
+
+        // the name of the bfd symbol refers to the string table of the mapping
+        auto _base       = bfd_file::symbol{};
+        _base.binding    = static_cast<decltype(_base.binding)>(_rec.binding);
+        _base.visibility = static_cast<decltype(_base.visibility)>(_rec.visibility);
+        _base.address    = _rec.base_address;
+        _base.symsize    = _rec.base_size;
+        _base.name       = _get_string(_rec.name);
+        _base.section    = nullptr;
+
+        auto& _sym   = _info.symbols.emplace_back(symbol{ _base });
+        _sym.address = address_range{ _rec.address_low, _rec.address_high };
+        _sym.line    = _rec.line;
+        _sym.func    = _get_string(_rec.func);
+        _sym.file    = _get_string(_rec.file);
+
+        _sym.inlines.reserve(_rec.inlines.count);
+        for(uint64_t j = 0; j < _rec.inlines.count; ++j)
+        {
+            const auto& _inl = _inlines[_rec.inlines.begin + j];
+            _sym.inlines.emplace_back(inlined_symbol{ _inl.line, _get_string(_inl.file),
+                                                      _get_string(_inl.func) });
+        }
+
+        _sym.dwarf_info.reserve(_rec.dwarf.count);
+        for(uint64_t j = 0; j < _rec.dwarf.count; ++j)
+            _sym.dwarf_info.emplace_back(_get_dwarf(_dwarf[_rec.dwarf.begin + j]));
+
+        _sym.breakpoints.assign(_addrs + _rec.breakpoints.begin,
+                                _addrs + _rec.breakpoints.begin + _rec.breakpoints.count);
+    }
+
+    if(!_valid) return std::nullopt;
+    return _info;
+}
+}  // namespace
+
+mapping::mapping(std::string _filename, const void* _data, size_t _size)
+: filename{ std::move(_filename) }
+, data{ _data }
+, size{ _size }
+{}
+
+mapping::~mapping()
+{
+    if(data && size > 0) munmap(const_cast<void*>(data), size);
+}
+
+uint32_t
+get_flags(bool _process_dwarf, bool _process_bfd, bool _include_all)
+{
+    return (_process_dwarf ? 1 : 0) | (_process_bfd ? 2 : 0) | (_include_all ? 4 : 0);
+}
+
+uint64_t
+get_variant(const std::vector<scope_filter>& _filters)
+{
+    if(_filters.empty()) return 0;
+
+    auto _ss = std::stringstream{};
+    for(const auto& itr : _filters)
+        _ss << static_cast<int>(itr.mode) << ':' << static_cast<int>(itr.scope) << ':'
+            << itr.expression << '\n';
+    // zero is reserved for the entries without filters
+    auto _v = get_fnv1a_hash(_ss.str());
+    return (_v == 0) ? 1 : _v;
+}
+
+std::string
+get_key(const std::string& _filename)
+{
+    int _fd = ::open(_filename.c_str(), O_RDONLY);
+    if(_fd < 0) return std::string{};
+
+    struct stat _st = {};
+    auto        _v  = std::string{};
+    if(fstat(_fd, &_st) == 0)
+    {
+        _v = read_build_id(_fd, _st.st_size);
+        if(_v.empty())
+        {
+            auto _hash =
+                get_fnv1a_hash(JOIN(':', _filename, _st.st_mtim.tv_sec,
+                                    _st.st_mtim.tv_nsec, _st.st_size));
+            auto _ss = std::stringstream{};
+            _ss << std::hex << std::setfill('0') << std::setw(16) << _hash;
+            _v = _ss.str();
+        }
+    }
+
+    ::close(_fd);
+    return _v;
+}
+
+std::optional<binary_info>
+load(const std::string& _filename, uint32_t _flags, uint64_t _variant)
+{
+    auto _path = get_entry_filename(_filename, _flags, _variant);
+    if(_path.empty()) return std::nullopt;
+
+    int _fd = ::open(_path.c_str(), O_RDONLY);
+    if(_fd < 0) return std::nullopt;
+
+    struct stat _st   = {};
+    void*       _data = MAP_FAILED;
+    if(fstat(_fd, &_st) == 0 && _st.st_size > 0)
+        _data = mmap(nullptr, _st.st_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    ::close(_fd);
+
+    if(_data == MAP_FAILED) return std::nullopt;
+
+    auto _info = read_entry(std::make_shared<mapping>(_filename, _data, _st.st_size),
+                            _flags, _variant);
+    if(!_info)
+    {
+        OMNITRACE_BASIC_VERBOSE(0, "[binary] Ignoring the invalid cache entry '%s'\n",
+                                _path.c_str());
+        return std::nullopt;
+    }
+
+    OMNITRACE_BASIC_VERBOSE(1,
+                            "[binary] Reading line info for '%s' from '%s'... %zu "
+                            "entries\n",
+                            _filename.c_str(), _path.c_str(), _info->symbols.size());
+    return _info;
+}
+
+bool
+save(const std::string& _filename, uint32_t _flags, const binary_info& _info,
+     uint64_t _variant)
+{
+    auto _path = get_entry_filename(_filename, _flags, _variant);
+    if(_path.empty()) return false;
+
+    auto _header     = file_header{};
+    auto _symbols    = std::vector<symbol_record>{};
+    auto _inlines    = std::vector<inlined_record>{};
+    auto _dwarf      = std::vector<dwarf_record>{};
+    auto _ranges     = std::vector<range_record>{};
+    auto _addrs      = std::vector<uint64_t>{};
+    auto _strings    = string_table{};
+    auto _add_dwarf  = [&_dwarf, &_strings](const dwarf_entry& _v) {
+        auto& _rec         = _dwarf.emplace_back();
+        _rec.address_low   = _v.address.low;
+        _rec.address_high  = _v.address.high;
+        _rec.file          = _strings(_v.file);
+        _rec.line          = _v.line;
+        _rec.col           = _v.col;
+        _rec.vliw_op_index = _v.vliw_op_index;
+        _rec.isa           = _v.isa;
+        _rec.discriminator = _v.discriminator;
+        _rec.flags = (_v.begin_statement ? begin_statement_flag : 0) |
+                     (_v.end_sequence ? end_sequence_flag : 0) |
+                     (_v.line_block ? line_block_flag : 0) |
+                     (_v.prologue_end ? prologue_end_flag : 0) |
+                     (_v.epilogue_begin ? epilogue_begin_flag : 0);
+    };
+
+    for(const auto& itr : _info.debug_info)
+        _add_dwarf(itr);
+
+    for(const auto& itr : _info.ranges)
+        _ranges.emplace_back(range_record{ itr.low, itr.high });
+
+    _addrs.assign(_info.breakpoints.begin(), _info.breakpoints.end());
+
+    _symbols.reserve(_info.symbols.size());
+    for(const auto& itr : _info.symbols)
+    {
+        const auto& _base = itr.get_base();
+        auto&       _rec  = _symbols.emplace_back();
+        _rec.address_low  = itr.address.low;
+        _rec.address_high = itr.address.high;
+        _rec.base_address = _base.address;
+        _rec.base_size    = _base.symsize;
+        _rec.name         = _strings(as_string_view(_base.name));
+        _rec.func         = _strings(itr.func);
+        _rec.file         = _strings(itr.file);
+        _rec.line         = itr.line;
+        _rec.binding      = static_cast<int32_t>(itr.binding);
+        _rec.visibility   = static_cast<int32_t>(itr.visibility);
+
+        _rec.inlines = span_record{ _inlines.size(), itr.inlines.size() };
+        for(const auto& iitr : itr.inlines)
+            _inlines.emplace_back(
+                inlined_record{ _strings(iitr.file), _strings(iitr.func), iitr.line, 0 });
+
+        _rec.dwarf = span_record{ _dwarf.size(), itr.dwarf_info.size() };
+        for(const auto& ditr : itr.dwarf_info)
+            _add_dwarf(ditr);
+
+        _rec.breakpoints = span_record{ _addrs.size(), itr.breakpoints.size() };
+        _addrs.insert(_addrs.end(), itr.breakpoints.begin(), itr.breakpoints.end());
+    }
+
+    memcpy(_header.magic, file_magic, sizeof(file_magic));
+    _header.flags           = _flags;
+    _header.variant         = _variant;
+    _header.num_symbols     = _symbols.size();
+    _header.num_inlines     = _inlines.size();
+    _header.num_dwarf       = _dwarf.size();
+    _header.num_ranges      = _ranges.size();
+    _header.num_addresses   = _addrs.size();
+    _header.num_debug_info  = _info.debug_info.size();
+    _header.num_breakpoints = _info.breakpoints.size();
+    _header.strings_size    = _strings.data.size();
+
+    // written to a temporary file and renamed so that a reader never sees a partial
+    // entry and concurrent writers of the same entry do not interleave
+    auto _tmp = JOIN('.', _path, getpid(), "tmp");
+    {
+        auto ofs = std::ofstream{};
+        if(!filepath::open(ofs, _tmp, std::ios::out | std::ios::binary))
+        {
+            OMNITRACE_BASIC_VERBOSE(1, "[binary] Unable to open cache entry '%s'\n",
+                                    _tmp.c_str());
+            return false;
+        }
+
+        ofs.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+        write_table(ofs, _symbols);
+        write_table(ofs, _inlines);
+        write_table(ofs, _dwarf);
+        write_table(ofs, _ranges);
+        write_table(ofs, _addrs);
+        ofs.write(_strings.data.data(),
+                  static_cast<std::streamsize>(_strings.data.size()));
+        if(!ofs.good())
+        {
+            ofs.close();
+            std::remove(_tmp.c_str());
+            return false;
+        }
+    }
+
+    if(std::rename(_tmp.c_str(), _path.c_str()) != 0)
+    {
+        std::remove(_tmp.c_str());
+        return false;
+    }
+
+    OMNITRACE_BASIC_VERBOSE(1, "[binary] Saved line info for '%s' to '%s'\n",
+                            _filename.c_str(), _path.c_str());
+    return true;
+}
+}  // namespace analysis_cache
+}  // namespace binary
+}  // namespace omnitrace
@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/binary/fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace binary
+{
+/// persistent cache of the binary_info produced by get_binary_info (see
+/// OMNITRACE_BINARY_CACHE). Each entry is a flat file of fixed-size records and a
+/// string table which is memory-mapped when loaded. The names of the symbols refer to
+/// the string table so the mapping is owned by the binary_info. A cached binary_info
+/// has no bfd handle and no section map
+namespace analysis_cache
+{
+/// read-only mapping of a cache entry
+struct mapping
+{
+    mapping(std::string _filename, const void* _data, size_t _size);
+    ~mapping();
+
+    mapping(const mapping&) = delete;
+    mapping& operator=(const mapping&) = delete;
+
+    std::string filename = {};  ///< the binary which the entry describes
+    const void* data     = nullptr;
+    size_t      size     = 0;
+};
+
+/// the flags distinguishing the entries of the same binary processed with different
+/// options
+uint32_t
+get_flags(bool _process_dwarf, bool _process_bfd, bool _include_all);
+
+/// the hash distinguishing the entries of the same binary after different filters,
+/// e.g. the eligible symbols of the causal profiling. Zero if there are no filters
+uint64_t
+get_variant(const std::vector<scope_filter>& _filters);
+
+/// the hex-encoded ELF build-id or, if the binary has none, a hash of its path,
+/// modification time and size. Empty if the binary can not be read
+std::string
+get_key(const std::string& _filename);
+
+/// returns the cached info of the binary or nothing if there is no valid entry
+std::optional<binary_info>
+load(const std::string& _filename, uint32_t _flags, uint64_t _variant = 0);
+
+/// writes the entry of the binary. Concurrent writers of the same entry are safe
+bool
+save(const std::string& _filename, uint32_t _flags, const binary_info&,
+     uint64_t _variant = 0);
+}  // namespace analysis_cache
+}  // namespace binary
+}  // namespace omnitrace
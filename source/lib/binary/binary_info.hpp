@@ -24,6 +24,7 @@
 
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
+#include "analysis_cache.hpp"
 #include "core/utility.hpp"
 #include "dwarf_entry.hpp"
 #include "symbol.hpp"
@@ -49,6 +50,7 @@ struct binary_info
     std::vector<address_range>               ranges      = {};
     std::vector<uintptr_t>                   breakpoints = {};
     std::unordered_map<address_range, void*> sections    = {};
+    std::shared_ptr<analysis_cache::mapping> cache       = {};  // if loaded from cache
 
     void        sort();
     std::string filename() const;
@@ -81,7 +83,8 @@ binary_info::find_section(uintptr_t _addr) const
 inline std::string
 binary_info::filename() const
 {
-    return (bfd) ? std::string{ bfd->name } : std::string{};
+    if(bfd) return std::string{ bfd->name };
+    return (cache) ? cache->filename : std::string{};
 }
 }  // namespace binary
 }  // namespace omnitrace
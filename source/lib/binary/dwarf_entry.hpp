@@ -24,6 +24,7 @@
 
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
+#include "interned_string.hpp"
 
 namespace omnitrace
 {
@@ -37,18 +38,18 @@ struct dwarf_entry
 
     OMNITRACE_DEFAULT_OBJECT(dwarf_entry)
 
-    bool          begin_statement = false;
-    bool          end_sequence    = false;
-    bool          line_block      = false;
-    bool          prologue_end    = false;
-    bool          epilogue_begin  = false;
-    unsigned int  line            = 0;
-    int           col             = 0;
-    unsigned int  vliw_op_index   = 0;
-    unsigned int  isa             = 0;
-    unsigned int  discriminator   = 0;
-    address_range address         = { 0, 0 };
-    std::string   file            = {};
+    bool            begin_statement = false;
+    bool            end_sequence    = false;
+    bool            line_block      = false;
+    bool            prologue_end    = false;
+    bool            epilogue_begin  = false;
+    unsigned int    line            = 0;
+    int             col             = 0;
+    unsigned int    vliw_op_index   = 0;
+    unsigned int    isa             = 0;
+    unsigned int    discriminator   = 0;
+    address_range   address         = { 0, 0 };
+    interned_string file            = {};
 
     bool is_valid() const;
 
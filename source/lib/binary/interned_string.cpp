@@ -0,0 +1,116 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "interned_string.hpp"
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace binary
+{
+namespace
+{
+// the binaries may be processed concurrently so the pool is split into shards with
+// their own lock
+constexpr size_t num_shards = 16;
+
+// the keys refer to the strings in the storage, which are never relocated
+struct pool_shard
+{
+    std::mutex                                               mutex   = {};
+    std::deque<std::string>                                  storage = {};
+    std::unordered_map<std::string_view, const std::string*> values  = {};
+};
+
+// intentionally leaked so the strings outlive every static object referring to them
+auto&
+get_pool()
+{
+    static auto* _v = new std::array<pool_shard, num_shards>{};
+    return *_v;
+}
+
+const std::string*
+intern(std::string_view _v)
+{
+    if(_v.empty()) return nullptr;
+
+    auto& _shard = get_pool()[std::hash<std::string_view>{}(_v) % num_shards];
+    auto  _lk    = std::unique_lock<std::mutex>{ _shard.mutex };
+    auto  itr    = _shard.values.find(_v);
+    if(itr != _shard.values.end()) return itr->second;
+
+    const auto* _value = &_shard.storage.emplace_back(_v);
+    _shard.values.emplace(std::string_view{ *_value }, _value);
+    return _value;
+}
+}  // namespace
+
+interned_string::interned_string(const char* _v)
+: m_value{ (_v) ? intern(std::string_view{ _v }) : nullptr }
+{}
+
+interned_string::interned_string(std::string_view _v)
+: m_value{ intern(_v) }
+{}
+
+interned_string::interned_string(const std::string& _v)
+: m_value{ intern(_v) }
+{}
+
+size_t
+interned_string::get_pool_bytes()
+{
+    // the nodes of the lookup table are estimated as the key, the value and two pointers
+    constexpr size_t node_size = sizeof(std::string_view) + (3 * sizeof(void*));
+
+    size_t _v = 0;
+    for(auto& itr : get_pool())
+    {
+        auto _lk = std::unique_lock<std::mutex>{ itr.mutex };
+        _v += (itr.storage.size() * sizeof(std::string)) +
+              (itr.values.size() * node_size) +
+              (itr.values.bucket_count() * sizeof(void*));
+        for(const auto& sitr : itr.storage)
+        {
+            // the characters of the short strings are stored inline
+            const auto* _beg = reinterpret_cast<const char*>(&sitr);
+            if(sitr.data() < _beg || sitr.data() >= _beg + sizeof(std::string))
+                _v += sitr.capacity() + 1;
+        }
+    }
+    return _v;
+}
+
+const std::string&
+interned_string::get_empty()
+{
+    static const auto* _v = new std::string{};
+    return *_v;
+}
+}  // namespace binary
+}  // namespace omnitrace
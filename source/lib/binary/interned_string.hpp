@@ -0,0 +1,111 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+namespace binary
+{
+/// handle to an immutable string in a process-wide pool. Equal strings share one
+/// allocation which is never released so a copy is the size of a pointer and the
+/// equality comparison is a pointer comparison. Used for the source file names of
+/// the symbols and the DWARF line table, which have few distinct values
+struct interned_string
+{
+    interned_string() = default;
+    interned_string(const char*);
+    interned_string(std::string_view);
+    interned_string(const std::string&);
+
+    const std::string& str() const { return (m_value) ? *m_value : get_empty(); }
+    const char*        c_str() const { return str().c_str(); }
+    size_t             length() const { return str().length(); }
+    size_t             size() const { return str().size(); }
+    bool               empty() const { return m_value == nullptr; }
+
+    operator const std::string&() const { return str(); }
+    operator std::string_view() const { return str(); }
+
+    template <typename ArchiveT>
+    std::string save_minimal(const ArchiveT&) const
+    {
+        return str();
+    }
+
+    template <typename ArchiveT>
+    void load_minimal(const ArchiveT&, const std::string& _v)
+    {
+        *this = interned_string{ _v };
+    }
+
+    friend bool operator==(interned_string _lhs, interned_string _rhs)
+    {
+        return _lhs.m_value == _rhs.m_value;
+    }
+
+    friend bool operator!=(interned_string _lhs, interned_string _rhs)
+    {
+        return _lhs.m_value != _rhs.m_value;
+    }
+
+    // ordered by value so that sorting does not depend on the allocation order
+    friend bool operator<(interned_string _lhs, interned_string _rhs)
+    {
+        return _lhs.m_value != _rhs.m_value && _lhs.str() < _rhs.str();
+    }
+
+    friend bool operator==(const interned_string& _lhs, const std::string& _rhs)
+    {
+        return _lhs.str() == _rhs;
+    }
+
+    friend bool operator==(const std::string& _lhs, const interned_string& _rhs)
+    {
+        return _lhs == _rhs.str();
+    }
+
+    friend bool operator==(const interned_string& _lhs, const char* _rhs)
+    {
+        return _lhs.str() == _rhs;
+    }
+
+    friend std::ostream& operator<<(std::ostream& _os, const interned_string& _v)
+    {
+        return (_os << _v.str());
+    }
+
+    /// bytes held by the pool (the strings and the entries of their lookup tables)
+    static size_t get_pool_bytes();
+
+private:
+    static const std::string& get_empty();
+
+    const std::string* m_value = nullptr;
+};
+}  // namespace binary
+}  // namespace omnitrace
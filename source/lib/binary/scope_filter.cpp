@@ -23,23 +23,82 @@
 #include "scope_filter.hpp"
 #include "core/exception.hpp"
 
+#include <deque>
+#include <mutex>
 #include <regex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
 namespace omnitrace
 {
 namespace binary
 {
+namespace
+{
+// the compiled regex of an expression and the results of the values it was applied to.
+// The same file and function names are checked against the filters many times, e.g.
+// once per DWARF entry and once per symbol
+struct expression_cache
+{
+    static constexpr size_t max_size = (1 << 20);
+
+    explicit expression_cache(const std::string& _expr)
+    : regex{ _expr }
+    {}
+
+    bool search(std::string_view _value)
+    {
+        {
+            auto _lk = std::unique_lock<std::mutex>{ mutex };
+            auto itr = values.find(_value);
+            if(itr != values.end()) return itr->second;
+        }
+
+        auto _result = std::regex_search(_value.begin(), _value.end(), regex);
+
+        auto _lk = std::unique_lock<std::mutex>{ mutex };
+        if(values.size() < max_size && values.count(_value) == 0)
+            values.emplace(std::string_view{ storage.emplace_back(_value) }, _result);
+        return _result;
+    }
+
+    const std::regex regex;
+    std::mutex       mutex = {};
+    // the keys refer to the strings in the storage, which are never relocated
+    std::deque<std::string>                    storage = {};
+    std::unordered_map<std::string_view, bool> values  = {};
+};
+
+expression_cache&
+get_expression_cache(const std::string& _expr)
+{
+    // intentionally leaked so the filters may be applied during the finalization
+    static auto* _caches = new std::unordered_map<std::string, expression_cache>{};
+    static auto  _mutex  = std::mutex{};
+
+    auto _lk = std::unique_lock<std::mutex>{ _mutex };
+    auto itr = _caches->find(_expr);
+    if(itr == _caches->end())
+        itr = _caches->emplace(std::piecewise_construct, std::forward_as_tuple(_expr),
+                               std::forward_as_tuple(_expr))
+                  .first;
+    // the elements of an unordered_map are not relocated by an insertion
+    return itr->second;
+}
+}  // namespace
+
 bool
 scope_filter::operator()(std::string_view _value) const
 {
     if(mode == FILTER_INCLUDE)
-        return (expression.empty())
-                   ? true
-                   : std::regex_search(_value.data(), std::regex{ expression });
+        return (expression.empty()) ? true
+                                    : get_expression_cache(expression).search(_value);
     else if(mode == FILTER_EXCLUDE)
-        return (expression.empty())
-                   ? false
-                   : !std::regex_search(_value.data(), std::regex{ expression });
+        return (expression.empty()) ? false
+                                    : !get_expression_cache(expression).search(_value);
     throw exception<std::runtime_error>{ "invalid scope filter mode" };
 }
 }  // namespace binary
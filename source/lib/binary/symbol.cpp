@@ -30,6 +30,7 @@
 #define PACKAGE     "omnitrace"
 #define L_LNNO_SIZE 4
 
+#include <algorithm>
 #include <bfd.h>
 #include <coff/external.h>
 #include <coff/internal.h>
@@ -152,9 +153,17 @@ symbol::operator bool() const
 size_t
 symbol::read_dwarf_entries(const std::deque<dwarf_entry>& _info)
 {
-    for(const auto& itr : _info)
+    // an entry can only be contained if it starts within the address range of the
+    // symbol so only the contiguous span of the (sorted) entries starting there is
+    // checked
+    auto _beg = std::lower_bound(
+        _info.begin(), _info.end(), address.low,
+        [](const dwarf_entry& _lhs, uintptr_t _v) { return _lhs.address.low < _v; });
+    for(auto itr = _beg; itr != _info.end() && (itr->address.low < address.high ||
+                                                itr->address.low == address.low);
+        ++itr)
     {
-        if(address.contains(itr.address)) dwarf_info.emplace_back(itr);
+        if(address.contains(itr->address)) dwarf_info.emplace_back(*itr);
     }
 
     // make sure the dwarf info is sorted by address (low to high)
@@ -204,14 +213,15 @@ symbol::read_dwarf_entries(const std::deque<dwarf_entry>& _info)
 size_t
 symbol::read_dwarf_breakpoints(const std::vector<uintptr_t>& _bkpts)
 {
-    for(const auto& itr : _bkpts)
+    // the breakpoints are sorted so the ones within the symbol are contiguous and
+    // remain sorted low to high
+    auto _beg = std::lower_bound(_bkpts.begin(), _bkpts.end(), address.low);
+    for(auto itr = _beg;
+        itr != _bkpts.end() && (*itr < address.high || *itr == address.low); ++itr)
     {
-        if(address.contains(itr)) breakpoints.emplace_back(itr);
+        if(address.contains(*itr)) breakpoints.emplace_back(*itr);
     }
 
-    // make sure the breakpoints are sorted low to high
-    std::sort(breakpoints.begin(), breakpoints.end());
-
     return breakpoints.size();
 }
 
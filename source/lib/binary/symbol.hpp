@@ -24,6 +24,7 @@
 
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
+#include "interned_string.hpp"
 
 #include <timemory/unwind/bfd.hpp>
 
@@ -38,9 +39,9 @@ namespace binary
 {
 struct inlined_symbol
 {
-    unsigned int line = 0;
-    std::string  file = {};
-    std::string  func = {};
+    unsigned int    line = 0;
+    interned_string file = {};
+    std::string     func = {};
 
     template <typename ArchiveT>
     void serialize(ArchiveT&, const unsigned int);
@@ -67,11 +68,14 @@ struct symbol : private tim::unwind::bfd_file::symbol
     explicit operator bool() const;
 
     bool          read_bfd_line_info(bfd_file&);
+    // the entries must be sorted by low address and the breakpoints low to high
     size_t        read_dwarf_entries(const std::deque<dwarf_entry>&);
     size_t        read_dwarf_breakpoints(const std::vector<uintptr_t>&);
     address_range ipaddr() const { return address + load_address; }
     symbol        clone() const;
 
+    const base_type& get_base() const { return *this; }
+
     template <typename Tp = std::deque<symbol>>
     Tp get_inline_symbols(const std::vector<scope_filter>&) const;
 
@@ -89,7 +93,7 @@ struct symbol : private tim::unwind::bfd_file::symbol
     uintptr_t                   load_address = 0;
     address_range               address      = {};
     std::string                 func         = {};
-    std::string                 file         = {};
+    interned_string             file         = {};
     std::vector<uintptr_t>      breakpoints  = {};
     std::vector<inlined_symbol> inlines      = {};
     std::vector<dwarf_entry>    dwarf_info   = {};
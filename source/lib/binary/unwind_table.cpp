@@ -0,0 +1,250 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "unwind_table.hpp"
+#include "core/debug.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <dlfcn.h>
+#include <link.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/auxv.h>
+#include <vector>
+
+#if !defined(UNW_LOCAL_ONLY)
+#    define UNW_LOCAL_ONLY
+#endif
+
+#include <libunwind.h>
+
+namespace omnitrace
+{
+namespace binary
+{
+namespace
+{
+// DW_EH_PE encodings used by the linkers for the binary search table of .eh_frame_hdr
+constexpr uint8_t eh_pe_udata4  = 0x03;
+constexpr uint8_t eh_pe_sdata4  = 0x0b;
+constexpr uint8_t eh_pe_datarel = 0x30;
+
+struct eh_frame_hdr
+{
+    uint8_t version          = 0;
+    uint8_t eh_frame_ptr_enc = 0;
+    uint8_t fde_count_enc    = 0;
+    uint8_t table_enc        = 0;
+};
+
+// entry of the binary search table, the offsets are relative to the .eh_frame_hdr
+struct eh_frame_hdr_entry
+{
+    int32_t start_ip_offset = 0;
+    int32_t fde_offset      = 0;
+};
+
+struct unwind_library
+{
+    std::string                                  name     = {};
+    uintptr_t                                    base     = 0;
+    uintptr_t                                    hdr      = 0;
+    uintptr_t                                    table    = 0;
+    size_t                                       entries  = 0;
+    void*                                        handle   = nullptr;
+    std::vector<std::pair<uintptr_t, uintptr_t>> segments = {};
+};
+
+// the registered unw_dyn_info_t are linked into the list of libunwind so they must
+// never be relocated and the nodes are never freed since a thread of the application
+// may still be walking the list when the tables are released
+struct unwind_registry
+{
+    std::mutex                 mutex     = {};
+    bool                       released  = false;
+    unsigned long long         adds      = 0;
+    std::map<uintptr_t, void*> libraries = {};
+    std::deque<unw_dyn_info_t> tables    = {};
+    std::deque<std::string>    names     = {};
+};
+
+auto&
+get_registry()
+{
+    static auto* _v = new unwind_registry{};
+    return *_v;
+}
+
+struct iterate_data
+{
+    unsigned long long          adds      = 0;
+    unsigned long long          prev_adds = 0;
+    const unwind_registry*      registry  = nullptr;
+    std::vector<unwind_library> libraries = {};
+};
+
+int
+find_unwind_tables(struct dl_phdr_info* _info, size_t _size, void* _data)
+{
+    auto* _v = static_cast<iterate_data*>(_data);
+
+    if(_size >= offsetof(struct dl_phdr_info, dlpi_subs))
+    {
+        _v->adds = _info->dlpi_adds;
+        // nothing was loaded since the last update
+        if(_v->adds == _v->prev_adds) return 1;
+    }
+
+    auto _lib = unwind_library{};
+    _lib.name = (_info->dlpi_name) ? _info->dlpi_name : "";
+    _lib.base = _info->dlpi_addr;
+
+    for(int i = 0; i < _info->dlpi_phnum; ++i)
+    {
+        const auto& _phdr = _info->dlpi_phdr[i];
+        if(_phdr.p_type == PT_GNU_EH_FRAME)
+            _lib.hdr = _info->dlpi_addr + _phdr.p_vaddr;
+        else if(_phdr.p_type == PT_LOAD && (_phdr.p_flags & PF_X) != 0)
+            _lib.segments.emplace_back(_info->dlpi_addr + _phdr.p_vaddr,
+                                       _info->dlpi_addr + _phdr.p_vaddr + _phdr.p_memsz);
+    }
+
+    if(_lib.hdr == 0 || _lib.segments.empty()) return 0;
+    if(_v->registry->libraries.count(_lib.hdr) > 0) return 0;
+
+    // libunwind only searches the tables of the lookups it performs on its own when they
+    // use the encoding below, the fde count and the .eh_frame pointer are 4 bytes
+    auto _hdr = eh_frame_hdr{};
+    memcpy(&_hdr, reinterpret_cast<const void*>(_lib.hdr), sizeof(_hdr));
+    if(_hdr.version != 1 || _hdr.fde_count_enc != eh_pe_udata4 ||
+       _hdr.table_enc != (eh_pe_datarel | eh_pe_sdata4) ||
+       ((_hdr.eh_frame_ptr_enc & 0x0f) != eh_pe_udata4 &&
+        (_hdr.eh_frame_ptr_enc & 0x0f) != eh_pe_sdata4))
+        return 0;
+
+    uint32_t _count = 0;
+    memcpy(&_count, reinterpret_cast<const void*>(_lib.hdr + 8), sizeof(_count));
+    if(_count == 0) return 0;
+
+    _lib.table   = _lib.hdr + 12;
+    _lib.entries = _count;
+    _v->libraries.emplace_back(std::move(_lib));
+    return 0;
+}
+
+bool
+is_vdso(uintptr_t _base)
+{
+    static auto _v = getauxval(AT_SYSINFO_EHDR);
+    return (_v != 0 && _base == _v);
+}
+
+// the main executable and the vdso are never unloaded. For the others, take a
+// reference so that the table remains valid until it is released
+bool
+acquire(unwind_library& _lib)
+{
+    if(_lib.name.empty() || is_vdso(_lib.base)) return true;
+
+    _lib.handle = dlopen(_lib.name.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+    if(!_lib.handle) return false;
+
+    // the library may have been replaced since the program headers were iterated
+    struct link_map* _link_map = nullptr;
+    if(dlinfo(_lib.handle, RTLD_DI_LINKMAP, &_link_map) != 0 || !_link_map ||
+       _link_map->l_addr != _lib.base)
+    {
+        dlclose(_lib.handle);
+        _lib.handle = nullptr;
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+size_t
+update_unwind_tables()
+{
+    auto& _registry = get_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+
+    if(_registry.released) return 0;
+
+    auto _data      = iterate_data{};
+    _data.prev_adds = _registry.adds;
+    _data.registry  = &_registry;
+    dl_iterate_phdr(&find_unwind_tables, &_data);
+    _registry.adds = _data.adds;
+
+    for(auto& itr : _data.libraries)
+    {
+        if(!acquire(itr)) continue;
+
+        const auto& _name = _registry.names.emplace_back(itr.name);
+        for(const auto& sitr : itr.segments)
+        {
+            auto& _table = _registry.tables.emplace_back();
+            memset(&_table, 0, sizeof(_table));
+            _table.start_ip         = sitr.first;
+            _table.end_ip           = sitr.second;
+            _table.gp               = 0;
+            _table.format           = UNW_INFO_FORMAT_REMOTE_TABLE;
+            _table.u.rti.name_ptr   = reinterpret_cast<unw_word_t>(_name.c_str());
+            _table.u.rti.segbase    = itr.hdr;
+            _table.u.rti.table_data = itr.table;
+            _table.u.rti.table_len =
+                (itr.entries * sizeof(eh_frame_hdr_entry)) / sizeof(unw_word_t);
+            _U_dyn_register(&_table);
+        }
+        _registry.libraries.emplace(itr.hdr, itr.handle);
+
+        OMNITRACE_BASIC_VERBOSE(3, "[unwind] registered %zu procedures of '%s'\n",
+                                itr.entries,
+                                (itr.name.empty()) ? "<exe>" : itr.name.c_str());
+    }
+
+    return _registry.libraries.size();
+}
+
+void
+release_unwind_tables()
+{
+    auto& _registry = get_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+
+    if(_registry.released) return;
+    _registry.released = true;
+
+    for(auto& itr : _registry.tables)
+        _U_dyn_cancel(&itr);
+
+    for(auto& itr : _registry.libraries)
+    {
+        if(itr.second) dlclose(itr.second);
+    }
+    _registry.libraries.clear();
+}
+}  // namespace binary
+}  // namespace omnitrace
@@ -0,0 +1,45 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+namespace omnitrace
+{
+namespace binary
+{
+/// registers the .eh_frame_hdr search table of every loaded library which is not
+/// registered yet as dynamic unwind info of libunwind. libunwind searches the dynamic
+/// unwind info before iterating the program headers of the loaded libraries so, once
+/// registered, the procedure of a frame is found by every thread through the same
+/// process-wide tables. The libraries are kept loaded until the tables are released.
+/// Returns the number of libraries registered
+size_t
+update_unwind_tables();
+
+/// cancels the registrations and releases the libraries. No thread should be unwinding
+/// when this is invoked
+void
+release_unwind_tables();
+}  // namespace binary
+}  // namespace omnitrace
@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sched.h>
+#include <type_traits>
+
+namespace omnitrace
+{
+inline namespace common
+{
+// layout of the shared-memory segment of OMNITRACE_LIVE_EXPORT, shared by the writer
+// in libomnitrace and the readers (omnitrace-live). The segment is only written by the
+// background process sampler of the application: the sequence is odd while an update
+// is written so a reader copies the payload and retries if the sequence changed. The
+// counters are cumulative since the start of the process
+namespace live_segment
+{
+constexpr uint32_t magic         = 0x4c4d4e4f;  // "OMNL"
+constexpr uint32_t version       = 1;
+constexpr size_t   name_length   = 96;
+constexpr size_t   max_regions   = 256;  // the regions with the most time
+constexpr size_t   max_functions = 32;   // the functions with the most samples
+constexpr size_t   max_devices   = 16;
+
+struct region_entry
+{
+    uint64_t count                 = 0;
+    uint64_t time                  = 0;  // nsec, inclusive, summed over the threads
+    char     name[name_length + 1] = {};
+};
+
+struct function_entry
+{
+    uint64_t samples               = 0;
+    char     name[name_length + 1] = {};
+};
+
+struct device_entry
+{
+    double   busy        = -1.0;  // percent, negative if unavailable
+    int64_t  memory      = -1;    // bytes used, negative if unavailable
+    uint64_t kernels     = 0;
+    uint64_t kernel_time = 0;  // nsec
+};
+
+struct payload
+{
+    uint64_t       timestamp                = 0;  // nsec (CLOCK_REALTIME) of the update
+    uint64_t       updates                  = 0;
+    uint64_t       samples                  = 0;  // including the unnamed functions
+    uint64_t       comm_bytes               = 0;
+    uint64_t       comm_messages            = 0;
+    uint32_t       finished                 = 0;  // last update of the process
+    uint32_t       num_regions              = 0;
+    uint32_t       num_functions            = 0;
+    uint32_t       num_devices              = 0;
+    region_entry   regions[max_regions]     = {};
+    function_entry functions[max_functions] = {};
+    device_entry   devices[max_devices]     = {};
+};
+
+struct segment
+{
+    uint32_t              magic    = 0;  // set last by the writer
+    uint32_t              version  = 0;
+    uint64_t              size     = 0;  // sizeof(segment) of the writer
+    int64_t               pid      = 0;
+    uint64_t              start    = 0;  // nsec (CLOCK_REALTIME)
+    uint64_t              interval = 0;  // nsec between the updates
+    std::atomic<uint64_t> sequence = { 0 };
+    payload               data     = {};
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the sequence of the segment is shared between processes");
+static_assert(std::is_trivially_copyable<payload>::value,
+              "the payload is copied with memcpy");
+
+inline bool
+is_valid(const segment& _v, size_t _size)
+{
+    return _size >= sizeof(segment) && _v.magic == magic && _v.version == version &&
+           _v.size == sizeof(segment);
+}
+
+inline void
+begin_update(segment& _v)
+{
+    _v.sequence.store(_v.sequence.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void
+end_update(segment& _v)
+{
+    _v.sequence.fetch_add(1, std::memory_order_release);
+}
+
+// copies a consistent payload. Returns false if every attempt overlapped an update
+inline bool
+read(const segment& _v, payload& _out, size_t _attempts = 1000)
+{
+    for(size_t i = 0; i < _attempts; ++i)
+    {
+        auto _beg = _v.sequence.load(std::memory_order_acquire);
+        if((_beg % 2) == 0)
+        {
+            std::memcpy(&_out, &_v.data, sizeof(payload));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(_v.sequence.load(std::memory_order_relaxed) == _beg) return true;
+        }
+        sched_yield();
+    }
+    return false;
+}
+}  // namespace live_segment
+}  // namespace common
+}  // namespace omnitrace
@@ -275,7 +275,7 @@ add_core_arguments(parser_t& _parser, parser_data& _data)
     const auto* _overflow_desc =
         R"(Sample based on an overflow event. Accepts zero or more arguments:
     %{INDENT}%0. Enables sampling based on overflow.
-    %{INDENT}%1. Overflow metric, e.g. PERF_COUNT_HW_INSTRUCTIONS
+    %{INDENT}%1. Overflow metric, e.g. PERF_COUNT_HW_INSTRUCTIONS or ibs_op// (AMD IBS)
     %{INDENT}%2. Overflow value. E.g., if metric == PERF_COUNT_HW_INSTRUCTIONS, then 10000000 == sample every 10,000,000 instructions.
     %{INDENT}%3+ Thread IDs to target for sampling, starting at 0 (the main thread).
     %{INDENT}%   May be specified as index or range, e.g., '0 2-4' will be interpreted as:
@@ -0,0 +1,171 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "core/calibration.hpp"
+#include "core/debug.hpp"
+
+#include <timemory/mpl/policy.hpp>
+#include <timemory/tpls/cereal/archives.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/tpls/cereal/cereal/archives/json.hpp>
+#include <timemory/tpls/cereal/types.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <unistd.h>
+
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <sstream>
+
+namespace omnitrace
+{
+namespace calibration
+{
+namespace cereal = ::tim::cereal;
+
+std::optional<double>
+data::get(std::string_view _name) const
+{
+    for(const auto& itr : entries)
+        if(itr.name == _name) return itr.mean;
+    return std::nullopt;
+}
+
+std::string
+get_sample_name(SamplingUnwinder _unwinder, size_t _depth)
+{
+    auto _name = (_unwinder == SamplingUnwinder::LibUnwind) ? std::string{ "libunwind" }
+                                                            : std::string{ "fp" };
+    return "sample-" + _name + "-" + std::to_string(_depth);
+}
+
+std::string
+get_hostname()
+{
+    char _host[256];
+    if(gethostname(_host, sizeof(_host)) != 0) return std::string{ "localhost" };
+    _host[sizeof(_host) - 1] = '\0';
+    return std::string{ _host };
+}
+
+void
+write(const data& _data, const std::string& _fname)
+{
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("calibration", _data));
+        ar->finishNode();
+    }
+
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+        OMNITRACE_THROW("Error opening calibration output file: %s", _fname.c_str());
+
+    ofs << oss.str() << "\n";
+}
+
+std::optional<data>
+read(const std::string& _fname)
+{
+    if(_fname.empty() || !tim::filepath::exists(_fname)) return std::nullopt;
+
+    auto ifs = std::ifstream{};
+    if(!tim::filepath::open(ifs, _fname)) return std::nullopt;
+
+    auto _data = data{};
+    try
+    {
+        auto ar = tim::policy::input_archive<cereal::JSONInputArchive>::get(ifs);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("calibration", _data));
+        ar->finishNode();
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "Error reading calibration file '%s': %s\n",
+                            _fname.c_str(), _e.what());
+        return std::nullopt;
+    }
+
+    return _data;
+}
+
+std::optional<double>
+get_sample_cost(const data& _data, SamplingUnwinder _unwinder)
+{
+    // the depth of the call-stacks is not known in advance so the deepest calibrated
+    // depth gives an upper bound of the cost
+    auto _get_deepest = [&_data](SamplingUnwinder _v) -> std::optional<double> {
+        auto _prefix = get_sample_name(_v, 0);
+        _prefix.pop_back();
+
+        auto   _cost  = std::optional<double>{};
+        size_t _depth = 0;
+        for(const auto& itr : _data.entries)
+        {
+            if(itr.name.find(_prefix) != 0) continue;
+            auto _n = std::stoul(itr.name.substr(_prefix.length()));
+            if(_cost && _n < _depth) continue;
+            _cost  = itr.mean;
+            _depth = _n;
+        }
+        return _cost;
+    };
+
+    auto _cost = (_unwinder == SamplingUnwinder::LibUnwind)
+                     ? std::optional<double>{}
+                     : _get_deepest(SamplingUnwinder::FramePointer);
+    if(!_cost) _cost = _get_deepest(SamplingUnwinder::LibUnwind);
+    if(!_cost) return std::nullopt;
+
+    return *_cost + _data.get("signal").value_or(0.0);
+}
+
+std::optional<double>
+get_sampling_overhead(const data& _data, SamplingUnwinder _unwinder, double _rate)
+{
+    auto _cost = get_sample_cost(_data, _unwinder);
+    if(!_cost) return std::nullopt;
+
+    return (100.0 * *_cost * _rate) / 1.0e9;
+}
+
+uint32_t
+get_sampling_stride(const data& _data, SamplingUnwinder _unwinder, double _rate,
+                    double _target, uint32_t _max)
+{
+    auto _overhead = get_sampling_overhead(_data, _unwinder, _rate);
+    if(!_overhead || _target <= 0.0) return 1;
+
+    uint32_t _stride = 1;
+    while(_stride < _max && (*_overhead / _stride) > _target)
+        _stride *= 2;
+    return _stride;
+}
+}  // namespace calibration
+}  // namespace omnitrace
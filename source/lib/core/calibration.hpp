@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/state.hpp"
+
+#include <timemory/tpls/cereal/cereal.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace omnitrace
+{
+/// the cost of the hot operation of each backend on a node, measured by
+/// 'omnitrace-avail --calibrate' (see OMNITRACE_CALIBRATION_FILE). The overhead of a
+/// sampling configuration is estimated from the cost of the signal and the cost of
+/// unwinding the call-stack at the deepest calibrated depth
+namespace calibration
+{
+/// the cost of one operation in nanoseconds
+struct entry
+{
+    std::string name        = {};
+    std::string description = {};
+    double      mean        = 0.0;  ///< mean over the rounds
+    double      min         = 0.0;  ///< lowest mean of a round
+    size_t      count       = 0;    ///< number of operations per round
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = ::tim::cereal;
+        ar(cereal::make_nvp("name", name), cereal::make_nvp("description", description),
+           cereal::make_nvp("mean", mean), cereal::make_nvp("min", min),
+           cereal::make_nvp("count", count));
+    }
+};
+
+struct data
+{
+    std::string        hostname  = {};
+    int64_t            timestamp = 0;  ///< seconds since the epoch
+    std::vector<entry> entries   = {};
+
+    /// the mean cost (nsec) of the operation
+    std::optional<double> get(std::string_view _name) const;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = ::tim::cereal;
+        ar(cereal::make_nvp("hostname", hostname),
+           cereal::make_nvp("timestamp", timestamp),
+           cereal::make_nvp("entries", entries));
+    }
+};
+
+/// name of the entry of a sample unwound by the unwinder at the given depth
+std::string
+get_sample_name(SamplingUnwinder _unwinder, size_t _depth);
+
+/// the hostname of this node
+std::string
+get_hostname();
+
+void
+write(const data& _data, const std::string& _fname);
+
+/// returns an empty optional if the file does not exist or cannot be parsed
+std::optional<data>
+read(const std::string& _fname);
+
+/// cost (nsec) of a timer signal which is sampled. The frame-pointer unwinder falls
+/// back to the cost of libunwind when the frame-pointers were not calibrated
+std::optional<double>
+get_sample_cost(const data& _data, SamplingUnwinder _unwinder);
+
+/// percent of the wall-time of a sampled thread spent in the signal handler when the
+/// timers deliver the given number of signals per second
+std::optional<double>
+get_sampling_overhead(const data& _data, SamplingUnwinder _unwinder, double _rate);
+
+/// the lowest power of two stride of the timer signals which keeps the cost of the
+/// samples below the target percent of the wall-time. Returns one when the cost is
+/// not calibrated. The default maximum is the maximum of the adaptive sampling rate
+uint32_t
+get_sampling_stride(const data& _data, SamplingUnwinder _unwinder, double _rate,
+                    double _target, uint32_t _max = 1024);
+}  // namespace calibration
+}  // namespace omnitrace
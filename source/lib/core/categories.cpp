@@ -37,52 +37,38 @@ namespace categories
 {
 namespace
 {
-template <typename Tp>
-void
-configure_categories(bool _enable, const std::set<std::string>& _categories)
-{
-    auto _name = trait::name<Tp>::value;
-    if(_categories.count(_name) > 0)
-    {
-        OMNITRACE_VERBOSE_F(3, "%s category: %s\n", (_enable) ? "Enabling" : "Disabling",
-                            _name);
-        trait::runtime_enabled<Tp>::set(_enable);
-    }
-}
-
 template <size_t... Idx>
-void
-configure_categories(bool _enable, const std::set<std::string>& _categories,
-                     std::index_sequence<Idx...>)
+uint64_t
+get_mask(const std::set<std::string>& _categories, std::index_sequence<Idx...>)
 {
-    (configure_categories<category_type_id_t<Idx>>(_enable, _categories), ...);
+    auto _v = uint64_t{ 0 };
+    ((_v |= (_categories.count(trait::name<category_type_id_t<Idx>>::value) > 0)
+                ? (1ULL << Idx)
+                : 0ULL),
+     ...);
+    return _v;
 }
+}  // namespace
 
-void
-configure_categories(bool _enable, const std::set<std::string>& _categories)
+uint64_t
+get_mask(const std::set<std::string>& _categories)
 {
-    OMNITRACE_VERBOSE_F(1, "%s categories...\n", (_enable) ? "Enabling" : "Disabling");
-
-    configure_categories(
-        _enable, _categories,
-        utility::make_index_sequence_range<1, OMNITRACE_CATEGORY_LAST>{});
+    return get_mask(_categories,
+                    utility::make_index_sequence_range<1, OMNITRACE_CATEGORY_LAST>{});
 }
-}  // namespace
 
 void
 enable_categories(const std::set<std::string>& _categories)
 {
-    configure_categories(
-        true, _categories,
-        utility::make_index_sequence_range<1, OMNITRACE_CATEGORY_LAST>{});
+    OMNITRACE_VERBOSE_F(1, "Enabling categories...\n");
+    enable_categories(get_mask(_categories));
 }
 
 void
 disable_categories(const std::set<std::string>& _categories)
 {
-    configure_categories(
-        false, _categories,
-        utility::make_index_sequence_range<1, OMNITRACE_CATEGORY_LAST>{});
+    OMNITRACE_VERBOSE_F(1, "Disabling categories...\n");
+    disable_categories(get_mask(_categories));
 }
 
 void
@@ -95,40 +81,31 @@ setup()
 
     if(!_trace_specs.empty())
     {
+        // a window only sets or clears the bits of the enabled categories
+        auto _mask         = get_mask(config::get_enabled_categories());
         auto _trace_stages = constraint::get_trace_stages();
 
-        _trace_stages.init = [](const constraint::spec& _spec) {
-            if(_spec.delay > 1.0e-3) disable_categories(config::get_enabled_categories());
+        _trace_stages.init = [_mask](const constraint::spec& _spec) {
+            if(_spec.delay > 1.0e-3) disable_categories(_mask);
             return get_state() < State::Finalized;
         };
 
-        _trace_stages.start = [](const constraint::spec&) {
-            enable_categories(config::get_enabled_categories());
+        _trace_stages.start = [_mask](const constraint::spec&) {
+            enable_categories(_mask);
             return get_state() < State::Finalized;
         };
 
-        _trace_stages.stop = [](const constraint::spec&) {
+        _trace_stages.stop = [_mask](const constraint::spec&) {
             // only disable categories if not finalized since this might run in background
             // during finalization and disable output of data in those categories
-            if(get_state() < State::Finalized)
-                disable_categories(config::get_enabled_categories());
+            if(get_state() < State::Finalized) disable_categories(_mask);
             return get_state() < State::Finalized;
         };
 
-        auto _promise = std::promise<void>();
-        std::thread{ [_trace_specs, _trace_stages](std::promise<void>* _prom) {
-                        // ensure all categories are disabled before proceeding
-                        // if a delay is requested
-                        if(_trace_specs.front().delay > 1.0e-3)
-                            disable_categories(config::get_enabled_categories());
-                        _prom->set_value();
-                        for(const auto& itr : _trace_specs)
-                            itr(_trace_stages);
-                    },
-                     &_promise }
-            .detach();
+        // ensure all categories are disabled before proceeding if a delay is requested
+        if(_trace_specs.front().delay > 1.0e-3) disable_categories(_mask);
 
-        _promise.get_future().wait_for(std::chrono::seconds{ 1 });
+        constraint::schedule(std::move(_trace_specs), std::move(_trace_stages));
     }
 }
 
@@ -129,6 +129,15 @@ OMNITRACE_DEFINE_CATEGORY(category, kernel_hardware_counter, OMNITRACE_CATEGORY_
 OMNITRACE_DEFINE_CATEGORY(category, numa, OMNITRACE_CATEGORY_NUMA, "numa", "Non-unified memory architecture")
 OMNITRACE_DEFINE_CATEGORY(category, timer_sampling, OMNITRACE_CATEGORY_TIMER_SAMPLING, "timer_sampling", "Sampling based on a timer")
 OMNITRACE_DEFINE_CATEGORY(category, overflow_sampling, OMNITRACE_CATEGORY_OVERFLOW_SAMPLING, "overflow_sampling", "Sampling based on a counter overflow")
+OMNITRACE_DEFINE_CATEGORY(category, heap_profile, OMNITRACE_CATEGORY_HEAP_PROFILE, "heap_profile", "Heap allocations (derived from the sampled allocations)")
+OMNITRACE_DEFINE_CATEGORY(category, critical_path, OMNITRACE_CATEGORY_CRITICAL_PATH, "critical_path", "Critical path across the CPU threads and the GPU queues")
+OMNITRACE_DEFINE_CATEGORY(category, gpu_memory, OMNITRACE_CATEGORY_GPU_MEMORY, "gpu_memory", "Live memory allocated through HIP (derived from the HIP API calls)")
+OMNITRACE_DEFINE_CATEGORY(category, user_counter, OMNITRACE_CATEGORY_USER_COUNTER, "user_counter", "User-defined counters (omnitrace_user_counter_record)")
+OMNITRACE_DEFINE_CATEGORY(category, memory_bandwidth, OMNITRACE_CATEGORY_MEMORY_BANDWIDTH, "memory_bandwidth", "Memory bandwidth of each socket (derived from the uncore counters in background thread)")
+OMNITRACE_DEFINE_CATEGORY(category, io, OMNITRACE_CATEGORY_IO, "io", "POSIX I/O calls (read, write, open, close and fsync functions)")
+OMNITRACE_DEFINE_CATEGORY(category, mpi_pvars, OMNITRACE_CATEGORY_MPI_PVARS, "mpi_pvars", "MPI_T performance variables of the MPI library (sampled in background thread)")
+OMNITRACE_DEFINE_CATEGORY(category, kernel_launch, OMNITRACE_CATEGORY_KERNEL_LAUNCH, "kernel_launch", "Kernels launched on each GPU queue which have not completed (derived from the HIP API and the kernel dispatches)")
+OMNITRACE_DEFINE_CATEGORY(category, memory_footprint, OMNITRACE_CATEGORY_MEMORY_FOOTPRINT, "memory_footprint", "Memory held by the data structures of omnitrace (collected in background thread)")
 
 OMNITRACE_DECLARE_CATEGORY(category, sampling, OMNITRACE_CATEGORY_SAMPLING, "sampling", "Host-side call-stack sampling")
 // clang-format on
@@ -190,17 +199,66 @@ using name = perfetto_category<Tp...>;
         OMNITRACE_PERFETTO_CATEGORY(category::numa),                                     \
         OMNITRACE_PERFETTO_CATEGORY(category::timer_sampling),                           \
         OMNITRACE_PERFETTO_CATEGORY(category::overflow_sampling),                        \
+        OMNITRACE_PERFETTO_CATEGORY(category::heap_profile),                             \
+        OMNITRACE_PERFETTO_CATEGORY(category::critical_path),                            \
+        OMNITRACE_PERFETTO_CATEGORY(category::gpu_memory),                               \
+        OMNITRACE_PERFETTO_CATEGORY(category::user_counter),                             \
+        OMNITRACE_PERFETTO_CATEGORY(category::memory_bandwidth),                         \
+        OMNITRACE_PERFETTO_CATEGORY(category::io),                                       \
+        OMNITRACE_PERFETTO_CATEGORY(category::mpi_pvars),                                \
+        OMNITRACE_PERFETTO_CATEGORY(category::kernel_launch),                            \
+        OMNITRACE_PERFETTO_CATEGORY(category::memory_footprint),                         \
         ::perfetto::Category("timemory").SetDescription("Events from the timemory API")
 
 #if defined(TIMEMORY_USE_PERFETTO)
 #    define TIMEMORY_PERFETTO_CATEGORIES OMNITRACE_PERFETTO_CATEGORIES
 #endif
 
+#include <atomic>
+#include <cstdint>
 #include <set>
 #include <string>
+#include <type_traits>
 
 namespace omnitrace
 {
+static_assert(OMNITRACE_CATEGORY_LAST <= 64,
+              "OMNITRACE_CATEGORY_MASK requires at most 64 categories");
+
+// compile-time selection of categories: bit N of OMNITRACE_CATEGORY_MASK corresponds
+// to the category with the enum value N. Regions in categories which are not compiled
+// in are discarded at compile-time. Categories in OMNITRACE_CATEGORY_MASK_STATIC are
+// always enabled and skip the run-time checks. Either trait can be specialized for a
+// specific category before any region in that category is instantiated.
+template <typename CategoryT>
+using category_enum_id_t = decltype(category_enum_id<CategoryT>::value);
+
+template <typename CategoryT>
+constexpr bool
+category_in_mask(uint64_t _mask)
+{
+    return ((_mask >> category_enum_id<CategoryT>::value) & 1ULL) == 1ULL;
+}
+
+template <typename CategoryT, typename = void>
+struct category_compiled : std::true_type
+{};
+
+template <typename CategoryT>
+struct category_compiled<CategoryT, std::void_t<category_enum_id_t<CategoryT>>>
+: std::bool_constant<category_in_mask<CategoryT>(OMNITRACE_CATEGORY_MASK)>
+{};
+
+template <typename CategoryT, typename = void>
+struct category_static : std::false_type
+{};
+
+template <typename CategoryT>
+struct category_static<CategoryT, std::void_t<category_enum_id_t<CategoryT>>>
+: std::bool_constant<category_compiled<CategoryT>::value &&
+                     category_in_mask<CategoryT>(OMNITRACE_CATEGORY_MASK_STATIC)>
+{};
+
 inline namespace config
 {
 std::set<std::string>
@@ -212,6 +270,49 @@ get_disabled_categories();
 
 namespace categories
 {
+/// bit N is set while the category with the enum value N (see omnitrace/categories.h) is
+/// enabled. Enabling or disabling a set of categories is one atomic operation on it and
+/// checking a category is one load
+inline std::atomic<uint64_t> enabled_mask = { ~uint64_t{ 0 } };
+
+// the categories with an enum value after OMNITRACE_CATEGORY_NONE have a bit in the mask
+template <typename CategoryT, typename = void>
+struct has_mask_bit : std::false_type
+{};
+
+template <typename CategoryT>
+struct has_mask_bit<CategoryT, std::void_t<category_enum_id_t<CategoryT>>>
+: std::bool_constant<(category_enum_id<CategoryT>::value > OMNITRACE_CATEGORY_NONE)>
+{};
+
+/// whether the category is enabled. Types without a bit in the mask fall back to their
+/// runtime_enabled trait
+template <typename CategoryT>
+inline bool
+is_enabled()
+{
+    if constexpr(has_mask_bit<CategoryT>::value)
+        return category_in_mask<CategoryT>(enabled_mask.load(std::memory_order_relaxed));
+    else
+        return ::tim::trait::runtime_enabled<CategoryT>::get();
+}
+
+/// the bits of the categories in the set
+uint64_t
+get_mask(const std::set<std::string>&);
+
+inline void
+enable_categories(uint64_t _mask)
+{
+    enabled_mask.fetch_or(_mask);
+}
+
+inline void
+disable_categories(uint64_t _mask)
+{
+    enabled_mask.fetch_and(~_mask);
+}
+
 void
 enable_categories(const std::set<std::string>& = config::get_enabled_categories());
 
@@ -0,0 +1,174 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "core/clock_sync.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/tsc.hpp"
+
+#include <timemory/backends/mpi.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+#    include <mpi.h>
+#endif
+
+namespace omnitrace
+{
+namespace clock_sync
+{
+namespace
+{
+auto&
+get_samples()
+{
+    static auto _v = std::vector<sample_data>{};
+    return _v;
+}
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+// the PMPI functions are used so the exchange is not recorded by the MPI wrappers
+sample_data
+exchange(MPI_Comm _comm, int _rank, int _size, size_t _rounds)
+{
+    constexpr int ping_tag   = 1;
+    constexpr int pong_tag   = 2;
+    constexpr int offset_tag = 3;
+
+    auto _v = sample_data{};
+    if(_rank == 0)
+    {
+        for(int i = 1; i < _size; ++i)
+        {
+            auto _best = sample_data{ 0, 0, std::numeric_limits<uint64_t>::max() };
+            for(size_t j = 0; j < _rounds; ++j)
+            {
+                uint64_t _remote = 0;
+                uint64_t _t0     = tsc::get_clock_real_now();
+                PMPI_Send(nullptr, 0, MPI_BYTE, i, ping_tag, _comm);
+                PMPI_Recv(&_remote, 1, MPI_UINT64_T, i, pong_tag, _comm,
+                          MPI_STATUS_IGNORE);
+                uint64_t _t1 = tsc::get_clock_real_now();
+                if(_t1 - _t0 < _best.rtt)
+                {
+                    // the remote time is assumed to be read halfway through the trip
+                    _best.rtt    = _t1 - _t0;
+                    _best.offset = static_cast<int64_t>(_remote - _t0) -
+                                   static_cast<int64_t>(_best.rtt / 2);
+                }
+            }
+            int64_t _data[2] = { _best.offset, static_cast<int64_t>(_best.rtt) };
+            PMPI_Send(_data, 2, MPI_INT64_T, i, offset_tag, _comm);
+        }
+    }
+    else
+    {
+        for(size_t j = 0; j < _rounds; ++j)
+        {
+            PMPI_Recv(nullptr, 0, MPI_BYTE, 0, ping_tag, _comm, MPI_STATUS_IGNORE);
+            uint64_t _now = tsc::get_clock_real_now();
+            PMPI_Send(&_now, 1, MPI_UINT64_T, 0, pong_tag, _comm);
+        }
+        int64_t _data[2] = { 0, 0 };
+        PMPI_Recv(_data, 2, MPI_INT64_T, 0, offset_tag, _comm, MPI_STATUS_IGNORE);
+        _v.offset = _data[0];
+        _v.rtt    = static_cast<uint64_t>(_data[1]);
+    }
+    _v.timestamp = tsc::get_clock_real_now();
+    return _v;
+}
+#endif
+}  // namespace
+
+bool
+sample(size_t _rounds)
+{
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    int _initialized = 0;
+    int _finalized   = 0;
+    PMPI_Initialized(&_initialized);
+    PMPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0 || _rounds == 0) return false;
+
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+    if(_size < 2) return false;
+
+    // a duplicate of the communicator keeps the messages apart from the application
+    MPI_Comm _comm = MPI_COMM_NULL;
+    PMPI_Comm_dup(MPI_COMM_WORLD, &_comm);
+    auto _v = exchange(_comm, _rank, _size, _rounds);
+    PMPI_Comm_free(&_comm);
+
+    OMNITRACE_VERBOSE(2,
+                      "[clock_sync] rank %i: offset from rank 0 is %li nsec (round-trip: "
+                      "%lu nsec)\n",
+                      _rank, static_cast<long>(_v.offset),
+                      static_cast<unsigned long>(_v.rtt));
+
+    get_samples().emplace_back(_v);
+    return true;
+#else
+    (void) _rounds;
+    return false;
+#endif
+}
+
+bool
+available()
+{
+    return !get_samples().empty();
+}
+
+int64_t
+get_offset(uint64_t _ts)
+{
+    const auto& _samples = get_samples();
+    if(_samples.empty()) return 0;
+
+    // the first and last samples define the linear drift of the offset. The offset
+    // is not extrapolated beyond the samples since the drift is only an estimate
+    const auto& _a = _samples.front();
+    const auto& _b = _samples.back();
+    if(_samples.size() < 2 || _b.timestamp <= _a.timestamp) return _b.offset;
+    if(_ts <= _a.timestamp) return _a.offset;
+    if(_ts >= _b.timestamp) return _b.offset;
+
+    auto _slope = static_cast<double>(_b.offset - _a.offset) /
+                  static_cast<double>(_b.timestamp - _a.timestamp);
+    auto _dt = static_cast<double>(_ts - _a.timestamp);
+    return _a.offset + static_cast<int64_t>(_slope * _dt);
+}
+
+uint64_t
+correct(uint64_t _ts)
+{
+    return static_cast<uint64_t>(static_cast<int64_t>(_ts) - get_offset(_ts));
+}
+}  // namespace clock_sync
+}  // namespace omnitrace
@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// estimates the offset of the clock of this rank relative to the clock of rank 0 of
+/// MPI_COMM_WORLD (see OMNITRACE_PERFETTO_CLOCK_SYNC). Each sample is a ping-pong
+/// exchange between rank 0 and every other rank where the offset is estimated from
+/// the round-trip with the lowest latency. With two samples (after MPI_Init and at
+/// finalization), the offset is interpolated linearly so the drift between the
+/// clocks is corrected too
+namespace clock_sync
+{
+struct sample_data
+{
+    uint64_t timestamp = 0;  ///< local time of the sample (nanoseconds)
+    int64_t  offset    = 0;  ///< local time minus the time of rank 0 (nanoseconds)
+    uint64_t rtt       = 0;  ///< lowest round-trip time of the exchange (nanoseconds)
+};
+
+/// runs the exchange and stores the sample. Collective over MPI_COMM_WORLD. Returns
+/// false if MPI is not available, not active, or there is only one rank
+bool
+sample(size_t _rounds);
+
+/// returns true if at least one sample has been stored
+bool
+available();
+
+/// the offset (in nanoseconds) of the local clock at the local time
+int64_t
+get_offset(uint64_t _ts);
+
+/// converts a local timestamp to the clock of rank 0
+uint64_t
+correct(uint64_t _ts);
+}  // namespace clock_sync
+}  // namespace omnitrace
@@ -42,7 +42,9 @@
 OMNITRACE_DECLARE_COMPONENT(roctracer)
 OMNITRACE_DECLARE_COMPONENT(rocprofiler)
 OMNITRACE_DECLARE_COMPONENT(rcclp_handle)
+OMNITRACE_DECLARE_COMPONENT(rcclp_timing)
 OMNITRACE_DECLARE_COMPONENT(comm_data)
+OMNITRACE_DECLARE_COMPONENT(mpi_wait_state)
 
 OMNITRACE_COMPONENT_ALIAS(comm_data_tracker_t,
                           ::tim::component::data_tracker<float, project::omnitrace>)
@@ -82,6 +84,12 @@ struct backtrace_gpu_power
 {};
 struct backtrace_gpu_memory
 {};
+struct mpi_wait_time
+{};
+struct python_gil_wait
+{};
+struct python_gil_hold
+{};
 using sampling_wall_clock = data_tracker<double, backtrace_wall_clock>;
 using sampling_cpu_clock  = data_tracker<double, backtrace_cpu_clock>;
 using sampling_percent    = data_tracker<double, backtrace_fraction>;
@@ -89,6 +97,10 @@ using sampling_gpu_busy   = data_tracker<double, backtrace_gpu_busy>;
 using sampling_gpu_temp   = data_tracker<double, backtrace_gpu_temp>;
 using sampling_gpu_power  = data_tracker<double, backtrace_gpu_power>;
 using sampling_gpu_memory = data_tracker<double, backtrace_gpu_memory>;
+using mpi_wait_tracker_t  = data_tracker<double, mpi_wait_time>;
+
+using python_gil_wait_tracker_t = data_tracker<double, python_gil_wait>;
+using python_gil_hold_tracker_t = data_tracker<double, python_gil_hold>;
 
 template <typename ApiT, typename StartFuncT = default_functor_t,
           typename StopFuncT = default_functor_t>
@@ -107,6 +119,7 @@ OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::rocprofiler, false_type
 #if !defined(OMNITRACE_USE_RCCL)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, category::rocm_rccl, false_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::rcclp_handle, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::rcclp_timing, false_type)
 #endif
 
 #if !defined(OMNITRACE_USE_RCCL) && !defined(OMNITRACE_USE_MPI)
@@ -114,6 +127,11 @@ OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::comm_data_tracker_t, fa
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::comm_data, false_type)
 #endif
 
+#if !defined(OMNITRACE_USE_MPI)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::mpi_wait_state, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::mpi_wait_tracker_t, false_type)
+#endif
+
 #if !defined(TIMEMORY_USE_LIBUNWIND)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, category::sampling, false_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::backtrace, false_type)
@@ -159,6 +177,12 @@ TIMEMORY_SET_COMPONENT_API(omnitrace::component::sampling_gpu_temp, project::omn
                            tpls::rocm, device::gpu, os::supports_linux,
                            category::temperature, category::sampling,
                            category::process_sampling)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::mpi_wait_tracker_t, project::omnitrace,
+                           tpls::mpi, category::timing, os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::python_gil_wait_tracker_t,
+                           project::omnitrace, category::timing, os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::python_gil_hold_tracker_t,
+                           project::omnitrace, category::timing, os::supports_unix)
 
 TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::roctracer, "roctracer",
                                  "High-precision ROCm API and kernel tracing", "")
@@ -187,6 +211,16 @@ TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::sampling_gpu_power,
 TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::sampling_gpu_temp,
                                  "sampling_gpu_temp", "GPU Temperature via ROCm-SMI",
                                  "Derived from sampling")
+TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::mpi_wait_tracker_t,
+                                 "mpi_wait_state",
+                                 "Time in the MPI calls waiting for a late peer",
+                                 "Late sender, late receiver, and collective imbalance")
+TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::python_gil_wait_tracker_t,
+                                 "python_gil_wait", "Time waiting for the Python GIL",
+                                 "Intercepted acquisitions and timer samples")
+TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::python_gil_hold_tracker_t,
+                                 "python_gil_hold", "Time holding the Python GIL",
+                                 "Between the intercepted acquisition and release")
 
 // statistics type
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_wall_clock, double)
@@ -196,6 +230,9 @@ TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_gpu_temp, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_gpu_power, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_gpu_memory, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::comm_data_tracker_t, float)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::mpi_wait_tracker_t, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::python_gil_wait_tracker_t, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::python_gil_hold_tracker_t, double)
 
 // enable timing units
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_wall_clock,
@@ -208,6 +245,18 @@ OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_wall_cloc
                                 true_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_cpu_clock,
                                 true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::mpi_wait_tracker_t,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::mpi_wait_tracker_t,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::python_gil_wait_tracker_t,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::python_gil_wait_tracker_t,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::python_gil_hold_tracker_t,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::python_gil_hold_tracker_t,
+                                true_type)
 
 // enable percent units
 OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_percent_units, component::sampling_gpu_busy,
@@ -0,0 +1,359 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "core/compression.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#if defined(OMNITRACE_USE_ZLIB)
+#    include <zlib.h>
+#endif
+
+#if defined(OMNITRACE_USE_ZSTD)
+#    include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+namespace omnitrace
+{
+namespace compression
+{
+namespace units = ::tim::units;
+
+namespace
+{
+constexpr size_t chunk_size = (1 << 20);
+
+// fills the buffer and returns the number of bytes. Fewer bytes than the size of the
+// buffer means the end of the input
+using reader_t = std::function<size_t(char*, size_t)>;
+
+#if defined(OMNITRACE_USE_ZLIB)
+bool
+compress_gzip(const reader_t& _read, std::ostream& _os, int _level)
+{
+    auto _strm = z_stream{};
+    // 15 + 16: the largest window with a gzip header instead of a zlib header
+    _level = (_level > 0) ? std::min(_level, Z_BEST_COMPRESSION) : Z_DEFAULT_COMPRESSION;
+    if(deflateInit2(&_strm, _level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    auto _inp   = std::vector<char>(chunk_size);
+    auto _out   = std::vector<char>(chunk_size);
+    auto _ok    = true;
+    auto _flush = Z_NO_FLUSH;
+    do
+    {
+        auto _n         = _read(_inp.data(), _inp.size());
+        _flush          = (_n < _inp.size()) ? Z_FINISH : Z_NO_FLUSH;
+        _strm.next_in   = reinterpret_cast<Bytef*>(_inp.data());
+        _strm.avail_in  = static_cast<uInt>(_n);
+        do
+        {
+            _strm.next_out  = reinterpret_cast<Bytef*>(_out.data());
+            _strm.avail_out = static_cast<uInt>(_out.size());
+            if(deflate(&_strm, _flush) == Z_STREAM_ERROR)
+            {
+                _ok = false;
+                break;
+            }
+            _os.write(_out.data(), _out.size() - _strm.avail_out);
+        } while(_strm.avail_out == 0);
+    } while(_ok && _flush != Z_FINISH && _os);
+
+    deflateEnd(&_strm);
+    return (_ok && _os);
+}
+#endif
+
+#if defined(OMNITRACE_USE_ZSTD)
+bool
+compress_zstd(const reader_t& _read, std::ostream& _os, int _level)
+{
+    auto* _ctx = ZSTD_createCCtx();
+    if(!_ctx) return false;
+
+    // a level of zero is the default level of zstd. The worker threads are only
+    // supported by a multi-threaded libzstd so the error is ignored
+    ZSTD_CCtx_setParameter(_ctx, ZSTD_c_compressionLevel, _level);
+    ZSTD_CCtx_setParameter(_ctx, ZSTD_c_checksumFlag, 1);
+    ZSTD_CCtx_setParameter(_ctx, ZSTD_c_nbWorkers, 2);
+
+    auto _inp  = std::vector<char>(ZSTD_CStreamInSize());
+    auto _out  = std::vector<char>(ZSTD_CStreamOutSize());
+    auto _ok   = true;
+    auto _last = false;
+    while(_ok && !_last && _os)
+    {
+        auto _n    = _read(_inp.data(), _inp.size());
+        _last      = (_n < _inp.size());
+        auto _mode = (_last) ? ZSTD_e_end : ZSTD_e_continue;
+        auto _in   = ZSTD_inBuffer{ _inp.data(), _n, 0 };
+        auto _done = false;
+        while(!_done)
+        {
+            auto _o   = ZSTD_outBuffer{ _out.data(), _out.size(), 0 };
+            auto _rem = ZSTD_compressStream2(_ctx, &_o, &_in, _mode);
+            if(ZSTD_isError(_rem))
+            {
+                _ok = false;
+                break;
+            }
+            _os.write(_out.data(), _o.pos);
+            _done = (_last) ? (_rem == 0) : (_in.pos == _in.size);
+        }
+    }
+
+    ZSTD_freeCCtx(_ctx);
+    return (_ok && _os);
+}
+#endif
+
+bool
+compress(const std::string& _fname, const reader_t& _read, std::string_view _method)
+{
+    auto _ofs = std::ofstream{};
+    if(!filepath::open(_ofs, _fname, std::ios::out | std::ios::binary))
+    {
+        OMNITRACE_VERBOSE(0, "Error opening '%s'...\n", _fname.c_str());
+        return false;
+    }
+
+    auto _level = config::get_output_compression_level();
+    auto _ok    = false;
+#if defined(OMNITRACE_USE_ZLIB)
+    if(_method == "gzip") _ok = compress_gzip(_read, _ofs, _level);
+#endif
+#if defined(OMNITRACE_USE_ZSTD)
+    if(_method == "zstd") _ok = compress_zstd(_read, _ofs, _level);
+#endif
+    (void) _read;
+    (void) _level;
+
+    _ofs.close();
+    if(!_ok)
+    {
+        OMNITRACE_VERBOSE(0, "Error compressing '%s' with %s...\n", _fname.c_str(),
+                          std::string{ _method }.c_str());
+        std::remove(_fname.c_str());
+    }
+    return _ok;
+}
+
+int64_t
+get_modification_time(const std::string& _fname)
+{
+    struct stat _stat = {};
+    if(::stat(_fname.c_str(), &_stat) != 0) return -1;
+    return (static_cast<int64_t>(_stat.st_mtim.tv_sec) * units::sec) +
+           _stat.st_mtim.tv_nsec;
+}
+
+auto&
+get_pending()
+{
+    static auto _v = std::vector<std::thread>{};
+    return _v;
+}
+
+auto&
+get_pending_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+}  // namespace
+
+bool
+is_available(std::string_view _method)
+{
+#if defined(OMNITRACE_USE_ZLIB)
+    if(_method == "gzip") return true;
+#endif
+#if defined(OMNITRACE_USE_ZSTD)
+    if(_method == "zstd") return true;
+#endif
+    return (_method == "none");
+}
+
+std::string
+get_method()
+{
+    static auto _v = []() {
+        auto _method = config::get_output_compression();
+        if(_method.empty()) return std::string{ "none" };
+        if(!is_available(_method))
+        {
+            OMNITRACE_VERBOSE(0,
+                              "OMNITRACE_OUTPUT_COMPRESSION=%s is not supported by this "
+                              "build. The output files will not be compressed...\n",
+                              _method.c_str());
+            return std::string{ "none" };
+        }
+        return _method;
+    }();
+    return _v;
+}
+
+std::string
+get_extension(std::string_view _method)
+{
+    if(_method == "gzip") return ".gz";
+    if(_method == "zstd") return ".zst";
+    return std::string{};
+}
+
+bool
+write(const std::string& _fname, const char* _data, size_t _size,
+      std::string_view _method)
+{
+    size_t _offset = 0;
+    auto   _read   = [&](char* _buf, size_t _n) {
+        _n = std::min(_n, _size - _offset);
+        std::copy_n(_data + _offset, _n, _buf);
+        _offset += _n;
+        return _n;
+    };
+    return compress(_fname, _read, _method);
+}
+
+bool
+compress_file(const std::string& _fname, std::string_view _method)
+{
+    if(_method == "none" || !is_available(_method)) return false;
+
+    auto _ifs = std::ifstream{ _fname, std::ios::in | std::ios::binary };
+    if(!_ifs) return false;
+
+    auto _read = [&_ifs](char* _buf, size_t _n) {
+        _ifs.read(_buf, _n);
+        return static_cast<size_t>(_ifs.gcount());
+    };
+
+    auto _output = _fname + get_extension(_method);
+    if(!compress(_output, _read, _method)) return false;
+
+    OMNITRACE_VERBOSE(1, "Compressed '%s' to '%s'...\n", _fname.c_str(),
+                      _output.c_str());
+    _ifs.close();
+    std::remove(_fname.c_str());
+    return true;
+}
+
+void
+async(std::function<void()>&& _func)
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_pending_mutex() };
+    get_pending().emplace_back([_func = std::move(_func)]() {
+        threading::offset_this_id(true);
+        threading::set_thread_name("omni.compress");
+        _func();
+    });
+}
+
+void
+wait()
+{
+    auto _pending = std::vector<std::thread>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_pending_mutex() };
+        std::swap(_pending, get_pending());
+    }
+
+    if(!_pending.empty())
+        OMNITRACE_VERBOSE(1, "Waiting for %zu output compression(s)...\n",
+                          _pending.size());
+
+    for(auto& itr : _pending)
+        itr.join();
+}
+
+file_times_t
+get_files(const std::string& _prefix, std::string_view _ext)
+{
+    auto _pos  = _prefix.find_last_of('/');
+    auto _dir  = (_pos == std::string::npos) ? std::string{ "./" }
+                                             : _prefix.substr(0, _pos + 1);
+    auto _base = (_pos == std::string::npos) ? _prefix : _prefix.substr(_pos + 1);
+
+    auto  _v    = file_times_t{};
+    auto* _dirp = opendir(_dir.c_str());
+    if(!_dirp) return _v;
+
+    while(auto* _entry = readdir(_dirp))
+    {
+        auto _name = std::string_view{ _entry->d_name };
+        if(_name.length() <= _ext.length() || _name.find(_base) != 0 ||
+           _name.substr(_name.length() - _ext.length()) != _ext)
+            continue;
+        auto _fname = JOIN("", _dir, _name);
+        auto _mtime = get_modification_time(_fname);
+        if(_mtime >= 0) _v.emplace(std::move(_fname), _mtime);
+    }
+    closedir(_dirp);
+    return _v;
+}
+
+void
+compress_updated_files(const file_times_t& _snapshot, const std::string& _prefix,
+                       std::string_view _ext, const std::string& _suffix)
+{
+    auto _method = get_method();
+    if(_method == "none") return;
+
+    auto _files = std::vector<std::string>{};
+    for(const auto& itr : get_files(_prefix, _ext))
+    {
+        auto _prev = _snapshot.find(itr.first);
+        if(_prev != _snapshot.end() && _prev->second == itr.second) continue;
+
+        auto _stem = itr.first.substr(0, itr.first.length() - _ext.length());
+        auto _len  = _suffix.length();
+        if(_len > 0 &&
+           (_stem.length() < _len || _stem.substr(_stem.length() - _len) != _suffix))
+            continue;
+        _files.emplace_back(itr.first);
+    }
+
+    if(_files.empty()) return;
+
+    async([_files, _method]() {
+        for(const auto& itr : _files)
+            compress_file(itr, _method);
+    });
+}
+}  // namespace compression
+}  // namespace omnitrace
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+/// compression of the output files (see OMNITRACE_OUTPUT_COMPRESSION). The data is
+/// compressed in chunks as it is written (gzip via zlib, zstd via libzstd) on
+/// background threads so the compression overlaps with the rest of the finalization.
+/// The finalization waits for the pending compressions before it returns
+namespace compression
+{
+/// the compression method of OMNITRACE_OUTPUT_COMPRESSION if it is supported by this
+/// build, otherwise "none"
+std::string
+get_method();
+
+/// whether the method is supported by this build
+bool
+is_available(std::string_view _method);
+
+/// the extension appended to the compressed files, e.g. ".gz". Empty for "none"
+std::string
+get_extension(std::string_view _method);
+
+/// compresses the data into the file. Returns false if the file cannot be written
+bool
+write(const std::string& _fname, const char* _data, size_t _size,
+      std::string_view _method = get_method());
+
+/// compresses the file into the file name followed by the extension of the method and
+/// removes the original. Returns false if the original is kept
+bool
+compress_file(const std::string& _fname, std::string_view _method = get_method());
+
+/// runs the function on a background thread
+void
+async(std::function<void()>&& _func);
+
+/// waits for the functions which were passed to async
+void
+wait();
+
+/// the modification times of the files with the extension in the directory of the
+/// output prefix whose name starts with the basename of the prefix
+using file_times_t = std::map<std::string, int64_t>;
+
+file_times_t
+get_files(const std::string& _prefix, std::string_view _ext);
+
+/// compresses the files with the extension and the suffix (e.g. the process suffix)
+/// which were created or modified after the snapshot on a background thread
+void
+compress_updated_files(const file_times_t& _snapshot, const std::string& _prefix,
+                       std::string_view _ext, const std::string& _suffix);
+}  // namespace compression
+}  // namespace omnitrace
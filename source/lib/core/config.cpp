@@ -29,6 +29,7 @@
 #include "mproc.hpp"
 #include "perf.hpp"
 #include "perfetto.hpp"
+#include "staging.hpp"
 #include "utility.hpp"
 
 #include <asm-generic/errno-base.h>
@@ -60,15 +61,22 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <limits>
 #include <linux/capability.h>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 namespace omnitrace
 {
@@ -257,6 +265,26 @@ configure_settings(bool _init)
                                  "Verbosity within the omnitrace-dl library", 0,
                                  "debugging", "libomnitrace-dl", "advanced");
 
+    OMNITRACE_CONFIG_EXT_SETTING(
+        bool, "OMNITRACE_DL_LAZY",
+        "When omnitrace-dl is preloaded, defer loading libomnitrace until the first "
+        "omnitrace_user_start_trace(), the OMNITRACE_DL_LAZY_SIGNAL signal, or a command "
+        "line matching OMNITRACE_DL_LAZY_COMMAND. Processes which are never enabled do "
+        "not load libomnitrace",
+        false, "libomnitrace-dl", "performance", "advanced");
+
+    OMNITRACE_CONFIG_EXT_SETTING(
+        std::string, "OMNITRACE_DL_LAZY_COMMAND",
+        "Regex pattern for the command lines whose process loads libomnitrace right "
+        "away when OMNITRACE_DL_LAZY is enabled",
+        "", "libomnitrace-dl", "advanced");
+
+    OMNITRACE_CONFIG_EXT_SETTING(
+        int, "OMNITRACE_DL_LAZY_SIGNAL",
+        "Signal number which loads libomnitrace when OMNITRACE_DL_LAZY is enabled. "
+        "Zero disables the signal trigger",
+        0, "libomnitrace-dl", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         size_t, "OMNITRACE_NUM_THREADS_HINT",
         "This is hint for how many threads are expected to be created in the "
@@ -298,6 +326,12 @@ configure_settings(bool _init)
                              "Enable ROCm hardware counters", true, "backend",
                              "rocprofiler", "rocm");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_USE_PC_SAMPLING",
+        "Enable the GPU PC sampling of rocprofiler-sdk (instruction-level hotspots of "
+        "the kernels)",
+        false, "backend", "pc_sampling", "rocm");
+
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_USE_ROCM_SMI",
         "Enable sampling GPU power, temp, utilization, and memory usage", true, "backend",
@@ -341,6 +375,59 @@ configure_settings(bool _init)
         "Enable support for ROCm Communication Collectives Library (RCCL) Performance",
         false, "rocm", "rccl", "backend");
 
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_COMM_DATA_RESOLUTION",
+        "Minimum time (in milliseconds) between updates of the MPI/RCCL communication "
+        "data perfetto counter tracks. The bytes sent/received in between are "
+        "accumulated and reported in the next update or, after the last update, at "
+        "the finalization. Zero updates the counter tracks on every MPI/RCCL call",
+        0.0, "mpi", "rccl", "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_COMM_HISTOGRAM",
+        "Record log2-bucketed message-size histograms per communicator and operation "
+        "and the traffic matrix between the ranks for the MPI/RCCL communication. "
+        "The data is reduced across the ranks and written to comm_histogram.{txt,json} "
+        "by rank 0",
+        false, "mpi", "rccl", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_MPI_WAIT_STATE",
+        "Split the time in the MPI point-to-point and collective calls into the time "
+        "waiting for a late peer (late sender, late receiver, collective imbalance) "
+        "and the remaining time. The send times are posted to the receivers on a "
+        "duplicate communicator and the collectives perform an additional reduction. "
+        "Requires OMNITRACE_USE_MPIP and OMNITRACE_PROFILE",
+        false, "mpi", "data", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_MPI_WAIT_STATE_EAGER_LIMIT",
+        "Message size (in bytes) above which MPI_Send and MPI_Rsend are assumed to "
+        "wait for the matching receive (rendezvous protocol) for the late receiver "
+        "analysis of OMNITRACE_MPI_WAIT_STATE. MPI_Ssend always waits",
+        65536, "mpi", "data", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_MPI_PVARS",
+        "Regular expression selecting the MPI_T performance variables (e.g. "
+        "'unexpected|posted|rndv|eager') sampled by the background process sampler "
+        "after MPI_Init. The counters are written to perfetto as rates, the levels as "
+        "values, and the change of each counter (or the highest level) while each "
+        "region was active is written to mpi-pvars.{txt,json}. Only the variables "
+        "which are not bound to an MPI object are sampled. Empty disables the "
+        "sampling. Requires OMNITRACE_USE_PROCESS_SAMPLING",
+        std::string{}, "mpi", "process_sampling", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_MPI_RANKS",
+        "Restrict the data collection to a subset of the MPI ranks (of MPI_COMM_WORLD). "
+        "Either a list of ranks and ranges, e.g. '0-3,16,32-63', 'node[:N]' for the "
+        "first N ranks (default: 1) of each node or 'random:N[:SEED]' for rank 0 and "
+        "N-1 ranks selected at random. The selection is the same on every rank. An "
+        "empty value selects all of the ranks. The other ranks disable the collection "
+        "once MPI is initialized and do not write a trace",
+        "", "mpi", "parallelism", "data", "io");
+
     OMNITRACE_CONFIG_CL_SETTING(
         bool, "OMNITRACE_KOKKOSP_KERNEL_LOGGER", "Enables kernel logging", false,
         "--omnitrace-kokkos-kernel-logger", "kokkos", "debugging", "advanced");
@@ -360,10 +447,86 @@ configure_settings(bool _init)
         "Enable tracking deep copies (warning: may corrupt flamegraph in perfetto)",
         false, "kokkos", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_KOKKOSP_KERNEL_SUMMARY",
+        "Write the number of launches and the duration statistics of each Kokkos "
+        "parallel_for, parallel_reduce, parallel_scan, and fence (per device) to "
+        "kokkos-kernels.txt when Kokkos is finalized",
+        false, "kokkos", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_KOKKOSP_MEMORY_ANALYSIS",
+        "Track the live bytes of each Kokkos memory space and the effective bandwidth "
+        "of the deep copies per (source, destination) memory space in perfetto counter "
+        "tracks and write the totals to kokkos-memory.txt when Kokkos is finalized",
+        false, "kokkos", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_KOKKOSP_TUNING",
+        "Answer the Kokkos Tools tuning requests: the configurations of each tuning "
+        "problem (the tuning variables and the context values, e.g. the kernel name) are "
+        "measured from the request to the end of the context and the fastest is used "
+        "afterwards and saved to OMNITRACE_KOKKOSP_TUNING_FILE for the later runs",
+        false, "kokkos", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        int64_t, "OMNITRACE_KOKKOSP_TUNING_TRIALS",
+        "Number of measured trials of each Kokkos tuning problem before the fastest "
+        "configuration is used. Every configuration is measured once if they fit, "
+        "otherwise the configurations are chosen at random",
+        16, "kokkos", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_KOKKOSP_TUNING_FILE",
+        "File which stores the fastest configuration of each Kokkos tuning problem "
+        "across runs. The saved configurations are used without measuring them again: "
+        "remove the file (or the line of the problem) to tune again",
+        "omnitrace-kokkos-tuning.txt", "kokkos", "advanced", "io");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_USE_OMPT",
                              "Enable support for OpenMP-Tools", false, "openmp", "ompt",
                              "backend");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_OMPT_AGGREGATE",
+        "Only collect the count, duration statistics, and load imbalance across the "
+        "threads of each OpenMP parallel region, task, and synchronization region and "
+        "write them to ompt_summary.{txt,json} instead of recording every instance "
+        "in the perfetto and timemory output",
+        false, "openmp", "ompt", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_OMPT_AGGREGATE_SAMPLE_INTERVAL",
+        "When OMNITRACE_OMPT_AGGREGATE is enabled, also record one in N of the "
+        "instances of each region (per thread) in the perfetto and timemory output. "
+        "A value of zero only writes the summary",
+        0, "openmp", "ompt", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_OMPT_BARRIER_ANALYSIS",
+        "Combine the time which the threads wait in the implicit barriers of each "
+        "outermost OpenMP parallel region into the load imbalance of the region (the "
+        "total wait, the straggler thread, and the percent of the thread time spent "
+        "waiting), show it in perfetto counter tracks, and write the totals to "
+        "ompt_barrier.{txt,json}",
+        false, "openmp", "ompt", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_OMPT_DEVICE_TRACING",
+        "Enable the OpenMP-tools device tracing of the target devices: the target "
+        "regions, the data transfers and allocations and the kernels of the offloaded "
+        "regions are collected in trace buffers by the OpenMP runtime, correlated with "
+        "the host target construct which launched them, shown in perfetto tracks per "
+        "device and summarized per target construct in ompt_device.{txt,json}",
+        false, "openmp", "ompt", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_OMPT_DEVICE_BUFFER_SIZE",
+        "Size (in bytes) of the buffers which the OpenMP runtime fills with the device "
+        "trace records of OMNITRACE_OMPT_DEVICE_TRACING. Larger buffers are processed "
+        "less frequently at the cost of more memory per device",
+        1048576, "openmp", "ompt", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_USE_CODE_COVERAGE",
                              "Enable support for code coverage", false, "coverage",
                              "backend", "advanced");
@@ -393,6 +556,50 @@ configure_settings(bool _init)
                              "and/or <DELAY>:<DURATION>:<REPEAT>:<CLOCK_ID>",
                              std::string{}, "trace", "profile", "perfetto", "timemory");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_TRACE_TRIGGERS",
+        "Collect trace/profile data only in the windows opened and closed by events. "
+        "Semi-colon separated list of region=NAME@N[+M] (from the N-th entry of the "
+        "region until M exits of it later), kernel=NAME@N[+M] (from the N-th launch of a "
+        "kernel whose name contains NAME for M launches) and/or hip_memory>BYTES (while "
+        "the live HIP memory on the devices exceeds BYTES, "
+        "requires OMNITRACE_GPU_MEMORY_TRACKING)",
+        std::string{}, "trace", "profile", "perfetto", "timemory");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_PHASE_DETECTION",
+        "Collect trace/profile data only in a few representative iterations of the "
+        "iterative phase of the application, i.e. the outermost region of the main "
+        "thread which recurs with a stable duration and number of nested regions, and in "
+        "the iterations which deviate from it",
+        false, "trace", "profile", "perfetto", "timemory");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_TRACE_PHASE_WARMUP",
+        "Number of consecutive iterations with a stable signature before a region is "
+        "selected as the iterative phase (see OMNITRACE_TRACE_PHASE_DETECTION)",
+        3, "trace", "profile", "perfetto", "timemory", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_TRACE_PHASE_ITERATIONS",
+        "Number of consecutive representative iterations of the iterative phase which "
+        "are collected (see OMNITRACE_TRACE_PHASE_DETECTION)",
+        2, "trace", "profile", "perfetto", "timemory");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_TRACE_PHASE_THRESHOLD",
+        "Relative deviation of the duration or of the number of nested regions of an "
+        "iteration from the iterative phase above which the iteration is an outlier. "
+        "Also the tolerance of the stable signature during the detection",
+        0.5, "trace", "profile", "perfetto", "timemory", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_TRACE_PHASE_OUTLIERS",
+        "Maximum number of outlier iterations of the iterative phase which are collected "
+        "from the point where they deviate until their end (see "
+        "OMNITRACE_TRACE_PHASE_DETECTION)",
+        1, "trace", "profile", "perfetto", "timemory");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_TRACE_PERIOD_CLOCK_ID",
         "Set the default clock ID for OMNITRACE_TRACE_DELAY, OMNITRACE_TRACE_DURATION, "
@@ -458,6 +665,100 @@ configure_settings(bool _init)
                              "less than zero, uses OMNITRACE_SAMPLING_DURATION",
                              -1.0, "sampling", "process_sampling");
 
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PROCESS_SAMPLING_RETENTION",
+        "If > 0.0, only the most recent N seconds of background process samples (CPU "
+        "frequency, memory usage, rocm-smi metrics) are retained in memory. Older "
+        "samples are overwritten in a fixed-size buffer",
+        0.0, "process_sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ENERGY",
+        "Sample the energy of the CPU packages and cores and, with "
+        "OMNITRACE_USE_ROCM_SMI, of the GPUs in the background process sampler and "
+        "attribute it to the regions and the kernels. The joules per region and per "
+        "kernel are written to energy.{txt,json}. Requires "
+        "OMNITRACE_USE_PROCESS_SAMPLING",
+        false, "process_sampling", "energy", "rocm_smi", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_ENERGY_CPU_SOURCE",
+        "Source of the CPU energy when OMNITRACE_ENERGY=ON. \"perf\" opens the "
+        "energy-pkg and energy-cores events of the perf power PMU, \"powercap\" reads "
+        "the RAPL zones in /sys/class/powercap and \"msr\" reads the RAPL MSRs "
+        "through /dev/cpu/N/msr. \"auto\" uses the first one available",
+        std::string{ "auto" }, "process_sampling", "energy", "advanced")
+        ->set_choices({ "auto", "perf", "powercap", "msr", "none" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_GPU_ATTRIBUTION",
+        "Apportion the device-wide rocm-smi busy time and energy of the GPUs to the "
+        "processes which share them from the kernel intervals of each process. With "
+        "MPI, the ranks of a node are combined and the lowest rank of the node writes "
+        "gpu-attribution.{txt,json}. Requires OMNITRACE_USE_PROCESS_SAMPLING, "
+        "OMNITRACE_USE_ROCM_SMI and OMNITRACE_USE_ROCTRACER",
+        false, "process_sampling", "rocm_smi", "roctracer", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_MEMORY_BANDWIDTH",
+        "Sample the memory controller (uncore) counters of each socket in the "
+        "background process sampler, write the read and write bandwidth to perfetto "
+        "and attribute the bytes to the regions. The totals per socket and per region "
+        "are written to memory-bandwidth.{txt,json}. Requires "
+        "OMNITRACE_USE_PROCESS_SAMPLING and access to the system-wide perf events "
+        "(perf_event_paranoid <= 0 or CAP_PERFMON)",
+        false, "process_sampling", "memory_bandwidth", "hardware_counters", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_MEMORY_BANDWIDTH_EVENTS",
+        "Uncore events counting the memory traffic when OMNITRACE_MEMORY_BANDWIDTH=ON, "
+        "separated by semi-colons. Each event is "
+        "'[read:|write:]<pmu>/<terms>/[=<bytes per count>]', e.g. "
+        "'read:uncore_imc_*/event=0x04,umask=0x03/=64'. A '*' in the PMU name matches "
+        "the index of each PMU instance. The events without a direction count the "
+        "total traffic. \"auto\" selects the IMC CAS counts on Intel and the UMC or "
+        "data fabric events on AMD",
+        std::string{ "auto" }, "process_sampling", "memory_bandwidth",
+        "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_LIVE_EXPORT",
+        "Publish rolling aggregates (the count and the time of the regions, the most "
+        "sampled functions, the GPU busy, memory and kernels and the communication "
+        "bytes) into a shared-memory segment while the application runs, e.g. for "
+        "omnitrace-live. Requires OMNITRACE_USE_PROCESS_SAMPLING",
+        false, "process_sampling", "live_export", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_LIVE_EXPORT_INTERVAL",
+        "Time (in seconds) between the updates of the shared-memory segment of "
+        "OMNITRACE_LIVE_EXPORT. The updates happen from the background process sampler "
+        "so the interval is rounded up to its period",
+        1.0, "process_sampling", "live_export");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_LIVE_EXPORT_NAME",
+        "Name of the POSIX shared-memory segment of OMNITRACE_LIVE_EXPORT. '%pid%' is "
+        "replaced by the process id",
+        std::string{ "/omnitrace-live-%pid%" }, "process_sampling", "live_export",
+        "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_MEMORY_FOOTPRINT",
+        "Account the memory held by the data structures of omnitrace (the samples, the "
+        "roctracer records, the process samples, the perfetto buffer and the strings of "
+        "the symbol tables), write it to perfetto while the application runs and to "
+        "memory-footprint.txt at finalization. Requires OMNITRACE_USE_PROCESS_SAMPLING",
+        false, "process_sampling", "memory_footprint", "debugging");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_MEMORY_FOOTPRINT_BUDGET",
+        "Memory (in MB) each subsystem of OMNITRACE_MEMORY_FOOTPRINT may hold, e.g. "
+        "'sampling=512 process_sampling=64'. Once a subsystem exceeds its budget, it "
+        "sheds data: the sampling stops recording samples and the process samplers only "
+        "retain their newest samples",
+        std::string{}, "process_sampling", "memory_footprint", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_SAMPLING_CPUS",
         "CPUs to collect frequency information for. Values should be separated by commas "
@@ -525,6 +826,28 @@ configure_settings(bool _init)
                              "pthread_mutex_unlock, pthread_mutex_trylock",
                              false, "backend", "parallelism", "gotcha", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        uint64_t, "OMNITRACE_TRACE_THREAD_LOCKS_CONTENTION_NS",
+        "When greater than zero, the mutex, rwlock, and spinlock wrappers only record "
+        "the lock acquisitions which waited at least this many nanoseconds (along with "
+        "the lock address and the call-stack of the waiter) in the perfetto trace. "
+        "Unlock and trylock calls are not recorded in this mode",
+        0, "backend", "parallelism", "gotcha", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_TRACE_THREAD_LOCKS_SAMPLE_INTERVAL",
+        "When OMNITRACE_TRACE_THREAD_LOCKS_CONTENTION_NS is greater than zero, only "
+        "record one in N of the contended lock acquisitions (per thread)",
+        1, "backend", "parallelism", "gotcha", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_THREAD_LOCKS_PROFILE",
+        "Accumulate the number of acquisitions, the total wait time, and the maximum "
+        "wait time of the mutexes, rwlocks, and spinlocks per lock address and "
+        "call-site and write them to lock_profile.{txt,json}. Only the acquisitions "
+        "which waited at least OMNITRACE_TRACE_THREAD_LOCKS_CONTENTION_NS are included",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_TRACE_THREAD_RW_LOCKS",
                              "Enable tracing calls to pthread_rwlock_* functions. May "
                              "cause deadlocks with ROCm-enabled OpenMPI.",
@@ -543,6 +866,125 @@ configure_settings(bool _init)
                              "Enable tracing calls to pthread_join functions.", true,
                              "backend", "parallelism", "gotcha", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_LAZY_THREAD_SETUP",
+        "Reduce the cost of creating a thread. The creating thread does not wait for the "
+        "new thread to be set up and the timemory data of the new thread (e.g. the "
+        "'start_thread' region) is only set up when the thread enters its first region. "
+        "The samplers of the new threads are still started immediately. Recommended for "
+        "the applications which create many short-lived threads. Ignored when causal "
+        "profiling is enabled",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_HEAP_PROFILE",
+        "Wrap malloc, calloc, realloc, posix_memalign, free and the operator new and "
+        "delete functions, record the call-stack of one allocation per "
+        "OMNITRACE_HEAP_PROFILE_SAMPLE_INTERVAL bytes (on average) and write the "
+        "estimated allocated and live bytes per call-stack and per function to "
+        "heap-profile.{txt,json}. The allocated and live bytes and the allocation rate "
+        "are also shown in counter tracks in perfetto",
+        false, "backend", "gotcha", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_HEAP_PROFILE_SAMPLE_INTERVAL",
+        "Mean number of bytes allocated between the sampled allocations of "
+        "OMNITRACE_HEAP_PROFILE. The intervals are random (exponentially distributed) so "
+        "the allocations of every size are sampled with a known probability",
+        524288, "backend", "gotcha", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_IO_TRACE",
+        "Wrap read, write, pread, pwrite, readv, writev, preadv, pwritev, open, "
+        "openat, close, fsync and fdatasync (and their 64-bit variants) and accumulate "
+        "the number of calls, the bytes and log2 histograms of the sizes and the "
+        "latencies per file and operation in io-trace.{txt,json}. The read and write "
+        "throughput is shown in counter tracks in perfetto and the calls which took at "
+        "least OMNITRACE_IO_TRACE_THRESHOLD_NS are traced",
+        false, "backend", "gotcha", "io", "performance");
+
+    OMNITRACE_CONFIG_SETTING(
+        uint64_t, "OMNITRACE_IO_TRACE_THRESHOLD_NS",
+        "Minimum duration (in nanoseconds) of the I/O calls which are traced in "
+        "perfetto when OMNITRACE_IO_TRACE=ON. The shorter calls are only included in "
+        "the histograms and the counter tracks",
+        1000000, "backend", "gotcha", "io", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_THROTTLE_COUNT",
+        "Number of calls to an instrumented function (per thread) after which the "
+        "function is no longer traced if its mean inclusive time per call is less than "
+        "OMNITRACE_THROTTLE_PER_CALL_NS. A value of zero disables throttling",
+        0, "backend", "trace", "profile", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_THROTTLE_PER_CALL_NS",
+        "Mean inclusive time per call (in nanoseconds) below which an instrumented "
+        "function is throttled once it has been called OMNITRACE_THROTTLE_COUNT times",
+        10000, "backend", "trace", "profile", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_COMPILER_INSTRUMENTATION",
+        "Trace the functions of the binaries compiled with -finstrument-functions (and "
+        "linked to libomnitrace-dl) or, on x86-64, -fpatchable-function-entry=5. The NOP "
+        "sleds of the patchable functions are only patched when "
+        "OMNITRACE_COMPILER_INSTRUMENTATION_INCLUDE is set and never for the functions "
+        "with exception handlers",
+        true, "backend", "trace", "profile");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_COMPILER_INSTRUMENTATION_INCLUDE",
+        "Only trace the compiler-instrumented functions matching the list of provided "
+        "regexes (separated by tab, semi-colon, and/or quotes (single or double))",
+        std::string{}, "backend", "trace", "profile");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_COMPILER_INSTRUMENTATION_EXCLUDE",
+        "Do not trace the compiler-instrumented functions matching the list of provided "
+        "regexes (separated by tab, semi-colon, and/or quotes (single or double))",
+        std::string{}, "backend", "trace", "profile");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TSC_CLOCK",
+        "Read the timestamps for tracing and sampling from the time-stamp counter "
+        "(rdtsc) after calibrating it against the real-time clock. Only used when the "
+        "CPU reports an invariant TSC and the kernel clocksource is the TSC, otherwise "
+        "the real-time clock is used",
+        false, "backend", "trace", "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_TSC_CLOCK_INTERVAL",
+        "Interval (in seconds) between the recalibrations of the time-stamp counter "
+        "against the real-time clock when OMNITRACE_TSC_CLOCK is enabled. The "
+        "difference from the real-time clock is absorbed over the next interval so the "
+        "timestamps stay monotonic. A value <= 0 only calibrates once",
+        1.0, "backend", "trace", "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_FAST_START",
+        "Reduce the initialization time: the thread-pool for background tasks is "
+        "created on first use, the TSC clock is calibrated over 1 msec instead of 10 "
+        "msec, and the backtrace warm-up is skipped when neither sampling nor causal "
+        "profiling is enabled",
+        false, "backend", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SELF_PROFILE",
+        "Accumulate the time and number of calls spent inside the omnitrace entry "
+        "points for each subsystem (regions, perfetto, timemory, sampling, causal, "
+        "roctracer, kokkos, and the function wrappers) and report the breakdown at "
+        "finalization",
+        false, "debugging", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_HUGE_PAGES",
+        "Back the large buffers which are written on the hot paths (the call-stack "
+        "tables of the sampling and the deferred perfetto regions) with 2 MB huge "
+        "pages: the reserved huge pages (MAP_HUGETLB) when available, otherwise "
+        "transparent huge pages (MADV_HUGEPAGE). The buffers are prefaulted when they "
+        "are allocated. The TLB misses are reported with OMNITRACE_SELF_PROFILE",
+        false, "performance", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_SAMPLING_KEEP_INTERNAL",
         "Configure whether the statistical samples should include call-stack entries "
@@ -567,6 +1009,285 @@ configure_settings(bool _init)
         "thread started by the application.",
         8, "sampling", "debugging", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_OFFLOAD_PER_THREAD",
+        "When OMNITRACE_USE_TEMPORARY_FILES=ON, offload the full sampling buffers of "
+        "each thread to a separate, pre-sized, memory-mapped temporary file instead of "
+        "serializing the buffers of all the threads into a single temporary file. This "
+        "removes the process-wide lock around offloading the samples and allows the "
+        "samples of a thread to be re-loaded without seeking through a shared file",
+        false, "sampling", "io", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_STREAMING",
+        "Post-process the sampling buffers of each thread when they are full instead of "
+        "holding all the samples until finalization. The perfetto slices are emitted "
+        "during the run and the timemory call-graph is accumulated per unique call-stack "
+        "so the raw samples can be released immediately",
+        false, "sampling", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_SAMPLING_SNAPSHOT_INTERVAL",
+        "Time (in seconds) between the snapshots of the sampling profile for continuous "
+        "profiling. Every snapshot holds the call-graph of the samples streamed since "
+        "the previous snapshot and is written to sampling-snapshot-<N>.{txt,json} "
+        "while the application runs. Zero disables the snapshots. Implies "
+        "OMNITRACE_SAMPLING_STREAMING",
+        0.0, "sampling", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_PARALLEL_POST_PROCESS",
+        "Load and symbolize the samples of each thread in parallel on the background "
+        "thread pool (see OMNITRACE_THREAD_POOL_SIZE) during finalization. The results "
+        "are still written serially in the order of the threads",
+        true, "sampling", "parallelism", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_DEFERRED_SYMBOLS",
+        "Only record the instruction pointers of the call-stack when sampling. The "
+        "unique instruction pointers from all the samples are symbolized once during "
+        "post-processing and the samples are rebuilt from the resulting table",
+        false, "sampling", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_RAW_OUTPUT",
+        "Write the raw samples (the timestamps and the instruction pointers of the "
+        "call-stacks), the memory maps and the build-ids of the binaries to a "
+        "raw-<pid> folder of the output instead of symbolizing and post-processing the "
+        "samples in the application. The raw output is converted into the perfetto and "
+        "timemory output later with omnitrace-process. Implies "
+        "OMNITRACE_SAMPLING_DEFERRED_SYMBOLS",
+        false, "sampling", "io", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_COVERAGE",
+        "Derive an approximate code coverage from the sampled call-stacks (and the "
+        "branch stacks with OMNITRACE_SAMPLING_BRANCH_STACK) without instrumentation: "
+        "the functions and the lines of the DWARF line table of the sampled binaries "
+        "which were sampled are written to sampling-coverage.{txt,json}. Implies "
+        "OMNITRACE_SAMPLING_DEFERRED_SYMBOLS",
+        false, "sampling", "coverage", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_UNWINDER",
+        "Unwinder of the call-stacks sampled by the timers. \"frame-pointer\" follows "
+        "the frame pointers of the interrupted call-stack (-fno-omit-frame-pointer) and "
+        "falls back on libunwind when the first frame pointer is not within the stack "
+        "of the thread. \"auto\" compares both unwinders on the first samples and "
+        "keeps the frame-pointer unwinder if the call-stacks agree",
+        std::string{ "libunwind" }, "sampling", "performance", "advanced")
+        ->set_choices({ "libunwind", "frame-pointer", "auto" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_SHARED_UNWIND_TABLES",
+        "Register the unwind tables of the loaded libraries with libunwind once for the "
+        "whole process so the libunwind unwinder of the sampled threads finds the "
+        "procedure of each frame without iterating the program headers of every "
+        "library. The libraries registered are not unloaded before finalization",
+        true, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_AGGREGATE",
+        "Aggregate the call-stacks in the sampling signal handler. Each unique "
+        "call-stack is counted in a preallocated per-thread table and only new "
+        "call-stacks and periodic checkpoints (see "
+        "OMNITRACE_SAMPLING_AGGREGATE_CHECKPOINT) are stored in the sampling buffers. "
+        "The timemory output is generated from the table and the perfetto output only "
+        "contains the stored samples. The samples which were only counted in the table "
+        "are discarded before the buffers are offloaded and the call-stacks which do not "
+        "fit in a full table are stored individually",
+        false, "sampling", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_AGGREGATE_TABLE_SIZE",
+        "Number of unique call-stacks per thread which can be tracked when "
+        "OMNITRACE_SAMPLING_AGGREGATE=ON (rounded up to a power of 2). Samples of "
+        "call-stacks which do not fit are dropped from the aggregated output",
+        4096, "sampling", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_AGGREGATE_CHECKPOINT",
+        "When OMNITRACE_SAMPLING_AGGREGATE=ON, store every Nth sample of a call-stack in "
+        "the sampling buffers so that it appears in the timeline. A value of zero only "
+        "stores the first sample of each call-stack",
+        1000, "sampling", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_PYTHON",
+        "Record the Python call-stack of the interrupted thread in the CPU-time and "
+        "real-time samples of Python programs (e.g. omnitrace-python --sample). The "
+        "Python frames replace the frames of the interpreter loop in the sampled "
+        "call-stacks",
+        false, "sampling", "python", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_PYTHON_BUFFER_SIZE",
+        "Number of Python frames per thread which can be stored when "
+        "OMNITRACE_SAMPLING_PYTHON=ON. The Python call-stacks of the samples which do "
+        "not fit are dropped",
+        262144, "sampling", "python", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PYTHON_GIL",
+        "Measure the time each thread of a Python program waits for and holds the GIL, "
+        "attributed to the Python function which acquired it. The acquisitions through "
+        "the C API (e.g. the extension modules releasing the GIL around a blocking "
+        "call) are intercepted and the waits inside the interpreter are found in the "
+        "samples when OMNITRACE_USE_SAMPLING is enabled. The wait and hold time per "
+        "interval are shown in counter tracks in perfetto",
+        false, "python", "gotcha", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_PERF_BACKEND",
+        "Replace the CPU-time and real-time sampling timers with a perf_event per thread "
+        "whose user-space callchains are unwound by the kernel and collected from the "
+        "ring buffers by a background thread. Metrics of the timer samples are not "
+        "collected and the callchains require code compiled with frame pointers. Falls "
+        "back to the timers when the perf_event cannot be opened",
+        false, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_PERF_BUFFER_PAGES",
+        "Number of data pages in the ring buffer of each thread when "
+        "OMNITRACE_SAMPLING_PERF_BACKEND=ON (rounded up to a power of 2)",
+        64, "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_PERF_METRICS",
+        "Read the thread CPU time, context switches, and page faults of the samples from "
+        "the metadata pages of perf software counters instead of getrusage and the "
+        "thread CPU clock so a sample does not make a syscall. The page faults are the "
+        "count as of the last time the thread was scheduled in. Falls back to getrusage "
+        "when the counters cannot be opened",
+        true, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_PEAK_RSS_INTERVAL",
+        "When OMNITRACE_SAMPLING_PERF_METRICS=ON, read the peak memory usage (and refresh "
+        "the page faults) with a syscall every N samples. The samples in between report "
+        "the last value",
+        16, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_REGION_RATES",
+        "Comma-separated <region>:<frequency> rules which change the sampling frequency "
+        "of a thread while it is inside one of the regions, e.g. \"assemble:5000,*:50\". "
+        "\"*\" is the frequency outside of the regions of the rules. The rules apply to "
+        "the real-time timer (the CPU-time timer without it) and each sample is weighted "
+        "by the samples which the highest frequency would have taken",
+        "", "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_THREAD_GROUP",
+        "Replace the CPU-time and real-time sampling timers of every thread with one "
+        "timer thread which sends the sampling signal to the sampled threads "
+        "round-robin. Each thread is sampled at the requested frequency until the "
+        "total signal rate reaches OMNITRACE_SAMPLING_THREAD_GROUP_RATE, beyond which "
+        "the samples are weighted by the time since the previous sample of the thread. "
+        "The CPU-time signals skip the threads which did not run since their previous "
+        "sample. Intended for the applications with thousands of threads",
+        false, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_SAMPLING_THREAD_GROUP_RATE",
+        "Maximum number of sampling signals per second sent to all the threads when "
+        "OMNITRACE_SAMPLING_THREAD_GROUP=ON",
+        2000.0, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_COLLAPSE_GPU_WAIT",
+        "Do not unwind the call-stack of the samples taken while a thread is inside "
+        "hipDeviceSynchronize, hipStreamSynchronize, or hipEventSynchronize. These "
+        "samples are reduced to a single '[GPU wait]' frame of the HIP function, which "
+        "reduces the size of the sampling data and the post-processing time of GPU-bound "
+        "applications. Requires OMNITRACE_USE_ROCTRACER=ON",
+        false, "sampling", "rocm", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_OFFCPU",
+        "Record the user-space call-stack and the duration of every interval a sampled "
+        "thread is switched out (blocked or preempted) via a context-switch perf_event "
+        "per thread and write the off-CPU time of the call-stacks and functions to "
+        "sampling-offcpu.{txt,json}. Requires a perf_event_paranoid value of 1 or less "
+        "and code compiled with frame pointers",
+        false, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_NUMA_LOCALITY",
+        "Sample the data addresses of the memory loads of the sampled threads with "
+        "OMNITRACE_NUMA_LOCALITY_EVENT, resolve the NUMA node of their pages in the "
+        "background and write the fraction of the loads from remote nodes per "
+        "allocation site (of the numa_alloc functions) and per function to "
+        "numa-locality.{txt,json}",
+        false, "sampling", "numa", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_NUMA_LOCALITY_EVENT",
+        "Memory sampling event of OMNITRACE_NUMA_LOCALITY in the perf syntax for a PMU "
+        "in /sys/bus/event_source/devices, e.g. 'cpu/mem-loads,ldlat=30/' (Intel) or "
+        "'ibs_op//' (AMD)",
+        "cpu/mem-loads,ldlat=30/", "sampling", "numa", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(size_t, "OMNITRACE_NUMA_LOCALITY_PERIOD",
+                             "Number of events of OMNITRACE_NUMA_LOCALITY_EVENT between "
+                             "the samples",
+                             1000, "sampling", "numa", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_BRANCH_STACK",
+        "Sample the last taken branches of the sampled threads (LBR on Intel, BRS or "
+        "LbrExtV2 on AMD) every OMNITRACE_SAMPLING_BRANCH_PERIOD events of "
+        "OMNITRACE_SAMPLING_BRANCH_EVENT, reconstruct the straight-line blocks which "
+        "were executed between the branches and write the hottest blocks, branches "
+        "and functions to sampling-branches.{txt,json}",
+        false, "sampling", "branch", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_BRANCH_EVENT",
+        "Event of OMNITRACE_SAMPLING_BRANCH_STACK, e.g. "
+        "PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES or an event in the "
+        "perf syntax for a PMU in /sys/bus/event_source/devices",
+        std::string{ "PERF_COUNT_HW_BRANCH_INSTRUCTIONS" }, "sampling", "branch",
+        "advanced");
+
+    OMNITRACE_CONFIG_SETTING(size_t, "OMNITRACE_SAMPLING_BRANCH_PERIOD",
+                             "Number of events of OMNITRACE_SAMPLING_BRANCH_EVENT "
+                             "between the samples of the branch stack",
+                             100003, "sampling", "branch", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_SAMPLING_OVERHEAD_TARGET",
+        "Maximum percentage of the wall-time each thread should spend unwinding the "
+        "call-stack of the CPU-time and real-time samples. When the measured overhead "
+        "exceeds this value, only every Nth timer signal is sampled (and N is reduced "
+        "when the overhead allows it). The samples are reweighted by N in the output. "
+        "A value of zero disables the adaptive rate",
+        0.0, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_CALIBRATION_FILE",
+        "Calibration of the cost of the backends on this node written by "
+        "'omnitrace-avail --calibrate'. The adaptive sampling rate starts from the "
+        "stride which keeps the calibrated cost of the samples within "
+        "OMNITRACE_SAMPLING_OVERHEAD_TARGET and omnitrace-run reports the estimated "
+        "overhead of the sampling configuration",
+        "", "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_NUMA_ALLOCATORS",
+        "Share the sampler allocators only among the threads that are running on the "
+        "same NUMA node (when the sampler is created). The allocator thread is bound to "
+        "the CPUs of that node",
+        false, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_COMPACT_OFFLOAD",
+        "Store the sampling buffers offloaded to the temporary file, or to the "
+        "per-thread segments (see OMNITRACE_SAMPLING_OFFLOAD_PER_THREAD), with a delta "
+        "and variable-length encoding instead of the raw samples. Reduces the size of "
+        "the temporary files at the cost of encoding in the allocator thread",
+        false, "sampling", "io", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_SAMPLING_OVERFLOW",
                              "Enable sampling via an overflow of a HW counter. This "
                              "requires Linux perf (/proc/sys/kernel/perf_event_paranoid "
@@ -601,20 +1322,79 @@ configure_settings(bool _init)
                              "the same signal (SIGRTMIN + 1)",
                              SIGRTMIN + 1, "sampling", "advanced");
 
-    OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_SAMPLING_OVERFLOW_EVENT",
-                             "Metric for overflow sampling",
-                             std::string{ "perf::PERF_COUNT_HW_CACHE_REFERENCES" },
-                             "sampling", "hardware_counters")
+    auto _overflow_choices = perf::get_config_choices();
+    _overflow_choices.emplace_back("ibs_op//");
+    _overflow_choices.emplace_back("ibs_fetch//");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_OVERFLOW_EVENT",
+        "Metric for overflow sampling. Also accepts an event in the perf syntax for a "
+        "PMU in /sys/bus/event_source/devices, e.g. 'ibs_op//' for the precise "
+        "instruction-based sampling of the AMD CPUs, which also records the data "
+        "address, the latency and the data source of the memory operations",
+        std::string{ "perf::PERF_COUNT_HW_CACHE_REFERENCES" }, "sampling",
+        "hardware_counters")
+        ->set_choices(_overflow_choices);
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_PERF_EVENTS",
+        "Hardware counters (e.g. PERF_COUNT_HW_INSTRUCTIONS PERF_COUNT_HW_CPU_CYCLES) "
+        "which are counted by a perf_event per thread and read from user-space with the "
+        "rdpmc instruction. When set, these replace OMNITRACE_PAPI_EVENTS as the thread "
+        "hardware counters of the samples. The counters are read with a syscall when "
+        "the kernel does not permit rdpmc (see /sys/bus/event_source/devices/cpu/rdpmc)",
+        std::string{}, "sampling", "hardware_counters", "advanced")
         ->set_choices(perf::get_config_choices());
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERF_EVENTS_REGIONS",
+        "Accumulate the OMNITRACE_PERF_EVENTS counters of the user regions and the "
+        "instrumented functions on every thread and write the totals per region to "
+        "perf_counters.{txt,json}",
+        false, "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERF_EVENTS_GROUP_SIZE",
+        "Number of the OMNITRACE_PERF_EVENTS which are counted at the same time. When "
+        "more events are requested, the events are partitioned into groups of this size "
+        "which take turns counting and the values are scaled by the fraction of the "
+        "time each event was counting. Zero counts all the events at the same time",
+        4, "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERF_EVENTS_ROTATION_INTERVAL",
+        "Minimum time (in msec) which a group of OMNITRACE_PERF_EVENTS counts before the "
+        "next group (see OMNITRACE_PERF_EVENTS_GROUP_SIZE). The groups are rotated when "
+        "the counters are read by the samples and the regions",
+        10.0, "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_FORK_CHILD_CAPTURE",
+        "Profile the child processes created by fork() which do not call exec(). "
+        "Instead of being disabled, the child reuses the configuration and the binary "
+        "info of the parent, samples its CPU-time at OMNITRACE_SAMPLING_CPUTIME_FREQ "
+        "when sampling is enabled, accumulates its regions, and writes the totals to "
+        "fork-child-profile.{txt,json} with the PID of the child as the output suffix",
+        false, "sampling", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_FORK_CHILD_CAPTURE_SAMPLES",
+        "Maximum number of call-stacks which are sampled by a child process with "
+        "OMNITRACE_FORK_CHILD_CAPTURE. The buffer is allocated when the child starts "
+        "and the samples beyond the capacity are counted as dropped",
+        65536, "sampling", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_ROCTRACER_HIP_API",
                              "Enable HIP API tracing support", true, "roctracer", "rocm",
                              "advanced");
 
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_ROCTRACER_HIP_API_BACKTRACE",
-        "Enable annotating the perfetto debug annotation with backtraces", false,
-        "roctracer", "rocm", "perfetto", "advanced");
+        "Annotate the perfetto slices of the HIP API calls and of their kernel "
+        "dispatches with the id of the host call-stack of the call. The call-stacks are "
+        "deduplicated per thread and every unique call-stack is symbolized once at "
+        "finalization and written with its id to hip-api-stacks.{txt,json}",
+        false, "roctracer", "rocm", "perfetto", "advanced");
 
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_ROCTRACER_HIP_ACTIVITY",
                              "Enable HIP activity tracing support", true, "roctracer",
@@ -632,10 +1412,112 @@ configure_settings(bool _init)
                              "HSA API type to collect", "", "roctracer", "rocm",
                              "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_ROCTRACER_HSA_API_SAMPLING",
+        "Rate limit of the HSA API tracing as space-separated [NAME=]FIRST[:INTERVAL] "
+        "entries: the first FIRST calls of a function on each thread are traced and then "
+        "one in every INTERVAL calls (none if INTERVAL is 0 or omitted). The entries "
+        "without a name apply to every function which is not named, e.g. "
+        "'1000:100 hsa_signal_load_relaxed=10:10000'. The number of calls and of traced "
+        "calls of each function is written to roctracer-hsa-api.txt",
+        "", "roctracer", "rocm", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_ROCTRACER_DISCARD_BARRIERS",
                              "Skip barrier marker events in traces", false, "roctracer",
                              "rocm", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_ROCTRACER_CLOCK_SKEW_INTERVAL",
+        "Interval (in seconds) between re-synchronizations of the CPU and GPU clocks. "
+        "The offset applied to the roctracer timestamps is a linear fit of the most "
+        "recent synchronization points to account for drift. A value <= 0 synchronizes "
+        "once",
+        1.0, "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCTRACER_ACTIVITY_BUFFER_SIZE",
+        "Number of HIP activity records (kernels, copies, barriers) buffered per thread "
+        "until the thread which launched them inserts them into its call-graph at its "
+        "next HIP function call. Additional records are allocated on demand",
+        4096, "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCM_QUEUE_TRACE",
+        "Time the kernel dispatches by intercepting the HSA queues instead of through "
+        "the roctracer activity buffers. The completion signal of each kernel dispatch "
+        "packet is replaced and a background thread reads the dispatch timestamps once "
+        "the signal completes. Copies and barriers are still traced by roctracer",
+        false, "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCM_QUEUE_TRACE_SIZE",
+        "Maximum number of kernel dispatches in flight per HSA queue which are timed "
+        "with OMNITRACE_ROCM_QUEUE_TRACE. Additional dispatches are submitted without "
+        "being timed",
+        1024, "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCTRACER_AGGREGATE",
+        "Only collect the per-kernel (and per-device) count, duration statistics, and "
+        "bytes copied for HIP activity instead of recording every dispatch in the "
+        "perfetto and timemory output",
+        false, "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_CRITICAL_PATH",
+        "Record the HIP API calls, the kernels and copies and the user regions, and at "
+        "finalization extract the critical path across the CPU threads and the GPU "
+        "queues from the launch, queue order and synchronization dependencies. The "
+        "critical time and slack of each kernel, HIP function and region are written to "
+        "critical-path.{txt,json}, a perfetto track and the timemory output",
+        false, "roctracer", "rocm", "perfetto", "timemory", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_RCCLP_DEVICE_TIMING",
+        "Match the RCCL calls with the kernels they launch (requires roctracer) and "
+        "report the on-device duration, the achieved bus bandwidth and the skew "
+        "between the ranks per collective, communicator and message size in "
+        "rccl_timing.{txt,json}. The calls are folded into the statistics as soon as "
+        "their kernels complete",
+        false, "rocm", "rccl", "roctracer", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_GPU_MEMORY_TRACKING",
+        "Account for every HIP allocation and deallocation (requires roctracer and the "
+        "HIP API tracing) and write the peak of the live memory per device with the "
+        "allocation sites (call-stacks) which held it and the allocations which were "
+        "never freed to gpu-memory.{txt,json}. The live memory of each device is also "
+        "shown in a counter track in perfetto",
+        false, "rocm", "roctracer", "perfetto", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_HIP_GRAPHS",
+        "Track the construction (stream captures and explicit kernel nodes), the "
+        "instantiation and the launches of HIP graphs (requires roctracer and the HIP "
+        "API tracing) so the kernels dispatched by hipGraphLaunch are named after and "
+        "attributed to the nodes of the graph. The per-node timings, the host launch "
+        "time and the launch latency of each instantiated graph are written to "
+        "hip-graphs.{txt,json}",
+        false, "rocm", "roctracer", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_KERNEL_LAUNCH_LATENCY",
+        "Measure the latency from the kernel launches on the host to the begin of the "
+        "kernels (requires roctracer and the HIP API tracing) and the idle gaps between "
+        "the consecutive kernels of each GPU queue. The log2 histograms of both are "
+        "written per device and queue to kernel-launch.{txt,json} and the number of "
+        "kernels in flight on each queue is shown in a counter track in perfetto",
+        false, "rocm", "roctracer", "perfetto", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_MEMCPY_ANALYSIS",
+        "Classify the HIP memory copies (requires roctracer and the HIP API tracing) by "
+        "direction (H2D, D2H, D2D, P2P), size and whether the host memory was pinned or "
+        "pageable from the arguments of the copy functions and the recorded allocations. "
+        "The log2 histograms of the achieved bandwidth of each class are written to "
+        "memcpy-analysis.{txt,json} and the copies of pageable host memory are reported",
+        false, "rocm", "roctracer", "analysis", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_ROCM_EVENTS",
         "ROCm hardware counters. Use ':device=N' syntax to specify collection on device "
@@ -643,6 +1525,51 @@ configure_settings(bool _init)
         "is collected on every available device",
         "", "rocprofiler", "rocm", "hardware_counters");
 
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCM_EVENTS_SAMPLE_RATE",
+        "Collect the OMNITRACE_ROCM_EVENTS hardware counters for one in every N "
+        "dispatches of each kernel (the first dispatch of a kernel is always collected). "
+        "The other dispatches run without a profiling context. The timemory output "
+        "scales the sampled counter values by the ratio of dispatches to samples",
+        1, "rocprofiler", "rocm", "hardware_counters");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_ROCM_EVENTS_MODE",
+        "How the OMNITRACE_ROCM_EVENTS hardware counters are collected. 'dispatch' "
+        "collects the counters of each kernel dispatch, which serializes the kernels. "
+        "'sampled' collects the counters of each device as a whole in every interval of "
+        "the background process sampler (OMNITRACE_PROCESS_SAMPLING_FREQ) without "
+        "intercepting the dispatches and writes them as perfetto counter tracks",
+        "dispatch", "rocprofiler", "rocm", "hardware_counters")
+        ->set_choices({ "dispatch", "sampled" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCM_ROOFLINE",
+        "Collect the hardware counters required for a roofline analysis of the kernels "
+        "(the FLOPs and the DRAM bytes for the architecture of each device) instead of "
+        "OMNITRACE_ROCM_EVENTS. When the counters do not fit in one pass, the "
+        "dispatches of each kernel rotate through the passes. The FLOPs, the bytes, the "
+        "arithmetic intensity and the fraction of the attainable peak of each kernel "
+        "are written to roofline.{txt,json}",
+        false, "rocprofiler", "rocm", "hardware_counters", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_PC_SAMPLING_METHOD",
+        "How the program counters of the waves are sampled. 'host_trap' interrupts the "
+        "waves from the host at a time interval (MI200 and later). 'stochastic' samples "
+        "the waves in hardware at an interval of shader cycles with a lower overhead "
+        "(MI300 and later)",
+        "host_trap", "pc_sampling", "rocm")
+        ->set_choices({ "host_trap", "stochastic" });
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PC_SAMPLING_INTERVAL",
+        "Interval of the GPU PC sampling in microseconds (host_trap) or shader cycles "
+        "(stochastic). Larger intervals slow the kernels less. Zero selects 100 "
+        "microseconds or 2^20 cycles. The interval is clamped to the range supported "
+        "by each device and rounded up to a power of two when the device requires it",
+        size_t{ 0 }, "pc_sampling", "rocm");
+
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_ROCM_SMI_METRICS",
                              "rocm-smi metrics to collect: busy, temp, power, mem_usage",
                              "busy,temp,power,mem_usage", "backend", "rocm_smi", "rocm",
@@ -661,6 +1588,21 @@ configure_settings(bool _init)
                              "default to the value of OMNITRACE_COLLAPSE_PROCESSES",
                              false, "perfetto", "data", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_CLOCK_SYNC",
+        "Estimate the offset of the clock of each MPI rank relative to rank 0 after "
+        "MPI_Init and at finalization and shift the perfetto timestamps of each rank "
+        "onto the clock of rank 0 so the traces of different nodes line up. Not "
+        "applied to OMNITRACE_PERFETTO_STREAMING output",
+        false, "perfetto", "mpi", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_CLOCK_SYNC_ROUNDS",
+        "Number of ping-pong exchanges between rank 0 and each rank when estimating the "
+        "clock offsets (see OMNITRACE_PERFETTO_CLOCK_SYNC). The exchange with the "
+        "lowest round-trip time provides the estimate",
+        16, "perfetto", "mpi", "data", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_PERFETTO_ROCTRACER_PER_STREAM",
         "Separate roctracer GPU side traces (copies, kernels) into separate "
@@ -674,6 +1616,87 @@ configure_settings(bool _init)
         "discard", "perfetto", "data")
         ->set_choices({ "fill", "discard" });
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_STREAMING",
+        "Periodically write the perfetto trace data directly into the output file "
+        "during execution instead of at finalization. Bounds the memory usage of "
+        "long-running applications and leaves a readable partial trace if the "
+        "application does not finalize. Not supported by "
+        "OMNITRACE_PERFETTO_COMBINE_TRACES",
+        false, "perfetto", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_FLUSH_PERIOD",
+        "Period (in milliseconds) between the writes of the perfetto trace data to the "
+        "output file when OMNITRACE_PERFETTO_STREAMING is enabled",
+        5000, "perfetto", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_AUTO_SIZE",
+        "Size the perfetto buffer from the rate of the trace data measured during "
+        "OMNITRACE_PERFETTO_AUTO_SIZE_WARMUP instead of "
+        "OMNITRACE_PERFETTO_BUFFER_SIZE_KB. Enables OMNITRACE_PERFETTO_STREAMING, the buffer holds the data produced "
+        "between the writes into the output file and is enlarged (up to "
+        "OMNITRACE_PERFETTO_AUTO_SIZE_MAX_KB) when the fraction of dropped chunks "
+        "exceeds OMNITRACE_PERFETTO_AUTO_SIZE_DROP_RATE. Not supported by "
+        "OMNITRACE_FLIGHT_RECORDER or OMNITRACE_PERFETTO_COMBINE_TRACES",
+        false, "perfetto", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERFETTO_AUTO_SIZE_WARMUP",
+        "Duration (in seconds) over which the rate of the trace data is measured when "
+        "OMNITRACE_PERFETTO_AUTO_SIZE is enabled. The fraction of dropped chunks is "
+        "checked with the same period afterwards",
+        1.0, "perfetto", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_AUTO_SIZE_MAX_KB",
+        "Upper bound (in KB) of the perfetto buffer when OMNITRACE_PERFETTO_AUTO_SIZE is "
+        "enabled. Also used for the buffer during the warm-up",
+        size_t{ 1048576 }, "perfetto", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERFETTO_AUTO_SIZE_DROP_RATE",
+        "Fraction of the perfetto chunks which may be dropped before the buffer is "
+        "enlarged when OMNITRACE_PERFETTO_AUTO_SIZE is enabled",
+        1.0e-3, "perfetto", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_FLIGHT_RECORDER",
+        "Run perfetto as a flight recorder: trace data is kept in a ring buffer of "
+        "OMNITRACE_PERFETTO_BUFFER_SIZE_KB (no temporary files are used) and the most "
+        "recent data is written when a dump is triggered by "
+        "OMNITRACE_FLIGHT_RECORDER_SIGNAL, omnitrace_user_dump_trace(), "
+        "OMNITRACE_FLIGHT_RECORDER_LATENCY_THRESHOLD, or at finalization",
+        false, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(int, "OMNITRACE_FLIGHT_RECORDER_SIGNAL",
+                             "Signal which triggers a dump of the flight recorder. Set "
+                             "to zero to disable dumping via a signal",
+                             SIGUSR2, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_EMERGENCY_DUMP",
+        "Write the in-memory buffers (pending perfetto regions of "
+        "OMNITRACE_PERFETTO_DEFERRED_REGIONS, pending HIP activity records and the "
+        "offloaded samples) to an emergency-dump.bin file when the process is "
+        "terminated by SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT or SIGTERM. Convert "
+        "the file with 'python -m omnitrace.emergency'",
+        false, "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_FLIGHT_RECORDER_LATENCY_THRESHOLD",
+        "If > 0.0, a user region (omnitrace_user_push_region/omnitrace_user_pop_region) "
+        "which takes longer than this many milliseconds triggers a dump of the flight "
+        "recorder",
+        0.0, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_FLIGHT_RECORDER_WINDOW",
+        "Time (in seconds) of background process samples retained in memory by the "
+        "flight recorder when OMNITRACE_PROCESS_SAMPLING_RETENTION is not set",
+        60.0, "perfetto", "process_sampling", "advanced");
+
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_ENABLE_CATEGORIES",
                              "Enable collecting profiling and trace data for these "
                              "categories and disable all other categories",
@@ -706,6 +1729,32 @@ configure_settings(bool _init)
         "trace with the same value",
         false, "perfetto", "data", "debugging", "roctracer", "rocm", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_DEFERRED_ROCTRACER_ANNOTATIONS",
+        "When PERFETTO_ANNOTATIONS, USE_ROCTRACER, and ROCTRACER_HIP_API are all "
+        "enabled, enabling this option will defer the formatting of the arg information "
+        "for HIP API calls: the HIP API callback only copies the arguments and the "
+        "slices are emitted in batches by a background thread. This reduces the "
+        "overhead of the HIP API calls in the application. Ignored when "
+        "ROCTRACER_HIP_API_BACKTRACE is enabled",
+        false, "perfetto", "data", "debugging", "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_DEFERRED_REGIONS",
+        "Defer the encoding of the perfetto slices of the instrumented, user, and other "
+        "regions: the begin and end of a region only store a fixed-size record in a "
+        "per-thread ring buffer and a background thread encodes the records in batches. "
+        "This reduces the overhead of fine-grained instrumentation. The arguments of the "
+        "regions and the timemory annotations are not included in this mode",
+        false, "perfetto", "data", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_DEFERRED_BUFFER_SIZE",
+        "Number of records in the per-thread ring buffer of "
+        "OMNITRACE_PERFETTO_DEFERRED_REGIONS (rounded up to a power of two). When the "
+        "ring is full, the thread encodes its records itself",
+        size_t{ 16384 }, "perfetto", "data", "performance", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         uint64_t, "OMNITRACE_THREAD_POOL_SIZE",
         "Max number of threads for processing background tasks",
@@ -714,9 +1763,58 @@ configure_settings(bool _init)
         "parallelism", "advanced");
 
     OMNITRACE_CONFIG_SETTING(
-        std::string, "OMNITRACE_TIMEMORY_COMPONENTS",
-        "List of components to collect via timemory (see `omnitrace-avail -C`)",
-        "wall_clock", "timemory", "component");
+        std::string, "OMNITRACE_BACKGROUND_CPUS",
+        "CPUs which the background threads of omnitrace (the thread pool, the process "
+        "sampler, the sampling and tracing helper threads and the threads created by "
+        "perfetto and roctracer while omnitrace is configuring them) are pinned to. "
+        "Either a list of CPUs (e.g. '0,64-71') or a policy: 'smt' (the SMT siblings of "
+        "the CPUs of the process) or 'l3' (the first CPU of each L3 cache domain, e.g. "
+        "core 0 of each CCD, among the CPUs of the process). Empty or 'none' leaves the "
+        "affinity unchanged",
+        "", "parallelism", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        int, "OMNITRACE_BACKGROUND_NICE",
+        "Nice value added to the background threads of omnitrace (see "
+        "OMNITRACE_BACKGROUND_CPUS) so they yield to the application threads which "
+        "share their CPUs. Zero leaves the priority unchanged",
+        0, "parallelism", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PARALLEL_FINALIZE",
+        "Run the independent post-processing stages of finalization (e.g. sampling, "
+        "process-level samples, code coverage) concurrently on the background thread "
+        "pool (see OMNITRACE_THREAD_POOL_SIZE)",
+        true, "parallelism", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_TIMEMORY_COMPONENTS",
+        "List of components to collect via timemory (see `omnitrace-avail -C`)",
+        "wall_clock", "timemory", "component");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PROFILE_AGGREGATE",
+        "Reduce the timemory call-graphs of all the MPI ranks up a binomial tree and "
+        "only write the min, max, mean, and stddev of each call-path on rank 0 instead "
+        "of the per-rank output (or combined output when "
+        "OMNITRACE_COLLAPSE_PROCESSES=ON)",
+        false, "timemory", "mpi", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TIMELINE_PROFILE_COMPACT",
+        "With OMNITRACE_TIMELINE_PROFILE=ON, record each instance of a region as a "
+        "32-byte record in the per-thread storage of omnitrace instead of a timemory "
+        "call-graph node and write the instances to timeline-profile.{txt,json}. Only "
+        "records the wall-clock time of the regions",
+        false, "timemory", "profile", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_COLUMNAR_OUTPUT",
+        "Write the timemory call-graphs of the profiling and sampling components of each "
+        "rank to a profile.columnar file: a memory-mappable binary file with a string "
+        "table and one column per field of the nodes (see the omnitrace.columnar python "
+        "module)",
+        false, "timemory", "io", "advanced");
 
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_OUTPUT_FILE",
                              "[DEPRECATED] See OMNITRACE_PERFETTO_FILE", std::string{},
@@ -726,6 +1824,20 @@ configure_settings(bool _init)
                              std::string{ "perfetto-trace.proto" }, "perfetto", "io",
                              "filename", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_OUTPUT_COMPRESSION",
+        "Compress the perfetto trace and the timemory JSON files on background threads "
+        "during finalization. The compressed files have a .gz or .zst extension",
+        std::string{ "none" }, "perfetto", "timemory", "io", "data", "performance",
+        "advanced")
+        ->set_choices({ "none", "gzip", "zstd" });
+
+    OMNITRACE_CONFIG_SETTING(
+        int, "OMNITRACE_OUTPUT_COMPRESSION_LEVEL",
+        "Level of the OMNITRACE_OUTPUT_COMPRESSION. Zero selects the default level of the "
+        "method (6 for gzip, 3 for zstd), higher levels trade time for smaller files",
+        0, "io", "data", "performance", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_USE_TEMPORARY_FILES",
                              "Write data to temporary files to minimize the memory usage "
                              "of omnitrace, e.g. call-stack samples will be periodically "
@@ -736,6 +1848,32 @@ configure_settings(bool _init)
         std::string, "OMNITRACE_TMPDIR", "Base directory for temporary files",
         get_env<std::string>("TMPDIR", "/tmp"), "io", "data", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_TMP_BACKEND",
+        "Storage of the temporary files. \"file\" creates them in OMNITRACE_TMPDIR. "
+        "\"memfd\" creates anonymous memory files (memfd_create) instead: nothing is "
+        "written to the filesystem of OMNITRACE_TMPDIR and the files are released by "
+        "the kernel when the process exits, including when it crashes. The contents "
+        "of an anonymous file are accounted as shared memory of the process",
+        std::string{ "file" }, "io", "data", "advanced")
+        ->set_choices({ "file", "memfd" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TMP_SEAL",
+        "When OMNITRACE_TMP_BACKEND=memfd, seal the anonymous files against any further "
+        "write or resize when their contents are read back during finalization",
+        false, "io", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_OUTPUT_STAGING",
+        "Node-local directory (e.g. /dev/shm or a local NVMe, 'tmpdir' for "
+        "OMNITRACE_TMPDIR) where the output files are written during finalization. "
+        "When the application is launched by omnitrace-run, a detached process moves "
+        "the files to OMNITRACE_OUTPUT_PATH after the application exited so the time "
+        "to exit does not depend on the shared filesystem. Otherwise the files are "
+        "moved at the end of the finalization",
+        "", "io", "performance", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_CAUSAL_BACKEND",
         "Backend for call-stack sampling. See "
@@ -749,9 +1887,11 @@ configure_settings(bool _init)
         std::string, "OMNITRACE_CAUSAL_MODE",
         "Perform causal experiments at the function-scope or line-scope. Ideally, use "
         "function first to locate function with highest impact and then switch to line "
-        "mode + OMNITRACE_CAUSAL_FUNCTION_SCOPE set to the function being targeted.",
+        "mode + OMNITRACE_CAUSAL_FUNCTION_SCOPE set to the function being targeted. "
+        "In kernel mode, the experiments virtually speed up the GPU kernels (requires "
+        "OMNITRACE_USE_ROCTRACER)",
         std::string{ "function" }, "causal", "analysis")
-        ->set_choices({ "func", "line", "function" });
+        ->set_choices({ "func", "line", "function", "kernel" });
 
     OMNITRACE_CONFIG_SETTING(
         double, "OMNITRACE_CAUSAL_DELAY",
@@ -772,6 +1912,14 @@ configure_settings(bool _init)
         "Perform causal experiment over the length of the entire application", false,
         "causal", "analysis", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        uint64_t, "OMNITRACE_CAUSAL_DELAY_SPIN_NS",
+        "Virtual speed-up delays shorter than this many nanoseconds (plus the current "
+        "estimate of the wake-up latency of clock_nanosleep) are busy-waited. Longer "
+        "delays sleep until this many nanoseconds before the end of the delay and "
+        "busy-wait the remainder",
+        20000, "causal", "analysis", "advanced");
+
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_CAUSAL_FILE",
                              "Name of causal output filename (w/o extension)",
                              std::string{ "experiments" }, "causal", "analysis",
@@ -790,6 +1938,63 @@ configure_settings(bool _init)
         "used.",
         0, "causal", "analysis");
 
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_CAUSAL_NUM_WORKERS",
+        "Number of concurrent processes (e.g. launched by omnitrace-causal --jobs) "
+        "sharing the causal experiments. Each worker evaluates a different subset of the "
+        "virtual speedups and lines and the results are merged into a single causal "
+        "output file. When used with MPI, this value is multiplied by the number of "
+        "ranks, i.e. every rank is a separate worker",
+        1, "causal", "analysis", "advanced", "parallelism");
+
+    OMNITRACE_CONFIG_SETTING(size_t, "OMNITRACE_CAUSAL_WORKER_ID",
+                             "Index of this process in [0, OMNITRACE_CAUSAL_NUM_WORKERS)",
+                             0, "causal", "analysis", "advanced", "parallelism");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_CAUSAL_ADAPTIVE",
+        "Instead of experimenting on randomly sampled lines/functions with random "
+        "virtual speedups, favor the selections whose impact estimate (from the "
+        "current and the previously saved experiments) is promising or still "
+        "uncertain and retire the selections whose estimate has converged",
+        false, "causal", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE",
+        "With OMNITRACE_CAUSAL_ADAPTIVE, a line/function is retired once the half-width "
+        "of the 95% confidence interval of its impact estimate (the program speedup per "
+        "unit of virtual speedup) is below this value",
+        0.05, "causal", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_CAUSAL_ADAPTIVE_MIN_EXPERIMENTS",
+        "With OMNITRACE_CAUSAL_ADAPTIVE, minimum number of experiments with a non-zero "
+        "virtual speedup before the impact estimate of a line/function is used",
+        3, "causal", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_CAUSAL_ADAPTIVE_STATUS",
+        "With OMNITRACE_CAUSAL_ADAPTIVE, path of a file written at finalization with "
+        "the number of lines/functions whose impact estimate has converged. The suffix "
+        "'.<worker id>' is appended when the experiments are shared by several workers. "
+        "omnitrace-causal --converge sets this to stop launching runs once every "
+        "estimate has converged",
+        std::string{}, "causal", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_CAUSAL_LOG",
+        "Append every causal experiment to an indexed binary log as soon as it "
+        "completes instead of rewriting the JSON output at finalization. The "
+        "experiments of a run which is interrupted are preserved and later runs "
+        "resume from the log",
+        false, "causal", "io");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_CAUSAL_LOG_EXPORT",
+        "With OMNITRACE_CAUSAL_LOG, also export the entire log to the JSON output at "
+        "finalization",
+        false, "causal", "io");
+
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_CAUSAL_FIXED_SPEEDUP",
                              "List of virtual speedups between 0 and 100 (inclusive) to "
                              "sample from for causal profiling",
@@ -841,6 +2046,30 @@ configure_settings(bool _init)
         "starting with '_' or containing '::_M'.",
         true, "causal", "analysis", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_BINARY_CACHE",
+        "Save the symbols and DWARF line info of each binary processed for causal "
+        "profiling to OMNITRACE_BINARY_CACHE_DIR and reuse them in later runs instead "
+        "of reading them from the binary again. The entries are keyed by the ELF "
+        "build-id or, if there is none, the path, modification time and size of the "
+        "binary",
+        false, "causal", "analysis", "io");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_BINARY_CACHE_DIR",
+        "Directory of the OMNITRACE_BINARY_CACHE entries. Defaults to "
+        "omnitrace/binary-info in XDG_CACHE_HOME (or $HOME/.cache)",
+        std::string{}, "causal", "analysis", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_BINARY_ANALYSIS_THREADS",
+        "Number of binaries (the executable and the shared libraries) whose symbols and "
+        "DWARF line info are read concurrently for causal profiling. Inside the "
+        "application, the omnitrace thread pool is used when its size "
+        "(OMNITRACE_THREAD_POOL_SIZE) is greater than one. A value of zero uses one "
+        "thread per CPU",
+        1, "causal", "analysis", "parallelism", "advanced");
+
     // set the defaults
     _config->get_flamegraph_output()     = false;
     _config->get_ctest_notes()           = false;
@@ -1064,7 +2293,23 @@ configure_settings(bool _init)
     handle_deprecated_setting("OMNITRACE_USE_TIMEMORY", "OMNITRACE_PROFILE");
 
     scope::get_fields()[scope::flat::value]     = _config->get_flat_profile();
-    scope::get_fields()[scope::timeline::value] = _config->get_timeline_profile();
+    // the compact timeline profile replaces the per-instance nodes of the regions and
+    // the call-graphs of the other components are not expanded
+    scope::get_fields()[scope::timeline::value] =
+        _config->get_timeline_profile() &&
+        !_config->get<bool>("OMNITRACE_TIMELINE_PROFILE_COMPACT");
+
+    // the instruction pointers of the raw output are symbolized by omnitrace-process
+    if(_config->get<bool>("OMNITRACE_RAW_OUTPUT"))
+        set_setting_value("OMNITRACE_SAMPLING_DEFERRED_SYMBOLS", true);
+
+    // the sampling code coverage needs the instruction pointers of the samples
+    if(_config->get<bool>("OMNITRACE_SAMPLING_COVERAGE"))
+        set_setting_value("OMNITRACE_SAMPLING_DEFERRED_SYMBOLS", true);
+
+    // the snapshots are taken from the call-graphs accumulated by the streaming
+    if(_config->get<double>("OMNITRACE_SAMPLING_SNAPSHOT_INTERVAL") > 0.0)
+        set_setting_value("OMNITRACE_SAMPLING_STREAMING", true);
 
     settings::suppress_parsing()  = true;
     settings::use_output_suffix() = _config->get<bool>("OMNITRACE_USE_PID");
@@ -1090,10 +2335,13 @@ configure_settings(bool _init)
     configure_mode_settings(_config);
     configure_signal_handler(_config);
     configure_disabled_settings(_config);
+    configure_output_staging(_config);
 
     OMNITRACE_BASIC_VERBOSE(2, "configuration complete\n");
 
     _settings_are_configured() = true;
+
+    update_snapshot();
 }
 
 void
@@ -1129,6 +2377,7 @@ configure_mode_settings(const std::shared_ptr<settings>& _config)
         _set("OMNITRACE_USE_ROCM_SMI", false);
         _set("OMNITRACE_USE_ROCTRACER", false);
         _set("OMNITRACE_USE_ROCPROFILER", false);
+        _set("OMNITRACE_USE_PC_SAMPLING", false);
         _set("OMNITRACE_USE_KOKKOSP", false);
         _set("OMNITRACE_USE_RCCLP", false);
         _set("OMNITRACE_USE_OMPT", false);
@@ -1156,6 +2405,7 @@ configure_mode_settings(const std::shared_ptr<settings>& _config)
                                    "rocprofiler, and rocm_smi...\n");
 #endif
         _set("OMNITRACE_USE_ROCPROFILER", false);
+        _set("OMNITRACE_USE_PC_SAMPLING", false);
         _set("OMNITRACE_USE_ROCTRACER", false);
         _set("OMNITRACE_USE_ROCM_SMI", false);
     }
@@ -1192,6 +2442,7 @@ configure_mode_settings(const std::shared_ptr<settings>& _config)
         _set("OMNITRACE_USE_ROCM_SMI", false);
         _set("OMNITRACE_USE_ROCTRACER", false);
         _set("OMNITRACE_USE_ROCPROFILER", false);
+        _set("OMNITRACE_USE_PC_SAMPLING", false);
         _set("OMNITRACE_USE_KOKKOSP", false);
         _set("OMNITRACE_USE_RCCLP", false);
         _set("OMNITRACE_USE_OMPT", false);
@@ -1346,6 +2597,30 @@ std::set<int> get_sampling_signals(int64_t)
     return _v;
 }
 
+void
+configure_output_staging(const std::shared_ptr<settings>& _config)
+{
+    auto _dir =
+        staging::get_directory(_config->get<std::string>("OMNITRACE_OUTPUT_STAGING"),
+                               _config->get<std::string>("OMNITRACE_TMPDIR"));
+    if(_dir.empty() || !staging::get_root().empty()) return;
+
+    // the identifier of the drain process of omnitrace-run, if there is one
+    auto _id = get_env<std::string>(std::string{ staging::drain_env }, "", false);
+    if(_id.empty()) _id = std::to_string(process::get_id());
+
+    // the placeholders of the output path are expanded when the files are written
+    auto _output = settings::output_path();
+    if(_output.empty() || _output.front() != '/')
+        _output = JOIN('/', "%env{PWD}%", _output);
+
+    staging::get_root()     = staging::get_root(_dir, _id);
+    settings::output_path() = staging::get_root() + _output;
+
+    OMNITRACE_BASIC_VERBOSE(1, "Staging the output of '%s' in '%s'...\n",
+                            _output.c_str(), staging::get_root().c_str());
+}
+
 void
 configure_disabled_settings(const std::shared_ptr<settings>& _config)
 {
@@ -1378,6 +2653,7 @@ configure_disabled_settings(const std::shared_ptr<settings>& _config)
     _handle_use_option("OMNITRACE_USE_ROCM_SMI", "rocm_smi");
     _handle_use_option("OMNITRACE_USE_ROCTRACER", "roctracer");
     _handle_use_option("OMNITRACE_USE_ROCPROFILER", "rocprofiler");
+    _handle_use_option("OMNITRACE_USE_PC_SAMPLING", "pc_sampling");
 
 #if !defined(OMNITRACE_USE_ROCTRACER) || OMNITRACE_USE_ROCTRACER == 0
     _config->find("OMNITRACE_USE_ROCTRACER")->second->set_hidden(true);
@@ -1391,6 +2667,12 @@ configure_disabled_settings(const std::shared_ptr<settings>& _config)
         _config->find(itr)->second->set_hidden(true);
 #endif
 
+#if !defined(OMNITRACE_USE_ROCPROFILER_SDK) || OMNITRACE_USE_ROCPROFILER_SDK == 0
+    _config->find("OMNITRACE_USE_PC_SAMPLING")->second->set_hidden(true);
+    for(const auto& itr : _config->disable_category("pc_sampling"))
+        _config->find(itr)->second->set_hidden(true);
+#endif
+
 #if !defined(OMNITRACE_USE_ROCM_SMI) || OMNITRACE_USE_ROCM_SMI == 0
     _config->find("OMNITRACE_USE_ROCM_SMI")->second->set_hidden(true);
     for(const auto& itr : _config->disable_category("rocm_smi"))
@@ -1405,8 +2687,18 @@ configure_disabled_settings(const std::shared_ptr<settings>& _config)
 
 #if !defined(TIMEMORY_USE_MPI) || TIMEMORY_USE_MPI == 0
     _config->disable("OMNITRACE_PERFETTO_COMBINE_TRACES");
+    _config->disable("OMNITRACE_PERFETTO_CLOCK_SYNC");
+    _config->disable("OMNITRACE_PERFETTO_CLOCK_SYNC_ROUNDS");
+    _config->disable("OMNITRACE_MPI_WAIT_STATE");
+    _config->disable("OMNITRACE_MPI_WAIT_STATE_EAGER_LIMIT");
+    _config->disable("OMNITRACE_MPI_PVARS");
     _config->disable("OMNITRACE_COLLAPSE_PROCESSES");
     _config->find("OMNITRACE_PERFETTO_COMBINE_TRACES")->second->set_hidden(true);
+    _config->find("OMNITRACE_PERFETTO_CLOCK_SYNC")->second->set_hidden(true);
+    _config->find("OMNITRACE_PERFETTO_CLOCK_SYNC_ROUNDS")->second->set_hidden(true);
+    _config->find("OMNITRACE_MPI_WAIT_STATE")->second->set_hidden(true);
+    _config->find("OMNITRACE_MPI_WAIT_STATE_EAGER_LIMIT")->second->set_hidden(true);
+    _config->find("OMNITRACE_MPI_PVARS")->second->set_hidden(true);
     _config->find("OMNITRACE_COLLAPSE_PROCESSES")->second->set_hidden(true);
 #endif
 
@@ -1847,6 +3139,28 @@ get_use_timemory()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_profile_aggregate()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROFILE_AGGREGATE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_columnar_output()
+{
+    static auto _v = get_config()->find("OMNITRACE_COLUMNAR_OUTPUT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_timeline_profile_compact()
+{
+    static auto _v = get_config()->find("OMNITRACE_TIMELINE_PROFILE_COMPACT");
+    return get_config()->get_timeline_profile() &&
+           static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool&
 get_use_causal()
 {
@@ -1887,6 +3201,17 @@ get_use_rocprofiler()
 #endif
 }
 
+bool
+get_use_pc_sampling()
+{
+#if defined(OMNITRACE_USE_ROCPROFILER_SDK) && OMNITRACE_USE_ROCPROFILER_SDK > 0
+    static auto _v = get_config()->find("OMNITRACE_USE_PC_SAMPLING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
 bool
 get_use_rocm_smi()
 {
@@ -1969,6 +3294,41 @@ get_use_ompt()
 #endif
 }
 
+bool
+get_ompt_aggregate()
+{
+    static auto _v = get_config()->find("OMNITRACE_OMPT_AGGREGATE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_ompt_aggregate_sample_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_OMPT_AGGREGATE_SAMPLE_INTERVAL");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_ompt_barrier_analysis()
+{
+    static auto _v = get_config()->find("OMNITRACE_OMPT_BARRIER_ANALYSIS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_ompt_device_tracing()
+{
+    static auto _v = get_config()->find("OMNITRACE_OMPT_DEVICE_TRACING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_ompt_device_buffer_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_OMPT_DEVICE_BUFFER_SIZE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 bool
 get_use_code_coverage()
 {
@@ -1983,6 +3343,48 @@ get_use_rcclp()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+double
+get_comm_data_resolution()
+{
+    static auto _v = get_config()->find("OMNITRACE_COMM_DATA_RESOLUTION");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_use_comm_histogram()
+{
+    static auto _v = get_config()->find("OMNITRACE_COMM_HISTOGRAM");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_mpi_wait_state()
+{
+    static auto _v = get_config()->find("OMNITRACE_MPI_WAIT_STATE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_mpi_wait_state_eager_limit()
+{
+    static auto _v = get_config()->find("OMNITRACE_MPI_WAIT_STATE_EAGER_LIMIT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+std::string
+get_mpi_pvars()
+{
+    static auto _v = get_config()->find("OMNITRACE_MPI_PVARS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_mpi_ranks()
+{
+    static auto _v = get_config()->find("OMNITRACE_MPI_RANKS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
 size_t
 get_num_threads_hint()
 {
@@ -2071,6 +3473,24 @@ get_perfetto_combined_traces()
 #endif
 }
 
+bool
+get_perfetto_clock_sync()
+{
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_CLOCK_SYNC");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
+size_t
+get_perfetto_clock_sync_rounds()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_CLOCK_SYNC_ROUNDS");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 std::string
 get_perfetto_fill_policy()
 {
@@ -2078,6 +3498,83 @@ get_perfetto_fill_policy()
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
+bool
+get_perfetto_streaming()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_STREAMING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_flush_period()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_FLUSH_PERIOD");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_perfetto_auto_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_AUTO_SIZE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_perfetto_auto_size_warmup()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_AUTO_SIZE_WARMUP");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_auto_size_max()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_AUTO_SIZE_MAX_KB");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+double
+get_perfetto_auto_size_drop_rate()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_AUTO_SIZE_DROP_RATE");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_use_flight_recorder()
+{
+    static auto _v = get_config()->find("OMNITRACE_FLIGHT_RECORDER");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+int
+get_flight_recorder_signal()
+{
+    static auto _v = get_config()->find("OMNITRACE_FLIGHT_RECORDER_SIGNAL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+bool
+get_emergency_dump()
+{
+    static auto _v = get_config()->find("OMNITRACE_EMERGENCY_DUMP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_flight_recorder_latency_threshold()
+{
+    static auto _v = get_config()->find("OMNITRACE_FLIGHT_RECORDER_LATENCY_THRESHOLD");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+double
+get_flight_recorder_window()
+{
+    static auto _v = get_config()->find("OMNITRACE_FLIGHT_RECORDER_WINDOW");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
 namespace
 {
 auto
@@ -2155,6 +3652,20 @@ get_perfetto_annotations()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_perfetto_deferred_regions()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_DEFERRED_REGIONS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_deferred_buffer_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_DEFERRED_BUFFER_SIZE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 uint64_t
 get_thread_pool_size()
 {
@@ -2162,6 +3673,27 @@ get_thread_pool_size()
     return _v;
 }
 
+std::string
+get_background_cpus()
+{
+    static auto _v = get_config()->find("OMNITRACE_BACKGROUND_CPUS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+int
+get_background_nice()
+{
+    static auto _v = get_config()->find("OMNITRACE_BACKGROUND_NICE");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+bool
+get_parallel_finalize()
+{
+    static auto _v = get_config()->find("OMNITRACE_PARALLEL_FINALIZE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 std::string
 get_trace_hsa_api_types()
 {
@@ -2326,38 +3858,434 @@ get_sampling_allocator_size()
     return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
 }
 
-double
-get_process_sampling_freq()
+bool
+get_sampling_offload_per_thread()
 {
-    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_FREQ");
-    auto        _val =
-        std::min<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(), 1000.0);
-    if(_val < 1.0e-9) return std::min<double>(get_sampling_freq(), 100.0);
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OFFLOAD_PER_THREAD");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_streaming()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_STREAMING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 double
-get_process_sampling_duration()
+get_sampling_snapshot_interval()
 {
-    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_DURATION");
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_SNAPSHOT_INTERVAL");
     return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
-std::string
-get_sampling_gpus()
+bool
+get_sampling_parallel_post_process()
 {
-#if defined(OMNITRACE_USE_ROCM_SMI) && OMNITRACE_USE_ROCM_SMI > 0
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_GPUS");
-    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
-#else
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PARALLEL_POST_PROCESS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_deferred_symbols()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_DEFERRED_SYMBOLS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_raw_output()
+{
+    static auto _v = get_config()->find("OMNITRACE_RAW_OUTPUT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_coverage()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_COVERAGE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_shared_unwind_tables()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_SHARED_UNWIND_TABLES");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+SamplingUnwinder
+get_sampling_unwinder()
+{
+    static auto _m = std::unordered_map<std::string_view, SamplingUnwinder>{
+        { "libunwind", SamplingUnwinder::LibUnwind },
+        { "frame-pointer", SamplingUnwinder::FramePointer },
+        { "auto", SamplingUnwinder::Auto },
+    };
+
+    auto _v    = get_config()->find("OMNITRACE_SAMPLING_UNWINDER");
+    auto _mode = static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+    auto itr   = _m.find(_mode);
+    if(itr == _m.end())
+    {
+        OMNITRACE_THROW("[%s] invalid sampling unwinder %s. Choices: %s\n", __FUNCTION__,
+                        _mode.c_str(),
+                        timemory::join::join(timemory::join::array_config{ ", ", "", "" },
+                                             _v->second->get_choices())
+                            .c_str());
+    }
+    return itr->second;
+}
+
+bool
+get_sampling_aggregate()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_AGGREGATE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_aggregate_table_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_AGGREGATE_TABLE_SIZE");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+size_t
+get_sampling_aggregate_checkpoint()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_AGGREGATE_CHECKPOINT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_sampling_python()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PYTHON");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_python_buffer_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PYTHON_BUFFER_SIZE");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+bool
+get_python_gil()
+{
+    static auto _v = get_config()->find("OMNITRACE_PYTHON_GIL");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_perf_events()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERF_EVENTS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_perf_events_regions()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERF_EVENTS_REGIONS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_perf_events_group_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERF_EVENTS_GROUP_SIZE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+double
+get_perf_events_rotation_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERF_EVENTS_ROTATION_INTERVAL");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_fork_child_capture()
+{
+    static auto _v = get_config()->find("OMNITRACE_FORK_CHILD_CAPTURE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_fork_child_capture_samples()
+{
+    static auto _v = get_config()->find("OMNITRACE_FORK_CHILD_CAPTURE_SAMPLES");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_sampling_perf_backend()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PERF_BACKEND");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_perf_buffer_pages()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PERF_BUFFER_PAGES");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+bool
+get_sampling_perf_metrics()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PERF_METRICS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_peak_rss_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PEAK_RSS_INTERVAL");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+std::string
+get_sampling_region_rates()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_REGION_RATES");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_sampling_thread_group()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_THREAD_GROUP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_sampling_thread_group_rate()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_THREAD_GROUP_RATE");
+    return std::max<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(),
+                            1.0);
+}
+
+bool
+get_sampling_collapse_gpu_wait()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_COLLAPSE_GPU_WAIT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_offcpu()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OFFCPU");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_numa_locality()
+{
+    static auto _v = get_config()->find("OMNITRACE_NUMA_LOCALITY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_numa_locality_event()
+{
+    static auto _v = get_config()->find("OMNITRACE_NUMA_LOCALITY_EVENT");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+size_t
+get_numa_locality_period()
+{
+    static auto _v = get_config()->find("OMNITRACE_NUMA_LOCALITY_PERIOD");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+bool
+get_sampling_branch_stack()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_BRANCH_STACK");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_sampling_branch_event()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_BRANCH_EVENT");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_branch_period()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_BRANCH_PERIOD");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+double
+get_sampling_overhead_target()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OVERHEAD_TARGET");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+std::string
+get_calibration_file()
+{
+    static auto _v = get_config()->find("OMNITRACE_CALIBRATION_FILE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_sampling_numa_allocators()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_NUMA_ALLOCATORS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_compact_offload()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_COMPACT_OFFLOAD");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_process_sampling_freq()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_FREQ");
+    auto        _val =
+        std::min<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(), 1000.0);
+    if(_val < 1.0e-9) return std::min<double>(get_sampling_freq(), 100.0);
+    return _val;
+}
+
+double
+get_process_sampling_duration()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_DURATION");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+double
+get_process_sampling_retention()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_RETENTION");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_energy()
+{
+    static auto _v = get_config()->find("OMNITRACE_ENERGY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_energy_cpu_source()
+{
+    static auto _v = get_config()->find("OMNITRACE_ENERGY_CPU_SOURCE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_gpu_attribution()
+{
+    static auto _v = get_config()->find("OMNITRACE_GPU_ATTRIBUTION");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_memory_bandwidth()
+{
+    static auto _v = get_config()->find("OMNITRACE_MEMORY_BANDWIDTH");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_memory_bandwidth_events()
+{
+    static auto _v = get_config()->find("OMNITRACE_MEMORY_BANDWIDTH_EVENTS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_live_export()
+{
+    static auto _v = get_config()->find("OMNITRACE_LIVE_EXPORT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_live_export_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_LIVE_EXPORT_INTERVAL");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+std::string
+get_live_export_name()
+{
+    static auto _v = get_config()->find("OMNITRACE_LIVE_EXPORT_NAME");
+    return settings::format(static_cast<tim::tsettings<std::string>&>(*_v->second).get(),
+                            get_config()->get_tag());
+}
+
+bool
+get_memory_footprint()
+{
+    static auto _v = get_config()->find("OMNITRACE_MEMORY_FOOTPRINT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_memory_footprint_budget()
+{
+    static auto _v = get_config()->find("OMNITRACE_MEMORY_FOOTPRINT_BUDGET");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_sampling_gpus()
+{
+#if defined(OMNITRACE_USE_ROCM_SMI) && OMNITRACE_USE_ROCM_SMI > 0
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_GPUS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+#else
     return std::string{};
 #endif
 }
 
 bool
-get_trace_thread_locks()
+get_trace_thread_locks()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+uint64_t
+get_trace_thread_locks_contention_ns()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS_CONTENTION_NS");
+    return static_cast<tim::tsettings<uint64_t>&>(*_v->second).get();
+}
+
+size_t
+get_trace_thread_locks_sample_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS_SAMPLE_INTERVAL");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+bool
+get_trace_thread_locks_profile()
 {
-    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS");
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS_PROFILE");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
@@ -2368,6 +4296,55 @@ get_rocm_events()
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
+std::string
+get_rocm_events_mode()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_MODE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_pc_sampling_method()
+{
+    static auto _v = get_config()->find("OMNITRACE_PC_SAMPLING_METHOD");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+size_t
+get_pc_sampling_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_PC_SAMPLING_INTERVAL");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_hip_graphs()
+{
+    static auto _v = get_config()->find("OMNITRACE_HIP_GRAPHS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_kernel_launch_latency()
+{
+    static auto _v = get_config()->find("OMNITRACE_KERNEL_LAUNCH_LATENCY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_memcpy_analysis()
+{
+    static auto _v = get_config()->find("OMNITRACE_MEMCPY_ANALYSIS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_rocm_roofline()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCM_ROOFLINE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool
 get_trace_thread_rwlocks()
 {
@@ -2396,6 +4373,134 @@ get_trace_thread_join()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_lazy_thread_setup()
+{
+    static auto _v = get_config()->find("OMNITRACE_LAZY_THREAD_SETUP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_heap_profile()
+{
+    static auto _v = get_config()->find("OMNITRACE_HEAP_PROFILE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_heap_profile_sample_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_HEAP_PROFILE_SAMPLE_INTERVAL");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+bool
+get_io_trace()
+{
+    static auto _v = get_config()->find("OMNITRACE_IO_TRACE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+uint64_t
+get_io_trace_threshold_ns()
+{
+    static auto _v = get_config()->find("OMNITRACE_IO_TRACE_THRESHOLD_NS");
+    return static_cast<tim::tsettings<uint64_t>&>(*_v->second).get();
+}
+
+bool
+get_critical_path()
+{
+    static auto _v = get_config()->find("OMNITRACE_CRITICAL_PATH");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_rcclp_device_timing()
+{
+    static auto _v = get_config()->find("OMNITRACE_RCCLP_DEVICE_TIMING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_gpu_memory_tracking()
+{
+    static auto _v = get_config()->find("OMNITRACE_GPU_MEMORY_TRACKING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_throttle_count()
+{
+    static auto _v = get_config()->find("OMNITRACE_THROTTLE_COUNT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_throttle_per_call_ns()
+{
+    static auto _v = get_config()->find("OMNITRACE_THROTTLE_PER_CALL_NS");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_use_compiler_instrumentation()
+{
+    static auto _v = get_config()->find("OMNITRACE_COMPILER_INSTRUMENTATION");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::vector<std::string>
+get_compiler_instrumentation_include()
+{
+    static auto _v = get_config()->find("OMNITRACE_COMPILER_INSTRUMENTATION_INCLUDE");
+    return tim::delimit(static_cast<tim::tsettings<std::string>&>(*_v->second).get(),
+                        "\t\"';");
+}
+
+std::vector<std::string>
+get_compiler_instrumentation_exclude()
+{
+    static auto _v = get_config()->find("OMNITRACE_COMPILER_INSTRUMENTATION_EXCLUDE");
+    return tim::delimit(static_cast<tim::tsettings<std::string>&>(*_v->second).get(),
+                        "\t\"';");
+}
+
+bool
+get_use_tsc_clock()
+{
+    static auto _v = get_config()->find("OMNITRACE_TSC_CLOCK");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_tsc_clock_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_TSC_CLOCK_INTERVAL");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_fast_start()
+{
+    static auto _v = get_config()->find("OMNITRACE_FAST_START");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_self_profile()
+{
+    static auto _v = get_config()->find("OMNITRACE_SELF_PROFILE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_huge_pages()
+{
+    static auto _v = get_config()->find("OMNITRACE_HUGE_PAGES");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool
 get_debug_tid()
 {
@@ -2430,6 +4535,41 @@ get_tmpdir()
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
+std::string
+get_tmp_backend()
+{
+    static auto _v = get_config()->find("OMNITRACE_TMP_BACKEND");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_tmp_seal()
+{
+    static auto _v = get_config()->find("OMNITRACE_TMP_SEAL");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_output_compression()
+{
+    static auto _v = get_config()->find("OMNITRACE_OUTPUT_COMPRESSION");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+int
+get_output_compression_level()
+{
+    static auto _v = get_config()->find("OMNITRACE_OUTPUT_COMPRESSION_LEVEL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+std::string
+get_output_staging()
+{
+    static auto _v = get_config()->find("OMNITRACE_OUTPUT_STAGING");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
 tmp_file::tmp_file(std::string _v)
 : filename{ std::move(_v) }
 {}
@@ -2501,6 +4641,13 @@ tmp_file::flush()
 bool
 tmp_file::close()
 {
+    if(mapped)
+    {
+        munmap(mapped, mapped_size);
+        mapped      = nullptr;
+        mapped_size = 0;
+    }
+
     flush();
 
     if(stream.is_open())
@@ -2526,7 +4673,15 @@ bool
 tmp_file::remove()
 {
     close();
-    if(filepath::exists(filename))
+    if(memfd >= 0)
+    {
+        // the anonymous file is released with its last descriptor
+        OMNITRACE_BASIC_VERBOSE(2, "Removing temporary file '%s'...\n", filename.c_str());
+        auto _ret = ::close(memfd);
+        memfd     = -1;
+        return (_ret == 0);
+    }
+    else if(filepath::exists(filename))
     {
         OMNITRACE_BASIC_VERBOSE(2, "Removing temporary file '%s'...\n", filename.c_str());
         auto _ret = ::remove(filename.c_str());
@@ -2536,6 +4691,40 @@ tmp_file::remove()
     return true;
 }
 
+std::pair<const char*, size_t>
+tmp_file::map()
+{
+    if(mapped) return { static_cast<const char*>(mapped), mapped_size };
+
+    flush();
+
+    int _fd = (memfd >= 0) ? memfd : ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if(_fd < 0) return { nullptr, 0 };
+
+#if defined(F_ADD_SEALS)
+    if(memfd >= 0 && get_tmp_seal() &&
+       fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) != 0)
+        OMNITRACE_BASIC_VERBOSE(1, "Sealing temporary file '%s' failed: %s\n",
+                                filename.c_str(), strerror(errno));
+#endif
+
+    struct stat _stat = {};
+    if(fstat(_fd, &_stat) == 0 && _stat.st_size > 0)
+    {
+        auto  _size = static_cast<size_t>(_stat.st_size);
+        auto* _addr = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+        if(_addr != MAP_FAILED)
+        {
+            mapped      = _addr;
+            mapped_size = _size;
+        }
+    }
+
+    if(_fd != memfd) ::close(_fd);
+
+    return { static_cast<const char*>(mapped), mapped_size };
+}
+
 tmp_file::operator bool() const
 {
     return (stream.is_open() && stream.good()) || (file != nullptr && fd > 0);
@@ -2582,6 +4771,30 @@ get_tmp_file(std::string _basename, std::string _ext)
     if(itr != _existing_files.end()) return itr->second;
 
     auto _v = std::make_shared<tmp_file>(_fname);
+    if(get_tmp_backend() == "memfd")
+    {
+#if defined(MFD_CLOEXEC) && defined(MFD_ALLOW_SEALING)
+        // the name is only shown in /proc/<pid>/fd. The streams open the file through
+        // its descriptor in /proc/self/fd
+        auto _name = _fname.substr(_fname.find_last_of('/') + 1);
+        auto _fd   = memfd_create(_name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+        int _fd = -1;
+        errno   = ENOSYS;
+#endif
+        if(_fd >= 0)
+        {
+            _v->memfd    = _fd;
+            _v->filename = JOIN('/', "/proc/self/fd", _fd);
+        }
+        else
+        {
+            OMNITRACE_BASIC_VERBOSE(0,
+                                    "Warning! memfd_create failed (%s), temporary file "
+                                    "'%s' is created in OMNITRACE_TMPDIR\n",
+                                    strerror(errno), _fname.c_str());
+        }
+    }
     _existing_files.emplace(_fname, std::move(_v));
     return _existing_files.at(_fname);
 }
@@ -2617,15 +4830,17 @@ get_causal_mode()
     if(!settings_are_configured())
     {
         auto _mode = tim::get_env_choice<std::string>("OMNITRACE_CAUSAL_MODE", "function",
-                                                      { "line", "function" });
+                                                      { "line", "function", "kernel" });
         if(_mode == "line") return CausalMode::Line;
+        if(_mode == "kernel") return CausalMode::Kernel;
         return CausalMode::Function;
     }
     static auto _causal_mode = []() {
         auto _m = std::unordered_map<std::string_view, CausalMode>{
             { "line", CausalMode::Line },
             { "func", CausalMode::Function },
-            { "function", CausalMode::Function }
+            { "function", CausalMode::Function },
+            { "kernel", CausalMode::Kernel }
         };
         auto _v = get_config()->find("OMNITRACE_CAUSAL_MODE");
         try
@@ -2652,6 +4867,77 @@ get_causal_end_to_end()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+uint64_t
+get_causal_delay_spin_ns()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_DELAY_SPIN_NS");
+    return static_cast<tim::tsettings<uint64_t>&>(*_v->second).get();
+}
+
+bool
+get_causal_adaptive()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_ADAPTIVE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_causal_adaptive_tolerance()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+size_t
+get_causal_adaptive_min_experiments()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_ADAPTIVE_MIN_EXPERIMENTS");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+std::string
+get_causal_adaptive_status()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_ADAPTIVE_STATUS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_causal_log()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_LOG");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_causal_log_export()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_LOG_EXPORT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_causal_num_workers()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_NUM_WORKERS");
+    auto        _n = static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+    return std::max<size_t>(_n, 1) * std::max<int>(dmp::size(), 1);
+}
+
+size_t
+get_causal_worker_id()
+{
+    static auto _v  = get_config()->find("OMNITRACE_CAUSAL_WORKER_ID");
+    static auto _nv = get_config()->find("OMNITRACE_CAUSAL_NUM_WORKERS");
+    auto        _id = static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+    auto        _n  = static_cast<tim::tsettings<size_t>&>(*_nv->second).get();
+    OMNITRACE_CONDITIONAL_THROW(_id >= std::max<size_t>(_n, 1),
+                                "Error! OMNITRACE_CAUSAL_WORKER_ID (%zu) must be less "
+                                "than OMNITRACE_CAUSAL_NUM_WORKERS (%zu)",
+                                _id, _n);
+    return (_id * std::max<int>(dmp::size(), 1)) + std::max<int>(dmp::rank(), 0);
+}
+
 std::vector<int64_t>
 get_causal_fixed_speedup()
 {
@@ -2756,5 +5042,120 @@ get_causal_function_exclude()
     return tim::delimit(static_cast<tim::tsettings<std::string>&>(*_v->second).get(),
                         "\t\"';");
 }
+
+bool
+get_binary_cache()
+{
+    static auto _v = get_config()->find("OMNITRACE_BINARY_CACHE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_binary_cache_dir()
+{
+    static auto _v    = get_config()->find("OMNITRACE_BINARY_CACHE_DIR");
+    auto        _path = static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+    if(!_path.empty()) return _path;
+
+    auto _base = get_env<std::string>("XDG_CACHE_HOME", "");
+    if(_base.empty())
+    {
+        auto _home = get_env<std::string>("HOME", "");
+        if(_home.empty()) return std::string{};
+        _base = JOIN('/', _home, ".cache");
+    }
+    return JOIN('/', _base, "omnitrace", "binary-info");
+}
+
+size_t
+get_binary_analysis_threads()
+{
+    static auto _v = get_config()->find("OMNITRACE_BINARY_ANALYSIS_THREADS");
+    auto _n = static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+    return (_n == 0) ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : _n;
+}
+
+void
+update_snapshot()
+{
+    if(!settings_are_configured()) return;
+
+    static auto _mutex     = std::mutex{};
+    static auto _snapshots = std::vector<std::unique_ptr<snapshot>>{};
+
+    auto _lk = std::unique_lock<std::mutex>{ _mutex };
+    auto _v  = std::make_unique<snapshot>();
+
+    _v->generation                 = _snapshots.size() + 1;
+    _v->use_tmp_files              = get_use_tmp_files();
+    _v->sampling_streaming         = get_sampling_streaming();
+    _v->sampling_compact_offload   = get_sampling_compact_offload();
+    _v->sampling_collapse_gpu_wait = get_sampling_collapse_gpu_wait();
+    _v->sampling_numa_allocators   = get_sampling_numa_allocators();
+    _v->sampling_allocator_size    = get_sampling_allocator_size();
+    _v->sampling_unwinder          = get_sampling_unwinder();
+    _v->sampling_region_rates      = get_use_sampling() &&
+                                     !get_sampling_region_rates().empty();
+    _v->use_comm_histogram         = get_use_comm_histogram();
+    _v->comm_data_resolution       = get_comm_data_resolution();
+    _v->self_profile               = get_self_profile();
+
+    _v->trace_thread_locks_contention_ns    = get_trace_thread_locks_contention_ns();
+    _v->trace_thread_locks_sample_interval  = get_trace_thread_locks_sample_interval();
+    _v->trace_thread_locks_profile          = get_trace_thread_locks_profile();
+    _v->causal_delay_spin_ns                = get_causal_delay_spin_ns();
+    _v->causal_progress_points              = get_use_causal() &&
+                                              !get_causal_end_to_end();
+    _v->causal_kernels                      = get_use_causal() &&
+                                              get_causal_mode() == CausalMode::Kernel;
+    _v->ompt_aggregate                      = get_ompt_aggregate();
+    _v->ompt_aggregate_sample_interval      = get_ompt_aggregate_sample_interval();
+    _v->perf_events_regions                 = get_perf_events_regions();
+    _v->lazy_thread_setup                   = get_lazy_thread_setup();
+    _v->heap_profile                        = get_heap_profile();
+    _v->heap_profile_sample_interval        = get_heap_profile_sample_interval();
+    _v->io_trace                            = get_io_trace();
+    _v->io_trace_threshold_ns               = get_io_trace_threshold_ns();
+    _v->critical_path                       = get_critical_path();
+    _v->energy                              = get_energy() && get_use_process_sampling();
+    _v->gpu_attribution                     = get_gpu_attribution() &&
+                                              get_use_process_sampling();
+    _v->memory_bandwidth                    = get_memory_bandwidth() &&
+                                              get_use_process_sampling();
+    _v->mpi_pvars                           = !get_mpi_pvars().empty() &&
+                                              get_use_process_sampling();
+    _v->region_attribution                  = _v->energy || _v->memory_bandwidth ||
+                                              _v->mpi_pvars;
+    _v->live_export                         = get_live_export() &&
+                                              get_use_process_sampling();
+    _v->memory_footprint                    = get_memory_footprint() &&
+                                              get_use_process_sampling();
+    _v->rcclp_device_timing                 = get_rcclp_device_timing();
+    _v->gpu_memory_tracking                 = get_gpu_memory_tracking();
+    _v->hip_graphs                          = get_hip_graphs();
+    _v->kernel_launch_latency               = get_kernel_launch_latency();
+    _v->memcpy_analysis                     = get_memcpy_analysis();
+    _v->rocm_roofline                       = get_use_rocprofiler() &&
+                                              get_rocm_roofline();
+    _v->timeline_profile_compact            = get_timeline_profile_compact();
+    _v->perfetto_deferred_regions           = get_perfetto_deferred_regions();
+
+    debug::log_flags::set(get_debug(), get_verbose(), get_is_continuous_integration());
+
+    // the roctracer settings are not registered in every configuration
+    auto _get_bool = [](const char* _name) {
+        return get_setting_value<bool>(_name).value_or(false);
+    };
+    _v->roctracer_aggregate         = _get_bool("OMNITRACE_ROCTRACER_AGGREGATE");
+    _v->roctracer_discard_barriers  = _get_bool("OMNITRACE_ROCTRACER_DISCARD_BARRIERS");
+    _v->roctracer_hip_api_backtrace = _get_bool("OMNITRACE_ROCTRACER_HIP_API_BACKTRACE");
+    _v->perfetto_compact_roctracer_annotations =
+        _get_bool("OMNITRACE_PERFETTO_COMPACT_ROCTRACER_ANNOTATIONS");
+    _v->perfetto_deferred_roctracer_annotations =
+        _get_bool("OMNITRACE_PERFETTO_DEFERRED_ROCTRACER_ANNOTATIONS");
+
+    get_snapshot_pointer().store(_v.get(), std::memory_order_release);
+    _snapshots.emplace_back(std::move(_v));
+}
 }  // namespace config
 }  // namespace omnitrace
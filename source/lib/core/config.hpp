@@ -23,6 +23,7 @@
 #pragma once
 
 #include "common.hpp"
+#include "config_snapshot.hpp"
 #include "defines.hpp"
 #include "state.hpp"
 #include "timemory.hpp"
@@ -34,6 +35,7 @@
 #include <string>
 #include <string_view>
 #include <unordered_set>
+#include <utility>
 
 namespace omnitrace
 {
@@ -63,6 +65,9 @@ configure_signal_handler(const std::shared_ptr<settings>&);
 void
 configure_disabled_settings(const std::shared_ptr<settings>&);
 
+void
+configure_output_staging(const std::shared_ptr<settings>&);
+
 int
 get_sampling_overflow_signal();
 
@@ -112,6 +117,7 @@ set_setting_value(const std::string& _name, Tp&& _v)
     auto  _upd     = itr->set_user_updated();
     auto  _success = itr->set(std::forward<Tp>(_v), _user_upd);
     if(!_success) itr->set_updated(_upd);
+    if(_success) update_snapshot();
     return _success;
 }
 
@@ -125,7 +131,9 @@ set_default_setting_value(const std::string& _name, Tp&& _v)
     if(!_setting->second) return false;
     if(_setting->second->get_config_updated() || _setting->second->get_environ_updated())
         return false;
-    return _setting->second->set(std::forward<Tp>(_v));
+    auto _success = _setting->second->set(std::forward<Tp>(_v));
+    if(_success) update_snapshot();
+    return _success;
 }
 
 template <typename Tp>
@@ -191,6 +199,15 @@ get_use_perfetto() OMNITRACE_HOT;
 bool&
 get_use_timemory() OMNITRACE_HOT;
 
+bool
+get_profile_aggregate();
+
+bool
+get_timeline_profile_compact();
+
+bool
+get_columnar_output();
+
 bool&
 get_use_causal() OMNITRACE_HOT;
 
@@ -200,6 +217,9 @@ get_use_roctracer() OMNITRACE_HOT;
 bool
 get_use_rocprofiler() OMNITRACE_HOT;
 
+bool
+get_use_pc_sampling();
+
 bool
 get_use_rocm_smi() OMNITRACE_HOT;
 
@@ -227,6 +247,21 @@ get_use_kokkosp_kernel_logger();
 bool
 get_use_ompt();
 
+bool
+get_ompt_aggregate();
+
+size_t
+get_ompt_aggregate_sample_interval();
+
+bool
+get_ompt_barrier_analysis();
+
+bool
+get_ompt_device_tracing();
+
+size_t
+get_ompt_device_buffer_size();
+
 bool
 get_use_code_coverage();
 
@@ -236,6 +271,24 @@ get_sampling_keep_internal();
 bool
 get_use_rcclp();
 
+double
+get_comm_data_resolution();
+
+bool
+get_use_comm_histogram();
+
+bool
+get_mpi_wait_state();
+
+size_t
+get_mpi_wait_state_eager_limit();
+
+std::string
+get_mpi_pvars();
+
+std::string
+get_mpi_ranks();
+
 bool
 get_trace_hip_api();
 
@@ -257,9 +310,48 @@ get_perfetto_buffer_size();
 bool
 get_perfetto_combined_traces();
 
+bool
+get_perfetto_clock_sync();
+
+size_t
+get_perfetto_clock_sync_rounds();
+
 std::string
 get_perfetto_fill_policy();
 
+bool
+get_perfetto_streaming();
+
+size_t
+get_perfetto_flush_period();
+
+bool
+get_perfetto_auto_size();
+
+double
+get_perfetto_auto_size_warmup();
+
+size_t
+get_perfetto_auto_size_max();
+
+double
+get_perfetto_auto_size_drop_rate();
+
+bool
+get_use_flight_recorder();
+
+int
+get_flight_recorder_signal();
+
+bool
+get_emergency_dump();
+
+double
+get_flight_recorder_latency_threshold();
+
+double
+get_flight_recorder_window();
+
 std::set<std::string>
 get_enabled_categories();
 
@@ -269,9 +361,24 @@ get_disabled_categories();
 bool
 get_perfetto_annotations() OMNITRACE_HOT;
 
+bool
+get_perfetto_deferred_regions();
+
+size_t
+get_perfetto_deferred_buffer_size();
+
 uint64_t
 get_thread_pool_size();
 
+std::string
+get_background_cpus();
+
+int
+get_background_nice();
+
+bool
+get_parallel_finalize();
+
 std::string
 get_trace_hsa_api_types();
 
@@ -336,18 +443,180 @@ get_num_threads_hint();
 size_t
 get_sampling_allocator_size();
 
+bool
+get_sampling_offload_per_thread();
+
+bool
+get_sampling_streaming();
+
+double
+get_sampling_snapshot_interval();
+
+bool
+get_sampling_parallel_post_process();
+
+bool
+get_sampling_deferred_symbols();
+
+bool
+get_raw_output();
+
+bool
+get_sampling_coverage();
+
+SamplingUnwinder
+get_sampling_unwinder();
+
+bool
+get_sampling_shared_unwind_tables();
+
+bool
+get_sampling_aggregate();
+
+size_t
+get_sampling_aggregate_table_size();
+
+size_t
+get_sampling_aggregate_checkpoint();
+
+bool
+get_sampling_python();
+
+size_t
+get_sampling_python_buffer_size();
+
+bool
+get_python_gil();
+
+std::string
+get_perf_events();
+
+bool
+get_perf_events_regions();
+
+size_t
+get_perf_events_group_size();
+
+double
+get_perf_events_rotation_interval();
+
+bool
+get_fork_child_capture();
+
+size_t
+get_fork_child_capture_samples();
+
+bool
+get_sampling_perf_backend();
+
+size_t
+get_sampling_perf_buffer_pages();
+
+bool
+get_sampling_perf_metrics();
+
+size_t
+get_sampling_peak_rss_interval();
+
+std::string
+get_sampling_region_rates();
+
+bool
+get_sampling_thread_group();
+
+double
+get_sampling_thread_group_rate();
+
+bool
+get_sampling_collapse_gpu_wait();
+
+bool
+get_sampling_offcpu();
+
+bool
+get_numa_locality();
+
+std::string
+get_numa_locality_event();
+
+size_t
+get_numa_locality_period();
+
+bool
+get_sampling_branch_stack();
+
+std::string
+get_sampling_branch_event();
+
+size_t
+get_sampling_branch_period();
+
+double
+get_sampling_overhead_target();
+
+std::string
+get_calibration_file();
+
+bool
+get_sampling_numa_allocators();
+
+bool
+get_sampling_compact_offload();
+
 double
 get_process_sampling_freq();
 
 double
 get_process_sampling_duration();
 
+double
+get_process_sampling_retention();
+
+bool
+get_energy();
+
+std::string
+get_energy_cpu_source();
+
+bool
+get_gpu_attribution();
+
+bool
+get_memory_bandwidth();
+
+std::string
+get_memory_bandwidth_events();
+
+bool
+get_live_export();
+
+double
+get_live_export_interval();
+
+std::string
+get_live_export_name();
+
+bool
+get_memory_footprint();
+
+std::string
+get_memory_footprint_budget();
+
 std::string
 get_sampling_gpus();
 
 bool
 get_trace_thread_locks();
 
+uint64_t
+get_trace_thread_locks_contention_ns();
+
+size_t
+get_trace_thread_locks_sample_interval();
+
+bool
+get_trace_thread_locks_profile();
+
 bool
 get_trace_thread_rwlocks();
 
@@ -360,15 +629,105 @@ get_trace_thread_barriers();
 bool
 get_trace_thread_join();
 
+bool
+get_lazy_thread_setup();
+
+bool
+get_heap_profile();
+
+size_t
+get_heap_profile_sample_interval();
+
+bool
+get_io_trace();
+
+uint64_t
+get_io_trace_threshold_ns();
+
+bool
+get_critical_path();
+
+bool
+get_rcclp_device_timing();
+
+bool
+get_gpu_memory_tracking();
+
+size_t
+get_throttle_count();
+
+size_t
+get_throttle_per_call_ns();
+
+bool
+get_use_compiler_instrumentation();
+
+std::vector<std::string>
+get_compiler_instrumentation_include();
+
+std::vector<std::string>
+get_compiler_instrumentation_exclude();
+
+bool
+get_use_tsc_clock();
+
+double
+get_tsc_clock_interval();
+
+bool
+get_fast_start();
+
+bool
+get_self_profile();
+
+bool
+get_use_huge_pages();
+
 std::string
 get_rocm_events();
 
+std::string
+get_rocm_events_mode();
+
+std::string
+get_pc_sampling_method();
+
+size_t
+get_pc_sampling_interval();
+
+bool
+get_hip_graphs();
+
+bool
+get_kernel_launch_latency();
+
+bool
+get_memcpy_analysis();
+
+bool
+get_rocm_roofline();
+
 bool
 get_use_tmp_files();
 
 std::string
 get_tmpdir();
 
+std::string
+get_tmp_backend();
+
+bool
+get_tmp_seal();
+
+std::string
+get_output_staging();
+
+std::string
+get_output_compression();
+
+int
+get_output_compression_level();
+
 struct tmp_file
 {
     tmp_file(std::string);
@@ -380,12 +739,19 @@ struct tmp_file
     bool close();
     bool remove();
 
+    /// maps the contents read-only so they can be read back without a copy and, with
+    /// OMNITRACE_TMP_SEAL, seals an anonymous file against writes. Unmapped by close()
+    std::pair<const char*, size_t> map();
+
     explicit operator bool() const;
 
-    std::string  filename = {};
-    std::fstream stream   = {};
-    FILE*        file     = nullptr;
-    int          fd       = -1;
+    std::string  filename    = {};  ///< /proc/self/fd/<memfd> for an anonymous file
+    std::fstream stream      = {};
+    FILE*        file        = nullptr;
+    int          fd          = -1;
+    int          memfd       = -1;  ///< OMNITRACE_TMP_BACKEND=memfd
+    void*        mapped      = nullptr;
+    size_t       mapped_size = 0;
 };
 
 std::shared_ptr<tmp_file>
@@ -400,6 +766,36 @@ get_causal_mode();
 bool
 get_causal_end_to_end();
 
+uint64_t
+get_causal_delay_spin_ns();
+
+bool
+get_causal_adaptive();
+
+double
+get_causal_adaptive_tolerance();
+
+size_t
+get_causal_adaptive_min_experiments();
+
+std::string
+get_causal_adaptive_status();
+
+bool
+get_causal_log();
+
+bool
+get_causal_log_export();
+
+/// total number of workers sharing the causal experiments, i.e. the product of
+/// OMNITRACE_CAUSAL_NUM_WORKERS and the number of MPI ranks
+size_t
+get_causal_num_workers();
+
+/// index of this process in [0, get_causal_num_workers())
+size_t
+get_causal_worker_id();
+
 std::vector<int64_t>
 get_causal_fixed_speedup();
 
@@ -423,5 +819,16 @@ get_causal_source_exclude();
 
 std::vector<std::string>
 get_causal_function_exclude();
+
+bool
+get_binary_cache();
+
+/// empty if there is no suitable directory
+std::string
+get_binary_cache_dir();
+
+/// resolves zero to the number of CPUs
+size_t
+get_binary_analysis_threads();
 }  // namespace config
 }  // namespace omnitrace
@@ -0,0 +1,143 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "state.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+inline namespace config
+{
+/// typed, immutable copy of the settings which are read on the hot paths (e.g. the
+/// roctracer activity callback, the sampling offload, and the MPI/RCCL wrappers).
+/// A new snapshot is published whenever the settings are configured or changed via
+/// set_setting_value() so the readers neither look up the settings by name nor
+/// cache values in local statics which would go stale. Reading the fields of one
+/// snapshot provides a consistent set of values.
+struct alignas(64) snapshot
+{
+    uint64_t generation = 0;  ///< incremented every time a snapshot is published
+
+    // sampling
+    bool   use_tmp_files              = true;
+    bool   sampling_streaming         = false;
+    bool   sampling_compact_offload   = false;
+    bool   sampling_collapse_gpu_wait = false;
+    bool   sampling_numa_allocators   = false;
+    bool   sampling_region_rates      = false;
+    size_t sampling_allocator_size    = 8;
+
+    SamplingUnwinder sampling_unwinder = SamplingUnwinder::LibUnwind;
+
+    // MPI and RCCL communication data
+    bool   use_comm_histogram   = false;
+    double comm_data_resolution = 0.0;
+
+    // roctracer
+    bool roctracer_aggregate                     = false;
+    bool roctracer_discard_barriers              = false;
+    bool roctracer_hip_api_backtrace             = false;
+    bool perfetto_compact_roctracer_annotations  = false;
+    bool perfetto_deferred_roctracer_annotations = false;
+    bool critical_path                           = false;
+    bool energy                                  = false;
+    bool gpu_attribution                         = false;
+    bool memory_bandwidth                        = false;
+    bool mpi_pvars                               = false;
+    bool region_attribution                      = false;
+    bool rcclp_device_timing                     = false;
+    bool gpu_memory_tracking                     = false;
+    bool rocm_roofline                           = false;
+    bool hip_graphs                              = false;
+    bool kernel_launch_latency                   = false;
+    bool memcpy_analysis                         = false;
+    bool live_export                             = false;
+    bool memory_footprint                        = false;
+
+    // pthread lock wrappers
+    uint64_t trace_thread_locks_contention_ns   = 0;
+    size_t   trace_thread_locks_sample_interval = 1;
+    bool     trace_thread_locks_profile         = false;
+
+    // thread creation
+    bool lazy_thread_setup = false;
+
+    // heap allocation wrappers
+    bool   heap_profile                 = false;
+    size_t heap_profile_sample_interval = 524288;
+
+    // POSIX I/O wrappers
+    bool     io_trace              = false;
+    uint64_t io_trace_threshold_ns = 1000000;
+
+    // OpenMP-tools
+    bool   ompt_aggregate                 = false;
+    size_t ompt_aggregate_sample_interval = 0;
+
+    // timemory
+    bool timeline_profile_compact = false;
+
+    // perfetto
+    bool perfetto_deferred_regions = false;
+
+    // user-space hardware counters
+    bool perf_events_regions = false;
+
+    // causal profiling
+    uint64_t causal_delay_spin_ns   = 20000;
+    bool     causal_progress_points = false;  ///< the progress points are counted
+    bool     causal_kernels         = false;  ///< the kernels are the selections
+
+    // overhead attribution
+    bool self_profile = false;
+};
+
+/// pointer to the current snapshot. The previous snapshots are retained (they are
+/// only published a handful of times) so a reader never holds a dangling reference
+inline std::atomic<const snapshot*>&
+get_snapshot_pointer()
+{
+    static auto _v = std::atomic<const snapshot*>{ nullptr };
+    return _v;
+}
+
+/// the current snapshot or the default values if the settings are not configured
+inline const snapshot&
+get_snapshot()
+{
+    static const auto _default = snapshot{};
+    const auto*       _v       = get_snapshot_pointer().load(std::memory_order_acquire);
+    return (_v) ? *_v : _default;
+}
+
+/// builds a snapshot from the current settings and publishes it. Does nothing if the
+/// settings are not configured
+void
+update_snapshot();
+}  // namespace config
+}  // namespace omnitrace
@@ -29,8 +29,10 @@
 #include <timemory/units.hpp>
 #include <timemory/utility/delimit.hpp>
 
+#include <cerrno>
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <ratio>
 #include <string>
 #include <thread>
@@ -130,6 +132,24 @@ get_clock_now(clockid_t clock_id) noexcept
     auto         _ts    = get_timespec(clock_id);
     return (_ts.tv_sec * std::nano::den + _ts.tv_nsec) * factor;
 }
+
+// sleeps until the absolute time on the clock. An absolute deadline is not extended
+// when the sleep is interrupted by the sampling signals. clock_nanosleep does not
+// support the raw and coarse clocks so these fall back to relative sleeps
+void
+sleep_until(clockid_t clock_id, uint64_t _deadline)
+{
+    auto _ts  = timespec{ static_cast<time_t>(_deadline / units::sec),
+                         static_cast<long>(_deadline % units::sec) };
+    int  _ret = 0;
+    while((_ret = clock_nanosleep(clock_id, TIMER_ABSTIME, &_ts, nullptr)) == EINTR)
+    {}
+    if(_ret == 0) return;
+
+    for(auto _now = get_clock_now(clock_id); _now < _deadline;
+        _now      = get_clock_now(clock_id))
+        sleep(_deadline - _now);
+}
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -348,5 +368,49 @@ get_trace_stages()
 
     return _v;
 }
+
+void
+schedule(std::vector<spec> _specs, stages _stages)
+{
+    if(_specs.empty()) return;
+
+    auto _run = [](const std::vector<spec>& _specs_v, const stages& _stages_v) {
+        while(get_state() < State::Active)
+            sleep(1 * units::msec);
+
+        for(const auto& itr : _specs_v)
+        {
+            auto _n = itr.repeat;
+            if(_n < 1) _n = std::numeric_limits<uint64_t>::max();
+
+            auto _clock    = itr.clock_id.value;
+            auto _delay    = static_cast<uint64_t>(itr.delay * units::sec);
+            auto _duration = static_cast<uint64_t>(itr.duration * units::sec);
+            auto _origin   = get_clock_now(_clock);
+
+            for(uint64_t i = 0; i < _n; ++i)
+            {
+                auto _spec =
+                    spec{ itr.clock_id, itr.delay, itr.duration, i, itr.repeat };
+                auto _begin = _origin + (i * (_delay + _duration)) + _delay;
+                auto _end   = _begin + _duration;
+
+                OMNITRACE_VERBOSE(3,
+                                  "Scheduling constraint spec %lu of %lu :: delay: "
+                                  "%6.3f, duration: %6.3f, clock: %s\n",
+                                  i, _spec.repeat, _spec.delay, _spec.duration,
+                                  _spec.clock_id.as_string().c_str());
+
+                if(!_stages_v.init(_spec)) return;
+                sleep_until(_clock, _begin);
+                if(!_stages_v.start(_spec) || _duration == 0) return;
+                sleep_until(_clock, _end);
+                if(!_stages_v.stop(_spec)) return;
+            }
+        }
+    };
+
+    std::thread{ _run, std::move(_specs), std::move(_stages) }.detach();
+}
 }  // namespace constraint
 }  // namespace omnitrace
@@ -110,5 +110,15 @@ get_trace_specs();
 
 stages
 get_trace_stages();
+
+/// executes the specs, in order, on one background thread. The edges of the windows of
+/// a spec are absolute times on its clock, i.e. window N opens at
+/// N * (delay + duration) + delay after the spec began, so a short window repeated for
+/// days does not drift and the thread only wakes at the edges. The init, start and stop
+/// stages are invoked at the edges (the wait and collect stages are not used) and the
+/// schedule ends when one of them returns false. A spec without a duration leaves its
+/// window open and ends the schedule
+void
+schedule(std::vector<spec>, stages);
 }  // namespace constraint
 }  // namespace omnitrace
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "core/common.hpp"
+#include "core/containers/c_array.hpp"
 #include "core/containers/operators.hpp"
 #include "core/debug.hpp"
 #include "core/exception.hpp"
@@ -30,7 +31,9 @@
 #include <array>
 #include <atomic>
 #include <cstdlib>
+#include <iterator>
 #include <new>
+#include <type_traits>
 
 namespace omnitrace
 {
@@ -69,6 +72,11 @@ struct aligned_static_vector
     using size_type       = size_t;
     using difference_type = std::ptrdiff_t;
 
+    /// the elements are contiguous when the alignment does not pad them, e.g. the
+    /// default alignment of the type. Only then are span() and assign_uninitialized()
+    /// available and is append() a memcpy for trivially copyable values
+    static constexpr bool is_contiguous = (sizeof(aligned_value_type) == sizeof(Tp));
+
     aligned_static_vector()                                 = default;
     aligned_static_vector(const aligned_static_vector&)     = default;
     aligned_static_vector(aligned_static_vector&&) noexcept = default;
@@ -91,6 +99,20 @@ struct aligned_static_vector
 
     void pop_back() { --m_size; }
 
+    /// appends the elements of [first, last). Throws if the capacity is exceeded
+    template <typename InputItrT>
+    void append(InputItrT _first, InputItrT _last);
+
+    template <typename RangeT>
+    void append(const RangeT& _v);
+
+    /// sets the size without assigning the elements and returns them so they can be
+    /// written in place
+    c_array<Tp> assign_uninitialized(size_t _n);
+
+    c_array<Tp>       span();
+    c_array<const Tp> span() const;
+
     void clear();
     void reserve(size_t) noexcept {}
     void shrink_to_fit() noexcept {}
@@ -259,6 +281,86 @@ aligned_static_vector<Tp, N, AlignN, AtomicSizeV>::operator=(
     return *this;
 }
 
+template <typename Tp, size_t N, size_t AlignN, bool AtomicSizeV>
+template <typename InputItrT>
+void
+aligned_static_vector<Tp, N, AlignN, AtomicSizeV>::append(InputItrT _first,
+                                                          InputItrT _last)
+{
+    using value_t = std::remove_cv_t<std::remove_pointer_t<InputItrT>>;
+
+    if constexpr(is_contiguous && std::is_pointer<InputItrT>::value &&
+                 std::is_same<value_t, Tp>::value)
+    {
+        size_t _idx = m_size;
+        auto   _n   = static_cast<size_t>(_last - _first);
+        if(OMNITRACE_UNLIKELY(_idx + _n > N))
+        {
+            throw exception<std::out_of_range>(
+                std::string{ "aligned_static_vector::append - " } +
+                std::to_string(_idx + _n) + " exceeds capacity " + std::to_string(N));
+        }
+
+        copy_elements(&m_data[_idx].value, _first, _n);
+        if constexpr(AtomicSizeV)
+            m_size.store(_idx + _n);
+        else
+            m_size = _idx + _n;
+    }
+    else
+    {
+        for(; _first != _last; ++_first)
+            emplace_back(*_first);
+    }
+}
+
+template <typename Tp, size_t N, size_t AlignN, bool AtomicSizeV>
+template <typename RangeT>
+void
+aligned_static_vector<Tp, N, AlignN, AtomicSizeV>::append(const RangeT& _v)
+{
+    if constexpr(is_contiguous_range<const RangeT>::value)
+        append(std::data(_v), std::data(_v) + std::size(_v));
+    else
+        append(std::begin(_v), std::end(_v));
+}
+
+template <typename Tp, size_t N, size_t AlignN, bool AtomicSizeV>
+c_array<Tp>
+aligned_static_vector<Tp, N, AlignN, AtomicSizeV>::assign_uninitialized(size_t _n)
+{
+    static_assert(is_contiguous, "Error! the aligned elements are not contiguous");
+
+    if(OMNITRACE_UNLIKELY(_n > N))
+    {
+        throw exception<std::out_of_range>(
+            std::string{ "aligned_static_vector::assign_uninitialized - " } +
+            std::to_string(_n) + " exceeds capacity " + std::to_string(N));
+    }
+
+    if constexpr(AtomicSizeV)
+        m_size.store(_n);
+    else
+        m_size = _n;
+    return c_array<Tp>{ &m_data[0].value, _n };
+}
+
+template <typename Tp, size_t N, size_t AlignN, bool AtomicSizeV>
+c_array<Tp>
+aligned_static_vector<Tp, N, AlignN, AtomicSizeV>::span()
+{
+    static_assert(is_contiguous, "Error! the aligned elements are not contiguous");
+    return c_array<Tp>{ &m_data[0].value, size() };
+}
+
+template <typename Tp, size_t N, size_t AlignN, bool AtomicSizeV>
+c_array<const Tp>
+aligned_static_vector<Tp, N, AlignN, AtomicSizeV>::span() const
+{
+    static_assert(is_contiguous, "Error! the aligned elements are not contiguous");
+    return c_array<const Tp>{ &m_data[0].value, size() };
+}
+
 template <typename Tp, size_t N, size_t AlignN, bool AtomicSizeV>
 void
 aligned_static_vector<Tp, N, AlignN, AtomicSizeV>::clear()
@@ -24,11 +24,16 @@
 
 #include "core/exception.hpp"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace omnitrace
@@ -51,6 +56,10 @@ struct c_array
 
     // Get the size of the wrapped array
     size_t size() const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+
+    // Get the base pointer of the wrapped array
+    Tp* data() const { return m_base; }
 
     // Access an element by index
     Tp& operator[](size_t i) { return m_base[i]; }
@@ -136,5 +145,33 @@ wrap_c_array(Tp* base, size_t size)
 {
     return c_array<Tp>(base, size);
 }
+
+// Ranges whose elements are contiguous in memory, i.e. std::data and std::size apply
+template <typename RangeT, typename = void>
+struct is_contiguous_range : std::false_type
+{};
+
+template <typename RangeT>
+struct is_contiguous_range<
+    RangeT, std::void_t<decltype(std::data(std::declval<RangeT&>())),
+                        decltype(std::size(std::declval<RangeT&>()))>>
+: std::true_type
+{};
+
+// Copies n elements between non-overlapping arrays, with one memcpy when the elements
+// are trivially copyable
+template <typename Tp>
+void
+copy_elements(Tp* _dst, const Tp* _src, size_t _n)
+{
+    if constexpr(std::is_trivially_copyable<Tp>::value)
+    {
+        if(_n > 0) std::memcpy(_dst, _src, _n * sizeof(Tp));
+    }
+    else
+    {
+        std::copy_n(_src, _n, _dst);
+    }
+}
 }  // namespace container
 }  // namespace omnitrace
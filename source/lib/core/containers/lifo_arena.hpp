@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace omnitrace
+{
+namespace container
+{
+/// storage for objects whose lifetimes nest, e.g. the bundles of the regions of a
+/// thread. The objects are bump-allocated in fixed-size chunks which are retained
+/// once allocated, so the memory of consecutive objects is contiguous (within a
+/// chunk) and there are no calls to the allocator once the peak depth was reached.
+/// A slot which is released out of order is reused by the next allocation or
+/// reclaimed once every slot above it has been released. Only provides the storage:
+/// the objects are constructed and destroyed by the caller
+template <typename Tp, size_t ChunkSizeV = 128>
+class lifo_arena
+{
+public:
+    using value_type = Tp;
+    using pointer    = Tp*;
+
+    static constexpr const size_t chunk_size = ChunkSizeV;
+
+    lifo_arena()  = default;
+    ~lifo_arena() = default;
+
+    lifo_arena(const lifo_arena&)     = delete;
+    lifo_arena(lifo_arena&&) noexcept = default;
+
+    lifo_arena& operator=(const lifo_arena&) = delete;
+    lifo_arena& operator=(lifo_arena&&) noexcept = default;
+
+    /// uninitialized storage for one object
+    pointer allocate()
+    {
+        // reuse the slots released out of order so that the memory of long-lived
+        // objects which are not nested does not grow. The entries above the top are
+        // stale since they were reclaimed when the top moved below them
+        while(OMNITRACE_UNLIKELY(!m_holes.empty()))
+        {
+            auto _idx = m_holes.back();
+            m_holes.pop_back();
+            if(_idx < m_top && !m_live[_idx])
+            {
+                m_live[_idx] = true;
+                return get(_idx);
+            }
+        }
+
+        if(OMNITRACE_UNLIKELY(m_top == m_live.size())) grow();
+        m_live[m_top] = true;
+        return get(m_top++);
+    }
+
+    /// releases the storage of an object returned by allocate()
+    void deallocate(pointer _v)
+    {
+        // the object is almost always the last one which was allocated
+        size_t _idx = (m_top > 0 && get(m_top - 1) == _v) ? (m_top - 1) : find(_v);
+        if(OMNITRACE_UNLIKELY(_idx >= m_top)) return;
+
+        m_live[_idx] = false;
+        if(_idx + 1 < m_top)
+            m_holes.emplace_back(_idx);
+        else
+        {
+            while(m_top > 0 && !m_live[m_top - 1])
+                --m_top;
+        }
+    }
+
+    /// whether the address is a slot of this arena, regardless of whether it is in use
+    bool owns(const Tp* _v) const { return find(_v) < m_live.size(); }
+
+    /// the number of slots below the top, including the ones released out of order
+    size_t size() const { return m_top; }
+    size_t capacity() const { return m_live.size(); }
+    bool   empty() const { return m_top == 0; }
+
+private:
+    struct chunk
+    {
+        std::aligned_storage_t<sizeof(Tp), alignof(Tp)> data[ChunkSizeV];
+    };
+
+    pointer get(size_t _idx) const
+    {
+        return reinterpret_cast<pointer>(
+            &m_chunks[_idx / ChunkSizeV]->data[_idx % ChunkSizeV]);
+    }
+
+    size_t find(const Tp* _v) const
+    {
+        auto _less = std::less<const Tp*>{};
+        for(size_t i = 0; i < m_chunks.size(); ++i)
+        {
+            auto* _beg = get(i * ChunkSizeV);
+            if(!_less(_v, _beg) && _less(_v, _beg + ChunkSizeV))
+                return (i * ChunkSizeV) + static_cast<size_t>(_v - _beg);
+        }
+        return m_live.size();
+    }
+
+    void grow()
+    {
+        m_chunks.emplace_back(std::make_unique<chunk>());
+        m_live.resize(m_live.size() + ChunkSizeV, false);
+    }
+
+    size_t                              m_top    = 0;
+    std::vector<bool>                   m_live   = {};
+    std::vector<size_t>                 m_holes  = {};
+    std::vector<std::unique_ptr<chunk>> m_chunks = {};
+};
+}  // namespace container
+}  // namespace omnitrace
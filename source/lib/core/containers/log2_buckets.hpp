@@ -0,0 +1,88 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace omnitrace
+{
+namespace container
+{
+/// power-of-two buckets of the histograms of unsigned values, e.g. sizes and durations.
+/// Bucket N > 0 counts the values in [2^(N-1), 2^N), bucket 0 counts zero and the last
+/// bucket also counts all the larger values
+template <size_t N>
+struct log2_buckets
+{
+    static_assert(N > 1 && N <= 65, "log2_buckets require 2 to 65 buckets");
+
+    static constexpr size_t num_buckets = N;
+
+    using array_type = std::array<uint64_t, N>;
+
+    static size_t get_bucket(uint64_t _v)
+    {
+        size_t _n = (_v == 0) ? 0 : (64 - __builtin_clzll(_v));
+        return std::min<size_t>(_n, num_buckets - 1);
+    }
+
+    /// lowest value counted in the bucket
+    static uint64_t get_bucket_begin(size_t _n)
+    {
+        return (_n == 0) ? 0 : (uint64_t{ 1 } << (_n - 1));
+    }
+
+    /// e.g. "0" or "[4, 8)" and the lowest value prefixed by ">= " for the last bucket
+    static std::string get_bucket_label(size_t _n)
+    {
+        if(_n == 0) return std::string{ "0" };
+        auto _lo = std::to_string(get_bucket_begin(_n));
+        if(_n + 1 == num_buckets) return ">= " + _lo;
+        return "[" + _lo + ", " + std::to_string(uint64_t{ 1 } << _n) + ")";
+    }
+
+    static void add(array_type& _buckets, uint64_t _v) { _buckets[get_bucket(_v)] += 1; }
+
+    static void merge(array_type& _lhs, const array_type& _rhs)
+    {
+        for(size_t i = 0; i < num_buckets; ++i)
+            _lhs[i] += _rhs[i];
+    }
+
+    /// the number of buckets up to and including the last non-empty bucket
+    static size_t get_used(const array_type& _buckets)
+    {
+        auto _n = num_buckets;
+        while(_n > 0 && _buckets[_n - 1] == 0)
+            --_n;
+        return _n;
+    }
+};
+}  // namespace container
+}  // namespace omnitrace
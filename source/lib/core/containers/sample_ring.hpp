@@ -0,0 +1,245 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace container
+{
+/// structure-of-arrays ring buffer for periodically sampled metrics. Each metric
+/// is stored in its own preallocated column and the timestamps are stored as the
+/// delta from the previous sample. A capacity of zero makes the ring unbounded,
+/// otherwise the oldest samples are overwritten once the ring is full
+template <typename Tp, typename DeltaT = uint32_t>
+struct sample_ring
+{
+    using value_type     = Tp;
+    using delta_type     = DeltaT;
+    using timestamp_type = uint64_t;
+
+    static constexpr delta_type wide_delta = std::numeric_limits<delta_type>::max();
+
+    sample_ring() = default;
+    sample_ring(size_t _ncolumns, size_t _capacity) { reset(_ncolumns, _capacity); }
+
+    void reset(size_t _ncolumns, size_t _capacity);
+
+    /// appends a sample. _values must point to columns() values
+    void push(timestamp_type _ts, const value_type* _values);
+
+    template <typename ContainerT,
+              std::enable_if_t<!std::is_pointer<ContainerT>::value, int> = 0>
+    void push(timestamp_type _ts, const ContainerT& _values)
+    {
+        push(_ts, _values.data());
+    }
+
+    bool   empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    size_t columns() const { return m_columns.size(); }
+    size_t dropped() const { return m_dropped; }
+
+    /// bytes allocated by the columns, the deltas and the wide deltas
+    size_t bytes() const;
+
+    /// keeps the newest samples which fit in the capacity and bounds the ring to it.
+    /// The older samples are counted as dropped
+    void set_capacity(size_t _capacity);
+
+    /// value of the column for the n-th oldest sample
+    const value_type& at(size_t _col, size_t _idx) const
+    {
+        return m_columns[_col][physical(_idx)];
+    }
+
+    /// invokes _func(timestamp, index) for every sample, oldest first
+    template <typename FuncT>
+    void for_each(FuncT&& _func) const;
+
+    /// invokes _func(timestamp, value) for every sample of a column, oldest first
+    template <typename FuncT>
+    void for_each(size_t _col, FuncT&& _func) const;
+
+private:
+    size_t physical(size_t _idx) const
+    {
+        return (m_capacity == 0) ? _idx : ((m_head + _idx) % m_capacity);
+    }
+
+    timestamp_type delta(size_t _idx) const;
+    void           pop_front();
+
+    timestamp_type                               m_first_ts = 0;
+    timestamp_type                               m_last_ts  = 0;
+    size_t                                       m_head     = 0;
+    size_t                                       m_size     = 0;
+    size_t                                       m_capacity = 0;
+    size_t                                       m_dropped  = 0;
+    uint64_t                                     m_seq      = 0;
+    std::vector<delta_type>                      m_deltas   = {};
+    std::vector<std::vector<value_type>>         m_columns  = {};
+    std::unordered_map<uint64_t, timestamp_type> m_wide     = {};
+};
+
+template <typename Tp, typename DeltaT>
+void
+sample_ring<Tp, DeltaT>::reset(size_t _ncolumns, size_t _capacity)
+{
+    m_first_ts = 0;
+    m_last_ts  = 0;
+    m_head     = 0;
+    m_size     = 0;
+    m_capacity = _capacity;
+    m_dropped  = 0;
+    m_seq      = 0;
+    m_wide.clear();
+    m_deltas  = std::vector<delta_type>(_capacity);
+    m_columns = std::vector<std::vector<value_type>>(_ncolumns,
+                                                     std::vector<value_type>(_capacity));
+}
+
+template <typename Tp, typename DeltaT>
+void
+sample_ring<Tp, DeltaT>::push(timestamp_type _ts, const value_type* _values)
+{
+    if(m_capacity > 0 && m_size == m_capacity) pop_front();
+
+    // timestamps from the sampler are monotonic but guard against a step backwards
+    if(m_size == 0)
+        m_first_ts = _ts;
+    else if(_ts < m_last_ts)
+        _ts = m_last_ts;
+
+    auto _delta = (m_size == 0) ? timestamp_type{ 0 } : (_ts - m_last_ts);
+    m_last_ts   = _ts;
+
+    // deltas which do not fit are flagged and stored on the side
+    auto _encoded = static_cast<delta_type>(_delta);
+    if(_delta >= wide_delta)
+    {
+        _encoded               = wide_delta;
+        m_wide[m_seq + m_size] = _delta;
+    }
+
+    if(m_capacity == 0)
+    {
+        m_deltas.emplace_back(_encoded);
+        for(size_t i = 0; i < m_columns.size(); ++i)
+            m_columns[i].emplace_back(_values[i]);
+    }
+    else
+    {
+        auto _idx      = physical(m_size);
+        m_deltas[_idx] = _encoded;
+        for(size_t i = 0; i < m_columns.size(); ++i)
+            m_columns[i][_idx] = _values[i];
+    }
+    ++m_size;
+}
+
+template <typename Tp, typename DeltaT>
+size_t
+sample_ring<Tp, DeltaT>::bytes() const
+{
+    // the nodes of the wide deltas are estimated as the key, the value and two pointers
+    auto _v = (m_deltas.capacity() * sizeof(delta_type)) +
+              (m_wide.size() * (sizeof(uint64_t) + sizeof(timestamp_type) +
+                                (2 * sizeof(void*))));
+    for(const auto& itr : m_columns)
+        _v += itr.capacity() * sizeof(value_type);
+    return _v;
+}
+
+template <typename Tp, typename DeltaT>
+void
+sample_ring<Tp, DeltaT>::set_capacity(size_t _capacity)
+{
+    if(_capacity == m_capacity) return;
+
+    auto _ring   = sample_ring{ columns(), _capacity };
+    auto _values = std::vector<value_type>(columns());
+    for_each([&](timestamp_type _ts, size_t _idx) {
+        for(size_t i = 0; i < _values.size(); ++i)
+            _values[i] = at(i, _idx);
+        _ring.push(_ts, _values.data());
+    });
+    _ring.m_dropped += m_dropped;
+    *this = std::move(_ring);
+}
+
+template <typename Tp, typename DeltaT>
+void
+sample_ring<Tp, DeltaT>::pop_front()
+{
+    if(m_size == 0) return;
+    if(m_size > 1) m_first_ts += delta(1);
+    if(m_deltas[physical(0)] == wide_delta) m_wide.erase(m_seq);
+    m_head = (m_head + 1) % m_capacity;
+    ++m_seq;
+    ++m_dropped;
+    --m_size;
+}
+
+template <typename Tp, typename DeltaT>
+typename sample_ring<Tp, DeltaT>::timestamp_type
+sample_ring<Tp, DeltaT>::delta(size_t _idx) const
+{
+    auto _v = m_deltas[physical(_idx)];
+    if(_v == wide_delta) return m_wide.at(m_seq + _idx);
+    return _v;
+}
+
+template <typename Tp, typename DeltaT>
+template <typename FuncT>
+void
+sample_ring<Tp, DeltaT>::for_each(FuncT&& _func) const
+{
+    auto _ts = m_first_ts;
+    for(size_t i = 0; i < m_size; ++i)
+    {
+        if(i > 0) _ts += delta(i);
+        _func(_ts, i);
+    }
+}
+
+template <typename Tp, typename DeltaT>
+template <typename FuncT>
+void
+sample_ring<Tp, DeltaT>::for_each(size_t _col, FuncT&& _func) const
+{
+    const auto& _column = m_columns[_col];
+    for_each([&](timestamp_type _ts, size_t _idx) {
+        _func(_ts, _column[physical(_idx)]);
+    });
+}
+}  // namespace container
+}  // namespace omnitrace
@@ -23,10 +23,13 @@
 #pragma once
 
 #include "core/containers/aligned_static_vector.hpp"
+#include "core/containers/c_array.hpp"
 #include "core/containers/operators.hpp"
 #include "core/defines.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
@@ -153,6 +156,7 @@ public:
     };
 
     stable_vector() = default;
+    ~stable_vector();
     explicit stable_vector(size_type count, const Tp& value);
     explicit stable_vector(size_type count);
 
@@ -179,12 +183,13 @@ public:
 
     size_type size() const noexcept
     {
-        return empty() ? 0 : (m_chunks.size() - 1) * ChunkSizeV + m_chunks.back()->size();
+        auto _n = num_chunks();
+        return (_n == 0) ? 0 : (_n - 1) * ChunkSizeV + get_chunk(_n - 1)->size();
     }
     size_type max_size() const noexcept { return std::numeric_limits<size_type>::max(); }
-    size_type capacity() const noexcept { return m_chunks.size() * ChunkSizeV; }
+    size_type capacity() const noexcept { return num_chunks() * ChunkSizeV; }
 
-    bool empty() const noexcept { return m_chunks.size() == 0; }
+    bool empty() const noexcept { return num_chunks() == 0; }
 
     void reserve(size_type new_capacity);
     void shrink_to_fit() noexcept {}
@@ -195,15 +200,15 @@ public:
     }
     bool operator!=(const this_type& c) const { return !operator==(c); }
 
-    void swap(this_type& v) { std::swap(m_chunks, v.m_chunks); }
+    void swap(this_type& v);
 
     friend void swap(this_type& l, this_type& r) { l.swap(r); }
 
-    reference       front() { return m_chunks.front()->front(); }
-    const_reference front() const { return front(); }
+    reference       front() { return get_chunk(0)->front(); }
+    const_reference front() const { return get_chunk(0)->front(); }
 
-    reference       back() { return m_chunks.back()->back(); }
-    const_reference back() const { return back(); }
+    reference       back() { return get_chunk(num_chunks() - 1)->back(); }
+    const_reference back() const { return get_chunk(num_chunks() - 1)->back(); }
 
     void push_back(const Tp& t);
     void push_back(Tp&& t);
@@ -211,6 +216,24 @@ public:
     template <typename... Args>
     void emplace_back(Args&&... args);
 
+    /// appends the elements of [first, last). A contiguous range of trivially copyable
+    /// values is copied with one memcpy per chunk when the chunks are contiguous
+    template <typename InputItrT>
+    void append(InputItrT first, InputItrT last);
+
+    template <typename RangeT>
+    void append(const RangeT& r);
+
+    /// the elements are stored in chunks of chunk_size elements which are contiguous
+    /// when the alignment does not pad them. The spans of the chunks allow the
+    /// elements to be copied or serialized in bulk
+    static constexpr bool has_contiguous_chunks = (sizeof(Tp) % AlignN == 0);
+
+    size_type chunk_count() const noexcept { return num_chunks(); }
+
+    c_array<Tp>       chunk_span(size_type n);
+    c_array<const Tp> chunk_span(size_type n) const;
+
     reference operator[](size_type i);
 
     const_reference operator[](size_type i) const;
@@ -220,15 +243,47 @@ public:
     const_reference at(size_type i) const;
 
 private:
-    using chunk_type   = container::aligned_static_vector<Tp, ChunkSizeV, AlignN, true>;
-    using storage_type = std::vector<std::unique_ptr<chunk_type>>;
+    using chunk_type = container::aligned_static_vector<Tp, ChunkSizeV, AlignN, true>;
+    using block_type = std::atomic<chunk_type*>;
+
+    // the chunks are referenced by a directory of blocks where block N holds 2^N chunk
+    // pointers. Neither the blocks nor the chunks are ever relocated so the elements
+    // may be accessed while other chunks are added, e.g. when the thread data grows
+    static constexpr size_t max_blocks = 48;
+
+    static std::pair<size_t, size_t> locate(size_t _chunk)
+    {
+        auto _n   = _chunk + 1;
+        auto _blk = static_cast<size_t>(63 - __builtin_clzll(_n));
+        return { _blk, _n - (size_t{ 1 } << _blk) };
+    }
+
+    size_t num_chunks() const { return m_num_chunks.load(std::memory_order_acquire); }
+
+    chunk_type* get_chunk(size_t _chunk) const
+    {
+        auto _loc = locate(_chunk);
+        return m_blocks[_loc.first].load(std::memory_order_acquire)[_loc.second].load(
+            std::memory_order_acquire);
+    }
 
-    void        add_chunk();
+    void        add_chunk(chunk_type*);
+    void        add_chunk() { add_chunk(new chunk_type{}); }
     chunk_type& last_chunk();
 
-    storage_type m_chunks;
+    std::atomic<size_t>                              m_num_chunks = { 0 };
+    std::array<std::atomic<block_type*>, max_blocks> m_blocks     = {};
 };
 
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+stable_vector<Tp, ChunkSizeV, AlignN>::~stable_vector()
+{
+    for(size_t i = 0; i < num_chunks(); ++i)
+        delete get_chunk(i);
+    for(auto& itr : m_blocks)
+        delete[] itr.load();
+}
+
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(size_type count, const Tp& value)
 {
@@ -260,16 +315,17 @@ stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(InputItrT first, InputItrT
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(const stable_vector& other)
 {
-    for(const auto& chunk : other.m_chunks)
+    for(size_t i = 0; i < other.num_chunks(); ++i)
     {
-        m_chunks.emplace_back(std::make_unique<chunk_type>(*chunk));
+        add_chunk(new chunk_type(*other.get_chunk(i)));
     }
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(stable_vector&& other) noexcept
-: m_chunks(std::move(other.m_chunks))
-{}
+{
+    swap(other);
+}
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(std::initializer_list<Tp> ilist)
@@ -290,21 +346,43 @@ stable_vector<Tp, ChunkSizeV, AlignN>::operator=(stable_vector v)
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 void
-stable_vector<Tp, ChunkSizeV, AlignN>::add_chunk()
+stable_vector<Tp, ChunkSizeV, AlignN>::swap(this_type& v)
 {
-    m_chunks.emplace_back(std::make_unique<chunk_type>());
+    for(size_t i = 0; i < max_blocks; ++i)
+        m_blocks[i].store(v.m_blocks[i].exchange(m_blocks[i].load()));
+    m_num_chunks.store(v.m_num_chunks.exchange(m_num_chunks.load()));
+}
+
+// adding chunks is not thread-safe with respect to other modifications but the
+// existing elements may be concurrently accessed
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+void
+stable_vector<Tp, ChunkSizeV, AlignN>::add_chunk(chunk_type* _chunk)
+{
+    auto  _n     = m_num_chunks.load(std::memory_order_relaxed);
+    auto  _loc   = locate(_n);
+    auto* _block = m_blocks.at(_loc.first).load(std::memory_order_relaxed);
+    if(!_block)
+    {
+        _block = new block_type[size_t{ 1 } << _loc.first]{};
+        m_blocks.at(_loc.first).store(_block, std::memory_order_release);
+    }
+    _block[_loc.second].store(_chunk, std::memory_order_release);
+    m_num_chunks.store(_n + 1, std::memory_order_release);
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 typename stable_vector<Tp, ChunkSizeV, AlignN>::chunk_type&
 stable_vector<Tp, ChunkSizeV, AlignN>::last_chunk()
 {
-    if(OMNITRACE_UNLIKELY(m_chunks.empty() || m_chunks.back()->size() == ChunkSizeV))
+    auto _n = num_chunks();
+    if(OMNITRACE_UNLIKELY(_n == 0 || get_chunk(_n - 1)->size() == ChunkSizeV))
     {
         add_chunk();
+        ++_n;
     }
 
-    return *m_chunks.back();
+    return *get_chunk(_n - 1);
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
@@ -340,11 +418,61 @@ stable_vector<Tp, ChunkSizeV, AlignN>::emplace_back(Args&&... args)
     last_chunk().emplace_back(std::forward<Args>(args)...);
 }
 
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+template <typename InputItrT>
+void
+stable_vector<Tp, ChunkSizeV, AlignN>::append(InputItrT first, InputItrT last)
+{
+    using value_t = std::remove_cv_t<std::remove_pointer_t<InputItrT>>;
+
+    if constexpr(has_contiguous_chunks && std::is_pointer<InputItrT>::value &&
+                 std::is_same<value_t, Tp>::value)
+    {
+        while(first != last)
+        {
+            auto& _chunk = last_chunk();
+            auto  _n     = std::min<size_type>(last - first, ChunkSizeV - _chunk.size());
+            _chunk.append(first, first + _n);
+            first += _n;
+        }
+    }
+    else
+    {
+        for(; first != last; ++first)
+            emplace_back(*first);
+    }
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+template <typename RangeT>
+void
+stable_vector<Tp, ChunkSizeV, AlignN>::append(const RangeT& r)
+{
+    if constexpr(is_contiguous_range<const RangeT>::value)
+        append(std::data(r), std::data(r) + std::size(r));
+    else
+        append(std::begin(r), std::end(r));
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+c_array<Tp>
+stable_vector<Tp, ChunkSizeV, AlignN>::chunk_span(size_type n)
+{
+    return get_chunk(n)->span();
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+c_array<const Tp>
+stable_vector<Tp, ChunkSizeV, AlignN>::chunk_span(size_type n) const
+{
+    return static_cast<const chunk_type*>(get_chunk(n))->span();
+}
+
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 typename stable_vector<Tp, ChunkSizeV, AlignN>::reference
 stable_vector<Tp, ChunkSizeV, AlignN>::operator[](size_type i)
 {
-    return (*m_chunks[i / ChunkSizeV])[i % ChunkSizeV];
+    return (*get_chunk(i / ChunkSizeV))[i % ChunkSizeV];
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
@@ -32,6 +32,8 @@
 #include <array>
 #include <atomic>
 #include <cstdlib>
+#include <iterator>
+#include <type_traits>
 
 namespace omnitrace
 {
@@ -77,6 +79,22 @@ struct static_vector
 
     void pop_back() { --m_size; }
 
+    /// appends the elements of [first, last). The elements of a contiguous range of
+    /// trivially copyable values are copied with one memcpy. Throws if the capacity is
+    /// exceeded
+    template <typename InputItrT>
+    void append(InputItrT _first, InputItrT _last);
+
+    template <typename RangeT>
+    void append(const RangeT& _v);
+
+    /// sets the size without assigning the elements and returns them so they can be
+    /// written in place, e.g. when reading serialized data
+    c_array<Tp> assign_uninitialized(size_t _n);
+
+    c_array<Tp>       span() { return { m_data.data(), size() }; }
+    c_array<const Tp> span() const { return { m_data.data(), size() }; }
+
     void clear();
     void reserve(size_t) noexcept {}
     void shrink_to_fit() noexcept {}
@@ -130,8 +148,8 @@ template <typename Tp, size_t N, bool AtomicSizeV>
 static_vector<Tp, N, AtomicSizeV>::static_vector(c_array<Tp>&& _v)
 {
     auto _n = std::min<size_t>(N, _v.size());
-    for(size_t i = 0; i < _n; ++i, ++m_size)
-        m_data[i] = _v[i];
+    copy_elements(m_data.data(), _v.data(), _n);
+    update_size(_n);
 }
 
 template <typename Tp, size_t N, bool AtomicSizeV>
@@ -139,8 +157,8 @@ template <size_t M>
 static_vector<Tp, N, AtomicSizeV>::static_vector(std::array<Tp, M>&& _v)
 {
     auto _n = std::min<size_t>(N, M);
-    for(size_t i = 0; i < _n; ++i, ++m_size)
-        m_data[i] = _v[i];
+    copy_elements(m_data.data(), _v.data(), _n);
+    update_size(_n);
 }
 
 template <typename Tp, size_t N, bool AtomicSizeV>
@@ -171,6 +189,60 @@ static_vector<Tp, N, AtomicSizeV>::operator=(std::pair<std::array<Tp, N>, size_t
     return *this;
 }
 
+template <typename Tp, size_t N, bool AtomicSizeV>
+template <typename InputItrT>
+void
+static_vector<Tp, N, AtomicSizeV>::append(InputItrT _first, InputItrT _last)
+{
+    using value_t = std::remove_cv_t<std::remove_pointer_t<InputItrT>>;
+
+    if constexpr(std::is_pointer<InputItrT>::value && std::is_same<value_t, Tp>::value)
+    {
+        auto _idx = size();
+        auto _n   = static_cast<size_t>(_last - _first);
+        if(OMNITRACE_UNLIKELY(_idx + _n > N))
+        {
+            throw exception<std::out_of_range>(
+                std::string{ "static_vector::append - " } + std::to_string(_idx + _n) +
+                " exceeds capacity " + std::to_string(N));
+        }
+
+        copy_elements(m_data.data() + _idx, _first, _n);
+        update_size(_idx + _n);
+    }
+    else
+    {
+        for(; _first != _last; ++_first)
+            emplace_back(*_first);
+    }
+}
+
+template <typename Tp, size_t N, bool AtomicSizeV>
+template <typename RangeT>
+void
+static_vector<Tp, N, AtomicSizeV>::append(const RangeT& _v)
+{
+    if constexpr(is_contiguous_range<const RangeT>::value)
+        append(std::data(_v), std::data(_v) + std::size(_v));
+    else
+        append(std::begin(_v), std::end(_v));
+}
+
+template <typename Tp, size_t N, bool AtomicSizeV>
+c_array<Tp>
+static_vector<Tp, N, AtomicSizeV>::assign_uninitialized(size_t _n)
+{
+    if(OMNITRACE_UNLIKELY(_n > N))
+    {
+        throw exception<std::out_of_range>(
+            std::string{ "static_vector::assign_uninitialized - " } + std::to_string(_n) +
+            " exceeds capacity " + std::to_string(N));
+    }
+
+    update_size(_n);
+    return c_array<Tp>{ m_data.data(), _n };
+}
+
 template <typename Tp, size_t N, bool AtomicSizeV>
 void
 static_vector<Tp, N, AtomicSizeV>::clear()
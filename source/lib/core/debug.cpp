@@ -29,7 +29,10 @@
 #include <timemory/process/threading.hpp>
 #include <timemory/utility/filepath.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -79,6 +82,43 @@ auto _protect_lock   = std::atomic<bool>{ false };
 auto _protect_unlock = std::atomic<bool>{ false };
 }  // namespace
 
+namespace log_flags
+{
+namespace
+{
+uint32_t
+encode(bool _debug, int _verbose, bool _ci)
+{
+    using limits_t = std::numeric_limits<int16_t>;
+
+    auto _level = (_debug) ? limits_t::max()
+                           : std::clamp<int>(_verbose, limits_t::min(), limits_t::max());
+    return (static_cast<uint16_t>(_level) & verbose_mask) | ((_debug) ? debug_bit : 0) |
+           ((_ci) ? ci_bit : 0) | valid_bit;
+}
+}  // namespace
+
+uint32_t
+init()
+{
+    auto _v = encode(tim::get_env<bool>("OMNITRACE_DEBUG", false, false),
+                     tim::get_env<int>("OMNITRACE_VERBOSE", 0, false),
+                     tim::get_env<bool>("OMNITRACE_CI", false, false));
+
+    // the settings take precedence if they were published in the meantime
+    uint32_t _expected = 0;
+    if(!value.compare_exchange_strong(_expected, _v, std::memory_order_relaxed))
+        return _expected;
+    return _v;
+}
+
+void
+set(bool _debug, int _verbose, bool _ci)
+{
+    value.store(encode(_debug, _verbose, _ci), std::memory_order_relaxed);
+}
+}  // namespace log_flags
+
 void
 set_source_location(source_location&& _v)
 {
@@ -38,6 +38,8 @@
 #include <timemory/utility/utility.hpp>
 
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <string_view>
@@ -69,8 +71,66 @@ bool
 get_debug_pid() OMNITRACE_HOT;
 }  // namespace config
 
+// the messages of a higher verbosity level are removed at compile-time. The debug
+// messages (e.g. OMNITRACE_DEBUG) are at OMNITRACE_DEBUG_VERBOSE_LEVEL, i.e. above
+// every verbosity level which is used
+#if !defined(OMNITRACE_DEBUG_VERBOSE_LEVEL)
+#    define OMNITRACE_DEBUG_VERBOSE_LEVEL 5
+#endif
+
+#if !defined(OMNITRACE_MAX_VERBOSE_LEVEL)
+#    define OMNITRACE_MAX_VERBOSE_LEVEL OMNITRACE_DEBUG_VERBOSE_LEVEL
+#endif
+
 namespace debug
 {
+/// OMNITRACE_DEBUG, OMNITRACE_VERBOSE, and OMNITRACE_CI packed into one value so that
+/// the check of a logging macro is a single relaxed load. Read from the environment
+/// on first use and updated whenever the settings are (see update_snapshot)
+namespace log_flags
+{
+constexpr uint32_t verbose_mask = 0xFFFF;  ///< verbosity (or max when debugging)
+constexpr uint32_t debug_bit    = (1U << 16);
+constexpr uint32_t ci_bit       = (1U << 17);
+constexpr uint32_t valid_bit    = (1U << 18);
+
+inline std::atomic<uint32_t> value = { 0 };
+
+/// reads the flags from the environment if they have not been set
+uint32_t
+init();
+
+void
+set(bool _debug, int _verbose, bool _ci);
+
+inline uint32_t
+get()
+{
+    auto _v = value.load(std::memory_order_relaxed);
+    return (OMNITRACE_LIKELY((_v & valid_bit) != 0)) ? _v : init();
+}
+}  // namespace log_flags
+
+/// the verbosity level, or the maximum level when debugging is enabled
+inline int
+get_verbose_level()
+{
+    return static_cast<int16_t>(
+        static_cast<uint16_t>(log_flags::get() & log_flags::verbose_mask));
+}
+
+inline bool
+get_debug_enabled()
+{
+    return (log_flags::get() & log_flags::debug_bit) != 0;
+}
+
+inline bool
+get_ci_enabled()
+{
+    return (log_flags::get() & log_flags::ci_bit) != 0;
+}
+
 struct source_location
 {
     std::string_view function = {};
@@ -402,11 +462,11 @@ as_hex<void*>(void*, size_t);
 
 #define OMNITRACE_CI_THROW_E(COND, TYPE, ...)                                            \
     OMNITRACE_CONDITIONAL_THROW_E(                                                       \
-        ::omnitrace::get_is_continuous_integration() && (COND), TYPE, __VA_ARGS__)
+        ::omnitrace::debug::get_ci_enabled() && (COND), TYPE, __VA_ARGS__)
 
 #define OMNITRACE_CI_BASIC_THROW_E(COND, TYPE, ...)                                      \
     OMNITRACE_CONDITIONAL_BASIC_THROW_E(                                                 \
-        ::omnitrace::get_is_continuous_integration() && (COND), TYPE, __VA_ARGS__)
+        ::omnitrace::debug::get_ci_enabled() && (COND), TYPE, __VA_ARGS__)
 
 //--------------------------------------------------------------------------------------//
 
@@ -487,11 +547,11 @@ as_hex<void*>(void*, size_t);
 
 #define OMNITRACE_CI_FAILURE(COND, METHOD, ...)                                          \
     OMNITRACE_CONDITIONAL_FAILURE(                                                       \
-        ::omnitrace::get_is_continuous_integration() && (COND), METHOD, __VA_ARGS__)
+        ::omnitrace::debug::get_ci_enabled() && (COND), METHOD, __VA_ARGS__)
 
 #define OMNITRACE_CI_BASIC_FAILURE(COND, METHOD, ...)                                    \
     OMNITRACE_CONDITIONAL_BASIC_FAILURE(                                                 \
-        ::omnitrace::get_is_continuous_integration() && (COND), METHOD, __VA_ARGS__)
+        ::omnitrace::debug::get_ci_enabled() && (COND), METHOD, __VA_ARGS__)
 
 //--------------------------------------------------------------------------------------//
 
@@ -539,6 +599,23 @@ as_hex<void*>(void*, size_t);
 #define OMNITRACE_CI_BASIC_ABORT(COND, ...)                                              \
     OMNITRACE_CI_BASIC_FAILURE(COND, OMNITRACE_ESC(::std::abort()), __VA_ARGS__)
 
+//--------------------------------------------------------------------------------------//
+//
+//  Conditions of the debug, verbose, and warning macros. LEVEL is intentionally not
+//  parenthesized in the comparisons, e.g. a LEVEL of "2 || get_debug_sampling()" is
+//  enabled at a verbosity of 2 or when debugging the sampling. The comparison with
+//  OMNITRACE_MAX_VERBOSE_LEVEL removes the message at compile-time
+//
+//--------------------------------------------------------------------------------------//
+
+#define OMNITRACE_DEBUG_CONDITION                                                        \
+    (OMNITRACE_MAX_VERBOSE_LEVEL >= OMNITRACE_DEBUG_VERBOSE_LEVEL &&                     \
+     ::omnitrace::debug::get_debug_enabled())
+
+#define OMNITRACE_VERBOSE_CONDITION(LEVEL)                                               \
+    ((OMNITRACE_MAX_VERBOSE_LEVEL >= LEVEL) &&                                           \
+     (::omnitrace::debug::get_verbose_level() >= LEVEL))
+
 //--------------------------------------------------------------------------------------//
 //
 //  Debug macros
@@ -546,16 +623,16 @@ as_hex<void*>(void*, size_t);
 //--------------------------------------------------------------------------------------//
 
 #define OMNITRACE_DEBUG(...)                                                             \
-    OMNITRACE_CONDITIONAL_PRINT(::omnitrace::get_debug(), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_PRINT(OMNITRACE_DEBUG_CONDITION, __VA_ARGS__)
 
 #define OMNITRACE_BASIC_DEBUG(...)                                                       \
-    OMNITRACE_CONDITIONAL_BASIC_PRINT(::omnitrace::get_debug_env(), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_BASIC_PRINT(OMNITRACE_DEBUG_CONDITION, __VA_ARGS__)
 
 #define OMNITRACE_DEBUG_F(...)                                                           \
-    OMNITRACE_CONDITIONAL_PRINT_F(::omnitrace::get_debug(), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_PRINT_F(OMNITRACE_DEBUG_CONDITION, __VA_ARGS__)
 
 #define OMNITRACE_BASIC_DEBUG_F(...)                                                     \
-    OMNITRACE_CONDITIONAL_BASIC_PRINT_F(::omnitrace::get_debug_env(), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_BASIC_PRINT_F(OMNITRACE_DEBUG_CONDITION, __VA_ARGS__)
 
 //--------------------------------------------------------------------------------------//
 //
@@ -564,22 +641,16 @@ as_hex<void*>(void*, size_t);
 //--------------------------------------------------------------------------------------//
 
 #define OMNITRACE_VERBOSE(LEVEL, ...)                                                    \
-    OMNITRACE_CONDITIONAL_PRINT(                                                         \
-        ::omnitrace::get_debug() || (::omnitrace::get_verbose() >= LEVEL), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_PRINT(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 #define OMNITRACE_BASIC_VERBOSE(LEVEL, ...)                                              \
-    OMNITRACE_CONDITIONAL_BASIC_PRINT(::omnitrace::get_debug_env() ||                    \
-                                          (::omnitrace::get_verbose_env() >= LEVEL),     \
-                                      __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_BASIC_PRINT(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 #define OMNITRACE_VERBOSE_F(LEVEL, ...)                                                  \
-    OMNITRACE_CONDITIONAL_PRINT_F(                                                       \
-        ::omnitrace::get_debug() || (::omnitrace::get_verbose() >= LEVEL), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_PRINT_F(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 #define OMNITRACE_BASIC_VERBOSE_F(LEVEL, ...)                                            \
-    OMNITRACE_CONDITIONAL_BASIC_PRINT_F(::omnitrace::get_debug_env() ||                  \
-                                            (::omnitrace::get_verbose_env() >= LEVEL),   \
-                                        __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_BASIC_PRINT_F(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 //--------------------------------------------------------------------------------------//
 //
@@ -588,22 +659,16 @@ as_hex<void*>(void*, size_t);
 //--------------------------------------------------------------------------------------//
 
 #define OMNITRACE_WARNING(LEVEL, ...)                                                    \
-    OMNITRACE_CONDITIONAL_WARN(                                                          \
-        ::omnitrace::get_debug() || (::omnitrace::get_verbose() >= LEVEL), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_WARN(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 #define OMNITRACE_BASIC_WARNING(LEVEL, ...)                                              \
-    OMNITRACE_CONDITIONAL_BASIC_WARN(::omnitrace::get_debug_env() ||                     \
-                                         (::omnitrace::get_verbose_env() >= LEVEL),      \
-                                     __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_BASIC_WARN(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 #define OMNITRACE_WARNING_F(LEVEL, ...)                                                  \
-    OMNITRACE_CONDITIONAL_WARN_F(                                                        \
-        ::omnitrace::get_debug() || (::omnitrace::get_verbose() >= LEVEL), __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_WARN_F(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 #define OMNITRACE_BASIC_WARNING_F(LEVEL, ...)                                            \
-    OMNITRACE_CONDITIONAL_BASIC_WARN_F(::omnitrace::get_debug_env() ||                   \
-                                           (::omnitrace::get_verbose_env() >= LEVEL),    \
-                                       __VA_ARGS__)
+    OMNITRACE_CONDITIONAL_BASIC_WARN_F(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)
 
 #define OMNITRACE_WARNING_IF(COND, ...) OMNITRACE_CONDITIONAL_WARN((COND), __VA_ARGS__)
 
@@ -612,15 +677,13 @@ as_hex<void*>(void*, size_t);
 
 #define OMNITRACE_WARNING_OR_CI_THROW(LEVEL, ...)                                        \
     {                                                                                    \
-        if(OMNITRACE_UNLIKELY(::omnitrace::get_is_continuous_integration()))             \
+        if(OMNITRACE_UNLIKELY(::omnitrace::debug::get_ci_enabled()))                     \
         {                                                                                \
             OMNITRACE_CI_THROW(true, __VA_ARGS__);                                       \
         }                                                                                \
         else                                                                             \
         {                                                                                \
-            OMNITRACE_CONDITIONAL_WARN(::omnitrace::get_debug() ||                       \
-                                           (::omnitrace::get_verbose() >= LEVEL),        \
-                                       __VA_ARGS__)                                      \
+            OMNITRACE_CONDITIONAL_WARN(OMNITRACE_VERBOSE_CONDITION(LEVEL), __VA_ARGS__)  \
         }                                                                                \
     }
 
@@ -628,8 +691,8 @@ as_hex<void*>(void*, size_t);
 #define OMNITRACE_PREFER(COND)                                                           \
     ((OMNITRACE_LIKELY(COND))                                                            \
          ? ::tim::log::base()                                                            \
-         : ((::omnitrace::get_is_continuous_integration()) ? TIMEMORY_FATAL              \
-                                                           : TIMEMORY_WARNING))
+         : ((::omnitrace::debug::get_ci_enabled()) ? TIMEMORY_FATAL                      \
+                                                   : TIMEMORY_WARNING))
 
 //--------------------------------------------------------------------------------------//
 //
@@ -44,6 +44,8 @@
 
 #include <timemory/manager.hpp>
 
+#include <vector>
+
 #if OMNITRACE_USE_ROCM_SMI > 0
 #    include <rocm_smi/rocm_smi.h>
 #endif
@@ -493,6 +495,38 @@ add_hip_device_metadata(ArchiveT& ar)
 #endif
 }
 
+std::optional<uint64_t>
+hip_device_pci_id(int _device)
+{
+#if OMNITRACE_USE_HIP > 0
+    // the properties are read once since the query may be made during the finalization
+    static auto _ids = []() {
+        auto _v     = std::vector<std::optional<uint64_t>>{};
+        int  _count = 0;
+        if(hipGetDeviceCount(&_count) != hipSuccess) return _v;
+        for(int dev = 0; dev < _count; ++dev)
+        {
+            auto _prop = hipDeviceProp_t{};
+            if(hipGetDeviceProperties(&_prop, dev) != hipSuccess)
+            {
+                _v.emplace_back(std::nullopt);
+                continue;
+            }
+            _v.emplace_back((static_cast<uint64_t>(_prop.pciDomainID) << 32) |
+                            ((static_cast<uint64_t>(_prop.pciBusID) & 0xff) << 8) |
+                            ((static_cast<uint64_t>(_prop.pciDeviceID) & 0x1f) << 3));
+        }
+        return _v;
+    }();
+
+    if(_device < 0 || static_cast<size_t>(_device) >= _ids.size()) return std::nullopt;
+    return _ids.at(_device);
+#else
+    (void) _device;
+    return std::nullopt;
+#endif
+}
+
 void
 add_hip_device_metadata()
 {
@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <optional>
+
 namespace omnitrace
 {
 namespace gpu
@@ -37,5 +40,10 @@ rsmi_device_count();
 
 void
 add_hip_device_metadata();
+
+/// PCI domain, bus and device of a HIP device in the layout of the rocm-smi BDF id
+/// (without the function). Empty if HIP is not available or the query failed
+std::optional<uint64_t>
+hip_device_pci_id(int _device);
 }  // namespace gpu
 }  // namespace omnitrace
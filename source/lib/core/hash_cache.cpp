@@ -0,0 +1,45 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "core/hash_cache.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/hash.hpp>
+
+namespace omnitrace
+{
+namespace hash_cache
+{
+hash_value_t
+add_hash_id(std::string_view _name, entry& _entry)
+{
+    // a miss only happens once per string on each thread (or when the entry is
+    // evicted) so the registry is only locked when a thread sees a string first
+    auto _hash  = ::tim::add_hash_id(_name);
+    _entry.key  = _name.data();
+    _entry.name = ::tim::get_hash_identifier_fast(_hash);
+    _entry.hash = _hash;
+    return _hash;
+}
+}  // namespace hash_cache
+}  // namespace omnitrace
@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "common/defines.h"
+
+#include <timemory/hash/types.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+/// per-thread cache in front of the hash registry of timemory. tim::add_hash_id
+/// looks up (and, for new strings, inserts) the string in a map shared by all of the
+/// threads, which the instrumentation calls for every region. The cache is a
+/// direct-mapped table keyed by the address of the string: a hit compares the string
+/// with the registered identifier and returns the known hash without touching the
+/// registry. Strings at a different address or with different contents (e.g. a
+/// reused buffer) fall back to timemory
+namespace hash_cache
+{
+using hash_value_t = ::tim::hash_value_t;
+
+struct entry
+{
+    const char*      key  = nullptr;
+    std::string_view name = {};  // persistent identifier in the registry
+    hash_value_t     hash = 0;
+};
+
+/// registers the string with timemory and updates the entry of the cache
+hash_value_t
+add_hash_id(std::string_view _name, entry& _entry);
+
+/// same as tim::add_hash_id
+inline hash_value_t
+add_hash_id(std::string_view _name)
+{
+    constexpr size_t cache_size = 512;
+    static thread_local auto _cache = std::array<entry, cache_size>{};
+
+    // string literals are not aligned so the low bits are mixed into the index
+    auto  _addr  = reinterpret_cast<uintptr_t>(_name.data());
+    auto& _entry = _cache[(_addr ^ (_addr >> 9)) % cache_size];
+    if(OMNITRACE_LIKELY(_entry.key == _name.data() && _entry.hash != 0 &&
+                        _entry.name.size() == _name.size() &&
+                        (_entry.name.data() == _name.data() || _entry.name == _name)))
+        return _entry.hash;
+
+    return add_hash_id(_name, _entry);
+}
+}  // namespace hash_cache
+}  // namespace omnitrace
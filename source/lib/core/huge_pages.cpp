@@ -0,0 +1,328 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "core/huge_pages.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <linux/perf_event.h>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace huge_pages
+{
+namespace
+{
+struct mapping
+{
+    size_t  bytes = 0;
+    backing kind  = regular;
+};
+
+struct tlb_counter
+{
+    const char* name  = nullptr;
+    uint64_t    cache = 0;
+    int         fd    = -1;
+};
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+// intentionally leaked so the buffers which are released during the static
+// destruction are still found
+auto&
+get_mappings()
+{
+    static auto* _v = new std::map<void*, mapping>{};
+    return *_v;
+}
+
+auto&
+get_totals()
+{
+    static auto _v = std::array<size_t, count>{};
+    return _v;
+}
+
+auto&
+get_tlb_counters()
+{
+    static auto _v = std::array<tlb_counter, 2>{
+        tlb_counter{ "dTLB-load-misses", PERF_COUNT_HW_CACHE_DTLB, -1 },
+        tlb_counter{ "iTLB-load-misses", PERF_COUNT_HW_CACHE_ITLB, -1 }
+    };
+    return _v;
+}
+
+auto&
+get_tlb_start()
+{
+    static auto _v = std::chrono::steady_clock::time_point{};
+    return _v;
+}
+
+size_t
+get_base_page_size()
+{
+    static auto _v = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return _v;
+}
+
+size_t
+round_up(size_t _v, size_t _n)
+{
+    return ((_v + _n - 1) / _n) * _n;
+}
+
+// madvise(MADV_HUGEPAGE) succeeds when the transparent huge pages are disabled
+bool
+use_transparent()
+{
+    static auto _v = []() {
+        auto _ifs  = std::ifstream{ "/sys/kernel/mm/transparent_hugepage/enabled" };
+        auto _mode = std::string{};
+        if(!_ifs || !std::getline(_ifs, _mode)) return false;
+        return _mode.find("[never]") == std::string::npos;
+    }();
+    return _v;
+}
+
+void*
+map_hugetlb(size_t _bytes)
+{
+#if defined(MAP_HUGETLB)
+    int _flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE;
+#    if defined(MAP_HUGE_SHIFT)
+    _flags |= (21 << MAP_HUGE_SHIFT);
+#    endif
+    // the huge pages are reserved by mmap so an insufficient pool fails here instead
+    // of raising SIGBUS when the buffer is written
+    auto* _v = mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, _flags, -1, 0);
+    return (_v == MAP_FAILED) ? nullptr : _v;
+#else
+    (void) _bytes;
+    return nullptr;
+#endif
+}
+
+void*
+map_transparent(size_t _bytes)
+{
+#if defined(MADV_HUGEPAGE)
+    // over-allocate by a huge page and trim both ends so the buffer is aligned
+    auto  _len = _bytes + page_size;
+    auto* _v   = mmap(nullptr, _len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+    if(_v == MAP_FAILED) return nullptr;
+
+    auto _addr = reinterpret_cast<uintptr_t>(_v);
+    auto _beg  = round_up(_addr, page_size);
+    auto _end  = _beg + _bytes;
+    if(_beg > _addr) munmap(_v, _beg - _addr);
+    if(_addr + _len > _end) munmap(reinterpret_cast<void*>(_end), _addr + _len - _end);
+
+    auto* _ptr = reinterpret_cast<void*>(_beg);
+    if(madvise(_ptr, _bytes, MADV_HUGEPAGE) != 0)
+    {
+        munmap(_ptr, _bytes);
+        return nullptr;
+    }
+
+    // touch the pages after the advice so they are faulted in as huge pages
+    auto* _data = static_cast<volatile char*>(_ptr);
+    for(size_t i = 0; i < _bytes; i += get_base_page_size())
+        _data[i] = 0;
+    return _ptr;
+#else
+    (void) _bytes;
+    return nullptr;
+#endif
+}
+}  // namespace
+
+void*
+allocate(size_t _bytes)
+{
+    if(_bytes == 0) _bytes = 1;
+
+    void* _v    = nullptr;
+    auto  _len  = size_t{ 0 };
+    auto  _kind = regular;
+    if(config::get_use_huge_pages())
+    {
+        _len = round_up(_bytes, page_size);
+        if((_v = map_hugetlb(_len)) != nullptr)
+            _kind = hugetlb;
+        else if(use_transparent() && (_v = map_transparent(_len)) != nullptr)
+            _kind = transparent;
+        else
+        {
+            static std::atomic_flag _once = ATOMIC_FLAG_INIT;
+            if(!_once.test_and_set())
+                OMNITRACE_VERBOSE_F(1,
+                                    "Huge pages are not available (%s), the buffers use "
+                                    "the base pages\n",
+                                    strerror(errno));
+        }
+    }
+
+    if(_v == nullptr)
+    {
+        _len = round_up(_bytes, get_base_page_size());
+        _v   = mmap(nullptr, _len, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if(_v == MAP_FAILED) throw std::bad_alloc{};
+    }
+
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    get_mappings().emplace(_v, mapping{ _len, _kind });
+    get_totals().at(_kind) += _len;
+    return _v;
+}
+
+void
+deallocate(void* _ptr, size_t _bytes)
+{
+    if(_ptr == nullptr) return;
+
+    auto _len = round_up((_bytes == 0) ? 1 : _bytes, get_base_page_size());
+    {
+        std::unique_lock<std::mutex> _lk{ get_mutex() };
+        auto                         itr = get_mappings().find(_ptr);
+        if(itr != get_mappings().end())
+        {
+            _len = itr->second.bytes;
+            get_totals().at(itr->second.kind) -= _len;
+            get_mappings().erase(itr);
+        }
+    }
+    munmap(_ptr, _len);
+}
+
+size_t
+get_bytes(backing _kind)
+{
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    return get_totals().at(_kind);
+}
+
+const char*
+get_name(backing _kind)
+{
+    switch(_kind)
+    {
+        case regular: return "regular";
+        case hugetlb: return "hugetlb";
+        case transparent: return "transparent";
+        case count: break;
+    }
+    return "unknown";
+}
+
+void
+setup()
+{
+    if(!config::get_self_profile()) return;
+
+    for(auto& itr : get_tlb_counters())
+    {
+        if(itr.fd >= 0) continue;
+
+        auto _pe = perf_event_attr{};
+        memset(&_pe, 0, sizeof(_pe));
+        _pe.size   = sizeof(_pe);
+        _pe.type   = PERF_TYPE_HW_CACHE;
+        _pe.config = itr.cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        // the counts of the child threads are summed into the counter
+        _pe.inherit        = 1;
+        _pe.exclude_kernel = 1;
+        _pe.exclude_hv     = 1;
+        _pe.read_format =
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        auto _fd = syscall(__NR_perf_event_open, &_pe, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if(_fd < 0)
+        {
+            OMNITRACE_VERBOSE_F(1, "perf_event_open(%s) failed: %s\n", itr.name,
+                                strerror(errno));
+            continue;
+        }
+        itr.fd = static_cast<int>(_fd);
+    }
+    get_tlb_start() = std::chrono::steady_clock::now();
+}
+
+void
+report()
+{
+    OMNITRACE_VERBOSE_F(0, "Hot buffers of omnitrace (OMNITRACE_HUGE_PAGES=%s):\n",
+                        config::get_use_huge_pages() ? "ON" : "OFF");
+    for(size_t i = 0; i < count; ++i)
+    {
+        auto _kind = static_cast<backing>(i);
+        OMNITRACE_VERBOSE_F(0, "    %-11s :: %10.3f MB\n", get_name(_kind),
+                            static_cast<double>(get_bytes(_kind)) / (1024 * 1024));
+    }
+
+    auto _elapsed = std::chrono::duration<double, std::milli>{
+        std::chrono::steady_clock::now() - get_tlb_start()
+    }.count();
+    for(auto& itr : get_tlb_counters())
+    {
+        if(itr.fd < 0) continue;
+
+        uint64_t _data[3] = { 0, 0, 0 };  // value, time enabled, time running
+        if(read(itr.fd, _data, sizeof(_data)) == sizeof(_data))
+        {
+            // scale the value when the counter was multiplexed
+            auto _value = static_cast<double>(_data[0]);
+            if(_data[2] > 0 && _data[2] < _data[1])
+                _value *= static_cast<double>(_data[1]) / _data[2];
+            OMNITRACE_VERBOSE_F(0, "    %-17s :: %14.0f :: %12.1f per msec\n", itr.name,
+                                _value, (_elapsed > 0.0) ? _value / _elapsed : 0.0);
+        }
+        close(itr.fd);
+        itr.fd = -1;
+    }
+}
+}  // namespace huge_pages
+}  // namespace omnitrace
@@ -0,0 +1,108 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// 2 MB huge pages for the large buffers of omnitrace which are written on the hot
+/// paths (see OMNITRACE_HUGE_PAGES), e.g. the call-stack tables of the sampling
+/// signal handlers and the rings of the deferred perfetto regions. A buffer is mapped
+/// from the reserved huge pages (MAP_HUGETLB) when possible, otherwise from 2 MB
+/// aligned memory advised for transparent huge pages (MADV_HUGEPAGE). The buffers are
+/// prefaulted when they are allocated so the hot paths do not page-fault
+namespace huge_pages
+{
+constexpr size_t page_size = 2 * 1024 * 1024;
+
+enum backing : uint8_t
+{
+    regular = 0,  ///< base pages, i.e. OMNITRACE_HUGE_PAGES is disabled or failed
+    hugetlb,      ///< reserved huge pages (/proc/sys/vm/nr_hugepages)
+    transparent,  ///< transparent huge pages
+    count
+};
+
+/// zero-initialized anonymous memory which is page-aligned. Throws std::bad_alloc if
+/// the memory cannot be mapped
+void*
+allocate(size_t _bytes);
+
+void
+deallocate(void* _ptr, size_t _bytes);
+
+/// the bytes which are currently mapped with the backing
+size_t
+get_bytes(backing);
+
+const char*
+get_name(backing);
+
+/// opens the process-wide dTLB and iTLB miss counters of the self-profile
+/// (OMNITRACE_SELF_PROFILE). Must be called by the main thread before the other
+/// threads are created since only the threads created afterwards are counted
+void
+setup();
+
+/// prints the bytes of each backing and the TLB misses of the process
+void
+report();
+
+/// allocator of the containers of the hot buffers
+template <typename Tp>
+struct allocator
+{
+    using value_type = Tp;
+
+    allocator() = default;
+
+    template <typename Up>
+    allocator(const allocator<Up>&) noexcept
+    {}
+
+    Tp* allocate(size_t _n)
+    {
+        return static_cast<Tp*>(huge_pages::allocate(_n * sizeof(Tp)));
+    }
+
+    void deallocate(Tp* _ptr, size_t _n) noexcept
+    {
+        huge_pages::deallocate(_ptr, _n * sizeof(Tp));
+    }
+
+    template <typename Up>
+    bool operator==(const allocator<Up>&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename Up>
+    bool operator!=(const allocator<Up>&) const noexcept
+    {
+        return false;
+    }
+};
+}  // namespace huge_pages
+}  // namespace omnitrace
@@ -0,0 +1,168 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+#    include <mpi.h>
+
+#    include <algorithm>
+#    include <limits>
+#endif
+
+namespace omnitrace
+{
+/// tree reductions of per-rank data over MPI. The data of each rank is an opaque
+/// buffer and the merge function combines the buffer received from a child rank into
+/// the local buffer, e.g. by appending it or by deserializing and summing it:
+///
+///     void merge(buffer_t& _dst, buffer_t&& _src);
+///
+/// The data of the lower rank is always the destination so appending preserves the
+/// rank order within each level of the tree
+namespace mpi_reduce
+{
+using buffer_t = std::vector<char>;
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+/// binomial tree reduction onto rank 0 of the communicator: at step N, the ranks with
+/// bit N set send their (already reduced) buffer to the rank 2^N below them and drop
+/// out. The buffer of every rank except rank 0 is empty afterwards
+template <typename MergeT>
+void
+binomial(MPI_Comm _comm, buffer_t& _data, MergeT&& _merge)
+{
+    constexpr uint64_t max_chunk = std::numeric_limits<int>::max();
+
+    int _rank = 0;
+    int _size = 1;
+    MPI_Comm_rank(_comm, &_rank);
+    MPI_Comm_size(_comm, &_size);
+
+    for(int _step = 1; _step < _size; _step <<= 1)
+    {
+        if((_rank & _step) != 0)
+        {
+            uint64_t _n    = _data.size();
+            int      _dest = _rank - _step;
+            MPI_Send(&_n, 1, MPI_UINT64_T, _dest, 0, _comm);
+            for(uint64_t i = 0; i < _n; i += max_chunk)
+                MPI_Send(_data.data() + i, static_cast<int>(std::min(max_chunk, _n - i)),
+                         MPI_CHAR, _dest, 1, _comm);
+            buffer_t{}.swap(_data);
+            return;
+        }
+
+        if(_rank + _step < _size)
+        {
+            uint64_t _n   = 0;
+            int      _src = _rank + _step;
+            MPI_Recv(&_n, 1, MPI_UINT64_T, _src, 0, _comm, MPI_STATUS_IGNORE);
+            auto _recv = buffer_t(_n);
+            for(uint64_t i = 0; i < _n; i += max_chunk)
+                MPI_Recv(_recv.data() + i, static_cast<int>(std::min(max_chunk, _n - i)),
+                         MPI_CHAR, _src, 1, _comm, MPI_STATUS_IGNORE);
+            _merge(_data, std::move(_recv));
+        }
+    }
+}
+
+/// reduces the data of the ranks on each node onto the lowest rank of the node and
+/// then reduces those onto rank 0 of MPI_COMM_WORLD so the traffic between nodes
+/// takes log2(nodes) steps. Returns false and leaves the data unchanged if MPI is not
+/// initialized (or already finalized)
+template <typename MergeT>
+bool
+hierarchical(buffer_t& _data, MergeT&& _merge)
+{
+    int _initialized = 0;
+    int _finalized   = 0;
+    MPI_Initialized(&_initialized);
+    MPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0) return false;
+
+    int _rank      = 0;
+    int _node_rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+
+    MPI_Comm _node_comm   = MPI_COMM_NULL;
+    MPI_Comm _leader_comm = MPI_COMM_NULL;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, _rank, MPI_INFO_NULL,
+                        &_node_comm);
+    MPI_Comm_rank(_node_comm, &_node_rank);
+    MPI_Comm_split(MPI_COMM_WORLD, (_node_rank == 0) ? 0 : MPI_UNDEFINED, _rank,
+                   &_leader_comm);
+
+    binomial(_node_comm, _data, _merge);
+    if(_leader_comm != MPI_COMM_NULL)
+    {
+        binomial(_leader_comm, _data, _merge);
+        MPI_Comm_free(&_leader_comm);
+    }
+    MPI_Comm_free(&_node_comm);
+    return true;
+}
+
+/// reduces the data of the ranks on each node onto the lowest rank of the node. The
+/// ranks which hold the data of a node afterwards are flagged by _leader. Returns false
+/// and leaves the data unchanged if MPI is not initialized (or already finalized)
+template <typename MergeT>
+bool
+node(buffer_t& _data, MergeT&& _merge, bool& _leader)
+{
+    int _initialized = 0;
+    int _finalized   = 0;
+    MPI_Initialized(&_initialized);
+    MPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0) return false;
+
+    int _rank      = 0;
+    int _node_rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+
+    MPI_Comm _node_comm = MPI_COMM_NULL;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, _rank, MPI_INFO_NULL,
+                        &_node_comm);
+    MPI_Comm_rank(_node_comm, &_node_rank);
+
+    binomial(_node_comm, _data, _merge);
+    MPI_Comm_free(&_node_comm);
+    _leader = (_node_rank == 0);
+    return true;
+}
+
+/// merge function which appends the buffers
+inline void
+append(buffer_t& _dst, buffer_t&& _src)
+{
+    if(_dst.empty())
+        _dst = std::move(_src);
+    else
+        _dst.insert(_dst.end(), _src.begin(), _src.end());
+}
+#endif
+}  // namespace mpi_reduce
+}  // namespace omnitrace
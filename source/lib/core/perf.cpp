@@ -22,8 +22,16 @@
 
 #include "perf.hpp"
 #include "debug.hpp"
+#include "utility.hpp"
 
 #include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <dirent.h>
+#include <fstream>
+#include <string>
 
 namespace omnitrace
 {
@@ -31,6 +39,77 @@ namespace perf
 {
 namespace units = ::tim::units;
 
+namespace
+{
+std::string
+read_sysfs(const std::string& _path)
+{
+    auto _ifs = std::ifstream{ _path };
+    auto _v   = std::string{};
+    if(_ifs) std::getline(_ifs, _v);
+    return _v;
+}
+
+// writes the value into the bits of a field of the PMU format, e.g. "config1:0-15"
+void
+set_pmu_format(struct perf_event_attr& _pe, const std::string& _format, uint64_t _value)
+{
+    auto  _pos   = _format.find(':');
+    auto  _name  = _format.substr(0, _pos);
+    auto* _field = (_name == "config")    ? &_pe.config
+                   : (_name == "config1") ? &_pe.config1
+                   : (_name == "config2") ? &_pe.config2
+                                          : nullptr;
+    OMNITRACE_CONDITIONAL_THROW(_field == nullptr || _pos == std::string::npos,
+                                "unsupported perf PMU format: %s", _format.c_str());
+
+    size_t _bit = 0;
+    for(const auto& itr : tim::delimit(_format.substr(_pos + 1), ","))
+    {
+        auto _dash = itr.find('-');
+        auto _lo   = std::stoul(itr.substr(0, _dash));
+        auto _hi   = _lo;
+        if(_dash != std::string::npos) _hi = std::stoul(itr.substr(_dash + 1));
+        for(auto i = _lo; i <= _hi && i < 64; ++i, ++_bit)
+        {
+            *_field &= ~(1UL << i);
+            if(_bit < 64 && ((_value >> _bit) & 1) != 0) *_field |= (1UL << i);
+        }
+    }
+}
+
+// the terms are either a field and a value (e.g. "ldlat=30"), a field which is set
+// to one (e.g. "any") or the name of an event whose terms are read from sysfs
+void
+set_pmu_terms(struct perf_event_attr& _pe, const std::string& _dir,
+              const std::string& _terms, int _depth)
+{
+    OMNITRACE_CONDITIONAL_THROW(_depth > 4, "recursive perf PMU event: %s",
+                                _terms.c_str());
+
+    for(const auto& itr : tim::delimit(_terms, ","))
+    {
+        auto _pos    = itr.find('=');
+        auto _key    = itr.substr(0, _pos);
+        auto _format = read_sysfs(_dir + "/format/" + _key);
+        if(!_format.empty())
+        {
+            auto _value = 1UL;
+            if(_pos != std::string::npos)
+                _value = std::stoul(itr.substr(_pos + 1), nullptr, 0);
+            set_pmu_format(_pe, _format, _value);
+            continue;
+        }
+
+        auto _event = read_sysfs(_dir + "/events/" + _key);
+        OMNITRACE_CONDITIONAL_THROW(_event.empty() || _pos != std::string::npos,
+                                    "unknown term '%s' of perf PMU %s", itr.c_str(),
+                                    _dir.c_str());
+        set_pmu_terms(_pe, _dir, _event, _depth + 1);
+    }
+}
+}  // namespace
+
 std::vector<std::string>
 get_config_choices()
 {
@@ -197,11 +276,8 @@ get_hw_cache_config(std::string_view _v)
 }
 
 void
-config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
-                         double _freq)
+config_event(struct perf_event_attr& _pe, std::string_view _event)
 {
-    auto _period = (1.0 / _freq) * units::sec;
-
     _pe.type = static_cast<int>(perf::get_event_type(_event));
     switch(_pe.type)
     {
@@ -229,6 +305,26 @@ config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
             OMNITRACE_THROW("unsupported perf type");
         }
     };
+}
+
+void
+config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
+                         double _freq)
+{
+    auto _period = (1.0 / _freq) * units::sec;
+
+    if(is_pmu_event(_event))
+    {
+        config_pmu_event(_pe, _event);
+        _pe.sample_period = static_cast<uint64_t>(_freq);
+        // IBS ignores the 4 low bits of the period and the older kernels reject a
+        // period which sets them
+        if(is_ibs_event(_event))
+            _pe.sample_period = std::max<uint64_t>(_pe.sample_period & ~0xfUL, 0x10);
+        return;
+    }
+
+    config_event(_pe, _event);
 
     if(_pe.type == PERF_TYPE_SOFTWARE &&
        (_pe.config == PERF_COUNT_SW_CPU_CLOCK || _pe.config == PERF_COUNT_SW_TASK_CLOCK))
@@ -240,5 +336,92 @@ config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
         _pe.sample_period = static_cast<uint64_t>(_freq);
     }
 }
+
+bool
+is_pmu_event(std::string_view _event)
+{
+    auto _pos = _event.find('/');
+    return (_pos != std::string_view::npos && _pos > 0);
+}
+
+bool
+is_ibs_event(std::string_view _event)
+{
+    return is_pmu_event(_event) &&
+           (_event.find("ibs_op/") == 0 || _event.find("ibs_fetch/") == 0);
+}
+
+void
+config_pmu_event(struct perf_event_attr& _pe, std::string_view _event)
+{
+    auto _spec = std::string{ _event };
+    auto _pos  = _spec.find('/');
+    OMNITRACE_CONDITIONAL_THROW(_pos == std::string::npos || _pos == 0,
+                                "invalid perf PMU event '%s' (expected <pmu>/<terms>/)",
+                                _spec.c_str());
+
+    auto _dir   = "/sys/bus/event_source/devices/" + _spec.substr(0, _pos);
+    auto _terms = _spec.substr(_pos + 1);
+    if(!_terms.empty() && _terms.back() == '/') _terms.pop_back();
+
+    auto _type = read_sysfs(_dir + "/type");
+    OMNITRACE_CONDITIONAL_THROW(_type.empty(), "perf PMU '%s' is not available",
+                                _spec.substr(0, _pos).c_str());
+
+    _pe.type = static_cast<uint32_t>(std::stoul(_type));
+    if(!_terms.empty()) set_pmu_terms(_pe, _dir, _terms, 0);
+}
+
+std::vector<std::string>
+get_pmu_instances(std::string_view _name)
+{
+    auto _v   = std::vector<std::string>{};
+    auto _pos = _name.find('*');
+    if(_pos == std::string_view::npos)
+    {
+        auto _pmu = std::string{ _name };
+        if(!read_sysfs("/sys/bus/event_source/devices/" + _pmu + "/type").empty())
+            _v.emplace_back(_pmu);
+        return _v;
+    }
+
+    auto _prefix = _name.substr(0, _pos);
+    auto _suffix = _name.substr(_pos + 1);
+    auto _match  = [_prefix, _suffix](std::string_view _pmu) {
+        if(_pmu.size() <= _prefix.size() + _suffix.size()) return false;
+        if(_pmu.substr(0, _prefix.size()) != _prefix) return false;
+        if(_pmu.substr(_pmu.size() - _suffix.size()) != _suffix) return false;
+        auto _index =
+            _pmu.substr(_prefix.size(), _pmu.size() - _prefix.size() - _suffix.size());
+        return std::all_of(_index.begin(), _index.end(),
+                           [](char _c) { return std::isdigit(_c) != 0; });
+    };
+
+    auto* _dir = opendir("/sys/bus/event_source/devices");
+    if(!_dir) return _v;
+    while(auto* _entry = readdir(_dir))
+    {
+        if(_match(_entry->d_name)) _v.emplace_back(_entry->d_name);
+    }
+    closedir(_dir);
+
+    // numeric order of the index, i.e. uncore_imc_2 before uncore_imc_10
+    std::sort(_v.begin(), _v.end(), [](const std::string& _lhs, const std::string& _rhs) {
+        return (_lhs.size() == _rhs.size()) ? (_lhs < _rhs) : (_lhs.size() < _rhs.size());
+    });
+    return _v;
+}
+
+std::vector<int>
+get_pmu_cpus(std::string_view _pmu)
+{
+    auto _path = "/sys/bus/event_source/devices/" + std::string{ _pmu } + "/cpumask";
+    auto _mask = read_sysfs(_path);
+    auto _v    = std::vector<int>{};
+    if(_mask.empty()) return _v;
+    for(auto itr : utility::parse_numeric_range<>(_mask, "CPUs", 1L))
+        _v.emplace_back(static_cast<int>(itr));
+    return _v;
+}
 }  // namespace perf
 }  // namespace omnitrace
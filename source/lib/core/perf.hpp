@@ -28,6 +28,9 @@
 
 #include <cstdint>
 #include <linux/perf_event.h>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #if __GLIBC__ == 2 && __GLIBC_MINOR__ < 30
 #    include <sys/syscall.h>
@@ -285,7 +288,40 @@ hw_config  get_hw_config(std::string_view);
 sw_config  get_sw_config(std::string_view);
 int        get_hw_cache_config(std::string_view);
 
+/// sets the type and the config of the event, e.g. PERF_COUNT_HW_INSTRUCTIONS
+void
+config_event(struct perf_event_attr&, std::string_view);
+
+/// sets the event and the sampling period. The events in the perf syntax of a PMU
+/// (see config_pmu_event), e.g. "ibs_op//", are sampled every <value> events
 void
 config_overflow_sampling(struct perf_event_attr&, std::string_view, double);
+
+/// check if the event uses the perf syntax of a PMU, i.e. "<pmu>/<terms>/"
+bool
+is_pmu_event(std::string_view);
+
+/// check if the event is sampled by the instruction-based sampling (IBS) of the AMD
+/// CPUs, i.e. the ibs_op or ibs_fetch PMU
+bool
+is_ibs_event(std::string_view);
+
+/// sets the type and the config fields of an event of a PMU in sysfs with the syntax
+/// of perf, e.g. "cpu/mem-loads,ldlat=30/" or "cpu/event=0xcd,umask=0x1/". The event
+/// names and the fields are read from /sys/bus/event_source/devices/<pmu>
+void
+config_pmu_event(struct perf_event_attr&, std::string_view);
+
+/// the names of the PMUs in sysfs which match the name. A '*' matches the decimal index
+/// of the instances of a PMU, e.g. "uncore_imc_*" matches uncore_imc_0 and uncore_imc_1
+/// but not uncore_imc_free_running_0
+std::vector<std::string>
+get_pmu_instances(std::string_view);
+
+/// the CPUs which the system-wide events of a PMU are opened on, i.e. the cpumask of
+/// the uncore PMUs (usually the first CPU of each socket). Empty if the PMU does not
+/// provide a cpumask
+std::vector<int>
+get_pmu_cpus(std::string_view);
 }  // namespace perf
 }  // namespace omnitrace
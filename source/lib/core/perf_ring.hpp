@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <linux/perf_event.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace omnitrace
+{
+namespace perf
+{
+/// header-only access to the data pages of the ring buffer of a perf_event, i.e. the
+/// pages mapped after the metadata page. Shared by perf_event in the library and the
+/// executables which do not link it (e.g. the attach sampling of omnitrace-instrument)
+namespace ring
+{
+/// copies _nbytes at the _index (offset since the start of the sampling) of the data
+/// pages, which may wrap around the end of the data pages
+inline void
+copy(const void* _data, size_t _data_size, uint64_t _index, void* _dest, size_t _nbytes)
+{
+    const auto* _base  = static_cast<const char*>(_data);
+    auto        _pos   = static_cast<size_t>(_index % _data_size);
+    auto        _first = (_nbytes < _data_size - _pos) ? _nbytes : (_data_size - _pos);
+    memcpy(_dest, _base + _pos, _first);
+    memcpy(static_cast<char*>(_dest) + _first, _base, _nbytes - _first);
+}
+
+/// the end of the records written by the kernel. The acquire pairs with the update of
+/// the kernel so the records before the head are visible
+inline uint64_t
+load_head(const perf_event_mmap_page* _meta)
+{
+    return __atomic_load_n(&_meta->data_head, __ATOMIC_ACQUIRE);
+}
+
+/// releases the records before the tail to the kernel once they have been copied
+inline void
+store_tail(perf_event_mmap_page* _meta, uint64_t _tail)
+{
+    __atomic_store_n(&_meta->data_tail, _tail, __ATOMIC_RELEASE);
+}
+
+/// invokes _func(const perf_event_header&, const char* _record) for every complete
+/// record between the tail and the head, where _record is a contiguous copy of the
+/// record including its header, then releases them. Returns the number of records
+template <typename FuncT>
+size_t
+drain(perf_event_mmap_page* _meta, const void* _data, size_t _data_size, FuncT&& _func)
+{
+    auto   _head   = load_head(_meta);
+    auto   _tail   = _meta->data_tail;
+    auto   _record = std::vector<char>{};
+    size_t _n      = 0;
+    while(_tail + sizeof(perf_event_header) <= _head)
+    {
+        auto _hdr = perf_event_header{};
+        copy(_data, _data_size, _tail, &_hdr, sizeof(_hdr));
+        if(_hdr.size < sizeof(_hdr) || _tail + _hdr.size > _head) break;
+
+        _record.resize(_hdr.size);
+        copy(_data, _data_size, _tail, _record.data(), _record.size());
+        _func(_hdr, static_cast<const char*>(_record.data()));
+        _tail += _hdr.size;
+        ++_n;
+    }
+    store_tail(_meta, _tail);
+    return _n;
+}
+}  // namespace ring
+}  // namespace perf
+}  // namespace omnitrace
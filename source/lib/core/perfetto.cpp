@@ -21,11 +21,27 @@
 // SOFTWARE.
 
 #include "perfetto.hpp"
+#include "clock_sync.hpp"
+#include "compression.hpp"
 #include "config.hpp"
 #include "library/runtime.hpp"
+#include "mpi_reduce.hpp"
 #include "perfetto_fwd.hpp"
+#include "rank_selection.hpp"
 #include "utility.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
 namespace omnitrace
 {
 namespace perfetto
@@ -47,6 +63,139 @@ get_perfetto_tmp_file(pid_t _pid = process::get_id())
     return _v.at(_pid);
 }
 
+// the flight recorder keeps the data in memory and combined traces are gathered at
+// finalization so neither can write the trace into the output file as it is collected
+bool
+use_streaming()
+{
+    return (config::get_perfetto_streaming() || config::get_perfetto_auto_size()) &&
+           !config::get_use_flight_recorder() && !config::get_perfetto_combined_traces();
+}
+
+// the auto-sized buffer only has to hold the data between the writes into the file
+bool
+use_auto_size()
+{
+    return config::get_perfetto_auto_size() && use_streaming();
+}
+
+// output file of a streaming session. empty until the session is first started
+auto&
+get_streaming_filename(pid_t _pid = process::get_id())
+{
+    static auto _v = std::unordered_map<pid_t, std::string>{};
+    return _v[_pid];
+}
+
+// serializes dumping the session with finalizing it
+auto&
+get_session_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+bool
+read_varint(const char*& _p, const char* _end, uint64_t& _v)
+{
+    _v = 0;
+    for(int _shift = 0; _p < _end && _shift < 64; _shift += 7)
+    {
+        auto _byte = static_cast<uint8_t>(*_p++);
+        _v |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+        if((_byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+void
+write_varint(std::vector<char>& _out, uint64_t _v)
+{
+    while(_v >= 0x80)
+    {
+        _out.emplace_back(static_cast<char>((_v & 0x7f) | 0x80));
+        _v >>= 7;
+    }
+    _out.emplace_back(static_cast<char>(_v));
+}
+
+// skips the value of a field with the given wire type
+bool
+skip_field(const char*& _p, const char* _end, uint64_t _wire_type)
+{
+    uint64_t _n = 0;
+    switch(_wire_type)
+    {
+        case 0: return read_varint(_p, _end, _n);
+        case 1: _n = 8; break;
+        case 2:
+            if(!read_varint(_p, _end, _n)) return false;
+            break;
+        case 5: _n = 4; break;
+        default: return false;
+    }
+    if(_n > static_cast<uint64_t>(_end - _p)) return false;
+    _p += _n;
+    return true;
+}
+
+// a serialized trace is a sequence of TracePacket messages (field 1 of Trace) and the
+// timestamp is field 8 of TracePacket. The timestamp of every packet is converted
+// onto the clock of rank 0 and every other field is copied verbatim. Returns false
+// (and leaves the trace unchanged) if the data cannot be decoded
+bool
+correct_timestamps(std::vector<char>& _data)
+{
+    constexpr uint64_t packet_tag    = (1 << 3) | 2;
+    constexpr uint64_t timestamp_tag = (8 << 3) | 0;
+
+    auto        _out    = std::vector<char>{};
+    auto        _packet = std::vector<char>{};
+    const char* _p      = _data.data();
+    const char* _end    = _data.data() + _data.size();
+
+    _out.reserve(_data.size() + (_data.size() / 16));
+    while(_p < _end)
+    {
+        uint64_t _tag = 0;
+        uint64_t _len = 0;
+        if(!read_varint(_p, _end, _tag) || _tag != packet_tag ||
+           !read_varint(_p, _end, _len) || _len > static_cast<uint64_t>(_end - _p))
+            return false;
+
+        const char* _pp   = _p;
+        const char* _pend = _p + _len;
+        _p                = _pend;
+
+        _packet.clear();
+        while(_pp < _pend)
+        {
+            const char* _field = _pp;
+            uint64_t    _ftag  = 0;
+            if(!read_varint(_pp, _pend, _ftag)) return false;
+            if(_ftag == timestamp_tag)
+            {
+                uint64_t _ts = 0;
+                if(!read_varint(_pp, _pend, _ts)) return false;
+                write_varint(_packet, timestamp_tag);
+                write_varint(_packet, clock_sync::correct(_ts));
+            }
+            else
+            {
+                if(!skip_field(_pp, _pend, _ftag & 0x7)) return false;
+                _packet.insert(_packet.end(), _field, _pp);
+            }
+        }
+
+        write_varint(_out, packet_tag);
+        write_varint(_out, _packet.size());
+        _out.insert(_out.end(), _packet.begin(), _packet.end());
+    }
+
+    _data = std::move(_out);
+    return true;
+}
+
 auto&
 get_config()
 {
@@ -63,6 +212,203 @@ get_session(pid_t _pid = process::get_id())
         _v.emplace(_pid, std::unique_ptr<::perfetto::TracingSession>{});
     return _v.at(_pid);
 }
+
+// statistics of the trace buffer. Every (re-)started session begins with new
+// statistics so the statistics of the stopped sessions are accumulated
+struct buffer_stats
+{
+    size_t bytes_written      = 0;
+    size_t chunks_written     = 0;
+    size_t chunks_discarded   = 0;
+    size_t chunks_overwritten = 0;
+
+    size_t dropped() const { return chunks_discarded + chunks_overwritten; }
+
+    double drop_rate() const
+    {
+        auto _total = chunks_written + chunks_discarded;
+        return (_total > 0) ? static_cast<double>(dropped()) / _total : 0.0;
+    }
+
+    buffer_stats& operator+=(const buffer_stats& _rhs)
+    {
+        bytes_written += _rhs.bytes_written;
+        chunks_written += _rhs.chunks_written;
+        chunks_discarded += _rhs.chunks_discarded;
+        chunks_overwritten += _rhs.chunks_overwritten;
+        return *this;
+    }
+
+    buffer_stats operator-(const buffer_stats& _rhs) const
+    {
+        auto _v               = *this;
+        _v.bytes_written      = bytes_written - _rhs.bytes_written;
+        _v.chunks_written     = chunks_written - _rhs.chunks_written;
+        _v.chunks_discarded   = chunks_discarded - _rhs.chunks_discarded;
+        _v.chunks_overwritten = chunks_overwritten - _rhs.chunks_overwritten;
+        return _v;
+    }
+};
+
+auto&
+get_buffer_stats(pid_t _pid = process::get_id())
+{
+    static auto _v = std::unordered_map<pid_t, buffer_stats>{};
+    return _v[_pid];
+}
+
+buffer_stats
+read_buffer_stats(::perfetto::TracingSession* _session)
+{
+    auto _v = buffer_stats{};
+    if(!_session) return _v;
+
+    auto _args  = _session->GetTraceStatsBlocking();
+    auto _stats = ::perfetto::protos::gen::TraceStats{};
+    if(!_args.success || !_stats.ParseFromArray(_args.trace_stats_data.data(),
+                                                _args.trace_stats_data.size()))
+        return _v;
+
+    for(const auto& itr : _stats.buffer_stats())
+    {
+        _v.bytes_written += itr.bytes_written();
+        _v.chunks_written += itr.chunks_written();
+        _v.chunks_discarded += itr.chunks_discarded();
+        _v.chunks_overwritten += itr.chunks_overwritten();
+    }
+    return _v;
+}
+
+// the buffer size (in KB) selected by the auto-sizing and its monitor thread. The
+// objects are never deleted so the thread of the parent is never destroyed by a forked
+// child
+struct auto_size_state
+{
+    bool                         stop        = false;
+    size_t                       buffer_size = 0;
+    std::mutex                   mutex       = {};
+    std::condition_variable      cv          = {};
+    std::unique_ptr<std::thread> thread      = {};
+};
+
+auto*
+get_auto_size_state(pid_t _pid = process::get_id())
+{
+    static auto _v = std::unordered_map<pid_t, auto_size_state*>{};
+    auto*&      _p = _v[_pid];
+    if(!_p) _p = new auto_size_state{};
+    return _p;
+}
+
+// size (in KB) of the buffer which holds the data produced at the given rate (in bytes
+// per second) between two writes into the output file. The factor of two is headroom
+// for bursts and for the time the tracing service needs to write the data
+size_t
+get_auto_buffer_size(double _rate)
+{
+    auto _period = static_cast<double>(config::get_perfetto_flush_period()) / 1000.0;
+    auto _size   = static_cast<size_t>(2.0 * _rate * _period / units::KB);
+    _size        = std::max(_size, config::get_perfetto_shmem_size_hint());
+    return std::min(_size, config::get_perfetto_auto_size_max());
+}
+
+void
+auto_size_monitor(auto_size_state* _state)
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.perfetto");
+
+    using clock_type = std::chrono::steady_clock;
+    using seconds_t  = std::chrono::duration<double>;
+
+    auto _warmup   = std::max(config::get_perfetto_auto_size_warmup(), 1.0e-3);
+    auto _interval = seconds_t{ _warmup };
+    auto _target   = config::get_perfetto_auto_size_drop_rate();
+    auto _max_size = config::get_perfetto_auto_size_max();
+    auto _beg      = clock_type::now();
+    auto _prev     = buffer_stats{};
+
+    auto _lk = std::unique_lock<std::mutex>{ _state->mutex };
+    while(!_state->cv.wait_for(_lk, _interval, [_state]() { return _state->stop; }))
+    {
+        _lk.unlock();
+        {
+            auto  _session_lk = std::unique_lock<std::mutex>{ get_session_mutex() };
+            auto& _session    = get_session();
+            if(!_session) return;
+
+            auto _curr = get_buffer_stats();
+            _curr += read_buffer_stats(_session.get());
+            auto _delta = _curr - _prev;
+            auto _size  = _state->buffer_size;
+            _prev       = _curr;
+
+            if(_state->buffer_size == 0)
+            {
+                auto _elapsed = seconds_t{ clock_type::now() - _beg }.count();
+                auto _rate    = _curr.bytes_written / _elapsed;
+                _size         = get_auto_buffer_size(_rate);
+                OMNITRACE_VERBOSE(1,
+                                  "[perfetto] %.3f MB/s of trace data during the "
+                                  "warm-up. Buffer size: %zu KB...\n",
+                                  _rate / units::MB, _size);
+                _interval = seconds_t{ std::max(
+                    _warmup, config::get_perfetto_flush_period() / 1000.0) };
+            }
+            else if(_delta.drop_rate() > _target && _size < _max_size)
+            {
+                _size = std::min(2 * _size, _max_size);
+                OMNITRACE_VERBOSE(1,
+                                  "[perfetto] %.3f%% of the chunks were dropped. Buffer "
+                                  "size: %zu KB...\n",
+                                  100.0 * _delta.drop_rate(), _size);
+            }
+
+            // the buffer of a session cannot be resized so the session is restarted.
+            // The streamed output file is appended
+            auto _restart = (_state->buffer_size == 0) ? (_size != _max_size)
+                                                       : (_size != _state->buffer_size);
+            _state->buffer_size = _size;
+            if(_restart)
+            {
+                stop();
+                start();
+                _prev = get_buffer_stats();
+            }
+        }
+        _lk.lock();
+    }
+}
+
+void
+stop_auto_size()
+{
+    auto* _state = get_auto_size_state();
+    if(!_state->thread) return;
+    {
+        auto _lk     = std::unique_lock<std::mutex>{ _state->mutex };
+        _state->stop = true;
+    }
+    _state->cv.notify_all();
+    _state->thread->join();
+    _state->thread.reset();
+}
+
+void
+report_buffer_stats()
+{
+    const auto& _stats = get_buffer_stats();
+    auto        _size  = (use_auto_size()) ? get_auto_size_state()->buffer_size
+                                           : config::get_perfetto_buffer_size();
+    // the dropped chunks are always reported
+    OMNITRACE_VERBOSE((_stats.dropped() > 0 || use_auto_size()) ? 0 : 1,
+                      "[perfetto] %zu chunks (%.2f MB) written into a %zu KB buffer. "
+                      "%zu chunks discarded, %zu chunks overwritten (%.3f%%)...\n",
+                      _stats.chunks_written,
+                      static_cast<double>(_stats.bytes_written) / units::MB, _size,
+                      _stats.chunks_discarded, _stats.chunks_overwritten,
+                      100.0 * _stats.drop_rate());
+}
 }  // namespace
 
 void
@@ -76,8 +422,21 @@ setup()
     auto shmem_size_hint = config::get_perfetto_shmem_size_hint();
     auto buffer_size     = config::get_perfetto_buffer_size();
 
+    // the shared memory cannot be resized after initialization so it is sized for the
+    // largest buffer. the warm-up uses the largest buffer so that the measured rate is
+    // not limited by dropped chunks
+    if(use_auto_size())
+    {
+        constexpr size_t max_shmem_size = 32768;
+        buffer_size                     = config::get_perfetto_auto_size_max();
+        shmem_size_hint =
+            std::max(shmem_size_hint, std::min(buffer_size / 64, max_shmem_size));
+    }
+
+    // the flight recorder always overwrites the oldest data
     auto _policy =
-        config::get_perfetto_fill_policy() == "discard"
+        (config::get_perfetto_fill_policy() == "discard" &&
+         !config::get_use_flight_recorder())
             ? ::perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_DISCARD
             : ::perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_RING_BUFFER;
     auto* buffer_config = cfg.add_buffers();
@@ -95,6 +454,16 @@ setup()
     ds_cfg->set_name("track_event");  // this MUST be track_event
     ds_cfg->set_track_event_config_raw(track_event_cfg.SerializeAsString());
 
+    if((config::get_perfetto_streaming() || config::get_perfetto_auto_size()) &&
+       !use_streaming())
+    {
+        OMNITRACE_VERBOSE_F(0, "OMNITRACE_PERFETTO_STREAMING and "
+                               "OMNITRACE_PERFETTO_AUTO_SIZE are not supported with "
+                               "OMNITRACE_FLIGHT_RECORDER or "
+                               "OMNITRACE_PERFETTO_COMBINE_TRACES and will be "
+                               "ignored...\n");
+    }
+
     args.shmem_size_hint_kb = shmem_size_hint;
 
     if(get_perfetto_backend() != "inprocess") args.backends |= ::perfetto::kSystemBackend;
@@ -114,8 +483,10 @@ start()
     if(!tracing_session) tracing_session = ::perfetto::Tracing::NewTrace();
 
     tracing_session = ::perfetto::Tracing::NewTrace();
+    // temporary files grow without bound so they are not used by the flight recorder
     auto& _tmp_file = get_perfetto_tmp_file();
-    if(config::get_use_tmp_files())
+    if(config::get_use_tmp_files() && !config::get_use_flight_recorder() &&
+       !use_streaming())
     {
         if(!_tmp_file)
         {
@@ -130,10 +501,51 @@ start()
     }
 
     OMNITRACE_VERBOSE(2, "Setup perfetto...\n");
-    int   _fd = (_tmp_file) ? _tmp_file->fd : -1;
-    auto& cfg = get_config();
+    int  _fd = (_tmp_file) ? _tmp_file->fd : -1;
+    auto cfg = get_config();
+
+    if(use_streaming())
+    {
+        // traces are a sequence of packets so a resumed session appends to the file.
+        // filepath::open creates the output directory and truncates the file. the
+        // tracing service takes ownership of the file descriptor
+        auto& _filename = get_streaming_filename();
+        if(_filename.empty())
+        {
+            _filename = config::get_perfetto_output_filename();
+            std::ofstream ofs{};
+            if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+                OMNITRACE_VERBOSE(0, "Error opening '%s'...\n", _filename.c_str());
+        }
+
+        _fd = ::open(_filename.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if(_fd < 0)
+        {
+            OMNITRACE_VERBOSE(0, "Error opening '%s' for streaming perfetto output: %s\n",
+                              _filename.c_str(), strerror(errno));
+            _filename.clear();
+        }
+        else
+        {
+            // the tracing service drains the buffer into the file on its own thread
+            auto _period = config::get_perfetto_flush_period();
+            auto _size   = get_auto_size_state()->buffer_size;
+            if(use_auto_size() && _size > 0)
+                cfg.mutable_buffers()->at(0).set_size_kb(_size);
+            cfg.set_write_into_file(true);
+            cfg.set_file_write_period_ms(_period);
+            cfg.set_flush_period_ms(_period);
+            OMNITRACE_VERBOSE(1, "Streaming perfetto output to '%s' every %zu ms...\n",
+                              _filename.c_str(), _period);
+        }
+    }
+
     tracing_session->Setup(cfg, _fd);
     tracing_session->StartBlocking();
+
+    auto* _state = get_auto_size_state();
+    if(use_auto_size() && !_state->thread)
+        _state->thread = std::make_unique<std::thread>(auto_size_monitor, _state);
 }
 
 void
@@ -151,6 +563,7 @@ stop()
         OMNITRACE_VERBOSE(2, "Flushing the perfetto trace data...\n");
         ::perfetto::TrackEvent::Flush();
         tracing_session->FlushBlocking();
+        get_buffer_stats() += read_buffer_stats(tracing_session.get());
 
         OMNITRACE_VERBOSE(2, "Stopping the perfetto trace session (blocking)...\n");
         tracing_session->StopBlocking();
@@ -162,11 +575,39 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
 {
     using char_vec_t = std::vector<char>;
 
+    // the monitor restarts the session while holding the session mutex
+    stop_auto_size();
+
+    auto _lk = std::unique_lock<std::mutex>{ get_session_mutex() };
+
     stop();
 
     auto& tracing_session = get_perfetto_session();
     if(!tracing_session) return;
 
+    report_buffer_stats();
+
+    // the data has already been written by the tracing service
+    if(use_streaming() && !get_streaming_filename().empty())
+    {
+        auto _filename = get_streaming_filename();
+        if(config::get_verbose() >= 0)
+        {
+            operation::file_output_message<tim::project::omnitrace> _fom{};
+            _fom(_filename, std::string{ "perfetto" }, " (streamed)... ");
+            _fom.append("%s", "Done");  // NOLINT
+        }
+        // the streamed file is complete once the session is stopped
+        if(compression::get_method() != "none")
+        {
+            compression::async([_filename]() { compression::compress_file(_filename); });
+            _filename += compression::get_extension(compression::get_method());
+        }
+        if(_timemory_manager)
+            _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
+        return;
+    }
+
     auto _get_session_data = [&tracing_session]() {
         auto _data     = char_vec_t{};
         auto _tmp_file = get_perfetto_tmp_file();
@@ -187,7 +628,7 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
             size_t _fnum_elem = ftell(_fdata);
             fseek(_fdata, 0, SEEK_SET);  // same as rewind(f);
 
-            _data.resize(_fnum_elem + 1);
+            _data.resize(_fnum_elem);
             auto _fnum_read = fread(_data.data(), sizeof(char), _fnum_elem, _fdata);
             fclose(_fdata);
 
@@ -201,36 +642,41 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
                                 char_vec_t{ tracing_session->ReadTraceBlocking() });
     };
 
+    // the timestamps of each rank are converted before the traces are combined. The
+    // ranks excluded by OMNITRACE_MPI_RANKS do not contribute to the output
+    auto _get_corrected_data = [&_get_session_data]() {
+        if(!rank_selection::is_selected()) return char_vec_t{};
+        auto _data = _get_session_data();
+        if(!clock_sync::available()) return _data;
+        if(!correct_timestamps(_data))
+            OMNITRACE_VERBOSE(0, "Warning! the perfetto trace could not be decoded, "
+                                 "the timestamps are not synchronized with rank 0\n");
+        return _data;
+    };
+
     auto trace_data = char_vec_t{};
 #if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
     if(get_perfetto_combined_traces())
     {
-        using perfetto_mpi_get_t = tim::operation::finalize::mpi_get<char_vec_t, true>;
-
-        auto _trace_data = _get_session_data();
-        auto _rank_data  = std::vector<char_vec_t>{};
-        auto _combine    = [](char_vec_t& _dst, const char_vec_t& _src) -> char_vec_t& {
-            _dst.reserve(_dst.size() + _src.size());
-            for(auto&& itr : _src)
-                _dst.emplace_back(itr);
-            return _dst;
-        };
-
-        perfetto_mpi_get_t{ get_perfetto_combined_traces(),
-                            settings::node_count() }(_rank_data, _trace_data, _combine);
-        for(auto& itr : _rank_data)
-            trace_data =
-                (trace_data.empty()) ? std::move(itr) : _combine(trace_data, itr);
+        trace_data = _get_corrected_data();
+        // a serialized trace is a sequence of packets so the traces of the ranks
+        // are appended without decoding them
+        if(!mpi_reduce::hierarchical(trace_data, mpi_reduce::append))
+            OMNITRACE_VERBOSE(0, "MPI is not available, perfetto traces will not be "
+                                 "combined...\n");
     }
     else
     {
-        trace_data = _get_session_data();
+        trace_data = _get_corrected_data();
     }
 #else
-    trace_data = _get_session_data();
+    trace_data = _get_corrected_data();
 #endif
 
     auto _filename = config::get_perfetto_output_filename();
+    auto _method   = compression::get_method();
+    if(_method != "none") _filename += compression::get_extension(_method);
+
     if(!trace_data.empty())
     {
         operation::file_output_message<tim::project::omnitrace> _fom{};
@@ -241,21 +687,43 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
                  static_cast<double>(trace_data.size()) / units::KB,
                  static_cast<double>(trace_data.size()) / units::MB,
                  static_cast<double>(trace_data.size()) / units::GB);
-        std::ofstream ofs{};
-        if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+
+        if(_method != "none")
         {
-            _fom.append("Error opening '%s'...", _filename.c_str());
-            _perfetto_output_error = true;
+            // the compression overlaps with the remainder of the finalization and is
+            // waited on before the process exits (or the output staging is drained)
+            compression::async(
+                [_filename, _method, _data = std::move(trace_data)]() {
+                    if(!compression::write(_filename, _data.data(), _data.size(),
+                                           _method))
+                        OMNITRACE_VERBOSE(0, "Error writing '%s'...\n",
+                                          _filename.c_str());
+                });
+            if(config::get_verbose() >= 0)
+                _fom.append("%s (%s in the background)", "Done",  // NOLINT
+                            _method.c_str());
+            if(_timemory_manager)
+                _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
         }
         else
         {
-            // Write the trace into a file.
-            ofs.write(&trace_data[0], trace_data.size());
-            if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
-            if(_timemory_manager)
-                _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
+            std::ofstream ofs{};
+            if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+            {
+                _fom.append("Error opening '%s'...", _filename.c_str());
+                _perfetto_output_error = true;
+            }
+            else
+            {
+                // Write the trace into a file.
+                ofs.write(&trace_data[0], trace_data.size());
+                if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+                if(_timemory_manager)
+                    _timemory_manager->add_file_output("protobuf", "perfetto",
+                                                       _filename);
+            }
+            ofs.close();
         }
-        ofs.close();
     }
     else if(dmp::rank() == 0)
     {
@@ -273,6 +741,55 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
     }
 }
 
+size_t
+get_buffer_size()
+{
+    if(is_system_backend()) return 0;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_session_mutex() };
+    if(!get_session() || get_config().buffers().empty()) return 0;
+
+    // the auto-sized buffer replaces the configured one after the warm-up
+    auto _size = (use_auto_size()) ? get_auto_size_state()->buffer_size : size_t{ 0 };
+    if(_size == 0) _size = get_config().buffers().at(0).size_kb();
+    return _size;
+}
+
+bool
+dump(const std::string& _filename)
+{
+    if(is_system_backend()) return false;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_session_mutex() };
+
+    auto& tracing_session = get_perfetto_session();
+    if(!tracing_session) return false;
+
+    stop();
+    auto _data = std::vector<char>{ tracing_session->ReadTraceBlocking() };
+    start();
+
+    if(_data.empty())
+    {
+        OMNITRACE_VERBOSE(0, "perfetto trace data is empty. File '%s' will not be "
+                             "written...\n",
+                          _filename.c_str());
+        return false;
+    }
+
+    std::ofstream ofs{};
+    if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+    {
+        OMNITRACE_VERBOSE(0, "Error opening '%s'...\n", _filename.c_str());
+        return false;
+    }
+
+    OMNITRACE_VERBOSE(0, "[perfetto] Outputting '%s' (%.2f KB / %.2f MB)...\n",
+                      _filename.c_str(), static_cast<double>(_data.size()) / units::KB,
+                      static_cast<double>(_data.size()) / units::MB);
+    ofs.write(_data.data(), _data.size());
+    return true;
+}
 }  // namespace perfetto
 
 std::unique_ptr<::perfetto::TracingSession>&
@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 namespace tim
 {
 class manager;
@@ -42,5 +45,15 @@ stop();
 
 void
 post_process(tim::manager*, bool&);
+
+/// writes the current contents of the in-process tracing session to the file and
+/// restarts the session. Returns false if nothing was written
+bool
+dump(const std::string&);
+
+/// size (in KB) of the buffer of the in-process tracing session. Zero when there is no
+/// session or the system backend holds the buffer
+size_t
+get_buffer_size();
 }  // namespace perfetto
 }  // namespace omnitrace
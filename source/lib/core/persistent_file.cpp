@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "persistent_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <utility>
+
+namespace omnitrace
+{
+persistent_file::persistent_file(std::string _path)
+: m_fd{ ::open(_path.c_str(), O_RDONLY | O_CLOEXEC) }
+, m_path{ std::move(_path) }
+, m_buffer(4096)
+{}
+
+persistent_file::~persistent_file() { close(); }
+
+persistent_file::persistent_file(persistent_file&& _v) noexcept
+: m_fd{ std::exchange(_v.m_fd, -1) }
+, m_path{ std::move(_v.m_path) }
+, m_buffer{ std::move(_v.m_buffer) }
+{}
+
+persistent_file&
+persistent_file::operator=(persistent_file&& _v) noexcept
+{
+    if(this != &_v)
+    {
+        close();
+        m_fd     = std::exchange(_v.m_fd, -1);
+        m_path   = std::move(_v.m_path);
+        m_buffer = std::move(_v.m_buffer);
+    }
+    return *this;
+}
+
+void
+persistent_file::close()
+{
+    if(m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+}
+
+std::string_view
+persistent_file::read()
+{
+    if(m_fd < 0) return std::string_view{};
+
+    // most /proc files report a size of zero so the buffer grows until a read
+    // returns less than its capacity
+    while(true)
+    {
+        size_t _len = 0;
+        while(_len < m_buffer.size())
+        {
+            auto _n = ::pread(m_fd, m_buffer.data() + _len, m_buffer.size() - _len, _len);
+            if(_n < 0 && errno == EINTR) continue;
+            if(_n <= 0) break;
+            _len += static_cast<size_t>(_n);
+        }
+
+        if(_len < m_buffer.size()) return std::string_view{ m_buffer.data(), _len };
+        m_buffer.resize(2 * m_buffer.size());
+    }
+}
+
+std::optional<int64_t>
+persistent_file::read_int()
+{
+    auto    _data  = read();
+    size_t  _pos   = 0;
+    int64_t _value = 0;
+    if(parse_int(_data, _pos, _value)) return _value;
+    return std::nullopt;
+}
+
+bool
+parse_int(std::string_view _data, size_t& _pos, int64_t& _value)
+{
+    auto _is_digit = [](char _c) { return _c >= '0' && _c <= '9'; };
+
+    while(_pos < _data.size() && !_is_digit(_data[_pos]))
+        ++_pos;
+    if(_pos >= _data.size()) return false;
+
+    bool _negative = (_pos > 0 && _data[_pos - 1] == '-');
+    _value         = 0;
+    while(_pos < _data.size() && _is_digit(_data[_pos]))
+        _value = (10 * _value) + (_data[_pos++] - '0');
+    if(_negative) _value = -_value;
+    return true;
+}
+}  // namespace omnitrace
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace omnitrace
+{
+/// keeps a /proc or sysfs file open and re-reads it from offset zero with pread()
+/// into a reusable buffer so that polling the file neither re-opens it nor allocates
+struct persistent_file
+{
+    persistent_file() = default;
+    explicit persistent_file(std::string _path);
+    ~persistent_file();
+
+    persistent_file(const persistent_file&) = delete;
+    persistent_file& operator=(const persistent_file&) = delete;
+
+    persistent_file(persistent_file&&) noexcept;
+    persistent_file& operator=(persistent_file&&) noexcept;
+
+    bool               is_open() const { return m_fd >= 0; }
+    const std::string& path() const { return m_path; }
+
+    /// returns the current contents of the file. The view is invalidated by the
+    /// next read
+    std::string_view read();
+
+    /// returns the first integer in the current contents of the file
+    std::optional<int64_t> read_int();
+
+    void close();
+
+private:
+    int               m_fd     = -1;
+    std::string       m_path   = {};
+    std::vector<char> m_buffer = {};
+};
+
+/// parses the integer starting at or after _pos and advances _pos past it. Returns
+/// false if there are no more digits in _data
+bool
+parse_int(std::string_view _data, size_t& _pos, int64_t& _value);
+}  // namespace omnitrace
@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "procfs_reader.hpp"
+#include "persistent_file.hpp"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace procfs_reader
+{
+namespace
+{
+int64_t
+get_page_size()
+{
+    static auto _v = static_cast<int64_t>(::sysconf(_SC_PAGESIZE));
+    return _v;
+}
+
+// returns the value of the field in /proc/self/statm (in pages)
+std::optional<int64_t>
+read_statm(size_t _field)
+{
+    static thread_local auto _file = persistent_file{ "/proc/self/statm" };
+
+    auto    _data  = _file.read();
+    size_t  _pos   = 0;
+    int64_t _value = 0;
+    for(size_t i = 0; i <= _field; ++i)
+    {
+        if(!parse_int(_data, _pos, _value)) return std::nullopt;
+    }
+    return _value;
+}
+}  // namespace
+
+std::optional<int64_t>
+get_page_rss()
+{
+    if(auto _v = read_statm(1)) return (*_v * get_page_size());
+    return std::nullopt;
+}
+
+std::optional<int64_t>
+get_virt_mem()
+{
+    if(auto _v = read_statm(0)) return (*_v * get_page_size());
+    return std::nullopt;
+}
+
+std::optional<int64_t>
+get_cpu_freq(size_t _cpu)
+{
+    static thread_local auto _files = std::vector<persistent_file>{};
+    static thread_local auto _tried = std::vector<bool>{};
+
+    if(_cpu >= _files.size())
+    {
+        _files.resize(_cpu + 1);
+        _tried.resize(_cpu + 1, false);
+    }
+
+    if(!_tried[_cpu])
+    {
+        _tried[_cpu] = true;
+        _files[_cpu] = persistent_file{ "/sys/devices/system/cpu/cpu" +
+                                        std::to_string(_cpu) +
+                                        "/cpufreq/scaling_cur_freq" };
+    }
+
+    return _files[_cpu].read_int();
+}
+}  // namespace procfs_reader
+}  // namespace omnitrace
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace omnitrace
+{
+/// readers for the /proc and sysfs files polled by the background process sampler.
+/// The files are opened once per thread and re-read with pread() (see
+/// persistent_file) so a sample does not re-open or allocate. The file descriptors
+/// are thread-local so a sampler thread started in a forked child does not read
+/// /proc/self of its parent
+namespace procfs_reader
+{
+/// resident set size in bytes from /proc/self/statm
+std::optional<int64_t>
+get_page_rss();
+
+/// virtual memory size in bytes from /proc/self/statm
+std::optional<int64_t>
+get_virt_mem();
+
+/// current frequency of the cpu in kHz from
+/// /sys/devices/system/cpu/cpu<N>/cpufreq/scaling_cur_freq
+std::optional<int64_t>
+get_cpu_freq(size_t _cpu);
+}  // namespace procfs_reader
+}  // namespace omnitrace
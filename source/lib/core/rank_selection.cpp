@@ -0,0 +1,164 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "core/rank_selection.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/mproc.hpp"
+#include "core/utility.hpp"
+
+#include <timemory/environment.hpp>
+#include <timemory/utility/delimit.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace rank_selection
+{
+namespace
+{
+auto&
+get_selected()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// the launchers export the rank of the process on its node. Otherwise, the processes
+// launched by the same parent (e.g. orted or hydra_pmi_proxy) are on the same node
+int
+get_local_rank()
+{
+    for(const auto* itr : { "OMPI_COMM_WORLD_LOCAL_RANK", "MPI_LOCALRANKID",
+                            "MV2_COMM_WORLD_LOCAL_RANK", "PALS_LOCAL_RANKID",
+                            "FLUX_TASK_LOCAL_ID", "SLURM_LOCALID" })
+    {
+        auto _v = tim::get_env<int>(itr, -1, false);
+        if(_v >= 0) return _v;
+    }
+    return mproc::get_process_index();
+}
+
+int
+get_count(const std::string& _v, const std::string& _spec, int _default)
+{
+    if(_v.empty()) return _default;
+    if(_v.find_first_not_of("0123456789") != std::string::npos)
+    {
+        OMNITRACE_BASIC_VERBOSE_F(0, "Invalid OMNITRACE_MPI_RANKS value '%s'. "
+                                     "Selecting all of the ranks...\n",
+                                  _spec.c_str());
+        return -1;
+    }
+    return std::stoi(_v);
+}
+
+// rank 0 and N-1 of the other ranks. The engine is seeded identically on every rank
+// and only its raw output is used, which is the same for every implementation
+bool
+is_selected_random(int _rank, int _size, int _count, uint64_t _seed)
+{
+    if(_rank == 0 || _count >= _size) return true;
+    if(_count <= 1) return false;
+
+    auto _ranks = std::vector<int>(_size - 1);
+    std::iota(_ranks.begin(), _ranks.end(), 1);
+
+    auto _engine = std::mt19937_64{ _seed };
+    for(int i = 0; i < _count - 1; ++i)
+    {
+        auto _n = static_cast<uint64_t>(_ranks.size() - i);
+        auto _j = static_cast<size_t>(i + (_engine() % _n));
+        std::swap(_ranks.at(i), _ranks.at(_j));
+        if(_ranks.at(i) == _rank) return true;
+    }
+    return false;
+}
+}  // namespace
+
+bool
+is_selected()
+{
+    return get_selected().load(std::memory_order_relaxed);
+}
+
+bool
+is_selected(const std::string& _spec, int _rank, int _size, int _local_rank)
+{
+    auto _fields = tim::delimit(_spec, ": \t\n");
+    if(_fields.empty() || _rank < 0 || _size <= 0) return true;
+
+    const auto& _mode = _fields.at(0);
+    if(_mode == "node")
+    {
+        auto _count = get_count((_fields.size() > 1) ? _fields.at(1) : "", _spec, 1);
+        if(_count < 0 || _local_rank < 0) return true;
+        return _local_rank < _count;
+    }
+    else if(_mode == "random")
+    {
+        if(_fields.size() < 2)
+        {
+            OMNITRACE_BASIC_VERBOSE_F(0, "OMNITRACE_MPI_RANKS=%s requires the number of "
+                                         "ranks, e.g. random:16. Selecting all of the "
+                                         "ranks...\n",
+                                      _spec.c_str());
+            return true;
+        }
+        auto _count = get_count(_fields.at(1), _spec, 1);
+        auto _seed  = get_count((_fields.size() > 2) ? _fields.at(2) : "", _spec, 0);
+        if(_count < 0 || _seed < 0) return true;
+        return is_selected_random(_rank, _size, _count, _seed);
+    }
+
+    auto _ranks = utility::parse_numeric_range<int64_t, std::set<int64_t>>(
+        _spec, "MPI ranks", 1L);
+    return _ranks.empty() || _ranks.count(_rank) > 0;
+}
+
+bool
+update(int _rank, int _size)
+{
+    auto _spec = config::get_mpi_ranks();
+    if(_spec.empty()) return is_selected();
+
+    auto _local = get_local_rank();
+    auto _v     = is_selected(_spec, _rank, _size, _local);
+    if(_v != get_selected().exchange(_v))
+    {
+        OMNITRACE_BASIC_VERBOSE(1,
+                                "[rank_selection] rank %i of %i (local rank %i) is %s "
+                                "OMNITRACE_MPI_RANKS=%s\n",
+                                _rank, _size, _local, (_v) ? "in" : "not in",
+                                _spec.c_str());
+    }
+    return _v;
+}
+}  // namespace rank_selection
+}  // namespace omnitrace
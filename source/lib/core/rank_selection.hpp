@@ -0,0 +1,49 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+
+namespace omnitrace
+{
+/// selection of the MPI ranks which collect data (see OMNITRACE_MPI_RANKS). Every
+/// rank evaluates the selection independently from its rank, the number of ranks
+/// and its node-local rank so no communication is required and the result is the
+/// same on every rank
+namespace rank_selection
+{
+/// true unless the rank is known and is not selected
+bool
+is_selected();
+
+/// evaluates the selection for the rank of MPI_COMM_WORLD and the number of ranks.
+/// Returns the new value of is_selected()
+bool
+update(int _rank, int _size);
+
+/// true if the rank is in the selection described by the value of
+/// OMNITRACE_MPI_RANKS (an empty value selects every rank)
+bool
+is_selected(const std::string& _spec, int _rank, int _size, int _local_rank);
+}  // namespace rank_selection
+}  // namespace omnitrace
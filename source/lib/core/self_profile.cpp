@@ -0,0 +1,173 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "core/self_profile.hpp"
+#include "core/concepts.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/huge_pages.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/settings/settings.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+
+namespace omnitrace
+{
+namespace self_profile
+{
+namespace
+{
+// the slots are never released so the data of the threads which have exited is
+// still available at finalization
+auto&
+get_slots()
+{
+    static auto _v = std::array<thread_data, max_supported_threads>{};
+    return _v;
+}
+
+auto&
+get_peak_slots()
+{
+    static auto _v = std::atomic<size_t>{ 0 };
+    return _v;
+}
+
+thread_data*
+init_thread_data()
+{
+    auto _idx = static_cast<size_t>(utility::get_thread_index());
+    if(_idx >= max_supported_threads) return nullptr;
+
+    auto& _peak = get_peak_slots();
+    auto  _prev = _peak.load(std::memory_order_relaxed);
+    while(_prev < _idx + 1 &&
+          !_peak.compare_exchange_weak(_prev, _idx + 1, std::memory_order_relaxed))
+    {}
+    return &get_slots()[_idx];
+}
+
+void
+write_text(size_t _nthreads)
+{
+    auto _fname = tim::settings::compose_output_filename("self-profile", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening self-profile output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<thread_data>{}(_fname,
+                                                      std::string{ "self-profile" });
+
+    ofs << std::setprecision(3) << std::fixed;
+    for(size_t i = 0; i < _nthreads; ++i)
+    {
+        const auto& _data = get_slots()[i];
+        for(size_t j = 0; j < subsystem::count; ++j)
+        {
+            const auto& _entry = _data.entries[j];
+            if(_entry.calls == 0) continue;
+            ofs << "thread " << i << " :: " << get_name(static_cast<subsystem>(j))
+                << " :: " << (static_cast<double>(_entry.time) / units::msec)
+                << " msec :: " << _entry.calls << " calls\n";
+        }
+    }
+}
+}  // namespace
+
+thread_data*
+get_thread_data()
+{
+    static thread_local auto* _v = init_thread_data();
+    return _v;
+}
+
+const char*
+get_name(subsystem _v)
+{
+    switch(_v)
+    {
+        case region: return "region";
+        case perfetto: return "perfetto";
+        case timemory: return "timemory";
+        case sampling: return "sampling";
+        case causal: return "causal";
+        case roctracer: return "roctracer";
+        case kokkos: return "kokkos";
+        case gotcha: return "gotcha";
+        case count: break;
+    }
+    return "unknown";
+}
+
+void
+report()
+{
+    if(!get_self_profile()) return;
+
+    auto _nthreads = get_peak_slots().load();
+    auto _totals   = std::array<entry, subsystem::count>{};
+    auto _total    = uint64_t{ 0 };
+    for(size_t i = 0; i < _nthreads; ++i)
+    {
+        for(size_t j = 0; j < subsystem::count; ++j)
+        {
+            _totals[j].time += get_slots()[i].entries[j].time;
+            _totals[j].calls += get_slots()[i].entries[j].calls;
+            _total += get_slots()[i].entries[j].time;
+        }
+    }
+
+    OMNITRACE_VERBOSE_F(0, "Time spent inside omnitrace by %zu threads: %.3f msec\n",
+                        _nthreads, static_cast<double>(_total) / units::msec);
+    for(size_t j = 0; j < subsystem::count; ++j)
+    {
+        const auto& _entry = _totals[j];
+        if(_entry.calls == 0) continue;
+        OMNITRACE_VERBOSE_F(0,
+                            "    %-10s :: %12.3f msec (%5.1f%%) :: %10zu calls :: "
+                            "%10.1f nsec/call\n",
+                            get_name(static_cast<subsystem>(j)),
+                            static_cast<double>(_entry.time) / units::msec,
+                            (_total > 0) ? (100.0 * _entry.time) / _total : 0.0,
+                            static_cast<size_t>(_entry.calls),
+                            static_cast<double>(_entry.time) / _entry.calls);
+    }
+
+    huge_pages::report();
+
+    if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+        write_text(_nthreads);
+}
+}  // namespace self_profile
+}  // namespace omnitrace
@@ -0,0 +1,149 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "common/defines.h"
+#include "core/config_snapshot.hpp"
+#include "core/defines.hpp"
+#include "core/tsc.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// accumulates the time and the number of calls spent inside the omnitrace entry
+/// points of each subsystem for each thread (see OMNITRACE_SELF_PROFILE). The time is
+/// exclusive: when an entry point of one subsystem calls into another subsystem,
+/// e.g. a roctracer callback emitting a perfetto event, the time is charged to the
+/// innermost subsystem. Recording only touches thread-local data so it is safe to use
+/// in the signal handlers of the samplers
+namespace self_profile
+{
+enum subsystem : uint8_t
+{
+    region = 0,  ///< instrumentation and user API regions (category_region)
+    perfetto,    ///< perfetto trace events
+    timemory,    ///< timemory profiling bundles
+    sampling,    ///< call-stack sampling signal handlers
+    causal,      ///< causal profiling signal handlers
+    roctracer,   ///< HIP/HSA/roctx API and activity callbacks
+    kokkos,      ///< Kokkos profiling library callbacks
+    gotcha,      ///< MPI, RCCL and NUMA function wrappers
+    count
+};
+
+static constexpr size_t max_depth = 16;
+
+struct entry
+{
+    uint64_t time  = 0;  // nanoseconds
+    uint64_t calls = 0;
+};
+
+struct alignas(64) thread_data
+{
+    uint32_t                            depth   = 0;
+    uint64_t                            last    = 0;
+    std::array<uint8_t, max_depth>      stack   = {};
+    std::array<entry, subsystem::count> entries = {};
+};
+
+/// the data of the calling thread or nullptr if the thread exceeds the maximum
+/// number of supported threads
+thread_data*
+get_thread_data() OMNITRACE_HOT;
+
+/// returns the name of the subsystem, e.g. "roctracer"
+const char*
+get_name(subsystem);
+
+inline bool
+enabled()
+{
+    return config::get_snapshot().self_profile;
+}
+
+/// enters a subsystem. Regions nested inside another subsystem (e.g. the pthread
+/// regions created by the gotcha wrappers) are charged to the enclosing subsystem.
+/// Returns false if nothing was recorded, in which case pop() must not be called
+inline bool
+push(subsystem _v)
+{
+    auto* _data = get_thread_data();
+    if(!_data || (_v == region && _data->depth > 0)) return false;
+
+    auto _now = tsc::get_clock_real_now();
+    if(_data->depth > 0 && _data->depth <= max_depth)
+        _data->entries[_data->stack[_data->depth - 1]].time += _now - _data->last;
+    if(_data->depth < max_depth) _data->stack[_data->depth] = _v;
+    ++_data->depth;
+    ++_data->entries[_v].calls;
+    _data->last = _now;
+    return true;
+}
+
+inline void
+pop()
+{
+    auto* _data = get_thread_data();
+    if(!_data || _data->depth == 0) return;
+
+    auto _now = tsc::get_clock_real_now();
+    if(_data->depth <= max_depth)
+        _data->entries[_data->stack[_data->depth - 1]].time += _now - _data->last;
+    --_data->depth;
+    _data->last = _now;
+}
+
+struct scoped
+{
+    OMNITRACE_INLINE scoped(subsystem _v)
+    : m_active{ enabled() && push(_v) }
+    {}
+
+    OMNITRACE_INLINE ~scoped()
+    {
+        if(m_active) pop();
+    }
+
+    scoped(const scoped&) = delete;
+    scoped& operator=(const scoped&) = delete;
+
+private:
+    bool m_active = false;
+};
+
+/// prints the breakdown by subsystem and writes the per-thread breakdown to
+/// self-profile.txt. Does nothing if OMNITRACE_SELF_PROFILE is disabled
+void
+report();
+}  // namespace self_profile
+}  // namespace omnitrace
+
+#define OMNITRACE_SELF_PROFILE_SCOPE(SUBSYSTEM)                                          \
+    ::omnitrace::self_profile::scoped OMNITRACE_VARIABLE(_self_profile_, __LINE__)       \
+    {                                                                                    \
+        ::omnitrace::self_profile::SUBSYSTEM                                             \
+    }
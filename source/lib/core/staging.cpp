@@ -0,0 +1,167 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "core/staging.hpp"
+#include "core/common.hpp"
+#include "core/debug.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace omnitrace
+{
+namespace staging
+{
+namespace
+{
+bool
+make_directories(const std::string& _path)
+{
+    for(auto _pos = _path.find('/', 1); true; _pos = _path.find('/', _pos + 1))
+    {
+        auto _dir = _path.substr(0, _pos);
+        if(!_dir.empty() && ::mkdir(_dir.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if(_pos == std::string::npos) break;
+    }
+    return true;
+}
+
+// rename within the same filesystem, otherwise copy and remove (e.g. from a tmpfs or
+// a local NVMe to a parallel filesystem)
+bool
+move_file(const std::string& _src, const std::string& _dst)
+{
+    if(::rename(_src.c_str(), _dst.c_str()) == 0) return true;
+    if(errno != EXDEV) return false;
+
+    {
+        auto _ifs = std::ifstream{ _src, std::ios::binary };
+        auto _ofs = std::ofstream{ _dst, std::ios::binary | std::ios::trunc };
+        if(!_ifs || !_ofs) return false;
+        _ofs << _ifs.rdbuf();
+        if(!_ofs) return false;
+    }
+    ::unlink(_src.c_str());
+    return true;
+}
+
+size_t
+drain(const std::string& _root, const std::string& _rel, int _verbose)
+{
+    auto  _path = _root + _rel;
+    auto* _dir  = opendir(_path.c_str());
+    if(!_dir) return 0;
+
+    auto _files   = std::vector<std::string>{};
+    auto _subdirs = std::vector<std::string>{};
+    while(auto* _entry = readdir(_dir))
+    {
+        auto _name = std::string{ _entry->d_name };
+        if(_name == "." || _name == "..") continue;
+
+        struct stat _stat = {};
+        if(::lstat(JOIN('/', _path, _name).c_str(), &_stat) != 0) continue;
+        if(S_ISDIR(_stat.st_mode))
+            _subdirs.emplace_back(_name);
+        else if(S_ISREG(_stat.st_mode) && !_rel.empty())
+            _files.emplace_back(_name);
+    }
+    closedir(_dir);
+
+    size_t _n = 0;
+    if(!_files.empty() && !make_directories(_rel))
+    {
+        if(_verbose >= 0)
+            TIMEMORY_PRINTF_WARNING(stderr,
+                                    "Output directory '%s' cannot be created: %s\n",
+                                    _rel.c_str(), strerror(errno));
+        return _n;
+    }
+
+    for(const auto& itr : _files)
+    {
+        auto _src = JOIN('/', _path, itr);
+        auto _dst = JOIN('/', _rel, itr);
+        if(move_file(_src, _dst))
+        {
+            ++_n;
+            if(_verbose >= 2)
+                TIMEMORY_PRINTF_INFO(stderr, "Moved '%s' to '%s'\n", _src.c_str(),
+                                     _dst.c_str());
+        }
+        else if(_verbose >= 0)
+        {
+            TIMEMORY_PRINTF_WARNING(stderr,
+                                    "Staged output '%s' cannot be moved to '%s'\n",
+                                    _src.c_str(), _dst.c_str());
+        }
+    }
+
+    for(const auto& itr : _subdirs)
+        _n += drain(_root, JOIN('/', _rel, itr), _verbose);
+
+    // only succeeds when everything below was moved
+    ::rmdir(_path.c_str());
+    return _n;
+}
+}  // namespace
+
+std::string
+get_directory(std::string _value, const std::string& _tmpdir)
+{
+    if(_value.empty() || _value == "none" || _value == "off") return std::string{};
+    if(_value == "tmpdir") _value = _tmpdir;
+    while(_value.length() > 1 && _value.back() == '/')
+        _value.pop_back();
+    return _value;
+}
+
+std::string
+get_root(const std::string& _directory, const std::string& _id)
+{
+    return JOIN('/', _directory, JOIN('-', "omnitrace-staging", _id));
+}
+
+std::string&
+get_root()
+{
+    static auto _v = std::string{};
+    return _v;
+}
+
+size_t
+drain(const std::string& _root, int _verbose)
+{
+    if(_root.empty()) return 0;
+    return drain(_root, std::string{}, _verbose);
+}
+}  // namespace staging
+}  // namespace omnitrace
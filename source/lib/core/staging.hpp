@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+/// node-local staging of the output files (see OMNITRACE_OUTPUT_STAGING). The output
+/// path is redirected into '<staging>/omnitrace-staging-<id>' followed by the absolute
+/// output path, e.g. '/dev/shm/omnitrace-staging-1234/lustre/proj/omnitrace-app-output',
+/// so the final location of every staged file is its path relative to the root of the
+/// staging directory. omnitrace-run starts a detached process which moves the files
+/// once the application has exited, otherwise the files are moved at the end of the
+/// finalization
+namespace staging
+{
+/// set by omnitrace-run to the identifier of the staging directory when it started a
+/// drain process for it
+static constexpr std::string_view drain_env = "OMNITRACE_OUTPUT_STAGING_DRAIN";
+
+/// the staging directory for the value of OMNITRACE_OUTPUT_STAGING. Empty when the
+/// staging is disabled
+std::string
+get_directory(std::string _value, const std::string& _tmpdir);
+
+/// the root of the staged files of the identifier
+std::string
+get_root(const std::string& _directory, const std::string& _id);
+
+/// the root of the staged files of this process. Empty when the staging is disabled
+std::string&
+get_root();
+
+/// moves the files below the root to their final location and removes the
+/// directories of the root. Returns the number of files which were moved
+size_t
+drain(const std::string& _root, int _verbose = 0);
+}  // namespace staging
+}  // namespace omnitrace
@@ -169,6 +169,7 @@ to_string(omnitrace::CausalMode _v)
     {
         case omnitrace::CausalMode::Line: return "Line";
         case omnitrace::CausalMode::Function: return "Function";
+        case omnitrace::CausalMode::Kernel: return "Kernel";
     }
     return {};
 }
@@ -67,7 +67,15 @@ enum class CausalBackend : unsigned short
 enum class CausalMode : unsigned short
 {
     Line = 0,
-    Function
+    Function,
+    Kernel
+};
+
+enum class SamplingUnwinder : unsigned short
+{
+    LibUnwind = 0,
+    FramePointer,
+    Auto,
 };
 
 //
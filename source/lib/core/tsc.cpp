@@ -0,0 +1,193 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "tsc.hpp"
+#include "debug.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#if OMNITRACE_HAS_TSC > 0
+#    include <cpuid.h>
+#endif
+
+namespace omnitrace
+{
+namespace tsc
+{
+namespace
+{
+bool
+has_invariant_tsc()
+{
+#if OMNITRACE_HAS_TSC > 0
+    unsigned int _eax = 0, _ebx = 0, _ecx = 0, _edx = 0;
+    if(__get_cpuid(0x80000000, &_eax, &_ebx, &_ecx, &_edx) == 0 || _eax < 0x80000007)
+        return false;
+    if(__get_cpuid(0x80000007, &_eax, &_ebx, &_ecx, &_edx) == 0) return false;
+    // CPUID.80000007H:EDX[8] is the invariant TSC flag
+    return (_edx & (1U << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+std::string
+get_clocksource()
+{
+    auto _ifs = std::ifstream{
+        "/sys/devices/system/clocksource/clocksource0/current_clocksource"
+    };
+    auto _v = std::string{};
+    if(_ifs) _ifs >> _v;
+    return _v;
+}
+
+// reads the counter bracketed by two reads of the clock and keeps the tightest of a
+// few attempts so that the pair is as close to simultaneous as possible
+std::pair<uint64_t, uint64_t>
+sample_pair()
+{
+    auto _best_ns   = uint64_t{ 0 };
+    auto _best_tick = uint64_t{ 0 };
+    auto _best_gap  = ~uint64_t{ 0 };
+    for(int i = 0; i < 8; ++i)
+    {
+        auto _beg  = ::tim::get_clock_real_now<uint64_t, std::nano>();
+        auto _tick = read();
+        auto _end  = ::tim::get_clock_real_now<uint64_t, std::nano>();
+        if(_end - _beg < _best_gap)
+        {
+            _best_gap  = _end - _beg;
+            _best_ns   = _beg + (_end - _beg) / 2;
+            _best_tick = _tick;
+        }
+    }
+    return std::make_pair(_best_ns, _best_tick);
+}
+}  // namespace
+
+bool
+is_reliable()
+{
+    static auto _v = []() {
+        if(!has_invariant_tsc())
+        {
+            OMNITRACE_VERBOSE_F(1, "TSC is not invariant\n");
+            return false;
+        }
+        auto _clocksource = get_clocksource();
+        if(_clocksource != "tsc")
+        {
+            OMNITRACE_VERBOSE_F(1, "kernel clocksource is '%s', not the TSC\n",
+                                _clocksource.c_str());
+            return false;
+        }
+        return true;
+    }();
+    return _v;
+}
+
+bool
+calibrate(uint64_t _duration_ns, uint64_t _interval_ns)
+{
+    auto& _v = get_calibration();
+    if(enabled()) return true;
+    if(!is_reliable()) return false;
+
+    auto _beg = sample_pair();
+    while(::tim::get_clock_real_now<uint64_t, std::nano>() - _beg.first < _duration_ns)
+    {}
+    auto _end = sample_pair();
+
+    if(_end.second <= _beg.second || _end.first <= _beg.first) return false;
+
+    auto _ns_per_tick = static_cast<long double>(_end.first - _beg.first) /
+                        static_cast<long double>(_end.second - _beg.second);
+
+    auto& _model = _v.models.at(0);
+    _model.tick0.store(_beg.second, std::memory_order_relaxed);
+    _model.ns0.store(_beg.first, std::memory_order_relaxed);
+    _model.mult.store(static_cast<uint64_t>(_ns_per_tick * (1ULL << 32)),
+                      std::memory_order_relaxed);
+
+    _v.ref_tick = _end.second;
+    _v.ref_ns   = _end.first;
+    _v.interval = static_cast<uint64_t>(_interval_ns / _ns_per_tick);
+    _v.next.store(_end.second + _v.interval, std::memory_order_relaxed);
+    _v.index.store(0, std::memory_order_relaxed);
+    _v.enabled.store(true, std::memory_order_release);
+
+    OMNITRACE_VERBOSE_F(1, "TSC calibrated :: %.3Lf MHz (recalibrated every %.3f sec)\n",
+                        1.0e3L / _ns_per_tick, _interval_ns / 1.0e9);
+    return true;
+}
+
+// the frequency is measured over the last interval and the model continues from the
+// value of the current model at the new anchor, i.e. the timestamps stay continuous and
+// monotonic, while the difference from CLOCK_REALTIME is absorbed over the next
+// interval. A difference beyond a tenth of the interval, e.g. a step of the real-time
+// clock, is applied at once. The pair is read with async-signal-safe calls since the
+// conversions are also made by the signal handlers of the samplers
+void
+recalibrate()
+{
+    auto& _v = get_calibration();
+    if(_v.updating.exchange(true, std::memory_order_acquire)) return;
+
+    auto _pair = sample_pair();
+    if(_pair.second >= _v.next.load(std::memory_order_relaxed) &&
+       _pair.second > _v.ref_tick && _pair.first > _v.ref_ns)
+    {
+        auto        _idx     = _v.index.load(std::memory_order_relaxed);
+        const auto& _current = _v.models[_idx % 2];
+        auto&       _model   = _v.models[(_idx + 1) % 2];
+
+        auto _ns_per_tick = static_cast<long double>(_pair.first - _v.ref_ns) /
+                            static_cast<long double>(_pair.second - _v.ref_tick);
+        auto _span  = _ns_per_tick * static_cast<long double>(_v.interval);
+        auto _ns0   = to_ns(_current, _pair.second);
+        auto _error = static_cast<long double>(_pair.first) -
+                      static_cast<long double>(_ns0);
+
+        if(_span <= 0.0L || std::abs(_error) > 0.1L * _span)
+            _ns0 = _pair.first;
+        else
+            _ns_per_tick *= (1.0L + _error / _span);
+
+        _model.tick0.store(_pair.second, std::memory_order_relaxed);
+        _model.ns0.store(_ns0, std::memory_order_relaxed);
+        _model.mult.store(static_cast<uint64_t>(_ns_per_tick * (1ULL << 32)),
+                          std::memory_order_relaxed);
+        _v.index.store(_idx + 1, std::memory_order_release);
+
+        _v.ref_tick = _pair.second;
+        _v.ref_ns   = _pair.first;
+        _v.next.store(_pair.second + _v.interval, std::memory_order_relaxed);
+    }
+
+    _v.updating.store(false, std::memory_order_release);
+}
+}  // namespace tsc
+}  // namespace omnitrace
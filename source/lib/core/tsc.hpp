@@ -0,0 +1,139 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ratio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#    define OMNITRACE_HAS_TSC 1
+#else
+#    define OMNITRACE_HAS_TSC 0
+#endif
+
+namespace omnitrace
+{
+namespace tsc
+{
+/// linear model of CLOCK_REALTIME nanoseconds as a function of the time-stamp counter.
+/// Two copies are kept so that the thread which updates the model writes the copy which
+/// is not read and then publishes it
+struct linear_model
+{
+    std::atomic<uint64_t> tick0 = { 0 };  ///< counter value at the anchor
+    std::atomic<uint64_t> ns0   = { 0 };  ///< CLOCK_REALTIME nanoseconds at the anchor
+    std::atomic<uint64_t> mult  = { 0 };  ///< nanoseconds per tick in 32.32 fixed-point
+};
+
+/// conversion from the time-stamp counter to CLOCK_REALTIME nanoseconds. calibrate()
+/// writes the first model before enabled is set and, afterwards, the model is re-fitted
+/// every interval by the one thread which claims the update (see recalibrate())
+struct calibration
+{
+    std::atomic<bool>           enabled  = { false };
+    std::atomic<uint32_t>       index    = { 0 };  ///< the model which is read
+    std::atomic<uint64_t>       next     = { 0 };  ///< counter value of the next update
+    std::atomic<bool>           updating = { false };
+    uint64_t                    interval = 0;  ///< ticks between updates (0 disables)
+    std::array<linear_model, 2> models   = {};
+
+    // the clock pair of the last calibration, only accessed by the updating thread
+    uint64_t ref_tick = 0;
+    uint64_t ref_ns   = 0;
+};
+
+inline calibration&
+get_calibration()
+{
+    static calibration _v = {};
+    return _v;
+}
+
+/// returns true if the CPU reports an invariant TSC and the kernel clocksource is
+/// the TSC (i.e. the kernel considers it synchronized across CPUs)
+bool
+is_reliable();
+
+/// measures the TSC frequency against CLOCK_REALTIME and enables the conversion. The
+/// model is re-fitted every _interval_ns (never when zero) so the frequency error and
+/// the adjustments of CLOCK_REALTIME do not accumulate against the timestamps which are
+/// read from the real-time clock. Returns false (and leaves the TSC disabled) if the
+/// TSC is not reliable
+bool
+calibrate(uint64_t _duration_ns = 10000000, uint64_t _interval_ns = 1000000000);
+
+/// re-fits the model against CLOCK_REALTIME when no other thread does. Only invoked
+/// by to_ns() once the counter reaches the next update
+void
+recalibrate();
+
+inline bool
+enabled()
+{
+    return get_calibration().enabled.load(std::memory_order_acquire);
+}
+
+inline uint64_t
+read()
+{
+#if OMNITRACE_HAS_TSC > 0
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+inline uint64_t
+to_ns(const linear_model& _model, uint64_t _tick)
+{
+    auto _tick0 = _model.tick0.load(std::memory_order_relaxed);
+    auto _ns0   = _model.ns0.load(std::memory_order_relaxed);
+    auto _mult  = _model.mult.load(std::memory_order_relaxed);
+    auto _delta = static_cast<__int128>(_tick) - static_cast<__int128>(_tick0);
+    return _ns0 + static_cast<int64_t>((_delta * _mult) >> 32);
+}
+
+inline uint64_t
+to_ns(uint64_t _tick)
+{
+    auto& _v = get_calibration();
+    if(_v.interval > 0 && _tick >= _v.next.load(std::memory_order_relaxed)) recalibrate();
+    return to_ns(_v.models[_v.index.load(std::memory_order_acquire) % 2], _tick);
+}
+
+/// CLOCK_REALTIME in nanoseconds, read from the TSC when it has been calibrated
+inline uint64_t
+get_clock_real_now()
+{
+    if(enabled()) return to_ns(read());
+    return ::tim::get_clock_real_now<uint64_t, std::nano>();
+}
+}  // namespace tsc
+}  // namespace omnitrace
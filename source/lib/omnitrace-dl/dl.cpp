@@ -45,10 +45,15 @@
 #include <timemory/utility/filepath.hpp>
 
 #include <cassert>
+#include <cerrno>
 #include <chrono>
+#include <csignal>
+#include <fcntl.h>
 #include <gnu/libc-version.h>
 #include <link.h>
 #include <linux/limits.h>
+#include <mutex>
+#include <regex>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <thread>
@@ -165,6 +170,12 @@ omnitrace_preinit() OMNITRACE_INTERNAL_API;
 void
 omnitrace_postinit(std::string exe = {}) OMNITRACE_INTERNAL_API;
 
+bool
+omnitrace_lazy_setup(int, char**, const std::string&) OMNITRACE_INTERNAL_API;
+
+bool
+omnitrace_lazy_load() OMNITRACE_INTERNAL_API;
+
 pid_t _omnitrace_root_pid = get_omnitrace_root_pid();
 
 // environment priority:
@@ -301,13 +312,38 @@ struct OMNITRACE_INTERNAL_API indirect
                         "omnitrace_push_category_region");
         OMNITRACE_DLSYM(omnitrace_pop_category_region_f, m_omnihandle,
                         "omnitrace_pop_category_region");
+        OMNITRACE_DLSYM(omnitrace_register_region_f, m_omnihandle,
+                        "omnitrace_register_region");
+        OMNITRACE_DLSYM(omnitrace_push_region_id_f, m_omnihandle,
+                        "omnitrace_push_region_id");
+        OMNITRACE_DLSYM(omnitrace_pop_region_id_f, m_omnihandle,
+                        "omnitrace_pop_region_id");
+        OMNITRACE_DLSYM(omnitrace_dump_trace_f, m_omnihandle, "omnitrace_dump_trace");
+        OMNITRACE_DLSYM(omnitrace_register_counter_f, m_omnihandle,
+                        "omnitrace_register_counter");
+        OMNITRACE_DLSYM(omnitrace_record_counter_f, m_omnihandle,
+                        "omnitrace_record_counter");
         OMNITRACE_DLSYM(omnitrace_register_source_f, m_omnihandle,
                         "omnitrace_register_source");
         OMNITRACE_DLSYM(omnitrace_register_coverage_f, m_omnihandle,
                         "omnitrace_register_coverage");
+        OMNITRACE_DLSYM(omnitrace_register_coverage_counter_f, m_omnihandle,
+                        "omnitrace_register_coverage_counter");
+        OMNITRACE_DLSYM(omnitrace_register_loop_f, m_omnihandle,
+                        "omnitrace_register_loop");
+        OMNITRACE_DLSYM(omnitrace_loop_trip_f, m_omnihandle, "omnitrace_loop_trip");
+        OMNITRACE_DLSYM(omnitrace_function_enter_f, m_omnihandle,
+                        "omnitrace_function_enter");
+        OMNITRACE_DLSYM(omnitrace_function_exit_f, m_omnihandle,
+                        "omnitrace_function_exit");
+        OMNITRACE_DLSYM(omnitrace_register_python_sampler_f, m_omnihandle,
+                        "omnitrace_register_python_sampler");
         OMNITRACE_DLSYM(omnitrace_progress_f, m_omnihandle, "omnitrace_progress");
         OMNITRACE_DLSYM(omnitrace_annotated_progress_f, m_omnihandle,
                         "omnitrace_annotated_progress");
+        OMNITRACE_DLSYM(omnitrace_register_progress_f, m_omnihandle,
+                        "omnitrace_register_progress");
+        OMNITRACE_DLSYM(omnitrace_progress_id_f, m_omnihandle, "omnitrace_progress_id");
 
         OMNITRACE_DLSYM(kokkosp_print_help_f, m_omnihandle, "kokkosp_print_help");
         OMNITRACE_DLSYM(kokkosp_parse_args_f, m_omnihandle, "kokkosp_parse_args");
@@ -354,6 +390,13 @@ struct OMNITRACE_INTERNAL_API indirect
         OMNITRACE_DLSYM(kokkosp_dual_view_sync_f, m_omnihandle, "kokkosp_dual_view_sync");
         OMNITRACE_DLSYM(kokkosp_dual_view_modify_f, m_omnihandle,
                         "kokkosp_dual_view_modify");
+        OMNITRACE_DLSYM(kokkosp_declare_output_type_f, m_omnihandle,
+                        "kokkosp_declare_output_type");
+        OMNITRACE_DLSYM(kokkosp_declare_input_type_f, m_omnihandle,
+                        "kokkosp_declare_input_type");
+        OMNITRACE_DLSYM(kokkosp_request_values_f, m_omnihandle, "kokkosp_request_values");
+        OMNITRACE_DLSYM(kokkosp_begin_context_f, m_omnihandle, "kokkosp_begin_context");
+        OMNITRACE_DLSYM(kokkosp_end_context_f, m_omnihandle, "kokkosp_end_context");
 
 #if OMNITRACE_USE_ROCTRACER > 0
         OMNITRACE_DLSYM(hsa_on_load_f, m_omnihandle, "OnLoad");
@@ -375,8 +418,14 @@ struct OMNITRACE_INTERNAL_API indirect
         _warn_verbose = 0;
         OMNITRACE_DLSYM(omnitrace_user_configure_f, m_userhandle,
                         "omnitrace_user_configure");
+        configure_user(omnitrace_user_configure_f);
+    }
 
-        if(omnitrace_user_configure_f)
+    // replaces the callbacks of libomnitrace-user with the omnitrace-dl functions
+    static OMNITRACE_INLINE void configure_user(
+        int (*_configure)(int, omnitrace_user_callbacks_t, omnitrace_user_callbacks_t*))
+    {
+        if(_configure)
         {
             omnitrace_user_callbacks_t _cb = {};
             _cb.start_trace                = &omnitrace_user_start_trace_dl;
@@ -389,7 +438,15 @@ struct OMNITRACE_INTERNAL_API indirect
             _cb.push_annotated_region      = &omnitrace_user_push_annotated_region_dl;
             _cb.pop_annotated_region       = &omnitrace_user_pop_annotated_region_dl;
             _cb.annotated_progress         = &omnitrace_user_annotated_progress_dl;
-            (*omnitrace_user_configure_f)(OMNITRACE_USER_REPLACE_CONFIG, _cb, nullptr);
+            _cb.register_region            = &omnitrace_user_register_region_dl;
+            _cb.push_region_id             = &omnitrace_user_push_region_id_dl;
+            _cb.pop_region_id              = &omnitrace_user_pop_region_id_dl;
+            _cb.dump_trace                 = &omnitrace_user_dump_trace_dl;
+            _cb.register_counter           = &omnitrace_user_counter_register_dl;
+            _cb.record_counter             = &omnitrace_user_counter_record_dl;
+            _cb.register_progress          = &omnitrace_user_register_progress_dl;
+            _cb.progress_id                = &omnitrace_user_progress_id_dl;
+            (*_configure)(OMNITRACE_USER_REPLACE_CONFIG, _cb, nullptr);
         }
     }
 
@@ -406,6 +463,15 @@ public:
     void (*omnitrace_register_source_f)(const char*, const char*, size_t, size_t,
                                         const char*)                         = nullptr;
     void (*omnitrace_register_coverage_f)(const char*, const char*, size_t)  = nullptr;
+    void (*omnitrace_register_coverage_counter_f)(const char*, const char*, size_t,
+                                                  size_t, const char*,
+                                                  const volatile uint64_t*)  = nullptr;
+    void (*omnitrace_register_loop_f)(const char*, uint64_t)                 = nullptr;
+    void (*omnitrace_loop_trip_f)(uint64_t)                                  = nullptr;
+    void (*omnitrace_function_enter_f)(void*, void*)                         = nullptr;
+    void (*omnitrace_function_exit_f)(void*, void*)                          = nullptr;
+    void (*omnitrace_register_python_sampler_f)(
+        omnitrace_python_unwind_func_t, omnitrace_python_resolve_func_t)     = nullptr;
     void (*omnitrace_push_trace_f)(const char*)                              = nullptr;
     void (*omnitrace_pop_trace_f)(const char*)                               = nullptr;
     int (*omnitrace_push_region_f)(const char*)                              = nullptr;
@@ -414,9 +480,17 @@ public:
                                             omnitrace_annotation_t*, size_t) = nullptr;
     int (*omnitrace_pop_category_region_f)(omnitrace_category_t, const char*,
                                            omnitrace_annotation_t*, size_t)  = nullptr;
+    int (*omnitrace_register_region_f)(const char*, uint64_t*)               = nullptr;
+    int (*omnitrace_push_region_id_f)(uint64_t)                              = nullptr;
+    int (*omnitrace_pop_region_id_f)(uint64_t)                               = nullptr;
+    int (*omnitrace_dump_trace_f)(void)                                      = nullptr;
+    int (*omnitrace_register_counter_f)(const char*, const char*, uint64_t*) = nullptr;
+    int (*omnitrace_record_counter_f)(uint64_t, double)                      = nullptr;
     void (*omnitrace_progress_f)(const char*)                                = nullptr;
     void (*omnitrace_annotated_progress_f)(const char*, omnitrace_annotation_t*,
                                            size_t)                           = nullptr;
+    int (*omnitrace_register_progress_f)(const char*, uint64_t*)             = nullptr;
+    int (*omnitrace_progress_id_f)(uint64_t)                                 = nullptr;
 
     // libomnitrace-user functions
     int (*omnitrace_user_configure_f)(int, user_cb_t, user_cb_t*) = nullptr;
@@ -454,6 +528,15 @@ public:
     void (*kokkosp_profile_event_f)(const char*)                              = nullptr;
     void (*kokkosp_dual_view_sync_f)(const char*, const void* const, bool)    = nullptr;
     void (*kokkosp_dual_view_modify_f)(const char*, const void* const, bool)  = nullptr;
+    void (*kokkosp_declare_output_type_f)(const char*, const size_t,
+                                          Kokkos_Tools_VariableInfo*)         = nullptr;
+    void (*kokkosp_declare_input_type_f)(const char*, const size_t,
+                                         Kokkos_Tools_VariableInfo*)          = nullptr;
+    void (*kokkosp_request_values_f)(const size_t, const size_t,
+                                     const Kokkos_Tools_VariableValue*, const size_t,
+                                     Kokkos_Tools_VariableValue*)             = nullptr;
+    void (*kokkosp_begin_context_f)(const size_t)                             = nullptr;
+    void (*kokkosp_end_context_f)(const size_t)                               = nullptr;
 
     // HSA functions
 #if OMNITRACE_USE_ROCTRACER > 0
@@ -527,6 +610,16 @@ get_enabled()
     return *_v;
 }
 
+// the gate is opened once libomnitrace is initialized and closed when the trace is
+// stopped for the process or finalized. It is only read by the instrumentation so the
+// stores are relaxed
+void
+update_trace_gate()
+{
+    auto _v = (get_active() && get_enabled().load()) ? 1 : 0;
+    __atomic_store_n(&omnitrace_dl_trace_gate, _v, __ATOMIC_RELAXED);
+}
+
 auto&
 get_thread_enabled()
 {
@@ -555,6 +648,119 @@ get_instrumented()
     return _v;
 }
 
+// when OMNITRACE_DL_LAZY is enabled, omnitrace_main defers the omnitrace_init call and
+// stores its arguments here until the first enable (see omnitrace_lazy_load)
+struct lazy_state
+{
+    bool              deferred       = false;
+    bool              binary_rewrite = false;
+    bool              push_main      = true;  ///< main region is on the main thread
+    std::atomic<bool> pending        = { false };
+    std::thread::id   main_thread    = {};
+    std::string       mode           = {};
+    std::string       exe            = {};
+    std::mutex        mutex          = {};
+    int               fds[2]         = { -1, -1 };  ///< written by the trigger signal
+};
+
+auto&
+get_lazy()
+{
+    static auto* _v = new lazy_state{};
+    return *_v;
+}
+
+// the entry points of libomnitrace invoked by the instrumentation. The table is
+// published once libomnitrace is initialized and withdrawn when it is finalized so a
+// non-null table implies the library is active and the calls through it do not need
+// to consult the global state or get_indirect()
+struct resolved_table
+{
+    void (*push_trace)(const char*)                              = nullptr;
+    void (*pop_trace)(const char*)                               = nullptr;
+    int (*push_region)(const char*)                              = nullptr;
+    int (*pop_region)(const char*)                               = nullptr;
+    int (*push_category_region)(omnitrace_category_t, const char*,
+                                omnitrace_annotation_t*, size_t) = nullptr;
+    int (*pop_category_region)(omnitrace_category_t, const char*,
+                               omnitrace_annotation_t*, size_t)  = nullptr;
+    int (*push_region_id)(uint64_t)                              = nullptr;
+    int (*pop_region_id)(uint64_t)                               = nullptr;
+    void (*loop_trip)(uint64_t)                                  = nullptr;
+    void (*function_enter)(void*, void*)                         = nullptr;
+    void (*function_exit)(void*, void*)                          = nullptr;
+    int (*record_counter)(uint64_t, double)                      = nullptr;
+    int (*progress_id)(uint64_t)                                 = nullptr;
+};
+
+// both are constant-initialized so reading them does not involve an initialization
+// guard. The thread flag is set by the first call on the thread which finds the
+// thread enabled and cleared when the thread is disabled
+std::atomic<const resolved_table*> _omnitrace_dl_resolved        = { nullptr };
+thread_local bool                  _omnitrace_dl_thread_resolved = false;
+
+void
+publish_resolved_table()
+{
+    // invoking through the table bypasses the logging of the calls by common::invoke
+    if(_omnitrace_dl_verbose >= 3) return;
+
+    static auto* _v        = new resolved_table{};
+    auto&        _indirect = get_indirect();
+
+    _v->push_trace           = _indirect.omnitrace_push_trace_f;
+    _v->pop_trace            = _indirect.omnitrace_pop_trace_f;
+    _v->push_region          = _indirect.omnitrace_push_region_f;
+    _v->pop_region           = _indirect.omnitrace_pop_region_f;
+    _v->push_category_region = _indirect.omnitrace_push_category_region_f;
+    _v->pop_category_region  = _indirect.omnitrace_pop_category_region_f;
+    _v->push_region_id       = _indirect.omnitrace_push_region_id_f;
+    _v->pop_region_id        = _indirect.omnitrace_pop_region_id_f;
+    _v->loop_trip            = _indirect.omnitrace_loop_trip_f;
+    _v->function_enter       = _indirect.omnitrace_function_enter_f;
+    _v->function_exit        = _indirect.omnitrace_function_exit_f;
+    _v->record_counter       = _indirect.omnitrace_record_counter_f;
+    _v->progress_id          = _indirect.omnitrace_progress_id_f;
+
+    // the null function pointers are reported by common::invoke
+    if(!_v->push_trace || !_v->pop_trace || !_v->push_region || !_v->pop_region ||
+       !_v->push_category_region || !_v->pop_category_region || !_v->push_region_id ||
+       !_v->pop_region_id || !_v->loop_trip || !_v->function_enter ||
+       !_v->function_exit || !_v->record_counter || !_v->progress_id)
+        return;
+
+    _omnitrace_dl_resolved.store(_v, std::memory_order_release);
+}
+
+void
+withdraw_resolved_table()
+{
+    _omnitrace_dl_resolved.store(nullptr, std::memory_order_release);
+}
+
+// returns the published table unless the thread is disabled (when requested) or the
+// call originates from within libomnitrace, i.e. the calls common::invoke guards
+inline const resolved_table*
+get_resolved_table(bool _thread_enabled = true)
+{
+    if(_thread_enabled && !_omnitrace_dl_thread_resolved) return nullptr;
+    if(common::get_guard() != 0) return nullptr;
+    return _omnitrace_dl_resolved.load(std::memory_order_acquire);
+}
+
+template <typename FuncT, typename... Args>
+inline auto
+invoke_resolved(FuncT _func, Args... _args)
+{
+    struct decrement_guard
+    {
+        ~decrement_guard() { --common::get_guard(); }
+    } _unlk{};
+
+    ++common::get_guard();
+    return (*_func)(_args...);
+}
+
 // ensure finalization is called
 bool _omnitrace_dl_fini = (std::atexit([]() {
                                if(get_active()) omnitrace_finalize();
@@ -596,6 +802,8 @@ namespace dl = omnitrace::dl;
 
 extern "C"
 {
+    int omnitrace_dl_trace_gate = 0;
+
     void omnitrace_preinit_library(void)
     {
         if(omnitrace::common::get_env("OMNITRACE_MONOCHROME", tim::log::monochrome()))
@@ -646,6 +854,8 @@ extern "C"
             dl::_omnitrace_dl_verbose = dl::get_omnitrace_dl_env();
             if(dl::get_instrumented() < dl::InstrumentMode::PythonProfile)
                 dl::omnitrace_postinit((c) ? std::string{ c } : std::string{});
+            dl::publish_resolved_table();
+            dl::update_trace_gate();
         }
     }
 
@@ -664,20 +874,33 @@ extern "C"
             return;
         }
 
+        // the calls made during the finalization go through the checks of the
+        // global state
+        dl::withdraw_resolved_table();
+
         bool _invoked = false;
         OMNITRACE_DL_INVOKE_STATUS(_invoked, get_indirect().omnitrace_finalize_f);
         if(_invoked)
         {
             dl::get_active() = false;
             dl::get_finied() = true;
+            dl::update_trace_gate();
+        }
+        else if(dl::get_active())
+        {
+            dl::publish_resolved_table();
         }
     }
 
     void omnitrace_push_trace(const char* name)
     {
+        if(const auto* _table = dl::get_resolved_table())
+            return dl::invoke_resolved(_table->push_trace, name);
+
         if(!dl::get_active()) return;
         if(dl::get_thread_enabled())
         {
+            dl::_omnitrace_dl_thread_resolved = true;
             OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_trace_f, name);
         }
         else
@@ -688,9 +911,13 @@ extern "C"
 
     void omnitrace_pop_trace(const char* name)
     {
+        if(const auto* _table = dl::get_resolved_table())
+            return dl::invoke_resolved(_table->pop_trace, name);
+
         if(!dl::get_active()) return;
         if(dl::get_thread_enabled())
         {
+            dl::_omnitrace_dl_thread_resolved = true;
             OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_trace_f, name);
         }
         else
@@ -701,9 +928,13 @@ extern "C"
 
     int omnitrace_push_region(const char* name)
     {
+        if(const auto* _table = dl::get_resolved_table())
+            return dl::invoke_resolved(_table->push_region, name);
+
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
+            dl::_omnitrace_dl_thread_resolved = true;
             return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_f, name);
         }
         else
@@ -715,9 +946,13 @@ extern "C"
 
     int omnitrace_pop_region(const char* name)
     {
+        if(const auto* _table = dl::get_resolved_table())
+            return dl::invoke_resolved(_table->pop_region, name);
+
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
+            dl::_omnitrace_dl_thread_resolved = true;
             return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_f, name);
         }
         else
@@ -731,9 +966,14 @@ extern "C"
                                        omnitrace_annotation_t* _annotations,
                                        size_t                  _annotation_count)
     {
+        if(const auto* _table = dl::get_resolved_table())
+            return dl::invoke_resolved(_table->push_category_region, _category, name,
+                                       _annotations, _annotation_count);
+
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
+            dl::_omnitrace_dl_thread_resolved = true;
             return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_category_region_f,
                                        _category, name, _annotations, _annotation_count);
         }
@@ -748,9 +988,14 @@ extern "C"
                                       omnitrace_annotation_t* _annotations,
                                       size_t                  _annotation_count)
     {
+        if(const auto* _table = dl::get_resolved_table())
+            return dl::invoke_resolved(_table->pop_category_region, _category, name,
+                                       _annotations, _annotation_count);
+
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
+            dl::_omnitrace_dl_thread_resolved = true;
             return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_category_region_f,
                                        _category, name, _annotations, _annotation_count);
         }
@@ -798,15 +1043,73 @@ extern "C"
                             address);
     }
 
+    void omnitrace_register_coverage_counter(const char* file, const char* func,
+                                             size_t line, size_t address,
+                                             const char*              source,
+                                             const volatile uint64_t* counter)
+    {
+        OMNITRACE_DL_LOG(3, "%s(\"%s\", \"%s\", %zu, %zu, \"%s\", %p)\n", __FUNCTION__,
+                         file, func, line, address, source, (const void*) counter);
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_coverage_counter_f, file,
+                            func, line, address, source, counter);
+    }
+
+    void omnitrace_register_loop(const char* name, uint64_t id)
+    {
+        OMNITRACE_DL_LOG(3, "%s(\"%s\", %lu)\n", __FUNCTION__, name, (unsigned long) id);
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_loop_f, name, id);
+    }
+
+    void omnitrace_loop_trip(uint64_t id)
+    {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->loop_trip, id);
+
+        if(!dl::get_active()) return;
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_loop_trip_f, id);
+    }
+
+    // the hooks inserted by -finstrument-functions. The application only links to
+    // libomnitrace-dl so these are not defined by libomnitrace
+    void __cyg_profile_func_enter(void* func, void* call_site)
+    {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->function_enter, func, call_site);
+
+        if(!dl::get_active()) return;
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_function_enter_f, func, call_site);
+    }
+
+    void __cyg_profile_func_exit(void* func, void* call_site)
+    {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->function_exit, func, call_site);
+
+        if(!dl::get_active()) return;
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_function_exit_f, func, call_site);
+    }
+
+    void omnitrace_register_python_sampler(omnitrace_python_unwind_func_t  unwind,
+                                           omnitrace_python_resolve_func_t resolve)
+    {
+        OMNITRACE_DL_LOG(2, "%s(%p, %p)\n", __FUNCTION__, (void*) unwind,
+                         (void*) resolve);
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_python_sampler_f, unwind,
+                            resolve);
+    }
+
     int omnitrace_user_start_trace_dl(void)
     {
+        dl::omnitrace_lazy_load();
         dl::get_enabled().store(true);
+        dl::update_trace_gate();
         return omnitrace_user_start_thread_trace_dl();
     }
 
     int omnitrace_user_stop_trace_dl(void)
     {
         dl::get_enabled().store(false);
+        dl::update_trace_gate();
         return omnitrace_user_stop_thread_trace_dl();
     }
 
@@ -818,32 +1121,105 @@ extern "C"
 
     int omnitrace_user_stop_thread_trace_dl(void)
     {
-        dl::get_thread_enabled() = false;
+        dl::get_thread_enabled()          = false;
+        dl::_omnitrace_dl_thread_resolved = false;
         return 0;
     }
 
     int omnitrace_user_push_region_dl(const char* name)
     {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->push_region, name);
+
         if(!dl::get_active()) return 0;
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_f, name);
     }
 
     int omnitrace_user_pop_region_dl(const char* name)
     {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->pop_region, name);
+
         if(!dl::get_active()) return 0;
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_f, name);
     }
 
+    int omnitrace_user_register_region_dl(const char* name, uint64_t* _handle)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_region_f, name,
+                                   _handle);
+    }
+
+    int omnitrace_user_push_region_id_dl(uint64_t _handle)
+    {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->push_region_id, _handle);
+
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_id_f, _handle);
+    }
+
+    int omnitrace_user_pop_region_id_dl(uint64_t _handle)
+    {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->pop_region_id, _handle);
+
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_id_f, _handle);
+    }
+
+    int omnitrace_user_dump_trace_dl(void)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_dump_trace_f);
+    }
+
+    int omnitrace_user_counter_register_dl(const char* name, const char* units,
+                                           uint64_t* _handle)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_counter_f, name,
+                                   units, _handle);
+    }
+
+    int omnitrace_user_counter_record_dl(uint64_t _handle, double _value)
+    {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->record_counter, _handle, _value);
+
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_record_counter_f, _handle,
+                                   _value);
+    }
+
     int omnitrace_user_progress_dl(const char* name)
     {
         OMNITRACE_DL_INVOKE(get_indirect().omnitrace_progress_f, name);
         return 0;
     }
 
+    int omnitrace_user_register_progress_dl(const char* name, uint64_t* _handle)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_progress_f, name,
+                                   _handle);
+    }
+
+    int omnitrace_user_progress_id_dl(uint64_t _handle)
+    {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->progress_id, _handle);
+
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_progress_id_f, _handle);
+    }
+
     int omnitrace_user_push_annotated_region_dl(const char*             name,
                                                 omnitrace_annotation_t* _annotations,
                                                 size_t                  _annotation_count)
     {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->push_category_region,
+                                       OMNITRACE_CATEGORY_USER, name, _annotations,
+                                       _annotation_count);
+
         if(!dl::get_active()) return 0;
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_category_region_f,
                                    OMNITRACE_CATEGORY_USER, name, _annotations,
@@ -854,6 +1230,11 @@ extern "C"
                                                omnitrace_annotation_t* _annotations,
                                                size_t                  _annotation_count)
     {
+        if(const auto* _table = dl::get_resolved_table(false))
+            return dl::invoke_resolved(_table->pop_category_region,
+                                       OMNITRACE_CATEGORY_USER, name, _annotations,
+                                       _annotation_count);
+
         if(!dl::get_active()) return 0;
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_category_region_f,
                                    OMNITRACE_CATEGORY_USER, name, _annotations,
@@ -1060,6 +1441,39 @@ extern "C"
                                    is_device);
     }
 
+    void kokkosp_declare_output_type(const char* name, const size_t id,
+                                     Kokkos_Tools_VariableInfo* info)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().kokkosp_declare_output_type_f, name, id,
+                                   info);
+    }
+
+    void kokkosp_declare_input_type(const char* name, const size_t id,
+                                    Kokkos_Tools_VariableInfo* info)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().kokkosp_declare_input_type_f, name, id,
+                                   info);
+    }
+
+    void kokkosp_request_values(const size_t context, const size_t num_inputs,
+                                const Kokkos_Tools_VariableValue* inputs,
+                                const size_t                      num_outputs,
+                                Kokkos_Tools_VariableValue*       outputs)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().kokkosp_request_values_f, context,
+                                   num_inputs, inputs, num_outputs, outputs);
+    }
+
+    void kokkosp_begin_context(const size_t context)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().kokkosp_begin_context_f, context);
+    }
+
+    void kokkosp_end_context(const size_t context)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().kokkosp_end_context_f, context);
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //      HSA
@@ -1230,6 +1644,8 @@ omnitrace_postinit(std::string _exe)
                 _exe = tim::filepath::readlink(join('/', "/proc", getpid(), "exe"));
 
             omnitrace_init_tooling();
+            // a lazy load on another thread does not begin the region of main
+            if(!get_lazy().push_main) break;
             if(_exe.empty())
                 omnitrace_push_trace("main");
             else
@@ -1245,6 +1661,95 @@ omnitrace_postinit(std::string _exe)
     }
 }
 
+bool
+omnitrace_lazy_setup(int _argc, char** _argv, const std::string& _mode)
+{
+    if(!get_env("OMNITRACE_DL_LAZY", false)) return false;
+
+    auto _cmd = std::string{};
+    for(int i = 0; i < _argc; ++i)
+        _cmd += (i == 0) ? std::string{ _argv[i] } : common::join("", " ", _argv[i]);
+
+    auto _pattern = get_env("OMNITRACE_DL_LAZY_COMMAND", std::string{});
+    if(!_pattern.empty())
+    {
+        try
+        {
+            if(std::regex_search(_cmd, std::regex{ _pattern }))
+            {
+                OMNITRACE_DL_LOG(1, "%s() :: '%s' matches OMNITRACE_DL_LAZY_COMMAND\n",
+                                 __FUNCTION__, _cmd.c_str());
+                return false;
+            }
+        } catch(std::regex_error& _e)
+        {
+            OMNITRACE_DL_LOG(0, "%s() :: invalid OMNITRACE_DL_LAZY_COMMAND '%s' :: %s\n",
+                             __FUNCTION__, _pattern.c_str(), _e.what());
+        }
+    }
+
+    auto& _lazy          = get_lazy();
+    _lazy.deferred       = true;
+    _lazy.binary_rewrite = (get_instrumented() == InstrumentMode::BinaryRewrite);
+    _lazy.main_thread    = std::this_thread::get_id();
+    _lazy.mode           = _mode;
+    _lazy.exe            = (_argc > 0) ? _argv[0] : "";
+    _lazy.pending.store(true, std::memory_order_release);
+
+    // libomnitrace-user is only searched for among the loaded libraries since the
+    // application can not call omnitrace_user_start_trace() otherwise
+    using user_configure_t =
+        int (*)(int, omnitrace_user_callbacks_t, omnitrace_user_callbacks_t*);
+    indirect::configure_user(reinterpret_cast<user_configure_t>(
+        dlsym(RTLD_DEFAULT, "omnitrace_user_configure")));
+
+    // the signal handler can not load libomnitrace so it wakes a thread which does
+    auto _signal = get_env("OMNITRACE_DL_LAZY_SIGNAL", 0);
+    if(_signal > 0 && pipe2(_lazy.fds, O_CLOEXEC) == 0)
+    {
+        struct sigaction _action = {};
+        sigemptyset(&_action.sa_mask);
+        _action.sa_flags   = SA_RESTART;
+        _action.sa_handler = [](int) {
+            char _v   = 1;
+            auto _ret = write(get_lazy().fds[1], &_v, sizeof(_v));
+            (void) _ret;
+        };
+        sigaction(_signal, &_action, nullptr);
+
+        std::thread{ []() {
+            char    _v   = 0;
+            ssize_t _ret = -1;
+            while((_ret = read(get_lazy().fds[0], &_v, sizeof(_v))) < 0 && errno == EINTR)
+            {}
+            if(_ret > 0) omnitrace_lazy_load();
+        } }.detach();
+    }
+
+    OMNITRACE_DL_LOG(1,
+                     "%s() :: loading libomnitrace is deferred until the first "
+                     "omnitrace_user_start_trace()%s\n",
+                     __FUNCTION__,
+                     (_signal > 0) ? common::join("", " or signal ", _signal).c_str()
+                                   : "");
+    return true;
+}
+
+bool
+omnitrace_lazy_load()
+{
+    auto& _lazy = get_lazy();
+    if(!_lazy.pending.load(std::memory_order_acquire)) return false;
+
+    auto _lk = std::unique_lock<std::mutex>{ _lazy.mutex };
+    if(!_lazy.pending.exchange(false)) return false;
+
+    OMNITRACE_DL_LOG(1, "%s() :: loading libomnitrace\n", __FUNCTION__);
+    _lazy.push_main = (std::this_thread::get_id() == _lazy.main_thread);
+    omnitrace_init(_lazy.mode.c_str(), _lazy.binary_rewrite, _lazy.exe.c_str());
+    return true;
+}
+
 bool
 omnitrace_preload()
 {
@@ -1434,13 +1939,22 @@ extern "C"
         }
 
         auto _mode = get_env("OMNITRACE_MODE", get_default_mode());
-        omnitrace_init(_mode.c_str(),
-                       dl::get_instrumented() == dl::InstrumentMode::BinaryRewrite,
-                       argv[0]);
+        if(!dl::omnitrace_lazy_setup(argc, argv, _mode))
+            omnitrace_init(_mode.c_str(),
+                           dl::get_instrumented() == dl::InstrumentMode::BinaryRewrite,
+                           argv[0]);
 
         int ret = (*::omnitrace::dl::main_real)(argc, argv, envp);
 
-        omnitrace_pop_trace(basename(argv[0]));
+        if(dl::get_lazy().deferred)
+        {
+            // libomnitrace is not loaded once main returns
+            auto _lk = std::unique_lock<std::mutex>{ dl::get_lazy().mutex };
+            dl::get_lazy().pending.store(false);
+            if(!dl::get_inited()) return ret;
+        }
+
+        if(dl::get_lazy().push_main) omnitrace_pop_trace(basename(argv[0]));
         omnitrace_finalize();
 
         return ret;
@@ -77,6 +77,10 @@ extern "C"
                            const char* env_val) OMNITRACE_PUBLIC_API;
     void omnitrace_set_mpi(bool use, bool attached) OMNITRACE_PUBLIC_API;
     void omnitrace_set_instrumented(int) OMNITRACE_PUBLIC_API;
+    /// nonzero while the calls to omnitrace_push_trace and omnitrace_pop_trace can have
+    /// an effect. The snippets of omnitrace-instrument branch around the calls when zero
+    extern int omnitrace_dl_trace_gate OMNITRACE_PUBLIC_API;
+
     void omnitrace_push_trace(const char* name) OMNITRACE_PUBLIC_API;
     void omnitrace_pop_trace(const char* name) OMNITRACE_PUBLIC_API;
     int  omnitrace_push_region(const char*) OMNITRACE_PUBLIC_API;
@@ -93,6 +97,18 @@ extern "C"
                                    const char* source) OMNITRACE_PUBLIC_API;
     void omnitrace_register_coverage(const char* file, const char* func,
                                      size_t address) OMNITRACE_PUBLIC_API;
+    void omnitrace_register_coverage_counter(
+        const char* file, const char* func, size_t line, size_t address,
+        const char* source, const volatile uint64_t* counter) OMNITRACE_PUBLIC_API;
+    void omnitrace_register_loop(const char* name, uint64_t id) OMNITRACE_PUBLIC_API;
+    void omnitrace_loop_trip(uint64_t id) OMNITRACE_PUBLIC_API;
+    void __cyg_profile_func_enter(void*, void*) OMNITRACE_PUBLIC_API
+        __attribute__((no_instrument_function));
+    void __cyg_profile_func_exit(void*, void*) OMNITRACE_PUBLIC_API
+        __attribute__((no_instrument_function));
+    void omnitrace_register_python_sampler(omnitrace_python_unwind_func_t,
+                                           omnitrace_python_resolve_func_t)
+        OMNITRACE_PUBLIC_API;
     void omnitrace_progress(const char*) OMNITRACE_PUBLIC_API;
     void omnitrace_annotated_progress(const char*, omnitrace_annotation_t*,
                                       size_t) OMNITRACE_PUBLIC_API;
@@ -115,9 +131,19 @@ extern "C"
     int omnitrace_user_pop_annotated_region_dl(const char*, omnitrace_annotation_t*,
                                                size_t) OMNITRACE_HIDDEN_API;
 
+    int omnitrace_user_register_region_dl(const char*, uint64_t*) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_push_region_id_dl(uint64_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_pop_region_id_dl(uint64_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_dump_trace_dl(void) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_counter_register_dl(const char*, const char*,
+                                           uint64_t*) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_counter_record_dl(uint64_t, double) OMNITRACE_HIDDEN_API;
+
     int omnitrace_user_progress_dl(const char* name) OMNITRACE_HIDDEN_API;
     int omnitrace_user_annotated_progress_dl(const char*, omnitrace_annotation_t*,
                                              size_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_register_progress_dl(const char*, uint64_t*) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_progress_id_dl(uint64_t) OMNITRACE_HIDDEN_API;
     // KokkosP
     struct OMNITRACE_HIDDEN_API SpaceHandle
     {
@@ -130,6 +156,10 @@ extern "C"
         bool padding[255];
     };
 
+    // the tuning values are only forwarded
+    struct Kokkos_Tools_VariableInfo;
+    struct Kokkos_Tools_VariableValue;
+
     void kokkosp_print_help(char*) OMNITRACE_PUBLIC_API;
     void kokkosp_parse_args(int, char**) OMNITRACE_PUBLIC_API;
     void kokkosp_declare_metadata(const char*, const char*) OMNITRACE_PUBLIC_API;
@@ -167,6 +197,15 @@ extern "C"
                                 bool) OMNITRACE_PUBLIC_API;
     void kokkosp_dual_view_modify(const char*, const void* const,
                                   bool) OMNITRACE_PUBLIC_API;
+    void kokkosp_declare_output_type(const char*, const size_t,
+                                     Kokkos_Tools_VariableInfo*) OMNITRACE_PUBLIC_API;
+    void kokkosp_declare_input_type(const char*, const size_t,
+                                    Kokkos_Tools_VariableInfo*) OMNITRACE_PUBLIC_API;
+    void kokkosp_request_values(const size_t, const size_t,
+                                const Kokkos_Tools_VariableValue*, const size_t,
+                                Kokkos_Tools_VariableValue*) OMNITRACE_PUBLIC_API;
+    void kokkosp_begin_context(const size_t) OMNITRACE_PUBLIC_API;
+    void kokkosp_end_context(const size_t) OMNITRACE_PUBLIC_API;
 
     // OpenMP Tools (OMPT)
 #    if OMNITRACE_USE_OMPT > 0
@@ -82,6 +82,15 @@ extern "C"
         OMNITRACE_CATEGORY_NUMA,
         OMNITRACE_CATEGORY_TIMER_SAMPLING,
         OMNITRACE_CATEGORY_OVERFLOW_SAMPLING,
+        OMNITRACE_CATEGORY_HEAP_PROFILE,
+        OMNITRACE_CATEGORY_CRITICAL_PATH,
+        OMNITRACE_CATEGORY_GPU_MEMORY,
+        OMNITRACE_CATEGORY_USER_COUNTER,
+        OMNITRACE_CATEGORY_MEMORY_BANDWIDTH,
+        OMNITRACE_CATEGORY_IO,
+        OMNITRACE_CATEGORY_MPI_PVARS,
+        OMNITRACE_CATEGORY_KERNEL_LAUNCH,
+        OMNITRACE_CATEGORY_MEMORY_FOOTPRINT,
         OMNITRACE_CATEGORY_LAST
         // the value of below enum is used for iterating
         // over the enum in C++ templates. It MUST
@@ -48,8 +48,20 @@
 #        define OMNITRACE_CAUSAL_LABEL __FILE__ ":" OMNITRACE_CAUSAL_STR(__LINE__)
 #    endif
 #    if !defined(OMNITRACE_CAUSAL_PROGRESS)
-/** Adds a throughput progress point with label `<file>:<line>` */
-#        define OMNITRACE_CAUSAL_PROGRESS omnitrace_user_progress(OMNITRACE_CAUSAL_LABEL);
+/** Adds a throughput progress point with label `<file>:<line>`. The label is registered
+ * on the first pass so the following passes only increment a counter of the calling
+ * thread. */
+#        define OMNITRACE_CAUSAL_PROGRESS                                                \
+            {                                                                            \
+                static uint64_t _omnitrace_causal_progress_id = 0;                       \
+                if(_omnitrace_causal_progress_id == 0)                                   \
+                    omnitrace_user_register_progress(OMNITRACE_CAUSAL_LABEL,             \
+                                                     &_omnitrace_causal_progress_id);    \
+                if(_omnitrace_causal_progress_id != 0)                                   \
+                    omnitrace_user_progress_id(_omnitrace_causal_progress_id);           \
+                else                                                                     \
+                    omnitrace_user_progress(OMNITRACE_CAUSAL_LABEL);                     \
+            }
 #    endif
 #    if !defined(OMNITRACE_CAUSAL_PROGRESS_NAMED)
 /** Adds a throughput progress point with user defined label. Each instance should use a
@@ -36,6 +36,19 @@ extern "C"
     typedef int (*omnitrace_region_func_t)(const char*);
     typedef int (*omnitrace_annotated_region_func_t)(const char*, omnitrace_annotation*,
                                                      size_t);
+    typedef int (*omnitrace_register_region_func_t)(const char*, uint64_t*);
+    typedef int (*omnitrace_region_id_func_t)(uint64_t);
+    typedef int (*omnitrace_register_counter_func_t)(const char*, const char*, uint64_t*);
+    typedef int (*omnitrace_record_counter_func_t)(uint64_t, double);
+
+    /// unwinds the Python call-stack of the calling thread, starting at the innermost
+    /// frame, into the code objects, the bytecode offsets, and whether the frame is the
+    /// first frame of an invocation of the interpreter loop. Invoked in a signal handler
+    typedef size_t (*omnitrace_python_unwind_func_t)(const void**, int*, int*, size_t);
+    /// resolves the function name, the filename, and the line number of a bytecode
+    /// offset in an unwound code object. Returns zero if the code object is not valid
+    typedef int (*omnitrace_python_resolve_func_t)(const void*, int, const char**,
+                                                   const char**, int*);
 
     /// @struct omnitrace_user_callbacks
     /// @brief Struct containing the callbacks for the user API
@@ -53,6 +66,14 @@ extern "C"
         omnitrace_annotated_region_func_t push_annotated_region;
         omnitrace_annotated_region_func_t pop_annotated_region;
         omnitrace_annotated_region_func_t annotated_progress;
+        omnitrace_register_region_func_t  register_region;
+        omnitrace_region_id_func_t        push_region_id;
+        omnitrace_region_id_func_t        pop_region_id;
+        omnitrace_trace_func_t            dump_trace;
+        omnitrace_register_counter_func_t register_counter;
+        omnitrace_record_counter_func_t   record_counter;
+        omnitrace_register_region_func_t  register_progress;
+        omnitrace_region_id_func_t        progress_id;
 
         /// @var start_trace
         /// @brief callback for enabling tracing globally
@@ -74,6 +95,22 @@ extern "C"
         /// @brief callback for ending a trace region + annotations
         /// @var annotated_progress
         /// @brief callback for marking an causal profiling event + annotations
+        /// @var register_region
+        /// @brief callback for registering a region name and returning its handle
+        /// @var push_region_id
+        /// @brief callback for starting a trace region via a registered handle
+        /// @var pop_region_id
+        /// @brief callback for ending a trace region via a registered handle
+        /// @var dump_trace
+        /// @brief callback for writing the current contents of the flight recorder
+        /// @var register_counter
+        /// @brief callback for registering a counter name and returning its handle
+        /// @var record_counter
+        /// @brief callback for recording a value of a registered counter
+        /// @var register_progress
+        /// @brief callback for registering a progress point and returning its handle
+        /// @var progress_id
+        /// @brief callback for marking a causal profiling event via a registered handle
     } omnitrace_user_callbacks_t;
 
     /// @enum OMNITRACE_USER_CONFIGURE_MODE
@@ -110,7 +147,8 @@ extern "C"
 #ifndef OMNITRACE_USER_CALLBACKS_INIT
 #    define OMNITRACE_USER_CALLBACKS_INIT                                                \
         {                                                                                \
-            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL                   \
+            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,      \
+                NULL, NULL, NULL, NULL, NULL, NULL                                       \
         }
 #endif
 
@@ -104,6 +104,60 @@ extern "C"
     extern int omnitrace_user_pop_annotated_region(const char*, omnitrace_annotation_t*,
                                                    size_t) OMNITRACE_PUBLIC_API;
 
+    /// @fn int omnitrace_user_register_region(const char* id, uint64_t* handle)
+    /// @param[in] id The string identifier for the region
+    /// @param[out] handle Receives the handle for the region
+    /// @return omnitrace_user_error_t value
+    /// @brief Register a user defined region once and receive a handle which can be
+    /// passed to @ref omnitrace_user_push_region_id and
+    /// @ref omnitrace_user_pop_region_id. The name is hashed and stored at
+    /// registration so pushing and popping via the handle avoids any string work.
+    /// Registering the same name twice returns the same handle.
+    extern int omnitrace_user_register_region(const char*,
+                                              uint64_t*) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_push_region_id(uint64_t handle)
+    /// @param handle Value from @ref omnitrace_user_register_region
+    /// @return omnitrace_user_error_t value
+    /// @brief Start a user defined region via a registered handle.
+    extern int omnitrace_user_push_region_id(uint64_t) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_pop_region_id(uint64_t handle)
+    /// @param handle Value from @ref omnitrace_user_register_region
+    /// @return omnitrace_user_error_t value
+    /// @brief End a user defined region via a registered handle.
+    extern int omnitrace_user_pop_region_id(uint64_t) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_counter_register(const char* name, const char* units,
+    ///                                         uint64_t* handle)
+    /// @param[in] name The string identifier for the counter
+    /// @param[in] units The units of the values (may be NULL)
+    /// @param[out] handle Receives the handle for the counter
+    /// @return omnitrace_user_error_t value
+    /// @brief Register a counter once and receive a handle which can be passed to
+    /// @ref omnitrace_user_counter_record. Each counter is a counter track in the
+    /// perfetto trace which is shared by all the threads. Registering the same name
+    /// twice returns the same handle.
+    extern int omnitrace_user_counter_register(const char*, const char*,
+                                               uint64_t*) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_counter_record(uint64_t handle, double value)
+    /// @param handle Value from @ref omnitrace_user_counter_register
+    /// @param value The value of the counter
+    /// @return omnitrace_user_error_t value
+    /// @brief Record the current value of a registered counter, e.g. a queue depth or
+    /// a residual norm. The value is appended to a buffer of the thread which is
+    /// written to the trace when it is full so the call is cheap enough for inner
+    /// loops.
+    extern int omnitrace_user_counter_record(uint64_t, double) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_dump_trace(void)
+    /// @return omnitrace_user_error_t value
+    /// @brief Write the current contents of the flight recorder
+    /// (OMNITRACE_FLIGHT_RECORDER=ON) to a perfetto-trace-dump-N.proto file and
+    /// continue recording. Has no effect when the flight recorder is disabled.
+    extern int omnitrace_user_dump_trace(void) OMNITRACE_PUBLIC_API;
+
     /// mark causal progress
     extern int omnitrace_user_progress(const char*) OMNITRACE_PUBLIC_API;
 
@@ -111,6 +165,26 @@ extern "C"
     extern int omnitrace_user_annotated_progress(const char*, omnitrace_annotation_t*,
                                                  size_t) OMNITRACE_PUBLIC_API;
 
+    /// @fn int omnitrace_user_register_progress(const char* id, uint64_t* handle)
+    /// @param[in] id The label of the progress point
+    /// @param[out] handle Receives the handle for the progress point
+    /// @return omnitrace_user_error_t value
+    /// @brief Register a throughput progress point once and mark it via
+    /// @ref omnitrace_user_progress_id afterwards. The handle is zero if the progress
+    /// point could not be registered, in which case @ref omnitrace_user_progress
+    /// should be used instead. Registering the same label twice returns the same
+    /// handle.
+    extern int omnitrace_user_register_progress(const char*,
+                                                uint64_t*) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_progress_id(uint64_t handle)
+    /// @param handle Value from @ref omnitrace_user_register_progress
+    /// @return omnitrace_user_error_t value
+    /// @brief Mark causal progress via a registered handle. Unlike
+    /// @ref omnitrace_user_progress, the label is not hashed and nothing is
+    /// allocated: the call increments a counter of the calling thread.
+    extern int omnitrace_user_progress_id(uint64_t) OMNITRACE_PUBLIC_API;
+
     /// @fn int omnitrace_user_configure(omnitrace_user_configure_mode_t mode,
     ///                                  omnitrace_user_callbacks_t inp,
     ///                                  omnitrace_user_callbacks_t* out)
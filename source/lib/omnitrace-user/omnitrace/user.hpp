@@ -0,0 +1,115 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/** @file user.hpp */
+
+#ifndef OMNITRACE_USER_HPP_
+#define OMNITRACE_USER_HPP_
+
+/**
+ * @defgroup OMNITRACE_USER_CXX_GROUP OmniTrace C++ User API
+ *
+ * @{
+ */
+
+#if !defined(OMNITRACE_USER_ENABLED)
+/** Preprocessor switch to enable/disable the C++ user regions. When disabled, the macros
+ * expand to nothing so there is no call into omnitrace at all */
+#    define OMNITRACE_USER_ENABLED 1
+#endif
+
+#if OMNITRACE_USER_ENABLED > 0
+#    include <omnitrace/user.h>
+
+#    include <atomic>
+#    include <cstdint>
+
+namespace omnitrace
+{
+namespace user
+{
+/** Registers the region name via @ref omnitrace_user_register_region. The handle is
+ * cached and only the registration is retried while it is zero, i.e. while the user API
+ * is not bound to omnitrace yet */
+inline uint64_t
+get_region_id(std::atomic<uint64_t>& _cache, const char* _name) noexcept
+{
+    auto _id = _cache.load(std::memory_order_relaxed);
+    if(_id == 0 && omnitrace_user_register_region(_name, &_id) == OMNITRACE_USER_SUCCESS)
+        _cache.store(_id, std::memory_order_relaxed);
+    return _id;
+}
+
+/** Pushes a registered region on construction and pops it on destruction via
+ * @ref omnitrace_user_push_region_id and @ref omnitrace_user_pop_region_id */
+class scoped_region
+{
+public:
+    explicit scoped_region(uint64_t _id) noexcept
+    : m_id{ _id }
+    {
+        if(m_id != 0) omnitrace_user_push_region_id(m_id);
+    }
+
+    ~scoped_region()
+    {
+        if(m_id != 0) omnitrace_user_pop_region_id(m_id);
+    }
+
+    scoped_region(const scoped_region&) = delete;
+    scoped_region(scoped_region&&)      = delete;
+    scoped_region& operator=(const scoped_region&) = delete;
+    scoped_region& operator=(scoped_region&&) = delete;
+
+private:
+    uint64_t m_id = 0;
+};
+}  // namespace user
+}  // namespace omnitrace
+
+/** @cond OMNITRACE_HIDDEN_DEFINES */
+#    define OMNITRACE_USER_CONCAT2(a, b) a##b
+#    define OMNITRACE_USER_CONCAT(a, b)  OMNITRACE_USER_CONCAT2(a, b)
+#    define OMNITRACE_USER_VARIABLE(a)   OMNITRACE_USER_CONCAT(a, __LINE__)
+/** @endcond */
+
+#    if !defined(OMNITRACE_SCOPED_REGION)
+/** Starts a user region which ends at the end of the enclosing scope. The name is
+ * registered once per call site (function-local static) so the push and the pop only
+ * pass the handle. At most one region per line */
+#        define OMNITRACE_SCOPED_REGION(NAME)                                            \
+            static ::std::atomic<uint64_t> OMNITRACE_USER_VARIABLE(                      \
+                _omnitrace_region_id_){ 0 };                                             \
+            ::omnitrace::user::scoped_region OMNITRACE_USER_VARIABLE(                    \
+                _omnitrace_region_){ ::omnitrace::user::get_region_id(                   \
+                OMNITRACE_USER_VARIABLE(_omnitrace_region_id_), NAME) }
+#    endif
+#else
+#    if !defined(OMNITRACE_SCOPED_REGION)
+#        define OMNITRACE_SCOPED_REGION(NAME)
+#    endif
+#endif
+
+/** @} */
+
+#endif  // OMNITRACE_USER_HPP_
@@ -85,6 +85,17 @@ extern "C"
         return invoke(_callbacks.progress, id);
     }
 
+    int omnitrace_user_register_progress(const char* id, uint64_t* handle)
+    {
+        if(!id || !handle) return OMNITRACE_USER_ERROR_BAD_VALUE;
+        return invoke(_callbacks.register_progress, id, handle);
+    }
+
+    int omnitrace_user_progress_id(uint64_t handle)
+    {
+        return invoke(_callbacks.progress_id, handle);
+    }
+
     int omnitrace_user_push_annotated_region(const char* id, annotation_t* _annotations,
                                              size_t _annotation_count)
     {
@@ -105,6 +116,36 @@ extern "C"
         return invoke(_callbacks.annotated_progress, id, _annotations, _annotation_count);
     }
 
+    int omnitrace_user_register_region(const char* id, uint64_t* handle)
+    {
+        if(!id || !handle) return OMNITRACE_USER_ERROR_BAD_VALUE;
+        return invoke(_callbacks.register_region, id, handle);
+    }
+
+    int omnitrace_user_push_region_id(uint64_t handle)
+    {
+        return invoke(_callbacks.push_region_id, handle);
+    }
+
+    int omnitrace_user_pop_region_id(uint64_t handle)
+    {
+        return invoke(_callbacks.pop_region_id, handle);
+    }
+
+    int omnitrace_user_dump_trace(void) { return invoke(_callbacks.dump_trace); }
+
+    int omnitrace_user_counter_register(const char* id, const char* units,
+                                        uint64_t* handle)
+    {
+        if(!id || !handle) return OMNITRACE_USER_ERROR_BAD_VALUE;
+        return invoke(_callbacks.register_counter, id, units, handle);
+    }
+
+    int omnitrace_user_counter_record(uint64_t handle, double value)
+    {
+        return invoke(_callbacks.record_counter, handle, value);
+    }
+
     int omnitrace_user_configure(omnitrace_user_configure_mode_t mode,
                                  omnitrace_user_callbacks_t      inp,
                                  omnitrace_user_callbacks_t*     out)
@@ -136,6 +177,14 @@ extern "C"
                 _update(_v.push_annotated_region, inp.push_annotated_region);
                 _update(_v.pop_annotated_region, inp.pop_annotated_region);
                 _update(_v.annotated_progress, inp.annotated_progress);
+                _update(_v.register_region, inp.register_region);
+                _update(_v.push_region_id, inp.push_region_id);
+                _update(_v.pop_region_id, inp.pop_region_id);
+                _update(_v.dump_trace, inp.dump_trace);
+                _update(_v.register_counter, inp.register_counter);
+                _update(_v.record_counter, inp.record_counter);
+                _update(_v.register_progress, inp.register_progress);
+                _update(_v.progress_id, inp.progress_id);
 
                 _callbacks = _v;
                 break;
@@ -158,6 +207,14 @@ extern "C"
                 _update(_v.push_annotated_region, inp.push_annotated_region);
                 _update(_v.pop_annotated_region, inp.pop_annotated_region);
                 _update(_v.annotated_progress, inp.annotated_progress);
+                _update(_v.register_region, inp.register_region);
+                _update(_v.push_region_id, inp.push_region_id);
+                _update(_v.pop_region_id, inp.pop_region_id);
+                _update(_v.dump_trace, inp.dump_trace);
+                _update(_v.register_counter, inp.register_counter);
+                _update(_v.record_counter, inp.record_counter);
+                _update(_v.register_progress, inp.register_progress);
+                _update(_v.progress_id, inp.progress_id);
 
                 _callbacks = _v;
                 break;
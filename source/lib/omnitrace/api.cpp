@@ -100,6 +100,90 @@ omnitrace_pop_category_region(omnitrace_category_t _category, const char* _name,
     return 0;
 }
 
+extern "C" int
+omnitrace_register_region(const char* _name, uint64_t* _handle)
+{
+    try
+    {
+        omnitrace_register_region_hidden(_name, _handle);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_push_region_id(uint64_t _handle)
+{
+    try
+    {
+        omnitrace_push_region_id_hidden(_handle);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_pop_region_id(uint64_t _handle)
+{
+    try
+    {
+        omnitrace_pop_region_id_hidden(_handle);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_register_counter(const char* _name, const char* _units, uint64_t* _handle)
+{
+    try
+    {
+        omnitrace_register_counter_hidden(_name, _units, _handle);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_record_counter(uint64_t _handle, double _value)
+{
+    try
+    {
+        omnitrace_record_counter_hidden(_handle, _value);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_dump_trace(void)
+{
+    try
+    {
+        omnitrace_dump_trace_hidden();
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
 extern "C" void
 omnitrace_progress(const char* _name)
 {
@@ -113,6 +197,27 @@ omnitrace_annotated_progress(const char* _name, omnitrace_annotation_t* _annotat
     omnitrace_annotated_progress_hidden(_name, _annotations, _annotation_count);
 }
 
+extern "C" int
+omnitrace_register_progress(const char* _name, uint64_t* _handle)
+{
+    try
+    {
+        omnitrace_register_progress_hidden(_name, _handle);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_progress_id(uint64_t _handle)
+{
+    omnitrace_progress_id_hidden(_handle);
+    return 0;
+}
+
 extern "C" void
 omnitrace_init_library(void)
 {
@@ -167,3 +272,43 @@ omnitrace_register_coverage(const char* file, const char* func, size_t address)
 {
     omnitrace_register_coverage_hidden(file, func, address);
 }
+
+extern "C" void
+omnitrace_register_coverage_counter(const char* file, const char* func, size_t line,
+                                    size_t address, const char* source,
+                                    const volatile uint64_t* counter)
+{
+    omnitrace_register_coverage_counter_hidden(file, func, line, address, source,
+                                               counter);
+}
+
+extern "C" void
+omnitrace_register_loop(const char* name, uint64_t id)
+{
+    omnitrace_register_loop_hidden(name, id);
+}
+
+extern "C" void
+omnitrace_loop_trip(uint64_t id)
+{
+    omnitrace_loop_trip_hidden(id);
+}
+
+extern "C" void
+omnitrace_function_enter(void* func, void* call_site)
+{
+    omnitrace_function_enter_hidden(func, call_site);
+}
+
+extern "C" void
+omnitrace_function_exit(void* func, void* call_site)
+{
+    omnitrace_function_exit_hidden(func, call_site);
+}
+
+extern "C" void
+omnitrace_register_python_sampler(omnitrace_python_unwind_func_t  unwind,
+                                  omnitrace_python_resolve_func_t resolve)
+{
+    omnitrace_register_python_sampler_hidden(unwind, resolve);
+}
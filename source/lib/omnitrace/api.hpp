@@ -24,10 +24,12 @@
 
 #include "core/defines.hpp"
 #include "omnitrace/categories.h"  // in omnitrace-user
+#include "omnitrace/types.h"       // in omnitrace-user
 
 #include <timemory/compat/macros.h>
 
 #include <cstddef>
+#include <cstdint>
 
 // forward decl of the API
 extern "C"
@@ -77,6 +79,22 @@ extern "C"
                                       omnitrace_annotation_t*,
                                       size_t) OMNITRACE_PUBLIC_API;
 
+    /// registers a user-defined region and provides a handle for the push/pop by id
+    int omnitrace_register_region(const char*, uint64_t*) OMNITRACE_PUBLIC_API;
+
+    /// starts a registered instrumentation region (user-defined)
+    int omnitrace_push_region_id(uint64_t) OMNITRACE_PUBLIC_API;
+
+    /// stops a registered instrumentation region (user-defined)
+    int omnitrace_pop_region_id(uint64_t) OMNITRACE_PUBLIC_API;
+
+    /// registers a user-defined counter and provides a handle for the records
+    int omnitrace_register_counter(const char*, const char*,
+                                   uint64_t*) OMNITRACE_PUBLIC_API;
+
+    /// records a value of a registered counter (user-defined)
+    int omnitrace_record_counter(uint64_t, double) OMNITRACE_PUBLIC_API;
+
     /// stores source code information
     void omnitrace_register_source(const char* file, const char* func, size_t line,
                                    size_t      address,
@@ -86,6 +104,32 @@ extern "C"
     void omnitrace_register_coverage(const char* file, const char* func,
                                      size_t address) OMNITRACE_PUBLIC_API;
 
+    /// stores source code information and the counter which the instrumentation
+    /// increments inline
+    void omnitrace_register_coverage_counter(
+        const char* file, const char* func, size_t line, size_t address,
+        const char* source, const volatile uint64_t* counter) OMNITRACE_PUBLIC_API;
+
+    /// stores the label of a loop whose trips are counted by the instrumentation
+    void omnitrace_register_loop(const char* name, uint64_t id) OMNITRACE_PUBLIC_API;
+
+    /// increments the trip count of a registered loop on the calling thread
+    void omnitrace_loop_trip(uint64_t id) OMNITRACE_PUBLIC_API;
+
+    /// starts the region of a function compiled with -finstrument-functions
+    void omnitrace_function_enter(void* func, void* call_site) OMNITRACE_PUBLIC_API;
+
+    /// stops the region of a function compiled with -finstrument-functions
+    void omnitrace_function_exit(void* func, void* call_site) OMNITRACE_PUBLIC_API;
+
+    /// sets the functions which unwind and resolve the Python call-stacks of the samples
+    void omnitrace_register_python_sampler(omnitrace_python_unwind_func_t,
+                                           omnitrace_python_resolve_func_t)
+        OMNITRACE_PUBLIC_API;
+
+    /// writes the current contents of the flight recorder
+    int omnitrace_dump_trace(void) OMNITRACE_PUBLIC_API;
+
     /// mark causal progress
     void omnitrace_progress(const char*) OMNITRACE_PUBLIC_API;
 
@@ -93,6 +137,12 @@ extern "C"
     void omnitrace_annotated_progress(const char*, omnitrace_annotation_t*,
                                       size_t) OMNITRACE_PUBLIC_API;
 
+    /// registers a causal progress point and returns its handle
+    int omnitrace_register_progress(const char*, uint64_t*) OMNITRACE_PUBLIC_API;
+
+    /// mark causal progress of a registered progress point
+    int omnitrace_progress_id(uint64_t) OMNITRACE_PUBLIC_API;
+
     // these are the real implementations for internal calling convention
     void omnitrace_init_library_hidden(void) OMNITRACE_HIDDEN_API;
     bool omnitrace_init_tooling_hidden(void) OMNITRACE_HIDDEN_API;
@@ -111,11 +161,30 @@ extern "C"
     void omnitrace_pop_category_region_hidden(omnitrace_category_t, const char*,
                                               omnitrace_annotation_t*,
                                               size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_region_hidden(const char*, uint64_t*) OMNITRACE_HIDDEN_API;
+    void omnitrace_push_region_id_hidden(uint64_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_pop_region_id_hidden(uint64_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_counter_hidden(const char*, const char*,
+                                           uint64_t*) OMNITRACE_HIDDEN_API;
+    void omnitrace_record_counter_hidden(uint64_t, double) OMNITRACE_HIDDEN_API;
     void omnitrace_register_source_hidden(const char*, const char*, size_t, size_t,
                                           const char*) OMNITRACE_HIDDEN_API;
     void omnitrace_register_coverage_hidden(const char*, const char*,
                                             size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_coverage_counter_hidden(
+        const char*, const char*, size_t, size_t, const char*,
+        const volatile uint64_t*) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_loop_hidden(const char*, uint64_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_loop_trip_hidden(uint64_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_function_enter_hidden(void*, void*) OMNITRACE_HIDDEN_API;
+    void omnitrace_function_exit_hidden(void*, void*) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_python_sampler_hidden(omnitrace_python_unwind_func_t,
+                                                  omnitrace_python_resolve_func_t)
+        OMNITRACE_HIDDEN_API;
+    void omnitrace_dump_trace_hidden(void) OMNITRACE_HIDDEN_API;
     void omnitrace_progress_hidden(const char*) OMNITRACE_HIDDEN_API;
     void omnitrace_annotated_progress_hidden(const char*, omnitrace_annotation_t*,
                                              size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_progress_hidden(const char*, uint64_t*) OMNITRACE_HIDDEN_API;
+    void omnitrace_progress_id_hidden(uint64_t) OMNITRACE_HIDDEN_API;
 }
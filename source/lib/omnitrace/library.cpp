@@ -27,37 +27,77 @@
 #include "api.hpp"
 #include "common/setup.hpp"
 #include "core/categories.hpp"
+#include "core/clock_sync.hpp"
 #include "core/components/fwd.hpp"
+#include "core/compression.hpp"
 #include "core/concepts.hpp"
 #include "core/config.hpp"
 #include "core/constraint.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/gpu.hpp"
+#include "core/huge_pages.hpp"
 #include "core/locking.hpp"
 #include "core/perfetto_fwd.hpp"
+#include "core/rank_selection.hpp"
+#include "core/self_profile.hpp"
+#include "core/staging.hpp"
 #include "core/timemory.hpp"
+#include "core/tsc.hpp"
 #include "core/utility.hpp"
 #include "library/causal/data.hpp"
 #include "library/causal/experiment.hpp"
 #include "library/causal/sampling.hpp"
+#include "library/columnar_output.hpp"
+#include "library/comm_histogram.hpp"
+#include "library/components/comm_data.hpp"
 #include "library/components/exit_gotcha.hpp"
 #include "library/components/fork_gotcha.hpp"
+#include "library/components/io_gotcha.hpp"
+#include "library/components/malloc_gotcha.hpp"
 #include "library/components/mpi_gotcha.hpp"
 #include "library/components/numa_gotcha.hpp"
 #include "library/components/pthread_gotcha.hpp"
+#include "library/components/python_gil_gotcha.hpp"
 #include "library/components/rocprofiler.hpp"
+#include "library/compiler_instrumentation.hpp"
 #include "library/coverage.hpp"
+#include "library/critical_path.hpp"
+#include "library/emergency_dump.hpp"
+#include "library/flight_recorder.hpp"
+#include "library/fork_capture.hpp"
+#include "library/gpu_attribution.hpp"
+#include "library/gpu_memory.hpp"
+#include "library/heap_profile.hpp"
+#include "library/hip_api_stacks.hpp"
+#include "library/hip_graph.hpp"
+#include "library/io_trace.hpp"
+#include "library/kernel_launch.hpp"
+#include "library/lock_profile.hpp"
+#include "library/loop_trips.hpp"
+#include "library/memcpy_analysis.hpp"
 #include "library/ompt.hpp"
+#include "library/ompt_aggregate.hpp"
+#include "library/ompt_barrier.hpp"
+#include "library/ompt_device.hpp"
+#include "library/pc_sampling.hpp"
+#include "library/perf_counters.hpp"
 #include "library/process_sampler.hpp"
+#include "library/profile_aggregate.hpp"
+#include "library/profile_merge.hpp"
 #include "library/ptl.hpp"
+#include "library/python_gil.hpp"
+#include "library/rccl_timing.hpp"
 #include "library/rcclp.hpp"
 #include "library/rocprofiler.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
+#include "library/timeline_profile.hpp"
+#include "library/trace_trigger.hpp"
 #include "library/tracing.hpp"
+#include "library/user_counters.hpp"
 #include "omnitrace/categories.h"  // in omnitrace-user
 
 #include <timemory/hash/types.hpp>
@@ -76,16 +116,21 @@
 #include <timemory/utility/join.hpp>
 #include <timemory/utility/procfs/maps.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <iomanip>
+#include <memory>
 #include <mutex>
 #include <pthread.h>
+#include <sstream>
 #include <stdexcept>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 using namespace omnitrace;
 
@@ -128,6 +173,82 @@ ensure_initialization(bool _offset, int64_t _glob_n, int64_t _offset_n)
     return _offset;
 }
 
+struct phase_time
+{
+    std::string_view name  = {};
+    int64_t          start = 0;
+    int64_t          stop  = 0;
+};
+
+using phase_times_t = std::vector<phase_time>;
+
+// wall-clock timestamps of each phase of the initialization in the order they completed
+auto&
+get_startup_phases()
+{
+    static auto _v = phase_times_t{};
+    return _v;
+}
+
+// same for the finalization. Post-processing stages may overlap
+auto&
+get_finalize_phases()
+{
+    static auto _v = phase_times_t{};
+    return _v;
+}
+
+struct phase_timer
+{
+    phase_timer(phase_times_t& _times, std::string_view _name)
+    : m_times{ _times }
+    , m_name{ _name }
+    {}
+
+    ~phase_timer()
+    {
+        static auto _mutex = std::mutex{};
+        auto        _stop  = tim::get_clock_real_now<int64_t, std::nano>();
+        auto        _lk    = std::unique_lock<std::mutex>{ _mutex };
+        m_times.emplace_back(phase_time{ m_name, m_start, _stop });
+    }
+
+    phase_timer(const phase_timer&) = delete;
+    phase_timer& operator=(const phase_timer&) = delete;
+
+private:
+    phase_times_t&   m_times;
+    std::string_view m_name  = {};
+    int64_t          m_start = tim::get_clock_real_now<int64_t, std::nano>();
+};
+
+// logs the duration of each phase and adds them to the metadata as
+// OMNITRACE_<PREFIX>_<PHASE>_MSEC. The total is the wall-clock time from the start of
+// the first phase to the end of the last phase since the phases may overlap
+void
+report_phases(std::string_view _label, std::string_view _prefix,
+              const phase_times_t& _phases)
+{
+    if(_phases.empty()) return;
+
+    auto _ss    = std::stringstream{};
+    auto _start = _phases.front().start;
+    auto _stop  = _phases.front().stop;
+    _ss << std::setprecision(3) << std::fixed;
+    for(const auto& itr : _phases)
+    {
+        auto _msec = static_cast<double>(itr.stop - itr.start) / units::msec;
+        _ss << ((&itr != &_phases.front()) ? ", " : "") << itr.name << "=" << _msec;
+        _start = std::min(_start, itr.start);
+        _stop  = std::max(_stop, itr.stop);
+        tim::manager::add_metadata(JOIN("_", "OMNITRACE", _prefix, itr.name, "MSEC"),
+                                   _msec);
+    }
+    OMNITRACE_VERBOSE_F(1, "%s phases (msec): %s (total: %.3f)\n", _label.data(),
+                        _ss.str().c_str(),
+                        static_cast<double>(_stop - _start) / units::msec);
+}
+
 void
 finalization_handler()
 {
@@ -372,15 +493,6 @@ omnitrace_init_library_hidden()
                                         std::to_string(get_state()).c_str(),
                                         std::to_string(State::Init).c_str());
 
-    OMNITRACE_CONDITIONAL_BASIC_PRINT_F(
-        _debug_init, "Calling backtrace once so that the one-time call of malloc in "
-                     "glibc's backtrace() occurs...\n");
-    {
-        std::stringstream _ss{};
-        timemory_print_backtrace<16>(_ss);
-        (void) _ss;
-    }
-
     set_state(State::Init);
 
     OMNITRACE_CI_THROW(get_state() != State::Init,
@@ -390,7 +502,23 @@ omnitrace_init_library_hidden()
     OMNITRACE_CONDITIONAL_BASIC_PRINT_F(_debug_init, "Configuring settings...\n");
 
     // configure the settings
-    configure_settings();
+    {
+        auto _phase = phase_timer{ get_startup_phases(), "CONFIGURE" };
+        configure_settings();
+    }
+
+    // the backtrace is only required to be async-signal-safe for the sampling
+    // signal handlers so the warm-up can be skipped for a fast start without them
+    if(!get_fast_start() || get_use_sampling() || get_use_causal())
+    {
+        OMNITRACE_CONDITIONAL_BASIC_PRINT_F(
+            _debug_init, "Calling backtrace once so that the one-time call of malloc in "
+                         "glibc's backtrace() occurs...\n");
+        auto              _phase = phase_timer{ get_startup_phases(), "BACKTRACE" };
+        std::stringstream _ss{};
+        timemory_print_backtrace<16>(_ss);
+        (void) _ss;
+    }
 
     auto _debug_value = get_debug();
     if(_debug_init) config::set_setting_value("OMNITRACE_DEBUG", true);
@@ -398,6 +526,16 @@ omnitrace_init_library_hidden()
         if(_debug_init) config::set_setting_value("OMNITRACE_DEBUG", _debug_value);
     } };
 
+    // calibrate before any thread records a timestamp so that every timestamp
+    // is converted with the same multiplier
+    if(get_use_tsc_clock())
+    {
+        auto _phase    = phase_timer{ get_startup_phases(), "TSC_CALIBRATION" };
+        auto _interval = static_cast<uint64_t>(
+            std::max<double>(get_tsc_clock_interval(), 0.0) * units::sec);
+        tsc::calibrate((get_fast_start()) ? units::msec : 10 * units::msec, _interval);
+    }
+
     tim::trait::runtime_enabled<comp::roctracer>::set(get_use_roctracer());
     tim::trait::runtime_enabled<comp::roctracer_data>::set(get_use_roctracer() &&
                                                            get_use_timemory());
@@ -452,15 +590,19 @@ omnitrace_init_tooling_hidden()
     auto _dtor = scope::destructor{ []() {
         // if set to finalized, don't continue
         if(get_state() > State::Active) return;
+        // before any thread of omnitrace is created so they are all counted
+        huge_pages::setup();
         if(get_use_process_sampling())
         {
             OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+            auto _phase = phase_timer{ get_startup_phases(), "PROCESS_SAMPLER" };
             process_sampler::setup();
         }
         if(get_use_causal())
         {
             {
                 OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+                auto _phase = phase_timer{ get_startup_phases(), "SAMPLING" };
                 causal::sampling::setup();
             }
             push_enable_sampling_on_child_threads(get_use_causal());
@@ -470,12 +612,14 @@ omnitrace_init_tooling_hidden()
         {
             {
                 OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+                auto _phase = phase_timer{ get_startup_phases(), "SAMPLING" };
                 sampling::setup();
             }
             push_enable_sampling_on_child_threads(get_use_sampling());
             sampling::unblock_signals();
         }
         get_main_bundle()->start();
+        report_phases("Startup", "STARTUP", get_startup_phases());
         OMNITRACE_DEBUG_F("State: %s -> State::Active\n",
                           std::to_string(get_state()).c_str());
         set_state(State::Active);  // set to active as very last operation
@@ -495,10 +639,16 @@ omnitrace_init_tooling_hidden()
     if(get_use_perfetto())
     {
         OMNITRACE_VERBOSE_F(1, "Setting up Perfetto...\n");
+        auto _phase = phase_timer{ get_startup_phases(), "PERFETTO_SETUP" };
         omnitrace::perfetto::setup();
     }
 
-    tasking::setup();
+    // with a fast start, the thread-pool is created when the first task is submitted
+    if(!get_fast_start())
+    {
+        auto _phase = phase_timer{ get_startup_phases(), "THREAD_POOL" };
+        tasking::setup();
+    }
 
     if(get_use_causal()) causal::start_experimenting();
 
@@ -534,22 +684,35 @@ omnitrace_init_tooling_hidden()
     if(get_use_ompt())
     {
         OMNITRACE_VERBOSE_F(1, "Setting up OMPT...\n");
+        auto _phase = phase_timer{ get_startup_phases(), "OMPT" };
         ompt::setup();
     }
 
     if(get_use_rcclp())
     {
         OMNITRACE_VERBOSE_F(1, "Setting up RCCLP...\n");
+        auto _phase = phase_timer{ get_startup_phases(), "RCCLP" };
         rcclp::setup();
     }
 
     if(get_use_perfetto())
     {
         OMNITRACE_VERBOSE_F(1, "Starting Perfetto...\n");
+        auto _phase = phase_timer{ get_startup_phases(), "PERFETTO_START" };
         omnitrace::perfetto::start();
+        flight_recorder::setup();
     }
 
     categories::setup();
+    trace_trigger::setup();
+    emergency_dump::setup();
+
+    if(get_use_compiler_instrumentation())
+    {
+        OMNITRACE_VERBOSE_F(1, "Setting up the compiler instrumentation...\n");
+        auto _phase = phase_timer{ get_startup_phases(), "COMPILER_INSTRUMENTATION" };
+        compiler_instrumentation::setup();
+    }
 
     // if static objects are destroyed in the inverse order of when they are
     // created this should ensure that finalization is called before perfetto
@@ -664,6 +827,14 @@ omnitrace_reset_preload_hidden(void)
 
 //======================================================================================//
 
+extern "C" void
+omnitrace_dump_trace_hidden(void)
+{
+    flight_recorder::dump();
+}
+
+//======================================================================================//
+
 extern "C" void
 omnitrace_finalize_hidden(void)
 {
@@ -685,6 +856,7 @@ omnitrace_finalize_hidden(void)
     }
     else if(_is_child)
     {
+        fork_capture::post_process();
         set_state(State::Finalized);
         std::quick_exit(EXIT_SUCCESS);
         return;
@@ -710,6 +882,7 @@ omnitrace_finalize_hidden(void)
     // e.g. omnitrace_pop_trace("main");
     if(_push_count > _pop_count)
     {
+        auto _phase = phase_timer{ get_finalize_phases(), "POP_REGIONS" };
         for(auto& itr : tracing::get_finalization_functions())
         {
             itr();
@@ -720,12 +893,19 @@ omnitrace_finalize_hidden(void)
     if(get_use_roctracer())
     {
         OMNITRACE_VERBOSE_F(1, "Flushing roctracer...\n");
+        auto _phase = phase_timer{ get_finalize_phases(), "ROCTRACER_FLUSH" };
         // ensure that roctracer is flushed before setting the state to finalized
         comp::roctracer::flush();
     }
 
+    // the bytes communicated after the last update of the counter tracks
+    component::comm_data::flush();
+
     set_state(State::Finalized);
 
+    // the buffers are released during the finalization
+    emergency_dump::shutdown();
+
     push_enable_sampling_on_child_threads(false);
     set_sampling_on_all_future_threads(false);
 
@@ -772,6 +952,9 @@ omnitrace_finalize_hidden(void)
     fini_bundle_t _finalization{};
     _finalization.start();
 
+    auto _shutdown_phase =
+        std::make_unique<phase_timer>(get_finalize_phases(), "SHUTDOWN");
+
     if(get_use_rcclp())
     {
         OMNITRACE_VERBOSE_F(1, "Shutting down RCCLP...\n");
@@ -784,6 +967,12 @@ omnitrace_finalize_hidden(void)
         ompt::shutdown();
     }
 
+    if(get_use_compiler_instrumentation())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down the compiler instrumentation...\n");
+        compiler_instrumentation::shutdown();
+    }
+
     OMNITRACE_DEBUG_F("Stopping and destroying instrumentation bundles...\n");
     for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
     {
@@ -817,6 +1006,9 @@ omnitrace_finalize_hidden(void)
 
         pthread_gotcha::shutdown();
         component::numa_gotcha::shutdown();
+        component::malloc_gotcha::shutdown();
+        component::io_gotcha::shutdown();
+        component::python_gil_gotcha::shutdown();
     }
 
     // stop the gotcha bundle
@@ -833,6 +1025,18 @@ omnitrace_finalize_hidden(void)
         process_sampler::shutdown();
     }
 
+    if(get_use_perfetto() && config::get_perfetto_deferred_regions())
+    {
+        OMNITRACE_VERBOSE_F(1, "Encoding the deferred perfetto regions...\n");
+        tracing::deferred::shutdown();
+    }
+
+    if(get_use_perfetto() && get_use_flight_recorder())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down the flight recorder...\n");
+        flight_recorder::shutdown();
+    }
+
     if(get_use_roctracer())
     {
         OMNITRACE_VERBOSE_F(1, "Shutting down roctracer...\n");
@@ -844,11 +1048,10 @@ omnitrace_finalize_hidden(void)
         tasking::join();
     }
 
-    if(get_use_rocprofiler())
+    if(get_use_pc_sampling())
     {
-        OMNITRACE_VERBOSE_F(1, "Shutting down rocprofiler...\n");
-        rocprofiler::post_process();
-        rocprofiler::rocm_cleanup();
+        OMNITRACE_VERBOSE_F(1, "Shutting down the GPU PC sampling...\n");
+        pc_sampling::shutdown();
     }
 
     if(get_use_causal())
@@ -863,6 +1066,8 @@ omnitrace_finalize_hidden(void)
         sampling::shutdown();
     }
 
+    _shutdown_phase.reset();
+
     OMNITRACE_VERBOSE_F(3, "Reporting the process- and thread-level metrics...\n");
     // report the high-level metrics for the process
     if(get_main_bundle())
@@ -896,35 +1101,314 @@ omnitrace_finalize_hidden(void)
         }
     }
 
+    // the samplers are stopped so the time spent inside omnitrace is final
+    self_profile::report();
+
     OMNITRACE_VERBOSE_F(0, "\n");
 
+    // the post-processing stages which do not depend on each other run concurrently.
+    // Inline stages run on this thread: sampling uses the thread pool itself and the
+    // rocprofiler and causal stages write to the thread-local storage of this thread
+    auto _post_process = tasking::task_graph{};
+    auto _sampling_ids = std::vector<tasking::task_graph::task_id>{};
+
+    if(get_use_rocprofiler())
+    {
+        _post_process.add(
+            "rocprofiler",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Shutting down rocprofiler...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "ROCPROFILER" };
+                rocprofiler::post_process();
+                rocprofiler::rocm_cleanup();
+            },
+            {}, true);
+    }
+
     // ensure that all the MT instances are flushed
     if(get_use_sampling())
     {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the sampling backtraces...\n");
-        sampling::post_process();
+        _sampling_ids.emplace_back(_post_process.add(
+            "sampling",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the sampling backtraces...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "SAMPLING" };
+                sampling::post_process();
+            },
+            {}, true));
     }
 
     if(get_use_causal())
     {
-        OMNITRACE_VERBOSE_F(1, "Finishing the causal experiments...\n");
-        causal::finish_experimenting();
+        _post_process.add(
+            "causal",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Finishing the causal experiments...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "CAUSAL" };
+                causal::finish_experimenting();
+            },
+            _sampling_ids, true);
     }
 
     if(get_use_process_sampling())
     {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the system-level samples...\n");
-        process_sampler::post_process();
+        _post_process.add("process_sampler", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the system-level samples...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "PROCESS_SAMPLER" };
+            process_sampler::post_process();
+        });
+    }
+
+    if(get_use_code_coverage())
+    {
+        _post_process.add("coverage", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the code coverage...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "COVERAGE" };
+            coverage::post_process();
+        });
+    }
+
+    if(get_use_sampling() && get_sampling_coverage())
+    {
+        _post_process.add(
+            "sampling_coverage",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the sampling code coverage...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "SAMPLING_COVERAGE" };
+                coverage::post_process_sampling();
+            },
+            _sampling_ids);
+    }
+
+    if(loop_trips::size() > 0)
+    {
+        // the records are appended by the samplers which are stopped by the sampling
+        _post_process.add(
+            "loop_trips",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the loop trip counts...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "LOOP_TRIPS" };
+                loop_trips::post_process();
+            },
+            _sampling_ids);
+    }
+
+    if(user_counters::size() > 0)
+    {
+        _post_process.add("user_counters", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the user counters...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "USER_COUNTERS" };
+            user_counters::post_process();
+        });
+    }
+
+    if(config::get_timeline_profile_compact())
+    {
+        _post_process.add("timeline_profile", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the timeline profile...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "TIMELINE_PROFILE" };
+            timeline_profile::post_process();
+        });
+    }
+
+    if(config::get_trace_thread_locks_profile())
+    {
+        _post_process.add("lock_profile", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the lock profile...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "LOCK_PROFILE" };
+            lock_profile::post_process();
+        });
+    }
+
+    if(config::get_heap_profile())
+    {
+        _post_process.add("heap_profile", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the heap profile...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "HEAP_PROFILE" };
+            heap_profile::post_process();
+        });
+    }
+
+    if(config::get_io_trace())
+    {
+        _post_process.add("io_trace", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the I/O trace...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "IO_TRACE" };
+            io_trace::post_process();
+        });
+    }
+
+    // inline since the timemory data is inserted into the storage of the threads. The
+    // waits found in the samples are added by the sampling
+    if(config::get_python_gil())
+    {
+        _post_process.add(
+            "python_gil",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the Python GIL contention...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "PYTHON_GIL" };
+                python_gil::post_process();
+            },
+            _sampling_ids, true);
+    }
+
+    if(config::get_gpu_memory_tracking())
+    {
+        _post_process.add("gpu_memory", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the GPU memory allocations...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "GPU_MEMORY" };
+            gpu_memory::post_process();
+        });
+    }
+
+    if(config::get_hip_graphs())
+    {
+        _post_process.add("hip_graphs", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the HIP graph launches...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "HIP_GRAPHS" };
+            hip_graph::post_process();
+        });
+    }
+
+    if(config::get_kernel_launch_latency())
+    {
+        _post_process.add("kernel_launch", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the kernel launch latencies...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "KERNEL_LAUNCH" };
+            kernel_launch::post_process();
+        });
+    }
+
+    if(get_use_pc_sampling())
+    {
+        _post_process.add("pc_sampling", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the GPU PC samples...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "PC_SAMPLING" };
+            pc_sampling::post_process();
+        });
+    }
+
+    if(config::get_snapshot().roctracer_hip_api_backtrace)
+    {
+        _post_process.add("hip_api_stacks", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the HIP API call-stacks...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "HIP_API_STACKS" };
+            hip_api_stacks::post_process();
+        });
+    }
+
+    if(config::get_memcpy_analysis())
+    {
+        _post_process.add("memcpy_analysis", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the HIP memory copies...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "MEMCPY_ANALYSIS" };
+            memcpy_analysis::post_process();
+        });
+    }
+
+    // inline since the summary is inserted into the timemory storage of this thread
+    if(config::get_critical_path())
+    {
+        _post_process.add(
+            "critical_path",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the critical path...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "CRITICAL_PATH" };
+                critical_path::post_process();
+            },
+            {}, true);
+    }
+
+    if(get_use_ompt() && config::get_ompt_aggregate())
+    {
+        _post_process.add("ompt_summary", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the OpenMP region summary...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "OMPT_SUMMARY" };
+            ompt_aggregate::post_process();
+        });
+    }
+
+    if(get_use_ompt() && config::get_ompt_barrier_analysis())
+    {
+        _post_process.add("ompt_barrier", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the OpenMP barrier waits...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "OMPT_BARRIER" };
+            ompt_barrier::post_process();
+        });
+    }
+
+    if(get_use_ompt() && config::get_ompt_device_tracing())
+    {
+        _post_process.add("ompt_device", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the OpenMP device tracing...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "OMPT_DEVICE" };
+            ompt_device::post_process();
+        });
+    }
+
+    if(!config::get_perf_events().empty())
+    {
+        _post_process.add("perf_counters", []() {
+            OMNITRACE_VERBOSE_F(1, "Post-processing the perf counters...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "PERF_COUNTERS" };
+            perf_counters::post_process();
+        });
+    }
+
+    // inline since the cross-rank reduction uses MPI on this thread
+    if(get_use_comm_histogram())
+    {
+        _post_process.add(
+            "comm_histogram",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the comm histograms...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "COMM_HISTOGRAM" };
+                comm_histogram::post_process();
+            },
+            {}, true);
+    }
+
+    // inline since the cross-rank reduction uses MPI on this thread
+    if(config::get_rcclp_device_timing())
+    {
+        _post_process.add(
+            "rccl_timing",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the RCCL device timing...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "RCCL_TIMING" };
+                rccl_timing::post_process();
+            },
+            {}, true);
+    }
+
+    // inline since the node-level reduction uses MPI on this thread
+    if(get_use_process_sampling() && config::get_gpu_attribution())
+    {
+        _post_process.add(
+            "gpu_attribution",
+            []() {
+                OMNITRACE_VERBOSE_F(1, "Post-processing the GPU attribution...\n");
+                auto _phase = phase_timer{ get_finalize_phases(), "GPU_ATTRIBUTION" };
+                gpu_attribution::post_process();
+            },
+            {}, true);
+    }
+
+    _post_process.execute(get_parallel_finalize());
+
+    // the thread data is merged once the pending tasks have inserted into it
+    if(get_use_timemory())
+    {
+        tasking::join();
+        auto _phase = phase_timer{ get_finalize_phases(), "PROFILE_MERGE" };
+        profile_merge::post_process();
     }
 
     // shutdown tasking before timemory is finalized, especially the roctracer thread-pool
     OMNITRACE_VERBOSE_F(1, "Shutting down thread-pools...\n");
-    tasking::shutdown();
-
-    if(get_use_code_coverage())
     {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the code coverage...\n");
-        coverage::post_process();
+        auto _phase = phase_timer{ get_finalize_phases(), "THREAD_POOL" };
+        tasking::shutdown();
     }
 
     tracing::copy_timemory_hash_ids();
@@ -932,6 +1416,15 @@ omnitrace_finalize_hidden(void)
     bool _perfetto_output_error = false;
     if(get_use_perfetto())
     {
+        auto _phase = phase_timer{ get_finalize_phases(), "PERFETTO" };
+
+        // the second clock offset estimate provides the drift between the clocks
+        if(clock_sync::available())
+        {
+            OMNITRACE_VERBOSE_F(1, "Estimating the clock drift of the ranks...\n");
+            clock_sync::sample(config::get_perfetto_clock_sync_rounds());
+        }
+
         OMNITRACE_VERBOSE_F(0, "Finalizing perfetto...\n");
         omnitrace::perfetto::post_process(_timemory_manager.get(),
                                           _perfetto_output_error);
@@ -952,18 +1445,68 @@ omnitrace_finalize_hidden(void)
                tim::cereal::make_nvp("memory_maps", _maps));
         });
 
+        // before the aggregate, which resets the storage
+        if(get_columnar_output())
+        {
+            OMNITRACE_VERBOSE_F(1, "Writing the columnar output...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "COLUMNAR_OUTPUT" };
+            columnar_output::post_process();
+        }
+
+        if(get_profile_aggregate())
+        {
+            OMNITRACE_VERBOSE_F(1, "Aggregating the timemory profiles...\n");
+            auto _phase = phase_timer{ get_finalize_phases(), "PROFILE_AGGREGATE" };
+            profile_aggregate::post_process();
+        }
+
         OMNITRACE_VERBOSE_F(1, "Finalizing timemory...\n");
-        tim::timemory_finalize(_timemory_manager.get());
+        {
+            // the JSON files written by timemory are compressed after they are closed
+            auto _prefix = settings::get_global_output_prefix();
+            auto _files  = compression::get_files(_prefix, ".json");
+            auto _phase  = phase_timer{ get_finalize_phases(), "TIMEMORY" };
+            tim::timemory_finalize(_timemory_manager.get());
+            compression::compress_updated_files(
+                _files, _prefix, ".json",
+                (config::get_use_pid())
+                    ? JOIN('-', "", settings::default_process_suffix())
+                    : std::string{});
+        }
+
+        // report before the metadata is written so that the phases are included
+        report_phases("Finalize", "FINALIZE", get_finalize_phases());
 
-        auto _cfg       = settings::compose_filename_config{};
-        _cfg.use_suffix = config::get_use_pid();
-        _cfg.suffix     = settings::default_process_suffix();
-        _timemory_manager->write_metadata(settings::get_global_output_prefix(),
-                                          "omnitrace", _cfg);
+        // the ranks excluded by OMNITRACE_MPI_RANKS do not write the metadata
+        if(rank_selection::is_selected())
+        {
+            auto _cfg       = settings::compose_filename_config{};
+            _cfg.use_suffix = config::get_use_pid();
+            _cfg.suffix     = settings::default_process_suffix();
+            _timemory_manager->write_metadata(settings::get_global_output_prefix(),
+                                              "omnitrace", _cfg);
+        }
+    }
+    else
+    {
+        report_phases("Finalize", "FINALIZE", get_finalize_phases());
     }
 
     categories::shutdown();
 
+    // the output files have to be complete before they are moved
+    compression::wait();
+
+    // without the drain process of omnitrace-run, the staged files are moved here
+    if(!staging::get_root().empty() &&
+       get_env<std::string>(std::string{ staging::drain_env }, "", false).empty())
+    {
+        OMNITRACE_VERBOSE_F(1, "Moving the staged output files from '%s'...\n",
+                            staging::get_root().c_str());
+        auto _n = staging::drain(staging::get_root(), get_verbose());
+        OMNITRACE_VERBOSE_F(1, "Moved %zu staged output files\n", _n);
+    }
+
     _finalization.stop();
 
     if(_perfetto_output_error)
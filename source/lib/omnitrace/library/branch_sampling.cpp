@@ -0,0 +1,643 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/branch_sampling.hpp"
+#include "binary/analysis.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perf.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/coverage.hpp"
+#include "library/housekeeping.hpp"
+#include "library/perf.hpp"
+#include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/unwind/processed_entry.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace branch_sampling
+{
+namespace
+{
+using perf_event_t = perf::perf_event;
+
+// number of consecutive blocks of a trace
+constexpr size_t trace_length = 4;
+
+// the straight-line ranges longer than this are the result of an inconsistent branch
+// stack, e.g. the branches of an interrupt
+constexpr uintptr_t max_range_size = 4096;
+
+// the ring buffers only need to hold the samples within one collection interval
+constexpr auto collect_interval = std::chrono::milliseconds{ 20 };
+
+using range_t = std::pair<uintptr_t, uintptr_t>;  // first and last address
+using edge_t  = std::pair<uintptr_t, uintptr_t>;  // source and target
+using trace_t = std::array<uintptr_t, trace_length>;
+
+struct edge_entry
+{
+    uint64_t samples    = 0;
+    uint64_t mispredict = 0;
+};
+
+struct thread_state
+{
+    int64_t      tid   = 0;
+    uint64_t     lost  = 0;
+    perf_event_t event = {};
+};
+
+struct profile_data
+{
+    uint64_t                     samples = 0;
+    std::map<range_t, uint64_t>  ranges  = {};
+    std::map<edge_t, edge_entry> edges   = {};
+    std::map<trace_t, uint64_t>  traces  = {};
+};
+
+// a block is a range of addresses which was always executed as a whole in the sampled
+// ranges. The end is the address of the branch which terminates it (or the address
+// before the next block)
+struct block_entry
+{
+    uintptr_t begin   = 0;
+    uintptr_t end     = 0;
+    uint64_t  samples = 0;
+};
+
+struct function_entry
+{
+    uint64_t samples = 0;  // sum of the samples of the blocks
+    uint64_t blocks  = 0;
+};
+
+template <typename Tp>
+using entry_list_t = std::vector<std::pair<std::string, Tp>>;
+
+struct summary
+{
+    uint64_t                     samples   = 0;
+    uint64_t                     lost      = 0;
+    entry_list_t<block_entry>    blocks    = {};
+    entry_list_t<edge_entry>     edges     = {};
+    entry_list_t<uint64_t>       traces    = {};
+    entry_list_t<function_entry> functions = {};
+};
+
+std::once_flag post_process_once{};
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+auto&
+get_threads()
+{
+    static auto _v = std::map<int64_t, std::unique_ptr<thread_state>>{};
+    return _v;
+}
+
+auto&
+get_profile()
+{
+    static auto _v = profile_data{};
+    return _v;
+}
+
+bool
+is_user_address(uintptr_t _v)
+{
+    return (_v != 0 && static_cast<intptr_t>(_v) > 0);
+}
+
+// requires the mutex to be held. The entries are ordered from the most recent branch
+void
+process(const perf_branch_entry* _entries, size_t _n)
+{
+    auto& _profile = get_profile();
+    _profile.samples += 1;
+
+    for(size_t i = 0; i < _n; ++i)
+    {
+        const auto& _entry = _entries[i];
+        if(!is_user_address(_entry.from) || !is_user_address(_entry.to)) continue;
+        auto& _edge = _profile.edges[edge_t{ _entry.from, _entry.to }];
+        _edge.samples += 1;
+        if(_entry.mispred != 0) _edge.mispredict += 1;
+    }
+
+    // walk from the oldest branch: the instructions from the target of a branch to the
+    // source of the next one executed without a taken branch
+    auto _trace = std::vector<uintptr_t>{};
+    for(size_t i = _n; i > 1; --i)
+    {
+        auto _beg = _entries[i - 1].to;
+        auto _end = _entries[i - 2].from;
+        if(!is_user_address(_beg) || !is_user_address(_end) || _end < _beg ||
+           _end - _beg > max_range_size)
+        {
+            _trace.clear();
+            continue;
+        }
+
+        _profile.ranges[range_t{ _beg, _end }] += 1;
+
+        _trace.emplace_back(_beg);
+        if(_trace.size() >= trace_length)
+        {
+            auto _key = trace_t{};
+            std::copy(_trace.end() - trace_length, _trace.end(), _key.begin());
+            _profile.traces[_key] += 1;
+        }
+    }
+}
+
+// requires the mutex to be held
+void
+drain(thread_state& _state)
+{
+    if(!_state.event.is_open()) return;
+
+    for(auto itr : _state.event)
+    {
+        if(itr.is_lost())
+        {
+            ++_state.lost;
+            continue;
+        }
+        if(!itr.is_sample()) continue;
+
+        auto _stack = itr.get_branch_stack();
+        if(_stack.size() > 0) process(_stack.data(), _stack.size());
+    }
+}
+
+// requires the mutex to be held
+void
+collect()
+{
+    for(auto& itr : get_threads())
+        drain(*itr.second);
+}
+
+void
+start_collector()
+{
+    if(get_thread()) return;
+
+    auto _func = []() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.branch");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        while(get_active().load())
+        {
+            std::unique_lock<std::mutex> _lk{ get_mutex() };
+            get_cv().wait_for(_lk, collect_interval);
+            collect();
+        }
+    };
+
+    get_active().store(true);
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_thread() = std::make_unique<std::thread>(_func);
+}
+
+std::string
+as_hex_string(uintptr_t _v)
+{
+    auto _ss = std::stringstream{};
+    _ss << "0x" << std::hex << _v;
+    return _ss.str();
+}
+
+std::string
+get_address_label(uintptr_t _addr)
+{
+    if(auto _val = binary::lookup_ipaddr_entry<true>(_addr); _val)
+    {
+        auto _func = (_val->name.empty()) ? "??" : tim::demangle(_val->name);
+        if(_val->location.empty())
+            return JOIN("", _func, " [", as_hex_string(_addr), "]");
+        auto _line = (_val->lineno == 0) ? "?" : JOIN("", _val->lineno);
+        return JOIN("", _func, " @ ", _val->location, ":", _line, " [",
+                    as_hex_string(_addr), "]");
+    }
+    return as_hex_string(_addr);
+}
+
+std::string
+get_function_label(uintptr_t _addr)
+{
+    if(auto _val = binary::lookup_ipaddr_entry<true>(_addr); _val && !_val->name.empty())
+        return tim::demangle(_val->name);
+    return as_hex_string(_addr);
+}
+
+// splits the sampled ranges at the first and one past the last address of every range
+// and counts the samples of each piece with a sweep over these boundaries
+std::vector<block_entry>
+get_blocks(const std::map<range_t, uint64_t>& _ranges)
+{
+    auto _delta = std::map<uintptr_t, int64_t>{};
+    for(const auto& itr : _ranges)
+    {
+        _delta[itr.first.first] += itr.second;
+        _delta[itr.first.second + 1] -= itr.second;
+    }
+
+    auto    _blocks  = std::vector<block_entry>{};
+    int64_t _running = 0;
+    for(auto itr = _delta.begin(); itr != _delta.end(); ++itr)
+    {
+        _running += itr->second;
+        auto _next = std::next(itr);
+        if(_running <= 0 || _next == _delta.end()) continue;
+        _blocks.emplace_back(block_entry{ itr->first, _next->first - 1,
+                                          static_cast<uint64_t>(_running) });
+    }
+    return _blocks;
+}
+
+// requires the mutex to be held
+summary
+get_summary()
+{
+    const auto& _profile = get_profile();
+
+    auto _summary    = summary{};
+    _summary.samples = _profile.samples;
+    for(const auto& itr : get_threads())
+        _summary.lost += itr.second->lost;
+
+    auto _sort = [](auto& _v, auto&& _get) {
+        std::stable_sort(_v.begin(), _v.end(),
+                         [&_get](const auto& _lhs, const auto& _rhs) {
+                             return _get(_lhs.second) > _get(_rhs.second);
+                         });
+    };
+
+    auto _functions = std::map<std::string, function_entry>{};
+    for(const auto& itr : get_blocks(_profile.ranges))
+    {
+        auto  _name = get_function_label(itr.begin);
+        auto& _func = _functions[_name];
+        _func.samples += itr.samples;
+        _func.blocks += 1;
+        _summary.blocks.emplace_back(get_address_label(itr.begin), itr);
+    }
+    _summary.functions = { _functions.begin(), _functions.end() };
+
+    for(const auto& itr : _profile.edges)
+    {
+        _summary.edges.emplace_back(JOIN("", get_address_label(itr.first.first), " -> ",
+                                         get_address_label(itr.first.second)),
+                                    itr.second);
+    }
+
+    for(const auto& itr : _profile.traces)
+    {
+        auto _ss = std::stringstream{};
+        for(size_t i = 0; i < itr.first.size(); ++i)
+            _ss << ((i == 0) ? "" : " -> ") << get_address_label(itr.first.at(i));
+        _summary.traces.emplace_back(_ss.str(), itr.second);
+    }
+
+    _sort(_summary.blocks, [](const block_entry& _v) { return _v.samples; });
+    _sort(_summary.edges, [](const edge_entry& _v) { return _v.samples; });
+    _sort(_summary.traces, [](uint64_t _v) { return _v; });
+    _sort(_summary.functions, [](const function_entry& _v) { return _v.samples; });
+
+    return _summary;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("sampling-branches", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening branch sampling output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "sampling-branches" });
+
+    ofs << "samples: " << _data.samples << ", blocks: " << _data.blocks.size()
+        << ", branches: " << _data.edges.size() << ", lost records: " << _data.lost
+        << "\n";
+
+    ofs << "\n"
+        << std::setw(12) << "samples" << " | " << std::setw(8) << "size" << " | "
+        << "block\n";
+    for(const auto& itr : _data.blocks)
+    {
+        ofs << std::setw(12) << itr.second.samples << " | " << std::setw(8)
+            << (itr.second.end - itr.second.begin + 1) << " | " << itr.first << "\n";
+    }
+
+    ofs << "\n"
+        << std::setw(12) << "samples" << " | " << std::setw(12) << "mispredicted"
+        << " | " << "branch\n";
+    for(const auto& itr : _data.edges)
+    {
+        ofs << std::setw(12) << itr.second.samples << " | " << std::setw(12)
+            << itr.second.mispredict << " | " << itr.first << "\n";
+    }
+
+    ofs << "\n" << std::setw(12) << "samples" << " | " << "trace\n";
+    for(const auto& itr : _data.traces)
+        ofs << std::setw(12) << itr.second << " | " << itr.first << "\n";
+
+    ofs << "\n"
+        << std::setw(12) << "samples" << " | " << std::setw(8) << "blocks" << " | "
+        << "function\n";
+    for(const auto& itr : _data.functions)
+    {
+        ofs << std::setw(12) << itr.second.samples << " | " << std::setw(8)
+            << itr.second.blocks << " | " << itr.first << "\n";
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("branch_sampling");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("samples", _data.samples),
+              cereal::make_nvp("lost_records", _data.lost));
+
+        auto _save_list = [&ar](const char* _name, const char* _key,
+                                const auto& _entries, auto&& _save) {
+            ar->setNextName(_name);
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : _entries)
+            {
+                ar->startNode();
+                (*ar)(cereal::make_nvp(_key, itr.first));
+                _save(itr.second);
+                ar->finishNode();
+            }
+            ar->finishNode();
+        };
+
+        _save_list("blocks", "block", _data.blocks, [&ar](const block_entry& _v) {
+            (*ar)(cereal::make_nvp("begin", _v.begin), cereal::make_nvp("end", _v.end),
+                  cereal::make_nvp("samples", _v.samples));
+        });
+        _save_list("branches", "branch", _data.edges, [&ar](const edge_entry& _v) {
+            (*ar)(cereal::make_nvp("samples", _v.samples),
+                  cereal::make_nvp("mispredicted", _v.mispredict));
+        });
+        _save_list("traces", "trace", _data.traces,
+                   [&ar](uint64_t _v) { (*ar)(cereal::make_nvp("samples", _v)); });
+        _save_list("functions", "function", _data.functions,
+                   [&ar](const function_entry& _v) {
+                       (*ar)(cereal::make_nvp("samples", _v.samples),
+                             cereal::make_nvp("blocks", _v.blocks));
+                   });
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("sampling-branches", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening branch sampling output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "sampling-branches" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+bool
+configure(bool _setup, int64_t _tid)
+{
+    if(!config::get_sampling_branch_stack()) return false;
+
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    auto                         itr = get_threads().find(_tid);
+
+    if(!_setup)
+    {
+        if(itr != get_threads().end() && itr->second->event.is_open())
+        {
+            itr->second->event.stop();
+            drain(*itr->second);
+            itr->second->event.close();
+        }
+        return false;
+    }
+
+    if(itr != get_threads().end() && itr->second->event.is_open()) return true;
+
+    const auto& _info = thread_info::get(_tid, SequentTID);
+    if(!_info) return false;
+
+    struct perf_event_attr _pe;
+    memset(&_pe, 0, sizeof(_pe));
+
+    auto _event = config::get_sampling_branch_event();
+    try
+    {
+        if(perf::is_pmu_event(_event))
+            perf::config_pmu_event(_pe, _event);
+        else
+            perf::config_event(_pe, _event);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "branch sampling event '%s' is not supported: %s\n",
+                            _event.c_str(), _e.what());
+        return false;
+    }
+
+    _pe.sample_type        = PERF_SAMPLE_IP | PERF_SAMPLE_BRANCH_STACK;
+    _pe.branch_sample_type = PERF_SAMPLE_BRANCH_USER | PERF_SAMPLE_BRANCH_ANY;
+    _pe.sample_period      = config::get_sampling_branch_period();
+    _pe.exclude_kernel     = 1;
+    _pe.exclude_hv         = 1;
+    _pe.disabled           = 1;
+    _pe.inherit            = 0;
+
+    auto _state = std::make_unique<thread_state>();
+    _state->tid = _tid;
+    _state->event.set_num_pages(config::get_sampling_perf_buffer_pages());
+
+    // the branch stack is only available when the CPU records the branches, e.g. not
+    // within most virtual machines
+    if(auto _err = _state->event.open(_pe, _info->index_data->system_value); _err)
+    {
+        OMNITRACE_WARNING_F(
+            0, "branch sampling perf_event failed to open on thread %li: %s\n", _tid,
+            _err->c_str());
+        return false;
+    }
+
+    OMNITRACE_VERBOSE(2, "[branch_sampling] Sampling the branches of thread %li...\n",
+                      _tid);
+
+    start_collector();
+
+    _state->event.start();
+    if(itr != get_threads().end())
+    {
+        _state->lost = itr->second->lost;
+        itr->second  = std::move(_state);
+    }
+    else
+        get_threads().emplace(_tid, std::move(_state));
+
+    return true;
+}
+
+void
+stop()
+{
+    if(get_thread())
+    {
+        get_active().store(false);
+        get_cv().notify_all();
+        get_thread()->join();
+        get_thread().reset();
+    }
+
+    // collect whatever remains in the ring buffers of the threads still running
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    for(auto& itr : get_threads())
+    {
+        if(!itr.second->event.is_open()) continue;
+        itr.second->event.stop();
+        drain(*itr.second);
+        itr.second->event.close();
+    }
+}
+
+void
+post_process()
+{
+    if(!config::get_sampling_branch_stack()) return;
+
+    std::call_once(post_process_once, []() {
+        stop();
+
+        std::unique_lock<std::mutex> _lk{ get_mutex() };
+        if(get_threads().empty()) return;
+
+        if(config::get_sampling_coverage())
+        {
+            for(const auto& itr : get_profile().ranges)
+                coverage::record_range(itr.first.first, itr.first.second, itr.second);
+        }
+
+        try
+        {
+            auto _data = get_summary();
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the branch sampling profile failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace branch_sampling
+}  // namespace omnitrace
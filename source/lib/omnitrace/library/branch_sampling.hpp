@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// branch stack sampling of the sampled threads (see OMNITRACE_SAMPLING_BRANCH_STACK).
+/// A perf_event which records the last taken branches of the thread (LBR on Intel,
+/// BRS or LbrExtV2 on AMD) is opened on each thread and a background thread drains the
+/// ring buffers. Between two consecutive taken branches of a sample, the instructions
+/// from the target of the older branch to the source of the newer branch executed
+/// without any taken branch, so every sample yields a few straight-line address
+/// ranges. At finalization, the ranges are split at every branch source and target
+/// which was sampled, which approximates the basic blocks, and the number of times
+/// each block, each branch and each short sequence of blocks (trace) was sampled is
+/// written to sampling-branches.{txt,json}
+namespace branch_sampling
+{
+/// opens (or closes and drains) the perf_event of the thread. Returns false if the
+/// branch stack sampling is not enabled or the perf_event could not be opened
+bool
+configure(bool _setup, int64_t _tid);
+
+/// stops the background thread and closes the perf_events of every thread
+void
+stop();
+
+/// stops the collection and writes the profile. Only the first invocation has an
+/// effect
+void
+post_process();
+}  // namespace branch_sampling
+}  // namespace omnitrace
@@ -24,6 +24,7 @@
 #include "core/concepts.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
+#include "core/self_profile.hpp"
 #include "core/state.hpp"
 #include "core/utility.hpp"
 #include "library/causal/data.hpp"
@@ -96,6 +97,7 @@ void
 overflow::sample(int _sig)
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(causal);
 
     static thread_local const auto& _tinfo      = thread_info::get();
     auto                            _tid        = _tinfo->index_data->sequent_value;
@@ -165,6 +167,7 @@ backtrace::sample(int _sig)
     ++_protect_flag;
     // on RedHat, the unw_step within get_unw_signal_frame_stack_raw involves a mutex lock
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(causal);
     m_index = causal::experiment::get_index();
     m_stack = get_unw_signal_frame_stack_raw<depth, ignore_depth>();
 
@@ -24,6 +24,7 @@
 #include "core/common.hpp"
 #include "core/concepts.hpp"
 #include "core/debug.hpp"
+#include "core/hash_cache.hpp"
 #include "core/timemory.hpp"
 #include "library/causal/experiment.hpp"
 #include "library/thread_data.hpp"
@@ -32,6 +33,12 @@
 #include <timemory/mpl/type_traits.hpp>
 #include <timemory/units.hpp>
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
 namespace omnitrace
 {
 namespace causal
@@ -62,6 +69,51 @@ get_progress_allocator(int64_t _tid)
 {
     return thread_data<progress_allocator_t>::instance(construct_on_thread{ _tid });
 }
+
+constexpr size_t max_registered_points = 256;
+
+// the counters of the registered throughput progress points. Each thread owns one
+// block aligned to a cache line so the threads never write to the same cache line
+struct alignas(64) registered_counters
+{
+    std::array<std::atomic<int64_t>, max_registered_points> values = {};
+};
+
+using reported_values_t = std::array<int64_t, max_registered_points>;
+
+struct registry
+{
+    std::mutex                                      mutex    = {};
+    std::vector<tim::hash_value_t>                  hashes   = {};
+    std::unordered_map<tim::hash_value_t, uint64_t> handles  = {};
+    std::vector<registered_counters*>               counters = {};
+    // the values of the counters of each thread at the previous get_progress_points()
+    std::vector<reported_values_t> reported = {};
+};
+
+auto&
+get_registry()
+{
+    // the counters are leaked, a progress point may be marked during the finalization
+    static auto* _v = new registry{};
+    return *_v;
+}
+
+registered_counters*
+get_registered_counters()
+{
+    static thread_local registered_counters* _v
+        OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) = nullptr;
+    if(OMNITRACE_UNLIKELY(!_v))
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        _v         = new registered_counters{};
+        _reg.counters.emplace_back(_v);
+        _reg.reported.emplace_back(reported_values_t{});
+    }
+    return _v;
+}
 }  // namespace
 
 std::unordered_map<tim::hash_value_t, progress_point>
@@ -82,9 +134,62 @@ progress_point::get_progress_points()
             }
         }
     }
+
+    auto& _reg = get_registry();
+    auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+    for(size_t i = 0; i < _reg.counters.size(); ++i)
+    {
+        const auto& _values = _reg.counters.at(i)->values;
+        auto&       _prev   = _reg.reported.at(i);
+        for(size_t j = 0; j < _reg.hashes.size(); ++j)
+        {
+            auto _curr  = _values.at(j).load(std::memory_order_relaxed);
+            auto _delta = _curr - _prev.at(j);
+            _prev.at(j) = _curr;
+            if(_delta == 0) continue;
+
+            auto& ditr = _data[_reg.hashes.at(j)];
+            ditr.set_hash(_reg.hashes.at(j));
+            ditr.m_delta += _delta;
+        }
+    }
     return _data;
 }
 
+uint64_t
+progress_point::register_throughput_point(std::string_view _name)
+{
+    auto  _hash = hash_cache::add_hash_id(_name);
+    auto& _reg  = get_registry();
+    auto  _lk   = std::unique_lock<std::mutex>{ _reg.mutex };
+
+    auto itr = _reg.handles.find(_hash);
+    if(itr != _reg.handles.end()) return itr->second;
+
+    // the failure is remembered so it is only reported once
+    if(_reg.hashes.size() >= max_registered_points)
+    {
+        OMNITRACE_WARNING_F(0,
+                            "the maximum number of registered progress points (%zu) was "
+                            "reached. '%s' is marked by name instead\n",
+                            max_registered_points, std::string{ _name }.c_str());
+        _reg.handles.emplace(_hash, 0);
+        return 0;
+    }
+
+    _reg.hashes.emplace_back(_hash);
+    return (_reg.handles[_hash] = _reg.hashes.size());
+}
+
+void
+progress_point::mark_throughput_point(uint64_t _handle)
+{
+    if(OMNITRACE_UNLIKELY(_handle == 0 || _handle > max_registered_points)) return;
+
+    auto& _v = get_registered_counters()->values[_handle - 1];
+    _v.store(_v.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
 std::string
 progress_point::label()
 {
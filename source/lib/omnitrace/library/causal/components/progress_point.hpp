@@ -34,6 +34,7 @@
 #include <timemory/utility/types.hpp>
 
 #include <cstdint>
+#include <string_view>
 #include <unordered_map>
 
 namespace omnitrace
@@ -99,8 +100,20 @@ struct progress_point : comp::base<progress_point, void>
         ar(cereal::make_nvp("departure", m_departure));
     }
 
+    /// sums the progress since the previous call: the string-based progress points of
+    /// every thread and the counters of the registered progress points
     static std::unordered_map<tim::hash_value_t, progress_point> get_progress_points();
 
+    /// registers a throughput progress point and returns its handle (zero if the
+    /// maximum number of registered progress points is reached). Registering the same
+    /// name twice returns the same handle
+    static uint64_t register_throughput_point(std::string_view);
+
+    /// increments the counter of the calling thread for a registered throughput
+    /// progress point. Only the calling thread writes to its counters so this is a
+    /// single increment without any lock, hash or allocation
+    static void mark_throughput_point(uint64_t _handle);
+
 private:
     hash_type       m_hash      = 0;
     int64_t         m_delta     = 0;
@@ -23,6 +23,7 @@
 #include "library/causal/data.hpp"
 #include "binary/address_multirange.hpp"
 #include "binary/analysis.hpp"
+#include "binary/analysis_cache.hpp"
 #include "binary/binary_info.hpp"
 #include "binary/link_map.hpp"
 #include "binary/scope_filter.hpp"
@@ -30,6 +31,7 @@
 #include "core/config.hpp"
 #include "core/containers/c_array.hpp"
 #include "core/debug.hpp"
+#include "core/hash_cache.hpp"
 #include "core/state.hpp"
 #include "core/utility.hpp"
 #include "library/causal/delay.hpp"
@@ -38,6 +40,8 @@
 #include "library/causal/sample_data.hpp"
 #include "library/causal/sampling.hpp"
 #include "library/causal/selected_entry.hpp"
+#include "library/causal/selection_policy.hpp"
+#include "library/housekeeping.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_data.hpp"
@@ -60,10 +64,13 @@
 #include <cstdint>
 #include <cstdlib>
 #include <initializer_list>
+#include <mutex>
+#include <numeric>
 #include <random>
 #include <regex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -109,6 +116,11 @@ get_engine()
         auto _seed_v = config::get_setting_value<uint64_t>("OMNITRACE_CAUSAL_RANDOM_SEED")
                            .value_or(0);
         if(_seed_v == 0) _seed_v = std::random_device{}();
+        // when the experiments are distributed, the workers must not make the same
+        // (pseudo-random) selections from a common seed
+        if(config::get_causal_num_workers() > 1)
+            return tim::get_hash_id(
+                _seed_v, static_cast<int64_t>(config::get_causal_worker_id()));
         return _seed_v;
     }();
 
@@ -255,7 +267,113 @@ get_filters(const std::set<binary::scope_filter::filter_scope>& _scopes = {
     return _filters;
 }
 
-using binary_info_t = std::vector<binary::binary_info>;
+// sorted interval index over the address ranges of the symbols in a binary_info. The
+// entries are sorted by the lower bound of the range and the running maximum of the
+// upper bounds terminates the backward scan for the ranges which contain an address
+struct symbol_index
+{
+    struct entry
+    {
+        uintptr_t low   = 0;
+        uintptr_t high  = 0;
+        size_t    index = 0;
+    };
+
+    symbol_index() = default;
+    explicit symbol_index(const binary::binary_info&);
+
+    // returns the symbols whose address range contains the address in the same order
+    // as they appear in binary_info::symbols
+    std::vector<const binary::symbol*> find(uintptr_t) const;
+
+private:
+    const binary::binary_info* m_info     = nullptr;
+    std::vector<entry>         m_entries  = {};
+    std::vector<uintptr_t>     m_max_high = {};
+};
+
+symbol_index::symbol_index(const binary::binary_info& _info)
+: m_info{ &_info }
+{
+    m_entries.reserve(_info.symbols.size());
+    for(size_t i = 0; i < _info.symbols.size(); ++i)
+    {
+        auto _ipaddr = _info.symbols.at(i).ipaddr();
+        if(!_ipaddr.is_valid()) continue;
+        // a single address is stored as a range of one
+        auto _high = (_ipaddr.is_range()) ? _ipaddr.high : _ipaddr.low + 1;
+        m_entries.emplace_back(entry{ _ipaddr.low, _high, i });
+    }
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const auto& _lhs, const auto& _rhs) {
+        return (_lhs.low == _rhs.low) ? (_lhs.index < _rhs.index) : (_lhs.low < _rhs.low);
+    });
+
+    m_max_high.reserve(m_entries.size());
+    uintptr_t _max_high = 0;
+    for(const auto& itr : m_entries)
+    {
+        _max_high = std::max(_max_high, itr.high);
+        m_max_high.emplace_back(_max_high);
+    }
+}
+
+std::vector<const binary::symbol*>
+symbol_index::find(uintptr_t _addr) const
+{
+    auto _indexes = std::vector<size_t>{};
+    if(!m_info) return std::vector<const binary::symbol*>{};
+
+    // first entry with a lower bound greater than the address
+    auto _end = std::upper_bound(
+        m_entries.begin(), m_entries.end(), _addr,
+        [](uintptr_t _lhs, const auto& _rhs) { return _lhs < _rhs.low; });
+
+    for(auto i = std::distance(m_entries.begin(), _end); i > 0; --i)
+    {
+        // none of the preceding ranges extend past the address
+        if(m_max_high.at(i - 1) <= _addr) break;
+        const auto& _entry = m_entries.at(i - 1);
+        if(_entry.high > _addr) _indexes.emplace_back(_entry.index);
+    }
+
+    std::sort(_indexes.begin(), _indexes.end());
+
+    auto _symbols = std::vector<const binary::symbol*>{};
+    _symbols.reserve(_indexes.size());
+    for(auto itr : _indexes)
+        _symbols.emplace_back(&m_info->symbols.at(itr));
+    return _symbols;
+}
+
+using binary_info_t  = std::vector<binary::binary_info>;
+using symbol_index_t = std::vector<symbol_index>;
+
+// indexes of the binary info in get_cached_binary_info()
+std::pair<symbol_index_t, symbol_index_t>&
+get_cached_symbol_index()
+{
+    static auto _v = std::pair<symbol_index_t, symbol_index_t>{};
+    return _v;
+}
+
+// the binaries are processed on the thread pool when it has more than one thread,
+// otherwise the default executor starts its own threads
+binary::executor_t
+get_binary_executor()
+{
+    if(config::get_binary_analysis_threads() > 1 && config::get_thread_pool_size() > 1)
+    {
+        return [](size_t _n, const std::function<void(size_t)>& _func) {
+            auto _graph = tasking::task_graph{};
+            for(size_t i = 0; i < _n; ++i)
+                _graph.add(JOIN('-', "binary-info", i), [&_func, i]() { _func(i); });
+            _graph.execute(true);
+        };
+    }
+    return binary::get_default_executor();
+}
+
 std::pair<binary_info_t, binary_info_t>&
 get_cached_binary_info()
 {
@@ -267,10 +385,22 @@ get_cached_binary_info()
         for(const auto& itr : _link_map)
             _files.emplace_back(itr.real());
 
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
         auto _discarded = std::vector<binary::binary_info>{};
-        auto _requested = binary::get_binary_info(_files, get_filters());
+        auto _requested = binary::get_binary_info(_files, get_filters(), true, true,
+                                                  false, get_binary_executor());
         return std::make_pair(_requested, _discarded);
     }();
+
+    static auto _once = []() {
+        auto& _index = get_cached_symbol_index().first;
+        _index.reserve(_v.first.size());
+        for(const auto& itr : _v.first)
+            _index.emplace_back(itr);
+        return true;
+    }();
+    (void) _once;
+
     return _v;
 }
 
@@ -282,50 +412,108 @@ satisfies_filter(const binary::scope_filter::filter_scope& _scope,
     return binary::scope_filter::satisfies_filter(_filters, _scope, _value);
 }
 
-auto
-compute_eligible_lines_impl()
+// applies the scope filters to the symbols and the line info of a binary
+binary::binary_info
+apply_scope_filters(const binary::binary_info&               _info,
+                    const std::vector<binary::scope_filter>& _filters)
 {
-    const auto& _binary_info = get_cached_binary_info().first;
-    auto&       _scoped_info = get_cached_binary_info().second;
-    auto        _filters     = get_filters();
+    auto _scoped     = binary::binary_info{};
+    _scoped.bfd      = _info.bfd;
+    _scoped.mappings = _info.mappings;
+    _scoped.sections = _info.sections;
 
-    for(const auto& litr : _binary_info)
+    for(const auto& ditr : _info.symbols)
     {
-        auto& _scoped    = _scoped_info.emplace_back();
-        _scoped.bfd      = litr.bfd;
-        _scoped.mappings = litr.mappings;
-        _scoped.sections = litr.sections;
+        auto _sym = ditr.clone();
 
-        for(const auto& ditr : litr.symbols)
-        {
-            auto _sym = ditr.clone();
-
-            _sym.inlines =
-                ditr.get_inline_symbols<std::vector<binary::inlined_symbol>>(_filters);
+        _sym.inlines =
+            ditr.get_inline_symbols<std::vector<binary::inlined_symbol>>(_filters);
 
-            _sym.dwarf_info =
-                ditr.get_debug_line_info<std::vector<binary::dwarf_entry>>(_filters);
+        _sym.dwarf_info =
+            ditr.get_debug_line_info<std::vector<binary::dwarf_entry>>(_filters);
 
-            if(ditr(_filters) || (_sym.inlines.size() + _sym.dwarf_info.size()) > 0)
-            {
-                _scoped.ranges.emplace_back(_sym.ipaddr());
-                _scoped.symbols.emplace_back(_sym);
-            }
+        if(ditr(_filters) || (_sym.inlines.size() + _sym.dwarf_info.size()) > 0)
+        {
+            _scoped.ranges.emplace_back(_sym.ipaddr());
+            _scoped.symbols.emplace_back(_sym);
         }
+    }
 
-        for(const auto& ditr : litr.debug_info)
+    for(const auto& ditr : _info.debug_info)
+    {
+        if(sf::satisfies_filter(_filters, sf::SOURCE_FILTER, ditr.file) ||
+           sf::satisfies_filter(_filters, sf::SOURCE_FILTER,
+                                join(':', ditr.file, ditr.line)))
         {
-            if(sf::satisfies_filter(_filters, sf::SOURCE_FILTER, ditr.file) ||
-               sf::satisfies_filter(_filters, sf::SOURCE_FILTER,
-                                    join(':', ditr.file, ditr.line)))
-            {
-                _scoped.debug_info.emplace_back(ditr);
-            }
+            _scoped.debug_info.emplace_back(ditr);
         }
+    }
 
-        _scoped.sort();
+    _scoped.sort();
+    return _scoped;
+}
+
+// reuses the eligible lines saved by a previous run with the same filters when
+// OMNITRACE_BINARY_CACHE is enabled. The cache entries are keyed by the build-id of
+// the binary and the hash of the filters. The load addresses are not saved so the
+// symbols are relocated with the mappings of this process
+binary::binary_info
+get_eligible_lines(const binary::binary_info&               _info,
+                   const std::vector<binary::scope_filter>& _filters)
+{
+    namespace analysis_cache = binary::analysis_cache;
+
+    auto _filename = _info.filename();
+    if(!config::get_binary_cache() || _filename.empty())
+        return apply_scope_filters(_info, _filters);
+
+    auto _flags   = analysis_cache::get_flags(true, true, false);
+    auto _variant = analysis_cache::get_variant(_filters);
+    auto _cached  = analysis_cache::load(_filename, _flags, _variant);
+    if(_cached)
+    {
+        auto _scoped = std::vector<binary::binary_info>{};
+        _scoped.emplace_back(std::move(*_cached));
+        _scoped.front().bfd      = _info.bfd;
+        _scoped.front().sections = _info.sections;
+        binary::update_mappings(_scoped, _info.mappings);
+
+        auto& _v = _scoped.front();
+        _v.ranges.clear();
+        for(const auto& itr : _v.symbols)
+            _v.ranges.emplace_back(itr.ipaddr());
+        utility::filter_sort_unique(_v.ranges);
+        return std::move(_v);
     }
 
+    auto _scoped = apply_scope_filters(_info, _filters);
+    analysis_cache::save(_filename, _flags, _scoped, _variant);
+    return _scoped;
+}
+
+auto
+compute_eligible_lines_impl()
+{
+    const auto& _binary_info = get_cached_binary_info().first;
+    auto&       _scoped_info = get_cached_binary_info().second;
+    auto        _filters     = get_filters();
+
+    // each binary has its own slot so the order does not depend on the executor
+    _scoped_info.clear();
+    _scoped_info.resize(_binary_info.size());
+    {
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        get_binary_executor()(_binary_info.size(), [&](size_t _idx) {
+            _scoped_info.at(_idx) = get_eligible_lines(_binary_info.at(_idx), _filters);
+        });
+    }
+
+    auto& _scoped_index = get_cached_symbol_index().second;
+    _scoped_index.clear();
+    _scoped_index.reserve(_scoped_info.size());
+    for(const auto& itr : _scoped_info)
+        _scoped_index.emplace_back(itr);
+
     auto& _eligible_ar = get_eligible_address_ranges();
     for(const auto& litr : _scoped_info)
     {
@@ -340,6 +528,9 @@ compute_eligible_lines_impl()
         }
     }
 
+    // eligibility checks are performed in the hot paths of the causal sampling
+    _eligible_ar.freeze();
+
     OMNITRACE_VERBOSE(
         0, "[causal] eligible address ranges: %zu, coarse address range: %zu [%s]\n",
         _eligible_ar.size(), _eligible_ar.range_size(),
@@ -445,6 +636,9 @@ save_line_info_impl(std::ostream&                           _ofs,
 void
 compute_eligible_lines()
 {
+    // the kernels are selected without the line info of the host binaries
+    if(config::get_causal_mode() == CausalMode::Kernel) return;
+
     static auto _once = std::once_flag{};
     std::call_once(_once, []() {
         compute_eligible_lines_impl();
@@ -459,6 +653,98 @@ auto eligible_pc_history    = std::map<uintptr_t, size_t>{};
 auto eligible_pc_idx        = std::atomic<size_t>{ 0 };
 auto eligible_pc_candidates = std::atomic<size_t>{ 0 };
 
+// the GPU kernels observed by record_kernel(...): the selections of the kernel mode
+struct kernel_candidate
+{
+    std::string name     = {};
+    uint64_t    duration = 0;  // total device time [nsec]
+    uint64_t    count    = 0;
+};
+
+struct kernel_registry
+{
+    std::mutex                                              mutex   = {};
+    std::unordered_map<tim::hash_value_t, kernel_candidate> kernels = {};
+};
+
+auto&
+get_kernel_registry()
+{
+    // leaked, the kernel records may be delivered during the finalization
+    static auto* _v = new kernel_registry{};
+    return *_v;
+}
+
+selected_entry
+get_kernel_selection(tim::hash_value_t _hash, const kernel_candidate& _kernel)
+{
+    // the hash of the kernel name takes the place of the address and the symbol
+    // address so the selection is classified by the kernel name
+    auto _selection           = selected_entry{};
+    _selection.address        = _hash;
+    _selection.symbol_address = _hash;
+    _selection.symbol.address = binary::address_range{ _hash };
+    _selection.symbol.func    = _kernel.name;
+    return _selection;
+}
+
+// the kernels are chosen with a probability proportional to their device time, the
+// same weighting as the call-stack samples provide for the host code
+selected_entry
+sample_kernel_selection(size_t _nitr, size_t _wait_ns)
+{
+    auto& _reg        = get_kernel_registry();
+    auto  _candidates = std::vector<std::pair<tim::hash_value_t, kernel_candidate>>{};
+    while(_candidates.empty())
+    {
+        {
+            auto _lk = std::unique_lock<std::mutex>{ _reg.mutex };
+            for(const auto& itr : _reg.kernels)
+                if(itr.second.duration > 0) _candidates.emplace_back(itr);
+        }
+
+        if(!_candidates.empty()) break;
+        if(get_state() >= State::Finalized) return selected_entry{};
+        std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::nanoseconds{ _wait_ns });
+    }
+
+    for(size_t _n = 0; _n < _nitr; ++_n)
+    {
+        selection_policy::reset_fallback();
+        auto _remaining = _candidates;
+        while(!_remaining.empty())
+        {
+            uint64_t _total = 0;
+            for(const auto& itr : _remaining)
+                _total += itr.second.duration;
+
+            auto _dist  = std::uniform_int_distribution<uint64_t>{ 0, _total - 1 };
+            auto _value = _dist(get_engine<kernel_candidate>());
+            auto _idx   = size_t{ 0 };
+            for(; _idx + 1 < _remaining.size(); ++_idx)
+            {
+                if(_value < _remaining.at(_idx).second.duration) break;
+                _value -= _remaining.at(_idx).second.duration;
+            }
+
+            auto _selection = get_kernel_selection(_remaining.at(_idx).first,
+                                                   _remaining.at(_idx).second);
+            _remaining.erase(_remaining.begin() + _idx);
+
+            if(selection_policy::enabled() && !selection_policy::accept(_selection))
+                continue;
+            return _selection;
+        }
+
+        // every candidate has converged
+        auto _selection = selection_policy::get_fallback();
+        if(_selection) return _selection;
+    }
+
+    return selected_entry{};
+}
+
 void
 perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
 {
@@ -468,6 +754,7 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
 
     const auto& _thr_info = thread_info::init(true);
     set_thread_state(ThreadState::Disabled);
+    housekeeping::configure_thread();
     OMNITRACE_CONDITIONAL_THROW(!_thr_info->is_offset,
                                 "Error! causal profiling thread should be offset");
 
@@ -786,6 +1073,9 @@ sample_selection(size_t _nitr, size_t _wait_ns)
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
+    if(config::get_causal_mode() == CausalMode::Kernel)
+        return sample_kernel_selection(_nitr, _wait_ns);
+
     auto _select_address = [&](auto& _address_vec) {
         // this isn't necessary bc of check before calling this lambda but
         // kept because of size() - 1 in distribution range
@@ -847,7 +1137,10 @@ sample_selection(size_t _nitr, size_t _wait_ns)
             auto& _linfo_v = (config::get_causal_mode() == CausalMode::Function)
                                  ? linfo.front()
                                  : linfo.back();
-            return selected_entry{ _addr, _sym_addr, _linfo_v };
+            auto _selection = selected_entry{ _addr, _sym_addr, _linfo_v };
+            if(selection_policy::enabled() && !selection_policy::accept(_selection))
+                continue;
+            return _selection;
         }
         return selected_entry{};
     };
@@ -876,8 +1169,12 @@ sample_selection(size_t _nitr, size_t _wait_ns)
 
         if(!_addresses.empty())
         {
+            selection_policy::reset_fallback();
             auto _selection = _select_address(_addresses);
             if(_selection) return _selection;
+            // every candidate has converged
+            _selection = selection_policy::get_fallback();
+            if(_selection) return _selection;
         }
     }
 
@@ -890,11 +1187,13 @@ get_line_info(uintptr_t _addr, bool _include_discarded)
     static auto _glob_filters  = get_filters({ sf::BINARY_FILTER });
     static auto _scope_filters = get_filters();
     auto        _data          = std::deque<binary::symbol>{};
-    auto        _get_line_info = [&](const auto& _info, const auto& _filters) {
+    auto        _get_line_info = [&](const auto& _info, const auto& _index,
+                                 const auto& _filters) {
         // search for exact matches first
-        for(const binary::binary_info& litr : _info)
+        for(size_t i = 0; i < _info.size(); ++i)
         {
-            auto _local_data = std::deque<binary::symbol>{};
+            const binary::binary_info& litr       = _info.at(i);
+            auto                       _local_data = std::deque<binary::symbol>{};
 
             // make sure the address is in the coarse grained mapped regions
             // before performing an exhaustive search
@@ -907,16 +1206,24 @@ get_line_info(uintptr_t _addr, bool _include_discarded)
 
             if(!_is_mapped) return;
 
-            for(const auto& ditr : litr.symbols)
+            // the index is built after the binary info is finalized so fall back
+            // to an exhaustive search if it is not available yet
+            auto _symbols = std::vector<const binary::symbol*>{};
+            if(i < _index.size())
+                _symbols = _index.at(i).find(_addr);
+            else
             {
+                for(const auto& ditr : litr.symbols)
+                    _symbols.emplace_back(&ditr);
+            }
+
+            for(const auto* sitr : _symbols)
+            {
+                const auto& ditr = *sitr;
                 // skip if load address is greater than address
                 if(_addr < ditr.load_address) continue;
                 // compute the symbols ip address range
                 auto _ipaddr = ditr.ipaddr();
-                // if the lower bound of the ip address range is greater than the address,
-                // all following symbols are not worth searching since they are at higher
-                // addresses than this symbol (sorted by address)
-                // if(_ipaddr.low > _addr) break;
 
                 if(!_ipaddr.contains(_addr)) continue;
 
@@ -957,9 +1264,11 @@ get_line_info(uintptr_t _addr, bool _include_discarded)
     };
 
     if(_include_discarded)
-        _get_line_info(get_cached_binary_info().first, _glob_filters);
+        _get_line_info(get_cached_binary_info().first, get_cached_symbol_index().first,
+                       _glob_filters);
     else
-        _get_line_info(get_cached_binary_info().second, _scope_filters);
+        _get_line_info(get_cached_binary_info().second, get_cached_symbol_index().second,
+                       _scope_filters);
 
     return _data;
 }
@@ -971,7 +1280,7 @@ push_progress_point(std::string_view _name)
 
     ++num_progress_points;
 
-    auto  _hash = tim::add_hash_id(_name);
+    auto  _hash = hash_cache::add_hash_id(_name);
     auto& _data = get_progress_bundles();
     if(OMNITRACE_LIKELY(_data != nullptr))
     {
@@ -998,7 +1307,7 @@ pop_progress_point(std::string_view _name)
     }
     else
     {
-        auto _hash = tim::add_hash_id(_name);
+        auto _hash = hash_cache::add_hash_id(_name);
         for(auto itr = _data->rbegin(); itr != _data->rend(); ++itr)
         {
             if((*itr)->get_hash() == _hash)
@@ -1019,7 +1328,7 @@ mark_progress_point(std::string_view _name, bool _force)
 
     ++num_progress_points;
 
-    auto  _hash = tim::add_hash_id(_name);
+    auto  _hash = hash_cache::add_hash_id(_name);
     auto& _data = get_progress_bundles();
     if(OMNITRACE_LIKELY(_data != nullptr))
     {
@@ -1031,13 +1340,80 @@ mark_progress_point(std::string_view _name, bool _force)
     }
 }
 
+void
+record_kernel(std::string_view _name, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(_end_ns <= _beg_ns) return;
+
+    auto _hash     = tim::get_hash_id(_name);
+    auto _duration = _end_ns - _beg_ns;
+
+    if(experiment::is_selected_kernel(_hash))
+    {
+        // the device time which the virtual speedup removed from the kernel is added
+        // to the global delay so every host thread is delayed by it
+        experiment::add_selected();
+        delay::get_global() +=
+            static_cast<int64_t>(_duration * experiment::get_delay_scaling());
+    }
+
+    auto& _reg = get_kernel_registry();
+    auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+    auto& _v   = _reg.kernels[_hash];
+    if(_v.name.empty()) _v.name = std::string{ _name };
+    _v.duration += _duration;
+    _v.count += 1;
+}
+
+uint64_t
+register_progress_point(std::string_view _name)
+{
+    // registered right before the first mark so it also releases the experiments
+    ++num_progress_points;
+    return component::progress_point::register_throughput_point(_name);
+}
+
+void
+mark_registered_progress_point(uint64_t _handle)
+{
+    if(!config::get_snapshot().causal_progress_points) return;
+    component::progress_point::mark_throughput_point(_handle);
+}
+
 uint16_t
-sample_virtual_speedup()
+sample_virtual_speedup(const selected_entry& _selection)
 {
     if(speedup_dist.empty())
         return 0;
     else if(speedup_dist.size() == 1)
         return speedup_dist.front();
+    else if(selection_policy::enabled() && _selection)
+        return selection_policy::select_speedup(_selection, speedup_dist);
+    else if(config::get_causal_num_workers() > 1)
+    {
+        // the workers walk through a common sequence of random permutations of the
+        // speedup pool in an interleaved fashion: the Nth experiment of worker W uses
+        // entry (N * num_workers + W) of the sequence so every pass of the workers over
+        // the pool evaluates each virtual speedup exactly once
+        static auto _count = std::atomic<size_t>{ 0 };
+        static auto _seed  = []() -> hash_value_t {
+            auto _seed_v =
+                config::get_setting_value<uint64_t>("OMNITRACE_CAUSAL_RANDOM_SEED")
+                    .value_or(0);
+            // the permutations must be identical for every worker
+            return (_seed_v == 0) ? hash_value_t{ 0x9e3779b97f4a7c15 } : _seed_v;
+        }();
+
+        auto _size = speedup_dist.size();
+        auto _idx  = (_count++ * config::get_causal_num_workers()) +
+                    config::get_causal_worker_id();
+        auto _perm = std::vector<size_t>(_size, 0);
+        std::iota(_perm.begin(), _perm.end(), size_t{ 0 });
+        std::shuffle(_perm.begin(), _perm.end(),
+                     random_engine_t{ tim::get_hash_id(
+                         _seed, static_cast<int64_t>(_idx / _size)) });
+        return speedup_dist.at(_perm.at(_idx % _size));
+    }
     else
     {
         struct virtual_speedup
@@ -1053,6 +1429,11 @@ start_experimenting()
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
+    OMNITRACE_WARNING_IF(config::get_causal_mode() == CausalMode::Kernel &&
+                             !config::get_use_roctracer(),
+                         "[causal] kernel mode requires OMNITRACE_USE_ROCTRACER=ON: no "
+                         "experiment will be started\n");
+
     auto _user_speedup_dist = config::get_causal_fixed_speedup();
     if(!_user_speedup_dist.empty())
     {
@@ -1067,6 +1448,10 @@ start_experimenting()
         }
     }
 
+    // when the workers sharing the experiments start, none of them has written a
+    // result yet so the existing output can be removed here instead of when saving
+    experiment::reset_experiments();
+    selection_policy::setup();
     delay::setup();
     compute_eligible_lines();
 
@@ -1090,6 +1475,7 @@ finish_experimenting()
     }
     sampling::post_process();
     experiment::save_experiments();
+    selection_policy::save_status();
 }
 }  // namespace causal
 }  // namespace omnitrace
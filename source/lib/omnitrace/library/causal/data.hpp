@@ -68,8 +68,25 @@ void pop_progress_point(std::string_view);
 void
 mark_progress_point(std::string_view, bool force = false);
 
+/// records a GPU kernel which completed on the device. In kernel mode (see
+/// OMNITRACE_CAUSAL_MODE), the kernels are the candidates for the experiments and the
+/// completion of the selected kernel delays the host threads by the virtual speedup
+/// of its duration
+void
+record_kernel(std::string_view, uint64_t _beg_ns, uint64_t _end_ns);
+
+/// registers a throughput progress point and returns the handle for
+/// mark_registered_progress_point (zero if it could not be registered)
+uint64_t
+register_progress_point(std::string_view);
+
+/// marks a registered throughput progress point with a single increment of a
+/// counter of the calling thread. The counters are summed at the experiment boundaries
+void
+mark_registered_progress_point(uint64_t);
+
 uint16_t
-sample_virtual_speedup();
+sample_virtual_speedup(const selected_entry& = {});
 
 void
 start_experimenting();
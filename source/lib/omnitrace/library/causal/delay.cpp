@@ -21,7 +21,9 @@
 // SOFTWARE.
 
 #include "library/causal/delay.hpp"
+#include "core/config.hpp"
 #include "core/state.hpp"
+#include "core/tsc.hpp"
 #include "core/utility.hpp"
 #include "library/causal/components/causal_gotcha.hpp"
 #include "library/causal/experiment.hpp"
@@ -37,7 +39,9 @@
 #include <timemory/process/threading.hpp>
 
 #include <atomic>
-#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
 #include <random>
 
 namespace omnitrace
@@ -55,31 +59,80 @@ get_delay_data()
     return _v;
 }
 
+// state of the delays shared by all the threads. The wake-up latency and jitter are
+// exponentially-weighted moving averages of how late clock_nanosleep returns after
+// the requested time and of the deviation from that average so they adapt to the
+// kernel, the timer slack, and the load
+struct delay_state
+{
+    std::atomic<int64_t>  wakeup_latency = { 0 };
+    std::atomic<int64_t>  wakeup_jitter  = { 0 };
+    std::atomic<uint64_t> count          = { 0 };
+    std::atomic<int64_t>  error_sum      = { 0 };
+    std::atomic<uint64_t> max_error      = { 0 };
+};
+
+auto&
+get_delay_state()
+{
+    static auto _v = delay_state{};
+    return _v;
+}
+
+inline void
+cpu_relax()
+{
+#if OMNITRACE_HAS_TSC > 0
+    _mm_pause();
+#endif
+}
+
+// sleeps until the CLOCK_REALTIME deadline (the clock of tracing::now()) and returns
+// how late the thread woke up. An absolute deadline is not extended when the sleep
+// is interrupted by the sampling signals
 int64_t
-compute_sleep_for_overhead()
+sleep_until(int64_t _deadline)
+{
+    auto _ts = timespec{ static_cast<time_t>(_deadline / units::sec),
+                         static_cast<long>(_deadline % units::sec) };
+    while(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &_ts, nullptr) == EINTR)
+    {}
+    return static_cast<int64_t>(tracing::now()) - _deadline;
+}
+
+void
+update_wakeup_latency(int64_t _late)
+{
+    auto& _latency = get_delay_state().wakeup_latency;
+    auto& _jitter  = get_delay_state().wakeup_jitter;
+    auto  _prev    = _latency.load(std::memory_order_relaxed);
+    auto  _prev_j  = _jitter.load(std::memory_order_relaxed);
+    _latency.store(_prev + (_late - _prev) / 8, std::memory_order_relaxed);
+    _jitter.store(_prev_j + (std::abs(_late - _prev) - _prev_j) / 8,
+                  std::memory_order_relaxed);
+}
+
+void
+calibrate_wakeup_latency()
 {
     using random_engine_t = std::mt19937_64;
     auto   _engine        = random_engine_t{ std::random_device{}() };
-    auto   _dist          = std::uniform_int_distribution<int64_t>{ 0, 5 };
+    auto   _dist          = std::uniform_int_distribution<int64_t>{ 0, 5000 };
     size_t _ntot          = 250;
     size_t _nwarm         = 50;
     auto   _stats         = tim::statistics<double>{};
     for(size_t i = 0; i < _ntot; ++i)
     {
-        auto    _val = _dist(_engine);
-        int64_t _beg = tracing::now();
-        std::this_thread::sleep_for(std::chrono::nanoseconds{ _val });
-        int64_t _end = tracing::now();
+        auto _late = sleep_until(static_cast<int64_t>(tracing::now()) + _dist(_engine));
         if(i < _nwarm) continue;
-        auto _diff = (_end - _beg);
-        OMNITRACE_CONDITIONAL_THROW(
-            _diff < _val, "Error! sleep_for(%zu) [nanoseconds] >= %zu", _val, _diff);
-        _stats += (_diff - _val);
+        _stats += std::max<int64_t>(_late, 0);
     }
 
+    get_delay_state().wakeup_latency.store(static_cast<int64_t>(_stats.get_mean()));
+
     OMNITRACE_BASIC_VERBOSE(2,
-                            "[causal] overhead of std::this_thread::sleep_for(...) "
-                            "invocation = %6.3f usec +/- %e\n",
+                            "[causal] wake-up latency of clock_nanosleep(...) "
+                            "= %6.3f usec +/- %e\n",
                             _stats.get_mean() / units::usec,
                             _stats.get_stddev() / units::usec);
 
@@ -88,18 +141,14 @@ compute_sleep_for_overhead()
     });
 
     (void) get_delay_data();
-
-    return _stats.get_mean();
 }
-
-int64_t sleep_for_overhead = 0;
 }  // namespace
 
 void
 delay::setup()
 {
     static std::once_flag _once{};
-    std::call_once(_once, []() { sleep_for_overhead = compute_sleep_for_overhead(); });
+    std::call_once(_once, []() { calibrate_wakeup_latency(); });
 }
 
 void
@@ -114,10 +163,7 @@ delay::process()
         else if(get_global() > get_local())
         {
             ::omnitrace::causal::sampling::pause();
-            auto _beg = tracing::now();
-            std::this_thread::sleep_for(
-                std::chrono::nanoseconds{ get_global() - get_local() });
-            get_local() += (tracing::now() - _beg);
+            get_local() += wait(get_global() - get_local());
             ::omnitrace::causal::sampling::resume();
         }
     }
@@ -187,5 +233,56 @@ delay::compute_total_delay(uint64_t _baseline)
 {
     return get_global().load() - _baseline;
 }
+
+// sleeps until the spin threshold plus the expected wake-up latency (and twice its
+// jitter) before the end of the delay and busy-waits on tracing::now(), i.e. the TSC
+// when it is calibrated, for the remainder. The wake-up latency is re-estimated
+// after every sleep
+int64_t
+delay::wait(int64_t _ns)
+{
+    auto& _state  = get_delay_state();
+    auto  _spin   = static_cast<int64_t>(config::get_snapshot().causal_delay_spin_ns);
+    auto  _margin = _state.wakeup_latency.load(std::memory_order_relaxed) +
+                   2 * _state.wakeup_jitter.load(std::memory_order_relaxed);
+    auto  _beg    = static_cast<int64_t>(tracing::now());
+    auto  _end    = _beg + _ns;
+    auto  _wake   = _end - _spin - _margin;
+
+    if(_wake > _beg) update_wakeup_latency(sleep_until(_wake));
+
+    auto _now = static_cast<int64_t>(tracing::now());
+    while(_now < _end)
+    {
+        cpu_relax();
+        _now = tracing::now();
+    }
+
+    auto _elapsed = _now - _beg;
+    auto _error   = _elapsed - _ns;
+    auto _abs     = static_cast<uint64_t>(std::abs(_error));
+    auto _max     = _state.max_error.load(std::memory_order_relaxed);
+    _state.count.fetch_add(1, std::memory_order_relaxed);
+    _state.error_sum.fetch_add(_error, std::memory_order_relaxed);
+    while(_abs > _max && !_state.max_error.compare_exchange_weak(
+                             _max, _abs, std::memory_order_relaxed))
+    {}
+
+    return _elapsed;
+}
+
+delay::accuracy
+delay::get_accuracy(bool _reset)
+{
+    auto& _state = get_delay_state();
+    auto  _v     = accuracy{};
+    auto  _sum   = (_reset) ? _state.error_sum.exchange(0) : _state.error_sum.load();
+
+    _v.count          = (_reset) ? _state.count.exchange(0) : _state.count.load();
+    _v.max_error      = (_reset) ? _state.max_error.exchange(0) : _state.max_error.load();
+    _v.mean_error     = (_v.count > 0) ? (static_cast<double>(_sum) / _v.count) : 0.0;
+    _v.wakeup_latency = _state.wakeup_latency.load();
+    return _v;
+}
 }  // namespace causal
 }  // namespace omnitrace
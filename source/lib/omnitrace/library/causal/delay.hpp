@@ -42,6 +42,15 @@ struct delay : comp::empty_base
 {
     using value_type = void;
 
+    /// the difference between the elapsed and the requested time of the delays
+    struct accuracy
+    {
+        uint64_t count          = 0;    ///< number of delays
+        double   mean_error     = 0.0;  ///< mean of elapsed - requested [nsec]
+        uint64_t max_error      = 0;    ///< max of |elapsed - requested| [nsec]
+        int64_t  wakeup_latency = 0;    ///< estimated clock_nanosleep oversleep [nsec]
+    };
+
     OMNITRACE_DEFAULT_OBJECT(delay)
 
     static void    setup();
@@ -56,6 +65,10 @@ struct delay : comp::empty_base
 
     static int64_t  get(int64_t _tid = threading::get_id());
     static uint64_t compute_total_delay(uint64_t);
+
+    /// waits for the given number of nanoseconds and returns the elapsed time
+    static int64_t  wait(int64_t);
+    static accuracy get_accuracy(bool _reset = false);
 };
 }  // namespace causal
 }  // namespace omnitrace
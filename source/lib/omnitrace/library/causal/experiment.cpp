@@ -32,6 +32,7 @@
 #include "library/causal/components/progress_point.hpp"
 #include "library/causal/data.hpp"
 #include "library/causal/delay.hpp"
+#include "library/causal/experiment_log.hpp"
 #include "library/causal/sample_data.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
@@ -47,9 +48,17 @@
 #include <timemory/units.hpp>
 #include <timemory/unwind/dlinfo.hpp>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
 #include <ratio>
 #include <regex>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -71,6 +80,24 @@ int64_t global_scaling            = 1;
 int64_t global_scaling_increments = 0;
 bool    use_exp_speedup_scaling =
     get_env<bool>("OMNITRACE_CAUSAL_SCALE_EXPERIMENT_TIME_BY_SPEEDUP", false);
+bool    experiments_reset = false;
+
+auto
+get_filename_config()
+{
+    auto _cfg         = settings::compose_filename_config{};
+    _cfg.subdirectory = "causal";
+    // the workers sharing the experiments write to a common file
+    _cfg.use_suffix = config::get_use_pid() && config::get_causal_num_workers() <= 1;
+    return _cfg;
+}
+
+auto
+get_log_filename(const std::string& _fname_base,
+                 const settings::compose_filename_config& _cfg)
+{
+    return tim::settings::compose_output_filename(_fname_base, "log", _cfg);
+}
 }  // namespace
 
 experiment::sample::sample(const base_type& _b, uint64_t _c)
@@ -195,6 +222,14 @@ experiment::serialize(ArchiveT& ar, const unsigned)
     }
     else
     {
+        // the delay accuracy and the selection reason are informational and are not
+        // required when loading
+        ar(cereal::make_nvp("delay_count", delay_count),
+           cereal::make_nvp("delay_error", delay_error),
+           cereal::make_nvp("delay_error_max", delay_error_max),
+           cereal::make_nvp("selection_reason",
+                            std::string{ selection_policy::get_name(select_reason) }));
+
         auto _ppts = std::vector<component::progress_point>{};
         {
             auto ppts = fini_progress;
@@ -210,6 +245,371 @@ experiment::serialize(ArchiveT& ar, const unsigned)
     }
 }
 
+namespace
+{
+template <typename Tp>
+std::string
+serialize_payload(const char* _name, const Tp& _v)
+{
+    auto oss = std::stringstream{};
+    {
+        auto ar = tim::policy::output_archive<cereal::MinimalJSONOutputArchive>::get(oss);
+        (*ar)(cereal::make_nvp(_name, _v));
+    }
+    return oss.str();
+}
+
+template <typename Tp>
+Tp
+deserialize_payload(const char* _name, const std::string& _v)
+{
+    auto iss   = std::stringstream{ _v };
+    auto _data = Tp{};
+    {
+        auto ar = tim::policy::input_archive<cereal::JSONInputArchive>::get(iss);
+        (*ar)(cereal::make_nvp(_name, _data));
+    }
+    return _data;
+}
+
+int64_t
+get_startup()
+{
+    return thread_info::get(0, InternalTID)->lifetime.first;
+}
+
+// groups the entries of the log into the records of each process
+std::vector<experiment::record>
+load_log(const std::string& _fname)
+{
+    auto _index      = experiment_log::read_index(_fname);
+    auto _payloads   = experiment_log::read_payloads(_fname, _index);
+    auto _records    = std::vector<experiment::record>{};
+    auto _positions  = std::map<int64_t, size_t>{};
+    auto _get_record = [&_records, &_positions](int64_t _startup) -> experiment::record& {
+        auto itr = _positions.find(_startup);
+        if(itr != _positions.end()) return _records.at(itr->second);
+        _positions.emplace(_startup, _records.size());
+        _records.emplace_back();
+        _records.back().startup = _startup;
+        return _records.back();
+    };
+
+    for(size_t i = 0; i < _index.size() && i < _payloads.size(); ++i)
+    {
+        const auto& _entry   = _index.at(i);
+        const auto& _payload = _payloads.at(i);
+        if(_payload.empty()) continue;
+        try
+        {
+            auto& _record = _get_record(_entry.startup);
+            if(_entry.type == experiment_log::record_entry)
+            {
+                auto _v = deserialize_payload<experiment::record>("record", _payload);
+                _record.runtime = _v.runtime;
+                _record.samples = std::move(_v.samples);
+            }
+            else
+            {
+                _record.experiments.emplace_back(
+                    deserialize_payload<experiment>("experiment", _payload));
+            }
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_VERBOSE(0, "Warning! unable to load entry %zu of %s: %s\n", i,
+                              _fname.c_str(), _e.what());
+        }
+    }
+
+    // the processes which did not finish have no record entry
+    for(auto& itr : _records)
+    {
+        if(itr.runtime > 0 || itr.experiments.empty()) continue;
+        uint64_t _beg = std::numeric_limits<uint64_t>::max();
+        uint64_t _end = 0;
+        for(const auto& eitr : itr.experiments)
+        {
+            _beg = std::min<uint64_t>(_beg, eitr.start_time);
+            _end = std::max<uint64_t>(_end, eitr.end_time);
+        }
+        itr.runtime = (_end > _beg) ? (_end - _beg) : 0;
+    }
+
+    return _records;
+}
+
+void
+append_log(const experiment& _v)
+{
+    auto _fname_base = config::get_causal_output_filename();
+    auto _cfg        = get_filename_config();
+    auto _entry      = experiment_log::index_entry{};
+
+    _entry.type            = experiment_log::experiment_entry;
+    _entry.virtual_speedup = _v.virtual_speedup;
+    _entry.reason          = _v.select_reason;
+    _entry.startup         = get_startup();
+    _entry.duration        = _v.duration;
+    _entry.progress        = _v.get_progress();
+    _entry.name            = selection_policy::get_name(_v.selection);
+
+    auto _payload = serialize_payload("experiment", _v);
+    auto _lk      = scoped_file_lock{ tim::settings::compose_output_filename(
+        _fname_base, "lock", _cfg) };
+    if(!experiment_log::append(get_log_filename(_fname_base, _cfg), _entry, _payload))
+        OMNITRACE_VERBOSE(0, "Warning! unable to append causal experiment #%u to %s\n",
+                          _v.index, get_log_filename(_fname_base, _cfg).c_str());
+}
+
+// the aggregate of the experiments with the same selection, progress point, and virtual
+// speedup. The period is the duration per unit of progress, i.e. the inverse of the
+// throughput or the latency
+struct summary_point
+{
+    uint64_t count    = 0;
+    double   duration = 0.0;
+    double   progress = 0.0;
+    double   sum      = 0.0;  // of the period of each experiment
+    double   sumsq    = 0.0;
+
+    void add(double _duration, double _progress)
+    {
+        auto _period = _duration / _progress;
+        count += 1;
+        duration += _duration;
+        progress += _progress;
+        sum += _period;
+        sumsq += _period * _period;
+    }
+
+    double period() const { return duration / progress; }
+};
+
+struct summary_curve
+{
+    std::string                       type   = {};
+    std::map<uint16_t, summary_point> points = {};  // keyed by the virtual speedup
+};
+
+// keyed by the selection and then by the progress point
+using summary_data_t = std::map<std::string, std::map<std::string, summary_curve>>;
+
+// the same selection name and progress point classification as the causal viewer
+std::string
+get_summary_name(const selected_entry& _v)
+{
+    if(_v.symbol_address == 0) return join(":", _v.symbol.file, _v.symbol.line);
+    return demangle(_v.symbol.func);
+}
+
+// writes the program speedup of each (selection, progress point, virtual speedup) with
+// its spread and the impact of each (selection, progress point) so that the causal
+// viewer does not have to load and reprocess every experiment. The curves are sorted
+// by decreasing impact and indexed by selection
+void
+save_summary(const std::vector<experiment::record>& _records,
+             const std::string& _fname_base, const experiment::filename_config_t& _cfg)
+{
+    auto   _data        = summary_data_t{};
+    auto   _samples     = std::map<std::string, uint64_t>{};
+    size_t _experiments = 0;
+    for(const auto& ritr : _records)
+    {
+        for(const auto& eitr : ritr.experiments)
+        {
+            auto& _selection = _data[get_summary_name(eitr.selection)];
+            auto  _ppts      = eitr.fini_progress;
+            for(const auto& pitr : eitr.init_progress)
+                _ppts[pitr.first] -= pitr.second;
+
+            for(const auto& pitr : _ppts)
+            {
+                auto _name     = std::string{ tim::get_hash_identifier(pitr.first) };
+                auto _type     = std::string{};
+                auto _progress = int64_t{ 0 };
+                if(pitr.second.get_delta() > 0)
+                {
+                    _type     = "throughput";
+                    _progress = pitr.second.get_delta();
+                }
+                else if(pitr.second.get_arrival() > 0)
+                {
+                    _type     = "latency";
+                    _progress = pitr.second.get_arrival();
+                }
+                else
+                    continue;
+
+                auto& _curve = _selection[_name];
+                if(_curve.type.empty()) _curve.type = _type;
+                _curve.points[eitr.virtual_speedup].add(eitr.duration, _progress);
+            }
+            ++_experiments;
+        }
+        for(const auto& sitr : ritr.samples)
+            _samples[demangle(sitr.name)] += sitr.count;
+    }
+
+    // the sum, mean, and stddev of the values
+    auto _get_stats = [](const std::vector<double>& _v) {
+        double _sum = 0.0;
+        double _sq  = 0.0;
+        for(auto itr : _v)
+        {
+            _sum += itr;
+            _sq += itr * itr;
+        }
+        auto _n    = std::max<double>(_v.size(), 1.0);
+        auto _mean = _sum / _n;
+        auto _var  = std::max(_sq / _n - _mean * _mean, 0.0);
+        return std::array<double, 3>{ _sum, _mean, std::sqrt(_var) };
+    };
+
+    struct curve_entry
+    {
+        const std::string*    selection      = nullptr;
+        const std::string*    progress_point = nullptr;
+        const summary_curve*  curve          = nullptr;
+        std::vector<double>   speedup        = {};
+        std::array<double, 3> impact         = {};
+    };
+
+    auto _curves = std::vector<curve_entry>{};
+    for(const auto& sitr : _data)
+    {
+        for(const auto& pitr : sitr.second)
+        {
+            auto _base = pitr.second.points.find(0);
+            if(_base == pitr.second.points.end()) continue;
+
+            auto _entry       = curve_entry{ &sitr.first, &pitr.first, &pitr.second };
+            auto _base_period = _base->second.period();
+            for(const auto& itr : pitr.second.points)
+                _entry.speedup.emplace_back(
+                    100.0 * (_base_period - itr.second.period()) / _base_period);
+
+            // the area below each segment of the curve
+            auto _impact = std::vector<double>{};
+            auto _vitr   = pitr.second.points.begin();
+            for(size_t i = 1; i < _entry.speedup.size(); ++i, ++_vitr)
+            {
+                auto _x = static_cast<double>(std::next(_vitr)->first - _vitr->first);
+                _impact.emplace_back(0.5 * _x *
+                                     (_entry.speedup.at(i - 1) + _entry.speedup.at(i)));
+            }
+            _entry.impact = _get_stats(_impact);
+            _curves.emplace_back(std::move(_entry));
+        }
+    }
+
+    std::stable_sort(_curves.begin(), _curves.end(),
+                     [](const auto& _lhs, const auto& _rhs) {
+                         return _lhs.impact.at(0) > _rhs.impact.at(0);
+                     });
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("causal_summary");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("version", 1),
+              cereal::make_nvp("records", _records.size()),
+              cereal::make_nvp("experiments", _experiments));
+
+        ar->setNextName("curves");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _curves)
+        {
+            auto _base_period = itr.curve->points.at(0).period();
+            auto _virtual     = std::vector<uint16_t>{};
+            auto _count       = std::vector<uint64_t>{};
+            auto _stddev      = std::vector<double>{};
+            auto _ci95        = std::vector<double>{};
+            for(const auto& pitr : itr.curve->points)
+            {
+                // the program speedup of an experiment is an affine function of its
+                // period so the spread is the scaled spread of the periods
+                const auto& _v     = pitr.second;
+                auto        _n     = static_cast<double>(_v.count);
+                auto        _mean  = _v.sum / _n;
+                auto        _var   = std::max(_v.sumsq / _n - _mean * _mean, 0.0);
+                auto        _scale = 100.0 / _base_period;
+                _virtual.emplace_back(pitr.first);
+                _count.emplace_back(_v.count);
+                _stddev.emplace_back(_scale * std::sqrt(_var));
+                // the 95% confidence interval of the mean uses the sample variance
+                _ci95.emplace_back((_v.count > 1) ? (1.96 * _scale *
+                                                     std::sqrt(_var / (_n - 1)))
+                                                  : 0.0);
+            }
+
+            const auto& _impact = itr.impact;
+            ar->startNode();
+            (*ar)(cereal::make_nvp("selection", *itr.selection),
+                  cereal::make_nvp("progress_point", *itr.progress_point),
+                  cereal::make_nvp("type", itr.curve->type),
+                  cereal::make_nvp("impact_sum", _impact[0]),
+                  cereal::make_nvp("impact_mean", _impact[1]),
+                  cereal::make_nvp("impact_stddev", _impact[2]),
+                  cereal::make_nvp("virtual_speedup", _virtual),
+                  cereal::make_nvp("program_speedup", itr.speedup),
+                  cereal::make_nvp("speedup_stddev", _stddev),
+                  cereal::make_nvp("speedup_ci95", _ci95),
+                  cereal::make_nvp("experiments", _count));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        // the indexes of the curves of each selection
+        ar->setNextName("index");
+        ar->startNode();
+        {
+            auto _index = std::map<std::string, std::vector<size_t>>{};
+            for(size_t i = 0; i < _curves.size(); ++i)
+                _index[*_curves.at(i).selection].emplace_back(i);
+            for(const auto& itr : _index)
+                (*ar)(cereal::make_nvp(itr.first.c_str(), itr.second));
+        }
+        ar->finishNode();
+
+        ar->setNextName("samples");
+        ar->startNode();
+        {
+            auto _location = std::vector<std::string>{};
+            auto _count    = std::vector<uint64_t>{};
+            for(const auto& itr : _samples)
+            {
+                _location.emplace_back(itr.first);
+                _count.emplace_back(itr.second);
+            }
+            (*ar)(cereal::make_nvp("location", _location),
+                  cereal::make_nvp("count", _count));
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename(
+        JOIN("-", _fname_base, "summary"), "json", _cfg);
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening causal summary output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<experiment>{}(_fname,
+                                                     std::string{ "causal_summary" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
 std::string
 experiment::label()
 {
@@ -241,7 +641,8 @@ experiment::start()
 
     // experiment time is scaled up for longer speedups
     index           = experiment_history.size() + 1;
-    virtual_speedup = sample_virtual_speedup();
+    virtual_speedup = sample_virtual_speedup(selection);
+    select_reason   = selection_policy::get_reason();
     delay_scaling   = virtual_speedup / 100.0;
     if(use_exp_speedup_scaling) scaling_factor *= (1.0 + delay_scaling);
 
@@ -249,10 +650,13 @@ experiment::start()
     sample_delay    = sampling_period * delay_scaling;
     total_delay     = delay::sync();
     init_progress   = component::progress_point::get_progress_points();
+    delay::get_accuracy(true);
     start_time      = tracing::now();
 
     OMNITRACE_VERBOSE(0, "Starting causal experiment #%-3u: %s\n", index,
                       as_string().c_str());
+    OMNITRACE_VERBOSE(1, "Causal experiment #%-3u selection reason: %s\n", index,
+                      selection_policy::get_name(select_reason));
 
     if(get_state() < State::Finalized)
     {
@@ -295,9 +699,23 @@ experiment::stop()
     duration      = (experiment_time > total_delay) ? (experiment_time - total_delay) : 0;
     fini_progress = component::progress_point::get_progress_points();
 
+    auto _accuracy  = delay::get_accuracy(true);
+    delay_count     = _accuracy.count;
+    delay_error     = _accuracy.mean_error;
+    delay_error_max = _accuracy.max_error;
+
+    OMNITRACE_VERBOSE(1,
+                      "Causal experiment #%-3u delay accuracy: %zu delays, mean error = "
+                      "%.3f usec, max error = %.3f usec, wake-up latency = %.3f usec\n",
+                      index, static_cast<size_t>(delay_count), delay_error / units::usec,
+                      static_cast<double>(delay_error_max) / units::usec,
+                      static_cast<double>(_accuracy.wakeup_latency) / units::usec);
+
     // sync data
     delay::sync();
 
+    selection_policy::update(*this);
+
     auto _prog_stats = tim::statistics<double>{};
     auto _prog_vals  = std::vector<int64_t>{};
     _prog_vals.reserve(fini_progress.size());
@@ -350,7 +768,12 @@ experiment::stop()
             global_scaling_increments);
     }
 
-    if(_high > 0) experiment_history.emplace_back(*this);
+    if(_high > 0)
+    {
+        experiment_history.emplace_back(*this);
+        if(config::get_causal_log() && duration > 0 && experiment_time > 0)
+            append_log(*this);
+    }
 
     std::this_thread::sleep_for(
         std::chrono::nanoseconds{ 5 * sampling_period * batch_size });
@@ -358,6 +781,20 @@ experiment::stop()
     return true;
 }
 
+double
+experiment::get_progress() const
+{
+    auto _ppts = fini_progress;
+    for(const auto& itr : init_progress)
+        _ppts[itr.first] -= itr.second;
+
+    double _n = 0.0;
+    for(const auto& itr : _ppts)
+        _n += std::max<int64_t>({ itr.second.get_delta(), itr.second.get_arrival(),
+                                  itr.second.get_departure(), int64_t{ 0 } });
+    return _n;
+}
+
 std::string
 experiment::as_string() const
 {
@@ -373,7 +810,7 @@ experiment::as_string() const
     if(selection.symbol_address > 0 && selection.address != selection.symbol_address)
         _ss << "(symbol@" << as_hex(selection.symbol_address) << ") ";
     if(!selection.symbol.file.empty() && selection.symbol.line > 0)
-        _ss << "[" << filepath::basename(selection.symbol.file) << ":"
+        _ss << "[" << filepath::basename(selection.symbol.file.str()) << ":"
             << selection.symbol.line << "]";
 
     auto _patch = [](std::string _v) {
@@ -427,13 +864,15 @@ experiment::is_active()
 bool
 experiment::is_selected(uint64_t _addr)
 {
+    // in kernel mode, the host code is never selected
+    if(config::get_snapshot().causal_kernels) return false;
     return (is_active() && current_experiment_value.selection.contains(_addr));
 }
 
 bool
 experiment::is_selected(unwind_addr_t _stack)
 {
-    if(is_active())
+    if(is_active() && !config::get_snapshot().causal_kernels)
     {
         for(auto itr : _stack)
             if(itr > 0 && current_experiment_value.selection.contains(itr)) return true;
@@ -444,7 +883,7 @@ experiment::is_selected(unwind_addr_t _stack)
 bool
 experiment::is_selected(container::c_array<uint64_t> _stack)
 {
-    if(is_active())
+    if(is_active() && !config::get_snapshot().causal_kernels)
     {
         for(auto itr : _stack)
             if(itr > 0 && current_experiment_value.selection.contains(itr)) return true;
@@ -452,6 +891,13 @@ experiment::is_selected(container::c_array<uint64_t> _stack)
     return false;
 }
 
+bool
+experiment::is_selected_kernel(hash_value_t _hash)
+{
+    return (is_active() && config::get_snapshot().causal_kernels &&
+            current_experiment_value.selection.address == _hash);
+}
+
 void
 experiment::add_selected()
 {
@@ -465,13 +911,36 @@ experiment::get_experiments()
     return experiment_history;
 }
 
+void
+experiment::reset_experiments()
+{
+    if(!config::get_setting_value<bool>("OMNITRACE_CAUSAL_FILE_RESET").value_or(false))
+        return;
+
+    auto _fname_base = config::get_causal_output_filename();
+    auto _cfg        = get_filename_config();
+    auto _lk         = scoped_file_lock{ tim::settings::compose_output_filename(
+        _fname_base, "lock", _cfg) };
+
+    // the number of MPI ranks may not be known yet so both the per-process and the
+    // shared output files are removed
+    for(auto _use_suffix : { true, false })
+    {
+        _cfg.use_suffix = _use_suffix && config::get_use_pid();
+        for(const auto* _ext : { "json", "coz", "log" })
+        {
+            auto _fname = tim::settings::compose_output_filename(_fname_base, _ext, _cfg);
+            if(filepath::exists(_fname)) std::remove(_fname.c_str());
+        }
+    }
+
+    experiments_reset = true;
+}
+
 void
 experiment::save_experiments()
 {
-    auto _cfg         = settings::compose_filename_config{};
-    _cfg.subdirectory = "causal";
-    _cfg.use_suffix   = config::get_use_pid();
-    save_experiments(config::get_causal_output_filename(), _cfg);
+    save_experiments(config::get_causal_output_filename(), get_filename_config());
 }
 
 void  // NOLINTNEXTLINE
@@ -537,13 +1006,56 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
     }
 
     bool _causal_output_reset =
+        !experiments_reset &&
         config::get_setting_value<bool>("OMNITRACE_CAUSAL_FILE_RESET").value_or(false);
 
+    // the load and rewrite of the output files must not interleave with the other
+    // workers sharing the experiments
+    auto _lk = scoped_file_lock{ tim::settings::compose_output_filename(_fname_base,
+                                                                        "lock", _cfg) };
+
+    bool _write_json        = true;
+    auto _saved_experiments = std::vector<experiment::record>{};
+    if(config::get_causal_log())
+    {
+        // the experiments were appended to the log as they completed so only the
+        // runtime and the samples remain
+        auto _entry     = experiment_log::index_entry{};
+        _entry.type     = experiment_log::record_entry;
+        _entry.startup  = current_record.startup;
+        _entry.duration = current_record.runtime;
+
+        auto _log_record    = record{};
+        _log_record.startup = current_record.startup;
+        _log_record.runtime = current_record.runtime;
+        _log_record.samples = current_record.samples;
+
+        auto _log_fname = get_log_filename(_fname_base, _cfg);
+        if(!experiment_log::append(_log_fname, _entry,
+                                   serialize_payload("record", _log_record)))
+        {
+            OMNITRACE_THROW("Error appending to causal experiment log: %s",
+                            _log_fname.c_str());
+        }
+
+        if(get_verbose() >= 0)
+            operation::file_output_message<experiment>{}(
+                _log_fname, std::string{ "causal_experiments" });
+
+        // the summary is needed by the causal viewer even when the experiments are not
+        // exported
+        _write_json        = config::get_causal_log_export();
+        _saved_experiments = load_log(_log_fname);
+    }
+    else
     {
-        auto _saved_experiments = (_causal_output_reset)
-                                      ? std::vector<experiment::record>{}
-                                      : load_experiments(_fname_base, _cfg, false);
+        if(!_causal_output_reset)
+            _saved_experiments = load_experiments(_fname_base, _cfg, false);
         _saved_experiments.emplace_back(current_record);
+    }
+
+    if(_write_json)
+    {
         std::stringstream oss{};
         {
             auto ar =
@@ -574,33 +1086,20 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
         }
     }
 
-    auto _fname = tim::settings::compose_output_filename(_fname_base, "coz", _cfg);
+    save_summary(_saved_experiments, _fname_base, _cfg);
 
-    // read in existing data
-    auto _existing = std::stringstream{};
-    if(!_causal_output_reset)
-    {
-        std::ifstream ifs{ _fname };
-        if(ifs)
-        {
-            while(ifs && ifs.good())
-            {
-                std::string _line;
-                std::getline(ifs, _line);
-                _existing << _line << "\n";
-            }
-        }
-    }
+    auto _fname = tim::settings::compose_output_filename(_fname_base, "coz", _cfg);
 
+    // the previous runs are preserved by appending unless the output is reset
+    auto _mode = (_causal_output_reset) ? std::ios::trunc : std::ios::app;
     std::ofstream ofs{};
     ofs.setf(std::ios::fixed);
-    if(tim::filepath::open(ofs, _fname))
+    if(tim::filepath::open(ofs, _fname, std::ios::out | _mode))
     {
         if(get_verbose() >= 0)
             operation::file_output_message<experiment>{}(
                 _fname, std::string{ "causal_experiments" });
 
-        ofs << _existing.str();
         ofs << "startup\ttime=" << current_record.startup << "\n";
 
         for(auto& itr : current_record.experiments)
@@ -608,9 +1107,7 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
             auto& _selection = itr.selection;
             auto& _line_info = _selection.symbol;
 
-            std::string _name = (_selection.symbol_address > 0)
-                                    ? _line_info.func
-                                    : join(":", _line_info.file, _line_info.line);
+            std::string _name = selection_policy::get_name(_selection);
 
             OMNITRACE_CONDITIONAL_THROW(
                 _name.empty(),
@@ -623,6 +1120,10 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
                 << "\tspeedup=" << std::setprecision(2)
                 << static_cast<double>(itr.virtual_speedup / 100.0)
                 << "\tduration=" << itr.duration << "\tselected-samples=" << itr.selected
+                << "\tdelay-count=" << itr.delay_count << "\tdelay-error="
+                << static_cast<int64_t>(itr.delay_error)
+                << "\tdelay-error-max=" << itr.delay_error_max
+                << "\tselection-reason=" << selection_policy::get_name(itr.select_reason)
                 << "\n";
 
             auto ppts = itr.fini_progress;
@@ -673,10 +1174,26 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
 std::vector<experiment::record>
 experiment::load_experiments(bool _throw_on_error)
 {
-    auto _cfg         = settings::compose_filename_config{};
-    _cfg.subdirectory = "causal";
-    _cfg.use_suffix   = config::get_use_pid();
-    return load_experiments(config::get_causal_output_filename(), _cfg, _throw_on_error);
+    auto _fname_base = config::get_causal_output_filename();
+    auto _cfg        = get_filename_config();
+    auto _lk         = scoped_file_lock{ tim::settings::compose_output_filename(
+        _fname_base, "lock", _cfg) };
+    if(config::get_causal_log())
+    {
+        auto _log_fname = get_log_filename(_fname_base, _cfg);
+        if(filepath::exists(_log_fname)) return load_log(_log_fname);
+    }
+    return load_experiments(_fname_base, _cfg, _throw_on_error);
+}
+
+std::vector<experiment_log::index_entry>
+experiment::load_experiment_index()
+{
+    auto _fname_base = config::get_causal_output_filename();
+    auto _cfg        = get_filename_config();
+    auto _lk         = scoped_file_lock{ tim::settings::compose_output_filename(
+        _fname_base, "lock", _cfg) };
+    return experiment_log::read_index(get_log_filename(_fname_base, _cfg));
 }
 
 std::vector<experiment::record>
@@ -30,7 +30,9 @@
 #include "library/causal/components/backtrace.hpp"
 #include "library/causal/components/progress_point.hpp"
 #include "library/causal/data.hpp"
+#include "library/causal/experiment_log.hpp"
 #include "library/causal/selected_entry.hpp"
+#include "library/causal/selection_policy.hpp"
 
 #include <timemory/hash/types.hpp>
 #include <timemory/mpl/concepts.hpp>
@@ -54,6 +56,7 @@ struct experiment
     using progress_points_t =
         std::unordered_map<tim::hash_value_t, component::progress_point>;
     using experiments_t     = std::vector<experiment>;
+    using reason_t          = selection_policy::reason;
     using filename_config_t = settings::compose_filename_config;
     using period_stats_t    = tim::statistics<int64_t>;
 
@@ -98,6 +101,7 @@ struct experiment
     bool        wait() const;  // returns false if interrupted
     bool        stop();
     std::string as_string() const;
+    double      get_progress() const;  // sum of the progress point changes
 
     template <typename ArchiveT>
     void serialize(ArchiveT& ar, const unsigned version);
@@ -110,6 +114,7 @@ struct experiment
     static bool          is_selected(uint64_t);
     static bool          is_selected(unwind_addr_t);
     static bool          is_selected(container::c_array<uint64_t>);
+    static bool          is_selected_kernel(hash_value_t);
     static void          add_selected();
     static experiments_t get_experiments();
 
@@ -119,11 +124,13 @@ struct experiment
         return is_selected(container::c_array<uint64_t>{ _v.data(), _v.size() });
     }
 
+    static void                reset_experiments();
     static void                save_experiments();
     static void                save_experiments(std::string, const filename_config_t&);
     static std::vector<record> load_experiments(bool _throw_on_err = true);
     static std::vector<record> load_experiments(std::string, const filename_config_t&,
                                                 bool = true);
+    static std::vector<experiment_log::index_entry> load_experiment_index();
 
     bool              running         = false;
     uint16_t          virtual_speedup = 0;    /// 0-100 in multiples of 5
@@ -139,8 +146,12 @@ struct experiment
     uint64_t          total_delay     = 0;    /// total delays [nsec]
     uint64_t          selected        = 0;    /// num times selected line sampled
     uint64_t          global_delay    = 0;
+    uint64_t          delay_count     = 0;    /// number of delays inserted
+    double            delay_error     = 0.0;  /// mean of elapsed - requested [nsec]
+    uint64_t          delay_error_max = 0;    /// max of |elapsed - requested| [nsec]
     double            delay_scaling   = 0.0;  /// virtual_speedup / 100.
     selected_entry    selection       = {};   /// which line was selected
+    reason_t          select_reason   = selection_policy::random_choice;
     progress_points_t init_progress   = {};   /// progress points at start
     progress_points_t fini_progress   = {};   /// progress points at end
 };
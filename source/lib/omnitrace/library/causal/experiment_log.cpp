@@ -0,0 +1,231 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/causal/experiment_log.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+
+#include <timemory/utility/filepath.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace
+{
+constexpr char     log_magic[8] = { 'O', 'M', 'N', 'I', 'C', 'L', 'O', 'G' };
+constexpr uint32_t log_version  = 1;
+
+struct file_header
+{
+    char     magic[8] = {};
+    uint32_t version  = 0;
+    uint32_t reserved = 0;
+};
+
+struct entry_header
+{
+    uint32_t type            = 0;
+    uint32_t name_size       = 0;
+    uint64_t payload_size    = 0;
+    int64_t  startup         = 0;
+    uint64_t duration        = 0;
+    double   progress        = 0;
+    uint16_t virtual_speedup = 0;
+    uint16_t reason          = 0;
+    uint32_t reserved        = 0;
+};
+
+static_assert(sizeof(file_header) == 16, "unexpected padding of the log header");
+static_assert(sizeof(entry_header) == 48, "unexpected padding of the entry header");
+
+bool
+write_all(int _fd, const char* _data, size_t _size)
+{
+    while(_size > 0)
+    {
+        auto _n = ::write(_fd, _data, _size);
+        if(_n < 0 && errno == EINTR) continue;
+        if(_n <= 0) return false;
+        _data += _n;
+        _size -= _n;
+    }
+    return true;
+}
+}  // namespace
+
+scoped_file_lock::scoped_file_lock(const std::string& _fname)
+{
+    // creates the output directory if necessary
+    {
+        auto ofs = std::ofstream{};
+        tim::filepath::open(ofs, _fname, std::ios::out | std::ios::app);
+    }
+    m_fd = ::open(_fname.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(m_fd < 0)
+    {
+        OMNITRACE_VERBOSE(0, "Warning! unable to open causal lock file '%s': %s\n",
+                          _fname.c_str(), strerror(errno));
+        return;
+    }
+    while(::flock(m_fd, LOCK_EX) != 0 && errno == EINTR)
+    {}
+}
+
+scoped_file_lock::~scoped_file_lock()
+{
+    if(m_fd < 0) return;
+    ::flock(m_fd, LOCK_UN);
+    ::close(m_fd);
+}
+
+namespace experiment_log
+{
+bool
+append(const std::string& _fname, const index_entry& _entry, std::string_view _payload)
+{
+    {
+        auto ofs = std::ofstream{};
+        if(!tim::filepath::open(ofs, _fname, std::ios::out | std::ios::app)) return false;
+    }
+
+    int _fd = ::open(_fname.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if(_fd < 0) return false;
+
+    auto _buffer = std::string{};
+    struct stat _stat = {};
+    if(::fstat(_fd, &_stat) == 0 && _stat.st_size == 0)
+    {
+        auto _header = file_header{};
+        std::memcpy(_header.magic, log_magic, sizeof(log_magic));
+        _header.version = log_version;
+        _buffer.append(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    }
+
+    auto _header            = entry_header{};
+    _header.type            = _entry.type;
+    _header.name_size       = _entry.name.size();
+    _header.payload_size    = _payload.size();
+    _header.startup         = _entry.startup;
+    _header.duration        = _entry.duration;
+    _header.progress        = _entry.progress;
+    _header.virtual_speedup = _entry.virtual_speedup;
+    _header.reason          = _entry.reason;
+
+    _buffer.reserve(_buffer.size() + sizeof(_header) + _entry.name.size() +
+                    _payload.size());
+    _buffer.append(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    _buffer.append(_entry.name);
+    _buffer.append(_payload.data(), _payload.size());
+
+    auto _success = write_all(_fd, _buffer.data(), _buffer.size());
+    ::close(_fd);
+    return _success;
+}
+
+std::vector<index_entry>
+read_index(const std::string& _fname)
+{
+    auto _data = std::vector<index_entry>{};
+    auto ifs   = std::ifstream{ _fname, std::ios::in | std::ios::binary };
+    if(!ifs) return _data;
+
+    auto _file_header = file_header{};
+    if(!ifs.read(reinterpret_cast<char*>(&_file_header), sizeof(_file_header)) ||
+       std::memcmp(_file_header.magic, log_magic, sizeof(log_magic)) != 0 ||
+       _file_header.version != log_version)
+    {
+        OMNITRACE_VERBOSE(0,
+                          "Warning! '%s' is not a causal experiment log (version %u)\n",
+                          _fname.c_str(), log_version);
+        return _data;
+    }
+
+    ifs.seekg(0, std::ios::end);
+    auto _end = static_cast<uint64_t>(ifs.tellg());
+    ifs.seekg(sizeof(_file_header), std::ios::beg);
+
+    auto _header = entry_header{};
+    while(ifs.read(reinterpret_cast<char*>(&_header), sizeof(_header)))
+    {
+        if(_header.type != experiment_entry && _header.type != record_entry) break;
+
+        auto _entry            = index_entry{};
+        _entry.type            = static_cast<entry_type>(_header.type);
+        _entry.virtual_speedup = _header.virtual_speedup;
+        _entry.reason          = _header.reason;
+        _entry.startup         = _header.startup;
+        _entry.duration        = _header.duration;
+        _entry.progress        = _header.progress;
+        _entry.name.resize(_header.name_size);
+        if(!ifs.read(_entry.name.data(), _header.name_size)) break;
+
+        _entry.offset = static_cast<uint64_t>(ifs.tellg());
+        _entry.size   = _header.payload_size;
+        if(_entry.offset + _entry.size > _end) break;
+
+        ifs.seekg(_entry.size, std::ios::cur);
+        _data.emplace_back(std::move(_entry));
+    }
+
+    return _data;
+}
+
+std::vector<std::string>
+read_payloads(const std::string& _fname, const std::vector<index_entry>& _entries)
+{
+    auto _data = std::vector<std::string>{};
+    auto ifs   = std::ifstream{ _fname, std::ios::in | std::ios::binary };
+    if(!ifs) return _data;
+
+    _data.reserve(_entries.size());
+    for(const auto& itr : _entries)
+    {
+        auto _payload = std::string(itr.size, '\0');
+        ifs.seekg(itr.offset, std::ios::beg);
+        if(!ifs.read(_payload.data(), itr.size))
+        {
+            OMNITRACE_VERBOSE(0,
+                              "Warning! unable to read %zu bytes at offset %zu of '%s'\n",
+                              static_cast<size_t>(itr.size),
+                              static_cast<size_t>(itr.offset), _fname.c_str());
+            ifs.clear();
+            _payload.clear();
+        }
+        _data.emplace_back(std::move(_payload));
+    }
+
+    return _data;
+}
+}  // namespace experiment_log
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace omnitrace
+{
+namespace causal
+{
+/// exclusive advisory lock which serializes reading and writing the causal output
+/// files between the workers sharing the experiments
+struct scoped_file_lock
+{
+    explicit scoped_file_lock(const std::string& _fname);
+    ~scoped_file_lock();
+
+    scoped_file_lock(const scoped_file_lock&) = delete;
+    scoped_file_lock& operator=(const scoped_file_lock&) = delete;
+
+private:
+    int m_fd = -1;
+};
+
+/// append-only binary log of the causal experiments (see OMNITRACE_CAUSAL_LOG). The
+/// file starts with a header and every entry is a fixed-size header which doubles as
+/// the index of the entry, followed by the name of the selection and an opaque
+/// payload (the serialized experiment or process record). The index can be read
+/// without reading any payload. A truncated trailing entry, e.g. from a process which
+/// was killed while writing, is ignored. The data is in the native byte order
+namespace experiment_log
+{
+enum entry_type : uint32_t
+{
+    experiment_entry = 0x50584543,  ///< "CEXP": one completed experiment
+    record_entry     = 0x44524352,  ///< "RCRD": the runtime and samples of a process
+};
+
+struct index_entry
+{
+    entry_type  type            = experiment_entry;
+    uint16_t    virtual_speedup = 0;
+    uint16_t    reason          = 0;
+    int64_t     startup         = 0;   ///< identifies the process
+    uint64_t    duration        = 0;   ///< runtime - delays [nsec]
+    double      progress        = 0;   ///< sum of the progress point deltas
+    std::string name            = {};  ///< name of the selection
+    uint64_t    offset          = 0;   ///< position of the payload in the file
+    uint64_t    size            = 0;   ///< size of the payload
+};
+
+/// appends an entry. The caller must hold the lock of the causal output files
+bool
+append(const std::string& _fname, const index_entry&, std::string_view _payload);
+
+/// reads the index of every complete entry
+std::vector<index_entry>
+read_index(const std::string& _fname);
+
+/// reads the payloads of the given entries of the index
+std::vector<std::string>
+read_payloads(const std::string& _fname, const std::vector<index_entry>&);
+}  // namespace experiment_log
+}  // namespace causal
+}  // namespace omnitrace
@@ -21,11 +21,17 @@
 // SOFTWARE.
 
 #include "library/causal/sample_data.hpp"
+#include "library/thread_data.hpp"
 
+#include <timemory/backends/threading.hpp>
+
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <set>
+#include <vector>
 
 namespace omnitrace
 {
@@ -33,29 +39,185 @@ namespace causal
 {
 namespace
 {
-auto samples = std::map<uint32_t, std::map<uintptr_t, uint64_t>>{};
+// open-addressing hash table with linear probing which is only written by the owning
+// thread so recording a sample does not lock or touch any shared cache-line. A slot
+// is empty while its count is zero. The capacity is a power of two and the table is
+// replaced by one with twice the capacity when it is half full. The tables are
+// published so that other threads can merge them at any time: a slot is filled before
+// its count is released and a new table is filled before it is released. The replaced
+// tables are kept until the thread data is destroyed since they may still be read
+struct thread_samples
+{
+    static constexpr size_t initial_capacity = 1024;
+
+    struct slot
+    {
+        uintptr_t             address = 0;
+        uint32_t              index   = 0;
+        std::atomic<uint64_t> count   = { 0 };
+    };
+
+    struct table
+    {
+        explicit table(size_t _capacity)
+        : capacity{ _capacity }
+        , slots{ std::make_unique<slot[]>(_capacity) }
+        {}
+
+        size_t                  capacity = 0;
+        std::unique_ptr<slot[]> slots    = {};
+    };
+
+    thread_samples();
+
+    void add(uint32_t _index, uintptr_t _addr, uint64_t _count);
+
+    /// invokes _func(index, address, count) for every sample. May be called by any
+    /// thread while the owning thread records samples
+    template <typename FuncT>
+    void for_each(FuncT&& _func) const;
+
+private:
+    static slot& find(table&, uint32_t _index, uintptr_t _addr);
+
+    void grow();
+
+    size_t                              m_size    = 0;
+    std::atomic<table*>                 m_current = { nullptr };
+    std::vector<std::unique_ptr<table>> m_tables  = {};  // current and replaced
+};
+
+using thread_samples_data = thread_data<thread_samples, sample_data>;
+
+thread_samples::thread_samples()
+{
+    m_tables.emplace_back(std::make_unique<table>(initial_capacity));
+    m_current.store(m_tables.back().get(), std::memory_order_release);
+}
+
+thread_samples::slot&
+thread_samples::find(table& _table, uint32_t _index, uintptr_t _addr)
+{
+    auto _mask = _table.capacity - 1;
+    auto _hash = (_addr ^ (static_cast<uint64_t>(_index) << 48)) * 0x9e3779b97f4a7c15ULL;
+    for(auto i = static_cast<size_t>(_hash >> 32);; ++i)
+    {
+        auto& _slot = _table.slots[i & _mask];
+        if(_slot.count.load(std::memory_order_relaxed) == 0 ||
+           (_slot.address == _addr && _slot.index == _index))
+            return _slot;
+    }
+}
+
+void
+thread_samples::grow()
+{
+    const auto* _prev = m_current.load(std::memory_order_relaxed);
+    auto        _next = std::make_unique<table>(_prev->capacity * 2);
+    for(size_t i = 0; i < _prev->capacity; ++i)
+    {
+        const auto& itr    = _prev->slots[i];
+        auto        _count = itr.count.load(std::memory_order_relaxed);
+        if(_count == 0) continue;
+        auto& _slot   = find(*_next, itr.index, itr.address);
+        _slot.address = itr.address;
+        _slot.index   = itr.index;
+        _slot.count.store(_count, std::memory_order_relaxed);
+    }
+    m_current.store(_next.get(), std::memory_order_release);
+    m_tables.emplace_back(std::move(_next));
+}
+
+void
+thread_samples::add(uint32_t _index, uintptr_t _addr, uint64_t _count)
+{
+    if(_count == 0) return;
+
+    auto* _slot  = &find(*m_current.load(std::memory_order_relaxed), _index, _addr);
+    auto  _value = _slot->count.load(std::memory_order_relaxed);
+    if(_value == 0)
+    {
+        if(2 * (m_size + 1) > m_current.load(std::memory_order_relaxed)->capacity)
+        {
+            grow();
+            _slot = &find(*m_current.load(std::memory_order_relaxed), _index, _addr);
+        }
+        _slot->address = _addr;
+        _slot->index   = _index;
+        ++m_size;
+    }
+    // only the owning thread writes the count so it does not need a read-modify-write
+    _slot->count.store(_value + _count, std::memory_order_release);
+}
+
+template <typename FuncT>
+void
+thread_samples::for_each(FuncT&& _func) const
+{
+    const auto* _table = m_current.load(std::memory_order_acquire);
+    for(size_t i = 0; i < _table->capacity; ++i)
+    {
+        const auto& itr    = _table->slots[i];
+        auto        _count = itr.count.load(std::memory_order_acquire);
+        if(_count > 0) _func(itr.index, itr.address, _count);
+    }
+}
+
+auto&
+get_thread_samples(int64_t _tid = tim::threading::get_id())
+{
+    return thread_samples_data::instance(construct_on_thread{ _tid });
+}
+
+// merges the tables of all the threads. Safe while the threads record samples, e.g.
+// when an experiment fails to start while the samplers are running, in which case
+// the samples recorded during the merge may or may not be included
+std::map<uint32_t, std::map<uintptr_t, uint64_t>>
+merge_samples()
+{
+    auto _data = std::map<uint32_t, std::map<uintptr_t, uint64_t>>{};
+    if(!thread_samples_data::get()) return _data;
+
+    for(const auto& titr : *thread_samples_data::get())
+    {
+        if(!titr) continue;
+        titr->for_each([&_data](uint32_t _index, uintptr_t _addr, uint64_t _count) {
+            _data[_index][_addr] += _count;
+        });
+    }
+    return _data;
 }
 
 std::vector<sample_data>
-get_samples(uint32_t _index)
+get_samples(const std::map<uintptr_t, uint64_t>& _samples)
 {
     auto _data = std::vector<sample_data>{};
-    _data.reserve(samples.at(_index).size());
-    for(const auto& itr : samples.at(_index))
+    _data.reserve(_samples.size());
+    for(const auto& itr : _samples)
     {
         _data.emplace_back(sample_data{ itr.first, itr.second });
     }
     return _data;
 }
+}  // namespace
+
+std::vector<sample_data>
+get_samples(uint32_t _index)
+{
+    auto _samples = merge_samples();
+    auto _itr     = _samples.find(_index);
+    if(_itr == _samples.end()) return std::vector<sample_data>{};
+    return get_samples(_itr->second);
+}
 
 std::map<uint32_t, std::vector<sample_data>>
 get_samples()
 {
     auto _data = std::map<uint32_t, std::vector<sample_data>>{};
 
-    for(const auto& itr : samples)
+    for(const auto& itr : merge_samples())
     {
-        _data[itr.first] = get_samples(itr.first);
+        _data[itr.first] = get_samples(itr.second);
     }
 
     return _data;
@@ -64,7 +226,8 @@ get_samples()
 void
 add_sample(uint32_t _index, uintptr_t _addr, uint64_t _count)
 {
-    samples[_index][_addr] += _count;
+    auto& _v = get_thread_samples();
+    if(_v) _v->add(_index, _addr, _count);
 }
 
 void
@@ -26,7 +26,6 @@
 #include "core/concepts.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
-#include "core/locking.hpp"
 #include "core/state.hpp"
 #include "core/utility.hpp"
 #include "library/causal/components/backtrace.hpp"
@@ -165,8 +164,8 @@ get_causal_sampler(int64_t _tid)
 void
 causal_offload_buffer(int64_t, causal_sampler_buffer_t&& _buf)
 {
-    auto _data      = std::move(_buf);
-    auto _processed = std::map<uint32_t, std::map<uintptr_t, uint64_t>>{};
+    // the samples are recorded in the histogram of the offloading thread
+    auto _data = std::move(_buf);
     while(!_data.is_empty())
     {
         auto _bundle = causal_sampler_bundle_t{};
@@ -179,7 +178,7 @@ causal_offload_buffer(int64_t, causal_sampler_buffer_t&& _buf)
 
             for(auto itr : _stack)
             {
-                if(itr > 0) _processed[_bt_causal->get_index()][itr] += 1;
+                if(itr > 0) add_sample(_bt_causal->get_index(), itr);
             }
         }
 
@@ -192,22 +191,12 @@ causal_offload_buffer(int64_t, causal_sampler_buffer_t&& _buf)
             {
                 for(auto aitr : ditr)
                 {
-                    if(aitr > 0) _processed[_of_causal->get_index()][aitr] += 1;
+                    if(aitr > 0) add_sample(_of_causal->get_index(), aitr);
                 }
             }
         }
     }
     _data.destroy();
-
-    if(!_processed.empty())
-    {
-        static auto _mutex = locking::atomic_mutex{};
-        auto        _lk    = locking::atomic_lock{ _mutex };
-        for(const auto& itr : _processed)
-        {
-            add_samples(itr.first, itr.second);
-        }
-    }
 }
 
 std::set<int>
@@ -0,0 +1,426 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/causal/selection_policy.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/utility.hpp"
+#include "library/causal/experiment.hpp"
+
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace selection_policy
+{
+namespace
+{
+// two-sided 95% confidence interval
+constexpr double z_value = 1.96;
+
+// running mean and sum of squared deviations of the progress rates
+struct group_stats
+{
+    size_t count = 0;
+    double mean  = 0.0;
+    double m2    = 0.0;
+
+    group_stats& operator+=(double _v)
+    {
+        ++count;
+        auto _delta = _v - mean;
+        mean += _delta / count;
+        m2 += _delta * (_v - mean);
+        return *this;
+    }
+};
+
+struct line_stats
+{
+    size_t                          count    = 0;   // non-zero virtual speedups
+    std::map<uint16_t, group_stats> speedups = {};  // keyed by virtual speedup
+};
+
+struct estimate
+{
+    bool   valid      = false;
+    double impact     = 0.0;
+    double half_width = std::numeric_limits<double>::infinity();
+};
+
+// the selection does not change the outcome of an experiment without a virtual
+// speedup so every such experiment contributes to a common baseline
+auto baseline_stats = group_stats{};
+auto lines          = std::unordered_map<std::string, line_stats>{};
+auto noise_cv2      = -1.0;  // pooled variance of the rates relative to the baseline
+auto max_score      = 0.0;   // largest upper bound of the unconverged lines
+auto last_reason    = random_choice;
+auto fallback       = selected_entry{};
+auto fallback_width = -1.0;
+auto fallback_valid = true;
+
+auto&
+get_engine()
+{
+    static auto _v = std::mt19937_64{ std::random_device{}() };
+    return _v;
+}
+
+// progress points per second of the experiment duration (which excludes the delays)
+double
+get_rate(uint64_t _duration, double _progress)
+{
+    if(_duration == 0) return -1.0;
+    return (_progress * units::sec) / _duration;
+}
+
+// least-squares slope (through the origin) of the relative change in the progress
+// rate versus the virtual speedup fraction, weighted by the number of experiments
+estimate
+get_estimate(const line_stats& _v)
+{
+    const auto& _base = baseline_stats;
+    if(_base.count < 2 || _base.mean <= 0.0 || noise_cv2 < 0.0) return estimate{};
+
+    double _num = 0.0;
+    double _den = 0.0;
+    double _var = 0.0;
+    for(const auto& itr : _v.speedups)
+    {
+        auto _n      = static_cast<double>(itr.second.count);
+        auto _x      = itr.first / 100.0;
+        auto _effect = (itr.second.mean - _base.mean) / _base.mean;
+        _num += _n * _x * _effect;
+        _den += _n * _x * _x;
+        _var += _n * _n * _x * _x * noise_cv2 * ((1.0 / _n) + (1.0 / _base.count));
+    }
+
+    if(_den <= 0.0) return estimate{};
+    return estimate{ true, _num / _den, z_value * std::sqrt(_var) / _den };
+}
+
+void
+update_cache()
+{
+    // pooled within-group variance across the baseline and every (line, speedup)
+    double _m2  = baseline_stats.m2;
+    size_t _dof = (baseline_stats.count > 0) ? (baseline_stats.count - 1) : 0;
+    for(const auto& litr : lines)
+    {
+        for(const auto& sitr : litr.second.speedups)
+        {
+            _m2 += sitr.second.m2;
+            _dof += sitr.second.count - 1;
+        }
+    }
+
+    noise_cv2 = (_dof > 0 && baseline_stats.mean > 0.0)
+                    ? (_m2 / _dof) / (baseline_stats.mean * baseline_stats.mean)
+                    : -1.0;
+
+    max_score = 0.0;
+    for(const auto& itr : lines)
+    {
+        auto _est = get_estimate(itr.second);
+        if(_est.valid && _est.half_width >= config::get_causal_adaptive_tolerance())
+            max_score = std::max(max_score, std::abs(_est.impact) + _est.half_width);
+    }
+}
+
+void
+add(const std::string& _name, uint16_t _speedup, double _rate, bool _update)
+{
+    if(_rate < 0.0) return;
+
+    if(_speedup == 0)
+        baseline_stats += _rate;
+    else
+    {
+        auto& _line = lines[_name];
+        _line.speedups[_speedup] += _rate;
+        ++_line.count;
+    }
+
+    if(_update) update_cache();
+}
+
+void
+add(const experiment& _v, bool _update)
+{
+    if(!_v.selection) return;
+    add(get_name(_v.selection), _v.virtual_speedup,
+        get_rate(_v.duration, _v.get_progress()), _update);
+}
+}  // namespace
+
+const char*
+get_name(reason _v)
+{
+    switch(_v)
+    {
+        case random_choice: return "random";
+        case explore: return "explore";
+        case uncertain: return "uncertain";
+        case promising: return "promising";
+        case converged: return "converged";
+        case baseline: return "baseline";
+    }
+    return "unknown";
+}
+
+std::string
+get_name(const selected_entry& _v)
+{
+    return (_v.symbol_address > 0) ? _v.symbol.func
+                                   : JOIN(":", _v.symbol.file, _v.symbol.line);
+}
+
+bool
+enabled()
+{
+    return config::get_causal_adaptive() && !config::get_causal_end_to_end();
+}
+
+void
+setup()
+{
+    if(!enabled()) return;
+
+    size_t _n = 0;
+    try
+    {
+        // the index of the log has everything needed without reading the payloads
+        if(config::get_causal_log())
+        {
+            for(const auto& itr : experiment::load_experiment_index())
+            {
+                if(itr.type != experiment_log::experiment_entry) continue;
+                add(itr.name, itr.virtual_speedup, get_rate(itr.duration, itr.progress),
+                    false);
+                ++_n;
+            }
+        }
+        else
+        {
+            for(const auto& ritr : experiment::load_experiments(false))
+            {
+                for(const auto& itr : ritr.experiments)
+                {
+                    add(itr, false);
+                    ++_n;
+                }
+            }
+        }
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING(0, "[causal] adaptive selection: unable to load the saved "
+                             "experiments: %s\n",
+                          _e.what());
+    }
+    update_cache();
+
+    OMNITRACE_VERBOSE(1,
+                      "[causal] adaptive selection: %zu saved experiments, %zu "
+                      "lines/functions, %zu baseline experiments\n",
+                      _n, lines.size(), baseline_stats.count);
+}
+
+bool
+accept(const selected_entry& _v)
+{
+    auto itr = lines.find(get_name(_v));
+    if(itr == lines.end() ||
+       itr->second.count < config::get_causal_adaptive_min_experiments())
+    {
+        last_reason = explore;
+        return true;
+    }
+
+    auto _est = get_estimate(itr->second);
+    if(!_est.valid)
+    {
+        last_reason = explore;
+        return true;
+    }
+
+    if(_est.half_width < config::get_causal_adaptive_tolerance())
+    {
+        if(_est.half_width > fallback_width)
+        {
+            fallback       = _v;
+            fallback_width = _est.half_width;
+        }
+        return false;
+    }
+
+    // favor the lines with the largest upper bound of the impact magnitude
+    auto _score = std::abs(_est.impact) + _est.half_width;
+    auto _prob  = (max_score > 0.0) ? std::clamp(_score / max_score, 0.1, 1.0) : 1.0;
+    if(std::uniform_real_distribution<double>{ 0.0, 1.0 }(get_engine()) >= _prob)
+    {
+        fallback_valid = false;
+        return false;
+    }
+
+    last_reason = (_est.impact - _est.half_width > 0.0) ? promising : uncertain;
+    return true;
+}
+
+selected_entry
+get_fallback()
+{
+    if(!fallback_valid || !fallback) return selected_entry{};
+    last_reason = converged;
+    return fallback;
+}
+
+void
+reset_fallback()
+{
+    fallback       = selected_entry{};
+    fallback_width = -1.0;
+    fallback_valid = true;
+}
+
+uint16_t
+select_speedup(const selected_entry& _v, const std::vector<uint16_t>& _pool)
+{
+    if(_pool.empty()) return 0;
+
+    // keep the fraction of baseline experiments at the fraction of zeros in the pool
+    auto _nzero =
+        static_cast<size_t>(std::count(_pool.begin(), _pool.end(), uint16_t{ 0 }));
+    auto _total = baseline_stats.count;
+    for(const auto& itr : lines)
+        _total += itr.second.count;
+
+    if(_nzero > 0 && baseline_stats.count * _pool.size() < _nzero * (_total + 1))
+    {
+        last_reason = baseline;
+        return 0;
+    }
+
+    // otherwise, the virtual speedup with the fewest experiments for the selection
+    auto        _candidates = std::vector<uint16_t>{};
+    auto        _min_count  = std::numeric_limits<size_t>::max();
+    auto        itr         = lines.find(get_name(_v));
+    const auto* _line       = (itr != lines.end()) ? &itr->second : nullptr;
+    for(auto sitr : _pool)
+    {
+        if(sitr == 0 || std::count(_candidates.begin(), _candidates.end(), sitr) > 0)
+            continue;
+
+        size_t _count = 0;
+        if(_line && _line->speedups.count(sitr) > 0)
+            _count = _line->speedups.at(sitr).count;
+
+        if(_count < _min_count)
+        {
+            _candidates.clear();
+            _min_count = _count;
+        }
+        if(_count == _min_count) _candidates.emplace_back(sitr);
+    }
+
+    if(_candidates.empty()) return 0;
+    auto _dist = std::uniform_int_distribution<size_t>{ 0, _candidates.size() - 1 };
+    return _candidates.at(_dist(get_engine()));
+}
+
+reason
+get_reason()
+{
+    return (enabled()) ? last_reason : random_choice;
+}
+
+void
+update(const experiment& _v)
+{
+    if(!enabled()) return;
+
+    add(_v, true);
+
+    if(get_verbose() >= 2)
+    {
+        auto itr = lines.find(get_name(_v.selection));
+        if(itr == lines.end()) return;
+        auto _est = get_estimate(itr->second);
+        OMNITRACE_VERBOSE(2,
+                          "[causal] adaptive selection: %s :: %zu experiments :: impact "
+                          "= %.3f +/- %.3f\n",
+                          get_name(_v.selection).c_str(), itr->second.count,
+                          _est.impact, _est.half_width);
+    }
+}
+
+void
+save_status()
+{
+    auto _fname = config::get_causal_adaptive_status();
+    if(!enabled() || _fname.empty()) return;
+
+    if(config::get_causal_num_workers() > 1)
+        _fname = JOIN('.', _fname, config::get_causal_worker_id());
+
+    size_t _converged = 0;
+    double _max_width = 0.0;
+    auto   _tolerance = config::get_causal_adaptive_tolerance();
+    auto   _min_count = config::get_causal_adaptive_min_experiments();
+    for(const auto& itr : lines)
+    {
+        auto _est = get_estimate(itr.second);
+        if(!_est.valid) continue;
+        if(itr.second.count >= _min_count && _est.half_width < _tolerance) ++_converged;
+        _max_width = std::max(_max_width, _est.half_width);
+    }
+
+    auto _ofs = std::ofstream{ _fname };
+    if(!_ofs)
+    {
+        OMNITRACE_WARNING(0, "[causal] unable to write the adaptive status to %s\n",
+                          _fname.c_str());
+        return;
+    }
+
+    _ofs << "selections " << lines.size() << "\n"
+         << "converged " << _converged << "\n"
+         << "baseline " << baseline_stats.count << "\n"
+         << "max_half_width " << _max_width << "\n";
+}
+}  // namespace selection_policy
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "library/causal/fwd.hpp"
+#include "library/causal/selected_entry.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace causal
+{
+struct experiment;
+
+/// adaptive selection of the causal experiments (see OMNITRACE_CAUSAL_ADAPTIVE). The
+/// impact of a line/function is estimated as the slope of the relative change in the
+/// progress rate versus the virtual speedup, using all the experiments with a zero
+/// virtual speedup as the baseline. Lines/functions are favored in proportion to the
+/// upper bound of the 95% confidence interval of their impact and retired once the
+/// half-width of the interval is below OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE. These
+/// functions are only called from the thread performing the experiments
+namespace selection_policy
+{
+enum reason : uint8_t
+{
+    random_choice = 0,  ///< adaptive selection is disabled
+    explore,            ///< not enough experiments to estimate the impact
+    uncertain,          ///< impact is not significantly different from zero
+    promising,          ///< impact is significantly positive but has not converged
+    converged,          ///< every candidate has converged, selected the widest interval
+    baseline,           ///< zero virtual speedup to refine the baseline progress rate
+};
+
+const char* get_name(reason);
+
+/// the name of the selection in the causal output, i.e. the function name in function
+/// mode or "<file>:<line>" in line mode
+std::string
+get_name(const selected_entry&);
+
+bool
+enabled();
+
+/// loads the previously saved experiments
+void
+setup();
+
+/// whether a candidate of sample_selection() should be used. Candidates which have
+/// converged are rejected but the one with the widest interval is kept as a fallback
+bool
+accept(const selected_entry&);
+
+/// the selection to use when all the candidates were rejected (may be empty)
+selected_entry
+get_fallback();
+
+/// resets the fallback before a new selection
+void
+reset_fallback();
+
+/// the virtual speedup for the selection from the pool of virtual speedups
+uint16_t
+select_speedup(const selected_entry&, const std::vector<uint16_t>& _pool);
+
+/// why the most recent selection (and speedup) was made
+reason
+get_reason();
+
+/// adds the result of a completed experiment
+void
+update(const experiment&);
+
+/// writes the number of lines/functions and how many of them have converged to
+/// OMNITRACE_CAUSAL_ADAPTIVE_STATUS (if set) for omnitrace-causal --converge
+void
+save_status();
+}  // namespace selection_policy
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,299 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/columnar_output.hpp"
+#include "core/components/fwd.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/trip_count/extern.hpp>
+#include <timemory/hash.hpp>
+#include <timemory/mpl/type_traits.hpp>
+#include <timemory/storage.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/type_list.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace columnar_output
+{
+namespace
+{
+template <typename... Tp>
+using type_list = tim::type_list<Tp...>;
+
+// timemory components with a scalar value, including the call-graphs of the samples
+using component_types_t =
+    type_list<comp::wall_clock, comp::cpu_clock, comp::cpu_util, comp::user_clock,
+              comp::system_clock, comp::thread_cpu_clock, comp::process_cpu_clock,
+              comp::peak_rss, comp::page_rss, comp::trip_count,
+              component::sampling_wall_clock, component::sampling_cpu_clock,
+              component::sampling_percent, component::sampling_gpu_busy,
+              component::sampling_gpu_memory, component::sampling_gpu_power,
+              component::sampling_gpu_temp>;
+
+struct file_header
+{
+    char     magic[8]       = { 'O', 'M', 'N', 'I', 'C', 'O', 'L', '\0' };
+    uint32_t version        = columnar_output::version;
+    uint32_t num_tables     = 0;
+    uint64_t num_strings    = 0;
+    uint64_t strings_offset = 0;
+    uint64_t tables_offset  = 0;
+};
+
+enum column : uint32_t
+{
+    name_column = 0,
+    depth_column,
+    parent_column,
+    laps_column,
+    value_column,
+    num_columns
+};
+
+struct table_entry
+{
+    uint32_t label                = 0;
+    uint32_t unit                 = 0;
+    uint64_t num_rows             = 0;
+    uint64_t columns[num_columns] = {};
+};
+
+// the layouts are part of the format
+static_assert(sizeof(file_header) == 40, "unexpected size of the file header");
+static_assert(sizeof(table_entry) == 56, "unexpected size of the table entries");
+
+struct table
+{
+    uint32_t              label  = 0;
+    uint32_t              unit   = 0;
+    std::vector<uint32_t> name   = {};
+    std::vector<uint32_t> depth  = {};
+    std::vector<int64_t>  parent = {};
+    std::vector<uint64_t> laps   = {};
+    std::vector<double>   value  = {};
+};
+
+// the names of the nodes of every component are in one table since the components
+// mostly measure the same regions
+struct string_table
+{
+    uint32_t get(const std::string& _v)
+    {
+        auto itr = indexes.find(_v);
+        if(itr != indexes.end()) return itr->second;
+        auto _idx = static_cast<uint32_t>(values.size());
+        values.emplace_back(_v);
+        indexes.emplace(_v, _idx);
+        return _idx;
+    }
+
+    std::vector<std::string>                  values  = {};
+    std::unordered_map<std::string, uint32_t> indexes = {};
+};
+
+template <typename Tp>
+void
+collect(std::vector<table>& _tables, string_table& _strings)
+{
+    if constexpr(tim::trait::is_available<Tp>::value)
+    {
+        auto* _storage = tim::storage<Tp>::noninit_master_instance();
+        if(!_storage) return;
+
+        _storage->merge();
+        if(_storage->empty()) return;
+
+        auto _data  = _storage->get();
+        auto _table = table{};
+        auto _stack = std::vector<int64_t>{};  // the last row at each depth
+
+        _table.label = _strings.get(Tp::get_label());
+        _table.unit  = _strings.get(Tp::get_display_unit());
+        _table.name.reserve(_data.size());
+        _table.depth.reserve(_data.size());
+        _table.parent.reserve(_data.size());
+        _table.laps.reserve(_data.size());
+        _table.value.reserve(_data.size());
+
+        for(const auto& itr : _data)
+        {
+            auto _depth = static_cast<size_t>(std::max<int64_t>(itr.depth(), 0));
+            auto _row   = static_cast<int64_t>(_table.name.size());
+            _stack.resize(_depth);
+            _table.name.emplace_back(
+                _strings.get(std::string{ tim::get_hash_identifier_fast(itr.hash()) }));
+            _table.depth.emplace_back(static_cast<uint32_t>(_depth));
+            _table.parent.emplace_back((_stack.empty()) ? -1 : _stack.back());
+            _table.laps.emplace_back(itr.data().get_laps());
+            _table.value.emplace_back(static_cast<double>(itr.data().get()));
+            _stack.emplace_back(_row);
+        }
+
+        _tables.emplace_back(std::move(_table));
+    }
+}
+
+template <typename... Tp>
+void
+collect(std::vector<table>& _tables, string_table& _strings, type_list<Tp...>)
+{
+    (collect<Tp>(_tables, _strings), ...);
+}
+
+uint64_t
+align(uint64_t _v)
+{
+    return (_v + 7) & ~uint64_t{ 7 };
+}
+
+// the offsets of every section are computed first so the file is written in one pass
+void
+write(const std::string& _fname, const std::vector<table>& _tables,
+      const string_table& _strings)
+{
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname, std::ios::out | std::ios::binary))
+    {
+        OMNITRACE_THROW("Error opening columnar output file: %s", _fname.c_str());
+    }
+
+    auto _header        = file_header{};
+    _header.num_tables  = static_cast<uint32_t>(_tables.size());
+    _header.num_strings = _strings.values.size();
+
+    auto _offset           = align(sizeof(file_header));
+    auto _string_offsets   = std::vector<uint64_t>{};
+    auto _string_data_size = uint64_t{ 0 };
+    _string_offsets.reserve(_strings.values.size() + 1);
+    for(const auto& itr : _strings.values)
+    {
+        _string_offsets.emplace_back(_string_data_size);
+        _string_data_size += itr.length();
+    }
+    _string_offsets.emplace_back(_string_data_size);
+
+    _header.strings_offset = _offset;
+    _offset += align(_string_offsets.size() * sizeof(uint64_t) + _string_data_size);
+    _header.tables_offset = _offset;
+    _offset += align(_tables.size() * sizeof(table_entry));
+
+    auto _entries = std::vector<table_entry>{};
+    for(const auto& itr : _tables)
+    {
+        auto _entry     = table_entry{};
+        auto _n         = itr.name.size();
+        _entry.label    = itr.label;
+        _entry.unit     = itr.unit;
+        _entry.num_rows = _n;
+        for(auto citr : { std::make_pair(name_column, sizeof(uint32_t)),
+                          std::make_pair(depth_column, sizeof(uint32_t)),
+                          std::make_pair(parent_column, sizeof(int64_t)),
+                          std::make_pair(laps_column, sizeof(uint64_t)),
+                          std::make_pair(value_column, sizeof(double)) })
+        {
+            _entry.columns[citr.first] = _offset;
+            _offset += align(_n * citr.second);
+        }
+        _entries.emplace_back(_entry);
+    }
+
+    auto _pos   = uint64_t{ 0 };
+    auto _write = [&ofs, &_pos](const void* _v, size_t _n) {
+        ofs.write(static_cast<const char*>(_v), _n);
+        _pos += _n;
+    };
+    auto _pad = [&ofs, &_pos]() {
+        constexpr char _zeros[8] = {};
+        ofs.write(_zeros, align(_pos) - _pos);
+        _pos = align(_pos);
+    };
+    auto _write_column = [&_write, &_pad](const auto& _v) {
+        _write(_v.data(), _v.size() * sizeof(_v.front()));
+        _pad();
+    };
+
+    _write(&_header, sizeof(_header));
+    _pad();
+    _write(_string_offsets.data(), _string_offsets.size() * sizeof(uint64_t));
+    for(const auto& itr : _strings.values)
+        _write(itr.data(), itr.length());
+    _pad();
+    _write(_entries.data(), _entries.size() * sizeof(table_entry));
+    _pad();
+    for(const auto& itr : _tables)
+    {
+        _write_column(itr.name);
+        _write_column(itr.depth);
+        _write_column(itr.parent);
+        _write_column(itr.laps);
+        _write_column(itr.value);
+    }
+
+    OMNITRACE_CI_THROW(_pos != _offset, "columnar output size mismatch: %zu vs. %zu\n",
+                       static_cast<size_t>(_pos), static_cast<size_t>(_offset));
+}
+}  // namespace
+
+void
+post_process()
+{
+    auto _tables  = std::vector<table>{};
+    auto _strings = string_table{};
+
+    collect(_tables, _strings, component_types_t{});
+
+    if(_tables.empty()) return;
+
+    size_t _rows = 0;
+    for(const auto& itr : _tables)
+        _rows += itr.name.size();
+
+    OMNITRACE_VERBOSE(1, "Writing the columnar output of %zu call-graph nodes...\n",
+                      _rows);
+
+    try
+    {
+        auto _fname = tim::settings::compose_output_filename("profile", ".columnar");
+        write(_fname, _tables, _strings);
+        if(get_verbose() >= 0)
+            operation::file_output_message<table>{}(_fname,
+                                                    std::string{ "columnar_output" });
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "writing the columnar output failed: %s\n", _e.what());
+    }
+}
+}  // namespace columnar_output
+}  // namespace omnitrace
@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+namespace omnitrace
+{
+/// columnar binary output of the timemory call-graphs of the profiling and sampling
+/// components (see OMNITRACE_COLUMNAR_OUTPUT). Each rank writes one file holding a
+/// string table shared by all the components and, per component, a table of the
+/// call-graph nodes with one contiguous column per field so the file can be memory
+/// mapped and used without parsing. See source/python/omnitrace/columnar.py
+namespace columnar_output
+{
+/// the layout of the file. All the sections are aligned to 8 bytes and the offsets are
+/// from the start of the file:
+///
+///     header      : magic "OMNICOL\0", version, number of tables, number of strings,
+///                   offset of the string table, and offset of the table directory
+///     strings     : uint64 offsets[N + 1] into the character data, then the data
+///     directory   : one entry per table: label and unit (string indexes), number of
+///                   rows, and the offset of each column
+///     columns     : name (uint32 string index), depth (uint32), parent (int64, -1 for
+///                   the roots), laps (uint64), and value (float64) of each node
+///
+/// The values are in the display unit of the component and summed over the threads
+constexpr unsigned version = 1;
+
+/// merges the thread data of the supported timemory components and writes the
+/// profile.columnar file of this rank. Must be called before tim::timemory_finalize
+void
+post_process();
+}  // namespace columnar_output
+}  // namespace omnitrace
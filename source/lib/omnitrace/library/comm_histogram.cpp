@@ -0,0 +1,409 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/comm_histogram.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/mpi_reduce.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+
+#include <array>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace omnitrace
+{
+namespace comm_histogram
+{
+namespace
+{
+struct entry
+{
+    uint64_t                          bytes   = 0;
+    uint64_t                          count   = 0;
+    buckets_t::array_type             buckets = {};
+
+    entry& operator+=(const entry& _rhs)
+    {
+        bytes += _rhs.bytes;
+        count += _rhs.count;
+        buckets_t::merge(buckets, _rhs.buckets);
+        return *this;
+    }
+};
+
+struct thread_key
+{
+    std::string_view op   = {};
+    uintptr_t        comm = 0;
+    int32_t          peer = -1;
+
+    bool operator==(const thread_key& _rhs) const
+    {
+        return std::tie(op, comm, peer) == std::tie(_rhs.op, _rhs.comm, _rhs.peer);
+    }
+};
+
+struct thread_key_hash
+{
+    size_t operator()(const thread_key& _v) const
+    {
+        return std::hash<std::string_view>{}(_v.op) ^
+               (std::hash<uintptr_t>{}(_v.comm) << 1) ^
+               (std::hash<int32_t>{}(_v.peer) << 2);
+    }
+};
+
+struct thread_histogram
+{
+    std::unordered_map<thread_key, entry, thread_key_hash> data  = {};
+    std::unordered_set<uintptr_t>                          comms = {};
+};
+
+using thread_histogram_data = omnitrace::thread_data<thread_histogram, thread_histogram>;
+
+// reduced across the threads and ranks. The traffic is keyed by the rank in
+// MPI_COMM_WORLD since the ranks within the other communicators are not unique
+using histogram_key = std::tuple<std::string, std::string>;       // comm, op
+using traffic_key   = std::tuple<std::string, int32_t, int32_t>;  // comm, rank, peer
+
+struct traffic_entry
+{
+    uint64_t bytes = 0;
+    uint64_t count = 0;
+};
+
+struct reduced_data
+{
+    std::map<histogram_key, entry>       histograms = {};
+    std::map<traffic_key, traffic_entry> traffic    = {};
+
+    reduced_data& operator+=(const reduced_data& _rhs)
+    {
+        for(const auto& itr : _rhs.histograms)
+            histograms[itr.first] += itr.second;
+        for(const auto& itr : _rhs.traffic)
+        {
+            auto& _v = traffic[itr.first];
+            _v.bytes += itr.second.bytes;
+            _v.count += itr.second.count;
+        }
+        return *this;
+    }
+};
+
+auto&
+get_thread_histogram(int64_t _tid = tim::threading::get_id())
+{
+    return thread_histogram_data::instance(construct_on_thread{ _tid });
+}
+
+auto&
+get_comm_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_comms()
+{
+    static auto _v = std::unordered_map<uintptr_t, comm_info>{};
+    return _v;
+}
+
+// one line per entry with tab-separated fields. Communicator labels and operation
+// names do not contain tabs or newlines
+mpi_reduce::buffer_t
+serialize(const reduced_data& _data)
+{
+    auto _ss = std::stringstream{};
+    for(const auto& itr : _data.histograms)
+    {
+        _ss << "H\t" << std::get<0>(itr.first) << '\t' << std::get<1>(itr.first) << '\t'
+            << itr.second.bytes << '\t' << itr.second.count;
+        for(auto bitr : itr.second.buckets)
+            _ss << '\t' << bitr;
+        _ss << '\n';
+    }
+    for(const auto& itr : _data.traffic)
+    {
+        _ss << "T\t" << std::get<0>(itr.first) << '\t' << std::get<1>(itr.first) << '\t'
+            << std::get<2>(itr.first) << '\t' << itr.second.bytes << '\t'
+            << itr.second.count << '\n';
+    }
+    auto _str = _ss.str();
+    return mpi_reduce::buffer_t{ _str.begin(), _str.end() };
+}
+
+reduced_data
+deserialize(const mpi_reduce::buffer_t& _data)
+{
+    auto _v    = reduced_data{};
+    auto _ss   = std::istringstream{ std::string{ _data.begin(), _data.end() } };
+    auto _line = std::string{};
+    while(std::getline(_ss, _line))
+    {
+        auto _fields = std::vector<std::string>{};
+        auto _ls     = std::istringstream{ _line };
+        auto _field  = std::string{};
+        while(std::getline(_ls, _field, '\t'))
+            _fields.emplace_back(_field);
+
+        if(_fields.size() == 5 + num_buckets && _fields.at(0) == "H")
+        {
+            auto& _entry = _v.histograms[histogram_key{ _fields.at(1), _fields.at(2) }];
+            _entry.bytes += std::stoull(_fields.at(3));
+            _entry.count += std::stoull(_fields.at(4));
+            for(size_t i = 0; i < num_buckets; ++i)
+                _entry.buckets[i] += std::stoull(_fields.at(5 + i));
+        }
+        else if(_fields.size() == 6 && _fields.at(0) == "T")
+        {
+            auto _key    = traffic_key{ _fields.at(1), std::stoi(_fields.at(2)),
+                                     std::stoi(_fields.at(3)) };
+            auto& _entry = _v.traffic[_key];
+            _entry.bytes += std::stoull(_fields.at(4));
+            _entry.count += std::stoull(_fields.at(5));
+        }
+        else
+        {
+            OMNITRACE_CI_THROW(true, "Invalid comm_histogram entry: '%s'\n",
+                               _line.c_str());
+        }
+    }
+    return _v;
+}
+
+void
+write_text(const reduced_data& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("comm_histogram", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening comm_histogram output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<comm_info>{}(_fname,
+                                                    std::string{ "comm_histogram" });
+
+    for(const auto& itr : _data.histograms)
+    {
+        ofs << std::get<0>(itr.first) << " :: " << std::get<1>(itr.first) << " :: "
+            << itr.second.count << " messages, " << itr.second.bytes << " bytes\n";
+        for(size_t i = 0; i < num_buckets; ++i)
+        {
+            if(itr.second.buckets[i] == 0) continue;
+            ofs << "    " << std::setw(28) << std::left << buckets_t::get_bucket_label(i)
+                << std::right << " bytes : " << std::setw(12) << itr.second.buckets[i]
+                << "\n";
+        }
+        ofs << "\n";
+    }
+
+    std::string _last = {};
+    for(const auto& itr : _data.traffic)
+    {
+        const auto& _comm = std::get<0>(itr.first);
+        if(_comm != _last) ofs << _comm << " :: traffic (rank -> peer)\n";
+        _last = _comm;
+
+        auto _peer = std::get<2>(itr.first);
+        ofs << "    " << std::setw(8) << std::get<1>(itr.first) << " -> " << std::setw(8)
+            << ((_peer < 0) ? std::string{ "all" } : std::to_string(_peer)) << " : "
+            << std::setw(16) << itr.second.bytes << " bytes in " << std::setw(12)
+            << itr.second.count << " messages\n";
+    }
+}
+
+void
+write_json(const reduced_data& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        auto _bounds = std::vector<uint64_t>{};
+        for(size_t i = 0; i < num_buckets; ++i)
+            _bounds.emplace_back(buckets_t::get_bucket_begin(i));
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("comm_histogram");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("bucket_lower_bounds", _bounds));
+
+        ar->setNextName("histograms");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.histograms)
+        {
+            const auto& _b       = itr.second.buckets;
+            auto        _buckets = std::vector<uint64_t>{ _b.begin(), _b.end() };
+            ar->startNode();
+            (*ar)(cereal::make_nvp("comm", std::get<0>(itr.first)),
+                  cereal::make_nvp("op", std::get<1>(itr.first)),
+                  cereal::make_nvp("bytes", itr.second.bytes),
+                  cereal::make_nvp("count", itr.second.count),
+                  cereal::make_nvp("buckets", _buckets));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->setNextName("traffic");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.traffic)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("comm", std::get<0>(itr.first)),
+                  cereal::make_nvp("rank", std::get<1>(itr.first)),
+                  cereal::make_nvp("peer", std::get<2>(itr.first)),
+                  cereal::make_nvp("bytes", itr.second.bytes),
+                  cereal::make_nvp("count", itr.second.count));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("comm_histogram", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening comm_histogram output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<comm_info>{}(_fname,
+                                                    std::string{ "comm_histogram" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+bool
+is_registered(uintptr_t _comm)
+{
+    const auto& _v = get_thread_histogram();
+    return (_v && _v->comms.count(_comm) > 0);
+}
+
+void
+register_comm(uintptr_t _comm, comm_info _info)
+{
+    auto& _v = get_thread_histogram();
+    if(!_v) _v = std::make_unique<thread_histogram>();
+    _v->comms.emplace(_comm);
+
+    auto _lk = std::unique_lock<std::mutex>{ get_comm_mutex() };
+    get_comms().emplace(_comm, std::move(_info));
+}
+
+void
+record(std::string_view _op, uintptr_t _comm, int32_t _peer, uint64_t _bytes)
+{
+    auto& _v = get_thread_histogram();
+    if(!_v) _v = std::make_unique<thread_histogram>();
+
+    auto& _entry = _v->data[thread_key{ _op, _comm, _peer }];
+    _entry.bytes += _bytes;
+    _entry.count += 1;
+    buckets_t::add(_entry.buckets, _bytes);
+}
+
+void
+post_process()
+{
+    auto _data = reduced_data{};
+    auto _rank = static_cast<int32_t>(dmp::rank());
+
+    if(thread_histogram_data::get())
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_comm_mutex() };
+        for(auto& titr : *thread_histogram_data::get())
+        {
+            if(!titr) continue;
+            for(const auto& itr : titr->data)
+            {
+                auto _citr  = get_comms().find(itr.first.comm);
+                auto _label = (_citr != get_comms().end()) ? _citr->second.label
+                                                           : std::string{ "unknown" };
+                auto _op    = std::string{ itr.first.op };
+                _data.histograms[histogram_key{ _label, _op }] += itr.second;
+                auto  _key     = traffic_key{ _label, _rank, itr.first.peer };
+                auto& _traffic = _data.traffic[_key];
+                _traffic.bytes += itr.second.bytes;
+                _traffic.count += itr.second.count;
+            }
+            titr.reset();
+        }
+    }
+
+    bool _reduced = false;
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    {
+        auto _buffer = serialize(_data);
+        _reduced     = mpi_reduce::hierarchical(
+            _buffer, [](mpi_reduce::buffer_t& _dst, mpi_reduce::buffer_t&& _src) {
+                auto _v = deserialize(_dst);
+                _v += deserialize(_src);
+                _dst = serialize(_v);
+            });
+        if(_reduced) _data = deserialize(_buffer);
+    }
+#endif
+
+    // every rank writes its own file when the data could not be reduced
+    if(_reduced && _rank != 0) return;
+
+    OMNITRACE_VERBOSE(1,
+                      "Writing %zu message-size histograms and %zu traffic entries...\n",
+                      _data.histograms.size(), _data.traffic.size());
+
+    auto _get_setting = [](const std::string& _v) {
+        auto&& _b = config::get_setting_value<bool>(_v);
+        OMNITRACE_CI_THROW(!_b, "Error! No configuration setting named '%s'", _v.c_str());
+        return _b.value_or(true);
+    };
+
+    if(_get_setting("OMNITRACE_TEXT_OUTPUT")) write_text(_data);
+    if(_get_setting("OMNITRACE_JSON_OUTPUT")) write_json(_data);
+}
+}  // namespace comm_histogram
+}  // namespace omnitrace
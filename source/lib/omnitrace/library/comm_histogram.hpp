@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/containers/log2_buckets.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+/// log2-bucketed message-size histograms and traffic matrices of the MPI and RCCL
+/// communication intercepted by component::comm_data (see OMNITRACE_COMM_HISTOGRAM).
+/// The entries are accumulated per thread without locking and are reduced across the
+/// threads and then across the ranks at finalization so only one file is written
+namespace comm_histogram
+{
+/// bucket N > 0 counts the messages of [2^(N-1), 2^N) bytes, bucket 0 counts the
+/// empty messages and the last bucket also counts all the larger messages
+using buckets_t = container::log2_buckets<32>;
+
+static constexpr size_t num_buckets = buckets_t::num_buckets;
+
+inline size_t
+get_bucket(uint64_t _bytes)
+{
+    return buckets_t::get_bucket(_bytes);
+}
+
+/// identifies a communicator across the ranks since the handles are process-local
+struct comm_info
+{
+    std::string label = {};  // e.g. MPI_COMM_WORLD or the name of the communicator
+    int32_t     rank  = 0;
+    int32_t     size  = 0;
+};
+
+/// returns true if the communicator handle has been registered by this thread
+bool
+is_registered(uintptr_t _comm);
+
+/// registers the communicator handle for this process. Must be called before
+/// the first record() of the handle
+void
+register_comm(uintptr_t _comm, comm_info _info);
+
+/// records a message of the operation (e.g. MPI_Isend) with a peer, i.e. the
+/// destination/source/root rank within the communicator or -1 for collectives
+/// without a single peer. The operation name must outlive the finalization
+void
+record(std::string_view _op, uintptr_t _comm, int32_t _peer, uint64_t _bytes);
+
+/// reduces the histograms and traffic matrices across threads and ranks and
+/// writes comm_histogram.{txt,json} on rank 0. Collective over all the ranks
+void
+post_process();
+}  // namespace comm_histogram
+}  // namespace omnitrace
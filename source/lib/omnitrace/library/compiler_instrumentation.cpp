@@ -0,0 +1,952 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/compiler_instrumentation.hpp"
+#include "api.hpp"
+#include "binary/analysis.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "library/components/category_region.hpp"
+#include "library/fork_capture.hpp"
+#include "library/perf_counters.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <elf.h>
+#include <exception>
+#include <fcntl.h>
+#include <link.h>
+#include <map>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#if !defined(MAP_FIXED_NOREPLACE)
+#    define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#if defined(__x86_64__)
+extern "C" void
+omnitrace_patch_entry_trampoline() OMNITRACE_HIDDEN_API;
+
+extern "C" void
+omnitrace_patch_exit_trampoline() OMNITRACE_HIDDEN_API;
+
+extern "C" void
+omnitrace_patch_enter(uintptr_t, uintptr_t*) OMNITRACE_HIDDEN_API;
+
+extern "C" uintptr_t
+omnitrace_patch_exit(uintptr_t) OMNITRACE_HIDDEN_API;
+#endif
+
+namespace omnitrace
+{
+namespace compiler_instrumentation
+{
+namespace
+{
+enum function_state : uint8_t
+{
+    FUNCTION_UNRESOLVED = 0,
+    FUNCTION_EXCLUDED,
+    FUNCTION_INCLUDED
+};
+
+// the key is the address passed to the hooks (or the address of the patched sled) and
+// the region is written once before the state is published
+struct function_entry
+{
+    std::atomic<uintptr_t> address = { 0 };
+    std::atomic<uint8_t>   state   = { FUNCTION_UNRESOLVED };
+    tracing::region_handle region  = {};
+};
+
+// open-addressing table which is never resized so that the lookups do not lock. The
+// insertions stop at three-quarters of the capacity to keep the probe sequences short
+constexpr size_t function_table_bits = 16;
+constexpr size_t max_functions       = (1 << function_table_bits);
+constexpr size_t max_function_load   = (3 * max_functions) / 4;
+
+auto&
+get_function_table()
+{
+    static auto* _v = new std::array<function_entry, max_functions>{};
+    return *_v;
+}
+
+auto&
+get_function_count()
+{
+    static auto _v = std::atomic<size_t>{ 0 };
+    return _v;
+}
+
+auto&
+get_enabled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+struct function_filters
+{
+    std::optional<std::regex> include = {};
+    std::optional<std::regex> exclude = {};
+};
+
+std::optional<std::regex>
+get_regex_or(const std::vector<std::string>& _v)
+{
+    if(_v.empty()) return std::optional<std::regex>{};
+
+    auto _pattern = std::string{};
+    for(const auto& itr : _v)
+        _pattern += ((_pattern.empty()) ? "(" : "|(") + itr + ")";
+    return std::regex{ _pattern, std::regex_constants::optimize };
+}
+
+const auto&
+get_function_filters()
+{
+    static auto _v =
+        function_filters{ get_regex_or(config::get_compiler_instrumentation_include()),
+                          get_regex_or(config::get_compiler_instrumentation_exclude()) };
+    return _v;
+}
+
+bool
+is_selected(const std::string& _name)
+{
+    if(_name.empty()) return false;
+
+    const auto& _filters = get_function_filters();
+    if(_filters.include && !std::regex_search(_name, *_filters.include)) return false;
+    if(_filters.exclude && std::regex_search(_name, *_filters.exclude)) return false;
+    return true;
+}
+
+void
+resolve(function_entry& _entry, uintptr_t _addr)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _name = std::string{};
+    if(auto _v = binary::lookup_ipaddr_entry<true>(_addr); _v) _name = _v->name;
+
+    auto _state = FUNCTION_EXCLUDED;
+    if(is_selected(_name))
+    {
+        auto _hash    = tim::add_hash_id(_name);
+        _entry.region = { _hash, tim::get_hash_identifier_fast(_hash) };
+        _state        = FUNCTION_INCLUDED;
+    }
+
+    OMNITRACE_VERBOSE(3, "[compiler_instrumentation] %s '%s' (%p)\n",
+                      (_state == FUNCTION_INCLUDED) ? "including" : "excluding",
+                      _name.c_str(), reinterpret_cast<void*>(_addr));
+    _entry.state.store(_state, std::memory_order_release);
+}
+
+// returns the entry of the function, resolving it on the first lookup. While another
+// thread resolves the function, the entry is returned in the unresolved state
+function_entry*
+find_function(uintptr_t _addr)
+{
+    auto& _table = get_function_table();
+    auto  _idx   = (_addr * 0x9E3779B97F4A7C15ULL) >> (64 - function_table_bits);
+    for(size_t i = 0; i < max_functions; ++i, _idx = (_idx + 1) % max_functions)
+    {
+        auto& _entry = _table[_idx];
+        auto  _value = _entry.address.load(std::memory_order_acquire);
+        if(_value == _addr) return &_entry;
+        if(_value != 0) continue;
+
+        auto& _count = get_function_count();
+        if(_count.fetch_add(1, std::memory_order_relaxed) >= max_function_load)
+        {
+            _count.fetch_sub(1, std::memory_order_relaxed);
+            static auto _once = std::once_flag{};
+            std::call_once(_once, []() {
+                OMNITRACE_WARNING(0,
+                                  "[compiler_instrumentation] the functions beyond the "
+                                  "first %zu are not recorded\n",
+                                  max_function_load);
+            });
+            return nullptr;
+        }
+
+        if(_entry.address.compare_exchange_strong(_value, _addr,
+                                                  std::memory_order_acq_rel))
+        {
+            resolve(_entry, _addr);
+            return &_entry;
+        }
+
+        // another thread claimed the slot
+        _count.fetch_sub(1, std::memory_order_relaxed);
+        if(_value == _addr) return &_entry;
+    }
+    return nullptr;
+}
+
+// the functions on the call-stack of the thread. The entries of the patched functions
+// also hold the location and the value of the return address which was replaced
+struct call_entry
+{
+    uintptr_t             function = 0;
+    uintptr_t*            slot     = nullptr;
+    uintptr_t             ret      = 0;
+    tracing::region_token token    = {};
+};
+
+struct call_stack
+{
+    std::vector<call_entry> entries = {};
+};
+
+using call_stack_data = omnitrace::thread_data<call_stack, call_stack>;
+
+// the thread-data outlives the thread-local objects, i.e. the hooks may be invoked by
+// the functions called after the destructors of the thread-local objects have run
+call_stack*
+get_call_stack()
+{
+    static thread_local auto* _v =
+        call_stack_data::instance(construct_on_thread{ tim::threading::get_id() }).get();
+    return _v;
+}
+
+bool
+is_recording()
+{
+    return get_enabled().load(std::memory_order_relaxed) &&
+           get_state() == State::Active && get_thread_state() == ThreadState::Enabled;
+}
+
+// returns the function if calls to it should be recorded on this thread
+function_entry*
+get_recorded_function(uintptr_t _addr)
+{
+    if(!is_recording()) return nullptr;
+
+    auto* _entry = find_function(_addr);
+    if(!_entry || _entry->state.load(std::memory_order_acquire) != FUNCTION_INCLUDED)
+        return nullptr;
+    return _entry;
+}
+
+// starts the region of the function. The token is empty if the region was not started
+tracing::region_token
+start_function(const function_entry& _entry)
+{
+    auto _token = component::category_region<category::host>::start(_entry.region);
+    if(!_token.region.name.empty())
+    {
+        perf_counters::push_region();
+        fork_capture::push_region();
+    }
+    return _token;
+}
+
+// the stack is unwound even when the thread is no longer recorded
+void
+stop_function(const call_entry& _entry)
+{
+    auto _name = _entry.token.region.name;
+    if(_name.empty() || get_thread_state() != ThreadState::Enabled) return;
+
+    fork_capture::pop_region(_name);
+    perf_counters::pop_region(_name);
+    component::category_region<category::host>::stop(_entry.token);
+}
+
+#if defined(__x86_64__)
+// call rel32 to the stub of the binary, which jumps to the entry trampoline
+constexpr size_t sled_size = 5;
+
+bool
+is_sled(const uint8_t* _v)
+{
+    constexpr uint8_t _single_nops[sled_size] = { 0x90, 0x90, 0x90, 0x90, 0x90 };
+    constexpr uint8_t _multi_nop[sled_size]   = { 0x0f, 0x1f, 0x44, 0x00, 0x00 };
+    return (memcmp(_v, _single_nops, sled_size) == 0 ||
+            memcmp(_v, _multi_nop, sled_size) == 0);
+}
+
+bool
+is_endbr64(const uint8_t* _v)
+{
+    constexpr uint8_t _endbr64[4] = { 0xf3, 0x0f, 0x1e, 0xfa };
+    return (memcmp(_v, _endbr64, sizeof(_endbr64)) == 0);
+}
+
+// reads the addresses in the __patchable_function_entries sections of the binary.
+// The sections are allocated so the addresses were relocated by the loader
+std::vector<uintptr_t>
+get_patchable_entries(const std::string& _path, uintptr_t _load_address)
+{
+    auto _v  = std::vector<uintptr_t>{};
+    auto _fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(_fd < 0) return _v;
+
+    auto _read = [_fd](void* _dst, size_t _size, off_t _offset) {
+        return ::pread(_fd, _dst, _size, _offset) == static_cast<ssize_t>(_size);
+    };
+
+    auto _ehdr = Elf64_Ehdr{};
+    if(_read(&_ehdr, sizeof(_ehdr), 0) && memcmp(_ehdr.e_ident, ELFMAG, SELFMAG) == 0 &&
+       _ehdr.e_ident[EI_CLASS] == ELFCLASS64 && _ehdr.e_shentsize == sizeof(Elf64_Shdr) &&
+       _ehdr.e_shstrndx < _ehdr.e_shnum)
+    {
+        auto _shdrs = std::vector<Elf64_Shdr>(_ehdr.e_shnum);
+        auto _names = std::vector<char>{};
+        if(_read(_shdrs.data(), _shdrs.size() * sizeof(Elf64_Shdr), _ehdr.e_shoff))
+        {
+            const auto& _strtab = _shdrs.at(_ehdr.e_shstrndx);
+            _names.resize(_strtab.sh_size + 1, '\0');
+            if(!_read(_names.data(), _strtab.sh_size, _strtab.sh_offset)) _names.clear();
+        }
+
+        constexpr auto _section = std::string_view{ "__patchable_function_entries" };
+        for(const auto& itr : _shdrs)
+        {
+            if(itr.sh_name >= _names.size()) continue;
+            if(std::string_view{ _names.data() + itr.sh_name } != _section) continue;
+            if((itr.sh_flags & SHF_ALLOC) == 0) continue;
+
+            const auto* _beg =
+                reinterpret_cast<const uintptr_t*>(_load_address + itr.sh_addr);
+            _v.insert(_v.end(), _beg, _beg + (itr.sh_size / sizeof(uintptr_t)));
+        }
+    }
+
+    ::close(_fd);
+    return _v;
+}
+
+// reads a pointer of the DWARF exception-handling encoding (DW_EH_PE_*) and advances
+// the position past it. Only the format of the value is decoded, i.e. the value is not
+// relative to any base. Returns false for the formats which are not known
+bool
+read_encoded(const uint8_t*& _p, uint8_t _enc, int64_t& _v)
+{
+    auto _read = [&_p, &_v](auto _value) {
+        memcpy(&_value, _p, sizeof(_value));
+        _p += sizeof(_value);
+        _v = static_cast<int64_t>(_value);
+        return true;
+    };
+
+    auto _read_leb128 = [&_p, &_v](bool _signed) {
+        uint64_t _value = 0;
+        uint32_t _shift = 0;
+        uint8_t  _byte  = 0;
+        do
+        {
+            _byte = *_p++;
+            if(_shift < 64) _value |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+            _shift += 7;
+        } while((_byte & 0x80) != 0);
+        if(_signed && _shift < 64 && (_byte & 0x40) != 0) _value |= ~0ULL << _shift;
+        _v = static_cast<int64_t>(_value);
+        return true;
+    };
+
+    switch(_enc & 0x0f)
+    {
+        case 0x00: return _read(uint64_t{});
+        case 0x01: return _read_leb128(false);
+        case 0x02: return _read(uint16_t{});
+        case 0x03: return _read(uint32_t{});
+        case 0x04: return _read(uint64_t{});
+        case 0x09: return _read_leb128(true);
+        case 0x0a: return _read(int16_t{});
+        case 0x0b: return _read(int32_t{});
+        case 0x0c: return _read(int64_t{});
+        default: break;
+    }
+    return false;
+}
+
+// whether the FDE refers to a language-specific data area, i.e. the function catches
+// the exceptions or runs the destructors of its objects when an exception propagates
+// through it
+bool
+has_lsda(const uint8_t* _fde)
+{
+    auto _length = uint32_t{};
+    auto _cie_id = uint32_t{};
+    memcpy(&_length, _fde, sizeof(_length));
+    memcpy(&_cie_id, _fde + 4, sizeof(_cie_id));
+    if(_length == 0 || _length == 0xffffffff || _cie_id == 0) return false;
+
+    // the CIE pointer is relative to its own location
+    const auto* _cie = _fde + 4 - _cie_id;
+    const auto* _p   = _cie + 8;
+    auto        _ver = *_p++;
+    auto        _aug = std::string_view{ reinterpret_cast<const char*>(_p) };
+    _p += _aug.length() + 1;
+    if(_aug.empty() || _aug.front() != 'z' || _aug.find('L') == std::string_view::npos)
+        return false;
+
+    auto _value = int64_t{};
+    read_encoded(_p, 0x01, _value);  // code alignment
+    read_encoded(_p, 0x09, _value);  // data alignment
+    if(_ver == 1)
+        ++_p;  // return address register
+    else
+        read_encoded(_p, 0x01, _value);
+    read_encoded(_p, 0x01, _value);  // augmentation length
+
+    uint8_t _fde_enc  = 0x00;
+    uint8_t _lsda_enc = 0xff;
+    for(auto itr : _aug.substr(1))
+    {
+        if(itr == 'R')
+            _fde_enc = *_p++;
+        else if(itr == 'L')
+            _lsda_enc = *_p++;
+        else if(itr == 'P')
+        {
+            auto _enc = *_p++;
+            if(!read_encoded(_p, _enc, _value)) return true;
+        }
+        else if(itr != 'S' && itr != 'B')
+            return true;  // conservatively assumed to have one
+    }
+    if(_lsda_enc == 0xff) return false;
+
+    // the initial location, the address range, the augmentation length and the LSDA
+    _p = _fde + 8;
+    if(!read_encoded(_p, _fde_enc, _value) || !read_encoded(_p, _fde_enc & 0x0f, _value))
+        return true;
+    read_encoded(_p, 0x01, _value);
+    if(!read_encoded(_p, _lsda_enc, _value)) return true;
+    return (_value != 0);
+}
+
+// the entry addresses of the functions with a language-specific data area, from the
+// search table of the .eh_frame_hdr section. Empty if the table is not available
+std::optional<std::vector<uintptr_t>>
+get_lsda_functions(uintptr_t _eh_frame_hdr)
+{
+    if(_eh_frame_hdr == 0) return std::optional<std::vector<uintptr_t>>{};
+
+    // the table which is written by the linkers is datarel/sdata4, i.e. relative to the
+    // start of the .eh_frame_hdr section
+    const auto* _hdr = reinterpret_cast<const uint8_t*>(_eh_frame_hdr);
+    if(_hdr[0] != 1 || _hdr[3] != 0x3b) return std::optional<std::vector<uintptr_t>>{};
+
+    const auto* _p     = _hdr + 4;
+    auto        _count = int64_t{};
+    if(!read_encoded(_p, _hdr[1], _count) || !read_encoded(_p, _hdr[2], _count) ||
+       _count < 0)
+        return std::optional<std::vector<uintptr_t>>{};
+
+    auto _v = std::vector<uintptr_t>{};
+    for(int64_t i = 0; i < _count; ++i, _p += 8)
+    {
+        auto _loc = int32_t{};
+        auto _fde = int32_t{};
+        memcpy(&_loc, _p, sizeof(_loc));
+        memcpy(&_fde, _p + 4, sizeof(_fde));
+        if(has_lsda(reinterpret_cast<const uint8_t*>(_eh_frame_hdr + _fde)))
+            _v.emplace_back(_eh_frame_hdr + _loc);
+    }
+
+    // the table is sorted by the initial locations
+    return _v;
+}
+
+struct text_segment
+{
+    uintptr_t begin = 0;
+    uintptr_t end   = 0;
+    int       prot  = PROT_NONE;
+};
+
+struct patch_binary
+{
+    std::string               path          = {};
+    uintptr_t                 load_address  = 0;
+    uintptr_t                 eh_frame_hdr  = 0;
+    std::vector<text_segment> text_segments = {};
+};
+
+int
+get_patch_binaries(struct dl_phdr_info* _info, size_t, void* _data)
+{
+    auto _path = std::string{ (_info->dlpi_name) ? _info->dlpi_name : "" };
+    if(_path.empty()) _path = "/proc/self/exe";
+    if(_path.find("libomnitrace") != std::string::npos) return 0;
+
+    auto _binary = patch_binary{ _path, _info->dlpi_addr, 0, {} };
+    for(ElfW(Half) i = 0; i < _info->dlpi_phnum; ++i)
+    {
+        const auto& _phdr = _info->dlpi_phdr[i];
+        auto        _beg  = _info->dlpi_addr + _phdr.p_vaddr;
+        if(_phdr.p_type == PT_GNU_EH_FRAME) _binary.eh_frame_hdr = _beg;
+        if(_phdr.p_type != PT_LOAD || (_phdr.p_flags & PF_X) == 0) continue;
+
+        auto _prot = PROT_EXEC;
+        if((_phdr.p_flags & PF_R) != 0) _prot |= PROT_READ;
+        if((_phdr.p_flags & PF_W) != 0) _prot |= PROT_WRITE;
+        _binary.text_segments.emplace_back(
+            text_segment{ _beg, _beg + _phdr.p_memsz, _prot });
+    }
+
+    if(!_binary.text_segments.empty())
+        static_cast<std::vector<patch_binary>*>(_data)->emplace_back(std::move(_binary));
+    return 0;
+}
+
+uintptr_t
+get_page_size()
+{
+    static auto _v = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    return _v;
+}
+
+// movabs $omnitrace_patch_entry_trampoline, %r11; jmp *%r11. The scratch register is
+// used since %rax holds the number of vector registers of a variadic call
+constexpr size_t stub_size = 13;
+
+// the stub has to be within the reach of a rel32 call from every sled of the binary so
+// it is mapped next to the binary
+uint8_t*
+allocate_stub(uintptr_t _lo, uintptr_t _hi)
+{
+    constexpr uintptr_t _step  = (1UL << 20);
+    constexpr uintptr_t _reach = (1UL << 31) - _step;
+
+    const auto _page     = get_page_size();
+    auto       _in_reach = [_lo, _hi](uintptr_t _v) {
+        return ((_v > _hi) ? (_v + stub_size - _lo) : (_hi + sled_size - _v)) < _reach;
+    };
+
+    for(uintptr_t _offset = _step; _offset < _reach; _offset += _step)
+    {
+        auto _hints = std::array<uintptr_t, 2>{
+            (_lo > _offset) ? ((_lo - _offset) & ~(_page - 1)) : 0,
+            ((_hi + _offset) & ~(_page - 1))
+        };
+        for(auto itr : _hints)
+        {
+            if(itr == 0) continue;
+            auto* _v = ::mmap(reinterpret_cast<void*>(itr), _page, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+            if(_v == MAP_FAILED) continue;
+            if(_in_reach(reinterpret_cast<uintptr_t>(_v)))
+                return static_cast<uint8_t*>(_v);
+            ::munmap(_v, _page);
+        }
+    }
+    return nullptr;
+}
+
+bool
+write_stub(uint8_t* _stub)
+{
+    auto _target = reinterpret_cast<uint64_t>(&omnitrace_patch_entry_trampoline);
+    _stub[0]     = 0x49;
+    _stub[1]     = 0xbb;
+    memcpy(_stub + 2, &_target, sizeof(_target));
+    _stub[10] = 0x41;
+    _stub[11] = 0xff;
+    _stub[12] = 0xe3;
+    return (::mprotect(_stub, get_page_size(), PROT_READ | PROT_EXEC) == 0);
+}
+
+// the sleds are written while the segment is writable and executable. The sleds are
+// patched during the initialization, i.e. before the application normally creates its
+// threads, since two single-byte NOPs cannot be replaced by a call atomically. The
+// segment is not patched when it cannot be writable and executable at the same time
+// (W^X policies) since the other threads or a signal handler may be running in it
+size_t
+patch_segment(const text_segment& _segment, const std::vector<uintptr_t>& _sleds,
+              const uint8_t* _stub)
+{
+    const auto _page = get_page_size();
+    auto       _beg  = _segment.begin & ~(_page - 1);
+    auto*      _addr = reinterpret_cast<void*>(_beg);
+    auto       _size = _segment.end - _beg;
+
+    if(::mprotect(_addr, _size, _segment.prot | PROT_WRITE) != 0)
+    {
+        OMNITRACE_VERBOSE(1,
+                          "[compiler_instrumentation] the text segment at %p is not "
+                          "patched since it could not be made writable: %s\n",
+                          _addr, strerror(errno));
+        return 0;
+    }
+
+    size_t _n = 0;
+    for(auto itr : _sleds)
+    {
+        if(itr < _segment.begin || itr + sled_size > _segment.end) continue;
+
+        auto    _rel32 = static_cast<int32_t>(reinterpret_cast<intptr_t>(_stub) -
+                                           static_cast<intptr_t>(itr + sled_size));
+        uint8_t _call[sled_size] = { 0xe8 };
+        memcpy(_call + 1, &_rel32, sizeof(_rel32));
+        memcpy(reinterpret_cast<void*>(itr), _call, sled_size);
+        ++_n;
+    }
+
+    if(::mprotect(_addr, _size, _segment.prot) != 0)
+    {
+        OMNITRACE_WARNING(0,
+                          "[compiler_instrumentation] the protection of the text segment "
+                          "at %p could not be restored: %s\n",
+                          _addr, strerror(errno));
+    }
+    return _n;
+}
+
+void
+patch_binary_sleds(const patch_binary& _binary)
+{
+    auto _entries = get_patchable_entries(_binary.path, _binary.load_address);
+    if(_entries.empty()) return;
+
+    // an exception cannot propagate through the return address which is replaced so
+    // the functions which catch the exceptions or clean up after them are not patched
+    auto _lsda = get_lsda_functions(_binary.eh_frame_hdr);
+    if(!_lsda)
+    {
+        OMNITRACE_VERBOSE(1,
+                          "[compiler_instrumentation] %s :: the sleds are not patched "
+                          "since the exception handling table was not found\n",
+                          _binary.path.c_str());
+        return;
+    }
+
+    auto _in_text = [&_binary](uintptr_t _v) {
+        for(const auto& itr : _binary.text_segments)
+            if(_v >= itr.begin && _v + sled_size <= itr.end) return true;
+        return false;
+    };
+
+    // every sled is resolved here so the hooks only look up the address
+    auto   _sleds    = std::vector<uintptr_t>{};
+    size_t _excluded = 0;
+    _sleds.reserve(_entries.size());
+    for(auto itr : _entries)
+    {
+        if(!_in_text(itr)) continue;
+        if(std::binary_search(_lsda->begin(), _lsda->end(), itr))
+        {
+            ++_excluded;
+            continue;
+        }
+        if(is_endbr64(reinterpret_cast<const uint8_t*>(itr))) itr += 4;
+        if(!_in_text(itr) || !is_sled(reinterpret_cast<const uint8_t*>(itr))) continue;
+
+        const auto* _entry = find_function(itr);
+        if(_entry && _entry->state.load(std::memory_order_acquire) == FUNCTION_INCLUDED)
+            _sleds.emplace_back(itr);
+    }
+
+    OMNITRACE_VERBOSE(1,
+                      "[compiler_instrumentation] %s :: %zu of %zu functions selected "
+                      "(%zu functions with exception handlers skipped)\n",
+                      _binary.path.c_str(), _sleds.size(), _entries.size(), _excluded);
+    if(_sleds.empty()) return;
+
+    std::sort(_sleds.begin(), _sleds.end());
+    auto* _stub = allocate_stub(_sleds.front(), _sleds.back());
+    if(!_stub || !write_stub(_stub))
+    {
+        OMNITRACE_WARNING(0,
+                          "[compiler_instrumentation] %s :: the sleds were not patched "
+                          "since there is no memory within the reach of a call\n",
+                          _binary.path.c_str());
+        return;
+    }
+
+    size_t _n = 0;
+    for(const auto& itr : _binary.text_segments)
+        _n += patch_segment(itr, _sleds, _stub);
+
+    OMNITRACE_VERBOSE(2, "[compiler_instrumentation] %s :: %zu functions patched\n",
+                      _binary.path.c_str(), _n);
+}
+#endif
+}  // namespace
+
+void
+setup()
+{
+    get_enabled().store(true);
+
+#if defined(__x86_64__)
+    // the patched functions return through omnitrace so the sleds are only patched for
+    // the functions which are explicitly selected
+    if(config::get_compiler_instrumentation_include().empty())
+    {
+        OMNITRACE_VERBOSE(2, "[compiler_instrumentation] the patchable function entries "
+                             "are not patched since "
+                             "OMNITRACE_COMPILER_INSTRUMENTATION_INCLUDE is empty\n");
+        return;
+    }
+
+    // the binaries are collected first so the symbols are not resolved while the
+    // loader lock is held
+    auto _binaries = std::vector<patch_binary>{};
+    dl_iterate_phdr(&get_patch_binaries, &_binaries);
+    for(const auto& itr : _binaries)
+        patch_binary_sleds(itr);
+#endif
+}
+
+void
+shutdown()
+{
+    get_enabled().store(false);
+}
+}  // namespace compiler_instrumentation
+}  // namespace omnitrace
+
+//======================================================================================//
+
+extern "C" void
+omnitrace_function_enter_hidden(void* _func, void*)
+{
+    using namespace omnitrace::compiler_instrumentation;
+
+    try
+    {
+        auto  _addr  = reinterpret_cast<uintptr_t>(_func);
+        auto* _entry = get_recorded_function(_addr);
+        if(!_entry) return;
+
+        // the entry is pushed even when the region was not started so that the exits
+        // of a recursive function match their entries
+        if(auto* _stack = get_call_stack(); _stack)
+            _stack->entries.emplace_back(
+                call_entry{ _addr, nullptr, 0, start_function(*_entry) });
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+    }
+}
+
+extern "C" void
+omnitrace_function_exit_hidden(void* _func, void*)
+{
+    using namespace omnitrace::compiler_instrumentation;
+
+    try
+    {
+        auto* _stack = get_call_stack();
+        if(!_stack || _stack->entries.empty()) return;
+
+        auto  _addr    = reinterpret_cast<uintptr_t>(_func);
+        auto& _entries = _stack->entries;
+        if(_entries.back().function != _addr)
+        {
+            // the entries above the function belong to the frames left by longjmp
+            const auto* _entry = find_function(_addr);
+            if(!_entry ||
+               _entry->state.load(std::memory_order_acquire) != FUNCTION_INCLUDED)
+                return;
+
+            auto ritr = std::find_if(_entries.rbegin(), _entries.rend(),
+                                     [_addr](const call_entry& _v) {
+                                         return (_v.function == _addr && !_v.slot);
+                                     });
+            if(ritr == _entries.rend()) return;
+            for(auto itr = _entries.rbegin(); itr != ritr; ++itr)
+                stop_function(*itr);
+            _entries.erase(ritr.base(), _entries.end());
+        }
+
+        stop_function(_entries.back());
+        _entries.pop_back();
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+    }
+}
+
+#if defined(__x86_64__)
+// invoked by the entry trampoline with the address after the sled and the location of
+// the return address of the patched function. The return address is replaced by the
+// exit trampoline as long as the region of the function is open
+extern "C" void
+omnitrace_patch_enter(uintptr_t _ret, uintptr_t* _slot)
+{
+    using namespace omnitrace::compiler_instrumentation;
+
+    try
+    {
+        auto  _addr  = _ret - sled_size;
+        auto* _entry = get_recorded_function(_addr);
+        if(!_entry) return;
+
+        auto* _stack = get_call_stack();
+        if(!_stack) return;
+
+        // the entries at or below the return address belong to the frames left by
+        // longjmp
+        auto& _entries = _stack->entries;
+        while(!_entries.empty() && _entries.back().slot && _entries.back().slot <= _slot)
+        {
+            stop_function(_entries.back());
+            _entries.pop_back();
+        }
+
+        auto _token = start_function(*_entry);
+        if(_token.region.name.empty()) return;
+
+        _entries.emplace_back(call_entry{ _addr, _slot, *_slot, _token });
+        *_slot = reinterpret_cast<uintptr_t>(&omnitrace_patch_exit_trampoline) + 1;
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+    }
+}
+
+// invoked by the exit trampoline with the stack pointer after the return of the patched
+// function. Returns the original return address
+extern "C" uintptr_t
+omnitrace_patch_exit(uintptr_t _rsp)
+{
+    using namespace omnitrace::compiler_instrumentation;
+
+    auto* _slot    = reinterpret_cast<uintptr_t*>(_rsp) - 1;
+    auto& _entries = get_call_stack()->entries;
+    while(!_entries.empty())
+    {
+        auto _entry = _entries.back();
+        _entries.pop_back();
+        try
+        {
+            stop_function(_entry);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        }
+        if(_entry.slot == _slot) return _entry.ret;
+    }
+
+    OMNITRACE_FAIL_F("the return address of a patched function at %p was lost\n",
+                     static_cast<void*>(_slot));
+    return 0;
+}
+
+// both trampolines preserve the registers which the function may use for arguments or
+// return values. The entry trampoline is reached through the stub with the address
+// after the sled on top of the stack (16-byte aligned) and the exit trampoline is the
+// return address of the patched function. The return address is after the leading NOP
+// of the exit trampoline so that the symbol lookup of the address before it, e.g. by
+// the unwinders, finds the trampoline
+asm(R"asm(
+    .text
+    .p2align 4
+    .globl  omnitrace_patch_entry_trampoline
+    .hidden omnitrace_patch_entry_trampoline
+    .type   omnitrace_patch_entry_trampoline, @function
+omnitrace_patch_entry_trampoline:
+    pushq   %rbp
+    movq    %rsp, %rbp
+    pushq   %rax
+    pushq   %rdi
+    pushq   %rsi
+    pushq   %rdx
+    pushq   %rcx
+    pushq   %r8
+    pushq   %r9
+    pushq   %r10
+    subq    $136, %rsp
+    movdqu  %xmm0, 0(%rsp)
+    movdqu  %xmm1, 16(%rsp)
+    movdqu  %xmm2, 32(%rsp)
+    movdqu  %xmm3, 48(%rsp)
+    movdqu  %xmm4, 64(%rsp)
+    movdqu  %xmm5, 80(%rsp)
+    movdqu  %xmm6, 96(%rsp)
+    movdqu  %xmm7, 112(%rsp)
+    movq    8(%rbp), %rdi
+    leaq    16(%rbp), %rsi
+    call    omnitrace_patch_enter
+    movdqu  0(%rsp), %xmm0
+    movdqu  16(%rsp), %xmm1
+    movdqu  32(%rsp), %xmm2
+    movdqu  48(%rsp), %xmm3
+    movdqu  64(%rsp), %xmm4
+    movdqu  80(%rsp), %xmm5
+    movdqu  96(%rsp), %xmm6
+    movdqu  112(%rsp), %xmm7
+    addq    $136, %rsp
+    popq    %r10
+    popq    %r9
+    popq    %r8
+    popq    %rcx
+    popq    %rdx
+    popq    %rsi
+    popq    %rdi
+    popq    %rax
+    popq    %rbp
+    ret
+    .size   omnitrace_patch_entry_trampoline, .-omnitrace_patch_entry_trampoline
+
+    .p2align 4
+    .globl  omnitrace_patch_exit_trampoline
+    .hidden omnitrace_patch_exit_trampoline
+    .type   omnitrace_patch_exit_trampoline, @function
+omnitrace_patch_exit_trampoline:
+    nop
+    pushq   %rax
+    pushq   %rbp
+    movq    %rsp, %rbp
+    pushq   %rax
+    pushq   %rdx
+    subq    $32, %rsp
+    movdqu  %xmm0, 0(%rsp)
+    movdqu  %xmm1, 16(%rsp)
+    leaq    16(%rbp), %rdi
+    call    omnitrace_patch_exit
+    movq    %rax, 8(%rbp)
+    movdqu  0(%rsp), %xmm0
+    movdqu  16(%rsp), %xmm1
+    addq    $32, %rsp
+    popq    %rdx
+    popq    %rax
+    popq    %rbp
+    ret
+    .size   omnitrace_patch_exit_trampoline, .-omnitrace_patch_exit_trampoline
+)asm");
+#endif
@@ -0,0 +1,46 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace omnitrace
+{
+/// function tracing of the binaries compiled with -finstrument-functions or
+/// -fpatchable-function-entry=5 (see OMNITRACE_COMPILER_INSTRUMENTATION). The
+/// __cyg_profile_func_enter/exit hooks of libomnitrace-dl forward the function address
+/// and the address is mapped to a region once, so the hooks never look up a string
+/// and the functions which are not selected only cost a lookup in the table. On
+/// x86-64, the entry NOP sleds of the selected functions are patched into calls at
+/// initialization and the other sleds remain NOPs
+namespace compiler_instrumentation
+{
+/// resolves and selects the functions of every loaded binary which has patchable
+/// function entries and patches the sleds of the selected functions
+void
+setup();
+
+/// stops recording the function calls. The patched sleds remain calls which return
+/// immediately
+void
+shutdown();
+}  // namespace compiler_instrumentation
+}  // namespace omnitrace
@@ -20,16 +20,24 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include "binary/unwind_table.hpp"
+#include "core/calibration.hpp"
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
+#include "core/self_profile.hpp"
 #include "core/state.hpp"
+#include "core/tsc.hpp"
 #include "library/components/ensure_storage.hpp"
+#include "library/frame_pointer.hpp"
+#include "library/live_export.hpp"
 #include "library/ptl.hpp"
+#include "library/region_rates.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
+#include "library/thread_info.hpp"
 
 #include <timemory/backends/papi.hpp>
 #include <timemory/backends/threading.hpp>
@@ -55,7 +63,9 @@
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <ctime>
 #include <initializer_list>
@@ -74,16 +84,275 @@ namespace omnitrace
 {
 namespace component
 {
+namespace
+{
+struct stack_table_tag
+{};
+
+using stack_table_instances = thread_data<backtrace::stack_table, stack_table_tag>;
+using rate_controller_instances =
+    thread_data<backtrace::rate_controller, stack_table_tag>;
+
+uint64_t
+compute_stack_hash(const backtrace::addr_data_t& _data)
+{
+    // FNV-1a
+    uint64_t _hash = 0xcbf29ce484222325ULL;
+    for(auto itr : _data)
+    {
+        _hash ^= static_cast<uint64_t>(itr);
+        _hash *= 0x100000001b3ULL;
+    }
+    return _hash;
+}
+
+// the initial stride of the rate controllers from the calibrated cost of a sample at
+// the sampling frequencies of the timers (see OMNITRACE_CALIBRATION_FILE)
+uint32_t
+get_calibrated_stride()
+{
+    static auto _v = []() -> uint32_t {
+        auto _data = calibration::read(config::get_calibration_file());
+        if(!_data) return 1;
+
+        auto _rate    = 0.0;
+        auto _signals = get_sampling_signals();
+        if(_signals.count(get_sampling_cputime_signal()) > 0)
+            _rate += get_sampling_cputime_freq();
+        if(_signals.count(get_sampling_realtime_signal()) > 0)
+            _rate += get_sampling_realtime_freq();
+
+        auto _stride = calibration::get_sampling_stride(
+            *_data, config::get_snapshot().sampling_unwinder, _rate,
+            get_sampling_overhead_target(), backtrace::rate_controller::max_stride);
+
+        OMNITRACE_VERBOSE(1,
+                          "Initial stride of the timer signals from the calibration "
+                          "in '%s': %u\n",
+                          config::get_calibration_file().c_str(), _stride);
+        return _stride;
+    }();
+    return _v;
+}
+
+// OMNITRACE_SAMPLING_UNWINDER=auto unwinds the first samples of the process with both
+// unwinders and keeps the frame pointers if nearly all of the call-stacks agree. The
+// frame pointers are not recorded for the leaf functions without a frame, e.g. in the
+// C library, so those samples disagree
+struct unwinder_calibration
+{
+    static constexpr uint32_t num_samples = 32;
+    static constexpr uint32_t min_matches = 28;
+
+    std::atomic<uint32_t>         samples = { 0 };
+    std::atomic<uint32_t>         matches = { 0 };
+    std::atomic<SamplingUnwinder> result  = { SamplingUnwinder::Auto };
+};
+
+auto&
+get_unwinder_calibration()
+{
+    static auto _v = unwinder_calibration{};
+    return _v;
+}
+
+SamplingUnwinder
+get_sample_unwinder()
+{
+    auto _v = config::get_snapshot().sampling_unwinder;
+    if(_v != SamplingUnwinder::Auto) return _v;
+    return get_unwinder_calibration().result.load(std::memory_order_relaxed);
+}
+
+// libunwind also reports the frames of the signal handler so the frame-pointer
+// call-stack, which starts at the interrupted instruction, is matched from there. It may
+// miss the last few frames of the C library below main or the thread function
+bool
+is_matching_stack(const backtrace::addr_data_t& _fp, const backtrace::addr_data_t& _raw)
+{
+    auto _is_equal = [](uintptr_t _lhs, uintptr_t _rhs) {
+        return (_lhs == _rhs || _lhs + 1 == _rhs || _rhs + 1 == _lhs);
+    };
+
+    if(_fp.empty()) return false;
+    auto itr = std::find(_raw.begin(), _raw.end(), _fp.front());
+    if(itr == _raw.end()) return false;
+
+    auto _remaining = static_cast<size_t>(std::distance(itr, _raw.end()));
+    if(_fp.size() > _remaining || _remaining - _fp.size() > 3) return false;
+    for(size_t i = 1; i < _fp.size(); ++i)
+        if(!_is_equal(_fp[i], *(itr + i))) return false;
+    return true;
+}
+
+void
+calibrate_unwinder(const backtrace::addr_data_t& _fp, const backtrace::addr_data_t& _raw)
+{
+    auto& _calib = get_unwinder_calibration();
+    if(is_matching_stack(_fp, _raw)) _calib.matches.fetch_add(1);
+    if(_calib.samples.fetch_add(1) + 1 != unwinder_calibration::num_samples) return;
+
+    _calib.result.store((_calib.matches.load() >= unwinder_calibration::min_matches)
+                            ? SamplingUnwinder::FramePointer
+                            : SamplingUnwinder::LibUnwind);
+}
+}  // namespace
+
+backtrace::stack_table::stack_table(size_t _capacity)
+{
+    // round up to a power of two so that the probe can use a mask
+    size_t _n = 1;
+    while(_n < _capacity)
+        _n <<= 1;
+    m_mask = _n - 1;
+    m_data.resize(_n);
+}
+
+backtrace::stack_entry*
+backtrace::stack_table::record(const addr_data_t& _data, uint64_t _elapsed,
+                               bool& _inserted)
+{
+    _inserted = false;
+    if(_data.empty() || m_data.empty()) return nullptr;
+
+    auto _hash = compute_stack_hash(_data);
+    for(size_t i = 0; i < m_data.size(); ++i)
+    {
+        auto& _entry = m_data[(_hash + i) & m_mask];
+        if(_entry.count == 0)
+        {
+            // keep the load factor at or below 0.75 so probes stay short
+            if(4 * (m_size + 1) > 3 * m_data.size()) break;
+            _entry.hash = _hash;
+            _entry.data = _data;
+            _inserted   = true;
+            ++m_size;
+        }
+        else if(_entry.hash != _hash || _entry.data.size() != _data.size() ||
+                !std::equal(_data.begin(), _data.end(), _entry.data.begin()))
+        {
+            continue;
+        }
+
+        _entry.count += 1;
+        _entry.elapsed += _elapsed;
+        return &_entry;
+    }
+
+    ++m_dropped;
+    return nullptr;
+}
+
+backtrace::rate_controller::rate_controller(double _target, uint32_t _stride)
+: m_target{ _target }
+, m_stride{ std::max<uint32_t>(std::min(_stride, max_stride), 1) }
+{
+    if(m_stride > 1) m_changes.emplace_back(change{ 0, m_stride });
+}
+
+void
+backtrace::rate_controller::update(uint64_t _beg, uint64_t _end)
+{
+    m_window_cost += (_end - _beg);
+    if(m_window_beg == 0) m_window_beg = _beg;
+
+    auto _elapsed = _end - m_window_beg;
+    if(_elapsed < window_ns) return;
+
+    auto _overhead = (100.0 * m_window_cost) / _elapsed;
+    auto _stride   = m_stride;
+    if(_overhead > m_target && _stride < max_stride)
+        _stride *= 2;
+    // halving the stride doubles the overhead so leave some headroom
+    else if(_overhead < 0.4 * m_target && _stride > 1)
+        _stride /= 2;
+
+    // once the log of changes is full, the stride is frozen so that the samples can
+    // still be reweighted correctly
+    if(_stride != m_stride && m_changes.size() < m_changes.capacity())
+    {
+        m_stride = _stride;
+        m_count  = 1;
+        m_changes.emplace_back(change{ _end, _stride });
+    }
+
+    m_window_beg  = _end;
+    m_window_cost = 0;
+}
+
+uint32_t
+backtrace::rate_controller::get_stride(uint64_t _timestamp) const
+{
+    uint32_t _stride = 1;
+    for(const auto& itr : m_changes)
+    {
+        if(itr.timestamp > _timestamp) break;
+        _stride = itr.stride;
+    }
+    return _stride;
+}
+
+void
+backtrace::configure(bool _setup, int64_t _tid)
+{
+    if(!_setup) return;
+
+    // make sure the queries in the sampler do not allocate
+    (void) get_sampling_overhead_target();
+
+    // the live export reads the interrupted instruction from the signal frame
+    if(config::get_snapshot().sampling_unwinder != SamplingUnwinder::LibUnwind ||
+       config::get_snapshot().live_export)
+        frame_pointer::configure_thread();
+
+    // registers the libraries loaded since the last sampled thread started
+    if(get_sampling_shared_unwind_tables()) binary::update_unwind_tables();
+
+    if(get_sampling_overhead_target() > 0.0)
+        rate_controller_instances::construct(construct_on_thread{ _tid },
+                                             get_sampling_overhead_target(),
+                                             get_calibrated_stride());
+
+    if(get_sampling_aggregate())
+    {
+        (void) get_sampling_aggregate_checkpoint();
+        stack_table_instances::construct(construct_on_thread{ _tid },
+                                         get_sampling_aggregate_table_size());
+    }
+}
+
+SamplingUnwinder
+backtrace::get_unwinder()
+{
+    return get_sample_unwinder();
+}
+
+unique_ptr_t<backtrace::rate_controller>&
+backtrace::get_rate_controller(int64_t _tid)
+{
+    return rate_controller_instances::instance(construct_on_thread{ _tid },
+                                               get_sampling_overhead_target(),
+                                               get_calibrated_stride());
+}
+
+unique_ptr_t<backtrace::stack_table>&
+backtrace::get_stack_table(int64_t _tid)
+{
+    return stack_table_instances::instance(construct_on_thread{ _tid },
+                                           get_sampling_aggregate_table_size());
+}
+
 std::vector<backtrace::entry_type>
 backtrace::get() const
 {
     std::vector<entry_type> _v = {};
     if(size() == 0) return _v;
 
+    if(const auto* _data = std::get_if<data_t>(&m_data))
     {
         static auto _cache = cache_type{ get_sampling_include_inlines() };
         auto_lock_t _lk{ type_mutex<backtrace>() };
-        _v = m_data.get(&_cache, false);
+        _v = _data->get(&_cache, false);
     }
 
     // put the bottom of the call-stack on top
@@ -98,6 +367,25 @@ backtrace::get() const
     return _v;
 }
 
+bool
+backtrace::is_gpu_wait(uintptr_t _v)
+{
+    return (_v > no_gpu_wait && _v < gpu_wait_frame_end);
+}
+
+const char*
+backtrace::get_gpu_wait_name(uintptr_t _v)
+{
+    switch(_v)
+    {
+        case device_synchronize_wait: return "[GPU wait] hipDeviceSynchronize";
+        case stream_synchronize_wait: return "[GPU wait] hipStreamSynchronize";
+        case event_synchronize_wait: return "[GPU wait] hipEventSynchronize";
+        default: break;
+    }
+    return nullptr;
+}
+
 std::string
 backtrace::label()
 {
@@ -110,8 +398,8 @@ backtrace::description()
     return "Records backtrace data";
 }
 
-std::vector<backtrace::entry_type>
-backtrace::filter_and_patch(const std::vector<entry_type>& _data)
+short
+backtrace::patch_entry(entry_type& _v)
 {
     // check whether the call-stack entry should be used. -1 means break, 0 means continue
     auto _use_label = [](std::string_view _lbl) -> short {
@@ -147,16 +435,23 @@ backtrace::filter_and_patch(const std::vector<entry_type>& _data)
         return std::string{ _lbl }.replace(_pos, _dyninst.length(), "");
     };
 
+    auto _name = tim::demangle(_patch_label(_v.name));
+    auto _use  = _use_label(_name);
+    if(_use == 1) _v.name = _name;
+    return _use;
+}
+
+std::vector<backtrace::entry_type>
+backtrace::filter_and_patch(const std::vector<entry_type>& _data)
+{
     auto _ret = std::vector<entry_type>{};
     _ret.reserve(_data.size());
     for(const auto& itr : _data)
     {
-        auto _name = tim::demangle(_patch_label(itr.name));
-        auto _use  = _use_label(_name);
+        auto _v   = itr;
+        auto _use = patch_entry(_v);
         if(_use == -1) break;
         if(_use == 0) continue;
-        auto _v = itr;
-        _v.name = _name;
         _ret.emplace_back(_v);
     }
 
@@ -177,31 +472,171 @@ backtrace::empty() const
     return (size() == 0);
 }
 
+bool
+backtrace::is_aggregated() const
+{
+    return std::holds_alternative<aggregated_data_t>(m_data);
+}
+
 size_t
 backtrace::size() const
 {
-    return m_data.size();
+    if(const auto* _v = std::get_if<data_t>(&m_data)) return _v->size();
+    return get_addresses().size();
+}
+
+backtrace::data_t
+backtrace::get_data() const
+{
+    if(const auto* _v = std::get_if<data_t>(&m_data)) return *_v;
+    return data_t{};
+}
+
+const backtrace::addr_data_t&
+backtrace::get_addresses() const
+{
+    static const auto _empty = addr_data_t{};
+    if(const auto* _v = std::get_if<addr_data_t>(&m_data)) return *_v;
+    if(const auto* _v = std::get_if<aggregated_data_t>(&m_data)) return _v->data;
+    return _empty;
 }
 
 void
 backtrace::sample(int signo)
 {
+    // the sampler stores a sample for every signal, including the ones skipped below
+    if(config::get_snapshot().memory_footprint) sampling::track_sample();
+
+    // the metrics of a sample which is not counted in the call-stack table are not
+    // attributed to the entry of a previous sample
+    get_pending_entry() = nullptr;
+
     if(signo == get_sampling_overflow_signal()) return;
 
+    // the signals decimated by a region rate below the timer frequency are not unwound
+    if(config::get_snapshot().sampling_region_rates && !region_rates::accept(signo))
+        return;
+
+    // the hot spots of the live export are counted before the overhead target skips
+    // the unwinding of some samples
+    if(config::get_snapshot().live_export) live_export::record_sample(signo);
+
     // on RedHat, the unw_step within get_unw_stack involves a mutex lock
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(sampling);
+
+    if(get_sampling_overhead_target() > 0.0)
+    {
+        static thread_local const auto& _tinfo = thread_info::get();
+        static thread_local auto*       _ctrl =
+            get_rate_controller(_tinfo->index_data->sequent_value).get();
+
+        if(_ctrl)
+        {
+            if(!_ctrl->accept()) return;
+
+            auto _beg = tsc::get_clock_real_now();
+            sample_stack(signo);
+            _ctrl->update(_beg, tsc::get_clock_real_now());
+            return;
+        }
+    }
+
+    sample_stack(signo);
+}
 
+TIMEMORY_NOINLINE void
+backtrace::sample_stack(int signo)
+{
     using namespace tim::backtrace;
     constexpr bool   with_signal_frame = false;
-    constexpr size_t ignore_depth      = 3;
+    constexpr size_t ignore_depth      = 4;
     // ignore depth based on:
     // 1. this frame
-    // 2. tim::sampling::sampler<...>::sample(...) [always inline]
-    // 3. tim::sampling::sampler<...>::execute(...)
+    // 2. backtrace::sample(...)
+    // 3. tim::sampling::sampler<...>::sample(...) [always inline]
+    // 4. tim::sampling::sampler<...>::execute(...)
     // 4a. funlockfile       [common but not explicitly in call-stack]
     // 4b. __resume_rt       [common but not explicitly in call-stack]
     // 4c. killpg            [common but not explicitly in call-stack]
-    m_data = get_unw_stack<stack_depth, ignore_depth, with_signal_frame>();
+
+    // the spin-wait of the HIP runtime is not unwound, the sample only contains the
+    // synthetic frame of the HIP function
+    auto _gpu_wait = (config::get_snapshot().sampling_collapse_gpu_wait)
+                         ? get_gpu_wait()
+                         : no_gpu_wait;
+
+    // the frame-pointer call-stack is used unless the chain is broken or the unwinders
+    // are being compared, in which case the sample is unwound by libunwind
+    auto _unwinder = get_sample_unwinder();
+    auto _fp_data  = addr_data_t{};
+    if(_gpu_wait == no_gpu_wait && _unwinder != SamplingUnwinder::LibUnwind)
+    {
+        uintptr_t _buffer[stack_depth];
+        auto      _n = frame_pointer::unwind(_buffer, stack_depth, signo);
+        _fp_data.append(_buffer, _buffer + _n);
+
+        if(_unwinder == SamplingUnwinder::Auto)
+        {
+            auto _raw = addr_data_t{};
+            _raw      = get_unw_stack_raw<stack_depth, ignore_depth>();
+            calibrate_unwinder(_fp_data, _raw);
+            _fp_data.clear();
+        }
+    }
+
+    if(get_sampling_aggregate())
+    {
+        static thread_local const auto& _tinfo = thread_info::get();
+        static thread_local auto*       _table =
+            get_stack_table(_tinfo->index_data->sequent_value).get();
+
+        auto _data = addr_data_t{};
+        if(_gpu_wait != no_gpu_wait)
+            _data.emplace_back(_gpu_wait);
+        else if(!_fp_data.empty())
+            _data = _fp_data;
+        else
+            _data = get_unw_stack_raw<stack_depth, ignore_depth>();
+
+        if(_table)
+        {
+            auto _now      = tsc::get_clock_real_now();
+            auto _last     = _table->last_timestamp;
+            auto _elapsed  = (_last > 0) ? (_now - _last) : uint64_t{ 0 };
+            bool _inserted = false;
+
+            _table->last_timestamp = _now;
+            auto* _entry           = _table->record(_data, _elapsed, _inserted);
+            get_pending_entry()    = _entry;
+
+            // only new call-stacks and periodic checkpoints are added to the timeline.
+            // A call-stack which does not fit in the full table is stored like a
+            // sample without the aggregation so that it is not lost
+            auto _checkpoint = get_sampling_aggregate_checkpoint();
+            if(_entry && !_inserted &&
+               (_checkpoint == 0 || (_entry->count % _checkpoint) != 0))
+                return;
+            if(_entry)
+            {
+                m_data.emplace<aggregated_data_t>().data = _data;
+                return;
+            }
+        }
+
+        m_data.emplace<addr_data_t>(_data);
+    }
+    else if(_gpu_wait != no_gpu_wait)
+    {
+        m_data.emplace<addr_data_t>().emplace_back(_gpu_wait);
+    }
+    else if(!_fp_data.empty())
+        m_data.emplace<addr_data_t>(_fp_data);
+    else if(get_sampling_deferred_symbols())
+        m_data.emplace<addr_data_t>() = get_unw_stack_raw<stack_depth, ignore_depth>();
+    else
+        m_data.emplace<data_t>() =
+            get_unw_stack<stack_depth, ignore_depth, with_signal_frame>();
 }
 }  // namespace component
 }  // namespace omnitrace
@@ -24,11 +24,15 @@
 
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
+#include "core/containers/static_vector.hpp"
 #include "core/defines.hpp"
+#include "core/huge_pages.hpp"
+#include "core/state.hpp"
 #include "core/timemory.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/components/base/declaration.hpp>
+#include <timemory/components/papi/types.hpp>
 #include <timemory/mpl/concepts.hpp>
 #include <timemory/unwind/cache.hpp>
 #include <timemory/unwind/processed_entry.hpp>
@@ -39,6 +43,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <set>
+#include <variant>
 #include <vector>
 
 namespace omnitrace
@@ -50,6 +55,8 @@ struct backtrace : comp::empty_base
     static constexpr size_t stack_depth = OMNITRACE_MAX_UNWIND_DEPTH;
 
     using data_t            = tim::unwind::stack<stack_depth>;
+    using addr_data_t       = container::static_vector<uintptr_t, stack_depth>;
+    using hw_counter_t      = std::array<int64_t, TIMEMORY_PAPI_ARRAY_SIZE>;
     using cache_type        = typename data_t::cache_type;
     using entry_type        = tim::unwind::processed_entry;
     using clock_type        = std::chrono::steady_clock;
@@ -57,9 +64,133 @@ struct backtrace : comp::empty_base
     using system_clock      = std::chrono::system_clock;
     using system_time_point = typename system_clock::time_point;
 
+    // unique call-stack and the number of samples, the time between the samples and
+    // the CPU time and hardware counters since the previous sample, attributed to it
+    // when OMNITRACE_SAMPLING_AGGREGATE is enabled
+    struct stack_entry
+    {
+        bool         use_cpu = false;
+        bool         use_hw  = false;
+        uint64_t     hash    = 0;
+        uint64_t     count   = 0;
+        uint64_t     elapsed = 0;
+        int64_t      cpu     = 0;
+        hw_counter_t hw      = {};
+        addr_data_t  data    = {};
+    };
+
+    // the instruction pointers of a sample which is also counted in the call-stack
+    // table, i.e. the first sample of a call-stack or a checkpoint, so that it is only
+    // used for the timeline
+    struct aggregated_data_t
+    {
+        addr_data_t data = {};
+    };
+
+    using storage_t =
+        std::variant<std::monostate, data_t, addr_data_t, aggregated_data_t>;
+
+    // preallocated, open-addressed (linear probing) table of call-stacks. The table
+    // never allocates after construction so it is safe to update in a signal handler
+    struct stack_table
+    {
+        explicit stack_table(size_t _capacity);
+
+        stack_entry* record(const addr_data_t&, uint64_t _elapsed, bool& _inserted);
+
+        size_t      size() const { return m_size; }
+        size_t      capacity() const { return m_data.size(); }
+        size_t      dropped() const { return m_dropped; }
+        const auto& get() const { return m_data; }
+
+        uint64_t last_timestamp = 0;
+
+    private:
+        using allocator_t = huge_pages::allocator<stack_entry>;
+
+        size_t                                m_size    = 0;
+        size_t                                m_mask    = 0;
+        size_t                                m_dropped = 0;
+        std::vector<stack_entry, allocator_t> m_data    = {};
+    };
+
+    // decimates the timer signals so that the time spent unwinding in the signal
+    // handler stays below OMNITRACE_SAMPLING_OVERHEAD_TARGET percent of the wall-time.
+    // Every change of the stride is recorded so that the samples can be reweighted.
+    // The initial stride is estimated from OMNITRACE_CALIBRATION_FILE when available
+    struct rate_controller
+    {
+        struct change
+        {
+            uint64_t timestamp = 0;
+            uint32_t stride    = 1;
+        };
+
+        static constexpr uint32_t max_stride  = 1024;
+        static constexpr size_t   max_changes = 512;
+        static constexpr uint64_t window_ns   = 100000000;
+
+        explicit rate_controller(double _target, uint32_t _stride = 1);
+
+        // returns false if the sample should be skipped
+        bool accept() { return (m_count++ % m_stride) == 0; }
+        void update(uint64_t _beg, uint64_t _end);
+
+        uint32_t    get_stride() const { return m_stride; }
+        uint32_t    get_stride(uint64_t _timestamp) const;
+        const auto& get_changes() const { return m_changes; }
+
+    private:
+        double                                        m_target      = 0.0;
+        uint32_t                                      m_stride      = 1;
+        uint64_t                                      m_count       = 0;
+        uint64_t                                      m_window_beg  = 0;
+        uint64_t                                      m_window_cost = 0;
+        container::static_vector<change, max_changes> m_changes     = {};
+    };
+
+    // synthetic frames of the samples taken inside the synchronizing HIP functions when
+    // OMNITRACE_SAMPLING_COLLAPSE_GPU_WAIT is enabled. The values are not valid
+    // instruction addresses so they are stored in place of the call-stack
+    enum gpu_wait_frame : uintptr_t
+    {
+        no_gpu_wait = 0,
+        device_synchronize_wait,
+        stream_synchronize_wait,
+        event_synchronize_wait,
+        gpu_wait_frame_end,
+    };
+
+    // set by the HIP API callback of roctracer. The flag uses the initial-exec TLS
+    // model since it is read in the signal handler
+    static gpu_wait_frame& get_gpu_wait()
+    {
+        static thread_local gpu_wait_frame _v
+            OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) = no_gpu_wait;
+        return _v;
+    }
+
+    // the entry of the call-stack table which the current sample was counted in. Set
+    // by sample() and consumed by backtrace_metrics::sample(), which runs after it in
+    // the same signal handler
+    static stack_entry*& get_pending_entry()
+    {
+        static thread_local stack_entry* _v
+            OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) = nullptr;
+        return _v;
+    }
+
+    static bool        is_gpu_wait(uintptr_t _v);
+    static const char* get_gpu_wait_name(uintptr_t _v);
+
     static std::string label();
     static std::string description();
 
+    static void configure(bool, int64_t _tid = threading::get_id());
+    static SamplingUnwinder               get_unwinder();
+    static unique_ptr_t<stack_table>&     get_stack_table(int64_t _tid);
+    static unique_ptr_t<rate_controller>& get_rate_controller(int64_t _tid);
+
     backtrace()                     = default;
     ~backtrace()                    = default;
     backtrace(const backtrace&)     = default;
@@ -70,17 +201,29 @@ struct backtrace : comp::empty_base
 
     static std::vector<entry_type> filter_and_patch(const std::vector<entry_type>&);
 
+    // patches the name of the entry and returns 1 if the entry should be used,
+    // 0 if the entry should be skipped, and -1 if the remaining entries should be skipped
+    static short patch_entry(entry_type&);
+
     static void start();
     static void stop();
 
     void                    sample(int = -1);
     bool                    empty() const;
+    bool                    is_aggregated() const;
     size_t                  size() const;
     std::vector<entry_type> get() const;
-    data_t                  get_data() const { return m_data; }
+    data_t                  get_data() const;
+    const addr_data_t&      get_addresses() const;
 
 private:
-    data_t m_data = {};
+    // never inlined so that the number of frames to ignore is the same with and
+    // without the rate controller
+    TIMEMORY_NOINLINE void sample_stack(int);
+
+    // a sample holds either the unwound frames or only their instruction pointers so
+    // the two share the storage of the bundle in the sampler buffers
+    storage_t m_data = {};
 };
 }  // namespace component
 }  // namespace omnitrace
@@ -26,6 +26,9 @@
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
 #include "library/components/ensure_storage.hpp"
+#include "library/loop_trips.hpp"
+#include "library/perf.hpp"
+#include "library/perf_counters.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
@@ -56,11 +59,14 @@
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <ctime>
 #include <initializer_list>
+#include <linux/perf_event.h>
 #include <mutex>
+#include <optional>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -116,6 +122,131 @@ get_sampler_running(int64_t _tid)
 {
     return sampler_running_instances::instance(construct_on_thread{ _tid }, false);
 }
+
+// with OMNITRACE_SAMPLING_PERF_METRICS, the thread CPU time, the context switches, and
+// the page faults of the samples are read from the metadata pages of perf software
+// counters (see perf::perf_event::read_user_page) and the peak RSS is only read every
+// OMNITRACE_SAMPLING_PEAK_RSS_INTERVAL samples. The offsets are the differences with
+// getrusage and the thread CPU clock when the counters were opened so the values are
+// the same as the ones of getrusage
+struct perf_metrics
+{
+    bool             active         = false;
+    size_t           interval       = 1;
+    size_t           count          = 0;  // number of samples
+    int64_t          cpu            = 0;  // offsets
+    int64_t          ctx_swch       = 0;
+    int64_t          page_flt       = 0;
+    int64_t          mem_peak       = 0;  // last peak RSS
+    uint64_t         faults         = 0;  // last page faults read with a syscall
+    perf::perf_event ctx_swch_event = {};
+    perf::perf_event page_flt_event = {};
+};
+
+using perf_metrics_instances = thread_data<perf_metrics, category::sampling>;
+
+unique_ptr_t<perf_metrics>&
+get_perf_metrics(int64_t _tid)
+{
+    return perf_metrics_instances::instance(construct_on_thread{ _tid });
+}
+
+// the counters of the calling thread once they are opened so the samples do not look
+// up the thread data
+perf_metrics*&
+get_local_perf_metrics()
+{
+    static thread_local perf_metrics* _v = nullptr;
+    return _v;
+}
+
+std::optional<std::string>
+open_software_counter(perf::perf_event& _event, uint64_t _config, bool _exclude_kernel)
+{
+    struct perf_event_attr _pe;
+    memset(&_pe, 0, sizeof(_pe));
+    _pe.type           = PERF_TYPE_SOFTWARE;
+    _pe.config         = _config;
+    _pe.exclude_kernel = (_exclude_kernel) ? 1 : 0;
+    _pe.exclude_hv     = 1;
+
+    auto _err = _event.open(_pe);
+    if(!_err) _event.start();
+    return _err;
+}
+
+// opens the counters of the calling thread. The context switches are counted in the
+// kernel so, unless the context switches are disabled, the counters are only used
+// when perf_event_paranoid permits counting the kernel
+void
+setup_perf_metrics(int64_t _tid, bool _context_switches)
+{
+    if(!config::get_sampling_perf_metrics() || get_local_perf_metrics()) return;
+
+    auto& _v = get_perf_metrics(_tid);
+    if(!_v) _v = std::make_unique<perf_metrics>();
+
+    if(auto _err = open_software_counter(_v->page_flt_event, PERF_COUNT_SW_PAGE_FAULTS,
+                                         true))
+    {
+        OMNITRACE_VERBOSE(2, "[backtrace_metrics] failed to open the page faults "
+                             "counter :: %s\n",
+                          _err->c_str());
+        return;
+    }
+
+    if(_context_switches)
+    {
+        if(auto _err = open_software_counter(_v->ctx_swch_event,
+                                             PERF_COUNT_SW_CONTEXT_SWITCHES, false))
+        {
+            OMNITRACE_VERBOSE(2, "[backtrace_metrics] failed to open the context "
+                                 "switches counter :: %s\n",
+                              _err->c_str());
+            _v->page_flt_event.close();
+            return;
+        }
+    }
+
+    uint64_t _ctx_swch = 0;
+    uint64_t _page_flt = 0;
+    uint64_t _running  = 0;
+    if(!_v->page_flt_event.read_user_page(_page_flt, _running))
+    {
+        OMNITRACE_VERBOSE(2, "[backtrace_metrics] the time of the perf counters cannot "
+                             "be read from user-space\n");
+        _v->page_flt_event.close();
+        _v->ctx_swch_event.close();
+        return;
+    }
+    if(_context_switches) _v->ctx_swch_event.read_user_page(_ctx_swch, _running);
+    _page_flt = _v->page_flt_event.get_count();
+
+    auto _cache  = tim::rusage_cache{ RUSAGE_THREAD };
+    _v->interval = config::get_sampling_peak_rss_interval();
+    _v->cpu      = tim::get_clock_thread_now<int64_t, std::nano>() - _running;
+    _v->ctx_swch = _cache.get_num_priority_context_switch() +
+                   _cache.get_num_voluntary_context_switch() - _ctx_swch;
+    _v->page_flt = _cache.get_num_major_page_faults() +
+                   _cache.get_num_minor_page_faults() - _page_flt;
+    _v->mem_peak = _cache.get_peak_rss();
+    _v->faults   = _page_flt;
+    _v->active   = true;
+
+    get_local_perf_metrics() = _v.get();
+}
+
+void
+shutdown_perf_metrics()
+{
+    auto* _v = get_local_perf_metrics();
+    if(!_v) return;
+
+    _v->active = false;
+    _v->page_flt_event.close();
+    _v->ctx_swch_event.close();
+    get_local_perf_metrics() = nullptr;
+}
 }  // namespace
 
 std::string
@@ -153,13 +284,16 @@ auto get_enabled(tim::type_list<Tp...>)
     constexpr size_t N  = sizeof...(Tp);
     auto             _v = std::bitset<N>{};
     size_t           _n = 0;
-    (_v.set(_n++, trait::runtime_enabled<Tp>::get()), ...);
+    (_v.set(_n++, categories::is_enabled<Tp>()), ...);
     return _v;
 }
 }  // namespace
 void
 backtrace_metrics::sample(int)
 {
+    // the loop trip counts are recorded regardless of the enabled metrics
+    loop_trips::sample();
+
     if(!get_enabled(type_list<category::process_sampling, backtrace_metrics>{}).all())
     {
         m_valid.reset();
@@ -171,12 +305,40 @@ backtrace_metrics::sample(int)
     // return if everything is disabled
     if(!m_valid.any()) return;
 
-    auto _cache = tim::rusage_cache{ RUSAGE_THREAD };
-    m_cpu       = tim::get_clock_thread_now<int64_t, std::nano>();
-    m_mem_peak  = _cache.get_peak_rss();
-    m_ctx_swch  = _cache.get_num_priority_context_switch() +
-                 _cache.get_num_voluntary_context_switch();
-    m_page_flt = _cache.get_num_major_page_faults() + _cache.get_num_minor_page_faults();
+    auto*    _perf     = get_local_perf_metrics();
+    uint64_t _page_flt = 0;
+    uint64_t _running  = 0;
+    if(_perf && _perf->page_flt_event.read_user_page(_page_flt, _running))
+    {
+        // the page faults are refreshed with the peak RSS since the count in the page
+        // is the value when the thread was last scheduled in
+        if(_perf->count++ % _perf->interval == 0)
+        {
+            _perf->mem_peak = tim::rusage_cache{ RUSAGE_THREAD }.get_peak_rss();
+            _perf->faults   = _perf->page_flt_event.get_count();
+        }
+
+        uint64_t _ctx_swch = 0;
+        uint64_t _unused   = 0;
+        if(_perf->ctx_swch_event.is_open())
+            _perf->ctx_swch_event.read_user_page(_ctx_swch, _unused);
+
+        m_cpu      = _perf->cpu + static_cast<int64_t>(_running);
+        m_mem_peak = _perf->mem_peak;
+        m_ctx_swch = _perf->ctx_swch + static_cast<int64_t>(_ctx_swch);
+        m_page_flt =
+            _perf->page_flt + static_cast<int64_t>(std::max(_page_flt, _perf->faults));
+    }
+    else
+    {
+        auto _cache = tim::rusage_cache{ RUSAGE_THREAD };
+        m_cpu       = tim::get_clock_thread_now<int64_t, std::nano>();
+        m_mem_peak  = _cache.get_peak_rss();
+        m_ctx_swch  = _cache.get_num_priority_context_switch() +
+                     _cache.get_num_voluntary_context_switch();
+        m_page_flt =
+            _cache.get_num_major_page_faults() + _cache.get_num_minor_page_faults();
+    }
 
     if constexpr(tim::trait::is_available<hw_counters>::value)
     {
@@ -185,12 +347,56 @@ backtrace_metrics::sample(int)
             tim::index_of<category::thread_hardware_counter, categories_t>::value;
 
         auto _tid = threading::get_id();
-        if(m_valid.test(hw_category_idx) && m_valid.test(hw_counters_idx))
+        if(m_valid.test(hw_category_idx) && perf_counters::is_active())
+        {
+            // the counters of OMNITRACE_PERF_EVENTS are read from user-space
+            auto _values = perf_counters::values_t{};
+            auto _n      = std::min(perf_counters::read(_values), m_hw_counter.size());
+            for(size_t i = 0; i < _n; ++i)
+                m_hw_counter[i] = _values[i];
+            m_valid.set(hw_counters_idx);
+        }
+        else if(m_valid.test(hw_category_idx) && m_valid.test(hw_counters_idx))
         {
             assert(get_papi_vector(_tid).get() != nullptr);
             m_hw_counter = get_papi_vector(_tid)->record();
         }
     }
+
+    if(config::get_sampling_aggregate()) aggregate();
+}
+
+void
+backtrace_metrics::aggregate() const
+{
+    static thread_local backtrace_metrics _last
+        OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) = {};
+
+    auto*& _entry = backtrace::get_pending_entry();
+    if(_entry && _last)
+    {
+        auto _delta = *this - _last;
+        if(_delta(category::thread_cpu_time{}))
+        {
+            _entry->use_cpu = true;
+            _entry->cpu += _delta.m_cpu;
+        }
+
+        if constexpr(tim::trait::is_available<hw_counters>::value)
+        {
+            if(_delta(type_list<hw_counters>{}) &&
+               _delta(category::thread_hardware_counter{}))
+            {
+                _entry->use_hw = true;
+                auto _n        = std::min(_entry->hw.size(), _delta.m_hw_counter.size());
+                for(size_t i = 0; i < _n; ++i)
+                    _entry->hw[i] += _delta.m_hw_counter[i];
+            }
+        }
+    }
+
+    _entry = nullptr;
+    _last  = *this;
 }
 
 void
@@ -207,11 +413,27 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
         (void) get_debug_sampling();  // make sure query in sampler does not allocate
         assert(_tid == threading::get_id());
 
+        setup_perf_metrics(_tid,
+                           categories::is_enabled<category::thread_context_switch>());
+
         if constexpr(tim::trait::is_available<hw_counters>::value)
         {
             perfetto_counter_track<hw_counters>::init();
             OMNITRACE_DEBUG("HW COUNTER: starting...\n");
-            if(get_papi_vector(_tid))
+            if(!config::get_perf_events().empty() && perf_counters::setup())
+            {
+                auto _labels = perf_counters::get_labels(_tid);
+                if(_labels.size() > num_hw_counters)
+                {
+                    OMNITRACE_VERBOSE(1,
+                                      "Only the first %zu of the %zu perf events are "
+                                      "recorded in the samples\n",
+                                      num_hw_counters, _labels.size());
+                    _labels.resize(num_hw_counters);
+                }
+                *get_papi_labels(_tid) = std::move(_labels);
+            }
+            else if(get_papi_vector(_tid))
             {
                 get_papi_vector(_tid)->start();
                 *get_papi_labels(_tid) = get_papi_vector(_tid)->get_config()->labels;
@@ -223,11 +445,16 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
         OMNITRACE_DEBUG("Destroying sampler for thread %lu...\n", _tid);
         *_running = false;
 
+        if(_tid == threading::get_id()) shutdown_perf_metrics();
+
         if constexpr(tim::trait::is_available<hw_counters>::value)
         {
             if(_tid == threading::get_id())
             {
-                if(get_papi_vector(_tid)) get_papi_vector(_tid)->stop();
+                if(perf_counters::is_active())
+                    perf_counters::shutdown();
+                else if(get_papi_vector(_tid))
+                    get_papi_vector(_tid)->stop();
                 OMNITRACE_DEBUG("HW COUNTER: stopped...\n");
             }
         }
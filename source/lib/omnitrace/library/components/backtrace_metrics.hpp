@@ -123,6 +123,10 @@ struct backtrace_metrics : comp::empty_base
     }
 
 private:
+    // adds the metrics since the previous sample to the entry of the call-stack table
+    // which the sample was counted in (see OMNITRACE_SAMPLING_AGGREGATE)
+    void aggregate() const;
+
     valid_array_t     m_valid      = {};
     int64_t           m_cpu        = 0;
     int64_t           m_mem_peak   = 0;
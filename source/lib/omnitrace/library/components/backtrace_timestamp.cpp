@@ -21,6 +21,10 @@
 // SOFTWARE.
 
 #include "library/components/backtrace_timestamp.hpp"
+#include "core/config.hpp"
+#include "core/tsc.hpp"
+#include "library/python_sampling.hpp"
+#include "library/region_rates.hpp"
 #include "library/thread_info.hpp"
 
 #include <timemory/components/timing/backends.hpp>
@@ -43,10 +47,14 @@ backtrace_timestamp::is_valid() const
 }
 
 void
-backtrace_timestamp::sample(int)
+backtrace_timestamp::sample(int signo)
 {
-    m_tid  = tim::threading::get_id();
-    m_real = tim::get_clock_real_now<uint64_t, std::nano>();
+    m_tid    = tim::threading::get_id();
+    m_real   = tsc::get_clock_real_now();
+    m_weight = region_rates::get_weight(signo);
+
+    // the Python call-stack is matched with the native call-stack by the timestamp
+    if(signo != get_sampling_overflow_signal()) python_sampling::sample(m_tid, m_real);
 }
 }  // namespace component
 }  // namespace omnitrace
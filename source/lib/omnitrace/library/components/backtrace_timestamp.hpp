@@ -62,11 +62,13 @@ struct backtrace_timestamp : comp::empty_base
 
     auto get_tid() const { return m_tid; }
     auto get_timestamp() const { return m_real; }
+    auto get_weight() const { return m_weight; }
     bool is_valid() const;
 
 private:
-    int64_t  m_tid  = 0;
-    uint64_t m_real = 0;
+    int64_t  m_tid    = 0;
+    uint64_t m_real   = 0;
+    uint32_t m_weight = 1;  // see OMNITRACE_SAMPLING_REGION_RATES
 };
 }  // namespace component
 }  // namespace omnitrace
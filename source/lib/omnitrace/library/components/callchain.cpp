@@ -27,6 +27,7 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
+#include "core/self_profile.hpp"
 #include "core/state.hpp"
 #include "library/components/ensure_storage.hpp"
 #include "library/perf.hpp"
@@ -59,6 +60,7 @@
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <ctime>
@@ -179,6 +181,7 @@ callchain::sample(int signo)
 
     // on RedHat, the unw_step within get_unw_stack involves a mutex lock
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(sampling);
 
     static thread_local const auto& _tinfo      = thread_info::get();
     auto                            _tid        = _tinfo->index_data->sequent_value;
@@ -188,25 +191,44 @@ callchain::sample(int signo)
 
     _perf_event->stop();
 
+    // the precise events (e.g. IBS) also sample the memory operations
+    auto _has_data = _perf_event->is_sampling(perf::sample::data_src);
+
     for(auto itr : *_perf_event)
     {
         if(itr.is_sample())
         {
-            auto _ip        = itr.get_ip();
-            auto _data      = record{};
+            auto _ip = itr.get_ip();
+            // IBS samples the kernel when the kernel does not support excluding it
+            if(static_cast<int64_t>(_ip) < 0) continue;
+
+            auto  _chain    = itr.get_callchain();
+            auto* _beg      = _chain.data();
+            auto* _end      = _beg + _chain.size();
+            auto  _data     = record{};
             _data.timestamp = itr.get_time();
             _data.data.emplace_back(_ip);
-            bool _skip_ip = true;
-            for(auto ditr : itr.get_callchain())
+
+            if(_has_data)
             {
-                // skip the first instance of current IP but allow after that since this
-                // might be a recursive call
-                if(ditr == _ip && _skip_ip)
-                    _skip_ip = false;
-                else
-                    _data.data.emplace_back(ditr);
-                if(_data.data.size() == _data.data.capacity()) break;
+                _data.addr     = itr.get_addr();
+                _data.weight   = itr.get_weight();
+                _data.data_src = itr.get_data_src();
             }
+
+            // copies as much of the range as fits in the record
+            auto _append = [&_data](const uint64_t* _first, const uint64_t* _last) {
+                auto _n = std::min<size_t>(_last - _first,
+                                           _data.data.capacity() - _data.data.size());
+                _data.data.append(_first, _first + _n);
+            };
+
+            // skip the first instance of current IP but allow after that since this
+            // might be a recursive call
+            auto* _pos = std::find(_beg, _end, _ip);
+            _append(_beg, _pos);
+            if(_pos != _end) _append(_pos + 1, _end);
+
             if(!_data.data.empty()) m_data.emplace_back(_data);
         }
     }
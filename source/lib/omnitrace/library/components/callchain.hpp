@@ -53,6 +53,9 @@ struct callchain : comp::empty_base
     struct record
     {
         uint64_t                                         timestamp = 0;
+        uint64_t                                         addr      = 0;
+        uint64_t                                         weight    = 0;
+        uint64_t                                         data_src  = 0;
         container::static_vector<uintptr_t, stack_depth> data      = {};
 
         bool operator<(const record& rhs) const;
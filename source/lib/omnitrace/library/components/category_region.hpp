@@ -24,10 +24,17 @@
 
 #include "core/config.hpp"
 #include "core/defines.hpp"
+#include "core/hash_cache.hpp"
+#include "core/self_profile.hpp"
 #include "core/state.hpp"
 #include "core/timemory.hpp"
 #include "library/causal/data.hpp"
+#include "library/critical_path.hpp"
+#include "library/live_export.hpp"
+#include "library/region_attribution.hpp"
+#include "library/region_rates.hpp"
 #include "library/runtime.hpp"
+#include "library/trace_trigger.hpp"
 #include "library/tracing.hpp"
 #include "library/tracing/annotation.hpp"
 
@@ -38,6 +45,7 @@
 #include <timemory/utility/types.hpp>
 
 #include <string_view>
+#include <utility>
 
 namespace tim
 {
@@ -72,6 +80,31 @@ using causal_throughput_categories_t =
     type_list<category::host, category::kokkos, category::ompt, category::rocm_hip,
               category::rocm_hsa, category::rocm_rccl, category::rocm_roctx>;
 
+// these categories label the host time of the critical path
+using critical_path_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::rocm_roctx>;
+
+// the energy and the memory bandwidth of these categories are reported per region
+using region_attribution_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::rocm_roctx>;
+
+// these categories change the sampling rate of OMNITRACE_SAMPLING_REGION_RATES
+using sampling_rate_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::rocm_roctx>;
+
+// the count and the time of these categories are published by OMNITRACE_LIVE_EXPORT
+using live_export_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::rocm_roctx>;
+
+// these categories can open and close the windows of the region trace triggers
+using trace_trigger_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::rocm_roctx>;
+
 // define this outside of category region functions so that the
 // static thread_local is global instead of per-template instantiation
 inline ThreadState
@@ -100,6 +133,15 @@ struct category_region : comp::base<category_region<CategoryT>, void>
     template <typename... OptsT, typename... Args>
     static void stop(std::string_view name, Args&&...);
 
+    template <typename... OptsT, typename... Args>
+    static tracing::region_token start(tracing::region_handle, Args&&...);
+
+    template <typename... OptsT, typename... Args>
+    static void stop(tracing::region_handle, Args&&...);
+
+    template <typename... OptsT, typename... Args>
+    static void stop(tracing::region_token, Args&&...);
+
     template <typename... OptsT, typename... Args>
     static void mark(std::string_view name, Args&&...);
 
@@ -124,23 +166,52 @@ template <typename... OptsT, typename... Args>
 void
 category_region<CategoryT>::start(std::string_view name, Args&&... args)
 {
+    start<OptsT...>(tracing::region_handle{ 0, name }, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+{
+    stop<OptsT...>(tracing::region_handle{ 0, name }, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+tracing::region_token
+category_region<CategoryT>::start(tracing::region_handle _region, Args&&... args)
+{
+    using return_type = tracing::region_token;
+
+    auto& name = _region.name;
+
+    // before the category check since the trigger may enable the category
+    if constexpr(is_one_of<CategoryT, trace_trigger_categories_t>::value)
+    {
+        if(OMNITRACE_UNLIKELY(trace_trigger::get_enabled().region))
+            trace_trigger::region_begin(name);
+    }
+
     // skip if category is disabled
-    if(tracing::category_push_disabled<CategoryT>()) return;
+    if(tracing::category_push_disabled<CategoryT>()) return return_type{};
 
     // unconditionally return if thread is disabled or finalized
-    if(get_thread_state() == ThreadState::Disabled) return;
-    if(get_state() >= State::Finalized) return;
+    if(get_thread_state() == ThreadState::Disabled) return return_type{};
+    if(get_state() >= State::Finalized) return return_type{};
 
-    if(name.empty()) return;
+    if(name.empty()) return return_type{};
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(region);
 
     // the expectation here is that if the state is not active then the call
     // to omnitrace_init_tooling_hidden will activate all the appropriate
     // tooling one time and as it exits set it to active and return true.
-    if(get_state() != State::Active && !omnitrace_init_tooling_hidden()) return;
+    if(get_state() != State::Active && !omnitrace_init_tooling_hidden())
+        return return_type{};
 
-    if(get_thread_status() == ThreadState::Disabled) return;
+    if(get_thread_status() == ThreadState::Disabled) return return_type{};
 
     constexpr bool _ct_use_timemory =
         (sizeof...(OptsT) == 0 || is_one_of<quirk::timemory, type_list<OptsT...>>::value);
@@ -162,8 +233,12 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
         ++tracing::push_count();
     }
 
-    auto _hash = tim::add_hash_id(name);
-    name       = tim::get_hash_identifier_fast(_hash);
+    // registered regions already hold the hash and the persistent name
+    if(_region.hash == 0)
+    {
+        _region.hash = hash_cache::add_hash_id(name);
+        name         = tim::get_hash_identifier_fast(_region.hash);
+    }
 
     if constexpr(_ct_use_causal)
     {
@@ -173,11 +248,43 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
         }
     }
 
+    if constexpr(is_one_of<CategoryT, critical_path_categories_t>::value)
+    {
+        if(config::get_snapshot().critical_path)
+            critical_path::region_begin(_region.hash);
+    }
+
+    if constexpr(is_one_of<CategoryT, region_attribution_categories_t>::value)
+    {
+        if(config::get_snapshot().region_attribution)
+            region_attribution::region_begin(_region.hash);
+    }
+
+    if constexpr(is_one_of<CategoryT, sampling_rate_categories_t>::value)
+    {
+        if(config::get_snapshot().sampling_region_rates)
+            region_rates::region_begin(_region.hash);
+    }
+
+    if constexpr(is_one_of<CategoryT, live_export_categories_t>::value)
+    {
+        if(config::get_snapshot().live_export) live_export::region_begin(_region.hash);
+    }
+
+    auto _bundle = std::pair<instrumentation_bundle_t*, size_t>{ nullptr, 0 };
+    auto _serial = uint64_t{ 0 };
     if constexpr(_ct_use_timemory)
     {
         if(get_use_timemory())
         {
-            tracing::push_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+            OMNITRACE_SELF_PROFILE_SCOPE(timemory);
+            if(config::get_snapshot().timeline_profile_compact)
+                tracing::push_timeline(CategoryT{}, _region.hash);
+            else
+                _bundle = tracing::push_timemory(CategoryT{}, _region.hash,
+                                                 std::forward<Args>(args)...);
+            if(_bundle.first)
+                _serial = tracing::get_instrumentation_bundles()->serial(_bundle.second);
         }
     }
 
@@ -185,22 +292,43 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
     {
         if(get_use_perfetto())
         {
+            OMNITRACE_SELF_PROFILE_SCOPE(perfetto);
             tracing::push_perfetto(CategoryT{}, name.data(), std::forward<Args>(args)...);
         }
     }
+
+    return return_type{ _region, _bundle.first, _bundle.second, _serial };
 }
 
 template <typename CategoryT>
 template <typename... OptsT, typename... Args>
 void
-category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+category_region<CategoryT>::stop(tracing::region_handle _region, Args&&... args)
 {
+    stop<OptsT...>(tracing::region_token{ _region }, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(tracing::region_token _token, Args&&... args)
+{
+    auto& name = _token.region.name;
+
+    // a window closed by the trigger still pops the region since the stack is not empty
+    if constexpr(is_one_of<CategoryT, trace_trigger_categories_t>::value)
+    {
+        if(OMNITRACE_UNLIKELY(trace_trigger::get_enabled().region))
+            trace_trigger::region_end(name);
+    }
+
     // skip if category is disabled
     if(tracing::category_pop_disabled<CategoryT>()) return;
 
     if(get_thread_state() == ThreadState::Disabled) return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(region);
 
     constexpr bool _ct_use_timemory =
         (sizeof...(OptsT) == 0 || is_one_of<quirk::timemory, type_list<OptsT...>>::value);
@@ -229,6 +357,7 @@ category_region<CategoryT>::stop(std::string_view name, Args&&... args)
         {
             if(get_use_perfetto())
             {
+                OMNITRACE_SELF_PROFILE_SCOPE(perfetto);
                 tracing::pop_perfetto(CategoryT{}, name.data(),
                                       std::forward<Args>(args)...);
             }
@@ -238,7 +367,17 @@ category_region<CategoryT>::stop(std::string_view name, Args&&... args)
         {
             if(get_use_timemory())
             {
-                tracing::pop_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+                OMNITRACE_SELF_PROFILE_SCOPE(timemory);
+                if(config::get_snapshot().timeline_profile_compact)
+                {
+                    auto _hash = _token.region.hash;
+                    tracing::pop_timeline(CategoryT{}, (_hash != 0)
+                                                           ? _hash
+                                                           : tim::hash::get_hash_id(name));
+                }
+                else
+                    tracing::pop_timemory(CategoryT{}, _token,
+                                          std::forward<Args>(args)...);
             }
         }
 
@@ -253,6 +392,46 @@ category_region<CategoryT>::stop(std::string_view name, Args&&... args)
                 if(get_use_causal()) causal::pop_progress_point(name);
             }
         }
+
+        if constexpr(is_one_of<CategoryT, critical_path_categories_t>::value)
+        {
+            if(config::get_snapshot().critical_path)
+            {
+                auto _hash = _token.region.hash;
+                critical_path::region_end((_hash != 0) ? _hash
+                                                       : hash_cache::add_hash_id(name));
+            }
+        }
+
+        if constexpr(is_one_of<CategoryT, region_attribution_categories_t>::value)
+        {
+            if(config::get_snapshot().region_attribution)
+            {
+                auto _hash = _token.region.hash;
+                region_attribution::region_end(
+                    (_hash != 0) ? _hash : hash_cache::add_hash_id(name));
+            }
+        }
+
+        if constexpr(is_one_of<CategoryT, sampling_rate_categories_t>::value)
+        {
+            if(config::get_snapshot().sampling_region_rates)
+            {
+                auto _hash = _token.region.hash;
+                region_rates::region_end((_hash != 0) ? _hash
+                                                      : hash_cache::add_hash_id(name));
+            }
+        }
+
+        if constexpr(is_one_of<CategoryT, live_export_categories_t>::value)
+        {
+            if(config::get_snapshot().live_export)
+            {
+                auto _hash = _token.region.hash;
+                live_export::region_end((_hash != 0) ? _hash
+                                                     : hash_cache::add_hash_id(name));
+            }
+        }
     }
     else
     {
@@ -285,6 +464,7 @@ category_region<CategoryT>::mark(std::string_view name, Args&&...)
     if(get_thread_state() >= ThreadState::Completed) return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(region);
 
     if(get_use_causal())
     {
@@ -374,14 +554,21 @@ struct local_category_region : comp::base<local_category_region<CategoryT>, void
     auto start(Args&&... args)
     {
         if(m_prefix.empty()) return;
-        return impl_type::template start<OptsT...>(m_prefix, std::forward<Args>(args)...);
+        m_token = impl_type::template start<OptsT...>(
+            tracing::region_handle{ 0, m_prefix }, std::forward<Args>(args)...);
     }
 
+    // the token from start locates the bundle without searching the stack. If start
+    // returned early, the token is empty and the pop falls back to the prefix
     template <typename... OptsT, typename... Args>
     auto stop(Args&&... args)
     {
         if(m_prefix.empty()) return;
-        return impl_type::template stop<OptsT...>(m_prefix, std::forward<Args>(args)...);
+        auto _token = std::exchange(m_token, tracing::region_token{});
+        if(_token.region.name.empty())
+            return impl_type::template stop<OptsT...>(m_prefix,
+                                                      std::forward<Args>(args)...);
+        return impl_type::template stop<OptsT...>(_token, std::forward<Args>(args)...);
     }
 
     template <typename... OptsT, typename... Args>
@@ -411,7 +598,8 @@ struct local_category_region : comp::base<local_category_region<CategoryT>, void
     void set_prefix(std::string_view _v) { m_prefix = _v; }
 
 private:
-    std::string_view m_prefix = {};
+    std::string_view      m_prefix = {};
+    tracing::region_token m_token  = {};
 };
 }  // namespace component
 }  // namespace omnitrace
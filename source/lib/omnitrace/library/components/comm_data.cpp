@@ -24,6 +24,9 @@
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/perfetto.hpp"
+#include "core/self_profile.hpp"
+#include "library/comm_histogram.hpp"
+#include "library/live_export.hpp"
 #include "library/tracing.hpp"
 
 #include <timemory/backends/mpi.hpp>
@@ -31,12 +34,36 @@
 #include <timemory/units.hpp>
 #include <timemory/utility/locking.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+
 namespace omnitrace
 {
 namespace component
 {
 namespace
 {
+// the running total of a counter track and the value which was written last. When a
+// resolution is set, the bytes communicated after the last update of the track are
+// written by comm_data::flush()
+struct counter_total
+{
+    std::atomic<uint64_t> value   = { 0 };
+    std::atomic<uint64_t> next    = { 0 };
+    std::atomic<uint64_t> written = { 0 };
+};
+
+template <typename Tp>
+counter_total&
+get_counter_total()
+{
+    static auto _v = counter_total{};
+    return _v;
+}
+
 template <typename Tp, typename... Args>
 void
 write_perfetto_counter_track(uint64_t _val)
@@ -60,18 +87,109 @@ write_perfetto_counter_track(uint64_t _val)
         static std::once_flag _once{};
         std::call_once(_once, _emplace, _idx);
 
-        static std::mutex _mutex{};
-        static uint64_t   value = 0;
-        uint64_t          _now  = 0;
+        // the running total is accumulated lock-free. When a resolution is set, only
+        // the thread which claims the next update interval writes the counter
+        auto& _total  = get_counter_total<Tp>();
+        auto  _period = static_cast<uint64_t>(
+            std::max<double>(config::get_snapshot().comm_data_resolution, 0.0) *
+            units::msec);
+
+        auto _value = _total.value.fetch_add(_val, std::memory_order_relaxed) + _val;
+        auto _now   = omnitrace::tracing::now<uint64_t>();
+        if(_period > 0)
+        {
+            auto _prev = _total.next.load(std::memory_order_relaxed);
+            if(_now < _prev || !_total.next.compare_exchange_strong(
+                                   _prev, _now + _period, std::memory_order_relaxed))
+                return;
+            _value = _total.value.load(std::memory_order_relaxed);
+        }
+
+        TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _now, _value);
+        _total.written.store(_value, std::memory_order_relaxed);
+    }
+}
+
+// writes the total when it changed after the last update of the counter track
+template <typename Tp>
+void
+flush_perfetto_counter_track()
+{
+    using counter_track = omnitrace::perfetto_counter_track<Tp>;
+
+    auto& _total = get_counter_total<Tp>();
+    auto  _value = _total.value.load(std::memory_order_relaxed);
+    if(!omnitrace::get_use_perfetto() || !counter_track::exists(0) ||
+       _total.written.load(std::memory_order_relaxed) == _value)
+        return;
+
+    TRACE_COUNTER(Tp::value, counter_track::at(0, 0),
+                  omnitrace::tracing::now<uint64_t>(), _value);
+    _total.written.store(_value, std::memory_order_relaxed);
+}
+
+bool
+use_comm_histogram()
+{
+    return config::get_snapshot().use_comm_histogram &&
+           omnitrace::get_state() == omnitrace::State::Active;
+}
+
+#if defined(OMNITRACE_USE_MPI)
+void
+record_histogram(const gotcha_data& _data, MPI_Comm _comm, int _peer, uint64_t _bytes)
+{
+    if(config::get_snapshot().live_export) live_export::record_comm(_bytes);
+
+    if(!use_comm_histogram()) return;
+
+    auto _handle = (uintptr_t) _comm;  // NOLINT
+    if(!comm_histogram::is_registered(_handle))
+    {
+        auto _info = comm_histogram::comm_info{};
+        PMPI_Comm_rank(_comm, &_info.rank);
+        PMPI_Comm_size(_comm, &_info.size);
+        if(_comm == MPI_COMM_WORLD)
+        {
+            _info.label = "MPI_COMM_WORLD";
+        }
+        else
         {
-            std::unique_lock<std::mutex> _lk{ _mutex };
-            _now = omnitrace::tracing::now<uint64_t>();
-            _val = (value += _val);
+            char _name[MPI_MAX_OBJECT_NAME] = {};
+            int  _len                       = 0;
+            PMPI_Comm_get_name(_comm, _name, &_len);
+            _info.label = (_len > 0) ? std::string{ _name, static_cast<size_t>(_len) }
+                                     : JOIN("", "MPI_Comm[size=", _info.size, ']');
         }
+        comm_histogram::register_comm(_handle, std::move(_info));
+    }
+
+    comm_histogram::record(_data.tool_id, _handle, _peer, _bytes);
+}
+#endif
+
+#if defined(OMNITRACE_USE_RCCL)
+void
+record_histogram(const gotcha_data& _data, ncclComm_t _comm, int _peer, uint64_t _bytes)
+{
+    if(config::get_snapshot().live_export) live_export::record_comm(_bytes);
+
+    if(!use_comm_histogram()) return;
 
-        TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _now, _val);
+    // communicators are labeled in the order they are first used by the process
+    static auto _count  = std::atomic<int>{ 0 };
+    auto        _handle = reinterpret_cast<uintptr_t>(_comm);
+    if(!comm_histogram::is_registered(_handle))
+    {
+        auto _info  = comm_histogram::comm_info{};
+        _info.rank  = dmp::rank();
+        _info.label = JOIN("", "ncclComm[", _count++, ']');
+        comm_histogram::register_comm(_handle, std::move(_info));
     }
+
+    comm_histogram::record(_data.tool_id, _handle, _peer, _bytes);
 }
+#endif
 }  // namespace
 
 void
@@ -86,6 +204,15 @@ comm_data::global_finalize()
     configure();
 }
 
+void
+comm_data::flush()
+{
+    flush_perfetto_counter_track<mpi_send>();
+    flush_perfetto_counter_track<mpi_recv>();
+    flush_perfetto_counter_track<rccl_send>();
+    flush_perfetto_counter_track<rccl_recv>();
+}
+
 void
 comm_data::configure()
 {
@@ -109,12 +236,14 @@ comm_data::configure()
 // MPI_Send
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm _comm)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_histogram(_data, _comm, dst, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -128,12 +257,14 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int cou
 // MPI_Recv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Status*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm _comm, MPI_Status*)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
+    record_histogram(_data, _comm, dst, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -147,12 +278,14 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
 // MPI_Isend
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Request*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm _comm, MPI_Request*)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_histogram(_data, _comm, dst, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -166,12 +299,14 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int cou
 // MPI_Irecv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Request*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm _comm, MPI_Request*)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
+    record_histogram(_data, _comm, dst, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -185,12 +320,14 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
 // MPI_Bcast
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int root, MPI_Comm)
+                 MPI_Datatype datatype, int root, MPI_Comm _comm)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_histogram(_data, _comm, root, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -202,13 +339,15 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
 // MPI_Allreduce
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, void*, int count,
-                 MPI_Datatype datatype, MPI_Op, MPI_Comm)
+                 MPI_Datatype datatype, MPI_Op, MPI_Comm _comm)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
     write_perfetto_counter_track<mpi_send>(count * _size);
+    record_histogram(_data, _comm, -1, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     add(_data, count * _size);
@@ -218,14 +357,18 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, void*,
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, int dst, int sendtag, void*, int recvcount,
-                 MPI_Datatype recvtype, int src, int recvtag, MPI_Comm, MPI_Status*)
+                 MPI_Datatype recvtype, int src, int recvtag, MPI_Comm _comm,
+                 MPI_Status*)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
     if(_send_size == 0 || _recv_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
+    record_histogram(_data, _comm, dst, sendcount * _send_size);
+    record_histogram(_data, _comm, src, recvcount * _recv_size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -256,14 +399,21 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, void*, int recvcount, MPI_Datatype recvtype,
-                 int root, MPI_Comm)
+                 int root, MPI_Comm _comm)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
     if(_send_size == 0 || _recv_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
+    // the message of each rank is the send buffer of a gather and the receive buffer
+    // of a scatter
+    record_histogram(_data, _comm, root,
+                     (_data.tool_id.find("Scatter") != std::string::npos)
+                         ? recvcount * _recv_size
+                         : sendcount * _send_size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -279,14 +429,16 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, void*, int recvcount, MPI_Datatype recvtype,
-                 MPI_Comm)
+                 MPI_Comm _comm)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
     if(_send_size == 0 || _recv_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
+    record_histogram(_data, _comm, -1, sendcount * _send_size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -301,13 +453,15 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
 // ncclReduce
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, ncclRedOp_t, int root, ncclComm_t,
-                 hipStream_t)
+                 size_t count, ncclDataType_t datatype, ncclRedOp_t, int root,
+                 ncclComm_t _comm, hipStream_t)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
 
     write_perfetto_counter_track<rccl_recv>(count * _size);
+    record_histogram(_data, _comm, root, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -322,8 +476,9 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
 // ncclRecv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, size_t count,
-                 ncclDataType_t datatype, int peer, ncclComm_t, hipStream_t)
+                 ncclDataType_t datatype, int peer, ncclComm_t _comm, hipStream_t)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
 
@@ -344,6 +499,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, size_t
     }
 
     write_perfetto_counter_track<rccl_recv>(count * _size);
+    record_histogram(_data, _comm, peer, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto        _name  = std::string_view{ _data.tool_id };
@@ -358,12 +514,15 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, size_t
 // ncclBroadcast
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, int root, ncclComm_t, hipStream_t)
+                 size_t count, ncclDataType_t datatype, int root, ncclComm_t _comm,
+                 hipStream_t)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
 
     write_perfetto_counter_track<rccl_send>(count * _size);
+    record_histogram(_data, _comm, root, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -376,9 +535,10 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
 // ncclReduceScatter
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, ncclRedOp_t, ncclComm_t,
+                 size_t count, ncclDataType_t datatype, ncclRedOp_t, ncclComm_t _comm,
                  hipStream_t)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
 
@@ -397,6 +557,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
     {
         OMNITRACE_CI_THROW(true, "RCCL function not handled: %s", _data.tool_id.c_str());
     }
+    record_histogram(_data, _comm, -1, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     add(_data, count * _size);
@@ -405,12 +566,14 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
 // ncclAllGather
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, ncclComm_t, hipStream_t)
+                 size_t count, ncclDataType_t datatype, ncclComm_t _comm, hipStream_t)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
 
     write_perfetto_counter_track<rccl_recv>(count * _size);
+    record_histogram(_data, _comm, -1, count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
     add(_data, count * _size);
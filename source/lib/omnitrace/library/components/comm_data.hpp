@@ -95,6 +95,7 @@ struct comm_data : base<comm_data, void>
     static void preinit();
     static void configure();
     static void global_finalize();
+    static void flush();
     static void start() {}
     static void stop() {}
 
@@ -27,6 +27,7 @@
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
+#include "core/procfs_reader.hpp"
 #include "core/timemory.hpp"
 
 #include <timemory/components/macros.hpp>
@@ -36,6 +37,8 @@
 #include <timemory/utility/procfs/cpuinfo.hpp>
 #include <timemory/utility/type_list.hpp>
 
+#include <optional>
+
 namespace cpuinfo = tim::procfs::cpuinfo;
 
 namespace omnitrace
@@ -142,15 +145,23 @@ cpu_freq::configure()
         }
     }
 
-    if(!cpuinfo::freq{})
+    // prefer the per-cpu cpufreq sysfs files over re-parsing /proc/cpuinfo
+    bool _has_cpufreq = procfs_reader::get_cpu_freq(0).has_value();
+    bool _has_cpuinfo = _has_cpufreq || static_cast<bool>(cpuinfo::freq{});
+
+    if(!_has_cpuinfo)
     {
         OMNITRACE_VERBOSE(0, "[cpu_freq::config] Warning! CPU frequencies are disabled "
                              ":: unable to open /proc/cpuinfo");
         _enabled_freqs.clear();
     }
 
-    OMNITRACE_CI_FAIL(!cpuinfo::freq{}, "[cpu_freq::config] CPU frequencies are disabled "
-                                        ":: unable to open /proc/cpuinfo");
+    OMNITRACE_CI_FAIL(!_has_cpuinfo, "[cpu_freq::config] CPU frequencies are disabled "
+                                     ":: unable to open /proc/cpuinfo");
+
+    OMNITRACE_VERBOSE(2, "[cpu_freq::config] reading CPU frequencies from %s\n",
+                      (_has_cpufreq) ? "/sys/devices/system/cpu/cpu*/cpufreq"
+                                     : "/proc/cpuinfo");
 
     get_enabled_cpus() = _enabled_freqs;
 }
@@ -170,10 +181,17 @@ cpu_freq::record()
     if(!enabled_cpu_freqs.empty())
     {
         _freqs.reserve(enabled_cpu_freqs.size());
-        auto&& _freq = cpuinfo::freq{};
+        // /proc/cpuinfo is only parsed when scaling_cur_freq is unavailable
+        auto _cpuinfo = std::optional<cpuinfo::freq>{};
         for(const auto& itr : enabled_cpu_freqs)
         {
-            _freqs.emplace_back(_freq(itr) * tim::units::MHz);
+            if(auto _khz = procfs_reader::get_cpu_freq(itr))
+            {
+                _freqs.emplace_back(*_khz * tim::units::kHz);
+                continue;
+            }
+            if(!_cpuinfo) _cpuinfo.emplace();
+            _freqs.emplace_back((*_cpuinfo)(itr) * tim::units::MHz);
         }
     }
 
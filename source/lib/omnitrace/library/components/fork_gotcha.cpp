@@ -22,12 +22,14 @@
 
 #include "api.hpp"
 
+#include "core/categories.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
 #include "core/perfetto_fwd.hpp"
 #include "core/state.hpp"
 #include "library/components/fork_gotcha.hpp"
+#include "library/fork_capture.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 
@@ -52,12 +54,17 @@ bool prefork_lock         = false;
 bool postfork_parent_lock = false;
 bool postfork_child_lock  = false;
 
+// the enabled categories which prefork disabled, i.e. the categories of a closed trace
+// window are not re-enabled in the parent
+uint64_t prefork_categories = 0;
+
 // this does a quick exit (no cleanup) on child processes
 // because perfetto has a tendency to access memory it
 // shouldn't during cleanup
 void
 child_exit(int _ec, void*)
 {
+    fork_capture::post_process();
     std::quick_exit(_ec);
 }
 
@@ -84,7 +91,10 @@ prefork_setup()
 
     if(config::get_use_sampling()) sampling::block_samples();
 
-    omnitrace::categories::disable_categories(config::get_enabled_categories());
+    prefork_categories =
+        omnitrace::categories::enabled_mask.load() &
+        omnitrace::categories::get_mask(config::get_enabled_categories());
+    omnitrace::categories::disable_categories(prefork_categories);
 
     // prevent re-entry until post-fork routines have been called
     prefork_lock         = true;
@@ -97,7 +107,7 @@ postfork_parent()
 {
     if(postfork_parent_lock) return;
 
-    omnitrace::categories::enable_categories(config::get_enabled_categories());
+    omnitrace::categories::enable_categories(prefork_categories);
 
     if(config::get_use_sampling()) sampling::unblock_samples();
 
@@ -115,15 +125,23 @@ postfork_child()
         << "Error! child process " << process::get_id()
         << " believes it is the root process " << get_root_process_id() << "\n";
 
+    // the child reuses the configuration of the parent when it is captured so the
+    // messages of the capture are not silenced
+    bool _capture = config::get_fork_child_capture();
+
     settings::enabled() = false;
-    settings::verbose() = -127;
     settings::debug()   = false;
+    if(!_capture) settings::verbose() = -127;
     omnitrace::sampling::shutdown();
     omnitrace::categories::shutdown();
     set_thread_state(::omnitrace::ThreadState::Disabled);
 
     omnitrace::get_perfetto_session(process::get_parent_id()).release();
 
+    // the backends of the parent stay disabled: their background threads do not
+    // exist in the child
+    if(_capture) fork_capture::setup();
+
     // register these exit handlers to avoid cleaning up resources
     on_exit(&child_exit, nullptr);
     std::atexit([]() { child_exit(EXIT_SUCCESS, nullptr); });
@@ -139,6 +157,7 @@ fork_gotcha::configure()
 {
     fork_gotcha_t::get_initializer() = []() {
         TIMEMORY_C_GOTCHA(fork_gotcha_t, 0, fork);
+        if(config::get_fork_child_capture()) TIMEMORY_C_GOTCHA(fork_gotcha_t, 1, _exit);
     };
 
     // registering the pthread_atfork and gotcha means that we might execute twice
@@ -174,5 +193,13 @@ fork_gotcha::operator()(const gotcha_data_t&, pid_t (*_real_fork)()) const
 
     return _pid;
 }
+
+void
+fork_gotcha::operator()(const gotcha_data_t&, void (*_real_exit)(int), int _ec) const
+{
+    if(is_child_process()) fork_capture::post_process();
+
+    (*_real_exit)(_ec);
+}
 }  // namespace component
 }  // namespace omnitrace
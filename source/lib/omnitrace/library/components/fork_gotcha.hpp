@@ -33,7 +33,7 @@ namespace component
 // this is used to wrap fork()
 struct fork_gotcha : comp::base<fork_gotcha, void>
 {
-    static constexpr size_t gotcha_capacity = 1;
+    static constexpr size_t gotcha_capacity = 2;
 
     using gotcha_data_t = comp::gotcha_data;
 
@@ -48,6 +48,10 @@ struct fork_gotcha : comp::base<fork_gotcha, void>
     // this will get called right before fork
     pid_t operator()(const gotcha_data_t&, pid_t (*)()) const;
 
+    // this will get called right before _exit in a child captured with
+    // OMNITRACE_FORK_CHILD_CAPTURE (e.g. os._exit in python multiprocessing)
+    void operator()(const gotcha_data_t&, void (*)(int), int) const;
+
     // silence SFINAE disabled for omnitrace::fork_gotcha warnings
     static inline void start() {}
     static inline void stop() {}
@@ -0,0 +1,250 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/io_gotcha.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "library/io_trace.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/utility/types.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+auto&
+get_io_gotcha()
+{
+    static auto _v = tim::lightweight_tuple<io_gotcha_t>{};
+    return _v;
+}
+
+bool
+is_traced(const io_trace::scoped_guard& _guard)
+{
+    return !_guard.nested() && get_state() == ::omnitrace::State::Active &&
+           get_thread_state() == ThreadState::Enabled;
+}
+
+// the errno of the call is restored after the recording
+template <typename Tp>
+void
+record(const io_gotcha::gotcha_data_t& _data, int _fd, Tp _ret, uint64_t _beg,
+       const char* _path = nullptr)
+{
+    auto _end   = tracing::now();
+    auto _errno = errno;
+    auto _op    = io_trace::get_operation(_data.tool_id);
+    if(_op == io_trace::open_operation && _ret >= 0)
+        io_trace::record_open(static_cast<int>(_ret), _path);
+    io_trace::record(_data.tool_id.c_str(), _op, _fd, static_cast<int64_t>(_ret), _beg,
+                     _end);
+    errno = _errno;
+}
+}  // namespace
+
+void
+io_gotcha::configure()
+{
+    io_gotcha_t::get_initializer() = []() {
+        io_gotcha_t::configure<0, ssize_t, int, void*, size_t>("read");
+        io_gotcha_t::configure<1, ssize_t, int, const void*, size_t>("write");
+        io_gotcha_t::configure<2, ssize_t, int, void*, size_t, off_t>("pread");
+        io_gotcha_t::configure<3, ssize_t, int, void*, size_t, off_t>("pread64");
+        io_gotcha_t::configure<4, ssize_t, int, const void*, size_t, off_t>("pwrite");
+        io_gotcha_t::configure<5, ssize_t, int, const void*, size_t, off_t>("pwrite64");
+        io_gotcha_t::configure<6, ssize_t, int, const struct iovec*, int>("readv");
+        io_gotcha_t::configure<7, ssize_t, int, const struct iovec*, int>("writev");
+        // off64_t is off_t on the 64-bit platforms
+        io_gotcha_t::configure<8, ssize_t, int, const struct iovec*, int, off_t>(
+            "preadv");
+        io_gotcha_t::configure<9, ssize_t, int, const struct iovec*, int, off_t>(
+            "preadv64");
+        io_gotcha_t::configure<10, ssize_t, int, const struct iovec*, int, off_t>(
+            "pwritev");
+        io_gotcha_t::configure<11, ssize_t, int, const struct iovec*, int, off_t>(
+            "pwritev64");
+        io_gotcha_t::configure<12, int, const char*, int, mode_t>("open");
+        io_gotcha_t::configure<13, int, const char*, int, mode_t>("open64");
+        io_gotcha_t::configure<14, int, int, const char*, int, mode_t>("openat");
+        io_gotcha_t::configure<15, int, int, const char*, int, mode_t>("openat64");
+        io_gotcha_t::configure<16, int, int>("close");
+        io_gotcha_t::configure<17, int, int>("fsync");
+        io_gotcha_t::configure<18, int, int>("fdatasync");
+    };
+}
+
+void
+io_gotcha::shutdown()
+{
+    io_gotcha_t::disable();
+}
+
+void
+io_gotcha::start()
+{
+    if(!io_trace::is_enabled()) return;
+
+    if(!get_io_gotcha().get<io_gotcha_t>()->get_is_running())
+    {
+        OMNITRACE_VERBOSE(1, "[io_trace] Wrapping the POSIX I/O functions...\n");
+        configure();
+        get_io_gotcha().start();
+    }
+}
+
+void
+io_gotcha::stop()
+{}
+
+ssize_t
+io_gotcha::operator()(const gotcha_data_t& _data, ssize_t (*_func)(int, void*, size_t),
+                      int _fd, void* _buf, size_t _count) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_fd, _buf, _count);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_fd, _buf, _count);
+    record(_data, _fd, _ret, _beg);
+    return _ret;
+}
+
+ssize_t
+io_gotcha::operator()(const gotcha_data_t& _data,
+                      ssize_t (*_func)(int, const void*, size_t), int _fd,
+                      const void* _buf, size_t _count) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_fd, _buf, _count);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_fd, _buf, _count);
+    record(_data, _fd, _ret, _beg);
+    return _ret;
+}
+
+ssize_t
+io_gotcha::operator()(const gotcha_data_t& _data,
+                      ssize_t (*_func)(int, void*, size_t, off_t), int _fd, void* _buf,
+                      size_t _count, off_t _offset) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_fd, _buf, _count, _offset);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_fd, _buf, _count, _offset);
+    record(_data, _fd, _ret, _beg);
+    return _ret;
+}
+
+ssize_t
+io_gotcha::operator()(const gotcha_data_t& _data,
+                      ssize_t (*_func)(int, const void*, size_t, off_t), int _fd,
+                      const void* _buf, size_t _count, off_t _offset) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_fd, _buf, _count, _offset);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_fd, _buf, _count, _offset);
+    record(_data, _fd, _ret, _beg);
+    return _ret;
+}
+
+ssize_t
+io_gotcha::operator()(const gotcha_data_t& _data,
+                      ssize_t (*_func)(int, const struct iovec*, int), int _fd,
+                      const struct iovec* _iov, int _iovcnt) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_fd, _iov, _iovcnt);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_fd, _iov, _iovcnt);
+    record(_data, _fd, _ret, _beg);
+    return _ret;
+}
+
+ssize_t
+io_gotcha::operator()(const gotcha_data_t& _data,
+                      ssize_t (*_func)(int, const struct iovec*, int, off_t), int _fd,
+                      const struct iovec* _iov, int _iovcnt, off_t _offset) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_fd, _iov, _iovcnt, _offset);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_fd, _iov, _iovcnt, _offset);
+    record(_data, _fd, _ret, _beg);
+    return _ret;
+}
+
+int
+io_gotcha::operator()(const gotcha_data_t& _data, int (*_func)(const char*, int, mode_t),
+                      const char* _path, int _flags, mode_t _mode) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_path, _flags, _mode);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_path, _flags, _mode);
+    record(_data, -1, _ret, _beg, _path);
+    return _ret;
+}
+
+int
+io_gotcha::operator()(const gotcha_data_t& _data,
+                      int (*_func)(int, const char*, int, mode_t), int _dirfd,
+                      const char* _path, int _flags, mode_t _mode) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_dirfd, _path, _flags, _mode);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_dirfd, _path, _flags, _mode);
+    record(_data, -1, _ret, _beg, _path);
+    return _ret;
+}
+
+int
+io_gotcha::operator()(const gotcha_data_t& _data, int (*_func)(int), int _fd) const
+{
+    auto _guard = io_trace::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_fd);
+
+    auto _beg = tracing::now();
+    auto _ret = (*_func)(_fd);
+    record(_data, _fd, _ret, _beg);
+    return _ret;
+}
+}  // namespace component
+}  // namespace omnitrace
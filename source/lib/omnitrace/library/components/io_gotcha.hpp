@@ -0,0 +1,95 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace omnitrace
+{
+namespace component
+{
+// this is used to wrap the POSIX I/O functions for the I/O trace (see
+// OMNITRACE_IO_TRACE). The functions with the same signature (e.g. readv and writev)
+// are distinguished by the name of the wrapped function. open and openat are wrapped
+// with the mode argument, which is only read by the callee when the flags create a file
+struct io_gotcha : tim::component::base<io_gotcha, void>
+{
+    static constexpr size_t gotcha_capacity = 19;
+
+    using gotcha_data_t = tim::component::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(io_gotcha)
+
+    // string id for component
+    static std::string label() { return "io_gotcha"; }
+
+    // generate the gotcha wrappers
+    static void configure();
+    static void shutdown();
+
+    static void start();
+    static void stop();
+
+    // read
+    ssize_t operator()(const gotcha_data_t&, ssize_t (*)(int, void*, size_t), int, void*,
+                       size_t) const;
+    // write
+    ssize_t operator()(const gotcha_data_t&, ssize_t (*)(int, const void*, size_t), int,
+                       const void*, size_t) const;
+    // pread / pread64
+    ssize_t operator()(const gotcha_data_t&, ssize_t (*)(int, void*, size_t, off_t), int,
+                       void*, size_t, off_t) const;
+    // pwrite / pwrite64
+    ssize_t operator()(const gotcha_data_t&, ssize_t (*)(int, const void*, size_t, off_t),
+                       int, const void*, size_t, off_t) const;
+    // readv / writev
+    ssize_t operator()(const gotcha_data_t&, ssize_t (*)(int, const struct iovec*, int),
+                       int, const struct iovec*, int) const;
+    // preadv / preadv64 / pwritev / pwritev64
+    ssize_t operator()(const gotcha_data_t&,
+                       ssize_t (*)(int, const struct iovec*, int, off_t), int,
+                       const struct iovec*, int, off_t) const;
+    // open / open64
+    int operator()(const gotcha_data_t&, int (*)(const char*, int, mode_t), const char*,
+                   int, mode_t) const;
+    // openat / openat64
+    int operator()(const gotcha_data_t&, int (*)(int, const char*, int, mode_t), int,
+                   const char*, int, mode_t) const;
+    // close / fsync / fdatasync
+    int operator()(const gotcha_data_t&, int (*)(int), int) const;
+};
+}  // namespace component
+
+using io_gotcha_t = tim::component::gotcha<component::io_gotcha::gotcha_capacity,
+                                           std::tuple<>, component::io_gotcha>;
+}  // namespace omnitrace
@@ -0,0 +1,157 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/components/malloc_gotcha.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/heap_profile.hpp"
+
+#include <timemory/utility/types.hpp>
+
+#include <cstddef>
+#include <cstdlib>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+auto&
+get_malloc_gotcha()
+{
+    static auto _v = tim::lightweight_tuple<malloc_gotcha_t>{};
+    return _v;
+}
+}  // namespace
+
+void
+malloc_gotcha::configure()
+{
+    malloc_gotcha_t::get_initializer() = []() {
+        malloc_gotcha_t::configure<0, void*, size_t>("malloc");
+        malloc_gotcha_t::configure<1, void*, size_t, size_t>("calloc");
+        malloc_gotcha_t::configure<2, void*, void*, size_t>("realloc");
+        malloc_gotcha_t::configure<3, int, void**, size_t, size_t>("posix_memalign");
+        malloc_gotcha_t::configure<4, void, void*>("free");
+        // operator new(size_t) and operator new[](size_t)
+        malloc_gotcha_t::configure<5, void*, size_t>("_Znwm");
+        malloc_gotcha_t::configure<6, void*, size_t>("_Znam");
+        // operator delete(void*) and operator delete[](void*)
+        malloc_gotcha_t::configure<7, void, void*>("_ZdlPv");
+        malloc_gotcha_t::configure<8, void, void*>("_ZdaPv");
+        // operator delete(void*, size_t) and operator delete[](void*, size_t)
+        malloc_gotcha_t::configure<9, void, void*, size_t>("_ZdlPvm");
+        malloc_gotcha_t::configure<10, void, void*, size_t>("_ZdaPvm");
+    };
+}
+
+void
+malloc_gotcha::shutdown()
+{
+    malloc_gotcha_t::disable();
+}
+
+void
+malloc_gotcha::start()
+{
+    if(!heap_profile::is_enabled()) return;
+
+    if(!get_malloc_gotcha().get<malloc_gotcha_t>()->get_is_running())
+    {
+        OMNITRACE_VERBOSE(1, "[heap_profile] Wrapping the allocation functions...\n");
+        configure();
+        get_malloc_gotcha().start();
+    }
+}
+
+void
+malloc_gotcha::stop()
+{}
+
+// the nested calls (e.g. malloc within operator new) and the allocations of the heap
+// profile are passed through. The free is recorded before the memory is released so
+// the address can not be re-used by another thread in the meantime
+
+void*
+malloc_gotcha::operator()(const gotcha_data_t&, void* (*_func)(size_t),
+                          size_t _size) const
+{
+    auto  _guard = heap_profile::scoped_guard{};
+    auto* _ret   = (*_func)(_size);
+    if(!_guard.nested()) heap_profile::record_allocation(_ret, _size);
+    return _ret;
+}
+
+void*
+malloc_gotcha::operator()(const gotcha_data_t&, void* (*_func)(size_t, size_t),
+                          size_t _count, size_t _size) const
+{
+    auto  _guard = heap_profile::scoped_guard{};
+    auto* _ret   = (*_func)(_count, _size);
+    if(!_guard.nested()) heap_profile::record_allocation(_ret, _count * _size);
+    return _ret;
+}
+
+void*
+malloc_gotcha::operator()(const gotcha_data_t&, void* (*_func)(void*, size_t),
+                          void* _addr, size_t _size) const
+{
+    auto _guard = heap_profile::scoped_guard{};
+    if(_guard.nested()) return (*_func)(_addr, _size);
+
+    heap_profile::record_free(_addr);
+    auto* _ret = (*_func)(_addr, _size);
+    heap_profile::record_allocation(_ret, _size);
+    return _ret;
+}
+
+int
+malloc_gotcha::operator()(const gotcha_data_t&, int (*_func)(void**, size_t, size_t),
+                          void** _addr, size_t _alignment, size_t _size) const
+{
+    auto _guard = heap_profile::scoped_guard{};
+    auto _ret   = (*_func)(_addr, _alignment, _size);
+    if(!_guard.nested() && _ret == 0) heap_profile::record_allocation(*_addr, _size);
+    return _ret;
+}
+
+void
+malloc_gotcha::operator()(const gotcha_data_t&, void (*_func)(void*), void* _addr) const
+{
+    auto _guard = heap_profile::scoped_guard{};
+    if(!_guard.nested()) heap_profile::record_free(_addr);
+    (*_func)(_addr);
+}
+
+void
+malloc_gotcha::operator()(const gotcha_data_t&, void (*_func)(void*, size_t),
+                          void* _addr, size_t _size) const
+{
+    auto _guard = heap_profile::scoped_guard{};
+    if(!_guard.nested()) heap_profile::record_free(_addr);
+    (*_func)(_addr, _size);
+}
+}  // namespace component
+}  // namespace omnitrace
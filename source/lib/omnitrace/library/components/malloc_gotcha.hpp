@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+namespace component
+{
+// this is used to wrap the heap allocation functions for the heap profile (see
+// OMNITRACE_HEAP_PROFILE). aligned_alloc and memalign are not wrapped since their
+// signature is the same as calloc
+struct malloc_gotcha : tim::component::base<malloc_gotcha, void>
+{
+    static constexpr size_t gotcha_capacity = 11;
+
+    using gotcha_data_t = tim::component::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(malloc_gotcha)
+
+    // string id for component
+    static std::string label() { return "malloc_gotcha"; }
+
+    // generate the gotcha wrappers
+    static void configure();
+    static void shutdown();
+
+    static void start();
+    static void stop();
+
+    // malloc / operator new / operator new[]
+    void* operator()(const gotcha_data_t&, void* (*)(size_t), size_t) const;
+    // calloc
+    void* operator()(const gotcha_data_t&, void* (*)(size_t, size_t), size_t,
+                     size_t) const;
+    // realloc
+    void* operator()(const gotcha_data_t&, void* (*)(void*, size_t), void*,
+                     size_t) const;
+    // posix_memalign
+    int operator()(const gotcha_data_t&, int (*)(void**, size_t, size_t), void**,
+                   size_t, size_t) const;
+    // free / operator delete / operator delete[]
+    void operator()(const gotcha_data_t&, void (*)(void*), void*) const;
+    // sized operator delete / operator delete[]
+    void operator()(const gotcha_data_t&, void (*)(void*, size_t), void*, size_t) const;
+};
+}  // namespace component
+
+using malloc_gotcha_t =
+    tim::component::gotcha<component::malloc_gotcha::gotcha_capacity, std::tuple<>,
+                           component::malloc_gotcha>;
+}  // namespace omnitrace
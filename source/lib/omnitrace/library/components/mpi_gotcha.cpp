@@ -22,12 +22,18 @@
 
 #include "library/components/mpi_gotcha.hpp"
 #include "api.hpp"
+#include "core/categories.hpp"
+#include "core/clock_sync.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/mproc.hpp"
+#include "core/rank_selection.hpp"
 #include "library/components/category_region.hpp"
 #include "library/components/comm_data.hpp"
+#include "library/components/mpi_wait_state.hpp"
+#include "library/mpi_pvars.hpp"
+#include "library/sampling.hpp"
 
 #include <timemory/backends/mpi.hpp>
 #include <timemory/backends/process.hpp>
@@ -46,8 +52,8 @@ namespace component
 {
 namespace
 {
-using mpip_bundle_t =
-    tim::component_tuple<category_region<category::mpi>, comp::comm_data>;
+using mpip_bundle_t = tim::component_tuple<category_region<category::mpi>,
+                                           comp::comm_data, comp::mpi_wait_state>;
 
 struct comm_rank_data
 {
@@ -118,6 +124,8 @@ omnitrace_mpi_fini(MPI_Comm, int, void*, void*)
         tim::signals::block_signals(_blocked, tim::signals::sigmask_scope::process);
     if(mpip_index != std::numeric_limits<uint64_t>::max())
         comp::deactivate_mpip<mpip_bundle_t, project::omnitrace>(mpip_index);
+    comp::mpi_wait_state::shutdown();
+    mpi_pvars::stop();
     if(is_root_process()) omnitrace_finalize_hidden();
     return MPI_SUCCESS;
 }
@@ -142,6 +150,31 @@ omnitrace_mpi_set_attr()
 #endif
 }
 
+// the ranks excluded by OMNITRACE_MPI_RANKS stop collecting: the categories are
+// disabled so no regions are recorded and the samples are dropped by the signal
+// handler. These ranks still take part in the collective operations during the
+// finalization, they only contribute empty data
+void
+update_rank_selection(int _rank, int _size)
+{
+    auto _prev = rank_selection::is_selected();
+    auto _curr = rank_selection::update(_rank, _size);
+    if(_curr == _prev) return;
+
+    if(!_curr)
+    {
+        categories::shutdown();
+        if(get_use_sampling()) sampling::block_samples();
+        settings::enabled() = false;
+    }
+    else
+    {
+        categories::enable_categories();
+        if(get_use_sampling()) sampling::unblock_samples();
+        settings::enabled() = true;
+    }
+}
+
 using strset_t       = std::set<std::string>;
 auto permit_bindings = strset_t{};
 auto reject_bindings = strset_t{};
@@ -216,6 +249,7 @@ mpi_gotcha::update()
                                 tim::mpi::size(), _size);
         last_comm_record      = _rank_data;
         config::get_use_pid() = true;
+        update_rank_selection(_rank, _size);
         return true;
     }
     return false;
@@ -265,6 +299,8 @@ mpi_gotcha::audit(const gotcha_data_t& _data, audit::incoming)
 
     if(mpip_index != std::numeric_limits<uint64_t>::max())
         comp::deactivate_mpip<mpip_bundle_t, project::omnitrace>(mpip_index);
+    comp::mpi_wait_state::shutdown();
+    mpi_pvars::stop();
 
 #if !defined(TIMEMORY_USE_MPI) && defined(TIMEMORY_USE_MPI_HEADERS)
     tim::mpi::is_initialized_callback() = []() { return false; };
@@ -308,6 +344,21 @@ mpi_gotcha::audit(const gotcha_data_t& _data, audit::outgoing, int _retval)
     if(_retval == tim::mpi::success_v && _data.tool_id.find("MPI_Init") == 0)
     {
         omnitrace_mpi_set_attr();
+
+#if defined(TIMEMORY_USE_MPI)
+        update_rank_selection(tim::mpi::rank(), tim::mpi::size());
+        mpi_pvars::start();
+#endif
+
+        // the first clock offset estimate. The second is made during finalization.
+        // The wait-state analysis compares the timestamps of different ranks
+        if((get_use_perfetto() && config::get_perfetto_clock_sync()) ||
+           (get_use_mpip() && config::get_mpi_wait_state()))
+        {
+            OMNITRACE_BASIC_VERBOSE_F(2, "Estimating the clock offsets...\n");
+            clock_sync::sample(config::get_perfetto_clock_sync_rounds());
+        }
+
         // omnitrace will set this environement variable to true in binary rewrite mode
         // when it detects MPI. Hides this env variable from the user to avoid this
         // being activated unwaringly during runtime instrumentation because that
@@ -321,6 +372,7 @@ mpi_gotcha::audit(const gotcha_data_t& _data, audit::outgoing, int _retval)
             // to control the gotcha bindings at runtime
             comp::configure_mpip<mpip_bundle_t, project::omnitrace>(permit_bindings,
                                                                     reject_bindings);
+            comp::mpi_wait_state::setup();
             mpip_index = comp::activate_mpip<mpip_bundle_t, project::omnitrace>();
         }
 
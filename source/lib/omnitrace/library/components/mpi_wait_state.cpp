@@ -0,0 +1,895 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/mpi_wait_state.hpp"
+#include "common/join.hpp"
+#include "core/clock_sync.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/self_profile.hpp"
+#include "core/state.hpp"
+#include "core/tsc.hpp"
+
+#include <timemory/manager.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+#if defined(OMNITRACE_USE_MPI)
+enum call_kind : int
+{
+    none_kind = 0,
+    send_kind,        // MPI_Send, MPI_Rsend
+    ssend_kind,       // MPI_Ssend
+    bsend_kind,       // MPI_Bsend
+    isend_kind,       // MPI_Isend, MPI_Issend, MPI_Ibsend, MPI_Irsend
+    recv_kind,        // MPI_Recv
+    irecv_kind,       // MPI_Irecv
+    sendrecv_kind,    // MPI_Sendrecv, MPI_Sendrecv_replace
+    wait_kind,        // MPI_Wait
+    waitall_kind,     // MPI_Waitall
+    waitany_kind,     // MPI_Waitany
+    waitsome_kind,    // MPI_Waitsome
+    test_kind,        // MPI_Test
+    testall_kind,     // MPI_Testall
+    testany_kind,     // MPI_Testany
+    testsome_kind,    // MPI_Testsome
+    free_kind,        // MPI_Request_free
+    collective_kind,  // blocking collectives
+};
+
+int
+get_kind(const std::string& _name)
+{
+    static const auto _kinds = std::unordered_map<std::string, int>{
+        { "MPI_Send", send_kind },
+        { "MPI_Rsend", send_kind },
+        { "MPI_Ssend", ssend_kind },
+        { "MPI_Bsend", bsend_kind },
+        { "MPI_Isend", isend_kind },
+        { "MPI_Issend", isend_kind },
+        { "MPI_Ibsend", isend_kind },
+        { "MPI_Irsend", isend_kind },
+        { "MPI_Recv", recv_kind },
+        { "MPI_Irecv", irecv_kind },
+        { "MPI_Sendrecv", sendrecv_kind },
+        { "MPI_Sendrecv_replace", sendrecv_kind },
+        { "MPI_Wait", wait_kind },
+        { "MPI_Waitall", waitall_kind },
+        { "MPI_Waitany", waitany_kind },
+        { "MPI_Waitsome", waitsome_kind },
+        { "MPI_Test", test_kind },
+        { "MPI_Testall", testall_kind },
+        { "MPI_Testany", testany_kind },
+        { "MPI_Testsome", testsome_kind },
+        { "MPI_Request_free", free_kind },
+        { "MPI_Barrier", collective_kind },
+        { "MPI_Bcast", collective_kind },
+        { "MPI_Reduce", collective_kind },
+        { "MPI_Allreduce", collective_kind },
+        { "MPI_Reduce_scatter_block", collective_kind },
+        { "MPI_Scan", collective_kind },
+        { "MPI_Exscan", collective_kind },
+        { "MPI_Gather", collective_kind },
+        { "MPI_Gatherv", collective_kind },
+        { "MPI_Scatter", collective_kind },
+        { "MPI_Scatterv", collective_kind },
+        { "MPI_Allgather", collective_kind },
+        { "MPI_Allgatherv", collective_kind },
+        { "MPI_Alltoall", collective_kind },
+        { "MPI_Alltoallv", collective_kind },
+    };
+
+    auto itr = _kinds.find(_name);
+    return (itr == _kinds.end()) ? none_kind : itr->second;
+}
+
+// how long a receive polls for the send time of its message before the message is
+// counted as unmatched. The send time is posted before the message so it has almost
+// always arrived when the message is received
+constexpr uint64_t probe_timeout_ns = 1000000;
+
+// the entry time of the send and whether the sender waits for the matching receive
+struct send_time
+{
+    uint64_t value = 0;
+    uint64_t sync  = 0;
+};
+
+struct send_slot
+{
+    send_time   data    = {};
+    MPI_Request request = MPI_REQUEST_NULL;
+};
+
+struct recv_info
+{
+    MPI_Comm comm   = MPI_COMM_NULL;
+    int      peer   = MPI_PROC_NULL;
+    int      tag    = 0;
+    uint64_t posted = 0;
+};
+
+struct wait_state_data
+{
+    std::mutex                              mutex       = {};
+    MPI_Comm                                comm        = MPI_COMM_NULL;
+    MPI_Group                               world       = MPI_GROUP_NULL;
+    size_t                                  eager_limit = 0;
+    std::deque<std::unique_ptr<send_slot>>  pending     = {};
+    std::vector<std::unique_ptr<send_slot>> available   = {};
+    std::map<MPI_Request, recv_info>        receives    = {};
+    std::atomic<uint64_t>                   matched     = { 0 };
+    std::atomic<uint64_t>                   unmatched   = { 0 };
+};
+
+auto&
+get_data()
+{
+    static auto* _v = new wait_state_data{};
+    return *_v;
+}
+
+uint64_t
+now()
+{
+    return clock_sync::correct(tsc::get_clock_real_now());
+}
+
+// the rank in MPI_COMM_WORLD of a rank in the communicator. Inter-communicators and
+// the special ranks are not supported
+int
+world_rank(MPI_Comm _comm, int _rank)
+{
+    if(_rank == MPI_PROC_NULL || _rank == MPI_ANY_SOURCE || _rank < 0)
+        return MPI_UNDEFINED;
+    if(_comm == MPI_COMM_WORLD) return _rank;
+
+    int _inter = 0;
+    if(_comm == MPI_COMM_NULL || PMPI_Comm_test_inter(_comm, &_inter) != MPI_SUCCESS ||
+       _inter != 0)
+        return MPI_UNDEFINED;
+
+    auto _group = MPI_Group{ MPI_GROUP_NULL };
+    auto _world = int{ MPI_UNDEFINED };
+    if(PMPI_Comm_group(_comm, &_group) != MPI_SUCCESS) return MPI_UNDEFINED;
+    PMPI_Group_translate_ranks(_group, 1, &_rank, get_data().world, &_world);
+    PMPI_Group_free(&_group);
+    return _world;
+}
+
+size_t
+message_size(int _count, MPI_Datatype _datatype)
+{
+    int _size = 0;
+    PMPI_Type_size(_datatype, &_size);
+    return static_cast<size_t>(std::max<int>(_count, 0)) *
+           static_cast<size_t>(std::max<int>(_size, 0));
+}
+
+// posts the entry time of a send to the destination. The buffers of the completed
+// sends are reused
+void
+post_send_time(MPI_Comm _comm, int _dst, int _tag, bool _sync)
+{
+    auto _ts    = now();
+    auto _world = world_rank(_comm, _dst);
+    if(_world == MPI_UNDEFINED) return;
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    while(!_data.pending.empty())
+    {
+        int _flag = 0;
+        PMPI_Test(&_data.pending.front()->request, &_flag, MPI_STATUS_IGNORE);
+        if(_flag == 0) break;
+        _data.available.emplace_back(std::move(_data.pending.front()));
+        _data.pending.pop_front();
+    }
+
+    auto _slot = std::unique_ptr<send_slot>{};
+    if(_data.available.empty())
+    {
+        _slot = std::make_unique<send_slot>();
+    }
+    else
+    {
+        _slot = std::move(_data.available.back());
+        _data.available.pop_back();
+    }
+
+    _slot->data = send_time{ _ts, (_sync) ? 1UL : 0UL };
+    PMPI_Isend(&_slot->data, 2, MPI_UINT64_T, _world, _tag, _data.comm,
+               &_slot->request);
+    _data.pending.emplace_back(std::move(_slot));
+}
+
+// reads the send time of a received message. A matched probe is used so that
+// concurrent receives from the same peer and tag cannot take the same message
+std::optional<send_time>
+read_send_time(MPI_Comm _comm, int _src, int _tag, const MPI_Status* _status)
+{
+    if(_src == MPI_PROC_NULL) return std::nullopt;
+
+    auto& _data = get_data();
+    if(_src == MPI_ANY_SOURCE || _tag == MPI_ANY_TAG)
+    {
+        if(_status == MPI_STATUS_IGNORE)
+        {
+            ++_data.unmatched;
+            return std::nullopt;
+        }
+        _src = _status->MPI_SOURCE;
+        _tag = _status->MPI_TAG;
+    }
+
+    auto _world = world_rank(_comm, _src);
+    if(_world == MPI_UNDEFINED)
+    {
+        ++_data.unmatched;
+        return std::nullopt;
+    }
+
+    auto _end = tsc::get_clock_real_now() + probe_timeout_ns;
+    do
+    {
+        int  _flag    = 0;
+        auto _message = MPI_Message{ MPI_MESSAGE_NULL };
+        PMPI_Improbe(_world, _tag, _data.comm, &_flag, &_message, MPI_STATUS_IGNORE);
+        if(_flag != 0)
+        {
+            auto _v = send_time{};
+            PMPI_Mrecv(&_v, 2, MPI_UINT64_T, &_message, MPI_STATUS_IGNORE);
+            ++_data.matched;
+            return _v;
+        }
+    } while(tsc::get_clock_real_now() < _end);
+
+    ++_data.unmatched;
+    return std::nullopt;
+}
+
+std::optional<recv_info>
+release_receive(MPI_Request _request)
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  itr   = _data.receives.find(_request);
+    if(itr == _data.receives.end()) return std::nullopt;
+    auto _info = itr->second;
+    _data.receives.erase(itr);
+    return _info;
+}
+
+bool
+is_recording()
+{
+    return get_use_timemory() && get_state() == State::Active;
+}
+
+void
+record_time(const gotcha_data& _data, const char* _state, uint64_t _ns)
+{
+    using tracker_t = tim::auto_tuple<mpi_wait_tracker_t>;
+
+    tracker_t _t{ JOIN('/', std::string_view{ _data.tool_id }, _state) };
+    _t.store(std::plus<double>{},
+             static_cast<double>(_ns) / mpi_wait_tracker_t::get_unit());
+}
+
+// the wait time is split into the late sender time and the transfer time. The late
+// receiver time is the time the sender of a synchronous message was blocked before
+// the receive was posted
+struct receive_times
+{
+    size_t   count         = 0;
+    size_t   sync          = 0;
+    uint64_t late_sender   = 0;
+    uint64_t late_receiver = 0;
+
+    void add(const send_time& _send, uint64_t _beg, uint64_t _end, uint64_t _posted)
+    {
+        ++count;
+        if(_send.value > _beg)
+            late_sender = std::max(late_sender, std::min(_send.value, _end) - _beg);
+        if(_send.sync != 0)
+        {
+            ++sync;
+            if(_posted > _send.value) late_receiver += _posted - _send.value;
+        }
+    }
+
+    void record(const gotcha_data& _data, uint64_t _beg, uint64_t _end) const
+    {
+        if(count == 0 || !is_recording()) return;
+
+        auto _wait = (_end > _beg) ? (_end - _beg) : 0;
+        record_time(_data, "late_sender", late_sender);
+        record_time(_data, "transfer", _wait - late_sender);
+        if(sync > 0) record_time(_data, "late_receiver", late_receiver);
+    }
+};
+#endif
+}  // namespace
+
+void
+mpi_wait_state::preinit()
+{
+    configure();
+}
+
+void
+mpi_wait_state::configure()
+{
+    static bool _once = false;
+    if(_once) return;
+    _once = true;
+
+    mpi_wait_tracker_t::label()       = "mpi_wait_state";
+    mpi_wait_tracker_t::description() = "Time in the MPI calls waiting for a late peer";
+}
+
+void
+mpi_wait_state::setup()
+{
+#if defined(OMNITRACE_USE_MPI)
+    if(!config::get_mpi_wait_state() || get_active()) return;
+
+    if(!get_use_timemory())
+    {
+        OMNITRACE_VERBOSE(1, "[mpi_wait_state] OMNITRACE_MPI_WAIT_STATE requires "
+                             "OMNITRACE_PROFILE. Disabled\n");
+        return;
+    }
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    if(PMPI_Comm_dup(MPI_COMM_WORLD, &_data.comm) != MPI_SUCCESS) return;
+    PMPI_Comm_set_name(_data.comm, "omnitrace_mpi_wait_state");
+    PMPI_Comm_group(MPI_COMM_WORLD, &_data.world);
+    _data.eager_limit = config::get_mpi_wait_state_eager_limit();
+
+    OMNITRACE_VERBOSE(2, "[mpi_wait_state] wait-state analysis is active\n");
+    get_active().store(true);
+#endif
+}
+
+void
+mpi_wait_state::shutdown()
+{
+#if defined(OMNITRACE_USE_MPI)
+    if(!get_active().exchange(false)) return;
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    // the buffers of the pending sends are not released since the sends may still
+    // be in progress
+    for(auto& itr : _data.pending)
+    {
+        if(itr->request != MPI_REQUEST_NULL) PMPI_Request_free(&itr->request);
+    }
+
+    // discard the send times which were not read, e.g. the messages received by
+    // a call which is not analyzed
+    size_t _discarded = 0;
+    while(true)
+    {
+        int  _flag    = 0;
+        auto _message = MPI_Message{ MPI_MESSAGE_NULL };
+        PMPI_Improbe(MPI_ANY_SOURCE, MPI_ANY_TAG, _data.comm, &_flag, &_message,
+                     MPI_STATUS_IGNORE);
+        if(_flag == 0) break;
+        auto _v = send_time{};
+        PMPI_Mrecv(&_v, 2, MPI_UINT64_T, &_message, MPI_STATUS_IGNORE);
+        ++_discarded;
+    }
+
+    PMPI_Group_free(&_data.world);
+    PMPI_Comm_free(&_data.comm);
+    _data.receives.clear();
+
+    OMNITRACE_VERBOSE(1,
+                      "[mpi_wait_state] matched the send time of %zu of %zu receives "
+                      "(%zu send times discarded)\n",
+                      static_cast<size_t>(_data.matched.load()),
+                      static_cast<size_t>(_data.matched.load() + _data.unmatched.load()),
+                      _discarded);
+#endif
+}
+
+#if defined(OMNITRACE_USE_MPI)
+// MPI_Send
+// MPI_Ssend
+// MPI_Bsend
+// MPI_Rsend
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, int count,
+                      MPI_Datatype datatype, int dst, int tag, MPI_Comm _comm)
+{
+    if(!get_active()) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+    auto _kind = get_kind(_data.tool_id);
+    if(_kind == ssend_kind)
+        post_send_time(_comm, dst, tag, true);
+    else if(_kind == send_kind)
+        post_send_time(_comm, dst, tag,
+                       message_size(count, datatype) > get_data().eager_limit);
+    else if(_kind == bsend_kind)
+        post_send_time(_comm, dst, tag, false);
+}
+
+// MPI_Recv
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, void*, int,
+                      MPI_Datatype, int src, int tag, MPI_Comm _comm,
+                      MPI_Status* _status)
+{
+    if(!get_active() || get_kind(_data.tool_id) != recv_kind) return;
+
+    m_kind   = recv_kind;
+    m_peer   = src;
+    m_tag    = tag;
+    m_comm   = _comm;
+    m_status = _status;
+    m_beg    = now();
+}
+
+// MPI_Isend
+// MPI_Issend
+// MPI_Ibsend
+// MPI_Irsend
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                      MPI_Datatype, int dst, int tag, MPI_Comm _comm, MPI_Request*)
+{
+    if(!get_active() || get_kind(_data.tool_id) != isend_kind) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+    post_send_time(_comm, dst, tag, false);
+}
+
+// MPI_Irecv
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, void*, int,
+                      MPI_Datatype, int src, int tag, MPI_Comm _comm,
+                      MPI_Request* _request)
+{
+    if(!get_active() || get_kind(_data.tool_id) != irecv_kind) return;
+
+    m_kind    = irecv_kind;
+    m_peer    = src;
+    m_tag     = tag;
+    m_comm    = _comm;
+    m_request = _request;
+    m_beg     = now();
+}
+
+// MPI_Sendrecv
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*,
+                      int sendcount, MPI_Datatype sendtype, int dst, int sendtag, void*,
+                      int, MPI_Datatype, int src, int recvtag, MPI_Comm _comm,
+                      MPI_Status* _status)
+{
+    if(!get_active() || get_kind(_data.tool_id) != sendrecv_kind) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+    post_send_time(_comm, dst, sendtag,
+                   message_size(sendcount, sendtype) > get_data().eager_limit);
+
+    m_kind   = sendrecv_kind;
+    m_peer   = src;
+    m_tag    = recvtag;
+    m_comm   = _comm;
+    m_status = _status;
+    m_beg    = now();
+}
+
+// MPI_Sendrecv_replace
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, void*, int count,
+                      MPI_Datatype datatype, int dst, int sendtag, int src, int recvtag,
+                      MPI_Comm _comm, MPI_Status* _status)
+{
+    if(!get_active() || get_kind(_data.tool_id) != sendrecv_kind) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+    post_send_time(_comm, dst, sendtag,
+                   message_size(count, datatype) > get_data().eager_limit);
+
+    m_kind   = sendrecv_kind;
+    m_peer   = src;
+    m_tag    = recvtag;
+    m_comm   = _comm;
+    m_status = _status;
+    m_beg    = now();
+}
+
+// MPI_Wait
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, MPI_Request* _request,
+                      MPI_Status* _status)
+{
+    if(!get_active() || get_kind(_data.tool_id) != wait_kind) return;
+
+    m_status = _status;
+    completion(_data, 1, _request);
+}
+
+// MPI_Test
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, MPI_Request* _request,
+                      int* _flag, MPI_Status* _status)
+{
+    if(!get_active() || get_kind(_data.tool_id) != test_kind) return;
+
+    m_flag   = _flag;
+    m_status = _status;
+    completion(_data, 1, _request);
+}
+
+// MPI_Waitall
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, int _count,
+                      MPI_Request* _requests, MPI_Status* _statuses)
+{
+    if(!get_active() || get_kind(_data.tool_id) != waitall_kind) return;
+
+    m_status = _statuses;
+    completion(_data, _count, _requests);
+}
+
+// MPI_Waitany
+// MPI_Testall
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, int _count,
+                      MPI_Request* _requests, int* _value, MPI_Status* _status)
+{
+    if(!get_active()) return;
+
+    auto _kind = get_kind(_data.tool_id);
+    if(_kind == waitany_kind)
+        m_index = _value;
+    else if(_kind == testall_kind)
+        m_flag = _value;
+    else
+        return;
+
+    m_status = _status;
+    completion(_data, _count, _requests);
+}
+
+// MPI_Testany
+// MPI_Waitsome
+// MPI_Testsome
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, int _count,
+                      MPI_Request* _requests, int* _index, int* _value,
+                      MPI_Status* _status)
+{
+    if(!get_active()) return;
+
+    auto _kind = get_kind(_data.tool_id);
+    if(_kind == testany_kind)
+        m_flag = _value;
+    else if(_kind == waitsome_kind || _kind == testsome_kind)
+        m_indices = _value;
+    else
+        return;
+
+    m_index  = _index;
+    m_status = _status;
+    completion(_data, _count, _requests);
+}
+
+// MPI_Request_free
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, MPI_Request* _request)
+{
+    if(!get_active() || get_kind(_data.tool_id) != free_kind || !_request) return;
+
+    release_receive(*_request);
+}
+
+// MPI_Barrier
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Bcast
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, void*, int,
+                      MPI_Datatype, int, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Reduce
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, void*,
+                      int, MPI_Datatype, MPI_Op, int, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Allreduce
+// MPI_Reduce_scatter_block
+// MPI_Scan
+// MPI_Exscan
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, void*,
+                      int, MPI_Datatype, MPI_Op, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Gather
+// MPI_Scatter
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                      MPI_Datatype, void*, int, MPI_Datatype, int, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Allgather
+// MPI_Alltoall
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                      MPI_Datatype, void*, int, MPI_Datatype, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Gatherv
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                      MPI_Datatype, void*, const int*, const int*, MPI_Datatype, int,
+                      MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Scatterv
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*,
+                      const int*, const int*, MPI_Datatype, void*, int, MPI_Datatype,
+                      int, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Allgatherv
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                      MPI_Datatype, void*, const int*, const int*, MPI_Datatype,
+                      MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Alltoallv
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::incoming, const void*,
+                      const int*, const int*, MPI_Datatype, void*, const int*,
+                      const int*, MPI_Datatype, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+void
+mpi_wait_state::collective(const gotcha_data& _data, MPI_Comm _comm)
+{
+    if(!get_active() || get_kind(_data.tool_id) != collective_kind) return;
+
+    // the additional reduction has a different meaning on an inter-communicator
+    int _inter = 0;
+    if(_comm == MPI_COMM_NULL || PMPI_Comm_test_inter(_comm, &_inter) != MPI_SUCCESS ||
+       _inter != 0)
+        return;
+
+    m_kind = collective_kind;
+    m_comm = _comm;
+    m_beg  = now();
+}
+
+// the tracked receive requests are found before the call since the completed
+// requests are set to MPI_REQUEST_NULL
+void
+mpi_wait_state::completion(const gotcha_data& _data, int _count, MPI_Request* _requests)
+{
+    if(!_requests || _count <= 0) return;
+
+    auto& _v  = get_data();
+    auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+    if(_v.receives.empty()) return;
+
+    m_pending.clear();
+    for(int i = 0; i < _count; ++i)
+    {
+        if(_requests[i] != MPI_REQUEST_NULL && _v.receives.count(_requests[i]) > 0)
+            m_pending.emplace_back(i, _requests[i]);
+    }
+
+    if(m_pending.empty()) return;
+
+    m_kind = get_kind(_data.tool_id);
+    m_beg  = now();
+}
+
+void
+mpi_wait_state::audit(const gotcha_data& _data, audit::outgoing, int _retval)
+{
+    auto _kind = std::exchange(m_kind, none_kind);
+    if(_kind == none_kind || !get_active()) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+    auto _end = now();
+
+    if(_kind == collective_kind)
+    {
+        // an error on any rank would leave the other ranks waiting in the reduction
+        // so the reduction is performed regardless of the return value
+        uint64_t _last = m_beg;
+        PMPI_Allreduce(&m_beg, &_last, 1, MPI_UINT64_T, MPI_MAX, m_comm);
+        if(_retval != MPI_SUCCESS || !is_recording()) return;
+
+        auto _wait      = (_end > m_beg) ? (_end - m_beg) : 0;
+        auto _imbalance = (_last > m_beg) ? std::min(_last - m_beg, _wait) : 0;
+        record_time(_data, "imbalance", _imbalance);
+        record_time(_data, "transfer", _wait - _imbalance);
+        return;
+    }
+
+    if(_retval != MPI_SUCCESS) return;
+
+    if(_kind == irecv_kind)
+    {
+        if(!m_request || *m_request == MPI_REQUEST_NULL) return;
+        auto& _v  = get_data();
+        auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+        _v.receives[*m_request] = recv_info{ m_comm, m_peer, m_tag, m_beg };
+        return;
+    }
+
+    auto _times = receive_times{};
+
+    if(_kind == recv_kind || _kind == sendrecv_kind)
+    {
+        auto _send = read_send_time(m_comm, m_peer, m_tag, m_status);
+        if(_send) _times.add(*_send, m_beg, _end, m_beg);
+        _times.record(_data, m_beg, _end);
+        return;
+    }
+
+    // the statuses of the completed requests: a single status for MPI_Wait, MPI_Test,
+    // MPI_Waitany, and MPI_Testany, one per request for MPI_Waitall and MPI_Testall,
+    // and one per completed request for MPI_Waitsome and MPI_Testsome
+    auto _read = [&](MPI_Request _request, const MPI_Status* _status) {
+        auto _info = release_receive(_request);
+        if(!_info) return;
+        auto _send = read_send_time(_info->comm, _info->peer, _info->tag, _status);
+        if(_send) _times.add(*_send, m_beg, _end, _info->posted);
+    };
+
+    auto _single = [&](int _index) {
+        for(const auto& itr : m_pending)
+        {
+            if(itr.first == _index) _read(itr.second, m_status);
+        }
+    };
+
+    switch(_kind)
+    {
+        case wait_kind: _single(0); break;
+        case test_kind:
+        {
+            if(m_flag && *m_flag != 0) _single(0);
+            break;
+        }
+        case waitany_kind:
+        {
+            if(m_index && *m_index != MPI_UNDEFINED) _single(*m_index);
+            break;
+        }
+        case testany_kind:
+        {
+            if(m_flag && *m_flag != 0 && m_index && *m_index != MPI_UNDEFINED)
+                _single(*m_index);
+            break;
+        }
+        case waitall_kind:
+        case testall_kind:
+        {
+            if(_kind == testall_kind && (!m_flag || *m_flag == 0)) break;
+            for(const auto& itr : m_pending)
+            {
+                _read(itr.second, (m_status == MPI_STATUSES_IGNORE)
+                                      ? MPI_STATUS_IGNORE
+                                      : &m_status[itr.first]);
+            }
+            break;
+        }
+        case waitsome_kind:
+        case testsome_kind:
+        {
+            if(!m_index || !m_indices || *m_index == MPI_UNDEFINED) break;
+            for(int i = 0; i < *m_index; ++i)
+            {
+                for(const auto& itr : m_pending)
+                {
+                    if(itr.first != m_indices[i]) continue;
+                    _read(itr.second, (m_status == MPI_STATUSES_IGNORE)
+                                          ? MPI_STATUS_IGNORE
+                                          : &m_status[i]);
+                }
+            }
+            break;
+        }
+        default: break;
+    }
+
+    // the tests do not wait so only the completions are recorded
+    if(_kind == test_kind || _kind == testall_kind || _kind == testany_kind ||
+       _kind == testsome_kind)
+        return;
+
+    _times.record(_data, m_beg, _end);
+}
+#endif
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::mpi_wait_time>), true,
+    double)
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(mpi_wait_state, false, void)
@@ -0,0 +1,220 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/components/fwd.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/components/macros.hpp>
+
+#if defined(OMNITRACE_USE_MPI)
+#    include <mpi.h>
+#endif
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+using gotcha_data = ::tim::component::gotcha_data;
+
+/// splits the time in the MPI calls into the time spent waiting for a late peer and
+/// the remaining (transfer) time (see OMNITRACE_MPI_WAIT_STATE). Every send posts
+/// the (clock-synchronized) time it was entered to the destination on a duplicate of
+/// MPI_COMM_WORLD and the receive which completes the message reads it back:
+///
+///   - late sender:   the receive was waiting before the send was entered
+///   - late receiver: a synchronous send was entered before the receive was posted
+///   - imbalance:     a collective was entered before the last rank arrived, which is
+///                    found from an additional MPI_MAX reduction of the entry times
+///
+/// The times are accumulated into data trackers below the region of the MPI call so
+/// they are aggregated per call-site in the timemory output
+struct mpi_wait_state : base<mpi_wait_state, void>
+{
+    using value_type = void;
+    using this_type  = mpi_wait_state;
+    using base_type  = base<this_type, value_type>;
+
+    OMNITRACE_DEFAULT_OBJECT(mpi_wait_state)
+
+    static void preinit();
+    static void configure();
+    static void start() {}
+    static void stop() {}
+
+    /// creates the communicator for the send times. Called after MPI_Init
+    static void setup();
+
+    /// releases the pending send times and the communicator. Called before the
+    /// MPI_Finalize
+    static void shutdown();
+
+#if defined(OMNITRACE_USE_MPI)
+    // MPI_Send
+    // MPI_Ssend
+    // MPI_Bsend
+    // MPI_Rsend
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int count,
+               MPI_Datatype datatype, int dst, int tag, MPI_Comm);
+
+    // MPI_Recv
+    void audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype,
+               int src, int tag, MPI_Comm, MPI_Status*);
+
+    // MPI_Isend
+    // MPI_Issend
+    // MPI_Ibsend
+    // MPI_Irsend
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int count,
+               MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Request*);
+
+    // MPI_Irecv
+    void audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype,
+               int src, int tag, MPI_Comm, MPI_Request*);
+
+    // MPI_Sendrecv
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
+               MPI_Datatype sendtype, int dst, int sendtag, void*, int, MPI_Datatype,
+               int src, int recvtag, MPI_Comm, MPI_Status*);
+
+    // MPI_Sendrecv_replace
+    void audit(const gotcha_data& _data, audit::incoming, void*, int count,
+               MPI_Datatype datatype, int dst, int sendtag, int src, int recvtag,
+               MPI_Comm, MPI_Status*);
+
+    // MPI_Wait
+    void audit(const gotcha_data& _data, audit::incoming, MPI_Request*, MPI_Status*);
+
+    // MPI_Test
+    void audit(const gotcha_data& _data, audit::incoming, MPI_Request*, int*,
+               MPI_Status*);
+
+    // MPI_Waitall
+    void audit(const gotcha_data& _data, audit::incoming, int, MPI_Request*,
+               MPI_Status*);
+
+    // MPI_Waitany
+    // MPI_Testall
+    void audit(const gotcha_data& _data, audit::incoming, int, MPI_Request*, int*,
+               MPI_Status*);
+
+    // MPI_Testany
+    // MPI_Waitsome
+    // MPI_Testsome
+    void audit(const gotcha_data& _data, audit::incoming, int, MPI_Request*, int*, int*,
+               MPI_Status*);
+
+    // MPI_Request_free
+    void audit(const gotcha_data& _data, audit::incoming, MPI_Request*);
+
+    // MPI_Barrier
+    void audit(const gotcha_data& _data, audit::incoming, MPI_Comm);
+
+    // MPI_Bcast
+    void audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype, int,
+               MPI_Comm);
+
+    // MPI_Reduce
+    void audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+               MPI_Datatype, MPI_Op, int, MPI_Comm);
+
+    // MPI_Allreduce
+    // MPI_Reduce_scatter_block
+    // MPI_Scan
+    // MPI_Exscan
+    void audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+               MPI_Datatype, MPI_Op, MPI_Comm);
+
+    // MPI_Gather
+    // MPI_Scatter
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int, MPI_Datatype,
+               void*, int, MPI_Datatype, int, MPI_Comm);
+
+    // MPI_Allgather
+    // MPI_Alltoall
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int, MPI_Datatype,
+               void*, int, MPI_Datatype, MPI_Comm);
+
+    // MPI_Gatherv
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int, MPI_Datatype,
+               void*, const int*, const int*, MPI_Datatype, int, MPI_Comm);
+
+    // MPI_Scatterv
+    void audit(const gotcha_data& _data, audit::incoming, const void*, const int*,
+               const int*, MPI_Datatype, void*, int, MPI_Datatype, int, MPI_Comm);
+
+    // MPI_Allgatherv
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int, MPI_Datatype,
+               void*, const int*, const int*, MPI_Datatype, MPI_Comm);
+
+    // MPI_Alltoallv
+    void audit(const gotcha_data& _data, audit::incoming, const void*, const int*,
+               const int*, MPI_Datatype, void*, const int*, const int*, MPI_Datatype,
+               MPI_Comm);
+
+    // all of the above
+    void audit(const gotcha_data& _data, audit::outgoing, int _retval);
+
+private:
+    void collective(const gotcha_data& _data, MPI_Comm _comm);
+    void completion(const gotcha_data& _data, int _count, MPI_Request* _requests);
+
+    int          m_kind     = 0;
+    int          m_peer     = MPI_PROC_NULL;
+    int          m_tag      = 0;
+    uint64_t     m_beg      = 0;
+    MPI_Comm     m_comm     = MPI_COMM_NULL;
+    MPI_Status*  m_status   = nullptr;
+    MPI_Request* m_request  = nullptr;
+    int*         m_index    = nullptr;
+    int*         m_indices  = nullptr;
+    int*         m_flag     = nullptr;
+
+    // the tracked receive requests (and their index) passed to the completion calls
+    std::vector<std::pair<int, MPI_Request>> m_pending = {};
+#endif
+};
+}  // namespace component
+}  // namespace omnitrace
+
+#if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                             \
+    (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#    include <timemory/components/base.hpp>
+#    include <timemory/components/data_tracker/components.hpp>
+#    include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::mpi_wait_time>), true,
+    double)
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(mpi_wait_state, false, void)
+#endif
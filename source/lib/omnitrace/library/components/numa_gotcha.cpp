@@ -24,9 +24,12 @@
 #include "core/common.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
+#include "core/self_profile.hpp"
 #include "core/state.hpp"
 #include "core/timemory.hpp"
 #include "library/components/category_region.hpp"
+#include "library/lock_profile.hpp"
+#include "library/numa_locality.hpp"
 #include "library/runtime.hpp"
 
 #include <timemory/backends/threading.hpp>
@@ -57,6 +60,14 @@ get_numa_gotcha()
     static auto _v = tim::lightweight_tuple<numa_gotcha_t>{};
     return _v;
 }
+
+// the size of the numa_alloc call in progress on the thread, for the NUMA locality
+size_t&
+get_pending_allocation()
+{
+    static thread_local size_t _v = 0;
+    return _v;
+}
 }  // namespace
 
 void
@@ -119,6 +130,7 @@ numa_gotcha::audit(const gotcha_data& _data, audit::incoming, void* start,
                    unsigned long len, int mode, const unsigned long* nmask,
                    unsigned long maxnode, unsigned flags)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "start",
                                            start, "len", len, "mode", mode, "nmask",
                                            nmask, "maxnode", maxnode, "flags", flags);
@@ -129,6 +141,7 @@ numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int pid,
                    unsigned long maxnode, const unsigned long* frommask,
                    const unsigned long* tomask)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "pid", pid,
                                            "maxnode", maxnode, "frommask", frommask,
                                            "tomask", tomask);
@@ -139,6 +152,7 @@ numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int pid,
                    unsigned long count, void** pages, const int* nodes, int* status,
                    int flags)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "pid", pid,
                                            "count", count, "pages", pages, "nodes", nodes,
                                            "status", status, "flags", flags);
@@ -148,6 +162,7 @@ void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int pid,
                    struct bitmask* from, struct bitmask* to)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "pid", pid,
                                            "from", JOIN("", from).c_str(), "to",
                                            JOIN("", to).c_str());
@@ -156,36 +171,50 @@ numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int pid,
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, size_t _size)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "size",
                                            _size);
+    if(numa_locality::is_enabled()) get_pending_allocation() = _size;
 }
 
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, size_t _size, int _node)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "size",
                                            _size, "node", _node);
+    if(numa_locality::is_enabled()) get_pending_allocation() = _size;
 }
 
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, void* _addr, size_t _size)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "address",
                                            _addr, "size", _size);
+    if(numa_locality::is_enabled())
+        numa_locality::record_free(reinterpret_cast<uintptr_t>(_addr));
 }
 
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, void* _old_addr,
                    size_t _old_size, size_t _new_size)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::start(std::string_view{ _data.tool_id },
                                            "old_address", _old_addr, "old_size",
                                            _old_size, "new_size", _new_size);
+    if(numa_locality::is_enabled())
+    {
+        numa_locality::record_free(reinterpret_cast<uintptr_t>(_old_addr));
+        get_pending_allocation() = _new_size;
+    }
 }
 
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::outgoing, int ret)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::stop(std::string_view{ _data.tool_id }, "return",
                                           ret);
 }
@@ -193,6 +222,7 @@ numa_gotcha::audit(const gotcha_data& _data, audit::outgoing, int ret)
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::outgoing, long ret)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::stop(std::string_view{ _data.tool_id }, "return",
                                           ret);
 }
@@ -200,8 +230,15 @@ numa_gotcha::audit(const gotcha_data& _data, audit::outgoing, long ret)
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::outgoing, void* ret)
 {
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
     category_region<category::numa>::stop(std::string_view{ _data.tool_id }, "return",
                                           ret);
+    if(auto& _size = get_pending_allocation(); _size > 0)
+    {
+        numa_locality::record_allocation(reinterpret_cast<uintptr_t>(ret), _size,
+                                         lock_profile::get_call_site());
+        _size = 0;
+    }
 }
 }  // namespace component
 }  // namespace omnitrace
@@ -29,6 +29,7 @@
 #include "library/causal/delay.hpp"
 #include "library/components/category_region.hpp"
 #include "library/components/roctracer.hpp"
+#include "library/housekeeping.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
@@ -150,6 +151,16 @@ using native_handle_set_t = std::set<pthread_create_gotcha::native_handle_t>;
 auto native_handles          = native_handle_set_t{};
 auto internal_native_handles = native_handle_set_t{};
 auto native_handles_mutex    = locking::atomic_mutex{};
+
+// the wrappers released by the exited threads are reused by the new threads. The
+// number is bounded so that a burst of threads does not hold on to the memory
+constexpr size_t max_free_wrappers   = 64;
+auto*            free_wrappers_mutex = new locking::atomic_mutex{};  // intentional leak
+auto*            free_wrappers       = []() {
+    auto* _v = new std::vector<pthread_create_gotcha::wrapper*>{};
+    _v->reserve(max_free_wrappers);
+    return _v;
+}();
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -210,7 +221,7 @@ pthread_create_gotcha::wrapper::operator()() const
                _thr_bundle->get<comp::wall_clock>()->get_is_running())
                 _thr_bundle->stop();
             if(_bundle) stop_bundle(*_bundle, _tid);
-            pthread_create_gotcha::shutdown(_tid);
+            if(!m_config.lazy) pthread_create_gotcha::shutdown(_tid);
             OMNITRACE_BASIC_VERBOSE(
                 1, "[PID=%i][rank=%i] Thread %s (parent: %s) exited\n", process::get_id(),
                 dmp::rank(), _info->index_data->as_string().c_str(),
@@ -227,7 +238,32 @@ pthread_create_gotcha::wrapper::operator()() const
         internal_native_handles.emplace(pthread_self());
     }
 
-    if(_active && !_coverage && !m_config.offset)
+    // threads created while omnitrace is in control (e.g. the perfetto and roctracer
+    // threads) are background threads
+    if(m_config.internal) housekeeping::configure_thread();
+
+    if(_active && !_coverage && !m_config.offset && m_config.lazy)
+    {
+        // the timemory data of this thread is set up by tracing::thread_init when the
+        // first region is pushed. Only the sampler is started here
+        _tid = _info->index_data->sequent_value;
+        OMNITRACE_BASIC_VERBOSE(1, "[PID=%i][rank=%i] Thread %s (parent: %s) created\n",
+                                process::get_id(), dmp::rank(),
+                                _info->index_data->as_string().c_str(),
+                                _parent_info->index_data->as_string().c_str());
+        // passing this thread as the parent prevents copying the cid stack of the
+        // parent, which may be modified concurrently since the parent does not wait
+        auto& _cids = get_cpu_cid_stack(_tid, _tid);
+        if(_cids) _cids->assign(m_parent_cids.begin(), m_parent_cids.end());
+        if(m_config.enable_sampling)
+        {
+            _is_sampling = true;
+            OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+            _signals = sampling::setup();
+            sampling::unblock_signals();
+        }
+    }
+    else if(_active && !_coverage && !m_config.offset)
     {
         _tid = _info->index_data->sequent_value;
         OMNITRACE_BASIC_VERBOSE(1, "[PID=%i][rank=%i] Thread %s (parent: %s) created\n",
@@ -340,11 +376,68 @@ pthread_create_gotcha::wrapper::wrap(void* _arg)
     }
 
     // eliminate memory leak
-    if(_ret != _arg) delete _wrapper;
+    if(_ret != _arg) release(_wrapper);
 
     return _ret;
 }
 
+pthread_create_gotcha::wrapper*
+pthread_create_gotcha::wrapper::acquire(routine_t _routine, void* _arg,
+                                        wrapper_config _config)
+{
+    wrapper* _v = nullptr;
+    {
+        auto _lk = locking::atomic_lock{ *free_wrappers_mutex };
+        if(!free_wrappers->empty())
+        {
+            _v = free_wrappers->back();
+            free_wrappers->pop_back();
+        }
+    }
+
+    if(_v)
+    {
+        _v->m_routine = _routine;
+        _v->m_arg     = _arg;
+        _v->m_config  = std::move(_config);
+    }
+    else
+    {
+        _v = new wrapper{ _routine, _arg, std::move(_config) };
+    }
+
+    // the capacity of the cid stack copy is retained by the recycled wrappers
+    _v->m_parent_cids.clear();
+    if(_v->m_config.lazy)
+    {
+        const auto& _cids = get_cpu_cid_stack();
+        if(_cids) _v->m_parent_cids.assign(_cids->begin(), _cids->end());
+    }
+
+    return _v;
+}
+
+void
+pthread_create_gotcha::wrapper::release(wrapper* _v)
+{
+    if(!_v) return;
+
+    _v->m_routine = nullptr;
+    _v->m_arg     = nullptr;
+    _v->m_config  = wrapper_config{};
+
+    {
+        auto _lk = locking::atomic_lock{ *free_wrappers_mutex };
+        if(free_wrappers->size() < max_free_wrappers)
+        {
+            free_wrappers->emplace_back(_v);
+            return;
+        }
+    }
+
+    delete _v;
+}
+
 namespace
 {
 const auto shutdown_signal_v = SIGRTMAX - 1;
@@ -513,6 +606,7 @@ pthread_create_gotcha::operator()(pthread_t* thread, const pthread_attr_t* attr,
     auto        _mode         = get_mode();
     auto        _disabled     = (_thr_state == ThreadState::Disabled);
     auto        _enabled      = (_thr_state == ThreadState::Enabled);
+    auto        _internal     = (_thr_state == ThreadState::Internal);
     auto        _bundle       = std::optional<bundle_t>{};
     auto        _sample_child = sampling_enabled_on_child_threads();
     auto        _active       = (_glob_state == ::omnitrace::State::Active && !_disabled);
@@ -569,19 +663,27 @@ pthread_create_gotcha::operator()(pthread_t* thread, const pthread_attr_t* attr,
         get_cpu_cid_stack();
     }
 
+    // the new thread does not have to be set up before this function returns so the
+    // signals are only blocked in this thread (the new thread inherits the mask)
+    auto _lazy =
+        (_use_bundle && !_enable_causal && config::get_snapshot().lazy_thread_setup);
+    auto _scope = (_lazy) ? tim::signals::sigmask_scope::thread
+                          : tim::signals::sigmask_scope::process;
+
     set_thread_state(ThreadState::Disabled);
     auto _blocked = get_sampling_signals();
-    auto _promise = (_active) ? std::make_shared<std::promise<void>>() : promise_t{};
-    auto _config =
-        wrapper_config{ _enable_causal, _enable_sampling, _offset, _tid, _promise };
-    auto* _wrap = new wrapper{ func, arg, _config };
+    auto _promise = promise_t{};
+    if(_active && !_lazy) _promise = std::make_shared<std::promise<void>>();
+    auto  _config = wrapper_config{ _enable_causal, _enable_sampling, _offset, _lazy,
+                                    _internal,      _tid,             _promise };
+    auto* _wrap   = wrapper::acquire(func, arg, std::move(_config));
     set_thread_state(ThreadState::Internal);
 
-    // block the signals in entire process
+    // block the signals in entire process (or this thread)
     if(_enable_sampling && !_blocked.empty())
     {
         OMNITRACE_DEBUG("blocking signals...\n");
-        tim::signals::block_signals(_blocked, tim::signals::sigmask_scope::process);
+        tim::signals::block_signals(_blocked, _scope);
     }
 
     if(_use_bundle)
@@ -607,11 +709,11 @@ pthread_create_gotcha::operator()(pthread_t* thread, const pthread_attr_t* attr,
     if(_use_bundle)
         stop_bundle(*_bundle, _info->index_data->sequent_value, audit::outgoing{}, _ret);
 
-    // unblock the signals in the entire process
+    // unblock the signals in the entire process (or this thread)
     if(_enable_sampling && !_blocked.empty())
     {
         OMNITRACE_DEBUG("unblocking signals...\n");
-        tim::signals::unblock_signals(_blocked, tim::signals::sigmask_scope::process);
+        tim::signals::unblock_signals(_blocked, _scope);
     }
 
     OMNITRACE_DEBUG("returning success...\n");
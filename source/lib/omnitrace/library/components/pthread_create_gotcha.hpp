@@ -29,6 +29,7 @@
 
 #include <cstdint>
 #include <future>
+#include <vector>
 
 namespace omnitrace
 {
@@ -50,6 +51,8 @@ struct pthread_create_gotcha : tim::component::base<pthread_create_gotcha, void>
         bool      enable_causal   = false;
         bool      enable_sampling = false;
         bool      offset          = false;
+        bool      lazy            = false;  ///< see OMNITRACE_LAZY_THREAD_SETUP
+        bool      internal        = false;  ///< created by omnitrace or a backend
         int64_t   parent_tid      = 0;
         promise_t promise         = {};
     };
@@ -61,10 +64,17 @@ struct pthread_create_gotcha : tim::component::base<pthread_create_gotcha, void>
 
         static void* wrap(void* _arg);
 
+        /// returns a wrapper from the ones released by the exited threads, if any
+        static wrapper* acquire(routine_t _routine, void* _arg, wrapper_config _cfg);
+        static void     release(wrapper*);
+
     private:
         routine_t      m_routine = nullptr;
         void*          m_arg     = nullptr;
         wrapper_config m_config  = {};
+        // copy of the cpu cid stack of the parent for the lazy setup since the parent
+        // does not wait for the new thread
+        std::vector<uint64_t> m_parent_cids = {};
     };
 
     OMNITRACE_DEFAULT_OBJECT(pthread_create_gotcha)
@@ -21,20 +21,30 @@
 // SOFTWARE.
 
 #include "library/components/pthread_mutex_gotcha.hpp"
+#include "binary/analysis.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
+#include "core/hash_cache.hpp"
+#include "core/self_profile.hpp"
 #include "core/utility.hpp"
 #include "library/components/category_region.hpp"
+#include "library/lock_profile.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
+#include "library/tracing.hpp"
 
 #include <timemory/backends/threading.hpp>
+#include <timemory/unwind/processed_entry.hpp>
+#include <timemory/utility/backtrace.hpp>
 #include <timemory/utility/signals.hpp>
 #include <timemory/utility/types.hpp>
 
 #include <cstdint>
 #include <pthread.h>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace omnitrace
 {
@@ -72,7 +82,7 @@ pthread_mutex_gotcha::get_hashes()
         {
             auto&& _id = _data.at(i).tool_id;
             if(!_id.empty())
-                _init.at(i) = tim::add_hash_id(_id.c_str());
+                _init.at(i) = hash_cache::add_hash_id(_id.c_str());
             else
             {
                 if(_skip.count(i) > 0) continue;
@@ -168,11 +178,17 @@ pthread_mutex_gotcha::shutdown()
 
 pthread_mutex_gotcha::pthread_mutex_gotcha(const gotcha_data_t& _data)
 : m_data{ &_data }
-{}
+{
+    auto _id = std::string_view{ m_data->tool_id };
+    for(auto itr : { "pthread_mutex_", "pthread_rwlock_", "pthread_spin_" })
+        m_lock = m_lock || _id.find(itr) == 0;
+    m_acquire = m_lock && _id.find("unlock") == std::string_view::npos &&
+                _id.find("try") == std::string_view::npos;
+}
 
 template <typename... Args>
 auto
-pthread_mutex_gotcha::operator()(uintptr_t&&, int (*_callee)(Args...),
+pthread_mutex_gotcha::operator()(uintptr_t&& _addr, int (*_callee)(Args...),
                                  Args... _args) const
 {
     using bundle_t = category_region<category::pthread>;
@@ -199,9 +215,92 @@ pthread_mutex_gotcha::operator()(uintptr_t&&, int (*_callee)(Args...),
         bool& _protect;
     } _dtor{ m_protect = true };
 
-    bundle_t::audit(std::string_view{ m_data->tool_id }, audit::incoming{}, _args...);
+    if(m_lock && (config::get_snapshot().trace_thread_locks_contention_ns > 0 ||
+                  config::get_snapshot().trace_thread_locks_profile))
+    {
+        if(!m_acquire) return (*_callee)(_args...);
+        return contended(_addr, _callee, _args...);
+    }
+
+    {
+        OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+        bundle_t::audit(std::string_view{ m_data->tool_id }, audit::incoming{}, _args...);
+    }
     auto _ret = (*_callee)(_args...);
-    bundle_t::audit(std::string_view{ m_data->tool_id }, audit::outgoing{}, _ret);
+    {
+        OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+        bundle_t::audit(std::string_view{ m_data->tool_id }, audit::outgoing{}, _ret);
+    }
+
+    return _ret;
+}
+
+template <typename... Args>
+int
+pthread_mutex_gotcha::contended(uintptr_t _addr, int (*_callee)(Args...),
+                                Args... _args) const
+{
+    const auto& _cfg = config::get_snapshot();
+    auto        _beg = tracing::now();
+    auto        _ret = (*_callee)(_args...);
+    auto        _end = tracing::now();
+
+    // only the acquisitions which waited longer than the threshold are recorded
+    if(_end - _beg < _cfg.trace_thread_locks_contention_ns) return _ret;
+
+    if(_cfg.trace_thread_locks_profile)
+    {
+        OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+        lock_profile::record(_addr, lock_profile::get_call_site(), _end - _beg);
+    }
+
+    // without a threshold, the acquisitions are only recorded in the lock profile
+    if(_cfg.trace_thread_locks_contention_ns == 0 || !get_use_perfetto()) return _ret;
+
+    static thread_local size_t _count = 0;
+    if(_count++ % _cfg.trace_thread_locks_sample_interval != 0) return _ret;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+
+    constexpr size_t bt_stack_depth       = 16;
+    constexpr size_t bt_ignore_depth      = 3;
+    constexpr bool   bt_with_signal_frame = false;
+
+    // the call-stack of the waiter
+    auto _bt_data = std::vector<tim::unwind::processed_entry>{};
+    if(config::get_perfetto_annotations())
+    {
+        auto _backtrace =
+            tim::get_unw_stack<bt_stack_depth, bt_ignore_depth, bt_with_signal_frame>();
+        _bt_data.reserve(_backtrace.size());
+        for(auto itr : _backtrace)
+        {
+            if(!itr) continue;
+            if(auto _val = binary::lookup_ipaddr_entry<false>(itr->address()); _val)
+                _bt_data.emplace_back(std::move(*_val));
+        }
+    }
+
+    const char* _name = m_data->tool_id.c_str();
+    tracing::push_perfetto_ts(
+        category::pthread{}, _name, _beg, [&](::perfetto::EventContext ctx) {
+            if(!config::get_perfetto_annotations()) return;
+            tracing::add_perfetto_annotation(ctx, "lock", reinterpret_cast<void*>(_addr));
+            tracing::add_perfetto_annotation(ctx, "wait_ns", _end - _beg);
+            tracing::add_perfetto_annotation(ctx, "return", _ret);
+            for(size_t i = 0; i < _bt_data.size(); ++i)
+            {
+                const auto& itr   = _bt_data.at(i);
+                auto        _func = (itr.name.empty()) ? "??" : demangle(itr.name);
+                auto        _loc  = (itr.location.empty()) ? "??" : itr.location;
+                auto        _line = (itr.lineno == 0) ? "?" : JOIN("", itr.lineno);
+                // zero-padded for the ordering in the UI (the depth is limited to 16)
+                tracing::add_perfetto_annotation(
+                    ctx, JOIN("", (i < 10) ? "frame#0" : "frame#", i),
+                    JOIN("", _func, " @ ", _loc, ":", _line));
+            }
+        });
+    tracing::pop_perfetto_ts(category::pthread{}, _name, _end);
 
     return _ret;
 }
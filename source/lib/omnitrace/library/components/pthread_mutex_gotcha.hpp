@@ -68,7 +68,12 @@ private:
     template <typename... Args>
     auto operator()(uintptr_t&&, int (*)(Args...), Args...) const;
 
+    template <typename... Args>
+    int contended(uintptr_t, int (*)(Args...), Args...) const;
+
     mutable bool         m_protect = false;
+    bool                 m_lock    = false;  // mutex, rwlock, or spinlock function
+    bool                 m_acquire = false;  // blocking lock acquisition
     const gotcha_data_t* m_data    = nullptr;
 };
 
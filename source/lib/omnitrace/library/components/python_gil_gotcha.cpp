@@ -0,0 +1,171 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/python_gil_gotcha.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "library/python_gil.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/utility/types.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <string_view>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+// the value of PyGILState_STATE when the GIL was not held by the thread
+constexpr int gil_state_unlocked = 1;
+
+auto&
+get_python_gil_gotcha()
+{
+    static auto _v = tim::lightweight_tuple<python_gil_gotcha_t>{};
+    return _v;
+}
+
+bool
+is_traced(const python_gil::scoped_guard& _guard)
+{
+    return !_guard.nested() && get_state() == ::omnitrace::State::Active &&
+           get_thread_state() == ThreadState::Enabled;
+}
+
+bool
+is_release(const python_gil_gotcha::gotcha_data_t& _data)
+{
+    return std::string_view{ _data.tool_id } == "PyEval_ReleaseThread";
+}
+}  // namespace
+
+void
+python_gil_gotcha::configure()
+{
+    python_gil_gotcha_t::get_initializer() = []() {
+        python_gil_gotcha_t::configure<0, void, void*>("PyEval_RestoreThread");
+        python_gil_gotcha_t::configure<1, void, void*>("PyEval_AcquireThread");
+        python_gil_gotcha_t::configure<2, void, void*>("PyEval_ReleaseThread");
+        python_gil_gotcha_t::configure<3, void*>("PyEval_SaveThread");
+        python_gil_gotcha_t::configure<4, int>("PyGILState_Ensure");
+        python_gil_gotcha_t::configure<5, void, int>("PyGILState_Release");
+    };
+
+    python_gil_wait_tracker_t::label()       = "python_gil_wait";
+    python_gil_wait_tracker_t::description() = "Time waiting for the Python GIL";
+    python_gil_hold_tracker_t::label()       = "python_gil_hold";
+    python_gil_hold_tracker_t::description() = "Time holding the Python GIL";
+}
+
+void
+python_gil_gotcha::shutdown()
+{
+    python_gil_gotcha_t::disable();
+}
+
+void
+python_gil_gotcha::start()
+{
+    if(!python_gil::is_enabled()) return;
+
+    if(!get_python_gil_gotcha().get<python_gil_gotcha_t>()->get_is_running())
+    {
+        OMNITRACE_VERBOSE(1, "[python_gil] Wrapping the GIL functions of Python...\n");
+        configure();
+        get_python_gil_gotcha().start();
+    }
+}
+
+void
+python_gil_gotcha::stop()
+{}
+
+void
+python_gil_gotcha::operator()(const gotcha_data_t& _data, void (*_func)(void*),
+                              void* _tstate) const
+{
+    auto _guard = python_gil::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_tstate);
+
+    if(is_release(_data))
+    {
+        python_gil::record_release(tracing::now());
+        return (*_func)(_tstate);
+    }
+
+    auto _beg = tracing::now();
+    (*_func)(_tstate);
+    auto _errno = errno;
+    python_gil::record_acquire(_beg, tracing::now());
+    errno = _errno;
+}
+
+void*
+python_gil_gotcha::operator()(const gotcha_data_t&, void* (*_func)()) const
+{
+    auto _guard = python_gil::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)();
+
+    python_gil::record_release(tracing::now());
+    return (*_func)();
+}
+
+int
+python_gil_gotcha::operator()(const gotcha_data_t&, int (*_func)()) const
+{
+    auto _guard = python_gil::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)();
+
+    // the GIL is only acquired if it was not held by the thread
+    auto _beg   = tracing::now();
+    auto _ret   = (*_func)();
+    auto _errno = errno;
+    if(_ret == gil_state_unlocked) python_gil::record_acquire(_beg, tracing::now());
+    errno = _errno;
+    return _ret;
+}
+
+void
+python_gil_gotcha::operator()(const gotcha_data_t&, void (*_func)(int), int _state) const
+{
+    auto _guard = python_gil::scoped_guard{};
+    if(!is_traced(_guard)) return (*_func)(_state);
+
+    if(_state == gil_state_unlocked) python_gil::record_release(tracing::now());
+    (*_func)(_state);
+}
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::python_gil_wait>), true,
+    double)
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::python_gil_hold>), true,
+    double)
@@ -0,0 +1,93 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/components/fwd.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace omnitrace
+{
+namespace component
+{
+// this is used to wrap the functions of the Python C API which acquire and release the
+// GIL for the GIL contention (see OMNITRACE_PYTHON_GIL). The thread states and the
+// PyGILState_STATE values are opaque so Python is not required. The functions with the
+// same signature (PyEval_RestoreThread, PyEval_AcquireThread and PyEval_ReleaseThread)
+// are distinguished by the name of the wrapped function
+struct python_gil_gotcha : tim::component::base<python_gil_gotcha, void>
+{
+    static constexpr size_t gotcha_capacity = 6;
+
+    using gotcha_data_t = tim::component::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(python_gil_gotcha)
+
+    // string id for component
+    static std::string label() { return "python_gil_gotcha"; }
+
+    // generate the gotcha wrappers
+    static void configure();
+    static void shutdown();
+
+    static void start();
+    static void stop();
+
+    // PyEval_RestoreThread / PyEval_AcquireThread / PyEval_ReleaseThread
+    void operator()(const gotcha_data_t&, void (*)(void*), void*) const;
+    // PyEval_SaveThread
+    void* operator()(const gotcha_data_t&, void* (*)()) const;
+    // PyGILState_Ensure
+    int operator()(const gotcha_data_t&, int (*)()) const;
+    // PyGILState_Release
+    void operator()(const gotcha_data_t&, void (*)(int), int) const;
+};
+}  // namespace component
+
+using python_gil_gotcha_t =
+    tim::component::gotcha<component::python_gil_gotcha::gotcha_capacity, std::tuple<>,
+                           component::python_gil_gotcha>;
+}  // namespace omnitrace
+
+#if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                             \
+    (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#    include <timemory/components/base.hpp>
+#    include <timemory/components/data_tracker/components.hpp>
+#    include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::python_gil_wait>), true,
+    double)
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::python_gil_hold>), true,
+    double)
+#endif
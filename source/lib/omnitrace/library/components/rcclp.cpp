@@ -21,10 +21,13 @@
 // SOFTWARE.
 
 #include "library/components/rcclp.hpp"
+#include "library/rccl_timing.hpp"
 #include "library/rcclp.hpp"
 
 #include <timemory/manager.hpp>
 
+#include <vector>
+
 std::ostream&
 operator<<(std::ostream& _os, const ncclUniqueId& _v)
 {
@@ -167,6 +170,143 @@ rcclp_handle::stop()
     }
 }
 
+namespace
+{
+// the communicators being created by the calling thread. They are registered once the
+// call returns
+struct comm_init
+{
+    ncclComm_t* comms  = nullptr;
+    int32_t     ncomms = 0;
+    int32_t     rank   = 0;
+    int32_t     size   = 0;
+};
+
+comm_init&
+get_comm_init()
+{
+    static thread_local auto _v = comm_init{};
+    return _v;
+}
+
+uint64_t
+get_bytes(size_t _count, ncclDataType_t _datatype)
+{
+    return _count * comm_data::rccl_type_size(_datatype);
+}
+
+uintptr_t
+get_handle(ncclComm_t _comm)
+{
+    return reinterpret_cast<uintptr_t>(_comm);
+}
+}  // namespace
+
+// ncclCommInitRank
+void
+rcclp_timing::audit(const gotcha_data&, audit::incoming, ncclComm_t* _comm, int nranks,
+                    ncclUniqueId, int rank)
+{
+    get_comm_init() = comm_init{ _comm, 1, rank, nranks };
+}
+
+// ncclCommInitAll
+void
+rcclp_timing::audit(const gotcha_data&, audit::incoming, ncclComm_t* _comms, int ndev,
+                    const int*)
+{
+    get_comm_init() = comm_init{ _comms, ndev, 0, ndev };
+}
+
+// ncclGroupStart
+// ncclGroupEnd
+void
+rcclp_timing::audit(const gotcha_data& _data, audit::incoming)
+{
+    if(_data.tool_id == "ncclGroupStart")
+        rccl_timing::group_begin();
+    else if(_data.tool_id == "ncclGroupEnd")
+        rccl_timing::group_end();
+}
+
+// ncclReduce
+void
+rcclp_timing::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                    size_t count, ncclDataType_t datatype, ncclRedOp_t, int,
+                    ncclComm_t _comm, hipStream_t)
+{
+    rccl_timing::collective_begin(_data.tool_id, get_handle(_comm),
+                                  get_bytes(count, datatype));
+}
+
+// ncclSend
+// ncclRecv
+// ncclBcast
+void
+rcclp_timing::audit(const gotcha_data& _data, audit::incoming, const void*,
+                    size_t count, ncclDataType_t datatype, int, ncclComm_t _comm,
+                    hipStream_t)
+{
+    rccl_timing::collective_begin(_data.tool_id, get_handle(_comm),
+                                  get_bytes(count, datatype));
+}
+
+// ncclBroadcast
+// ncclGather
+// ncclScatter
+void
+rcclp_timing::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                    size_t count, ncclDataType_t datatype, int, ncclComm_t _comm,
+                    hipStream_t)
+{
+    rccl_timing::collective_begin(_data.tool_id, get_handle(_comm),
+                                  get_bytes(count, datatype));
+}
+
+// ncclAllReduce
+// ncclReduceScatter
+void
+rcclp_timing::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                    size_t count, ncclDataType_t datatype, ncclRedOp_t, ncclComm_t _comm,
+                    hipStream_t)
+{
+    rccl_timing::collective_begin(_data.tool_id, get_handle(_comm),
+                                  get_bytes(count, datatype));
+}
+
+// ncclAllGather
+// ncclAllToAll
+void
+rcclp_timing::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                    size_t count, ncclDataType_t datatype, ncclComm_t _comm, hipStream_t)
+{
+    rccl_timing::collective_begin(_data.tool_id, get_handle(_comm),
+                                  get_bytes(count, datatype));
+}
+
+void
+rcclp_timing::audit(const gotcha_data&, audit::outgoing, ncclResult_t _ret)
+{
+    auto& _init = get_comm_init();
+    if(_init.comms != nullptr && _ret == ncclSuccess)
+    {
+        if(_init.ncomms == 1)
+        {
+            rccl_timing::register_comm(get_handle(*_init.comms), _init.rank, _init.size);
+        }
+        else
+        {
+            auto _handles = std::vector<uintptr_t>{};
+            for(int32_t i = 0; i < _init.ncomms; ++i)
+                _handles.emplace_back(get_handle(_init.comms[i]));
+            rccl_timing::register_comms(_handles.data(), _init.ncomms);
+        }
+    }
+    _init = comm_init{};
+
+    rccl_timing::call_end();
+}
+
 rcclp_handle::persistent_data&
 rcclp_handle::get_persistent_data()
 {
@@ -44,11 +44,83 @@
 #    define OMNITRACE_NUM_RCCLP_WRAPPERS 25
 #endif
 
+namespace omnitrace
+{
+namespace component
+{
+/// attributes the HIP API calls made while an RCCL call is launched to the call so that
+/// the kernels it dispatches are timed on the device (see OMNITRACE_RCCLP_DEVICE_TIMING)
+struct rcclp_timing : base<rcclp_timing, void>
+{
+    using value_type = void;
+    using this_type  = rcclp_timing;
+    using base_type  = base<this_type, value_type>;
+
+    OMNITRACE_DEFAULT_OBJECT(rcclp_timing)
+
+    static std::string label() { return "rcclp_timing"; }
+    static std::string description()
+    {
+        return "Correlates the RCCL calls with the kernels they launch";
+    }
+    static void start() {}
+    static void stop() {}
+
+#if defined(OMNITRACE_USE_RCCL)
+    // ncclCommInitRank
+    static void audit(const gotcha_data& _data, audit::incoming, ncclComm_t*,
+                      int nranks, ncclUniqueId, int rank);
+
+    // ncclCommInitAll
+    static void audit(const gotcha_data& _data, audit::incoming, ncclComm_t*, int ndev,
+                      const int*);
+
+    // ncclGroupStart
+    // ncclGroupEnd
+    static void audit(const gotcha_data& _data, audit::incoming);
+
+    // ncclReduce
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclRedOp_t, int root,
+                      ncclComm_t, hipStream_t);
+
+    // ncclSend
+    // ncclRecv
+    // ncclBcast
+    static void audit(const gotcha_data& _data, audit::incoming, const void*,
+                      size_t count, ncclDataType_t datatype, int peer, ncclComm_t,
+                      hipStream_t);
+
+    // ncclBroadcast
+    // ncclGather
+    // ncclScatter
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, int root, ncclComm_t,
+                      hipStream_t);
+
+    // ncclAllReduce
+    // ncclReduceScatter
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclRedOp_t, ncclComm_t,
+                      hipStream_t);
+
+    // ncclAllGather
+    // ncclAllToAll
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclComm_t, hipStream_t);
+
+    // every wrapped function
+    static void audit(const gotcha_data& _data, audit::outgoing, ncclResult_t);
+#endif
+};
+}  // namespace component
+}  // namespace omnitrace
+
 OMNITRACE_COMPONENT_ALIAS(
     rccl_toolset_t,
     ::tim::component_bundle<category::rocm_rccl,
                             omnitrace::component::category_region<category::rocm_rccl>,
-                            comm_data>)
+                            comm_data, rcclp_timing>)
 OMNITRACE_COMPONENT_ALIAS(rcclp_gotcha_t,
                           ::tim::component::gotcha<OMNITRACE_NUM_RCCLP_WRAPPERS,
                                                    rccl_toolset_t, category::rocm_rccl>)
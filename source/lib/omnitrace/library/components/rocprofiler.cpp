@@ -57,13 +57,6 @@ rocprofiler_activity_count()
 }
 }  // namespace
 
-unique_ptr_t<rocm_data_t>&
-rocm_data(int64_t _tid)
-{
-    using thread_data_t = thread_data<rocm_data_t, rocm_event>;
-    return thread_data_t::instance(construct_on_thread{ _tid });
-}
-
 rocm_event::rocm_event(uint32_t _dev, uint32_t _thr, uint32_t _queue,
                        std::string _event_name, rocm_metric_type _begin,
                        rocm_metric_type _end, uint32_t _feature_count, void* _features_v)
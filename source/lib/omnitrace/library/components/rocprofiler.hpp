@@ -67,6 +67,8 @@ struct rocm_event
     uint32_t                        device_id      = 0;
     uint32_t                        thread_id      = 0;
     uint32_t                        queue_id       = 0;
+    uint32_t                        kernel_id      = 0;  ///< see rocm::kernel_symbol
+    uint32_t                        group          = 0;  ///< see rocm::roofline
     rocm_metric_type                entry          = 0;
     rocm_metric_type                exit           = 0;
     std::string                     name           = {};
@@ -95,9 +97,6 @@ struct rocm_event
 using rocm_data_t       = std::vector<rocm_event>;
 using rocm_data_tracker = data_tracker<rocm_feature_value, rocm_event>;
 
-omnitrace::unique_ptr_t<rocm_data_t>&
-rocm_data(int64_t _tid = threading::get_id());
-
 using rocprofiler_value = typename rocm_event::value_type;
 using rocprofiler_data  = data_tracker<rocprofiler_value, rocprofiler>;
 
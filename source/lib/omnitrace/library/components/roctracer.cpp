@@ -27,6 +27,7 @@
 #include "core/defines.hpp"
 #include "core/dynamic_library.hpp"
 #include "core/redirect.hpp"
+#include "library/rocm/queue_trace.hpp"
 #include "library/roctracer.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_data.hpp"
@@ -182,7 +183,15 @@ roctracer::setup(void* table, bool on_load_trace)
             ACTIVITY_DOMAIN_ROCTX, roctx_api_callback, nullptr));
     }
 
-    if(get_trace_hip_activity())
+    if(get_trace_hip_activity() && rocm::queue_trace::is_enabled())
+    {
+        // the kernel dispatches are timed through the HSA queues
+        OMNITRACE_ROCTRACER_CALL(
+            roctracer_enable_op_activity(ACTIVITY_DOMAIN_HIP_OPS, HIP_OP_ID_COPY));
+        OMNITRACE_ROCTRACER_CALL(
+            roctracer_enable_op_activity(ACTIVITY_DOMAIN_HIP_OPS, HIP_OP_ID_BARRIER));
+    }
+    else if(get_trace_hip_activity())
     {
         // Enable HIP activity tracing
         OMNITRACE_ROCTRACER_CALL(
@@ -301,6 +310,8 @@ roctracer::flush()
                           roctracer_activity_count().load());
     }
 
+    rocm::queue_trace::flush();
+
     OMNITRACE_VERBOSE_F(2, "executing hip_exec_activity_callbacks(0..%zu)\n",
                         thread_info::get_peak_num_threads());
     // make sure all async operations are executed
@@ -350,6 +361,8 @@ roctracer::shutdown()
             roctracer_disable_domain_callback(ACTIVITY_DOMAIN_HIP_API));
     }
 
+    flush_deferred_hip_api_calls();
+
     if(get_use_roctx())
     {
         OMNITRACE_VERBOSE_F(
@@ -358,6 +371,8 @@ roctracer::shutdown()
             roctracer_disable_domain_callback(ACTIVITY_DOMAIN_ROCTX));
     }
 
+    rocm::queue_trace::shutdown();
+
     if(get_trace_hip_activity())
     {
         OMNITRACE_VERBOSE_F(
@@ -385,6 +400,9 @@ roctracer::shutdown()
             roctracer_disable_op_activity(ACTIVITY_DOMAIN_HSA_OPS, HSA_OP_ID_COPY));
     }
 
+    write_roctracer_aggregate();
+    write_hsa_api_sampling();
+
     OMNITRACE_VERBOSE_F(1, "roctracer is shutdown\n");
 }
 
@@ -22,22 +22,34 @@
 
 #include "library/coverage.hpp"
 #include "api.hpp"
+#include "binary/analysis.hpp"
+#include "binary/binary_info.hpp"
+#include "core/common.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "library/coverage/impl.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/backends/threading.hpp>
+#include <timemory/process/process.hpp>
 #include <timemory/tpls/cereal/cereal.hpp>
 #include <timemory/utility/popen.hpp>
+#include <timemory/utility/procfs/maps.hpp>
 
 #include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iterator>
 #include <map>
 #include <mutex>
+#include <set>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #define OMNITRACE_SERIALIZE(MEMBER_VARIABLE)                                             \
     ar(::tim::cereal::make_nvp(#MEMBER_VARIABLE, MEMBER_VARIABLE))
@@ -89,6 +101,102 @@ get_coverage_count(int64_t _tid = tim::threading::get_id())
 {
     return coverage_thread_data::instance(construct_on_thread{ _tid });
 }
+//
+// the counters incremented inline by the instrumentation (omnitrace-instrument
+// --coverage-counters) and the index of their entry in the coverage data
+auto&
+get_coverage_counters()
+{
+    static auto _v = std::vector<std::pair<size_t, const volatile uint64_t*>>{};
+    return _v;
+}
+//
+void
+add_coverage_data(const char* file, const char* func, size_t line, size_t address,
+                  const char* source)
+{
+    get_coverage_data().emplace_back(
+        coverage_data{ size_t{ 0 }, address, line, file, func,
+                       (source && strlen(source) > 0) ? source : func });
+
+    get_code_coverage().size += 1;
+    get_code_coverage().possible.modules.emplace(file);
+    get_code_coverage().possible.functions.emplace(func);
+    get_code_coverage().possible.addresses.emplace(address);
+}
+//
+void
+write_output(const std::string& _name, const code_coverage& _summary,
+             const coverage_data_vector& _details, bool _text, bool _json)
+{
+    if(_text)
+    {
+        auto          _fname = tim::settings::compose_output_filename(_name, ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<code_coverage>{}(_fname, _name);
+            for(const auto& itr : _details)
+            {
+                auto _addr = TIMEMORY_JOIN("", "0x", std::hex, itr.address);
+                ofs << std::setw(8) << itr.count << "  " << std::setw(8) << _addr << "  "
+                    << itr.source << "\n";
+            }
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening coverage output file: %s", _fname.c_str());
+        }
+    }
+
+    if(_json)
+    {
+        std::stringstream oss{};
+        {
+            namespace cereal = tim::cereal;
+            auto ar =
+                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+            ar->setNextName("omnitrace");
+            ar->startNode();
+            ar->setNextName("coverage");
+            ar->startNode();
+            (*ar)(cereal::make_nvp("summary", _summary));
+            (*ar)(cereal::make_nvp("details", _details));
+            ar->finishNode();
+            ar->finishNode();
+        }
+        auto _fname = tim::settings::compose_output_filename(_name, ".json");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<code_coverage>{}(_fname, _name);
+            ofs << oss.str() << "\n";
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening coverage output file: %s", _fname.c_str());
+        }
+    }
+}
+//
+// the addresses recorded by the samplers for the approximate code coverage
+struct sampled_data
+{
+    std::mutex                                          mutex     = {};
+    std::unordered_map<uintptr_t, uint64_t>             addresses = {};
+    std::map<std::pair<uintptr_t, uintptr_t>, uint64_t> ranges    = {};
+};
+//
+auto&
+get_sampled_data()
+{
+    // intentionally leaked
+    static auto* _v = new sampled_data{};
+    return *_v;
+}
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -160,6 +268,14 @@ post_process()
                 }
             }
         }
+
+        for(const auto& itr : get_coverage_counters())
+        {
+            auto& _entry = _coverage_data.at(itr.first);
+            auto  _count = static_cast<size_t>(*itr.second);
+            _entry.count += _count;
+            _data[_entry.module][_entry.function][_entry.address] += _count;
+        }
     }
 
     for(const auto& file : _data)
@@ -179,6 +295,9 @@ post_process()
         }
     }
 
+    // created before the entries with the same source are combined below
+    auto _bitmap = coverage_bitmap::from_details(_coverage_data);
+
     std::sort(_coverage_data.begin(), _coverage_data.end(),
               std::greater<coverage_data>{});
 
@@ -228,69 +347,204 @@ post_process()
     auto _text_output = _get_setting("OMNITRACE_TEXT_OUTPUT");
     auto _json_output = _get_setting("OMNITRACE_JSON_OUTPUT");
 
-    if(_text_output)
+    write_output("coverage", _coverage, _coverage_data, _text_output, _json_output);
+
     {
-        auto          _fname = tim::settings::compose_output_filename("coverage", ".txt");
-        std::ofstream ofs{};
-        if(tim::filepath::open(ofs, _fname))
+        auto _fname = tim::settings::compose_output_filename("coverage", ".bin");
+        if(get_verbose() >= 0)
+            operation::file_output_message<code_coverage>{}(_fname,
+                                                            std::string{ "coverage" });
+        _bitmap.save(_fname);
+    }
+
+    if(get_verbose() >= 0) fprintf(stderr, "\n");
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+record_samples(const std::vector<uintptr_t>& _addrs, uint64_t _count)
+{
+    auto& _data = get_sampled_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    for(size_t i = 0; i < _addrs.size(); ++i)
+    {
+        // the outer frames are return addresses: the call is the preceding instruction
+        auto _addr = _addrs.at(i);
+        if(_addr == 0) continue;
+        _data.addresses[(i == 0) ? _addr : (_addr - 1)] += _count;
+    }
+}
+
+void
+record_range(uintptr_t _beg, uintptr_t _end, uint64_t _count)
+{
+    if(_beg == 0 || _end < _beg) return;
+
+    auto& _data = get_sampled_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    _data.ranges[{ _beg, _end }] += _count;
+}
+
+void
+post_process_sampling()
+{
+    auto& _data = get_sampled_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    if(_data.addresses.empty() && _data.ranges.empty())
+    {
+        OMNITRACE_VERBOSE_F(0, "Warning! Sampling code coverage enabled but no samples "
+                               "were recorded!\n");
+        return;
+    }
+
+    // the binaries mapped at the finalization which contain a sampled address
+    auto _filter = [](const tim::procfs::maps& _v) {
+        return (!_v.pathname.empty() && _v.pathname.front() == '/' &&
+                filepath::exists(_v.pathname));
+    };
+    auto _maps = tim::procfs::get_contiguous_maps(process::get_id(), _filter, false);
+    std::sort(_maps.begin(), _maps.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.load_address < _rhs.load_address;
+    });
+
+    auto _files    = std::set<std::string>{};
+    auto _add_file = [&_maps, &_files](uintptr_t _addr) {
+        if(binary::is_internal_ipaddr(_addr)) return;
+        auto itr = std::upper_bound(
+            _maps.begin(), _maps.end(), _addr,
+            [](uintptr_t _v, const auto& _map) { return _v < _map.load_address; });
+        if(itr == _maps.begin()) return;
+        --itr;
+        if(_addr <= itr->last_address) _files.emplace(itr->pathname);
+    };
+    for(const auto& itr : _data.addresses)
+        _add_file(itr.first);
+    for(const auto& itr : _data.ranges)
+        _add_file(itr.first.first);
+
+    auto _paths = std::vector<std::string>{ _files.begin(), _files.end() };
+    auto _info  = binary::get_binary_info(_paths, {});
+
+    // every line of the DWARF line table of a function is a coverage entity. The
+    // functions without line info are a single entity
+    struct line_range
+    {
+        uintptr_t low   = 0;  // runtime address
+        uintptr_t high  = 0;
+        size_t    index = 0;  // in the details
+    };
+
+    using key_t = std::tuple<std::string, std::string, size_t>;
+
+    auto _summary = code_coverage{};
+    auto _details = coverage_data_vector{};
+    auto _index   = std::map<key_t, size_t>{};
+    auto _lines   = std::vector<line_range>{};
+
+    _summary.approximate = true;
+    for(const auto& bitr : _info)
+    {
+        for(const auto& sitr : bitr.symbols)
         {
-            if(get_verbose() >= 0)
-                operation::file_output_message<code_coverage>{}(
-                    _fname, std::string{ "coverage" });
-            for(auto& itr : _coverage_data)
-            {
-                // if(get_debug() && get_verbose() >= 2)
-                if(true)
-                {
-                    auto _addr = TIMEMORY_JOIN("", "0x", std::hex, itr.address);
-                    ofs << std::setw(8) << itr.count << "  " << std::setw(8) << _addr
-                        << "  " << itr.source << "\n";
-                }
-                else
+            if(sitr.func.empty() || !sitr.address.is_range()) continue;
+
+            auto _func = tim::demangle(sitr.func);
+            auto _add  = [&](const std::string& _file, size_t _line,
+                            binary::address_range _range) {
+                auto _key = key_t{ _file, _func, _line };
+                auto itr  = _index.find(_key);
+                if(itr == _index.end())
                 {
-                    ofs << std::setw(8) << itr.count << "  " << itr.source << "\n";
+                    auto _source = JOIN("", _func, " [", _file, "] [{", _line, "}]");
+                    itr = _index.emplace(std::move(_key), _details.size()).first;
+                    _details.emplace_back(coverage_data{ size_t{ 0 }, _range.low, _line,
+                                                         _file, _func, _source });
+                    _summary.size += 1;
+                    _summary.possible.modules.emplace(_file);
+                    _summary.possible.functions.emplace(_func);
+                    _summary.possible.addresses.emplace(_range.low);
                 }
+                _lines.emplace_back(line_range{ _range.low + sitr.load_address,
+                                                _range.high + sitr.load_address,
+                                                itr->second });
+            };
+
+            auto _lines_added = false;
+            for(const auto& ditr : sitr.dwarf_info)
+            {
+                if(ditr.line == 0 || !ditr.address.is_range()) continue;
+                _add(ditr.file.str(), ditr.line, ditr.address);
+                _lines_added = true;
             }
-        }
-        else
-        {
-            OMNITRACE_THROW("Error opening coverage output file: %s", _fname.c_str());
+
+            if(!_lines_added)
+                _add((sitr.file.empty()) ? bitr.filename() : sitr.file.str(), sitr.line,
+                     sitr.address);
         }
     }
 
-    if(_json_output)
+    std::sort(_lines.begin(), _lines.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.low < _rhs.low;
+    });
+
+    // the line ranges which contain (or overlap) the sampled addresses
+    auto _find = [&_lines](uintptr_t _addr) {
+        auto itr = std::upper_bound(
+            _lines.begin(), _lines.end(), _addr,
+            [](uintptr_t _v, const line_range& _line) { return _v < _line.low; });
+        return (itr == _lines.begin()) ? _lines.begin() : std::prev(itr);
+    };
+
+    for(const auto& itr : _data.addresses)
     {
-        std::stringstream oss{};
-        {
-            namespace cereal = tim::cereal;
-            auto ar =
-                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+        auto litr = _find(itr.first);
+        if(litr != _lines.end() && litr->low <= itr.first && itr.first < litr->high)
+            _details.at(litr->index).count += itr.second;
+    }
 
-            ar->setNextName("omnitrace");
-            ar->startNode();
-            ar->setNextName("coverage");
-            ar->startNode();
-            (*ar)(cereal::make_nvp("summary", _coverage));
-            (*ar)(cereal::make_nvp("details", _coverage_data));
-            ar->finishNode();
-            ar->finishNode();
-        }
-        auto _fname = tim::settings::compose_output_filename("coverage", ".json");
-        std::ofstream ofs{};
-        if(tim::filepath::open(ofs, _fname))
-        {
-            if(get_verbose() >= 0)
-                operation::file_output_message<code_coverage>{}(
-                    _fname, std::string{ "coverage" });
-            ofs << oss.str() << "\n";
-        }
-        else
+    for(const auto& itr : _data.ranges)
+    {
+        for(auto litr = _find(itr.first.first);
+            litr != _lines.end() && litr->low <= itr.first.second; ++litr)
         {
-            OMNITRACE_THROW("Error opening coverage output file: %s", _fname.c_str());
+            if(litr->high > itr.first.first) _details.at(litr->index).count += itr.second;
         }
     }
 
-    if(get_verbose() >= 0) fprintf(stderr, "\n");
+    for(const auto& itr : _details)
+    {
+        if(itr.count == 0) continue;
+        _summary.count += 1;
+        _summary.covered.modules.emplace(itr.module);
+        _summary.covered.functions.emplace(itr.function);
+        _summary.covered.addresses.emplace(itr.address);
+    }
+
+    std::sort(_details.begin(), _details.end(), std::greater<coverage_data>{});
+
+    OMNITRACE_VERBOSE(0, "approximate code coverage     :: %6.2f%s\n",
+                      _summary() * 100.0, "%");
+    OMNITRACE_VERBOSE(0, "approximate module coverage   :: %6.2f%s\n",
+                      _summary(code_coverage::MODULE) * 100.0, "%");
+    OMNITRACE_VERBOSE(0, "approximate function coverage :: %6.2f%s\n",
+                      _summary(code_coverage::FUNCTION) * 100.0, "%");
+
+    try
+    {
+        write_output(
+            "sampling-coverage", _summary, _details,
+            config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true),
+            config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true));
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "writing the sampling code coverage failed: %s\n",
+                            _e.what());
+    }
+
+    _data.addresses.clear();
+    _data.ranges.clear();
 }
 }  // namespace coverage
 }  // namespace omnitrace
@@ -305,19 +559,10 @@ omnitrace_register_source_hidden(const char* file, const char* func, size_t line
 {
     if(coverage::get_post_processed()) return;
 
-    using coverage_data = coverage::coverage_data;
-
     OMNITRACE_BASIC_VERBOSE_F(4, "[0x%x] :: %-20s :: %20s:%zu :: %s\n",
                               (unsigned int) address, func, file, line, source);
 
-    coverage::get_coverage_data().emplace_back(
-        coverage_data{ size_t{ 0 }, address, line, file, func,
-                       (source && strlen(source) > 0) ? source : func });
-
-    coverage::get_code_coverage().size += 1;
-    coverage::get_code_coverage().possible.modules.emplace(file);
-    coverage::get_code_coverage().possible.functions.emplace(func);
-    coverage::get_code_coverage().possible.addresses.emplace(address);
+    coverage::add_coverage_data(file, func, line, address, source);
 
     // initialize
     for(size_t i = 0; i < coverage::coverage_thread_data::size(); ++i)
@@ -344,3 +589,22 @@ omnitrace_register_coverage_hidden(const char* file, const char* func, size_t ad
 }
 
 //--------------------------------------------------------------------------------------//
+
+extern "C" void
+omnitrace_register_coverage_counter_hidden(const char* file, const char* func,
+                                           size_t line, size_t address,
+                                           const char*              source,
+                                           const volatile uint64_t* counter)
+{
+    if(coverage::get_post_processed() || !counter) return;
+
+    OMNITRACE_BASIC_VERBOSE_F(4, "[0x%x] :: %-20s :: %20s:%zu :: %s (counter: %p)\n",
+                              (unsigned int) address, func, file, line, source,
+                              (const void*) counter);
+
+    coverage::add_coverage_data(file, func, line, address, source);
+    coverage::get_coverage_counters().emplace_back(
+        coverage::get_coverage_data().size() - 1, counter);
+}
+
+//--------------------------------------------------------------------------------------//
@@ -27,8 +27,12 @@
 #include <timemory/tpls/cereal/cereal/cereal.hpp>
 
 #include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #if !defined(OMNITRACE_SERIALIZE)
 #    define OMNITRACE_SERIALIZE(MEMBER_VARIABLE)                                         \
@@ -42,6 +46,23 @@ namespace coverage
 #if !defined(OMNITRACE_PYBIND11_SOURCE) || OMNITRACE_PYBIND11_SOURCE == 0
 void
 post_process();
+
+/// records the instruction pointers of a sampled call-stack for the approximate code
+/// coverage (see OMNITRACE_SAMPLING_COVERAGE). The addresses start at the innermost
+/// frame and _count is the number of samples of the call-stack
+void
+record_samples(const std::vector<uintptr_t>& _addrs, uint64_t _count);
+
+/// records a range of instructions, from _beg to _end (inclusive), which executed
+/// without a taken branch (see OMNITRACE_SAMPLING_BRANCH_STACK)
+void
+record_range(uintptr_t _beg, uintptr_t _end, uint64_t _count);
+
+/// maps the recorded addresses to the functions and the lines of the DWARF line table
+/// of the sampled binaries and writes sampling-coverage.{txt,json}. The entities which
+/// were never sampled are not necessarily uncovered so the summary is approximate
+void
+post_process_sampling();
 #endif
 
 //--------------------------------------------------------------------------------------//
@@ -87,10 +108,11 @@ struct code_coverage
     template <typename ArchiveT>
     void serialize(ArchiveT& ar, const unsigned version);
 
-    size_t count    = 0;
-    size_t size     = 0;
-    data   covered  = {};
-    data   possible = {};
+    size_t count       = 0;
+    size_t size        = 0;
+    bool   approximate = false;  ///< derived from the samples, not the instrumentation
+    data   covered     = {};
+    data   possible    = {};
 };
 //
 template <typename ArchiveT>
@@ -103,6 +125,7 @@ code_coverage::serialize(ArchiveT& ar, const unsigned version)
     OMNITRACE_SERIALIZE(possible);
     if constexpr(tim::concepts::is_output_archive<ArchiveT>::value)
     {
+        OMNITRACE_SERIALIZE(approximate);
         ar.setNextName("coverage");
         ar.startNode();
         ar(tim::cereal::make_nvp("total", get(STANDARD)));
@@ -111,6 +134,17 @@ code_coverage::serialize(ArchiveT& ar, const unsigned version)
         ar(tim::cereal::make_nvp("functions", get(FUNCTION)));
         ar.finishNode();
     }
+    else
+    {
+        // the files written by the earlier versions do not have it
+        try
+        {
+            OMNITRACE_SERIALIZE(approximate);
+        } catch(std::exception&)
+        {
+            approximate = false;
+        }
+    }
     (void) version;
 }
 //
@@ -168,6 +202,63 @@ coverage_data::serialize(ArchiveT& ar, const unsigned version)
     OMNITRACE_SERIALIZE(source);
     (void) version;
 }
+
+//--------------------------------------------------------------------------------------//
+//
+/// \struct coverage_bitmap
+/// \brief Compact representation of the code coverage: a deduplicated table of the
+/// coverage entities of every module and a bitmap of the entities which were covered.
+/// Merging the coverage of the processes which instrumented the same binaries is a
+/// bitwise OR of the bitmaps. The number of times an entity was executed is not kept
+//
+//--------------------------------------------------------------------------------------//
+
+struct coverage_bitmap
+{
+    using word_t = uint64_t;
+
+    static constexpr size_t   word_bits = 8 * sizeof(word_t);
+    static constexpr uint32_t version   = 1;
+
+    struct entry
+    {
+        uint32_t function = 0;  ///< index in the string table
+        uint32_t source   = 0;  ///< index in the string table
+        uint64_t address  = 0;
+        uint64_t line     = 0;
+    };
+
+    struct module_data
+    {
+        bool test(size_t _idx) const;
+        void set(size_t _idx);
+
+        uint32_t            name    = 0;   ///< index in the string table
+        std::vector<entry>  entries = {};  ///< sorted by function and address
+        std::vector<word_t> covered = {};  ///< one bit per entry
+    };
+
+    static coverage_bitmap from_details(const std::vector<coverage_data>&);
+
+    /// throws std::runtime_error if the file is not a coverage bitmap
+    static coverage_bitmap load(const std::string& _fname);
+
+    /// throws std::runtime_error if the file can not be written
+    void save(const std::string& _fname) const;
+
+    std::vector<coverage_data> get_details() const;
+    code_coverage              get_summary() const;
+
+    coverage_bitmap& operator|=(const coverage_bitmap&);
+
+    std::vector<std::string> strings = {};
+    std::vector<module_data> modules = {};
+
+private:
+    uint32_t get_string_index(const std::string&);
+
+    std::unordered_map<std::string, uint32_t> m_string_index = {};
+};
 //
 }  // namespace coverage
 }  // namespace omnitrace
@@ -29,11 +29,21 @@
 
 #include "library/coverage.hpp"
 
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/join.hpp>
+
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iosfwd>
+#include <map>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace omnitrace
@@ -189,6 +199,330 @@ coverage_data::operator>=(const coverage_data& rhs) const
 {
     return !(*this < rhs);
 }
+
+//--------------------------------------------------------------------------------------//
+
+namespace
+{
+constexpr char coverage_bitmap_magic[8] = { 'O', 'M', 'N', 'I', 'C', 'O', 'V', '\0' };
+
+// the entities of a module keyed by function and address, and whether they were covered
+using coverage_entry_map_t =
+    std::map<std::pair<uint32_t, uint64_t>, std::pair<coverage_bitmap::entry, bool>>;
+
+auto
+get_entry_key(const coverage_bitmap::entry& _v)
+{
+    return std::make_pair(_v.function, _v.address);
+}
+
+bool
+is_same_entry(const coverage_bitmap::entry& _lhs, const coverage_bitmap::entry& _rhs)
+{
+    return std::tie(_lhs.function, _lhs.source, _lhs.address, _lhs.line) ==
+           std::tie(_rhs.function, _rhs.source, _rhs.address, _rhs.line);
+}
+
+coverage_bitmap::module_data
+make_module_data(uint32_t _name, const coverage_entry_map_t& _entries)
+{
+    constexpr auto _word_bits = coverage_bitmap::word_bits;
+
+    auto _v = coverage_bitmap::module_data{};
+    _v.name = _name;
+    _v.entries.reserve(_entries.size());
+    _v.covered.resize((_entries.size() + _word_bits - 1) / _word_bits, 0);
+    for(const auto& itr : _entries)
+    {
+        if(itr.second.second) _v.set(_v.entries.size());
+        _v.entries.emplace_back(itr.second.first);
+    }
+    return _v;
+}
+
+template <typename Tp>
+void
+write_binary(std::ostream& _os, const Tp& _v)
+{
+    _os.write(reinterpret_cast<const char*>(&_v), sizeof(Tp));
+}
+
+template <typename Tp>
+Tp
+read_binary(std::istream& _is)
+{
+    auto _v = Tp{};
+    if(!_is.read(reinterpret_cast<char*>(&_v), sizeof(Tp)))
+        throw std::runtime_error("unexpected end of file");
+    return _v;
+}
+}  // namespace
+
+bool
+coverage_bitmap::module_data::test(size_t _idx) const
+{
+    return ((covered.at(_idx / word_bits) >> (_idx % word_bits)) & 1) == 1;
+}
+
+void
+coverage_bitmap::module_data::set(size_t _idx)
+{
+    covered.at(_idx / word_bits) |= (word_t{ 1 } << (_idx % word_bits));
+}
+
+uint32_t
+coverage_bitmap::get_string_index(const std::string& _v)
+{
+    if(m_string_index.size() != strings.size())
+    {
+        m_string_index.clear();
+        for(size_t i = 0; i < strings.size(); ++i)
+            m_string_index.emplace(strings.at(i), static_cast<uint32_t>(i));
+    }
+
+    auto itr = m_string_index.find(_v);
+    if(itr != m_string_index.end()) return itr->second;
+
+    auto _idx = static_cast<uint32_t>(strings.size());
+    strings.emplace_back(_v);
+    m_string_index.emplace(_v, _idx);
+    return _idx;
+}
+
+coverage_bitmap
+coverage_bitmap::from_details(const std::vector<coverage_data>& _data)
+{
+    auto _v       = coverage_bitmap{};
+    auto _modules = std::map<uint32_t, coverage_entry_map_t>{};
+    for(const auto& itr : _data)
+    {
+        auto _entry = entry{ _v.get_string_index(itr.function),
+                             _v.get_string_index(itr.source), itr.address, itr.line };
+        auto& _value = _modules[_v.get_string_index(itr.module)]
+                           .try_emplace(get_entry_key(_entry), _entry, false)
+                           .first->second;
+        _value.second = _value.second || itr.count > 0;
+    }
+
+    _v.modules.reserve(_modules.size());
+    for(const auto& itr : _modules)
+        _v.modules.emplace_back(make_module_data(itr.first, itr.second));
+    return _v;
+}
+
+coverage_bitmap
+coverage_bitmap::load(const std::string& _fname)
+{
+    auto _ifs = std::ifstream{ _fname, std::ios::in | std::ios::binary };
+    if(!_ifs)
+        throw std::runtime_error(
+            TIMEMORY_JOIN("", "Error opening coverage bitmap: ", _fname));
+
+    auto _v = coverage_bitmap{};
+    try
+    {
+        char _magic[sizeof(coverage_bitmap_magic)] = {};
+        if(!_ifs.read(_magic, sizeof(_magic)) ||
+           std::memcmp(_magic, coverage_bitmap_magic, sizeof(_magic)) != 0)
+            throw std::runtime_error("not a coverage bitmap");
+        if(read_binary<uint32_t>(_ifs) != version)
+            throw std::runtime_error("unsupported version");
+
+        auto _nstrings = read_binary<uint64_t>(_ifs);
+        for(uint64_t i = 0; i < _nstrings; ++i)
+        {
+            auto _str = std::string(read_binary<uint64_t>(_ifs), '\0');
+            if(!_ifs.read(_str.data(), _str.size()))
+                throw std::runtime_error("unexpected end of file");
+            _v.strings.emplace_back(std::move(_str));
+        }
+
+        auto _check_index = [&_v](uint32_t _idx) {
+            if(_idx >= _v.strings.size())
+                throw std::runtime_error("invalid index in the string table");
+            return _idx;
+        };
+
+        auto _nmodules = read_binary<uint64_t>(_ifs);
+        for(uint64_t i = 0; i < _nmodules; ++i)
+        {
+            auto& _module  = _v.modules.emplace_back();
+            _module.name   = _check_index(read_binary<uint32_t>(_ifs));
+            auto _nentries = read_binary<uint64_t>(_ifs);
+            for(uint64_t j = 0; j < _nentries; ++j)
+            {
+                auto& _entry    = _module.entries.emplace_back();
+                _entry.function = _check_index(read_binary<uint32_t>(_ifs));
+                _entry.source   = _check_index(read_binary<uint32_t>(_ifs));
+                _entry.address  = read_binary<uint64_t>(_ifs);
+                _entry.line     = read_binary<uint64_t>(_ifs);
+            }
+            _module.covered.resize((_nentries + word_bits - 1) / word_bits, 0);
+            for(auto& itr : _module.covered)
+                itr = read_binary<word_t>(_ifs);
+        }
+    } catch(std::runtime_error& _e)
+    {
+        throw std::runtime_error(
+            TIMEMORY_JOIN("", "Error reading coverage bitmap ", _fname, ": ", _e.what()));
+    }
+
+    return _v;
+}
+
+void
+coverage_bitmap::save(const std::string& _fname) const
+{
+    auto _ofs = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname, std::ios::out | std::ios::binary))
+        throw std::runtime_error(
+            TIMEMORY_JOIN("", "Error opening coverage bitmap output file: ", _fname));
+
+    _ofs.write(coverage_bitmap_magic, sizeof(coverage_bitmap_magic));
+    write_binary<uint32_t>(_ofs, version);
+    write_binary<uint64_t>(_ofs, strings.size());
+    for(const auto& itr : strings)
+    {
+        write_binary<uint64_t>(_ofs, itr.size());
+        _ofs.write(itr.data(), itr.size());
+    }
+
+    write_binary<uint64_t>(_ofs, modules.size());
+    for(const auto& itr : modules)
+    {
+        write_binary<uint32_t>(_ofs, itr.name);
+        write_binary<uint64_t>(_ofs, itr.entries.size());
+        for(const auto& eitr : itr.entries)
+        {
+            write_binary<uint32_t>(_ofs, eitr.function);
+            write_binary<uint32_t>(_ofs, eitr.source);
+            write_binary<uint64_t>(_ofs, eitr.address);
+            write_binary<uint64_t>(_ofs, eitr.line);
+        }
+        _ofs.write(reinterpret_cast<const char*>(itr.covered.data()),
+                   itr.covered.size() * sizeof(word_t));
+    }
+
+    if(!_ofs)
+        throw std::runtime_error(
+            TIMEMORY_JOIN("", "Error writing coverage bitmap output file: ", _fname));
+}
+
+std::vector<coverage_data>
+coverage_bitmap::get_details() const
+{
+    auto _v = std::vector<coverage_data>{};
+    for(const auto& itr : modules)
+    {
+        for(size_t i = 0; i < itr.entries.size(); ++i)
+        {
+            const auto& _entry = itr.entries.at(i);
+            _v.emplace_back(coverage_data{
+                (itr.test(i)) ? size_t{ 1 } : size_t{ 0 }, _entry.address, _entry.line,
+                strings.at(itr.name), strings.at(_entry.function),
+                strings.at(_entry.source) });
+        }
+    }
+    return _v;
+}
+
+code_coverage
+coverage_bitmap::get_summary() const
+{
+    auto _v = code_coverage{};
+    for(const auto& itr : modules)
+    {
+        const auto& _module = strings.at(itr.name);
+        for(size_t i = 0; i < itr.entries.size(); ++i)
+        {
+            const auto& _entry    = itr.entries.at(i);
+            const auto& _function = strings.at(_entry.function);
+            if(itr.test(i))
+            {
+                _v.count += 1;
+                _v.covered.modules.emplace(_module);
+                _v.covered.functions.emplace(_function);
+                _v.covered.addresses.emplace(_entry.address);
+            }
+            _v.size += 1;
+            _v.possible.modules.emplace(_module);
+            _v.possible.functions.emplace(_function);
+            _v.possible.addresses.emplace(_entry.address);
+        }
+    }
+    return _v;
+}
+
+coverage_bitmap&
+coverage_bitmap::operator|=(const coverage_bitmap& rhs)
+{
+    auto _same_entries = [](const module_data& _lhs, const module_data& _rhs) {
+        return _lhs.name == _rhs.name && _lhs.entries.size() == _rhs.entries.size() &&
+               std::equal(_lhs.entries.begin(), _lhs.entries.end(), _rhs.entries.begin(),
+                          is_same_entry);
+    };
+
+    // the processes instrumented the same binaries so the bitmaps have the same layout.
+    // The loop is a plain OR of the words which the compiler vectorizes
+    if(strings == rhs.strings && modules.size() == rhs.modules.size() &&
+       std::equal(modules.begin(), modules.end(), rhs.modules.begin(), _same_entries))
+    {
+        for(size_t i = 0; i < modules.size(); ++i)
+        {
+            auto*       _dst = modules[i].covered.data();
+            const auto* _src = rhs.modules[i].covered.data();
+            for(size_t j = 0, n = modules[i].covered.size(); j < n; ++j)
+                _dst[j] |= _src[j];
+        }
+        return *this;
+    }
+
+    // otherwise the tables are merged
+    auto _strings = std::vector<uint32_t>{};
+    _strings.reserve(rhs.strings.size());
+    for(const auto& itr : rhs.strings)
+        _strings.emplace_back(get_string_index(itr));
+
+    auto _module_index = std::unordered_map<uint32_t, size_t>{};
+    for(size_t i = 0; i < modules.size(); ++i)
+        _module_index.emplace(modules.at(i).name, i);
+
+    for(const auto& ritr : rhs.modules)
+    {
+        auto _name    = _strings.at(ritr.name);
+        auto _entries = coverage_entry_map_t{};
+        auto mitr     = _module_index.find(_name);
+        if(mitr != _module_index.end())
+        {
+            const auto& _lhs = modules.at(mitr->second);
+            for(size_t i = 0; i < _lhs.entries.size(); ++i)
+                _entries.emplace(get_entry_key(_lhs.entries.at(i)),
+                                 std::make_pair(_lhs.entries.at(i), _lhs.test(i)));
+        }
+
+        for(size_t i = 0; i < ritr.entries.size(); ++i)
+        {
+            auto _entry     = ritr.entries.at(i);
+            _entry.function = _strings.at(_entry.function);
+            _entry.source   = _strings.at(_entry.source);
+            auto& _value =
+                _entries.try_emplace(get_entry_key(_entry), _entry, false).first->second;
+            _value.second = _value.second || ritr.test(i);
+        }
+
+        if(mitr != _module_index.end())
+        {
+            modules.at(mitr->second) = make_module_data(_name, _entries);
+        }
+        else
+        {
+            _module_index.emplace(_name, modules.size());
+            modules.emplace_back(make_module_data(_name, _entries));
+        }
+    }
+
+    return *this;
+}
 //
 }  // namespace coverage
 }  // namespace omnitrace
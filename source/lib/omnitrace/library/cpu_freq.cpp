@@ -24,11 +24,15 @@
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
+#include "core/containers/sample_ring.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
+#include "core/procfs_reader.hpp"
 #include "core/timemory.hpp"
 #include "library/components/cpu_freq.hpp"
+#include "library/memory_footprint.hpp"
+#include "library/process_sampler.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
 
@@ -38,11 +42,12 @@
 #include <timemory/utility/procfs/cpuinfo.hpp>
 #include <timemory/utility/type_list.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <mutex>
 #include <string>
 #include <sys/resource.h>
-#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -55,9 +60,22 @@ using type_list = tim::type_list<Tp...>;
 
 namespace
 {
-using cpu_data_tuple_t = std::tuple<size_t, int64_t, int64_t, int64_t, int64_t, int64_t,
-                                    int64_t, int64_t, component::cpu_freq>;
-std::deque<cpu_data_tuple_t> data = {};
+// columns of the sample ring: the process usage values followed by one column per
+// enabled cpu frequency
+enum cpu_data_column : size_t
+{
+    page_rss_column = 0,
+    virt_mem_column,
+    peak_rss_column,
+    context_switch_column,
+    page_fault_column,
+    user_mode_time_column,
+    kernel_mode_time_column,
+    cpu_freq_column,
+};
+
+container::sample_ring<int64_t> data   = {};
+std::vector<int64_t>            values = {};
 
 template <typename... Types>
 void init_perfetto_counter_tracks(type_list<Types...>)
@@ -86,6 +104,19 @@ void
 config()
 {
     component::cpu_freq::configure();
+
+    auto _ncolumns = cpu_freq_column + component::cpu_freq::get_enabled_cpus().size();
+    values.resize(_ncolumns, 0);
+    data.reset(_ncolumns, process_sampler::get_retention_capacity());
+
+    // once the footprint exceeds the budget, the ring only retains the newest half
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        if(!config::get_snapshot().memory_footprint) return;
+        memory_footprint::add_source(
+            memory_footprint::process_sampling_subsystem, []() { return data.bytes(); },
+            []() { data.set_capacity(std::max<size_t>(data.size() / 2, 1)); });
+    });
 }
 
 void
@@ -94,16 +125,28 @@ sample()
     auto _ts = tim::get_clock_real_now<size_t, std::nano>();
 
     auto _rcache = tim::rusage_cache{ RUSAGE_SELF };
-    auto _freqs  = component::cpu_freq{}.sample();
+    auto _freqs  = component::cpu_freq::record();
+
+    // config() has not sized the columns yet
+    if(data.columns() < cpu_freq_column) return;
 
     // user and kernel mode times are in microseconds
-    data.emplace_back(
-        _ts, tim::get_page_rss(), tim::get_virt_mem(), _rcache.get_peak_rss(),
-        _rcache.get_num_priority_context_switch() +
-            _rcache.get_num_voluntary_context_switch(),
-        _rcache.get_num_major_page_faults() + _rcache.get_num_minor_page_faults(),
-        _rcache.get_user_mode_time() * 1000, _rcache.get_kernel_mode_time() * 1000,
-        std::move(_freqs));
+    auto _page_rss = procfs_reader::get_page_rss();
+    auto _virt_mem = procfs_reader::get_virt_mem();
+
+    values[page_rss_column]       = (_page_rss) ? *_page_rss : tim::get_page_rss();
+    values[virt_mem_column]       = (_virt_mem) ? *_virt_mem : tim::get_virt_mem();
+    values[peak_rss_column]       = _rcache.get_peak_rss();
+    values[context_switch_column] = _rcache.get_num_priority_context_switch() +
+                                    _rcache.get_num_voluntary_context_switch();
+    values[page_fault_column] =
+        _rcache.get_num_major_page_faults() + _rcache.get_num_minor_page_faults();
+    values[user_mode_time_column]   = _rcache.get_user_mode_time() * 1000;
+    values[kernel_mode_time_column] = _rcache.get_kernel_mode_time() * 1000;
+    for(size_t i = 0; i < _freqs.size() && cpu_freq_column + i < data.columns(); ++i)
+        values[cpu_freq_column + i] = _freqs[i];
+
+    data.push(_ts, values);
 }
 
 void
@@ -162,6 +205,11 @@ post_process()
     OMNITRACE_VERBOSE(1,
                       "Post-processing %zu cpu frequency and memory usage entries...\n",
                       data.size());
+    if(data.dropped() > 0)
+        OMNITRACE_VERBOSE(1,
+                          "%zu older cpu frequency and memory usage entries were "
+                          "discarded (OMNITRACE_PROCESS_SAMPLING_RETENTION)...\n",
+                          data.dropped());
     auto _process_frequencies = [](size_t _idx, size_t _offset) {
         using freq_track = perfetto_counter_track<category::cpu_freq>;
 
@@ -177,13 +225,12 @@ post_process()
             freq_track::emplace(_idx, addendum("Frequency"), "MHz");
         }
 
-        for(auto& itr : data)
-        {
-            uint64_t _ts   = std::get<0>(itr);
-            double   _freq = static_cast<double>(std::get<8>(itr).at(_offset));
-            if(!_thread_info->is_valid_time(_ts)) continue;
+        const auto _unit = static_cast<double>(component::cpu_freq::unit());
+        data.for_each(cpu_freq_column + _offset, [&](uint64_t _ts, int64_t _value) {
+            if(!_thread_info->is_valid_time(_ts)) return;
+            double _freq = _value / _unit;
             write_perfetto_counter_track<category::cpu_freq>(index{ _idx }, _ts, _freq);
-        }
+        });
 
         auto _end_ts = _thread_info->get_stop();
         write_perfetto_counter_track<category::cpu_freq>(index{ _idx }, _end_ts, 0);
@@ -203,18 +250,16 @@ post_process()
         OMNITRACE_CI_THROW(!_thread_info, "Missing thread info for thread 0");
         if(!_thread_info) return;
 
-        for(auto& itr : data)
-        {
-            uint64_t _ts = std::get<0>(itr);
-            if(!_thread_info->is_valid_time(_ts)) continue;
-
-            double   _page = std::get<1>(itr);
-            double   _virt = std::get<2>(itr);
-            double   _peak = std::get<3>(itr);
-            uint64_t _cntx = std::get<4>(itr);
-            uint64_t _flts = std::get<5>(itr);
-            double   _user = std::get<6>(itr);
-            double   _kern = std::get<7>(itr);
+        data.for_each([&](uint64_t _ts, size_t _n) {
+            if(!_thread_info->is_valid_time(_ts)) return;
+
+            double   _page = data.at(page_rss_column, _n);
+            double   _virt = data.at(virt_mem_column, _n);
+            double   _peak = data.at(peak_rss_column, _n);
+            uint64_t _cntx = data.at(context_switch_column, _n);
+            uint64_t _flts = data.at(page_fault_column, _n);
+            double   _user = data.at(user_mode_time_column, _n);
+            double   _kern = data.at(kernel_mode_time_column, _n);
             write_perfetto_counter_track<category::process_page>(_ts,
                                                                  _page / units::megabyte);
             write_perfetto_counter_track<category::process_virt>(_ts,
@@ -227,7 +272,7 @@ post_process()
                 _ts, _user / units::sec);
             write_perfetto_counter_track<category::process_kernel_mode_time>(
                 _ts, _kern / units::sec);
-        }
+        });
 
         auto _end_ts = _thread_info->get_stop();
         write_perfetto_counter_track<category::process_page>(_end_ts, 0.0);
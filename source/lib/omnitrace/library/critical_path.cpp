@@ -0,0 +1,1095 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/critical_path.hpp"
+#include "core/concepts.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/variadic.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace critical_path
+{
+namespace
+{
+constexpr auto npos      = std::numeric_limits<uint32_t>::max();
+constexpr auto max_slack = std::numeric_limits<int64_t>::max();
+
+struct host_call
+{
+    uint64_t    corr_id = 0;
+    uint64_t    begin   = 0;
+    uint64_t    end     = 0;
+    const char* name    = nullptr;
+    int32_t     device  = 0;
+    bool        sync    = false;
+};
+
+struct region_record
+{
+    uint64_t hash  = 0;
+    uint64_t begin = 0;
+    uint64_t end   = 0;
+};
+
+// only the owning thread appends to its records. The lock is uncontended unless the
+// thread is still running when its records are post-processed
+struct thread_records
+{
+    locking::atomic_mutex                      mutex        = {};
+    std::vector<host_call>                     calls        = {};
+    std::vector<std::pair<uint64_t, uint64_t>> open_calls   = {};  // corr id, begin
+    std::vector<region_record>                 regions      = {};
+    std::vector<size_t>                        open_regions = {};
+};
+
+struct device_record
+{
+    uint64_t    corr_id = 0;
+    uint64_t    begin   = 0;
+    uint64_t    end     = 0;
+    const char* name    = nullptr;
+    int64_t     queue   = 0;
+    int32_t     device  = 0;
+    node_kind   kind    = kernel_node;
+};
+
+struct device_records
+{
+    std::mutex                 mutex = {};
+    std::vector<device_record> data  = {};
+};
+
+using thread_records_data = omnitrace::thread_data<thread_records, thread_records>;
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+auto&
+get_thread_records(int64_t _tid = tim::threading::get_id())
+{
+    return thread_records_data::instance(construct_on_thread{ _tid });
+}
+
+thread_records&
+get_local_records()
+{
+    auto& _v = get_thread_records();
+    if(!_v) _v = std::make_unique<thread_records>();
+    return *_v;
+}
+
+// intentionally leaked so the records can be appended during the static destruction
+auto&
+get_device_records()
+{
+    static auto* _v = new device_records{};
+    return *_v;
+}
+
+enum edge_kind : uint8_t
+{
+    program_edge = 0,  // consecutive nodes of a thread
+    queue_edge,        // consecutive operations of a device queue
+    launch_edge,       // HIP API call to the device operation
+    sync_edge,         // device operation to the HIP API call which waited for it
+};
+
+struct node
+{
+    uint64_t  begin    = 0;
+    uint64_t  end      = 0;
+    uint64_t  release  = 0;  // when the last dependency was satisfied
+    uint64_t  critical = 0;  // nanoseconds on the critical path
+    int64_t   slack    = 0;  // nanoseconds
+    uint32_t  label    = 0;
+    uint32_t  owner    = 0;  // index of the thread or the queue
+    node_kind kind     = host_node;
+};
+
+struct edge
+{
+    uint32_t  pred = 0;
+    uint32_t  succ = 0;
+    edge_kind kind = program_edge;
+};
+
+// the names of the nodes. Intentionally leaked since perfetto interns the names of
+// the slices by address
+struct label_table
+{
+    uint32_t get(const std::string& _name)
+    {
+        auto itr = ids.find(_name);
+        if(itr != ids.end()) return itr->second;
+        auto _id = static_cast<uint32_t>(names.size());
+        names.emplace_back(_name);
+        ids.emplace(_name, _id);
+        return _id;
+    }
+
+    uint32_t get(const char* _name)
+    {
+        auto itr = pointers.find(_name);
+        if(itr != pointers.end()) return itr->second;
+        auto _id = get(std::string{ (_name) ? _name : "??" });
+        pointers.emplace(_name, _id);
+        return _id;
+    }
+
+    uint32_t get_region(uint64_t _hash)
+    {
+        auto itr = regions.find(_hash);
+        if(itr != regions.end()) return itr->second;
+        auto _id = get(std::string{ tim::get_hash_identifier_fast(_hash) });
+        regions.emplace(_hash, _id);
+        return _id;
+    }
+
+    std::deque<std::string>                   names    = {};
+    std::unordered_map<std::string, uint32_t> ids      = {};
+    std::unordered_map<const char*, uint32_t> pointers = {};
+    std::unordered_map<uint64_t, uint32_t>    regions  = {};
+};
+
+auto&
+get_labels()
+{
+    static auto* _v = new label_table{};
+    return *_v;
+}
+
+struct thread_span
+{
+    int64_t                    tid     = 0;
+    uint32_t                   first   = 0;  // host nodes of the thread
+    uint32_t                   last    = 0;
+    std::vector<region_record> regions = {};
+};
+
+struct queue_span
+{
+    int32_t               device = 0;
+    int64_t               queue  = 0;
+    uint32_t              first  = 0;
+    uint32_t              last   = 0;
+    std::vector<uint64_t> ends   = {};  // running maximum of the end of the operations
+};
+
+struct graph
+{
+    std::vector<node>        nodes     = {};
+    std::vector<edge>        edges     = {};
+    std::vector<uint32_t>    host_pred = {};  // program order predecessor of host nodes
+    std::vector<thread_span> threads   = {};
+    std::vector<queue_span>  queues    = {};
+
+    // compressed adjacency of the edges
+    std::vector<uint32_t> in_offsets  = {};
+    std::vector<uint32_t> in_edges    = {};
+    std::vector<uint32_t> out_offsets = {};
+    std::vector<uint32_t> out_edges   = {};
+
+    void add_edge(uint32_t _pred, uint32_t _succ, edge_kind _kind)
+    {
+        if(_pred == npos || _succ == npos) return;
+        edges.emplace_back(edge{ _pred, _succ, _kind });
+    }
+
+    // when the edge releases the successor. The HIP API call and the later operations
+    // of a queue may start before the predecessor ends, e.g. a kernel may begin before
+    // the launch returns, whereas a synchronizing call waits until its end
+    uint64_t get_release(const edge& _e) const
+    {
+        const auto& _pred = nodes.at(_e.pred);
+        const auto& _succ = nodes.at(_e.succ);
+        return std::min(_pred.end, (_e.kind == sync_edge) ? _succ.end : _succ.begin);
+    }
+};
+
+// minimum of a range of the slacks in O(log N)
+struct min_tree
+{
+    explicit min_tree(const std::vector<int64_t>& _v)
+    : size{ _v.size() }
+    , data(2 * _v.size(), max_slack)
+    {
+        std::copy(_v.begin(), _v.end(), data.begin() + size);
+        for(size_t i = size; i-- > 1;)
+            data[i] = std::min(data[2 * i], data[2 * i + 1]);
+    }
+
+    // minimum in [_lhs, _rhs)
+    int64_t operator()(size_t _lhs, size_t _rhs) const
+    {
+        auto _v = max_slack;
+        for(_lhs += size, _rhs += size; _lhs < _rhs; _lhs >>= 1, _rhs >>= 1)
+        {
+            if(_lhs & 1) _v = std::min(_v, data[_lhs++]);
+            if(_rhs & 1) _v = std::min(_v, data[--_rhs]);
+        }
+        return _v;
+    }
+
+    size_t               size = 0;
+    std::vector<int64_t> data = {};
+};
+
+struct summary
+{
+    uint64_t count     = 0;
+    uint64_t total     = 0;  // nanoseconds
+    uint64_t critical  = 0;  // nanoseconds
+    uint64_t on_path   = 0;  // number of instances on the critical path
+    int64_t  min_slack = max_slack;
+    double   sum_slack = 0.0;
+
+    void add(uint64_t _duration, uint64_t _critical, int64_t _slack)
+    {
+        count += 1;
+        total += _duration;
+        critical += _critical;
+        on_path += (_critical > 0) ? 1 : 0;
+        min_slack = std::min(min_slack, _slack);
+        sum_slack += static_cast<double>(_slack);
+    }
+
+    double mean_slack() const { return (count > 0) ? (sum_slack / count) : 0.0; }
+};
+
+struct segment
+{
+    uint32_t node  = 0;
+    uint64_t begin = 0;
+    uint64_t end   = 0;
+};
+
+struct result
+{
+    uint64_t                                  begin     = 0;  // of the application
+    uint64_t                                  end       = 0;
+    uint64_t                                  length    = 0;  // of the critical path
+    size_t                                    num_nodes = 0;
+    size_t                                    num_edges = 0;
+    size_t                                    num_cycle = 0;
+    std::vector<segment>                      path      = {};
+    std::vector<std::pair<uint64_t, summary>> nodes     = {};  // kind and label
+    std::vector<std::pair<uint32_t, summary>> regions   = {};  // label
+};
+
+const char*
+get_kind_name(node_kind _kind)
+{
+    switch(_kind)
+    {
+        case host_node: return "host";
+        case api_node: return "hip_api";
+        case kernel_node: return "kernel";
+        case copy_node: return "copy";
+        case barrier_node: return "barrier";
+        case node_kind_end: break;
+    }
+    return "unknown";
+}
+
+// the host nodes of a thread: the HIP API calls and the host time between them, which
+// is labeled with the innermost region containing its midpoint. The HIP API calls
+// nested in another call are part of the outer call
+void
+add_thread(graph& _g, int64_t _tid, thread_records& _records,
+           std::unordered_map<uint64_t, uint32_t>& _calls,
+           std::vector<std::pair<uint32_t, int32_t>>& _syncs)
+{
+    auto& _labels  = get_labels();
+    auto  _calls_v = std::move(_records.calls);
+    auto  _regions = std::move(_records.regions);
+
+    auto _beg = std::numeric_limits<uint64_t>::max();
+    auto _end = uint64_t{ 0 };
+    for(const auto& itr : _calls_v)
+    {
+        _beg = std::min(_beg, itr.begin);
+        _end = std::max(_end, itr.end);
+    }
+    for(const auto& itr : _regions)
+    {
+        _beg = std::min(_beg, itr.begin);
+        _end = std::max(_end, std::max(itr.begin, itr.end));
+    }
+    if(_beg >= _end) return;
+
+    // the regions which did not end before the finalization end with the thread
+    for(auto& itr : _regions)
+        if(itr.end < itr.begin) itr.end = _end;
+
+    std::stable_sort(_calls_v.begin(), _calls_v.end(),
+                     [](const host_call& _lhs, const host_call& _rhs) {
+                         return _lhs.begin < _rhs.begin;
+                     });
+    std::stable_sort(_regions.begin(), _regions.end(),
+                     [](const region_record& _lhs, const region_record& _rhs) {
+                         return _lhs.begin < _rhs.begin;
+                     });
+
+    auto _thread_label = _labels.get(JOIN("", "[thread ", _tid, "]"));
+    auto _next_region  = size_t{ 0 };
+    auto _open         = std::vector<const region_record*>{};
+    auto _host_label   = [&](uint64_t _mid) {
+        while(_next_region < _regions.size() && _regions[_next_region].begin <= _mid)
+        {
+            const auto& _region = _regions[_next_region++];
+            while(!_open.empty() && _open.back()->end < _region.begin)
+                _open.pop_back();
+            _open.emplace_back(&_region);
+        }
+        while(!_open.empty() && _open.back()->end < _mid)
+            _open.pop_back();
+        return (_open.empty()) ? _thread_label : _labels.get_region(_open.back()->hash);
+    };
+
+    auto _owner = static_cast<uint32_t>(_g.threads.size());
+    auto _first = static_cast<uint32_t>(_g.nodes.size());
+    auto _prev  = npos;
+    auto _add   = [&](node_kind _kind, uint64_t _b, uint64_t _e, uint32_t _label) {
+        auto _idx = static_cast<uint32_t>(_g.nodes.size());
+        _g.nodes.emplace_back(node{ _b, _e, 0, 0, 0, _label, _owner, _kind });
+        _g.host_pred.emplace_back(_prev);
+        _g.add_edge(_prev, _idx, program_edge);
+        _prev = _idx;
+        return _idx;
+    };
+
+    auto _cursor = _beg;
+    auto _last   = npos;
+    for(const auto& itr : _calls_v)
+    {
+        if(_last != npos && itr.begin < _cursor)
+        {
+            _calls.emplace(itr.corr_id, _last);
+            continue;
+        }
+
+        if(itr.begin > _cursor)
+            _add(host_node, _cursor, itr.begin, _host_label((_cursor + itr.begin) / 2));
+
+        _last = _add(api_node, itr.begin, std::max(itr.begin, itr.end),
+                     _labels.get(itr.name));
+        _calls.emplace(itr.corr_id, _last);
+        if(itr.sync) _syncs.emplace_back(_last, itr.device);
+        _cursor = _g.nodes.at(_last).end;
+    }
+
+    if(_end > _cursor) _add(host_node, _cursor, _end, _host_label((_cursor + _end) / 2));
+
+    _g.threads.emplace_back(thread_span{ _tid, _first,
+                                         static_cast<uint32_t>(_g.nodes.size()),
+                                         std::move(_regions) });
+}
+
+// the device operations of each queue in the order of submission, the launch by the
+// HIP API call and the waits of the synchronizing calls
+void
+add_device(graph& _g, std::vector<device_record>&& _data,
+           const std::unordered_map<uint64_t, uint32_t>&    _calls,
+           const std::vector<std::pair<uint32_t, int32_t>>& _syncs)
+{
+    auto& _labels = get_labels();
+
+    std::stable_sort(_data.begin(), _data.end(),
+                     [](const device_record& _lhs, const device_record& _rhs) {
+                         return std::tie(_lhs.device, _lhs.queue, _lhs.begin) <
+                                std::tie(_rhs.device, _rhs.queue, _rhs.begin);
+                     });
+
+    for(const auto& itr : _data)
+    {
+        if(_g.queues.empty() || _g.queues.back().device != itr.device ||
+           _g.queues.back().queue != itr.queue)
+        {
+            auto _first = static_cast<uint32_t>(_g.nodes.size());
+            _g.queues.emplace_back(queue_span{ itr.device, itr.queue, _first, _first });
+        }
+
+        auto& _queue = _g.queues.back();
+        auto  _owner = static_cast<uint32_t>(_g.queues.size() - 1);
+        auto  _idx   = static_cast<uint32_t>(_g.nodes.size());
+        _g.nodes.emplace_back(
+            node{ itr.begin, itr.end, 0, 0, 0, _labels.get(itr.name), _owner, itr.kind });
+        if(_queue.last > _queue.first) _g.add_edge(_idx - 1, _idx, queue_edge);
+        _queue.last = _idx + 1;
+        _queue.ends.emplace_back(
+            (_queue.ends.empty()) ? itr.end : std::max(itr.end, _queue.ends.back()));
+
+        auto citr = _calls.find(itr.corr_id);
+        if(citr == _calls.end()) continue;
+
+        // the call returned after the operation completed, e.g. a synchronous copy, so
+        // the operation follows the host node before the call and the call waits for it
+        auto        _call = citr->second;
+        const auto& _host = _g.nodes.at(_call);
+        if(itr.end <= _host.end && _g.host_pred.at(_call) != npos)
+        {
+            _g.add_edge(_g.host_pred.at(_call), _idx, launch_edge);
+            _g.add_edge(_idx, _call, sync_edge);
+        }
+        else
+        {
+            _g.add_edge(_call, _idx, launch_edge);
+        }
+    }
+
+    // a synchronizing call waits for the last operation of each queue of its device
+    // which completed while it was blocked. All the queues are considered if the
+    // device has no queues, e.g. when the device ids do not match
+    auto _device_queues = std::unordered_map<int32_t, std::vector<uint32_t>>{};
+    auto _all_queues    = std::vector<uint32_t>{};
+    for(uint32_t i = 0; i < _g.queues.size(); ++i)
+    {
+        _device_queues[_g.queues.at(i).device].emplace_back(i);
+        _all_queues.emplace_back(i);
+    }
+
+    for(const auto& itr : _syncs)
+    {
+        const auto& _call   = _g.nodes.at(itr.first);
+        auto        ditr    = _device_queues.find(itr.second);
+        const auto& _queues = (ditr != _device_queues.end()) ? ditr->second : _all_queues;
+        for(auto qitr : _queues)
+        {
+            const auto& _queue = _g.queues.at(qitr);
+            const auto& _ends  = _queue.ends;
+            auto        _pos   = std::upper_bound(_ends.begin(), _ends.end(), _call.end);
+            if(_pos == _ends.begin()) continue;
+            auto _idx = static_cast<uint32_t>(_queue.first + (_pos - _ends.begin()) - 1);
+            if(_g.nodes.at(_idx).end >= _call.begin)
+                _g.add_edge(_idx, itr.first, sync_edge);
+        }
+    }
+}
+
+void
+build_adjacency(graph& _g)
+{
+    auto _n = _g.nodes.size();
+    _g.in_offsets.assign(_n + 1, 0);
+    _g.out_offsets.assign(_n + 1, 0);
+    for(const auto& itr : _g.edges)
+    {
+        ++_g.in_offsets.at(itr.succ + 1);
+        ++_g.out_offsets.at(itr.pred + 1);
+    }
+    for(size_t i = 0; i < _n; ++i)
+    {
+        _g.in_offsets.at(i + 1) += _g.in_offsets.at(i);
+        _g.out_offsets.at(i + 1) += _g.out_offsets.at(i);
+    }
+
+    _g.in_edges.resize(_g.edges.size());
+    _g.out_edges.resize(_g.edges.size());
+    auto _in  = std::vector<uint32_t>{ _g.in_offsets.begin(), _g.in_offsets.end() - 1 };
+    auto _out = std::vector<uint32_t>{ _g.out_offsets.begin(), _g.out_offsets.end() - 1 };
+    for(uint32_t i = 0; i < _g.edges.size(); ++i)
+    {
+        _g.in_edges.at(_in.at(_g.edges.at(i).succ)++)   = i;
+        _g.out_edges.at(_out.at(_g.edges.at(i).pred)++) = i;
+    }
+}
+
+// the path is walked backwards from the node which ended last through the dependency
+// which released each node last. The slack of a node is the minimum over its
+// successors of the slack of the successor plus the time between the release of the
+// successor by this node and the release of the successor by its last dependency
+result
+analyze(graph& _g)
+{
+    auto  _res    = result{};
+    auto& _nodes  = _g.nodes;
+    auto  _n      = _nodes.size();
+    _res.num_nodes = _n;
+    _res.num_edges = _g.edges.size();
+    if(_n == 0) return _res;
+
+    build_adjacency(_g);
+
+    _res.begin = std::numeric_limits<uint64_t>::max();
+    for(auto& itr : _nodes)
+    {
+        itr.release = itr.begin;
+        _res.begin  = std::min(_res.begin, itr.begin);
+        _res.end    = std::max(_res.end, itr.end);
+    }
+
+    // topological order (Kahn)
+    auto _order   = std::vector<uint32_t>{};
+    auto _pending = std::vector<uint32_t>(_n, 0);
+    _order.reserve(_n);
+    for(uint32_t i = 0; i < _n; ++i)
+    {
+        _pending.at(i) = _g.in_offsets.at(i + 1) - _g.in_offsets.at(i);
+        if(_pending.at(i) == 0) _order.emplace_back(i);
+    }
+    for(size_t i = 0; i < _order.size(); ++i)
+    {
+        auto _idx = _order.at(i);
+        for(auto j = _g.out_offsets.at(_idx); j < _g.out_offsets.at(_idx + 1); ++j)
+        {
+            auto _succ = _g.edges.at(_g.out_edges.at(j)).succ;
+            if(--_pending.at(_succ) == 0) _order.emplace_back(_succ);
+        }
+    }
+    // nodes in a cycle (which require inconsistent timestamps) keep their begin as
+    // the release and the slack until the end of the application
+    _res.num_cycle = _n - _order.size();
+
+    for(uint32_t i = 0; i < _n; ++i)
+    {
+        auto& _node = _nodes.at(i);
+        for(auto j = _g.in_offsets.at(i); j < _g.in_offsets.at(i + 1); ++j)
+        {
+            auto _release = _g.get_release(_g.edges.at(_g.in_edges.at(j)));
+            _node.release =
+                (j == _g.in_offsets.at(i)) ? _release : std::max(_node.release, _release);
+        }
+        _node.slack = static_cast<int64_t>(_res.end - _node.end);
+    }
+
+    for(auto ritr = _order.rbegin(); ritr != _order.rend(); ++ritr)
+    {
+        auto& _node = _nodes.at(*ritr);
+        for(auto j = _g.out_offsets.at(*ritr); j < _g.out_offsets.at(*ritr + 1); ++j)
+        {
+            const auto& _edge    = _g.edges.at(_g.out_edges.at(j));
+            const auto& _succ    = _nodes.at(_edge.succ);
+            auto        _release = _g.get_release(_edge);
+            auto        _gap     = static_cast<int64_t>(_succ.release - _release);
+            _node.slack          = std::min(_node.slack, _succ.slack + _gap);
+        }
+    }
+
+    // the node which ended last, preferring the least slack
+    auto _idx = uint32_t{ 0 };
+    for(uint32_t i = 1; i < _n; ++i)
+    {
+        const auto& _lhs = _nodes.at(i);
+        const auto& _rhs = _nodes.at(_idx);
+        if(_lhs.end > _rhs.end || (_lhs.end == _rhs.end && _lhs.slack < _rhs.slack))
+            _idx = i;
+    }
+
+    auto _cursor = _nodes.at(_idx).end;
+    for(size_t _steps = 0; _idx != npos && _steps < _n; ++_steps)
+    {
+        auto& _node  = _nodes.at(_idx);
+        auto  _start = std::min(_node.release, _cursor);
+        auto  _pred  = npos;
+        auto  _max   = uint64_t{ 0 };
+        for(auto j = _g.in_offsets.at(_idx); j < _g.in_offsets.at(_idx + 1); ++j)
+        {
+            const auto& _edge    = _g.edges.at(_g.in_edges.at(j));
+            auto        _release = _g.get_release(_edge);
+            if(_pred == npos || _release > _max)
+            {
+                _pred = _edge.pred;
+                _max  = _release;
+            }
+        }
+
+        if(_cursor > _start)
+        {
+            _node.critical += _cursor - _start;
+            _res.path.emplace_back(segment{ _idx, _start, _cursor });
+        }
+        _cursor = _start;
+        _idx    = _pred;
+    }
+    std::reverse(_res.path.begin(), _res.path.end());
+    if(!_res.path.empty())
+        _res.length = _res.path.back().end - _res.path.front().begin;
+
+    // the kernels, copies, HIP API calls and host time with the same label
+    auto _nodes_v = std::unordered_map<uint64_t, summary>{};
+    for(const auto& itr : _nodes)
+    {
+        auto _key = (static_cast<uint64_t>(itr.kind) << 32) | itr.label;
+        _nodes_v[_key].add(itr.end - itr.begin, itr.critical, itr.slack);
+    }
+    _res.nodes = { _nodes_v.begin(), _nodes_v.end() };
+
+    // the critical time of a region is the overlap with the critical path on its
+    // thread and its slack is the minimum slack of the host nodes which it overlaps
+    auto _regions = std::unordered_map<uint32_t, summary>{};
+    auto _paths   = std::vector<std::vector<std::pair<uint64_t, uint64_t>>>(
+        _g.threads.size());
+    for(const auto& itr : _res.path)
+    {
+        const auto& _node = _nodes.at(itr.node);
+        if(_node.kind == host_node || _node.kind == api_node)
+            _paths.at(_node.owner).emplace_back(itr.begin, itr.end);
+    }
+
+    for(size_t t = 0; t < _g.threads.size(); ++t)
+    {
+        const auto& _thread = _g.threads.at(t);
+        const auto& _path   = _paths.at(t);
+        if(_thread.regions.empty()) continue;
+
+        auto _prefix = std::vector<uint64_t>(_path.size() + 1, 0);
+        for(size_t i = 0; i < _path.size(); ++i)
+            _prefix.at(i + 1) = _prefix.at(i) + (_path.at(i).second - _path.at(i).first);
+
+        auto _slacks = std::vector<int64_t>{};
+        _slacks.reserve(_thread.last - _thread.first);
+        for(auto i = _thread.first; i < _thread.last; ++i)
+            _slacks.emplace_back(_nodes.at(i).slack);
+        auto _min_slack = min_tree{ _slacks };
+
+        auto _nbeg = _nodes.begin() + _thread.first;
+        auto _nend = _nodes.begin() + _thread.last;
+        for(const auto& itr : _thread.regions)
+        {
+            if(itr.end <= itr.begin) continue;
+
+            auto _first = std::partition_point(
+                              _path.begin(), _path.end(),
+                              [&itr](const auto& _v) { return _v.second <= itr.begin; }) -
+                          _path.begin();
+            auto _last = std::partition_point(
+                             _path.begin(), _path.end(),
+                             [&itr](const auto& _v) { return _v.first < itr.end; }) -
+                         _path.begin();
+
+            auto _critical = uint64_t{ 0 };
+            if(_first < _last)
+            {
+                _critical = _prefix.at(_last) - _prefix.at(_first);
+                const auto& _lhs = _path.at(_first);
+                const auto& _rhs = _path.at(_last - 1);
+                if(_lhs.first < itr.begin) _critical -= (itr.begin - _lhs.first);
+                if(_rhs.second > itr.end) _critical -= (_rhs.second - itr.end);
+            }
+
+            auto _lhs = std::partition_point(_nbeg, _nend, [&itr](const node& _v) {
+                            return _v.end <= itr.begin;
+                        }) -
+                        _nbeg;
+            auto _rhs = std::partition_point(_nbeg, _nend, [&itr](const node& _v) {
+                            return _v.begin < itr.end;
+                        }) -
+                        _nbeg;
+            auto _slack = (_lhs < _rhs) ? _min_slack(_lhs, _rhs)
+                                        : static_cast<int64_t>(_res.end - itr.end);
+
+            auto _label = get_labels().get_region(itr.hash);
+            _regions[_label].add(itr.end - itr.begin, _critical, _slack);
+        }
+    }
+    _res.regions = { _regions.begin(), _regions.end() };
+
+    auto _cmp = [](const auto& _lhs, const auto& _rhs) {
+        if(_lhs.second.critical != _rhs.second.critical)
+            return _lhs.second.critical > _rhs.second.critical;
+        return _lhs.second.total > _rhs.second.total;
+    };
+    std::sort(_res.nodes.begin(), _res.nodes.end(), _cmp);
+    std::sort(_res.regions.begin(), _res.regions.end(), _cmp);
+
+    return _res;
+}
+
+void
+emit_perfetto(const graph& _g, const result& _res)
+{
+    if(!get_use_perfetto() || _res.path.empty()) return;
+
+    const auto& _labels = get_labels();
+    const auto  _track  = tracing::get_perfetto_track(
+        category::critical_path{},
+        [](auto) { return std::string{ "Critical Path" }; }, process::get_id());
+
+    for(const auto& itr : _res.path)
+    {
+        const auto& _node = _g.nodes.at(itr.node);
+        tracing::push_perfetto_track(
+            category::critical_path{}, _labels.names.at(_node.label).c_str(), _track,
+            itr.begin, [&](::perfetto::EventContext ctx) {
+                if(config::get_perfetto_annotations())
+                {
+                    tracing::add_perfetto_annotation(ctx, "kind",
+                                                     get_kind_name(_node.kind));
+                    tracing::add_perfetto_annotation(ctx, "begin_ns", _node.begin);
+                    tracing::add_perfetto_annotation(ctx, "end_ns", _node.end);
+                    tracing::add_perfetto_annotation(ctx, "release_ns", _node.release);
+                }
+            });
+        tracing::pop_perfetto_track(category::critical_path{}, "", _track, itr.end);
+    }
+}
+
+// the critical time of the nodes and regions is inserted as the wall-clock time of a
+// "critical_path" region on this thread and the number of instances on the path as
+// the number of laps
+void
+insert_timemory(const result& _res)
+{
+    if(!get_use_timemory() || _res.path.empty()) return;
+
+    using bundle_t = tim::lightweight_tuple<comp::wall_clock>;
+
+    auto _set = [](bundle_t& _bundle, uint64_t _value, uint64_t _laps) {
+        auto* _wc = _bundle.get<comp::wall_clock>();
+        if(_wc)
+        {
+            _wc->set_value(_value);
+            _wc->set_accum(_value);
+            _wc->set_laps(static_cast<int64_t>(_laps));
+        }
+    };
+
+    auto _insert = [&_set](const std::string& _name, const summary& _data) {
+        if(_data.critical == 0) return;
+        auto _bundle = bundle_t{ tim::string_view_t{ _name } };
+        _bundle.push();
+        _bundle.start();
+        _bundle.stop();
+        _set(_bundle, _data.critical, _data.on_path);
+        _bundle.pop();
+    };
+
+    const auto& _labels = get_labels();
+    auto        _root   = bundle_t{ tim::string_view_t{ "critical_path" } };
+    _root.push();
+    _root.start();
+    for(const auto& itr : _res.nodes)
+    {
+        auto _kind = static_cast<node_kind>(itr.first >> 32);
+        auto _name = _labels.names.at(itr.first & 0xFFFFFFFF);
+        _insert(JOIN("", "[", get_kind_name(_kind), "] ", _name), itr.second);
+    }
+    for(const auto& itr : _res.regions)
+        _insert(JOIN("", "[region] ", _labels.names.at(itr.first)), itr.second);
+    _root.stop();
+    _set(_root, _res.length, 1);
+    _root.pop();
+}
+
+void
+write_text(const result& _res)
+{
+    auto _fname = tim::settings::compose_output_filename("critical-path", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening critical path output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<result>{}(_fname, std::string{ "critical_path" });
+
+    const auto& _labels  = get_labels();
+    auto        _msec    = [](double _v) { return _v / units::msec; };
+    auto        _elapsed = _res.end - _res.begin;
+    auto        _percent = [&_res](uint64_t _v) {
+        return (_res.length > 0) ? (100.0 * _v / _res.length) : 0.0;
+    };
+
+    ofs << std::setprecision(3) << std::fixed;
+    ofs << "critical path (msec)     : " << _msec(_res.length) << "\n";
+    ofs << "elapsed time (msec)      : " << _msec(_elapsed) << "\n";
+    ofs << "nodes                    : " << _res.num_nodes << "\n";
+    ofs << "dependencies             : " << _res.num_edges << "\n";
+    ofs << "nodes on the path        : " << _res.path.size() << "\n\n";
+
+    auto _header = [&ofs](const char* _kind) {
+        ofs << std::setw(8) << _kind << " | " << std::setw(14) << "path (msec)" << " | "
+            << std::setw(8) << "path (%)" << " | " << std::setw(14) << "total (msec)"
+            << " | " << std::setw(10) << "count" << " | " << std::setw(10) << "on path"
+            << " | " << std::setw(14) << "min slack" << " | " << std::setw(14)
+            << "mean slack" << " | name\n";
+    };
+
+    auto _row = [&](const char* _kind, const std::string& _name, const summary& _v) {
+        ofs << std::setw(8) << _kind << " | " << std::setw(14) << _msec(_v.critical)
+            << " | " << std::setw(8) << _percent(_v.critical) << " | " << std::setw(14)
+            << _msec(_v.total) << " | " << std::setw(10) << _v.count << " | "
+            << std::setw(10) << _v.on_path << " | " << std::setw(14)
+            << _msec(_v.min_slack) << " | " << std::setw(14) << _msec(_v.mean_slack())
+            << " | " << _name << "\n";
+    };
+
+    ofs << "# slack (msec) of each kernel, copy, HIP API function and host label\n";
+    _header("kind");
+    for(const auto& itr : _res.nodes)
+        _row(get_kind_name(static_cast<node_kind>(itr.first >> 32)),
+             _labels.names.at(itr.first & 0xFFFFFFFF), itr.second);
+
+    if(!_res.regions.empty())
+    {
+        ofs << "\n# critical time and slack (msec) of each region\n";
+        _header("kind");
+        for(const auto& itr : _res.regions)
+            _row("region", _labels.names.at(itr.first), itr.second);
+    }
+}
+
+void
+write_json(const result& _res)
+{
+    namespace cereal = tim::cereal;
+
+    const auto& _labels = get_labels();
+
+    auto _save = [&_labels](auto& ar, const char* _kind, uint32_t _label,
+                            const summary& _v) {
+        ar->startNode();
+        (*ar)(cereal::make_nvp("kind", std::string{ _kind }),
+              cereal::make_nvp("name", _labels.names.at(_label)),
+              cereal::make_nvp("critical_ns", _v.critical),
+              cereal::make_nvp("total_ns", _v.total), cereal::make_nvp("count", _v.count),
+              cereal::make_nvp("on_path", _v.on_path),
+              cereal::make_nvp("min_slack_ns", _v.min_slack),
+              cereal::make_nvp("mean_slack_ns", _v.mean_slack()));
+        ar->finishNode();
+    };
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("critical_path");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("length_ns", _res.length),
+              cereal::make_nvp("begin_ns", _res.begin),
+              cereal::make_nvp("end_ns", _res.end),
+              cereal::make_nvp("num_nodes", _res.num_nodes),
+              cereal::make_nvp("num_dependencies", _res.num_edges),
+              cereal::make_nvp("num_path_nodes", _res.path.size()));
+
+        ar->setNextName("nodes");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _res.nodes)
+            _save(ar, get_kind_name(static_cast<node_kind>(itr.first >> 32)),
+                  itr.first & 0xFFFFFFFF, itr.second);
+        ar->finishNode();
+
+        ar->setNextName("regions");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _res.regions)
+            _save(ar, "region", itr.first, itr.second);
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("critical-path", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening critical path output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<result>{}(_fname, std::string{ "critical_path" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+api_begin(uint64_t _corr_id, uint64_t _ts)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _v  = get_local_records();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    _v.open_calls.emplace_back(_corr_id, _ts);
+}
+
+void
+api_end(uint64_t _corr_id, const char* _name, int32_t _device, bool _sync,
+        uint64_t _ts)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _v  = get_local_records();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    for(auto itr = _v.open_calls.rbegin(); itr != _v.open_calls.rend(); ++itr)
+    {
+        if(itr->first != _corr_id) continue;
+        _v.calls.emplace_back(
+            host_call{ _corr_id, itr->second, _ts, _name, _device, _sync });
+        _v.open_calls.erase(std::next(itr).base());
+        return;
+    }
+}
+
+void
+device_op(node_kind _kind, uint64_t _corr_id, const char* _name, int32_t _device,
+          int64_t _queue, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _v  = get_device_records();
+    auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+    _v.data.emplace_back(
+        device_record{ _corr_id, _beg_ns, _end_ns, _name, _queue, _device, _kind });
+}
+
+void
+region_begin(uint64_t _hash)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _v  = get_local_records();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    _v.open_regions.emplace_back(_v.regions.size());
+    _v.regions.emplace_back(region_record{ _hash, tracing::now(), 0 });
+}
+
+void
+region_end(uint64_t _hash)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto  _ts = tracing::now();
+    auto& _v  = get_local_records();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    for(auto itr = _v.open_regions.rbegin(); itr != _v.open_regions.rend(); ++itr)
+    {
+        auto& _region = _v.regions.at(*itr);
+        if(_region.hash != _hash) continue;
+        _region.end = _ts;
+        _v.open_regions.erase(std::next(itr).base());
+        return;
+    }
+}
+
+void
+post_process()
+{
+    if(!config::get_critical_path()) return;
+
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        get_active().store(false);
+
+        auto _g      = graph{};
+        auto _calls  = std::unordered_map<uint64_t, uint32_t>{};
+        auto _syncs  = std::vector<std::pair<uint32_t, int32_t>>{};
+        auto _device = std::vector<device_record>{};
+
+        if(thread_records_data::get())
+        {
+            int64_t _tid = 0;
+            for(auto& itr : *thread_records_data::get())
+            {
+                if(itr)
+                {
+                    auto _lk = locking::atomic_lock{ itr->mutex };
+                    add_thread(_g, _tid, *itr, _calls, _syncs);
+                }
+                ++_tid;
+            }
+        }
+
+        {
+            auto& _v  = get_device_records();
+            auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+            std::swap(_device, _v.data);
+        }
+
+        add_device(_g, std::move(_device), _calls, _syncs);
+
+        if(_g.nodes.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No HIP API calls or device operations were recorded "
+                                   "for the critical path\n");
+            return;
+        }
+
+        try
+        {
+            auto _res = analyze(_g);
+
+            OMNITRACE_WARNING_IF_F(_res.num_cycle > 0,
+                                   "%zu of %zu nodes of the critical path form a cycle "
+                                   "and were not ordered\n",
+                                   _res.num_cycle, _res.num_nodes);
+            OMNITRACE_VERBOSE_F(1,
+                                "Critical path of %.3f msec over %zu of %zu nodes and "
+                                "%zu dependencies\n",
+                                static_cast<double>(_res.length) / units::msec,
+                                _res.path.size(), _res.num_nodes, _res.num_edges);
+
+            emit_perfetto(_g, _res);
+            insert_timemory(_res);
+
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_res);
+
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_res);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "Critical path post-processing failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace critical_path
+}  // namespace omnitrace
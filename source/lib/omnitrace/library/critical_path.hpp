@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// critical path of the CPU threads and the GPU queues (see OMNITRACE_CRITICAL_PATH).
+/// The HIP API calls and the user regions are recorded per thread and the kernels,
+/// copies and barriers per device queue. At finalization they are the nodes of a
+/// dependency graph whose edges are the program order of each thread, the order of
+/// each queue, the launch of a device operation (matched by the correlation id) and
+/// the wait of a synchronizing call for the operations which completed while it was
+/// blocked. The host time between the HIP API calls is a node labeled with the
+/// innermost region of the thread. The critical path is walked backwards from the
+/// last node to finish through the dependency which released each node last and the
+/// slack of a node is how much longer it could take before the end of the
+/// application is delayed. The path and the per-kernel, per-function and per-region
+/// critical time and slack are written to critical-path.{txt,json}, a "Critical Path"
+/// track in perfetto and the timemory output
+namespace critical_path
+{
+enum node_kind : uint8_t
+{
+    host_node = 0,  ///< host time between the HIP API calls of a thread
+    api_node,       ///< HIP API call
+    kernel_node,    ///< kernel dispatch
+    copy_node,      ///< memory copy
+    barrier_node,   ///< barrier packet
+    node_kind_end,
+};
+
+/// records the begin of the HIP API call with the correlation id on the calling thread
+void
+api_begin(uint64_t _corr_id, uint64_t _ts);
+
+/// records the end of the HIP API call. _sync is true for the functions which wait for
+/// the work previously submitted to the device
+void
+api_end(uint64_t _corr_id, const char* _name, int32_t _device, bool _sync,
+        uint64_t _ts);
+
+/// records a device operation of the HIP API call with the correlation id. _name must
+/// remain valid until the post-processing
+void
+device_op(node_kind _kind, uint64_t _corr_id, const char* _name, int32_t _device,
+          int64_t _queue, uint64_t _beg_ns, uint64_t _end_ns);
+
+/// records the begin of a region of the calling thread
+void
+region_begin(uint64_t _hash);
+
+/// records the end of the innermost region of the calling thread with the hash
+void
+region_end(uint64_t _hash);
+
+/// builds the graph, extracts the critical path and writes the output. Only the first
+/// invocation has an effect
+void
+post_process();
+}  // namespace critical_path
+}  // namespace omnitrace
@@ -0,0 +1,298 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/emergency_dump.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+
+#include <timemory/settings/settings.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace emergency_dump
+{
+namespace
+{
+constexpr uint32_t dump_version = 1;
+constexpr size_t   max_sources  = 4096;
+constexpr size_t   stack_size   = 65536;
+constexpr auto     dump_signals = std::array<int, 6>{ SIGSEGV, SIGBUS,  SIGFPE,
+                                                  SIGILL,  SIGABRT, SIGTERM };
+
+struct file_header
+{
+    char     magic[8]  = { 'O', 'M', 'N', 'I', 'D', 'M', 'P', '\0' };
+    uint32_t version   = dump_version;
+    int32_t  signal    = 0;
+    int64_t  pid       = 0;
+    uint64_t timestamp = 0;
+};
+
+struct section_header
+{
+    uint32_t kind       = end_section;
+    uint32_t entry_size = 0;
+    int64_t  tid        = 0;
+    uint64_t nbytes     = 0;
+};
+
+// the slots are constant-initialized so the sources may be added during the static
+// initialization. A slot is in use while the function is set
+struct source
+{
+    std::atomic<dump_func_t> func = { nullptr };
+    std::atomic<const void*> data = { nullptr };
+    std::atomic<int64_t>     tid  = { 0 };
+};
+
+source              sources[max_sources] = {};
+std::atomic<size_t> num_sources          = { 0 };
+std::atomic<bool>   is_dumping           = { false };
+int                 dump_fd              = -1;
+pid_t               dump_pid             = 0;
+std::string         dump_filename        = {};
+
+// the handlers which were installed before setup() in the order of dump_signals
+struct sigaction former_actions[dump_signals.size()] = {};
+
+// the alternative stack of the thread which called setup()
+char alt_stack[stack_size] = {};
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+void
+restore_actions()
+{
+    for(size_t i = 0; i < dump_signals.size(); ++i)
+        sigaction(dump_signals[i], &former_actions[i], nullptr);
+}
+
+void
+signal_handler(int _sig)
+{
+    // only the first signal of the process which opened the file writes the dump. the
+    // state is not active once the finalization started (the buffers are released)
+    if(getpid() == dump_pid && get_state() == State::Active &&
+       !is_dumping.exchange(true))
+    {
+        auto _ts = timespec{};
+        clock_gettime(CLOCK_REALTIME, &_ts);
+
+        auto _header      = file_header{};
+        _header.signal    = _sig;
+        _header.pid       = dump_pid;
+        _header.timestamp = (static_cast<uint64_t>(_ts.tv_sec) * 1000000000UL) +
+                            static_cast<uint64_t>(_ts.tv_nsec);
+
+        auto _writer = writer{ dump_fd };
+        _writer.write(_header);
+        auto _n = num_sources.load(std::memory_order_acquire);
+        for(size_t i = 0; i < _n; ++i)
+        {
+            auto _func = sources[i].func.load(std::memory_order_acquire);
+            if(!_func) continue;
+            (*_func)(_writer, sources[i].data.load(std::memory_order_relaxed),
+                     sources[i].tid.load(std::memory_order_relaxed));
+            // flushed after every source so that a fault in a corrupted buffer only
+            // loses the remaining sources
+            _writer.flush();
+        }
+        _writer.section(end_section, 0, 0);
+        _writer.flush();
+        fsync(dump_fd);
+    }
+
+    // the former handlers (e.g. the timemory signal handler or the default action)
+    // receive the signal once this handler returns
+    restore_actions();
+    raise(_sig);
+}
+}  // namespace
+
+writer::writer(int _fd)
+: m_fd{ _fd }
+{}
+
+void
+writer::section(section_kind _kind, int64_t _tid, uint64_t _nbytes,
+                uint32_t _entry_size)
+{
+    auto _header       = section_header{};
+    _header.kind       = _kind;
+    _header.entry_size = _entry_size;
+    _header.tid        = _tid;
+    _header.nbytes     = _nbytes;
+    write(_header);
+}
+
+void
+writer::write(const void* _data, size_t _nbytes)
+{
+    const auto* _p = static_cast<const char*>(_data);
+    while(_nbytes > 0)
+    {
+        if(m_size == sizeof(m_buffer)) flush();
+        auto _n = std::min(_nbytes, sizeof(m_buffer) - m_size);
+        memcpy(m_buffer + m_size, _p, _n);
+        m_size += _n;
+        _p += _n;
+        _nbytes -= _n;
+    }
+}
+
+void
+writer::write_string(const char* _v)
+{
+    auto _len = static_cast<uint32_t>((_v) ? strlen(_v) : 0);
+    write(_len);
+    if(_len > 0) write(_v, _len);
+}
+
+uint64_t
+writer::string_size(const char* _v)
+{
+    return sizeof(uint32_t) + ((_v) ? strlen(_v) : 0);
+}
+
+void
+writer::flush()
+{
+    size_t _off = 0;
+    while(m_fd >= 0 && _off < m_size)
+    {
+        auto _n = ::write(m_fd, m_buffer + _off, m_size - _off);
+        if(_n < 0 && errno == EINTR) continue;
+        if(_n <= 0) break;
+        _off += static_cast<size_t>(_n);
+    }
+    m_size = 0;
+}
+
+size_t
+add_source(dump_func_t _func, const void* _data, int64_t _tid)
+{
+    if(!_func) return invalid_source;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    auto _n  = num_sources.load(std::memory_order_relaxed);
+    for(size_t i = 0; i <= _n && i < max_sources; ++i)
+    {
+        if(sources[i].func.load(std::memory_order_relaxed) != nullptr) continue;
+        sources[i].data.store(_data, std::memory_order_relaxed);
+        sources[i].tid.store(_tid, std::memory_order_relaxed);
+        sources[i].func.store(_func, std::memory_order_release);
+        if(i == _n) num_sources.store(_n + 1, std::memory_order_release);
+        return i;
+    }
+    return invalid_source;
+}
+
+void
+remove_source(size_t _id)
+{
+    if(_id >= max_sources) return;
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    sources[_id].func.store(nullptr, std::memory_order_release);
+}
+
+void
+setup()
+{
+    if(!config::get_emergency_dump() || dump_fd >= 0) return;
+
+    // the file is created now since neither the directories nor the file can be
+    // created in the signal handler
+    dump_filename = tim::settings::compose_output_filename("emergency-dump", ".bin");
+    {
+        auto _ofs = std::ofstream{};
+        if(!filepath::open(_ofs, dump_filename, std::ios::out | std::ios::binary))
+        {
+            OMNITRACE_VERBOSE(0, "[emergency_dump] Error opening '%s'...\n",
+                              dump_filename.c_str());
+            return;
+        }
+    }
+
+    dump_fd = ::open(dump_filename.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if(dump_fd < 0)
+    {
+        OMNITRACE_VERBOSE(0, "[emergency_dump] Error opening '%s': %s\n",
+                          dump_filename.c_str(), strerror(errno));
+        return;
+    }
+    dump_pid = getpid();
+
+    // a stack overflow of the main thread is only handled on an alternative stack
+    auto _stack     = stack_t{};
+    _stack.ss_sp    = alt_stack;
+    _stack.ss_size  = stack_size;
+    _stack.ss_flags = 0;
+    sigaltstack(&_stack, nullptr);
+
+    struct sigaction _action = {};
+    _action.sa_handler       = &signal_handler;
+    _action.sa_flags         = SA_ONSTACK;
+    sigemptyset(&_action.sa_mask);
+    for(size_t i = 0; i < dump_signals.size(); ++i)
+        sigaction(dump_signals[i], &_action, &former_actions[i]);
+
+    OMNITRACE_VERBOSE(1, "[emergency_dump] The in-memory buffers are written to '%s' "
+                         "on fatal signals...\n",
+                      dump_filename.c_str());
+}
+
+void
+shutdown()
+{
+    if(dump_fd < 0) return;
+
+    restore_actions();
+    ::close(dump_fd);
+    dump_fd = -1;
+
+    // nothing was written before the finalization
+    if(!is_dumping.load()) ::unlink(dump_filename.c_str());
+}
+}  // namespace emergency_dump
+}  // namespace omnitrace
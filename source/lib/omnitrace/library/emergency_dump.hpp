@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// async-signal-safe dump of the in-memory buffers when the process is terminated by
+/// SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT or SIGTERM (see OMNITRACE_EMERGENCY_DUMP).
+/// The buffers register themselves as sources and the signal handler writes the raw
+/// contents of every source to a file which was opened at initialization, using
+/// nothing but write(2). The dump is converted offline by the omnitrace.emergency python
+/// module. The file has a header followed by sections:
+///
+///   header:  char[8] magic ("OMNIDMP"), u32 version, i32 signal, i64 pid,
+///            u64 timestamp (CLOCK_REALTIME, nanoseconds)
+///   section: u32 kind, u32 entry size, i64 thread, u64 number of bytes, payload
+///
+/// The last section of a complete dump has the kind end_section
+namespace emergency_dump
+{
+enum section_kind : uint32_t
+{
+    end_section      = 0,
+    region_section   = 1,  ///< u64 timestamp, u32 phase (1 = begin), string name
+    activity_section = 2,  ///< u64 begin, u64 end, string name
+    sampling_section = 3,  ///< raw samples of the entry size
+};
+
+/// buffered writer into the file descriptor of the dump. Strings are a u32 length
+/// followed by the characters
+class writer
+{
+public:
+    explicit writer(int _fd);
+    ~writer() { flush(); }
+
+    writer(const writer&) = delete;
+    writer(writer&&)      = delete;
+    writer& operator=(const writer&) = delete;
+    writer& operator=(writer&&) = delete;
+
+    void section(section_kind, int64_t _tid, uint64_t _nbytes, uint32_t _entry_size = 0);
+    void write(const void*, size_t);
+    void write_string(const char*);
+    void flush();
+
+    template <typename Tp>
+    void write(const Tp& _v)
+    {
+        write(&_v, sizeof(Tp));
+    }
+
+    /// number of bytes of the string written by write_string
+    static uint64_t string_size(const char*);
+
+private:
+    int    m_fd           = -1;
+    size_t m_size         = 0;
+    char   m_buffer[4096] = {};
+};
+
+/// writes a section for the data of a source. Invoked from the signal handler so only
+/// async-signal-safe functions may be called and no memory may be allocated
+using dump_func_t = void (*)(writer&, const void* _data, int64_t _tid);
+
+static constexpr size_t invalid_source = static_cast<size_t>(-1);
+
+/// registers a source. Returns the identifier for remove_source or invalid_source when
+/// all of the slots are in use
+size_t
+add_source(dump_func_t _func, const void* _data, int64_t _tid);
+
+/// unregisters the source before its data is released
+void
+remove_source(size_t _id);
+
+/// opens the dump file and installs the signal handlers when OMNITRACE_EMERGENCY_DUMP
+/// is enabled
+void
+setup();
+
+/// restores the former signal handlers and removes the (unused) dump file
+void
+shutdown();
+}  // namespace emergency_dump
+}  // namespace omnitrace
@@ -0,0 +1,935 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/energy.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/gpu.hpp"
+#include "core/perf.hpp"
+#include "core/persistent_file.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/region_attribution.hpp"
+#include "library/rocm_smi.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <dirent.h>
+#include <exception>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace energy
+{
+namespace
+{
+using region_attribution::change_t;
+using region_attribution::split;
+using region_attribution::timeline;
+
+enum cpu_domain : uint8_t
+{
+    package_domain = 0,
+    cores_domain,
+    num_domains,
+};
+
+constexpr auto domain_names = std::array<const char*, num_domains>{ "package", "cores" };
+
+enum cpu_source : uint8_t
+{
+    perf_source = 0,  // "power" PMU of perf, energy-pkg and energy-cores
+    powercap_source,  // /sys/class/powercap/intel-rapl:*/energy_uj
+    msr_source,       // the RAPL energy status MSRs through /dev/cpu/N/msr
+};
+
+constexpr auto source_names = std::array<const char*, 3>{ "perf", "powercap", "msr" };
+
+// RAPL MSRs: power unit, package energy status and core energy status
+constexpr auto amd_msrs   = std::array<uint64_t, 3>{ 0xc0010299, 0xc001029b, 0xc001029a };
+constexpr auto intel_msrs = std::array<uint64_t, 3>{ 0x606, 0x611, 0x639 };
+
+// one energy counter of the CPUs, i.e. a package or the cores of a package (or, with
+// the MSRs of AMD, one core)
+struct cpu_counter
+{
+    cpu_domain      domain  = package_domain;
+    cpu_source      source  = perf_source;
+    int32_t         package = 0;
+    int             fd      = -1;  // perf_event or /dev/cpu/N/msr
+    uint64_t        msr     = 0;   // address of the energy status MSR
+    persistent_file file    = {};  // powercap energy_uj
+    double          scale   = 0.0;  // joules per count
+    uint64_t        range   = 0;    // value where the count wraps, zero if 64-bit
+    uint64_t        last    = 0;
+    double          joules  = 0.0;  // accumulated since the first read
+    bool            valid   = false;
+
+    std::optional<uint64_t> read();
+    void                    update();
+    void                    close();
+};
+
+std::optional<uint64_t>
+cpu_counter::read()
+{
+    uint64_t _v = 0;
+    switch(source)
+    {
+        case perf_source:
+        {
+            if(::read(fd, &_v, sizeof(_v)) != sizeof(_v)) return std::nullopt;
+            return _v;
+        }
+        case msr_source:
+        {
+            if(::pread(fd, &_v, sizeof(_v), msr) != sizeof(_v)) return std::nullopt;
+            return (_v & 0xffffffffUL);
+        }
+        case powercap_source:
+        {
+            auto _uj = file.read_int();
+            if(!_uj || *_uj < 0) return std::nullopt;
+            return static_cast<uint64_t>(*_uj);
+        }
+    }
+    return std::nullopt;
+}
+
+void
+cpu_counter::update()
+{
+    auto _v = read();
+    if(!_v) return;
+
+    if(valid)
+    {
+        if(*_v >= last)
+            joules += static_cast<double>(*_v - last) * scale;
+        else if(range > 0)
+            joules += static_cast<double>(range - last + *_v) * scale;
+    }
+    last  = *_v;
+    valid = true;
+}
+
+void
+cpu_counter::close()
+{
+    if(fd >= 0) ::close(fd);
+    fd = -1;
+    file.close();
+}
+
+enum gpu_mode : uint8_t
+{
+    unknown_mode = 0,
+    counter_mode,  // energy counter of the device
+    power_mode,    // integrated average power
+};
+
+struct gpu_device
+{
+    uint32_t index  = 0;
+    gpu_mode mode   = unknown_mode;
+    double   offset = 0.0;  // energy counter at the first sample
+    double   power  = 0.0;  // watts at the last sample
+    uint64_t last   = 0;    // time of the last sample
+    timeline energy = {};
+};
+
+struct sampler_state
+{
+    std::mutex                        mutex    = {};
+    bool                              active   = false;
+    std::optional<cpu_source>         source   = {};
+    std::vector<cpu_counter>          counters = {};
+    std::array<timeline, num_domains> cpu      = {};
+    std::vector<gpu_device>           gpus     = {};
+};
+
+// intentionally leaked so the sampler does not depend on the order of the static
+// destruction
+sampler_state&
+get_sampler()
+{
+    static auto* _v = new sampler_state{};
+    return *_v;
+}
+
+struct kernel_record
+{
+    const char* name   = nullptr;
+    uint64_t    begin  = 0;
+    uint64_t    end    = 0;
+    int32_t     device = 0;
+};
+
+struct kernel_records
+{
+    std::mutex                 mutex = {};
+    std::vector<kernel_record> data  = {};
+};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the kernels can be appended during the static destruction
+kernel_records&
+get_kernel_records()
+{
+    static auto* _v = new kernel_records{};
+    return *_v;
+}
+
+std::string
+read_line(const std::string& _path)
+{
+    auto _ifs = std::ifstream{ _path };
+    auto _v   = std::string{};
+    if(_ifs) std::getline(_ifs, _v);
+    return _v;
+}
+
+std::set<int64_t>
+get_cpu_list(const std::string& _path)
+{
+    auto _v = read_line(_path);
+    if(_v.empty()) return std::set<int64_t>{};
+    return utility::parse_numeric_range<>(_v, "CPUs", 1L);
+}
+
+int32_t
+get_package(int64_t _cpu)
+{
+    auto _v =
+        read_line(JOIN("", "/sys/devices/system/cpu/cpu", _cpu,
+                       "/topology/physical_package_id"));
+    return (_v.empty()) ? 0 : std::stoi(_v);
+}
+
+bool
+is_amd()
+{
+    auto _ifs  = std::ifstream{ "/proc/cpuinfo" };
+    auto _line = std::string{};
+    while(_ifs && std::getline(_ifs, _line))
+    {
+        if(_line.find("vendor_id") != 0) continue;
+        return (_line.find("AuthenticAMD") != std::string::npos ||
+                _line.find("HygonGenuine") != std::string::npos);
+    }
+    return false;
+}
+
+void
+close_counters(std::vector<cpu_counter>& _counters)
+{
+    for(auto& itr : _counters)
+        itr.close();
+    _counters.clear();
+}
+
+// the energy-pkg and energy-cores events of the perf "power" PMU on the first CPU of
+// every package (listed in the cpumask of the PMU)
+std::vector<cpu_counter>
+open_perf_counters()
+{
+    constexpr auto _pmu =
+        std::array<std::pair<cpu_domain, const char*>, num_domains>{
+            std::make_pair(package_domain, "energy-pkg"),
+            std::make_pair(cores_domain, "energy-cores")
+        };
+
+    const auto _dir  = std::string{ "/sys/bus/event_source/devices/power" };
+    auto       _cpus = get_cpu_list(_dir + "/cpumask");
+    auto       _v    = std::vector<cpu_counter>{};
+    for(const auto& itr : _pmu)
+    {
+        // the events which are not provided by the CPU are not listed
+        auto _scale = read_line(JOIN("", _dir, "/events/", itr.second, ".scale"));
+        if(_scale.empty()) continue;
+
+        for(auto _cpu : _cpus)
+        {
+            auto _pe = perf_event_attr{};
+            memset(&_pe, 0, sizeof(_pe));
+            _pe.size = sizeof(_pe);
+            perf::config_pmu_event(_pe, JOIN("", "power/", itr.second, "/"));
+
+            auto _fd = syscall(__NR_perf_event_open, &_pe, -1, _cpu, -1, 0);
+            if(_fd < 0)
+            {
+                OMNITRACE_VERBOSE_F(1,
+                                    "perf_event_open(power/%s/) on CPU %li failed: %s\n",
+                                    itr.second, _cpu, strerror(errno));
+                close_counters(_v);
+                return _v;
+            }
+
+            auto& _counter   = _v.emplace_back();
+            _counter.domain  = itr.first;
+            _counter.source  = perf_source;
+            _counter.package = get_package(_cpu);
+            _counter.fd      = static_cast<int>(_fd);
+            _counter.scale   = std::stod(_scale);
+        }
+    }
+    return _v;
+}
+
+// the package zones of the RAPL powercap driver and their core subzones. The energy
+// is only readable by root on most systems
+std::vector<cpu_counter>
+open_powercap_counters()
+{
+    const auto _root = std::string{ "/sys/class/powercap/" };
+    auto*      _dir  = opendir(_root.c_str());
+    if(!_dir) return std::vector<cpu_counter>{};
+
+    auto _zones = std::vector<std::string>{};
+    while(auto* _entry = readdir(_dir))
+    {
+        if(std::string_view{ _entry->d_name }.find("intel-rapl:") == 0)
+            _zones.emplace_back(_entry->d_name);
+    }
+    closedir(_dir);
+    std::sort(_zones.begin(), _zones.end());
+
+    auto _v = std::vector<cpu_counter>{};
+    for(const auto& itr : _zones)
+    {
+        auto _path   = _root + itr + "/";
+        auto _name   = read_line(_path + "name");
+        auto _domain = (_name.find("package") == 0) ? std::optional{ package_domain }
+                       : (_name == "core")          ? std::optional{ cores_domain }
+                                                    : std::optional<cpu_domain>{};
+        if(!_domain) continue;
+
+        // intel-rapl:<package>[:<subzone>]
+        auto _file = persistent_file{ _path + "energy_uj" };
+        if(!_file.is_open() || !_file.read_int())
+        {
+            OMNITRACE_VERBOSE_F(1, "%senergy_uj is not readable\n", _path.c_str());
+            close_counters(_v);
+            return _v;
+        }
+
+        auto  _range     = read_line(_path + "max_energy_range_uj");
+        auto& _counter   = _v.emplace_back();
+        _counter.domain  = *_domain;
+        _counter.source  = powercap_source;
+        _counter.package = std::stoi(itr.substr(itr.find(':') + 1));
+        _counter.file    = std::move(_file);
+        _counter.scale   = 1.0e-6;
+        _counter.range   = (_range.empty()) ? 0 : std::stoull(_range);
+    }
+    return _v;
+}
+
+// the RAPL MSRs of the first CPU of every package. The cores are one MSR per package
+// on Intel (PP0) and one MSR per physical core on AMD
+std::vector<cpu_counter>
+open_msr_counters()
+{
+    const auto  _amd  = is_amd();
+    const auto& _msrs = (_amd) ? amd_msrs : intel_msrs;
+
+    auto _v    = std::vector<cpu_counter>{};
+    auto _seen = std::set<int32_t>{};
+    for(auto _cpu : get_cpu_list("/sys/devices/system/cpu/online"))
+    {
+        auto _package = get_package(_cpu);
+        auto _first   = _seen.emplace(_package).second;
+        // the first hardware thread of the core
+        auto _core = get_cpu_list(JOIN("", "/sys/devices/system/cpu/cpu", _cpu,
+                                       "/topology/thread_siblings_list"));
+        auto _primary = (_core.empty() || *_core.begin() == _cpu);
+
+        auto _domains = std::vector<cpu_domain>{};
+        if(_first) _domains.emplace_back(package_domain);
+        if((_amd && _primary) || (!_amd && _first)) _domains.emplace_back(cores_domain);
+
+        for(auto itr : _domains)
+        {
+            auto _path = JOIN("", "/dev/cpu/", _cpu, "/msr");
+            auto _fd   = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+            auto _unit = uint64_t{ 0 };
+            if(_fd < 0 || ::pread(_fd, &_unit, sizeof(_unit), _msrs.at(0)) !=
+                              sizeof(_unit))
+            {
+                OMNITRACE_VERBOSE_F(1, "reading the RAPL MSRs from %s failed: %s\n",
+                                    _path.c_str(), strerror(errno));
+                if(_fd >= 0) ::close(_fd);
+                close_counters(_v);
+                return _v;
+            }
+
+            auto& _counter   = _v.emplace_back();
+            _counter.domain  = itr;
+            _counter.source  = msr_source;
+            _counter.package = _package;
+            _counter.fd      = _fd;
+            _counter.msr     = _msrs.at((itr == package_domain) ? 1 : 2);
+            // bits 12:8 of the power unit are the energy status unit, 1/2^ESU joules
+            _counter.scale = 1.0 / static_cast<double>(1UL << ((_unit >> 8) & 0x1f));
+            _counter.range = (1UL << 32);
+        }
+    }
+    return _v;
+}
+
+void
+sample_gpu(gpu_device& _dev, uint64_t _ts)
+{
+    if(_dev.mode != power_mode)
+    {
+        if(auto _joules = rocm_smi::get_energy(_dev.index))
+        {
+            if(_dev.mode == unknown_mode)
+            {
+                _dev.mode   = counter_mode;
+                _dev.offset = *_joules;
+            }
+            _dev.energy.push(_ts, *_joules - _dev.offset);
+            return;
+        }
+        if(_dev.mode == counter_mode) return;
+    }
+
+    if(auto _power = rocm_smi::get_power(_dev.index))
+    {
+        if(_dev.mode == unknown_mode)
+        {
+            _dev.mode = power_mode;
+            _dev.energy.push(_ts, 0.0);
+        }
+        else if(_ts > _dev.last)
+        {
+            auto _dt = static_cast<double>(_ts - _dev.last) / units::sec;
+            _dev.energy.push(_ts, _dev.energy.values.back() +
+                                      0.5 * (*_power + _dev.power) * _dt);
+        }
+        _dev.power = *_power;
+        _dev.last  = _ts;
+    }
+}
+
+void
+sample_locked(sampler_state& _v)
+{
+    auto _ts     = tracing::now();
+    auto _joules = std::array<double, num_domains>{};
+    auto _found  = std::array<bool, num_domains>{};
+    for(auto& itr : _v.counters)
+    {
+        itr.update();
+        _joules.at(itr.domain) += itr.joules;
+        _found.at(itr.domain) = true;
+    }
+
+    for(size_t i = 0; i < num_domains; ++i)
+    {
+        if(_found.at(i)) _v.cpu.at(i).push(_ts, _joules.at(i));
+    }
+
+    for(auto& itr : _v.gpus)
+        sample_gpu(itr, _ts);
+}
+
+struct region_entry
+{
+    uint64_t                        count      = 0;
+    uint64_t                        time       = 0;
+    std::array<double, num_domains> joules     = {};  // while the region was active
+    std::array<double, num_domains> attributed = {};  // share of the threads
+};
+
+struct kernel_entry
+{
+    uint64_t count  = 0;
+    uint64_t time   = 0;
+    double   joules = 0.0;
+};
+
+struct package_entry
+{
+    int32_t    package = 0;
+    cpu_domain domain  = package_domain;
+    double     joules  = 0.0;
+};
+
+struct device_entry
+{
+    uint32_t    device = 0;
+    std::string source = {};
+    double      joules = 0.0;
+    double      idle   = 0.0;
+};
+
+struct summary
+{
+    std::string                                       cpu_source = {};
+    double                                            duration   = 0.0;
+    std::array<double, num_domains>                   cpu_total  = {};
+    std::array<double, num_domains>                   cpu_idle   = {};
+    std::vector<package_entry>                        packages   = {};
+    std::vector<device_entry>                         devices    = {};
+    std::vector<std::pair<std::string, region_entry>> regions    = {};
+    std::vector<std::pair<std::string, kernel_entry>> kernels    = {};
+};
+
+summary
+get_summary(sampler_state& _s)
+{
+    auto _data = summary{};
+    if(_s.source) _data.cpu_source = source_names.at(*_s.source);
+
+    auto _beg    = std::numeric_limits<uint64_t>::max();
+    auto _end    = uint64_t{ 0 };
+    auto _extent = [&_beg, &_end](const timeline& _v) {
+        if(_v.empty()) return;
+        _beg = std::min(_beg, _v.ts.front());
+        _end = std::max(_end, _v.ts.back());
+    };
+    for(const auto& itr : _s.cpu)
+        _extent(itr);
+    for(const auto& itr : _s.gpus)
+        _extent(itr.energy);
+    if(_end == 0) return _data;
+    _data.duration = static_cast<double>(_end - _beg) / units::sec;
+
+    // regions which were still open end with the last sample
+    auto _instances = region_attribution::get_intervals(_end);
+    auto _changes   = region_attribution::get_thread_changes(_instances);
+
+    auto _shares = std::array<timeline, num_domains>{};
+    for(size_t i = 0; i < num_domains; ++i)
+    {
+        if(_s.cpu.at(i).empty()) continue;
+        _data.cpu_total.at(i) = _s.cpu.at(i).values.back();
+        _shares.at(i)         = split(_s.cpu.at(i), _changes, _data.cpu_idle.at(i));
+    }
+
+    auto _regions = std::unordered_map<uint64_t, region_entry>{};
+    for(const auto& itr : _instances)
+    {
+        auto& _entry = _regions[itr.hash];
+        _entry.count += 1;
+        _entry.time += (itr.end - itr.begin);
+        for(size_t i = 0; i < num_domains; ++i)
+        {
+            _entry.joules.at(i) += _s.cpu.at(i).between(itr.begin, itr.end);
+            _entry.attributed.at(i) += _shares.at(i).between(itr.begin, itr.end);
+        }
+    }
+
+    for(const auto& itr : _regions)
+    {
+        _data.regions.emplace_back(
+            std::string{ tim::get_hash_identifier_fast(itr.first) }, itr.second);
+    }
+
+    // the packages are reported per domain and package even if several counters
+    // (e.g. one per core) were summed
+    auto _packages = std::map<std::pair<cpu_domain, int32_t>, double>{};
+    for(const auto& itr : _s.counters)
+        _packages[{ itr.domain, itr.package }] += itr.joules;
+    for(const auto& itr : _packages)
+        _data.packages.emplace_back(
+            package_entry{ itr.first.second, itr.first.first, itr.second });
+
+    auto _kernels = std::vector<kernel_record>{};
+    {
+        auto& _v  = get_kernel_records();
+        auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+        _kernels  = _v.data;
+    }
+
+    auto _kernel_entries = std::unordered_map<std::string_view, kernel_entry>{};
+    for(const auto& itr : _kernels)
+    {
+        auto& _entry = _kernel_entries[itr.name];
+        _entry.count += 1;
+        _entry.time += (itr.end - itr.begin);
+    }
+
+    for(auto& itr : _s.gpus)
+    {
+        if(itr.energy.empty()) continue;
+
+        auto _device   = device_entry{};
+        _device.device = itr.index;
+        _device.source = (itr.mode == counter_mode) ? "energy counter" : "average power";
+        _device.joules = itr.energy.values.back();
+
+        auto _device_changes = std::vector<change_t>{};
+        for(const auto& kitr : _kernels)
+        {
+            if(kitr.device != static_cast<int32_t>(itr.index)) continue;
+            _device_changes.emplace_back(kitr.begin, 1);
+            _device_changes.emplace_back(kitr.end, -1);
+        }
+
+        auto _share = split(itr.energy, _device_changes, _device.idle);
+        for(const auto& kitr : _kernels)
+        {
+            if(kitr.device != static_cast<int32_t>(itr.index)) continue;
+            _kernel_entries[kitr.name].joules += _share.between(kitr.begin, kitr.end);
+        }
+        _data.devices.emplace_back(std::move(_device));
+    }
+
+    for(const auto& itr : _kernel_entries)
+        _data.kernels.emplace_back(std::string{ itr.first }, itr.second);
+
+    std::sort(_data.regions.begin(), _data.regions.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  return _lhs.second.attributed.at(package_domain) >
+                         _rhs.second.attributed.at(package_domain);
+              });
+    std::sort(_data.kernels.begin(), _data.kernels.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  return _lhs.second.joules > _rhs.second.joules;
+              });
+
+    return _data;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("energy", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening energy output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "energy" });
+
+    ofs << std::fixed << std::setprecision(3);
+    ofs << "duration: " << _data.duration << " sec\n";
+    if(!_data.cpu_source.empty())
+    {
+        ofs << "\nCPU energy (" << _data.cpu_source << "):\n";
+        for(size_t i = 0; i < num_domains; ++i)
+        {
+            ofs << "    " << std::setw(8) << domain_names.at(i) << " : " << std::setw(14)
+                << _data.cpu_total.at(i)
+                << " J, outside of the regions: " << _data.cpu_idle.at(i) << " J\n";
+        }
+        for(const auto& itr : _data.packages)
+        {
+            ofs << "    " << std::setw(8) << domain_names.at(itr.domain) << " "
+                << itr.package << " : " << std::setw(12) << itr.joules << " J\n";
+        }
+    }
+
+    if(!_data.devices.empty())
+    {
+        ofs << "\nGPU energy:\n";
+        for(const auto& itr : _data.devices)
+        {
+            ofs << "    device " << itr.device << " : " << std::setw(14) << itr.joules
+                << " J, outside of the kernels: " << itr.idle << " J ("
+                << itr.source << ")\n";
+        }
+    }
+
+    ofs << "\n"
+        << std::setw(10) << "count" << " | " << std::setw(12) << "time [sec]" << " | "
+        << std::setw(14) << "package [J]" << " | " << std::setw(14) << "attributed [J]"
+        << " | " << std::setw(14) << "cores [J]" << " | " << std::setw(14)
+        << "attributed [J]" << " | " << "region\n";
+    for(const auto& itr : _data.regions)
+    {
+        const auto& _v = itr.second;
+        ofs << std::setw(10) << _v.count << " | " << std::setw(12)
+            << (static_cast<double>(_v.time) / units::sec) << " | " << std::setw(14)
+            << _v.joules.at(package_domain) << " | " << std::setw(14)
+            << _v.attributed.at(package_domain) << " | " << std::setw(14)
+            << _v.joules.at(cores_domain) << " | " << std::setw(14)
+            << _v.attributed.at(cores_domain) << " | " << itr.first << "\n";
+    }
+
+    if(_data.kernels.empty()) return;
+
+    ofs << "\n"
+        << std::setw(10) << "count" << " | " << std::setw(12) << "time [sec]" << " | "
+        << std::setw(14) << "energy [J]" << " | " << std::setw(10) << "power [W]"
+        << " | " << "kernel\n";
+    for(const auto& itr : _data.kernels)
+    {
+        const auto& _v    = itr.second;
+        auto        _time = static_cast<double>(_v.time) / units::sec;
+        ofs << std::setw(10) << _v.count << " | " << std::setw(12) << _time << " | "
+            << std::setw(14) << _v.joules << " | " << std::setw(10)
+            << ((_time > 0.0) ? (_v.joules / _time) : 0.0) << " | " << itr.first << "\n";
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("energy");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("duration", _data.duration),
+              cereal::make_nvp("cpu_source", _data.cpu_source),
+              cereal::make_nvp("cpu_package", _data.cpu_total.at(package_domain)),
+              cereal::make_nvp("cpu_cores", _data.cpu_total.at(cores_domain)),
+              cereal::make_nvp("cpu_package_idle", _data.cpu_idle.at(package_domain)),
+              cereal::make_nvp("cpu_cores_idle", _data.cpu_idle.at(cores_domain)));
+
+        auto _save_list = [&ar](const char* _name, const auto& _entries, auto&& _save) {
+            ar->setNextName(_name);
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : _entries)
+            {
+                ar->startNode();
+                _save(itr);
+                ar->finishNode();
+            }
+            ar->finishNode();
+        };
+
+        _save_list("packages", _data.packages, [&ar](const package_entry& _v) {
+            (*ar)(cereal::make_nvp("package", _v.package),
+                  cereal::make_nvp("domain", std::string{ domain_names.at(_v.domain) }),
+                  cereal::make_nvp("joules", _v.joules));
+        });
+
+        _save_list("devices", _data.devices, [&ar](const device_entry& _v) {
+            (*ar)(cereal::make_nvp("device", _v.device),
+                  cereal::make_nvp("source", _v.source),
+                  cereal::make_nvp("joules", _v.joules),
+                  cereal::make_nvp("idle", _v.idle));
+        });
+
+        _save_list("regions", _data.regions, [&ar](const auto& _v) {
+            (*ar)(cereal::make_nvp("region", _v.first),
+                  cereal::make_nvp("count", _v.second.count),
+                  cereal::make_nvp("time", _v.second.time),
+                  cereal::make_nvp("package", _v.second.joules.at(package_domain)),
+                  cereal::make_nvp("package_attributed",
+                                   _v.second.attributed.at(package_domain)),
+                  cereal::make_nvp("cores", _v.second.joules.at(cores_domain)),
+                  cereal::make_nvp("cores_attributed",
+                                   _v.second.attributed.at(cores_domain)));
+        });
+
+        _save_list("kernels", _data.kernels, [&ar](const auto& _v) {
+            (*ar)(cereal::make_nvp("kernel", _v.first),
+                  cereal::make_nvp("count", _v.second.count),
+                  cereal::make_nvp("time", _v.second.time),
+                  cereal::make_nvp("joules", _v.second.joules));
+        });
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("energy", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening energy output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "energy" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_energy()) return;
+
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) return;
+
+    using open_func_t = std::vector<cpu_counter> (*)();
+    constexpr auto _open =
+        std::array<std::pair<cpu_source, open_func_t>, 3>{
+            std::make_pair(perf_source, &open_perf_counters),
+            std::make_pair(powercap_source, &open_powercap_counters),
+            std::make_pair(msr_source, &open_msr_counters)
+        };
+
+    auto _source = config::get_energy_cpu_source();
+    for(const auto& itr : _open)
+    {
+        if(_source != "auto" && _source != source_names.at(itr.first)) continue;
+        try
+        {
+            _s.counters = itr.second();
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_VERBOSE_F(1, "%s energy counters are not available: %s\n",
+                                source_names.at(itr.first), _e.what());
+        }
+        if(!_s.counters.empty())
+        {
+            _s.source = itr.first;
+            break;
+        }
+    }
+
+    OMNITRACE_WARNING_IF_F(_s.counters.empty() && _source != "none",
+                           "No CPU energy counters are available (%s)\n",
+                           _source.c_str());
+    OMNITRACE_VERBOSE_F(1, "Sampling %zu CPU energy counters (%s)\n", _s.counters.size(),
+                        (_s.source) ? source_names.at(*_s.source) : "none");
+
+    if(get_use_rocm_smi())
+    {
+        for(uint32_t i = 0; i < static_cast<uint32_t>(gpu::rsmi_device_count()); ++i)
+            _s.gpus.emplace_back().index = i;
+    }
+
+    _s.active = true;
+}
+
+void
+config()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+sample()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+shutdown()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(!_s.active) return;
+
+    // the energy until the end of the application
+    sample_locked(_s);
+    for(auto& itr : _s.counters)
+        itr.close();
+    _s.active = false;
+}
+
+void
+post_process()
+{
+    if(!config::get_energy()) return;
+
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        shutdown();
+        get_active().store(false);
+        region_attribution::stop();
+
+        auto& _s  = get_sampler();
+        auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+
+        try
+        {
+            auto _data = get_summary(_s);
+            if(_data.duration <= 0.0)
+            {
+                OMNITRACE_VERBOSE_F(1, "No energy samples were recorded\n");
+                return;
+            }
+
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the energy profile failed: %s\n", _e.what());
+        }
+    });
+}
+
+void
+device_op(const char* _name, int32_t _device, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed) || _name == nullptr) return;
+
+    auto& _v  = get_kernel_records();
+    auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+    _v.data.emplace_back(kernel_record{ _name, _beg_ns, _end_ns, _device });
+}
+}  // namespace energy
+}  // namespace omnitrace
@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// energy attribution of the regions and the kernels (see OMNITRACE_ENERGY). The
+/// background process sampler reads the accumulated energy of the CPU packages and
+/// cores (perf "power" PMU, powercap or the RAPL MSRs) and of the GPUs (rocm-smi energy
+/// counter, or the integrated average power) at OMNITRACE_PROCESS_SAMPLING_FREQ. The
+/// threads only record the begin and end of their regions and the roctracer activity
+/// callback the interval of each kernel. At finalization, the energy of each interval is
+/// interpolated from the accumulated energy of the samples around it. The energy of a
+/// CPU package is also split evenly among the threads which are inside of a region at
+/// the same time (see region_attribution) and the energy of a GPU among its concurrent
+/// kernels. The joules per region and per kernel are written to energy.{txt,json}
+namespace energy
+{
+void
+setup();
+
+void
+config();
+
+void
+sample();
+
+void
+shutdown();
+
+void
+post_process();
+
+/// records the interval of a kernel on a device. _name must remain valid until the
+/// post-processing
+void
+device_op(const char* _name, int32_t _device, uint64_t _beg_ns, uint64_t _end_ns);
+}  // namespace energy
+}  // namespace omnitrace
@@ -0,0 +1,189 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/flight_recorder.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto_fwd.hpp"
+#include "core/state.hpp"
+#include "library/housekeeping.hpp"
+#include "library/runtime.hpp"
+#include "library/tracing/deferred.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/settings/settings.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <memory>
+#include <semaphore.h>
+#include <thread>
+
+namespace omnitrace
+{
+namespace flight_recorder
+{
+namespace
+{
+sem_t               dump_semaphore = {};
+struct sigaction    former_action  = {};
+int                 dump_signal    = 0;
+std::atomic<bool>   is_active      = { false };
+std::atomic<bool>   dump_pending   = { false };
+std::atomic<size_t> dump_count     = { 0 };
+uint64_t            latency_ns     = 0;
+
+std::unique_ptr<std::thread>&
+get_thread()
+{
+    static std::unique_ptr<std::thread> _v;
+    return _v;
+}
+
+void
+signal_handler(int)
+{
+    trigger();
+}
+
+void
+poll()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.flight");
+    housekeeping::configure_thread();
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    while(is_active.load())
+    {
+        if(sem_wait(&dump_semaphore) != 0)
+        {
+            if(errno == EINTR) continue;
+            break;
+        }
+        if(!is_active.load() || get_state() >= State::Finalized) break;
+        dump_pending.store(false);
+        dump();
+    }
+}
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_use_flight_recorder() || !config::get_use_perfetto()) return;
+    if(get_thread()) return;
+
+    auto _threshold = config::get_flight_recorder_latency_threshold();
+    latency_ns      = (_threshold > 0.0) ? (_threshold * units::msec) : 0;
+
+    if(sem_init(&dump_semaphore, 0, 0) != 0)
+    {
+        OMNITRACE_VERBOSE(0, "[flight_recorder] sem_init failed. Dumps are only written "
+                             "at finalization...\n");
+        return;
+    }
+
+    is_active.store(true);
+
+    dump_signal = config::get_flight_recorder_signal();
+    if(dump_signal > 0)
+    {
+        struct sigaction _action = {};
+        _action.sa_handler       = &signal_handler;
+        _action.sa_flags         = SA_RESTART;
+        sigemptyset(&_action.sa_mask);
+        if(sigaction(dump_signal, &_action, &former_action) != 0) dump_signal = 0;
+    }
+
+    OMNITRACE_VERBOSE(1,
+                      "[flight_recorder] trace data is retained in a %zu KB ring buffer. "
+                      "Dump signal: %i, latency threshold: %f msec\n",
+                      static_cast<size_t>(config::get_perfetto_buffer_size()),
+                      dump_signal, _threshold);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_thread() = std::make_unique<std::thread>(&poll);
+}
+
+void
+shutdown()
+{
+    auto& _thread = get_thread();
+    if(!_thread) return;
+
+    if(dump_signal > 0) sigaction(dump_signal, &former_action, nullptr);
+    dump_signal = 0;
+    latency_ns  = 0;
+
+    is_active.store(false);
+    sem_post(&dump_semaphore);
+    _thread->join();
+    _thread.reset();
+    sem_destroy(&dump_semaphore);
+}
+
+void
+trigger()
+{
+    if(!is_active.load()) return;
+    if(!dump_pending.exchange(true)) sem_post(&dump_semaphore);
+}
+
+void
+dump()
+{
+    if(!config::get_use_perfetto() || get_state() != State::Active) return;
+
+    if(!config::get_use_flight_recorder())
+    {
+        OMNITRACE_VERBOSE(1, "[flight_recorder] dump ignored :: dumping the trace "
+                             "requires OMNITRACE_FLIGHT_RECORDER=ON\n");
+        return;
+    }
+
+    auto _fname = tim::settings::compose_output_filename(
+        JOIN("-", "perfetto-trace-dump", dump_count++), ".proto");
+
+    OMNITRACE_VERBOSE(1, "[flight_recorder] dumping the trace to '%s'...\n",
+                      _fname.c_str());
+    // the regions which have not been encoded yet would be missing from the dump
+    tracing::deferred::flush();
+    perfetto::dump(_fname);
+}
+
+bool
+use_latency_threshold()
+{
+    return (latency_ns > 0);
+}
+
+bool
+exceeds_latency_threshold(uint64_t _elapsed_ns)
+{
+    return (latency_ns > 0 && _elapsed_ns > latency_ns);
+}
+}  // namespace flight_recorder
+}  // namespace omnitrace
@@ -0,0 +1,58 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+namespace flight_recorder
+{
+/// installs the OMNITRACE_FLIGHT_RECORDER_SIGNAL handler and starts the thread which
+/// writes the dumps when OMNITRACE_FLIGHT_RECORDER is enabled
+void
+setup();
+
+void
+shutdown();
+
+/// requests a dump from the flight recorder thread. This is async-signal-safe and
+/// requests made while a dump is pending are coalesced
+void
+trigger();
+
+/// writes the current contents of the flight recorder on the calling thread
+void
+dump();
+
+/// returns true if a region of this duration (in nanoseconds) exceeds the
+/// OMNITRACE_FLIGHT_RECORDER_LATENCY_THRESHOLD
+bool
+exceeds_latency_threshold(uint64_t _elapsed_ns);
+
+/// true when OMNITRACE_FLIGHT_RECORDER_LATENCY_THRESHOLD is enabled
+bool
+use_latency_threshold();
+}  // namespace flight_recorder
+}  // namespace omnitrace
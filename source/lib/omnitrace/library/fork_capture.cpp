@@ -0,0 +1,504 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/fork_capture.hpp"
+#include "binary/analysis.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/process/process.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/unwind/processed_entry.hpp>
+#include <timemory/utility/backtrace.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace omnitrace
+{
+namespace fork_capture
+{
+namespace
+{
+constexpr size_t stack_depth  = OMNITRACE_MAX_UNWIND_DEPTH;
+constexpr size_t ignore_depth = 1;  // the signal handler
+
+// the call-stacks of the samples are stored with a fixed stride of stack_depth and
+// are terminated by a zero address when shorter. The buffer is not initialized so
+// only the pages which are written are touched
+struct sample_buffer
+{
+    size_t                       capacity = 0;
+    std::unique_ptr<uintptr_t[]> data     = {};
+    std::atomic<size_t>          count    = { 0 };
+    std::atomic<size_t>          dropped  = { 0 };
+};
+
+struct region_entry
+{
+    std::string name  = {};
+    uint64_t    count = 0;
+    uint64_t    total = 0;  // nsec
+};
+
+struct thread_regions
+{
+    std::vector<uint64_t>                    stack   = {};
+    std::unordered_map<size_t, region_entry> regions = {};
+};
+
+// the totals of a function over the samples
+struct function_entry
+{
+    uint64_t exclusive = 0;
+    uint64_t inclusive = 0;
+};
+
+using function_list_t = std::vector<std::pair<std::string, function_entry>>;
+using region_map_t    = std::map<std::string, region_entry>;
+
+struct summary
+{
+    uint64_t        samples   = 0;
+    uint64_t        dropped   = 0;
+    double          period    = 0.0;  // msec
+    function_list_t functions = {};
+    region_map_t    regions   = {};
+};
+
+std::atomic<bool> active_capture = { false };
+std::once_flag    post_process_once{};
+
+// intentionally leaked: the profile is written by the exit handlers
+auto&
+get_samples()
+{
+    static auto* _v = new sample_buffer{};
+    return *_v;
+}
+
+auto&
+get_timer()
+{
+    static auto _v = std::pair<timer_t, bool>{ timer_t{}, false };
+    return _v;
+}
+
+auto&
+get_regions_mutex()
+{
+    static auto* _v = new std::mutex{};
+    return *_v;
+}
+
+auto&
+get_all_regions()
+{
+    static auto* _v = new std::vector<std::unique_ptr<thread_regions>>{};
+    return *_v;
+}
+
+// the regions of the calling thread, registered once
+thread_regions*
+get_local_regions()
+{
+    static thread_local thread_regions* _v = nullptr;
+    if(!_v)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_regions_mutex() };
+        get_all_regions().emplace_back(std::make_unique<thread_regions>());
+        _v = get_all_regions().back().get();
+    }
+    return _v;
+}
+
+TIMEMORY_NOINLINE void
+sample_handler(int, siginfo_t*, void*)
+{
+    auto  _errno = errno;
+    auto& _v     = get_samples();
+    auto  _idx   = _v.count.fetch_add(1, std::memory_order_relaxed);
+    if(_idx >= _v.capacity)
+    {
+        _v.dropped.fetch_add(1, std::memory_order_relaxed);
+        errno = _errno;
+        return;
+    }
+
+    auto*  _data = _v.data.get() + (_idx * stack_depth);
+    size_t _n    = 0;
+    for(auto itr : tim::get_unw_stack_raw<stack_depth, ignore_depth>())
+    {
+        if(itr == 0 || _n == stack_depth) break;
+        _data[_n++] = itr;
+    }
+    if(_n < stack_depth) _data[_n] = 0;
+    errno = _errno;
+}
+
+void
+start_sampler()
+{
+    auto _freq = config::get_sampling_cputime_freq();
+    auto _n    = config::get_fork_child_capture_samples();
+    if(_freq <= 0.0 || _n == 0) return;
+
+    auto& _v     = get_samples();
+    _v.data      = std::unique_ptr<uintptr_t[]>{ new uintptr_t[_n * stack_depth] };
+    _v.capacity  = _n;
+    auto _signum = config::get_sampling_cputime_signal();
+
+    struct sigaction _action = {};
+    sigemptyset(&_action.sa_mask);
+    _action.sa_flags     = SA_RESTART | SA_SIGINFO;
+    _action.sa_sigaction = &sample_handler;
+    if(sigaction(_signum, &_action, nullptr) != 0)
+    {
+        OMNITRACE_VERBOSE(0, "[fork_capture] sigaction(%i) failed: %s\n", _signum,
+                          strerror(errno));
+        return;
+    }
+
+    sigset_t _mask = {};
+    sigemptyset(&_mask);
+    sigaddset(&_mask, _signum);
+    pthread_sigmask(SIG_UNBLOCK, &_mask, nullptr);
+
+    // the CPU-time of the process so the samples are distributed over the threads
+    struct sigevent _event = {};
+    _event.sigev_notify    = SIGEV_SIGNAL;
+    _event.sigev_signo     = _signum;
+
+    auto& _timer = get_timer();
+    if(timer_create(CLOCK_PROCESS_CPUTIME_ID, &_event, &_timer.first) != 0)
+    {
+        OMNITRACE_VERBOSE(0, "[fork_capture] timer_create failed: %s\n",
+                          strerror(errno));
+        return;
+    }
+    _timer.second = true;
+
+    auto _period             = static_cast<int64_t>(1.0e9 / _freq);
+    auto _spec                = itimerspec{};
+    _spec.it_interval.tv_sec  = _period / 1000000000;
+    _spec.it_interval.tv_nsec = _period % 1000000000;
+    _spec.it_value            = _spec.it_interval;
+    timer_settime(_timer.first, 0, &_spec, nullptr);
+}
+
+void
+stop_sampler()
+{
+    auto& _timer = get_timer();
+    if(!_timer.second) return;
+    timer_delete(_timer.first);
+    _timer.second = false;
+}
+
+summary
+get_summary()
+{
+    // known functions which are by-products of the interrupt
+    static const auto _known_excludes =
+        std::set<std::string>{ "funlockfile", "killpg", "__restore_rt" };
+
+    auto& _v       = get_samples();
+    auto  _summary = summary{};
+
+    _summary.samples = std::min(_v.count.load(), _v.capacity);
+    _summary.dropped = _v.dropped.load();
+    _summary.period  = 1.0e3 / config::get_sampling_cputime_freq();
+
+    // the names of the addresses. The addresses of the samples have few distinct values
+    auto _storage   = std::unordered_set<std::string>{};
+    auto _names     = std::unordered_map<uintptr_t, const std::string*>{};
+    auto _functions = std::unordered_map<std::string, function_entry>{};
+    auto _unique    = std::unordered_set<const std::string*>{};
+    auto _lookup    = [&_storage, &_names](uintptr_t _addr) -> const std::string* {
+        auto itr = _names.find(_addr);
+        if(itr != _names.end()) return itr->second;
+
+        const std::string* _name = nullptr;
+        if(auto _entry = binary::lookup_ipaddr_entry<true>(_addr); _entry)
+        {
+            if(_known_excludes.count(_entry->name) == 0)
+                _name = &(*_storage.emplace(_entry->name).first);
+        }
+        return (_names[_addr] = _name);
+    };
+
+    for(size_t i = 0; i < _summary.samples; ++i)
+    {
+        const auto* _data  = _v.data.get() + (i * stack_depth);
+        bool        _inner = true;
+        _unique.clear();
+        for(size_t j = 0; j < stack_depth && _data[j] != 0; ++j)
+        {
+            const auto* _name = _lookup(_data[j]);
+            if(!_name) continue;
+
+            auto& _entry = _functions[*_name];
+            if(_inner) _entry.exclusive += 1;
+            if(_unique.emplace(_name).second) _entry.inclusive += 1;
+            _inner = false;
+        }
+    }
+
+    _summary.functions.assign(_functions.begin(), _functions.end());
+    std::sort(_summary.functions.begin(), _summary.functions.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  if(_lhs.second.exclusive != _rhs.second.exclusive)
+                      return _lhs.second.exclusive > _rhs.second.exclusive;
+                  if(_lhs.second.inclusive != _rhs.second.inclusive)
+                      return _lhs.second.inclusive > _rhs.second.inclusive;
+                  return _lhs.first < _rhs.first;
+              });
+
+    auto _lk = std::unique_lock<std::mutex>{ get_regions_mutex() };
+    for(const auto& titr : get_all_regions())
+    {
+        for(const auto& itr : titr->regions)
+        {
+            auto& _entry = _summary.regions[itr.second.name];
+            _entry.count += itr.second.count;
+            _entry.total += itr.second.total;
+        }
+    }
+
+    return _summary;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("fork-child-profile", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening fork-child-profile output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "fork-child-profile" });
+
+    ofs << "pid: " << process::get_id() << ", parent: " << process::get_parent_id()
+        << ", samples: " << _data.samples << ", dropped: " << _data.dropped
+        << ", period (msec): " << std::setprecision(3) << std::fixed << _data.period
+        << "\n";
+
+    if(!_data.functions.empty())
+    {
+        ofs << "\n"
+            << std::setw(12) << "exclusive" << " | " << std::setw(12) << "inclusive"
+            << " | " << std::setw(14) << "exclusive (%)" << " | function\n";
+        for(const auto& itr : _data.functions)
+        {
+            auto _percent = (_data.samples > 0)
+                                ? (100.0 * itr.second.exclusive) / _data.samples
+                                : 0.0;
+            ofs << std::setw(12) << itr.second.exclusive << " | " << std::setw(12)
+                << itr.second.inclusive << " | " << std::setw(14) << std::setprecision(2)
+                << _percent << " | " << itr.first << "\n";
+        }
+    }
+
+    if(!_data.regions.empty())
+    {
+        ofs << "\n"
+            << std::setw(12) << "count" << " | " << std::setw(14) << "total (msec)"
+            << " | " << std::setw(14) << "mean (usec)" << " | region\n";
+        for(const auto& itr : _data.regions)
+        {
+            const auto& _v = itr.second;
+            ofs << std::setw(12) << _v.count << " | " << std::setw(14)
+                << std::setprecision(3) << (_v.total / 1.0e6) << " | " << std::setw(14)
+                << (_v.total / 1.0e3) / std::max<uint64_t>(_v.count, 1) << " | "
+                << itr.first << "\n";
+        }
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("fork_child_profile");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("pid", process::get_id()),
+              cereal::make_nvp("parent", process::get_parent_id()),
+              cereal::make_nvp("samples", _data.samples),
+              cereal::make_nvp("dropped", _data.dropped),
+              cereal::make_nvp("period_msec", _data.period));
+
+        ar->setNextName("functions");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.functions)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("function", itr.first),
+                  cereal::make_nvp("exclusive", itr.second.exclusive),
+                  cereal::make_nvp("inclusive", itr.second.inclusive));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->setNextName("regions");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.regions)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("region", itr.first),
+                  cereal::make_nvp("count", itr.second.count),
+                  cereal::make_nvp("total_ns", itr.second.total));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("fork-child-profile", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening fork-child-profile output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "fork-child-profile" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+setup()
+{
+    if(active_capture.load()) return;
+
+    // the output of the child is distinguished from the output of the parent
+    settings::use_output_suffix()      = true;
+    settings::default_process_suffix() = process::get_id();
+
+    if(config::get_use_sampling()) start_sampler();
+
+    active_capture.store(true);
+
+    OMNITRACE_VERBOSE(1, "[fork_capture] capturing child process %i of %i\n",
+                      process::get_id(), process::get_parent_id());
+}
+
+bool
+is_active()
+{
+    return active_capture.load(std::memory_order_relaxed);
+}
+
+void
+push_region()
+{
+    if(!is_active()) return;
+
+    get_local_regions()->stack.emplace_back(
+        tim::get_clock_real_now<uint64_t, std::nano>());
+}
+
+void
+pop_region(std::string_view _name)
+{
+    if(!is_active()) return;
+
+    auto* _v = get_local_regions();
+    if(_v->stack.empty()) return;
+
+    auto  _elapsed = tim::get_clock_real_now<uint64_t, std::nano>() - _v->stack.back();
+    auto& _entry   = _v->regions[std::hash<std::string_view>{}(_name)];
+    if(_entry.name.empty()) _entry.name = std::string{ _name };
+    _entry.count += 1;
+    _entry.total += _elapsed;
+    _v->stack.pop_back();
+}
+
+void
+post_process()
+{
+    if(!is_active()) return;
+
+    std::call_once(post_process_once, []() {
+        stop_sampler();
+        active_capture.store(false);
+
+        try
+        {
+            auto _data = get_summary();
+
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "Exception caught: %s\n", _e.what());
+        }
+    });
+}
+}  // namespace fork_capture
+}  // namespace omnitrace
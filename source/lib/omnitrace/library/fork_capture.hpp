@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <string_view>
+
+namespace omnitrace
+{
+/// profile of a child process created by fork() without a subsequent exec (see
+/// OMNITRACE_FORK_CHILD_CAPTURE). The perfetto session and the timemory storage of the
+/// parent rely on background threads which do not exist in the child so, instead of
+/// re-initializing them, the child inherits the configuration and the binary info of
+/// the parent and records into self-contained buffers: a process CPU-time sampler
+/// writing the raw call-stacks into a preallocated buffer and the totals of the
+/// regions per thread. When the child exits, the samples are symbolized and written
+/// with the regions to fork-child-profile.{txt,json} with the PID of the child as the
+/// output suffix
+namespace fork_capture
+{
+/// starts the capture in a child process. Invoked after fork()
+void
+setup();
+
+/// check if the capture is running in this process
+bool
+is_active();
+
+/// records the start of a region on the calling thread
+void
+push_region();
+
+/// records the end of a region on the calling thread
+void
+pop_region(std::string_view);
+
+/// stops the capture and writes the profile. Only the first invocation has an effect
+void
+post_process();
+}  // namespace fork_capture
+}  // namespace omnitrace
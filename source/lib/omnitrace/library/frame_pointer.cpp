@@ -0,0 +1,246 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/frame_pointer.hpp"
+#include "core/debug.hpp"
+#include "core/defines.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <pthread.h>
+#include <signal.h>
+#include <ucontext.h>
+
+namespace omnitrace
+{
+namespace frame_pointer
+{
+namespace
+{
+struct stack_bounds
+{
+    uintptr_t lo = 0;
+    uintptr_t hi = 0;
+};
+
+// read in the signal handler so the initial-exec model avoids the TLS resolver
+stack_bounds&
+get_stack_bounds()
+{
+    static thread_local stack_bounds _v OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) =
+        {};
+    return _v;
+}
+
+#if defined(__x86_64__)
+// the frames of the signal handler between the unwinder and the signal frame
+constexpr uintptr_t max_handler_frames = 32 * 1024;
+
+// the return address of the signal handler, i.e. the sa_restorer which the C library
+// installs with every handler. Queried from the handled signal on the first sample
+auto&
+get_restorer()
+{
+    static auto _v = std::atomic<uintptr_t>{ 0 };
+    return _v;
+}
+
+// not inlined so that the copy of the restorer in the sigaction is not within the
+// frames searched for the signal frame
+OMNITRACE_ATTRIBUTE(noinline) uintptr_t
+query_restorer(int _signo)
+{
+    auto _errno = errno;
+    auto _v     = uintptr_t{ 0 };
+    struct sigaction _action = {};
+    if(sigaction(_signo, nullptr, &_action) == 0)
+        _v = reinterpret_cast<uintptr_t>(_action.sa_restorer);
+    errno = _errno;
+    return _v;
+}
+
+// the registers and the signal mask are the part of the ucontext which the kernel and
+// the C library lay out the same way
+constexpr size_t signal_context_size = offsetof(ucontext_t, uc_sigmask);
+
+// the signal frame is validated by the pointer to the saved floating-point state, which
+// the kernel places in the same frame past the ucontext, and by the stack pointer of
+// the interrupted code, which is above the frame unless the frame is on an alternate
+// signal stack. A word of the handler frames which happens to equal the restorer
+// address fails both checks with a very high probability
+bool
+is_signal_context(const ucontext_t* _ctx, uintptr_t _end, bool _altstack)
+{
+    auto _addr   = reinterpret_cast<uintptr_t>(_ctx);
+    auto _fpregs = reinterpret_cast<uintptr_t>(_ctx->uc_mcontext.fpregs);
+    auto _sp     = static_cast<uintptr_t>(_ctx->uc_mcontext.gregs[REG_RSP]);
+    if(_fpregs < _addr + signal_context_size || _fpregs >= _end) return false;
+    return (_altstack || _sp > _addr) && _ctx->uc_mcontext.gregs[REG_RIP] != 0;
+}
+
+// the return address of the handler is the first word of the signal frame and is
+// followed by the ucontext of the interrupted code
+const ucontext_t*
+find_signal_context(uintptr_t _beg, uintptr_t _end, uintptr_t _restorer, bool _altstack)
+{
+    constexpr auto _ctx_size = sizeof(uintptr_t) + signal_context_size;
+    for(auto _addr = _beg; _addr + _ctx_size <= _end; _addr += sizeof(uintptr_t))
+    {
+        if(*reinterpret_cast<const uintptr_t*>(_addr) != _restorer) continue;
+        const auto* _ctx = reinterpret_cast<const ucontext_t*>(_addr + sizeof(uintptr_t));
+        if(is_signal_context(_ctx, _end, _altstack)) return _ctx;
+    }
+    return nullptr;
+}
+
+// the context of the code interrupted by the signal which is being handled
+OMNITRACE_INLINE const ucontext_t*
+get_signal_context(const stack_bounds& _bounds, int _signo)
+{
+    auto _restorer = get_restorer().load(std::memory_order_relaxed);
+    if(_restorer == 0)
+    {
+        _restorer = query_restorer(_signo);
+        if(_restorer == 0) return nullptr;
+        get_restorer().store(_restorer, std::memory_order_relaxed);
+    }
+
+    // the handler runs on the stack of the thread unless an alternate signal stack
+    // is installed. The scan never leaves the stack the handler is running on and
+    // an unknown stack is left to libunwind
+    auto _beg      = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    auto _end      = _beg + max_handler_frames;
+    auto _altstack = false;
+    if(_beg >= _bounds.lo && _beg < _bounds.hi)
+    {
+        _end = std::min(_end, _bounds.hi);
+    }
+    else
+    {
+        auto _errno = errno;
+        auto _stack = stack_t{};
+        auto _ret   = sigaltstack(nullptr, &_stack);
+        errno       = _errno;
+        if(_ret != 0 || (_stack.ss_flags & SS_ONSTACK) == 0) return nullptr;
+
+        auto _lo = reinterpret_cast<uintptr_t>(_stack.ss_sp);
+        auto _hi = _lo + _stack.ss_size;
+        if(_beg < _lo || _beg >= _hi) return nullptr;
+        _end      = std::min(_end, _hi);
+        _altstack = true;
+    }
+
+    return find_signal_context(_beg, _end, _restorer, _altstack);
+}
+#endif
+}  // namespace
+
+void
+configure_thread()
+{
+    auto  _attr   = pthread_attr_t{};
+    auto& _bounds = get_stack_bounds();
+    if(pthread_getattr_np(pthread_self(), &_attr) != 0) return;
+
+    void*  _addr = nullptr;
+    size_t _size = 0;
+    if(pthread_attr_getstack(&_attr, &_addr, &_size) == 0 && _addr && _size > 0)
+    {
+        _bounds.lo = reinterpret_cast<uintptr_t>(_addr);
+        _bounds.hi = _bounds.lo + _size;
+        OMNITRACE_VERBOSE(3, "[frame_pointer] stack of thread spans [%p, %p)\n",
+                          (void*) _bounds.lo, (void*) _bounds.hi);
+    }
+    pthread_attr_destroy(&_attr);
+}
+
+size_t
+unwind(uintptr_t* _data, size_t _capacity, int _signo, const void* _ucontext)
+{
+#if defined(__x86_64__)
+    const auto& _bounds = get_stack_bounds();
+    if(_capacity == 0 || _bounds.hi == 0) return 0;
+
+    auto _in_stack = [&_bounds](uintptr_t _v) {
+        return (_v % sizeof(uintptr_t)) == 0 && _v >= _bounds.lo &&
+               _v + (2 * sizeof(uintptr_t)) <= _bounds.hi;
+    };
+
+    const auto* _ctx = (_ucontext) ? static_cast<const ucontext_t*>(_ucontext)
+                                   : get_signal_context(_bounds, _signo);
+    if(!_ctx) return 0;
+
+    const auto& _regs = _ctx->uc_mcontext.gregs;
+    auto        _pc   = static_cast<uintptr_t>(_regs[REG_RIP]);
+    auto        _fp   = static_cast<uintptr_t>(_regs[REG_RBP]);
+    auto        _sp   = static_cast<uintptr_t>(_regs[REG_RSP]);
+
+    // a frame pointer below the stack pointer is not a frame of the interrupted code
+    if(_pc == 0 || _fp < _sp || !_in_stack(_fp)) return 0;
+
+    size_t _n   = 0;
+    _data[_n++] = _pc;
+    while(_n < _capacity)
+    {
+        const auto* _frame = reinterpret_cast<const uintptr_t*>(_fp);
+        auto        _next  = _frame[0];
+        auto        _ret   = _frame[1];
+        if(_ret == 0) break;
+        _data[_n++] = _ret;
+
+        // the callers are at higher addresses so the chain ends otherwise
+        if(_next <= _fp || !_in_stack(_next)) break;
+        _fp = _next;
+    }
+    return _n;
+#else
+    (void) _data;
+    (void) _capacity;
+    (void) _signo;
+    (void) _ucontext;
+    return 0;
+#endif
+}
+
+uintptr_t
+interrupted_pc(int _signo, const void* _ucontext)
+{
+#if defined(__x86_64__)
+    const auto& _bounds = get_stack_bounds();
+    if(_bounds.hi == 0) return 0;
+
+    const auto* _ctx = (_ucontext) ? static_cast<const ucontext_t*>(_ucontext)
+                                   : get_signal_context(_bounds, _signo);
+    return (_ctx) ? static_cast<uintptr_t>(_ctx->uc_mcontext.gregs[REG_RIP]) : 0;
+#else
+    (void) _signo;
+    (void) _ucontext;
+    return 0;
+#endif
+}
+}  // namespace frame_pointer
+}  // namespace omnitrace
@@ -0,0 +1,62 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// frame-pointer unwinding of the call-stacks interrupted by the sampling signals (see
+/// OMNITRACE_SAMPLING_UNWINDER). The frames of the signal handler may not have frame
+/// pointers so, unless the handler provides its ucontext, the signal frame is located by
+/// its return address into the signal trampoline of the C library and validated before
+/// the walk starts from the registers saved in it.
+/// Every frame is checked against the bounds of the stack of the thread before it is
+/// read so a broken chain ends the call-stack instead of faulting
+namespace frame_pointer
+{
+/// records the bounds of the stack of the calling thread. Must be invoked by every
+/// thread before it is sampled
+void
+configure_thread();
+
+/// writes the instruction pointer of the interrupted function followed by the return
+/// addresses of its callers, innermost first, and returns the number of addresses. Zero
+/// is returned when the call-stack should be unwound by libunwind: the architecture is
+/// not supported, the thread is not configured or not in the handler of the signal, or
+/// the first frame pointer is not within the stack. Handlers installed with SA_SIGINFO
+/// pass their ucontext, otherwise the signal frame is searched on the stack the handler
+/// runs on, i.e. the stack of the thread or the active alternate signal stack.
+/// Async-signal-safe
+size_t
+unwind(uintptr_t* _data, size_t _capacity, int _signo, const void* _ucontext = nullptr);
+
+/// the instruction pointer of the interrupted function without walking the frames, i.e.
+/// also when the function does not maintain a frame pointer. Zero in the same cases as
+/// unwind() except the frame pointer check. Async-signal-safe
+uintptr_t
+interrupted_pc(int _signo, const void* _ucontext = nullptr);
+}  // namespace frame_pointer
+}  // namespace omnitrace
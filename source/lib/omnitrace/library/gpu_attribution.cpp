@@ -0,0 +1,882 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/gpu_attribution.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/gpu.hpp"
+#include "core/mpi_reduce.hpp"
+#include "core/timemory.hpp"
+#include "library/region_attribution.hpp"
+#include "library/rocm_smi.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace gpu_attribution
+{
+namespace
+{
+using region_attribution::timeline;
+
+// devices whose PCI location is unknown are keyed by their index with this bit set
+constexpr auto unknown_pci = uint64_t{ 1 } << 63;
+
+enum gpu_mode : uint8_t
+{
+    unknown_mode = 0,
+    counter_mode,  // energy counter of the device
+    power_mode,    // integrated average power
+};
+
+struct gpu_device
+{
+    uint32_t                index     = 0;
+    std::optional<uint64_t> pci_id    = {};
+    gpu_mode                mode      = unknown_mode;
+    double                  offset    = 0.0;  // energy counter at the first sample
+    double                  power     = 0.0;  // watts at the last sample
+    double                  busy_perc = 0.0;  // percent at the last sample
+    uint64_t                last      = 0;    // time of the last power sample
+    uint64_t                last_busy = 0;    // time of the last busy sample
+    uint64_t                mem_peak  = 0;
+    double                  mem_sum   = 0.0;
+    uint64_t                mem_count = 0;
+    timeline                energy    = {};  // accumulated joules
+    timeline                busy      = {};  // accumulated busy nanoseconds
+};
+
+struct sampler_state
+{
+    std::mutex              mutex  = {};
+    bool                    active = false;
+    std::vector<gpu_device> gpus   = {};
+};
+
+// intentionally leaked so the sampler does not depend on the order of the static
+// destruction
+sampler_state&
+get_sampler()
+{
+    static auto* _v = new sampler_state{};
+    return *_v;
+}
+
+using interval_t = std::pair<uint64_t, uint64_t>;
+
+struct kernel_records
+{
+    std::mutex                                           mutex = {};
+    std::unordered_map<int32_t, std::vector<interval_t>> data  = {};
+};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the kernels can be appended during the static destruction
+kernel_records&
+get_kernel_records()
+{
+    static auto* _v = new kernel_records{};
+    return *_v;
+}
+
+void
+sample_gpu(gpu_device& _dev, uint64_t _ts)
+{
+    if(!_dev.pci_id) _dev.pci_id = rocm_smi::get_pci_id(_dev.index);
+
+    if(auto _busy = rocm_smi::get_busy(_dev.index))
+    {
+        if(_dev.busy.empty())
+            _dev.busy.push(_ts, 0.0);
+        else if(_ts > _dev.last_busy)
+        {
+            auto _dt = static_cast<double>(_ts - _dev.last_busy);
+            _dev.busy.push(_ts, _dev.busy.values.back() +
+                                    0.5 * (*_busy + _dev.busy_perc) * 1.0e-2 * _dt);
+        }
+        _dev.busy_perc = *_busy;
+        _dev.last_busy = _ts;
+    }
+
+    if(auto _usage = rocm_smi::get_memory_usage(_dev.index))
+    {
+        _dev.mem_peak = std::max(_dev.mem_peak, *_usage);
+        _dev.mem_sum += static_cast<double>(*_usage);
+        _dev.mem_count += 1;
+    }
+
+    if(_dev.mode != power_mode)
+    {
+        if(auto _joules = rocm_smi::get_energy(_dev.index))
+        {
+            if(_dev.mode == unknown_mode)
+            {
+                _dev.mode   = counter_mode;
+                _dev.offset = *_joules;
+            }
+            _dev.energy.push(_ts, *_joules - _dev.offset);
+            return;
+        }
+        if(_dev.mode == counter_mode) return;
+    }
+
+    if(auto _power = rocm_smi::get_power(_dev.index))
+    {
+        if(_dev.mode == unknown_mode)
+        {
+            _dev.mode = power_mode;
+            _dev.energy.push(_ts, 0.0);
+        }
+        else if(_ts > _dev.last)
+        {
+            auto _dt = static_cast<double>(_ts - _dev.last) / units::sec;
+            _dev.energy.push(_ts, _dev.energy.values.back() +
+                                      0.5 * (*_power + _dev.power) * _dt);
+        }
+        _dev.power = *_power;
+        _dev.last  = _ts;
+    }
+}
+
+void
+sample_locked(sampler_state& _v)
+{
+    auto _ts = tracing::now();
+    for(auto& itr : _v.gpus)
+        sample_gpu(itr, _ts);
+}
+
+// the sampling interval, which is the width of the bins
+uint64_t
+get_bin_width()
+{
+    auto _freq = get_process_sampling_freq();
+    if(_freq <= 0.0) return units::sec;
+    return std::max<uint64_t>(static_cast<uint64_t>(units::sec / _freq), units::msec);
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//  binned data of the processes of a node
+//
+//--------------------------------------------------------------------------------------//
+
+struct device_bin
+{
+    uint64_t length  = 0;    // sampled nanoseconds of the bin
+    double   busy_ns = 0.0;  // device-wide
+    double   joules  = 0.0;  // device-wide
+};
+
+struct device_data
+{
+    int32_t                        rank       = 0;  // rank which sampled the device
+    uint32_t                       index      = 0;  // rocm-smi index on that rank
+    bool                           has_busy   = false;
+    bool                           has_energy = false;
+    uint64_t                       mem_peak   = 0;
+    double                         mem_mean   = 0.0;
+    std::map<uint64_t, device_bin> bins       = {};
+};
+
+struct process_data
+{
+    int32_t  pid   = 0;
+    uint64_t width = 0;
+    // kernel nanoseconds per bin of each device
+    std::map<uint64_t, std::map<uint64_t, uint64_t>> active = {};
+};
+
+struct node_data
+{
+    std::map<uint64_t, device_data> devices   = {};
+    std::map<int32_t, process_data> processes = {};  // per rank
+};
+
+uint64_t
+get_device_key(const gpu_device& _dev)
+{
+    // the function of the BDF id is not known to HIP
+    if(_dev.pci_id) return (*_dev.pci_id & ~uint64_t{ 0x7 });
+    return unknown_pci | _dev.index;
+}
+
+// the HIP devices are matched to the rocm-smi devices by their PCI location since the
+// visible devices of each process may differ. Without it, the HIP and rocm-smi indices
+// are assumed to be the same
+uint64_t
+get_device_key(const std::vector<gpu_device>& _gpus, int32_t _device)
+{
+    if(auto _pci = gpu::hip_device_pci_id(_device)) return *_pci;
+    for(const auto& itr : _gpus)
+    {
+        if(static_cast<int32_t>(itr.index) == _device) return get_device_key(itr);
+    }
+    return unknown_pci | static_cast<uint32_t>(_device);
+}
+
+std::string
+get_device_label(uint64_t _key)
+{
+    if((_key & unknown_pci) != 0)
+        return JOIN(" ", "device", static_cast<uint32_t>(_key & ~unknown_pci));
+
+    char _buf[32];
+    std::snprintf(_buf, sizeof(_buf), "%04x:%02x:%02x", static_cast<uint32_t>(_key >> 32),
+                  static_cast<uint32_t>((_key >> 8) & 0xff),
+                  static_cast<uint32_t>((_key >> 3) & 0x1f));
+    return std::string{ _buf };
+}
+
+// the kernels of a process which overlap (e.g. on several streams) are only counted
+// once and each interval is split at the bin edges
+std::map<uint64_t, uint64_t>
+get_active_bins(std::vector<interval_t> _intervals, uint64_t _width)
+{
+    auto _v = std::map<uint64_t, uint64_t>{};
+    std::sort(_intervals.begin(), _intervals.end());
+
+    auto _add = [&_v, _width](uint64_t _beg, uint64_t _end) {
+        while(_beg < _end)
+        {
+            auto _bin = _beg / _width;
+            auto _seg = std::min(_end, (_bin + 1) * _width) - _beg;
+            _v[_bin] += _seg;
+            _beg += _seg;
+        }
+    };
+
+    auto _cur = std::optional<interval_t>{};
+    for(const auto& itr : _intervals)
+    {
+        if(_cur && itr.first <= _cur->second)
+        {
+            _cur->second = std::max(_cur->second, itr.second);
+            continue;
+        }
+        if(_cur) _add(_cur->first, _cur->second);
+        _cur = itr;
+    }
+    if(_cur) _add(_cur->first, _cur->second);
+    return _v;
+}
+
+node_data
+get_local_data(const sampler_state&                                        _s,
+               const std::unordered_map<int32_t, std::vector<interval_t>>& _kernels)
+{
+    auto _width = get_bin_width();
+    auto _rank  = static_cast<int32_t>(dmp::rank());
+    auto _data  = node_data{};
+
+    for(const auto& itr : _s.gpus)
+    {
+        if(itr.busy.ts.size() < 2 && itr.energy.ts.size() < 2) continue;
+
+        auto _beg    = std::numeric_limits<uint64_t>::max();
+        auto _end    = uint64_t{ 0 };
+        auto _extent = [&_beg, &_end](const timeline& _v) {
+            if(_v.ts.size() < 2) return;
+            _beg = std::min(_beg, _v.ts.front());
+            _end = std::max(_end, _v.ts.back());
+        };
+        _extent(itr.busy);
+        _extent(itr.energy);
+
+        auto& _dev      = _data.devices[get_device_key(itr)];
+        _dev.rank       = _rank;
+        _dev.index      = itr.index;
+        _dev.has_busy   = (itr.busy.ts.size() > 1);
+        _dev.has_energy = (itr.energy.ts.size() > 1);
+        _dev.mem_peak   = itr.mem_peak;
+        _dev.mem_mean   = (itr.mem_count > 0)
+                              ? (itr.mem_sum / static_cast<double>(itr.mem_count))
+                              : 0.0;
+
+        for(auto _bin = _beg / _width; _bin * _width < _end; ++_bin)
+        {
+            auto _lo = std::max(_bin * _width, _beg);
+            auto _hi = std::min((_bin + 1) * _width, _end);
+            if(_hi <= _lo) continue;
+            auto& _v   = _dev.bins[_bin];
+            _v.length  = _hi - _lo;
+            _v.busy_ns = (_dev.has_busy) ? itr.busy.between(_lo, _hi) : 0.0;
+            _v.joules  = (_dev.has_energy) ? itr.energy.between(_lo, _hi) : 0.0;
+        }
+    }
+
+    auto& _proc = _data.processes[_rank];
+    _proc.pid   = static_cast<int32_t>(getpid());
+    _proc.width = _width;
+    for(const auto& itr : _kernels)
+    {
+        auto& _active = _proc.active[get_device_key(_s.gpus, itr.first)];
+        for(const auto& bitr : get_active_bins(itr.second, _width))
+            _active[bitr.first] += bitr.second;
+    }
+
+    return _data;
+}
+
+// one line per device, device bin, process and active bin with tab-separated fields
+mpi_reduce::buffer_t
+serialize(const node_data& _data)
+{
+    auto _ss = std::stringstream{};
+    _ss << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for(const auto& itr : _data.devices)
+    {
+        const auto& _v = itr.second;
+        _ss << "D\t" << itr.first << '\t' << _v.rank << '\t' << _v.index << '\t'
+            << _v.has_busy << '\t' << _v.has_energy << '\t' << _v.mem_peak << '\t'
+            << _v.mem_mean << '\n';
+        for(const auto& bitr : _v.bins)
+            _ss << "B\t" << itr.first << '\t' << bitr.first << '\t' << bitr.second.length
+                << '\t' << bitr.second.busy_ns << '\t' << bitr.second.joules << '\n';
+    }
+    for(const auto& itr : _data.processes)
+    {
+        _ss << "P\t" << itr.first << '\t' << itr.second.pid << '\t' << itr.second.width
+            << '\n';
+        for(const auto& ditr : itr.second.active)
+            for(const auto& bitr : ditr.second)
+                _ss << "A\t" << itr.first << '\t' << ditr.first << '\t' << bitr.first
+                    << '\t' << bitr.second << '\n';
+    }
+    auto _str = _ss.str();
+    return mpi_reduce::buffer_t{ _str.begin(), _str.end() };
+}
+
+node_data
+deserialize(const mpi_reduce::buffer_t& _data)
+{
+    auto _v    = node_data{};
+    auto _ss   = std::istringstream{ std::string{ _data.begin(), _data.end() } };
+    auto _line = std::string{};
+    while(std::getline(_ss, _line))
+    {
+        auto _fields = std::vector<std::string>{};
+        auto _ls     = std::istringstream{ _line };
+        auto _field  = std::string{};
+        while(std::getline(_ls, _field, '\t'))
+            _fields.emplace_back(_field);
+
+        auto _kind  = (_fields.empty()) ? std::string{} : _fields.front();
+        auto _valid = (_kind == "D" && _fields.size() == 8) ||
+                      (_kind == "B" && _fields.size() == 6) ||
+                      (_kind == "P" && _fields.size() == 4) ||
+                      (_kind == "A" && _fields.size() == 5);
+        if(!_valid)
+        {
+            OMNITRACE_CI_THROW(true, "Invalid gpu_attribution entry: '%s'\n",
+                               _line.c_str());
+            continue;
+        }
+
+        if(_kind == "D")
+        {
+            auto& _dev      = _v.devices[std::stoull(_fields.at(1))];
+            _dev.rank       = std::stoi(_fields.at(2));
+            _dev.index      = static_cast<uint32_t>(std::stoul(_fields.at(3)));
+            _dev.has_busy   = (std::stoi(_fields.at(4)) != 0);
+            _dev.has_energy = (std::stoi(_fields.at(5)) != 0);
+            _dev.mem_peak   = std::stoull(_fields.at(6));
+            _dev.mem_mean   = std::stod(_fields.at(7));
+        }
+        else if(_kind == "B")
+        {
+            auto& _bin =
+                _v.devices[std::stoull(_fields.at(1))].bins[std::stoull(_fields.at(2))];
+            _bin.length  = std::stoull(_fields.at(3));
+            _bin.busy_ns = std::stod(_fields.at(4));
+            _bin.joules  = std::stod(_fields.at(5));
+        }
+        else if(_kind == "P")
+        {
+            auto& _proc = _v.processes[std::stoi(_fields.at(1))];
+            _proc.pid   = std::stoi(_fields.at(2));
+            _proc.width = std::stoull(_fields.at(3));
+        }
+        else
+        {
+            auto& _proc = _v.processes[std::stoi(_fields.at(1))];
+            _proc.active[std::stoull(_fields.at(2))][std::stoull(_fields.at(3))] +=
+                std::stoull(_fields.at(4));
+        }
+    }
+    return _v;
+}
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+// every rank of a node samples the same devices so the samples of the lower rank are
+// kept and only the kernel time of the processes is combined
+void
+merge(mpi_reduce::buffer_t& _dst, mpi_reduce::buffer_t&& _src)
+{
+    auto _lhs = deserialize(_dst);
+    auto _rhs = deserialize(_src);
+    for(auto& itr : _rhs.devices)
+        _lhs.devices.emplace(itr.first, std::move(itr.second));
+    for(auto& itr : _rhs.processes)
+        _lhs.processes.emplace(itr.first, std::move(itr.second));
+    _dst = serialize(_lhs);
+}
+#endif
+
+//--------------------------------------------------------------------------------------//
+//
+//  attribution
+//
+//--------------------------------------------------------------------------------------//
+
+struct process_entry
+{
+    int32_t  rank      = 0;
+    int32_t  pid       = 0;
+    uint64_t kernel_ns = 0;    // union of the kernels of the process
+    uint64_t shared_ns = 0;    // kernel time in the bins shared with other processes
+    double   busy_ns   = 0.0;  // attributed busy time
+    double   joules    = 0.0;  // attributed energy
+};
+
+struct device_entry
+{
+    std::string                label        = {};
+    int32_t                    rank         = 0;
+    uint32_t                   index        = 0;
+    bool                       has_busy     = false;
+    bool                       has_energy   = false;
+    uint64_t                   duration     = 0;
+    double                     busy_ns      = 0.0;
+    double                     joules       = 0.0;
+    double                     idle_busy_ns = 0.0;  // busy time not attributed
+    double                     idle_joules  = 0.0;  // energy not attributed
+    uint64_t                   mem_peak     = 0;
+    double                     mem_mean     = 0.0;
+    std::vector<process_entry> processes    = {};
+};
+
+struct summary
+{
+    std::string               host      = {};
+    uint64_t                  width     = 0;
+    size_t                    processes = 0;
+    std::vector<device_entry> devices   = {};
+};
+
+summary
+get_summary(const node_data& _data)
+{
+    auto _v  = summary{};
+    _v.width = get_bin_width();
+    {
+        char _host[256];
+        if(gethostname(_host, sizeof(_host)) == 0)
+        {
+            _host[sizeof(_host) - 1] = '\0';
+            _v.host                  = _host;
+        }
+    }
+
+    auto _processes = std::vector<std::pair<int32_t, const process_data*>>{};
+    for(const auto& itr : _data.processes)
+    {
+        if(itr.second.width != _v.width)
+        {
+            OMNITRACE_WARNING_F(0,
+                                "rank %i sampled at a different interval (%lu nsec) "
+                                "and is excluded from the GPU attribution\n",
+                                itr.first, itr.second.width);
+            continue;
+        }
+        _processes.emplace_back(itr.first, &itr.second);
+    }
+    _v.processes = _processes.size();
+
+    for(const auto& ditr : _data.devices)
+    {
+        const auto& _dev   = ditr.second;
+        auto        _entry = device_entry{};
+        _entry.label       = get_device_label(ditr.first);
+        _entry.rank        = _dev.rank;
+        _entry.index       = _dev.index;
+        _entry.has_busy    = _dev.has_busy;
+        _entry.has_energy  = _dev.has_energy;
+        _entry.mem_peak    = _dev.mem_peak;
+        _entry.mem_mean    = _dev.mem_mean;
+
+        // the processes which ran kernels on the device
+        auto _active = std::vector<const std::map<uint64_t, uint64_t>*>{};
+        for(const auto& itr : _processes)
+        {
+            auto _aitr = itr.second->active.find(ditr.first);
+            if(_aitr == itr.second->active.end() || _aitr->second.empty()) continue;
+
+            auto& _proc = _entry.processes.emplace_back();
+            _proc.rank  = itr.first;
+            _proc.pid   = itr.second->pid;
+            for(const auto& bitr : _aitr->second)
+                _proc.kernel_ns += bitr.second;
+            _active.emplace_back(&_aitr->second);
+        }
+
+        auto _kernel_ns = std::vector<uint64_t>(_active.size(), 0);
+        for(const auto& bitr : _dev.bins)
+        {
+            const auto& _bin = bitr.second;
+            _entry.duration += _bin.length;
+            _entry.joules += _bin.joules;
+            if(_dev.has_busy) _entry.busy_ns += _bin.busy_ns;
+
+            uint64_t _sum = 0;
+            size_t   _num = 0;
+            for(size_t i = 0; i < _active.size(); ++i)
+            {
+                auto _aitr      = _active.at(i)->find(bitr.first);
+                _kernel_ns.at(i) = (_aitr != _active.at(i)->end()) ? _aitr->second : 0;
+                _sum += _kernel_ns.at(i);
+                if(_kernel_ns.at(i) > 0) ++_num;
+            }
+
+            if(_sum == 0)
+            {
+                _entry.idle_busy_ns += _bin.busy_ns;
+                _entry.idle_joules += _bin.joules;
+                continue;
+            }
+
+            // the traced kernels cannot account for more than the device was busy.
+            // Without the busy percentage, the kernel time is the busy time
+            auto _kernels = static_cast<double>(std::min(_sum, _bin.length));
+            auto _busy    = (_dev.has_busy) ? std::min(_bin.busy_ns, _kernels) : _kernels;
+            auto _frac =
+                (_dev.has_busy && _bin.busy_ns > 0.0) ? (_busy / _bin.busy_ns) : 1.0;
+
+            if(_dev.has_busy)
+                _entry.idle_busy_ns += (_bin.busy_ns - _busy);
+            else
+                _entry.busy_ns += _busy;
+            _entry.idle_joules += (_bin.joules * (1.0 - _frac));
+
+            for(size_t i = 0; i < _active.size(); ++i)
+            {
+                if(_kernel_ns.at(i) == 0) continue;
+                auto  _share = static_cast<double>(_kernel_ns.at(i)) /
+                               static_cast<double>(_sum);
+                auto& _proc  = _entry.processes.at(i);
+                _proc.busy_ns += _busy * _share;
+                _proc.joules += _bin.joules * _frac * _share;
+                if(_num > 1) _proc.shared_ns += _kernel_ns.at(i);
+            }
+        }
+
+        std::sort(_entry.processes.begin(), _entry.processes.end(),
+                  [](const auto& _lhs, const auto& _rhs) {
+                      return _lhs.busy_ns > _rhs.busy_ns;
+                  });
+        _v.devices.emplace_back(std::move(_entry));
+    }
+
+    return _v;
+}
+
+double
+get_percent(double _num, double _den)
+{
+    return (_den > 0.0) ? (100.0 * _num / _den) : 0.0;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("gpu-attribution", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening gpu-attribution output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "gpu_attribution" });
+
+    auto _sec = [](auto _ns) { return static_cast<double>(_ns) / units::sec; };
+    auto _mb  = [](auto _bytes) { return static_cast<double>(_bytes) / units::megabyte; };
+
+    ofs << std::fixed << std::setprecision(3);
+    ofs << "node: " << _data.host << ", " << _data.processes << " processes, "
+        << _sec(_data.width) << " sec bins\n";
+    for(const auto& itr : _data.devices)
+    {
+        auto _duration = static_cast<double>(itr.duration);
+        ofs << "\nGPU " << itr.label << " (rocm-smi device " << itr.index << " of rank "
+            << itr.rank << "):\n";
+        ofs << "    sampled     : " << std::setw(12) << _sec(_duration) << " sec\n";
+        if(itr.has_busy)
+            ofs << "    busy        : " << std::setw(12) << _sec(itr.busy_ns) << " sec ("
+                << get_percent(itr.busy_ns, _duration) << " %), "
+                << _sec(itr.idle_busy_ns) << " sec not attributed\n";
+        if(itr.has_energy)
+            ofs << "    energy      : " << std::setw(12) << itr.joules << " J, "
+                << itr.idle_joules << " J not attributed\n";
+        ofs << "    memory      : " << std::setw(12) << _mb(itr.mem_peak)
+            << " MB peak, " << _mb(itr.mem_mean) << " MB mean\n";
+
+        if(itr.processes.empty()) continue;
+
+        ofs << "\n    " << std::setw(6) << "rank" << " | " << std::setw(10) << "pid"
+            << " | " << std::setw(12) << "kernel [sec]" << " | " << std::setw(12)
+            << "shared [sec]" << " | " << std::setw(12) << "busy [sec]" << " | "
+            << std::setw(8) << "busy [%]" << " | " << std::setw(12) << "energy [J]"
+            << "\n";
+        for(const auto& pitr : itr.processes)
+        {
+            ofs << "    " << std::setw(6) << pitr.rank << " | " << std::setw(10)
+                << pitr.pid << " | " << std::setw(12) << _sec(pitr.kernel_ns) << " | "
+                << std::setw(12) << _sec(pitr.shared_ns) << " | " << std::setw(12)
+                << _sec(pitr.busy_ns) << " | " << std::setw(8)
+                << get_percent(pitr.busy_ns, itr.busy_ns) << " | " << std::setw(12)
+                << pitr.joules << "\n";
+        }
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("gpu_attribution");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("node", _data.host),
+              cereal::make_nvp("processes", _data.processes),
+              cereal::make_nvp("bin_width_ns", _data.width));
+
+        ar->setNextName("devices");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.devices)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("device", itr.label),
+                  cereal::make_nvp("rocm_smi_device", itr.index),
+                  cereal::make_nvp("sampled_by_rank", itr.rank),
+                  cereal::make_nvp("sampled_ns", itr.duration),
+                  cereal::make_nvp("has_busy", itr.has_busy),
+                  cereal::make_nvp("has_energy", itr.has_energy),
+                  cereal::make_nvp("busy_ns", itr.busy_ns),
+                  cereal::make_nvp("joules", itr.joules),
+                  cereal::make_nvp("unattributed_busy_ns", itr.idle_busy_ns),
+                  cereal::make_nvp("unattributed_joules", itr.idle_joules),
+                  cereal::make_nvp("memory_peak_bytes", itr.mem_peak),
+                  cereal::make_nvp("memory_mean_bytes", itr.mem_mean));
+
+            ar->setNextName("processes");
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& pitr : itr.processes)
+            {
+                ar->startNode();
+                (*ar)(cereal::make_nvp("rank", pitr.rank),
+                      cereal::make_nvp("pid", pitr.pid),
+                      cereal::make_nvp("kernel_ns", pitr.kernel_ns),
+                      cereal::make_nvp("shared_ns", pitr.shared_ns),
+                      cereal::make_nvp("busy_ns", pitr.busy_ns),
+                      cereal::make_nvp("busy_percent",
+                                       get_percent(pitr.busy_ns, itr.busy_ns)),
+                      cereal::make_nvp("joules", pitr.joules));
+                ar->finishNode();
+            }
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("gpu-attribution", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening gpu-attribution output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "gpu_attribution" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_gpu_attribution()) return;
+
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) return;
+
+    OMNITRACE_WARNING_IF_F(!get_use_rocm_smi(),
+                           "OMNITRACE_GPU_ATTRIBUTION requires OMNITRACE_USE_ROCM_SMI. "
+                           "Only the kernel time of the processes is reported\n");
+
+    if(get_use_rocm_smi())
+    {
+        for(uint32_t i = 0; i < static_cast<uint32_t>(gpu::rsmi_device_count()); ++i)
+            _s.gpus.emplace_back().index = i;
+    }
+
+    _s.active = true;
+}
+
+void
+config()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+sample()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+shutdown()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(!_s.active) return;
+
+    // the activity until the end of the application
+    sample_locked(_s);
+    _s.active = false;
+}
+
+void
+post_process()
+{
+    if(!config::get_gpu_attribution()) return;
+
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        shutdown();
+        get_active().store(false);
+
+        auto _data = node_data{};
+        {
+            auto& _s   = get_sampler();
+            auto& _k   = get_kernel_records();
+            auto  _slk = std::unique_lock<std::mutex>{ _s.mutex };
+            auto  _klk = std::unique_lock<std::mutex>{ _k.mutex };
+            _data      = get_local_data(_s, _k.data);
+        }
+
+        // every rank writes its own file when the data could not be combined
+        bool _leader = true;
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+        {
+            auto _buffer = serialize(_data);
+            if(mpi_reduce::node(_buffer, merge, _leader)) _data = deserialize(_buffer);
+        }
+#endif
+
+        if(!_leader) return;
+        if(_data.devices.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No rocm-smi samples were recorded for the GPU "
+                                   "attribution\n");
+            return;
+        }
+
+        OMNITRACE_VERBOSE_F(1, "GPU attribution of %zu devices to %zu processes...\n",
+                            _data.devices.size(), _data.processes.size());
+
+        try
+        {
+            auto _summary = get_summary(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_summary);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_summary);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the GPU attribution failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+
+void
+device_op(int32_t _device, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed) || _end_ns <= _beg_ns) return;
+
+    auto& _v  = get_kernel_records();
+    auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+    _v.data[_device].emplace_back(_beg_ns, _end_ns);
+}
+}  // namespace gpu_attribution
+}  // namespace omnitrace
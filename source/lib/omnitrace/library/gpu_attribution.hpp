@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// attribution of the device-wide GPU metrics to the processes which share a GPU (see
+/// OMNITRACE_GPU_ATTRIBUTION). The background process sampler reads the busy
+/// percentage, the energy (or the average power) and the memory usage of each device
+/// from rocm-smi and the roctracer activity callback records the interval of each
+/// kernel. At finalization, the time is divided into bins of the sampling interval
+/// which are aligned to the wall-clock so that every process on a node uses the same
+/// bins. The busy time and the energy of each bin are split among the processes by
+/// their share of the kernel time in the bin, the devices are matched by their PCI
+/// location. With MPI, the bins of the ranks of a node are combined on the lowest rank
+/// of the node which writes gpu-attribution.{txt,json}
+namespace gpu_attribution
+{
+void
+setup();
+
+void
+config();
+
+void
+sample();
+
+void
+shutdown();
+
+void
+post_process();
+
+/// records the interval of a kernel on a HIP device
+void
+device_op(int32_t _device, uint64_t _beg_ns, uint64_t _end_ns);
+}  // namespace gpu_attribution
+}  // namespace omnitrace
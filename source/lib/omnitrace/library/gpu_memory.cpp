@@ -0,0 +1,564 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/gpu_memory.hpp"
+#include "binary/analysis.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "library/trace_trigger.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/backtrace.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace gpu_memory
+{
+namespace
+{
+constexpr size_t stack_depth  = 32;
+constexpr size_t ignore_depth = 1;
+
+// the number of sites per device in each list of the output
+constexpr size_t max_output_sites = 50;
+
+// the number of frames per site in the output
+constexpr size_t max_output_frames = 16;
+
+// the changes of the live memory of a device within this interval are coalesced into
+// one point of the counter track, which keeps the highest and the last value
+constexpr uint64_t coalesce_interval = 100 * units::usec;
+
+// zero-terminated
+using callstack_t = std::array<uintptr_t, stack_depth>;
+
+struct site_key
+{
+    int32_t     device   = 0;
+    const char* function = nullptr;
+    callstack_t stack    = {};
+
+    friend bool operator<(const site_key& _lhs, const site_key& _rhs)
+    {
+        return std::tie(_lhs.device, _lhs.function, _lhs.stack) <
+               std::tie(_rhs.device, _rhs.function, _rhs.stack);
+    }
+};
+
+struct site_entry
+{
+    int32_t     device      = 0;
+    const char* function    = nullptr;
+    uint64_t    allocations = 0;
+    uint64_t    bytes       = 0;
+    uint64_t    live_count  = 0;
+    uint64_t    live_bytes  = 0;
+    uint64_t    peak_bytes  = 0;  // the live bytes at the peak of the device
+};
+
+struct device_totals
+{
+    uint64_t allocations = 0;
+    uint64_t bytes       = 0;
+    uint64_t live_count  = 0;
+    uint64_t live_bytes  = 0;
+    uint64_t peak_bytes  = 0;
+    uint64_t peak_ts     = 0;
+};
+
+struct timeline_point
+{
+    uint64_t timestamp = 0;
+    uint64_t peak      = 0;
+    uint64_t last_ts   = 0;
+    uint64_t last      = 0;
+};
+
+// the sites are in the order they were created
+struct device_entry
+{
+    device_totals               totals   = {};
+    std::vector<site_entry*>    sites    = {};
+    std::vector<timeline_point> timeline = {};
+};
+
+struct live_allocation
+{
+    device_entry* device = nullptr;
+    site_entry*   site   = nullptr;
+    uint64_t      size   = 0;
+};
+
+// the entries are never removed so the live allocations refer to them
+struct profile_data
+{
+    std::mutex                                     mutex      = {};
+    uint64_t                                       live_bytes = 0;  // excl. pinned host
+    std::map<int32_t, device_entry>                devices    = {};
+    std::map<site_key, site_entry>                 sites      = {};
+    std::unordered_map<uintptr_t, live_allocation> live       = {};
+};
+
+struct site_summary
+{
+    const site_key*          key    = nullptr;
+    site_entry               entry  = {};
+    std::vector<std::string> frames = {};
+};
+
+struct device_summary
+{
+    int32_t                   device  = 0;
+    device_totals             totals  = {};
+    std::vector<site_summary> peak    = {};
+    std::vector<site_summary> unfreed = {};
+};
+
+using summary_t = std::vector<device_summary>;
+
+std::once_flag post_process_once{};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the deallocations during the static destruction are safe
+auto&
+get_profile()
+{
+    static auto* _v = new profile_data{};
+    return *_v;
+}
+
+// requires the mutex of the profile
+void
+update_timeline(device_entry& _dev, uint64_t _now)
+{
+    auto  _live     = _dev.totals.live_bytes;
+    auto& _timeline = _dev.timeline;
+    if(_timeline.empty() || _now >= _timeline.back().timestamp + coalesce_interval)
+    {
+        _timeline.emplace_back(timeline_point{ _now, _live, _now, _live });
+        return;
+    }
+
+    auto& _point   = _timeline.back();
+    _point.peak    = std::max(_point.peak, _live);
+    _point.last_ts = _now;
+    _point.last    = _live;
+}
+
+// requires the mutex of the profile
+void
+update_trace_triggers(const profile_data& _profile)
+{
+    if(trace_trigger::get_enabled().memory)
+        trace_trigger::memory_update(_profile.live_bytes);
+}
+
+// requires the mutex of the profile
+void
+remove_live(profile_data& _profile, const live_allocation& _alloc, uint64_t _now)
+{
+    auto& _totals = _alloc.device->totals;
+    _alloc.site->live_count -= 1;
+    _alloc.site->live_bytes -= _alloc.size;
+    _totals.live_count -= 1;
+    _totals.live_bytes -= _alloc.size;
+    if(_alloc.site->device != host_device) _profile.live_bytes -= _alloc.size;
+    update_timeline(*_alloc.device, _now);
+}
+
+std::string
+get_device_name(int32_t _device)
+{
+    if(_device == host_device) return std::string{ "pinned host" };
+    return JOIN(' ', "device", _device);
+}
+
+std::vector<std::string>
+get_frames(const site_key& _key)
+{
+    // the frames within omnitrace (the HIP API callback) are excluded by the lookup
+    auto _frames = std::vector<std::string>{};
+    for(auto itr : _key.stack)
+    {
+        if(itr == 0) break;
+        if(auto _entry = binary::lookup_ipaddr_entry<true>(itr); _entry)
+            _frames.emplace_back(tim::demangle(_entry->name));
+    }
+
+    // the frames of roctracer and the HIP runtime precede the allocating function
+    auto itr = std::find(_frames.begin(), _frames.end(), std::string{ _key.function });
+    if(itr != _frames.end()) _frames.erase(_frames.begin(), itr);
+    if(_frames.size() > max_output_frames) _frames.resize(max_output_frames);
+    if(_frames.empty()) _frames.emplace_back(_key.function);
+    return _frames;
+}
+
+summary_t
+get_summary(const profile_data& _profile)
+{
+    auto _summary = summary_t{};
+    auto _index   = std::map<int32_t, size_t>{};
+    for(const auto& itr : _profile.devices)
+    {
+        _index.emplace(itr.first, _summary.size());
+        _summary.emplace_back(device_summary{ itr.first, itr.second.totals });
+    }
+
+    for(const auto& itr : _profile.sites)
+    {
+        auto& _dev = _summary.at(_index.at(itr.second.device));
+        if(itr.second.peak_bytes > 0)
+            _dev.peak.emplace_back(site_summary{ &itr.first, itr.second });
+        if(itr.second.live_bytes > 0)
+            _dev.unfreed.emplace_back(site_summary{ &itr.first, itr.second });
+    }
+
+    // only the sites in the output are symbolized
+    auto _frames   = std::map<const site_key*, std::vector<std::string>>{};
+    auto _finalize = [&_frames](std::vector<site_summary>& _sites, auto&& _value) {
+        std::stable_sort(_sites.begin(), _sites.end(),
+                         [&_value](const auto& _lhs, const auto& _rhs) {
+                             return _value(_lhs.entry) > _value(_rhs.entry);
+                         });
+        if(_sites.size() > max_output_sites) _sites.resize(max_output_sites);
+
+        for(auto& itr : _sites)
+        {
+            auto fitr = _frames.find(itr.key);
+            if(fitr == _frames.end())
+                fitr = _frames.emplace(itr.key, get_frames(*itr.key)).first;
+            itr.frames = fitr->second;
+        }
+    };
+
+    for(auto& itr : _summary)
+    {
+        _finalize(itr.peak, [](const site_entry& _v) { return _v.peak_bytes; });
+        _finalize(itr.unfreed, [](const site_entry& _v) { return _v.live_bytes; });
+    }
+
+    return _summary;
+}
+
+double
+as_megabytes(uint64_t _v)
+{
+    return static_cast<double>(_v) / units::megabyte;
+}
+
+void
+write_text(const summary_t& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("gpu-memory", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening gpu-memory output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname, std::string{ "gpu-memory" });
+
+    auto _write_site = [&ofs](const site_summary& _site) {
+        const auto& _v = _site.entry;
+        ofs << "\n"
+            << "    live at peak (MB): " << as_megabytes(_v.peak_bytes)
+            << ", allocated (MB): " << as_megabytes(_v.bytes)
+            << ", allocations: " << _v.allocations
+            << ", unfreed (MB): " << as_megabytes(_v.live_bytes)
+            << ", unfreed allocations: " << _v.live_count << "\n";
+        for(const auto& itr : _site.frames)
+            ofs << "        " << itr << "\n";
+    };
+
+    ofs << std::setprecision(3) << std::fixed;
+    for(const auto& itr : _data)
+    {
+        const auto& _totals = itr.totals;
+        ofs << get_device_name(itr.device) << ": allocations: " << _totals.allocations
+            << ", allocated (MB): " << as_megabytes(_totals.bytes)
+            << ", peak (MB): " << as_megabytes(_totals.peak_bytes)
+            << ", unfreed allocations: " << _totals.live_count
+            << ", unfreed (MB): " << as_megabytes(_totals.live_bytes) << "\n";
+
+        ofs << "\n  allocation sites at the peak:\n";
+        for(const auto& sitr : itr.peak)
+            _write_site(sitr);
+
+        if(!itr.unfreed.empty())
+        {
+            ofs << "\n  allocation sites of the unfreed memory:\n";
+            for(const auto& sitr : itr.unfreed)
+                _write_site(sitr);
+        }
+        ofs << "\n";
+    }
+}
+
+void
+write_json(const summary_t& _data)
+{
+    namespace cereal = tim::cereal;
+
+    auto _save_sites = [](auto& ar, const char* _name,
+                          const std::vector<site_summary>& _sites) {
+        ar->setNextName(_name);
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _sites)
+        {
+            const auto& _v = itr.entry;
+            ar->startNode();
+            (*ar)(cereal::make_nvp("function", std::string{ _v.function }),
+                  cereal::make_nvp("frames", itr.frames),
+                  cereal::make_nvp("allocations", _v.allocations),
+                  cereal::make_nvp("allocated_bytes", _v.bytes),
+                  cereal::make_nvp("peak_bytes", _v.peak_bytes),
+                  cereal::make_nvp("live_allocations", _v.live_count),
+                  cereal::make_nvp("live_bytes", _v.live_bytes));
+            ar->finishNode();
+        }
+        ar->finishNode();
+    };
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("gpu_memory");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data)
+        {
+            const auto& _totals = itr.totals;
+            ar->startNode();
+            (*ar)(cereal::make_nvp("device", itr.device),
+                  cereal::make_nvp("allocations", _totals.allocations),
+                  cereal::make_nvp("allocated_bytes", _totals.bytes),
+                  cereal::make_nvp("peak_bytes", _totals.peak_bytes),
+                  cereal::make_nvp("peak_timestamp", _totals.peak_ts),
+                  cereal::make_nvp("live_allocations", _totals.live_count),
+                  cereal::make_nvp("live_bytes", _totals.live_bytes));
+            _save_sites(ar, "peak", itr.peak);
+            _save_sites(ar, "unfreed", itr.unfreed);
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("gpu-memory", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening gpu-memory output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname, std::string{ "gpu-memory" });
+
+    ofs << oss.str() << "\n";
+}
+
+void
+write_perfetto(const profile_data& _profile)
+{
+    using track = perfetto_counter_track<category::gpu_memory>;
+
+    if(!get_use_perfetto()) return;
+
+    const auto* _category = trait::name<category::gpu_memory>::value;
+    for(const auto& ditr : _profile.devices)
+    {
+        if(ditr.second.timeline.empty()) continue;
+
+        auto _idx = track::size(0);
+        track::emplace(0, JOIN(' ', "GPU Memory", get_device_name(ditr.first)), "MB");
+        for(const auto& itr : ditr.second.timeline)
+        {
+            TRACE_COUNTER(_category, track::at(0, _idx), itr.timestamp,
+                          as_megabytes(itr.peak));
+            if(itr.last_ts != itr.timestamp || itr.last != itr.peak)
+                TRACE_COUNTER(_category, track::at(0, _idx), itr.last_ts,
+                              as_megabytes(itr.last));
+        }
+    }
+}
+}  // namespace
+
+void
+record_allocation(int32_t _device, const void* _addr, size_t _size, const char* _func)
+{
+    if(_addr == nullptr || _size == 0 || !get_active().load(std::memory_order_relaxed))
+        return;
+
+    // the allocations are comparatively rare and expensive so every call is unwound
+    auto   _key = site_key{ _device, _func, {} };
+    size_t _n   = 0;
+    for(auto itr : tim::get_unw_stack_raw<stack_depth, ignore_depth>())
+    {
+        if(itr == 0 || _n == stack_depth) break;
+        _key.stack[_n++] = itr;
+    }
+
+    auto  _now     = tracing::now<uint64_t>();
+    auto  _alloc   = live_allocation{ nullptr, nullptr, _size };
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+
+    auto& _dev  = _profile.devices[_device];
+    auto  _site = _profile.sites.emplace(_key, site_entry{ _device, _func });
+    if(_site.second) _dev.sites.emplace_back(&_site.first->second);
+    _alloc.device = &_dev;
+    _alloc.site   = &_site.first->second;
+
+    // the previous allocation at the address was released by a function which is not
+    // tracked, e.g. hipFreeArray
+    auto _ret = _profile.live.emplace(reinterpret_cast<uintptr_t>(_addr), _alloc);
+    if(!_ret.second)
+    {
+        remove_live(_profile, _ret.first->second, _now);
+        _ret.first->second = _alloc;
+    }
+
+    auto& _totals = _dev.totals;
+    _alloc.site->allocations += 1;
+    _alloc.site->bytes += _size;
+    _alloc.site->live_count += 1;
+    _alloc.site->live_bytes += _size;
+    _totals.allocations += 1;
+    _totals.bytes += _size;
+    _totals.live_count += 1;
+    _totals.live_bytes += _size;
+    if(_device != host_device) _profile.live_bytes += _size;
+
+    if(_totals.live_bytes > _totals.peak_bytes)
+    {
+        _totals.peak_bytes = _totals.live_bytes;
+        _totals.peak_ts    = _now;
+        for(auto* itr : _dev.sites)
+            itr->peak_bytes = itr->live_bytes;
+    }
+
+    update_timeline(_dev, _now);
+    update_trace_triggers(_profile);
+}
+
+void
+record_free(const void* _addr)
+{
+    if(_addr == nullptr || !get_active().load(std::memory_order_relaxed)) return;
+
+    auto  _now     = tracing::now<uint64_t>();
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr      = _profile.live.find(reinterpret_cast<uintptr_t>(_addr));
+    if(itr == _profile.live.end()) return;
+
+    remove_live(_profile, itr->second, _now);
+    _profile.live.erase(itr);
+    update_trace_triggers(_profile);
+}
+
+void
+post_process()
+{
+    if(!config::get_gpu_memory_tracking()) return;
+
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+
+        auto& _profile = get_profile();
+        auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+        if(_profile.devices.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No HIP memory allocations were recorded\n");
+            return;
+        }
+
+        // the final values of the counter tracks
+        auto _now = tracing::now<uint64_t>();
+        for(auto& itr : _profile.devices)
+            itr.second.timeline.emplace_back(
+                timeline_point{ _now, itr.second.totals.live_bytes, _now,
+                                itr.second.totals.live_bytes });
+
+        try
+        {
+            auto _data = get_summary(_profile);
+            for(const auto& itr : _data)
+            {
+                if(itr.totals.live_count == 0) continue;
+                OMNITRACE_VERBOSE_F(0, "%s: %lu allocations (%.3f MB) were not freed\n",
+                                    get_device_name(itr.device).c_str(),
+                                    itr.totals.live_count,
+                                    as_megabytes(itr.totals.live_bytes));
+            }
+
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+            write_perfetto(_profile);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the GPU memory report failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace gpu_memory
+}  // namespace omnitrace
@@ -0,0 +1,60 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// exact accounting of the memory allocated through HIP (see
+/// OMNITRACE_GPU_MEMORY_TRACKING). The HIP API callback reports every allocation on
+/// exit, when the pointer is known, and every deallocation on entry. The live bytes are
+/// tracked per device and per allocation site, i.e. the device, the HIP function and
+/// the call-stack of the allocating call, which is unwound but only symbolized at
+/// finalization. When a device reaches a new peak, the live bytes of its sites are
+/// saved as the attribution of the peak. At finalization, the peak and its attribution
+/// and the allocations which were never freed are written to gpu-memory.{txt,json}
+/// along with one counter track of the live memory per device in perfetto
+namespace gpu_memory
+{
+/// the device of the pinned host allocations
+constexpr int32_t host_device = -1;
+
+/// records an allocation of _size bytes at _addr on the device by the HIP function
+/// _func. The name must have static storage duration
+void
+record_allocation(int32_t _device, const void* _addr, size_t _size, const char* _func);
+
+/// removes the allocation at _addr from the live memory. Ignores the addresses which
+/// were not allocated while the tracking was active
+void
+record_free(const void* _addr);
+
+/// stops the recording and writes the report and the counter tracks. Only the first
+/// invocation has an effect
+void
+post_process();
+}  // namespace gpu_memory
+}  // namespace omnitrace
@@ -0,0 +1,637 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/heap_profile.hpp"
+#include "binary/analysis.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/self_profile.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/backtrace.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace heap_profile
+{
+namespace
+{
+constexpr size_t stack_depth  = 32;
+constexpr size_t ignore_depth = 1;
+
+// the number of locks protecting the sampled allocations
+constexpr size_t num_shards = 16;
+
+// the number of counters of the sampled allocations per address hash which let the
+// deallocations of the allocations which were not sampled skip the locks
+constexpr size_t filter_size = (1 << 16);
+
+// the number of call-stacks in the output
+constexpr size_t max_output_stacks = 50;
+
+// the minimum interval between the points of the counter tracks
+constexpr uint64_t timeline_interval = 10 * units::msec;
+
+// zero-terminated
+using callstack_t = std::array<uintptr_t, stack_depth>;
+
+// the values estimated from the sampled allocations
+struct heap_entry
+{
+    uint64_t samples    = 0;
+    double   count      = 0.0;
+    double   bytes      = 0.0;
+    double   live_count = 0.0;
+    double   live_bytes = 0.0;
+
+    void add(double _count, double _bytes)
+    {
+        samples += 1;
+        count += _count;
+        bytes += _bytes;
+        live_count += _count;
+        live_bytes += _bytes;
+    }
+
+    void remove(double _count, double _bytes)
+    {
+        live_count -= _count;
+        live_bytes -= _bytes;
+    }
+
+    heap_entry& operator+=(const heap_entry& _rhs)
+    {
+        samples += _rhs.samples;
+        count += _rhs.count;
+        bytes += _rhs.bytes;
+        live_count += _rhs.live_count;
+        live_bytes += _rhs.live_bytes;
+        return *this;
+    }
+};
+
+// a sampled allocation which has not been freed
+struct sampled_allocation
+{
+    heap_entry* entry = nullptr;
+    double      count = 0.0;
+    double      bytes = 0.0;
+};
+
+struct shard
+{
+    std::mutex                                        mutex       = {};
+    std::unordered_map<uintptr_t, sampled_allocation> allocations = {};
+};
+
+struct timeline_point
+{
+    uint64_t timestamp = 0;
+    double   bytes     = 0.0;
+    double   live      = 0.0;
+};
+
+// the entries are never removed so the sampled allocations refer to them
+struct profile_data
+{
+    std::mutex                        mutex    = {};
+    heap_entry                        total    = {};
+    std::map<callstack_t, heap_entry> stacks   = {};
+    std::vector<timeline_point>       timeline = {};
+};
+
+// the bytes until the next sample and the state of the xorshift generator
+struct thread_sampler
+{
+    bool     seeded    = false;
+    int64_t  remaining = 0;
+    uint64_t rng       = 0;
+};
+
+struct function_entry
+{
+    heap_entry exclusive = {};
+    heap_entry inclusive = {};
+};
+
+using function_list_t = std::vector<std::pair<std::string, function_entry>>;
+using stack_list_t    = std::vector<std::pair<std::vector<std::string>, heap_entry>>;
+
+struct summary
+{
+    heap_entry      total     = {};
+    function_list_t functions = {};
+    stack_list_t    stacks    = {};
+};
+
+std::once_flag post_process_once{};
+
+// initial-exec for the same reason as the flag of scoped_guard
+thread_sampler&
+get_sampler()
+{
+    static thread_local thread_sampler _v OMNITRACE_ATTRIBUTE(
+        tls_model("initial-exec")) = {};
+    return _v;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the deallocations during the static destruction are safe
+auto&
+get_profile()
+{
+    static auto* _v = new profile_data{};
+    return *_v;
+}
+
+auto&
+get_shards()
+{
+    static auto* _v = new std::array<shard, num_shards>{};
+    return *_v;
+}
+
+auto&
+get_filter()
+{
+    static auto _v = std::array<std::atomic<uint32_t>, filter_size>{};
+    return _v;
+}
+
+size_t
+get_hash(uintptr_t _addr)
+{
+    return static_cast<size_t>((_addr * 0x9e3779b97f4a7c15ULL) >> 40);
+}
+
+// exponentially distributed with a mean of _interval
+int64_t
+get_next_interval(thread_sampler& _sampler, double _interval)
+{
+    auto& _x = _sampler.rng;
+    _x ^= _x >> 12;
+    _x ^= _x << 25;
+    _x ^= _x >> 27;
+    // uniform in [0, 1)
+    auto _u = static_cast<double>((_x * 0x2545f4914f6cdd1dULL) >> 11) * 0x1.0p-53;
+    return static_cast<int64_t>(-std::log1p(-_u) * _interval) + 1;
+}
+
+// requires the mutex of the profile
+void
+update_timeline(profile_data& _profile, uint64_t _now)
+{
+    auto& _timeline = _profile.timeline;
+    if(!_timeline.empty() && _now < _timeline.back().timestamp + timeline_interval)
+        return;
+    _timeline.emplace_back(
+        timeline_point{ _now, _profile.total.bytes, _profile.total.live_bytes });
+}
+
+void
+remove_live(const sampled_allocation& _record)
+{
+    auto& _profile = get_profile();
+    auto  _now     = tracing::now<uint64_t>();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _record.entry->remove(_record.count, _record.bytes);
+    _profile.total.remove(_record.count, _record.bytes);
+    update_timeline(_profile, _now);
+}
+
+void
+sample(thread_sampler& _sampler, uintptr_t _addr, size_t _size)
+{
+    const auto& _cfg      = config::get_snapshot();
+    auto        _interval = static_cast<double>(_cfg.heap_profile_sample_interval);
+
+    if(!_sampler.seeded)
+    {
+        // the first interval of the thread. The seed must be non-zero
+        auto _seed = static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+        _sampler.seeded    = true;
+        _sampler.rng       = (_seed ^ reinterpret_cast<uintptr_t>(&_sampler)) | 1;
+        _sampler.remaining = get_next_interval(_sampler, _interval);
+        _sampler.remaining -= static_cast<int64_t>(_size);
+        if(_sampler.remaining > 0) return;
+    }
+
+    // the intervals are memoryless so an allocation which spans several intervals is
+    // sampled once and the next interval starts after it
+    _sampler.remaining = get_next_interval(_sampler, _interval);
+
+    if(_addr == 0 || !get_active().load(std::memory_order_relaxed) ||
+       get_state() != State::Active || get_thread_state() != ThreadState::Enabled)
+        return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+
+    auto   _stack = callstack_t{};
+    size_t _n     = 0;
+    for(auto itr : tim::get_unw_stack_raw<stack_depth, ignore_depth>())
+    {
+        if(itr == 0 || _n == stack_depth) break;
+        _stack[_n++] = itr;
+    }
+
+    // the probability that the allocation was sampled
+    auto _prob  = -std::expm1(-static_cast<double>(_size) / _interval);
+    auto _count = (_prob > 0.0) ? (1.0 / _prob) : 1.0;
+    auto _bytes = _count * static_cast<double>(_size);
+    auto _now   = tracing::now<uint64_t>();
+
+    auto  _record  = sampled_allocation{ nullptr, _count, _bytes };
+    auto& _profile = get_profile();
+    {
+        auto _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+        _record.entry = &_profile.stacks[_stack];
+        _record.entry->add(_count, _bytes);
+        _profile.total.add(_count, _bytes);
+        update_timeline(_profile, _now);
+    }
+
+    auto  _hash  = get_hash(_addr);
+    auto& _shard = get_shards()[_hash % num_shards];
+    auto  _stale = std::optional<sampled_allocation>{};
+    {
+        auto _lk  = std::unique_lock<std::mutex>{ _shard.mutex };
+        auto _ret = _shard.allocations.emplace(_addr, _record);
+        // the previous allocation at the address was released by a function which is
+        // not wrapped, e.g. within a library loaded after the wrappers were installed
+        if(!_ret.second)
+        {
+            _stale             = _ret.first->second;
+            _ret.first->second = _record;
+        }
+    }
+
+    if(_stale)
+        remove_live(*_stale);
+    else
+        get_filter()[_hash % filter_size].fetch_add(1, std::memory_order_relaxed);
+}
+
+summary
+get_summary(const profile_data& _profile)
+{
+    auto _summary  = summary{};
+    _summary.total = _profile.total;
+
+    // the names of the addresses. The call-stacks have few distinct addresses
+    auto _names  = std::unordered_map<uintptr_t, std::string>{};
+    auto _lookup = [&_names](uintptr_t _addr) -> const std::string& {
+        auto itr = _names.find(_addr);
+        if(itr != _names.end()) return itr->second;
+
+        auto _name = std::string{};
+        if(auto _entry = binary::lookup_ipaddr_entry<true>(_addr); _entry)
+            _name = tim::demangle(_entry->name);
+        return (_names[_addr] = _name);
+    };
+
+    // the frames within omnitrace (the wrappers) are excluded by the lookup
+    auto _functions = std::unordered_map<std::string, function_entry>{};
+    auto _unique    = std::unordered_set<std::string>{};
+    auto _named     = std::map<std::vector<std::string>, heap_entry>{};
+    for(const auto& itr : _profile.stacks)
+    {
+        auto _frames = std::vector<std::string>{};
+        _unique.clear();
+        for(auto ditr : itr.first)
+        {
+            if(ditr == 0) break;
+
+            const auto& _name = _lookup(ditr);
+            if(_name.empty()) continue;
+
+            auto& _entry = _functions[_name];
+            if(_frames.empty()) _entry.exclusive += itr.second;
+            if(_unique.emplace(_name).second) _entry.inclusive += itr.second;
+            _frames.emplace_back(_name);
+        }
+        if(_frames.empty()) _frames.emplace_back("??");
+        _named[_frames] += itr.second;
+    }
+
+    _summary.functions.assign(_functions.begin(), _functions.end());
+    std::sort(_summary.functions.begin(), _summary.functions.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  if(_lhs.second.exclusive.bytes != _rhs.second.exclusive.bytes)
+                      return _lhs.second.exclusive.bytes > _rhs.second.exclusive.bytes;
+                  if(_lhs.second.inclusive.bytes != _rhs.second.inclusive.bytes)
+                      return _lhs.second.inclusive.bytes > _rhs.second.inclusive.bytes;
+                  return _lhs.first < _rhs.first;
+              });
+
+    _summary.stacks.assign(_named.begin(), _named.end());
+    std::stable_sort(_summary.stacks.begin(), _summary.stacks.end(),
+                     [](const auto& _lhs, const auto& _rhs) {
+                         return _lhs.second.bytes > _rhs.second.bytes;
+                     });
+    if(_summary.stacks.size() > max_output_stacks)
+        _summary.stacks.resize(max_output_stacks);
+
+    return _summary;
+}
+
+// the live values are differences of the estimates and may be slightly negative
+uint64_t
+as_count(double _v)
+{
+    return (_v > 0.0) ? static_cast<uint64_t>(std::llround(_v)) : 0;
+}
+
+double
+as_megabytes(double _v)
+{
+    return std::max<double>(_v, 0.0) / units::megabyte;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("heap-profile", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening heap-profile output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "heap-profile" });
+
+    const auto& _total = _data.total;
+    ofs << "sampled allocations: " << _total.samples
+        << ", sample interval (bytes): " << config::get_heap_profile_sample_interval()
+        << ", allocations: " << as_count(_total.count) << ", allocated (MB): "
+        << std::setprecision(3) << std::fixed << as_megabytes(_total.bytes)
+        << ", live allocations: " << as_count(_total.live_count)
+        << ", live (MB): " << as_megabytes(_total.live_bytes) << "\n";
+
+    ofs << "\n"
+        << std::setw(16) << "exclusive (MB)" << " | " << std::setw(16)
+        << "inclusive (MB)" << " | " << std::setw(12) << "allocations" << " | "
+        << std::setw(14) << "live (MB)" << " | function\n";
+    for(const auto& itr : _data.functions)
+    {
+        ofs << std::setw(16) << as_megabytes(itr.second.exclusive.bytes) << " | "
+            << std::setw(16) << as_megabytes(itr.second.inclusive.bytes) << " | "
+            << std::setw(12) << as_count(itr.second.inclusive.count) << " | "
+            << std::setw(14) << as_megabytes(itr.second.inclusive.live_bytes) << " | "
+            << itr.first << "\n";
+    }
+
+    for(const auto& itr : _data.stacks)
+    {
+        ofs << "\n"
+            << "allocated (MB): " << as_megabytes(itr.second.bytes)
+            << ", allocations: " << as_count(itr.second.count)
+            << ", live (MB): " << as_megabytes(itr.second.live_bytes)
+            << ", live allocations: " << as_count(itr.second.live_count)
+            << ", samples: " << itr.second.samples << "\n";
+        for(const auto& fitr : itr.first)
+            ofs << "    " << fitr << "\n";
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    auto _save = [](auto& ar, const heap_entry& _v) {
+        (*ar)(cereal::make_nvp("samples", _v.samples),
+              cereal::make_nvp("allocations", as_count(_v.count)),
+              cereal::make_nvp("allocated_bytes", as_count(_v.bytes)),
+              cereal::make_nvp("live_allocations", as_count(_v.live_count)),
+              cereal::make_nvp("live_bytes", as_count(_v.live_bytes)));
+    };
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("heap_profile");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("sample_interval",
+                               config::get_heap_profile_sample_interval()));
+        _save(ar, _data.total);
+
+        ar->setNextName("functions");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.functions)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("function", itr.first));
+            ar->setNextName("exclusive");
+            ar->startNode();
+            _save(ar, itr.second.exclusive);
+            ar->finishNode();
+            ar->setNextName("inclusive");
+            ar->startNode();
+            _save(ar, itr.second.inclusive);
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->setNextName("stacks");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.stacks)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("frames", itr.first));
+            _save(ar, itr.second);
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("heap-profile", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening heap-profile output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "heap-profile" });
+
+    ofs << oss.str() << "\n";
+}
+
+void
+write_perfetto(const std::vector<timeline_point>& _timeline)
+{
+    using track = perfetto_counter_track<category::heap_profile>;
+
+    if(!get_use_perfetto() || _timeline.empty()) return;
+
+    if(!track::exists(0))
+    {
+        track::emplace(0, "Heap Allocated Memory", "MB");
+        track::emplace(0, "Heap Live Memory", "MB");
+        track::emplace(0, "Heap Allocation Rate", "MB/s");
+    }
+
+    const auto* _category = trait::name<category::heap_profile>::value;
+    for(size_t i = 0; i < _timeline.size(); ++i)
+    {
+        const auto& itr = _timeline.at(i);
+        TRACE_COUNTER(_category, track::at(0, 0), itr.timestamp,
+                      as_megabytes(itr.bytes));
+        TRACE_COUNTER(_category, track::at(0, 1), itr.timestamp,
+                      as_megabytes(itr.live));
+        if(i == 0) continue;
+
+        // the rate over the interval since the previous point
+        const auto& _prev    = _timeline.at(i - 1);
+        auto        _elapsed = static_cast<double>(itr.timestamp - _prev.timestamp);
+        if(_elapsed <= 0.0) continue;
+        TRACE_COUNTER(_category, track::at(0, 2), _prev.timestamp,
+                      as_megabytes(itr.bytes - _prev.bytes) * units::sec / _elapsed);
+    }
+    TRACE_COUNTER(_category, track::at(0, 2), _timeline.back().timestamp, 0.0);
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return config::get_heap_profile() && get_active().load();
+}
+
+void
+record_allocation(void* _addr, size_t _size)
+{
+    auto& _sampler = get_sampler();
+    _sampler.remaining -= static_cast<int64_t>(_size);
+    if(OMNITRACE_LIKELY(_sampler.remaining > 0)) return;
+
+    sample(_sampler, reinterpret_cast<uintptr_t>(_addr), _size);
+}
+
+void
+record_free(void* _addr)
+{
+    if(_addr == nullptr) return;
+
+    auto  _hash   = get_hash(reinterpret_cast<uintptr_t>(_addr));
+    auto& _filter = get_filter()[_hash % filter_size];
+    if(OMNITRACE_LIKELY(_filter.load(std::memory_order_relaxed) == 0)) return;
+
+    auto  _record = std::optional<sampled_allocation>{};
+    auto& _shard  = get_shards()[_hash % num_shards];
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _shard.mutex };
+        auto itr = _shard.allocations.find(reinterpret_cast<uintptr_t>(_addr));
+        if(itr == _shard.allocations.end()) return;
+        _record = itr->second;
+        _shard.allocations.erase(itr);
+    }
+
+    _filter.fetch_sub(1, std::memory_order_relaxed);
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+    remove_live(*_record);
+}
+
+void
+post_process()
+{
+    if(!config::get_heap_profile()) return;
+
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+
+        auto& _profile = get_profile();
+        auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+        if(_profile.total.samples == 0)
+        {
+            OMNITRACE_VERBOSE_F(1, "No heap allocations were sampled\n");
+            return;
+        }
+
+        // the final values of the counter tracks
+        _profile.timeline.emplace_back(timeline_point{
+            tracing::now<uint64_t>(), _profile.total.bytes, _profile.total.live_bytes });
+
+        try
+        {
+            auto _data = get_summary(_profile);
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+            write_perfetto(_profile.timeline);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the heap profile failed: %s\n", _e.what());
+        }
+    });
+}
+}  // namespace heap_profile
+}  // namespace omnitrace
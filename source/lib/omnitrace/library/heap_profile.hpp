@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "common/defines.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// sampled heap profile (see OMNITRACE_HEAP_PROFILE). The malloc_gotcha wrappers report
+/// every allocation and deallocation but, like tcmalloc, only one allocation per
+/// OMNITRACE_HEAP_PROFILE_SAMPLE_INTERVAL bytes on average is sampled: the number of
+/// bytes until the next sample is drawn from an exponential distribution per thread so
+/// an allocation of S bytes is sampled with the probability P = 1 - exp(-S / interval)
+/// and represents S / P bytes and 1 / P allocations. The other allocations only
+/// decrement a thread-local counter. The call-stack of a sampled allocation is
+/// unwound and the allocation is tracked until it is freed, which provides the
+/// estimated allocated and live bytes per call-stack. They are symbolized and written
+/// to heap-profile.{txt,json} at finalization along with the counter tracks of the
+/// allocated and live bytes and the allocation rate in perfetto
+namespace heap_profile
+{
+/// marks the thread as inside a wrapper so the nested calls, e.g. the malloc within
+/// operator new and the allocations of the profile itself, are not recorded. The flag
+/// uses the initial-exec TLS model since the first access of a dynamically allocated
+/// TLS block calls malloc
+struct scoped_guard
+{
+    scoped_guard()
+    : m_nested{ get_flag() }
+    {
+        get_flag() = true;
+    }
+
+    ~scoped_guard() { get_flag() = m_nested; }
+
+    scoped_guard(const scoped_guard&) = delete;
+    scoped_guard& operator=(const scoped_guard&) = delete;
+
+    bool nested() const { return m_nested; }
+
+private:
+    static bool& get_flag()
+    {
+        static thread_local bool _v OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) =
+            false;
+        return _v;
+    }
+
+    bool m_nested = false;
+};
+
+/// check if the heap profile is enabled, i.e. the wrappers should be installed
+bool
+is_enabled();
+
+/// records an allocation of _size bytes at _addr. Almost always only decrements the
+/// number of bytes until the next sample of the thread
+void
+record_allocation(void* _addr, size_t _size);
+
+/// removes a sampled allocation from the live allocations
+void
+record_free(void* _addr);
+
+/// stops the recording and writes the profile and the counter tracks. Only the first
+/// invocation has an effect
+void
+post_process();
+}  // namespace heap_profile
+}  // namespace omnitrace
@@ -0,0 +1,324 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "library/hip_api_stacks.hpp"
+#include "binary/analysis.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/backtrace.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace hip_api_stacks
+{
+namespace
+{
+// the frames of roctracer, the HIP runtime and omnitrace precede the frames of the
+// application so the buffer is deeper than the output
+constexpr size_t stack_depth  = 32;
+constexpr size_t ignore_depth = 1;
+
+// the number of frames per call-stack in the output
+constexpr size_t max_output_frames = 16;
+
+// the number of unique call-stacks per thread
+constexpr size_t thread_capacity = 1024;
+
+// zero-terminated
+using callstack_t = std::array<uintptr_t, stack_depth>;
+
+// open-addressing table with linear probing. A slot is empty until its id is set,
+// which is stored after the call-stack, and the slots are never removed so only the
+// owning thread writes to it
+struct thread_table
+{
+    struct slot
+    {
+        std::atomic<uint64_t> id    = { 0 };
+        uint64_t              count = 0;
+        callstack_t           stack = {};
+    };
+
+    std::array<slot, thread_capacity> slots    = {};
+    uint64_t                          overflow = 0;
+};
+
+using thread_table_data = omnitrace::thread_data<thread_table, thread_table>;
+
+auto&
+get_thread_table(int64_t _tid = tim::threading::get_id())
+{
+    return thread_table_data::instance(construct_on_thread{ _tid });
+}
+
+struct stack_summary
+{
+    uint64_t                 id     = 0;
+    uint64_t                 count  = 0;
+    std::vector<std::string> frames = {};
+};
+
+using summary_t = std::vector<stack_summary>;
+
+std::once_flag post_process_once{};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+uint64_t
+get_hash(const callstack_t& _stack)
+{
+    uint64_t _v = 0xcbf29ce484222325ULL;
+    for(auto itr : _stack)
+    {
+        if(itr == 0) break;
+        _v = (_v ^ itr) * 0x9e3779b97f4a7c15ULL;
+        _v ^= (_v >> 29);
+    }
+    return (_v == 0) ? 1 : _v;
+}
+
+std::string
+get_frame(uintptr_t _addr)
+{
+    // the frames within omnitrace (the HIP API callback) are excluded by the lookup
+    auto _entry = binary::lookup_ipaddr_entry<true>(_addr);
+    if(!_entry) return std::string{};
+
+    auto _func = (_entry->name.empty()) ? std::string{ "??" }
+                                        : tim::demangle(_entry->name);
+    auto _loc  = (_entry->location.empty()) ? std::string{ "??" } : _entry->location;
+    auto _line = (_entry->lineno == 0) ? std::string{ "?" } : JOIN("", _entry->lineno);
+    return JOIN("", _func, " @ ", _loc, ":", _line);
+}
+
+summary_t
+get_summary(uint64_t& _overflow)
+{
+    // the count and the call-stack of every id
+    using merged_t = std::pair<uint64_t, const callstack_t*>;
+
+    auto _stacks = std::unordered_map<uint64_t, merged_t>{};
+    for(const auto& titr : *thread_table_data::get())
+    {
+        if(!titr) continue;
+        _overflow += titr->overflow;
+        for(const auto& itr : titr->slots)
+        {
+            auto _id = itr.id.load(std::memory_order_acquire);
+            if(_id == 0) continue;
+            auto& _v = _stacks[_id];
+            _v.first += itr.count;
+            _v.second = &itr.stack;
+        }
+    }
+
+    // the frames are symbolized once per address
+    auto _frames  = std::unordered_map<uintptr_t, std::string>{};
+    auto _summary = summary_t{};
+    _summary.reserve(_stacks.size());
+    for(const auto& itr : _stacks)
+    {
+        auto _v = stack_summary{ itr.first, itr.second.first, {} };
+        for(auto aitr : *itr.second.second)
+        {
+            if(aitr == 0 || _v.frames.size() == max_output_frames) break;
+            auto fitr = _frames.find(aitr);
+            if(fitr == _frames.end()) fitr = _frames.emplace(aitr, get_frame(aitr)).first;
+            if(!fitr->second.empty()) _v.frames.emplace_back(fitr->second);
+        }
+        _summary.emplace_back(std::move(_v));
+    }
+
+    std::sort(_summary.begin(), _summary.end(),
+              [](const stack_summary& _lhs, const stack_summary& _rhs) {
+                  return (_lhs.count == _rhs.count) ? (_lhs.id < _rhs.id)
+                                                    : (_lhs.count > _rhs.count);
+              });
+    return _summary;
+}
+
+void
+write_text(const summary_t& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("hip-api-stacks", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening hip-api-stacks output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname,
+                                                    std::string{ "hip-api-stacks" });
+
+    for(const auto& itr : _data)
+    {
+        ofs << "stack_id " << itr.id << ": calls: " << itr.count << "\n";
+        for(const auto& fitr : itr.frames)
+            ofs << "    " << fitr << "\n";
+        ofs << "\n";
+    }
+}
+
+void
+write_json(const summary_t& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("hip_api_stacks");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("stack_id", itr.id),
+                  cereal::make_nvp("calls", itr.count),
+                  cereal::make_nvp("frames", itr.frames));
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("hip-api-stacks", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening hip-api-stacks output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname,
+                                                    std::string{ "hip-api-stacks" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+uint64_t
+capture()
+{
+    auto   _stack = callstack_t{};
+    size_t _n     = 0;
+    for(auto itr : tim::get_unw_stack_raw<stack_depth, ignore_depth>())
+    {
+        if(itr == 0 || _n == stack_depth) break;
+        _stack[_n++] = itr;
+    }
+
+    auto _id = get_hash(_stack);
+    if(!get_active().load(std::memory_order_relaxed)) return _id;
+
+    auto& _v = get_thread_table();
+    if(!_v) _v = std::make_unique<thread_table>();
+
+    auto _idx = static_cast<size_t>(_id % thread_capacity);
+    for(size_t i = 0; i < thread_capacity; ++i)
+    {
+        auto& _slot = _v->slots[(_idx + i) % thread_capacity];
+        auto  _sid  = _slot.id.load(std::memory_order_relaxed);
+        if(_sid == 0)
+        {
+            _slot.stack = _stack;
+            _slot.count = 1;
+            _slot.id.store(_id, std::memory_order_release);
+            return _id;
+        }
+        if(_sid == _id)
+        {
+            _slot.count += 1;
+            return _id;
+        }
+    }
+
+    _v->overflow += 1;
+    return _id;
+}
+
+void
+post_process()
+{
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+        if(!thread_table_data::get()) return;
+
+        uint64_t _overflow = 0;
+        auto     _data     = get_summary(_overflow);
+        if(_data.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No HIP API call-stacks were recorded\n");
+            return;
+        }
+
+        OMNITRACE_WARNING_IF_F(_overflow > 0,
+                               "%lu HIP API calls exceeded the capacity of %zu unique "
+                               "call-stacks per thread and are not in the report\n",
+                               _overflow, thread_capacity);
+
+        try
+        {
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the HIP API call-stacks failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace hip_api_stacks
+}  // namespace omnitrace
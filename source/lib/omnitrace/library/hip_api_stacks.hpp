@@ -0,0 +1,46 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// the host call-stacks of the HIP API calls (see OMNITRACE_ROCTRACER_HIP_API_BACKTRACE).
+/// The call-stack of a call is unwound into a fixed buffer without symbolizing it and
+/// is identified by a hash of its instruction pointers. Every thread keeps the unique
+/// call-stacks it captured in its own table so the capture does not lock. The perfetto
+/// slices of the HIP API calls and of their kernel dispatches are annotated with the
+/// stack id and, at finalization, every unique call-stack is symbolized once and
+/// written with its id to hip-api-stacks.{txt,json}
+namespace hip_api_stacks
+{
+/// unwinds the call-stack of the calling thread and returns its id (never zero)
+uint64_t
+capture();
+
+/// writes the symbolized call-stacks. Only the first invocation has an effect
+void
+post_process();
+}  // namespace hip_api_stacks
+}  // namespace omnitrace
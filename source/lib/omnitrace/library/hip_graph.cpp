@@ -0,0 +1,463 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/hip_graph.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace hip_graph
+{
+namespace
+{
+using kernel_list_t = std::vector<const char*>;
+
+struct node_entry
+{
+    const char* kernel = nullptr;
+    uint64_t    count  = 0;
+    uint64_t    total  = 0;
+    uint64_t    min    = std::numeric_limits<uint64_t>::max();
+    uint64_t    max    = 0;
+};
+
+struct graph_entry
+{
+    uint64_t      id      = 0;
+    kernel_list_t kernels = {};
+};
+
+// the executable graph, i.e. the graph instance which is launched
+struct exec_entry
+{
+    uint64_t                id         = 0;
+    uint64_t                graph      = 0;
+    uint64_t                launches   = 0;
+    uint64_t                incomplete = 0;  // launches with missing device operations
+    uint64_t                host_ns    = 0;  // entry to exit of hipGraphLaunch
+    uint64_t                latency_ns = 0;  // entry of hipGraphLaunch to the first node
+    uint64_t                span_ns    = 0;  // begin of the first to end of the last node
+    std::vector<node_entry> nodes      = {};
+};
+
+struct launch_entry
+{
+    exec_entry* exec  = nullptr;
+    uint64_t    enter = 0;
+    uint64_t    exit  = 0;
+    uint64_t    beg   = std::numeric_limits<uint64_t>::max();
+    uint64_t    end   = 0;
+    size_t      next  = 0;  // the next node to assign
+};
+
+struct profile_data
+{
+    std::mutex                                   mutex    = {};
+    uint64_t                                     graph_id = 0;
+    std::unordered_map<uintptr_t, graph_entry>   graphs   = {};
+    std::unordered_map<uintptr_t, kernel_list_t> captures = {};
+    std::unordered_map<uintptr_t, exec_entry*>   execs    = {};
+    // the executable graphs in the order they were instantiated, incl. the ones whose
+    // address was reused by a later instantiation
+    std::vector<std::unique_ptr<exec_entry>> instances = {};
+    // ordered by correlation id so the first entry is the oldest launch
+    std::map<uint64_t, launch_entry> pending = {};
+};
+
+using summary_t = std::vector<const exec_entry*>;
+
+std::once_flag post_process_once{};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the callbacks during the static destruction are safe
+auto&
+get_profile()
+{
+    static auto* _v = new profile_data{};
+    return *_v;
+}
+
+auto
+as_key(const void* _v)
+{
+    return reinterpret_cast<uintptr_t>(_v);
+}
+
+double
+as_usec(uint64_t _v, uint64_t _n = 1)
+{
+    return (_n == 0) ? 0.0
+                     : static_cast<double>(_v) / units::usec / static_cast<double>(_n);
+}
+
+void
+finalize(launch_entry& _launch)
+{
+    auto& _exec = *_launch.exec;
+    _exec.launches += 1;
+    if(_launch.exit > _launch.enter) _exec.host_ns += _launch.exit - _launch.enter;
+    if(_launch.next < _exec.nodes.size()) _exec.incomplete += 1;
+    if(_launch.next == 0) return;
+    if(_launch.beg > _launch.enter) _exec.latency_ns += _launch.beg - _launch.enter;
+    if(_launch.end > _launch.beg) _exec.span_ns += _launch.end - _launch.beg;
+}
+
+bool
+is_complete(const launch_entry& _launch)
+{
+    return _launch.exit > 0 && _launch.next == _launch.exec->nodes.size();
+}
+
+std::string
+get_kernel_name(const char* _kernel)
+{
+    return (_kernel == nullptr) ? std::string{ "<unknown>" } : tim::demangle(_kernel);
+}
+
+void
+write_text(const summary_t& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("hip-graphs", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening hip-graphs output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname, std::string{ "hip-graphs" });
+
+    ofs << std::setprecision(3) << std::fixed;
+    for(const auto* itr : _data)
+    {
+        auto _n = itr->launches;
+        ofs << "graph instance " << itr->id << " (graph " << itr->graph
+            << "): kernel nodes: " << itr->nodes.size() << ", launches: " << _n
+            << ", incomplete launches: " << itr->incomplete
+            << ", avg host launch (usec): " << as_usec(itr->host_ns, _n)
+            << ", avg launch latency (usec): " << as_usec(itr->latency_ns, _n)
+            << ", avg span (usec): " << as_usec(itr->span_ns, _n) << "\n";
+
+        for(size_t i = 0; i < itr->nodes.size(); ++i)
+        {
+            const auto& _node = itr->nodes.at(i);
+            ofs << "    node " << std::setw(3) << i << ": count: " << _node.count
+                << ", total (usec): " << as_usec(_node.total)
+                << ", avg (usec): " << as_usec(_node.total, _node.count);
+            if(_node.count > 0)
+                ofs << ", min (usec): " << as_usec(_node.min)
+                    << ", max (usec): " << as_usec(_node.max);
+            ofs << ", kernel: " << get_kernel_name(_node.kernel) << "\n";
+        }
+        ofs << "\n";
+    }
+}
+
+void
+write_json(const summary_t& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("hip_graphs");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto* itr : _data)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("instance", itr->id),
+                  cereal::make_nvp("graph", itr->graph),
+                  cereal::make_nvp("launches", itr->launches),
+                  cereal::make_nvp("incomplete_launches", itr->incomplete),
+                  cereal::make_nvp("host_launch_ns", itr->host_ns),
+                  cereal::make_nvp("launch_latency_ns", itr->latency_ns),
+                  cereal::make_nvp("span_ns", itr->span_ns));
+            ar->setNextName("nodes");
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& nitr : itr->nodes)
+            {
+                auto _empty = (nitr.count == 0);
+                ar->startNode();
+                (*ar)(cereal::make_nvp("kernel", get_kernel_name(nitr.kernel)),
+                      cereal::make_nvp("count", nitr.count),
+                      cereal::make_nvp("total_ns", nitr.total),
+                      cereal::make_nvp("min_ns", (_empty) ? uint64_t{ 0 } : nitr.min),
+                      cereal::make_nvp("max_ns", nitr.max));
+                ar->finishNode();
+            }
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("hip-graphs", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening hip-graphs output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname, std::string{ "hip-graphs" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+begin_capture(const void* _stream)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _profile.captures[as_key(_stream)].clear();
+}
+
+void
+end_capture(const void* _stream, const void* _graph)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr      = _profile.captures.find(as_key(_stream));
+    if(itr == _profile.captures.end()) return;
+
+    if(_graph != nullptr)
+        _profile.graphs[as_key(_graph)] =
+            graph_entry{ ++_profile.graph_id, std::move(itr->second) };
+    _profile.captures.erase(itr);
+}
+
+bool
+capture_launch(const void* _stream, const char* _kernel)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return false;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr      = _profile.captures.find(as_key(_stream));
+    if(itr == _profile.captures.end()) return false;
+
+    itr->second.emplace_back(_kernel);
+    return true;
+}
+
+void
+create_graph(const void* _graph)
+{
+    if(_graph == nullptr || !get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _profile.graphs[as_key(_graph)] = graph_entry{ ++_profile.graph_id, {} };
+}
+
+void
+add_kernel_node(const void* _graph, const void* _node, const char* _kernel)
+{
+    if(_graph == nullptr || _node == nullptr ||
+       !get_active().load(std::memory_order_relaxed))
+        return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto& _entry   = _profile.graphs[as_key(_graph)];
+    // the graph was created before the tracking started
+    if(_entry.id == 0) _entry.id = ++_profile.graph_id;
+    _entry.kernels.emplace_back(_kernel);
+}
+
+void
+instantiate(const void* _exec, const void* _graph)
+{
+    if(_exec == nullptr || !get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr      = _profile.graphs.find(as_key(_graph));
+    if(itr == _profile.graphs.end()) return;
+
+    auto _instance   = std::make_unique<exec_entry>();
+    _instance->id    = _profile.instances.size() + 1;
+    _instance->graph = itr->second.id;
+    for(const auto* kitr : itr->second.kernels)
+        _instance->nodes.emplace_back(node_entry{ kitr });
+
+    // the previous executable graph at the address was destroyed
+    _profile.execs[as_key(_exec)] = _instance.get();
+    _profile.instances.emplace_back(std::move(_instance));
+}
+
+void
+launch_begin(uint64_t _corr_id, const void* _exec, uint64_t _ts)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr      = _profile.execs.find(as_key(_exec));
+    if(itr == _profile.execs.end()) return;
+
+    auto _launch  = launch_entry{};
+    _launch.exec  = itr->second;
+    _launch.enter = _ts;
+    _profile.pending.emplace(_corr_id, _launch);
+}
+
+void
+launch_end(uint64_t _corr_id, uint64_t _ts)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr      = _profile.pending.find(_corr_id);
+    if(itr == _profile.pending.end()) return;
+
+    itr->second.exit = std::max<uint64_t>(_ts, 1);
+    if(is_complete(itr->second))
+    {
+        finalize(itr->second);
+        _profile.pending.erase(itr);
+    }
+}
+
+const char*
+device_op(uint64_t _corr_id, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return nullptr;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    if(_profile.pending.empty()) return nullptr;
+
+    auto _has_next = [](const auto& _v) {
+        return _v.second.next < _v.second.exec->nodes.size();
+    };
+
+    // the nodes are dispatched with the correlation id of the hipGraphLaunch by the
+    // versions of the runtime which propagate it and with an unrelated one otherwise
+    auto itr = _profile.pending.find(_corr_id);
+    if(itr == _profile.pending.end() || !_has_next(*itr))
+        itr = std::find_if(_profile.pending.begin(), _profile.pending.end(), _has_next);
+    if(itr == _profile.pending.end()) return nullptr;
+
+    auto& _launch = itr->second;
+    auto& _node   = _launch.exec->nodes.at(_launch.next++);
+    auto  _ns     = (_end_ns > _beg_ns) ? (_end_ns - _beg_ns) : 0;
+    _node.count += 1;
+    _node.total += _ns;
+    _node.min   = std::min(_node.min, _ns);
+    _node.max   = std::max(_node.max, _ns);
+    _launch.beg = std::min(_launch.beg, _beg_ns);
+    _launch.end = std::max(_launch.end, _end_ns);
+
+    const auto* _kernel = _node.kernel;
+    if(is_complete(_launch))
+    {
+        finalize(_launch);
+        _profile.pending.erase(itr);
+    }
+    return _kernel;
+}
+
+void
+post_process()
+{
+    if(!config::get_hip_graphs()) return;
+
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+
+        auto& _profile = get_profile();
+        auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+
+        // the launches whose device operations were not all received
+        for(auto& itr : _profile.pending)
+            finalize(itr.second);
+        _profile.pending.clear();
+
+        auto _data = summary_t{};
+        for(const auto& itr : _profile.instances)
+            if(itr->launches > 0) _data.emplace_back(itr.get());
+
+        if(_data.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No HIP graph launches were recorded\n");
+            return;
+        }
+
+        try
+        {
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the HIP graph report failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace hip_graph
+}  // namespace omnitrace
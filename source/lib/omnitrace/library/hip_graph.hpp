@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// the kernels of the HIP graphs (see OMNITRACE_HIP_GRAPHS). The kernel nodes of a
+/// graph are recorded as the graph is built, either explicitly or by capturing the
+/// kernels launched on a stream, and copied into the executable graph when it is
+/// instantiated. The device operations of a hipGraphLaunch do not correspond to a
+/// kernel launch on the host so they are assigned to the nodes of the launched graph
+/// in the order in which the nodes were added, which names the kernels and attributes
+/// them to the node. At finalization, the launches, the host time of the launch API,
+/// the latency and the span of the launches and the timings of every node are written
+/// per executable graph to hip-graphs.{txt,json}
+namespace hip_graph
+{
+/// the kernel names passed to these functions must have static storage duration.
+/// The handles are opaque and only used as keys
+
+/// starts the capture of the kernels launched on the stream
+void
+begin_capture(const void* _stream);
+
+/// ends the capture of the stream into the graph
+void
+end_capture(const void* _stream, const void* _graph);
+
+/// adds the kernel to the graph which is being captured on the stream. Returns false
+/// if the stream is not being captured, i.e. the kernel is launched
+bool
+capture_launch(const void* _stream, const char* _kernel);
+
+/// creates an empty graph (hipGraphCreate)
+void
+create_graph(const void* _graph);
+
+/// adds a kernel node to the graph (hipGraphAddKernelNode)
+void
+add_kernel_node(const void* _graph, const void* _node, const char* _kernel);
+
+/// instantiates the graph into the executable graph. The kernel nodes of the graph
+/// are copied so the later changes to the graph do not affect the executable graph
+void
+instantiate(const void* _exec, const void* _graph);
+
+/// the host entry and exit of a hipGraphLaunch with the correlation id
+void
+launch_begin(uint64_t _corr_id, const void* _exec, uint64_t _ts);
+
+void
+launch_end(uint64_t _corr_id, uint64_t _ts);
+
+/// assigns a kernel dispatch without a kernel launch on the host to the next node of
+/// the pending launch with the correlation id or, if not found, the oldest pending
+/// launch. Returns the name of the kernel of the node or nullptr if the dispatch is
+/// not part of a graph launch
+const char*
+device_op(uint64_t _corr_id, uint64_t _beg_ns, uint64_t _end_ns);
+
+/// stops the recording and writes the report. Only the first invocation has an
+/// effect
+void
+post_process();
+}  // namespace hip_graph
+}  // namespace omnitrace
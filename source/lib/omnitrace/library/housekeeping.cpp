@@ -0,0 +1,212 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/housekeeping.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/utility.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/utility/join.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <set>
+#include <string>
+#include <sys/resource.h>
+
+namespace omnitrace
+{
+namespace housekeeping
+{
+namespace
+{
+namespace join = ::timemory::join;
+
+std::string
+to_string(const std::set<int64_t>& _cpus)
+{
+    return join::join(join::array_config{ ",", "", "" }, _cpus);
+}
+
+std::string
+read_line(const std::string& _path)
+{
+    auto _ifs = std::ifstream{ _path };
+    auto _v   = std::string{};
+    if(_ifs) std::getline(_ifs, _v);
+    return _v;
+}
+
+std::set<int64_t>
+get_cpu_list(const std::string& _path)
+{
+    auto _v = read_line(_path);
+    if(_v.empty()) return std::set<int64_t>{};
+    return utility::parse_numeric_range<>(_v, "CPUs", 1L);
+}
+
+std::set<int64_t>
+get_topology_cpus(int64_t _cpu, const char* _entry)
+{
+    return get_cpu_list(JOIN("", "/sys/devices/system/cpu/cpu", _cpu, "/", _entry));
+}
+
+std::set<int64_t>
+get_affinity()
+{
+    auto _v   = std::set<int64_t>{};
+    auto _set = cpu_set_t{};
+    CPU_ZERO(&_set);
+    if(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &_set) != 0) return _v;
+    for(int64_t i = 0; i < CPU_SETSIZE; ++i)
+    {
+        if(CPU_ISSET(i, &_set)) _v.emplace(i);
+    }
+    return _v;
+}
+
+// the hardware threads of the cores of the process which are not the first
+// hardware thread of the core. These may be outside of the affinity of the process
+// when the ranks are only bound to the first hardware thread of each core
+std::set<int64_t>
+get_smt_cpus(const std::set<int64_t>& _process)
+{
+    auto _v = std::set<int64_t>{};
+    for(auto itr : _process)
+    {
+        auto _core = get_topology_cpus(itr, "topology/thread_siblings_list");
+        if(_core.size() < 2) continue;
+        _v.insert(std::next(_core.begin()), _core.end());
+    }
+    return _v;
+}
+
+// the first CPU of the process in each L3 cache domain
+std::set<int64_t>
+get_l3_cpus(const std::set<int64_t>& _process)
+{
+    auto _v    = std::set<int64_t>{};
+    auto _seen = std::set<int64_t>{};
+    for(auto itr : _process)
+    {
+        auto _domain = get_topology_cpus(itr, "cache/index3/shared_cpu_list");
+        if(_domain.empty()) continue;
+        if(_seen.emplace(*_domain.begin()).second) _v.emplace(itr);
+    }
+    return _v;
+}
+}  // namespace
+
+const std::set<int64_t>&
+get_cpus()
+{
+    // evaluated by the first background thread, which inherited the affinity of the
+    // application thread which created it
+    static auto _v = []() {
+        auto _spec = config::get_background_cpus();
+        if(_spec.empty() || _spec == "none") return std::set<int64_t>{};
+
+        auto _cpus = std::set<int64_t>{};
+        if(_spec == "smt")
+            _cpus = get_smt_cpus(get_affinity());
+        else if(_spec == "l3")
+            _cpus = get_l3_cpus(get_affinity());
+        else
+            _cpus = utility::parse_numeric_range<>(_spec, "CPUs", 1L);
+
+        if(_cpus.empty())
+        {
+            OMNITRACE_VERBOSE_F(0,
+                                "OMNITRACE_BACKGROUND_CPUS=%s did not select any CPUs. "
+                                "The background threads will not be pinned...\n",
+                                _spec.c_str());
+        }
+        else
+        {
+            OMNITRACE_VERBOSE_F(1, "Pinning the background threads to CPUs %s...\n",
+                                to_string(_cpus).c_str());
+        }
+        return _cpus;
+    }();
+    return _v;
+}
+
+void
+configure_thread()
+{
+    static thread_local bool _once = false;
+    if(_once) return;
+    _once = true;
+
+    const auto& _cpus = get_cpus();
+    if(!_cpus.empty())
+    {
+        // prefer the CPUs which overlap the inherited affinity
+        auto _inherited = get_affinity();
+        auto _overlap   = std::set<int64_t>{};
+        for(auto itr : _cpus)
+        {
+            if(_inherited.count(itr) > 0) _overlap.emplace(itr);
+        }
+
+        auto _set = cpu_set_t{};
+        CPU_ZERO(&_set);
+        for(auto itr : (_overlap.empty()) ? _cpus : _overlap)
+        {
+            if(itr >= 0 && itr < CPU_SETSIZE) CPU_SET(itr, &_set);
+        }
+
+        auto _ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &_set);
+        if(_ret != 0)
+        {
+            OMNITRACE_VERBOSE_F(1,
+                                "Pinning background thread %li to CPUs %s failed: %s\n",
+                                threading::get_sys_tid(), to_string(_cpus).c_str(),
+                                strerror(_ret));
+        }
+    }
+
+    auto _nice = config::get_background_nice();
+    if(_nice != 0)
+    {
+        // the linux priority of a thread is set via its thread-id
+        auto _tid = static_cast<id_t>(threading::get_sys_tid());
+        errno     = 0;
+        auto _cur = getpriority(PRIO_PROCESS, _tid);
+        if(errno == 0 && setpriority(PRIO_PROCESS, _tid, _cur + _nice) != 0)
+        {
+            OMNITRACE_VERBOSE_F(1,
+                                "Changing the priority of background thread %li failed: "
+                                "%s\n",
+                                threading::get_sys_tid(), strerror(errno));
+        }
+    }
+}
+}  // namespace housekeeping
+}  // namespace omnitrace
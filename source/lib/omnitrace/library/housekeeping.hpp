@@ -0,0 +1,49 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <set>
+
+namespace omnitrace
+{
+/// placement of the background threads of omnitrace (see OMNITRACE_BACKGROUND_CPUS
+/// and OMNITRACE_BACKGROUND_NICE). The helper threads are pinned to a housekeeping
+/// set of CPUs (e.g. the SMT siblings of the cores of an MPI rank) and run at a lower
+/// priority so they do not preempt the application threads on the cores the ranks
+/// are bound to
+namespace housekeeping
+{
+/// the CPUs of OMNITRACE_BACKGROUND_CPUS. Empty when the affinity is unchanged
+const std::set<int64_t>&
+get_cpus();
+
+/// pins the calling thread to the CPUs and lowers its priority. Called at the start
+/// of every background thread. When the CPUs overlap the affinity the thread
+/// inherited (e.g. the NUMA node of the sampler allocator), only the overlap is used.
+/// Only the first invocation on a thread has an effect
+void
+configure_thread();
+}  // namespace housekeeping
+}  // namespace omnitrace
@@ -0,0 +1,618 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/io_trace.hpp"
+#include "core/categories.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/containers/log2_buckets.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/self_profile.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace io_trace
+{
+namespace
+{
+constexpr auto operation_names =
+    std::array<const char*, num_operations>{ "read", "write", "open", "close", "sync" };
+
+using buckets_t = container::log2_buckets<40>;
+
+// the file descriptors below this value are mapped to the files without locking
+constexpr size_t max_fds = (1 << 16);
+
+// the number of files and operations per thread
+constexpr size_t thread_capacity = 128;
+
+// the interval of the throughput in the counter tracks
+constexpr uint64_t throughput_interval = 10 * units::msec;
+
+struct entry
+{
+    uint64_t                          count     = 0;
+    uint64_t                          errors    = 0;
+    uint64_t                          bytes     = 0;
+    uint64_t                          time      = 0;  // nanoseconds
+    uint64_t                          max       = 0;  // nanoseconds
+    buckets_t::array_type             sizes     = {};
+    buckets_t::array_type             latencies = {};
+
+    void add(int64_t _ret, uint64_t _time, bool _sized)
+    {
+        count += 1;
+        time += _time;
+        max = std::max(max, _time);
+        buckets_t::add(latencies, _time);
+        if(_ret < 0)
+        {
+            errors += 1;
+            return;
+        }
+        if(!_sized) return;
+        bytes += static_cast<uint64_t>(_ret);
+        buckets_t::add(sizes, static_cast<uint64_t>(_ret));
+    }
+
+    entry& operator+=(const entry& _rhs)
+    {
+        count += _rhs.count;
+        errors += _rhs.errors;
+        bytes += _rhs.bytes;
+        time += _rhs.time;
+        max = std::max(max, _rhs.max);
+        buckets_t::merge(sizes, _rhs.sizes);
+        buckets_t::merge(latencies, _rhs.latencies);
+        return *this;
+    }
+};
+
+// the paths are interned once per file and never removed so the ids remain valid.
+// The file descriptors are mapped to the ids with atomics so the lookups of the
+// wrappers do not lock. Id zero is an unknown file
+struct file_table
+{
+    std::mutex                                 mutex = {};
+    std::deque<std::string>                    names = { std::string{ "??" } };
+    std::unordered_map<std::string, uint32_t>  ids   = {};
+    std::array<std::atomic<uint32_t>, max_fds> fds   = {};
+};
+
+// intentionally leaked so the I/O during the static destruction is safe
+file_table&
+get_file_table()
+{
+    static auto* _v = new file_table{};
+    return *_v;
+}
+
+uint32_t
+intern(const std::string& _path)
+{
+    auto& _v  = get_file_table();
+    auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+    auto  itr = _v.ids.find(_path);
+    if(itr != _v.ids.end()) return itr->second;
+
+    auto _id = static_cast<uint32_t>(_v.names.size());
+    _v.names.emplace_back(_path);
+    _v.ids.emplace(_path, _id);
+    return _id;
+}
+
+std::string
+get_file_name(uint32_t _id)
+{
+    auto& _v  = get_file_table();
+    auto  _lk = std::unique_lock<std::mutex>{ _v.mutex };
+    return (_id < _v.names.size()) ? _v.names.at(_id) : _v.names.front();
+}
+
+// the file descriptors which were not opened through the wrappers (e.g. stdout or the
+// files opened before the wrappers were installed) are resolved through procfs
+uint32_t
+resolve(int _fd)
+{
+    auto _link = std::array<char, 4096>{};
+    auto _path = JOIN("", "/proc/self/fd/", _fd);
+    auto _n    = ::readlink(_path.c_str(), _link.data(), _link.size() - 1);
+    if(_n <= 0) return intern(JOIN("", "fd ", _fd));
+    return intern(std::string{ _link.data(), static_cast<size_t>(_n) });
+}
+
+uint32_t
+get_file(int _fd)
+{
+    if(_fd < 0) return 0;
+    if(static_cast<size_t>(_fd) >= max_fds) return resolve(_fd);
+
+    auto& _slot = get_file_table().fds[_fd];
+    auto  _id   = _slot.load(std::memory_order_acquire);
+    if(_id != 0) return _id;
+
+    _id = resolve(_fd);
+    _slot.store(_id, std::memory_order_release);
+    return _id;
+}
+
+struct throughput_entry
+{
+    uint64_t interval = 0;  // index of the throughput interval
+    uint64_t read     = 0;
+    uint64_t written  = 0;
+};
+
+// open-addressing table with linear probing. A slot is empty until its count is
+// non-zero and the slots are never removed so only the owning thread writes to it
+struct thread_table
+{
+    struct slot
+    {
+        uint32_t  file = 0;
+        operation op   = read_operation;
+        entry     data = {};
+    };
+
+    std::array<slot, thread_capacity> slots      = {};
+    entry                             overflow   = {};
+    std::vector<throughput_entry>     throughput = {};
+};
+
+using thread_table_data = omnitrace::thread_data<thread_table, thread_table>;
+
+auto&
+get_thread_table(int64_t _tid = tim::threading::get_id())
+{
+    return thread_table_data::instance(construct_on_thread{ _tid });
+}
+
+size_t
+get_slot(uint32_t _file, operation _op)
+{
+    auto _v = ((static_cast<uint64_t>(_file) << 3) | _op) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<size_t>(_v >> 40) % thread_capacity;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+auto post_process_once = std::once_flag{};
+
+// file id, operation
+using merged_key  = std::pair<uint32_t, operation>;
+using merged_data = std::map<merged_key, entry>;
+
+struct summary
+{
+    merged_data                               entries    = {};
+    std::array<entry, num_operations>         operations = {};
+    entry                                     overflow   = {};
+    std::map<uint64_t, throughput_entry>      throughput = {};
+    std::unordered_map<uint32_t, std::string> names      = {};
+};
+
+summary
+get_summary()
+{
+    auto _data = summary{};
+    if(!thread_table_data::get()) return _data;
+
+    for(const auto& titr : *thread_table_data::get())
+    {
+        if(!titr) continue;
+        for(const auto& itr : titr->slots)
+        {
+            if(itr.data.count == 0) continue;
+            _data.entries[merged_key{ itr.file, itr.op }] += itr.data;
+            _data.operations.at(itr.op) += itr.data;
+        }
+        _data.overflow += titr->overflow;
+        for(const auto& itr : titr->throughput)
+        {
+            auto& _v    = _data.throughput[itr.interval];
+            _v.interval = itr.interval;
+            _v.read += itr.read;
+            _v.written += itr.written;
+        }
+    }
+
+    for(const auto& itr : _data.entries)
+    {
+        if(_data.names.count(itr.first.first) == 0)
+            _data.names.emplace(itr.first.first, get_file_name(itr.first.first));
+    }
+    return _data;
+}
+
+// sorted by the total time in descending order
+std::vector<std::pair<merged_key, entry>>
+get_sorted(const merged_data& _data)
+{
+    auto _v = std::vector<std::pair<merged_key, entry>>{ _data.begin(), _data.end() };
+    std::sort(_v.begin(), _v.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.time > _rhs.second.time;
+    });
+    return _v;
+}
+
+double
+as_megabytes(uint64_t _v)
+{
+    return static_cast<double>(_v) / static_cast<double>(units::megabyte);
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("io-trace", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening io-trace output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "io-trace" });
+
+    auto _write_header = [&ofs]() {
+        ofs << std::setw(6) << "op" << " | " << std::setw(10) << "count" << " | "
+            << std::setw(8) << "errors" << " | " << std::setw(12) << "bytes (MB)"
+            << " | " << std::setw(12) << "time (msec)" << " | " << std::setw(12)
+            << "mean (usec)" << " | " << std::setw(12) << "max (usec)" << " | "
+            << std::setw(10) << "MB/s";
+    };
+
+    auto _write_entry = [&ofs](operation _op, const entry& _v) {
+        auto _time = static_cast<double>(_v.time);
+        ofs << std::setw(6) << operation_names.at(_op) << " | " << std::setw(10)
+            << _v.count << " | " << std::setw(8) << _v.errors << " | " << std::setw(12)
+            << as_megabytes(_v.bytes) << " | " << std::setw(12) << (_time / units::msec)
+            << " | " << std::setw(12)
+            << (_time / std::max<uint64_t>(_v.count, 1) / units::usec) << " | "
+            << std::setw(12) << (static_cast<double>(_v.max) / units::usec) << " | "
+            << std::setw(10)
+            << ((_v.time > 0) ? (as_megabytes(_v.bytes) * units::sec / _time) : 0.0);
+    };
+
+    ofs << std::setprecision(3) << std::fixed;
+
+    _write_header();
+    ofs << "\n";
+    for(size_t i = 0; i < num_operations; ++i)
+    {
+        if(_data.operations.at(i).count == 0) continue;
+        _write_entry(static_cast<operation>(i), _data.operations.at(i));
+        ofs << "\n";
+    }
+    ofs << "\n";
+
+    _write_header();
+    ofs << " | file\n";
+    for(const auto& itr : get_sorted(_data.entries))
+    {
+        _write_entry(itr.first.second, itr.second);
+        ofs << " | " << _data.names.at(itr.first.first) << "\n";
+    }
+
+    // the histograms of the reads and the writes of all the files
+    auto _write_histogram = [&ofs](const char* _label, const char* _units,
+                                   const buckets_t::array_type& _v) {
+        auto _last = buckets_t::get_used(_v);
+        if(_last == 0) return;
+
+        ofs << "\n" << _label << ":\n";
+        for(size_t i = 0; i < _last; ++i)
+        {
+            if(_v.at(i) == 0) continue;
+            ofs << "    " << std::setw(14) << buckets_t::get_bucket_begin(i) << " "
+                << std::setw(5) << _units << " : " << _v.at(i) << "\n";
+        }
+    };
+
+    for(auto itr : { read_operation, write_operation, sync_operation })
+    {
+        const auto& _v = _data.operations.at(itr);
+        if(_v.count == 0) continue;
+        if(itr != sync_operation)
+            _write_histogram(JOIN(" ", operation_names.at(itr), "sizes").c_str(), "bytes",
+                             _v.sizes);
+        _write_histogram(JOIN(" ", operation_names.at(itr), "latencies").c_str(), "ns",
+                         _v.latencies);
+    }
+
+    if(_data.overflow.count > 0)
+    {
+        ofs << "\n"
+            << _data.overflow.count << " calls (" << as_megabytes(_data.overflow.bytes)
+            << " MB) exceeded the capacity of " << thread_capacity
+            << " files and operations per thread\n";
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        auto _save_entry = [&ar](operation _op, const entry& _v) {
+            (*ar)(cereal::make_nvp("operation", std::string{ operation_names.at(_op) }),
+                  cereal::make_nvp("count", _v.count),
+                  cereal::make_nvp("errors", _v.errors),
+                  cereal::make_nvp("bytes", _v.bytes),
+                  cereal::make_nvp("time_ns", _v.time),
+                  cereal::make_nvp("max_ns", _v.max),
+                  cereal::make_nvp("size_buckets", _v.sizes),
+                  cereal::make_nvp("latency_buckets", _v.latencies));
+        };
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("io_trace");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("overflow_count", _data.overflow.count),
+              cereal::make_nvp("overflow_bytes", _data.overflow.bytes),
+              cereal::make_nvp("throughput_interval_ns", throughput_interval));
+
+        ar->setNextName("operations");
+        ar->startNode();
+        ar->makeArray();
+        for(size_t i = 0; i < num_operations; ++i)
+        {
+            if(_data.operations.at(i).count == 0) continue;
+            ar->startNode();
+            _save_entry(static_cast<operation>(i), _data.operations.at(i));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->setNextName("files");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : get_sorted(_data.entries))
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("file", _data.names.at(itr.first.first)));
+            _save_entry(itr.first.second, itr.second);
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("io-trace", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening io-trace output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "io-trace" });
+    ofs << oss.str() << "\n";
+}
+
+void
+write_perfetto(const summary& _data)
+{
+    using track = perfetto_counter_track<category::io>;
+
+    if(!get_use_perfetto() || _data.throughput.empty()) return;
+
+    if(!track::exists(0))
+    {
+        track::emplace(0, "I/O Read Throughput", "MB/s");
+        track::emplace(0, "I/O Write Throughput", "MB/s");
+    }
+
+    // the intervals without any I/O are zero
+    const auto* _category = trait::name<category::io>::value;
+    const auto  _interval = static_cast<double>(throughput_interval) / units::sec;
+    auto        _prev     = std::optional<uint64_t>{};
+    for(const auto& itr : _data.throughput)
+    {
+        if(_prev && *_prev + 1 < itr.first)
+        {
+            auto _ts = (*_prev + 1) * throughput_interval;
+            TRACE_COUNTER(_category, track::at(0, 0), _ts, 0.0);
+            TRACE_COUNTER(_category, track::at(0, 1), _ts, 0.0);
+        }
+        auto _ts = itr.first * throughput_interval;
+        TRACE_COUNTER(_category, track::at(0, 0), _ts,
+                      as_megabytes(itr.second.read) / _interval);
+        TRACE_COUNTER(_category, track::at(0, 1), _ts,
+                      as_megabytes(itr.second.written) / _interval);
+        _prev = itr.first;
+    }
+
+    auto _ts = (*_prev + 1) * throughput_interval;
+    TRACE_COUNTER(_category, track::at(0, 0), _ts, 0.0);
+    TRACE_COUNTER(_category, track::at(0, 1), _ts, 0.0);
+}
+
+void
+trace_call(const char* _func, operation _op, int _fd, uint32_t _file, int64_t _ret,
+           uint64_t _beg_ns, uint64_t _end_ns)
+{
+    tracing::push_perfetto_ts(
+        category::io{}, _func, _beg_ns, [&](::perfetto::EventContext ctx) {
+            if(!config::get_perfetto_annotations()) return;
+            tracing::add_perfetto_annotation(ctx, "fd", _fd);
+            tracing::add_perfetto_annotation(ctx, "file", get_file_name(_file));
+            if(_op == read_operation || _op == write_operation)
+                tracing::add_perfetto_annotation(ctx, "bytes", _ret);
+            tracing::add_perfetto_annotation(ctx, "return", _ret);
+        });
+    tracing::pop_perfetto_ts(category::io{}, _func, _end_ns);
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return config::get_io_trace() && get_active().load();
+}
+
+operation
+get_operation(std::string_view _func)
+{
+    if(_func.find("write") != std::string_view::npos) return write_operation;
+    if(_func.find("read") != std::string_view::npos) return read_operation;
+    if(_func.find("open") != std::string_view::npos) return open_operation;
+    if(_func.find("close") != std::string_view::npos) return close_operation;
+    return sync_operation;
+}
+
+void
+record_open(int _fd, const char* _path)
+{
+    if(_fd < 0 || _path == nullptr) return;
+
+    // relative paths are resolved by procfs
+    auto _id = (_path[0] == '/') ? intern(_path) : resolve(_fd);
+    if(static_cast<size_t>(_fd) < max_fds)
+        get_file_table().fds[_fd].store(_id, std::memory_order_release);
+}
+
+void
+record(const char* _func, operation _op, int _fd, int64_t _ret, uint64_t _beg_ns,
+       uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+
+    // the descriptor returned by open is the file of the call
+    auto _file  = get_file((_op == open_operation) ? static_cast<int>(_ret) : _fd);
+    auto _time  = (_end_ns > _beg_ns) ? (_end_ns - _beg_ns) : uint64_t{ 0 };
+    auto _sized = (_op == read_operation || _op == write_operation);
+
+    auto& _v = get_thread_table();
+    if(!_v) _v = std::make_unique<thread_table>();
+
+    auto  _idx  = get_slot(_file, _op);
+    auto* _data = &_v->overflow;
+    for(size_t i = 0; i < thread_capacity; ++i)
+    {
+        auto& _slot = _v->slots[(_idx + i) % thread_capacity];
+        if(_slot.data.count == 0)
+        {
+            _slot.file = _file;
+            _slot.op   = _op;
+        }
+        if(_slot.file == _file && _slot.op == _op)
+        {
+            _data = &_slot.data;
+            break;
+        }
+    }
+    _data->add(_ret, _time, _sized);
+
+    if(_sized && _ret > 0)
+    {
+        auto _interval = _end_ns / throughput_interval;
+        if(_v->throughput.empty() || _v->throughput.back().interval != _interval)
+            _v->throughput.emplace_back(throughput_entry{ _interval, 0, 0 });
+        auto& _tp = _v->throughput.back();
+        ((_op == read_operation) ? _tp.read : _tp.written) += static_cast<uint64_t>(_ret);
+    }
+
+    const auto& _cfg = config::get_snapshot();
+    if(_time >= _cfg.io_trace_threshold_ns && get_use_perfetto())
+        trace_call(_func, _op, _fd, _file, _ret, _beg_ns, _end_ns);
+
+    // the descriptor may be re-used by the next open
+    if(_op == close_operation && _ret == 0 && _fd >= 0 &&
+       static_cast<size_t>(_fd) < max_fds)
+        get_file_table().fds[_fd].store(0, std::memory_order_release);
+}
+
+void
+post_process()
+{
+    if(!config::get_io_trace()) return;
+
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+
+        try
+        {
+            auto _data = get_summary();
+            if(_data.entries.empty() && _data.overflow.count == 0)
+            {
+                OMNITRACE_VERBOSE_F(1, "No I/O calls were recorded\n");
+                return;
+            }
+
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+            write_perfetto(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the I/O trace failed: %s\n", _e.what());
+        }
+    });
+}
+}  // namespace io_trace
+}  // namespace omnitrace
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "common/defines.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+/// POSIX I/O tracing (see OMNITRACE_IO_TRACE). The io_gotcha wrappers time each call
+/// and report it with the file descriptor and the number of bytes transferred. The
+/// file descriptors are mapped to the paths in a table filled by the open calls (or
+/// read from /proc/self/fd on first use). Each thread accumulates the calls per file
+/// and operation in its own table along with log2 histograms of the sizes and the
+/// latencies and the bytes read and written per interval for the throughput, without
+/// any locking. Only the calls which took at least OMNITRACE_IO_TRACE_THRESHOLD_NS are
+/// traced in perfetto. At finalization, the tables are merged and written to
+/// io-trace.{txt,json} and the throughput to the counter tracks in perfetto
+namespace io_trace
+{
+enum operation : uint8_t
+{
+    read_operation = 0,
+    write_operation,
+    open_operation,
+    close_operation,
+    sync_operation,
+    num_operations,
+};
+
+/// marks the thread as inside a wrapper so the I/O of omnitrace itself is not recorded.
+/// The flag uses the initial-exec TLS model since the wrappers may be invoked before
+/// the TLS of omnitrace is set up
+struct scoped_guard
+{
+    scoped_guard()
+    : m_nested{ get_flag() }
+    {
+        get_flag() = true;
+    }
+
+    ~scoped_guard() { get_flag() = m_nested; }
+
+    scoped_guard(const scoped_guard&) = delete;
+    scoped_guard& operator=(const scoped_guard&) = delete;
+
+    bool nested() const { return m_nested; }
+
+private:
+    static bool& get_flag()
+    {
+        static thread_local bool _v OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) =
+            false;
+        return _v;
+    }
+
+    bool m_nested = false;
+};
+
+/// check if the I/O tracing is enabled, i.e. the wrappers should be installed
+bool
+is_enabled();
+
+/// the operation of a wrapped function, e.g. read_operation for "preadv64"
+operation
+get_operation(std::string_view _func);
+
+/// records the path of a file descriptor returned by open or openat
+void
+record_open(int _fd, const char* _path);
+
+/// records a call of _func (which must outlive the finalization) on the file
+/// descriptor between the timestamps (see tracing::now()). _ret is the value returned
+/// by the call, i.e. the number of bytes for the reads and the writes
+void
+record(const char* _func, operation _op, int _fd, int64_t _ret, uint64_t _beg_ns,
+       uint64_t _end_ns);
+
+/// stops the recording and writes the profile and the counter tracks. Only the first
+/// invocation has an effect
+void
+post_process();
+}  // namespace io_trace
+}  // namespace omnitrace
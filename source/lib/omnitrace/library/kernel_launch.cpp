@@ -0,0 +1,434 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "library/kernel_launch.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/containers/log2_buckets.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace kernel_launch
+{
+namespace
+{
+using buckets_t = container::log2_buckets<40>;
+
+// the changes of the kernels in flight of a queue within this interval are coalesced
+// into one point of the counter track, which keeps the highest and the last value
+constexpr uint64_t coalesce_interval = 10 * units::usec;
+
+struct histogram
+{
+    uint64_t                          count   = 0;
+    uint64_t                          total   = 0;  // nanoseconds
+    uint64_t                          max     = 0;  // nanoseconds
+    buckets_t::array_type             buckets = {};
+
+    void add(uint64_t _v)
+    {
+        count += 1;
+        total += _v;
+        max = std::max(max, _v);
+        buckets_t::add(buckets, _v);
+    }
+};
+
+struct timeline_point
+{
+    uint64_t timestamp = 0;
+    uint64_t peak      = 0;
+    uint64_t last_ts   = 0;
+    uint64_t last      = 0;
+};
+
+struct queue_totals
+{
+    uint64_t  kernels       = 0;
+    uint64_t  busy_ns       = 0;  // union of the kernel durations
+    uint64_t  first_beg     = 0;
+    uint64_t  last_end      = 0;
+    uint64_t  max_in_flight = 0;
+    histogram latency       = {};  // host launch to the begin of the kernel
+    histogram gaps          = {};  // end of the previous kernel to the begin
+};
+
+// the ends of the kernels in flight are kept in a min-heap since the kernels of a
+// queue may overlap
+using pending_t =
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>>;
+
+struct queue_entry
+{
+    queue_totals                totals   = {};
+    pending_t                   pending  = {};
+    std::vector<timeline_point> timeline = {};
+};
+
+using queue_key_t = std::pair<int32_t, int64_t>;  // device, queue
+
+struct profile_data
+{
+    std::mutex                             mutex    = {};
+    std::unordered_map<uint64_t, uint64_t> launches = {};  // correlation id, host ts
+    std::map<queue_key_t, queue_entry>     queues   = {};
+};
+
+struct queue_summary
+{
+    int32_t      device = 0;
+    int64_t      queue  = 0;
+    queue_totals totals = {};
+};
+
+using summary_t = std::vector<queue_summary>;
+
+std::once_flag post_process_once{};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the callbacks during the static destruction are safe
+auto&
+get_profile()
+{
+    static auto* _v = new profile_data{};
+    return *_v;
+}
+
+// requires the mutex of the profile. The timestamps of the points are kept in order
+// even if the records of the queue are slightly out of order
+void
+update_timeline(queue_entry& _queue, uint64_t _ts)
+{
+    auto  _level    = static_cast<uint64_t>(_queue.pending.size());
+    auto& _timeline = _queue.timeline;
+    if(!_timeline.empty()) _ts = std::max(_ts, _timeline.back().last_ts);
+
+    if(_timeline.empty() || _ts >= _timeline.back().timestamp + coalesce_interval)
+    {
+        _timeline.emplace_back(timeline_point{ _ts, _level, _ts, _level });
+        return;
+    }
+
+    auto& _point   = _timeline.back();
+    _point.peak    = std::max(_point.peak, _level);
+    _point.last_ts = _ts;
+    _point.last    = _level;
+}
+
+// requires the mutex of the profile. Completes the kernels which ended before the
+// timestamp
+void
+complete(queue_entry& _queue, uint64_t _ts)
+{
+    while(!_queue.pending.empty() && _queue.pending.top() <= _ts)
+    {
+        auto _end = _queue.pending.top();
+        _queue.pending.pop();
+        update_timeline(_queue, _end);
+    }
+}
+
+double
+as_usec(uint64_t _v)
+{
+    return static_cast<double>(_v) / units::usec;
+}
+
+double
+get_mean(const histogram& _v)
+{
+    if(_v.count == 0) return 0.0;
+    return static_cast<double>(_v.total) / static_cast<double>(_v.count);
+}
+
+double
+get_idle_fraction(const queue_totals& _v)
+{
+    if(_v.last_end <= _v.first_beg) return 0.0;
+    auto _span = _v.last_end - _v.first_beg;
+    return 1.0 - (static_cast<double>(std::min(_v.busy_ns, _span)) /
+                  static_cast<double>(_span));
+}
+
+std::string
+get_queue_name(const queue_summary& _v)
+{
+    return JOIN(' ', "device", _v.device, "queue", _v.queue);
+}
+
+void
+write_text(const summary_t& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("kernel-launch", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening kernel-launch output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname,
+                                                    std::string{ "kernel-launch" });
+
+    auto _write_histogram = [&ofs](const char* _label, const histogram& _v) {
+        auto _last = buckets_t::get_used(_v.buckets);
+        if(_last == 0) return;
+
+        ofs << "\n  " << _label << " (mean: " << as_usec(get_mean(_v))
+            << " usec, max: " << as_usec(_v.max) << " usec):\n";
+        for(size_t i = 0; i < _last; ++i)
+        {
+            if(_v.buckets.at(i) == 0) continue;
+            ofs << "    " << std::setw(14) << buckets_t::get_bucket_begin(i)
+                << " ns : " << _v.buckets.at(i) << "\n";
+        }
+    };
+
+    ofs << std::setprecision(3) << std::fixed;
+    for(const auto& itr : _data)
+    {
+        const auto& _v = itr.totals;
+        ofs << get_queue_name(itr) << ": kernels: " << _v.kernels
+            << ", span (usec): " << as_usec(_v.last_end - _v.first_beg)
+            << ", busy (usec): " << as_usec(_v.busy_ns)
+            << ", idle (%): " << (100.0 * get_idle_fraction(_v))
+            << ", max in flight: " << _v.max_in_flight << "\n";
+        _write_histogram("launch latency", _v.latency);
+        _write_histogram("gaps between kernels", _v.gaps);
+        ofs << "\n";
+    }
+}
+
+void
+write_json(const summary_t& _data)
+{
+    namespace cereal = tim::cereal;
+
+    auto _save_histogram = [](auto& ar, const char* _name, const histogram& _v) {
+        ar->setNextName(_name);
+        ar->startNode();
+        (*ar)(cereal::make_nvp("count", _v.count),
+              cereal::make_nvp("total_ns", _v.total), cereal::make_nvp("max_ns", _v.max),
+              cereal::make_nvp("buckets", _v.buckets));
+        ar->finishNode();
+    };
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("kernel_launch");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data)
+        {
+            const auto& _v = itr.totals;
+            ar->startNode();
+            (*ar)(cereal::make_nvp("device", itr.device),
+                  cereal::make_nvp("queue", itr.queue),
+                  cereal::make_nvp("kernels", _v.kernels),
+                  cereal::make_nvp("begin_ns", _v.first_beg),
+                  cereal::make_nvp("end_ns", _v.last_end),
+                  cereal::make_nvp("busy_ns", _v.busy_ns),
+                  cereal::make_nvp("idle_fraction", get_idle_fraction(_v)),
+                  cereal::make_nvp("max_in_flight", _v.max_in_flight));
+            _save_histogram(ar, "launch_latency", _v.latency);
+            _save_histogram(ar, "gaps", _v.gaps);
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("kernel-launch", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening kernel-launch output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname,
+                                                    std::string{ "kernel-launch" });
+
+    ofs << oss.str() << "\n";
+}
+
+void
+write_perfetto(const profile_data& _profile)
+{
+    using track = perfetto_counter_track<category::kernel_launch>;
+
+    if(!get_use_perfetto()) return;
+
+    const auto* _category = trait::name<category::kernel_launch>::value;
+    for(const auto& qitr : _profile.queues)
+    {
+        if(qitr.second.timeline.empty()) continue;
+
+        auto _idx = track::size(0);
+        track::emplace(0, JOIN(' ', "Kernels In Flight device", qitr.first.first,
+                               "queue", qitr.first.second));
+        for(const auto& itr : qitr.second.timeline)
+        {
+            TRACE_COUNTER(_category, track::at(0, _idx), itr.timestamp, itr.peak);
+            if(itr.last_ts != itr.timestamp || itr.last != itr.peak)
+                TRACE_COUNTER(_category, track::at(0, _idx), itr.last_ts, itr.last);
+        }
+    }
+}
+}  // namespace
+
+void
+launch(uint64_t _corr_id, uint64_t _ts)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _profile.launches[_corr_id] = _ts;
+}
+
+void
+device_op(uint64_t _corr_id, int32_t _device, int64_t _queue, uint64_t _beg_ns,
+          uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto& _entry   = _profile.queues[queue_key_t{ _device, _queue }];
+    auto& _totals  = _entry.totals;
+
+    // the dispatches without a kernel launch on the host, e.g. the nodes of a graph
+    // launch, are in flight from their begin. The host timestamp is clamped to the
+    // begin since the clock skew correction of the device timestamps is approximate
+    auto _launch = _beg_ns;
+    if(auto itr = _profile.launches.find(_corr_id); itr != _profile.launches.end())
+    {
+        _launch = std::min(itr->second, _beg_ns);
+        _totals.latency.add(_beg_ns - _launch);
+        _profile.launches.erase(itr);
+    }
+
+    if(_totals.kernels == 0)
+    {
+        _totals.first_beg = _beg_ns;
+        _totals.last_end  = _beg_ns;
+    }
+    else
+    {
+        _totals.gaps.add((_beg_ns > _totals.last_end) ? (_beg_ns - _totals.last_end) : 0);
+    }
+
+    if(_end_ns > _totals.last_end)
+    {
+        _totals.busy_ns += _end_ns - std::max(_beg_ns, _totals.last_end);
+        _totals.last_end = _end_ns;
+    }
+    _totals.first_beg = std::min(_totals.first_beg, _beg_ns);
+    _totals.kernels += 1;
+
+    complete(_entry, _launch);
+    _entry.pending.emplace(_end_ns);
+    _totals.max_in_flight =
+        std::max<uint64_t>(_totals.max_in_flight, _entry.pending.size());
+    update_timeline(_entry, _launch);
+}
+
+void
+post_process()
+{
+    if(!config::get_kernel_launch_latency()) return;
+
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+
+        auto& _profile = get_profile();
+        auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+        if(_profile.queues.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No kernel dispatches were recorded\n");
+            return;
+        }
+
+        auto _data = summary_t{};
+        for(auto& itr : _profile.queues)
+        {
+            // the kernels still in flight at the end of the last dispatch
+            complete(itr.second, itr.second.totals.last_end);
+            _data.emplace_back(
+                queue_summary{ itr.first.first, itr.first.second, itr.second.totals });
+        }
+
+        if(!_profile.launches.empty())
+            OMNITRACE_VERBOSE_F(1, "%zu kernel launches had no kernel dispatch\n",
+                                _profile.launches.size());
+
+        try
+        {
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+            write_perfetto(_profile);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the kernel launch report failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace kernel_launch
+}  // namespace omnitrace
@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// the launch latency and the occupancy of the GPU queues (see
+/// OMNITRACE_KERNEL_LAUNCH_LATENCY). The host time of every kernel launch is kept
+/// until the kernel dispatch with the same correlation id completes, which gives the
+/// latency from the launch to the begin of the kernel. The dispatches are accounted
+/// per device and queue in log2 histograms of the launch latency and of the idle gaps
+/// between consecutive kernels, along with the number of kernels which were launched
+/// but had not completed (in flight). At finalization, the histograms are written per
+/// queue to kernel-launch.{txt,json} and the kernels in flight of each queue are shown
+/// in a counter track in perfetto
+namespace kernel_launch
+{
+/// the host entry of a kernel launch with the correlation id
+void
+launch(uint64_t _corr_id, uint64_t _ts);
+
+/// the completed kernel dispatch with the correlation id. The timestamps are in the
+/// timebase of the host
+void
+device_op(uint64_t _corr_id, int32_t _device, int64_t _queue, uint64_t _beg_ns,
+          uint64_t _end_ns);
+
+/// stops the recording and writes the report. Only the first invocation has an
+/// effect
+void
+post_process();
+}  // namespace kernel_launch
+}  // namespace omnitrace
@@ -28,7 +28,9 @@
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
+#include "core/self_profile.hpp"
 #include "library/components/category_region.hpp"
+#include "library/kokkosp_tuning.hpp"
 #include "library/runtime.hpp"
 
 #include <timemory/api/kokkosp.hpp>
@@ -36,12 +38,25 @@
 #include <timemory/hash/types.hpp>
 #include <timemory/mpl/concepts.hpp>
 #include <timemory/mpl/type_traits.hpp>
+#include <timemory/utility/filepath.hpp>
 #include <timemory/utility/procfs/maps.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
 #include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace kokkosp  = ::tim::kokkosp;
 namespace category = ::tim::category;
@@ -89,6 +104,8 @@ namespace
 {
 bool                     _standalone_initialized = false;
 bool                     _kp_deep_copy           = false;
+bool                     _kp_kernel_summary      = false;
+bool                     _kp_memory_analysis     = false;
 size_t                   _name_len_limit         = 0;
 std::string              _kp_prefix              = {};
 std::vector<std::string> _initialize_arguments   = {};
@@ -148,6 +165,413 @@ violates_name_rules(Arg&& _arg, Args&&... _args)
 
     return (_len >= _name_len_limit);
 }
+
+// the kernels are registered once per (type, device, name) with the persistent name
+// and hash of the region and are never removed. The begin callbacks only hash the name
+// to find the kernel in the cache of the thread and the end callbacks only pop the
+// kernel from the stack of the thread, so no strings are built per launch
+struct kernel_info
+{
+    uint32_t                          index  = 0;
+    uint32_t                          devid  = 0;
+    const char*                       type   = nullptr;
+    std::string                       label  = {};
+    omnitrace::tracing::region_handle region = {};
+    std::atomic<uint64_t>             count  = { 0 };
+    std::atomic<uint64_t>             total  = { 0 };
+    std::atomic<uint64_t>             min    = { std::numeric_limits<uint64_t>::max() };
+    std::atomic<uint64_t>             max    = { 0 };
+
+    void add(uint64_t _ns);
+};
+
+struct kernel_registry
+{
+    std::mutex                                    mutex   = {};
+    std::deque<kernel_info>                       kernels = {};
+    std::unordered_map<std::string, kernel_info*> index   = {};
+};
+
+// a kernel which began on this thread. Kokkos ends the kernels in the reverse order of
+// the beginning on the thread which began them
+struct kernel_launch
+{
+    kernel_info*                     info  = nullptr;
+    omnitrace::tracing::region_token token = {};
+    uint64_t                         beg   = 0;
+};
+
+void
+kernel_info::add(uint64_t _ns)
+{
+    auto _update = [](auto& _atomic, auto _val, auto&& _cmp) {
+        auto _prev = _atomic.load(std::memory_order_relaxed);
+        while(_cmp(_val, _prev) &&
+              !_atomic.compare_exchange_weak(_prev, _val, std::memory_order_relaxed))
+        {}
+    };
+
+    count.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(_ns, std::memory_order_relaxed);
+    _update(min, _ns, std::less<uint64_t>{});
+    _update(max, _ns, std::greater<uint64_t>{});
+}
+
+// intentionally leaked so the names outlive the storage of the regions
+auto&
+get_kernel_registry()
+{
+    static auto* _v = new kernel_registry{};
+    return *_v;
+}
+
+auto&
+get_kernel_launches()
+{
+    static thread_local auto _v = std::vector<kernel_launch>{};
+    return _v;
+}
+
+kernel_info*
+register_kernel(const char* _type, const char* _name, uint32_t _devid)
+{
+    auto  _key      = JOIN('|', _type, _devid, _name);
+    auto& _registry = get_kernel_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+    auto  itr       = _registry.index.find(_key);
+    if(itr != _registry.index.end()) return itr->second;
+
+    auto _pname =
+        (_devid > std::numeric_limits<uint16_t>::max())  // junk device number
+            ? JOIN(" ", _kp_prefix, _name, JOIN("", '[', _type, ']'))
+            : JOIN(" ", _kp_prefix, _name, JOIN("", '[', _type, "][dev", _devid, ']'));
+
+    auto& _info  = _registry.kernels.emplace_back();
+    auto  _hash  = tim::add_hash_id(_pname);
+    _info.index  = _registry.kernels.size() - 1;
+    _info.devid  = _devid;
+    _info.type   = _type;
+    _info.label  = _name;
+    _info.region = { _hash, tim::get_hash_identifier_fast(_hash) };
+    _registry.index.emplace(std::move(_key), &_info);
+    return &_info;
+}
+
+kernel_info*
+get_kernel(const char* _type, const char* _name, uint32_t _devid)
+{
+    static thread_local auto _cache = std::unordered_map<size_t, kernel_info*>{};
+
+    auto _hash = std::hash<std::string_view>{}(_name) ^
+                 (std::hash<const void*>{}(_type) + (uint64_t{ _devid } << 1));
+    auto itr   = _cache.find(_hash);
+    if(OMNITRACE_LIKELY(itr != _cache.end() && itr->second->type == _type &&
+                        itr->second->devid == _devid && itr->second->label == _name))
+        return itr->second;
+
+    auto* _info = register_kernel(_type, _name, _devid);
+    // a colliding kernel replaces the cached entry
+    _cache[_hash] = _info;
+    return _info;
+}
+
+void
+begin_kernel(const char* _type, const char* _name, uint32_t _devid, uint64_t* _kernid)
+{
+    using region_type = kokkosp_region::impl_type;
+
+    auto* _info     = get_kernel(_type, _name, _devid);
+    auto& _launches = get_kernel_launches();
+    *_kernid        = (uint64_t{ _info->index } << 32) | _launches.size();
+
+    auto& _launch = _launches.emplace_back(kernel_launch{ _info });
+    _launch.token = region_type::start(_info->region);
+    _launch.beg   = omnitrace::tracing::now();
+}
+
+void
+end_kernel(uint64_t _kernid)
+{
+    using region_type = kokkosp_region::impl_type;
+
+    auto& _launches = get_kernel_launches();
+    auto  _depth    = (_kernid & 0xFFFFFFFF);
+    if(_launches.empty() || _depth != _launches.size() - 1 ||
+       _launches.back().info->index != (_kernid >> 32))
+    {
+        OMNITRACE_VERBOSE_F(2, "kokkos kernel %llu ended out of order\n",
+                            (unsigned long long) _kernid);
+        return;
+    }
+
+    auto _launch = _launches.back();
+    _launches.pop_back();
+    auto _elapsed = omnitrace::tracing::now() - _launch.beg;
+    // if the start returned early, the token is empty and the pop uses the region
+    if(_launch.token.region.name.empty())
+        region_type::stop(_launch.info->region);
+    else
+        region_type::stop(_launch.token);
+    _launch.info->add(_elapsed);
+}
+
+void
+write_kernel_summary()
+{
+    struct summary
+    {
+        const kernel_info* info  = nullptr;
+        uint64_t           count = 0;
+        uint64_t           total = 0;
+    };
+
+    auto _data = std::vector<summary>{};
+    {
+        auto& _registry = get_kernel_registry();
+        auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+        for(const auto& itr : _registry.kernels)
+        {
+            auto _count = itr.count.load();
+            if(_count > 0) _data.emplace_back(summary{ &itr, _count, itr.total.load() });
+        }
+    }
+
+    if(_data.empty()) return;
+
+    std::sort(_data.begin(), _data.end(),
+              [](const summary& _lhs, const summary& _rhs) {
+                  return _lhs.total > _rhs.total;
+              });
+
+    auto _fname = tim::settings::compose_output_filename("kokkos-kernels", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening kokkos kernel summary output file: %s",
+                        _fname.c_str());
+    }
+
+    OMNITRACE_VERBOSE_F(0, "Outputting '%s'...\n", _fname.c_str());
+    ofs << "# type  device  count  total_ns  mean_ns  min_ns  max_ns  name\n";
+    for(const auto& itr : _data)
+    {
+        ofs << itr.info->type << "  " << itr.info->devid << "  " << itr.count << "  "
+            << itr.total << "  " << (itr.total / itr.count) << "  "
+            << itr.info->min.load() << "  " << itr.info->max.load() << "  "
+            << itr.info->label << "\n";
+    }
+}
+
+// the memory spaces and the (source, destination) pairs of the deep copies are
+// registered on first use and never removed so the callbacks only update the atomics
+// of the entry and the counter track of the entry is never relocated
+struct memory_space_info
+{
+    std::string                             name   = {};
+    std::string                             label  = {};  // name of the counter track
+    std::optional<::perfetto::CounterTrack> track  = {};
+    std::atomic<int64_t>                    live   = { 0 };
+    std::atomic<int64_t>                    peak   = { 0 };
+    std::atomic<uint64_t>                   allocs = { 0 };
+    std::atomic<uint64_t>                   frees  = { 0 };
+};
+
+struct deep_copy_info
+{
+    std::string                             src   = {};
+    std::string                             dst   = {};
+    std::string                             label = {};  // name of the counter track
+    std::optional<::perfetto::CounterTrack> track = {};
+    std::atomic<uint64_t>                   count = { 0 };
+    std::atomic<uint64_t>                   bytes = { 0 };
+    std::atomic<uint64_t>                   total = { 0 };  // nanoseconds
+    std::atomic<double>                     min   = { DBL_MAX };
+    std::atomic<double>                     max   = { 0.0 };
+};
+
+struct memory_registry
+{
+    std::mutex                                          mutex       = {};
+    std::deque<memory_space_info>                       spaces      = {};
+    std::deque<deep_copy_info>                          copies      = {};
+    std::unordered_map<std::string, memory_space_info*> space_index = {};
+    std::unordered_map<std::string, deep_copy_info*>    copy_index  = {};
+};
+
+// a deep copy which began on this thread. Kokkos ends the deep copies in the reverse
+// order of the beginning
+struct deep_copy_launch
+{
+    deep_copy_info* info  = nullptr;
+    uint64_t        bytes = 0;
+    uint64_t        beg   = 0;
+};
+
+// intentionally leaked so the names of the counter tracks outlive perfetto
+auto&
+get_memory_registry()
+{
+    static auto* _v = new memory_registry{};
+    return *_v;
+}
+
+auto&
+get_deep_copy_launches()
+{
+    static thread_local auto _v = std::vector<deep_copy_launch>{};
+    return _v;
+}
+
+auto
+make_counter_track(const std::string& _name, const char* _units)
+{
+    return ::perfetto::CounterTrack{ _name.c_str() }.set_unit_name(_units);
+}
+
+memory_space_info*
+get_memory_space(const char* _name)
+{
+    static thread_local auto _cache =
+        std::unordered_map<std::string, memory_space_info*>{};
+
+    auto _key = std::string{ _name };
+    auto itr  = _cache.find(_key);
+    if(OMNITRACE_LIKELY(itr != _cache.end())) return itr->second;
+
+    auto& _registry = get_memory_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+    auto  ritr      = _registry.space_index.find(_key);
+    if(ritr == _registry.space_index.end())
+    {
+        auto& _info = _registry.spaces.emplace_back();
+        _info.name  = _key;
+        _info.label = JOIN(" ", "Kokkos", _key, "Live Bytes");
+        _info.track = make_counter_track(_info.label, "bytes");
+        ritr        = _registry.space_index.emplace(_key, &_info).first;
+    }
+    return (_cache[_key] = ritr->second);
+}
+
+deep_copy_info*
+get_deep_copy(const char* _src, const char* _dst)
+{
+    static thread_local auto _cache = std::unordered_map<std::string, deep_copy_info*>{};
+
+    auto _key = JOIN("->", _src, _dst);
+    auto itr  = _cache.find(_key);
+    if(OMNITRACE_LIKELY(itr != _cache.end())) return itr->second;
+
+    auto& _registry = get_memory_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+    auto  ritr      = _registry.copy_index.find(_key);
+    if(ritr == _registry.copy_index.end())
+    {
+        auto& _info = _registry.copies.emplace_back();
+        _info.src   = _src;
+        _info.dst   = _dst;
+        _info.label = JOIN(" ", "Kokkos Deep Copy Bandwidth", _key);
+        _info.track = make_counter_track(_info.label, "GB/s");
+        ritr        = _registry.copy_index.emplace(_key, &_info).first;
+    }
+    return (_cache[_key] = ritr->second);
+}
+
+void
+update_memory_space(const char* _name, int64_t _bytes)
+{
+    auto* _info = get_memory_space(_name);
+    auto  _live = _info->live.fetch_add(_bytes, std::memory_order_relaxed) + _bytes;
+    auto  _peak = _info->peak.load(std::memory_order_relaxed);
+    while(_live > _peak &&
+          !_info->peak.compare_exchange_weak(_peak, _live, std::memory_order_relaxed))
+    {}
+    ((_bytes > 0) ? _info->allocs : _info->frees).fetch_add(1, std::memory_order_relaxed);
+
+    if(omnitrace::config::get_use_perfetto())
+    {
+        TRACE_COUNTER(tim::trait::name<category::kokkos>::value, *_info->track,
+                      omnitrace::tracing::now(), _live);
+    }
+}
+
+void
+begin_deep_copy(const char* _src, const char* _dst, uint64_t _bytes)
+{
+    get_deep_copy_launches().emplace_back(deep_copy_launch{
+        get_deep_copy(_src, _dst), _bytes, omnitrace::tracing::now() });
+}
+
+void
+end_deep_copy()
+{
+    auto  _end      = omnitrace::tracing::now();
+    auto& _launches = get_deep_copy_launches();
+    if(_launches.empty()) return;
+
+    auto _launch = _launches.back();
+    _launches.pop_back();
+
+    auto* _info      = _launch.info;
+    auto  _elapsed   = std::max<uint64_t>(_end - _launch.beg, 1);
+    auto  _bandwidth = static_cast<double>(_launch.bytes) / _elapsed;  // GB/s
+
+    auto _update = [](auto& _atomic, auto _val, auto&& _cmp) {
+        auto _prev = _atomic.load(std::memory_order_relaxed);
+        while(_cmp(_val, _prev) &&
+              !_atomic.compare_exchange_weak(_prev, _val, std::memory_order_relaxed))
+        {}
+    };
+
+    _info->count.fetch_add(1, std::memory_order_relaxed);
+    _info->bytes.fetch_add(_launch.bytes, std::memory_order_relaxed);
+    _info->total.fetch_add(_elapsed, std::memory_order_relaxed);
+    _update(_info->min, _bandwidth, std::less<double>{});
+    _update(_info->max, _bandwidth, std::greater<double>{});
+
+    if(omnitrace::config::get_use_perfetto())
+    {
+        TRACE_COUNTER(tim::trait::name<category::kokkos>::value, *_info->track,
+                      _launch.beg, _bandwidth);
+        TRACE_COUNTER(tim::trait::name<category::kokkos>::value, *_info->track, _end,
+                      0.0);
+    }
+}
+
+void
+write_memory_summary()
+{
+    auto& _registry = get_memory_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+    if(_registry.spaces.empty() && _registry.copies.empty()) return;
+
+    auto _fname = tim::settings::compose_output_filename("kokkos-memory", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening kokkos memory summary output file: %s",
+                        _fname.c_str());
+    }
+
+    OMNITRACE_VERBOSE_F(0, "Outputting '%s'...\n", _fname.c_str());
+    ofs << "# memory_space  allocations  deallocations  live_bytes  peak_bytes\n";
+    for(const auto& itr : _registry.spaces)
+    {
+        ofs << itr.name << "  " << itr.allocs.load() << "  " << itr.frees.load() << "  "
+            << itr.live.load() << "  " << itr.peak.load() << "\n";
+    }
+
+    ofs << "\n# source  destination  count  bytes  total_ns  mean_GB/s  min_GB/s  "
+           "max_GB/s\n";
+    for(const auto& itr : _registry.copies)
+    {
+        auto _count = itr.count.load();
+        if(_count == 0) continue;
+        auto _mean = static_cast<double>(itr.bytes.load()) / itr.total.load();
+        ofs << itr.src << "  " << itr.dst << "  " << _count << "  " << itr.bytes.load()
+            << "  " << itr.total.load() << "  " << _mean << "  " << itr.min.load()
+            << "  " << itr.max.load() << "\n";
+    }
+}
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -166,12 +590,22 @@ extern "C"
                                 bool) OMNITRACE_PUBLIC_API;
     void kokkosp_dual_view_modify(const char*, const void* const,
                                   bool) OMNITRACE_PUBLIC_API;
+    void kokkosp_declare_output_type(const char*, const size_t,
+                                     Kokkos_Tools_VariableInfo*) OMNITRACE_PUBLIC_API;
+    void kokkosp_declare_input_type(const char*, const size_t,
+                                    Kokkos_Tools_VariableInfo*) OMNITRACE_PUBLIC_API;
+    void kokkosp_request_values(const size_t, const size_t,
+                                const Kokkos_Tools_VariableValue*, const size_t,
+                                Kokkos_Tools_VariableValue*) OMNITRACE_PUBLIC_API;
+    void kokkosp_begin_context(const size_t) OMNITRACE_PUBLIC_API;
+    void kokkosp_end_context(const size_t) OMNITRACE_PUBLIC_API;
 
     void kokkosp_print_help(char*) {}
 
     void kokkosp_parse_args(int argc, char** argv)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         if(!omnitrace::config::settings_are_configured() &&
            omnitrace::get_state() < omnitrace::State::Active)
         {
@@ -192,6 +626,7 @@ extern "C"
     void kokkosp_declare_metadata(const char* key, const char* value)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         tim::manager::add_metadata(key, value);
     }
 
@@ -205,6 +640,7 @@ extern "C"
                               const uint32_t devInfoCount, void* deviceInfo)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         tim::consume_parameters(devInfoCount, deviceInfo);
 
         OMNITRACE_BASIC_VERBOSE_F(
@@ -278,11 +714,25 @@ extern "C"
         _kp_deep_copy =
             omnitrace::config::get_setting_value<bool>("OMNITRACE_KOKKOSP_DEEP_COPY")
                 .value_or(_kp_deep_copy);
+
+        _kp_kernel_summary = omnitrace::config::get_setting_value<bool>(
+                                 "OMNITRACE_KOKKOSP_KERNEL_SUMMARY")
+                                 .value_or(_kp_kernel_summary);
+
+        _kp_memory_analysis = omnitrace::config::get_setting_value<bool>(
+                                  "OMNITRACE_KOKKOSP_MEMORY_ANALYSIS")
+                                  .value_or(_kp_memory_analysis);
+
+        omnitrace::kokkosp_tuning::setup();
     }
 
     void kokkosp_finalize_library()
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        if(_kp_kernel_summary) write_kernel_summary();
+        if(_kp_memory_analysis) write_memory_summary();
+        omnitrace::kokkosp_tuning::post_process();
         if(_standalone_initialized)
         {
             omnitrace_pop_trace_hidden("kokkos_main");
@@ -305,13 +755,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname = (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                         ? JOIN(" ", _kp_prefix, name, "[for]")
-                         : JOIN(" ", _kp_prefix, name, JOIN("", "[for][dev", devid, ']'));
-        *kernid    = kokkosp::get_unique_id();
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        begin_kernel("for", name, devid, kernid);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
     }
 
     void kokkosp_end_parallel_for(uint64_t kernid)
@@ -319,9 +765,9 @@ extern "C"
         if(is_invalid_id(kernid)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        end_kernel(kernid);
     }
 
     //----------------------------------------------------------------------------------//
@@ -331,14 +777,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname =
-            (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                ? JOIN(" ", _kp_prefix, name, "[reduce]")
-                : JOIN(" ", _kp_prefix, name, JOIN("", "[reduce][dev", devid, ']'));
-        *kernid = kokkosp::get_unique_id();
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        begin_kernel("reduce", name, devid, kernid);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
     }
 
     void kokkosp_end_parallel_reduce(uint64_t kernid)
@@ -346,9 +787,9 @@ extern "C"
         if(is_invalid_id(kernid)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        end_kernel(kernid);
     }
 
     //----------------------------------------------------------------------------------//
@@ -358,14 +799,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname =
-            (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                ? JOIN(" ", _kp_prefix, name, "[scan]")
-                : JOIN(" ", _kp_prefix, name, JOIN("", "[scan][dev", devid, ']'));
-        *kernid = kokkosp::get_unique_id();
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        begin_kernel("scan", name, devid, kernid);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
     }
 
     void kokkosp_end_parallel_scan(uint64_t kernid)
@@ -373,9 +809,9 @@ extern "C"
         if(is_invalid_id(kernid)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        end_kernel(kernid);
     }
 
     //----------------------------------------------------------------------------------//
@@ -385,14 +821,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname =
-            (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                ? JOIN(" ", _kp_prefix, name, "[fence]")
-                : JOIN(" ", _kp_prefix, name, JOIN("", "[fence][dev", devid, ']'));
-        *kernid = kokkosp::get_unique_id();
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        begin_kernel("fence", name, devid, kernid);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
     }
 
     void kokkosp_end_fence(uint64_t kernid)
@@ -400,9 +831,9 @@ extern "C"
         if(is_invalid_id(kernid)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        end_kernel(kernid);
     }
 
     //----------------------------------------------------------------------------------//
@@ -410,6 +841,7 @@ extern "C"
     void kokkosp_push_profile_region(const char* name)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name);
         kokkosp::get_profiler_stack<kokkosp_region>()
             .emplace_back(kokkosp::profiler_t<kokkosp_region>(name))
@@ -419,6 +851,7 @@ extern "C"
     void kokkosp_pop_profile_region()
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__);
         if(kokkosp::get_profiler_stack<kokkosp_region>().empty()) return;
         kokkosp::get_profiler_stack<kokkosp_region>().back().stop();
@@ -430,6 +863,7 @@ extern "C"
     void kokkosp_create_profile_section(const char* name, uint32_t* secid)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         *secid     = kokkosp::get_unique_id();
         auto pname = std::string{ name };
         kokkosp::create_profiler<kokkosp_region>(name, *secid);
@@ -438,6 +872,7 @@ extern "C"
     void kokkosp_destroy_profile_section(uint32_t secid)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::destroy_profiler<kokkosp_region>(secid);
     }
 
@@ -446,6 +881,7 @@ extern "C"
     void kokkosp_start_profile_section(uint32_t secid)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, secid);
         kokkosp::start_profiler<kokkosp_region>(secid);
     }
@@ -453,6 +889,7 @@ extern "C"
     void kokkosp_stop_profile_section(uint32_t secid)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, secid);
         kokkosp::stop_profiler<kokkosp_region>(secid);
     }
@@ -462,10 +899,19 @@ extern "C"
     void kokkosp_allocate_data(const SpaceHandle space, const char* label,
                                const void* const ptr, const uint64_t size)
     {
+        // the live bytes include the allocations which are not named
+        if(_kp_memory_analysis)
+        {
+            OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+            OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+            update_memory_space(space.name, static_cast<int64_t>(size));
+        }
+
         if(violates_name_rules(label)) return;
         if(omnitrace::config::get_use_causal()) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(0, __FUNCTION__, space.name, label,
                                  JOIN("", '[', ptr, ']'), size);
         auto pname =
@@ -477,10 +923,19 @@ extern "C"
     void kokkosp_deallocate_data(const SpaceHandle space, const char* label,
                                  const void* const ptr, const uint64_t size)
     {
+        // the live bytes include the allocations which are not named
+        if(_kp_memory_analysis)
+        {
+            OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+            OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+            update_memory_space(space.name, -static_cast<int64_t>(size));
+        }
+
         if(violates_name_rules(label)) return;
         if(omnitrace::config::get_use_causal()) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(0, __FUNCTION__, space.name, label,
                                  JOIN("", '[', ptr, ']'), size);
         auto pname =
@@ -495,10 +950,20 @@ extern "C"
                                  const void* dst_ptr, SpaceHandle src_handle,
                                  const char* src_name, const void* src_ptr, uint64_t size)
     {
-        if(!_kp_deep_copy || omnitrace::config::get_use_causal()) return;
-        if(violates_name_rules(dst_name, src_name)) return;
+        if(omnitrace::config::get_use_causal()) return;
+
+        // the analysis pushes every deep copy so that the end always pops its entry
+        if(_kp_memory_analysis)
+        {
+            OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+            OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+            begin_deep_copy(src_handle.name, dst_handle.name, size);
+        }
+
+        if(!_kp_deep_copy || violates_name_rules(dst_name, src_name)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, dst_handle.name, dst_name,
                                  JOIN("", '[', dst_ptr, ']'), src_handle.name, src_name,
                                  JOIN("", '[', src_ptr, ']'), size);
@@ -517,9 +982,19 @@ extern "C"
 
     void kokkosp_end_deep_copy()
     {
-        if(!_kp_deep_copy || omnitrace::config::get_use_causal()) return;
+        if(omnitrace::config::get_use_causal()) return;
+
+        if(_kp_memory_analysis)
+        {
+            OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+            OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+            end_deep_copy();
+        }
+
+        if(!_kp_deep_copy) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__);
         auto& _data = kokkosp::get_profiler_stack<kokkosp_region>();
         if(_data.empty()) return;
@@ -534,6 +1009,7 @@ extern "C"
     void kokkosp_profile_event(const char* name)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         auto _name = tim::get_hash_identifier_fast(tim::add_hash_id(name));
         kokkosp::profiler_t<kokkosp_region>{ _name }.mark();
     }
@@ -545,6 +1021,7 @@ extern "C"
         if(violates_name_rules(label)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         if(omnitrace::config::get_use_perfetto())
         {
             auto _name = tim::get_hash_identifier_fast(
@@ -565,6 +1042,7 @@ extern "C"
         if(violates_name_rules(label)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
         if(omnitrace::config::get_use_perfetto())
         {
             auto _name = tim::get_hash_identifier_fast(
@@ -582,6 +1060,50 @@ extern "C"
     }
 
     //----------------------------------------------------------------------------------//
+
+    void kokkosp_declare_output_type(const char* name, const size_t id,
+                                     Kokkos_Tools_VariableInfo* info)
+    {
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        omnitrace::kokkosp_tuning::declare_output_type(name, id, info);
+    }
+
+    void kokkosp_declare_input_type(const char* name, const size_t id,
+                                    Kokkos_Tools_VariableInfo* info)
+    {
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        omnitrace::kokkosp_tuning::declare_input_type(name, id, info);
+    }
+
+    void kokkosp_request_values(const size_t                      context,
+                                const size_t                      num_inputs,
+                                const Kokkos_Tools_VariableValue* inputs,
+                                const size_t                      num_outputs,
+                                Kokkos_Tools_VariableValue*       outputs)
+    {
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        omnitrace::kokkosp_tuning::request_values(context, num_inputs, inputs,
+                                                  num_outputs, outputs);
+    }
+
+    void kokkosp_begin_context(const size_t context)
+    {
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        omnitrace::kokkosp_tuning::begin_context(context);
+    }
+
+    void kokkosp_end_context(const size_t context)
+    {
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SELF_PROFILE_SCOPE(kokkos);
+        omnitrace::kokkosp_tuning::end_context(context);
+    }
+
+    //----------------------------------------------------------------------------------//
 }
 
 TIMEMORY_INITIALIZE_STORAGE(kokkosp::memory_tracker)
@@ -0,0 +1,634 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "library/kokkosp_tuning.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace kokkosp_tuning
+{
+namespace
+{
+using value_t = Kokkos_Tools_VariableValue_ValueUnion;
+
+// the number of candidates of a range which is enumerated with its step
+constexpr size_t max_range_candidates = 64;
+
+// the number of candidates of a floating-point range without a step
+constexpr size_t num_interval_candidates = 16;
+
+struct variable_info
+{
+    std::string                                   name       = {};
+    Kokkos_Tools_VariableInfo_ValueType           type       = kokkos_value_int64;
+    Kokkos_Tools_VariableInfo_StatisticalCategory category   = kokkos_value_categorical;
+    std::vector<value_t>                          candidates = {};
+    std::deque<std::string>                       strings    = {};  // of the candidates
+};
+
+using indices_t = std::vector<uint32_t>;
+
+struct configuration
+{
+    indices_t indices = {};
+    uint64_t  count   = 0;
+    uint64_t  total   = 0;  // nanoseconds
+
+    double get_mean() const
+    {
+        return (count == 0) ? std::numeric_limits<double>::max()
+                            : static_cast<double>(total) / static_cast<double>(count);
+    }
+};
+
+struct persisted_entry
+{
+    double                   mean   = 0.0;  // nanoseconds
+    std::vector<std::string> values = {};   // name=value of every variable
+};
+
+struct problem
+{
+    std::vector<const variable_info*> variables = {};
+    size_t                            space     = 1;  // number of configurations
+    size_t                            trials    = 0;
+    std::vector<configuration>        configs   = {};
+    std::map<indices_t, size_t>       index     = {};
+    std::optional<indices_t>          persisted = {};
+    std::mt19937_64                   rng       = {};
+};
+
+struct active_context
+{
+    problem* tuned  = nullptr;
+    size_t   config = 0;
+    uint64_t beg    = 0;
+};
+
+// the variables are never removed so the problems refer to them
+struct tuning_data
+{
+    std::mutex                                      mutex      = {};
+    bool                                            enabled    = false;
+    size_t                                          max_trials = 0;
+    std::string                                     filename   = {};
+    std::unordered_map<size_t, variable_info>       outputs    = {};
+    std::unordered_map<size_t, variable_info>       inputs     = {};
+    std::map<std::string, std::unique_ptr<problem>> problems   = {};
+    std::unordered_map<size_t, active_context>      contexts   = {};
+    std::map<std::string, persisted_entry>          persisted  = {};
+};
+
+std::once_flag post_process_once{};
+
+// intentionally leaked so the callbacks during the static destruction are safe
+auto&
+get_data()
+{
+    static auto* _v = new tuning_data{};
+    return *_v;
+}
+
+// the tabs and the newlines separate the fields of the tuning file
+std::string
+sanitize(std::string _v)
+{
+    std::replace_if(
+        _v.begin(), _v.end(), [](char _c) { return _c == '\t' || _c == '\n'; }, ' ');
+    return _v;
+}
+
+std::string
+join_names(const std::vector<std::string>& _names)
+{
+    auto _ss = std::stringstream{};
+    for(size_t i = 0; i < _names.size(); ++i)
+        _ss << ((i == 0) ? "" : ",") << _names.at(i);
+    return _ss.str();
+}
+
+std::string
+format_value(Kokkos_Tools_VariableInfo_ValueType _type, const value_t& _v)
+{
+    switch(_type)
+    {
+        case kokkos_value_int64: return std::to_string(_v.int_value);
+        case kokkos_value_double:
+        {
+            std::stringstream _ss{};
+            _ss << std::setprecision(17) << _v.double_value;
+            return _ss.str();
+        }
+        case kokkos_value_string:
+            return sanitize((_v.string_value) ? _v.string_value : "");
+    }
+    return std::string{};
+}
+
+// the input values which are measured on a scale (e.g. the size of the problem) are
+// grouped by their power of two so similar inputs share the tuned configuration
+std::string
+format_feature(const variable_info* _info, const Kokkos_Tools_VariableValue& _v)
+{
+    auto _name = (_info) ? _info->name : JOIN("", "input", _v.type_id);
+    if(!_info) return JOIN('=', _name, "?");
+
+    auto _scaled = (_info->category == kokkos_value_interval ||
+                    _info->category == kokkos_value_ratio);
+    if(_scaled && _info->type == kokkos_value_int64)
+    {
+        auto _abs = static_cast<uint64_t>(std::abs(_v.value.int_value));
+        auto _exp = (_abs == 0) ? 0 : (64 - __builtin_clzll(_abs));
+        return JOIN("", _name, "=", (_v.value.int_value < 0) ? "-" : "", "2^", _exp);
+    }
+    if(_scaled && _info->type == kokkos_value_double)
+    {
+        auto _val = _v.value.double_value;
+        if(_val == 0.0 || !std::isfinite(_val)) return JOIN('=', _name, _val);
+        return JOIN("", _name, "=", (_val < 0.0) ? "-" : "", "2^", std::ilogb(_val));
+    }
+    return JOIN('=', _name, format_value(_info->type, _v.value));
+}
+
+template <typename Tp>
+void
+add_range(std::vector<value_t>& _candidates, Tp _lo, Tp _hi, Tp _step,
+          const Kokkos_Tools_ValueRange& _range, Tp value_t::*_member)
+{
+    if(_step <= Tp{ 0 }) return;
+    if(_range.openLower) _lo += _step;
+    auto _includes = [&](Tp _v) { return (_range.openUpper) ? (_v < _hi) : (_v <= _hi); };
+    if(!_includes(_lo)) return;
+
+    auto _n      = static_cast<size_t>((_hi - _lo) / _step) + 1;
+    auto _stride = (_n + max_range_candidates - 1) / max_range_candidates;
+    for(size_t i = 0; i < _n; i += _stride)
+    {
+        auto _v = static_cast<Tp>(_lo + static_cast<Tp>(i) * _step);
+        if(!_includes(_v)) break;
+        auto& _value    = _candidates.emplace_back();
+        _value.*_member = _v;
+    }
+}
+
+void
+set_candidates(variable_info& _var, const Kokkos_Tools_VariableInfo& _info)
+{
+    if(_info.valueQuantity == kokkos_value_set)
+    {
+        const auto& _set = _info.candidates.set;
+        for(size_t i = 0; i < _set.size; ++i)
+        {
+            auto& _value = _var.candidates.emplace_back();
+            switch(_info.type)
+            {
+                case kokkos_value_int64:
+                    _value.int_value = _set.values.int_value[i];
+                    break;
+                case kokkos_value_double:
+                    _value.double_value = _set.values.double_value[i];
+                    break;
+                case kokkos_value_string:
+                {
+                    const auto* _str = _set.values.string_value[i];
+                    _value.string_value =
+                        _var.strings.emplace_back((_str) ? _str : "").c_str();
+                    break;
+                }
+            }
+        }
+    }
+    else if(_info.valueQuantity == kokkos_value_range)
+    {
+        const auto& _range = _info.candidates.range;
+        if(_info.type == kokkos_value_int64)
+        {
+            add_range<int64_t>(_var.candidates, _range.lower.int_value,
+                               _range.upper.int_value,
+                               std::max<int64_t>(_range.step.int_value, 1), _range,
+                               &value_t::int_value);
+        }
+        else if(_info.type == kokkos_value_double && _range.step.double_value > 0.0)
+        {
+            add_range<double>(_var.candidates, _range.lower.double_value,
+                              _range.upper.double_value, _range.step.double_value,
+                              _range, &value_t::double_value);
+        }
+        else if(_info.type == kokkos_value_double)
+        {
+            // evenly spaced values which exclude the open ends of the range
+            auto _lo = _range.lower.double_value;
+            auto _hi = _range.upper.double_value;
+            auto _n  = static_cast<double>(num_interval_candidates);
+            for(size_t i = 0; i < num_interval_candidates && _hi > _lo; ++i)
+            {
+                auto _i = static_cast<double>(i);
+                auto _f = (_range.openLower || _range.openUpper) ? ((_i + 0.5) / _n)
+                                                                 : (_i / (_n - 1.0));
+                auto& _value        = _var.candidates.emplace_back();
+                _value.double_value = _lo + (_f * (_hi - _lo));
+            }
+        }
+    }
+    // the unbounded variables have no candidates and are not tuned
+}
+
+// requires the mutex of the data
+void
+register_variable(std::unordered_map<size_t, variable_info>& _variables,
+                  const char* _name, size_t _id, const Kokkos_Tools_VariableInfo* _info,
+                  bool _tuned)
+{
+    if(_info == nullptr) return;
+
+    auto& _var    = _variables[_id];
+    _var.name     = sanitize((_name) ? _name : JOIN("", "variable", _id));
+    _var.type     = _info->type;
+    _var.category = _info->category;
+    _var.candidates.clear();
+    _var.strings.clear();
+    if(_tuned) set_candidates(_var, *_info);
+
+    OMNITRACE_VERBOSE_F(2,
+                        "[kokkos-tuning] %s variable '%s' (id %zu) with %zu candidates\n",
+                        (_tuned) ? "tuning" : "context", _var.name.c_str(), _id,
+                        _var.candidates.size());
+}
+
+const configuration*
+get_best(const problem& _problem)
+{
+    const configuration* _best = nullptr;
+    for(const auto& itr : _problem.configs)
+    {
+        if(itr.count > 0 && (!_best || itr.get_mean() < _best->get_mean())) _best = &itr;
+    }
+    return _best;
+}
+
+// requires the mutex of the data
+std::optional<indices_t>
+get_persisted(const tuning_data& _data, const std::string& _key, const problem& _problem)
+{
+    auto itr = _data.persisted.find(_key);
+    if(itr == _data.persisted.end()) return std::nullopt;
+
+    auto _indices = indices_t{};
+    for(const auto* vitr : _problem.variables)
+    {
+        auto _found = false;
+        for(size_t i = 0; i < vitr->candidates.size() && !_found; ++i)
+        {
+            auto _value =
+                JOIN('=', vitr->name, format_value(vitr->type, vitr->candidates[i]));
+            if(std::find(itr->second.values.begin(), itr->second.values.end(), _value) !=
+               itr->second.values.end())
+            {
+                _indices.emplace_back(i);
+                _found = true;
+            }
+        }
+        // the candidates changed since the configuration was saved
+        if(!_found) return std::nullopt;
+    }
+    return _indices;
+}
+
+// requires the mutex of the data
+indices_t
+select(tuning_data& _data, problem& _problem)
+{
+    if(_problem.persisted) return *_problem.persisted;
+
+    auto _exhausted =
+        (_problem.space <= _data.max_trials && _problem.trials >= _problem.space);
+    if(_problem.trials < _data.max_trials && !_exhausted)
+    {
+        auto _trial   = _problem.trials++;
+        auto _indices = indices_t{};
+        for(const auto* itr : _problem.variables)
+        {
+            auto _n = itr->candidates.size();
+            if(_problem.space <= _data.max_trials)
+            {
+                // every configuration is measured once, in order
+                _indices.emplace_back(_trial % _n);
+                _trial /= _n;
+            }
+            else
+            {
+                _indices.emplace_back(
+                    std::uniform_int_distribution<size_t>{ 0, _n - 1 }(_problem.rng));
+            }
+        }
+        return _indices;
+    }
+
+    if(const auto* _best = get_best(_problem)) return _best->indices;
+    return indices_t(_problem.variables.size(), 0);
+}
+
+// requires the mutex of the data
+void
+read_persisted(tuning_data& _data)
+{
+    auto ifs = std::ifstream{ _data.filename };
+    if(!ifs) return;
+
+    auto _line = std::string{};
+    while(std::getline(ifs, _line))
+    {
+        if(_line.empty() || _line.front() == '#') continue;
+        auto _fields = tim::delimit(_line, "\t");
+        if(_fields.size() < 3) continue;
+
+        auto _entry = persisted_entry{};
+        try
+        {
+            _entry.mean = std::stod(_fields.at(1));
+        } catch(std::exception&)
+        {
+            continue;
+        }
+        _entry.values.assign(_fields.begin() + 2, _fields.end());
+        _data.persisted[_fields.at(0)] = std::move(_entry);
+    }
+
+    OMNITRACE_VERBOSE_F(1, "[kokkos-tuning] read %zu tuned configurations from '%s'\n",
+                        _data.persisted.size(), _data.filename.c_str());
+}
+
+std::vector<std::string>
+get_values(const problem& _problem, const indices_t& _indices)
+{
+    auto _values = std::vector<std::string>{};
+    for(size_t i = 0; i < _problem.variables.size(); ++i)
+    {
+        const auto* _var   = _problem.variables.at(i);
+        const auto& _value = _var->candidates.at(_indices.at(i));
+        _values.emplace_back(JOIN('=', _var->name, format_value(_var->type, _value)));
+    }
+    return _values;
+}
+
+// requires the mutex of the data
+void
+write_persisted(tuning_data& _data)
+{
+    for(const auto& itr : _data.problems)
+    {
+        const auto* _best = get_best(*itr.second);
+        if(!_best) continue;
+        _data.persisted[itr.first] =
+            persisted_entry{ _best->get_mean(), get_values(*itr.second, _best->indices) };
+    }
+
+    if(_data.persisted.empty() || _data.filename.empty()) return;
+
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _data.filename))
+    {
+        OMNITRACE_THROW("Error opening kokkos tuning file: %s", _data.filename.c_str());
+    }
+
+    OMNITRACE_VERBOSE_F(0, "Outputting '%s'...\n", _data.filename.c_str());
+    ofs << "# problem\tmean_ns\tvalues...\n" << std::setprecision(3) << std::fixed;
+    for(const auto& itr : _data.persisted)
+    {
+        ofs << itr.first << "\t" << itr.second.mean;
+        for(const auto& vitr : itr.second.values)
+            ofs << "\t" << vitr;
+        ofs << "\n";
+    }
+}
+
+// requires the mutex of the data
+void
+write_report(const tuning_data& _data)
+{
+    if(_data.problems.empty()) return;
+
+    auto _fname = tim::settings::compose_output_filename("kokkos-tuning", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening kokkos tuning output file: %s", _fname.c_str());
+    }
+
+    OMNITRACE_VERBOSE_F(0, "Outputting '%s'...\n", _fname.c_str());
+    ofs << std::setprecision(3) << std::fixed;
+    for(const auto& itr : _data.problems)
+    {
+        const auto& _problem = *itr.second;
+        const auto* _best    = get_best(_problem);
+        ofs << itr.first << "\n"
+            << "    configurations: " << _problem.space
+            << ", measured: " << _problem.configs.size()
+            << ", source: " << ((_problem.persisted) ? "tuning file" : "this run")
+            << "\n";
+        if(!_best)
+        {
+            ofs << "    no completed measurement\n\n";
+            continue;
+        }
+
+        ofs << "    best: mean (usec): " << (_best->get_mean() / units::usec)
+            << ", measurements: " << _best->count << "\n";
+        for(const auto& vitr : get_values(_problem, _best->indices))
+            ofs << "        " << vitr << "\n";
+        ofs << "\n";
+    }
+}
+}  // namespace
+
+void
+setup()
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    _data.enabled =
+        config::get_setting_value<bool>("OMNITRACE_KOKKOSP_TUNING").value_or(false);
+    _data.max_trials = std::max<int64_t>(
+        config::get_setting_value<int64_t>("OMNITRACE_KOKKOSP_TUNING_TRIALS")
+            .value_or(16),
+        1);
+    _data.filename =
+        config::get_setting_value<std::string>("OMNITRACE_KOKKOSP_TUNING_FILE")
+            .value_or(std::string{});
+
+    if(_data.enabled && !_data.filename.empty()) read_persisted(_data);
+}
+
+void
+declare_output_type(const char* _name, size_t _id, const Kokkos_Tools_VariableInfo* _info)
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    if(_data.enabled) register_variable(_data.outputs, _name, _id, _info, true);
+}
+
+void
+declare_input_type(const char* _name, size_t _id, const Kokkos_Tools_VariableInfo* _info)
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    if(_data.enabled) register_variable(_data.inputs, _name, _id, _info, false);
+}
+
+void
+request_values(size_t _context, size_t _num_inputs,
+               const Kokkos_Tools_VariableValue* _inputs, size_t _num_outputs,
+               Kokkos_Tools_VariableValue* _outputs)
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    if(!_data.enabled || _num_outputs == 0 || _outputs == nullptr) return;
+
+    // the variables which can be tuned and their position in the request
+    auto _tuned     = std::vector<std::pair<size_t, const variable_info*>>{};
+    auto _variables = std::vector<std::string>{};
+    for(size_t i = 0; i < _num_outputs; ++i)
+    {
+        auto itr = _data.outputs.find(_outputs[i].type_id);
+        if(itr == _data.outputs.end() || itr->second.candidates.empty()) continue;
+        _tuned.emplace_back(i, &itr->second);
+        _variables.emplace_back(itr->second.name);
+    }
+    if(_tuned.empty()) return;
+
+    auto _features = std::vector<std::string>{};
+    for(size_t i = 0; i < _num_inputs && _inputs != nullptr; ++i)
+    {
+        auto        itr   = _data.inputs.find(_inputs[i].type_id);
+        const auto* _info = (itr != _data.inputs.end()) ? &itr->second : nullptr;
+        _features.emplace_back(format_feature(_info, _inputs[i]));
+    }
+    std::sort(_features.begin(), _features.end());
+
+    auto _key =
+        JOIN("", "tune: ", join_names(_variables), "; inputs: ", join_names(_features));
+    auto& _problem = _data.problems[_key];
+    if(!_problem)
+    {
+        _problem = std::make_unique<problem>();
+        for(const auto& itr : _tuned)
+        {
+            _problem->variables.emplace_back(itr.second);
+            auto _n = itr.second->candidates.size();
+            _problem->space = (_problem->space > std::numeric_limits<size_t>::max() / _n)
+                                  ? std::numeric_limits<size_t>::max()
+                                  : (_problem->space * _n);
+        }
+        _problem->rng.seed(std::hash<std::string>{}(_key));
+        _problem->persisted = get_persisted(_data, _key, *_problem);
+    }
+
+    auto _indices = select(_data, *_problem);
+    for(size_t i = 0; i < _tuned.size(); ++i)
+        _outputs[_tuned.at(i).first].value =
+            _tuned.at(i).second->candidates.at(_indices.at(i));
+
+    auto itr = _problem->index.find(_indices);
+    if(itr == _problem->index.end())
+    {
+        itr = _problem->index.emplace(_indices, _problem->configs.size()).first;
+        _problem->configs.emplace_back(configuration{ _indices });
+    }
+
+    _data.contexts[_context] =
+        active_context{ _problem.get(), itr->second, tracing::now<uint64_t>() };
+}
+
+void
+begin_context(size_t _context)
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    // the id of a context which ended without a request is reused
+    _data.contexts.erase(_context);
+}
+
+void
+end_context(size_t _context)
+{
+    auto  _end  = tracing::now<uint64_t>();
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  itr   = _data.contexts.find(_context);
+    if(itr == _data.contexts.end()) return;
+
+    auto& _config = itr->second.tuned->configs.at(itr->second.config);
+    _config.count += 1;
+    _config.total += (_end > itr->second.beg) ? (_end - itr->second.beg) : 0;
+    _data.contexts.erase(itr);
+}
+
+void
+post_process()
+{
+    std::call_once(post_process_once, []() {
+        auto& _data = get_data();
+        auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+        if(!_data.enabled) return;
+
+        _data.enabled = false;
+        try
+        {
+            write_persisted(_data);
+            write_report(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the kokkos tuning failed: %s\n", _e.what());
+        }
+    });
+}
+}  // namespace kokkosp_tuning
+}  // namespace omnitrace
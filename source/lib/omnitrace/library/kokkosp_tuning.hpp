@@ -0,0 +1,145 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// the types of the Kokkos Tools tuning interface (Kokkos_Profiling_C_Interface.h)
+extern "C"
+{
+    enum Kokkos_Tools_VariableInfo_ValueType
+    {
+        kokkos_value_double,
+        kokkos_value_int64,
+        kokkos_value_string,
+    };
+
+    enum Kokkos_Tools_VariableInfo_StatisticalCategory
+    {
+        kokkos_value_categorical,
+        kokkos_value_ordinal,
+        kokkos_value_interval,
+        kokkos_value_ratio
+    };
+
+    enum Kokkos_Tools_VariableInfo_CandidateValueType
+    {
+        kokkos_value_set,
+        kokkos_value_range,
+        kokkos_value_unbounded
+    };
+
+    union Kokkos_Tools_VariableValue_ValueUnion
+    {
+        int64_t     int_value;
+        double      double_value;
+        const char* string_value;
+    };
+
+    union Kokkos_Tools_VariableValue_ValueUnionSet
+    {
+        int64_t*     int_value;
+        double*      double_value;
+        const char** string_value;
+    };
+
+    struct Kokkos_Tools_ValueSet
+    {
+        size_t                                         size;
+        union Kokkos_Tools_VariableValue_ValueUnionSet values;
+    };
+
+    struct Kokkos_Tools_ValueRange
+    {
+        union Kokkos_Tools_VariableValue_ValueUnion lower;
+        union Kokkos_Tools_VariableValue_ValueUnion upper;
+        union Kokkos_Tools_VariableValue_ValueUnion step;
+        bool                                        openLower;
+        bool                                        openUpper;
+    };
+
+    union Kokkos_Tools_VariableInfo_SetOrRange
+    {
+        struct Kokkos_Tools_ValueSet   set;
+        struct Kokkos_Tools_ValueRange range;
+    };
+
+    struct Kokkos_Tools_VariableInfo
+    {
+        enum Kokkos_Tools_VariableInfo_ValueType           type;
+        enum Kokkos_Tools_VariableInfo_StatisticalCategory category;
+        enum Kokkos_Tools_VariableInfo_CandidateValueType  valueQuantity;
+        union Kokkos_Tools_VariableInfo_SetOrRange         candidates;
+        void*                                              toolProvidedInfo;
+    };
+
+    struct Kokkos_Tools_VariableValue
+    {
+        size_t                                      type_id;
+        union Kokkos_Tools_VariableValue_ValueUnion value;
+        struct Kokkos_Tools_VariableInfo*           metadata;
+    };
+}
+
+namespace omnitrace
+{
+/// the online autotuner behind the Kokkos Tools tuning interface (see
+/// OMNITRACE_KOKKOSP_TUNING). A tuning problem is the set of tuning variables requested
+/// together and the values of the context variables (the features of the input, e.g.
+/// the name of the kernel). The candidates of every tuning variable are its declared
+/// set or, for a range, up to 64 values of the range. The first requests of a problem
+/// measure the configurations (exhaustively if they fit the number of trials, else at
+/// random) from the request to the end of the context and the later requests use the
+/// fastest configuration. The best configuration of every problem is written to a file
+/// at finalization and used directly by the later runs
+namespace kokkosp_tuning
+{
+/// reads the settings and the best configurations of the previous runs
+void
+setup();
+
+void
+declare_output_type(const char* _name, size_t _id, const Kokkos_Tools_VariableInfo*);
+
+void
+declare_input_type(const char* _name, size_t _id, const Kokkos_Tools_VariableInfo*);
+
+/// sets the values of the tuning variables. The values are left unchanged (the
+/// defaults of Kokkos) if the tuning is disabled or the variables cannot be tuned
+void
+request_values(size_t _context, size_t _num_inputs, const Kokkos_Tools_VariableValue*,
+               size_t _num_outputs, Kokkos_Tools_VariableValue*);
+
+void
+begin_context(size_t _context);
+
+void
+end_context(size_t _context);
+
+/// writes the best configurations and the report. Only the first invocation has an
+/// effect
+void
+post_process();
+}  // namespace kokkosp_tuning
+}  // namespace omnitrace
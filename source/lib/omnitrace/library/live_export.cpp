@@ -0,0 +1,478 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/live_export.hpp"
+#include "binary/analysis.hpp"
+#include "common/live_segment.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/gpu.hpp"
+#include "core/locking.hpp"
+#include "core/timemory.hpp"
+#include "library/frame_pointer.hpp"
+#include "library/rocm_smi.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/utility/demangle.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace live_export
+{
+namespace
+{
+namespace live = ::omnitrace::common::live_segment;
+
+struct region_stats
+{
+    uint64_t count = 0;
+    uint64_t time  = 0;
+};
+
+// only the owning thread updates its regions. The lock is uncontended unless the
+// process sampler is merging them
+struct thread_regions
+{
+    locking::atomic_mutex                      mutex   = {};
+    std::unordered_map<uint64_t, region_stats> regions = {};
+    std::vector<std::pair<uint64_t, uint64_t>> open    = {};  // hash and begin
+};
+
+using thread_regions_data = omnitrace::thread_data<thread_regions, thread_regions>;
+
+// the interrupted functions are counted by address in the signal handlers, i.e.
+// without allocating or locking, and named by the process sampler
+struct sample_slot
+{
+    std::atomic<uintptr_t> address = { 0 };
+    std::atomic<uint64_t>  count   = { 0 };
+};
+
+constexpr size_t num_sample_slots = 4096;
+constexpr size_t max_sample_probe = 16;
+
+struct device_stats
+{
+    std::atomic<uint64_t> kernels = { 0 };
+    std::atomic<uint64_t> time    = { 0 };
+};
+
+struct live_data
+{
+    std::mutex            mutex     = {};  // the segment and the scratch payload
+    std::string           name      = {};
+    live::segment*        shm       = nullptr;
+    uint64_t              interval  = 0;  // nsec
+    uint64_t              last      = 0;  // nsec of the last update
+    uint64_t              updates   = 0;
+    live::payload         scratch   = {};
+    std::atomic<uint64_t> samples   = { 0 };
+    std::atomic<uint64_t> dropped   = { 0 };  // samples without a free slot
+    std::atomic<uint64_t> comm_size = { 0 };
+    std::atomic<uint64_t> comm_ops  = { 0 };
+
+    std::array<sample_slot, num_sample_slots>   slots   = {};
+    std::array<device_stats, live::max_devices> devices = {};
+    std::unordered_map<uintptr_t, std::string>  names   = {};  // sampler thread only
+};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+// intentionally leaked so the signal handlers and the wrappers never see it destroyed
+live_data&
+get_data()
+{
+    static auto* _v = new live_data{};
+    return *_v;
+}
+
+thread_regions&
+get_local_regions()
+{
+    auto& _v =
+        thread_regions_data::instance(construct_on_thread{ tim::threading::get_id() });
+    if(!_v) _v = std::make_unique<thread_regions>();
+    return *_v;
+}
+
+void
+copy_name(char* _dst, std::string_view _src)
+{
+    auto _n = std::min(_src.size(), live::name_length);
+    std::memcpy(_dst, _src.data(), _n);
+    _dst[_n] = '\0';
+}
+
+const std::string&
+get_function_name(live_data& _data, uintptr_t _addr)
+{
+    auto itr = _data.names.find(_addr);
+    if(itr != _data.names.end()) return itr->second;
+
+    auto _name = std::string{};
+    if(auto _entry = binary::lookup_ipaddr_entry<false>(_addr); _entry)
+        _name = tim::demangle(_entry->name);
+    if(_name.empty())
+    {
+        char _buffer[32] = {};
+        std::snprintf(_buffer, sizeof(_buffer), "%#lx",
+                      static_cast<unsigned long>(_addr));
+        _name = _buffer;
+    }
+    return (_data.names[_addr] = std::move(_name));
+}
+
+template <typename Tp, typename FuncT>
+void
+select_top(std::vector<Tp>& _v, size_t _n, FuncT&& _greater)
+{
+    if(_v.size() > _n)
+    {
+        std::partial_sort(_v.begin(), _v.begin() + _n, _v.end(), _greater);
+        _v.resize(_n);
+    }
+    else
+    {
+        std::sort(_v.begin(), _v.end(), _greater);
+    }
+}
+
+void
+fill_regions(live::payload& _v)
+{
+    auto _merged = std::unordered_map<uint64_t, region_stats>{};
+    if(thread_regions_data::get())
+    {
+        for(auto& itr : *thread_regions_data::get())
+        {
+            if(!itr) continue;
+            auto _lk = locking::atomic_lock{ itr->mutex };
+            for(const auto& ritr : itr->regions)
+            {
+                auto& _region = _merged[ritr.first];
+                _region.count += ritr.second.count;
+                _region.time += ritr.second.time;
+            }
+        }
+    }
+
+    auto _regions = std::vector<std::pair<uint64_t, region_stats>>{ _merged.begin(),
+                                                                    _merged.end() };
+    select_top(_regions, live::max_regions, [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.time > _rhs.second.time;
+    });
+
+    _v.num_regions = _regions.size();
+    for(size_t i = 0; i < _regions.size(); ++i)
+    {
+        auto& _entry = _v.regions[i];
+        _entry.count = _regions.at(i).second.count;
+        _entry.time  = _regions.at(i).second.time;
+        copy_name(_entry.name, tim::get_hash_identifier_fast(_regions.at(i).first));
+    }
+}
+
+void
+fill_functions(live_data& _data, live::payload& _v)
+{
+    auto _merged = std::unordered_map<std::string, uint64_t>{};
+    for(auto& itr : _data.slots)
+    {
+        auto _addr = itr.address.load(std::memory_order_acquire);
+        if(_addr == 0) continue;
+        auto _count = itr.count.load(std::memory_order_relaxed);
+        if(_count > 0) _merged[get_function_name(_data, _addr)] += _count;
+    }
+
+    auto _functions =
+        std::vector<std::pair<std::string, uint64_t>>{ _merged.begin(), _merged.end() };
+    select_top(_functions, live::max_functions,
+               [](const auto& _lhs, const auto& _rhs) {
+                   return _lhs.second > _rhs.second;
+               });
+
+    _v.samples       = _data.samples.load(std::memory_order_relaxed);
+    _v.num_functions = _functions.size();
+    for(size_t i = 0; i < _functions.size(); ++i)
+    {
+        _v.functions[i].samples = _functions.at(i).second;
+        copy_name(_v.functions[i].name, _functions.at(i).first);
+    }
+}
+
+void
+fill_devices(live_data& _data, live::payload& _v)
+{
+    size_t _n = (get_use_rocm_smi()) ? gpu::rsmi_device_count() : 0;
+    for(size_t i = 0; i < _data.devices.size(); ++i)
+    {
+        if(_data.devices.at(i).kernels.load(std::memory_order_relaxed) > 0)
+            _n = std::max(_n, i + 1);
+    }
+
+    _v.num_devices = std::min(_n, live::max_devices);
+    for(uint32_t i = 0; i < _v.num_devices; ++i)
+    {
+        auto& _entry       = _v.devices[i];
+        _entry.busy        = rocm_smi::get_busy(i).value_or(-1.0);
+        _entry.memory      = static_cast<int64_t>(rocm_smi::get_memory_usage(i).value_or(
+            static_cast<uint64_t>(-1)));
+        _entry.kernels     = _data.devices.at(i).kernels.load(std::memory_order_relaxed);
+        _entry.kernel_time = _data.devices.at(i).time.load(std::memory_order_relaxed);
+    }
+}
+
+// requires the mutex of the data
+void
+publish(live_data& _data, bool _finished)
+{
+    if(!_data.shm) return;
+
+    auto& _v = _data.scratch;
+    _v       = live::payload{};
+
+    fill_regions(_v);
+    fill_functions(_data, _v);
+    fill_devices(_data, _v);
+
+    _v.timestamp     = tim::get_clock_real_now<uint64_t, std::nano>();
+    _v.updates       = ++_data.updates;
+    _v.comm_bytes    = _data.comm_size.load(std::memory_order_relaxed);
+    _v.comm_messages = _data.comm_ops.load(std::memory_order_relaxed);
+    _v.finished      = (_finished) ? 1 : 0;
+
+    // only the copy happens within the update so the readers rarely retry
+    live::begin_update(*_data.shm);
+    std::memcpy(&_data.shm->data, &_v, sizeof(_v));
+    live::end_update(*_data.shm);
+}
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_snapshot().live_export) return;
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    if(_data.shm) return;
+
+    _data.name     = config::get_live_export_name();
+    _data.interval = static_cast<uint64_t>(
+        std::max(config::get_live_export_interval(), 0.0) * units::sec);
+
+    auto _fd = shm_open(_data.name.c_str(), O_CREAT | O_RDWR, 0644);
+    if(_fd < 0)
+    {
+        OMNITRACE_WARNING_F(0, "Unable to create the shared memory segment '%s': %s\n",
+                            _data.name.c_str(), strerror(errno));
+        return;
+    }
+
+    void* _addr = MAP_FAILED;
+    if(ftruncate(_fd, sizeof(live::segment)) == 0)
+        _addr = mmap(nullptr, sizeof(live::segment), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, _fd, 0);
+    auto _err = errno;
+    close(_fd);
+
+    if(_addr == MAP_FAILED)
+    {
+        OMNITRACE_WARNING_F(0, "Unable to map the shared memory segment '%s': %s\n",
+                            _data.name.c_str(), strerror(_err));
+        shm_unlink(_data.name.c_str());
+        return;
+    }
+
+    // the readers check the magic, which is set after the rest of the header
+    auto* _shm     = new(_addr) live::segment{};
+    _shm->version  = live::version;
+    _shm->size     = sizeof(live::segment);
+    _shm->pid      = getpid();
+    _shm->start    = tim::get_clock_real_now<uint64_t, std::nano>();
+    _shm->interval = _data.interval;
+    std::atomic_thread_fence(std::memory_order_release);
+    _shm->magic = live::magic;
+
+    _data.shm = _shm;
+    get_active().store(true);
+
+    OMNITRACE_VERBOSE_F(1, "Publishing the live export to the shared memory segment "
+                           "'%s' every %.3f seconds...\n",
+                        _data.name.c_str(),
+                        static_cast<double>(_data.interval) / units::sec);
+}
+
+void
+config()
+{}
+
+void
+sample()
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _data = get_data();
+    auto  _now  = tim::get_clock_real_now<uint64_t, std::nano>();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex, std::try_to_lock };
+    if(!_lk.owns_lock() || (_data.last > 0 && _now < _data.last + _data.interval))
+        return;
+
+    _data.last = _now;
+    publish(_data, false);
+}
+
+void
+shutdown()
+{
+    if(!get_active().exchange(false)) return;
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    if(!_data.shm) return;
+
+    publish(_data, true);
+
+    OMNITRACE_VERBOSE_F(1, "Removing the shared memory segment '%s' (%zu updates, %zu "
+                           "samples without a slot)...\n",
+                        _data.name.c_str(), static_cast<size_t>(_data.updates),
+                        static_cast<size_t>(_data.dropped.load()));
+
+    // the readers which already mapped the segment keep the last update
+    munmap(_data.shm, sizeof(live::segment));
+    shm_unlink(_data.name.c_str());
+    _data.shm = nullptr;
+}
+
+void
+post_process()
+{}
+
+void
+region_begin(uint64_t _hash)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _v  = get_local_regions();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    _v.open.emplace_back(_hash, tracing::now());
+}
+
+void
+region_end(uint64_t _hash)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto  _ts = tracing::now();
+    auto& _v  = get_local_regions();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    for(auto itr = _v.open.rbegin(); itr != _v.open.rend(); ++itr)
+    {
+        if(itr->first != _hash) continue;
+        auto& _region = _v.regions[_hash];
+        _region.count += 1;
+        _region.time += (_ts > itr->second) ? (_ts - itr->second) : 0;
+        _v.open.erase(std::next(itr).base());
+        return;
+    }
+}
+
+void
+record_sample(int _signo)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _data = get_data();
+    _data.samples.fetch_add(1, std::memory_order_relaxed);
+
+    auto _addr = frame_pointer::interrupted_pc(_signo);
+    if(_addr == 0) return;
+
+    auto _idx = (_addr * 0x9e3779b97f4a7c15ULL) >> 52;  // 4096 slots
+    for(size_t i = 0; i < max_sample_probe; ++i)
+    {
+        auto& _slot     = _data.slots[(_idx + i) % num_sample_slots];
+        auto  _expected = _slot.address.load(std::memory_order_relaxed);
+        if(_expected == 0 &&
+           _slot.address.compare_exchange_strong(_expected, _addr,
+                                                 std::memory_order_acq_rel))
+            _expected = _addr;
+        if(_expected != _addr) continue;
+
+        _slot.count.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    _data.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+device_op(int32_t _device, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+    if(_device < 0 || static_cast<size_t>(_device) >= live::max_devices) return;
+
+    auto& _v = get_data().devices.at(_device);
+    _v.kernels.fetch_add(1, std::memory_order_relaxed);
+    if(_end_ns > _beg_ns) _v.time.fetch_add(_end_ns - _beg_ns, std::memory_order_relaxed);
+}
+
+void
+record_comm(uint64_t _bytes)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _data = get_data();
+    _data.comm_size.fetch_add(_bytes, std::memory_order_relaxed);
+    _data.comm_ops.fetch_add(1, std::memory_order_relaxed);
+}
+}  // namespace live_export
+}  // namespace omnitrace
@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// live export of rolling aggregates while the application runs (see
+/// OMNITRACE_LIVE_EXPORT). The application threads only update their own counters;
+/// the background process sampler merges them every OMNITRACE_LIVE_EXPORT_INTERVAL
+/// and publishes them into the shared-memory segment described in
+/// common/live_segment.hpp, which omnitrace-live reads
+namespace live_export
+{
+/// creates the shared-memory segment. Called by the process sampler
+void
+setup();
+
+void
+config();
+
+/// publishes the aggregates if the interval has elapsed since the last update
+void
+sample();
+
+/// publishes the last update and removes the segment
+void
+shutdown();
+
+void
+post_process();
+
+/// the regions of the host, user, Python, Kokkos and ROCTx categories
+void
+region_begin(uint64_t _hash);
+
+void
+region_end(uint64_t _hash);
+
+/// counts the function interrupted by a sampling signal. Async-signal-safe
+void
+record_sample(int _signo);
+
+/// a kernel which ran on the device
+void
+device_op(int32_t _device, uint64_t _beg_ns, uint64_t _end_ns);
+
+/// the bytes of a MPI or RCCL operation
+void
+record_comm(uint64_t _bytes);
+}  // namespace live_export
+}  // namespace omnitrace
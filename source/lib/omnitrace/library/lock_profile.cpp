@@ -0,0 +1,322 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/lock_profile.hpp"
+#include "binary/analysis.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/backtrace.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace lock_profile
+{
+namespace
+{
+struct entry
+{
+    uint64_t count = 0;
+    uint64_t total = 0;  // nanoseconds
+    uint64_t max   = 0;  // nanoseconds
+
+    void add(uint64_t _wait)
+    {
+        count += 1;
+        total += _wait;
+        max = std::max(max, _wait);
+    }
+
+    entry& operator+=(const entry& _rhs)
+    {
+        count += _rhs.count;
+        total += _rhs.total;
+        max = std::max(max, _rhs.max);
+        return *this;
+    }
+};
+
+// open-addressing table with linear probing. A slot is empty until its count is
+// non-zero and the slots are never removed so only the owning thread writes to it
+struct thread_table
+{
+    struct slot
+    {
+        uintptr_t lock      = 0;
+        uintptr_t call_site = 0;
+        entry     data      = {};
+    };
+
+    std::array<slot, thread_capacity> slots    = {};
+    entry                             overflow = {};
+};
+
+using thread_table_data = omnitrace::thread_data<thread_table, thread_table>;
+
+// lock address, call-site
+using merged_key  = std::pair<uintptr_t, uintptr_t>;
+using merged_data = std::map<merged_key, entry>;
+
+auto&
+get_thread_table(int64_t _tid = tim::threading::get_id())
+{
+    return thread_table_data::instance(construct_on_thread{ _tid });
+}
+
+size_t
+get_slot(uintptr_t _lock, uintptr_t _call_site)
+{
+    auto _v = (_lock ^ (_call_site * 0x9e3779b97f4a7c15ULL));
+    return static_cast<size_t>(_v ^ (_v >> 29)) % thread_capacity;
+}
+
+std::string
+get_call_site_label(uintptr_t _call_site)
+{
+    if(_call_site == 0) return std::string{ "??" };
+    if(auto _val = binary::lookup_ipaddr_entry<false>(_call_site); _val)
+    {
+        auto _func = (_val->name.empty()) ? "??" : demangle(_val->name);
+        if(_val->location.empty()) return _func;
+        auto _line = (_val->lineno == 0) ? "?" : JOIN("", _val->lineno);
+        return JOIN("", _func, " @ ", _val->location, ":", _line);
+    }
+    return as_hex(_call_site);
+}
+
+// sorted by the total wait time in descending order
+std::vector<std::pair<merged_key, entry>>
+get_sorted(const merged_data& _data)
+{
+    auto _v = std::vector<std::pair<merged_key, entry>>{ _data.begin(), _data.end() };
+    std::sort(_v.begin(), _v.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.total > _rhs.second.total;
+    });
+    return _v;
+}
+
+void
+write_text(const merged_data& _data, const merged_data& _locks, const entry& _overflow)
+{
+    auto _fname = tim::settings::compose_output_filename("lock_profile", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening lock_profile output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<entry>{}(_fname, std::string{ "lock_profile" });
+
+    auto _write_header = [&ofs](const char* _label) {
+        ofs << std::setw(18) << "lock" << " | " << std::setw(12) << "count" << " | "
+            << std::setw(14) << "wait (msec)" << " | " << std::setw(12) << "mean (usec)"
+            << " | " << std::setw(12) << "max (usec)" << " | " << _label << "\n";
+    };
+
+    auto _write_entry = [&ofs](uintptr_t _lock, const entry& _v) {
+        ofs << std::setw(18) << as_hex(_lock) << " | " << std::setw(12) << _v.count
+            << " | " << std::setw(14) << (static_cast<double>(_v.total) / units::msec)
+            << " | " << std::setw(12)
+            << (static_cast<double>(_v.total) / std::max<uint64_t>(_v.count, 1) /
+                units::usec)
+            << " | " << std::setw(12) << (static_cast<double>(_v.max) / units::usec)
+            << " | ";
+    };
+
+    ofs << std::setprecision(3) << std::fixed;
+
+    _write_header("call-sites");
+    for(const auto& itr : get_sorted(_locks))
+    {
+        _write_entry(itr.first.first, itr.second);
+        ofs << itr.first.second << "\n";
+    }
+    ofs << "\n";
+
+    _write_header("call-site");
+    for(const auto& itr : get_sorted(_data))
+    {
+        _write_entry(itr.first.first, itr.second);
+        ofs << get_call_site_label(itr.first.second) << "\n";
+    }
+
+    if(_overflow.count > 0)
+    {
+        ofs << "\n" << _overflow.count << " acquisitions (" << std::setprecision(3)
+            << (static_cast<double>(_overflow.total) / units::msec)
+            << " msec) exceeded the capacity of " << thread_capacity
+            << " entries per thread\n";
+    }
+}
+
+void
+write_json(const merged_data& _data, const entry& _overflow)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("lock_profile");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("overflow_count", _overflow.count),
+              cereal::make_nvp("overflow_wait_ns", _overflow.total));
+
+        ar->setNextName("entries");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : get_sorted(_data))
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("lock", as_hex(itr.first.first)),
+                  cereal::make_nvp("call_site", get_call_site_label(itr.first.second)),
+                  cereal::make_nvp("call_site_address", itr.first.second),
+                  cereal::make_nvp("count", itr.second.count),
+                  cereal::make_nvp("total_wait_ns", itr.second.total),
+                  cereal::make_nvp("max_wait_ns", itr.second.max));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("lock_profile", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening lock_profile output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<entry>{}(_fname, std::string{ "lock_profile" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+uintptr_t
+get_call_site()
+{
+    constexpr size_t stack_depth       = 16;
+    constexpr size_t ignore_depth      = 1;
+    constexpr bool   with_signal_frame = false;
+
+    for(auto itr : tim::get_unw_stack<stack_depth, ignore_depth, with_signal_frame>())
+    {
+        if(itr && !binary::is_internal_ipaddr(itr->address())) return itr->address();
+    }
+    return 0;
+}
+
+void
+record(uintptr_t _lock, uintptr_t _call_site, uint64_t _wait)
+{
+    auto& _v = get_thread_table();
+    if(!_v) _v = std::make_unique<thread_table>();
+
+    auto _idx = get_slot(_lock, _call_site);
+    for(size_t i = 0; i < thread_capacity; ++i)
+    {
+        auto& _slot = _v->slots[(_idx + i) % thread_capacity];
+        if(_slot.data.count == 0)
+        {
+            _slot.lock      = _lock;
+            _slot.call_site = _call_site;
+        }
+        if(_slot.lock == _lock && _slot.call_site == _call_site)
+        {
+            _slot.data.add(_wait);
+            return;
+        }
+    }
+    _v->overflow.add(_wait);
+}
+
+void
+post_process()
+{
+    auto _data     = merged_data{};
+    auto _overflow = entry{};
+
+    if(thread_table_data::get())
+    {
+        for(const auto& titr : *thread_table_data::get())
+        {
+            if(!titr) continue;
+            for(const auto& itr : titr->slots)
+            {
+                if(itr.data.count == 0) continue;
+                _data[merged_key{ itr.lock, itr.call_site }] += itr.data;
+            }
+            _overflow += titr->overflow;
+        }
+    }
+
+    if(_data.empty() && _overflow.count == 0)
+    {
+        OMNITRACE_VERBOSE_F(1, "No contended lock acquisitions were recorded\n");
+        return;
+    }
+
+    // the totals of each lock over all the call-sites. The second field of the key
+    // is the number of call-sites
+    auto _locks = merged_data{};
+    {
+        auto _nsites = std::map<uintptr_t, uintptr_t>{};
+        for(const auto& itr : _data)
+            _nsites[itr.first.first] += 1;
+        for(const auto& itr : _data)
+            _locks[merged_key{ itr.first.first, _nsites.at(itr.first.first) }] +=
+                itr.second;
+    }
+
+    if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+        write_text(_data, _locks, _overflow);
+
+    if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+        write_json(_data, _overflow);
+}
+}  // namespace lock_profile
+}  // namespace omnitrace
@@ -0,0 +1,53 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// aggregates the time spent waiting for the mutexes, rwlocks, and spinlocks per lock
+/// address and call-site (see OMNITRACE_TRACE_THREAD_LOCKS_PROFILE). The entries are
+/// accumulated in a fixed-size table per thread without locking or allocating after
+/// the first record and are merged across the threads and symbolized at finalization
+namespace lock_profile
+{
+/// the maximum number of (lock address, call-site) pairs per thread. The waits of
+/// the pairs beyond this capacity are only counted in the total
+static constexpr size_t thread_capacity = 1024;
+
+/// returns the address of the first frame of the call-stack of the calling thread
+/// which is outside of omnitrace, i.e. the call-site of the intercepted function
+uintptr_t
+get_call_site();
+
+/// records an acquisition of the lock at the call-site which waited _wait nsec
+void
+record(uintptr_t _lock, uintptr_t _call_site, uint64_t _wait);
+
+/// merges the tables of all the threads and writes lock_profile.{txt,json}
+void
+post_process();
+}  // namespace lock_profile
+}  // namespace omnitrace
@@ -0,0 +1,283 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/loop_trips.hpp"
+#include "api.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "core/tsc.hpp"
+#include "library/thread_data.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace loop_trips
+{
+namespace
+{
+struct trip_record
+{
+    uint64_t timestamp = 0;
+    uint64_t id        = 0;
+    uint64_t count     = 0;
+};
+
+// only the owning thread writes to the data: the instrumentation increments the
+// counters and the sampler, which interrupts the thread, appends the records. The
+// sampler skips the thread while the vectors are resized and only requests more
+// capacity for the records so that it never allocates
+struct thread_trips
+{
+    static constexpr size_t min_capacity = 4096;
+
+    void update(uint64_t _id);
+
+    volatile sig_atomic_t    busy    = 0;
+    volatile sig_atomic_t    grow    = 0;
+    size_t                   dropped = 0;
+    std::vector<uint64_t>    counts  = {};
+    std::vector<uint64_t>    sampled = {};  // the counts of the last record
+    std::vector<trip_record> records = {};
+};
+
+using thread_trips_data = omnitrace::thread_data<thread_trips, thread_trips>;
+
+struct perfetto_loop_trips
+{};
+
+auto&
+get_loop_names()
+{
+    static auto _v = std::vector<std::string>{};
+    return _v;
+}
+
+auto&
+get_loop_names_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_thread_trips(int64_t _tid = tim::threading::get_id())
+{
+    return thread_trips_data::instance(construct_on_thread{ _tid });
+}
+
+void
+thread_trips::update(uint64_t _id)
+{
+    busy = 1;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    if(_id >= counts.size())
+    {
+        auto _n = std::max<size_t>(_id + 1, size());
+        counts.resize(_n, 0);
+        sampled.resize(_n, 0);
+    }
+
+    if(grow != 0 || records.capacity() == 0)
+    {
+        records.reserve(std::max(min_capacity, 2 * records.capacity()));
+        grow = 0;
+    }
+
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    busy = 0;
+}
+}  // namespace
+
+void
+sample()
+{
+    auto* _instances = thread_trips_data::get();
+    if(!_instances) return;
+
+    auto _tid = tim::threading::get_id();
+    if(_tid < 0 || static_cast<size_t>(_tid) >= _instances->size()) return;
+
+    auto& _data = _instances->at(_tid);
+    if(!_data || _data->busy != 0) return;
+
+    auto _ts = tsc::get_clock_real_now();
+    for(size_t i = 0; i < _data->counts.size(); ++i)
+    {
+        auto _count = _data->counts[i];
+        if(_count == _data->sampled[i]) continue;
+        if(_data->records.size() == _data->records.capacity())
+        {
+            // the change is recorded by the next sample after the records grew
+            ++_data->dropped;
+            break;
+        }
+        _data->records.emplace_back(trip_record{ _ts, i, _count });
+        _data->sampled[i] = _count;
+    }
+
+    if(2 * _data->records.size() >= _data->records.capacity()) _data->grow = 1;
+}
+
+size_t
+size()
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_loop_names_mutex() };
+    return get_loop_names().size();
+}
+
+void
+post_process()
+{
+    if(!get_use_perfetto()) return;
+
+    auto _names = std::vector<std::string>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_loop_names_mutex() };
+        _names   = get_loop_names();
+    }
+
+    if(_names.empty()) return;
+
+    using track = perfetto_counter_track<perfetto_loop_trips>;
+
+    auto* _instances = thread_trips_data::get();
+    if(!_instances) return;
+
+    size_t _nrecords = 0;
+    size_t _ndropped = 0;
+    for(size_t i = 0; i < _instances->size(); ++i)
+    {
+        auto& _data = _instances->at(i);
+        if(!_data) continue;
+
+        const auto& _thread_info = thread_info::get(i, SequentTID);
+        if(!_thread_info) continue;
+
+        // the trips executed after the last sample
+        auto _stop = _thread_info->get_stop();
+        if(_stop == 0) _stop = tsc::get_clock_real_now();
+        for(size_t j = 0; j < _data->counts.size(); ++j)
+        {
+            if(_data->counts[j] != _data->sampled[j])
+                _data->records.emplace_back(trip_record{ _stop, j, _data->counts[j] });
+        }
+
+        _nrecords += _data->records.size();
+        _ndropped += _data->dropped;
+
+        // index of the trip count track and the previous record of each loop
+        auto _tracks   = std::vector<int64_t>(_data->counts.size(), -1);
+        auto _previous = std::vector<trip_record>(_data->counts.size());
+        auto _tid_name = JOIN("", '[', i, ']');
+
+        for(const auto& itr : _data->records)
+        {
+            auto& _track = _tracks.at(itr.id);
+            auto& _prev  = _previous.at(itr.id);
+            if(_track < 0)
+            {
+                auto _name = (itr.id < _names.size() && !_names.at(itr.id).empty())
+                                 ? _names.at(itr.id)
+                                 : JOIN("", "loop_", itr.id);
+                _track     = track::size(i);
+                track::emplace(i, JOIN(' ', "Loop Trips", _name, _tid_name, "(S)"));
+                track::emplace(i, JOIN(' ', "Loop Trip Rate", _name, _tid_name, "(S)"),
+                               "trips/sec");
+                _prev = trip_record{ _thread_info->get_start(), itr.id, 0 };
+            }
+
+            auto _elapsed = (itr.timestamp > _prev.timestamp)
+                                ? (itr.timestamp - _prev.timestamp)
+                                : uint64_t{ 1 };
+            auto _rate    = static_cast<double>(itr.count - _prev.count) * units::sec /
+                            static_cast<double>(_elapsed);
+
+            TRACE_COUNTER(trait::name<category::timer_sampling>::value,
+                          track::at(i, _track), itr.timestamp, itr.count);
+            TRACE_COUNTER(trait::name<category::timer_sampling>::value,
+                          track::at(i, _track + 1), itr.timestamp, _rate);
+            _prev = itr;
+        }
+
+        for(auto itr : _tracks)
+        {
+            if(itr < 0) continue;
+            TRACE_COUNTER(trait::name<category::timer_sampling>::value,
+                          track::at(i, itr + 1), _stop, 0.0);
+        }
+    }
+
+    OMNITRACE_VERBOSE(1, "Post-processed %zu loop trip count records of %zu loops...\n",
+                      _nrecords, _names.size());
+    if(_ndropped > 0)
+        OMNITRACE_VERBOSE(1,
+                          "%zu loop trip count samples were deferred because the "
+                          "records were full...\n",
+                          _ndropped);
+}
+}  // namespace loop_trips
+}  // namespace omnitrace
+
+//--------------------------------------------------------------------------------------//
+
+namespace loop_trips = omnitrace::loop_trips;
+
+extern "C" void
+omnitrace_register_loop_hidden(const char* name, uint64_t id)
+{
+    OMNITRACE_BASIC_VERBOSE_F(4, "[%lu] :: %s\n", (unsigned long) id, name);
+
+    auto  _lk    = std::unique_lock<std::mutex>{ loop_trips::get_loop_names_mutex() };
+    auto& _names = loop_trips::get_loop_names();
+    if(id >= _names.size()) _names.resize(id + 1);
+    _names.at(id) = (name) ? name : "";
+}
+
+//--------------------------------------------------------------------------------------//
+
+extern "C" void
+omnitrace_loop_trip_hidden(uint64_t id)
+{
+    static thread_local auto* _data = loop_trips::get_thread_trips().get();
+
+    if(OMNITRACE_UNLIKELY(id >= _data->counts.size() || _data->grow != 0))
+    {
+        if(omnitrace::get_state() >= omnitrace::State::Finalized) return;
+        _data->update(id);
+    }
+    ++_data->counts[id];
+}
@@ -0,0 +1,50 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// trip counts of the loops instrumented with omnitrace-instrument --loop-trip-counts.
+/// The instrumentation only increments a counter of the calling thread for the loop id
+/// so it never touches the region stack. The counters are recorded by the sampler of
+/// the thread and are written to the perfetto trace as the trip count and the trip
+/// rate of every loop at finalization
+namespace loop_trips
+{
+/// records the counters which changed since the previous sample of the calling
+/// thread. Invoked from the sampling signal handler so it neither locks nor allocates
+void
+sample();
+
+/// returns the number of registered loops
+size_t
+size();
+
+/// writes the counter tracks of every thread to the perfetto trace
+void
+post_process();
+}  // namespace loop_trips
+}  // namespace omnitrace
@@ -0,0 +1,488 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+#include "library/memcpy_analysis.hpp"
+#include "core/config.hpp"
+#include "core/containers/log2_buckets.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace memcpy_analysis
+{
+namespace
+{
+// the sizes of the copies are in bytes and the bandwidths are in MB/s
+using buckets_t = container::log2_buckets<40>;
+
+enum direction : uint8_t
+{
+    host_to_host = 0,
+    host_to_device,
+    device_to_host,
+    device_to_device,
+    peer_to_peer,
+    num_directions
+};
+
+enum host_memory : uint8_t
+{
+    no_host_memory = 0,  // device to device and peer to peer
+    pinned_memory,
+    pageable_memory,
+    num_host_memory
+};
+
+constexpr auto direction_names =
+    std::array<const char*, num_directions>{ "H2H", "H2D", "D2H", "D2D", "P2P" };
+
+constexpr auto host_memory_names =
+    std::array<const char*, num_host_memory>{ "none", "pinned", "pageable" };
+
+struct allocation
+{
+    uint64_t size   = 0;
+    int32_t  device = 0;
+};
+
+struct pending_copy
+{
+    direction   dir    = host_to_host;
+    host_memory memory = no_host_memory;
+    uint64_t    bytes  = 0;
+};
+
+struct class_key
+{
+    direction   dir    = host_to_host;
+    size_t      size   = 0;  // log2 bucket of the bytes
+    host_memory memory = no_host_memory;
+
+    friend bool operator<(const class_key& _lhs, const class_key& _rhs)
+    {
+        return std::tie(_lhs.dir, _lhs.size, _lhs.memory) <
+               std::tie(_rhs.dir, _rhs.size, _rhs.memory);
+    }
+};
+
+struct class_entry
+{
+    uint64_t                          count   = 0;
+    uint64_t                          bytes   = 0;
+    uint64_t                          time    = 0;  // nanoseconds
+    uint64_t                          min_bw  = 0;  // MB/s
+    uint64_t                          max_bw  = 0;  // MB/s
+    buckets_t::array_type             buckets = {};
+
+    void add(uint64_t _bytes, uint64_t _time)
+    {
+        auto _bw = static_cast<uint64_t>(
+            (static_cast<double>(_bytes) / units::megabyte) /
+            (static_cast<double>(_time) / units::sec));
+        min_bw = (count == 0) ? _bw : std::min(min_bw, _bw);
+        max_bw = std::max(max_bw, _bw);
+        count += 1;
+        bytes += _bytes;
+        time += _time;
+        buckets_t::add(buckets, _bw);
+    }
+};
+
+// the staged copies of pageable memory may have several device operations with the
+// correlation id of the copy, which are consecutive, so the last matched copy is kept
+struct profile_data
+{
+    std::mutex                                 mutex       = {};
+    uint64_t                                   unmatched   = 0;
+    uint64_t                                   last_corrid = 0;
+    pending_copy                               last        = {};
+    std::map<uintptr_t, allocation>            allocations = {};
+    std::unordered_map<uint64_t, pending_copy> pending     = {};
+    std::map<class_key, class_entry>           classes     = {};
+};
+
+using summary_t = std::map<class_key, class_entry>;
+
+std::once_flag post_process_once{};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the deallocations during the static destruction are safe
+auto&
+get_profile()
+{
+    static auto* _v = new profile_data{};
+    return *_v;
+}
+
+// requires the mutex of the profile. Returns the allocation containing the address
+const allocation*
+find_allocation(const profile_data& _profile, const void* _addr)
+{
+    auto _v  = reinterpret_cast<uintptr_t>(_addr);
+    auto itr = _profile.allocations.upper_bound(_v);
+    if(itr == _profile.allocations.begin()) return nullptr;
+    --itr;
+    return (_v < itr->first + itr->second.size) ? &itr->second : nullptr;
+}
+
+// requires the mutex of the profile. The memory which was not allocated through HIP
+// after the initialization is pageable host memory
+host_memory
+get_host_memory(const profile_data& _profile, const void* _addr)
+{
+    const auto* _alloc = find_allocation(_profile, _addr);
+    return (_alloc != nullptr && _alloc->device == host_device) ? pinned_memory
+                                                                : pageable_memory;
+}
+
+// requires the mutex of the profile
+bool
+is_device_memory(const profile_data& _profile, const void* _addr)
+{
+    const auto* _alloc = find_allocation(_profile, _addr);
+    return (_alloc != nullptr && _alloc->device != host_device);
+}
+
+// requires the mutex of the profile
+pending_copy
+classify(const profile_data& _profile, const void* _dst, const void* _src,
+         size_t _bytes, copy_kind _kind)
+{
+    if(_kind == default_kind)
+    {
+        auto _dst_dev = is_device_memory(_profile, _dst);
+        auto _src_dev = is_device_memory(_profile, _src);
+        if(_src_dev && _dst_dev)
+            _kind = device_to_device_kind;
+        else if(_src_dev)
+            _kind = device_to_host_kind;
+        else if(_dst_dev)
+            _kind = host_to_device_kind;
+        else
+            _kind = host_to_host_kind;
+    }
+
+    switch(_kind)
+    {
+        case host_to_device_kind:
+            return pending_copy{ host_to_device, get_host_memory(_profile, _src),
+                                 _bytes };
+        case device_to_host_kind:
+            return pending_copy{ device_to_host, get_host_memory(_profile, _dst),
+                                 _bytes };
+        case device_to_device_kind:
+        {
+            const auto* _dst_alloc = find_allocation(_profile, _dst);
+            const auto* _src_alloc = find_allocation(_profile, _src);
+            auto        _peer      = (_dst_alloc != nullptr && _src_alloc != nullptr &&
+                               _dst_alloc->device != _src_alloc->device);
+            return pending_copy{ (_peer) ? peer_to_peer : device_to_device,
+                                 no_host_memory, _bytes };
+        }
+        default: break;
+    }
+
+    auto _pinned = (get_host_memory(_profile, _dst) == pinned_memory &&
+                    get_host_memory(_profile, _src) == pinned_memory);
+    return pending_copy{ host_to_host, (_pinned) ? pinned_memory : pageable_memory,
+                         _bytes };
+}
+
+double
+as_megabytes(uint64_t _v)
+{
+    return static_cast<double>(_v) / units::megabyte;
+}
+
+// MB/s
+double
+get_bandwidth(const class_entry& _v)
+{
+    if(_v.time == 0) return 0.0;
+    return as_megabytes(_v.bytes) / (static_cast<double>(_v.time) / units::sec);
+}
+
+// the copies between the host and the devices which used pageable host memory
+class_entry
+get_pageable(const summary_t& _data)
+{
+    auto _v = class_entry{};
+    for(const auto& itr : _data)
+    {
+        if(itr.first.memory != pageable_memory || itr.first.dir == host_to_host)
+            continue;
+        _v.count += itr.second.count;
+        _v.bytes += itr.second.bytes;
+        _v.time += itr.second.time;
+    }
+    return _v;
+}
+
+void
+write_text(const summary_t& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("memcpy-analysis", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening memcpy-analysis output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname,
+                                                    std::string{ "memcpy-analysis" });
+
+    ofs << std::setprecision(3) << std::fixed;
+    for(const auto& itr : _data)
+    {
+        const auto& _k = itr.first;
+        const auto& _v = itr.second;
+        ofs << direction_names.at(_k.dir) << ", size >= "
+            << buckets_t::get_bucket_begin(_k.size) << " bytes, host memory: "
+            << host_memory_names.at(_k.memory) << ": copies: " << _v.count
+            << ", copied (MB): " << as_megabytes(_v.bytes)
+            << ", time (msec): " << (static_cast<double>(_v.time) / units::msec)
+            << ", bandwidth (MB/s): " << get_bandwidth(_v) << " [min: " << _v.min_bw
+            << ", max: " << _v.max_bw << "]"
+            << ((_k.memory == pageable_memory && _k.dir != host_to_host)
+                    ? "  <-- pageable host memory"
+                    : "")
+            << "\n";
+
+        for(size_t i = 0; i < buckets_t::num_buckets; ++i)
+        {
+            if(_v.buckets.at(i) == 0) continue;
+            ofs << "    " << std::setw(14) << buckets_t::get_bucket_begin(i)
+                << " MB/s : " << _v.buckets.at(i) << "\n";
+        }
+    }
+
+    auto _pageable = get_pageable(_data);
+    if(_pageable.count > 0)
+    {
+        ofs << "\n"
+            << _pageable.count << " copies (" << as_megabytes(_pageable.bytes)
+            << " MB) between the host and the devices used pageable host memory. "
+            << "Pinned host memory (hipHostMalloc or hipHostRegister) is copied "
+            << "directly instead of being staged\n";
+    }
+}
+
+void
+write_json(const summary_t& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("memcpy_analysis");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data)
+        {
+            const auto& _k = itr.first;
+            const auto& _v = itr.second;
+            ar->startNode();
+            (*ar)(cereal::make_nvp("direction",
+                                   std::string{ direction_names.at(_k.dir) }),
+                  cereal::make_nvp("size_bucket", _k.size),
+                  cereal::make_nvp("min_bytes", buckets_t::get_bucket_begin(_k.size)),
+                  cereal::make_nvp("host_memory",
+                                   std::string{ host_memory_names.at(_k.memory) }),
+                  cereal::make_nvp("count", _v.count),
+                  cereal::make_nvp("bytes", _v.bytes),
+                  cereal::make_nvp("time_ns", _v.time),
+                  cereal::make_nvp("bandwidth_mbps", get_bandwidth(_v)),
+                  cereal::make_nvp("min_bandwidth_mbps", _v.min_bw),
+                  cereal::make_nvp("max_bandwidth_mbps", _v.max_bw),
+                  cereal::make_nvp("bandwidth_buckets", _v.buckets));
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("memcpy-analysis", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening memcpy-analysis output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname,
+                                                    std::string{ "memcpy-analysis" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+record_allocation(int32_t _device, const void* _addr, size_t _size)
+{
+    if(_addr == nullptr || _size == 0 || !get_active().load(std::memory_order_relaxed))
+        return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _profile.allocations[reinterpret_cast<uintptr_t>(_addr)] =
+        allocation{ _size, _device };
+}
+
+void
+record_free(const void* _addr)
+{
+    if(_addr == nullptr || !get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _profile.allocations.erase(reinterpret_cast<uintptr_t>(_addr));
+}
+
+void
+copy(uint64_t _corr_id, const void* _dst, const void* _src, size_t _bytes,
+     copy_kind _kind)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _profile.pending[_corr_id] = classify(_profile, _dst, _src, _bytes, _kind);
+}
+
+void
+peer_copy(uint64_t _corr_id, int32_t _dst_device, int32_t _src_device, size_t _bytes)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto _dir = (_dst_device == _src_device) ? device_to_device : peer_to_peer;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    _profile.pending[_corr_id] = pending_copy{ _dir, no_host_memory, _bytes };
+}
+
+void
+device_op(uint64_t _corr_id, uint64_t _beg_ns, uint64_t _end_ns, uint64_t _bytes)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+
+    if(auto itr = _profile.pending.find(_corr_id); itr != _profile.pending.end())
+    {
+        _profile.last_corrid = _corr_id;
+        _profile.last        = itr->second;
+        _profile.pending.erase(itr);
+    }
+    else if(_profile.last_corrid != _corr_id || _corr_id == 0)
+    {
+        // e.g. the copies of the runtime and the asynchronous copies which were
+        // enqueued before the initialization
+        ++_profile.unmatched;
+        return;
+    }
+
+    const auto& _copy = _profile.last;
+    auto        _size = (_bytes > 0) ? _bytes : _copy.bytes;
+    auto        _key  = class_key{ _copy.dir, buckets_t::get_bucket(_size),
+                                   _copy.memory };
+    auto        _time = std::max<uint64_t>(_end_ns - _beg_ns, 1);
+    _profile.classes[_key].add(_size, _time);
+}
+
+void
+post_process()
+{
+    if(!config::get_memcpy_analysis()) return;
+
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+
+        auto& _profile = get_profile();
+        auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+        if(_profile.classes.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No HIP memory copies were recorded\n");
+            return;
+        }
+
+        if(_profile.unmatched > 0)
+            OMNITRACE_VERBOSE_F(1, "%lu copy operations had no HIP copy function\n",
+                                _profile.unmatched);
+
+        const auto& _data     = _profile.classes;
+        auto        _pageable = get_pageable(_data);
+        if(_pageable.count > 0)
+            OMNITRACE_WARNING_F(0,
+                                "%lu HIP memory copies (%.3f MB, %.3f msec) used "
+                                "pageable host memory. See memcpy-analysis.txt\n",
+                                _pageable.count, as_megabytes(_pageable.bytes),
+                                static_cast<double>(_pageable.time) / units::msec);
+
+        try
+        {
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the memory copy report failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace memcpy_analysis
+}  // namespace omnitrace
@@ -0,0 +1,79 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// the classification of the HIP memory copies (see OMNITRACE_MEMCPY_ANALYSIS). The
+/// device and the pinned host allocations are recorded from the HIP API so the
+/// pointers of a copy function give the direction of the copy and whether the host
+/// memory is pinned or pageable. The copy is joined to its device operation by the
+/// correlation id and the achieved bandwidth is accounted per direction, log2 size
+/// bucket and host memory in log2 histograms. At finalization, the classes are
+/// written to memcpy-analysis.{txt,json} and the copies of pageable host memory are
+/// reported since they are staged through a pinned buffer by the runtime
+namespace memcpy_analysis
+{
+/// the pinned host allocations
+constexpr int32_t host_device = -1;
+
+/// the kind of a copy function. The values are the values of hipMemcpyKind
+enum copy_kind : int32_t
+{
+    host_to_host_kind = 0,
+    host_to_device_kind,
+    device_to_host_kind,
+    device_to_device_kind,
+    default_kind,  // inferred from the pointers
+};
+
+/// a device (or, with host_device, a pinned host) allocation
+void
+record_allocation(int32_t _device, const void* _addr, size_t _size);
+
+void
+record_free(const void* _addr);
+
+/// the host entry of a copy function with the correlation id
+void
+copy(uint64_t _corr_id, const void* _dst, const void* _src, size_t _bytes,
+     copy_kind _kind);
+
+/// the host entry of a copy between the memory of two devices (hipMemcpyPeer)
+void
+peer_copy(uint64_t _corr_id, int32_t _dst_device, int32_t _src_device, size_t _bytes);
+
+/// the completed copy operation with the correlation id. The timestamps are in the
+/// timebase of the host. The bytes of the copy function are used if zero
+void
+device_op(uint64_t _corr_id, uint64_t _beg_ns, uint64_t _end_ns, uint64_t _bytes);
+
+/// stops the recording and writes the report. Only the first invocation has an
+/// effect
+void
+post_process();
+}  // namespace memcpy_analysis
+}  // namespace omnitrace
@@ -0,0 +1,679 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/memory_bandwidth.hpp"
+#include "core/categories.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perf.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "library/perf.hpp"
+#include "library/region_attribution.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <linux/perf_event.h>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace memory_bandwidth
+{
+namespace
+{
+using region_attribution::split;
+using region_attribution::timeline;
+
+enum direction : uint8_t
+{
+    read_direction = 0,
+    write_direction,
+    total_direction,  // events which count the reads and the writes
+    num_directions,
+};
+
+constexpr auto direction_names =
+    std::array<const char*, num_directions>{ "read", "write", "total" };
+
+struct event_spec
+{
+    direction   dir   = total_direction;
+    std::string pmu   = {};  // may contain a '*' for the index of the instances
+    std::string terms = {};
+    double      bytes = 64.0;  // bytes transferred per count
+};
+
+struct counter
+{
+    perf::perf_event event  = {};
+    int32_t          socket = 0;
+    direction        dir    = total_direction;
+    double           bytes  = 0.0;
+    uint64_t         offset = 0;  // count at the first read
+    double           total  = 0.0;
+};
+
+struct socket_state
+{
+    std::array<bool, num_directions>     found = {};
+    std::array<timeline, num_directions> bytes = {};  // the total includes all events
+};
+
+struct sampler_state
+{
+    std::mutex                      mutex    = {};
+    bool                            active   = false;
+    std::vector<counter>            counters = {};
+    std::map<int32_t, socket_state> sockets  = {};
+};
+
+// intentionally leaked so the sampler does not depend on the order of the static
+// destruction
+sampler_state&
+get_sampler()
+{
+    static auto* _v = new sampler_state{};
+    return *_v;
+}
+
+std::string
+read_line(const std::string& _path)
+{
+    auto _ifs = std::ifstream{ _path };
+    auto _v   = std::string{};
+    if(_ifs) std::getline(_ifs, _v);
+    return _v;
+}
+
+int32_t
+get_socket(int _cpu)
+{
+    auto _v = read_line(JOIN("", "/sys/devices/system/cpu/cpu", _cpu,
+                             "/topology/physical_package_id"));
+    return (_v.empty()) ? 0 : std::stoi(_v);
+}
+
+bool
+has_pmu_event(const std::string& _pmu, const std::string& _event)
+{
+    auto _pmus = perf::get_pmu_instances(_pmu);
+    return !_pmus.empty() &&
+           !read_line(JOIN("", "/sys/bus/event_source/devices/", _pmus.front(),
+                           "/events/", _event))
+                .empty();
+}
+
+// "[read:|write:]<pmu>/<terms>/[=<bytes>]"
+event_spec
+parse_event(std::string _v)
+{
+    auto _spec = event_spec{};
+    for(auto itr : { read_direction, write_direction })
+    {
+        auto _prefix = JOIN("", direction_names.at(itr), ":");
+        if(_v.find(_prefix) == 0)
+        {
+            _spec.dir = itr;
+            _v        = _v.substr(_prefix.length());
+        }
+    }
+
+    auto _end = _v.rfind('/');
+    auto _pos = _v.find('/');
+    OMNITRACE_CONDITIONAL_THROW(
+        _pos == std::string::npos || _pos == 0 || _end == _pos,
+        "invalid memory bandwidth event '%s' (expected <pmu>/<terms>/)", _v.c_str());
+
+    _spec.pmu   = _v.substr(0, _pos);
+    _spec.terms = _v.substr(_pos + 1, _end - _pos - 1);
+
+    auto _bytes = _v.substr(_end + 1);
+    if(!_bytes.empty())
+    {
+        OMNITRACE_CONDITIONAL_THROW(_bytes.front() != '=',
+                                    "invalid bytes per count of memory bandwidth event "
+                                    "'%s' (expected =<bytes>)",
+                                    _v.c_str());
+        _spec.bytes = std::stod(_bytes.substr(1));
+    }
+    return _spec;
+}
+
+std::vector<event_spec>
+get_default_events()
+{
+    // the Intel IMC counts every 64 byte cache line read from or written to the DRAM.
+    // The free running counters are provided by the client CPUs without the
+    // programmable counters
+    if(has_pmu_event("uncore_imc_*", "cas_count_read"))
+        return { { read_direction, "uncore_imc_*", "cas_count_read", 64.0 },
+                 { write_direction, "uncore_imc_*", "cas_count_write", 64.0 } };
+
+    if(has_pmu_event("uncore_imc_free_running_*", "data_read"))
+        return { { read_direction, "uncore_imc_free_running_*", "data_read", 64.0 },
+                 { write_direction, "uncore_imc_free_running_*", "data_write", 64.0 } };
+
+    // the UMC of Zen 4 and later counts the CAS commands of each memory channel
+    if(!perf::get_pmu_instances("amd_umc_*").empty())
+        return { { read_direction, "amd_umc_*", "event=0x0a,rdwrmask=1", 64.0 },
+                 { write_direction, "amd_umc_*", "event=0x0a,rdwrmask=2", 64.0 } };
+
+    // the data fabric of Zen 2 and Zen 3 counts the 64 byte beats of the DRAM channels,
+    // without distinguishing the reads and the writes
+    if(!perf::get_pmu_instances("amd_df").empty())
+    {
+        auto _v = std::vector<event_spec>{};
+        for(const auto* itr :
+            { "0x07", "0x47", "0x87", "0xc7", "0x107", "0x147", "0x187", "0x1c7" })
+            _v.emplace_back(event_spec{ total_direction, "amd_df",
+                                        JOIN("", "event=", itr, ",umask=0x38"), 64.0 });
+        return _v;
+    }
+
+    return std::vector<event_spec>{};
+}
+
+std::vector<event_spec>
+get_events()
+{
+    auto _events = config::get_memory_bandwidth_events();
+    if(_events.empty() || _events == "auto") return get_default_events();
+
+    auto _v = std::vector<event_spec>{};
+    for(const auto& itr : tim::delimit(_events, "; "))
+        _v.emplace_back(parse_event(itr));
+    return _v;
+}
+
+// each event is opened on every instance of the PMU and, as a system-wide event, on
+// the CPUs in the cpumask of the instance
+std::vector<counter>
+open_counters(const std::vector<event_spec>& _events)
+{
+    auto _v = std::vector<counter>{};
+    for(const auto& itr : _events)
+    {
+        auto _pmus = perf::get_pmu_instances(itr.pmu);
+        OMNITRACE_VERBOSE_F((_pmus.empty()) ? 1 : 2,
+                            "Opening the memory bandwidth event %s/%s/ on %zu PMUs\n",
+                            itr.pmu.c_str(), itr.terms.c_str(), _pmus.size());
+
+        for(const auto& pitr : _pmus)
+        {
+            auto _cpus = perf::get_pmu_cpus(pitr);
+            if(_cpus.empty()) _cpus.emplace_back(0);
+
+            for(auto _cpu : _cpus)
+            {
+                auto _pe = perf_event_attr{};
+                memset(&_pe, 0, sizeof(_pe));
+                _pe.size = sizeof(_pe);
+                perf::config_pmu_event(_pe, JOIN("", pitr, "/", itr.terms, "/"));
+                _pe.read_format =
+                    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                auto _counter = counter{};
+                if(auto _err = _counter.event.open(_pe, -1, _cpu))
+                {
+                    OMNITRACE_VERBOSE_F(1, "%s/%s/ on CPU %i is not available: %s\n",
+                                        pitr.c_str(), itr.terms.c_str(), _cpu,
+                                        _err->c_str());
+                    continue;
+                }
+
+                _counter.socket = get_socket(_cpu);
+                _counter.dir    = itr.dir;
+                _counter.bytes  = itr.bytes;
+                _v.emplace_back(std::move(_counter));
+            }
+        }
+    }
+    return _v;
+}
+
+void
+sample_locked(sampler_state& _v)
+{
+    auto _ts    = tracing::now();
+    auto _bytes = std::map<int32_t, std::array<double, num_directions>>{};
+    for(auto& itr : _v.counters)
+    {
+        auto _count = itr.event.get_scaled_count();
+        itr.total   = static_cast<double>(_count - itr.offset) * itr.bytes;
+        _bytes[itr.socket].at(itr.dir) += itr.total;
+        if(itr.dir != total_direction)
+            _bytes[itr.socket].at(total_direction) += itr.total;
+    }
+
+    for(const auto& itr : _bytes)
+    {
+        auto& _socket = _v.sockets[itr.first];
+        for(size_t i = 0; i < num_directions; ++i)
+            _socket.bytes.at(i).push(_ts, itr.second.at(i));
+    }
+}
+
+double
+as_gigabytes(double _v)
+{
+    return _v / 1.0e9;
+}
+
+double
+get_rate(const timeline& _v, size_t _idx)
+{
+    if(_idx + 1 >= _v.ts.size() || _v.ts.at(_idx + 1) <= _v.ts.at(_idx)) return 0.0;
+    return (_v.values.at(_idx + 1) - _v.values.at(_idx)) /
+           (static_cast<double>(_v.ts.at(_idx + 1) - _v.ts.at(_idx)) / units::sec);
+}
+
+struct socket_entry
+{
+    int32_t                            socket = 0;
+    std::array<bool, num_directions>   found  = {};
+    std::array<double, num_directions> bytes  = {};
+    std::array<double, num_directions> peak   = {};  // bytes per second
+};
+
+struct region_entry
+{
+    uint64_t                           count      = 0;
+    uint64_t                           time       = 0;
+    std::array<double, num_directions> bytes      = {};  // while the region was active
+    double                             attributed = 0.0;  // share of the threads
+};
+
+struct summary
+{
+    double                                            duration = 0.0;
+    double                                            idle     = 0.0;
+    std::vector<socket_entry>                         sockets  = {};
+    std::vector<std::pair<std::string, region_entry>> regions  = {};
+};
+
+summary
+get_summary(sampler_state& _s)
+{
+    auto _data = summary{};
+
+    auto _beg = std::numeric_limits<uint64_t>::max();
+    auto _end = uint64_t{ 0 };
+    for(const auto& itr : _s.sockets)
+    {
+        const auto& _v = itr.second.bytes.at(total_direction);
+        if(_v.empty()) continue;
+        _beg = std::min(_beg, _v.ts.front());
+        _end = std::max(_end, _v.ts.back());
+    }
+    if(_end == 0) return _data;
+    _data.duration = static_cast<double>(_end - _beg) / units::sec;
+
+    auto _times = std::vector<uint64_t>{};
+    for(const auto& itr : _s.sockets)
+    {
+        auto _entry   = socket_entry{};
+        _entry.socket = itr.first;
+        _entry.found  = itr.second.found;
+        for(size_t i = 0; i < num_directions; ++i)
+        {
+            const auto& _v = itr.second.bytes.at(i);
+            if(_v.empty()) continue;
+            _entry.bytes.at(i) = _v.values.back();
+            for(size_t j = 0; j + 1 < _v.ts.size(); ++j)
+                _entry.peak.at(i) = std::max(_entry.peak.at(i), get_rate(_v, j));
+        }
+        _data.sockets.emplace_back(_entry);
+
+        const auto& _ts = itr.second.bytes.at(total_direction).ts;
+        _times.insert(_times.end(), _ts.begin(), _ts.end());
+    }
+
+    // the traffic of all of the sockets
+    std::sort(_times.begin(), _times.end());
+    _times.erase(std::unique(_times.begin(), _times.end()), _times.end());
+    auto _total = timeline{};
+    for(auto itr : _times)
+    {
+        auto _bytes = 0.0;
+        for(const auto& sitr : _s.sockets)
+            _bytes += sitr.second.bytes.at(total_direction).at(itr);
+        _total.push(itr, _bytes);
+    }
+
+    // regions which were still open end with the last sample
+    auto _instances = region_attribution::get_intervals(_end);
+    auto _changes   = region_attribution::get_thread_changes(_instances);
+    auto _share     = split(_total, _changes, _data.idle);
+
+    auto _regions = std::unordered_map<uint64_t, region_entry>{};
+    for(const auto& itr : _instances)
+    {
+        auto& _entry = _regions[itr.hash];
+        _entry.count += 1;
+        _entry.time += (itr.end - itr.begin);
+        for(const auto& sitr : _s.sockets)
+        {
+            for(size_t i = 0; i < num_directions; ++i)
+                _entry.bytes.at(i) += sitr.second.bytes.at(i).between(itr.begin, itr.end);
+        }
+        _entry.attributed += _share.between(itr.begin, itr.end);
+    }
+
+    for(const auto& itr : _regions)
+    {
+        _data.regions.emplace_back(
+            std::string{ tim::get_hash_identifier_fast(itr.first) }, itr.second);
+    }
+
+    std::sort(_data.regions.begin(), _data.regions.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  return _lhs.second.attributed > _rhs.second.attributed;
+              });
+
+    return _data;
+}
+
+void
+write_perfetto(const sampler_state& _s)
+{
+    using track = perfetto_counter_track<category::memory_bandwidth>;
+
+    if(!get_use_perfetto()) return;
+
+    const auto* _category = trait::name<category::memory_bandwidth>::value;
+    for(const auto& itr : _s.sockets)
+    {
+        for(size_t i = 0; i < num_directions; ++i)
+        {
+            const auto& _v = itr.second.bytes.at(i);
+            if(!itr.second.found.at(i) || _v.ts.size() < 2) continue;
+
+            auto _idx = track::size(0);
+            track::emplace(0,
+                           JOIN(' ', "Memory Bandwidth socket", itr.first,
+                                direction_names.at(i)),
+                           "GB/s");
+            for(size_t j = 0; j + 1 < _v.ts.size(); ++j)
+                TRACE_COUNTER(_category, track::at(0, _idx), _v.ts.at(j),
+                              as_gigabytes(get_rate(_v, j)));
+            TRACE_COUNTER(_category, track::at(0, _idx), _v.ts.back(), 0.0);
+        }
+    }
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("memory-bandwidth", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening memory-bandwidth output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "memory-bandwidth" });
+
+    ofs << std::fixed << std::setprecision(3);
+    ofs << "duration: " << _data.duration << " sec\n\n";
+    for(const auto& itr : _data.sockets)
+    {
+        for(size_t i = 0; i < num_directions; ++i)
+        {
+            if(!itr.found.at(i)) continue;
+            auto _mean =
+                (_data.duration > 0.0) ? (itr.bytes.at(i) / _data.duration) : 0.0;
+            ofs << "socket " << itr.socket << " " << std::setw(5) << direction_names.at(i)
+                << " : " << std::setw(14) << as_gigabytes(itr.bytes.at(i))
+                << " GB, mean: " << as_gigabytes(_mean)
+                << " GB/s, peak: " << as_gigabytes(itr.peak.at(i)) << " GB/s\n";
+        }
+    }
+    ofs << "outside of the regions: " << as_gigabytes(_data.idle) << " GB\n";
+
+    ofs << "\n"
+        << std::setw(10) << "count" << " | " << std::setw(12) << "time [sec]" << " | "
+        << std::setw(12) << "read [GB]" << " | " << std::setw(12) << "write [GB]"
+        << " | " << std::setw(12) << "total [GB]" << " | " << std::setw(14)
+        << "attributed [GB]" << " | " << std::setw(10) << "GB/s" << " | "
+        << "region\n";
+    for(const auto& itr : _data.regions)
+    {
+        const auto& _v     = itr.second;
+        auto        _time  = static_cast<double>(_v.time) / units::sec;
+        auto        _bytes = _v.bytes.at(total_direction);
+        ofs << std::setw(10) << _v.count << " | " << std::setw(12) << _time << " | "
+            << std::setw(12) << as_gigabytes(_v.bytes.at(read_direction)) << " | "
+            << std::setw(12) << as_gigabytes(_v.bytes.at(write_direction)) << " | "
+            << std::setw(12) << as_gigabytes(_bytes) << " | " << std::setw(15)
+            << as_gigabytes(_v.attributed) << " | " << std::setw(10)
+            << ((_time > 0.0) ? as_gigabytes(_bytes / _time) : 0.0) << " | "
+            << itr.first << "\n";
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("memory_bandwidth");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("duration", _data.duration),
+              cereal::make_nvp("idle", _data.idle));
+
+        auto _save_list = [&ar](const char* _name, const auto& _entries, auto&& _save) {
+            ar->setNextName(_name);
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : _entries)
+            {
+                ar->startNode();
+                _save(itr);
+                ar->finishNode();
+            }
+            ar->finishNode();
+        };
+
+        _save_list("sockets", _data.sockets, [&ar, &_data](const socket_entry& _v) {
+            (*ar)(cereal::make_nvp("socket", _v.socket));
+            for(size_t i = 0; i < num_directions; ++i)
+            {
+                if(!_v.found.at(i)) continue;
+                auto _mean =
+                    (_data.duration > 0.0) ? (_v.bytes.at(i) / _data.duration) : 0.0;
+                ar->setNextName(direction_names.at(i));
+                ar->startNode();
+                (*ar)(cereal::make_nvp("bytes", _v.bytes.at(i)),
+                      cereal::make_nvp("mean", _mean),
+                      cereal::make_nvp("peak", _v.peak.at(i)));
+                ar->finishNode();
+            }
+        });
+
+        _save_list("regions", _data.regions, [&ar](const auto& _v) {
+            (*ar)(cereal::make_nvp("region", _v.first),
+                  cereal::make_nvp("count", _v.second.count),
+                  cereal::make_nvp("time", _v.second.time),
+                  cereal::make_nvp("read", _v.second.bytes.at(read_direction)),
+                  cereal::make_nvp("write", _v.second.bytes.at(write_direction)),
+                  cereal::make_nvp("total", _v.second.bytes.at(total_direction)),
+                  cereal::make_nvp("attributed", _v.second.attributed));
+        });
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("memory-bandwidth", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening memory-bandwidth output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "memory-bandwidth" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_memory_bandwidth()) return;
+
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) return;
+
+    try
+    {
+        _s.counters = open_counters(get_events());
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "memory bandwidth events are not available: %s\n",
+                            _e.what());
+    }
+
+    OMNITRACE_WARNING_IF_F(_s.counters.empty(),
+                           "No memory bandwidth counters are available. The memory "
+                           "controller PMUs require perf_event_paranoid <= 0 or "
+                           "CAP_PERFMON\n");
+    if(_s.counters.empty()) return;
+
+    for(auto& itr : _s.counters)
+    {
+        itr.event.start();
+        itr.offset = itr.event.get_scaled_count();
+        _s.sockets[itr.socket].found.at(itr.dir) = true;
+    }
+
+    OMNITRACE_VERBOSE_F(1, "Sampling %zu memory bandwidth counters on %zu sockets\n",
+                        _s.counters.size(), _s.sockets.size());
+
+    _s.active = true;
+}
+
+void
+config()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+sample()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+shutdown()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(!_s.active) return;
+
+    // the traffic until the end of the application
+    sample_locked(_s);
+    for(auto& itr : _s.counters)
+    {
+        itr.event.stop();
+        itr.event.close();
+    }
+    _s.active = false;
+}
+
+void
+post_process()
+{
+    if(!config::get_memory_bandwidth()) return;
+
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        shutdown();
+        region_attribution::stop();
+
+        auto& _s  = get_sampler();
+        auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+
+        try
+        {
+            auto _data = get_summary(_s);
+            if(_data.duration <= 0.0)
+            {
+                OMNITRACE_VERBOSE_F(1, "No memory bandwidth samples were recorded\n");
+                return;
+            }
+
+            write_perfetto(_s);
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the memory bandwidth profile failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace memory_bandwidth
+}  // namespace omnitrace
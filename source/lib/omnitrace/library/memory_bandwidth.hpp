@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace omnitrace
+{
+/// memory bandwidth of each socket (see OMNITRACE_MEMORY_BANDWIDTH). The background
+/// process sampler reads the system-wide memory controller counters of the uncore PMUs
+/// (the CAS counts of the Intel IMC, the UMC or data fabric events of the AMD CPUs, or
+/// the events in OMNITRACE_MEMORY_BANDWIDTH_EVENTS) at OMNITRACE_PROCESS_SAMPLING_FREQ.
+/// At finalization, the read and write bandwidth of each socket is written to perfetto
+/// and the bytes transferred while each region was active are interpolated from the
+/// samples around it (see region_attribution). The totals per socket and per region are
+/// written to memory-bandwidth.{txt,json}
+namespace memory_bandwidth
+{
+void
+setup();
+
+void
+config();
+
+void
+sample();
+
+void
+shutdown();
+
+void
+post_process();
+}  // namespace memory_bandwidth
+}  // namespace omnitrace
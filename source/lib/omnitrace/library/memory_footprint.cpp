@@ -0,0 +1,343 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/memory_footprint.hpp"
+#include "binary/interned_string.hpp"
+#include "core/categories.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/containers/sample_ring.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/perfetto_fwd.hpp"
+#include "core/timemory.hpp"
+#include "library/process_sampler.hpp"
+#include "library/sampling.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace memory_footprint
+{
+namespace
+{
+constexpr auto subsystem_names = std::array<const char*, num_subsystems>{
+    "sampling", "roctracer", "process_sampling", "perfetto", "binary"
+};
+
+struct source
+{
+    subsystem   type = sampling_subsystem;
+    size_func_t size = {};
+    shed_func_t shed = {};
+};
+
+struct footprint
+{
+    uint64_t current = 0;
+    uint64_t peak    = 0;
+    uint64_t budget  = 0;  ///< zero means the subsystem is not bounded
+    uint64_t shed    = 0;  ///< number of samples which exceeded the budget
+};
+
+struct sampler_state
+{
+    std::mutex                            mutex   = {};
+    bool                                  active  = false;
+    std::vector<source>                   sources = {};
+    std::array<footprint, num_subsystems> data    = {};
+    container::sample_ring<int64_t>       samples = {};
+};
+
+sampler_state&
+get_sampler()
+{
+    static auto* _v = new sampler_state{};
+    return *_v;
+}
+
+// intentionally leaked since the containers are released during the static destruction
+auto&
+get_tracked()
+{
+    static auto* _v = new std::array<std::atomic<int64_t>, num_subsystems>{};
+    return *_v;
+}
+
+double
+as_megabytes(uint64_t _v)
+{
+    return static_cast<double>(_v) / units::MB;
+}
+
+// e.g. "sampling=512 process_sampling=64"
+void
+parse_budgets(sampler_state& _s)
+{
+    for(const auto& itr : tim::delimit(config::get_memory_footprint_budget(), " ,;"))
+    {
+        auto _pos  = itr.find('=');
+        auto _name = itr.substr(0, _pos);
+        auto _iter = std::find_if(subsystem_names.begin(), subsystem_names.end(),
+                                  [&_name](const char* _v) { return _name == _v; });
+        if(_pos == std::string::npos || _iter == subsystem_names.end())
+        {
+            OMNITRACE_WARNING_F(0, "invalid entry '%s' of the memory footprint budget\n",
+                                itr.c_str());
+            continue;
+        }
+
+        try
+        {
+            auto _mb  = std::stod(itr.substr(_pos + 1));
+            auto _idx = std::distance(subsystem_names.begin(), _iter);
+            _s.data.at(_idx).budget =
+                static_cast<uint64_t>(std::max(_mb, 0.0) * units::MB);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "invalid budget of the %s memory footprint: %s\n",
+                                _name.c_str(), _e.what());
+        }
+    }
+}
+
+void
+sample_locked(sampler_state& _s)
+{
+    auto _bytes = std::array<int64_t, num_subsystems>{};
+    for(size_t i = 0; i < num_subsystems; ++i)
+        _bytes.at(i) = get_tracked().at(i).load(std::memory_order_relaxed);
+
+    for(const auto& itr : _s.sources)
+    {
+        if(itr.size) _bytes.at(itr.type) += static_cast<int64_t>(itr.size());
+    }
+
+    for(size_t i = 0; i < num_subsystems; ++i)
+    {
+        auto& _v   = _s.data.at(i);
+        _v.current = static_cast<uint64_t>(std::max<int64_t>(_bytes.at(i), 0));
+        _v.peak    = std::max(_v.peak, _v.current);
+        if(_v.budget == 0 || _v.current <= _v.budget) continue;
+
+        auto _nshed = 0;
+        for(const auto& itr : _s.sources)
+        {
+            if(static_cast<size_t>(itr.type) != i || !itr.shed) continue;
+            itr.shed();
+            ++_nshed;
+        }
+
+        OMNITRACE_WARNING_IF_F(_v.shed == 0,
+                               "the %s memory footprint (%.3f MB) exceeds its budget of "
+                               "%.3f MB. %s\n",
+                               subsystem_names.at(i), as_megabytes(_v.current),
+                               as_megabytes(_v.budget),
+                               (_nshed > 0) ? "Shedding data..."
+                                            : "The data of the subsystem cannot be shed");
+        ++_v.shed;
+    }
+
+    _s.samples.push(tracing::now(), _bytes);
+}
+
+void
+write_perfetto(const sampler_state& _s)
+{
+    using track = perfetto_counter_track<category::memory_footprint>;
+
+    if(!get_use_perfetto() || _s.samples.empty()) return;
+
+    const auto* _category = trait::name<category::memory_footprint>::value;
+    for(size_t i = 0; i < num_subsystems; ++i)
+    {
+        if(_s.data.at(i).peak == 0) continue;
+
+        auto _idx = track::size(0);
+        track::emplace(0, JOIN(' ', "Memory Footprint", subsystem_names.at(i)), "MB");
+        _s.samples.for_each(i, [&](uint64_t _ts, int64_t _value) {
+            TRACE_COUNTER(_category, track::at(0, _idx), _ts,
+                          as_megabytes(std::max<int64_t>(_value, 0)));
+        });
+    }
+}
+
+void
+write_text(const sampler_state& _s)
+{
+    auto _fname = tim::settings::compose_output_filename("memory-footprint", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening memory-footprint output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<footprint>{}(_fname,
+                                                    std::string{ "memory-footprint" });
+
+    ofs << std::fixed << std::setprecision(3);
+    ofs << std::setw(16) << "subsystem" << " | " << std::setw(12) << "peak [MB]" << " | "
+        << std::setw(12) << "final [MB]" << " | " << std::setw(12) << "budget [MB]"
+        << " | " << std::setw(12) << "exceeded" << "\n";
+    for(size_t i = 0; i < num_subsystems; ++i)
+    {
+        const auto& _v = _s.data.at(i);
+        ofs << std::setw(16) << subsystem_names.at(i) << " | " << std::setw(12)
+            << as_megabytes(_v.peak) << " | " << std::setw(12) << as_megabytes(_v.current)
+            << " | " << std::setw(12);
+        if(_v.budget > 0)
+            ofs << as_megabytes(_v.budget);
+        else
+            ofs << "none";
+        ofs << " | " << std::setw(12) << _v.shed << "\n";
+    }
+    ofs << "\n" << _s.samples.size() << " samples";
+    if(_s.samples.dropped() > 0)
+        ofs << ", " << _s.samples.dropped()
+            << " older samples were discarded (OMNITRACE_PROCESS_SAMPLING_RETENTION)";
+    ofs << "\n";
+}
+}  // namespace
+
+const char*
+get_name(subsystem _v)
+{
+    return subsystem_names.at(_v);
+}
+
+void
+track(subsystem _type, int64_t _bytes)
+{
+    if(!config::get_snapshot().memory_footprint) return;
+    get_tracked().at(_type).fetch_add(_bytes, std::memory_order_relaxed);
+}
+
+void
+add_source(subsystem _type, size_func_t _size, shed_func_t _shed)
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    _s.sources.emplace_back(source{ _type, std::move(_size), std::move(_shed) });
+}
+
+void
+setup()
+{
+    if(!config::get_memory_footprint()) return;
+
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) return;
+
+    // the sources of the subsystems without a process sampler. The sampling stops
+    // recording samples when it exceeds its budget
+    auto _sampling = []() { sampling::block_samples(); };
+    auto _perfetto = []() { return perfetto::get_buffer_size() * units::KB; };
+    auto _binary   = []() { return binary::interned_string::get_pool_bytes(); };
+    if(get_use_sampling())
+        _s.sources.emplace_back(source{ sampling_subsystem, {}, _sampling });
+    if(get_use_perfetto())
+        _s.sources.emplace_back(source{ perfetto_subsystem, _perfetto });
+    _s.sources.emplace_back(source{ binary_subsystem, _binary });
+
+    parse_budgets(_s);
+    _s.active = true;
+}
+
+void
+config()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    _s.samples.reset(num_subsystems, process_sampler::get_retention_capacity());
+    if(_s.active) sample_locked(_s);
+}
+
+void
+sample()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+shutdown()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    // the sampler thread may still be sampling the sources so the last sample is the
+    // footprint at shutdown
+    _s.active = false;
+}
+
+void
+post_process()
+{
+    if(!config::get_memory_footprint()) return;
+
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        shutdown();
+
+        auto& _s  = get_sampler();
+        auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+        for(size_t i = 0; i < num_subsystems; ++i)
+        {
+            OMNITRACE_VERBOSE_F(1, "%s memory footprint: %.3f MB (peak)\n",
+                                subsystem_names.at(i), as_megabytes(_s.data.at(i).peak));
+        }
+
+        try
+        {
+            write_perfetto(_s);
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_s);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the memory footprint failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace memory_footprint
+}  // namespace omnitrace
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace omnitrace
+{
+/// accounting of the memory held by the data structures of omnitrace (see
+/// OMNITRACE_MEMORY_FOOTPRINT). The containers which the application threads update
+/// track their bytes in lock-free counters and the containers of the background
+/// threads are sources which report their size when the process sampler queries
+/// them. At finalization, the footprint of each subsystem is written to perfetto and
+/// its peak to memory-footprint.txt. When a subsystem holds more than its budget in
+/// OMNITRACE_MEMORY_FOOTPRINT_BUDGET, the sources of the subsystem shed data
+namespace memory_footprint
+{
+enum subsystem : uint8_t
+{
+    sampling_subsystem = 0,      ///< samples in the buffers of the call-stack sampler
+    roctracer_subsystem,         ///< HIP activity records and in-flight HIP API calls
+    process_sampling_subsystem,  ///< samples of the background process samplers
+    perfetto_subsystem,          ///< buffer of the in-process tracing session
+    binary_subsystem,            ///< strings of the symbol tables and the line info
+    num_subsystems
+};
+
+/// bytes currently held by a source
+using size_func_t = std::function<size_t()>;
+
+/// releases some of the data of a source whose subsystem exceeds its budget
+using shed_func_t = std::function<void()>;
+
+const char*
+get_name(subsystem);
+
+/// adds (or removes, if negative) bytes of a subsystem. Lock-free so it may be called
+/// from a signal handler
+void
+track(subsystem, int64_t _bytes);
+
+/// registers a source. The functions are invoked on the thread of the process sampler
+/// so the containers of the other process samplers do not need a lock
+void
+add_source(subsystem, size_func_t _size, shed_func_t _shed = {});
+
+void
+setup();
+
+void
+config();
+
+void
+sample();
+
+void
+shutdown();
+
+void
+post_process();
+}  // namespace memory_footprint
+}  // namespace omnitrace
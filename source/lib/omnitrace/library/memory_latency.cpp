@@ -0,0 +1,391 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/memory_latency.hpp"
+#include "binary/analysis.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/unwind/processed_entry.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace memory_latency
+{
+namespace
+{
+// the level of the memory hierarchy which served the operation
+enum level_index : size_t
+{
+    l1_level = 0,
+    l2_level,
+    l3_level,
+    dram_level,
+    remote_cache_level,
+    remote_dram_level,
+    other_level,
+    num_levels
+};
+
+constexpr std::array<const char*, num_levels> level_labels = {
+    "L1", "L2", "L3", "DRAM", "remote cache", "remote DRAM", "other"
+};
+
+constexpr std::array<const char*, num_levels> level_keys = {
+    "l1", "l2", "l3", "dram", "remote_cache", "remote_dram", "other"
+};
+
+constexpr uintptr_t cache_line_size = 64;
+
+struct latency_entry
+{
+    uint64_t                         samples = 0;
+    uint64_t                         loads   = 0;
+    uint64_t                         stores  = 0;
+    uint64_t                         weight  = 0;  // latency, usually in cycles
+    std::array<uint64_t, num_levels> levels  = {};
+    std::unordered_set<uintptr_t>    lines   = {};  // distinct data cache lines
+
+    void add(bool _load, size_t _level, uintptr_t _addr, uint64_t _weight)
+    {
+        samples += 1;
+        weight += _weight;
+        levels.at(_level) += 1;
+        if(_load)
+            loads += 1;
+        else
+            stores += 1;
+        if(_addr != 0) lines.emplace(_addr / cache_line_size);
+    }
+
+    latency_entry& operator+=(const latency_entry& _rhs)
+    {
+        samples += _rhs.samples;
+        loads += _rhs.loads;
+        stores += _rhs.stores;
+        weight += _rhs.weight;
+        for(size_t i = 0; i < num_levels; ++i)
+            levels.at(i) += _rhs.levels.at(i);
+        lines.insert(_rhs.lines.begin(), _rhs.lines.end());
+        return *this;
+    }
+
+    // the latency is reported for the loads
+    double mean_weight() const
+    {
+        return (loads > 0) ? static_cast<double>(weight) / loads : 0.0;
+    }
+};
+
+using entry_map_t  = std::unordered_map<uintptr_t, latency_entry>;
+using entry_list_t = std::vector<std::pair<std::string, latency_entry>>;
+
+struct summary
+{
+    latency_entry total        = {};
+    entry_list_t  instructions = {};
+    entry_list_t  functions    = {};
+};
+
+std::once_flag post_process_once{};
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_profile()
+{
+    static auto _v = entry_map_t{};
+    return _v;
+}
+
+size_t
+get_level(const perf_mem_data_src& _src)
+{
+    constexpr uint64_t _l1_bits   = PERF_MEM_LVL_L1 | PERF_MEM_LVL_LFB;
+    constexpr uint64_t _rram_bits = PERF_MEM_LVL_REM_RAM1 | PERF_MEM_LVL_REM_RAM2;
+    constexpr uint64_t _rcce_bits = PERF_MEM_LVL_REM_CCE1 | PERF_MEM_LVL_REM_CCE2;
+
+    auto _lvl = static_cast<uint64_t>(_src.mem_lvl);
+    if((_lvl & PERF_MEM_LVL_MISS) != 0 && (_lvl & PERF_MEM_LVL_HIT) == 0)
+        return other_level;
+    if((_lvl & _l1_bits) != 0) return l1_level;
+    if((_lvl & PERF_MEM_LVL_L2) != 0) return l2_level;
+    if((_lvl & PERF_MEM_LVL_L3) != 0) return l3_level;
+    if((_lvl & PERF_MEM_LVL_LOC_RAM) != 0) return dram_level;
+    if((_lvl & _rcce_bits) != 0) return remote_cache_level;
+    if((_lvl & _rram_bits) != 0) return remote_dram_level;
+
+#if defined(PERF_MEM_LVLNUM_RAM)
+    // the newer PMU drivers only report the level number
+    auto _remote = (_src.mem_remote != 0);
+    switch(_src.mem_lvl_num)
+    {
+        case PERF_MEM_LVLNUM_L1:
+        case PERF_MEM_LVLNUM_LFB: return l1_level;
+        case PERF_MEM_LVLNUM_L2: return (_remote) ? remote_cache_level : l2_level;
+        case PERF_MEM_LVLNUM_L3:
+        case PERF_MEM_LVLNUM_ANY_CACHE:
+            return (_remote) ? remote_cache_level : l3_level;
+        case PERF_MEM_LVLNUM_RAM: return (_remote) ? remote_dram_level : dram_level;
+        default: break;
+    }
+#endif
+    return other_level;
+}
+
+std::string
+as_hex_string(uintptr_t _v)
+{
+    auto _ss = std::stringstream{};
+    _ss << "0x" << std::hex << _v;
+    return _ss.str();
+}
+
+std::string
+get_instruction_label(uintptr_t _ip)
+{
+    if(auto _val = binary::lookup_ipaddr_entry<true>(_ip); _val)
+    {
+        auto _func = (_val->name.empty()) ? "??" : tim::demangle(_val->name);
+        if(_val->location.empty()) return JOIN("", _func, " [", as_hex_string(_ip), "]");
+        auto _line = (_val->lineno == 0) ? "?" : JOIN("", _val->lineno);
+        return JOIN("", _func, " @ ", _val->location, ":", _line, " [",
+                    as_hex_string(_ip), "]");
+    }
+    return as_hex_string(_ip);
+}
+
+std::string
+get_function_label(uintptr_t _ip)
+{
+    if(auto _val = binary::lookup_ipaddr_entry<true>(_ip); _val && !_val->name.empty())
+        return tim::demangle(_val->name);
+    return as_hex_string(_ip);
+}
+
+// requires the mutex to be held
+summary
+get_summary()
+{
+    const auto& _profile = get_profile();
+
+    auto _summary = summary{};
+    for(const auto& itr : _profile)
+        _summary.total += itr.second;
+
+    auto _merge = [](const entry_map_t& _data, auto&& _label) {
+        auto _merged = std::map<std::string, latency_entry>{};
+        for(const auto& itr : _data)
+            _merged[_label(itr.first)] += itr.second;
+
+        auto _v = entry_list_t{ _merged.begin(), _merged.end() };
+        std::stable_sort(_v.begin(), _v.end(), [](const auto& _lhs, const auto& _rhs) {
+            if(_lhs.second.weight != _rhs.second.weight)
+                return _lhs.second.weight > _rhs.second.weight;
+            return _lhs.second.samples > _rhs.second.samples;
+        });
+        return _v;
+    };
+
+    _summary.instructions = _merge(_profile, get_instruction_label);
+    _summary.functions    = _merge(_profile, get_function_label);
+
+    return _summary;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname =
+        tim::settings::compose_output_filename("sampling-memory-latency", ".txt");
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening memory latency output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(
+            _fname, std::string{ "sampling-memory-latency" });
+
+    const auto& _total = _data.total;
+    ofs << "samples: " << _total.samples << ", loads: " << _total.loads
+        << ", stores: " << _total.stores << ", mean load latency: "
+        << std::setprecision(2) << std::fixed << _total.mean_weight() << "\n";
+
+    auto _write = [&ofs](const entry_list_t& _entries, const char* _label) {
+        ofs << "\n"
+            << std::setw(10) << "samples" << " | " << std::setw(10) << "loads" << " | "
+            << std::setw(10) << "stores" << " | " << std::setw(14) << "total latency"
+            << " | " << std::setw(12) << "mean latency";
+        for(const auto* itr : level_labels)
+            ofs << " | " << std::setw(12) << itr;
+        ofs << " | " << std::setw(11) << "cache lines" << " | " << _label << "\n";
+        for(const auto& itr : _entries)
+        {
+            const auto& _v = itr.second;
+            ofs << std::setw(10) << _v.samples << " | " << std::setw(10) << _v.loads
+                << " | " << std::setw(10) << _v.stores << " | " << std::setw(14)
+                << _v.weight << " | " << std::setw(12) << _v.mean_weight();
+            for(auto litr : _v.levels)
+                ofs << " | " << std::setw(12) << litr;
+            ofs << " | " << std::setw(11) << _v.lines.size() << " | " << itr.first
+                << "\n";
+        }
+    };
+
+    _write(_data.instructions, "instruction");
+    _write(_data.functions, "function");
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    auto _save = [](auto& ar, const latency_entry& _v) {
+        (*ar)(cereal::make_nvp("samples", _v.samples),
+              cereal::make_nvp("loads", _v.loads), cereal::make_nvp("stores", _v.stores),
+              cereal::make_nvp("weight", _v.weight),
+              cereal::make_nvp("cache_lines", _v.lines.size()));
+        ar->setNextName("levels");
+        ar->startNode();
+        for(size_t i = 0; i < num_levels; ++i)
+            (*ar)(cereal::make_nvp(level_keys.at(i), _v.levels.at(i)));
+        ar->finishNode();
+    };
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("memory_latency");
+        ar->startNode();
+
+        _save(ar, _data.total);
+
+        auto _save_list = [&ar, &_save](const char* _name, const char* _key,
+                                        const entry_list_t& _entries) {
+            ar->setNextName(_name);
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : _entries)
+            {
+                ar->startNode();
+                (*ar)(cereal::make_nvp(_key, itr.first));
+                _save(ar, itr.second);
+                ar->finishNode();
+            }
+            ar->finishNode();
+        };
+
+        _save_list("instructions", "instruction", _data.instructions);
+        _save_list("functions", "function", _data.functions);
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname =
+        tim::settings::compose_output_filename("sampling-memory-latency", ".json");
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening memory latency output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(
+            _fname, std::string{ "sampling-memory-latency" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+record(uintptr_t _ip, uintptr_t _addr, uint64_t _weight, uint64_t _data_src)
+{
+    auto _src = perf_mem_data_src{};
+    _src.val  = _data_src;
+
+    auto _op = static_cast<uint64_t>(_src.mem_op);
+    if(_data_src == 0 || (_op & (PERF_MEM_OP_LOAD | PERF_MEM_OP_STORE)) == 0) return;
+
+    auto _load = ((_op & PERF_MEM_OP_LOAD) != 0);
+    auto _lk   = std::unique_lock<std::mutex>{ get_mutex() };
+    get_profile()[_ip].add(_load, get_level(_src), _addr, (_load) ? _weight : 0);
+}
+
+void
+post_process()
+{
+    std::call_once(post_process_once, []() {
+        std::unique_lock<std::mutex> _lk{ get_mutex() };
+        if(get_profile().empty()) return;
+
+        try
+        {
+            auto _data = get_summary();
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the memory latency profile failed: %s\n",
+                                _e.what());
+        }
+
+        get_profile().clear();
+    });
+}
+}  // namespace memory_latency
+}  // namespace omnitrace
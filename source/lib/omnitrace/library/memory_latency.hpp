@@ -0,0 +1,48 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// memory operations sampled by a precise overflow event (see
+/// OMNITRACE_SAMPLING_OVERFLOW_EVENT), e.g. the IBS op samples of the AMD CPUs. Along
+/// with the precise instruction pointer, these samples carry the data address, the
+/// latency and the level of the memory hierarchy which served a load or a store. The
+/// samples are accumulated per instruction and per function while the overflow
+/// samples are post-processed and written to sampling-memory-latency.{txt,json}
+namespace memory_latency
+{
+/// accumulates the sample of a memory operation. The samples whose data source is not
+/// a load or a store are ignored
+void
+record(uintptr_t _ip, uintptr_t _addr, uint64_t _weight, uint64_t _data_src);
+
+/// writes the profile if any memory operation was sampled. Only the first invocation
+/// has an effect
+void
+post_process();
+}  // namespace memory_latency
+}  // namespace omnitrace
@@ -0,0 +1,678 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/mpi_pvars.hpp"
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+
+#    include "core/categories.hpp"
+#    include "core/common.hpp"
+#    include "core/config.hpp"
+#    include "core/debug.hpp"
+#    include "core/perfetto.hpp"
+#    include "core/timemory.hpp"
+#    include "library/region_attribution.hpp"
+#    include "library/tracing.hpp"
+
+#    include <timemory/hash/types.hpp>
+#    include <timemory/operations/types/file_output_message.hpp>
+#    include <timemory/tpls/cereal/cereal.hpp>
+#    include <timemory/units.hpp>
+#    include <timemory/utility/filepath.hpp>
+
+#    include <mpi.h>
+
+#    include <algorithm>
+#    include <array>
+#    include <cstdint>
+#    include <cstring>
+#    include <exception>
+#    include <fstream>
+#    include <iomanip>
+#    include <limits>
+#    include <mutex>
+#    include <regex>
+#    include <sstream>
+#    include <string>
+#    include <unordered_map>
+#    include <utility>
+#    include <vector>
+
+namespace omnitrace
+{
+namespace mpi_pvars
+{
+namespace
+{
+using region_attribution::timeline;
+
+struct pvar
+{
+    int               index      = 0;
+    int               var_class  = 0;
+    bool              continuous = false;
+    MPI_Datatype      datatype   = MPI_DATATYPE_NULL;
+    MPI_T_pvar_handle handle     = MPI_T_PVAR_HANDLE_NULL;
+    std::vector<char> buffer     = {};  // the elements of the variable
+    std::string       name       = {};
+    std::string       desc       = {};
+    timeline          values     = {};
+};
+
+struct sampler_state
+{
+    std::mutex         mutex    = {};
+    bool               active   = false;
+    bool               finished = false;  // the MPI_T interface can not be re-opened
+    MPI_T_pvar_session session  = MPI_T_PVAR_SESSION_NULL;
+    std::vector<pvar>  pvars    = {};
+};
+
+// intentionally leaked so the sampler does not depend on the order of the static
+// destruction
+sampler_state&
+get_sampler()
+{
+    static auto* _v = new sampler_state{};
+    return *_v;
+}
+
+const char*
+get_class_name(int _v)
+{
+    switch(_v)
+    {
+        case MPI_T_PVAR_CLASS_STATE: return "state";
+        case MPI_T_PVAR_CLASS_LEVEL: return "level";
+        case MPI_T_PVAR_CLASS_SIZE: return "size";
+        case MPI_T_PVAR_CLASS_PERCENTAGE: return "percentage";
+        case MPI_T_PVAR_CLASS_HIGHWATERMARK: return "highwatermark";
+        case MPI_T_PVAR_CLASS_LOWWATERMARK: return "lowwatermark";
+        case MPI_T_PVAR_CLASS_COUNTER: return "counter";
+        case MPI_T_PVAR_CLASS_AGGREGATE: return "aggregate";
+        case MPI_T_PVAR_CLASS_TIMER: return "timer";
+        case MPI_T_PVAR_CLASS_GENERIC: return "generic";
+        default: break;
+    }
+    return "unknown";
+}
+
+// the counters, aggregates and timers only increase while the session is started so
+// the change over an interval is meaningful. The other classes are instantaneous
+bool
+is_monotonic(int _v)
+{
+    return (_v == MPI_T_PVAR_CLASS_COUNTER || _v == MPI_T_PVAR_CLASS_AGGREGATE ||
+            _v == MPI_T_PVAR_CLASS_TIMER);
+}
+
+// the sum of the elements, e.g. the variables of the message queues of OpenMPI hold a
+// value for every peer
+template <typename Tp>
+double
+get_sum(const std::vector<char>& _buf)
+{
+    auto _v = 0.0;
+    for(size_t i = 0; i + sizeof(Tp) <= _buf.size(); i += sizeof(Tp))
+    {
+        auto _elem = Tp{};
+        memcpy(&_elem, _buf.data() + i, sizeof(Tp));
+        _v += static_cast<double>(_elem);
+    }
+    return _v;
+}
+
+size_t
+get_size(MPI_Datatype _v)
+{
+    if(_v == MPI_INT) return sizeof(int);
+    if(_v == MPI_UNSIGNED) return sizeof(unsigned);
+    if(_v == MPI_UNSIGNED_LONG) return sizeof(unsigned long);
+    if(_v == MPI_UNSIGNED_LONG_LONG) return sizeof(unsigned long long);
+    if(_v == MPI_COUNT) return sizeof(MPI_Count);
+    if(_v == MPI_DOUBLE) return sizeof(double);
+    return 0;
+}
+
+bool
+read_value(MPI_T_pvar_session _session, pvar& _v, double& _value)
+{
+    if(MPI_T_pvar_read(_session, _v.handle, _v.buffer.data()) != MPI_SUCCESS)
+        return false;
+
+    if(_v.datatype == MPI_INT)
+        _value = get_sum<int>(_v.buffer);
+    else if(_v.datatype == MPI_UNSIGNED)
+        _value = get_sum<unsigned>(_v.buffer);
+    else if(_v.datatype == MPI_UNSIGNED_LONG)
+        _value = get_sum<unsigned long>(_v.buffer);
+    else if(_v.datatype == MPI_UNSIGNED_LONG_LONG)
+        _value = get_sum<unsigned long long>(_v.buffer);
+    else if(_v.datatype == MPI_COUNT)
+        _value = get_sum<MPI_Count>(_v.buffer);
+    else if(_v.datatype == MPI_DOUBLE)
+        _value = get_sum<double>(_v.buffer);
+    else
+        return false;
+    return true;
+}
+
+void
+sample_locked(sampler_state& _v)
+{
+    auto _ts = tracing::now();
+    for(auto& itr : _v.pvars)
+    {
+        auto _value = 0.0;
+        if(read_value(_v.session, itr, _value)) itr.values.push(_ts, _value);
+    }
+}
+
+// allocates a handle for every numeric variable matching the pattern which is not
+// bound to an MPI object (other than a communicator)
+void
+open_pvars(sampler_state& _s, const std::regex& _pattern)
+{
+    int _num = 0;
+    if(MPI_T_pvar_get_num(&_num) != MPI_SUCCESS) return;
+
+    for(int i = 0; i < _num; ++i)
+    {
+        auto         _name       = std::array<char, 256>{};
+        auto         _desc       = std::array<char, 1024>{};
+        int          _name_len   = static_cast<int>(_name.size());
+        int          _desc_len   = static_cast<int>(_desc.size());
+        int          _verbosity  = 0;
+        int          _class      = 0;
+        int          _bind       = 0;
+        int          _readonly   = 0;
+        int          _continuous = 0;
+        int          _atomic     = 0;
+        MPI_Datatype _datatype   = MPI_DATATYPE_NULL;
+        MPI_T_enum   _enumtype   = MPI_T_ENUM_NULL;
+
+        if(MPI_T_pvar_get_info(i, _name.data(), &_name_len, &_verbosity, &_class,
+                               &_datatype, &_enumtype, _desc.data(), &_desc_len,
+                               &_bind, &_readonly, &_continuous,
+                               &_atomic) != MPI_SUCCESS)
+            continue;
+
+        if(!std::regex_search(_name.data(), _pattern)) continue;
+
+        // the variables of the communicators (e.g. the message queues) are read for
+        // MPI_COMM_WORLD
+        auto  _comm = MPI_Comm{ MPI_COMM_WORLD };
+        void* _obj  = (_bind == MPI_T_BIND_MPI_COMM) ? &_comm : nullptr;
+        if((_bind != MPI_T_BIND_NO_OBJECT && _obj == nullptr) || get_size(_datatype) == 0)
+        {
+            const auto* _reason =
+                (get_size(_datatype) == 0) ? "non-numeric" : "MPI object";
+            OMNITRACE_VERBOSE_F(2,
+                                "Skipping the MPI_T performance variable '%s' (%s "
+                                "variables are not supported)\n",
+                                _name.data(), _reason);
+            continue;
+        }
+
+        auto _v       = pvar{};
+        _v.index      = i;
+        _v.var_class  = _class;
+        _v.continuous = (_continuous != 0);
+        _v.datatype   = _datatype;
+        _v.name       = _name.data();
+        _v.desc       = _desc.data();
+
+        int _count = 0;
+        if(MPI_T_pvar_handle_alloc(_s.session, i, _obj, &_v.handle, &_count) !=
+           MPI_SUCCESS)
+            continue;
+
+        if(_count < 1 ||
+           (!_v.continuous && MPI_T_pvar_start(_s.session, _v.handle) != MPI_SUCCESS))
+        {
+            OMNITRACE_VERBOSE_F(2, "Skipping the MPI_T performance variable '%s'\n",
+                                _v.name.c_str());
+            MPI_T_pvar_handle_free(_s.session, &_v.handle);
+            continue;
+        }
+        _v.buffer.resize(_count * get_size(_datatype), 0);
+
+        OMNITRACE_VERBOSE_F(2, "Sampling the MPI_T performance variable '%s' (%s)\n",
+                            _v.name.c_str(), get_class_name(_class));
+        _s.pvars.emplace_back(std::move(_v));
+    }
+}
+
+void
+close_locked(sampler_state& _s)
+{
+    for(auto& itr : _s.pvars)
+    {
+        if(!itr.continuous) MPI_T_pvar_stop(_s.session, itr.handle);
+        MPI_T_pvar_handle_free(_s.session, &itr.handle);
+    }
+    if(_s.session != MPI_T_PVAR_SESSION_NULL) MPI_T_pvar_session_free(&_s.session);
+    MPI_T_finalize();
+    _s.active   = false;
+    _s.finished = true;
+}
+
+double
+get_rate(const timeline& _v, size_t _idx)
+{
+    if(_idx + 1 >= _v.ts.size() || _v.ts.at(_idx + 1) <= _v.ts.at(_idx)) return 0.0;
+    return (_v.values.at(_idx + 1) - _v.values.at(_idx)) /
+           (static_cast<double>(_v.ts.at(_idx + 1) - _v.ts.at(_idx)) / units::sec);
+}
+
+// the highest sample while the interval was active, including the values at the
+// begin and the end
+double
+get_max(const timeline& _v, uint64_t _beg, uint64_t _end)
+{
+    auto _max = std::max(_v.at(_beg), _v.at(_end));
+    auto _itr = std::upper_bound(_v.ts.begin(), _v.ts.end(), _beg);
+    for(; _itr != _v.ts.end() && *_itr < _end; ++_itr)
+        _max = std::max(_max, _v.values.at(std::distance(_v.ts.begin(), _itr)));
+    return _max;
+}
+
+struct region_entry
+{
+    uint64_t            count  = 0;
+    uint64_t            time   = 0;
+    std::vector<double> values = {};  // change of the counters, max. of the levels
+};
+
+struct pvar_entry
+{
+    std::string name      = {};
+    std::string desc      = {};
+    std::string var_class = {};
+    bool        monotonic = false;
+    double      first     = 0.0;
+    double      last      = 0.0;
+    double      min       = 0.0;
+    double      max       = 0.0;
+};
+
+struct summary
+{
+    double                                            duration = 0.0;
+    std::vector<pvar_entry>                           pvars    = {};
+    std::vector<std::pair<std::string, region_entry>> regions  = {};
+};
+
+summary
+get_summary(const sampler_state& _s)
+{
+    auto _data = summary{};
+
+    auto _beg = std::numeric_limits<uint64_t>::max();
+    auto _end = uint64_t{ 0 };
+    for(const auto& itr : _s.pvars)
+    {
+        if(itr.values.empty()) continue;
+        _beg = std::min(_beg, itr.values.ts.front());
+        _end = std::max(_end, itr.values.ts.back());
+    }
+    if(_end == 0) return _data;
+    _data.duration = static_cast<double>(_end - _beg) / units::sec;
+
+    for(const auto& itr : _s.pvars)
+    {
+        auto _entry      = pvar_entry{};
+        _entry.name      = itr.name;
+        _entry.desc      = itr.desc;
+        _entry.var_class = get_class_name(itr.var_class);
+        _entry.monotonic = is_monotonic(itr.var_class);
+        if(!itr.values.empty())
+        {
+            const auto& _v = itr.values.values;
+            _entry.first   = _v.front();
+            _entry.last    = _v.back();
+            _entry.min     = *std::min_element(_v.begin(), _v.end());
+            _entry.max     = *std::max_element(_v.begin(), _v.end());
+        }
+        _data.pvars.emplace_back(std::move(_entry));
+    }
+
+    // regions which were still open end with the last sample
+    auto _regions = std::unordered_map<uint64_t, region_entry>{};
+    for(const auto& itr : region_attribution::get_intervals(_end))
+    {
+        auto& _entry = _regions[itr.hash];
+        _entry.values.resize(_s.pvars.size(), 0.0);
+        _entry.count += 1;
+        _entry.time += (itr.end - itr.begin);
+        for(size_t i = 0; i < _s.pvars.size(); ++i)
+        {
+            const auto& _v = _s.pvars.at(i);
+            if(_v.values.empty()) continue;
+            if(is_monotonic(_v.var_class))
+                _entry.values.at(i) += _v.values.between(itr.begin, itr.end);
+            else
+                _entry.values.at(i) = std::max(_entry.values.at(i),
+                                               get_max(_v.values, itr.begin, itr.end));
+        }
+    }
+
+    for(const auto& itr : _regions)
+    {
+        _data.regions.emplace_back(
+            std::string{ tim::get_hash_identifier_fast(itr.first) }, itr.second);
+    }
+
+    std::sort(_data.regions.begin(), _data.regions.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  return _lhs.second.time > _rhs.second.time;
+              });
+
+    return _data;
+}
+
+void
+write_perfetto(const sampler_state& _s)
+{
+    using track = perfetto_counter_track<category::mpi_pvars>;
+
+    if(!get_use_perfetto()) return;
+
+    const auto* _category = trait::name<category::mpi_pvars>::value;
+    for(const auto& itr : _s.pvars)
+    {
+        const auto& _v = itr.values;
+        if(_v.ts.size() < 2) continue;
+
+        auto _monotonic = is_monotonic(itr.var_class);
+        auto _idx       = track::size(0);
+        track::emplace(0, JOIN(' ', "MPI_T", itr.name), (_monotonic) ? "1/s" : "");
+        if(_monotonic)
+        {
+            for(size_t j = 0; j + 1 < _v.ts.size(); ++j)
+                TRACE_COUNTER(_category, track::at(0, _idx), _v.ts.at(j),
+                              get_rate(_v, j));
+            TRACE_COUNTER(_category, track::at(0, _idx), _v.ts.back(), 0.0);
+        }
+        else
+        {
+            for(size_t j = 0; j < _v.ts.size(); ++j)
+                TRACE_COUNTER(_category, track::at(0, _idx), _v.ts.at(j),
+                              _v.values.at(j));
+        }
+    }
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("mpi-pvars", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening mpi-pvars output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "mpi-pvars" });
+
+    ofs << std::fixed << std::setprecision(3);
+    ofs << "duration: " << _data.duration << " sec\n\n";
+    ofs << std::setw(14) << "class" << " | " << std::setw(14) << "first" << " | "
+        << std::setw(14) << "last" << " | " << std::setw(14) << "min" << " | "
+        << std::setw(14) << "max" << " | " << "variable\n";
+    for(const auto& itr : _data.pvars)
+    {
+        ofs << std::setw(14) << itr.var_class << " | " << std::setw(14) << itr.first
+            << " | " << std::setw(14) << itr.last << " | " << std::setw(14) << itr.min
+            << " | " << std::setw(14) << itr.max << " | " << itr.name << " ("
+            << itr.desc << ")\n";
+    }
+
+    // a table of the regions for every variable which changed within a region
+    for(size_t i = 0; i < _data.pvars.size(); ++i)
+    {
+        const auto& _pvar = _data.pvars.at(i);
+        auto        _used = std::any_of(
+            _data.regions.begin(), _data.regions.end(),
+            [i](const auto& _v) { return _v.second.values.at(i) != 0.0; });
+        if(!_used) continue;
+
+        ofs << "\n"
+            << _pvar.name << " (" << ((_pvar.monotonic) ? "change" : "max") << ")\n"
+            << std::setw(10) << "count" << " | " << std::setw(12) << "time [sec]"
+            << " | " << std::setw(14) << "value" << " | " << "region\n";
+        for(const auto& itr : _data.regions)
+        {
+            const auto& _v = itr.second;
+            if(_v.values.at(i) == 0.0) continue;
+            ofs << std::setw(10) << _v.count << " | " << std::setw(12)
+                << static_cast<double>(_v.time) / units::sec << " | " << std::setw(14)
+                << _v.values.at(i) << " | " << itr.first << "\n";
+        }
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("mpi_pvars");
+        ar->startNode();
+
+        (*ar)(cereal::make_nvp("duration", _data.duration));
+
+        ar->setNextName("pvars");
+        ar->startNode();
+        ar->makeArray();
+        for(size_t i = 0; i < _data.pvars.size(); ++i)
+        {
+            const auto& _v = _data.pvars.at(i);
+            ar->startNode();
+            (*ar)(cereal::make_nvp("name", _v.name),
+                  cereal::make_nvp("description", _v.desc),
+                  cereal::make_nvp("class", _v.var_class),
+                  cereal::make_nvp("first", _v.first), cereal::make_nvp("last", _v.last),
+                  cereal::make_nvp("min", _v.min), cereal::make_nvp("max", _v.max));
+
+            ar->setNextName("regions");
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : _data.regions)
+            {
+                if(itr.second.values.at(i) == 0.0) continue;
+                ar->startNode();
+                (*ar)(cereal::make_nvp("region", itr.first),
+                      cereal::make_nvp("count", itr.second.count),
+                      cereal::make_nvp("time", itr.second.time),
+                      cereal::make_nvp((_v.monotonic) ? "change" : "max",
+                                       itr.second.values.at(i)));
+                ar->finishNode();
+            }
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("mpi-pvars", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening mpi-pvars output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "mpi-pvars" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+start()
+{
+    if(!config::get_snapshot().mpi_pvars) return;
+
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active || _s.finished) return;
+
+    auto _pattern = std::regex{};
+    try
+    {
+        _pattern = std::regex{ config::get_mpi_pvars(), std::regex_constants::optimize };
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "invalid OMNITRACE_MPI_PVARS pattern '%s': %s\n",
+                            config::get_mpi_pvars().c_str(), _e.what());
+        _s.finished = true;
+        return;
+    }
+
+    // the sampler thread reads the variables while the application calls MPI so
+    // the calls into the MPI_T interface are serialized by the mutex
+    int _provided = MPI_THREAD_SINGLE;
+    if(MPI_T_init_thread(MPI_THREAD_SERIALIZED, &_provided) != MPI_SUCCESS)
+    {
+        OMNITRACE_WARNING_F(0, "MPI_T_init_thread failed. The MPI_T performance "
+                               "variables are not sampled\n");
+        _s.finished = true;
+        return;
+    }
+
+    if(_provided < MPI_THREAD_SERIALIZED ||
+       MPI_T_pvar_session_create(&_s.session) != MPI_SUCCESS)
+    {
+        OMNITRACE_WARNING_F(0, "the MPI_T interface does not support the access from "
+                               "the sampler thread. The MPI_T performance variables "
+                               "are not sampled\n");
+        close_locked(_s);
+        return;
+    }
+
+    open_pvars(_s, _pattern);
+
+    OMNITRACE_WARNING_IF_F(_s.pvars.empty(),
+                           "No MPI_T performance variables matching '%s' are "
+                           "available\n",
+                           config::get_mpi_pvars().c_str());
+    if(_s.pvars.empty())
+    {
+        close_locked(_s);
+        return;
+    }
+
+    OMNITRACE_VERBOSE_F(1, "Sampling %zu MPI_T performance variables\n",
+                        _s.pvars.size());
+
+    _s.active = true;
+    sample_locked(_s);
+}
+
+void
+stop()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(!_s.active) return;
+
+    // the values until the end of the application
+    sample_locked(_s);
+    close_locked(_s);
+}
+
+void
+setup()
+{}
+
+void
+config()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+sample()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+shutdown()
+{
+    stop();
+}
+
+void
+post_process()
+{
+    if(!config::get_snapshot().mpi_pvars) return;
+
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        shutdown();
+        region_attribution::stop();
+
+        auto& _s  = get_sampler();
+        auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+
+        try
+        {
+            auto _data = get_summary(_s);
+            if(_data.duration <= 0.0)
+            {
+                OMNITRACE_VERBOSE_F(1, "No MPI_T performance variable samples were "
+                                       "recorded\n");
+                return;
+            }
+
+            write_perfetto(_s);
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the MPI_T performance variables failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace mpi_pvars
+}  // namespace omnitrace
+
+#endif
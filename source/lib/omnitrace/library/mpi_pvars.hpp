@@ -0,0 +1,93 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+namespace omnitrace
+{
+/// MPI_T performance variables of the MPI library (see OMNITRACE_MPI_PVARS), e.g. the
+/// length of the unexpected message queue or the number of eager and rendezvous
+/// messages. The variables matching the pattern are discovered once MPI_Init returns
+/// and are read in a MPI_T session by the background process sampler. At
+/// finalization, the counters are written to perfetto as rates and the levels as
+/// values, the change of each counter (or the highest level) while each region was
+/// active is found from the samples around it (see region_attribution) and the
+/// results are written to mpi-pvars.{txt,json}
+namespace mpi_pvars
+{
+/// opens the MPI_T session. Called after MPI_Init
+void
+start();
+
+/// reads the variables a last time and closes the MPI_T session. Called before
+/// MPI_Finalize
+void
+stop();
+
+void
+setup();
+
+void
+config();
+
+void
+sample();
+
+void
+shutdown();
+
+void
+post_process();
+
+#if !defined(TIMEMORY_USE_MPI) || TIMEMORY_USE_MPI == 0
+inline void
+start()
+{}
+
+inline void
+stop()
+{}
+
+inline void
+setup()
+{}
+
+inline void
+config()
+{}
+
+inline void
+sample()
+{}
+
+inline void
+shutdown()
+{}
+
+inline void
+post_process()
+{}
+#endif
+}  // namespace mpi_pvars
+}  // namespace omnitrace
@@ -0,0 +1,745 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/numa_locality.hpp"
+#include "binary/analysis.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perf.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/housekeeping.hpp"
+#include "library/perf.hpp"
+#include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/unwind/processed_entry.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace numa_locality
+{
+namespace
+{
+using perf_event_t = perf::perf_event;
+
+// the counts of the sampled loads. The loads whose page could not be resolved (e.g.
+// the page was unmapped) are neither local nor remote
+struct locality_entry
+{
+    uint64_t samples     = 0;
+    uint64_t local       = 0;
+    uint64_t remote      = 0;
+    uint64_t dram        = 0;  // served by the memory of a node
+    uint64_t dram_remote = 0;
+    uint64_t weight      = 0;  // latency, usually in cycles
+
+    void add(int _cpu_node, int _page_node, bool _dram, uint64_t _weight)
+    {
+        samples += 1;
+        weight += _weight;
+        if(_page_node < 0 || _cpu_node < 0) return;
+
+        bool _remote = (_page_node != _cpu_node);
+        if(_remote)
+            remote += 1;
+        else
+            local += 1;
+        if(_dram)
+        {
+            dram += 1;
+            if(_remote) dram_remote += 1;
+        }
+    }
+
+    locality_entry& operator+=(const locality_entry& _rhs)
+    {
+        samples += _rhs.samples;
+        local += _rhs.local;
+        remote += _rhs.remote;
+        dram += _rhs.dram;
+        dram_remote += _rhs.dram_remote;
+        weight += _rhs.weight;
+        return *this;
+    }
+
+    double remote_percent() const
+    {
+        return (local + remote > 0) ? (100.0 * remote) / (local + remote) : 0.0;
+    }
+
+    double dram_remote_percent() const
+    {
+        return (dram > 0) ? (100.0 * dram_remote) / dram : 0.0;
+    }
+
+    double mean_weight() const
+    {
+        return (samples > 0) ? static_cast<double>(weight) / samples : 0.0;
+    }
+};
+
+struct raw_sample
+{
+    uintptr_t ip       = 0;
+    uintptr_t addr     = 0;
+    uint64_t  weight   = 0;
+    uint64_t  data_src = 0;
+    uint32_t  cpu      = 0;
+};
+
+struct thread_state
+{
+    int64_t      tid   = 0;
+    uint64_t     lost  = 0;
+    perf_event_t event = {};
+};
+
+struct allocation
+{
+    uintptr_t end       = 0;
+    uintptr_t call_site = 0;
+};
+
+using entry_map_t  = std::unordered_map<uintptr_t, locality_entry>;
+using node_pair_t  = std::pair<int, int>;  // node of the CPU, node of the page
+using node_map_t   = std::map<node_pair_t, uint64_t>;
+using entry_list_t = std::vector<std::pair<std::string, locality_entry>>;
+
+struct profile_data
+{
+    locality_entry total     = {};
+    entry_map_t    sites     = {};  // call-site of the allocation, zero for the others
+    entry_map_t    functions = {};  // instruction address
+    node_map_t     nodes     = {};
+};
+
+struct summary
+{
+    locality_entry total     = {};
+    uint64_t       lost      = 0;
+    entry_list_t   sites     = {};
+    entry_list_t   functions = {};
+    node_map_t     nodes     = {};
+};
+
+// the number of pages resolved per move_pages system call
+constexpr size_t resolve_batch_size = 512;
+
+// the ring buffers only need to hold the samples within one collection interval
+constexpr auto collect_interval = std::chrono::milliseconds{ 20 };
+
+std::once_flag post_process_once{};
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+auto&
+get_threads()
+{
+    static auto _v = std::map<int64_t, std::unique_ptr<thread_state>>{};
+    return _v;
+}
+
+auto&
+get_profile()
+{
+    static auto _v = profile_data{};
+    return _v;
+}
+
+auto&
+get_allocation_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_allocations()
+{
+    static auto _v = std::map<uintptr_t, allocation>{};
+    return _v;
+}
+
+// the NUMA node of each CPU or -1
+const std::vector<int>&
+get_cpu_nodes()
+{
+    static auto _v = []() {
+        auto _read = [](const std::string& _path) {
+            auto _ifs = std::ifstream{ _path };
+            auto _val = std::string{};
+            if(_ifs) std::getline(_ifs, _val);
+            return _val;
+        };
+
+        auto _data  = std::vector<int>{};
+        auto _nodes = _read("/sys/devices/system/node/online");
+        if(_nodes.empty()) return _data;
+
+        for(auto nitr : utility::parse_numeric_range<>(_nodes, "NUMA nodes", 1L))
+        {
+            auto _cpus =
+                _read(JOIN("", "/sys/devices/system/node/node", nitr, "/cpulist"));
+            if(_cpus.empty()) continue;
+            for(auto citr : utility::parse_numeric_range<>(_cpus, "CPUs", 1L))
+            {
+                if(citr < 0) continue;
+                if(static_cast<size_t>(citr) >= _data.size()) _data.resize(citr + 1, -1);
+                _data.at(citr) = static_cast<int>(nitr);
+            }
+        }
+        return _data;
+    }();
+    return _v;
+}
+
+int
+get_cpu_node(uint32_t _cpu)
+{
+    const auto& _v = get_cpu_nodes();
+    return (_cpu < _v.size()) ? _v.at(_cpu) : -1;
+}
+
+bool
+is_dram(uint64_t _data_src)
+{
+    auto _src = perf_mem_data_src{};
+    _src.val  = _data_src;
+    return (_src.mem_lvl &
+            (PERF_MEM_LVL_LOC_RAM | PERF_MEM_LVL_REM_RAM1 | PERF_MEM_LVL_REM_RAM2)) != 0;
+}
+
+// the call-site of the allocation containing the address or zero
+uintptr_t
+get_allocation_site(uintptr_t _addr)
+{
+    auto  _lk = std::unique_lock<std::mutex>{ get_allocation_mutex() };
+    auto& _v  = get_allocations();
+    auto  itr = _v.upper_bound(_addr);
+    if(itr == _v.begin()) return 0;
+    --itr;
+    return (_addr < itr->second.end) ? itr->second.call_site : 0;
+}
+
+// requires the mutex to be held
+void
+drain(thread_state& _state, std::vector<raw_sample>& _samples)
+{
+    if(!_state.event.is_open()) return;
+
+    for(auto itr : _state.event)
+    {
+        if(itr.is_lost())
+        {
+            ++_state.lost;
+            continue;
+        }
+        if(!itr.is_sample()) continue;
+
+        auto _sample     = raw_sample{};
+        _sample.ip       = itr.get_ip();
+        _sample.addr     = itr.get_addr();
+        _sample.weight   = itr.get_weight();
+        _sample.data_src = itr.get_data_src();
+        _sample.cpu      = itr.get_cpu();
+        _samples.emplace_back(_sample);
+    }
+}
+
+// requires the mutex to be held. The nodes of the pages are queried in batches with
+// move_pages without target nodes, which only reports the node of each page
+void
+process(const std::vector<raw_sample>& _samples)
+{
+    static const auto _page_mask = ~(static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1);
+
+    auto& _profile = get_profile();
+    auto  _pages   = std::vector<void*>{};
+    auto  _status  = std::vector<int>{};
+    for(size_t i = 0; i < _samples.size(); i += resolve_batch_size)
+    {
+        auto _n = std::min(resolve_batch_size, _samples.size() - i);
+        _pages.resize(_n);
+        _status.assign(_n, -EFAULT);
+        for(size_t j = 0; j < _n; ++j)
+            _pages.at(j) = reinterpret_cast<void*>(_samples.at(i + j).addr & _page_mask);
+
+        if(syscall(SYS_move_pages, 0, _n, _pages.data(), nullptr, _status.data(), 0) !=
+           0)
+            _status.assign(_n, -EFAULT);
+
+        for(size_t j = 0; j < _n; ++j)
+        {
+            const auto& _sample    = _samples.at(i + j);
+            auto        _cpu_node  = get_cpu_node(_sample.cpu);
+            auto        _page_node = (_sample.addr == 0) ? -1 : _status.at(j);
+            auto        _dram      = is_dram(_sample.data_src);
+            auto        _site      = get_allocation_site(_sample.addr);
+
+            _profile.total.add(_cpu_node, _page_node, _dram, _sample.weight);
+            _profile.sites[_site].add(_cpu_node, _page_node, _dram, _sample.weight);
+            _profile.functions[_sample.ip].add(_cpu_node, _page_node, _dram,
+                                               _sample.weight);
+            if(_cpu_node >= 0 && _page_node >= 0)
+                _profile.nodes[node_pair_t{ _cpu_node, _page_node }] += 1;
+        }
+    }
+}
+
+// requires the mutex to be held
+void
+collect()
+{
+    auto _samples = std::vector<raw_sample>{};
+    for(auto& itr : get_threads())
+        drain(*itr.second, _samples);
+    process(_samples);
+}
+
+void
+start_collector()
+{
+    if(get_thread()) return;
+
+    auto _func = []() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.numa");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        while(get_active().load())
+        {
+            std::unique_lock<std::mutex> _lk{ get_mutex() };
+            get_cv().wait_for(_lk, collect_interval);
+            collect();
+        }
+    };
+
+    get_active().store(true);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_thread() = std::make_unique<std::thread>(_func);
+}
+
+std::string
+as_hex_string(uintptr_t _v)
+{
+    auto _ss = std::stringstream{};
+    _ss << "0x" << std::hex << _v;
+    return _ss.str();
+}
+
+std::string
+get_site_label(uintptr_t _call_site)
+{
+    if(_call_site == 0) return std::string{ "[other memory]" };
+    if(auto _val = binary::lookup_ipaddr_entry<false>(_call_site); _val)
+    {
+        auto _func = (_val->name.empty()) ? "??" : tim::demangle(_val->name);
+        if(_val->location.empty()) return _func;
+        auto _line = (_val->lineno == 0) ? "?" : JOIN("", _val->lineno);
+        return JOIN("", _func, " @ ", _val->location, ":", _line);
+    }
+    return as_hex_string(_call_site);
+}
+
+std::string
+get_function_label(uintptr_t _ip)
+{
+    if(auto _val = binary::lookup_ipaddr_entry<true>(_ip); _val && !_val->name.empty())
+        return tim::demangle(_val->name);
+    return as_hex_string(_ip);
+}
+
+// requires the mutex to be held
+summary
+get_summary()
+{
+    const auto& _profile = get_profile();
+
+    auto _summary  = summary{};
+    _summary.total = _profile.total;
+    _summary.nodes = _profile.nodes;
+    for(const auto& itr : get_threads())
+        _summary.lost += itr.second->lost;
+
+    auto _merge = [](const entry_map_t& _data, auto&& _label) {
+        auto _merged = std::map<std::string, locality_entry>{};
+        for(const auto& itr : _data)
+            _merged[_label(itr.first)] += itr.second;
+
+        auto _v = entry_list_t{ _merged.begin(), _merged.end() };
+        std::stable_sort(_v.begin(), _v.end(), [](const auto& _lhs, const auto& _rhs) {
+            if(_lhs.second.remote != _rhs.second.remote)
+                return _lhs.second.remote > _rhs.second.remote;
+            return _lhs.second.samples > _rhs.second.samples;
+        });
+        return _v;
+    };
+
+    _summary.sites     = _merge(_profile.sites, get_site_label);
+    _summary.functions = _merge(_profile.functions, get_function_label);
+
+    return _summary;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("numa-locality", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening numa-locality output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "numa-locality" });
+
+    const auto& _total = _data.total;
+    ofs << "samples: " << _total.samples << ", local: " << _total.local
+        << ", remote: " << _total.remote << ", remote (%): " << std::setprecision(2)
+        << std::fixed << _total.remote_percent()
+        << ", remote DRAM (%): " << _total.dram_remote_percent()
+        << ", lost records: " << _data.lost << "\n";
+
+    ofs << "\n"
+        << std::setw(10) << "cpu node" << " | " << std::setw(10) << "page node" << " | "
+        << std::setw(12) << "samples" << "\n";
+    for(const auto& itr : _data.nodes)
+    {
+        ofs << std::setw(10) << itr.first.first << " | " << std::setw(10)
+            << itr.first.second << " | " << std::setw(12) << itr.second << "\n";
+    }
+
+    auto _write = [&ofs](const entry_list_t& _entries, const char* _label) {
+        ofs << "\n"
+            << std::setw(12) << "samples" << " | " << std::setw(12) << "remote" << " | "
+            << std::setw(10) << "remote (%)" << " | " << std::setw(16)
+            << "remote DRAM (%)" << " | " << std::setw(12) << "mean weight" << " | "
+            << _label << "\n";
+        for(const auto& itr : _entries)
+        {
+            const auto& _v = itr.second;
+            ofs << std::setw(12) << _v.samples << " | " << std::setw(12) << _v.remote
+                << " | " << std::setw(10) << _v.remote_percent() << " | "
+                << std::setw(16) << _v.dram_remote_percent() << " | " << std::setw(12)
+                << _v.mean_weight() << " | " << itr.first << "\n";
+        }
+    };
+
+    _write(_data.sites, "allocation site");
+    _write(_data.functions, "function");
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    auto _save = [](auto& ar, const locality_entry& _v) {
+        (*ar)(cereal::make_nvp("samples", _v.samples),
+              cereal::make_nvp("local", _v.local), cereal::make_nvp("remote", _v.remote),
+              cereal::make_nvp("dram", _v.dram),
+              cereal::make_nvp("dram_remote", _v.dram_remote),
+              cereal::make_nvp("weight", _v.weight));
+    };
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("numa_locality");
+        ar->startNode();
+
+        _save(ar, _data.total);
+        (*ar)(cereal::make_nvp("lost_records", _data.lost));
+
+        ar->setNextName("nodes");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.nodes)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("cpu_node", itr.first.first),
+                  cereal::make_nvp("page_node", itr.first.second),
+                  cereal::make_nvp("samples", itr.second));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        auto _save_list = [&ar, &_save](const char* _name, const char* _key,
+                                        const entry_list_t& _entries) {
+            ar->setNextName(_name);
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& itr : _entries)
+            {
+                ar->startNode();
+                (*ar)(cereal::make_nvp(_key, itr.first));
+                _save(ar, itr.second);
+                ar->finishNode();
+            }
+            ar->finishNode();
+        };
+
+        _save_list("allocation_sites", "site", _data.sites);
+        _save_list("functions", "function", _data.functions);
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("numa-locality", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening numa-locality output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "numa-locality" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return config::settings_are_configured() && config::get_numa_locality();
+}
+
+bool
+configure(bool _setup, int64_t _tid)
+{
+    if(!config::get_numa_locality()) return false;
+
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    auto                         itr = get_threads().find(_tid);
+
+    if(!_setup)
+    {
+        if(itr != get_threads().end() && itr->second->event.is_open())
+        {
+            auto _samples = std::vector<raw_sample>{};
+            itr->second->event.stop();
+            drain(*itr->second, _samples);
+            process(_samples);
+            itr->second->event.close();
+        }
+        return false;
+    }
+
+    if(itr != get_threads().end() && itr->second->event.is_open()) return true;
+
+    const auto& _info = thread_info::get(_tid, SequentTID);
+    if(!_info) return false;
+
+    struct perf_event_attr _pe;
+    memset(&_pe, 0, sizeof(_pe));
+
+    try
+    {
+        perf::config_pmu_event(_pe, config::get_numa_locality_event());
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "NUMA locality event '%s' is not supported: %s\n",
+                            config::get_numa_locality_event().c_str(), _e.what());
+        return false;
+    }
+
+    _pe.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_ADDR | PERF_SAMPLE_CPU |
+                      PERF_SAMPLE_WEIGHT | PERF_SAMPLE_DATA_SRC;
+    _pe.sample_period  = config::get_numa_locality_period();
+    _pe.exclude_kernel = 1;
+    _pe.exclude_hv     = 1;
+    _pe.disabled       = 1;
+    _pe.inherit        = 0;
+
+    auto _state = std::make_unique<thread_state>();
+    _state->tid = _tid;
+    _state->event.set_num_pages(config::get_sampling_perf_buffer_pages());
+
+    // the precise events (e.g. PEBS) require the highest skid constraint the CPU
+    // supports while the other PMUs (e.g. IBS) reject any constraint
+    auto _err = std::optional<std::string>{};
+    for(int i = 3; i >= 0; --i)
+    {
+        _pe.precise_ip = i;
+        _err           = _state->event.open(_pe, _info->index_data->system_value);
+        if(!_err) break;
+    }
+
+    if(_err)
+    {
+        OMNITRACE_WARNING_F(0,
+                            "NUMA locality perf_event failed to open on thread %li: %s\n",
+                            _tid, _err->c_str());
+        return false;
+    }
+
+    OMNITRACE_VERBOSE(2, "[numa_locality] Sampling the memory loads of thread %li...\n",
+                      _tid);
+
+    start_collector();
+
+    _state->event.start();
+    if(itr != get_threads().end())
+    {
+        _state->lost = itr->second->lost;
+        itr->second  = std::move(_state);
+    }
+    else
+        get_threads().emplace(_tid, std::move(_state));
+
+    return true;
+}
+
+void
+record_allocation(uintptr_t _addr, size_t _size, uintptr_t _call_site)
+{
+    if(_addr == 0 || _size == 0) return;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_allocation_mutex() };
+    get_allocations()[_addr] = allocation{ _addr + _size, _call_site };
+}
+
+void
+record_free(uintptr_t _addr)
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_allocation_mutex() };
+    get_allocations().erase(_addr);
+}
+
+void
+stop()
+{
+    if(get_thread())
+    {
+        get_active().store(false);
+        get_cv().notify_all();
+        get_thread()->join();
+        get_thread().reset();
+    }
+
+    // collect whatever remains in the ring buffers of the threads still running
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    auto                         _samples = std::vector<raw_sample>{};
+    for(auto& itr : get_threads())
+    {
+        if(!itr.second->event.is_open()) continue;
+        itr.second->event.stop();
+        drain(*itr.second, _samples);
+        itr.second->event.close();
+    }
+    process(_samples);
+}
+
+void
+post_process()
+{
+    if(!config::get_numa_locality()) return;
+
+    std::call_once(post_process_once, []() {
+        stop();
+
+        std::unique_lock<std::mutex> _lk{ get_mutex() };
+        if(get_threads().empty()) return;
+
+        try
+        {
+            auto _data = get_summary();
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the NUMA locality profile failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace numa_locality
+}  // namespace omnitrace
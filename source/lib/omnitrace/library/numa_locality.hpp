@@ -0,0 +1,68 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// NUMA locality of the memory loads of the sampled threads (see
+/// OMNITRACE_NUMA_LOCALITY). A memory sampling perf_event (e.g. the load-latency
+/// event) is opened on each thread to sample the data addresses of the loads and the
+/// level of the memory hierarchy which served them. A background thread drains the
+/// ring buffers and resolves the NUMA node of the sampled pages with move_pages in
+/// batches, so nothing runs in the sampled threads. A load is remote when the node
+/// of its page differs from the node of the CPU which issued it. The fraction of
+/// remote loads per allocation site of the numa_alloc functions, per function and
+/// per pair of nodes is written to numa-locality.{txt,json}
+namespace numa_locality
+{
+/// check if the NUMA locality is enabled, i.e. the allocations should be recorded
+bool
+is_enabled();
+
+/// opens (or closes and drains) the perf_event of the thread. Returns false if the
+/// NUMA locality is not enabled or the perf_event could not be opened
+bool
+configure(bool _setup, int64_t _tid);
+
+/// records the address range of an allocation and its call-site
+void
+record_allocation(uintptr_t _addr, size_t _size, uintptr_t _call_site);
+
+/// removes the allocation starting at the address
+void
+record_free(uintptr_t _addr);
+
+/// stops the background thread and closes the perf_events of every thread
+void
+stop();
+
+/// stops the collection and writes the profile. Only the first invocation has an
+/// effect
+void
+post_process();
+}  // namespace numa_locality
+}  // namespace omnitrace
@@ -0,0 +1,591 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/offcpu.hpp"
+#include "binary/analysis.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perf.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "library/housekeeping.hpp"
+#include "library/perf.hpp"
+#include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/unwind/processed_entry.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace omnitrace
+{
+namespace offcpu
+{
+namespace
+{
+using callstack_t = std::vector<uintptr_t>;
+
+// the off-CPU intervals of a call-stack (nsec)
+struct offcpu_entry
+{
+    uint64_t count     = 0;
+    uint64_t blocked   = 0;
+    uint64_t preempted = 0;
+
+    uint64_t total() const { return blocked + preempted; }
+
+    offcpu_entry& operator+=(const offcpu_entry& _rhs)
+    {
+        count += _rhs.count;
+        blocked += _rhs.blocked;
+        preempted += _rhs.preempted;
+        return *this;
+    }
+};
+
+// the switch-out which has not been matched with a switch-in yet
+struct pending_switch
+{
+    bool        valid     = false;
+    bool        preempted = false;
+    uint64_t    begin     = 0;
+    callstack_t stack     = {};
+};
+
+using stack_map_t  = std::map<callstack_t, offcpu_entry>;
+using perf_event_t = perf::perf_event;
+
+struct thread_state
+{
+    int64_t        tid     = 0;
+    uint64_t       lost    = 0;
+    perf_event_t   event   = {};
+    pending_switch pending = {};
+    stack_map_t    stacks  = {};
+};
+
+// the totals of a function over the off-CPU intervals
+struct function_entry
+{
+    offcpu_entry exclusive = {};
+    offcpu_entry inclusive = {};
+};
+
+using function_list_t = std::vector<std::pair<std::string, function_entry>>;
+using stack_list_t    = std::vector<std::pair<std::vector<std::string>, offcpu_entry>>;
+using thread_list_t   = std::vector<std::pair<int64_t, offcpu_entry>>;
+
+struct summary
+{
+    offcpu_entry    total     = {};
+    uint64_t        lost      = 0;
+    thread_list_t   threads   = {};
+    function_list_t functions = {};
+    stack_list_t    stacks    = {};
+};
+
+// the number of call-stacks in the output
+constexpr size_t max_output_stacks = 50;
+
+// the ring buffers only need to hold the switches within one collection interval
+constexpr auto collect_interval = std::chrono::milliseconds{ 10 };
+
+std::once_flag post_process_once{};
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+// the states are kept after the thread exits so the profile includes every thread
+auto&
+get_threads()
+{
+    static auto _v = std::map<int64_t, std::unique_ptr<thread_state>>{};
+    return _v;
+}
+
+// requires the mutex to be held
+void
+drain(thread_state& _state)
+{
+    if(!_state.event.is_open()) return;
+
+    auto& _pending = _state.pending;
+    for(auto itr : _state.event)
+    {
+        if(itr.is_lost())
+        {
+            // the interval in progress can not be matched reliably
+            ++_state.lost;
+            _pending.valid = false;
+        }
+        else if(itr.is_sample())
+        {
+            // the thread is being switched out: the user-space frames are the
+            // call-stack which waits
+            _pending.valid     = true;
+            _pending.preempted = false;
+            _pending.begin     = itr.get_time();
+            _pending.stack.clear();
+            for(auto ditr : itr.get_callchain())
+            {
+                // kernel context markers, e.g. PERF_CONTEXT_USER
+                if(ditr >= PERF_CONTEXT_MAX) continue;
+                _pending.stack.emplace_back(ditr);
+            }
+        }
+        else if(itr.is_switch())
+        {
+            if(itr.is_switch_out())
+            {
+                // follows the sample of the same switch
+                if(_pending.valid) _pending.preempted = itr.is_preempted();
+                continue;
+            }
+
+            auto _end = itr.get_switch_time();
+            if(_pending.valid && !_pending.stack.empty() && _end > _pending.begin)
+            {
+                auto& _entry = _state.stacks[_pending.stack];
+                _entry.count += 1;
+                if(_pending.preempted)
+                    _entry.preempted += (_end - _pending.begin);
+                else
+                    _entry.blocked += (_end - _pending.begin);
+            }
+            _pending.valid = false;
+        }
+    }
+}
+
+void
+start_collector()
+{
+    if(get_thread()) return;
+
+    auto _func = []() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.offcpu");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        while(get_active().load())
+        {
+            std::unique_lock<std::mutex> _lk{ get_mutex() };
+            get_cv().wait_for(_lk, collect_interval);
+            for(auto& itr : get_threads())
+                drain(*itr.second);
+        }
+    };
+
+    get_active().store(true);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_thread() = std::make_unique<std::thread>(_func);
+}
+
+summary
+get_summary()
+{
+    auto _summary = summary{};
+    auto _stacks  = stack_map_t{};
+    for(const auto& titr : get_threads())
+    {
+        auto _total = offcpu_entry{};
+        for(const auto& itr : titr.second->stacks)
+        {
+            _stacks[itr.first] += itr.second;
+            _total += itr.second;
+        }
+        _summary.total += _total;
+        _summary.lost += titr.second->lost;
+        if(_total.count > 0) _summary.threads.emplace_back(titr.first, _total);
+    }
+
+    // the names of the addresses. The call-stacks have few distinct addresses
+    auto _names  = std::unordered_map<uintptr_t, std::string>{};
+    auto _lookup = [&_names](uintptr_t _addr) -> const std::string& {
+        auto itr = _names.find(_addr);
+        if(itr != _names.end()) return itr->second;
+
+        auto _name = std::string{};
+        if(auto _entry = binary::lookup_ipaddr_entry<true>(_addr); _entry)
+            _name = _entry->name;
+        return (_names[_addr] = _name);
+    };
+
+    auto _functions = std::unordered_map<std::string, function_entry>{};
+    auto _unique    = std::unordered_set<std::string>{};
+    auto _named     = std::map<std::vector<std::string>, offcpu_entry>{};
+    for(const auto& itr : _stacks)
+    {
+        auto _frames = std::vector<std::string>{};
+        _unique.clear();
+        for(auto ditr : itr.first)
+        {
+            const auto& _name = _lookup(ditr);
+            if(_name.empty()) continue;
+
+            auto& _entry = _functions[_name];
+            if(_frames.empty()) _entry.exclusive += itr.second;
+            if(_unique.emplace(_name).second) _entry.inclusive += itr.second;
+            _frames.emplace_back(_name);
+        }
+        if(!_frames.empty()) _named[_frames] += itr.second;
+    }
+
+    auto _cmp = [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.total() > _rhs.second.total();
+    };
+
+    _summary.functions.assign(_functions.begin(), _functions.end());
+    std::sort(_summary.functions.begin(), _summary.functions.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  if(_lhs.second.exclusive.total() != _rhs.second.exclusive.total())
+                      return _lhs.second.exclusive.total() >
+                             _rhs.second.exclusive.total();
+                  if(_lhs.second.inclusive.total() != _rhs.second.inclusive.total())
+                      return _lhs.second.inclusive.total() >
+                             _rhs.second.inclusive.total();
+                  return _lhs.first < _rhs.first;
+              });
+
+    _summary.stacks.assign(_named.begin(), _named.end());
+    std::stable_sort(_summary.stacks.begin(), _summary.stacks.end(), _cmp);
+    if(_summary.stacks.size() > max_output_stacks)
+        _summary.stacks.resize(max_output_stacks);
+
+    std::stable_sort(_summary.threads.begin(), _summary.threads.end(), _cmp);
+
+    return _summary;
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("sampling-offcpu", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening sampling-offcpu output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "sampling-offcpu" });
+
+    auto _msec = [](uint64_t _v) { return _v / 1.0e6; };
+
+    ofs << "switches: " << _data.total.count << ", blocked (msec): "
+        << std::setprecision(3) << std::fixed << _msec(_data.total.blocked)
+        << ", preempted (msec): " << _msec(_data.total.preempted)
+        << ", lost records: " << _data.lost << "\n";
+
+    ofs << "\n"
+        << std::setw(12) << "switches" << " | " << std::setw(14) << "blocked (msec)"
+        << " | " << std::setw(16) << "preempted (msec)" << " | thread\n";
+    for(const auto& itr : _data.threads)
+    {
+        ofs << std::setw(12) << itr.second.count << " | " << std::setw(14)
+            << _msec(itr.second.blocked) << " | " << std::setw(16)
+            << _msec(itr.second.preempted) << " | " << itr.first << "\n";
+    }
+
+    ofs << "\n"
+        << std::setw(16) << "exclusive (msec)" << " | " << std::setw(16)
+        << "inclusive (msec)" << " | " << std::setw(12) << "switches"
+        << " | function\n";
+    for(const auto& itr : _data.functions)
+    {
+        ofs << std::setw(16) << _msec(itr.second.exclusive.total()) << " | "
+            << std::setw(16) << _msec(itr.second.inclusive.total()) << " | "
+            << std::setw(12) << itr.second.inclusive.count << " | " << itr.first << "\n";
+    }
+
+    for(const auto& itr : _data.stacks)
+    {
+        ofs << "\n"
+            << "off-CPU (msec): " << _msec(itr.second.total())
+            << ", blocked (msec): " << _msec(itr.second.blocked)
+            << ", preempted (msec): " << _msec(itr.second.preempted)
+            << ", switches: " << itr.second.count << "\n";
+        for(const auto& fitr : itr.first)
+            ofs << "    " << fitr << "\n";
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    auto _save = [](auto& ar, const offcpu_entry& _v) {
+        (*ar)(cereal::make_nvp("switches", _v.count),
+              cereal::make_nvp("blocked_nsec", _v.blocked),
+              cereal::make_nvp("preempted_nsec", _v.preempted));
+    };
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("sampling_offcpu");
+        ar->startNode();
+
+        _save(ar, _data.total);
+        (*ar)(cereal::make_nvp("lost_records", _data.lost));
+
+        ar->setNextName("threads");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.threads)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("thread", itr.first));
+            _save(ar, itr.second);
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->setNextName("functions");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.functions)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("function", itr.first));
+            ar->setNextName("exclusive");
+            ar->startNode();
+            _save(ar, itr.second.exclusive);
+            ar->finishNode();
+            ar->setNextName("inclusive");
+            ar->startNode();
+            _save(ar, itr.second.inclusive);
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->setNextName("stacks");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.stacks)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("frames", itr.first));
+            _save(ar, itr.second);
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("sampling-offcpu", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening sampling-offcpu output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname,
+                                                  std::string{ "sampling-offcpu" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+bool
+configure(bool _setup, int64_t _tid)
+{
+    if(!config::get_sampling_offcpu()) return false;
+
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    auto                         itr = get_threads().find(_tid);
+
+    if(!_setup)
+    {
+        if(itr != get_threads().end() && itr->second->event.is_open())
+        {
+            itr->second->event.stop();
+            drain(*itr->second);
+            itr->second->event.close();
+        }
+        return false;
+    }
+
+    if(itr != get_threads().end() && itr->second->event.is_open()) return true;
+
+    const auto& _info = thread_info::get(_tid, SequentTID);
+    if(!_info) return false;
+
+    struct perf_event_attr _pe;
+    memset(&_pe, 0, sizeof(_pe));
+
+    // the software event is generated in the scheduler so the kernel can not be
+    // excluded from the event, only from the call-chain
+    _pe.type   = PERF_TYPE_SOFTWARE;
+    _pe.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+    _pe.sample_type =
+        PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_CALLCHAIN;
+    _pe.sample_period            = 1;
+    _pe.context_switch           = 1;
+    _pe.sample_id_all            = 1;
+    _pe.exclude_hv               = 1;
+    _pe.exclude_callchain_kernel = 1;
+    _pe.disabled                 = 1;
+    _pe.inherit                  = 0;
+
+    auto _state = std::make_unique<thread_state>();
+    _state->tid = _tid;
+    _state->event.set_num_pages(config::get_sampling_perf_buffer_pages());
+
+    if(auto _err = _state->event.open(_pe, _info->index_data->system_value); _err)
+    {
+        OMNITRACE_WARNING_F(0, "off-CPU perf_event failed to open on thread %li: %s\n",
+                            _tid, _err->c_str());
+        return false;
+    }
+
+    OMNITRACE_VERBOSE(2, "[offcpu] Recording the context switches of thread %li...\n",
+                      _tid);
+
+    start_collector();
+
+    _state->event.start();
+    if(itr != get_threads().end())
+    {
+        // a thread with a re-used index: keep the intervals of the previous thread
+        _state->stacks = std::move(itr->second->stacks);
+        _state->lost   = itr->second->lost;
+        itr->second    = std::move(_state);
+    }
+    else
+        get_threads().emplace(_tid, std::move(_state));
+
+    return true;
+}
+
+void
+stop()
+{
+    if(get_thread())
+    {
+        get_active().store(false);
+        get_cv().notify_all();
+        get_thread()->join();
+        get_thread().reset();
+    }
+
+    // collect whatever remains in the ring buffers of the threads still running
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    for(auto& itr : get_threads())
+    {
+        if(!itr.second->event.is_open()) continue;
+        itr.second->event.stop();
+        drain(*itr.second);
+        itr.second->event.close();
+    }
+}
+
+void
+post_process()
+{
+    if(!config::get_sampling_offcpu()) return;
+
+    std::call_once(post_process_once, []() {
+        stop();
+
+        std::unique_lock<std::mutex> _lk{ get_mutex() };
+        if(get_threads().empty()) return;
+
+        try
+        {
+            auto _data = get_summary();
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the off-CPU profile failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace offcpu
+}  // namespace omnitrace
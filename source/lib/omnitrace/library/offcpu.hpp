@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// off-CPU profile of the sampled threads (see OMNITRACE_SAMPLING_OFFCPU). Timer-based
+/// samples only see the threads while they run (CPU-time) or spend their samples on
+/// threads which sleep (real-time). Instead, a context-switch perf_event is opened on
+/// each thread with a period of one: the kernel records the user-space call-chain of
+/// the thread when it is switched out and a switch record when it is switched back in
+/// so each interval the thread was blocked or preempted is attributed to the
+/// call-stack which waited. The ring buffers are drained by a background thread and
+/// the off-CPU time of the call-stacks and functions is written to
+/// sampling-offcpu.{txt,json}
+namespace offcpu
+{
+/// opens (or closes and drains) the perf_event of the thread. Returns false if the
+/// off-CPU profile is not enabled or the perf_event could not be opened
+bool
+configure(bool _setup, int64_t _tid);
+
+/// stops the background thread and closes the perf_events of every thread
+void
+stop();
+
+/// stops the collection and writes the profile. Only the first invocation has an
+/// effect
+void
+post_process();
+}  // namespace offcpu
+}  // namespace omnitrace
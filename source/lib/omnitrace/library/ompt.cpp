@@ -31,14 +31,28 @@
 #if defined(OMNITRACE_USE_OMPT) && OMNITRACE_USE_OMPT > 0
 
 #    include "core/components/fwd.hpp"
+#    include "core/state.hpp"
+#    include "core/timemory.hpp"
 #    include "library/components/category_region.hpp"
+#    include "library/ompt_aggregate.hpp"
+#    include "library/ompt_barrier.hpp"
+#    include "library/ompt_device.hpp"
+#    include "library/tracing.hpp"
 
 #    include <timemory/components/ompt.hpp>
 #    include <timemory/components/ompt/extern.hpp>
 #    include <timemory/mpl/type_traits.hpp>
 #    include <timemory/timemory.hpp>
 
+#    include <algorithm>
+#    include <cstdlib>
+#    include <map>
 #    include <memory>
+#    include <mutex>
+#    include <type_traits>
+#    include <vector>
+
+#    include <dlfcn.h>
 
 using api_t          = TIMEMORY_API;
 using ompt_handle_t  = tim::component::ompt_handle<api_t>;
@@ -54,6 +68,89 @@ extern "C"
 
 namespace omnitrace
 {
+namespace component
+{
+// accumulates the duration of the region in the ompt_aggregate table of the thread
+// and only forwards one in OMNITRACE_OMPT_AGGREGATE_SAMPLE_INTERVAL instances of the
+// region to the perfetto and timemory output
+struct ompt_aggregate_region : comp::base<ompt_aggregate_region, void>
+{
+    using region_type = local_category_region<category::ompt>;
+
+    static constexpr auto category_name = region_type::category_name;
+    static std::string    label() { return "ompt_aggregate_region"; }
+
+    template <typename... OptsT, typename... Args>
+    auto start(Args&&... args)
+    {
+        if(m_prefix.empty()) return;
+        auto _interval = config::get_snapshot().ompt_aggregate_sample_interval;
+        auto _n        = ompt_aggregate::start(m_entry);
+        m_sampled      = (_interval > 0 && _n % _interval == 0);
+        if(m_sampled) m_region.template start<OptsT...>(std::forward<Args>(args)...);
+        m_beg = tracing::now();
+    }
+
+    template <typename... OptsT, typename... Args>
+    auto stop(Args&&... args)
+    {
+        if(m_prefix.empty() || m_beg == 0) return;
+        ompt_aggregate::stop(m_entry, tracing::now() - std::exchange(m_beg, 0));
+        if(std::exchange(m_sampled, false))
+            m_region.template stop<OptsT...>(std::forward<Args>(args)...);
+    }
+
+    void set_prefix(std::string_view _v)
+    {
+        m_prefix = _v;
+        m_entry  = ompt_aggregate::find(_v);
+        m_region.set_prefix(_v);
+    }
+
+private:
+    bool                   m_sampled = false;
+    uint64_t               m_beg     = 0;
+    std::string_view       m_prefix  = {};
+    ompt_aggregate::entry* m_entry   = nullptr;
+    region_type            m_region  = {};
+};
+
+// feeds the start and end of the outermost parallel regions and the waits in their
+// implicit barriers to the ompt_barrier analysis
+struct ompt_barrier_region : comp::base<ompt_barrier_region, void>
+{
+    static std::string label() { return "ompt_barrier_region"; }
+
+    template <typename... Args>
+    auto start(Args&&...)
+    {
+        if(m_kind == ompt_barrier::other_region) return;
+        m_beg    = tracing::now();
+        m_region = (m_kind == ompt_barrier::parallel_region)
+                       ? ompt_barrier::parallel_begin(m_beg)
+                       : ompt_barrier::get_region();
+    }
+
+    template <typename... Args>
+    auto stop(Args&&...)
+    {
+        if(m_region == 0) return;
+        auto _region = std::exchange(m_region, 0);
+        if(m_kind == ompt_barrier::parallel_region)
+            ompt_barrier::parallel_end(_region, tracing::now());
+        else
+            ompt_barrier::barrier_wait(_region, tracing::now() - m_beg);
+    }
+
+    void set_prefix(std::string_view _v) { m_kind = ompt_barrier::get_region_kind(_v); }
+
+private:
+    ompt_barrier::region_kind m_kind   = ompt_barrier::other_region;
+    uint64_t                  m_beg    = 0;
+    uint64_t                  m_region = 0;
+};
+}  // namespace component
+
 namespace ompt
 {
 namespace
@@ -73,17 +170,299 @@ setup()
     comp::user_ompt_bundle::global_init();
     comp::user_ompt_bundle::reset();
     tim::auto_lock_t lk{ tim::type_mutex<ompt_handle_t>() };
-    comp::user_ompt_bundle::configure<component::local_category_region<category::ompt>>();
+    if(config::get_ompt_aggregate())
+        comp::user_ompt_bundle::configure<component::ompt_aggregate_region>();
+    else
+        comp::user_ompt_bundle::configure<
+            component::local_category_region<category::ompt>>();
+    if(config::get_ompt_barrier_analysis())
+        comp::user_ompt_bundle::configure<component::ompt_barrier_region>();
     f_bundle = std::make_unique<ompt_bundle_t>("omnitrace/ompt",
                                                quirk::config<quirk::auto_start>{});
 }
 
+namespace
+{
+// the entry points of the tracing interface of a target device and the offset of its
+// clock from the clock of the host
+struct device_tracing
+{
+    ompt_device_t*               device          = nullptr;
+    ompt_flush_trace_t           flush_trace     = nullptr;
+    ompt_stop_trace_t            stop_trace      = nullptr;
+    ompt_get_record_ompt_t       get_record_ompt = nullptr;
+    ompt_advance_buffer_cursor_t advance_cursor  = nullptr;
+    ompt_translate_time_t        translate_time  = nullptr;
+    double                       offset          = 0.0;  // nanoseconds
+};
+
+struct device_tracing_data
+{
+    std::mutex                    mutex   = {};
+    std::map<int, device_tracing> devices = {};
+};
+
+// intentionally leaked since the runtime finalizes the devices at exit
+auto&
+get_device_tracing_data()
+{
+    static auto* _v = new device_tracing_data{};
+    return *_v;
+}
+
+device_tracing
+get_device_tracing(int _device_num)
+{
+    auto& _data = get_device_tracing_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  itr   = _data.devices.find(_device_num);
+    return (itr == _data.devices.end()) ? device_tracing{} : itr->second;
+}
+
+// the device time in nanoseconds of the host clock. ompt_translate_time converts to
+// the seconds of omp_get_wtime, otherwise the device time is assumed to be in
+// nanoseconds
+uint64_t
+get_host_time(const device_tracing& _tracing, ompt_device_time_t _time)
+{
+    auto _ns = (_tracing.translate_time)
+                   ? (_tracing.translate_time(_tracing.device, _time) * units::sec)
+                   : static_cast<double>(_time);
+    return static_cast<uint64_t>(std::max(_ns + _tracing.offset, 0.0));
+}
+
+const char*
+get_construct_name(ompt_target_t _kind)
+{
+    // the nowait variants of the constructs (OpenMP 5.1) set the fourth bit
+    switch(static_cast<int>(_kind) & ~8)
+    {
+        case ompt_target_enter_data: return "target enter data";
+        case ompt_target_exit_data: return "target exit data";
+        case ompt_target_update: return "target update";
+        default: break;
+    }
+    return "target";
+}
+
+ompt_device::op_kind
+get_op_kind(ompt_target_data_op_t _optype)
+{
+    // the async variants of the operations (OpenMP 5.1) set the fifth bit
+    switch(static_cast<int>(_optype) & ~16)
+    {
+        case ompt_target_data_alloc: return ompt_device::alloc_op;
+        case ompt_target_data_transfer_to_device:
+            return ompt_device::transfer_to_device_op;
+        case ompt_target_data_transfer_from_device:
+            return ompt_device::transfer_from_device_op;
+        case ompt_target_data_delete: return ompt_device::delete_op;
+        default: break;
+    }
+    return ompt_device::other_op;
+}
+
+void
+process_record(const device_tracing& _tracing, int _device_num,
+               const ompt_record_ompt_t& _record)
+{
+    auto _ts = get_host_time(_tracing, _record.time);
+    switch(_record.type)
+    {
+        case ompt_callback_target:
+        {
+            const auto& _v  = _record.record.target;
+            auto        _id = (_v.target_id != ompt_id_none) ? _v.target_id
+                                                             : _record.target_id;
+            if(_v.endpoint == ompt_scope_begin)
+                ompt_device::target_begin(_v.device_num, _id,
+                                          get_construct_name(_v.kind), _v.codeptr_ra,
+                                          _ts);
+            else if(_v.endpoint == ompt_scope_end)
+                ompt_device::target_end(_id, _ts);
+            break;
+        }
+        case ompt_callback_target_data_op:
+        {
+            const auto& _v = _record.record.target_data_op;
+            ompt_device::device_op(get_op_kind(_v.optype), _device_num,
+                                   _record.target_id, _ts,
+                                   get_host_time(_tracing, _v.end_time), _v.bytes);
+            break;
+        }
+        case ompt_callback_target_submit:
+        {
+            const auto& _v = _record.record.target_kernel;
+            ompt_device::device_op(ompt_device::kernel_op, _device_num,
+                                   _record.target_id, _ts,
+                                   get_host_time(_tracing, _v.end_time), 0);
+            break;
+        }
+        default: break;
+    }
+}
+
+void
+buffer_request(int, ompt_buffer_t** _buffer, size_t* _bytes)
+{
+    static auto _size = std::max<size_t>(config::get_ompt_device_buffer_size(), 4096);
+
+    *_buffer = std::malloc(_size);
+    *_bytes  = (*_buffer == nullptr) ? 0 : _size;
+}
+
+// invoked by the runtime on one of its threads when a buffer is full or flushed
+void
+buffer_complete(int _device_num, ompt_buffer_t* _buffer, size_t _bytes,
+                ompt_buffer_cursor_t _begin, int _buffer_owned)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _tracing = get_device_tracing(_device_num);
+    if(_tracing.device != nullptr && _bytes > 0)
+    {
+        auto _cursor = _begin;
+        for(int _status = 1; _status != 0;)
+        {
+            const auto* _record = _tracing.get_record_ompt(_buffer, _cursor);
+            if(_record == nullptr) break;
+            process_record(_tracing, _device_num, *_record);
+            _status = _tracing.advance_cursor(_tracing.device, _buffer, _bytes, _cursor,
+                                              &_cursor);
+        }
+    }
+
+    if(_buffer_owned != 0) std::free(_buffer);
+}
+
+void
+device_initialize(int _device_num, const char* _type, ompt_device_t* _device,
+                  ompt_function_lookup_t _lookup, const char*)
+{
+    if(_lookup == nullptr) return;
+
+    auto _find = [_lookup](const char* _name, auto& _func) {
+        _func = reinterpret_cast<std::decay_t<decltype(_func)>>(_lookup(_name));
+        return (_func != nullptr);
+    };
+
+    const char*            _type_name   = (_type) ? _type : "unknown";
+    ompt_set_trace_ompt_t  _set_trace   = nullptr;
+    ompt_start_trace_t     _start_trace = nullptr;
+    ompt_get_device_time_t _get_time    = nullptr;
+    auto                   _tracing     = device_tracing{};
+
+    _tracing.device = _device;
+
+    if(!_find("ompt_set_trace_ompt", _set_trace) ||
+       !_find("ompt_start_trace", _start_trace) ||
+       !_find("ompt_get_record_ompt", _tracing.get_record_ompt) ||
+       !_find("ompt_advance_buffer_cursor", _tracing.advance_cursor))
+    {
+        OMNITRACE_VERBOSE_F(0, "OpenMP device %i (%s) does not support device tracing\n",
+                            _device_num, _type_name);
+        return;
+    }
+
+    _find("ompt_flush_trace", _tracing.flush_trace);
+    _find("ompt_stop_trace", _tracing.stop_trace);
+    _find("ompt_get_device_time", _get_time);
+
+    // the offset of the device clock is measured once when the device is initialized
+    using omp_get_wtime_t = double (*)();
+    auto _wtime = reinterpret_cast<omp_get_wtime_t>(dlsym(RTLD_DEFAULT, "omp_get_wtime"));
+    auto _now   = static_cast<double>(tracing::now());
+    if(!_find("ompt_translate_time", _tracing.translate_time) || _wtime == nullptr)
+        _tracing.translate_time = nullptr;
+
+    if(_tracing.translate_time != nullptr)
+        _tracing.offset = _now - ((*_wtime)() * units::sec);
+    else if(_get_time != nullptr)
+        _tracing.offset = _now - static_cast<double>(_get_time(_device));
+
+    for(auto itr : { ompt_callback_target, ompt_callback_target_data_op,
+                     ompt_callback_target_submit })
+    {
+        auto _ret    = _set_trace(_device, 1, itr);
+        auto _failed = (_ret == ompt_set_never || _ret == ompt_set_error);
+        OMNITRACE_VERBOSE_F((_failed) ? 0 : 2,
+                            "OpenMP device %i (%s) tracing of record type %i: %i\n",
+                            _device_num, _type_name, static_cast<int>(itr),
+                            static_cast<int>(_ret));
+    }
+
+    auto& _data = get_device_tracing_data();
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _data.mutex };
+        _data.devices[_device_num] = _tracing;
+    }
+
+    if(_start_trace(_device, &buffer_request, &buffer_complete) == 0)
+    {
+        OMNITRACE_VERBOSE_F(0, "Starting the tracing of OpenMP device %i (%s) failed\n",
+                            _device_num, _type_name);
+        auto _lk = std::unique_lock<std::mutex>{ _data.mutex };
+        _data.devices.erase(_device_num);
+        return;
+    }
+
+    OMNITRACE_VERBOSE_F(1, "OpenMP device tracing started on device %i (%s)\n",
+                        _device_num, _type_name);
+}
+
+// flushes the remaining records of the device and stops its tracing
+void
+device_finalize(int _device_num)
+{
+    auto _tracing = get_device_tracing(_device_num);
+    if(_tracing.device == nullptr) return;
+
+    if(_tracing.flush_trace) _tracing.flush_trace(_tracing.device);
+    if(_tracing.stop_trace) _tracing.stop_trace(_tracing.device);
+
+    auto& _data = get_device_tracing_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    _data.devices.erase(_device_num);
+}
+
+void
+configure_device_tracing(ompt_function_lookup_t _lookup)
+{
+    auto _set_callback =
+        reinterpret_cast<ompt_set_callback_t>(_lookup("ompt_set_callback"));
+    if(_set_callback == nullptr) return;
+
+    // replaces the device callbacks of the timemory toolset
+    _set_callback(ompt_callback_device_initialize,
+                  reinterpret_cast<ompt_callback_t>(&device_initialize));
+    _set_callback(ompt_callback_device_finalize,
+                  reinterpret_cast<ompt_callback_t>(&device_finalize));
+}
+
+void
+stop_device_tracing()
+{
+    auto _devices = std::vector<int>{};
+    {
+        auto& _data = get_device_tracing_data();
+        auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+        for(const auto& itr : _data.devices)
+            _devices.emplace_back(itr.first);
+    }
+
+    for(auto itr : _devices)
+        device_finalize(itr);
+}
+}  // namespace
+
 void
 shutdown()
 {
     static bool _protect = false;
     if(_protect) return;
     _protect = true;
+    // the records in the partially filled buffers are processed before finalization
+    stop_device_tracing();
     if(f_bundle)
     {
         if(tim::manager::instance()) tim::manager::instance()->cleanup("omnitrace-ompt");
@@ -130,6 +509,7 @@ tool_initialize(ompt_function_lookup_t lookup, int initial_device_num,
                         initial_device_num);
         f_finalize = tim::ompt::configure<TIMEMORY_OMPT_API_TAG>(
             lookup, initial_device_num, tool_data);
+        if(omnitrace::config::get_ompt_device_tracing()) configure_device_tracing(lookup);
     }
     return 1;  // success
 }
@@ -0,0 +1,292 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/ompt_aggregate.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace ompt_aggregate
+{
+struct entry
+{
+    std::string label   = {};
+    size_t      hash    = 0;
+    uint64_t    started = 0;
+    uint64_t    count   = 0;
+    uint64_t    total   = 0;  // nanoseconds
+    uint64_t    min     = std::numeric_limits<uint64_t>::max();
+    uint64_t    max     = 0;
+
+    void add(uint64_t _duration)
+    {
+        count += 1;
+        total += _duration;
+        min = std::min(min, _duration);
+        max = std::max(max, _duration);
+    }
+};
+
+namespace
+{
+// open-addressing table with linear probing. A slot is empty until it has a label and
+// the slots are never removed so only the owning thread writes to it
+struct thread_table
+{
+    std::array<entry, thread_capacity> slots    = {};
+    entry                              overflow = {};
+};
+
+using thread_table_data = omnitrace::thread_data<thread_table, thread_table>;
+
+// the statistics of a region merged across the threads. The imbalance is the
+// difference between the largest and smallest total duration of the threads which
+// executed the region
+struct summary
+{
+    uint64_t count      = 0;
+    uint64_t total      = 0;
+    uint64_t min        = std::numeric_limits<uint64_t>::max();
+    uint64_t max        = 0;
+    uint64_t nthreads   = 0;
+    uint64_t thread_min = std::numeric_limits<uint64_t>::max();
+    uint64_t thread_max = 0;
+
+    summary& operator+=(const entry& _rhs)
+    {
+        count += _rhs.count;
+        total += _rhs.total;
+        min = std::min(min, _rhs.min);
+        max = std::max(max, _rhs.max);
+        nthreads += 1;
+        thread_min = std::min(thread_min, _rhs.total);
+        thread_max = std::max(thread_max, _rhs.total);
+        return *this;
+    }
+
+    uint64_t mean() const { return total / std::max<uint64_t>(count, 1); }
+    uint64_t imbalance() const { return (nthreads > 0) ? thread_max - thread_min : 0; }
+};
+
+using merged_data = std::map<std::string, summary>;
+
+auto&
+get_thread_table(int64_t _tid = tim::threading::get_id())
+{
+    return thread_table_data::instance(construct_on_thread{ _tid });
+}
+
+// sorted by the total duration in descending order
+std::vector<std::pair<std::string, summary>>
+get_sorted(const merged_data& _data)
+{
+    auto _v = std::vector<std::pair<std::string, summary>>{ _data.begin(), _data.end() };
+    std::sort(_v.begin(), _v.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.total > _rhs.second.total;
+    });
+    return _v;
+}
+
+void
+write_text(const merged_data& _data, const entry& _overflow)
+{
+    auto _fname = tim::settings::compose_output_filename("ompt_summary", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening ompt_summary output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<entry>{}(_fname, std::string{ "ompt_summary" });
+
+    auto _usec = [](uint64_t _v) { return static_cast<double>(_v) / units::usec; };
+
+    ofs << std::setprecision(3) << std::fixed;
+    ofs << std::setw(12) << "count" << " | " << std::setw(8) << "threads" << " | "
+        << std::setw(14) << "total (msec)" << " | " << std::setw(12) << "mean (usec)"
+        << " | " << std::setw(12) << "min (usec)" << " | " << std::setw(12)
+        << "max (usec)" << " | " << std::setw(16) << "imbalance (usec)"
+        << " | region\n";
+    for(const auto& itr : get_sorted(_data))
+    {
+        const auto& _v = itr.second;
+        ofs << std::setw(12) << _v.count << " | " << std::setw(8) << _v.nthreads
+            << " | " << std::setw(14) << (static_cast<double>(_v.total) / units::msec)
+            << " | " << std::setw(12) << _usec(_v.mean()) << " | " << std::setw(12)
+            << _usec(_v.min) << " | " << std::setw(12) << _usec(_v.max) << " | "
+            << std::setw(16) << _usec(_v.imbalance()) << " | " << itr.first << "\n";
+    }
+
+    if(_overflow.count > 0)
+    {
+        ofs << "\n" << _overflow.count << " instances (" << std::setprecision(3)
+            << (static_cast<double>(_overflow.total) / units::msec)
+            << " msec) exceeded the capacity of " << thread_capacity
+            << " regions per thread\n";
+    }
+}
+
+void
+write_json(const merged_data& _data, const entry& _overflow)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("ompt_summary");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("overflow_count", _overflow.count),
+              cereal::make_nvp("overflow_duration_ns", _overflow.total));
+
+        ar->setNextName("regions");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : get_sorted(_data))
+        {
+            const auto& _v = itr.second;
+            ar->startNode();
+            (*ar)(cereal::make_nvp("region", itr.first),
+                  cereal::make_nvp("count", _v.count),
+                  cereal::make_nvp("threads", _v.nthreads),
+                  cereal::make_nvp("total_ns", _v.total),
+                  cereal::make_nvp("mean_ns", _v.mean()),
+                  cereal::make_nvp("min_ns", _v.min), cereal::make_nvp("max_ns", _v.max),
+                  cereal::make_nvp("thread_min_ns", _v.thread_min),
+                  cereal::make_nvp("thread_max_ns", _v.thread_max),
+                  cereal::make_nvp("imbalance_ns", _v.imbalance()));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("ompt_summary", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening ompt_summary output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<entry>{}(_fname, std::string{ "ompt_summary" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+entry*
+find(std::string_view _label)
+{
+    auto& _v = get_thread_table();
+    if(!_v) _v = std::make_unique<thread_table>();
+
+    auto _hash = std::hash<std::string_view>{}(_label);
+    for(size_t i = 0; i < thread_capacity; ++i)
+    {
+        auto& _slot = _v->slots[(_hash + i) % thread_capacity];
+        if(_slot.label.empty())
+        {
+            _slot.label = std::string{ _label };
+            _slot.hash  = _hash;
+            return &_slot;
+        }
+        if(_slot.hash == _hash && _slot.label == _label) return &_slot;
+    }
+    return &_v->overflow;
+}
+
+uint64_t
+start(entry* _v)
+{
+    return (_v) ? _v->started++ : 0;
+}
+
+void
+stop(entry* _v, uint64_t _duration)
+{
+    if(_v) _v->add(_duration);
+}
+
+void
+post_process()
+{
+    auto _data     = merged_data{};
+    auto _overflow = entry{};
+
+    if(thread_table_data::get())
+    {
+        for(const auto& titr : *thread_table_data::get())
+        {
+            if(!titr) continue;
+            for(const auto& itr : titr->slots)
+            {
+                if(itr.count == 0) continue;
+                _data[itr.label] += itr;
+            }
+            _overflow.count += titr->overflow.count;
+            _overflow.total += titr->overflow.total;
+        }
+    }
+
+    if(_data.empty() && _overflow.count == 0)
+    {
+        OMNITRACE_VERBOSE_F(1, "No OpenMP regions were recorded\n");
+        return;
+    }
+
+    if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+        write_text(_data, _overflow);
+
+    if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+        write_json(_data, _overflow);
+}
+}  // namespace ompt_aggregate
+}  // namespace omnitrace
@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+/// aggregates the number of instances, the duration statistics, and the imbalance
+/// across the threads of every OpenMP region (see OMNITRACE_OMPT_AGGREGATE). The
+/// regions are identified by the label of the OpenMP-tools callback, which encodes the
+/// type of the region and the construct. The entries are accumulated in a fixed-size
+/// table per thread without locking and are merged across the threads at finalization
+namespace ompt_aggregate
+{
+/// the maximum number of distinct regions per thread. The instances of the regions
+/// beyond this capacity are only counted in the total
+static constexpr size_t thread_capacity = 512;
+
+struct entry;
+
+/// returns the entry of the region in the table of the calling thread or a nullptr if
+/// the table is full. The label is only copied when the region is first encountered
+entry*
+find(std::string_view _label);
+
+/// increments the number of instances of the region which have started and returns
+/// the number of the previous instances on the calling thread
+uint64_t
+start(entry*);
+
+/// records an instance of the region which lasted _duration nsec
+void
+stop(entry*, uint64_t _duration);
+
+/// merges the tables of all the threads and writes ompt_summary.{txt,json}
+void
+post_process();
+}  // namespace ompt_aggregate
+}  // namespace omnitrace
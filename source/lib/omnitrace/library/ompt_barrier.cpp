@@ -0,0 +1,390 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/ompt_barrier.hpp"
+#include "core/concepts.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace ompt_barrier
+{
+namespace
+{
+// the waits of a region are evaluated when the region two regions later begins. The
+// workers may report the end of the implicit barrier at the end of a region after
+// they are released into the next region so the ring needs at least three entries
+static constexpr size_t ring_size = 4;
+
+struct wait_record
+{
+    std::atomic<uint64_t> region = { 0 };
+    std::atomic<uint64_t> wait   = { 0 };
+};
+
+// only the owning thread writes to its ring
+struct thread_waits
+{
+    std::array<wait_record, ring_size> records = {};
+};
+
+struct region_record
+{
+    uint64_t region = 0;
+    uint64_t begin  = 0;
+    uint64_t end    = 0;
+};
+
+struct summary
+{
+    uint64_t              regions          = 0;
+    uint64_t              duration         = 0;  // nanoseconds
+    uint64_t              wait             = 0;  // nanoseconds
+    double                imbalance        = 0.0;
+    double                max_imbalance    = 0.0;
+    uint64_t              max_imbalance_id = 0;
+    std::vector<uint64_t> thread_wait      = {};
+    std::vector<uint64_t> straggler        = {};
+};
+
+// the state of the parallel regions is only modified while holding the mutex
+struct region_state
+{
+    std::mutex                           mutex   = {};
+    uint64_t                             count   = 0;
+    uint64_t                             closed  = 0;
+    std::array<region_record, ring_size> regions = {};
+    summary                              data    = {};
+    bool                                 tracks  = false;
+};
+
+struct perfetto_ompt_barrier
+{};
+
+using track = perfetto_counter_track<perfetto_ompt_barrier>;
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+
+auto&
+get_nthreads()
+{
+    static auto _v = std::atomic<size_t>{ 0 };
+    return _v;
+}
+
+// intentionally leaked so the waits can be recorded during the static destruction
+auto&
+get_thread_waits()
+{
+    static auto* _v = new std::array<thread_waits, max_supported_threads>{};
+    return *_v;
+}
+
+auto&
+get_region_state()
+{
+    static auto* _v = new region_state{};
+    return *_v;
+}
+
+void
+emit(region_state& _state, const region_record& _region, uint64_t _wait,
+     double _imbalance, size_t _straggler)
+{
+    if(!get_use_perfetto()) return;
+
+    if(!_state.tracks)
+    {
+        _state.tracks = true;
+        track::emplace(0, "OMPT Barrier Wait", "msec");
+        track::emplace(0, "OMPT Load Imbalance", "%");
+        track::emplace(0, "OMPT Straggler Thread");
+    }
+
+    const auto* _category = trait::name<category::ompt>::value;
+    TRACE_COUNTER(_category, track::at(0, 0), _region.begin,
+                  static_cast<double>(_wait) / units::msec);
+    TRACE_COUNTER(_category, track::at(0, 1), _region.begin, _imbalance);
+    TRACE_COUNTER(_category, track::at(0, 2), _region.begin,
+                  static_cast<int64_t>(_straggler));
+    TRACE_COUNTER(_category, track::at(0, 0), _region.end, 0.0);
+    TRACE_COUNTER(_category, track::at(0, 1), _region.end, 0.0);
+}
+
+// evaluates the waits of the region. Requires the mutex of the state
+void
+close(region_state& _state, uint64_t _id)
+{
+    const auto& _region = _state.regions.at(_id % ring_size);
+    _state.closed       = std::max(_state.closed, _id);
+    if(_region.region != _id || _region.end <= _region.begin) return;
+
+    auto& _data      = _state.data;
+    auto  _nthreads  = std::min(get_nthreads().load(), max_supported_threads);
+    auto  _wait      = uint64_t{ 0 };
+    auto  _min       = std::numeric_limits<uint64_t>::max();
+    auto  _straggler = size_t{ 0 };
+    auto  _n         = size_t{ 0 };
+
+    for(size_t i = 0; i < _nthreads; ++i)
+    {
+        const auto& _record = get_thread_waits()[i].records[_id % ring_size];
+        if(_record.region.load(std::memory_order_acquire) != _id) continue;
+        auto _v = _record.wait.load(std::memory_order_relaxed);
+        if(_data.thread_wait.size() <= i)
+        {
+            _data.thread_wait.resize(i + 1, 0);
+            _data.straggler.resize(i + 1, 0);
+        }
+        _data.thread_wait.at(i) += _v;
+        _wait += _v;
+        _n += 1;
+        if(_v < _min)
+        {
+            _min       = _v;
+            _straggler = i;
+        }
+    }
+
+    if(_n == 0) return;
+
+    auto _duration  = _region.end - _region.begin;
+    auto _imbalance = std::min(100.0 * static_cast<double>(_wait) /
+                                   static_cast<double>(_n * _duration),
+                               100.0);
+
+    _data.regions += 1;
+    _data.duration += _duration;
+    _data.wait += _wait;
+    _data.imbalance += _imbalance;
+    _data.straggler.at(_straggler) += 1;
+    if(_imbalance > _data.max_imbalance)
+    {
+        _data.max_imbalance    = _imbalance;
+        _data.max_imbalance_id = _id;
+    }
+
+    emit(_state, _region, _wait, _imbalance, _straggler);
+}
+
+void
+write_text(const summary& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("ompt_barrier", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening ompt_barrier output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "ompt_barrier" });
+
+    auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / units::msec; };
+
+    ofs << std::setprecision(3) << std::fixed;
+    ofs << "parallel regions         : " << _data.regions << "\n";
+    ofs << "region time (msec)       : " << _msec(_data.duration) << "\n";
+    ofs << "barrier wait (msec)      : " << _msec(_data.wait) << "\n";
+    ofs << "mean imbalance (%)       : " << (_data.imbalance / _data.regions) << "\n";
+    ofs << "max imbalance (%)        : " << _data.max_imbalance << " (region "
+        << _data.max_imbalance_id << ")\n\n";
+
+    ofs << std::setw(8) << "thread" << " | " << std::setw(14) << "wait (msec)" << " | "
+        << std::setw(10) << "straggler" << "\n";
+    for(size_t i = 0; i < _data.thread_wait.size(); ++i)
+    {
+        if(_data.thread_wait.at(i) == 0 && _data.straggler.at(i) == 0) continue;
+        ofs << std::setw(8) << i << " | " << std::setw(14)
+            << _msec(_data.thread_wait.at(i)) << " | " << std::setw(10)
+            << _data.straggler.at(i) << "\n";
+    }
+}
+
+void
+write_json(const summary& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("ompt_barrier");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("regions", _data.regions),
+              cereal::make_nvp("duration_ns", _data.duration),
+              cereal::make_nvp("wait_ns", _data.wait),
+              cereal::make_nvp("mean_imbalance_percent", _data.imbalance / _data.regions),
+              cereal::make_nvp("max_imbalance_percent", _data.max_imbalance),
+              cereal::make_nvp("max_imbalance_region", _data.max_imbalance_id));
+
+        ar->setNextName("threads");
+        ar->startNode();
+        ar->makeArray();
+        for(size_t i = 0; i < _data.thread_wait.size(); ++i)
+        {
+            if(_data.thread_wait.at(i) == 0 && _data.straggler.at(i) == 0) continue;
+            ar->startNode();
+            (*ar)(cereal::make_nvp("thread", i),
+                  cereal::make_nvp("wait_ns", _data.thread_wait.at(i)),
+                  cereal::make_nvp("straggler_count", _data.straggler.at(i)));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("ompt_barrier", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening ompt_barrier output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "ompt_barrier" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+region_kind
+get_region_kind(std::string_view _label)
+{
+    constexpr auto _parallel = std::string_view{ "ompt_parallel" };
+    constexpr auto _barrier  = std::string_view{ "ompt_sync_region_barrier_implicit" };
+
+    if(_label.substr(0, _parallel.length()) == _parallel) return parallel_region;
+    if(_label.substr(0, _barrier.length()) == _barrier) return barrier_region;
+    return other_region;
+}
+
+uint64_t
+parallel_begin(uint64_t _ts)
+{
+    if(get_active().load(std::memory_order_acquire) != 0) return 0;
+
+    auto& _state = get_region_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+    if(get_active().load(std::memory_order_acquire) != 0) return 0;
+
+    auto _id = ++_state.count;
+    if(_id > 2) close(_state, _id - 2);
+    _state.regions.at(_id % ring_size) = region_record{ _id, _ts, 0 };
+    get_active().store(_id, std::memory_order_release);
+    return _id;
+}
+
+void
+parallel_end(uint64_t _region, uint64_t _ts)
+{
+    if(_region == 0) return;
+
+    auto& _state = get_region_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+    auto& _v     = _state.regions.at(_region % ring_size);
+    if(_v.region == _region) _v.end = _ts;
+    get_active().store(0, std::memory_order_release);
+}
+
+uint64_t
+get_region()
+{
+    return get_active().load(std::memory_order_acquire);
+}
+
+void
+barrier_wait(uint64_t _region, uint64_t _duration)
+{
+    auto _tid = static_cast<size_t>(tim::threading::get_id());
+    if(_region == 0 || _tid >= max_supported_threads) return;
+
+    auto& _nthreads = get_nthreads();
+    auto  _n        = _nthreads.load(std::memory_order_relaxed);
+    while(_n <= _tid && !_nthreads.compare_exchange_weak(_n, _tid + 1))
+    {}
+
+    auto& _record = get_thread_waits()[_tid].records[_region % ring_size];
+    if(_record.region.load(std::memory_order_relaxed) != _region)
+    {
+        _record.wait.store(_duration, std::memory_order_relaxed);
+        _record.region.store(_region, std::memory_order_release);
+    }
+    else
+    {
+        _record.wait.store(_record.wait.load(std::memory_order_relaxed) + _duration,
+                           std::memory_order_relaxed);
+    }
+}
+
+void
+post_process()
+{
+    auto& _state = get_region_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+    for(auto i = _state.closed + 1; i <= _state.count; ++i)
+        close(_state, i);
+
+    if(_state.data.regions == 0)
+    {
+        OMNITRACE_VERBOSE_F(1, "No OpenMP implicit barriers were recorded\n");
+        return;
+    }
+
+    if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+        write_text(_state.data);
+
+    if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+        write_json(_state.data);
+}
+}  // namespace ompt_barrier
+}  // namespace omnitrace
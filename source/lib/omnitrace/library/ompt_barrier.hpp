@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+/// combines the time which the threads wait in the implicit barriers of each outermost
+/// OpenMP parallel region into the load imbalance of the region (see
+/// OMNITRACE_OMPT_BARRIER_ANALYSIS): the total wait time, the straggler (the thread
+/// which waited the least) and the percent of the thread time of the region which was
+/// spent waiting. The waits are accumulated per thread in a small ring indexed by the
+/// region number and each region is evaluated when the next but one region begins, so
+/// no events are kept
+namespace ompt_barrier
+{
+enum region_kind
+{
+    other_region = 0,
+    parallel_region,
+    barrier_region,
+};
+
+/// classifies the label of an OpenMP-tools callback
+region_kind
+get_region_kind(std::string_view _label);
+
+/// returns the number of the parallel region which the calling thread began or zero
+/// if another parallel region is active, i.e. the region is nested
+uint64_t
+parallel_begin(uint64_t _ts);
+
+/// records the end of the parallel region returned by parallel_begin
+void
+parallel_end(uint64_t _region, uint64_t _ts);
+
+/// returns the number of the active outermost parallel region or zero
+uint64_t
+get_region();
+
+/// records _duration nsec spent in an implicit barrier of the parallel region by the
+/// calling thread
+void
+barrier_wait(uint64_t _region, uint64_t _duration);
+
+/// evaluates the remaining regions and writes ompt_barrier.{txt,json}
+void
+post_process();
+}  // namespace ompt_barrier
+}  // namespace omnitrace
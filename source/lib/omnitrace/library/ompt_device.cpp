@@ -0,0 +1,409 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/ompt_device.hpp"
+#include "binary/analysis.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace ompt_device
+{
+namespace
+{
+// the records of the operations may be in a later buffer than the end of their
+// target region so the most recent target regions are kept after they end
+constexpr size_t max_ended_targets = 4096;
+
+constexpr auto op_names = std::array<const char*, op_kind_count>{
+    "kernel", "alloc", "transfer_to_device", "transfer_from_device", "delete", "other"
+};
+
+struct construct_key
+{
+    const void* codeptr   = nullptr;
+    const char* construct = nullptr;
+
+    friend bool operator<(const construct_key& _lhs, const construct_key& _rhs)
+    {
+        return std::tie(_lhs.codeptr, _lhs.construct) <
+               std::tie(_rhs.codeptr, _rhs.construct);
+    }
+};
+
+struct op_totals
+{
+    uint64_t count = 0;
+    uint64_t time  = 0;  // nanoseconds
+    uint64_t bytes = 0;
+};
+
+struct construct_entry
+{
+    std::string                          label = {};
+    uint64_t                             count = 0;
+    uint64_t                             time  = 0;  // nanoseconds
+    std::array<op_totals, op_kind_count> ops   = {};
+};
+
+struct target_entry
+{
+    construct_entry* construct = nullptr;
+    int32_t          device    = 0;
+    uint64_t         begin     = 0;
+    bool             ended     = false;
+};
+
+struct profile_data
+{
+    std::mutex                                 mutex        = {};
+    std::map<construct_key, construct_entry>   constructs   = {};
+    std::unordered_map<uint64_t, target_entry> targets      = {};
+    std::deque<uint64_t>                       ended        = {};
+    construct_entry                            unattributed = { "<unknown>" };
+};
+
+using summary_t = std::vector<const construct_entry*>;
+
+std::once_flag post_process_once{};
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// intentionally leaked so the buffers which complete during the static destruction
+// are safe
+auto&
+get_profile()
+{
+    static auto* _v = new profile_data{};
+    return *_v;
+}
+
+// the construct and the source location of its return address, e.g.
+// "target @ main [jacobi.F90:102]"
+std::string
+get_label(const char* _construct, const void* _codeptr)
+{
+    auto _addr = reinterpret_cast<uintptr_t>(_codeptr);
+    if(_addr != 0)
+    {
+        if(auto _entry = binary::lookup_ipaddr_entry<false>(_addr); _entry)
+        {
+            auto _label = JOIN("", _construct, " @ ", tim::demangle(_entry->name));
+            if(!_entry->location.empty())
+                _label += JOIN("", " [", _entry->location, ":", _entry->lineno, "]");
+            return _label;
+        }
+    }
+    return JOIN("", _construct, " @ 0x", std::hex, _addr);
+}
+
+// one track of the target regions and one of the operations per device
+::perfetto::Track
+get_track(int32_t _device, int32_t _ops)
+{
+    auto _desc = [](int32_t _dev, int32_t _is_ops) {
+        return (_is_ops != 0) ? JOIN("", "OMPT Target Device ", _dev, " Operations")
+                              : JOIN("", "OMPT Target Device ", _dev);
+    };
+    return tracing::get_perfetto_track(category::ompt{}, _desc, _device, _ops);
+}
+
+double
+as_msec(uint64_t _v)
+{
+    return static_cast<double>(_v) / units::msec;
+}
+
+double
+as_megabytes(uint64_t _v)
+{
+    return static_cast<double>(_v) / units::megabyte;
+}
+
+void
+write_text(const summary_t& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("ompt_device", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening ompt_device output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname, std::string{ "ompt_device" });
+
+    ofs << std::setprecision(3) << std::fixed;
+    for(const auto* itr : _data)
+    {
+        ofs << itr->label << ": regions: " << itr->count
+            << ", time (msec): " << as_msec(itr->time) << "\n";
+        for(size_t i = 0; i < op_kind_count; ++i)
+        {
+            const auto& _op = itr->ops.at(i);
+            if(_op.count == 0) continue;
+            ofs << "    " << std::setw(20) << std::left << op_names.at(i) << std::right
+                << " count: " << _op.count << ", time (msec): " << as_msec(_op.time);
+            if(_op.bytes > 0) ofs << ", size (MB): " << as_megabytes(_op.bytes);
+            ofs << "\n";
+        }
+        ofs << "\n";
+    }
+}
+
+void
+write_json(const summary_t& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("ompt_device");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto* itr : _data)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("construct", itr->label),
+                  cereal::make_nvp("regions", itr->count),
+                  cereal::make_nvp("time_ns", itr->time));
+            ar->setNextName("operations");
+            ar->startNode();
+            ar->makeArray();
+            for(size_t i = 0; i < op_kind_count; ++i)
+            {
+                const auto& _op = itr->ops.at(i);
+                if(_op.count == 0) continue;
+                ar->startNode();
+                (*ar)(cereal::make_nvp("kind", std::string{ op_names.at(i) }),
+                      cereal::make_nvp("count", _op.count),
+                      cereal::make_nvp("time_ns", _op.time),
+                      cereal::make_nvp("bytes", _op.bytes));
+                ar->finishNode();
+            }
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("ompt_device", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening ompt_device output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary_t>{}(_fname, std::string{ "ompt_device" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+target_begin(int32_t _device, uint64_t _target_id, const char* _construct,
+             const void* _codeptr, uint64_t _ts)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  _key     = construct_key{ _codeptr, _construct };
+    auto  itr      = _profile.constructs.find(_key);
+    if(itr == _profile.constructs.end())
+        itr = _profile.constructs
+                  .emplace(_key, construct_entry{ get_label(_construct, _codeptr) })
+                  .first;
+
+    _profile.targets[_target_id] = target_entry{ &itr->second, _device, _ts, false };
+}
+
+void
+target_end(uint64_t _target_id, uint64_t _ts)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _profile = get_profile();
+    auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr      = _profile.targets.find(_target_id);
+    if(itr == _profile.targets.end() || itr->second.ended) return;
+
+    auto& _target = itr->second;
+    auto  _beg    = _target.begin;
+    auto  _end    = std::max(_ts, _beg);
+    _target.ended = true;
+    _target.construct->count += 1;
+    _target.construct->time += _end - _beg;
+
+    _profile.ended.emplace_back(_target_id);
+    if(_profile.ended.size() > max_ended_targets)
+    {
+        _profile.targets.erase(_profile.ended.front());
+        _profile.ended.pop_front();
+    }
+
+    // the label is not modified after the construct is created
+    const auto* _label  = _target.construct->label.c_str();
+    auto        _device = _target.device;
+    _lk.unlock();
+
+    if(get_use_perfetto())
+    {
+        auto _track = get_track(_device, 0);
+        tracing::push_perfetto_track(
+            category::ompt{}, _label, _track, _beg, [&](::perfetto::EventContext ctx) {
+                if(config::get_perfetto_annotations())
+                {
+                    tracing::add_perfetto_annotation(ctx, "target_id", _target_id);
+                    tracing::add_perfetto_annotation(ctx, "device", _device);
+                }
+            });
+        tracing::pop_perfetto_track(category::ompt{}, _label, _track, _end);
+    }
+}
+
+void
+device_op(op_kind _kind, int32_t _device, uint64_t _target_id, uint64_t _beg_ns,
+          uint64_t _end_ns, size_t _bytes)
+{
+    if(_kind >= op_kind_count || !get_active().load(std::memory_order_relaxed)) return;
+
+    _end_ns = std::max(_end_ns, _beg_ns);
+
+    auto& _profile   = get_profile();
+    auto  _lk        = std::unique_lock<std::mutex>{ _profile.mutex };
+    auto  itr        = _profile.targets.find(_target_id);
+    auto* _construct = (itr == _profile.targets.end()) ? &_profile.unattributed
+                                                        : itr->second.construct;
+    auto& _op        = _construct->ops.at(_kind);
+    _op.count += 1;
+    _op.time += _end_ns - _beg_ns;
+    _op.bytes += _bytes;
+
+    // the kernels are named after their target region
+    const auto* _label = (_kind == kernel_op && _construct != &_profile.unattributed)
+                             ? _construct->label.c_str()
+                             : op_names.at(_kind);
+    _lk.unlock();
+
+    if(get_use_perfetto())
+    {
+        auto _track = get_track(_device, 1);
+        tracing::push_perfetto_track(
+            category::ompt{}, _label, _track, _beg_ns, [&](::perfetto::EventContext ctx) {
+                if(config::get_perfetto_annotations())
+                {
+                    tracing::add_perfetto_annotation(ctx, "op", op_names.at(_kind));
+                    tracing::add_perfetto_annotation(ctx, "target_id", _target_id);
+                    tracing::add_perfetto_annotation(ctx, "device", _device);
+                    if(_bytes > 0) tracing::add_perfetto_annotation(ctx, "bytes", _bytes);
+                }
+            });
+        tracing::pop_perfetto_track(category::ompt{}, _label, _track, _end_ns);
+    }
+}
+
+void
+post_process()
+{
+    if(!config::get_ompt_device_tracing()) return;
+
+    std::call_once(post_process_once, []() {
+        get_active().store(false);
+
+        auto& _profile = get_profile();
+        auto  _lk      = std::unique_lock<std::mutex>{ _profile.mutex };
+
+        auto _data = summary_t{};
+        for(const auto& itr : _profile.constructs)
+            _data.emplace_back(&itr.second);
+        auto _unattributed = std::any_of(
+            _profile.unattributed.ops.begin(), _profile.unattributed.ops.end(),
+            [](const op_totals& _v) { return _v.count > 0; });
+        if(_unattributed) _data.emplace_back(&_profile.unattributed);
+
+        if(_data.empty())
+        {
+            OMNITRACE_VERBOSE_F(1, "No OpenMP target regions were recorded\n");
+            return;
+        }
+
+        // the constructs with the longest target regions first
+        std::stable_sort(_data.begin(), _data.end(),
+                         [](const auto* _lhs, const auto* _rhs) {
+                             return _lhs->time > _rhs->time;
+                         });
+
+        try
+        {
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the OpenMP device report failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace ompt_device
+}  // namespace omnitrace
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// the target regions, the data operations and the kernels executed on the OpenMP
+/// target devices (see OMNITRACE_OMPT_DEVICE_TRACING). The OpenMP runtime collects the
+/// device trace records in buffers which are processed asynchronously when they are
+/// complete. The operations are correlated with their target region by the target id
+/// and the target regions with the host construct by its return address. Every record
+/// is shown in the perfetto tracks of the device and is accumulated into the summary
+/// of its construct, which is written to ompt_device.{txt,json} at finalization
+namespace ompt_device
+{
+enum op_kind
+{
+    kernel_op = 0,
+    alloc_op,
+    transfer_to_device_op,
+    transfer_from_device_op,
+    delete_op,
+    other_op,
+    op_kind_count,
+};
+
+/// records the begin of the target region. The name of the construct (e.g. "target"
+/// or "target enter data") must have static storage duration
+void
+target_begin(int32_t _device, uint64_t _target_id, const char* _construct,
+             const void* _codeptr, uint64_t _ts);
+
+/// records the end of the target region
+void
+target_end(uint64_t _target_id, uint64_t _ts);
+
+/// records a data operation or a kernel of the target region
+void
+device_op(op_kind _kind, int32_t _device, uint64_t _target_id, uint64_t _beg_ns,
+          uint64_t _end_ns, size_t _bytes);
+
+/// stops the recording and writes ompt_device.{txt,json}. Only the first invocation
+/// has an effect
+void
+post_process();
+}  // namespace ompt_device
+}  // namespace omnitrace
@@ -0,0 +1,989 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/pc_sampling.hpp"
+#include "binary/dwarf_entry.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "library/runtime.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <amd_comgr/amd_comgr.h>
+#include <rocprofiler-sdk/rocprofiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <elf.h>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define OMNITRACE_ROCPROFILER_SDK_CALL(...)                                              \
+    ::omnitrace::pc_sampling::check_status(__FILE__, __LINE__, #__VA_ARGS__, __VA_ARGS__)
+
+namespace omnitrace
+{
+namespace pc_sampling
+{
+namespace
+{
+// the records are delivered to the callback thread when the buffer is filled up to
+// the watermark and when it is flushed
+constexpr size_t buffer_size      = 8 * units::MB;
+constexpr size_t buffer_watermark = 7 * units::MB;
+
+// OMNITRACE_PC_SAMPLING_INTERVAL=0
+constexpr uint64_t default_host_trap_interval  = 100;                  // usec
+constexpr uint64_t default_stochastic_interval = uint64_t{ 1 } << 20;  // cycles
+
+bool
+check_status(const char* _file, int _line, const char* _call,
+             rocprofiler_status_t _status)
+{
+    if(_status == ROCPROFILER_STATUS_SUCCESS) return true;
+
+    OMNITRACE_WARNING_F(0, "[%s:%i] %s failed :: %s\n", _file, _line, _call,
+                        rocprofiler_get_status_string(_status));
+    return false;
+}
+
+struct code_object
+{
+    uint64_t          id         = 0;
+    std::string       uri        = {};
+    uint64_t          load_base  = 0;
+    uint64_t          load_size  = 0;
+    int64_t           load_delta = 0;  // load address minus the virtual address
+    std::vector<char> image      = {};  // copy of the code objects not in a file
+};
+
+using pc_key_t = std::pair<uint64_t, uint64_t>;  // code object id, offset
+
+struct pc_key_hash
+{
+    size_t operator()(const pc_key_t& _v) const
+    {
+        return (_v.first * 0x9e3779b97f4a7c15ULL) ^ _v.second;
+    }
+};
+
+struct sample_data
+{
+    std::mutex                                          mutex        = {};
+    std::unordered_map<uint64_t, code_object>           code_objects = {};
+    std::unordered_map<pc_key_t, uint64_t, pc_key_hash> samples      = {};
+    size_t                                              total        = 0;
+    size_t                                              dropped      = 0;
+};
+
+struct tool_data
+{
+    rocprofiler_context_id_t context  = {};
+    rocprofiler_buffer_id_t  buffer   = {};
+    std::string              method   = {};
+    size_t                   interval = 0;
+    std::atomic<bool>        active   = { false };
+};
+
+auto&
+get_sample_data()
+{
+    // intentionally leaked: the callback thread may deliver records during exit
+    static auto* _v = new sample_data{};
+    return *_v;
+}
+
+auto&
+get_tool_data()
+{
+    static auto* _v = new tool_data{};
+    return *_v;
+}
+
+std::once_flag post_process_once{};
+
+void
+code_object_callback(rocprofiler_callback_tracing_record_t _record,
+                     rocprofiler_user_data_t*, void*)
+{
+    if(_record.kind != ROCPROFILER_CALLBACK_TRACING_CODE_OBJECT ||
+       _record.operation != ROCPROFILER_CODE_OBJECT_LOAD ||
+       _record.phase != ROCPROFILER_CALLBACK_PHASE_LOAD)
+        return;
+
+    const auto* _data =
+        static_cast<rocprofiler_callback_tracing_code_object_load_data_t*>(
+            _record.payload);
+
+    auto _obj = code_object{ _data->code_object_id,
+                             (_data->uri) ? std::string{ _data->uri } : std::string{},
+                             _data->load_base,
+                             _data->load_size,
+                             _data->load_delta,
+                             {} };
+
+    // the memory of the code objects loaded from memory may be released once they are
+    // unloaded, which is usually before the finalization
+    if(_data->storage_type == ROCPROFILER_CODE_OBJECT_STORAGE_TYPE_MEMORY &&
+       _data->memory_base != 0 && _data->memory_size > 0)
+    {
+        const auto* _beg = reinterpret_cast<const char*>(_data->memory_base);
+        _obj.image.assign(_beg, _beg + _data->memory_size);
+    }
+
+    auto& _samples = get_sample_data();
+    auto  _lk      = std::unique_lock<std::mutex>{ _samples.mutex };
+    _samples.code_objects[_obj.id] = std::move(_obj);
+}
+
+void
+add_sample(sample_data& _data, const rocprofiler_pc_t& _pc)
+{
+    _data.samples[pc_key_t{ _pc.code_object_id, _pc.code_object_offset }] += 1;
+    _data.total += 1;
+}
+
+void
+buffer_callback(rocprofiler_context_id_t, rocprofiler_buffer_id_t,
+                rocprofiler_record_header_t** _headers, size_t _num_headers, void*,
+                uint64_t _drop_count)
+{
+    auto& _data = get_sample_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    _data.dropped += _drop_count;
+    for(size_t i = 0; i < _num_headers; ++i)
+    {
+        const auto* _header = _headers[i];
+        if(_header->category != ROCPROFILER_BUFFER_CATEGORY_PC_SAMPLING) continue;
+
+        if(_header->kind == ROCPROFILER_PC_SAMPLING_RECORD_HOST_TRAP_V0_SAMPLE)
+        {
+            add_sample(_data,
+                       static_cast<const rocprofiler_pc_sampling_record_host_trap_v0_t*>(
+                           _header->payload)
+                           ->pc);
+        }
+        else if(_header->kind == ROCPROFILER_PC_SAMPLING_RECORD_STOCHASTIC_V0_SAMPLE)
+        {
+            add_sample(
+                _data,
+                static_cast<const rocprofiler_pc_sampling_record_stochastic_v0_t*>(
+                    _header->payload)
+                    ->pc);
+        }
+    }
+}
+
+const char*
+get_unit_name(rocprofiler_pc_sampling_unit_t _unit)
+{
+    switch(_unit)
+    {
+        case ROCPROFILER_PC_SAMPLING_UNIT_INSTRUCTIONS: return "instructions";
+        case ROCPROFILER_PC_SAMPLING_UNIT_CYCLES: return "cycles";
+        case ROCPROFILER_PC_SAMPLING_UNIT_TIME: return "usec";
+        default: break;
+    }
+    return "";
+}
+
+std::vector<const rocprofiler_agent_t*>
+get_gpu_agents()
+{
+    using agent_vec_t = std::vector<const rocprofiler_agent_t*>;
+
+    auto _query = [](rocprofiler_agent_version_t, const void** _agents, size_t _num,
+                     void* _udata) {
+        auto* _v = static_cast<agent_vec_t*>(_udata);
+        for(size_t i = 0; i < _num; ++i)
+        {
+            const auto* _agent = static_cast<const rocprofiler_agent_t*>(_agents[i]);
+            if(_agent->type == ROCPROFILER_AGENT_TYPE_GPU) _v->emplace_back(_agent);
+        }
+        return ROCPROFILER_STATUS_SUCCESS;
+    };
+
+    auto _v = agent_vec_t{};
+    OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_query_available_agents(
+        ROCPROFILER_AGENT_INFO_VERSION_0, _query, sizeof(rocprofiler_agent_t), &_v));
+    return _v;
+}
+
+// configures the sampling of the agent with the method if the agent supports it. The
+// interval is clamped to the range supported by the agent
+bool
+configure_agent(tool_data& _tool, const rocprofiler_agent_t* _agent,
+                rocprofiler_pc_sampling_method_t _method, uint64_t _interval)
+{
+    using config_vec_t = std::vector<rocprofiler_pc_sampling_configuration_t>;
+
+    auto _query = [](const rocprofiler_pc_sampling_configuration_t* _configs,
+                     size_t _num, void* _udata) {
+        static_cast<config_vec_t*>(_udata)->assign(_configs, _configs + _num);
+        return ROCPROFILER_STATUS_SUCCESS;
+    };
+
+    auto _configs = config_vec_t{};
+    if(rocprofiler_query_pc_sampling_agent_configurations(_agent->id, _query,
+                                                          &_configs) !=
+       ROCPROFILER_STATUS_SUCCESS)
+        _configs.clear();
+
+    for(const auto& itr : _configs)
+    {
+        if(itr.method != _method) continue;
+
+        auto _value = std::max<uint64_t>(_interval, itr.min_interval);
+        if(itr.max_interval > 0) _value = std::min<uint64_t>(_value, itr.max_interval);
+        if((itr.flags & ROCPROFILER_PC_SAMPLING_CONFIGURATION_FLAGS_INTERVAL_POW2) != 0)
+        {
+            auto _pow2 = uint64_t{ 1 };
+            while(_pow2 < _value)
+                _pow2 <<= 1;
+            if(itr.max_interval > 0 && _pow2 > itr.max_interval) _pow2 >>= 1;
+            _value = _pow2;
+        }
+
+        OMNITRACE_VERBOSE_F(1, "Sampling the PCs of GPU %u (%s) every %zu %s...\n",
+                            _agent->logical_node_type_id, _agent->name,
+                            static_cast<size_t>(_value), get_unit_name(itr.unit));
+
+        _tool.interval = _value;
+        return OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_configure_pc_sampling_service(
+            _tool.context, _agent->id, itr.method, itr.unit, _value, _tool.buffer, 0));
+    }
+
+    OMNITRACE_VERBOSE_F(1, "GPU %u (%s) does not support the %s PC sampling\n",
+                        _agent->logical_node_type_id, _agent->name,
+                        _tool.method.c_str());
+    return false;
+}
+
+int
+tool_init(rocprofiler_client_finalize_t, void*)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    // the callback thread of rocprofiler-sdk is not sampled
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+
+    auto& _tool    = get_tool_data();
+    _tool.method   = config::get_pc_sampling_method();
+    auto _method   = (_tool.method == "stochastic")
+                         ? ROCPROFILER_PC_SAMPLING_METHOD_STOCHASTIC
+                         : ROCPROFILER_PC_SAMPLING_METHOD_HOST_TRAP;
+    auto _interval = static_cast<uint64_t>(config::get_pc_sampling_interval());
+    if(_interval == 0)
+        _interval = (_method == ROCPROFILER_PC_SAMPLING_METHOD_STOCHASTIC)
+                        ? default_stochastic_interval
+                        : default_host_trap_interval;
+
+    auto _thread = rocprofiler_callback_thread_t{};
+    if(!OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_create_context(&_tool.context)) ||
+       !OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_configure_callback_tracing_service(
+           _tool.context, ROCPROFILER_CALLBACK_TRACING_CODE_OBJECT, nullptr, 0,
+           code_object_callback, nullptr)) ||
+       !OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_create_buffer(
+           _tool.context, buffer_size, buffer_watermark,
+           ROCPROFILER_BUFFER_POLICY_LOSSLESS, buffer_callback, nullptr,
+           &_tool.buffer)) ||
+       !OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_create_callback_thread(&_thread)) ||
+       !OMNITRACE_ROCPROFILER_SDK_CALL(
+           rocprofiler_assign_callback_thread(_tool.buffer, _thread)))
+        return -1;
+
+    size_t _num_agents = 0;
+    for(const auto* itr : get_gpu_agents())
+    {
+        if(configure_agent(_tool, itr, _method, _interval)) ++_num_agents;
+    }
+
+    if(_num_agents == 0)
+    {
+        OMNITRACE_WARNING_F(0, "None of the GPUs support the %s PC sampling\n",
+                            _tool.method.c_str());
+        return -1;
+    }
+
+    if(!OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_start_context(_tool.context)))
+        return -1;
+
+    _tool.active.store(true);
+    return 0;
+}
+
+void
+tool_fini(void*)
+{
+    shutdown();
+}
+
+struct elf_segment
+{
+    uint64_t vaddr  = 0;
+    uint64_t offset = 0;
+    uint64_t size   = 0;  // in the file
+};
+
+struct elf_symbol
+{
+    uint64_t    address = 0;
+    uint64_t    size    = 0;
+    std::string name    = {};
+};
+
+// the loadable segments and the function symbols of a code object
+struct elf_image
+{
+    std::vector<char>        data     = {};
+    std::vector<elf_segment> segments = {};
+    std::vector<elf_symbol>  symbols  = {};  // sorted by address
+
+    bool              parse();
+    const elf_symbol* find_symbol(uint64_t _vaddr) const;
+    uint64_t          read(uint64_t _vaddr, char* _dst, uint64_t _size) const;
+};
+
+bool
+elf_image::parse()
+{
+    auto _read = [this](void* _dst, size_t _size, uint64_t _offset) {
+        if(_offset > data.size() || _size > data.size() - _offset) return false;
+        memcpy(_dst, data.data() + _offset, _size);
+        return true;
+    };
+
+    auto _ehdr = Elf64_Ehdr{};
+    if(!_read(&_ehdr, sizeof(_ehdr), 0) || memcmp(_ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+       _ehdr.e_ident[EI_CLASS] != ELFCLASS64 || _ehdr.e_phentsize != sizeof(Elf64_Phdr))
+        return false;
+
+    for(size_t i = 0; i < _ehdr.e_phnum; ++i)
+    {
+        auto _phdr = Elf64_Phdr{};
+        if(!_read(&_phdr, sizeof(_phdr), _ehdr.e_phoff + (i * sizeof(Elf64_Phdr))))
+            return false;
+        if(_phdr.p_type == PT_LOAD)
+            segments.emplace_back(
+                elf_segment{ _phdr.p_vaddr, _phdr.p_offset, _phdr.p_filesz });
+    }
+
+    auto _shdrs = std::vector<Elf64_Shdr>(_ehdr.e_shnum);
+    if(_ehdr.e_shentsize != sizeof(Elf64_Shdr) ||
+       !_read(_shdrs.data(), _shdrs.size() * sizeof(Elf64_Shdr), _ehdr.e_shoff))
+        return true;
+
+    for(const auto& itr : _shdrs)
+    {
+        if(itr.sh_type != SHT_SYMTAB || itr.sh_entsize != sizeof(Elf64_Sym) ||
+           itr.sh_link >= _shdrs.size())
+            continue;
+
+        const auto& _strtab = _shdrs.at(itr.sh_link);
+        auto        _names  = std::vector<char>(_strtab.sh_size + 1, '\0');
+        if(!_read(_names.data(), _strtab.sh_size, _strtab.sh_offset)) continue;
+
+        for(uint64_t i = 0; i < itr.sh_size / sizeof(Elf64_Sym); ++i)
+        {
+            auto _sym = Elf64_Sym{};
+            if(!_read(&_sym, sizeof(_sym), itr.sh_offset + (i * sizeof(Elf64_Sym))))
+                break;
+            if(ELF64_ST_TYPE(_sym.st_info) != STT_FUNC || _sym.st_shndx == SHN_UNDEF ||
+               _sym.st_name >= _strtab.sh_size)
+                continue;
+            auto _name = std::string{ _names.data() + _sym.st_name };
+            symbols.emplace_back(elf_symbol{ _sym.st_value, _sym.st_size, _name });
+        }
+    }
+
+    std::sort(symbols.begin(), symbols.end(),
+              [](const elf_symbol& _lhs, const elf_symbol& _rhs) {
+                  return _lhs.address < _rhs.address;
+              });
+
+    // the symbols without a size extend to the next symbol
+    for(size_t i = 0; i + 1 < symbols.size(); ++i)
+    {
+        if(symbols.at(i).size == 0)
+            symbols.at(i).size = symbols.at(i + 1).address - symbols.at(i).address;
+    }
+
+    return true;
+}
+
+const elf_symbol*
+elf_image::find_symbol(uint64_t _vaddr) const
+{
+    auto itr = std::upper_bound(
+        symbols.begin(), symbols.end(), _vaddr,
+        [](uint64_t _v, const elf_symbol& _sym) { return _v < _sym.address; });
+    if(itr == symbols.begin()) return nullptr;
+    --itr;
+    return (_vaddr < itr->address + std::max<uint64_t>(itr->size, 1)) ? &(*itr)
+                                                                      : nullptr;
+}
+
+uint64_t
+elf_image::read(uint64_t _vaddr, char* _dst, uint64_t _size) const
+{
+    for(const auto& itr : segments)
+    {
+        if(_vaddr < itr.vaddr || _vaddr >= itr.vaddr + itr.size) continue;
+
+        auto _offset = itr.offset + (_vaddr - itr.vaddr);
+        if(_offset >= data.size()) return 0;
+        auto _n = std::min<uint64_t>({ _size, itr.vaddr + itr.size - _vaddr,
+                                       data.size() - _offset });
+        memcpy(_dst, data.data() + _offset, _n);
+        return _n;
+    }
+    return 0;
+}
+
+std::string
+decode_uri(std::string_view _v)
+{
+    auto _decoded = std::string{};
+    _decoded.reserve(_v.size());
+    for(size_t i = 0; i < _v.size(); ++i)
+    {
+        if(_v.at(i) == '%' && i + 2 < _v.size() && isxdigit(_v.at(i + 1)) &&
+           isxdigit(_v.at(i + 2)))
+        {
+            _decoded += static_cast<char>(
+                std::stoi(std::string{ _v.substr(i + 1, 2) }, nullptr, 16));
+            i += 2;
+        }
+        else
+        {
+            _decoded += _v.at(i);
+        }
+    }
+    return _decoded;
+}
+
+// the code objects which are not copied when they are loaded are in a file, possibly
+// within a fat binary: file://<path>#offset=<offset>&size=<size>
+bool
+load_image(const code_object& _obj, elf_image& _image)
+{
+    if(!_obj.image.empty())
+    {
+        _image.data = _obj.image;
+        return _image.parse();
+    }
+
+    constexpr auto _prefix = std::string_view{ "file://" };
+    if(_obj.uri.compare(0, _prefix.size(), _prefix) != 0) return false;
+
+    auto     _path   = _obj.uri.substr(_prefix.size());
+    uint64_t _offset = 0;
+    uint64_t _size   = 0;
+    auto     _pos    = _path.find('#');
+    if(_pos != std::string::npos)
+    {
+        for(const auto& itr : tim::delimit(_path.substr(_pos + 1), "&"))
+        {
+            auto _eq = itr.find('=');
+            if(_eq == std::string::npos) continue;
+            auto _key = itr.substr(0, _eq);
+            if(_key == "offset")
+                _offset = std::stoull(itr.substr(_eq + 1), nullptr, 0);
+            else if(_key == "size")
+                _size = std::stoull(itr.substr(_eq + 1), nullptr, 0);
+        }
+        _path = _path.substr(0, _pos);
+    }
+
+    auto _ifs = std::ifstream{ decode_uri(_path), std::ios::binary };
+    if(!_ifs) return false;
+
+    if(_size == 0)
+    {
+        _ifs.seekg(0, std::ios::end);
+        auto _end = static_cast<uint64_t>(_ifs.tellg());
+        if(_end <= _offset) return false;
+        _size = _end - _offset;
+    }
+
+    _image.data.resize(_size);
+    _ifs.seekg(static_cast<std::streamoff>(_offset));
+    if(!_ifs.read(_image.data.data(), static_cast<std::streamsize>(_size))) return false;
+
+    return _image.parse();
+}
+
+struct disassembly
+{
+    const elf_image* image       = nullptr;
+    std::string      instruction = {};
+};
+
+// disassembles the instructions at the addresses with the ISA of the code object
+std::unordered_map<uint64_t, std::string>
+disassemble(const elf_image& _image, const std::vector<uint64_t>& _addrs)
+{
+    auto _v    = std::unordered_map<uint64_t, std::string>{};
+    auto _isa  = std::string{};
+    auto _data = amd_comgr_data_t{};
+    if(amd_comgr_create_data(AMD_COMGR_DATA_KIND_EXECUTABLE, &_data) !=
+       AMD_COMGR_STATUS_SUCCESS)
+        return _v;
+
+    size_t _isa_size = 0;
+    if(amd_comgr_set_data(_data, _image.data.size(), _image.data.data()) ==
+           AMD_COMGR_STATUS_SUCCESS &&
+       amd_comgr_get_data_isa_name(_data, &_isa_size, nullptr) ==
+           AMD_COMGR_STATUS_SUCCESS &&
+       _isa_size > 0)
+    {
+        _isa.resize(_isa_size, '\0');
+        if(amd_comgr_get_data_isa_name(_data, &_isa_size, _isa.data()) !=
+           AMD_COMGR_STATUS_SUCCESS)
+            _isa.clear();
+        _isa = _isa.c_str();
+    }
+    amd_comgr_release_data(_data);
+    if(_isa.empty()) return _v;
+
+    auto _read_memory = [](uint64_t _from, char* _to, uint64_t _size, void* _udata) {
+        return static_cast<disassembly*>(_udata)->image->read(_from, _to, _size);
+    };
+    auto _print_instruction = [](const char* _instruction, void* _udata) {
+        static_cast<disassembly*>(_udata)->instruction += _instruction;
+    };
+    auto _print_address = [](uint64_t, void*) {};
+
+    auto _info = amd_comgr_disassembly_info_t{};
+    if(amd_comgr_create_disassembly_info(_isa.c_str(), _read_memory, _print_instruction,
+                                         _print_address,
+                                         &_info) != AMD_COMGR_STATUS_SUCCESS)
+        return _v;
+
+    for(auto itr : _addrs)
+    {
+        auto     _inst = disassembly{ &_image, {} };
+        uint64_t _size = 0;
+        if(amd_comgr_disassemble_instruction(_info, itr, &_inst, &_size) !=
+           AMD_COMGR_STATUS_SUCCESS)
+            continue;
+
+        auto& _str = _inst.instruction;
+        std::replace(_str.begin(), _str.end(), '\t', ' ');
+        auto _beg = _str.find_first_not_of(' ');
+        auto _end = _str.find_last_not_of(' ');
+        if(_beg != std::string::npos) _v.emplace(itr, _str.substr(_beg, _end - _beg + 1));
+    }
+
+    amd_comgr_destroy_disassembly_info(_info);
+    return _v;
+}
+
+// the DWARF line info of the code object, which is only present if the kernels were
+// compiled with debug info
+std::deque<binary::dwarf_entry>
+get_line_info(const elf_image& _image)
+{
+    auto _v  = std::deque<binary::dwarf_entry>{};
+    auto _fd = ::memfd_create("omnitrace-code-object", MFD_CLOEXEC);
+    if(_fd < 0) return _v;
+
+    const auto* _pos = _image.data.data();
+    auto        _n   = _image.data.size();
+    while(_n > 0)
+    {
+        auto _written = ::write(_fd, _pos, _n);
+        if(_written <= 0) break;
+        _pos += _written;
+        _n -= static_cast<size_t>(_written);
+    }
+
+    if(_n == 0 && ::lseek(_fd, 0, SEEK_SET) == 0)
+        _v = std::get<0>(binary::dwarf_entry::process_dwarf(_fd));
+
+    ::close(_fd);
+    return _v;
+}
+
+const binary::dwarf_entry*
+find_line(const std::deque<binary::dwarf_entry>& _entries, uint64_t _vaddr)
+{
+    auto itr = std::upper_bound(_entries.begin(), _entries.end(), _vaddr,
+                                [](uint64_t _v, const binary::dwarf_entry& _entry) {
+                                    return _v < _entry.address.low;
+                                });
+    if(itr == _entries.begin()) return nullptr;
+    --itr;
+    return (itr->end_sequence || itr->line == 0) ? nullptr : &(*itr);
+}
+
+struct instruction_entry
+{
+    uint64_t    address     = 0;  // virtual address in the code object
+    uint64_t    offset      = 0;  // from the begin of the kernel
+    size_t      samples     = 0;
+    std::string instruction = {};
+    std::string source      = {};
+};
+
+struct kernel_entry
+{
+    std::string                    name         = {};
+    uint64_t                       code_object  = 0;
+    size_t                         samples      = 0;
+    std::vector<instruction_entry> instructions = {};
+};
+
+struct report_data
+{
+    std::string               method     = {};
+    size_t                    interval   = 0;
+    size_t                    total      = 0;
+    size_t                    dropped    = 0;
+    size_t                    unresolved = 0;  // not in a recorded code object
+    std::vector<kernel_entry> kernels    = {};
+};
+
+// the code object of the sample and the virtual address of the PC in the code object.
+// The offsets of the PCs outside of a known code object are their addresses
+std::pair<const code_object*, uint64_t>
+resolve(const sample_data& _data, const pc_key_t& _key)
+{
+    auto _obj = _data.code_objects.find(_key.first);
+    if(_obj != _data.code_objects.end())
+        return { &_obj->second,
+                 _obj->second.load_base + _key.second - _obj->second.load_delta };
+
+    for(const auto& itr : _data.code_objects)
+    {
+        const auto& _v = itr.second;
+        if(_key.second >= _v.load_base && _key.second < _v.load_base + _v.load_size)
+            return { &_v, _key.second - _v.load_delta };
+    }
+    return { nullptr, 0 };
+}
+
+std::vector<kernel_entry>
+get_kernels(const code_object& _obj, const std::map<uint64_t, size_t>& _samples)
+{
+    auto _image  = elf_image{};
+    auto _loaded = false;
+    try
+    {
+        _loaded = load_image(_obj, _image);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_VERBOSE_F(1, "Reading the code object %s failed: %s\n",
+                            _obj.uri.c_str(), _e.what());
+    }
+
+    auto _addrs = std::vector<uint64_t>{};
+    for(const auto& itr : _samples)
+        _addrs.emplace_back(itr.first);
+
+    auto _isa   = (_loaded) ? disassemble(_image, _addrs)
+                            : std::unordered_map<uint64_t, std::string>{};
+    auto _lines = (_loaded) ? get_line_info(_image) : std::deque<binary::dwarf_entry>{};
+
+    auto _kernels = std::map<std::string, kernel_entry>{};
+    for(const auto& itr : _samples)
+    {
+        const auto* _sym    = _image.find_symbol(itr.first);
+        auto        _name   = (_sym) ? tim::demangle(_sym->name) : std::string{};
+        auto&       _kernel = _kernels[_name];
+        _kernel.name        = (_name.empty()) ? std::string{ "<unknown>" } : _name;
+        _kernel.code_object = _obj.id;
+        _kernel.samples += itr.second;
+
+        auto _offset = (_sym) ? itr.first - _sym->address : 0;
+        auto _entry  = instruction_entry{ itr.first, _offset, itr.second, std::string{},
+                                         std::string{} };
+        if(auto _inst = _isa.find(itr.first); _inst != _isa.end())
+            _entry.instruction = _inst->second;
+        if(const auto* _line = find_line(_lines, itr.first))
+            _entry.source = JOIN(':', _line->file.str(), _line->line);
+        _kernel.instructions.emplace_back(std::move(_entry));
+    }
+
+    auto _v = std::vector<kernel_entry>{};
+    for(auto& itr : _kernels)
+        _v.emplace_back(std::move(itr.second));
+    return _v;
+}
+
+report_data
+get_report(const sample_data& _data)
+{
+    const auto& _tool   = get_tool_data();
+    auto        _report = report_data{ _tool.method, _tool.interval, _data.total,
+                                _data.dropped,  0,           {} };
+
+    // the samples of each code object per virtual address
+    auto _objects = std::map<const code_object*, std::map<uint64_t, size_t>>{};
+    for(const auto& itr : _data.samples)
+    {
+        auto _pc = resolve(_data, itr.first);
+        if(_pc.first)
+            _objects[_pc.first][_pc.second] += itr.second;
+        else
+            _report.unresolved += itr.second;
+    }
+
+    for(const auto& itr : _objects)
+    {
+        for(auto& kitr : get_kernels(*itr.first, itr.second))
+            _report.kernels.emplace_back(std::move(kitr));
+    }
+
+    std::sort(_report.kernels.begin(), _report.kernels.end(),
+              [](const kernel_entry& _lhs, const kernel_entry& _rhs) {
+                  return _lhs.samples > _rhs.samples;
+              });
+    for(auto& itr : _report.kernels)
+    {
+        std::sort(itr.instructions.begin(), itr.instructions.end(),
+                  [](const instruction_entry& _lhs, const instruction_entry& _rhs) {
+                      return std::tie(_rhs.samples, _lhs.address) <
+                             std::tie(_lhs.samples, _rhs.address);
+                  });
+    }
+
+    return _report;
+}
+
+double
+get_percent(size_t _v, size_t _total)
+{
+    return (_total > 0) ? (100.0 * static_cast<double>(_v) / static_cast<double>(_total))
+                        : 0.0;
+}
+
+std::string
+as_hex(uint64_t _v, int _width)
+{
+    auto _ss = std::stringstream{};
+    _ss << "0x" << std::hex << std::setfill('0') << std::setw(_width) << _v;
+    return _ss.str();
+}
+
+void
+write_text(const report_data& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("pc-sampling", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening pc-sampling output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<report_data>{}(_fname,
+                                                      std::string{ "pc-sampling" });
+
+    ofs << "GPU PC sampling: method: " << _data.method
+        << ", interval: " << _data.interval << ", samples: " << _data.total
+        << ", dropped: " << _data.dropped << ", unresolved: " << _data.unresolved
+        << "\n";
+
+    ofs << std::setprecision(2) << std::fixed;
+    for(const auto& itr : _data.kernels)
+    {
+        ofs << "\n"
+            << itr.name << " (code object " << itr.code_object << "): " << itr.samples
+            << " samples (" << get_percent(itr.samples, _data.total) << "%)\n";
+        ofs << "    " << std::setw(12) << std::left << "address" << std::setw(10)
+            << "offset" << std::right << std::setw(10) << "samples" << std::setw(8)
+            << "%"
+            << "  " << std::setw(48) << std::left << "instruction"
+            << "source\n"
+            << std::right;
+        for(const auto& iitr : itr.instructions)
+        {
+            ofs << "    " << std::setw(12) << std::left << as_hex(iitr.address, 8)
+                << std::setw(10) << as_hex(iitr.offset, 6) << std::right
+                << std::setw(10) << iitr.samples << std::setw(8)
+                << get_percent(iitr.samples, itr.samples) << "  " << std::setw(48)
+                << std::left << iitr.instruction << iitr.source << "\n"
+                << std::right;
+        }
+    }
+}
+
+void
+write_json(const report_data& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("pc_sampling");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("method", _data.method),
+              cereal::make_nvp("interval", _data.interval),
+              cereal::make_nvp("samples", _data.total),
+              cereal::make_nvp("dropped", _data.dropped),
+              cereal::make_nvp("unresolved", _data.unresolved));
+        ar->setNextName("kernels");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.kernels)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("name", itr.name),
+                  cereal::make_nvp("code_object", itr.code_object),
+                  cereal::make_nvp("samples", itr.samples));
+            ar->setNextName("instructions");
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& iitr : itr.instructions)
+            {
+                ar->startNode();
+                (*ar)(cereal::make_nvp("address", iitr.address),
+                      cereal::make_nvp("offset", iitr.offset),
+                      cereal::make_nvp("samples", iitr.samples),
+                      cereal::make_nvp("instruction", iitr.instruction),
+                      cereal::make_nvp("source", iitr.source));
+                ar->finishNode();
+            }
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("pc-sampling", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening pc-sampling output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<report_data>{}(_fname,
+                                                      std::string{ "pc-sampling" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+shutdown()
+{
+    auto& _tool = get_tool_data();
+    if(!_tool.active.exchange(false)) return;
+
+    OMNITRACE_VERBOSE_F(1, "Flushing the GPU PC samples...\n");
+    OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_stop_context(_tool.context));
+    OMNITRACE_ROCPROFILER_SDK_CALL(rocprofiler_flush_buffer(_tool.buffer));
+}
+
+void
+post_process()
+{
+    if(!config::get_use_pc_sampling()) return;
+
+    std::call_once(post_process_once, []() {
+        shutdown();
+
+        auto& _data = get_sample_data();
+        auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+        if(_data.total == 0)
+        {
+            OMNITRACE_VERBOSE_F(1, "No GPU PC samples were recorded\n");
+            return;
+        }
+
+        if(_data.dropped > 0)
+            OMNITRACE_WARNING_F(0,
+                                "%zu GPU PC samples were dropped. Increase "
+                                "OMNITRACE_PC_SAMPLING_INTERVAL to record all of them\n",
+                                _data.dropped);
+
+        try
+        {
+            auto _report = get_report(_data);
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(_report);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(_report);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the GPU PC sampling report failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace pc_sampling
+}  // namespace omnitrace
+
+extern "C" rocprofiler_tool_configure_result_t*
+rocprofiler_configure(uint32_t version, const char* runtime_version, uint32_t priority,
+                      rocprofiler_client_id_t* client_id)
+{
+    using namespace ::omnitrace;
+
+    tim::consume_parameters(version, runtime_version, priority);
+
+    if(!tim::get_env("OMNITRACE_INIT_TOOLING", true)) return nullptr;
+    if(!tim::settings::enabled()) return nullptr;
+
+    if(!config::settings_are_configured() && get_state() < State::Active)
+        omnitrace_init_tooling_hidden();
+
+    if(!config::get_use_pc_sampling()) return nullptr;
+
+    client_id->name = "omnitrace";
+
+    static auto _result = rocprofiler_tool_configure_result_t{
+        sizeof(rocprofiler_tool_configure_result_t), &pc_sampling::tool_init,
+        &pc_sampling::tool_fini, nullptr
+    };
+    return &_result;
+}
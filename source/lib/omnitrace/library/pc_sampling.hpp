@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#if defined(OMNITRACE_USE_ROCPROFILER_SDK) && OMNITRACE_USE_ROCPROFILER_SDK > 0
+#    include <rocprofiler-sdk/registration.h>
+#endif
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// instruction-level hotspots of the GPU kernels from the PC sampling of rocprofiler-sdk
+/// (see OMNITRACE_USE_PC_SAMPLING). The devices buffer the sampled program counters of
+/// the waves, which the callback thread of rocprofiler-sdk drains and counts per code
+/// object and offset. The code objects are recorded when they are loaded. At
+/// finalization, the offsets are mapped to the kernels with the symbols of the code
+/// objects, to the instructions with the comgr disassembler and to the source lines
+/// with the DWARF line info (if the kernels were compiled with -g) and written to
+/// pc-sampling.{txt,json}
+namespace pc_sampling
+{
+/// delivers the samples still buffered by rocprofiler-sdk and stops the sampling
+void
+shutdown();
+
+/// writes the report. Only the first invocation has an effect
+void
+post_process();
+
+#if !defined(OMNITRACE_USE_ROCPROFILER_SDK) || OMNITRACE_USE_ROCPROFILER_SDK == 0
+inline void
+shutdown()
+{}
+
+inline void
+post_process()
+{}
+#endif
+}  // namespace pc_sampling
+}  // namespace omnitrace
+
+#if defined(OMNITRACE_USE_ROCPROFILER_SDK) && OMNITRACE_USE_ROCPROFILER_SDK > 0
+extern "C"
+{
+    // found by rocprofiler-register when the HIP and HSA runtimes are initialized
+    rocprofiler_tool_configure_result_t* rocprofiler_configure(
+        uint32_t version, const char* runtime_version, uint32_t priority,
+        rocprofiler_client_id_t* client_id) OMNITRACE_PUBLIC_API;
+}
+#endif
@@ -23,6 +23,7 @@
 #include "library/perf.hpp"
 #include "core/debug.hpp"
 #include "core/locking.hpp"
+#include "core/perf_ring.hpp"
 #include "core/state.hpp"
 #include "core/timemory.hpp"
 #include "core/utility.hpp"
@@ -75,12 +76,21 @@ namespace
 {
 struct SizeParams
 {
-    const size_t num_pages = 2;
-    const size_t page      = units::get_page_size();
-    const size_t data      = num_pages * page;
-    const size_t mmap      = data + page;
+    const size_t page = units::get_page_size();
 };
 const SizeParams sizes = {};
+
+// the samples of the branch stack hold the index of the hardware buffer (Linux 5.7+)
+inline bool
+has_branch_hw_index(uint64_t _branch_sample_type)
+{
+#if defined(PERF_SAMPLE_BRANCH_HW_INDEX)
+    return (_branch_sample_type & PERF_SAMPLE_BRANCH_HW_INDEX) != 0;
+#else
+    (void) _branch_sample_type;
+    return false;
+#endif
+}
 }  // namespace
 
 long
@@ -101,19 +111,23 @@ perf_event::perf_event(perf_event&& rhs) noexcept
         OMNITRACE_VERBOSE(1, "Closed perf event fd %li\n", m_fd);
     }
 
-    if(m_mapping != nullptr && m_mapping != rhs.m_mapping) munmap(m_mapping, sizes.mmap);
+    if(m_mapping != nullptr && m_mapping != rhs.m_mapping) munmap(m_mapping, m_mmap_size);
 
     // take rhs perf event's file descriptor and replace it with -1
     m_fd     = rhs.m_fd;
     rhs.m_fd = -1;
 
     // take rhs perf_event's mapping and replace it with nullptr
-    m_mapping     = rhs.m_mapping;
-    rhs.m_mapping = nullptr;
-
-    // Copy over the sample type and read format
-    m_sample_type = rhs.m_sample_type;
-    m_read_format = rhs.m_read_format;
+    m_mapping       = rhs.m_mapping;
+    m_mmap_size     = rhs.m_mmap_size;
+    rhs.m_mapping   = nullptr;
+    rhs.m_mmap_size = 0;
+
+    // Copy over the sample type, read format, and ring buffer size
+    m_sample_type        = rhs.m_sample_type;
+    m_read_format        = rhs.m_read_format;
+    m_branch_sample_type = rhs.m_branch_sample_type;
+    m_num_pages          = rhs.m_num_pages;
 }
 
 /// Close the perf_event file descriptor and unmap the ring buffer
@@ -129,19 +143,23 @@ perf_event::operator=(perf_event&& rhs) noexcept
     // Release resources if the current perf_event is initialized and not equal to this
     // one
     if(m_fd != -1 && m_fd != rhs.m_fd) ::close(m_fd);
-    if(m_mapping != nullptr && m_mapping != rhs.m_mapping) munmap(m_mapping, sizes.mmap);
+    if(m_mapping != nullptr && m_mapping != rhs.m_mapping) munmap(m_mapping, m_mmap_size);
 
     // take rhs perf event's file descriptor and replace it with -1
     m_fd     = rhs.m_fd;
     rhs.m_fd = -1;
 
     // take rhs perf_event's mapping and replace it with nullptr
-    m_mapping     = rhs.m_mapping;
-    rhs.m_mapping = nullptr;
+    m_mapping       = rhs.m_mapping;
+    m_mmap_size     = rhs.m_mmap_size;
+    rhs.m_mapping   = nullptr;
+    rhs.m_mmap_size = 0;
 
-    // Copy over the sample type and read format
-    m_sample_type = rhs.m_sample_type;
-    m_read_format = rhs.m_read_format;
+    // Copy over the sample type, read format, and ring buffer size
+    m_sample_type        = rhs.m_sample_type;
+    m_read_format        = rhs.m_read_format;
+    m_branch_sample_type = rhs.m_branch_sample_type;
+    m_num_pages          = rhs.m_num_pages;
 
     return *this;
 }
@@ -155,6 +173,9 @@ perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
     m_read_format = _pe.read_format;
     m_batch_size  = _pe.wakeup_events;
 
+    m_branch_sample_type =
+        (_pe.sample_type & PERF_SAMPLE_BRANCH_STACK) ? _pe.branch_sample_type : 0;
+
     // Set some mandatory fields
     _pe.size     = sizeof(struct perf_event_attr);
     _pe.disabled = 1;
@@ -187,7 +208,7 @@ perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
     if(_pe.sample_type != 0 && _pe.sample_period != 0)
     {
         void* ring_buffer =
-            mmap(nullptr, sizes.mmap, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            mmap(nullptr, get_mmap_size(), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
 
         OMNITRACE_RETURN_ERROR_MSG(
             ring_buffer == MAP_FAILED,
@@ -195,7 +216,20 @@ perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
             "permission to invoke the perf tool, and that the program being profiled "
             "does not use an excessive number of threads (>1000)");
 
-        m_mapping = reinterpret_cast<struct perf_event_mmap_page*>(ring_buffer);
+        m_mapping   = reinterpret_cast<struct perf_event_mmap_page*>(ring_buffer);
+        m_mmap_size = get_mmap_size();
+    }
+    else
+    {
+        // when counting, only map the metadata page which holds the index and offset
+        // of the hardware counter for the user-space reads. Without it, the count is
+        // read with a syscall
+        void* _page = mmap(nullptr, sizes.page, PROT_READ, MAP_SHARED, m_fd, 0);
+        if(_page != MAP_FAILED)
+        {
+            m_mapping   = reinterpret_cast<struct perf_event_mmap_page*>(_page);
+            m_mmap_size = sizes.page;
+        }
     }
 
     return std::optional<std::string>{};
@@ -235,6 +269,28 @@ perf_event::open(double _freq, uint32_t _batch_size, pid_t _pid, int _cpu)
     return open(_pe, _pid, _cpu);
 }
 
+void
+perf_event::set_num_pages(size_t _n)
+{
+    // the kernel requires the data region to be a power of 2 number of pages
+    size_t _v = 1;
+    while(_v < _n)
+        _v <<= 1;
+    m_num_pages = _v;
+}
+
+size_t
+perf_event::get_data_size() const
+{
+    return m_num_pages * sizes.page;
+}
+
+size_t
+perf_event::get_mmap_size() const
+{
+    return get_data_size() + sizes.page;
+}
+
 /// Read event count
 long
 perf_event::get_fileno() const
@@ -252,6 +308,144 @@ perf_event::get_count() const
     return count;
 }
 
+uint64_t
+perf_event::get_scaled_count() const
+{
+    constexpr uint64_t _times =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    if((m_read_format & _times) != _times) return get_count();
+
+    // the count, the time enabled and the time running, followed by the id
+    uint64_t _data[4] = { 0, 0, 0, 0 };
+    ssize_t  _size    = sizeof(uint64_t) * ((m_read_format & PERF_FORMAT_ID) ? 4 : 3);
+    OMNITRACE_REQUIRE(read(m_fd, _data, _size) == _size)
+        << "Failed to read event count from perf_event file";
+
+    if(_data[2] == 0) return 0;
+    if(_data[2] >= _data[1]) return _data[0];
+    return static_cast<uint64_t>(static_cast<double>(_data[0]) *
+                                 static_cast<double>(_data[1]) /
+                                 static_cast<double>(_data[2]));
+}
+
+namespace
+{
+#if defined(__x86_64__)
+inline uint64_t
+rdpmc(uint32_t _counter)
+{
+    uint32_t _lo = 0;
+    uint32_t _hi = 0;
+    asm volatile("rdpmc" : "=a"(_lo), "=d"(_hi) : "c"(_counter));
+    return (static_cast<uint64_t>(_hi) << 32) | _lo;
+}
+#endif
+
+#if defined(__x86_64__)
+inline uint64_t
+rdtsc()
+{
+    uint32_t _lo = 0;
+    uint32_t _hi = 0;
+    asm volatile("rdtsc" : "=a"(_lo), "=d"(_hi));
+    return (static_cast<uint64_t>(_hi) << 32) | _lo;
+}
+#endif
+
+inline void
+compiler_barrier()
+{
+    asm volatile("" ::: "memory");
+}
+}  // namespace
+
+/// Read event count from user-space. The kernel updates the index and the offset
+/// under the seqlock in the metadata page, see include/uapi/linux/perf_event.h
+uint64_t
+perf_event::read_count() const
+{
+#if defined(__x86_64__)
+    if(m_mapping != nullptr)
+    {
+        const volatile auto* _pc    = m_mapping;
+        uint32_t             _seq   = 0;
+        uint32_t             _idx   = 0;
+        int64_t              _count = 0;
+
+        do
+        {
+            _seq = _pc->lock;
+            compiler_barrier();
+
+            _idx   = _pc->index;
+            _count = _pc->offset;
+            if(_pc->cap_user_rdpmc && _idx != 0)
+            {
+                // the counter is pmc_width bits wide and must be sign-extended
+                auto _width = _pc->pmc_width;
+                auto _pmc   = static_cast<int64_t>(rdpmc(_idx - 1));
+                _pmc <<= (64 - _width);
+                _pmc >>= (64 - _width);
+                _count += _pmc;
+            }
+
+            compiler_barrier();
+        } while(_pc->lock != _seq);
+
+        // an index of zero means the event is not on a counter right now
+        if(_idx != 0 && _pc->cap_user_rdpmc) return static_cast<uint64_t>(_count);
+    }
+#endif
+    return get_count();
+}
+
+bool
+perf_event::has_user_read() const
+{
+#if defined(__x86_64__)
+    return (m_mapping != nullptr && m_mapping->cap_user_rdpmc != 0);
+#else
+    return false;
+#endif
+}
+
+/// The time since the kernel updated the page is computed from the TSC as described in
+/// include/uapi/linux/perf_event.h. A thread which reads its own counters is running
+/// so it has been running since the update
+bool
+perf_event::read_user_page(uint64_t& _count, uint64_t& _running) const
+{
+#if defined(__x86_64__)
+    if(m_mapping == nullptr || m_mapping->cap_user_time == 0) return false;
+
+    const volatile auto* _pc  = m_mapping;
+    uint32_t             _seq = 0;
+
+    do
+    {
+        _seq = _pc->lock;
+        compiler_barrier();
+
+        uint64_t _shift = _pc->time_shift;
+        uint64_t _mult  = _pc->time_mult;
+        uint64_t _cyc   = rdtsc();
+        uint64_t _quot  = _cyc >> _shift;
+        uint64_t _rem   = _cyc & ((uint64_t{ 1 } << _shift) - 1);
+
+        _count   = _pc->offset;
+        _running = _pc->time_running + _pc->time_offset + _quot * _mult +
+                   ((_rem * _mult) >> _shift);
+
+        compiler_barrier();
+    } while(_pc->lock != _seq);
+    return true;
+#else
+    (void) _count;
+    (void) _running;
+    return false;
+#endif
+}
+
 /// Start counting events
 bool
 perf_event::start() const
@@ -298,8 +492,9 @@ perf_event::close()
 
     if(m_mapping != nullptr)
     {
-        munmap(m_mapping, sizes.mmap);
-        m_mapping = nullptr;
+        munmap(m_mapping, m_mmap_size);
+        m_mapping   = nullptr;
+        m_mmap_size = 0;
     }
 }
 
@@ -328,8 +523,8 @@ perf_event::iterator::next()
     struct perf_event_header _hdr;
 
     // Copy out the record header
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, &_hdr,
-                                      sizeof(struct perf_event_header));
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.get_data_size(), m_index,
+                                      &_hdr, sizeof(struct perf_event_header));
 
     // Advance to the next record
     m_index += _hdr.size;
@@ -342,7 +537,7 @@ perf_event::iterator::iterator(perf_event& _source, struct perf_event_mmap_page*
     if(_mapping != nullptr)
     {
         m_index = _mapping->data_tail;
-        m_head  = _mapping->data_head;
+        m_head  = ring::load_head(_mapping);
     }
     else
     {
@@ -355,7 +550,7 @@ perf_event::iterator::~iterator()
 {
     if(m_mapping != nullptr)
     {
-        m_mapping->data_tail = m_index;
+        ring::store_tail(m_mapping, m_index);
     }
 }
 
@@ -378,14 +573,15 @@ perf_event::iterator::get()
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
     // Copy out the record header
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, _buf,
-                                      sizeof(struct perf_event_header));
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.get_data_size(), m_index,
+                                      _buf, sizeof(struct perf_event_header));
 
     // Get a pointer to the header
     struct perf_event_header* header = reinterpret_cast<struct perf_event_header*>(_buf);
 
     // Copy out the entire record
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, _buf, header->size);
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.get_data_size(), m_index,
+                                      _buf, header->size);
 
     return perf_event::record(&m_source, header);
 }
@@ -406,8 +602,8 @@ perf_event::iterator::has_data() const
     }
 
     struct perf_event_header _hdr;
-    perf_event::copy_from_ring_buffer(m_mapping, m_index, &_hdr,
-                                      sizeof(struct perf_event_header));
+    perf_event::copy_from_ring_buffer(m_mapping, m_source.get_data_size(), m_index,
+                                      &_hdr, sizeof(struct perf_event_header));
 
     // If the first record is larger than the available data, nothing can be read
     if(m_index + _hdr.size > m_head)
@@ -419,30 +615,14 @@ perf_event::iterator::has_data() const
 }
 
 void
-perf_event::copy_from_ring_buffer(struct perf_event_mmap_page* _mapping, ptrdiff_t _index,
-                                  void* _dest, size_t _nbytes)
+perf_event::copy_from_ring_buffer(struct perf_event_mmap_page* _mapping,
+                                  size_t _data_size, ptrdiff_t _index, void* _dest,
+                                  size_t _nbytes)
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
-    uintptr_t _base    = reinterpret_cast<uintptr_t>(_mapping) + sizes.page;
-    size_t    _beg_idx = _index % sizes.data;
-    size_t    _end_idx = _beg_idx + _nbytes;
-
-    if(_end_idx <= sizes.data)
-    {
-        memcpy(_dest, reinterpret_cast<void*>(_base + _beg_idx), _nbytes);
-    }
-    else
-    {
-        size_t _chunk_size2 = _end_idx - sizes.data;
-        size_t _chunk_size1 = _nbytes - _chunk_size2;
-
-        void* _dest2 =
-            reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(_dest) + _chunk_size1);
-
-        memcpy(_dest, reinterpret_cast<void*>(_base + _beg_idx), _chunk_size1);
-        memcpy(_dest2, reinterpret_cast<void*>(_base), _chunk_size2);
-    }
+    ring::copy(reinterpret_cast<const char*>(_mapping) + sizes.page, _data_size, _index,
+               _dest, _nbytes);
 }
 
 uint64_t
@@ -504,6 +684,36 @@ perf_event::record::get_cpu() const
     return *locate_field<sample::cpu, uint32_t*>();
 }
 
+uint64_t
+perf_event::record::get_addr() const
+{
+    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+                     m_source->is_sampling(sample::addr))
+        << "Record does not have an 'addr' field (" << is_sample() << "|" << m_source
+        << ")";
+    return *locate_field<sample::addr, uint64_t*>();
+}
+
+uint64_t
+perf_event::record::get_weight() const
+{
+    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+                     m_source->is_sampling(sample::weight))
+        << "Record does not have a 'weight' field (" << is_sample() << "|" << m_source
+        << ")";
+    return *locate_field<sample::weight, uint64_t*>();
+}
+
+uint64_t
+perf_event::record::get_data_src() const
+{
+    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+                     m_source->is_sampling(sample::data_src))
+        << "Record does not have a 'data_src' field (" << is_sample() << "|" << m_source
+        << ")";
+    return *locate_field<sample::data_src, uint64_t*>();
+}
+
 container::c_array<uint64_t>
 perf_event::record::get_callchain() const
 {
@@ -519,6 +729,57 @@ perf_event::record::get_callchain() const
     return container::wrap_c_array(_base, _size);
 }
 
+container::c_array<perf_branch_entry>
+perf_event::record::get_branch_stack() const
+{
+    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+                     m_source->is_sampling(sample::branch_stack))
+        << "Record does not have a branch_stack field (" << is_sample() << "|"
+        << m_source << ")";
+
+    uint64_t* _base = locate_field<sample::branch_stack, uint64_t*>();
+    uint64_t  _size = *_base;
+    // Advance past the size and the index of the hardware buffer
+    ++_base;
+    if(has_branch_hw_index(m_source->get_branch_sample_type())) ++_base;
+    return container::wrap_c_array(reinterpret_cast<perf_branch_entry*>(_base), _size);
+}
+
+bool
+perf_event::record::is_switch_out() const
+{
+#if defined(PERF_RECORD_MISC_SWITCH_OUT)
+    return is_switch() && (m_header->misc & PERF_RECORD_MISC_SWITCH_OUT) != 0;
+#else
+    return false;
+#endif
+}
+
+bool
+perf_event::record::is_preempted() const
+{
+#if defined(PERF_RECORD_MISC_SWITCH_OUT_PREEMPT)
+    return is_switch_out() && (m_header->misc & PERF_RECORD_MISC_SWITCH_OUT_PREEMPT) != 0;
+#else
+    return false;
+#endif
+}
+
+uint64_t
+perf_event::record::get_switch_time() const
+{
+    OMNITRACE_ASSERT(is_switch() && m_source != nullptr &&
+                     m_source->is_sampling(sample::time))
+        << "Record does not have a 'time' field (" << is_switch() << "|" << m_source
+        << ")";
+
+    // the body of a switch record is only the sample_id: { pid, tid }, time, ...
+    uintptr_t p =
+        reinterpret_cast<uintptr_t>(m_header) + sizeof(struct perf_event_header);
+    if(m_source->is_sampling(sample::pid_tid)) p += sizeof(uint32_t) + sizeof(uint32_t);
+    return *reinterpret_cast<uint64_t*>(p);
+}
+
 template <sample SampleT, typename Tp>
 Tp
 perf_event::record::locate_field() const
@@ -617,7 +878,13 @@ perf_event::record::locate_field() const
     // branch_stack
     if constexpr(SampleT == sample::branch_stack) return reinterpret_cast<Tp>(p);
     if(m_source != nullptr && m_source->is_sampling(sample::branch_stack))
-        OMNITRACE_FATAL << "Branch stack sampling is not supported";
+    {
+        uint64_t nr = *reinterpret_cast<uint64_t*>(p);
+        p += sizeof(uint64_t) + (nr * sizeof(struct perf_branch_entry));
+        // the index of the hardware buffer precedes the entries
+        if(has_branch_hw_index(m_source->get_branch_sample_type()))
+            p += sizeof(uint64_t);
+    }
 
     // regs
     if constexpr(SampleT == sample::regs) return reinterpret_cast<Tp>(p);
@@ -629,6 +896,16 @@ perf_event::record::locate_field() const
     if(m_source != nullptr && m_source->is_sampling(sample::stack))
         OMNITRACE_FATAL << "Stack sampling is not supported";
 
+    // weight
+    if constexpr(SampleT == sample::weight) return reinterpret_cast<Tp>(p);
+    if(m_source != nullptr && m_source->is_sampling(sample::weight))
+        p += sizeof(uint64_t);
+
+    // data_src
+    if constexpr(SampleT == sample::data_src) return reinterpret_cast<Tp>(p);
+    if(m_source != nullptr && m_source->is_sampling(sample::data_src))
+        p += sizeof(uint64_t);
+
     // end
     if constexpr(SampleT == sample::last) return reinterpret_cast<Tp>(p);
 
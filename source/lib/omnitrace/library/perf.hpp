@@ -75,9 +75,37 @@ struct perf_event
     /// Read event count
     uint64_t get_count() const;
 
+    /// Read event count of an event opened with PERF_FORMAT_TOTAL_TIME_ENABLED and
+    /// PERF_FORMAT_TOTAL_TIME_RUNNING in the read format, scaled by the fraction of the
+    /// time the event was scheduled on a counter when the counters are multiplexed
+    uint64_t get_scaled_count() const;
+
+    /// Read event count of a counting (non-sampling) perf_event which was opened by
+    /// the calling thread. Uses the rdpmc instruction when the kernel permits it and
+    /// the event is scheduled on a counter, otherwise falls back to get_count()
+    uint64_t read_count() const;
+
+    /// Check if read_count() can read the counter from user-space
+    bool has_user_read() const;
+
+    /// Read the count and the running time (nsec) of a counting software event (e.g.
+    /// PERF_COUNT_SW_CONTEXT_SWITCHES) which was opened by the calling thread from the
+    /// metadata page, without a syscall. The kernel updates the page when the thread is
+    /// scheduled in so the count is the value as of that time and the running time is
+    /// extended to now with the TSC. Returns false if the page is not mapped or the
+    /// time cannot be computed in user-space
+    bool read_user_page(uint64_t& _count, uint64_t& _running) const;
+
     /// Get the batch size
     uint32_t get_batch_size() const { return m_batch_size; }
 
+    /// Set the number of data pages in the ring buffer (rounded up to a power of 2).
+    /// Only applies to subsequent calls to open
+    void set_num_pages(size_t);
+
+    /// Get the number of data pages in the ring buffer
+    size_t get_num_pages() const { return m_num_pages; }
+
     /// Start counting events and collecting samples
     bool start() const;
 
@@ -103,6 +131,9 @@ struct perf_event
     /// Get the configuration for this perf_event's read format
     inline uint64_t get_read_format() const { return m_read_format; }
 
+    /// Get the configuration for this perf_event's branch sampling
+    inline uint64_t get_branch_sample_type() const { return m_branch_sample_type; }
+
     /// A generic record type
     struct record
     {
@@ -133,6 +164,18 @@ struct perf_event
         inline bool is_read() const { return get_type() == record_type::read; }
         inline bool is_sample() const { return get_type() == record_type::sample; }
         inline bool is_mmap2() const { return get_type() == record_type::mmap2; }
+        inline bool is_switch() const
+        {
+            return get_type() == record_type::switch_record;
+        }
+
+        /// Check if a switch record is the thread being switched out (requires
+        /// perf_event_attr::context_switch)
+        bool is_switch_out() const;
+
+        /// Check if the thread of a switch-out record was preempted while runnable
+        /// instead of blocking. Always false for kernels older than 4.17
+        bool is_preempted() const;
 
         uint64_t                     get_ip() const;
         uint64_t                     get_pid() const;
@@ -140,8 +183,19 @@ struct perf_event
         uint64_t                     get_time() const;
         uint64_t                     get_period() const;
         uint32_t                     get_cpu() const;
+        uint64_t                     get_addr() const;
+        uint64_t                     get_weight() const;
+        uint64_t                     get_data_src() const;
         container::c_array<uint64_t> get_callchain() const;
 
+        /// Taken branches of the sample, the most recent first (requires
+        /// perf_event_attr::branch_sample_type)
+        container::c_array<perf_branch_entry> get_branch_stack() const;
+
+        /// Timestamp of a switch record (requires perf_event_attr::sample_id_all and
+        /// the time in the sample type)
+        uint64_t get_switch_time() const;
+
     private:
         record(const perf_event* source, struct perf_event_header* header)
         : m_source(source)
@@ -189,20 +243,35 @@ struct perf_event
 private:
     // Copy data out of the mmap ring buffer
     static void copy_from_ring_buffer(struct perf_event_mmap_page* mapping,
-                                      ptrdiff_t index, void* dest, size_t bytes);
+                                      size_t data_size, ptrdiff_t index, void* dest,
+                                      size_t bytes);
+
+    // Size of the data region of the ring buffer
+    size_t get_data_size() const;
+
+    // Size of the data region of the ring buffer + the metadata page
+    size_t get_mmap_size() const;
 
     uint32_t m_batch_size = 10;
 
+    /// Number of data pages in the ring buffer
+    size_t m_num_pages = 2;
+
     /// File descriptor for the perf event
     long m_fd = -1;
 
     /// Memory mapped perf event region
     struct perf_event_mmap_page* m_mapping = nullptr;
 
+    /// Size of the memory mapped region (only the metadata page when counting)
+    size_t m_mmap_size = 0;
+
     /// The sample type from this perf_event's configuration
     uint64_t m_sample_type = 0;
     /// The read format from this perf event's configuration
     uint64_t m_read_format = 0;
+    /// The branch sample type from this perf event's configuration
+    uint64_t m_branch_sample_type = 0;
 };
 
 /// provides thread-local instance of perf_event
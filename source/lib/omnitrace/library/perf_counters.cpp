@@ -0,0 +1,503 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/perf_counters.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perf.hpp"
+#include "core/timemory.hpp"
+#include "library/perf.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+namespace omnitrace
+{
+namespace perf_counters
+{
+namespace
+{
+struct region_entry
+{
+    std::string name   = {};
+    uint64_t    count  = 0;
+    values_t    values = {};
+};
+
+// only the owning thread opens, reads, and closes the counters and updates the
+// regions. The labels, the counts, and the regions are read by the finalization.
+// The events are partitioned into groups of OMNITRACE_PERF_EVENTS_GROUP_SIZE and only
+// one group is counting at a time. The counts of the other groups are the values when
+// they were stopped and the running time of every event is accumulated so the counts
+// are scaled to the time since the counters were opened
+struct thread_counters
+{
+    bool                                     active     = false;
+    bool                                     busy       = false;  // read in progress
+    size_t                                   size       = 0;
+    size_t                                   group_size = max_events;
+    size_t                                   group      = 0;  // counting group
+    uint64_t                                 interval   = 0;  // rotation (nsec)
+    uint64_t                                 opened     = 0;  // timestamps (nsec)
+    uint64_t                                 rotated    = 0;
+    uint64_t                                 updated    = 0;
+    std::array<perf::perf_event, max_events> events     = {};
+    std::array<std::string, max_events>      labels     = {};
+    values_t                                 counts     = {};
+    values_t                                 running    = {};  // nsec
+    std::vector<values_t>                    stack      = {};
+    std::unordered_map<size_t, region_entry> regions    = {};
+
+    size_t num_groups() const { return (size + group_size - 1) / group_size; }
+    size_t group_begin() const { return group * group_size; }
+    size_t group_end() const { return std::min(group_begin() + group_size, size); }
+
+    uint64_t get_estimate(size_t _idx) const
+    {
+        auto _elapsed = updated - opened;
+        if(running[_idx] == 0) return 0;
+        if(running[_idx] == _elapsed) return counts[_idx];
+        return static_cast<uint64_t>(static_cast<double>(counts[_idx]) *
+                                     (static_cast<double>(_elapsed) / running[_idx]));
+    }
+};
+
+using thread_counters_data = omnitrace::thread_data<thread_counters, thread_counters>;
+
+auto&
+get_thread_counters(int64_t _tid = tim::threading::get_id())
+{
+    return thread_counters_data::instance(construct_on_thread{ _tid });
+}
+
+// the counters of the calling thread once they are opened so the reads in the signal
+// handler do not look up the thread data
+thread_counters*&
+get_local_counters()
+{
+    static thread_local thread_counters* _v = nullptr;
+    return _v;
+}
+
+uint64_t
+get_clock_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// reads the counting group
+void
+update(thread_counters& _v, uint64_t _now)
+{
+    for(size_t i = _v.group_begin(); i < _v.group_end(); ++i)
+    {
+        _v.counts[i] = _v.events[i].read_count();
+        _v.running[i] += (_now - _v.updated);
+    }
+    _v.updated = _now;
+}
+
+// stops the counting group and starts the next one
+void
+rotate(thread_counters& _v, uint64_t _now)
+{
+    update(_v, _now);
+    for(size_t i = _v.group_begin(); i < _v.group_end(); ++i)
+        _v.events[i].stop();
+    _v.group = (_v.group + 1) % _v.num_groups();
+    for(size_t i = _v.group_begin(); i < _v.group_end(); ++i)
+        _v.events[i].start();
+    _v.rotated = _now;
+}
+
+// the totals of an event merged across the threads
+struct event_summary
+{
+    uint64_t count    = 0;
+    uint64_t estimate = 0;
+    uint64_t running  = 0;
+    uint64_t elapsed  = 0;
+
+    double get_running_percent() const
+    {
+        return (elapsed > 0) ? (100.0 * running) / elapsed : 0.0;
+    }
+};
+
+// merged across the threads
+struct summary
+{
+    uint64_t count    = 0;
+    uint64_t nthreads = 0;
+    values_t values   = {};
+};
+
+using merged_data = std::map<std::string, summary>;
+
+void
+write_text(const std::vector<std::string>& _labels,
+           const std::vector<event_summary>& _events, const merged_data& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("perf_counters", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening perf_counters output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "perf_counters" });
+
+    // the estimates are the counts scaled by the fraction of the time which the
+    // event was counting
+    ofs << std::setw(20) << "count" << " | " << std::setw(20) << "estimate" << " | "
+        << std::setw(12) << "running (%)" << " | event\n";
+    for(size_t i = 0; i < _labels.size(); ++i)
+    {
+        const auto& _v = _events.at(i);
+        ofs << std::setw(20) << _v.count << " | " << std::setw(20) << _v.estimate
+            << " | " << std::setw(12) << std::setprecision(2) << std::fixed
+            << _v.get_running_percent() << " | " << _labels.at(i) << "\n";
+    }
+
+    if(_data.empty()) return;
+
+    ofs << "\n" << std::setw(12) << "count" << " | " << std::setw(8) << "threads";
+    for(const auto& itr : _labels)
+        ofs << " | " << std::setw(16) << itr;
+    ofs << " | region\n";
+    for(const auto& itr : _data)
+    {
+        const auto& _v = itr.second;
+        ofs << std::setw(12) << _v.count << " | " << std::setw(8) << _v.nthreads;
+        for(size_t i = 0; i < _labels.size(); ++i)
+            ofs << " | " << std::setw(std::max<size_t>(16, _labels.at(i).length()))
+                << _v.values.at(i);
+        ofs << " | " << itr.first << "\n";
+    }
+}
+
+void
+write_json(const std::vector<std::string>& _labels,
+           const std::vector<event_summary>& _events, const merged_data& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("perf_counters");
+        ar->startNode();
+
+        ar->setNextName("events");
+        ar->startNode();
+        ar->makeArray();
+        for(size_t i = 0; i < _labels.size(); ++i)
+        {
+            const auto& _v = _events.at(i);
+            ar->startNode();
+            (*ar)(cereal::make_nvp("event", _labels.at(i)),
+                  cereal::make_nvp("count", _v.count),
+                  cereal::make_nvp("estimate", _v.estimate),
+                  cereal::make_nvp("time_enabled_ns", _v.elapsed),
+                  cereal::make_nvp("time_running_ns", _v.running));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->setNextName("regions");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data)
+        {
+            const auto& _v      = itr.second;
+            auto        _values = std::vector<uint64_t>(
+                _v.values.begin(), _v.values.begin() + _labels.size());
+            ar->startNode();
+            (*ar)(cereal::make_nvp("region", itr.first),
+                  cereal::make_nvp("count", _v.count),
+                  cereal::make_nvp("threads", _v.nthreads),
+                  cereal::make_nvp("values", _values));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("perf_counters", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening perf_counters output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "perf_counters" });
+    ofs << oss.str() << "\n";
+}
+
+}  // namespace
+
+std::vector<std::string>
+get_events()
+{
+    return tim::delimit(config::get_perf_events(), " ,;\t\n");
+}
+
+bool
+setup()
+{
+    if(get_local_counters()) return get_local_counters()->active;
+
+    auto _events = get_events();
+    if(_events.empty()) return false;
+
+    auto& _v = get_thread_counters();
+    if(!_v) _v = std::make_unique<thread_counters>();
+
+    for(const auto& itr : _events)
+    {
+        if(_v->size == max_events)
+        {
+            OMNITRACE_VERBOSE(0, "[perf_counters] ignoring '%s' :: at most %zu counters "
+                                 "are supported\n",
+                              itr.c_str(), max_events);
+            continue;
+        }
+
+        struct perf_event_attr _pe;
+        memset(&_pe, 0, sizeof(_pe));
+        try
+        {
+            perf::config_event(_pe, itr);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_VERBOSE(0, "[perf_counters] unsupported event '%s' :: %s\n",
+                              itr.c_str(), _e.what());
+            continue;
+        }
+        _pe.exclude_kernel = 1;
+        _pe.exclude_hv     = 1;
+
+        auto& _event = _v->events.at(_v->size);
+        if(auto _err = _event.open(_pe))
+        {
+            OMNITRACE_VERBOSE(1, "[perf_counters] failed to open '%s' :: %s\n",
+                              itr.c_str(), _err->c_str());
+            continue;
+        }
+
+        // the sampling and the regions only warn once when rdpmc is not permitted
+        static auto _once = std::atomic_flag{ ATOMIC_FLAG_INIT };
+        if(!_event.has_user_read() && !_once.test_and_set())
+        {
+            OMNITRACE_VERBOSE(0, "[perf_counters] rdpmc is not available for '%s'. The "
+                                 "counters are read with a syscall\n",
+                              itr.c_str());
+        }
+
+        _v->labels.at(_v->size++) = itr;
+    }
+
+    auto _group_size = config::get_perf_events_group_size();
+    auto _interval   = config::get_perf_events_rotation_interval() * units::msec;
+
+    _v->group_size = (_group_size > 0) ? std::min(_group_size, max_events) : max_events;
+    _v->interval   = static_cast<uint64_t>(std::max(_interval, 0.0));
+    _v->opened     = get_clock_now();
+    _v->rotated    = _v->opened;
+    _v->updated    = _v->opened;
+    for(size_t i = _v->group_begin(); i < _v->group_end(); ++i)
+        _v->events[i].start();
+
+    _v->active           = (_v->size > 0);
+    get_local_counters() = _v.get();
+    return _v->active;
+}
+
+void
+shutdown()
+{
+    auto* _v = get_local_counters();
+    if(!_v || !_v->active) return;
+
+    update(*_v, get_clock_now());
+    _v->active = false;
+    for(size_t i = 0; i < _v->size; ++i)
+        _v->events.at(i).close();
+}
+
+bool
+is_active()
+{
+    const auto* _v = get_local_counters();
+    return (_v && _v->active);
+}
+
+std::vector<std::string>
+get_labels(int64_t _tid)
+{
+    const auto& _v = get_thread_counters(_tid);
+    if(!_v) return std::vector<std::string>{};
+    return std::vector<std::string>(_v->labels.begin(), _v->labels.begin() + _v->size);
+}
+
+size_t
+read(values_t& _values)
+{
+    auto* _v = get_local_counters();
+    if(!_v || !_v->active) return 0;
+
+    // when a sample interrupts a read on the same thread, the sample uses the counts
+    // of the previous read
+    if(!_v->busy)
+    {
+        _v->busy = true;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+
+        auto _now = get_clock_now();
+        if(_v->num_groups() > 1 && _now - _v->rotated >= _v->interval)
+            rotate(*_v, _now);
+        else
+            update(*_v, _now);
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        _v->busy = false;
+    }
+
+    for(size_t i = 0; i < _v->size; ++i)
+        _values[i] = _v->get_estimate(i);
+    return _v->size;
+}
+
+void
+push_region()
+{
+    if(!config::get_snapshot().perf_events_regions) return;
+
+    if(!get_local_counters() && !setup()) return;
+
+    auto* _v = get_local_counters();
+    if(!_v->active) return;
+
+    auto& _values = _v->stack.emplace_back();
+    read(_values);
+}
+
+void
+pop_region(std::string_view _name)
+{
+    auto* _v = get_local_counters();
+    if(!_v || _v->stack.empty()) return;
+
+    auto _values = values_t{};
+    read(_values);
+
+    const auto& _beg   = _v->stack.back();
+    auto&       _entry = _v->regions[std::hash<std::string_view>{}(_name)];
+    if(_entry.name.empty()) _entry.name = std::string{ _name };
+    _entry.count += 1;
+    for(size_t i = 0; i < _v->size; ++i)
+        _entry.values[i] += _values[i] - _beg[i];
+    _v->stack.pop_back();
+}
+
+void
+post_process()
+{
+    auto _labels = std::vector<std::string>{};
+    auto _events = std::vector<event_summary>{};
+    auto _data   = merged_data{};
+
+    if(thread_counters_data::get())
+    {
+        for(const auto& titr : *thread_counters_data::get())
+        {
+            if(!titr || titr->size == 0) continue;
+            if(_labels.empty())
+            {
+                _labels.assign(titr->labels.begin(), titr->labels.begin() + titr->size);
+                _events.resize(_labels.size());
+            }
+
+            for(size_t i = 0; i < std::min(titr->size, _events.size()); ++i)
+            {
+                auto& _v = _events.at(i);
+                _v.count += titr->counts[i];
+                _v.estimate += titr->get_estimate(i);
+                _v.running += titr->running[i];
+                _v.elapsed += (titr->updated - titr->opened);
+            }
+
+            for(const auto& itr : titr->regions)
+            {
+                auto& _v = _data[itr.second.name];
+                _v.count += itr.second.count;
+                _v.nthreads += 1;
+                for(size_t i = 0; i < max_events; ++i)
+                    _v.values[i] += itr.second.values[i];
+            }
+        }
+    }
+
+    if(_labels.empty())
+    {
+        OMNITRACE_VERBOSE_F(1, "No perf counters were opened\n");
+        return;
+    }
+
+    if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+        write_text(_labels, _events, _data);
+
+    if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+        write_json(_labels, _events, _data);
+}
+}  // namespace perf_counters
+}  // namespace omnitrace
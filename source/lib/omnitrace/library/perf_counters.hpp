@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace omnitrace
+{
+/// hardware counters of OMNITRACE_PERF_EVENTS. Every thread opens a counting
+/// perf_event per counter and reads it from user-space with the rdpmc instruction
+/// (see perf::perf_event::read_count) so a read costs tens of nanoseconds instead of
+/// the syscall of PAPI. The counters are the thread hardware counters of the samples
+/// and, with OMNITRACE_PERF_EVENTS_REGIONS, are accumulated per region.
+///
+/// More events than the hardware can count at once are partitioned into groups which
+/// take turns counting (OMNITRACE_PERF_EVENTS_GROUP_SIZE). The groups are rotated by
+/// the reads once OMNITRACE_PERF_EVENTS_ROTATION_INTERVAL has elapsed and the values
+/// are estimates: the counts scaled by the time since the counters were opened over
+/// the time which the event was counting
+namespace perf_counters
+{
+/// the maximum number of counters per thread
+static constexpr size_t max_events = 32;
+
+using values_t = std::array<uint64_t, max_events>;
+
+/// the events of OMNITRACE_PERF_EVENTS
+std::vector<std::string>
+get_events();
+
+/// opens and starts the counters of the calling thread. Returns true if at least one
+/// counter was opened (or the counters were already opened)
+bool
+setup();
+
+/// stops and closes the counters of the calling thread. The region totals are kept
+void
+shutdown();
+
+/// check if the counters of the calling thread are open
+bool
+is_active();
+
+/// the names of the counters which were opened on the thread
+std::vector<std::string>
+get_labels(int64_t _tid);
+
+/// reads the estimates of the counters of the calling thread and returns the number
+/// of values. Rotates the groups when the interval has elapsed. Safe to invoke from a
+/// signal handler: it neither locks nor allocates
+size_t
+read(values_t&);
+
+/// records the counters at the start of a region on the calling thread. Opens the
+/// counters of the thread the first time when OMNITRACE_PERF_EVENTS_REGIONS is enabled
+void
+push_region();
+
+/// adds the counts since the matching push_region to the totals of the region
+void
+pop_region(std::string_view _name);
+
+/// merges the totals of the events and of the regions of all the threads and writes
+/// perf_counters.{txt,json}
+void
+post_process();
+}  // namespace perf_counters
+}  // namespace omnitrace
@@ -24,9 +24,19 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "library/cpu_freq.hpp"
+#include "library/energy.hpp"
+#include "library/gpu_attribution.hpp"
+#include "library/housekeeping.hpp"
+#include "library/live_export.hpp"
+#include "library/memory_bandwidth.hpp"
+#include "library/memory_footprint.hpp"
+#include "library/mpi_pvars.hpp"
 #include "library/rocm_smi.hpp"
+#include "library/rocprofiler.hpp"
 #include "library/runtime.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <vector>
 
@@ -74,6 +84,7 @@ sampler::poll(std::atomic<State>* _state, nsec_t _interval, promise_t* _ready)
 {
     threading::offset_this_id(true);
     threading::set_thread_name("omni.sampler");
+    housekeeping::configure_thread();
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
@@ -140,6 +151,49 @@ sampler::setup()
     // shutdown if already running
     shutdown();
 
+    // before rocm-smi so the last energy sample of the GPUs precedes its shutdown
+    if(config::get_energy())
+    {
+        auto& _energy         = instances.emplace_back(std::make_unique<instance>());
+        _energy->setup        = []() { energy::setup(); };
+        _energy->shutdown     = []() { energy::shutdown(); };
+        _energy->post_process = []() { energy::post_process(); };
+        _energy->config       = []() { energy::config(); };
+        _energy->sample       = []() { energy::sample(); };
+    }
+
+    // the attribution is post-processed with the other cross-rank reductions
+    if(config::get_gpu_attribution())
+    {
+        auto& _gpu_attr         = instances.emplace_back(std::make_unique<instance>());
+        _gpu_attr->setup        = []() { gpu_attribution::setup(); };
+        _gpu_attr->shutdown     = []() { gpu_attribution::shutdown(); };
+        _gpu_attr->post_process = []() {};
+        _gpu_attr->config       = []() { gpu_attribution::config(); };
+        _gpu_attr->sample       = []() { gpu_attribution::sample(); };
+    }
+
+    if(config::get_memory_bandwidth())
+    {
+        auto& _bandwidth         = instances.emplace_back(std::make_unique<instance>());
+        _bandwidth->setup        = []() { memory_bandwidth::setup(); };
+        _bandwidth->shutdown     = []() { memory_bandwidth::shutdown(); };
+        _bandwidth->post_process = []() { memory_bandwidth::post_process(); };
+        _bandwidth->config       = []() { memory_bandwidth::config(); };
+        _bandwidth->sample       = []() { memory_bandwidth::sample(); };
+    }
+
+    // the MPI_T session is opened once MPI_Init returns
+    if(config::get_snapshot().mpi_pvars)
+    {
+        auto& _pvars         = instances.emplace_back(std::make_unique<instance>());
+        _pvars->setup        = []() { mpi_pvars::setup(); };
+        _pvars->shutdown     = []() { mpi_pvars::shutdown(); };
+        _pvars->post_process = []() { mpi_pvars::post_process(); };
+        _pvars->config       = []() { mpi_pvars::config(); };
+        _pvars->sample       = []() { mpi_pvars::sample(); };
+    }
+
     if(get_use_rocm_smi())
     {
         auto& _rocm_smi         = instances.emplace_back(std::make_unique<instance>());
@@ -150,6 +204,27 @@ sampler::setup()
         _rocm_smi->sample       = []() { rocm_smi::sample(); };
     }
 
+    if(rocprofiler::device_sampling::is_enabled())
+    {
+        auto& _rocprof         = instances.emplace_back(std::make_unique<instance>());
+        _rocprof->setup        = []() { rocprofiler::device_sampling::setup(); };
+        _rocprof->shutdown     = []() { rocprofiler::device_sampling::shutdown(); };
+        _rocprof->post_process = []() { rocprofiler::device_sampling::post_process(); };
+        _rocprof->config       = []() { rocprofiler::device_sampling::config(); };
+        _rocprof->sample       = []() { rocprofiler::device_sampling::sample(); };
+    }
+
+    // after rocm-smi so the GPU metrics of an update are from the same pass
+    if(config::get_live_export())
+    {
+        auto& _live         = instances.emplace_back(std::make_unique<instance>());
+        _live->setup        = []() { live_export::setup(); };
+        _live->shutdown     = []() { live_export::shutdown(); };
+        _live->post_process = []() { live_export::post_process(); };
+        _live->config       = []() { live_export::config(); };
+        _live->sample       = []() { live_export::sample(); };
+    }
+
     auto& _cpu_freq         = instances.emplace_back(std::make_unique<instance>());
     _cpu_freq->setup        = []() { cpu_freq::setup(); };
     _cpu_freq->shutdown     = []() { cpu_freq::shutdown(); };
@@ -157,6 +232,17 @@ sampler::setup()
     _cpu_freq->config       = []() { cpu_freq::config(); };
     _cpu_freq->sample       = []() { cpu_freq::sample(); };
 
+    // last so the footprint of the other process samplers is from the same pass
+    if(config::get_snapshot().memory_footprint)
+    {
+        auto& _footprint         = instances.emplace_back(std::make_unique<instance>());
+        _footprint->setup        = []() { memory_footprint::setup(); };
+        _footprint->shutdown     = []() { memory_footprint::shutdown(); };
+        _footprint->post_process = []() { memory_footprint::post_process(); };
+        _footprint->config       = []() { memory_footprint::config(); };
+        _footprint->sample       = []() { memory_footprint::sample(); };
+    }
+
     for(auto& itr : instances)
         itr->setup();
 
@@ -237,5 +323,15 @@ sampler::set_state(state_t _state)
 {
     get_sampler_state().store(_state);
 }
+
+size_t
+get_retention_capacity()
+{
+    auto _retention = config::get_process_sampling_retention();
+    if(_retention <= 0.0 && config::get_use_flight_recorder())
+        _retention = config::get_flight_recorder_window();
+    if(_retention <= 0.0) return 0;
+    return std::max<size_t>(std::ceil(_retention * get_process_sampling_freq()), 1);
+}
 }  // namespace process_sampler
 }  // namespace omnitrace
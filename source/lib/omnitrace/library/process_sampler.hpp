@@ -81,6 +81,11 @@ sampler::poll(std::atomic<state_t>* _state, Tp&& _interval, promise_t* _prom)
     poll(_state, std::chrono::duration_cast<nsec_t>(_interval), _prom);
 }
 //
+/// number of samples each process-level sampler retains in memory based on
+/// OMNITRACE_PROCESS_SAMPLING_RETENTION. Zero means the samples are not bounded
+size_t
+get_retention_capacity();
+//
 inline void
 setup()
 {
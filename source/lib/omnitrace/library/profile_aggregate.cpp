@@ -0,0 +1,405 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/profile_aggregate.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/mpi_reduce.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/hash.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/type_list.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace profile_aggregate
+{
+namespace
+{
+template <typename... Tp>
+using type_list = tim::type_list<Tp...>;
+
+// timemory components with a scalar value which can be aggregated
+using component_types_t =
+    type_list<comp::wall_clock, comp::cpu_clock, comp::cpu_util, comp::user_clock,
+              comp::system_clock, comp::thread_cpu_clock, comp::process_cpu_clock,
+              comp::peak_rss, comp::page_rss>;
+
+// separates the names of the call-path. It sorts before every printable character so
+// the call-paths sorted by name are in depth-first order
+constexpr char path_delim = '\x1f';
+
+struct stats
+{
+    uint64_t ranks    = 0;
+    uint64_t laps     = 0;
+    double   min      = std::numeric_limits<double>::max();
+    double   max      = std::numeric_limits<double>::lowest();
+    int32_t  min_rank = -1;
+    int32_t  max_rank = -1;
+    double   sum      = 0.0;
+    double   sumsq    = 0.0;
+
+    stats& operator+=(const stats& _rhs)
+    {
+        if(_rhs.ranks == 0) return *this;
+        if(_rhs.min < min || (_rhs.min == min && _rhs.min_rank < min_rank))
+        {
+            min      = _rhs.min;
+            min_rank = _rhs.min_rank;
+        }
+        if(_rhs.max > max || (_rhs.max == max && _rhs.max_rank < max_rank))
+        {
+            max      = _rhs.max;
+            max_rank = _rhs.max_rank;
+        }
+        ranks += _rhs.ranks;
+        laps += _rhs.laps;
+        sum += _rhs.sum;
+        sumsq += _rhs.sumsq;
+        return *this;
+    }
+
+    double mean() const { return (ranks > 0) ? (sum / ranks) : 0.0; }
+
+    double stddev() const
+    {
+        if(ranks < 2) return 0.0;
+        auto _mean = mean();
+        return std::sqrt(std::max(sumsq / ranks - _mean * _mean, 0.0));
+    }
+};
+
+struct metric
+{
+    std::string                  unit    = {};
+    std::map<std::string, stats> entries = {};  // keyed by call-path
+
+    metric& operator+=(const metric& _rhs)
+    {
+        if(unit.empty()) unit = _rhs.unit;
+        for(const auto& itr : _rhs.entries)
+            entries[itr.first] += itr.second;
+        return *this;
+    }
+};
+
+// keyed by the label of the component
+using aggregate_data = std::map<std::string, metric>;
+
+std::vector<std::string>
+split_path(const std::string& _path)
+{
+    auto _v    = std::vector<std::string>{};
+    auto _ss   = std::istringstream{ _path };
+    auto _name = std::string{};
+    while(std::getline(_ss, _name, path_delim))
+        _v.emplace_back(_name);
+    return _v;
+}
+
+template <typename Tp>
+void
+collect(aggregate_data& _data, int32_t _rank)
+{
+    auto* _storage = tim::storage<Tp>::noninit_master_instance();
+    if(!_storage) return;
+
+    _storage->merge();
+    if(_storage->empty()) return;
+
+    // the value of a call-path on this rank is the sum over the threads
+    auto _values = std::map<std::string, std::pair<double, uint64_t>>{};
+    auto _stack  = std::vector<std::string>{};
+    for(const auto& itr : _storage->get())
+    {
+        auto _name = std::string{ tim::get_hash_identifier_fast(itr.hash()) };
+        std::replace_if(
+            _name.begin(), _name.end(),
+            [](char _c) { return _c == '\t' || _c == '\n' || _c == path_delim; }, ' ');
+
+        _stack.resize(std::max<int64_t>(itr.depth(), 0));
+        _stack.emplace_back(std::move(_name));
+
+        auto _path = std::string{};
+        for(const auto& sitr : _stack)
+            _path += (_path.empty()) ? sitr : (path_delim + sitr);
+
+        auto& _v = _values[_path];
+        _v.first += itr.data().get();
+        _v.second += itr.data().get_laps();
+    }
+
+    // the aggregate replaces the per-rank output of timemory
+    _storage->reset();
+
+    auto& _metric = _data[Tp::get_label()];
+    _metric.unit  = Tp::get_display_unit();
+    for(const auto& itr : _values)
+    {
+        auto _v     = stats{};
+        _v.ranks    = 1;
+        _v.laps     = itr.second.second;
+        _v.min      = itr.second.first;
+        _v.max      = itr.second.first;
+        _v.min_rank = _rank;
+        _v.max_rank = _rank;
+        _v.sum      = itr.second.first;
+        _v.sumsq    = itr.second.first * itr.second.first;
+        _metric.entries[itr.first] += _v;
+    }
+}
+
+template <typename... Tp>
+void
+collect(aggregate_data& _data, int32_t _rank, type_list<Tp...>)
+{
+    (collect<Tp>(_data, _rank), ...);
+}
+
+// one line per metric and per entry with tab-separated fields
+mpi_reduce::buffer_t
+serialize(const aggregate_data& _data)
+{
+    auto _ss = std::stringstream{};
+    _ss << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for(const auto& mitr : _data)
+    {
+        _ss << "M\t" << mitr.first << '\t' << mitr.second.unit << '\n';
+        for(const auto& itr : mitr.second.entries)
+        {
+            const auto& _v = itr.second;
+            _ss << "E\t" << mitr.first << '\t' << itr.first << '\t' << _v.ranks << '\t'
+                << _v.laps << '\t' << _v.min << '\t' << _v.min_rank << '\t' << _v.max
+                << '\t' << _v.max_rank << '\t' << _v.sum << '\t' << _v.sumsq << '\n';
+        }
+    }
+    auto _str = _ss.str();
+    return mpi_reduce::buffer_t{ _str.begin(), _str.end() };
+}
+
+aggregate_data
+deserialize(const mpi_reduce::buffer_t& _data)
+{
+    auto _v    = aggregate_data{};
+    auto _ss   = std::istringstream{ std::string{ _data.begin(), _data.end() } };
+    auto _line = std::string{};
+    while(std::getline(_ss, _line))
+    {
+        auto _fields = std::vector<std::string>{};
+        auto _ls     = std::istringstream{ _line };
+        auto _field  = std::string{};
+        while(std::getline(_ls, _field, '\t'))
+            _fields.emplace_back(_field);
+
+        if((_fields.size() == 2 || _fields.size() == 3) && _fields.at(0) == "M")
+        {
+            // the unit field is missing for unitless metrics
+            auto& _metric = _v[_fields.at(1)];
+            if(_fields.size() == 3) _metric.unit = _fields.at(2);
+        }
+        else if(_fields.size() == 11 && _fields.at(0) == "E")
+        {
+            auto _e     = stats{};
+            _e.ranks    = std::stoull(_fields.at(3));
+            _e.laps     = std::stoull(_fields.at(4));
+            _e.min      = std::stod(_fields.at(5));
+            _e.min_rank = std::stoi(_fields.at(6));
+            _e.max      = std::stod(_fields.at(7));
+            _e.max_rank = std::stoi(_fields.at(8));
+            _e.sum      = std::stod(_fields.at(9));
+            _e.sumsq    = std::stod(_fields.at(10));
+            _v[_fields.at(1)].entries[_fields.at(2)] += _e;
+        }
+        else
+        {
+            OMNITRACE_CI_THROW(true, "Invalid profile_aggregate entry: '%s'\n",
+                               _line.c_str());
+        }
+    }
+    return _v;
+}
+
+void
+write_text(const std::string& _label, const metric& _data, int32_t _nranks)
+{
+    auto _fname =
+        tim::settings::compose_output_filename(JOIN("-", _label, "aggregate"), ".txt");
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening profile_aggregate output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<stats>{}(_fname, std::string{ _label });
+
+    auto   _names = std::vector<std::string>{};
+    size_t _width = 0;
+    for(const auto& itr : _data.entries)
+    {
+        auto _path = split_path(itr.first);
+        auto _name = std::string(2 * (_path.size() - 1), ' ') + "|_" + _path.back();
+        _width     = std::max(_width, _name.length());
+        _names.emplace_back(std::move(_name));
+    }
+
+    ofs << _label << " aggregated across " << _nranks << " ranks";
+    if(!_data.unit.empty()) ofs << " [" << _data.unit << "]";
+    ofs << "\n\n";
+    ofs << std::setw(_width) << std::left << "LABEL" << std::right << " | "
+        << std::setw(8) << "RANKS" << " | " << std::setw(12) << "LAPS" << " | "
+        << std::setw(12) << "MIN" << " | " << std::setw(8) << "MIN RANK" << " | "
+        << std::setw(12) << "MAX" << " | " << std::setw(8) << "MAX RANK" << " | "
+        << std::setw(12) << "MEAN" << " | " << std::setw(12) << "STDDEV" << "\n";
+
+    ofs << std::setprecision(6);
+    size_t _n = 0;
+    for(const auto& itr : _data.entries)
+    {
+        const auto& _v = itr.second;
+        ofs << std::setw(_width) << std::left << _names.at(_n++) << std::right << " | "
+            << std::setw(8) << _v.ranks << " | " << std::setw(12) << _v.laps << " | "
+            << std::setw(12) << _v.min << " | " << std::setw(8) << _v.min_rank << " | "
+            << std::setw(12) << _v.max << " | " << std::setw(8) << _v.max_rank << " | "
+            << std::setw(12) << _v.mean() << " | " << std::setw(12) << _v.stddev()
+            << "\n";
+    }
+}
+
+void
+write_json(const std::string& _label, const metric& _data, int32_t _nranks)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("profile_aggregate");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("metric", _label), cereal::make_nvp("unit", _data.unit),
+              cereal::make_nvp("num_ranks", _nranks));
+
+        ar->setNextName("entries");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data.entries)
+        {
+            const auto& _v    = itr.second;
+            auto        _path = split_path(itr.first);
+            ar->startNode();
+            (*ar)(cereal::make_nvp("name", _path.back()),
+                  cereal::make_nvp("depth", _path.size() - 1),
+                  cereal::make_nvp("call_path", _path),
+                  cereal::make_nvp("ranks", _v.ranks), cereal::make_nvp("laps", _v.laps),
+                  cereal::make_nvp("min", _v.min),
+                  cereal::make_nvp("min_rank", _v.min_rank),
+                  cereal::make_nvp("max", _v.max),
+                  cereal::make_nvp("max_rank", _v.max_rank),
+                  cereal::make_nvp("mean", _v.mean()),
+                  cereal::make_nvp("stddev", _v.stddev()));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname =
+        tim::settings::compose_output_filename(JOIN("-", _label, "aggregate"), ".json");
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening profile_aggregate output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<stats>{}(_fname, std::string{ _label });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+post_process()
+{
+    auto _rank   = static_cast<int32_t>(dmp::rank());
+    auto _nranks = static_cast<int32_t>(std::max<int>(dmp::size(), 1));
+    auto _data   = aggregate_data{};
+
+    collect(_data, _rank, component_types_t{});
+
+    bool _reduced = false;
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    {
+        auto _buffer = serialize(_data);
+        _reduced     = mpi_reduce::hierarchical(
+            _buffer, [](mpi_reduce::buffer_t& _dst, mpi_reduce::buffer_t&& _src) {
+                auto _v = deserialize(_dst);
+                for(const auto& itr : deserialize(_src))
+                    _v[itr.first] += itr.second;
+                _dst = serialize(_v);
+            });
+        if(_reduced) _data = deserialize(_buffer);
+    }
+#endif
+
+    // every rank writes its own files when the data could not be reduced
+    if(_reduced && _rank != 0) return;
+    if(!_reduced) _nranks = 1;
+
+    auto _get_setting = [](const std::string& _v) {
+        auto&& _b = config::get_setting_value<bool>(_v);
+        OMNITRACE_CI_THROW(!_b, "Error! No configuration setting named '%s'", _v.c_str());
+        return _b.value_or(true);
+    };
+
+    for(const auto& itr : _data)
+    {
+        OMNITRACE_VERBOSE(1, "Writing the %s aggregate of %zu call-paths...\n",
+                          itr.first.c_str(), itr.second.entries.size());
+        if(_get_setting("OMNITRACE_TEXT_OUTPUT"))
+            write_text(itr.first, itr.second, _nranks);
+        if(_get_setting("OMNITRACE_JSON_OUTPUT"))
+            write_json(itr.first, itr.second, _nranks);
+    }
+}
+}  // namespace profile_aggregate
+}  // namespace omnitrace
@@ -0,0 +1,40 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+namespace omnitrace
+{
+/// reduces the timemory call-graphs of all the ranks onto rank 0 up a tree (see
+/// OMNITRACE_PROFILE_AGGREGATE) and writes the min, max, mean, and stddev across the
+/// ranks of every call-path so the output volume does not grow with the number of ranks
+namespace profile_aggregate
+{
+/// merges the thread data of each supported timemory component, reduces it across the
+/// ranks, writes <component>-aggregate.{txt,json} on rank 0, and resets the storage so
+/// timemory does not write the per-rank output. Collective over all the ranks and must
+/// be called before tim::timemory_finalize
+void
+post_process();
+}  // namespace profile_aggregate
+}  // namespace omnitrace
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/profile_merge.hpp"
+#include "core/components/fwd.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/ptl.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/trip_count/extern.hpp>
+#include <timemory/mpl/type_traits.hpp>
+#include <timemory/settings.hpp>
+#include <timemory/storage.hpp>
+#include <timemory/utility/type_list.hpp>
+
+#include <string>
+
+namespace omnitrace
+{
+namespace profile_merge
+{
+namespace
+{
+template <typename... Tp>
+using type_list = tim::type_list<Tp...>;
+
+// the components which hold the bulk of the call-graph nodes. The others are merged
+// by timemory_finalize
+using component_types_t =
+    type_list<comp::wall_clock, comp::cpu_clock, comp::cpu_util, comp::user_clock,
+              comp::system_clock, comp::thread_cpu_clock, comp::process_cpu_clock,
+              comp::peak_rss, comp::page_rss, comp::trip_count,
+              component::sampling_wall_clock, component::sampling_cpu_clock,
+              component::sampling_percent, component::sampling_gpu_busy,
+              component::sampling_gpu_memory, component::sampling_gpu_power,
+              component::sampling_gpu_temp>;
+
+template <typename Tp>
+void
+add(tasking::task_graph& _graph)
+{
+    if constexpr(tim::trait::is_available<Tp>::value)
+    {
+        auto* _storage = tim::storage<Tp>::noninit_master_instance();
+        if(!_storage) return;
+
+        _graph.add(Tp::get_label(), [_storage]() { _storage->merge(); });
+    }
+}
+
+template <typename... Tp>
+void
+add(tasking::task_graph& _graph, type_list<Tp...>)
+{
+    (add<Tp>(_graph), ...);
+}
+}  // namespace
+
+void
+post_process()
+{
+    if(!tim::settings::collapse_threads() && !tim::settings::flat_profile()) return;
+
+    // the merges of the components only read the hash ids once all of them are known
+    tracing::copy_timemory_hash_ids();
+
+    auto _graph = tasking::task_graph{};
+    add(_graph, component_types_t{});
+
+    OMNITRACE_VERBOSE_F(1, "Merging the thread data of %zu timemory components...\n",
+                        _graph.size());
+    _graph.execute(config::get_parallel_finalize());
+}
+}  // namespace profile_merge
+}  // namespace omnitrace
@@ -25,6 +25,7 @@
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/state.hpp"
+#include "library/housekeeping.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
@@ -36,6 +37,11 @@
 #include <timemory/backends/threading.hpp>
 #include <timemory/utility/declaration.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+
 namespace omnitrace
 {
 namespace tasking
@@ -76,6 +82,7 @@ auto _thread_pool_cfg = []() {
         thread_info::init(true);
         threading::set_thread_name(
             JOIN('.', "ptl", PTL::Threading::GetThreadId()).c_str());
+        housekeeping::configure_thread();
         set_thread_state(ThreadState::Disabled);
         sampling::block_signals();
     };
@@ -97,8 +104,14 @@ PTL::ThreadPool&
 get_thread_pool()
 {
     static auto  _cfg = _thread_pool_cfg();
-    static auto* _v =
-        (get_thread_pool_state() = State::Active, new PTL::ThreadPool{ _cfg });
+    static auto* _v = []() {
+        // with OMNITRACE_FAST_START, the pool is created by the first task so the
+        // scoped states of setup() are applied here
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        get_thread_pool_state() = State::Active;
+        return new PTL::ThreadPool{ _cfg };
+    }();
     return *_v;
 }
 }  // namespace
@@ -132,8 +145,6 @@ get_thread_pool_state()
 void
 setup()
 {
-    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
     (void) get_thread_pool();
 }
 
@@ -208,6 +219,138 @@ initialize_threadpool(size_t _v)
     return get_thread_pool().initialize_threadpool(_v);
 }
 
+task_graph::task_id
+task_graph::add(std::string _name, functor_t _func, std::vector<task_id> _deps,
+                bool _inline)
+{
+    auto _id = m_tasks.size();
+    auto _v  = task{};
+
+    _v.is_inline = _inline;
+    _v.name      = std::move(_name);
+    _v.func      = std::move(_func);
+    for(auto itr : _deps)
+    {
+        OMNITRACE_REQUIRE(itr < _id)
+            << "task '" << _v.name << "' depends on task " << itr
+            << " which has not been added\n";
+        m_tasks.at(itr).dependents.emplace_back(_id);
+        ++_v.num_deps;
+    }
+
+    m_tasks.emplace_back(std::move(_v));
+    return _id;
+}
+
+void
+task_graph::execute(bool _parallel)
+{
+    const size_t _ntasks = m_tasks.size();
+
+    auto _failed    = std::exception_ptr{};
+    auto _skipped   = std::vector<bool>(_ntasks, false);
+    auto _remaining = std::vector<size_t>(_ntasks, 0);
+
+    auto _run = [this](task_id _id) {
+        auto& _task = m_tasks.at(_id);
+        OMNITRACE_VERBOSE_F(3, "Executing task '%s'...\n", _task.name.c_str());
+        try
+        {
+            if(_task.func) _task.func();
+        } catch(...)
+        {
+            return std::current_exception();
+        }
+        return std::exception_ptr{};
+    };
+
+    // the dependents of a task which failed (or was skipped) are skipped
+    auto _complete = [this, &_failed, &_skipped](task_id _id, std::exception_ptr _err,
+                                                 auto&& _on_ready) {
+        if(_err && !_failed) _failed = _err;
+        for(auto itr : m_tasks.at(_id).dependents)
+        {
+            if(_err || _skipped.at(_id)) _skipped.at(itr) = true;
+            _on_ready(itr);
+        }
+    };
+
+    if(!_parallel || _ntasks < 2 || config::get_thread_pool_size() < 2)
+    {
+        // the insertion order is a valid serial order
+        for(size_t i = 0; i < _ntasks; ++i)
+            _complete(i, (_skipped.at(i)) ? std::exception_ptr{} : _run(i),
+                      [](task_id) {});
+    }
+    else
+    {
+        auto   _mtx      = std::mutex{};
+        auto   _cv       = std::condition_variable{};
+        auto   _ready    = std::deque<task_id>{};
+        size_t _finished = 0;
+        auto   _tg       = PTL::TaskGroup<void>{ &get_thread_pool() };
+
+        // must be called while holding the lock
+        auto _finish = [&](task_id _id, std::exception_ptr _err) {
+            _complete(_id, _err, [&](task_id _dep) {
+                if(--_remaining.at(_dep) == 0) _ready.emplace_back(_dep);
+            });
+            ++_finished;
+            _cv.notify_all();
+        };
+
+        for(size_t i = 0; i < _ntasks; ++i)
+        {
+            _remaining.at(i) = m_tasks.at(i).num_deps;
+            if(_remaining.at(i) == 0) _ready.emplace_back(i);
+        }
+
+        auto _lk = std::unique_lock<std::mutex>{ _mtx };
+        while(true)
+        {
+            _cv.wait(_lk, [&]() { return !_ready.empty() || _finished == _ntasks; });
+            if(_ready.empty()) break;
+
+            // dispatch the thread pool tasks ahead of the inline tasks so that they
+            // overlap with the inline tasks
+            auto itr = std::find_if(_ready.begin(), _ready.end(), [this](task_id _v) {
+                return !m_tasks.at(_v).is_inline;
+            });
+            if(itr == _ready.end()) itr = _ready.begin();
+            auto _id = *itr;
+            _ready.erase(itr);
+
+            if(_skipped.at(_id))
+            {
+                _finish(_id, std::exception_ptr{});
+            }
+            else if(m_tasks.at(_id).is_inline)
+            {
+                _lk.unlock();
+                auto _err = _run(_id);
+                _lk.lock();
+                _finish(_id, _err);
+            }
+            else
+            {
+                _lk.unlock();
+                _tg.exec([&_run, &_finish, &_mtx, _id]() {
+                    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+                    auto _err   = _run(_id);
+                    auto _tg_lk = std::unique_lock<std::mutex>{ _mtx };
+                    _finish(_id, _err);
+                });
+                _lk.lock();
+            }
+        }
+        _lk.unlock();
+        _tg.join();
+    }
+
+    m_tasks.clear();
+    if(_failed) std::rethrow_exception(_failed);
+}
+
 PTL::TaskGroup<void>&
 general::get_task_group(int64_t _tid)
 {
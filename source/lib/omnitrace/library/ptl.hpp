@@ -27,7 +27,11 @@
 
 #include <PTL/PTL.hh>
 
+#include <cstddef>
+#include <functional>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace omnitrace
 {
@@ -44,6 +48,46 @@ shutdown();
 
 size_t initialize_threadpool(size_t);
 
+//--------------------------------------------------------------------------------------//
+//
+//      task graph
+//
+//--------------------------------------------------------------------------------------//
+
+/// a set of tasks with explicit dependencies. When executed in parallel, each task
+/// starts as soon as all of its dependencies have completed. Tasks which are not
+/// "inline" run on the thread pool and inline tasks (e.g. tasks which themselves use
+/// the thread pool or which touch thread-local data) run on the calling thread.
+/// Dependencies must be added before their dependents so the insertion order is a
+/// valid serial order
+struct task_graph
+{
+    using task_id   = size_t;
+    using functor_t = std::function<void()>;
+
+    task_id add(std::string _name, functor_t _func, std::vector<task_id> _deps = {},
+                bool _inline = false);
+
+    /// executes every task. Rethrows the first exception thrown by a task after
+    /// all the tasks which do not depend on the failed task have completed
+    void execute(bool _parallel);
+
+    size_t size() const { return m_tasks.size(); }
+    bool   empty() const { return m_tasks.empty(); }
+
+private:
+    struct task
+    {
+        bool                 is_inline  = false;
+        std::string          name       = {};
+        functor_t            func       = {};
+        std::vector<task_id> dependents = {};
+        size_t               num_deps   = 0;
+    };
+
+    std::vector<task> m_tasks = {};
+};
+
 //--------------------------------------------------------------------------------------//
 //
 //      general
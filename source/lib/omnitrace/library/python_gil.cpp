@@ -0,0 +1,430 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/python_gil.hpp"
+#include "core/categories.hpp"
+#include "core/common.hpp"
+#include "core/components/fwd.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/self_profile.hpp"
+#include "core/timemory.hpp"
+#include "library/python_sampling.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/trip_count/components.hpp>
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace python_gil
+{
+namespace
+{
+// the number of code objects per thread
+constexpr size_t thread_capacity = 256;
+
+// the interval of the wait and hold time in the counter tracks
+constexpr uint64_t gil_interval = 10 * units::msec;
+
+struct entry
+{
+    uint64_t acquisitions = 0;
+    uint64_t samples      = 0;  // timer samples waiting in the interpreter
+    uint64_t wait         = 0;  // nanoseconds, intercepted acquisitions
+    uint64_t sampled_wait = 0;  // nanoseconds, timer samples
+    uint64_t hold         = 0;  // nanoseconds
+};
+
+struct interval_entry
+{
+    uint64_t interval = 0;  // index of the interval
+    uint64_t wait     = 0;
+    uint64_t hold     = 0;
+};
+
+// open-addressing table with linear probing. A slot is empty until it is used and the
+// slots are never removed so only the owning thread writes to it, except for the
+// sampled waits which are added after the wrappers stopped recording
+struct thread_table
+{
+    struct slot
+    {
+        bool        used = false;
+        const void* code = nullptr;
+        entry       data = {};
+    };
+
+    std::array<slot, thread_capacity> slots      = {};
+    entry                             overflow   = {};
+    entry*                            holder     = nullptr;  // entry of the held GIL
+    uint64_t                          hold_begin = 0;
+    std::vector<interval_entry>       intervals  = {};
+    std::vector<interval_entry>       sampled    = {};
+};
+
+using thread_table_data = omnitrace::thread_data<thread_table, thread_table>;
+
+auto&
+get_thread_table(int64_t _tid = tim::threading::get_id())
+{
+    return thread_table_data::instance(construct_on_thread{ _tid });
+}
+
+entry*
+get_entry(thread_table& _v, const void* _code)
+{
+    auto _hash = reinterpret_cast<uintptr_t>(_code) * 0x9e3779b97f4a7c15ULL;
+    auto _idx  = static_cast<size_t>(_hash >> 40) % thread_capacity;
+    for(size_t i = 0; i < thread_capacity; ++i)
+    {
+        auto& _slot = _v.slots[(_idx + i) % thread_capacity];
+        if(!_slot.used)
+        {
+            _slot.used = true;
+            _slot.code = _code;
+        }
+        if(_slot.code == _code) return &_slot.data;
+    }
+    return &_v.overflow;
+}
+
+// splits the time between the timestamps at the boundaries of the intervals
+void
+add_intervals(std::vector<interval_entry>& _v, uint64_t _beg, uint64_t _end,
+              uint64_t interval_entry::*_field)
+{
+    while(_beg < _end)
+    {
+        auto _idx  = _beg / gil_interval;
+        auto _next = std::min(_end, (_idx + 1) * gil_interval);
+        if(_v.empty() || _v.back().interval != _idx)
+            _v.emplace_back(interval_entry{ _idx, 0, 0 });
+        _v.back().*_field += (_next - _beg);
+        _beg = _next;
+    }
+}
+
+bool
+is_take_gil(std::string_view _name)
+{
+    // the static function may have a suffix, e.g. take_gil.lto_priv.0
+    return _name.find("take_gil") == 0;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+auto post_process_once = std::once_flag{};
+
+struct thread_summary
+{
+    int64_t                                    tid       = 0;
+    std::vector<std::pair<const void*, entry>> entries   = {};
+    std::map<uint64_t, interval_entry>         intervals = {};
+};
+
+std::vector<thread_summary>
+get_summary(uint64_t _now)
+{
+    auto _data = std::vector<thread_summary>{};
+    if(!thread_table_data::get()) return _data;
+
+    const auto& _instances = *thread_table_data::get();
+    for(size_t i = 0; i < _instances.size(); ++i)
+    {
+        const auto& _v = _instances.at(i);
+        if(!_v) continue;
+
+        // the GIL which is still held is released at finalization
+        if(_v->holder && _now > _v->hold_begin)
+        {
+            _v->holder->hold += (_now - _v->hold_begin);
+            add_intervals(_v->intervals, _v->hold_begin, _now, &interval_entry::hold);
+            _v->holder = nullptr;
+        }
+
+        auto _summary = thread_summary{};
+        _summary.tid  = static_cast<int64_t>(i);
+        for(const auto& itr : _v->slots)
+        {
+            if(itr.used) _summary.entries.emplace_back(itr.code, itr.data);
+        }
+        if(_v->overflow.acquisitions > 0 || _v->overflow.samples > 0)
+            _summary.entries.emplace_back(nullptr, _v->overflow);
+
+        for(const auto* itr : { &_v->intervals, &_v->sampled })
+        {
+            for(const auto& iitr : *itr)
+            {
+                auto& _interval    = _summary.intervals[iitr.interval];
+                _interval.interval = iitr.interval;
+                _interval.wait += iitr.wait;
+                _interval.hold += iitr.hold;
+            }
+        }
+
+        if(!_summary.entries.empty()) _data.emplace_back(std::move(_summary));
+    }
+    return _data;
+}
+
+// the code objects are resolved once. Without a Python frame, e.g. a native thread
+// calling PyGILState_Ensure or a sample without the Python call-stack, the time is
+// unattributed
+std::string
+get_name(std::unordered_map<const void*, std::string>& _names, const void* _code)
+{
+    auto itr = _names.find(_code);
+    if(itr != _names.end()) return itr->second;
+
+    auto _name = std::string{ "[unattributed]" };
+    if(_code)
+    {
+        auto _v = python_sampling::resolve_code(_code);
+        _name   = (_v) ? JOIN("", _v->name, " [", _v->location, "]") : "[unknown]";
+    }
+    return _names.emplace(_code, std::move(_name)).first->second;
+}
+
+void
+write_timemory(const std::vector<thread_summary>& _data)
+{
+    using bundle_t =
+        tim::lightweight_tuple<comp::trip_count, component::python_gil_wait_tracker_t,
+                               component::python_gil_hold_tracker_t,
+                               quirk::config<quirk::flat_scope>>;
+
+    if(!get_use_timemory()) return;
+
+    auto _names = std::unordered_map<const void*, std::string>{};
+    for(const auto& titr : _data)
+    {
+        for(const auto& itr : titr.entries)
+        {
+            const auto& _v     = itr.second;
+            auto        _count = static_cast<int64_t>(_v.acquisitions + _v.samples);
+            auto        _wait  = static_cast<double>(_v.wait + _v.sampled_wait);
+            auto        _hold  = static_cast<double>(_v.hold);
+
+            auto _bundle = bundle_t{ tim::string_view_t{ get_name(_names, itr.first) } };
+            _bundle.push(titr.tid);
+            _bundle.start();
+            _bundle.stop();
+
+            if(auto* _tc = _bundle.get<comp::trip_count>())
+            {
+                _tc->set_value(_count);
+                _tc->set_accum(_count);
+                _tc->set_laps(_count);
+            }
+
+            if(auto* _wt = _bundle.get<component::python_gil_wait_tracker_t>())
+            {
+                _wait /= component::python_gil_wait_tracker_t::get_unit();
+                _wt->set_value(_wait);
+                _wt->set_accum(_wait);
+                _wt->set_laps(_count);
+            }
+
+            if(auto* _ht = _bundle.get<component::python_gil_hold_tracker_t>())
+            {
+                _hold /= component::python_gil_hold_tracker_t::get_unit();
+                _ht->set_value(_hold);
+                _ht->set_accum(_hold);
+                _ht->set_laps(static_cast<int64_t>(_v.acquisitions));
+            }
+            _bundle.pop();
+        }
+    }
+}
+
+void
+write_perfetto(const std::vector<thread_summary>& _data)
+{
+    using track = perfetto_counter_track<category::python>;
+
+    if(!get_use_perfetto()) return;
+
+    // the percentage of each interval the thread waited for and held the GIL. The
+    // intervals without any wait or hold are zero
+    const auto* _category = trait::name<category::python>::value;
+    const auto  _interval = static_cast<double>(gil_interval);
+    for(const auto& titr : _data)
+    {
+        if(titr.intervals.empty()) continue;
+
+        auto _idx = static_cast<size_t>(titr.tid);
+        if(!track::exists(_idx))
+        {
+            auto _tid_name = JOIN("", '[', titr.tid, ']');
+            track::emplace(_idx, JOIN(' ', "Python GIL Wait", _tid_name), "%");
+            track::emplace(_idx, JOIN(' ', "Python GIL Hold", _tid_name), "%");
+        }
+
+        auto _prev = std::optional<uint64_t>{};
+        for(const auto& itr : titr.intervals)
+        {
+            if(_prev && *_prev + 1 < itr.first)
+            {
+                auto _ts = (*_prev + 1) * gil_interval;
+                TRACE_COUNTER(_category, track::at(_idx, 0), _ts, 0.0);
+                TRACE_COUNTER(_category, track::at(_idx, 1), _ts, 0.0);
+            }
+            auto _ts = itr.first * gil_interval;
+            TRACE_COUNTER(_category, track::at(_idx, 0), _ts,
+                          100.0 * itr.second.wait / _interval);
+            TRACE_COUNTER(_category, track::at(_idx, 1), _ts,
+                          100.0 * itr.second.hold / _interval);
+            _prev = itr.first;
+        }
+
+        auto _ts = (*_prev + 1) * gil_interval;
+        TRACE_COUNTER(_category, track::at(_idx, 0), _ts, 0.0);
+        TRACE_COUNTER(_category, track::at(_idx, 1), _ts, 0.0);
+    }
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return config::get_python_gil() && get_active().load();
+}
+
+void
+record_acquire(uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+
+    auto& _v = get_thread_table();
+    if(!_v) _v = std::make_unique<thread_table>();
+
+    // the GIL is held so the frames of the thread are consistent
+    auto* _data = get_entry(*_v, python_sampling::get_current_code());
+    auto  _wait = (_end_ns > _beg_ns) ? (_end_ns - _beg_ns) : uint64_t{ 0 };
+
+    _data->acquisitions += 1;
+    _data->wait += _wait;
+    add_intervals(_v->intervals, _beg_ns, _end_ns, &interval_entry::wait);
+
+    _v->holder     = _data;
+    _v->hold_begin = _end_ns;
+}
+
+void
+record_release(uint64_t _ts_ns)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _v = get_thread_table();
+    if(!_v || !_v->holder) return;
+
+    OMNITRACE_SELF_PROFILE_SCOPE(gotcha);
+
+    if(_ts_ns > _v->hold_begin)
+    {
+        _v->holder->hold += (_ts_ns - _v->hold_begin);
+        add_intervals(_v->intervals, _v->hold_begin, _ts_ns, &interval_entry::hold);
+    }
+    _v->holder = nullptr;
+}
+
+void
+record_sample(int64_t _tid, uint64_t _beg_ns, uint64_t _end_ns,
+              const std::vector<entry_type>& _stack)
+{
+    if(!config::get_python_gil() || _end_ns <= _beg_ns) return;
+
+    // the waits in the wrappers were recorded when they were intercepted
+    bool _waiting = false;
+    for(const auto& itr : _stack)
+    {
+        auto _name = std::string_view{ itr.name };
+        if(_name.find("python_gil_gotcha") != std::string_view::npos) return;
+        _waiting = _waiting || is_take_gil(_name);
+    }
+    if(!_waiting) return;
+
+    auto& _v = get_thread_table(_tid);
+    if(!_v) _v = std::make_unique<thread_table>();
+
+    auto* _data = get_entry(*_v, python_sampling::get_code(_tid, _end_ns));
+    _data->samples += 1;
+    _data->sampled_wait += (_end_ns - _beg_ns);
+    add_intervals(_v->sampled, _beg_ns, _end_ns, &interval_entry::wait);
+}
+
+void
+post_process()
+{
+    if(!config::get_python_gil()) return;
+
+    std::call_once(post_process_once, []() {
+        // resolving the code objects acquires the GIL
+        get_active().store(false);
+
+        try
+        {
+            auto _data = get_summary(tracing::now());
+            if(_data.empty())
+            {
+                OMNITRACE_VERBOSE_F(1, "No acquisition of the Python GIL was recorded\n");
+                return;
+            }
+
+            write_timemory(_data);
+            write_perfetto(_data);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the Python GIL data failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace python_gil
+}  // namespace omnitrace
@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "common/defines.h"
+
+#include <timemory/unwind/processed_entry.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace omnitrace
+{
+/// GIL contention of Python programs (see OMNITRACE_PYTHON_GIL). The python_gil_gotcha
+/// wrappers of the acquisitions and releases through the C API time the wait for the
+/// GIL and the time it is held, which are attributed to the code object of the
+/// innermost Python frame at the acquisition. The acquisitions inside the interpreter
+/// do not go through the wrappers so the samples whose call-stack waits in take_gil
+/// are added as sampled waits. Each thread accumulates the times per code object and
+/// per interval in its own table without any locking. At finalization, the code
+/// objects are resolved and the times are stored in timemory and in counter tracks in
+/// perfetto
+namespace python_gil
+{
+using entry_type = tim::unwind::processed_entry;
+
+/// marks the thread as inside a wrapper so the nested acquisitions, e.g. by
+/// PyGILState_Ensure calling PyEval_RestoreThread, are recorded once. The flag uses the
+/// initial-exec TLS model since the wrappers may be invoked before the TLS of omnitrace
+/// is set up
+struct scoped_guard
+{
+    scoped_guard()
+    : m_nested{ get_flag() }
+    {
+        get_flag() = true;
+    }
+
+    ~scoped_guard() { get_flag() = m_nested; }
+
+    scoped_guard(const scoped_guard&) = delete;
+    scoped_guard& operator=(const scoped_guard&) = delete;
+
+    bool nested() const { return m_nested; }
+
+private:
+    static bool& get_flag()
+    {
+        static thread_local bool _v OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) =
+            false;
+        return _v;
+    }
+
+    bool m_nested = false;
+};
+
+/// check if the GIL is measured, i.e. the wrappers should be installed
+bool
+is_enabled();
+
+/// records an acquisition of the GIL by the calling thread which waited between the
+/// timestamps (see tracing::now()). The GIL is held from _end_ns until record_release
+void
+record_acquire(uint64_t _beg_ns, uint64_t _end_ns);
+
+/// records the release of the GIL by the calling thread
+void
+record_release(uint64_t _ts_ns);
+
+/// adds the time between the timestamps of a timer sample of the thread as a wait if
+/// the native call-stack waits for the GIL outside of the wrappers. The wait is
+/// attributed to the innermost Python frame of the sample when the Python call-stacks
+/// are sampled. Invoked during the post-processing of the samples, concurrently for
+/// distinct threads
+void
+record_sample(int64_t _tid, uint64_t _beg_ns, uint64_t _end_ns,
+              const std::vector<entry_type>& _stack);
+
+/// stops the recording, resolves the code objects and writes the timemory and perfetto
+/// data. Only the first invocation has an effect
+void
+post_process();
+}  // namespace python_gil
+}  // namespace omnitrace
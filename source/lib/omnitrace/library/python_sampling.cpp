@@ -0,0 +1,366 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/python_sampling.hpp"
+#include "api.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace python_sampling
+{
+namespace
+{
+// frames beyond this depth are not recorded
+constexpr size_t max_depth = 256;
+
+struct sample_record
+{
+    uint64_t timestamp = 0;
+    uint32_t offset    = 0;
+    uint32_t size      = 0;
+};
+
+// only the owning thread appends to the buffers, from the signal handler. The frames
+// are stored as the arrays which the unwinder fills so that they are never copied and
+// the pages are only touched when they are used
+struct thread_samples
+{
+    explicit thread_samples(size_t _capacity);
+
+    size_t capacity = 0;
+    size_t size     = 0;
+    size_t dropped  = 0;
+
+    std::unique_ptr<const void*[]> codes   = {};
+    std::unique_ptr<int[]>         lasti   = {};
+    std::unique_ptr<int[]>         entry   = {};
+    std::vector<sample_record>     samples = {};
+};
+
+using thread_samples_data = omnitrace::thread_data<thread_samples, thread_samples>;
+
+struct frame_key
+{
+    const void* code  = nullptr;
+    int         lasti = 0;
+
+    bool operator==(const frame_key& _rhs) const
+    {
+        return code == _rhs.code && lasti == _rhs.lasti;
+    }
+};
+
+struct frame_key_hash
+{
+    size_t operator()(const frame_key& _v) const
+    {
+        return std::hash<const void*>{}(_v.code) ^
+               (std::hash<int>{}(_v.lasti) * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+// the resolved frames, only modified before the samples are post-processed
+struct resolved_frame
+{
+    bool       valid = false;
+    entry_type entry = {};
+};
+
+using resolved_map_t = std::unordered_map<frame_key, resolved_frame, frame_key_hash>;
+
+thread_samples::thread_samples(size_t _capacity)
+: capacity{ _capacity }
+, codes{ new const void*[_capacity] }
+, lasti{ new int[_capacity] }
+, entry{ new int[_capacity] }
+{
+    // Python call-stacks are rarely shallower than this
+    samples.reserve(std::max<size_t>(_capacity / 8, 1024));
+}
+
+auto&
+get_unwinder()
+{
+    static auto _v = std::atomic<omnitrace_python_unwind_func_t>{ nullptr };
+    return _v;
+}
+
+auto&
+get_resolver()
+{
+    static auto _v = std::atomic<omnitrace_python_resolve_func_t>{ nullptr };
+    return _v;
+}
+
+auto&
+get_resolved()
+{
+    static auto _v = resolved_map_t{};
+    return _v;
+}
+
+bool
+is_interpreter_frame(const entry_type& _v)
+{
+    return std::string_view{ _v.name }.find("_PyEval_EvalFrame") == 0;
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return get_sampling_python() && get_unwinder().load() != nullptr;
+}
+
+void
+configure(bool _setup, int64_t _tid)
+{
+    if(!_setup || !enabled()) return;
+
+    thread_samples_data::construct(construct_on_thread{ _tid },
+                                   get_sampling_python_buffer_size());
+}
+
+void
+sample(int64_t _tid, uint64_t _timestamp)
+{
+    auto _unwind = get_unwinder().load(std::memory_order_relaxed);
+    if(!_unwind) return;
+
+    auto* _instances = thread_samples_data::get();
+    if(!_instances || _tid < 0 || static_cast<size_t>(_tid) >= _instances->size())
+        return;
+
+    auto& _data = _instances->at(_tid);
+    if(!_data) return;
+
+    if(_data->capacity - _data->size < max_depth ||
+       _data->samples.size() == _data->samples.capacity())
+    {
+        ++_data->dropped;
+        return;
+    }
+
+    auto _offset = _data->size;
+    auto _n      = (*_unwind)(&_data->codes[_offset], &_data->lasti[_offset],
+                         &_data->entry[_offset], max_depth);
+    if(_n == 0) return;
+
+    _n = std::min(_n, max_depth);
+    _data->size += _n;
+    _data->samples.emplace_back(sample_record{ _timestamp,
+                                               static_cast<uint32_t>(_offset),
+                                               static_cast<uint32_t>(_n) });
+}
+
+void
+resolve()
+{
+    auto _resolve = get_resolver().load();
+    if(!_resolve) return;
+
+    auto* _instances = thread_samples_data::get();
+    if(!_instances) return;
+
+    auto&  _resolved = get_resolved();
+    size_t _nsamples = 0;
+    size_t _ndropped = 0;
+    for(size_t i = 0; i < _instances->size(); ++i)
+    {
+        const auto& _data = _instances->at(i);
+        if(!_data) continue;
+
+        _nsamples += _data->samples.size();
+        _ndropped += _data->dropped;
+        for(size_t j = 0; j < _data->size; ++j)
+        {
+            auto _key = frame_key{ _data->codes[j], _data->lasti[j] };
+            if(_resolved.find(_key) != _resolved.end()) continue;
+
+            auto&       _v    = _resolved[_key];
+            const char* _func = nullptr;
+            const char* _file = nullptr;
+            int         _line = 0;
+            if((*_resolve)(_key.code, _key.lasti, &_func, &_file, &_line) == 0 || !_func)
+                continue;
+
+            _v.valid          = true;
+            _v.entry.name     = _func;
+            _v.entry.location = JOIN(':', (_file) ? _file : "", _line);
+        }
+    }
+
+    OMNITRACE_VERBOSE(1, "Resolved %zu unique frames of %zu Python call-stacks...\n",
+                      _resolved.size(), _nsamples);
+    if(_ndropped > 0)
+        OMNITRACE_VERBOSE(1,
+                          "%zu Python call-stack samples were dropped because the "
+                          "buffers were full (see "
+                          "OMNITRACE_SAMPLING_PYTHON_BUFFER_SIZE)...\n",
+                          _ndropped);
+}
+
+void
+merge(int64_t _tid, uint64_t _timestamp, std::vector<entry_type>& _stack)
+{
+    auto* _instances = thread_samples_data::get();
+    if(!_instances || _tid < 0 || static_cast<size_t>(_tid) >= _instances->size())
+        return;
+
+    const auto& _data = _instances->at(_tid);
+    if(!_data || _data->samples.empty()) return;
+
+    // the samples of a thread are in chronological order
+    auto itr = std::lower_bound(
+        _data->samples.begin(), _data->samples.end(), _timestamp,
+        [](const sample_record& _v, uint64_t _ts) { return _v.timestamp < _ts; });
+    if(itr == _data->samples.end() || itr->timestamp != _timestamp) return;
+
+    // the Python frames of each invocation of the interpreter loop, outermost first.
+    // The native call-stack is kept if any frame could not be resolved
+    const auto& _resolved = get_resolved();
+    auto        _groups   = std::vector<std::vector<const entry_type*>>{};
+    size_t      _nframes  = 0;
+    for(size_t i = itr->size; i > 0; --i)
+    {
+        auto _idx  = itr->offset + i - 1;
+        auto _ritr = _resolved.find(frame_key{ _data->codes[_idx], _data->lasti[_idx] });
+        if(_ritr == _resolved.end() || !_ritr->second.valid) return;
+        if(_groups.empty() || _data->entry[_idx] != 0) _groups.emplace_back();
+        _groups.back().emplace_back(&_ritr->second.entry);
+        ++_nframes;
+    }
+
+    auto _ninterp = std::count_if(_stack.begin(), _stack.end(), is_interpreter_frame);
+    auto _ret     = std::vector<entry_type>{};
+    _ret.reserve(_stack.size() + _nframes);
+
+    auto _append = [&_ret](const auto& _group) {
+        for(const auto* iitr : _group)
+            _ret.emplace_back(*iitr);
+    };
+
+    // without a frame of the interpreter loop, e.g. the symbols of the interpreter are
+    // not available, the Python frames are the outermost frames
+    if(_ninterp == 0)
+    {
+        for(const auto& gitr : _groups)
+            _append(gitr);
+    }
+
+    // if the invocations of the interpreter loop do not match the groups of frames,
+    // all the Python frames are placed at the outermost invocation
+    bool   _matched = (static_cast<size_t>(_ninterp) == _groups.size());
+    size_t _group   = 0;
+    for(auto& sitr : _stack)
+    {
+        if(!is_interpreter_frame(sitr))
+            _ret.emplace_back(std::move(sitr));
+        else if(_matched)
+            _append(_groups.at(_group++));
+        else if(_group++ == 0)
+        {
+            for(const auto& gitr : _groups)
+                _append(gitr);
+        }
+    }
+
+    _stack = std::move(_ret);
+}
+
+const void*
+get_code(int64_t _tid, uint64_t _timestamp)
+{
+    auto* _instances = thread_samples_data::get();
+    if(!_instances || _tid < 0 || static_cast<size_t>(_tid) >= _instances->size())
+        return nullptr;
+
+    const auto& _data = _instances->at(_tid);
+    if(!_data || _data->samples.empty()) return nullptr;
+
+    auto itr = std::lower_bound(
+        _data->samples.begin(), _data->samples.end(), _timestamp,
+        [](const sample_record& _v, uint64_t _ts) { return _v.timestamp < _ts; });
+    if(itr == _data->samples.end() || itr->timestamp != _timestamp || itr->size == 0)
+        return nullptr;
+
+    // the frames of a sample start at the innermost frame
+    return _data->codes[itr->offset];
+}
+
+const void*
+get_current_code()
+{
+    auto _unwind = get_unwinder().load(std::memory_order_relaxed);
+    if(!_unwind) return nullptr;
+
+    const void* _code  = nullptr;
+    int         _lasti = 0;
+    int         _entry = 0;
+    return ((*_unwind)(&_code, &_lasti, &_entry, 1) > 0) ? _code : nullptr;
+}
+
+std::optional<entry_type>
+resolve_code(const void* _code)
+{
+    auto _resolve = get_resolver().load();
+    if(!_resolve || !_code) return std::nullopt;
+
+    // a negative offset is the first line of the function
+    const char* _func = nullptr;
+    const char* _file = nullptr;
+    int         _line = 0;
+    if((*_resolve)(_code, -1, &_func, &_file, &_line) == 0 || !_func) return std::nullopt;
+
+    auto _v     = entry_type{};
+    _v.name     = _func;
+    _v.location = JOIN(':', (_file) ? _file : "", _line);
+    return _v;
+}
+}  // namespace python_sampling
+}  // namespace omnitrace
+
+//--------------------------------------------------------------------------------------//
+
+namespace python_sampling = omnitrace::python_sampling;
+
+extern "C" void
+omnitrace_register_python_sampler_hidden(omnitrace_python_unwind_func_t  unwind,
+                                         omnitrace_python_resolve_func_t resolve)
+{
+    OMNITRACE_BASIC_VERBOSE_F(2, "Registering the Python call-stack sampler...\n");
+
+    python_sampling::get_resolver().store(resolve);
+    python_sampling::get_unwinder().store(unwind);
+}
@@ -0,0 +1,84 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/unwind/processed_entry.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace omnitrace
+{
+/// Python call-stacks of the CPU-time and real-time samples when
+/// OMNITRACE_SAMPLING_PYTHON is enabled. The signal handler only copies the code objects
+/// and the bytecode offsets of the frames of the interrupted thread, which does not
+/// require the GIL because no other thread modifies the frames of a thread. The frames
+/// are resolved with the GIL during finalization and replace the frames of the
+/// interpreter loop in the native call-stack of the sample with the same timestamp
+namespace python_sampling
+{
+using entry_type = tim::unwind::processed_entry;
+
+/// returns true if the Python call-stacks are sampled
+bool
+enabled();
+
+/// allocates the buffers of the thread. Invoked by the thread when its sampler is
+/// configured
+void
+configure(bool _setup, int64_t _tid);
+
+/// records the Python call-stack of the calling thread. Invoked from the sampling
+/// signal handler so it neither locks nor allocates
+void
+sample(int64_t _tid, uint64_t _timestamp);
+
+/// resolves the sampled frames. Invoked on the finalizing thread after the samplers
+/// are stopped
+void
+resolve();
+
+/// replaces the frames of the interpreter loop in the call-stack of the sample of the
+/// thread taken at the timestamp. The call-stack starts at the outermost frame
+void
+merge(int64_t _tid, uint64_t _timestamp, std::vector<entry_type>& _stack);
+
+/// the code object of the innermost Python frame of the sample of the thread taken at
+/// the timestamp or nullptr
+const void*
+get_code(int64_t _tid, uint64_t _timestamp);
+
+/// the code object of the innermost Python frame of the calling thread or nullptr.
+/// Neither locks nor allocates
+const void*
+get_current_code();
+
+/// the function and the first line of a code object returned by get_code or
+/// get_current_code.
+/// Requires that the interpreter is still initialized
+std::optional<entry_type>
+resolve_code(const void* _code);
+}  // namespace python_sampling
+}  // namespace omnitrace
@@ -0,0 +1,374 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/raw_output.hpp"
+#include "binary/analysis_cache.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/process/process.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/procfs/maps.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace raw_output
+{
+namespace
+{
+namespace cereal = ::tim::cereal;
+namespace procfs = ::tim::procfs;
+
+// the samples are stored as zigzag varints of the differences with the previous
+// sample: the timestamp, the weight, the depth and every frame relative to the same
+// frame of the previous sample, so the frames shared by successive call-stacks are
+// stored in one byte
+constexpr auto     samples_magic   = std::array<char, 8>{ 'O', 'M', 'N', 'I',
+                                                      'R', 'A', 'W', '\0' };
+constexpr uint32_t samples_version = 1;
+constexpr auto     manifest_name   = "manifest.json";
+
+struct raw_tag
+{};
+
+void
+write_varint(uint64_t _v, std::string& _out)
+{
+    while(_v >= 0x80)
+    {
+        _out += static_cast<char>((_v & 0x7f) | 0x80);
+        _v >>= 7;
+    }
+    _out += static_cast<char>(_v);
+}
+
+bool
+read_varint(const char*& _beg, const char* _end, uint64_t& _v)
+{
+    _v = 0;
+    for(int _shift = 0; _beg < _end && _shift < 64; _shift += 7)
+    {
+        auto _byte = static_cast<uint8_t>(*_beg++);
+        _v |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+        if((_byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+void
+write_delta(uint64_t _curr, uint64_t _prev, std::string& _out)
+{
+    auto _diff = static_cast<int64_t>(_curr - _prev);
+    write_varint((static_cast<uint64_t>(_diff) << 1) ^ static_cast<uint64_t>(_diff >> 63),
+                 _out);
+}
+
+bool
+read_delta(const char*& _beg, const char* _end, uint64_t _prev, uint64_t& _v)
+{
+    uint64_t _zz = 0;
+    if(!read_varint(_beg, _end, _zz)) return false;
+    auto _diff = static_cast<int64_t>((_zz >> 1) ^ (~(_zz & 1) + 1));
+    _v         = _prev + static_cast<uint64_t>(_diff);
+    return true;
+}
+
+auto&
+get_thread_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_threads()
+{
+    static auto _v = std::vector<thread_entry>{};
+    return _v;
+}
+
+std::string
+get_hostname()
+{
+    char _v[256] = {};
+    if(gethostname(_v, sizeof(_v) - 1) != 0) return std::string{ "localhost" };
+    return std::string{ _v };
+}
+}  // namespace
+
+template <typename ArchiveT>
+void
+thread_entry::serialize(ArchiveT& ar, const unsigned int)
+{
+    ar(cereal::make_nvp("index", index), cereal::make_nvp("system", system),
+       cereal::make_nvp("start", start), cereal::make_nvp("stop", stop),
+       cereal::make_nvp("init", init), cereal::make_nvp("samples", samples),
+       cereal::make_nvp("filename", filename));
+}
+
+template <typename ArchiveT>
+void
+mapping_entry::serialize(ArchiveT& ar, const unsigned int)
+{
+    ar(cereal::make_nvp("low", low), cereal::make_nvp("high", high),
+       cereal::make_nvp("pathname", pathname));
+}
+
+template <typename ArchiveT>
+void
+binary_entry::serialize(ArchiveT& ar, const unsigned int)
+{
+    ar(cereal::make_nvp("pathname", pathname), cereal::make_nvp("key", key));
+}
+
+template <typename ArchiveT>
+void
+manifest::serialize(ArchiveT& ar, const unsigned int)
+{
+    ar(cereal::make_nvp("version", version), cereal::make_nvp("pid", pid),
+       cereal::make_nvp("hostname", hostname), cereal::make_nvp("command", command),
+       cereal::make_nvp("perfetto", perfetto), cereal::make_nvp("timemory", timemory),
+       cereal::make_nvp("binaries", binaries), cereal::make_nvp("mappings", mappings),
+       cereal::make_nvp("threads", threads));
+}
+
+bool
+enabled()
+{
+    // the streamed samples were already symbolized while the application was running
+    return config::get_raw_output() && !config::get_sampling_streaming();
+}
+
+std::string
+get_directory()
+{
+    return JOIN("", settings::get_global_output_prefix(), "raw-", process::get_id());
+}
+
+size_t
+write_samples(int64_t _tid, uint64_t _init, const std::vector<sample>& _samples)
+{
+    const auto& _info = thread_info::get(_tid, SequentTID);
+
+    auto _entry     = thread_entry{};
+    _entry.index    = _tid;
+    _entry.system   = (_info && _info->index_data) ? _info->index_data->system_value : 0;
+    _entry.start    = (_info) ? _info->get_start() : 0;
+    _entry.stop     = (_info) ? _info->get_stop() : 0;
+    _entry.init     = _init;
+    _entry.samples  = _samples.size();
+    _entry.filename = JOIN("", "samples-", _tid, ".bin");
+
+    auto _encoded = std::string{};
+    _encoded.reserve(_samples.size() * 16);
+
+    auto _prev = sample{};
+    for(const auto& itr : _samples)
+    {
+        write_delta(itr.timestamp, _prev.timestamp, _encoded);
+        write_varint(itr.weight, _encoded);
+        write_varint(itr.addresses.size(), _encoded);
+        for(size_t i = 0; i < itr.addresses.size(); ++i)
+        {
+            auto _last = (i < _prev.addresses.size()) ? _prev.addresses[i] : 0;
+            write_delta(itr.addresses[i], _last, _encoded);
+        }
+        _prev = itr;
+    }
+
+    auto _fname = JOIN('/', get_directory(), _entry.filename);
+    auto _ofs   = std::ofstream{};
+    if(!filepath::open(_ofs, _fname, std::ios::out | std::ios::binary))
+    {
+        OMNITRACE_VERBOSE(0, "[raw_output] Error opening '%s'...\n", _fname.c_str());
+        return 0;
+    }
+
+    _ofs.write(samples_magic.data(), samples_magic.size());
+    _ofs.write(reinterpret_cast<const char*>(&samples_version), sizeof(samples_version));
+    _ofs.write(_encoded.data(), _encoded.size());
+    _ofs.close();
+
+    OMNITRACE_VERBOSE(2, "[raw_output] Wrote %zu samples of thread %li in %zu bytes...\n",
+                      _samples.size(), _tid, _encoded.size());
+
+    auto _lk = std::unique_lock<std::mutex>{ get_thread_mutex() };
+    get_threads().emplace_back(std::move(_entry));
+    return _samples.size();
+}
+
+void
+post_process()
+{
+    auto _manifest     = manifest{};
+    _manifest.pid      = process::get_id();
+    _manifest.hostname = get_hostname();
+    _manifest.command  = config::get_exe_realpath();
+    _manifest.perfetto = config::get_use_perfetto();
+    _manifest.timemory = config::get_use_timemory();
+
+    {
+        auto _lk          = std::unique_lock<std::mutex>{ get_thread_mutex() };
+        _manifest.threads = std::move(get_threads());
+        get_threads().clear();
+    }
+
+    std::sort(_manifest.threads.begin(), _manifest.threads.end(),
+              [](const auto& _lhs, const auto& _rhs) { return _lhs.index < _rhs.index; });
+
+    // the maps at the finalization. Libraries which were unloaded before cannot be
+    // symbolized
+    auto _filter = [](const procfs::maps& _v) {
+        return (!_v.pathname.empty() && _v.pathname.front() == '/' &&
+                filepath::exists(_v.pathname));
+    };
+
+    auto _binaries = std::set<std::string>{};
+    for(const auto& itr : procfs::get_contiguous_maps(process::get_id(), _filter, false))
+    {
+        _manifest.mappings.emplace_back(
+            mapping_entry{ itr.load_address, itr.last_address, itr.pathname });
+        _binaries.emplace(itr.pathname);
+    }
+
+    for(const auto& itr : _binaries)
+        _manifest.binaries.emplace_back(
+            binary_entry{ itr, binary::analysis_cache::get_key(itr) });
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+        (*ar)(cereal::make_nvp("raw_output", _manifest));
+    }
+
+    auto _fname = JOIN('/', get_directory(), manifest_name);
+    auto _ofs   = std::ofstream{};
+    if(!filepath::open(_ofs, _fname))
+    {
+        OMNITRACE_VERBOSE(0, "[raw_output] Error opening '%s'...\n", _fname.c_str());
+        return;
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<raw_tag>{}(_fname, std::string{ "raw_output" });
+    _ofs << oss.str() << "\n";
+}
+
+manifest
+read_manifest(const std::string& _directory)
+{
+    auto _fname = JOIN('/', _directory, manifest_name);
+    auto _ifs   = std::ifstream{ _fname };
+    if(!_ifs)
+        OMNITRACE_THROW("Error! '%s' is not a raw output folder (no %s)",
+                        _directory.c_str(), manifest_name);
+
+    auto _manifest = manifest{};
+    {
+        auto ar = cereal::JSONInputArchive{ _ifs };
+        ar(cereal::make_nvp("raw_output", _manifest));
+    }
+
+    if(_manifest.version != manifest::current_version)
+        OMNITRACE_THROW("Error! '%s' has version %u of the raw output (expected %u)",
+                        _fname.c_str(), _manifest.version, manifest::current_version);
+
+    return _manifest;
+}
+
+std::vector<sample>
+read_samples(const std::string& _directory, const thread_entry& _thread)
+{
+    auto _fname = JOIN('/', _directory, _thread.filename);
+    auto _ifs   = std::ifstream{ _fname, std::ios::in | std::ios::binary };
+    auto _data  = std::string{ std::istreambuf_iterator<char>{ _ifs },
+                              std::istreambuf_iterator<char>{} };
+
+    auto _magic   = decltype(samples_magic){};
+    auto _version = uint32_t{ 0 };
+    if(_data.size() < _magic.size() + sizeof(_version))
+        OMNITRACE_THROW("Error! '%s' is not a raw samples file", _fname.c_str());
+
+    std::memcpy(_magic.data(), _data.data(), _magic.size());
+    std::memcpy(&_version, _data.data() + _magic.size(), sizeof(_version));
+    if(_magic != samples_magic || _version != samples_version)
+        OMNITRACE_THROW("Error! '%s' is not a raw samples file (version %u)",
+                        _fname.c_str(), _version);
+
+    const auto* _beg = _data.data() + _magic.size() + sizeof(_version);
+    const auto* _end = _data.data() + _data.size();
+
+    auto _samples = std::vector<sample>{};
+    _samples.reserve(_thread.samples);
+
+    auto _prev = sample{};
+    while(_beg < _end)
+    {
+        auto     _v      = sample{};
+        uint64_t _weight = 0;
+        uint64_t _depth  = 0;
+        if(!read_delta(_beg, _end, _prev.timestamp, _v.timestamp) ||
+           !read_varint(_beg, _end, _weight) || !read_varint(_beg, _end, _depth))
+            break;
+
+        _v.weight = static_cast<uint32_t>(_weight);
+        _v.addresses.resize(_depth);
+        bool _valid = true;
+        for(size_t i = 0; i < _depth && _valid; ++i)
+        {
+            auto _last = (i < _prev.addresses.size()) ? _prev.addresses[i] : 0;
+            auto _addr = uint64_t{ 0 };
+            _valid     = read_delta(_beg, _end, _last, _addr);
+            _v.addresses[i] = _addr;
+        }
+        if(!_valid) break;
+
+        _prev = _v;
+        _samples.emplace_back(std::move(_v));
+    }
+
+    if(_samples.size() != _thread.samples)
+        OMNITRACE_VERBOSE(0,
+                          "[raw_output] Warning! read %zu samples of thread %li from "
+                          "'%s', expected %zu\n",
+                          _samples.size(), _thread.index, _fname.c_str(),
+                          static_cast<size_t>(_thread.samples));
+
+    return _samples;
+}
+}  // namespace raw_output
+}  // namespace omnitrace
@@ -0,0 +1,129 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace omnitrace
+{
+/// raw output of the sampling (see OMNITRACE_RAW_OUTPUT). Instead of symbolizing the
+/// call-stacks and emitting the perfetto and timemory data during the finalization,
+/// the samples of every thread are written with the instruction pointers of their
+/// call-stacks to a raw-<pid> folder of the output, along with a manifest.json which
+/// contains the threads, the file-backed memory maps of the process and the build-id
+/// of every mapped binary. omnitrace-process converts the folder into the usual
+/// sampling output on another node
+namespace raw_output
+{
+/// a sample of a thread. The addresses start at the innermost frame
+struct sample
+{
+    uint64_t               timestamp = 0;  // nsec
+    uint32_t               weight    = 1;  // number of timer samples represented
+    std::vector<uintptr_t> addresses = {};
+};
+
+struct thread_entry
+{
+    int64_t     index    = 0;   // sequent thread id
+    int64_t     system   = 0;   // system thread id
+    uint64_t    start    = 0;   // nsec
+    uint64_t    stop     = 0;   // nsec, zero if the thread was still running
+    uint64_t    init     = 0;   // nsec, beginning of the first sample
+    uint64_t    samples  = 0;   // number of samples in the file
+    std::string filename = {};  // relative to the folder
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT&, const unsigned int);
+};
+
+/// a file-backed mapping of the process
+struct mapping_entry
+{
+    uintptr_t   low      = 0;
+    uintptr_t   high     = 0;
+    std::string pathname = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT&, const unsigned int);
+};
+
+/// a mapped binary. The key is the build-id of the binary (or a hash of its path,
+/// modification time and size, see binary::analysis_cache::get_key)
+struct binary_entry
+{
+    std::string pathname = {};
+    std::string key      = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT&, const unsigned int);
+};
+
+struct manifest
+{
+    static constexpr uint32_t current_version = 1;
+
+    uint32_t                   version  = current_version;
+    pid_t                      pid      = 0;
+    std::string                hostname = {};
+    std::string                command  = {};
+    bool                       perfetto = true;  // OMNITRACE_TRACE of the run
+    bool                       timemory = true;  // OMNITRACE_PROFILE of the run
+    std::vector<binary_entry>  binaries = {};
+    std::vector<mapping_entry> mappings = {};
+    std::vector<thread_entry>  threads  = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT&, const unsigned int);
+};
+
+/// true when OMNITRACE_RAW_OUTPUT is enabled
+bool
+enabled();
+
+/// the raw-<pid> folder of this process
+std::string
+get_directory();
+
+/// writes the samples of a thread, possibly concurrently with the other threads, and
+/// returns the number of samples written. _init is the beginning of the first sample
+size_t
+write_samples(int64_t _tid, uint64_t _init, const std::vector<sample>&);
+
+/// writes the manifest after the samples of every thread have been written
+void
+post_process();
+
+/// reads the manifest of a raw-<pid> folder. Throws if the folder is not a raw output
+manifest
+read_manifest(const std::string& _directory);
+
+/// reads the samples of a thread of a raw-<pid> folder
+std::vector<sample>
+read_samples(const std::string& _directory, const thread_entry&);
+}  // namespace raw_output
+}  // namespace omnitrace
@@ -0,0 +1,746 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/rccl_timing.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/mpi_reduce.hpp"
+#include "core/timemory.hpp"
+#include "library/comm_histogram.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace rccl_timing
+{
+namespace
+{
+constexpr auto npos = std::numeric_limits<uint64_t>::max();
+
+// the conventions of rccl-tests: the count of the gathers, scatters and
+// reduce-scatters is per rank so their bytes are scaled by the number of ranks, and
+// the bus bandwidth is the algorithm bandwidth times steps * (n - 1) / n or, for the
+// rooted and point-to-point operations, the algorithm bandwidth
+struct op_traits
+{
+    bool     per_rank = false;
+    uint32_t steps    = 0;
+};
+
+op_traits
+get_op_traits(std::string_view _op)
+{
+    static const auto _v = std::unordered_map<std::string_view, op_traits>{
+        { "ncclAllGather", { true, 1 } },  { "ncclReduceScatter", { true, 1 } },
+        { "ncclAllToAll", { true, 1 } },   { "ncclGather", { true, 1 } },
+        { "ncclScatter", { true, 1 } },    { "ncclAllReduce", { false, 2 } },
+        { "ncclReduce", { false, 0 } },    { "ncclBroadcast", { false, 0 } },
+        { "ncclBcast", { false, 0 } },     { "ncclSend", { false, 0 } },
+        { "ncclRecv", { false, 0 } },
+    };
+    auto itr = _v.find(_op);
+    return (itr != _v.end()) ? itr->second : op_traits{};
+}
+
+double
+get_bus_factor(std::string_view _op, int32_t _size)
+{
+    auto _traits = get_op_traits(_op);
+    if(_traits.steps == 0 || _size <= 0) return 1.0;
+    return (_traits.steps * (_size - 1)) / static_cast<double>(_size);
+}
+
+struct comm_entry
+{
+    uint32_t label = 0;
+    int32_t  rank  = 0;
+    int32_t  size  = 1;
+};
+
+struct stats
+{
+    uint64_t calls        = 0;  // completed calls
+    uint64_t device_calls = 0;  // calls with at least one device operation
+    uint64_t bytes        = 0;  // bytes of the calls with a device operation
+    uint64_t host_ns      = 0;
+    uint64_t device_ns    = 0;
+    uint64_t device_min   = std::numeric_limits<uint64_t>::max();
+    uint64_t device_max   = 0;
+
+    stats& operator+=(const stats& _rhs)
+    {
+        calls += _rhs.calls;
+        device_calls += _rhs.device_calls;
+        bytes += _rhs.bytes;
+        host_ns += _rhs.host_ns;
+        device_ns += _rhs.device_ns;
+        device_min = std::min(device_min, _rhs.device_min);
+        device_max = std::max(device_max, _rhs.device_max);
+        return *this;
+    }
+};
+
+// the op names are the gotcha tool ids or the interned labels of the groups
+using key_type = std::tuple<std::string_view, uint32_t, int32_t, int32_t, size_t>;
+
+struct key_stats
+{
+    key_type key  = {};  // op, comm label, rank, size, bucket
+    stats    data = {};
+};
+
+struct call_record
+{
+    size_t   key        = 0;
+    uint64_t bytes      = 0;
+    uint64_t host_beg   = 0;
+    uint64_t host_end   = 0;
+    uint64_t device_beg = std::numeric_limits<uint64_t>::max();
+    uint64_t device_end = 0;
+    uint32_t pending    = 0;
+    bool     host_done  = false;
+};
+
+struct timing_data
+{
+    std::mutex                                mutex      = {};
+    uint32_t                                  num_labels = 0;
+    uint64_t                                  num_calls  = 0;
+    std::unordered_map<uintptr_t, comm_entry> comms      = {};
+    std::set<std::string>                     op_labels  = {};
+    std::map<key_type, size_t>                keys       = {};
+    std::vector<key_stats>                    stats      = {};
+    std::unordered_map<uint64_t, call_record> calls      = {};
+    std::unordered_map<uint64_t, uint64_t>    launches   = {};  // corr id -> call
+};
+
+// the collectives of the open group of a thread
+struct group_member
+{
+    std::string_view op    = {};
+    uintptr_t        comm  = 0;
+    uint64_t         bytes = 0;
+};
+
+struct thread_state
+{
+    uint32_t                  depth   = 0;
+    uint64_t                  call    = npos;  // the call being launched
+    std::vector<group_member> members = {};
+};
+
+// intentionally leaked since the HIP activity may be delivered during the teardown
+timing_data&
+get_data()
+{
+    static auto* _v = new timing_data{};
+    return *_v;
+}
+
+thread_state&
+get_thread_state()
+{
+    static thread_local auto _v = thread_state{};
+    return _v;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+// the number of launches whose device operations have not been seen. The activity of
+// the other HIP API calls is skipped without locking while it is zero
+auto&
+get_outstanding()
+{
+    static auto _v = std::atomic<int64_t>{ 0 };
+    return _v;
+}
+
+// the communicators which were not created by a wrapped function are the ranks of
+// the process in the order of first use
+comm_entry&
+get_comm(timing_data& _data, uintptr_t _comm)
+{
+    auto itr = _data.comms.find(_comm);
+    if(itr != _data.comms.end()) return itr->second;
+    auto _entry = comm_entry{ _data.num_labels++, static_cast<int32_t>(dmp::rank()),
+                              static_cast<int32_t>(dmp::size()) };
+    return _data.comms.emplace(_comm, _entry).first->second;
+}
+
+uint64_t
+add_call(timing_data& _data, std::string_view _op, const comm_entry& _comm,
+         uint64_t _bytes)
+{
+    auto _key = key_type{ _op, _comm.label, _comm.rank, _comm.size,
+                          comm_histogram::get_bucket(_bytes) };
+    auto itr  = _data.keys.find(_key);
+    if(itr == _data.keys.end())
+    {
+        itr = _data.keys.emplace(_key, _data.stats.size()).first;
+        _data.stats.emplace_back(key_stats{ _key, stats{} });
+    }
+
+    auto _id = _data.num_calls++;
+    _data.calls.emplace(_id, call_record{ itr->second, _bytes, tracing::now() });
+    return _id;
+}
+
+void
+fold(timing_data& _data, const call_record& _call)
+{
+    auto& _v = _data.stats.at(_call.key).data;
+    _v.calls += 1;
+    _v.host_ns += (_call.host_end > _call.host_beg) ? (_call.host_end - _call.host_beg)
+                                                    : 0;
+    if(_call.device_end > _call.device_beg)
+    {
+        auto _ns = _call.device_end - _call.device_beg;
+        _v.device_calls += 1;
+        _v.bytes += _call.bytes;
+        _v.device_ns += _ns;
+        _v.device_min = std::min(_v.device_min, _ns);
+        _v.device_max = std::max(_v.device_max, _ns);
+    }
+}
+
+// reduced across the ranks: the statistics of each rank of the communicator
+using reduced_key = std::tuple<std::string, std::string, size_t>;  // op, comm, bucket
+
+struct reduced_entry
+{
+    int32_t                  size  = 0;
+    std::map<int32_t, stats> ranks = {};
+};
+
+using reduced_data = std::map<reduced_key, reduced_entry>;
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+// one line per rank and (op, communicator, message size) with tab-separated fields
+mpi_reduce::buffer_t
+serialize(const reduced_data& _data)
+{
+    auto _ss = std::stringstream{};
+    for(const auto& itr : _data)
+    {
+        for(const auto& ritr : itr.second.ranks)
+        {
+            const auto& _v = ritr.second;
+            _ss << std::get<0>(itr.first) << '\t' << std::get<1>(itr.first) << '\t'
+                << std::get<2>(itr.first) << '\t' << itr.second.size << '\t'
+                << ritr.first << '\t' << _v.calls << '\t' << _v.device_calls << '\t'
+                << _v.bytes << '\t' << _v.host_ns << '\t' << _v.device_ns << '\t'
+                << _v.device_min << '\t' << _v.device_max << '\n';
+        }
+    }
+    auto _str = _ss.str();
+    return mpi_reduce::buffer_t{ _str.begin(), _str.end() };
+}
+
+reduced_data
+deserialize(const mpi_reduce::buffer_t& _data)
+{
+    auto _v    = reduced_data{};
+    auto _ss   = std::istringstream{ std::string{ _data.begin(), _data.end() } };
+    auto _line = std::string{};
+    while(std::getline(_ss, _line))
+    {
+        auto _fields = std::vector<std::string>{};
+        auto _ls     = std::istringstream{ _line };
+        auto _field  = std::string{};
+        while(std::getline(_ls, _field, '\t'))
+            _fields.emplace_back(_field);
+
+        if(_fields.size() != 12)
+        {
+            OMNITRACE_CI_THROW(true, "Invalid rccl_timing entry: '%s'\n", _line.c_str());
+            continue;
+        }
+
+        auto  _key   = reduced_key{ _fields.at(0), _fields.at(1),
+                                 std::stoull(_fields.at(2)) };
+        auto& _entry = _v[_key];
+        _entry.size  = std::stoi(_fields.at(3));
+
+        auto _stats         = stats{};
+        _stats.calls        = std::stoull(_fields.at(5));
+        _stats.device_calls = std::stoull(_fields.at(6));
+        _stats.bytes        = std::stoull(_fields.at(7));
+        _stats.host_ns      = std::stoull(_fields.at(8));
+        _stats.device_ns    = std::stoull(_fields.at(9));
+        _stats.device_min   = std::stoull(_fields.at(10));
+        _stats.device_max   = std::stoull(_fields.at(11));
+        _entry.ranks[std::stoi(_fields.at(4))] += _stats;
+    }
+    return _v;
+}
+#endif
+
+// the summary of an entry. The wait of a rank is the difference between its mean
+// device time and the one of the fastest rank, i.e. the rank which arrived last
+struct summary
+{
+    stats                     total     = {};
+    double                    mean_ns   = 0.0;
+    double                    host_ns   = 0.0;
+    double                    algbw     = 0.0;  // GB/s
+    double                    busbw     = 0.0;  // GB/s
+    int32_t                   straggler = -1;
+    int32_t                   max_rank  = -1;
+    double                    max_wait  = 0.0;
+    double                    mean_wait = 0.0;
+    std::map<int32_t, double> waits     = {};
+};
+
+double
+get_mean_ns(const stats& _v)
+{
+    return (_v.device_calls > 0) ? (static_cast<double>(_v.device_ns) / _v.device_calls)
+                                 : 0.0;
+}
+
+summary
+summarize(const reduced_key& _key, const reduced_entry& _entry)
+{
+    auto _v = summary{};
+    for(const auto& itr : _entry.ranks)
+        _v.total += itr.second;
+
+    if(_v.total.calls > 0)
+        _v.host_ns = static_cast<double>(_v.total.host_ns) / _v.total.calls;
+    _v.mean_ns = get_mean_ns(_v.total);
+    if(_v.total.device_ns > 0)
+    {
+        // bytes per nanosecond is GB/s
+        _v.algbw = static_cast<double>(_v.total.bytes) / _v.total.device_ns;
+        _v.busbw = _v.algbw * get_bus_factor(std::get<0>(_key), _entry.size);
+    }
+
+    auto _min_mean = std::numeric_limits<double>::max();
+    for(const auto& itr : _entry.ranks)
+    {
+        if(itr.second.device_calls == 0) continue;
+        auto _mean = get_mean_ns(itr.second);
+        if(_mean < _min_mean)
+        {
+            _min_mean    = _mean;
+            _v.straggler = itr.first;
+        }
+    }
+
+    if(_v.straggler < 0) return _v;
+
+    for(const auto& itr : _entry.ranks)
+    {
+        if(itr.second.device_calls == 0) continue;
+        auto _wait = get_mean_ns(itr.second) - _min_mean;
+        _v.waits.emplace(itr.first, _wait);
+        _v.mean_wait += _wait;
+        if(_wait >= _v.max_wait)
+        {
+            _v.max_wait = _wait;
+            _v.max_rank = itr.first;
+        }
+    }
+    _v.mean_wait /= _v.waits.size();
+    return _v;
+}
+
+void
+write_text(const reduced_data& _data)
+{
+    auto _fname = tim::settings::compose_output_filename("rccl_timing", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening rccl_timing output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "rccl_timing" });
+
+    auto _usec = [](double _ns) { return _ns / units::usec; };
+
+    ofs << std::fixed << std::setprecision(3);
+    for(const auto& itr : _data)
+    {
+        auto _v     = summarize(itr.first, itr.second);
+        auto _label = comm_histogram::buckets_t::get_bucket_label(std::get<2>(itr.first));
+        ofs << std::get<0>(itr.first) << " :: " << std::get<1>(itr.first) << " ("
+            << itr.second.size << " ranks) :: " << _label << " bytes\n";
+        ofs << "    calls       : " << _v.total.calls << " on "
+            << itr.second.ranks.size() << " ranks, " << _v.total.device_calls
+            << " with device operations\n";
+        ofs << "    host        : " << std::setw(12) << _usec(_v.host_ns)
+            << " usec mean launch time\n";
+        if(_v.total.device_calls == 0)
+        {
+            ofs << "\n";
+            continue;
+        }
+        ofs << "    device      : " << std::setw(12) << _usec(_v.mean_ns)
+            << " usec mean, " << _usec(_v.total.device_min) << " usec min, "
+            << _usec(_v.total.device_max) << " usec max\n";
+        ofs << "    bandwidth   : " << std::setw(12) << _v.algbw << " GB/s algorithm, "
+            << _v.busbw << " GB/s bus\n";
+        ofs << "    skew        : " << std::setw(12) << _usec(_v.max_wait)
+            << " usec max wait (rank " << _v.max_rank << "), " << _usec(_v.mean_wait)
+            << " usec mean wait, straggler is rank " << _v.straggler << "\n\n";
+    }
+}
+
+void
+write_json(const reduced_data& _data)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("rccl_timing");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data)
+        {
+            auto _v       = summarize(itr.first, itr.second);
+            auto _min_ns  = (_v.total.device_calls > 0) ? _v.total.device_min : 0;
+            auto _lo_byte = (std::get<2>(itr.first) > 0)
+                                ? (uint64_t{ 1 } << (std::get<2>(itr.first) - 1))
+                                : uint64_t{ 0 };
+            ar->startNode();
+            (*ar)(cereal::make_nvp("op", std::get<0>(itr.first)),
+                  cereal::make_nvp("comm", std::get<1>(itr.first)),
+                  cereal::make_nvp("comm_size", itr.second.size),
+                  cereal::make_nvp("bytes_lower_bound", _lo_byte),
+                  cereal::make_nvp("calls", _v.total.calls),
+                  cereal::make_nvp("device_calls", _v.total.device_calls),
+                  cereal::make_nvp("bytes", _v.total.bytes),
+                  cereal::make_nvp("host_mean_ns", _v.host_ns),
+                  cereal::make_nvp("device_mean_ns", _v.mean_ns),
+                  cereal::make_nvp("device_min_ns", _min_ns),
+                  cereal::make_nvp("device_max_ns", _v.total.device_max),
+                  cereal::make_nvp("algbw_gbps", _v.algbw),
+                  cereal::make_nvp("busbw_gbps", _v.busbw),
+                  cereal::make_nvp("straggler_rank", _v.straggler),
+                  cereal::make_nvp("max_wait_ns", _v.max_wait),
+                  cereal::make_nvp("mean_wait_ns", _v.mean_wait));
+
+            ar->setNextName("ranks");
+            ar->startNode();
+            ar->makeArray();
+            for(const auto& ritr : itr.second.ranks)
+            {
+                auto _wait = _v.waits.find(ritr.first);
+                ar->startNode();
+                (*ar)(cereal::make_nvp("rank", ritr.first),
+                      cereal::make_nvp("calls", ritr.second.calls),
+                      cereal::make_nvp("device_calls", ritr.second.device_calls),
+                      cereal::make_nvp("device_mean_ns", get_mean_ns(ritr.second)),
+                      cereal::make_nvp("wait_ns", (_wait != _v.waits.end())
+                                                      ? _wait->second
+                                                      : 0.0));
+                ar->finishNode();
+            }
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("rccl_timing", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening rccl_timing output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<summary>{}(_fname, std::string{ "rccl_timing" });
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+void
+register_comm(uintptr_t _comm, int32_t _rank, int32_t _size)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    _data.comms[_comm] = comm_entry{ _data.num_labels++, _rank, _size };
+}
+
+void
+register_comms(const uintptr_t* _comms, int32_t _size)
+{
+    if(!get_active().load(std::memory_order_relaxed) || _comms == nullptr) return;
+
+    auto& _data  = get_data();
+    auto  _lk    = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  _label = _data.num_labels++;
+    for(int32_t i = 0; i < _size; ++i)
+        _data.comms[_comms[i]] = comm_entry{ _label, i, _size };
+}
+
+void
+collective_begin(std::string_view _op, uintptr_t _comm, uint64_t _bytes)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _state = get_thread_state();
+    auto& _data  = get_data();
+    auto  _lk    = std::unique_lock<std::mutex>{ _data.mutex };
+    auto& _entry = get_comm(_data, _comm);
+    if(get_op_traits(_op).per_rank) _bytes *= _entry.size;
+
+    if(_state.depth > 0)
+        _state.members.emplace_back(group_member{ _op, _comm, _bytes });
+    else
+        _state.call = add_call(_data, _op, _entry, _bytes);
+}
+
+void
+group_begin()
+{
+    auto& _state = get_thread_state();
+    if(_state.depth++ == 0) _state.members.clear();
+}
+
+void
+group_end()
+{
+    auto& _state = get_thread_state();
+    if(_state.depth == 0 || --_state.depth > 0) return;
+    if(_state.members.empty() || !get_active().load(std::memory_order_relaxed)) return;
+
+    // a group of one operation on one communicator is reported as that operation and
+    // the other groups as the combination of the distinct operations
+    auto _ops   = std::set<std::string_view>{};
+    auto _comm  = _state.members.front().comm;
+    auto _bytes = uint64_t{ 0 };
+    for(const auto& itr : _state.members)
+    {
+        _ops.emplace(itr.op);
+        _bytes += itr.bytes;
+        if(itr.comm != _comm) _comm = 0;
+    }
+    _state.members.clear();
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  _op   = *_ops.begin();
+    if(_ops.size() > 1 || _comm == 0)
+    {
+        auto _label = std::string{ "ncclGroup[" };
+        for(auto itr : _ops)
+            _label += JOIN("", (_label.back() == '[') ? "" : "+", itr);
+        _label += (_comm == 0) ? ", multiple comms]" : "]";
+        _op = *_data.op_labels.emplace(std::move(_label)).first;
+    }
+
+    auto _entry = comm_entry{ std::numeric_limits<uint32_t>::max(),
+                              static_cast<int32_t>(dmp::rank()),
+                              static_cast<int32_t>(dmp::size()) };
+    if(_comm != 0) _entry = get_comm(_data, _comm);
+    _state.call = add_call(_data, _op, _entry, _bytes);
+}
+
+void
+call_end()
+{
+    auto& _state = get_thread_state();
+    if(_state.depth > 0 || _state.call == npos) return;
+
+    auto  _id   = std::exchange(_state.call, npos);
+    auto  _ts   = tracing::now();
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  itr   = _data.calls.find(_id);
+    if(itr == _data.calls.end()) return;
+
+    itr->second.host_end  = _ts;
+    itr->second.host_done = true;
+    if(itr->second.pending == 0)
+    {
+        fold(_data, itr->second);
+        _data.calls.erase(itr);
+    }
+}
+
+void
+hip_launch(uint64_t _corr_id)
+{
+    auto& _state = get_thread_state();
+    if(_state.call == npos) return;
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  itr   = _data.calls.find(_state.call);
+    if(itr == _data.calls.end()) return;
+
+    if(_data.launches.emplace(_corr_id, _state.call).second)
+    {
+        itr->second.pending += 1;
+        get_outstanding().fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void
+device_op(uint64_t _corr_id, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(get_outstanding().load(std::memory_order_relaxed) <= 0) return;
+
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  litr  = _data.launches.find(_corr_id);
+    if(litr == _data.launches.end()) return;
+
+    auto itr = _data.calls.find(litr->second);
+    _data.launches.erase(litr);
+    get_outstanding().fetch_sub(1, std::memory_order_relaxed);
+    if(itr == _data.calls.end()) return;
+
+    // each launch is one dispatch so the call is complete once every launch was seen
+    auto& _call      = itr->second;
+    _call.device_beg = std::min(_call.device_beg, _beg_ns);
+    _call.device_end = std::max(_call.device_end, _end_ns);
+    if(_call.pending > 0) _call.pending -= 1;
+    if(_call.pending == 0 && _call.host_done)
+    {
+        fold(_data, _call);
+        _data.calls.erase(itr);
+    }
+}
+
+void
+post_process()
+{
+    if(!config::get_rcclp_device_timing()) return;
+
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        get_active().store(false);
+
+        auto  _reduced = reduced_data{};
+        auto  _pending = size_t{ 0 };
+        auto& _data    = get_data();
+        {
+            auto _lk = std::unique_lock<std::mutex>{ _data.mutex };
+
+            // the calls whose operations were not all delivered are folded with the
+            // operations which were
+            for(auto& itr : _data.calls)
+            {
+                if(itr.second.pending > 0) ++_pending;
+                if(!itr.second.host_done) itr.second.host_end = itr.second.host_beg;
+                fold(_data, itr.second);
+            }
+            _data.calls.clear();
+            _data.launches.clear();
+            get_outstanding().store(0);
+
+            for(const auto& itr : _data.stats)
+            {
+                if(itr.data.calls == 0) continue;
+                auto _label = std::get<1>(itr.key);
+                auto _comm  = (_label == std::numeric_limits<uint32_t>::max())
+                                  ? std::string{ "multiple" }
+                                  : JOIN("", "ncclComm[", _label, ']');
+                auto _key   = reduced_key{ std::string{ std::get<0>(itr.key) },
+                                         std::move(_comm), std::get<4>(itr.key) };
+                auto& _entry = _reduced[_key];
+                _entry.size  = std::get<3>(itr.key);
+                _entry.ranks[std::get<2>(itr.key)] += itr.data;
+            }
+        }
+
+        OMNITRACE_WARNING_IF_F(_pending > 0,
+                               "%zu RCCL calls had device operations which were not "
+                               "delivered before the finalization\n",
+                               _pending);
+
+        auto _rank       = dmp::rank();
+        bool _is_reduced = false;
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+        {
+            auto _buffer = serialize(_reduced);
+            _is_reduced  = mpi_reduce::hierarchical(_buffer, mpi_reduce::append);
+            if(_is_reduced) _reduced = deserialize(_buffer);
+        }
+#endif
+
+        // every rank writes its own file when the data could not be reduced
+        if(_is_reduced && _rank != 0) return;
+        if(_reduced.empty()) return;
+
+        OMNITRACE_VERBOSE_F(1, "RCCL device timing of %zu collectives...\n",
+                            _reduced.size());
+
+        try
+        {
+            auto _get_setting = [](const std::string& _v) {
+                auto&& _b = config::get_setting_value<bool>(_v);
+                OMNITRACE_CI_THROW(!_b, "Error! No configuration setting named '%s'",
+                                   _v.c_str());
+                return _b.value_or(true);
+            };
+
+            if(_get_setting("OMNITRACE_TEXT_OUTPUT")) write_text(_reduced);
+            if(_get_setting("OMNITRACE_JSON_OUTPUT")) write_json(_reduced);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "Writing the RCCL device timing failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace rccl_timing
+}  // namespace omnitrace
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+/// on-device timing of the RCCL calls (see OMNITRACE_RCCLP_DEVICE_TIMING). The RCCL
+/// calls only enqueue the collective so the host-side duration is the launch time. The
+/// HIP API calls made while a collective (or a group of collectives in
+/// ncclGroupStart/ncclGroupEnd) is being launched are matched with the kernels and
+/// copies they dispatch via the correlation id and the device time of the call is the
+/// interval from the begin of its first operation to the end of its last operation.
+/// Only the calls with outstanding operations are tracked: the completed calls are
+/// folded into the statistics of the (collective, communicator, message size) and the
+/// statistics are reduced across the ranks at finalization. The achieved bus bandwidth
+/// follows the conventions of rccl-tests and the skew of a rank is how much longer its
+/// operations took on average than the ones of the fastest rank, which is the time
+/// spent waiting for the stragglers
+namespace rccl_timing
+{
+/// registers the communicator created by ncclCommInitRank
+void
+register_comm(uintptr_t _comm, int32_t _rank, int32_t _size);
+
+/// registers the communicators created by ncclCommInitAll, i.e. the ranks of one
+/// communicator within this process
+void
+register_comms(const uintptr_t* _comms, int32_t _size);
+
+/// begin of a collective or point-to-point call on the calling thread. _bytes is the
+/// count argument of the call times the size of the data type
+void
+collective_begin(std::string_view _op, uintptr_t _comm, uint64_t _bytes);
+
+/// ncclGroupStart and ncclGroupEnd. The collectives of a group are launched together
+/// by the outermost ncclGroupEnd and are reported as one call
+void
+group_begin();
+
+void
+group_end();
+
+/// end of an RCCL call on the calling thread
+void
+call_end();
+
+/// the HIP API call with the correlation id is entered on the calling thread. It is
+/// attributed to the RCCL call being launched by the thread, if any
+void
+hip_launch(uint64_t _corr_id);
+
+/// a device operation of the HIP API call with the correlation id has completed
+void
+device_op(uint64_t _corr_id, uint64_t _beg_ns, uint64_t _end_ns);
+
+/// folds the calls with outstanding operations, reduces the statistics across the ranks
+/// and writes rccl_timing.{txt,json}. Collective over all the ranks
+void
+post_process();
+}  // namespace rccl_timing
+}  // namespace omnitrace
@@ -24,6 +24,7 @@
 
 #include "library/components/rcclp.hpp"
 #include "core/components/fwd.hpp"
+#include "core/config.hpp"
 #include "core/defines.hpp"
 #include "core/dynamic_library.hpp"
 #include "core/rccl.hpp"
@@ -73,6 +74,9 @@ setup()
         trait::runtime_enabled<component::comm_data_tracker_t>::set(_use_data);
     }
 
+    trait::runtime_enabled<component::rcclp_timing>::set(
+        config::get_rcclp_device_timing());
+
     component::configure_rcclp();
     global_id = component::activate_rcclp();
 }
@@ -0,0 +1,178 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/region_attribution.hpp"
+#include "core/locking.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+namespace omnitrace
+{
+namespace region_attribution
+{
+namespace
+{
+// only the owning thread appends to its records. The lock is uncontended unless the
+// thread is still running when its records are post-processed
+struct thread_records
+{
+    locking::atomic_mutex mutex        = {};
+    std::vector<interval> regions      = {};
+    std::vector<size_t>   open_regions = {};
+};
+
+using thread_records_data = omnitrace::thread_data<thread_records, thread_records>;
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+thread_records&
+get_local_records()
+{
+    auto& _v =
+        thread_records_data::instance(construct_on_thread{ tim::threading::get_id() });
+    if(!_v) _v = std::make_unique<thread_records>();
+    return *_v;
+}
+}  // namespace
+
+timeline
+split(const timeline& _total, std::vector<change_t> _changes, double& _idle)
+{
+    std::sort(_changes.begin(), _changes.end());
+
+    auto   _v     = timeline{};
+    auto   _n     = int64_t{ 0 };
+    auto   _share = 0.0;
+    size_t _i     = 0;
+    size_t _j     = 0;
+    auto   _prev  = std::optional<double>{};
+
+    while(_i < _total.ts.size() || _j < _changes.size())
+    {
+        auto _ts = (_j == _changes.size() ||
+                    (_i < _total.ts.size() && _total.ts.at(_i) <= _changes.at(_j).first))
+                       ? _total.ts.at(_i)
+                       : _changes.at(_j).first;
+
+        auto _value = _total.at(_ts);
+        if(_prev)
+        {
+            if(_n > 0)
+                _share += (_value - *_prev) / static_cast<double>(_n);
+            else
+                _idle += (_value - *_prev);
+        }
+        _prev = _value;
+        _v.push(_ts, _share);
+
+        while(_i < _total.ts.size() && _total.ts.at(_i) == _ts)
+            ++_i;
+        while(_j < _changes.size() && _changes.at(_j).first == _ts)
+            _n += _changes.at(_j++).second;
+    }
+
+    return _v;
+}
+
+void
+region_begin(uint64_t _hash)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto& _v     = get_local_records();
+    auto  _lk    = locking::atomic_lock{ _v.mutex };
+    auto  _depth = static_cast<uint32_t>(_v.open_regions.size());
+    _v.open_regions.emplace_back(_v.regions.size());
+    _v.regions.emplace_back(interval{ _hash, tracing::now(), 0, _depth });
+}
+
+void
+region_end(uint64_t _hash)
+{
+    if(!get_active().load(std::memory_order_relaxed)) return;
+
+    auto  _ts = tracing::now();
+    auto& _v  = get_local_records();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    for(auto itr = _v.open_regions.rbegin(); itr != _v.open_regions.rend(); ++itr)
+    {
+        auto& _region = _v.regions.at(*itr);
+        if(_region.hash != _hash) continue;
+        _region.end = _ts;
+        _v.open_regions.erase(std::next(itr).base());
+        return;
+    }
+}
+
+void
+stop()
+{
+    get_active().store(false);
+}
+
+std::vector<interval>
+get_intervals(uint64_t _end)
+{
+    auto _v = std::vector<interval>{};
+    if(!thread_records_data::get()) return _v;
+
+    for(auto& itr : *thread_records_data::get())
+    {
+        if(!itr) continue;
+        auto _lk = locking::atomic_lock{ itr->mutex };
+        for(auto _r : itr->regions)
+        {
+            if(_r.end == 0) _r.end = std::max(_end, _r.begin);
+            if(_r.end < _r.begin) continue;
+            _v.emplace_back(_r);
+        }
+    }
+    return _v;
+}
+
+std::vector<change_t>
+get_thread_changes(const std::vector<interval>& _intervals)
+{
+    // a thread counts once while it is inside of any region, i.e. from the begin to
+    // the end of its outermost regions
+    auto _v = std::vector<change_t>{};
+    for(const auto& itr : _intervals)
+    {
+        if(itr.depth != 0) continue;
+        _v.emplace_back(itr.begin, 1);
+        _v.emplace_back(itr.end, -1);
+    }
+    return _v;
+}
+}  // namespace region_attribution
+}  // namespace omnitrace
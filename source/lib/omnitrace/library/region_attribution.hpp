@@ -0,0 +1,113 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+/// attribution of the quantities accumulated by the background process sampler (e.g.
+/// the energy or the bytes transferred from the memory) to the regions. The threads
+/// only record the begin and end of their regions and the value of an interval is
+/// interpolated from the samples around it at finalization
+namespace region_attribution
+{
+/// accumulated value at the sample times, linear in between
+struct timeline
+{
+    std::vector<uint64_t> ts     = {};
+    std::vector<double>   values = {};
+
+    bool empty() const { return ts.empty(); }
+
+    void push(uint64_t _ts, double _value)
+    {
+        if(!ts.empty() && _ts < ts.back()) return;
+        ts.emplace_back(_ts);
+        values.emplace_back(_value);
+    }
+
+    double at(uint64_t _ts) const
+    {
+        if(ts.empty()) return 0.0;
+        if(_ts <= ts.front()) return values.front();
+        if(_ts >= ts.back()) return values.back();
+
+        auto _itr = std::upper_bound(ts.begin(), ts.end(), _ts);
+        auto _idx = std::distance(ts.begin(), _itr);
+        auto _t0  = ts.at(_idx - 1);
+        auto _t1  = ts.at(_idx);
+        auto _v0  = values.at(_idx - 1);
+        auto _v1  = values.at(_idx);
+        if(_t1 == _t0) return _v1;
+        return _v0 + (_v1 - _v0) * static_cast<double>(_ts - _t0) /
+                         static_cast<double>(_t1 - _t0);
+    }
+
+    double between(uint64_t _beg, uint64_t _end) const { return at(_end) - at(_beg); }
+};
+
+/// time and the begin (+1) or end (-1) of an interval
+using change_t = std::pair<uint64_t, int32_t>;
+
+/// the share of the accumulated value of one of the intervals active at the same time.
+/// The value of every segment between two consecutive samples or changes is divided
+/// by the number of intervals active during the segment and the value of the segments
+/// without any interval is added to _idle
+timeline
+split(const timeline& _total, std::vector<change_t> _changes, double& _idle);
+
+struct interval
+{
+    uint64_t hash  = 0;
+    uint64_t begin = 0;
+    uint64_t end   = 0;
+    uint32_t depth = 0;  ///< number of regions of the thread which enclose it
+};
+
+/// records the begin of a region of the calling thread
+void
+region_begin(uint64_t _hash);
+
+/// records the end of the innermost region of the calling thread with the hash
+void
+region_end(uint64_t _hash);
+
+/// stops recording the regions. The recorded intervals remain available
+void
+stop();
+
+/// the intervals of the regions of every thread. The regions which are still open end
+/// at _end
+std::vector<interval>
+get_intervals(uint64_t _end);
+
+/// the changes of the number of threads which are inside of at least one region
+std::vector<change_t>
+get_thread_changes(const std::vector<interval>& _intervals);
+}  // namespace region_attribution
+}  // namespace omnitrace
@@ -0,0 +1,301 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/region_rates.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/defines.hpp"
+#include "core/hash_cache.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/utility/delimit.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace region_rates
+{
+namespace
+{
+struct rules
+{
+    double                               default_rate = 0.0;  // zero without "*"
+    double                               max_rate     = 0.0;
+    std::unordered_map<uint64_t, double> regions      = {};
+};
+
+// only the owning thread updates its state. The signal handler reads the stride, the
+// count, and the weight
+struct thread_state
+{
+    int                                      signum   = -1;
+    bool                                     timer_ok = false;
+    bool                                     armed    = false;
+    timer_t                                  timer    = {};
+    double                                   freq     = 0.0;  // of the thread timer
+    double                                   max_rate = 0.0;
+    double                                   rate     = 0.0;
+    uint32_t                                 stride   = 1;
+    uint32_t                                 weight   = 1;
+    uint64_t                                 count    = 0;
+    std::vector<std::pair<uint64_t, double>> regions  = {};  // (hash, rate) stack
+};
+
+using thread_state_data = omnitrace::thread_data<thread_state, thread_state>;
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ true };
+    return _v;
+}
+
+std::string
+trim(std::string _v)
+{
+    auto _beg = _v.find_first_not_of(" \t\n");
+    auto _end = _v.find_last_not_of(" \t\n");
+    return (_beg == std::string::npos) ? std::string{}
+                                       : _v.substr(_beg, _end - _beg + 1);
+}
+
+const rules&
+get_rules()
+{
+    static auto _v = []() {
+        auto _rules = rules{};
+        for(const auto& itr : tim::delimit(config::get_sampling_region_rates(), ",;"))
+        {
+            auto _pos  = itr.find_last_of(':');
+            auto _name = trim(itr.substr(0, _pos));
+            auto _rate = 0.0;
+            try
+            {
+                if(_pos != std::string::npos) _rate = std::stod(itr.substr(_pos + 1));
+            } catch(std::exception&)
+            {}
+
+            if(_name.empty() || !(_rate > 0.0))
+            {
+                OMNITRACE_WARNING(0,
+                                  "[region_rates] ignoring '%s' in "
+                                  "OMNITRACE_SAMPLING_REGION_RATES (expected "
+                                  "<region>:<frequency>)\n",
+                                  itr.c_str());
+                continue;
+            }
+
+            if(_name == "*")
+                _rules.default_rate = _rate;
+            else
+                _rules.regions[hash_cache::add_hash_id(_name)] = _rate;
+            _rules.max_rate = std::max(_rules.max_rate, _rate);
+        }
+        return _rules;
+    }();
+    return _v;
+}
+
+thread_state*&
+get_local_state()
+{
+    static thread_local thread_state* _v OMNITRACE_ATTRIBUTE(tls_model("initial-exec")) =
+        nullptr;
+    return _v;
+}
+
+void
+set_timer(thread_state& _v, double _freq)
+{
+    auto _spec = itimerspec{};
+    if(_freq > 0.0)
+    {
+        auto _period              = static_cast<int64_t>(1.0e9 / _freq);
+        _spec.it_interval.tv_sec  = _period / 1000000000;
+        _spec.it_interval.tv_nsec = _period % 1000000000;
+        _spec.it_value            = _spec.it_interval;
+    }
+    timer_settime(_v.timer, 0, &_spec, nullptr);
+    _v.armed = (_freq > 0.0);
+}
+
+void
+set_rate(thread_state& _v, double _rate)
+{
+    if(_rate == _v.rate || !get_active().load(std::memory_order_relaxed)) return;
+    _v.rate = _rate;
+
+    auto _stride    = uint32_t{ 1 };
+    auto _effective = _v.freq;
+    if(_rate < _v.freq)
+    {
+        _stride    = std::max<uint32_t>(std::lround(_v.freq / _rate), 1);
+        _effective = _v.freq / _stride;
+        if(_v.armed) set_timer(_v, 0.0);
+    }
+    else if(_rate > _v.freq && _v.timer_ok)
+    {
+        _effective = _rate;
+        set_timer(_v, _rate - _v.freq);
+    }
+    else if(_v.armed)
+    {
+        set_timer(_v, 0.0);
+    }
+
+    // a signal in between these stores uses the previous weight for one sample
+    _v.stride = _stride;
+    _v.count  = 0;
+    _v.weight = std::max<uint32_t>(std::lround(_v.max_rate / _effective), 1);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return config::get_use_sampling() && get_rules().max_rate > 0.0;
+}
+
+double
+get_default_rate(double _freq)
+{
+    const auto& _rules = get_rules();
+    return (_rules.default_rate > 0.0) ? _rules.default_rate : _freq;
+}
+
+void
+configure(bool _setup, int _signum, clockid_t _clock_id, double _freq)
+{
+    auto*& _local = get_local_state();
+    if(!_setup)
+    {
+        if(!_local) return;
+        auto _v = std::exchange(_local, nullptr);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        if(_v->timer_ok) timer_delete(_v->timer);
+        _v->timer_ok = false;
+        _v->armed    = false;
+        return;
+    }
+
+    if(_local || !enabled() || !get_active().load() || !(_freq > 0.0)) return;
+
+    auto& _v =
+        thread_state_data::instance(construct_on_thread{ tim::threading::get_id() });
+    _v = std::make_unique<thread_state>();
+
+    _v->signum   = _signum;
+    _v->freq     = _freq;
+    _v->max_rate = std::max(_freq, get_rules().max_rate);
+    _v->rate     = _freq;
+    _v->weight   = std::max<uint32_t>(std::lround(_v->max_rate / _freq), 1);
+
+    // the thread timer is not accessible so the rates above its frequency are reached
+    // with a second timer of the thread which is armed for the difference
+    struct sigevent _event = {};
+    _event.sigev_notify    = SIGEV_THREAD_ID;
+    _event.sigev_signo     = _signum;
+    _event._sigev_un._tid  = tim::threading::get_sys_tid();
+    if(timer_create(_clock_id, &_event, &_v->timer) == 0)
+        _v->timer_ok = true;
+    else
+        OMNITRACE_VERBOSE(0,
+                          "[region_rates] timer_create failed: %s. The region rates "
+                          "above %.1f interrupts/sec are not reached\n",
+                          strerror(errno), _freq);
+
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    _local = _v.get();
+}
+
+void
+stop()
+{
+    get_active().store(false);
+    for(auto& itr : *thread_state_data::get())
+    {
+        if(!itr || !itr->timer_ok) continue;
+        itr->timer_ok = false;
+        itr->armed    = false;
+        timer_delete(itr->timer);
+    }
+}
+
+void
+region_begin(uint64_t _hash)
+{
+    auto* _v = get_local_state();
+    if(!_v) return;
+
+    const auto& _regions = get_rules().regions;
+    auto        itr      = _regions.find(_hash);
+    if(itr == _regions.end()) return;
+
+    _v->regions.emplace_back(_hash, itr->second);
+    set_rate(*_v, itr->second);
+}
+
+void
+region_end(uint64_t _hash)
+{
+    auto* _v = get_local_state();
+    if(!_v) return;
+
+    for(auto itr = _v->regions.rbegin(); itr != _v->regions.rend(); ++itr)
+    {
+        if(itr->first != _hash) continue;
+        _v->regions.erase(std::next(itr).base());
+        set_rate(*_v, (_v->regions.empty()) ? _v->freq : _v->regions.back().second);
+        return;
+    }
+}
+
+bool
+accept(int _signum)
+{
+    auto* _v = get_local_state();
+    if(!_v || _v->signum != _signum || _v->stride == 1) return true;
+    return (_v->count++ % _v->stride) == 0;
+}
+
+uint32_t
+get_weight(int _signum)
+{
+    auto* _v = get_local_state();
+    return (_v && _v->signum == _signum) ? _v->weight : 1;
+}
+}  // namespace region_rates
+}  // namespace omnitrace
@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+namespace omnitrace
+{
+/// region-scoped sampling rates (OMNITRACE_SAMPLING_REGION_RATES). The rules map the
+/// names of the regions to a sampling frequency and "*" is the frequency outside of
+/// the regions of the rules. When the innermost region of a rule of a thread changes,
+/// a rate above the frequency of the timer of the thread is reached by arming a second
+/// timer of the thread with the same signal and clock for the difference and a rate
+/// below it by only unwinding every Nth signal. Each sample is weighted by the number
+/// of samples which the highest frequency of the rules would have taken
+namespace region_rates
+{
+/// true when OMNITRACE_SAMPLING_REGION_RATES has a rule for a region
+bool
+enabled();
+
+/// the frequency of the timer outside of the regions of the rules: the "*" rule or
+/// _freq without it
+double
+get_default_rate(double _freq);
+
+/// creates (or deletes) the second timer of the calling thread. _signum, _clock_id,
+/// and _freq are the signal, clock, and frequency of the timer of the thread which
+/// the rules apply to
+void
+configure(bool _setup, int _signum, clockid_t _clock_id, double _freq);
+
+/// deletes the second timers of every thread before the sampling signals are ignored
+void
+stop();
+
+/// the begin of a region of the calling thread
+void
+region_begin(uint64_t _hash);
+
+/// the end of a region of the calling thread
+void
+region_end(uint64_t _hash);
+
+/// returns false if the sample of the signal should not be unwound. Safe to invoke
+/// from a signal handler
+bool
+accept(int _signum);
+
+/// the weight of a sample of the signal taken now. Safe to invoke from a signal
+/// handler
+uint32_t
+get_weight(int _signum);
+}  // namespace region_rates
+}  // namespace omnitrace
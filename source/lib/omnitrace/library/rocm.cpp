@@ -28,6 +28,7 @@
 #include "library/components/rocprofiler.hpp"
 #include "library/components/roctracer.hpp"
 #include "library/rocm/hsa_rsrc_factory.hpp"
+#include "library/rocm/queue_trace.hpp"
 #include "library/rocm_smi.hpp"
 #include "library/rocprofiler.hpp"
 #include "library/roctracer.hpp"
@@ -37,14 +38,19 @@
 
 #include <timemory/backends/cpu.hpp>
 #include <timemory/backends/threading.hpp>
+#include <timemory/utility/demangle.hpp>
 #include <timemory/utility/types.hpp>
 
 #include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
 #include <tuple>
+#include <unordered_map>
 
 #if defined(OMNITRACE_USE_ROCPROFILER) && OMNITRACE_USE_ROCPROFILER > 0
 #    include <rocprofiler.h>
@@ -59,6 +65,73 @@ namespace rocm
 std::mutex rocm_mutex    = {};
 bool       is_loaded     = false;
 bool       on_load_trace = (get_env<int>("ROCP_ONLOAD_TRACE", 0) > 0);
+
+namespace
+{
+struct kernel_symbol_table
+{
+    std::shared_mutex mutex = {};
+    // deque so that references to the symbols are never invalidated
+    std::deque<kernel_symbol> symbols = {};
+    // keys refer to kernel_symbol::mangled in the deque
+    std::unordered_map<std::string_view, uint32_t> ids = {};
+};
+
+auto&
+get_kernel_symbol_table()
+{
+    // intentionally leaked: activity records may still be processed during exit
+    static auto* _v = new kernel_symbol_table{};
+    return *_v;
+}
+
+std::string
+get_kernel_symbol_name(const std::string& _mangled)
+{
+    auto _name = tim::demangle(_mangled);
+    // remove suffixes such as " [clone .kd]"
+    auto _pos = _name.find_last_of(')');
+    if(_pos != std::string::npos) _name = _name.substr(0, _pos + 1);
+    return _name;
+}
+}  // namespace
+
+const kernel_symbol&
+get_kernel_symbol(std::string_view _mangled)
+{
+    auto& _table = get_kernel_symbol_table();
+    {
+        auto _lk  = std::shared_lock<std::shared_mutex>{ _table.mutex };
+        auto _itr = _table.ids.find(_mangled);
+        if(_itr != _table.ids.end()) return _table.symbols[_itr->second];
+    }
+
+    // demangle outside of the lock. If another thread interns the same name
+    // first, its entry is used and this result is discarded
+    auto _value = std::string{ _mangled };
+    auto _name  = get_kernel_symbol_name(_value);
+
+    auto _lk  = std::unique_lock<std::shared_mutex>{ _table.mutex };
+    auto _itr = _table.ids.find(_mangled);
+    if(_itr != _table.ids.end()) return _table.symbols[_itr->second];
+
+    auto  _id  = static_cast<uint32_t>(_table.symbols.size());
+    auto& _sym = _table.symbols.emplace_back(
+        kernel_symbol{ _id, std::move(_value), std::move(_name) });
+    _table.ids.emplace(std::string_view{ _sym.mangled }, _id);
+    return _sym;
+}
+
+const kernel_symbol&
+get_kernel_symbol(uint32_t _id)
+{
+    auto& _table = get_kernel_symbol_table();
+    auto  _lk    = std::shared_lock<std::shared_mutex>{ _table.mutex };
+    if(_id >= _table.symbols.size())
+        throw ::omnitrace::exception<std::out_of_range>(
+            JOIN("", "invalid kernel symbol id ", _id));
+    return _table.symbols[_id];
+}
 }  // namespace rocm
 }  // namespace omnitrace
 
@@ -111,7 +184,9 @@ extern "C"
     {
         using ::rocprofiler::util::HsaRsrcFactory;
 
-        if(!config::get_use_rocprofiler() || config::get_rocm_events().empty()) return;
+        if(!config::get_use_rocprofiler() ||
+           (config::get_rocm_events().empty() && !config::get_rocm_roofline()))
+            return;
 
         OMNITRACE_BASIC_VERBOSE_F(2 || rocm::on_load_trace, "Loading...\n");
 
@@ -128,9 +203,12 @@ extern "C"
 
         _lk.unlock();
 
+        // the dispatches are not intercepted when the counters are sampled
+        auto _sampled = omnitrace::rocprofiler::device_sampling::is_enabled();
+
         // Enable timestamping
         settings->timestamp_on     = 1;
-        settings->intercept_mode   = 1;
+        settings->intercept_mode   = (_sampled) ? 0 : 1;
         settings->hsa_intercepting = 1;
         settings->k_concurrent     = 0;
         settings->obj_dumping      = 0;
@@ -187,6 +265,7 @@ extern "C"
             rocm_smi::set_state(State::Active);
         }
 
+        rocm::queue_trace::setup(table);
         comp::roctracer::setup(static_cast<void*>(table), rocm::on_load_trace);
 
 #if defined(OMNITRACE_USE_ROCPROFILER) && OMNITRACE_USE_ROCPROFILER > 0
@@ -197,8 +276,9 @@ extern "C"
 #endif
 
         bool _success = true;
-        bool _is_empty =
-            (config::settings_are_configured() && config::get_rocm_events().empty());
+        bool _is_empty = (config::settings_are_configured() &&
+                          config::get_rocm_events().empty() &&
+                          !config::get_rocm_roofline());
         if(_force_rocprofiler_init || (get_use_rocprofiler() && !_is_empty))
         {
 #if OMNITRACE_HIP_VERSION < 50500
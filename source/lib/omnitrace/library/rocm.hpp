@@ -30,6 +30,8 @@
 
 #include <cstdint>
 #include <mutex>
+#include <string>
+#include <string_view>
 
 namespace omnitrace
 {
@@ -39,6 +41,24 @@ using lock_t = std::unique_lock<std::mutex>;
 
 extern std::mutex rocm_mutex;
 extern bool       is_loaded;
+
+/// interned GPU kernel symbol shared by the roctracer and rocprofiler output
+struct kernel_symbol
+{
+    uint32_t    id      = 0;
+    std::string mangled = {};  ///< symbol as reported by the runtime
+    std::string name    = {};  ///< demangled with any suffix after the arguments removed
+};
+
+/// returns the interned symbol for the kernel name. The name is demangled and
+/// truncated the first time it is seen. The returned reference remains valid (and
+/// the id unchanged) for the remainder of the process
+const kernel_symbol&
+get_kernel_symbol(std::string_view _mangled);
+
+/// returns the interned symbol for an id returned from a previous lookup
+const kernel_symbol&
+get_kernel_symbol(uint32_t _id);
 }  // namespace rocm
 }  // namespace omnitrace
 
@@ -0,0 +1,701 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/rocm/queue_trace.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/state.hpp"
+#include "library/housekeeping.hpp"
+#include "library/rocm.hpp"
+#include "library/roctracer.hpp"
+#include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#define AMD_INTERNAL_BUILD 1
+#include <hsa.h>
+#include <hsa_api_trace.h>
+#include <hsa_ext_amd.h>
+#include <roctracer_hip.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace rocm
+{
+namespace queue_trace
+{
+namespace
+{
+using packet_t = hsa_kernel_dispatch_packet_t;
+
+static_assert(sizeof(packet_t) == sizeof(hsa_barrier_and_packet_t),
+              "AQL packets are expected to have the same size");
+
+// how long the background thread waits on the oldest dispatch before checking the
+// other queues and whether it should stop
+constexpr auto wait_interval = std::chrono::milliseconds{ 1 };
+
+// the runtime functions which are replaced in the table
+struct hsa_functions
+{
+    decltype(hsa_queue_create)*                       queue_create           = nullptr;
+    decltype(hsa_queue_destroy)*                      queue_destroy          = nullptr;
+    decltype(hsa_executable_freeze)*                  executable_freeze      = nullptr;
+    decltype(hsa_executable_iterate_symbols)*         iterate_symbols        = nullptr;
+    decltype(hsa_executable_symbol_get_info)*         symbol_get_info        = nullptr;
+    decltype(hsa_agent_get_info)*                     agent_get_info         = nullptr;
+    decltype(hsa_iterate_agents)*                     iterate_agents         = nullptr;
+    decltype(hsa_system_get_info)*                    system_get_info        = nullptr;
+    decltype(hsa_signal_create)*                      signal_create          = nullptr;
+    decltype(hsa_signal_destroy)*                     signal_destroy         = nullptr;
+    decltype(hsa_signal_load_scacquire)*              signal_load_scacquire  = nullptr;
+    decltype(hsa_signal_store_screlease)*             signal_store_screlease = nullptr;
+    decltype(hsa_signal_wait_scacquire)*              signal_wait_scacquire  = nullptr;
+    decltype(hsa_amd_queue_intercept_create)*         intercept_create       = nullptr;
+    decltype(hsa_amd_queue_intercept_register)*       intercept_register     = nullptr;
+    decltype(hsa_amd_profiling_set_profiler_enabled)* set_profiler_enabled   = nullptr;
+    decltype(hsa_amd_profiling_get_dispatch_time)*    get_dispatch_time      = nullptr;
+};
+
+hsa_functions hsa_fn = {};
+
+std::atomic<bool> is_setup = { false };
+
+// the dispatches are only timed while the background thread runs
+std::atomic<bool> is_active = { false };
+
+// a kernel dispatch which was submitted with an injected completion signal
+struct dispatch_slot
+{
+    hsa_signal_t signal        = { 0 };  ///< injected completion signal
+    hsa_signal_t forward       = { 0 };  ///< original completion signal, if any
+    uint64_t     kernel_object = 0;
+    uint64_t     corr_id       = 0;
+};
+
+// the slots in [tail, head) are in flight and the slots before released can be re-used.
+// The signal of a slot with a forwarded completion signal is only reset once the next
+// dispatch completed, at which point the packet processor has executed the barrier
+// which waited on it
+struct traced_queue
+{
+    traced_queue(hsa_queue_t* _queue, hsa_agent_t _agent, int32_t _device,
+                 size_t _capacity);
+    ~traced_queue();
+
+    traced_queue(const traced_queue&) = delete;
+    traced_queue& operator=(const traced_queue&) = delete;
+
+    bool     submit(const packet_t& _packet, std::vector<packet_t>& _out);
+    size_t   process();
+    bool     in_flight() const { return tail.load() != head.load(); }
+    uint64_t id() const { return queue_id; }
+
+    hsa_queue_t*                     queue        = nullptr;
+    uint64_t                         queue_id     = 0;
+    hsa_agent_t                      agent        = { 0 };
+    int32_t                          device       = 0;
+    size_t                           mask         = 0;
+    uint64_t                         dropped      = 0;
+    locking::atomic_mutex            submit_mutex = {};
+    std::mutex                       mutex        = {};
+    std::atomic<uint64_t>            head         = { 0 };
+    std::atomic<uint64_t>            tail         = { 0 };
+    std::atomic<uint64_t>            released     = { 0 };
+    std::unique_ptr<dispatch_slot[]> slots        = {};
+};
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+// requires the mutex to be held
+auto&
+get_queues()
+{
+    static auto _v = std::vector<std::shared_ptr<traced_queue>>{};
+    return _v;
+}
+
+// incremented when a queue is added or removed so the background thread only copies
+// the list when it changed
+std::atomic<uint64_t> queues_generation = { 0 };
+
+// kernel object -> interned kernel symbol id
+struct kernel_object_table
+{
+    std::shared_mutex                      mutex = {};
+    std::unordered_map<uint64_t, uint32_t> ids   = {};
+};
+
+auto&
+get_kernel_objects()
+{
+    // intentionally leaked: the dispatches may still be processed during exit
+    static auto* _v = new kernel_object_table{};
+    return *_v;
+}
+
+// the HIP device ordinal of each GPU agent
+auto&
+get_agent_devices()
+{
+    static auto _v = std::unordered_map<uint64_t, int32_t>{};
+    return _v;
+}
+
+// conversion of the HSA system timestamps to nanoseconds
+uint64_t timestamp_frequency = 1000000000;
+
+uint64_t
+get_timestamp_ns(uint64_t _ticks)
+{
+    constexpr uint64_t nsec = 1000000000;
+    if(timestamp_frequency == nsec) return _ticks;
+    return (_ticks / timestamp_frequency) * nsec +
+           ((_ticks % timestamp_frequency) * nsec) / timestamp_frequency;
+}
+
+uint16_t
+get_packet_type(const packet_t& _packet)
+{
+    return (_packet.header >> HSA_PACKET_HEADER_TYPE) &
+           ((1 << HSA_PACKET_HEADER_WIDTH_TYPE) - 1);
+}
+
+traced_queue::traced_queue(hsa_queue_t* _queue, hsa_agent_t _agent, int32_t _device,
+                           size_t _capacity)
+: queue{ _queue }
+, queue_id{ _queue->id }
+, agent{ _agent }
+, device{ _device }
+{
+    size_t _n = 1;
+    while(_n < std::max<size_t>(_capacity, 2))
+        _n <<= 1;
+    mask  = _n - 1;
+    slots = std::make_unique<dispatch_slot[]>(_n);
+}
+
+traced_queue::~traced_queue()
+{
+    OMNITRACE_WARNING_IF_F(dropped > 0,
+                           "%lu kernel dispatches on HSA queue %lu were not timed "
+                           "because %zu dispatches were in flight. Increase "
+                           "OMNITRACE_ROCM_QUEUE_TRACE_SIZE to time every dispatch\n",
+                           dropped, id(), mask + 1);
+
+    for(size_t i = 0; i <= mask; ++i)
+    {
+        if(slots[i].signal.handle != 0) hsa_fn.signal_destroy(slots[i].signal);
+    }
+}
+
+// called by the submitting thread with the submit mutex held
+bool
+traced_queue::submit(const packet_t& _packet, std::vector<packet_t>& _out)
+{
+    auto _head = head.load(std::memory_order_relaxed);
+    if(_head - released.load(std::memory_order_acquire) > mask)
+    {
+        ++dropped;
+        return false;
+    }
+
+    auto& _slot = slots[_head & mask];
+    if(_slot.signal.handle == 0 &&
+       hsa_fn.signal_create(1, 0, nullptr, &_slot.signal) != HSA_STATUS_SUCCESS)
+    {
+        _slot.signal.handle = 0;
+        ++dropped;
+        return false;
+    }
+
+    _slot.forward       = _packet.completion_signal;
+    _slot.kernel_object = _packet.kernel_object;
+    _slot.corr_id       = get_hip_launch_correlation_id();
+
+    auto& _dispatch             = _out.emplace_back(_packet);
+    _dispatch.completion_signal = _slot.signal;
+
+    if(_slot.forward.handle != 0)
+    {
+        // completes the original signal on the device once the dispatch completed with
+        // the release fence which the dispatch had
+        constexpr uint16_t scope_mask =
+            (1 << HSA_PACKET_HEADER_WIDTH_SCRELEASE_FENCE_SCOPE) - 1;
+        auto _scope = (_packet.header >> HSA_PACKET_HEADER_SCRELEASE_FENCE_SCOPE) &
+                      scope_mask;
+
+        auto _barrier = hsa_barrier_and_packet_t{};
+        std::memset(&_barrier, 0, sizeof(_barrier));
+        _barrier.header = (HSA_PACKET_TYPE_BARRIER_AND << HSA_PACKET_HEADER_TYPE) |
+                          (_scope << HSA_PACKET_HEADER_SCRELEASE_FENCE_SCOPE);
+        _barrier.dep_signal[0]     = _slot.signal;
+        _barrier.completion_signal = _slot.forward;
+        std::memcpy(&_out.emplace_back(), &_barrier, sizeof(_barrier));
+    }
+
+    head.store(_head + 1, std::memory_order_release);
+    return true;
+}
+
+// called by the background thread or during a flush with the mutex held
+size_t
+traced_queue::process()
+{
+    auto _head  = head.load(std::memory_order_acquire);
+    auto _tail  = tail.load(std::memory_order_relaxed);
+    auto _begin = _tail;
+
+    for(; _tail < _head; ++_tail)
+    {
+        auto& _slot = slots[_tail & mask];
+        if(hsa_fn.signal_load_scacquire(_slot.signal) > 0) break;
+
+        auto _time = hsa_amd_profiling_dispatch_time_t{};
+        if(get_state() == State::Active &&
+           trait::runtime_enabled<comp::roctracer>::get() &&
+           hsa_fn.get_dispatch_time(agent, _slot.signal, &_time) == HSA_STATUS_SUCCESS)
+        {
+            const char* _name = "KernelExecution";
+            {
+                auto& _table = get_kernel_objects();
+                auto  _lk    = std::shared_lock<std::shared_mutex>{ _table.mutex };
+                auto  itr    = _table.ids.find(_slot.kernel_object);
+                if(itr != _table.ids.end())
+                    _name = get_kernel_symbol(itr->second).mangled.c_str();
+            }
+
+            hip_device_activity_callback(HIP_OP_ID_DISPATCH, _slot.corr_id, _name,
+                                         device, id(), get_timestamp_ns(_time.start),
+                                         get_timestamp_ns(_time.end), 0);
+        }
+
+        // the previous slot was kept for the barrier which forwarded its signal
+        auto _released = released.load(std::memory_order_relaxed);
+        if(_released < _tail)
+            hsa_fn.signal_store_screlease(slots[_released & mask].signal, 1);
+
+        if(_slot.forward.handle == 0)
+        {
+            hsa_fn.signal_store_screlease(_slot.signal, 1);
+            released.store(_tail + 1, std::memory_order_release);
+        }
+        else
+        {
+            released.store(_tail, std::memory_order_release);
+        }
+    }
+
+    tail.store(_tail, std::memory_order_release);
+    return (_tail - _begin);
+}
+
+traced_queue*
+find_queue(const void* _data)
+{
+    return static_cast<traced_queue*>(const_cast<void*>(_data));
+}
+
+void
+submit_packets(const void* _packets, uint64_t _count, uint64_t, void* _data,
+               hsa_amd_queue_intercept_packet_writer _writer)
+{
+    auto* _queue = find_queue(_data);
+    if(!is_active.load(std::memory_order_relaxed) || _queue == nullptr)
+    {
+        _writer(_packets, _count);
+        return;
+    }
+
+    // each dispatch becomes at most two packets
+    static thread_local auto _out = std::vector<packet_t>{};
+    _out.clear();
+    _out.reserve(2 * _count);
+
+    const auto* _begin = static_cast<const packet_t*>(_packets);
+    {
+        locking::atomic_lock _lk{ _queue->submit_mutex };
+        for(uint64_t i = 0; i < _count; ++i)
+        {
+            const auto& _packet = _begin[i];
+            if(get_packet_type(_packet) != HSA_PACKET_TYPE_KERNEL_DISPATCH ||
+               !_queue->submit(_packet, _out))
+                _out.emplace_back(_packet);
+        }
+    }
+
+    _writer(_out.data(), _out.size());
+}
+
+hsa_status_t
+register_kernel_symbol(hsa_executable_t, hsa_executable_symbol_t _symbol, void*)
+{
+    auto _kind = hsa_symbol_kind_t{};
+    if(hsa_fn.symbol_get_info(_symbol, HSA_EXECUTABLE_SYMBOL_INFO_TYPE, &_kind) !=
+           HSA_STATUS_SUCCESS ||
+       _kind != HSA_SYMBOL_KIND_KERNEL)
+        return HSA_STATUS_SUCCESS;
+
+    uint64_t _object = 0;
+    uint32_t _length = 0;
+    if(hsa_fn.symbol_get_info(_symbol, HSA_EXECUTABLE_SYMBOL_INFO_KERNEL_OBJECT,
+                              &_object) != HSA_STATUS_SUCCESS ||
+       hsa_fn.symbol_get_info(_symbol, HSA_EXECUTABLE_SYMBOL_INFO_NAME_LENGTH,
+                              &_length) != HSA_STATUS_SUCCESS)
+        return HSA_STATUS_SUCCESS;
+
+    auto _name = std::string(_length, '\0');
+    if(hsa_fn.symbol_get_info(_symbol, HSA_EXECUTABLE_SYMBOL_INFO_NAME, _name.data()) !=
+       HSA_STATUS_SUCCESS)
+        return HSA_STATUS_SUCCESS;
+
+    // the kernel descriptor suffix is not part of the name reported by HIP
+    constexpr auto descriptor_suffix = std::string_view{ ".kd" };
+    if(_name.length() > descriptor_suffix.length() &&
+       std::string_view{ _name }.substr(_name.length() - descriptor_suffix.length()) ==
+           descriptor_suffix)
+        _name.resize(_name.length() - descriptor_suffix.length());
+
+    auto  _id    = get_kernel_symbol(_name).id;
+    auto& _table = get_kernel_objects();
+    auto  _lk    = std::unique_lock<std::shared_mutex>{ _table.mutex };
+    _table.ids[_object] = _id;
+    return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t
+executable_freeze(hsa_executable_t _executable, const char* _options)
+{
+    auto _status = hsa_fn.executable_freeze(_executable, _options);
+    if(_status == HSA_STATUS_SUCCESS)
+        hsa_fn.iterate_symbols(_executable, register_kernel_symbol, nullptr);
+    return _status;
+}
+
+hsa_status_t
+register_agent(hsa_agent_t _agent, void* _data)
+{
+    auto _type = hsa_device_type_t{};
+    if(hsa_fn.agent_get_info(_agent, HSA_AGENT_INFO_DEVICE, &_type) ==
+           HSA_STATUS_SUCCESS &&
+       _type == HSA_DEVICE_TYPE_GPU)
+    {
+        auto* _count = static_cast<int32_t*>(_data);
+        get_agent_devices().emplace(_agent.handle, (*_count)++);
+    }
+    return HSA_STATUS_SUCCESS;
+}
+
+hsa_status_t
+queue_create(hsa_agent_t _agent, uint32_t _size, hsa_queue_type32_t _type,
+             void (*_callback)(hsa_status_t, hsa_queue_t*, void*), void* _data,
+             uint32_t _private_segment_size, uint32_t _group_segment_size,
+             hsa_queue_t** _queue)
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+
+    if(get_agent_devices().empty())
+    {
+        int32_t _count = 0;
+        hsa_fn.iterate_agents(register_agent, &_count);
+    }
+
+    auto _device = get_agent_devices().find(_agent.handle);
+    if(!is_active.load() || _device == get_agent_devices().end())
+        return hsa_fn.queue_create(_agent, _size, _type, _callback, _data,
+                                   _private_segment_size, _group_segment_size, _queue);
+
+    auto _status =
+        hsa_fn.intercept_create(_agent, _size, _type, _callback, _data,
+                                _private_segment_size, _group_segment_size, _queue);
+    if(_status != HSA_STATUS_SUCCESS) return _status;
+
+    static auto _capacity =
+        config::get_setting_value<size_t>("OMNITRACE_ROCM_QUEUE_TRACE_SIZE")
+            .value_or(1024);
+
+    auto _traced =
+        std::make_shared<traced_queue>(*_queue, _agent, _device->second, _capacity);
+    if(hsa_fn.set_profiler_enabled(*_queue, 1) == HSA_STATUS_SUCCESS &&
+       hsa_fn.intercept_register(*_queue, submit_packets, _traced.get()) ==
+           HSA_STATUS_SUCCESS)
+    {
+        get_queues().emplace_back(std::move(_traced));
+        ++queues_generation;
+    }
+    else
+    {
+        OMNITRACE_WARNING_F(0, "kernel dispatches on HSA queue %lu will not be timed\n",
+                            (*_queue)->id);
+    }
+    return _status;
+}
+
+hsa_status_t
+queue_destroy(hsa_queue_t* _queue)
+{
+    auto _traced = std::shared_ptr<traced_queue>{};
+    {
+        auto  _lk     = std::unique_lock<std::mutex>{ get_mutex() };
+        auto& _queues = get_queues();
+        for(auto itr = _queues.begin(); itr != _queues.end(); ++itr)
+        {
+            if((*itr)->queue == _queue)
+            {
+                _traced = std::move(*itr);
+                _queues.erase(itr);
+                ++queues_generation;
+                break;
+            }
+        }
+    }
+
+    if(_traced)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _traced->mutex };
+        _traced->process();
+    }
+
+    return hsa_fn.queue_destroy(_queue);
+}
+
+// waits on the oldest dispatch of the first queue with dispatches in flight. Returns
+// false if there are none
+bool
+wait(const std::vector<std::shared_ptr<traced_queue>>& _queues)
+{
+    for(const auto& itr : _queues)
+    {
+        if(!itr->in_flight()) continue;
+
+        auto _signal = itr->slots[itr->tail.load() & itr->mask].signal;
+        auto _timeout =
+            (timestamp_frequency * wait_interval.count()) / std::milli::den;
+        hsa_fn.signal_wait_scacquire(_signal, HSA_SIGNAL_CONDITION_LT, 1, _timeout,
+                                     HSA_WAIT_STATE_BLOCKED);
+        return true;
+    }
+    return false;
+}
+
+size_t
+process(const std::vector<std::shared_ptr<traced_queue>>& _queues)
+{
+    size_t _n = 0;
+    for(const auto& itr : _queues)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ itr->mutex };
+        _n += itr->process();
+    }
+    if(_n > 0 && get_use_perfetto()) ::perfetto::TrackEvent::Flush();
+    return _n;
+}
+
+auto
+get_queues_copy()
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    return get_queues();
+}
+
+void
+start_collector()
+{
+    if(get_thread()) return;
+
+    auto _func = []() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.hsa.queue");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        auto _generation = uint64_t{ 0 };
+        auto _queues     = std::vector<std::shared_ptr<traced_queue>>{};
+        while(is_active.load())
+        {
+            if(_generation != queues_generation.load())
+            {
+                _generation = queues_generation.load();
+                _queues     = get_queues_copy();
+            }
+
+            if(process(_queues) > 0 || wait(_queues)) continue;
+
+            auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+            get_cv().wait_for(_lk, wait_interval);
+        }
+    };
+
+    is_active.store(true);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_thread() = std::make_unique<std::thread>(_func);
+}
+}  // namespace
+
+bool
+setup(HsaApiTable* _table)
+{
+    if(_table == nullptr || is_setup.load()) return is_setup.load();
+
+    if(!config::get_setting_value<bool>("OMNITRACE_ROCM_QUEUE_TRACE").value_or(false) ||
+       !config::get_use_roctracer() || !config::get_trace_hip_activity())
+        return false;
+
+    if(config::get_use_rocprofiler() &&
+       (!config::get_rocm_events().empty() || config::get_rocm_roofline()))
+    {
+        OMNITRACE_WARNING_F(0, "OMNITRACE_ROCM_QUEUE_TRACE is not supported with the "
+                               "rocprofiler hardware counters. The kernel dispatches "
+                               "are traced by roctracer\n");
+        return false;
+    }
+
+    auto* _core = _table->core_;
+    auto* _amd  = _table->amd_ext_;
+    if(_core == nullptr || _amd == nullptr ||
+       _amd->hsa_amd_queue_intercept_create_fn == nullptr ||
+       _amd->hsa_amd_queue_intercept_register_fn == nullptr)
+    {
+        OMNITRACE_WARNING_F(0, "OMNITRACE_ROCM_QUEUE_TRACE is not supported by the HSA "
+                               "runtime. The kernel dispatches are traced by "
+                               "roctracer\n");
+        return false;
+    }
+
+    hsa_fn.queue_create           = _core->hsa_queue_create_fn;
+    hsa_fn.queue_destroy          = _core->hsa_queue_destroy_fn;
+    hsa_fn.executable_freeze      = _core->hsa_executable_freeze_fn;
+    hsa_fn.iterate_symbols        = _core->hsa_executable_iterate_symbols_fn;
+    hsa_fn.symbol_get_info        = _core->hsa_executable_symbol_get_info_fn;
+    hsa_fn.agent_get_info         = _core->hsa_agent_get_info_fn;
+    hsa_fn.iterate_agents         = _core->hsa_iterate_agents_fn;
+    hsa_fn.system_get_info        = _core->hsa_system_get_info_fn;
+    hsa_fn.signal_create          = _core->hsa_signal_create_fn;
+    hsa_fn.signal_destroy         = _core->hsa_signal_destroy_fn;
+    hsa_fn.signal_load_scacquire  = _core->hsa_signal_load_scacquire_fn;
+    hsa_fn.signal_store_screlease = _core->hsa_signal_store_screlease_fn;
+    hsa_fn.signal_wait_scacquire  = _core->hsa_signal_wait_scacquire_fn;
+    hsa_fn.intercept_create       = _amd->hsa_amd_queue_intercept_create_fn;
+    hsa_fn.intercept_register     = _amd->hsa_amd_queue_intercept_register_fn;
+    hsa_fn.set_profiler_enabled   = _amd->hsa_amd_profiling_set_profiler_enabled_fn;
+    hsa_fn.get_dispatch_time      = _amd->hsa_amd_profiling_get_dispatch_time_fn;
+
+    uint64_t _frequency = 0;
+    if(hsa_fn.system_get_info(HSA_SYSTEM_INFO_TIMESTAMP_FREQUENCY, &_frequency) ==
+           HSA_STATUS_SUCCESS &&
+       _frequency > 0)
+        timestamp_frequency = _frequency;
+
+    _core->hsa_queue_create_fn      = queue_create;
+    _core->hsa_queue_destroy_fn     = queue_destroy;
+    _core->hsa_executable_freeze_fn = executable_freeze;
+
+    start_collector();
+    is_setup.store(true);
+
+    OMNITRACE_VERBOSE_F(1, "kernel dispatches are timed through the HSA queues\n");
+    return true;
+}
+
+bool
+is_enabled()
+{
+    return is_setup.load();
+}
+
+void
+flush()
+{
+    if(!is_setup.load()) return;
+
+    auto _queues = get_queues_copy();
+    auto _end    = std::chrono::steady_clock::now() + std::chrono::seconds{ 1 };
+    while(true)
+    {
+        process(_queues);
+
+        bool _in_flight = false;
+        for(const auto& itr : _queues)
+            _in_flight = _in_flight || itr->in_flight();
+
+        if(!_in_flight || std::chrono::steady_clock::now() >= _end) break;
+        wait(_queues);
+    }
+}
+
+void
+shutdown()
+{
+    if(!is_setup.load()) return;
+
+    flush();
+
+    if(get_thread())
+    {
+        is_active.store(false);
+        get_cv().notify_all();
+        get_thread()->join();
+        get_thread().reset();
+    }
+}
+}  // namespace queue_trace
+}  // namespace rocm
+}  // namespace omnitrace
@@ -0,0 +1,90 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+extern "C"
+{
+    struct HsaApiTable;
+}
+
+namespace omnitrace
+{
+namespace rocm
+{
+/// kernel dispatch timing through the HSA queues (see OMNITRACE_ROCM_QUEUE_TRACE).
+/// The queues created by the runtime are replaced by intercept queues: when a kernel
+/// dispatch packet is submitted, its completion signal is replaced with a signal from
+/// a per-queue ring and, if the packet had a completion signal, a barrier-AND packet
+/// which depends on the injected signal and completes the original one is written
+/// after it so the device releases the application without any host involvement. A
+/// background thread waits on the injected signals in submission order, reads the
+/// dispatch timestamps and passes them to the same output as the roctracer activity
+/// records. The submitting thread only copies the packets and records the kernel
+/// object and the correlation id of the HIP launch in progress
+namespace queue_trace
+{
+/// installs the queue and executable interceptors in the HSA API table. Returns false
+/// if the queue tracing is not enabled or not supported by the runtime
+bool
+setup(HsaApiTable* _table);
+
+/// true if the kernel dispatches are timed through the HSA queues
+bool
+is_enabled();
+
+/// processes every dispatch which completed, waiting up to a second for the dispatches
+/// still in flight
+void
+flush();
+
+/// flushes and stops the background thread. The queues remain intercepted but the
+/// dispatches are no longer timed
+void
+shutdown();
+
+#if !defined(OMNITRACE_USE_ROCTRACER)
+inline bool
+setup(HsaApiTable*)
+{
+    return false;
+}
+
+inline bool
+is_enabled()
+{
+    return false;
+}
+
+inline void
+flush()
+{}
+
+inline void
+shutdown()
+{}
+#endif
+}  // namespace queue_trace
+}  // namespace rocm
+}  // namespace omnitrace
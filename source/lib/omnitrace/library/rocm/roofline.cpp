@@ -0,0 +1,457 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/rocm/roofline.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/rocm.hpp"
+#include "library/rocm/hsa_rsrc_factory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <hsa.h>
+#include <hsa_ext_amd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace omnitrace
+{
+namespace rocm
+{
+namespace roofline
+{
+namespace
+{
+using ::rocprofiler::util::AgentInfo;
+
+// the FP32 lanes of a compute unit on GCN and CDNA, each of which retires one FMA
+// (two FLOPs) per clock
+constexpr double fp32_lanes_per_cu = 64.0;
+
+// FETCH_SIZE and WRITE_SIZE are derived from the TCC EA requests in KB
+constexpr double kb_bytes = 1024.0;
+
+// the clocks are reported in MHz and the rates are written per billion
+constexpr double mega = 1.0e6;
+constexpr double giga = 1.0e9;
+
+struct group_data
+{
+    uint64_t            count  = 0;
+    std::vector<double> values = {};
+};
+
+struct kernel_data
+{
+    uint64_t                count          = 0;  // roctracer
+    uint64_t                time           = 0;
+    uint64_t                profiled_count = 0;  // rocprofiler
+    uint64_t                profiled_time  = 0;
+    std::vector<group_data> groups         = {};
+};
+
+struct device_data
+{
+    std::string                     name       = {};
+    double                          peak_flops = 0.0;  // per second
+    double                          peak_bytes = 0.0;  // per second
+    std::vector<counter_group>      groups     = {};
+    std::map<uint32_t, kernel_data> kernels    = {};
+};
+
+struct roofline_data
+{
+    std::mutex                      mutex   = {};
+    std::map<uint32_t, device_data> devices = {};
+};
+
+auto&
+get_data()
+{
+    static auto* _v = new roofline_data{};
+    return *_v;
+}
+
+// the FLOPs of the VALU instructions of one precision: the instructions are counted
+// per wave so they are scaled by the 64 lanes of a wave and an FMA is two FLOPs
+counter_group
+get_valu_group(std::string_view _type)
+{
+    return counter_group{ { JOIN("", "SQ_INSTS_VALU_ADD_", _type), 64.0, 0.0 },
+                          { JOIN("", "SQ_INSTS_VALU_MUL_", _type), 64.0, 0.0 },
+                          { JOIN("", "SQ_INSTS_VALU_FMA_", _type), 128.0, 0.0 },
+                          { JOIN("", "SQ_INSTS_VALU_TRANS_", _type), 64.0, 0.0 } };
+}
+
+std::vector<counter_group>
+get_counter_groups(std::string_view _name, uint32_t _wave_size)
+{
+    auto _starts_with = [_name](std::string_view _v) { return _name.find(_v) == 0; };
+    bool _cdna        = _starts_with("gfx908") || _starts_with("gfx90a") ||
+                 _starts_with("gfx94");
+    bool _mfma_mops = _starts_with("gfx90a") || _starts_with("gfx94");
+
+    auto _v = std::vector<counter_group>{};
+    _v.emplace_back(counter_group{ { "FETCH_SIZE", 0.0, kb_bytes },
+                                   { "WRITE_SIZE", 0.0, kb_bytes } });
+    if(_cdna)
+    {
+        for(const auto* itr : { "F16", "F32", "F64" })
+            _v.emplace_back(get_valu_group(itr));
+    }
+    else
+    {
+        // the other architectures do not count the VALU instructions by type so every
+        // lane of a VALU instruction is counted as one operation
+        _v.emplace_back(counter_group{ { "SQ_INSTS_VALU", 1.0 * _wave_size, 0.0 } });
+    }
+
+    // each unit of the MFMA MOPS counters is 512 FLOPs
+    if(_mfma_mops)
+    {
+        _v.emplace_back(counter_group{ { "SQ_INSTS_VALU_MFMA_MOPS_F16", 512.0, 0.0 },
+                                       { "SQ_INSTS_VALU_MFMA_MOPS_BF16", 512.0, 0.0 },
+                                       { "SQ_INSTS_VALU_MFMA_MOPS_F32", 512.0, 0.0 },
+                                       { "SQ_INSTS_VALU_MFMA_MOPS_F64", 512.0, 0.0 } });
+    }
+    return _v;
+}
+
+uint32_t
+get_agent_info(hsa_agent_t _agent, int _attr)
+{
+    uint32_t _v = 0;
+    if(hsa_agent_get_info(_agent, static_cast<hsa_agent_info_t>(_attr), &_v) !=
+       HSA_STATUS_SUCCESS)
+        return 0;
+    return _v;
+}
+
+struct kernel_entry
+{
+    uint32_t    device    = 0;
+    std::string name      = {};
+    uint64_t    count     = 0;
+    double      time      = 0.0;  // seconds
+    double      flops     = 0.0;
+    double      bytes     = 0.0;
+    double      intensity = 0.0;  // FLOPs per byte
+    double      fraction  = 0.0;  // of the attainable FLOP rate
+    bool        memory    = false;
+    size_t      passes    = 0;
+    size_t      groups    = 0;
+};
+
+std::vector<kernel_entry>
+get_entries()
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  _v    = std::vector<kernel_entry>{};
+
+    for(const auto& ditr : _data.devices)
+    {
+        const auto& _dev   = ditr.second;
+        auto        _ridge = 0.0;
+        if(_dev.peak_bytes > 0.0) _ridge = _dev.peak_flops / _dev.peak_bytes;
+        for(const auto& kitr : _dev.kernels)
+        {
+            const auto& _kern = kitr.second;
+            if(_kern.profiled_count == 0) continue;
+
+            auto _entry   = kernel_entry{};
+            _entry.device = ditr.first;
+            _entry.name   = rocm::get_kernel_symbol(kitr.first).name;
+            _entry.count  = (_kern.count > 0) ? _kern.count : _kern.profiled_count;
+            _entry.time   = static_cast<double>((_kern.count > 0) ? _kern.time
+                                                                  : _kern.profiled_time);
+            _entry.time /= units::sec;
+            _entry.groups = _dev.groups.size();
+
+            // the average of each counter over the dispatches which collected its
+            // group, extrapolated to every dispatch of the kernel
+            for(size_t g = 0; g < _kern.groups.size() && g < _dev.groups.size(); ++g)
+            {
+                const auto& _group = _kern.groups.at(g);
+                if(_group.count == 0) continue;
+                ++_entry.passes;
+                auto _scale = static_cast<double>(_entry.count) /
+                              static_cast<double>(_group.count);
+                for(size_t i = 0; i < _group.values.size(); ++i)
+                {
+                    const auto& _counter = _dev.groups.at(g).at(i);
+                    _entry.flops += _group.values.at(i) * _counter.flops * _scale;
+                    _entry.bytes += _group.values.at(i) * _counter.bytes * _scale;
+                }
+            }
+
+            if(_entry.bytes > 0.0) _entry.intensity = _entry.flops / _entry.bytes;
+            _entry.memory = (_entry.intensity < _ridge);
+
+            auto _attainable =
+                std::min(_dev.peak_flops, _entry.intensity * _dev.peak_bytes);
+            if(_attainable > 0.0 && _entry.time > 0.0)
+                _entry.fraction = (_entry.flops / _entry.time) / _attainable;
+            _v.emplace_back(std::move(_entry));
+        }
+    }
+
+    std::sort(_v.begin(), _v.end(),
+              [](const auto& _lhs, const auto& _rhs) { return _lhs.time > _rhs.time; });
+    return _v;
+}
+
+void
+write_text(const std::vector<kernel_entry>& _entries)
+{
+    auto _fname = tim::settings::compose_output_filename("roofline", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening roofline output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<kernel_entry>{}(_fname, std::string{ "roofline" });
+
+    ofs << std::fixed << std::setprecision(3);
+    {
+        auto& _data = get_data();
+        auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+        for(const auto& itr : _data.devices)
+        {
+            const auto& _dev = itr.second;
+            if(_dev.groups.empty()) continue;
+            ofs << "device " << itr.first << " (" << _dev.name
+                << "): peak: " << (_dev.peak_flops / giga)
+                << " GFLOP/s (FP32 vector), " << (_dev.peak_bytes / giga)
+                << " GB/s, ridge point: "
+                << ((_dev.peak_bytes > 0.0) ? (_dev.peak_flops / _dev.peak_bytes) : 0.0)
+                << " FLOP/byte, passes: " << _dev.groups.size() << "\n";
+        }
+    }
+
+    ofs << "\n"
+        << std::setw(10) << "count" << " | " << std::setw(12) << "time [sec]" << " | "
+        << std::setw(12) << "GFLOP" << " | " << std::setw(12) << "GB" << " | "
+        << std::setw(10) << "FLOP/byte" << " | " << std::setw(12) << "GFLOP/s" << " | "
+        << std::setw(10) << "GB/s" << " | " << std::setw(8) << "% peak" << " | "
+        << std::setw(7) << "bound" << " | " << std::setw(6) << "passes" << " | "
+        << std::setw(6) << "device" << " | "
+        << "kernel\n";
+    for(const auto& itr : _entries)
+    {
+        auto _rate = [&itr](double _v) {
+            return (itr.time > 0.0) ? (_v / itr.time / giga) : 0.0;
+        };
+        ofs << std::setw(10) << itr.count << " | " << std::setw(12) << itr.time << " | "
+            << std::setw(12) << (itr.flops / giga) << " | " << std::setw(12)
+            << (itr.bytes / giga) << " | " << std::setw(10) << itr.intensity
+            << " | " << std::setw(12) << _rate(itr.flops) << " | " << std::setw(10)
+            << _rate(itr.bytes) << " | " << std::setw(8) << (100.0 * itr.fraction)
+            << " | " << std::setw(7) << ((itr.memory) ? "memory" : "compute") << " | "
+            << std::setw(6) << JOIN('/', itr.passes, itr.groups) << " | "
+            << std::setw(6) << itr.device << " | " << itr.name << "\n";
+    }
+}
+
+void
+write_json(const std::vector<kernel_entry>& _entries)
+{
+    namespace cereal = tim::cereal;
+
+    std::stringstream oss{};
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("roofline");
+        ar->startNode();
+
+        ar->setNextName("devices");
+        ar->startNode();
+        ar->makeArray();
+        {
+            auto& _data = get_data();
+            auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+            for(const auto& itr : _data.devices)
+            {
+                if(itr.second.groups.empty()) continue;
+                ar->startNode();
+                (*ar)(cereal::make_nvp("device", itr.first),
+                      cereal::make_nvp("name", itr.second.name),
+                      cereal::make_nvp("peak_flops", itr.second.peak_flops),
+                      cereal::make_nvp("peak_bytes", itr.second.peak_bytes),
+                      cereal::make_nvp("passes", itr.second.groups.size()));
+                ar->finishNode();
+            }
+        }
+        ar->finishNode();
+
+        ar->setNextName("kernels");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _entries)
+        {
+            ar->startNode();
+            (*ar)(cereal::make_nvp("kernel", itr.name),
+                  cereal::make_nvp("device", itr.device),
+                  cereal::make_nvp("count", itr.count),
+                  cereal::make_nvp("time", itr.time),
+                  cereal::make_nvp("flops", itr.flops),
+                  cereal::make_nvp("bytes", itr.bytes),
+                  cereal::make_nvp("intensity", itr.intensity),
+                  cereal::make_nvp("fraction", itr.fraction),
+                  cereal::make_nvp("bound",
+                                   std::string{ (itr.memory) ? "memory" : "compute" }),
+                  cereal::make_nvp("passes", itr.passes));
+            ar->finishNode();
+        }
+        ar->finishNode();
+
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    auto _fname = tim::settings::compose_output_filename("roofline", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening roofline output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<kernel_entry>{}(_fname, std::string{ "roofline" });
+
+    ofs << oss.str() << "\n";
+}
+}  // namespace
+
+std::vector<counter_group>
+setup(const AgentInfo* _agent, const std::set<std::string>& _available)
+{
+    if(!_agent) return std::vector<counter_group>{};
+
+    auto _dev       = device_data{};
+    auto _get_info  = [_agent](int _attr) {
+        return get_agent_info(_agent->dev_id, _attr);
+    };
+    auto _clock     = _get_info(HSA_AMD_AGENT_INFO_MAX_CLOCK_FREQUENCY);
+    auto _mem_clock = _get_info(HSA_AMD_AGENT_INFO_MEMORY_MAX_FREQUENCY);
+    auto _mem_width = _get_info(HSA_AMD_AGENT_INFO_MEMORY_WIDTH);
+    _dev.name       = _agent->name;
+    _dev.groups     = get_counter_groups(_dev.name, _agent->max_wave_size);
+    _dev.peak_flops = 2.0 * fp32_lanes_per_cu * _agent->cu_num * _clock * mega;
+    // double data rate over the memory bus (the width is in bits)
+    _dev.peak_bytes = 2.0 * (_mem_width / 8.0) * _mem_clock * mega;
+
+    if(!_available.empty())
+    {
+        for(auto& gitr : _dev.groups)
+        {
+            auto _n = gitr.size();
+            gitr.erase(std::remove_if(gitr.begin(), gitr.end(),
+                                      [&_available](const counter& _v) {
+                                          return _available.count(_v.name) == 0;
+                                      }),
+                       gitr.end());
+            OMNITRACE_WARNING_IF(gitr.size() < _n,
+                                 "[roofline] %zu counters are not available on device "
+                                 "%u (%s): the FLOPs or bytes will be underestimated\n",
+                                 _n - gitr.size(), _agent->dev_index, _agent->name);
+        }
+        _dev.groups.erase(std::remove_if(_dev.groups.begin(), _dev.groups.end(),
+                                         [](const auto& _v) { return _v.empty(); }),
+                          _dev.groups.end());
+    }
+
+    OMNITRACE_VERBOSE_F(1,
+                        "[roofline] device %u (%s): %zu counter groups, peak "
+                        "%.1f GFLOP/s, %.1f GB/s\n",
+                        _agent->dev_index, _dev.name.c_str(), _dev.groups.size(),
+                        _dev.peak_flops / giga, _dev.peak_bytes / giga);
+
+    auto  _groups = _dev.groups;
+    auto& _data   = get_data();
+    auto  _lk     = std::unique_lock<std::mutex>{ _data.mutex };
+    auto& _entry  = _data.devices[_agent->dev_index];
+    _entry.name       = std::move(_dev.name);
+    _entry.peak_flops = _dev.peak_flops;
+    _entry.peak_bytes = _dev.peak_bytes;
+    _entry.groups     = std::move(_dev.groups);
+    return _groups;
+}
+
+void
+record_duration(int32_t _device, uint32_t _kernel_id, uint64_t _ns)
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto& _kern = _data.devices[std::max<int32_t>(_device, 0)].kernels[_kernel_id];
+    _kern.count += 1;
+    _kern.time += _ns;
+}
+
+void
+record_counters(uint32_t _device, uint32_t _kernel_id, uint32_t _group, uint64_t _ns,
+                const std::vector<double>& _values)
+{
+    auto& _data = get_data();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto& _kern = _data.devices[_device].kernels[_kernel_id];
+    _kern.profiled_count += 1;
+    _kern.profiled_time += _ns;
+
+    if(_kern.groups.size() <= _group) _kern.groups.resize(_group + 1);
+    auto& _entry = _kern.groups.at(_group);
+    if(_entry.values.size() < _values.size()) _entry.values.resize(_values.size(), 0.0);
+    _entry.count += 1;
+    for(size_t i = 0; i < _values.size(); ++i)
+        _entry.values.at(i) += _values.at(i);
+}
+
+void
+post_process()
+{
+    auto _entries = get_entries();
+    if(_entries.empty()) return;
+
+    write_text(_entries);
+    write_json(_entries);
+}
+}  // namespace roofline
+}  // namespace rocm
+}  // namespace omnitrace
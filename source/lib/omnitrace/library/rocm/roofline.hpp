@@ -0,0 +1,106 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace rocprofiler
+{
+namespace util
+{
+struct AgentInfo;
+}  // namespace util
+}  // namespace rocprofiler
+
+namespace omnitrace
+{
+namespace rocm
+{
+/// roofline analysis of the kernels (see OMNITRACE_ROCM_ROOFLINE). The rocprofiler
+/// counters which measure the floating point operations and the DRAM traffic are
+/// picked for the architecture of each device and split into groups which fit in one
+/// pass. The dispatches of each kernel rotate through the groups so every group is
+/// collected on a share of the dispatches and the totals are extrapolated from the
+/// average per dispatch. The durations come from the roctracer activity records of
+/// every dispatch (or from the profiled dispatches without roctracer). The peaks are
+/// estimated from the compute units, the clock and the memory bus of the device
+namespace roofline
+{
+/// a counter and its contribution per unit to the FLOPs and to the bytes
+struct counter
+{
+    std::string name  = {};
+    double      flops = 0.0;
+    double      bytes = 0.0;
+};
+
+using counter_group = std::vector<counter>;
+
+/// registers the device and returns the counter groups to collect on it. Every
+/// group is collected in a separate profiling pool. The counters which are not in
+/// the available counters of the device are removed unless the set is empty
+std::vector<counter_group>
+setup(const ::rocprofiler::util::AgentInfo* _agent,
+      const std::set<std::string>&         _available);
+
+/// records the duration of a dispatch from the roctracer activity callback
+void
+record_duration(int32_t _device, uint32_t _kernel_id, uint64_t _ns);
+
+/// records the counter values of a profiled dispatch. The values are in the order of
+/// the counters of the group
+void
+record_counters(uint32_t _device, uint32_t _kernel_id, uint32_t _group, uint64_t _ns,
+                const std::vector<double>& _values);
+
+/// writes roofline.txt and roofline.json
+void
+post_process();
+
+#if !defined(OMNITRACE_USE_ROCPROFILER) || OMNITRACE_USE_ROCPROFILER == 0
+inline std::vector<counter_group>
+setup(const ::rocprofiler::util::AgentInfo*, const std::set<std::string>&)
+{
+    return std::vector<counter_group>{};
+}
+
+inline void
+record_duration(int32_t, uint32_t, uint64_t)
+{}
+
+inline void
+record_counters(uint32_t, uint32_t, uint32_t, uint64_t, const std::vector<double>&)
+{}
+
+inline void
+post_process()
+{}
+#endif
+}  // namespace roofline
+}  // namespace rocm
+}  // namespace omnitrace
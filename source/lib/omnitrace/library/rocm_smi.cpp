@@ -34,10 +34,14 @@
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
+#include "core/containers/sample_ring.hpp"
 #include "core/debug.hpp"
 #include "core/gpu.hpp"
 #include "core/perfetto.hpp"
+#include "core/persistent_file.hpp"
 #include "core/state.hpp"
+#include "library/memory_footprint.hpp"
+#include "library/process_sampler.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
 
@@ -50,9 +54,14 @@
 
 #include <rocm_smi/rocm_smi.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
+#include <dirent.h>
 #include <ios>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -66,11 +75,21 @@ namespace omnitrace
 {
 namespace rocm_smi
 {
-using bundle_t          = std::deque<data>;
+using bundle_t          = container::sample_ring<int64_t>;
 using sampler_instances = thread_data<bundle_t, category::rocm_smi>;
 
 namespace
 {
+// columns of the per-device sample ring
+enum data_column : size_t
+{
+    busy_column = 0,
+    temp_column,
+    power_column,
+    mem_usage_column,
+    num_columns,
+};
+
 auto&
 get_settings(uint32_t _dev_id)
 {
@@ -112,6 +131,80 @@ get_state()
     static std::atomic<State> _v{ State::PreInit };
     return _v;
 }
+
+// the amdgpu sysfs/hwmon files which back the rocm-smi queries. These are held open
+// for the lifetime of the sampler and re-read with pread() so that each sample
+// is one syscall per metric instead of an open/read/close inside rocm-smi
+struct sysfs_metrics
+{
+    persistent_file busy      = {};  // percent
+    persistent_file temp      = {};  // millidegrees Celsius
+    persistent_file power     = {};  // microwatts
+    persistent_file mem_usage = {};  // bytes
+};
+
+auto&
+get_sysfs_metrics(uint32_t _dev_id)
+{
+    static auto _v = std::unordered_map<uint32_t, sysfs_metrics>{};
+    return _v[_dev_id];
+}
+
+std::string
+find_hwmon_path(const std::string& _device_path)
+{
+    auto  _hwmon_path = _device_path + "hwmon/";
+    auto* _dir        = opendir(_hwmon_path.c_str());
+    if(!_dir) return std::string{};
+
+    auto _path = std::string{};
+    while(auto* _entry = readdir(_dir))
+    {
+        if(std::string_view{ _entry->d_name }.find("hwmon") == 0)
+        {
+            _path = _hwmon_path + _entry->d_name + "/";
+            break;
+        }
+    }
+    closedir(_dir);
+    return _path;
+}
+
+void
+open_sysfs_metrics(uint32_t _dev_id)
+{
+    uint64_t _bdfid = 0;
+    if(rsmi_dev_pci_id_get(_dev_id, &_bdfid) != RSMI_STATUS_SUCCESS) return;
+
+    char _device_path[64];
+    std::snprintf(_device_path, sizeof(_device_path),
+                  "/sys/bus/pci/devices/%04x:%02x:%02x.%x/",
+                  static_cast<uint32_t>(_bdfid >> 32),
+                  static_cast<uint32_t>((_bdfid >> 8) & 0xff),
+                  static_cast<uint32_t>((_bdfid >> 3) & 0x1f),
+                  static_cast<uint32_t>(_bdfid & 0x7));
+
+    auto  _hwmon = find_hwmon_path(_device_path);
+    auto& _files = get_sysfs_metrics(_dev_id);
+
+    _files.busy      = persistent_file{ JOIN("", _device_path, "gpu_busy_percent") };
+    _files.mem_usage = persistent_file{ JOIN("", _device_path, "mem_info_vram_used") };
+    if(!_hwmon.empty())
+    {
+        _files.temp  = persistent_file{ _hwmon + "temp1_input" };
+        _files.power = persistent_file{ _hwmon + "power1_average" };
+        if(!_files.power.is_open())
+            _files.power = persistent_file{ _hwmon + "power1_input" };
+    }
+
+    OMNITRACE_VERBOSE_F(2,
+                        "rocm-smi device %u sysfs metrics from %s :: busy=%s, temp=%s, "
+                        "power=%s, mem_usage=%s\n",
+                        _dev_id, _device_path, (_files.busy.is_open()) ? "y" : "n",
+                        (_files.temp.is_open()) ? "y" : "n",
+                        (_files.power.is_open()) ? "y" : "n",
+                        (_files.mem_usage.is_open()) ? "y" : "n");
+}
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -135,29 +228,39 @@ data::sample(uint32_t _dev_id)
     m_dev_id = _dev_id;
     m_ts     = _ts;
 
-#define OMNITRACE_RSMI_GET(OPTION, FUNCTION, ...)                                        \
+    auto& _sysfs = get_sysfs_metrics(_dev_id);
+
+    // read the persistent sysfs file when it is available and only fall back to the
+    // (much slower) rocm-smi query when it is missing or unreadable
+#define OMNITRACE_RSMI_GET(OPTION, SYSFS, FIELD, FUNCTION, ...)                          \
     if(OPTION)                                                                           \
     {                                                                                    \
-        try                                                                              \
-        {                                                                                \
-            OMNITRACE_ROCM_SMI_CALL(FUNCTION(__VA_ARGS__), &OPTION);                     \
-        } catch(std::runtime_error & _e)                                                 \
-        {                                                                                \
-            OMNITRACE_VERBOSE_F(                                                         \
-                0, "[%s] Exception: %s. Disabling future samples from rocm-smi...\n",    \
-                #FUNCTION, _e.what());                                                   \
-            get_state().store(State::Disabled);                                          \
-        }                                                                                \
+        if(auto _sysfs_v = SYSFS.read_int())                                             \
+            FIELD = static_cast<decltype(FIELD)>(*_sysfs_v);                             \
+        else                                                                             \
+            try                                                                          \
+            {                                                                            \
+                OMNITRACE_ROCM_SMI_CALL(FUNCTION(__VA_ARGS__), &OPTION);                 \
+            } catch(std::runtime_error & _e)                                             \
+            {                                                                            \
+                OMNITRACE_VERBOSE_F(                                                     \
+                    0,                                                                   \
+                    "[%s] Exception: %s. Disabling future samples from rocm-smi...\n",   \
+                    #FUNCTION, _e.what());                                               \
+                get_state().store(State::Disabled);                                      \
+            }                                                                            \
     }
 
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).busy, rsmi_dev_busy_percent_get, _dev_id,
-                       &m_busy_perc);
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).temp, rsmi_dev_temp_metric_get, _dev_id,
-                       RSMI_TEMP_TYPE_EDGE, RSMI_TEMP_CURRENT, &m_temp);
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).power, rsmi_dev_power_ave_get, _dev_id, 0,
-                       &m_power);
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).mem_usage, rsmi_dev_memory_usage_get,
-                       _dev_id, RSMI_MEM_TYPE_VRAM, &m_mem_usage);
+    OMNITRACE_RSMI_GET(get_settings(m_dev_id).busy, _sysfs.busy, m_busy_perc,
+                       rsmi_dev_busy_percent_get, _dev_id, &m_busy_perc);
+    OMNITRACE_RSMI_GET(get_settings(m_dev_id).temp, _sysfs.temp, m_temp,
+                       rsmi_dev_temp_metric_get, _dev_id, RSMI_TEMP_TYPE_EDGE,
+                       RSMI_TEMP_CURRENT, &m_temp);
+    OMNITRACE_RSMI_GET(get_settings(m_dev_id).power, _sysfs.power, m_power,
+                       rsmi_dev_power_ave_get, _dev_id, 0, &m_power);
+    OMNITRACE_RSMI_GET(get_settings(m_dev_id).mem_usage, _sysfs.mem_usage, m_mem_usage,
+                       rsmi_dev_memory_usage_get, _dev_id, RSMI_MEM_TYPE_VRAM,
+                       &m_mem_usage);
 
 #undef OMNITRACE_RSMI_GET
 }
@@ -186,10 +289,33 @@ config()
         {
             _bundle_data.at(i) = &sampler_instances::get()->at(i);
             if(!*_bundle_data.at(i))
-                *_bundle_data.at(i) = unique_ptr_t<bundle_t>{ new bundle_t{} };
+                *_bundle_data.at(i) = unique_ptr_t<bundle_t>{ new bundle_t{
+                    num_columns, process_sampler::get_retention_capacity() } };
         }
     }
 
+    // once the footprint exceeds the budget, the rings only retain the newest half
+    static auto _once = std::once_flag{};
+    std::call_once(_once, []() {
+        if(!config::get_snapshot().memory_footprint) return;
+        auto _size = []() {
+            size_t _v = 0;
+            for(auto* itr : _bundle_data)
+                if(itr && *itr) _v += (*itr)->bytes();
+            return _v;
+        };
+        auto _shed = []() {
+            for(auto* itr : _bundle_data)
+                if(itr && *itr)
+                    (*itr)->set_capacity(std::max<size_t>((*itr)->size() / 2, 1));
+        };
+        memory_footprint::add_source(memory_footprint::process_sampling_subsystem,
+                                     _size, _shed);
+    });
+
+    for(auto itr : data::device_list)
+        open_sysfs_metrics(itr);
+
     data::get_initial().resize(data::device_count);
     for(auto itr : data::device_list)
         data::get_initial().at(itr).sample(itr);
@@ -204,8 +330,14 @@ sample()
         OMNITRACE_DEBUG_F("Polling rocm-smi for device %u...\n", itr);
         auto& _data = *_bundle_data.at(itr);
         if(!_data) continue;
-        _data->emplace_back(data{ itr });
-        OMNITRACE_DEBUG_F("    %s\n", TIMEMORY_JOIN("", _data->back()).c_str());
+        auto _sample = data{ itr };
+        if(_sample.m_dev_id != itr) continue;
+        _data->push(_sample.m_ts, std::array<int64_t, num_columns>{
+                                      static_cast<int64_t>(_sample.m_busy_perc),
+                                      static_cast<int64_t>(_sample.m_temp),
+                                      static_cast<int64_t>(_sample.m_power),
+                                      static_cast<int64_t>(_sample.m_mem_usage) });
+        OMNITRACE_DEBUG_F("    %s\n", TIMEMORY_JOIN("", _sample).c_str());
     }
 }
 
@@ -259,12 +391,16 @@ data::post_process(uint32_t _dev_id)
 
     if(device_count < _dev_id) return;
 
-    auto&       _rocm_smi_v = sampler_instances::get()->at(_dev_id);
-    auto        _rocm_smi   = (_rocm_smi_v) ? *_rocm_smi_v : std::deque<rocm_smi::data>{};
+    const auto& _rocm_smi    = sampler_instances::get()->at(_dev_id);
     const auto& _thread_info = thread_info::get(0, InternalTID);
 
     OMNITRACE_VERBOSE(1, "Post-processing %zu rocm-smi samples from device %u\n",
-                      _rocm_smi.size(), _dev_id);
+                      (_rocm_smi) ? _rocm_smi->size() : size_t{ 0 }, _dev_id);
+    if(_rocm_smi && _rocm_smi->dropped() > 0)
+        OMNITRACE_VERBOSE(1,
+                          "%zu older rocm-smi samples from device %u were discarded "
+                          "(OMNITRACE_PROCESS_SAMPLING_RETENTION)...\n",
+                          _rocm_smi->dropped(), _dev_id);
 
     OMNITRACE_CI_THROW(!_thread_info, "Missing thread info for thread 0");
     if(!_thread_info) return;
@@ -282,32 +418,32 @@ data::post_process(uint32_t _dev_id)
             if(_settings.mem_usage) _idx.at(3) = nidx++;
         }
 
-        for(auto& itr : _rocm_smi)
+        if(!_rocm_smi || _rocm_smi->empty()) return;
+
+        using counter_track = perfetto_counter_track<data>;
+        if(!counter_track::exists(_dev_id))
         {
-            using counter_track = perfetto_counter_track<data>;
-            if(itr.m_dev_id != _dev_id) continue;
-            if(!counter_track::exists(_dev_id))
-            {
-                auto addendum = [&](const char* _v) {
-                    return JOIN(" ", "GPU", _v, JOIN("", '[', _dev_id, ']'), "(S)");
-                };
+            auto addendum = [&](const char* _v) {
+                return JOIN(" ", "GPU", _v, JOIN("", '[', _dev_id, ']'), "(S)");
+            };
 
-                if(_settings.busy) counter_track::emplace(_dev_id, addendum("Busy"), "%");
-                if(_settings.temp)
-                    counter_track::emplace(_dev_id, addendum("Temperature"), "deg C");
-                if(_settings.power)
-                    counter_track::emplace(_dev_id, addendum("Power"), "watts");
-                if(_settings.mem_usage)
-                    counter_track::emplace(_dev_id, addendum("Memory Usage"),
-                                           "megabytes");
-            }
-            uint64_t _ts = itr.m_ts;
-            if(!_thread_info->is_valid_time(_ts)) continue;
+            if(_settings.busy) counter_track::emplace(_dev_id, addendum("Busy"), "%");
+            if(_settings.temp)
+                counter_track::emplace(_dev_id, addendum("Temperature"), "deg C");
+            if(_settings.power)
+                counter_track::emplace(_dev_id, addendum("Power"), "watts");
+            if(_settings.mem_usage)
+                counter_track::emplace(_dev_id, addendum("Memory Usage"), "megabytes");
+        }
 
-            double _busy  = itr.m_busy_perc;
-            double _temp  = itr.m_temp / 1.0e3;
-            double _power = itr.m_power / 1.0e6;
-            double _usage = itr.m_mem_usage / static_cast<double>(units::megabyte);
+        _rocm_smi->for_each([&](uint64_t _ts, size_t _n) {
+            if(!_thread_info->is_valid_time(_ts)) return;
+
+            double _busy  = _rocm_smi->at(busy_column, _n);
+            double _temp  = _rocm_smi->at(temp_column, _n) / 1.0e3;
+            double _power = _rocm_smi->at(power_column, _n) / 1.0e6;
+            double _usage = _rocm_smi->at(mem_usage_column, _n) /
+                            static_cast<double>(units::megabyte);
 
             if(_settings.busy)
                 TRACE_COUNTER("device_busy", counter_track::at(_dev_id, _idx.at(0)), _ts,
@@ -321,7 +457,7 @@ data::post_process(uint32_t _dev_id)
             if(_settings.mem_usage)
                 TRACE_COUNTER("device_memory_usage",
                               counter_track::at(_dev_id, _idx.at(3)), _ts, _usage);
-        }
+        });
     };
 
     if(get_use_perfetto()) _process_perfetto();
@@ -472,6 +608,85 @@ device_count()
 {
     return gpu::rsmi_device_count();
 }
+
+std::optional<double>
+get_energy(uint32_t _dev_id)
+{
+    if(rocm_smi::get_state() != State::Active || data::device_list.count(_dev_id) == 0)
+        return std::nullopt;
+
+    uint64_t _counter    = 0;
+    float    _resolution = 0.0;
+    uint64_t _ts         = 0;
+    if(rsmi_dev_energy_count_get(_dev_id, &_counter, &_resolution, &_ts) !=
+       RSMI_STATUS_SUCCESS)
+        return std::nullopt;
+
+    // the counter is in units of the resolution, which is in microjoules
+    return static_cast<double>(_counter) * _resolution * 1.0e-6;
+}
+
+std::optional<double>
+get_power(uint32_t _dev_id)
+{
+    if(rocm_smi::get_state() != State::Active || data::device_list.count(_dev_id) == 0)
+        return std::nullopt;
+
+    if(auto _v = get_sysfs_metrics(_dev_id).power.read_int())
+        return static_cast<double>(*_v) * 1.0e-6;
+
+    uint64_t _power = 0;
+    if(rsmi_dev_power_ave_get(_dev_id, 0, &_power) != RSMI_STATUS_SUCCESS)
+        return std::nullopt;
+
+    // microwatts
+    return static_cast<double>(_power) * 1.0e-6;
+}
+
+std::optional<double>
+get_busy(uint32_t _dev_id)
+{
+    if(rocm_smi::get_state() != State::Active || data::device_list.count(_dev_id) == 0)
+        return std::nullopt;
+
+    if(auto _v = get_sysfs_metrics(_dev_id).busy.read_int())
+        return static_cast<double>(*_v);
+
+    uint32_t _busy = 0;
+    if(rsmi_dev_busy_percent_get(_dev_id, &_busy) != RSMI_STATUS_SUCCESS)
+        return std::nullopt;
+
+    return static_cast<double>(_busy);
+}
+
+std::optional<uint64_t>
+get_memory_usage(uint32_t _dev_id)
+{
+    if(rocm_smi::get_state() != State::Active || data::device_list.count(_dev_id) == 0)
+        return std::nullopt;
+
+    if(auto _v = get_sysfs_metrics(_dev_id).mem_usage.read_int())
+        return static_cast<uint64_t>(*_v);
+
+    uint64_t _usage = 0;
+    if(rsmi_dev_memory_usage_get(_dev_id, RSMI_MEM_TYPE_VRAM, &_usage) !=
+       RSMI_STATUS_SUCCESS)
+        return std::nullopt;
+
+    return _usage;
+}
+
+std::optional<uint64_t>
+get_pci_id(uint32_t _dev_id)
+{
+    if(rocm_smi::get_state() != State::Active || data::device_list.count(_dev_id) == 0)
+        return std::nullopt;
+
+    uint64_t _bdfid = 0;
+    if(rsmi_dev_pci_id_get(_dev_id, &_bdfid) != RSMI_STATUS_SUCCESS) return std::nullopt;
+
+    return _bdfid;
+}
 }  // namespace rocm_smi
 }  // namespace omnitrace
 
@@ -40,6 +40,7 @@
 #include <future>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <ratio>
 #include <thread>
 #include <tuple>
@@ -69,6 +70,30 @@ void set_state(State);
 uint32_t
 device_count();
 
+/// accumulated energy (in joules) of a sampled device since an arbitrary point in time.
+/// Empty if rocm-smi is not active or the device does not provide an energy counter
+std::optional<double>
+get_energy(uint32_t _dev_id);
+
+/// current average power (in watts) of a sampled device. Empty if rocm-smi is not
+/// active or the power is not available
+std::optional<double>
+get_power(uint32_t _dev_id);
+
+/// current busy percentage of a sampled device. Empty if rocm-smi is not active or the
+/// busy percentage is not available
+std::optional<double>
+get_busy(uint32_t _dev_id);
+
+/// current VRAM usage (in bytes) of a sampled device. Empty if rocm-smi is not active or
+/// the memory usage is not available
+std::optional<uint64_t>
+get_memory_usage(uint32_t _dev_id);
+
+/// PCI BDF id of a sampled device. Empty if rocm-smi is not active
+std::optional<uint64_t>
+get_pci_id(uint32_t _dev_id);
+
 struct settings
 {
     bool busy      = true;
@@ -150,6 +175,36 @@ post_process()
 {}
 
 inline void set_state(State) {}
+
+inline std::optional<double>
+get_energy(uint32_t)
+{
+    return std::nullopt;
+}
+
+inline std::optional<double>
+get_power(uint32_t)
+{
+    return std::nullopt;
+}
+
+inline std::optional<double>
+get_busy(uint32_t)
+{
+    return std::nullopt;
+}
+
+inline std::optional<uint64_t>
+get_memory_usage(uint32_t)
+{
+    return std::nullopt;
+}
+
+inline std::optional<uint64_t>
+get_pci_id(uint32_t)
+{
+    return std::nullopt;
+}
 #endif
 }  // namespace rocm_smi
 }  // namespace omnitrace
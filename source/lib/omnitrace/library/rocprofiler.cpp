@@ -26,8 +26,16 @@
 #include "core/debug.hpp"
 #include "core/gpu.hpp"
 #include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "library/housekeeping.hpp"
+#include "library/ptl.hpp"
 #include "library/rocm.hpp"
 #include "library/rocm/hsa_rsrc_factory.hpp"
+#include "library/rocm/roofline.hpp"
+#include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
 
 #include <timemory/backends/hardware_counters.hpp>
 #include <timemory/manager.hpp>
@@ -37,15 +45,23 @@
 
 #include <rocprofiler.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <dlfcn.h>
+#include <fstream>
 #include <hsa.h>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <sstream>
 #include <string.h>
 #include <string_view>
+#include <thread>
 #include <type_traits>
 #include <unistd.h>
 #include <vector>
@@ -107,12 +123,64 @@ struct context_entry_t
     hsa_agent_t                 agent;
     rocprofiler_group_t         group;
     rocprofiler_callback_data_t data;
+    uint32_t                    kernel_id;
 };
 
-// Context callback arg
+// Context callback arg. Each device has one pool per counter group
 struct callbacks_arg_t
 {
-    rocprofiler_pool_t** pools;
+    std::vector<std::vector<rocprofiler_pool_t*>> pools = {};
+};
+
+// completed dispatch copied out of the profiling context so that the context can be
+// returned to the pool without constructing the rocm_event
+struct dispatch_record
+{
+    using metric_type   = component::rocm_metric_type;
+    using feature_array = std::array<rocprofiler_feature_t, OMNITRACE_ROCM_MAX_COUNTERS>;
+
+    uint32_t      device_id     = 0;
+    uint32_t      thread_id     = 0;
+    uint32_t      queue_id      = 0;
+    uint32_t      kernel_id     = 0;
+    uint32_t      group         = 0;
+    uint32_t      feature_count = 0;
+    metric_type   begin         = 0;
+    metric_type   end           = 0;
+    feature_array features      = {};
+};
+
+// ring of completed dispatches for one device. The completion handler of the
+// device's pool is the only producer and the thread which holds the drain flag is
+// the only consumer. Each device has its own drain thread which converts full
+// batches into the events of the device so the devices never contend with each
+// other during the collection and the post-processing only merges them for output
+struct dispatch_queue
+{
+    static constexpr size_t capacity   = 1024;
+    static constexpr size_t batch_size = capacity / 4;
+
+    explicit dispatch_queue(uint32_t _dev)
+    : device_id{ _dev }
+    {}
+
+    ~dispatch_queue() { stop(); }
+
+    void start();
+    void stop();
+    void notify();
+
+    uint32_t                              device_id = 0;
+    std::atomic<size_t>                   head      = { 0 };  // next record to drain
+    std::atomic<size_t>                   tail      = { 0 };  // next record to fill
+    std::atomic<bool>                     draining  = { false };
+    std::atomic<bool>                     scheduled = { false };
+    std::array<dispatch_record, capacity> records   = {};
+    component::rocm_data_t                events    = {};  // only touched by the drainer
+    bool                                  active    = false;
+    std::mutex                            mutex     = {};
+    std::condition_variable               cv        = {};
+    std::unique_ptr<std::thread>          thread    = {};
 };
 
 // Handler callback arg
@@ -120,8 +188,195 @@ struct handler_arg_t
 {
     rocprofiler_feature_t* features;
     unsigned               feature_count;
+    uint32_t               group;
+    dispatch_queue*        queue;
 };
 
+// exact number of dispatches and number of dispatches which were profiled for each
+// interned kernel symbol id when OMNITRACE_ROCM_EVENTS_SAMPLE_RATE > 1 and the number
+// of profiled dispatches which were assigned a counter group (OMNITRACE_ROCM_ROOFLINE)
+struct dispatch_count
+{
+    std::atomic<uint64_t> total    = { 0 };
+    std::atomic<uint64_t> sampled  = { 0 };
+    std::atomic<uint64_t> rotation = { 0 };
+};
+
+constexpr size_t max_dispatch_counts = (1 << 16);
+
+auto&
+get_dispatch_counts()
+{
+    static auto* _v = new std::array<dispatch_count, max_dispatch_counts>{};
+    return *_v;
+}
+
+size_t
+get_sample_rate()
+{
+    static auto _v = std::max<size_t>(
+        config::get_setting_value<size_t>("OMNITRACE_ROCM_EVENTS_SAMPLE_RATE")
+            .value_or(1),
+        1);
+    return _v;
+}
+
+// returns whether a profiling context should be attached to this dispatch
+bool
+select_dispatch(uint32_t _kernel_id)
+{
+    auto _rate = get_sample_rate();
+    // every dispatch is profiled when kernel ids exceed the table
+    if(_rate == 1 || _kernel_id >= max_dispatch_counts) return true;
+
+    auto& _count = get_dispatch_counts()[_kernel_id];
+    if(_count.total.fetch_add(1, std::memory_order_relaxed) % _rate != 0) return false;
+    _count.sampled.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// returns the counter group of a profiled dispatch when the device has several. The
+// dispatches of each kernel rotate through the groups
+uint32_t
+select_group(uint32_t _kernel_id, size_t _groups)
+{
+    if(_groups <= 1 || _kernel_id >= max_dispatch_counts) return 0;
+
+    auto& _count = get_dispatch_counts()[_kernel_id];
+    return _count.rotation.fetch_add(1, std::memory_order_relaxed) % _groups;
+}
+
+// factor which converts the sum of the sampled counter values into an estimate of
+// the sum over all dispatches
+double
+get_dispatch_scale(uint32_t _kernel_id)
+{
+    if(get_sample_rate() == 1 || _kernel_id >= max_dispatch_counts) return 1.0;
+    const auto& _count   = get_dispatch_counts()[_kernel_id];
+    auto        _sampled = _count.sampled.load();
+    return (_sampled > 0) ? (static_cast<double>(_count.total.load()) / _sampled) : 1.0;
+}
+
+auto&
+get_dispatch_queues()
+{
+    static auto _v = std::vector<std::unique_ptr<dispatch_queue>>{};
+    return _v;
+}
+
+// moves the completed dispatches into the events of the device. Returns false if
+// another thread is already draining the queue
+bool
+drain_dispatch_queue(dispatch_queue& _queue)
+{
+    bool _expected = false;
+    if(!_queue.draining.compare_exchange_strong(_expected, true,
+                                                std::memory_order_acq_rel))
+        return false;
+
+    auto _head = _queue.head.load(std::memory_order_relaxed);
+    auto _tail = _queue.tail.load(std::memory_order_acquire);
+    if(_head != _tail)
+    {
+        auto& _data = _queue.events;
+        _data.reserve(_data.size() + (_tail - _head));
+        for(; _head != _tail; ++_head)
+        {
+            const auto& _rec = _queue.records[_head % dispatch_queue::capacity];
+            auto& _evt = _data.emplace_back(component::rocm_event{
+                _rec.device_id, _rec.thread_id, _rec.queue_id,
+                rocm::get_kernel_symbol(_rec.kernel_id).name, _rec.begin, _rec.end,
+                _rec.feature_count,
+                const_cast<rocprofiler_feature_t*>(_rec.features.data()) });
+            _evt.kernel_id = _rec.kernel_id;
+            _evt.group     = _rec.group;
+        }
+        _queue.head.store(_head, std::memory_order_release);
+    }
+
+    _queue.draining.store(false, std::memory_order_release);
+    return true;
+}
+
+void
+dispatch_queue::start()
+{
+    if(thread) return;
+
+    auto _func = [this]() {
+        thread_info::init(true);
+        threading::set_thread_name(JOIN('.', "omni.rocprof", device_id).c_str());
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        // the timeout bounds how long a partial batch stays in the ring
+        auto _lk = std::unique_lock<std::mutex>{ mutex };
+        while(active)
+        {
+            cv.wait_for(_lk, std::chrono::milliseconds{ 100 }, [this]() {
+                return !active || scheduled.load(std::memory_order_acquire);
+            });
+            scheduled.store(false, std::memory_order_release);
+            _lk.unlock();
+            drain_dispatch_queue(*this);
+            _lk.lock();
+        }
+    };
+
+    active = true;
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    thread = std::make_unique<std::thread>(_func);
+}
+
+void
+dispatch_queue::stop()
+{
+    if(!thread) return;
+
+    {
+        auto _lk = std::unique_lock<std::mutex>{ mutex };
+        active   = false;
+    }
+    cv.notify_all();
+    thread->join();
+    thread.reset();
+}
+
+void
+dispatch_queue::notify()
+{
+    if(scheduled.exchange(true, std::memory_order_acq_rel)) return;
+
+    if(thread)
+    {
+        // locking orders the flag with the wait of the drain thread
+        {
+            auto _lk = std::unique_lock<std::mutex>{ mutex };
+        }
+        cv.notify_one();
+    }
+    else
+    {
+        scheduled.store(false, std::memory_order_release);
+        drain_dispatch_queue(*this);
+    }
+}
+
+// stops the drain threads and moves whatever remains in the rings into the events
+void
+drain_dispatch_queues()
+{
+    for(auto& itr : get_dispatch_queues())
+    {
+        if(!itr) continue;
+        itr->stop();
+        while(!drain_dispatch_queue(*itr))
+            sched_yield();
+    }
+}
+
 bool&
 is_setup()
 {
@@ -145,7 +400,7 @@ get_data_labels()
 // Dump stored context entry
 void
 rocm_dump_context_entry(context_entry_t* entry, rocprofiler_feature_t* features,
-                        unsigned feature_count)
+                        unsigned feature_count, uint32_t _group, dispatch_queue& _queue)
 {
     volatile std::atomic<bool>* valid =
         reinterpret_cast<std::atomic<bool>*>(&entry->valid);
@@ -156,13 +411,6 @@ rocm_dump_context_entry(context_entry_t* entry, rocprofiler_feature_t* features,
 
     if(!record) return;  // there is nothing to do here.
 
-    auto _queue_id    = entry->data.queue_id;
-    auto _thread_id   = entry->data.thread_id;
-    auto _dev_id      = HsaRsrcFactory::Instance().GetAgentInfo(entry->agent)->dev_index;
-    auto _kernel_name = std::string{ entry->data.kernel_name };
-    auto _pos         = _kernel_name.find_last_of(')');
-    if(_pos != std::string::npos) _kernel_name = _kernel_name.substr(0, _pos + 1);
-
     rocprofiler_group_t& group = entry->group;
     if(group.context == nullptr)
     {
@@ -175,11 +423,29 @@ rocm_dump_context_entry(context_entry_t* entry, rocprofiler_feature_t* features,
         rocm_check_status(rocprofiler_get_metrics(group.context));
     }
 
-    auto _evt =
-        component::rocm_event{ _dev_id,       _thread_id,  _queue_id,     _kernel_name,
-                               record->begin, record->end, feature_count, features };
+    // wait for space in the ring. If no one else is draining, drain it here
+    auto _tail = _queue.tail.load(std::memory_order_relaxed);
+    while(_tail - _queue.head.load(std::memory_order_acquire) >= dispatch_queue::capacity)
+    {
+        if(!drain_dispatch_queue(_queue)) sched_yield();
+    }
 
-    component::rocm_data()->emplace_back(_evt);
+    auto& _rec     = _queue.records[_tail % dispatch_queue::capacity];
+    _rec.device_id = HsaRsrcFactory::Instance().GetAgentInfo(entry->agent)->dev_index;
+    _rec.thread_id = entry->data.thread_id;
+    _rec.queue_id  = entry->data.queue_id;
+    _rec.kernel_id = entry->kernel_id;
+    _rec.group     = _group;
+    _rec.begin     = record->begin;
+    _rec.end       = record->end;
+    _rec.feature_count = std::min<uint32_t>(feature_count, OMNITRACE_ROCM_MAX_COUNTERS);
+    std::copy(features, features + _rec.feature_count, _rec.features.begin());
+    _queue.tail.store(_tail + 1, std::memory_order_release);
+
+    // hand a full batch off to the drain thread of the device instead of
+    // converting it here
+    auto _size = _tail + 1 - _queue.head.load(std::memory_order_relaxed);
+    if(_size >= dispatch_queue::batch_size) _queue.notify();
 }
 
 // Profiling completion handler
@@ -195,7 +461,8 @@ rocm_context_handler(const rocprofiler_pool_entry_t* entry, void* arg)
     // rocm::lock_t _lk{ rocm::rocm_mutex, std::defer_lock };
     // if(!_lk.owns_lock()) _lk.lock();
 
-    rocm_dump_context_entry(ctx_entry, handler_arg->features, handler_arg->feature_count);
+    rocm_dump_context_entry(ctx_entry, handler_arg->features, handler_arg->feature_count,
+                            handler_arg->group, *handler_arg->queue);
 
     return true;
 }
@@ -205,13 +472,22 @@ hsa_status_t
 rocm_dispatch_callback(const rocprofiler_callback_data_t* callback_data, void* arg,
                        rocprofiler_group_t* group)
 {
+    // the interned name remains valid for the lifetime of the process so the name
+    // does not need to be copied for every dispatch
+    const auto& _symbol = rocm::get_kernel_symbol(callback_data->kernel_name);
+
+    // dispatches which are not sampled run without a profiling context
+    if(!select_dispatch(_symbol.id)) return HSA_STATUS_SUCCESS;
+
     // Passed tool data
     hsa_agent_t agent = callback_data->agent;
 
     // Open profiling context
     const unsigned   gpu_id = HsaRsrcFactory::Instance().GetAgentInfo(agent)->dev_index;
     callbacks_arg_t* callbacks_arg = reinterpret_cast<callbacks_arg_t*>(arg);
-    rocprofiler_pool_t*      pool  = callbacks_arg->pools[gpu_id];
+    const auto&      _pools        = callbacks_arg->pools.at(gpu_id);
+    if(_pools.empty()) return HSA_STATUS_SUCCESS;
+    rocprofiler_pool_t*      pool = _pools.at(select_group(_symbol.id, _pools.size()));
     rocprofiler_pool_entry_t pool_entry{};
     rocm_check_status(rocprofiler_pool_fetch(pool, &pool_entry));
     // Profiling context entry
@@ -225,12 +501,36 @@ rocm_dispatch_callback(const rocprofiler_callback_data_t* callback_data, void* a
     entry->agent            = agent;
     entry->group            = *group;
     entry->data             = *callback_data;
-    entry->data.kernel_name = strdup(callback_data->kernel_name);
+    entry->data.kernel_name = _symbol.mangled.c_str();
+    entry->kernel_id        = _symbol.id;
     reinterpret_cast<std::atomic<bool>*>(&entry->valid)->store(true);
 
     return HSA_STATUS_SUCCESS;
 }
 
+unsigned
+features_input(unsigned _device, const std::vector<std::string>& _features,
+               rocprofiler_feature_t** ret)
+{
+    const unsigned         feature_count = _features.size();
+    rocprofiler_feature_t* features      = new rocprofiler_feature_t[feature_count];
+    memset(features, 0, feature_count * sizeof(rocprofiler_feature_t));
+
+    // PMC events
+    for(unsigned i = 0; i < feature_count; ++i)
+    {
+        OMNITRACE_VERBOSE_F(3, "Adding feature '%s' for device %u...\n",
+                            _features.at(i).c_str(), _device);
+        features[i].kind            = ROCPROFILER_FEATURE_KIND_METRIC;
+        features[i].name            = strdup(_features.at(i).c_str());
+        features[i].parameters      = nullptr;
+        features[i].parameter_count = 0;
+    }
+
+    *ret = features;
+    return feature_count;
+}
+
 unsigned
 metrics_input(unsigned _device, rocprofiler_feature_t** ret)
 {
@@ -255,23 +555,7 @@ metrics_input(unsigned _device, rocprofiler_feature_t** ret)
             _features.emplace_back(itr);
         }
     }
-    const unsigned         feature_count = _features.size();
-    rocprofiler_feature_t* features      = new rocprofiler_feature_t[feature_count];
-    memset(features, 0, feature_count * sizeof(rocprofiler_feature_t));
-
-    // PMC events
-    for(unsigned i = 0; i < feature_count; ++i)
-    {
-        OMNITRACE_VERBOSE_F(3, "Adding feature '%s' for device %u...\n",
-                            _features.at(i).c_str(), _device);
-        features[i].kind            = ROCPROFILER_FEATURE_KIND_METRIC;
-        features[i].name            = strdup(_features.at(i).c_str());
-        features[i].parameters      = nullptr;
-        features[i].parameter_count = 0;
-    }
-
-    *ret = features;
-    return feature_count;
+    return features_input(_device, _features, ret);
 }
 
 using info_data = std::vector<component::rocm_info_entry>;
@@ -412,43 +696,50 @@ rocm_metrics()
     return _data;
 }
 
+// the counters which rocprofiler reports for the device
+std::set<std::string>
+get_available_counters(unsigned _device, const info_data& _info)
+{
+    auto _suffix = JOIN("", ":device=", _device);
+    auto _v      = std::set<std::string>{};
+    for(const auto& itr : _info)
+    {
+        const auto& _sym = itr.symbol();
+        if(_sym.length() > _suffix.length() &&
+           _sym.compare(_sym.length() - _suffix.length(), _suffix.length(), _suffix) == 0)
+            _v.emplace(_sym.substr(0, _sym.length() - _suffix.length()));
+    }
+    return _v;
+}
+
 void
 rocm_initialize()
 {
     // Available GPU agents
     const unsigned gpu_count = HsaRsrcFactory::Instance().GetCountOfGpuAgents();
 
-    (void) rocm_metrics();
+    auto _info     = rocm_metrics();
+    auto _roofline = config::get_rocm_roofline();
+
+    if(device_sampling::is_enabled())
+    {
+        OMNITRACE_WARNING_IF(_roofline, "OMNITRACE_ROCM_ROOFLINE is ignored when "
+                                        "OMNITRACE_ROCM_EVENTS_MODE=sampled\n");
+        // the dispatches are not intercepted. The process sampler opens the contexts
+        is_setup() = true;
+        return;
+    }
+
+    OMNITRACE_WARNING_IF(
+        _roofline && !config::get_rocm_events().empty(),
+        "OMNITRACE_ROCM_EVENTS is ignored when OMNITRACE_ROCM_ROOFLINE is enabled\n");
 
     // Adding dispatch observer
     callbacks_arg_t* callbacks_arg = new callbacks_arg_t{};
-    callbacks_arg->pools           = new rocprofiler_pool_t*[gpu_count];
+    callbacks_arg->pools.resize(gpu_count);
+    get_dispatch_queues().clear();
     for(unsigned gpu_id = 0; gpu_id < gpu_count; gpu_id++)
     {
-        // Getting profiling features
-        rocprofiler_feature_t* features      = nullptr;
-        unsigned               feature_count = metrics_input(gpu_id, &features);
-
-        if(features)
-        {
-            get_event_names()[gpu_id].clear();
-            get_event_names()[gpu_id].reserve(feature_count);
-            for(unsigned i = 0; i < feature_count; ++i)
-                get_event_names().at(gpu_id).emplace_back(features[i]);
-        }
-
-        // Handler arg
-        handler_arg_t* handler_arg = new handler_arg_t{};
-        handler_arg->features      = features;
-        handler_arg->feature_count = feature_count;
-
-        // Context properties
-        rocprofiler_pool_properties_t properties{};
-        properties.num_entries   = 100;
-        properties.payload_bytes = sizeof(context_entry_t);
-        properties.handler       = rocm_context_handler;
-        properties.handler_arg   = handler_arg;
-
         // Getting GPU device info
         const AgentInfo* agent_info = nullptr;
         if(HsaRsrcFactory::Instance().GetGpuAgentInfo(gpu_id, &agent_info) == false)
@@ -457,12 +748,64 @@ rocm_initialize()
             abort();
         }
 
-        // Open profiling pool
-        rocprofiler_pool_t* pool = nullptr;
-        uint32_t            mode = 0;  // ROCPROFILER_MODE_SINGLEGROUP
-        rocm_check_status(rocprofiler_pool_open(agent_info->dev_id, features,
-                                                feature_count, &pool, mode, &properties));
-        callbacks_arg->pools[gpu_id] = pool;
+        // Getting profiling features: one set per counter group
+        auto _groups = std::vector<std::pair<rocprofiler_feature_t*, unsigned>>{};
+        if(_roofline)
+        {
+            auto _available = get_available_counters(gpu_id, _info);
+            for(const auto& gitr : rocm::roofline::setup(agent_info, _available))
+            {
+                auto _names = std::vector<std::string>{};
+                for(const auto& itr : gitr)
+                    _names.emplace_back(itr.name);
+                auto& _group  = _groups.emplace_back(nullptr, 0);
+                _group.second = features_input(gpu_id, _names, &_group.first);
+            }
+        }
+        else
+        {
+            rocprofiler_feature_t* features      = nullptr;
+            unsigned               feature_count = metrics_input(gpu_id, &features);
+
+            if(features)
+            {
+                get_event_names()[gpu_id].clear();
+                get_event_names()[gpu_id].reserve(feature_count);
+                for(unsigned i = 0; i < feature_count; ++i)
+                    get_event_names().at(gpu_id).emplace_back(features[i]);
+            }
+            _groups.emplace_back(features, feature_count);
+        }
+
+        auto* _queue = get_dispatch_queues()
+                           .emplace_back(std::make_unique<dispatch_queue>(gpu_id))
+                           .get();
+        _queue->start();
+
+        for(size_t i = 0; i < _groups.size(); ++i)
+        {
+            // Handler arg
+            handler_arg_t* handler_arg = new handler_arg_t{};
+            handler_arg->features      = _groups.at(i).first;
+            handler_arg->feature_count = _groups.at(i).second;
+            handler_arg->group         = i;
+            handler_arg->queue         = _queue;
+
+            // Context properties
+            rocprofiler_pool_properties_t properties{};
+            properties.num_entries   = 100;
+            properties.payload_bytes = sizeof(context_entry_t);
+            properties.handler       = rocm_context_handler;
+            properties.handler_arg   = handler_arg;
+
+            // Open profiling pool
+            rocprofiler_pool_t* pool = nullptr;
+            uint32_t            mode = 0;  // ROCPROFILER_MODE_SINGLEGROUP
+            rocm_check_status(rocprofiler_pool_open(
+                agent_info->dev_id, handler_arg->features, handler_arg->feature_count,
+                &pool, mode, &properties));
+            callbacks_arg->pools.at(gpu_id).emplace_back(pool);
+        }
     }
 
     rocprofiler_queue_callbacks_t callbacks_ptrs{};
@@ -476,6 +819,12 @@ rocm_initialize()
 void
 rocm_cleanup()
 {
+    if(device_sampling::is_enabled())
+    {
+        device_sampling::shutdown();
+        return;
+    }
+
     // Unregister dispatch callback
     rocm_check_status(rocprofiler_remove_queue_callbacks());
     // close profiling pool
@@ -486,40 +835,78 @@ rocm_cleanup()
 namespace
 {
 using rocm_event         = component::rocm_event;
-using rocm_data_t        = component::rocm_data_t;
 using rocm_metric_type   = component::rocm_metric_type;
 using rocm_feature_value = component::rocm_feature_value;
 using rocm_data_tracker  = component::rocm_data_tracker;
 
+void
+write_dispatch_counts()
+{
+    auto _fname = tim::settings::compose_output_filename("rocprof-dispatches", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening rocprofiler dispatch output file: %s",
+                        _fname.c_str());
+    }
+
+    OMNITRACE_VERBOSE_F(0, "Outputting '%s'...\n", _fname.c_str());
+    ofs << "# sample rate: 1/" << get_sample_rate() << "\n"
+        << "# dispatches  sampled  scale  name\n";
+    const auto& _counts = get_dispatch_counts();
+    for(uint32_t i = 0; i < _counts.size(); ++i)
+    {
+        auto _total = _counts[i].total.load();
+        if(_total == 0) continue;
+        ofs << _total << "  " << _counts[i].sampled.load() << "  "
+            << get_dispatch_scale(i) << "  " << rocm::get_kernel_symbol(i).name << "\n";
+    }
+}
+
+// runs the function for every device which has events. The devices do not share any
+// data so they are processed on the thread-pool when there is more than one
+template <typename FuncT>
+void
+for_each_device(FuncT&& _func)
+{
+    auto _devices = std::vector<dispatch_queue*>{};
+    for(auto& itr : get_dispatch_queues())
+        if(itr && !itr->events.empty()) _devices.emplace_back(itr.get());
+
+    if(_devices.size() > 1 && get_thread_pool_size() > 1)
+    {
+        auto& _tg = tasking::general::get_task_group();
+        for(size_t i = 0; i < _devices.size(); ++i)
+            _tg.exec([&_func, &_devices, i]() {
+                OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+                _func(i, *_devices.at(i));
+            });
+        _tg.join();
+    }
+    else
+    {
+        for(size_t i = 0; i < _devices.size(); ++i)
+            _func(i, *_devices.at(i));
+    }
+}
+
 void
 post_process_perfetto()
 {
     using counter_track = perfetto_counter_track<rocm_event>;
+    using values_t      = std::vector<rocm_feature_value>;
+    using samples_t     = std::vector<std::pair<uint64_t, values_t>>;
 
     static bool _once = false;
     if(_once) return;
 
-    auto _data          = rocm_data_t{};
-    auto _device_data   = std::map<uint32_t, std::vector<rocm_event*>>{};
-    auto _device_fields = std::map<uint32_t, std::vector<std::string_view>>{};
-    auto _device_range  = std::map<uint32_t, std::set<rocm_metric_type>>{};
-
-    for(size_t i = 0; i < OMNITRACE_MAX_THREADS; ++i)
-    {
-        auto& _v = component::rocm_data(i);
-        if(_v)
-        {
-            _data.reserve(_data.size() + _v->size());
-            for(auto& itr : *_v)
-                _data.emplace_back(itr);
-        }
-    }
+    size_t _num_devices = 0;
+    for(auto& itr : get_dispatch_queues())
+        if(itr && !itr->events.empty()) ++_num_devices;
 
-    if(_data.empty()) return;
+    if(_num_devices == 0) return;
     _once = true;
 
-    std::sort(_data.begin(), _data.end());
-
     auto _get_events = [](std::vector<rocm_event*>& _inp, rocm_metric_type _ts) {
         auto _v = std::vector<rocm_event*>{};
         for(const auto& itr : _inp)
@@ -530,49 +917,41 @@ post_process_perfetto()
         return _v;
     };
 
-    {
-        auto _device_time = std::map<uint32_t, std::set<rocm_metric_type>>{};
+    // the counter values of each device at the midpoints of the begin and end times
+    // of its dispatches
+    auto _samples  = std::vector<samples_t>(_num_devices);
+    auto _features = std::vector<rocm_event*>(_num_devices, nullptr);
+    for_each_device([&](size_t _idx, dispatch_queue& _queue) {
+        auto& _data        = _queue.events;
+        auto  _device_time = std::set<rocm_metric_type>{};
+        auto  _device_data = std::vector<rocm_event*>{};
+        _device_data.reserve(_data.size());
+
+        std::sort(_data.begin(), _data.end());
         for(auto& itr : _data)
         {
-            _device_data[itr.device_id].emplace_back(&itr);
-            _device_time[itr.device_id].emplace(itr.entry);
-            _device_time[itr.device_id].emplace(itr.exit);
-            auto _dev_id = itr.device_id;
-            if(get_use_perfetto() && !counter_track::exists(_dev_id))
-            {
-                auto addendum = [&](auto&& _v) {
-                    return JOIN(" ", "Device", _v, JOIN("", '[', _dev_id, ']'));
-                };
-                for(auto nitr : itr.feature_names)
-                {
-                    auto _name = get_data_labels().at(itr.device_id).at(nitr);
-                    counter_track::emplace(_dev_id, addendum(_name));
-                }
-            }
+            _device_data.emplace_back(&itr);
+            _device_time.emplace(itr.entry);
+            _device_time.emplace(itr.exit);
         }
+        _features.at(_idx) = _device_data.front();
 
-        for(auto& ditr : _device_time)
+        auto _device_range = std::set<rocm_metric_type>{};
+        for(auto itr = _device_time.begin(); itr != _device_time.end(); ++itr)
         {
-            for(auto itr = ditr.second.begin(); itr != ditr.second.end(); ++itr)
-            {
-                auto _next = std::next(itr);
-                if(_next == ditr.second.end()) continue;
-                _device_range[ditr.first].emplace(((*_next / 2) + (*itr / 2)));
-            }
+            auto _next = std::next(itr);
+            if(_next == _device_time.end()) continue;
+            _device_range.emplace(((*_next / 2) + (*itr / 2)));
         }
-    }
 
-    for(auto& ditr : _device_range)
-    {
-        auto _dev_id         = ditr.first;
-        auto _values         = std::vector<rocm_feature_value>{};
-        auto _ts_sorted_data = _device_data[_dev_id];
-        std::sort(_ts_sorted_data.begin(), _ts_sorted_data.end(),
+        auto& _dev_samples = _samples.at(_idx);
+        auto  _values      = values_t{};
+        _dev_samples.reserve(_device_range.size());
+        std::sort(_device_data.begin(), _device_data.end(),
                   [](auto* _l, auto* _r) { return _l->exit < _r->exit; });
-        for(const auto& itr : ditr.second)
+        for(const auto& itr : _device_range)
         {
-            auto     _v  = _get_events(_ts_sorted_data, itr);
-            uint64_t _ts = itr;
+            auto _v = _get_events(_device_data, itr);
             for(auto* vitr : _v)
             {
                 size_t _n = vitr->feature_values.size();
@@ -600,16 +979,40 @@ post_process_perfetto()
                     }
                 }
             }
+            _dev_samples.emplace_back(itr, _values);
+        }
+    });
+
+    // the tracks and the trace packets are written from this thread
+    for(size_t _idx = 0; _idx < _num_devices; ++_idx)
+    {
+        const auto* _evt    = _features.at(_idx);
+        auto        _dev_id = _evt->device_id;
+        if(!counter_track::exists(_dev_id))
+        {
+            auto addendum = [&](auto&& _v) {
+                return JOIN(" ", "Device", _v, JOIN("", '[', _dev_id, ']'));
+            };
+            for(auto nitr : _evt->feature_names)
+            {
+                auto _name = get_data_labels().at(_dev_id).at(nitr);
+                counter_track::emplace(_dev_id, addendum(_name));
+            }
+        }
 
-            for(size_t i = 0; i < _values.size(); ++i)
+        for(const auto& itr : _samples.at(_idx))
+        {
+            uint64_t _ts = itr.first;
+            for(size_t i = 0; i < itr.second.size(); ++i)
             {
                 auto _trace_counter = [_dev_id, i, _ts](auto&& _val) {
                     TRACE_COUNTER("kernel_hardware_counter",
                                   counter_track::at(_dev_id, i), _ts, _val);
                 };
-                std::visit(_trace_counter, _values.at(i));
+                std::visit(_trace_counter, itr.second.at(i));
             }
         }
+        _samples.at(_idx).clear();
     }
 }
 
@@ -619,32 +1022,21 @@ post_process_timemory()
     static bool _once = false;
     if(_once) return;
 
-    auto _data          = rocm_data_t{};
-    auto _device_data   = std::map<uint32_t, std::vector<rocm_event*>>{};
-    auto _device_fields = std::map<uint32_t, std::vector<std::string_view>>{};
-    auto _device_range  = std::map<uint32_t, std::set<rocm_metric_type>>{};
+    auto _device_data = std::map<uint32_t, std::vector<rocm_event*>>{};
 
-    for(size_t i = 0; i < OMNITRACE_MAX_THREADS; ++i)
+    // the events of each device are already separate
+    for(auto& qitr : get_dispatch_queues())
     {
-        auto& _v = component::rocm_data(i);
-        if(_v)
-        {
-            _data.reserve(_data.size() + _v->size());
-            for(auto& itr : *_v)
-                _data.emplace_back(itr);
-        }
+        if(!qitr || qitr->events.empty()) continue;
+        auto& _v = _device_data[qitr->device_id];
+        _v.reserve(qitr->events.size());
+        for(auto& itr : qitr->events)
+            _v.emplace_back(&itr);
     }
 
-    if(_data.empty()) return;
+    if(_device_data.empty()) return;
     _once = true;
 
-    std::sort(_data.begin(), _data.end());
-
-    for(auto& itr : _data)
-    {
-        _device_data[itr.device_id].emplace_back(&itr);
-    }
-
     for(auto& itr : _device_data)
     {
         // sort according to when it exited
@@ -700,10 +1092,22 @@ post_process_timemory()
         void operator()(int64_t _index, scope::config _scope) const
         {
             if(!parent) return;
+            // with sampled collection, the stored value is the estimate for all the
+            // dispatches of the kernel which this sample represents
+            auto _scale = get_dispatch_scale(parent->kernel_id);
+            auto _value = parent->feature_values.at(_index);
+            if(_scale != 1.0)
+            {
+                std::visit(
+                    [_scale](auto& _v) {
+                        using value_type = std::decay_t<decltype(_v)>;
+                        _v = static_cast<value_type>(static_cast<double>(_v) * _scale);
+                    },
+                    _value);
+            }
+
             bundle_type _bundle{ parent->name, _scope };
-            _bundle.push(parent->queue_id)
-                .start()
-                .store(parent->feature_values.at(_index));
+            _bundle.push(parent->queue_id).start().store(_value);
 
             std::sort(children.begin(), children.end());
             for(const auto& itr : children)
@@ -810,11 +1214,50 @@ post_process_timemory()
 
     tim::trait::runtime_enabled<omnitrace::rocprofiler::rocm_data_tracker>::set(false);
 }
+
+// the counters of the roofline groups are converted into the FLOPs and bytes of each
+// kernel instead of being written as counters
+void
+post_process_roofline()
+{
+    auto _values = std::vector<double>{};
+    for(auto& qitr : get_dispatch_queues())
+    {
+        if(!qitr) continue;
+        for(const auto& itr : qitr->events)
+        {
+            _values.clear();
+            auto _push = [&_values](auto _v) {
+                _values.emplace_back(static_cast<double>(_v));
+            };
+            for(const auto& vitr : itr.feature_values)
+                std::visit(_push, vitr);
+            rocm::roofline::record_counters(itr.device_id, itr.kernel_id, itr.group,
+                                            itr.exit - itr.entry, _values);
+        }
+        qitr->events.clear();
+    }
+
+    rocm::roofline::post_process();
+}
 }  // namespace
 
 void
 post_process()
 {
+    // the sampled counters are written by the process sampler
+    if(device_sampling::is_enabled()) return;
+
+    drain_dispatch_queues();
+
+    if(get_sample_rate() > 1) write_dispatch_counts();
+
+    if(config::get_rocm_roofline())
+    {
+        post_process_roofline();
+        return;
+    }
+
     if(get_use_perfetto()) post_process_perfetto();
 
     if(get_use_timemory())
@@ -830,5 +1273,243 @@ post_process()
         }
     }
 }
+
+namespace device_sampling
+{
+namespace
+{
+struct device_context
+{
+    uint32_t                         device     = 0;
+    rocprofiler_t*                   context    = nullptr;
+    rocprofiler_feature_t*           features   = nullptr;
+    unsigned                         count      = 0;
+    std::vector<uint64_t>            timestamps = {};
+    std::vector<std::vector<double>> values     = {};  // one per feature
+};
+
+struct sampler_state
+{
+    std::mutex                  mutex   = {};
+    bool                        active  = false;
+    bool                        opened  = false;
+    uint64_t                    start   = 0;
+    std::vector<device_context> devices = {};
+};
+
+// intentionally leaked so the contexts can be closed during the static destruction
+sampler_state&
+get_sampler()
+{
+    static auto* _v = new sampler_state{};
+    return *_v;
+}
+
+bool
+check_status(hsa_status_t _status, const char* _func)
+{
+    if(_status == HSA_STATUS_SUCCESS) return true;
+    const char* _err = rocm_error_string(_status);
+    OMNITRACE_WARNING_F(0, "%s failed: %s\n", _func, (_err) ? _err : "unknown error");
+    return false;
+}
+
+double
+get_value(const rocprofiler_feature_t& _feature)
+{
+    switch(_feature.data.kind)
+    {
+        case ROCPROFILER_DATA_KIND_INT32:
+            return static_cast<double>(_feature.data.result_int32);
+        case ROCPROFILER_DATA_KIND_INT64:
+            return static_cast<double>(_feature.data.result_int64);
+        case ROCPROFILER_DATA_KIND_FLOAT:
+            return static_cast<double>(_feature.data.result_float);
+        case ROCPROFILER_DATA_KIND_DOUBLE: return _feature.data.result_double;
+        default: break;
+    }
+    return 0.0;
+}
+
+void
+close_context(device_context& _v)
+{
+    if(_v.context)
+    {
+        check_status(rocprofiler_stop(_v.context, 0), "rocprofiler_stop");
+        check_status(rocprofiler_close(_v.context), "rocprofiler_close");
+    }
+    _v.context = nullptr;
+}
+
+// one standalone context per device with its own queue. The counters of a standalone
+// context count the activity of every queue of the device
+void
+open_contexts(sampler_state& _s)
+{
+    _s.opened = true;
+
+    const unsigned gpu_count = HsaRsrcFactory::Instance().GetCountOfGpuAgents();
+    for(unsigned gpu_id = 0; gpu_id < gpu_count; ++gpu_id)
+    {
+        const AgentInfo* agent_info = nullptr;
+        if(!HsaRsrcFactory::Instance().GetGpuAgentInfo(gpu_id, &agent_info)) continue;
+
+        auto _v  = device_context{};
+        _v.count = metrics_input(gpu_id, &_v.features);
+        if(_v.count == 0) continue;
+
+        auto _properties        = rocprofiler_properties_t{};
+        _properties.queue_depth = 128;
+        uint32_t _mode = ROCPROFILER_MODE_STANDALONE | ROCPROFILER_MODE_CREATEQUEUE |
+                         ROCPROFILER_MODE_SINGLEGROUP;
+        if(!check_status(rocprofiler_open(agent_info->dev_id, _v.features, _v.count,
+                                          &_v.context, _mode, &_properties),
+                         "rocprofiler_open"))
+        {
+            OMNITRACE_WARNING_F(0,
+                                "the counters of device %u are not sampled. The counters "
+                                "of a device must fit in one pass\n",
+                                gpu_id);
+            continue;
+        }
+        if(!check_status(rocprofiler_start(_v.context, 0), "rocprofiler_start"))
+        {
+            check_status(rocprofiler_close(_v.context), "rocprofiler_close");
+            continue;
+        }
+
+        _v.device = gpu_id;
+        _v.values.resize(_v.count);
+        _s.devices.emplace_back(std::move(_v));
+    }
+
+    _s.start = tracing::now();
+    OMNITRACE_VERBOSE_F(1, "Sampling the hardware counters of %zu devices\n",
+                        _s.devices.size());
+}
+
+// the counters accumulated since the previous sample. The counters are restarted so
+// the value of every sample, including the derived counters, covers one interval
+void
+sample_locked(sampler_state& _s)
+{
+    if(!_s.opened)
+    {
+        if(!is_setup()) return;
+        open_contexts(_s);
+        return;
+    }
+
+    auto _ts = tracing::now();
+    for(auto& itr : _s.devices)
+    {
+        if(!itr.context) continue;
+        if(!check_status(rocprofiler_read(itr.context, 0), "rocprofiler_read") ||
+           !check_status(rocprofiler_get_data(itr.context, 0), "rocprofiler_get_data") ||
+           !check_status(rocprofiler_get_metrics(itr.context), "rocprofiler_get_metrics"))
+        {
+            close_context(itr);
+            continue;
+        }
+
+        itr.timestamps.emplace_back(_ts);
+        for(unsigned i = 0; i < itr.count; ++i)
+            itr.values.at(i).emplace_back(get_value(itr.features[i]));
+
+        if(!check_status(rocprofiler_stop(itr.context, 0), "rocprofiler_stop") ||
+           !check_status(rocprofiler_start(itr.context, 0), "rocprofiler_start"))
+            close_context(itr);
+    }
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return config::get_use_rocprofiler() && config::get_rocm_events_mode() == "sampled";
+}
+
+void
+setup()
+{
+    if(!is_enabled()) return;
+
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    _s.active = true;
+}
+
+void
+config()
+{
+    sample();
+}
+
+void
+sample()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(_s.active) sample_locked(_s);
+}
+
+void
+shutdown()
+{
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+    if(!_s.active) return;
+
+    // the counters until the end of the application
+    if(_s.opened) sample_locked(_s);
+    for(auto& itr : _s.devices)
+        close_context(itr);
+    _s.active = false;
+}
+
+void
+post_process()
+{
+    using counter_track = perfetto_counter_track<device_context>;
+
+    if(!is_enabled()) return;
+
+    shutdown();
+
+    auto& _s  = get_sampler();
+    auto  _lk = std::unique_lock<std::mutex>{ _s.mutex };
+
+    for(auto& itr : _s.devices)
+    {
+        OMNITRACE_VERBOSE_F(1, "Post-processing %zu counter samples from device %u\n",
+                            itr.timestamps.size(), itr.device);
+        if(!get_use_perfetto() || itr.timestamps.empty()) continue;
+
+        if(!counter_track::exists(itr.device))
+        {
+            for(unsigned i = 0; i < itr.count; ++i)
+                counter_track::emplace(itr.device,
+                                       JOIN(" ", "Device", itr.features[i].name,
+                                            JOIN("", '[', itr.device, ']'), "(S)"));
+        }
+
+        // every value is the counter in the interval which ends at its timestamp
+        for(unsigned i = 0; i < itr.count; ++i)
+        {
+            auto _prev = _s.start;
+            for(size_t j = 0; j < itr.timestamps.size(); ++j)
+            {
+                TRACE_COUNTER("rocprofiler", counter_track::at(itr.device, i), _prev,
+                              itr.values.at(i).at(j));
+                _prev = itr.timestamps.at(j);
+            }
+            TRACE_COUNTER("rocprofiler", counter_track::at(itr.device, i), _prev, 0.0);
+            itr.values.at(i).clear();
+        }
+        itr.timestamps.clear();
+    }
+}
+}  // namespace device_sampling
 }  // namespace rocprofiler
 }  // namespace omnitrace
@@ -68,6 +68,32 @@ post_process();
 std::vector<component::rocm_info_entry>
 rocm_metrics();
 
+/// the counters of each device sampled as a whole in the intervals of the background
+/// process sampler instead of per dispatch (OMNITRACE_ROCM_EVENTS_MODE=sampled)
+namespace device_sampling
+{
+bool
+is_enabled();
+
+void
+setup();
+
+void
+config();
+
+/// opens the profiling contexts once rocprofiler is loaded, then reads the counters
+/// accumulated since the last sample
+void
+sample();
+
+void
+shutdown();
+
+/// writes the perfetto counter tracks
+void
+post_process();
+}  // namespace device_sampling
+
 #if !defined(OMNITRACE_USE_ROCPROFILER) || OMNITRACE_USE_ROCPROFILER == 0
 inline void
 post_process()
@@ -82,6 +108,35 @@ rocm_metrics()
 {
     return std::vector<component::rocm_info_entry>{};
 }
+
+namespace device_sampling
+{
+inline bool
+is_enabled()
+{
+    return false;
+}
+
+inline void
+setup()
+{}
+
+inline void
+config()
+{}
+
+inline void
+sample()
+{}
+
+inline void
+shutdown()
+{}
+
+inline void
+post_process()
+{}
+}  // namespace device_sampling
 #endif
 
 }  // namespace rocprofiler
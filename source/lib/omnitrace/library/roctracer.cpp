@@ -21,17 +21,34 @@
 // SOFTWARE.
 
 #include "library/roctracer.hpp"
-#include "binary/analysis.hpp"
 #include "core/components/fwd.hpp"
 #include "core/concepts.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/locking.hpp"
+#include "core/self_profile.hpp"
+#include "library/causal/data.hpp"
+#include "library/components/backtrace.hpp"
 #include "library/components/category_region.hpp"
+#include "library/critical_path.hpp"
+#include "library/emergency_dump.hpp"
+#include "library/energy.hpp"
+#include "library/gpu_attribution.hpp"
+#include "library/gpu_memory.hpp"
+#include "library/hip_api_stacks.hpp"
+#include "library/hip_graph.hpp"
+#include "library/kernel_launch.hpp"
+#include "library/live_export.hpp"
+#include "library/memcpy_analysis.hpp"
+#include "library/memory_footprint.hpp"
+#include "library/rccl_timing.hpp"
+#include "library/rocm.hpp"
+#include "library/rocm/roofline.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
+#include "library/trace_trigger.hpp"
 #include "library/tracing.hpp"
 
 #include <timemory/backends/cpu.hpp>
@@ -39,10 +56,21 @@
 #include <timemory/hash/types.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
 #include <tuple>
+#include <vector>
 
 #include <roctracer_ext.h>
 #include <roctracer_hip.h>
@@ -114,38 +142,413 @@ get_roctracer_hip_data(int64_t _tid = threading::get_id())
     return thread_data_t::instance(construct_on_thread{ _tid });
 }
 
-std::unordered_map<uint64_t, const char*>&
-get_roctracer_key_data()
+// bytes of an entry of the in-flight HIP API calls (the value, the pointer to the next
+// node and the cached hash) for the memory footprint
+constexpr int64_t hip_data_node_size =
+    sizeof(std::pair<const uint64_t, roctracer_hip_bundle_t>) + (2 * sizeof(void*));
+
+// maps the correlation id of a HIP API call to the kernel name, the thread which
+// launched it and the id of its call-stack (see hip_api_stacks). The table is a ring
+// indexed by the correlation id modulo the capacity so inserting and looking up an
+// entry is lock-free and the memory is bounded. When more than the capacity of ops are
+// in flight, the oldest entries are overwritten and the activity record falls back to
+// the op name
+struct correlation_entry
 {
-    static auto _v = std::unordered_map<uint64_t, const char*>{};
-    return _v;
+    std::atomic<uint64_t>    cid   = { 0 };
+    std::atomic<const char*> name  = { nullptr };
+    std::atomic<int64_t>     tid   = { 0 };
+    std::atomic<uint64_t>    stack = { 0 };
+};
+
+constexpr size_t correlation_table_size = (1 << 16);
+static_assert((correlation_table_size & (correlation_table_size - 1)) == 0,
+              "correlation table size must be a power of two");
+
+auto&
+get_roctracer_correlation_table()
+{
+    static auto* _v = new std::array<correlation_entry, correlation_table_size>{};
+    return *_v;
+}
+
+void
+set_roctracer_correlation(uint64_t _cid, const char* _name, int64_t _tid,
+                          uint64_t _stack)
+{
+    auto& _entry = get_roctracer_correlation_table()[_cid % correlation_table_size];
+    // invalidate the slot before updating the payload so a concurrent reader of the
+    // previous correlation id does not pair it with the new payload
+    _entry.cid.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _entry.name.store(_name, std::memory_order_relaxed);
+    _entry.tid.store(_tid, std::memory_order_relaxed);
+    _entry.stack.store(_stack, std::memory_order_relaxed);
+    _entry.cid.store(_cid, std::memory_order_release);
+}
+
+bool
+get_roctracer_correlation(uint64_t _cid, const char*& _name, int64_t& _tid,
+                          uint64_t& _stack)
+{
+    auto& _entry = get_roctracer_correlation_table()[_cid % correlation_table_size];
+    if(_entry.cid.load(std::memory_order_acquire) != _cid) return false;
+    _name  = _entry.name.load(std::memory_order_relaxed);
+    _tid   = _entry.tid.load(std::memory_order_relaxed);
+    _stack = _entry.stack.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // the slot was reused while it was being read
+    return (_entry.cid.load(std::memory_order_relaxed) == _cid);
+}
+
+// the duration of a kernel, copy or barrier which is inserted into the timemory
+// call-graph of the thread which launched it at its next HIP API call since only that
+// thread may update its call-graph
+struct hip_activity_record
+{
+    const char* name     = nullptr;
+    uint64_t    begin_ns = 0;
+    uint64_t    end_ns   = 0;
+};
+
+// the records of a thread, written by the activity callback and consumed by the
+// thread (or the flush) with the lock of the thread. The ring is allocated once and
+// the records only spill into the overflow, in order, when the thread does not call a
+// HIP function for OMNITRACE_ROCTRACER_ACTIVITY_BUFFER_SIZE activity records
+struct hip_activity_queue
+{
+    hip_activity_queue(size_t _capacity, int64_t _tid);
+    ~hip_activity_queue();
+
+    hip_activity_queue(const hip_activity_queue&) = delete;
+    hip_activity_queue(hip_activity_queue&&)      = delete;
+    hip_activity_queue& operator=(const hip_activity_queue&) = delete;
+    hip_activity_queue& operator=(hip_activity_queue&&) = delete;
+
+    bool empty() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    void push(const hip_activity_record& _v);
+
+    template <typename FuncT>
+    void consume(FuncT&& _func);
+
+    // the records in the ring which have not been consumed (the overflow may be
+    // reallocated while it is read so it is not included)
+    static void dump_records(emergency_dump::writer&, const void*, int64_t);
+
+    std::atomic<size_t>                    pending  = { 0 };
+    size_t                                 head     = 0;
+    size_t                                 mask     = 0;
+    bool                                   warned   = false;
+    std::unique_ptr<hip_activity_record[]> ring     = {};
+    std::vector<hip_activity_record>       overflow = {};
+    size_t                                 source   = emergency_dump::invalid_source;
+};
+
+hip_activity_queue::hip_activity_queue(size_t _capacity, int64_t _tid)
+{
+    size_t _n = 1;
+    while(_n < std::max<size_t>(_capacity, 2))
+        _n <<= 1;
+    mask   = _n - 1;
+    ring   = std::make_unique<hip_activity_record[]>(_n);
+    source = emergency_dump::add_source(&hip_activity_queue::dump_records, this, _tid);
+    memory_footprint::track(memory_footprint::roctracer_subsystem,
+                            _n * sizeof(hip_activity_record));
 }
 
-std::unordered_map<uint64_t, int64_t>&
-get_roctracer_tid_data()
+hip_activity_queue::~hip_activity_queue()
 {
-    static auto _v = std::unordered_map<uint64_t, int64_t>{};
+    auto _nbytes = (mask + 1) * sizeof(hip_activity_record);
+    emergency_dump::remove_source(source);
+    memory_footprint::track(memory_footprint::roctracer_subsystem,
+                            -static_cast<int64_t>(_nbytes));
+}
+
+void
+hip_activity_queue::dump_records(emergency_dump::writer& _writer, const void* _data,
+                                 int64_t _tid)
+{
+    const auto& _queue = *static_cast<const hip_activity_queue*>(_data);
+    auto        _n     = std::min<size_t>(_queue.pending.load(std::memory_order_acquire),
+                                   _queue.mask + 1);
+    if(_n == 0) return;
+
+    uint64_t _nbytes = 0;
+    for(size_t i = 0; i < _n; ++i)
+    {
+        const auto& _record = _queue.ring[(_queue.head + i) & _queue.mask];
+        _nbytes += (2 * sizeof(uint64_t)) +
+                   emergency_dump::writer::string_size(_record.name);
+    }
+
+    _writer.section(emergency_dump::activity_section, _tid, _nbytes);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        const auto& _record = _queue.ring[(_queue.head + i) & _queue.mask];
+        _writer.write(_record.begin_ns);
+        _writer.write(_record.end_ns);
+        _writer.write_string(_record.name);
+    }
+}
+
+void
+hip_activity_queue::push(const hip_activity_record& _v)
+{
+    auto _n = pending.load(std::memory_order_relaxed);
+    if(OMNITRACE_LIKELY(_n <= mask && overflow.empty()))
+    {
+        ring[(head + _n) & mask] = _v;
+    }
+    else
+    {
+        OMNITRACE_WARNING_IF_F(!warned, "a thread did not call a HIP function for %zu "
+                                        "activity records. Increase "
+                                        "OMNITRACE_ROCTRACER_ACTIVITY_BUFFER_SIZE to "
+                                        "avoid allocating the remainder\n",
+                               mask + 1);
+        warned = true;
+        overflow.emplace_back(_v);
+        memory_footprint::track(memory_footprint::roctracer_subsystem,
+                                sizeof(hip_activity_record));
+    }
+    pending.store(_n + 1, std::memory_order_release);
+}
+
+template <typename FuncT>
+void
+hip_activity_queue::consume(FuncT&& _func)
+{
+    auto _n = std::min<size_t>(pending.load(std::memory_order_relaxed), mask + 1);
+    for(size_t i = 0; i < _n; ++i)
+        _func(ring[(head + i) & mask]);
+    for(const auto& itr : overflow)
+        _func(itr);
+
+    head = (head + _n) & mask;
+    if(!overflow.empty())
+        memory_footprint::track(
+            memory_footprint::roctracer_subsystem,
+            -static_cast<int64_t>(overflow.size() * sizeof(hip_activity_record)));
+    overflow.clear();
+    pending.store(0, std::memory_order_release);
+}
+
+size_t
+get_hip_activity_buffer_size()
+{
+    static auto _v =
+        config::get_setting_value<size_t>("OMNITRACE_ROCTRACER_ACTIVITY_BUFFER_SIZE")
+            .value_or(4096);
     return _v;
 }
 
 auto&
 get_hip_activity_callbacks(int64_t _tid = threading::get_id())
 {
-    using thread_data_t =
-        thread_data<std::vector<std::function<void()>>, category::roctracer>;
-    return thread_data_t::instance(construct_on_thread{ _tid });
+    using thread_data_t = thread_data<hip_activity_queue, category::roctracer>;
+    return thread_data_t::instance(construct_on_thread{ _tid },
+                                   get_hip_activity_buffer_size(), _tid);
 }
 
 size_t
 get_hip_activity_callbacks_size()
 {
-    using thread_data_t =
-        thread_data<std::vector<std::function<void()>>, category::roctracer>;
+    using thread_data_t = thread_data<hip_activity_queue, category::roctracer>;
     return thread_data_t::size();
 }
 
+// per-(device, kernel) statistics when OMNITRACE_ROCTRACER_AGGREGATE is enabled. The
+// table uses open addressing with linear probing and is updated in place with
+// atomics so the activity callback never allocates or locks
+struct aggregate_entry
+{
+    std::atomic<uint64_t> key   = { 0 };  // ((device << 32) | kernel id) + 1
+    std::atomic<uint64_t> count = { 0 };
+    std::atomic<uint64_t> total = { 0 };
+    std::atomic<uint64_t> min   = { std::numeric_limits<uint64_t>::max() };
+    std::atomic<uint64_t> max   = { 0 };
+    std::atomic<uint64_t> bytes = { 0 };
+    std::atomic<double>   sumsq = { 0.0 };
+};
+
+constexpr size_t aggregate_table_size = 4096;
+
+auto&
+get_aggregate_table()
+{
+    static auto* _v = new std::array<aggregate_entry, aggregate_table_size>{};
+    return *_v;
+}
+
+auto&
+get_aggregate_dropped()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+
+bool
+get_use_roctracer_aggregate()
+{
+    return config::get_snapshot().roctracer_aggregate;
+}
+
+void
+update_aggregate(int32_t _devid, uint32_t _kernel_id, uint64_t _ns, uint64_t _bytes)
+{
+    auto  _dev   = static_cast<uint64_t>(static_cast<uint32_t>(_devid));
+    auto  _key   = ((_dev << 32) | _kernel_id) + 1;
+    auto& _table = get_aggregate_table();
+    auto  _idx   = std::hash<uint64_t>{}(_key) % aggregate_table_size;
+
+    for(size_t i = 0; i < aggregate_table_size; ++i)
+    {
+        auto&    _entry = _table[(_idx + i) % aggregate_table_size];
+        uint64_t _cur   = _entry.key.load(std::memory_order_acquire);
+        if(_cur == 0 &&
+           _entry.key.compare_exchange_strong(_cur, _key, std::memory_order_acq_rel))
+            _cur = _key;
+        if(_cur != _key) continue;
+
+        auto _update = [](auto& _atomic, auto _val, auto&& _cmp) {
+            auto _prev = _atomic.load(std::memory_order_relaxed);
+            while(_cmp(_val, _prev) &&
+                  !_atomic.compare_exchange_weak(_prev, _val, std::memory_order_relaxed))
+            {}
+        };
+
+        _entry.count.fetch_add(1, std::memory_order_relaxed);
+        _entry.total.fetch_add(_ns, std::memory_order_relaxed);
+        _entry.bytes.fetch_add(_bytes, std::memory_order_relaxed);
+        _update(_entry.min, _ns, std::less<uint64_t>{});
+        _update(_entry.max, _ns, std::greater<uint64_t>{});
+        auto _sq   = static_cast<double>(_ns) * static_cast<double>(_ns);
+        auto _prev = _entry.sumsq.load(std::memory_order_relaxed);
+        while(!_entry.sumsq.compare_exchange_weak(_prev, _prev + _sq,
+                                                  std::memory_order_relaxed))
+        {}
+        return;
+    }
+
+    get_aggregate_dropped().fetch_add(1, std::memory_order_relaxed);
+}
+
+// rate limit of the HSA API tracing of a function: the first calls of each thread are
+// traced and then one in every interval calls (none if the interval is zero)
+struct hsa_api_limit
+{
+    uint64_t first    = std::numeric_limits<uint64_t>::max();
+    uint64_t interval = 1;
+};
+
+using hsa_api_limits_t = std::array<hsa_api_limit, HSA_API_ID_NUMBER>;
+
+// the calls and the traced calls of each HSA API function on a thread, indexed by cid
+struct hsa_api_counts
+{
+    std::array<uint64_t, HSA_API_ID_NUMBER> calls  = {};
+    std::array<uint64_t, HSA_API_ID_NUMBER> traced = {};
+};
+
+using hsa_api_counts_data = omnitrace::thread_data<hsa_api_counts, hsa_api_counts>;
+
+// parses OMNITRACE_ROCTRACER_HSA_API_SAMPLING, i.e. the space-separated entries of the
+// form [NAME=]FIRST[:INTERVAL]. The entries without a name apply to every function
+// which is not named by another entry. Null if no rate limit is set
+const hsa_api_limits_t*
+get_hsa_api_limits()
+{
+    static const auto* _v = []() -> const hsa_api_limits_t* {
+        auto _spec =
+            config::get_setting_value<std::string>("OMNITRACE_ROCTRACER_HSA_API_SAMPLING")
+                .value_or(std::string{});
+        if(_spec.empty()) return nullptr;
+
+        auto _parse = [](const std::string& _entry, hsa_api_limit& _limit) {
+            auto _fields = tim::delimit(_entry, ":");
+            if(_fields.empty() || _fields.size() > 2) return false;
+            try
+            {
+                _limit.first = std::stoull(_fields.at(0));
+                _limit.interval =
+                    (_fields.size() > 1) ? std::stoull(_fields.at(1)) : uint64_t{ 0 };
+            } catch(std::exception&)
+            {
+                return false;
+            }
+            return true;
+        };
+
+        auto* _limits = new hsa_api_limits_t{};
+        auto  _named  = std::vector<std::pair<uint32_t, hsa_api_limit>>{};
+        for(const auto& itr : tim::delimit(_spec, " ,;\t"))
+        {
+            auto _pos   = itr.find('=');
+            auto _limit = hsa_api_limit{};
+            if(!_parse(itr.substr((_pos == std::string::npos) ? 0 : _pos + 1), _limit))
+            {
+                OMNITRACE_WARNING_F(0, "Ignoring invalid HSA API sampling entry '%s'\n",
+                                    itr.c_str());
+                continue;
+            }
+
+            if(_pos == std::string::npos)
+            {
+                _limits->fill(_limit);
+                continue;
+            }
+
+            auto     _name   = itr.substr(0, _pos);
+            uint32_t _cid    = HSA_API_ID_NUMBER;
+            auto     _domain = static_cast<activity_domain_t>(ACTIVITY_DOMAIN_HSA_API);
+            if(roctracer_op_code(_domain, _name.c_str(), &_cid, nullptr) != 0 ||
+               _cid >= HSA_API_ID_NUMBER)
+            {
+                OMNITRACE_WARNING_F(
+                    0, "Ignoring the HSA API sampling of unknown function '%s'\n",
+                    _name.c_str());
+                continue;
+            }
+            _named.emplace_back(_cid, _limit);
+        }
+
+        for(const auto& itr : _named)
+            _limits->at(itr.first) = itr.second;
+        return _limits;
+    }();
+    return _v;
+}
+
+hsa_api_counts&
+get_hsa_api_counts()
+{
+    static thread_local auto* _v = []() {
+        auto& _counts = hsa_api_counts_data::instance(construct_on_thread{});
+        if(!_counts) _counts = std::make_unique<hsa_api_counts>();
+        return _counts.get();
+    }();
+    return *_v;
+}
+
+// returns true if the call of the HSA API function is traced on this thread. The
+// calls are only counted when a rate limit is set
+bool
+sample_hsa_api(uint32_t _cid)
+{
+    const auto* _limits = get_hsa_api_limits();
+    if(_limits == nullptr || _cid >= HSA_API_ID_NUMBER) return true;
+
+    auto&       _counts = get_hsa_api_counts();
+    const auto& _limit  = (*_limits)[_cid];
+    auto        _n      = _counts.calls[_cid]++;
+    bool        _traced = (_n < _limit.first) ||
+                   (_limit.interval > 0 && (_n - _limit.first) % _limit.interval == 0);
+    if(_traced) ++_counts.traced[_cid];
+    return _traced;
+}
+
 using hip_activity_mutex_t = std::decay_t<decltype(get_hip_activity_callbacks())>;
-using key_data_mutex_t     = std::decay_t<decltype(get_roctracer_key_data())>;
 
 auto&
 get_hip_activity_mutex(int64_t _tid = threading::get_id())
@@ -156,65 +559,209 @@ get_hip_activity_mutex(int64_t _tid = threading::get_id())
 }
 }  // namespace
 
-//
-int64_t
-get_clock_skew()
+uint64_t&
+get_hip_launch_correlation_id()
 {
-    static auto _use = tim::get_env("OMNITRACE_USE_ROCTRACER_CLOCK_SKEW", true);
-    if(!_use) return 0;
-    static auto _v = []() {
-        namespace cpu = tim::cpu;
-        // synchronize timestamps
-        // We'll take a CPU timestamp before and after taking a GPU timestmp, then
-        // take the average of those two, hoping that it's roughly at the same time
-        // as the GPU timestamp.
-        static auto _cpu_now = []() {
-            cpu::fence();
-            return comp::wall_clock::record();
-        };
+    static thread_local uint64_t _v = 0;
+    return _v;
+}
 
-        static auto _gpu_now = []() {
-            cpu::fence();
-            uint64_t _ts = 0;
-            OMNITRACE_ROCTRACER_CALL(roctracer_get_timestamp(&_ts));
-            return _ts;
-        };
+namespace
+{
+// offset between the CPU (wall_clock) and the GPU (roctracer) clocks measured at a
+// GPU timestamp
+struct clock_sync_point
+{
+    uint64_t gpu_ts = 0;
+    int64_t  offset = 0;
+};
+
+clock_sync_point
+sample_clock_skew()
+{
+    namespace cpu = tim::cpu;
+    // synchronize timestamps
+    // We'll take a CPU timestamp before and after taking a GPU timestmp, then
+    // take the average of those two, hoping that it's roughly at the same time
+    // as the GPU timestamp.
+    auto _cpu_now = []() {
+        cpu::fence();
+        return comp::wall_clock::record();
+    };
+
+    auto _gpu_now = []() {
+        cpu::fence();
+        uint64_t _ts = 0;
+        OMNITRACE_ROCTRACER_CALL(roctracer_get_timestamp(&_ts));
+        return _ts;
+    };
+
+    // warm up cache and allow for any static initialization
+    (void) _cpu_now();
+    (void) _gpu_now();
+
+    constexpr int64_t _n       = 10;
+    uint64_t          _gpu_ave = 0;
+    int64_t           _diff    = 0;
+    for(int64_t i = 0; i < _n; ++i)
+    {
+        volatile uint64_t _cpu_ts = 0;
+        volatile uint64_t _gpu_ts = 0;
+        _cpu_ts += _cpu_now() / 2;
+        _gpu_ts += _gpu_now() / 1;
+        _cpu_ts += _cpu_now() / 2;
+        _diff += static_cast<int64_t>(_cpu_ts) - static_cast<int64_t>(_gpu_ts);
+        _gpu_ave += _gpu_ts / _n;
+    }
+    return clock_sync_point{ _gpu_ave, _diff / _n };
+}
+
+// linear model of the CPU/GPU clock offset, i.e. offset + slope * (gpu_ts - gpu_ref),
+// fitted by least squares over the most recent sync points so a noisy sync point does
+// not bend the model. The clocks are re-sampled once the configured interval has
+// elapsed since the last sync by the one thread which claims the update. The fit is
+// published under a sequence lock so the conversions of the activity records, two per
+// record, never take a lock
+struct clock_skew_model
+{
+    static constexpr size_t max_points = 16;
+
+    int64_t operator()(uint64_t _gpu_ts);
+
+    uint64_t interval = 0;  ///< nanoseconds between syncs
+
+private:
+    bool read(uint64_t _gpu_ts, int64_t& _offset) const;
+    void update();
 
-        do
+    // the fit, written by the thread which holds m_updating
+    std::atomic<uint64_t> m_seq      = { 0 };  ///< odd while the fit is written
+    std::atomic<uint64_t> m_gpu_ref  = { 0 };
+    std::atomic<int64_t>  m_offset   = { 0 };
+    std::atomic<double>   m_slope    = { 0.0 };
+    std::atomic<uint64_t> m_next     = { 0 };  ///< CPU timestamp of the next sync
+    std::atomic<bool>     m_updating = { false };
+
+    // only accessed by the thread which holds m_updating
+    std::deque<clock_sync_point> m_points = {};
+};
+
+int64_t
+clock_skew_model::operator()(uint64_t _gpu_ts)
+{
+    auto _next = m_next.load(std::memory_order_relaxed);
+    if(_next == 0 || (interval > 0 && comp::wall_clock::record() >= _next))
+    {
+        // the threads which do not claim the update keep the current fit unless there
+        // is none yet
+        if(!m_updating.exchange(true, std::memory_order_acquire))
         {
-            // warm up cache and allow for any static initialization
-            (void) _cpu_now();
-            (void) _gpu_now();
-        } while(false);
+            if(m_next.load(std::memory_order_relaxed) == _next) update();
+            m_updating.store(false, std::memory_order_release);
+        }
+    }
 
-        auto _compute = [](volatile uint64_t& _cpu_ts, volatile uint64_t& _gpu_ts) {
-            _cpu_ts = 0;
-            _gpu_ts = 0;
-            _cpu_ts += _cpu_now() / 2;
-            _gpu_ts += _gpu_now() / 1;
-            _cpu_ts += _cpu_now() / 2;
-            return static_cast<int64_t>(_cpu_ts) - static_cast<int64_t>(_gpu_ts);
-        };
-        constexpr int64_t _n       = 10;
-        int64_t           _cpu_ave = 0;
-        int64_t           _gpu_ave = 0;
-        int64_t           _diff    = 0;
-        for(int64_t i = 0; i < _n; ++i)
-        {
-            volatile uint64_t _cpu_ts = 0;
-            volatile uint64_t _gpu_ts = 0;
-            _diff += _compute(_cpu_ts, _gpu_ts);
-            _cpu_ave += _cpu_ts / _n;
-            _gpu_ave += _gpu_ts / _n;
-        }
-        OMNITRACE_BASIC_VERBOSE(2, "CPU timestamp: %li\n", _cpu_ave);
-        OMNITRACE_BASIC_VERBOSE(2, "HIP timestamp: %li\n", _gpu_ave);
-        OMNITRACE_BASIC_VERBOSE(1, "CPU/HIP timestamp skew: %li (used: %s)\n", _diff,
-                                _use ? "yes" : "no");
-        _diff /= _n;
-        return _diff;
+    auto _offset = int64_t{ 0 };
+    while(!read(_gpu_ts, _offset))
+        std::this_thread::yield();
+    return _offset;
+}
+
+bool
+clock_skew_model::read(uint64_t _gpu_ts, int64_t& _offset) const
+{
+    auto _seq = m_seq.load(std::memory_order_acquire);
+    if(_seq == 0 || (_seq & 1) != 0) return false;
+
+    auto _gpu_ref = m_gpu_ref.load(std::memory_order_relaxed);
+    auto _ref     = m_offset.load(std::memory_order_relaxed);
+    auto _slope   = m_slope.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(m_seq.load(std::memory_order_relaxed) != _seq) return false;
+
+    auto _dt = static_cast<long double>(_gpu_ts) - static_cast<long double>(_gpu_ref);
+    _offset  = _ref + static_cast<int64_t>(static_cast<long double>(_slope) * _dt);
+    return true;
+}
+
+void
+clock_skew_model::update()
+{
+    auto _point = sample_clock_skew();
+    OMNITRACE_BASIC_VERBOSE(m_points.empty() ? 1 : 3,
+                            "CPU/HIP timestamp skew: %li (at %lu)\n", _point.offset,
+                            _point.gpu_ts);
+    if(m_points.empty() || _point.gpu_ts > m_points.back().gpu_ts)
+        m_points.emplace_back(_point);
+    while(m_points.size() > max_points)
+        m_points.pop_front();
+
+    // the fit is computed relative to the mean of the points
+    auto _n     = static_cast<long double>(m_points.size());
+    auto _x0    = m_points.front().gpu_ts;
+    auto _sum_x = 0.0L;
+    auto _sum_y = 0.0L;
+    for(const auto& itr : m_points)
+    {
+        _sum_x += static_cast<long double>(itr.gpu_ts - _x0);
+        _sum_y += static_cast<long double>(itr.offset);
+    }
+    auto _mean_x = _sum_x / _n;
+    auto _mean_y = _sum_y / _n;
+
+    auto _sxx = 0.0L;
+    auto _sxy = 0.0L;
+    for(const auto& itr : m_points)
+    {
+        auto _dx = static_cast<long double>(itr.gpu_ts - _x0) - _mean_x;
+        _sxx += _dx * _dx;
+        _sxy += _dx * (static_cast<long double>(itr.offset) - _mean_y);
+    }
+    auto _slope = (_sxx > 0.0L) ? static_cast<double>(_sxy / _sxx) : 0.0;
+
+    auto _seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(_seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_gpu_ref.store(_x0 + static_cast<uint64_t>(_mean_x), std::memory_order_relaxed);
+    m_offset.store(static_cast<int64_t>(std::llround(_mean_y)),
+                   std::memory_order_relaxed);
+    m_slope.store(_slope, std::memory_order_relaxed);
+    m_seq.store(_seq + 2, std::memory_order_release);
+
+    m_next.store(_point.gpu_ts + _point.offset + std::max<uint64_t>(interval, 1),
+                 std::memory_order_relaxed);
+}
+
+auto&
+get_clock_skew_model()
+{
+    static auto* _v = []() {
+        auto* _model    = new clock_skew_model{};
+        auto  _interval = config::get_setting_value<double>(
+                             "OMNITRACE_ROCTRACER_CLOCK_SKEW_INTERVAL")
+                             .value_or(1.0);
+        _model->interval = (_interval > 0.0) ? (_interval * units::sec) : 0;
+        return _model;
     }();
-    return _v;
+    return *_v;
+}
+}  // namespace
+
+//
+int64_t
+get_clock_skew()
+{
+    uint64_t _gpu_ts = 0;
+    OMNITRACE_ROCTRACER_CALL(roctracer_get_timestamp(&_gpu_ts));
+    return get_clock_skew(_gpu_ts);
+}
+
+int64_t
+get_clock_skew(uint64_t _gpu_ts)
+{
+    static auto _use = tim::get_env("OMNITRACE_USE_ROCTRACER_CLOCK_SKEW", true);
+    if(!_use) return 0;
+    return get_clock_skew_model()(_gpu_ts);
 }
 
 // HSA API callback function
@@ -225,6 +772,7 @@ hsa_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
         return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(roctracer);
 
     (void) arg;
     const hsa_api_data_t* data = reinterpret_cast<const hsa_api_data_t*>(callback_data);
@@ -234,6 +782,7 @@ hsa_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
         (data->phase == ACTIVITY_API_PHASE_ENTER) ? "on-enter" : "on-exit");
 
     static thread_local int64_t begin_timestamp = 0;
+    static thread_local bool    is_traced       = true;
 
     switch(cid)
     {
@@ -282,9 +831,10 @@ hsa_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
         {
             if(data->phase == ACTIVITY_API_PHASE_ENTER)
             {
-                begin_timestamp = comp::wall_clock::record();
+                is_traced = sample_hsa_api(cid);
+                if(is_traced) begin_timestamp = comp::wall_clock::record();
             }
-            else
+            else if(is_traced)
             {
                 const auto* _name         = roctracer_op_string(domain, cid, 0);
                 const auto  end_timestamp = (cid == HSA_API_ID_hsa_shut_down)
@@ -345,6 +895,7 @@ hsa_activity_callback(uint32_t op, const void* vrecord, void* arg)
         return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(roctracer);
 
     auto&& _protect = comp::roctracer::protect_flush_activity();
     (void) _protect;
@@ -367,8 +918,8 @@ hsa_activity_callback(uint32_t op, const void* vrecord, void* arg)
 
     if(!_name) return;
 
-    auto _beg_ns = record->begin_ns + get_clock_skew();
-    auto _end_ns = record->end_ns + get_clock_skew();
+    auto _beg_ns = record->begin_ns + get_clock_skew(record->begin_ns);
+    auto _end_ns = record->end_ns + get_clock_skew(record->end_ns);
 
     if(get_use_perfetto())
     {
@@ -414,22 +965,573 @@ hip_exec_activity_callbacks(int64_t _tid)
     // guard against initialization of structure when trying to exec
     if(static_cast<size_t>(_tid) >= get_hip_activity_callbacks_size()) return;
 
-    // OMNITRACE_ROCTRACER_CALL(roctracer_flush_activity());
+    auto& _async_ops = get_hip_activity_callbacks(_tid);
+    if(!_async_ops || _async_ops->empty()) return;
+
     locking::atomic_lock _lk{ get_hip_activity_mutex(_tid) };
-    auto&                _async_ops = get_hip_activity_callbacks(_tid);
-    if(!_async_ops) return;
-    for(auto& itr : *_async_ops)
-    {
-        if(itr) itr();
-    }
-    _async_ops->clear();
+    _async_ops->consume([](const hip_activity_record& _record) {
+        auto _elapsed = _record.end_ns - _record.begin_ns;
+        auto _bundle  = roctracer_hip_bundle_t{ _record.name };
+        _bundle.start()
+            .store(std::plus<double>{}, static_cast<double>(_elapsed))
+            .stop()
+            .get<comp::wall_clock>([_elapsed](comp::wall_clock* wc) {
+                wc->set_value(_elapsed);
+                wc->set_accum(_elapsed);
+                return wc;
+            });
+        _bundle.pop();
+    });
 }
 
 namespace
 {
 thread_local std::unordered_map<size_t, size_t> gpu_crit_cids = {};
+
+// marks the thread as waiting for the GPU for the samples taken inside the
+// synchronizing HIP functions (see OMNITRACE_SAMPLING_COLLAPSE_GPU_WAIT)
+void
+update_gpu_wait(uint32_t _cid, const hip_api_data_t* _data)
+{
+    using backtrace_t = component::backtrace;
+
+    auto _frame = backtrace_t::no_gpu_wait;
+    switch(_cid)
+    {
+        case HIP_API_ID_hipDeviceSynchronize:
+            _frame = backtrace_t::device_synchronize_wait;
+            break;
+        case HIP_API_ID_hipStreamSynchronize:
+            _frame = backtrace_t::stream_synchronize_wait;
+            break;
+        case HIP_API_ID_hipEventSynchronize:
+            _frame = backtrace_t::event_synchronize_wait;
+            break;
+        default: return;
+    }
+
+    backtrace_t::get_gpu_wait() =
+        (_data->phase == ACTIVITY_API_PHASE_ENTER) ? _frame : backtrace_t::no_gpu_wait;
+}
+
+// the HIP functions which wait for the work previously submitted to the device. The
+// synchronous copies are identified by their device operation instead
+bool
+is_synchronizing(uint32_t _cid)
+{
+    switch(_cid)
+    {
+        case HIP_API_ID_hipDeviceSynchronize:
+        case HIP_API_ID_hipStreamSynchronize:
+        case HIP_API_ID_hipEventSynchronize:
+        case HIP_API_ID_hipFree: return true;
+        default: break;
+    }
+    return false;
+}
+
+// reports the allocations on exit, when the pointer is set, and the deallocations on
+// entry, before the memory can be reused (see OMNITRACE_GPU_MEMORY_TRACKING)
+void
+update_gpu_memory(uint32_t _cid, const hip_api_data_t* _data, const char* _name,
+                  int32_t _device)
+{
+    const bool  _enter = (_data->phase == ACTIVITY_API_PHASE_ENTER);
+    const auto& _args  = _data->args;
+
+    auto _alloc = [&](void** _ptr, size_t _size, int32_t _dev) {
+        if(!_enter && _ptr != nullptr && *_ptr != nullptr)
+            gpu_memory::record_allocation(_dev, *_ptr, _size, _name);
+    };
+
+    auto _free = [&](const void* _ptr) {
+        if(_enter) gpu_memory::record_free(_ptr);
+    };
+
+    switch(_cid)
+    {
+        case HIP_API_ID_hipMalloc:
+            _alloc(_args.hipMalloc.ptr, _args.hipMalloc.size, _device);
+            break;
+        case HIP_API_ID_hipExtMallocWithFlags:
+            _alloc(_args.hipExtMallocWithFlags.ptr, _args.hipExtMallocWithFlags.sizeBytes,
+                   _device);
+            break;
+        case HIP_API_ID_hipMallocManaged:
+            _alloc(_args.hipMallocManaged.dev_ptr, _args.hipMallocManaged.size, _device);
+            break;
+        case HIP_API_ID_hipMallocPitch:
+        {
+            const auto& _v = _args.hipMallocPitch;
+            if(!_enter && _v.pitch != nullptr)
+                _alloc(_v.ptr, *_v.pitch * _v.height, _device);
+            break;
+        }
+#if OMNITRACE_HIP_VERSION >= 50200
+        case HIP_API_ID_hipMallocAsync:
+            _alloc(_args.hipMallocAsync.dev_ptr, _args.hipMallocAsync.size, _device);
+            break;
+        case HIP_API_ID_hipMallocFromPoolAsync:
+            _alloc(_args.hipMallocFromPoolAsync.dev_ptr,
+                   _args.hipMallocFromPoolAsync.size, _device);
+            break;
+        case HIP_API_ID_hipFreeAsync: _free(_args.hipFreeAsync.dev_ptr); break;
+#endif
+        case HIP_API_ID_hipHostMalloc:
+            _alloc(_args.hipHostMalloc.ptr, _args.hipHostMalloc.size,
+                   gpu_memory::host_device);
+            break;
+        case HIP_API_ID_hipMallocHost:
+            _alloc(_args.hipMallocHost.ptr, _args.hipMallocHost.size,
+                   gpu_memory::host_device);
+            break;
+        case HIP_API_ID_hipHostAlloc:
+            _alloc(_args.hipHostAlloc.ptr, _args.hipHostAlloc.size,
+                   gpu_memory::host_device);
+            break;
+        case HIP_API_ID_hipFree: _free(_args.hipFree.ptr); break;
+        case HIP_API_ID_hipHostFree: _free(_args.hipHostFree.ptr); break;
+        case HIP_API_ID_hipFreeHost: _free(_args.hipFreeHost.ptr); break;
+        default: break;
+    }
 }
 
+// records the device and the pinned host allocations like update_gpu_memory and the
+// pointers of the copy functions on entry (see OMNITRACE_MEMCPY_ANALYSIS)
+void
+update_memcpy_analysis(uint32_t _cid, const hip_api_data_t* _data, int32_t _device)
+{
+    static_assert(memcpy_analysis::host_to_device_kind == hipMemcpyHostToDevice &&
+                      memcpy_analysis::default_kind == hipMemcpyDefault,
+                  "memcpy_analysis::copy_kind does not match hipMemcpyKind");
+
+    const bool  _enter   = (_data->phase == ACTIVITY_API_PHASE_ENTER);
+    const auto& _args    = _data->args;
+    const auto  _corr_id = _data->correlation_id;
+
+    auto _alloc = [&](void** _ptr, size_t _size, int32_t _dev) {
+        if(!_enter && _ptr != nullptr && *_ptr != nullptr)
+            memcpy_analysis::record_allocation(_dev, *_ptr, _size);
+    };
+
+    auto _free = [&](const void* _ptr) {
+        if(_enter) memcpy_analysis::record_free(_ptr);
+    };
+
+    auto _copy = [&](const void* _dst, const void* _src, size_t _size, auto _kind) {
+        if(_enter)
+            memcpy_analysis::copy(_corr_id, _dst, _src, _size,
+                                  static_cast<memcpy_analysis::copy_kind>(_kind));
+    };
+
+    switch(_cid)
+    {
+        case HIP_API_ID_hipMalloc:
+            _alloc(_args.hipMalloc.ptr, _args.hipMalloc.size, _device);
+            break;
+        case HIP_API_ID_hipExtMallocWithFlags:
+            _alloc(_args.hipExtMallocWithFlags.ptr, _args.hipExtMallocWithFlags.sizeBytes,
+                   _device);
+            break;
+        case HIP_API_ID_hipMallocManaged:
+            _alloc(_args.hipMallocManaged.dev_ptr, _args.hipMallocManaged.size, _device);
+            break;
+#if OMNITRACE_HIP_VERSION >= 50200
+        case HIP_API_ID_hipMallocAsync:
+            _alloc(_args.hipMallocAsync.dev_ptr, _args.hipMallocAsync.size, _device);
+            break;
+        case HIP_API_ID_hipFreeAsync: _free(_args.hipFreeAsync.dev_ptr); break;
+#endif
+        case HIP_API_ID_hipHostMalloc:
+            _alloc(_args.hipHostMalloc.ptr, _args.hipHostMalloc.size,
+                   memcpy_analysis::host_device);
+            break;
+        case HIP_API_ID_hipMallocHost:
+            _alloc(_args.hipMallocHost.ptr, _args.hipMallocHost.size,
+                   memcpy_analysis::host_device);
+            break;
+        case HIP_API_ID_hipHostAlloc:
+            _alloc(_args.hipHostAlloc.ptr, _args.hipHostAlloc.size,
+                   memcpy_analysis::host_device);
+            break;
+        case HIP_API_ID_hipHostRegister:
+        {
+            const auto& _v = _args.hipHostRegister;
+            if(!_enter)
+                memcpy_analysis::record_allocation(memcpy_analysis::host_device,
+                                                   _v.hostPtr, _v.sizeBytes);
+            break;
+        }
+        case HIP_API_ID_hipFree: _free(_args.hipFree.ptr); break;
+        case HIP_API_ID_hipHostFree: _free(_args.hipHostFree.ptr); break;
+        case HIP_API_ID_hipFreeHost: _free(_args.hipFreeHost.ptr); break;
+        case HIP_API_ID_hipHostUnregister: _free(_args.hipHostUnregister.hostPtr); break;
+        case HIP_API_ID_hipMemcpy:
+        {
+            const auto& _v = _args.hipMemcpy;
+            _copy(_v.dst, _v.src, _v.sizeBytes, _v.kind);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyAsync:
+        {
+            const auto& _v = _args.hipMemcpyAsync;
+            _copy(_v.dst, _v.src, _v.sizeBytes, _v.kind);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyWithStream:
+        {
+            const auto& _v = _args.hipMemcpyWithStream;
+            _copy(_v.dst, _v.src, _v.sizeBytes, _v.kind);
+            break;
+        }
+        case HIP_API_ID_hipMemcpy2D:
+        {
+            const auto& _v = _args.hipMemcpy2D;
+            _copy(_v.dst, _v.src, _v.width * _v.height, _v.kind);
+            break;
+        }
+        case HIP_API_ID_hipMemcpy2DAsync:
+        {
+            const auto& _v = _args.hipMemcpy2DAsync;
+            _copy(_v.dst, _v.src, _v.width * _v.height, _v.kind);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyHtoD:
+        {
+            const auto& _v = _args.hipMemcpyHtoD;
+            _copy(_v.dst, _v.src, _v.sizeBytes, hipMemcpyHostToDevice);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyHtoDAsync:
+        {
+            const auto& _v = _args.hipMemcpyHtoDAsync;
+            _copy(_v.dst, _v.src, _v.sizeBytes, hipMemcpyHostToDevice);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoH:
+        {
+            const auto& _v = _args.hipMemcpyDtoH;
+            _copy(_v.dst, _v.src, _v.sizeBytes, hipMemcpyDeviceToHost);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoHAsync:
+        {
+            const auto& _v = _args.hipMemcpyDtoHAsync;
+            _copy(_v.dst, _v.src, _v.sizeBytes, hipMemcpyDeviceToHost);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoD:
+        {
+            const auto& _v = _args.hipMemcpyDtoD;
+            _copy(_v.dst, _v.src, _v.sizeBytes, hipMemcpyDeviceToDevice);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyDtoDAsync:
+        {
+            const auto& _v = _args.hipMemcpyDtoDAsync;
+            _copy(_v.dst, _v.src, _v.sizeBytes, hipMemcpyDeviceToDevice);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyPeer:
+        {
+            const auto& _v = _args.hipMemcpyPeer;
+            if(_enter)
+                memcpy_analysis::peer_copy(_corr_id, _v.dstDeviceId, _v.srcDeviceId,
+                                           _v.sizeBytes);
+            break;
+        }
+        case HIP_API_ID_hipMemcpyPeerAsync:
+        {
+            const auto& _v = _args.hipMemcpyPeerAsync;
+            if(_enter)
+                memcpy_analysis::peer_copy(_corr_id, _v.dstDeviceId, _v.srcDevice,
+                                           _v.sizeBytes);
+            break;
+        }
+        default: break;
+    }
+}
+
+// the stream of a kernel launch or nullptr if the function is not a kernel launch
+const void*
+get_launch_stream(uint32_t _cid, const hip_api_data_t* _data)
+{
+    const auto& _args = _data->args;
+    switch(_cid)
+    {
+        case HIP_API_ID_hipLaunchKernel: return _args.hipLaunchKernel.stream;
+        case HIP_API_ID_hipLaunchCooperativeKernel:
+            return _args.hipLaunchCooperativeKernel.stream;
+        case HIP_API_ID_hipHccModuleLaunchKernel:
+            return _args.hipHccModuleLaunchKernel.hStream;
+        case HIP_API_ID_hipModuleLaunchKernel: return _args.hipModuleLaunchKernel.stream;
+        case HIP_API_ID_hipExtModuleLaunchKernel:
+            return _args.hipExtModuleLaunchKernel.hStream;
+        case HIP_API_ID_hipExtLaunchKernel: return _args.hipExtLaunchKernel.stream;
+        default: break;
+    }
+    return nullptr;
+}
+
+// records the construction, the instantiation and the launches of the HIP graphs. The
+// handles are set on exit and the launches are timed from entry to exit (see
+// OMNITRACE_HIP_GRAPHS)
+void
+update_hip_graphs(uint32_t _cid, const hip_api_data_t* _data, uint64_t _ts)
+{
+#if OMNITRACE_HIP_VERSION >= 50000
+    const bool  _enter = (_data->phase == ACTIVITY_API_PHASE_ENTER);
+    const auto& _args  = _data->args;
+
+    auto _deref = [](auto* _ptr) -> const void* {
+        return (_ptr == nullptr) ? nullptr : *_ptr;
+    };
+
+    switch(_cid)
+    {
+        case HIP_API_ID_hipStreamBeginCapture:
+            if(_enter) hip_graph::begin_capture(_args.hipStreamBeginCapture.stream);
+            break;
+        case HIP_API_ID_hipStreamEndCapture:
+            if(!_enter)
+                hip_graph::end_capture(_args.hipStreamEndCapture.stream,
+                                       _deref(_args.hipStreamEndCapture.pGraph));
+            break;
+        case HIP_API_ID_hipGraphCreate:
+            if(!_enter) hip_graph::create_graph(_deref(_args.hipGraphCreate.pGraph));
+            break;
+        case HIP_API_ID_hipGraphAddKernelNode:
+        {
+            const auto& _v = _args.hipGraphAddKernelNode;
+            if(!_enter && _v.pNodeParams != nullptr)
+                hip_graph::add_kernel_node(
+                    _v.graph, _deref(_v.pGraphNode),
+                    hipKernelNameRefByPtr(_v.pNodeParams->func, nullptr));
+            break;
+        }
+        case HIP_API_ID_hipGraphInstantiate:
+            if(!_enter)
+                hip_graph::instantiate(_deref(_args.hipGraphInstantiate.pGraphExec),
+                                       _args.hipGraphInstantiate.graph);
+            break;
+        case HIP_API_ID_hipGraphInstantiateWithFlags:
+        {
+            const auto& _v = _args.hipGraphInstantiateWithFlags;
+            if(!_enter) hip_graph::instantiate(_deref(_v.pGraphExec), _v.graph);
+            break;
+        }
+        case HIP_API_ID_hipGraphLaunch:
+            if(_enter)
+                hip_graph::launch_begin(_data->correlation_id,
+                                        _args.hipGraphLaunch.graphExec, _ts);
+            else
+                hip_graph::launch_end(_data->correlation_id, _ts);
+            break;
+        default: break;
+    }
+#else
+    (void) _cid;
+    (void) _data;
+    (void) _ts;
+#endif
+}
+
+// adds the arguments of the HIP API call to the slice as one annotation or as one
+// annotation per argument (see OMNITRACE_PERFETTO_COMPACT_ROCTRACER_ANNOTATIONS)
+void
+add_hip_api_args_annotations(tracing::perfetto_event_context_t& ctx,
+                             hip_api_id_t _api_id, const hip_api_data_t* _data)
+{
+    if(config::get_snapshot().perfetto_compact_roctracer_annotations)
+    {
+        tracing::add_perfetto_annotation(ctx, "args", hip_api_string(_api_id, _data));
+        return;
+    }
+
+    auto _args = std::string{ hip_api_string(_api_id, _data) };
+    if(_args.empty()) return;
+
+    for(auto itr : tim::delimit(_args, ","))
+    {
+        if(itr.empty()) continue;
+        auto _bpos = itr.find_first_not_of(' ');
+        auto _epos = itr.find_last_not_of(' ');
+        if(_epos > _bpos) itr = itr.substr(_bpos, (_epos - _bpos) + 1);
+        auto _pos = itr.find('=');
+        if(_pos != std::string::npos)
+            tracing::add_perfetto_annotation(ctx, itr.substr(0, _pos),
+                                             itr.substr(_pos + 1));
+    }
+}
+
+// In OMNITRACE_PERFETTO_DEFERRED_ROCTRACER_ANNOTATIONS mode, the callback only copies
+// the callback data of the HIP API call into a per-thread buffer on exit, i.e. after
+// HIP stored the values of the output arguments. Once a batch of calls completed, a
+// roctracer thread formats the arguments and emits the slices on the track of the
+// thread which made the calls
+struct deferred_hip_api_begin
+{
+    uint64_t corr_id    = 0;
+    uint64_t begin_ns   = 0;
+    uint64_t cid        = 0;
+    uint64_t parent_cid = 0;
+    uint32_t depth      = 0;
+    int32_t  device     = 0;
+};
+
+struct deferred_hip_api_call
+{
+    const char*            name   = nullptr;
+    uint32_t               op     = 0;
+    uint64_t               end_ns = 0;
+    deferred_hip_api_begin begin  = {};
+
+    // the raw bytes of the hip_api_data_t (the union of the arguments has members
+    // which are not default constructible in some HIP versions). Not initialized
+    // since it is always overwritten
+    alignas(hip_api_data_t) std::array<char, sizeof(hip_api_data_t)> data;
+};
+
+struct deferred_hip_api_calls
+{
+    static constexpr size_t batch_size = 256;
+
+    int64_t                             tid     = threading::get_id();
+    int64_t                             sys_tid = threading::get_sys_tid();
+    locking::atomic_mutex               mutex   = {};
+    std::vector<deferred_hip_api_begin> open    = {};
+    std::vector<deferred_hip_api_call>  calls   = {};
+};
+
+using deferred_hip_api_data =
+    omnitrace::thread_data<deferred_hip_api_calls, deferred_hip_api_calls>;
+
+deferred_hip_api_calls&
+get_deferred_hip_api_calls()
+{
+    static thread_local auto* _v = []() {
+        auto& _calls = deferred_hip_api_data::instance(construct_on_thread{});
+        if(!_calls)
+        {
+            _calls = std::make_unique<deferred_hip_api_calls>();
+            _calls->calls.reserve(deferred_hip_api_calls::batch_size);
+        }
+        return _calls.get();
+    }();
+    return *_v;
+}
+
+// the functions with string arguments are formatted during the call because the
+// strings may not outlive it
+bool
+use_deferred_hip_api(uint32_t _cid)
+{
+    const auto& _cfg = config::get_snapshot();
+    if(!_cfg.perfetto_deferred_roctracer_annotations ||
+       _cfg.roctracer_hip_api_backtrace || !config::get_perfetto_annotations())
+        return false;
+
+    switch(_cid)
+    {
+        case HIP_API_ID_hipDeviceGetName:
+        case HIP_API_ID_hipModuleGetFunction:
+        case HIP_API_ID_hipModuleGetGlobal:
+        case HIP_API_ID_hipModuleGetTexRef:
+        case HIP_API_ID_hipModuleLoad: return false;
+        default: break;
+    }
+    return true;
+}
+
+void
+emit_deferred_hip_api_calls(int64_t _tid, int64_t _sys_tid,
+                            const std::vector<deferred_hip_api_call>& _calls)
+{
+    const auto _track = ::perfetto::ThreadTrack::ForThread(
+        static_cast<::perfetto::base::PlatformThreadId>(_sys_tid));
+    for(const auto& itr : _calls)
+    {
+        const auto* _data   = reinterpret_cast<const hip_api_data_t*>(itr.data.data());
+        auto        _api_id = static_cast<hip_api_id_t>(itr.op);
+        const auto& _beg    = itr.begin;
+        tracing::push_perfetto_track(
+            category::rocm_hip{}, itr.name, _track, _beg.begin_ns,
+            ::perfetto::Flow::ProcessScoped(_beg.corr_id),
+            [&](::perfetto::EventContext ctx) {
+                tracing::add_perfetto_annotation(ctx, "begin_ns", _beg.begin_ns);
+                tracing::add_perfetto_annotation(ctx, "cid", _beg.cid);
+                tracing::add_perfetto_annotation(ctx, "pcid", _beg.parent_cid);
+                tracing::add_perfetto_annotation(ctx, "device", _beg.device);
+                tracing::add_perfetto_annotation(ctx, "tid", _tid);
+                tracing::add_perfetto_annotation(ctx, "depth", _beg.depth);
+                tracing::add_perfetto_annotation(ctx, "corr_id", _beg.corr_id);
+                add_hip_api_args_annotations(ctx, _api_id, _data);
+            });
+        tracing::pop_perfetto_track(category::rocm_hip{}, itr.name, _track, itr.end_ns,
+                                    [&](::perfetto::EventContext ctx) {
+                                        tracing::add_perfetto_annotation(ctx, "end_ns",
+                                                                         itr.end_ns);
+                                    });
+    }
+}
+
+// hands the completed calls of the thread to the roctracer thread-pool. Expects the
+// lock of the buffer to be held
+void
+submit_deferred_hip_api_calls(deferred_hip_api_calls& _v)
+{
+    if(_v.calls.empty()) return;
+
+    auto _calls = std::make_shared<std::vector<deferred_hip_api_call>>();
+    _calls->reserve(deferred_hip_api_calls::batch_size);
+    std::swap(*_calls, _v.calls);
+
+    auto _func = [_tid = _v.tid, _sys_tid = _v.sys_tid, _calls]() {
+        emit_deferred_hip_api_calls(_tid, _sys_tid, *_calls);
+    };
+
+    if(tasking::roctracer::get_task_group().pool())
+        tasking::roctracer::get_task_group().exec(_func);
+    else
+        _func();
+}
+
+void
+begin_deferred_hip_api(deferred_hip_api_begin&& _begin)
+{
+    auto& _v  = get_deferred_hip_api_calls();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+    _v.open.emplace_back(_begin);
+}
+
+// returns false if the call was not deferred on entry
+bool
+end_deferred_hip_api(const char* _name, uint32_t _op, const hip_api_data_t* _data,
+                     uint64_t _end_ns)
+{
+    auto& _v  = get_deferred_hip_api_calls();
+    auto  _lk = locking::atomic_lock{ _v.mutex };
+
+    // the calls are nested so the call is almost always the last one
+    auto itr = std::find_if(_v.open.rbegin(), _v.open.rend(), [_data](const auto& _b) {
+        return _b.corr_id == _data->correlation_id;
+    });
+    if(itr == _v.open.rend()) return false;
+
+    auto& _call  = _v.calls.emplace_back();
+    _call.name   = _name;
+    _call.op     = _op;
+    _call.end_ns = _end_ns;
+    _call.begin  = *itr;
+    std::memcpy(_call.data.data(), _data, sizeof(hip_api_data_t));
+    _v.open.erase(std::next(itr).base());
+
+    if(_v.calls.size() >= deferred_hip_api_calls::batch_size)
+        submit_deferred_hip_api_calls(_v);
+    return true;
+}
+}  // namespace
+
 void
 roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
                    void* /*arg*/)
@@ -438,6 +1540,7 @@ roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
         return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(roctracer);
 
     if(domain != ACTIVITY_DOMAIN_ROCTX) return;
 
@@ -530,10 +1633,15 @@ roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
 void
 hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void* arg)
 {
+    // precedes the check of the state so that the flag is always cleared on exit
+    if(config::get_snapshot().sampling_collapse_gpu_wait)
+        update_gpu_wait(cid, reinterpret_cast<const hip_api_data_t*>(callback_data));
+
     if(get_state() != State::Active || !trait::runtime_enabled<comp::roctracer>::get())
         return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(roctracer);
 
     assert(domain == ACTIVITY_DOMAIN_HIP_API);
     const char* op_name = roctracer_op_string(domain, cid, 0);
@@ -570,6 +1678,14 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
 
     auto& _device_id = get_current_device();
 
+    if(config::get_snapshot().gpu_memory_tracking)
+        update_gpu_memory(cid, data, op_name, std::max(_device_id - 1, 0));
+
+    if(config::get_snapshot().memcpy_analysis)
+        update_memcpy_analysis(cid, data, std::max(_device_id - 1, 0));
+
+    if(config::get_snapshot().hip_graphs) update_hip_graphs(cid, data, static_cast<uint64_t>(_ts));
+
     if(data->phase == ACTIVITY_API_PHASE_ENTER)
     {
         if(cid == HIP_API_ID_hipSetDevice)
@@ -623,54 +1739,48 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
             default: break;
         }
 
+        // the kernels launched on a stream which is captured into a graph are not
+        // executed until the graph is launched
+        if(_name != nullptr && config::get_snapshot().hip_graphs &&
+           hip_graph::capture_launch(get_launch_stream(cid, data), _name))
+            _name = nullptr;
+
+        // the call-stacks are symbolized once per unique stack at finalization
+        uint64_t _stack_id = 0;
+        if(config::get_snapshot().roctracer_hip_api_backtrace && get_use_perfetto() &&
+           config::get_perfetto_annotations())
+            _stack_id = hip_api_stacks::capture();
+
         if(_name != nullptr)
         {
             if(get_use_perfetto() || get_use_timemory() || get_use_rocm_smi())
             {
-                locking::atomic_lock _lk{ roctracer_type_mutex<key_data_mutex_t>() };
-                get_roctracer_key_data().emplace(_roct_cid, _name);
-                get_roctracer_tid_data().emplace(_roct_cid, _tid);
+                set_roctracer_correlation(_roct_cid, _name, _tid, _stack_id);
             }
-        }
 
-        std::tie(_crit_cid, _parent_crit_cid, _depth) = create_cpu_cid_entry();
+            if(config::get_snapshot().rcclp_device_timing)
+                rccl_timing::hip_launch(_roct_cid);
 
-        if(get_use_perfetto())
-        {
-            static auto _compact_annotations =
-                config::get_setting_value<bool>(
-                    "OMNITRACE_PERFETTO_COMPACT_ROCTRACER_ANNOTATIONS")
-                    .value_or(false);
+            if(trace_trigger::get_enabled().kernel) trace_trigger::kernel_launch(_name);
 
-            static auto _enable_backtraces =
-                config::get_setting_value<bool>("OMNITRACE_ROCTRACER_HIP_API_BACKTRACE")
-                    .value_or(false);
+            if(config::get_snapshot().kernel_launch_latency)
+                kernel_launch::launch(_roct_cid, static_cast<uint64_t>(_ts));
 
-            constexpr size_t bt_stack_depth       = 16;
-            constexpr size_t bt_ignore_depth      = 3;
-            constexpr bool   bt_with_signal_frame = true;
+            get_hip_launch_correlation_id() = _roct_cid;
+        }
 
-            using backtrace_entry_vec_t = std::vector<tim::unwind::processed_entry>;
-            auto _bt_data               = std::optional<backtrace_entry_vec_t>{};
-            if(_enable_backtraces && config::get_perfetto_annotations())
-            {
-                auto _backtrace = tim::get_unw_stack<bt_stack_depth, bt_ignore_depth,
-                                                     bt_with_signal_frame>();
-                _bt_data        = backtrace_entry_vec_t{};
-                _bt_data->reserve(_backtrace.size());
-                for(auto itr : _backtrace)
-                {
-                    if(itr)
-                    {
-                        if(auto _val = binary::lookup_ipaddr_entry<false>(itr->address());
-                           _val)
-                        {
-                            _bt_data->emplace_back(std::move(*_val));
-                        }
-                    }
-                }
-            }
+        std::tie(_crit_cid, _parent_crit_cid, _depth) = create_cpu_cid_entry();
 
+        if(config::get_snapshot().critical_path) critical_path::api_begin(_roct_cid, _ts);
+
+        if(get_use_perfetto() && use_deferred_hip_api(cid))
+        {
+            begin_deferred_hip_api(deferred_hip_api_begin{
+                _roct_cid, static_cast<uint64_t>(_ts), _crit_cid, _parent_crit_cid,
+                _depth, _device_id });
+        }
+        else if(get_use_perfetto())
+        {
             auto _api_id = static_cast<hip_api_id_t>(cid);
             tracing::push_perfetto_ts(
                 category::rocm_hip{}, op_name, _ts,
@@ -685,61 +1795,11 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
                         tracing::add_perfetto_annotation(ctx, "tid", _tid);
                         tracing::add_perfetto_annotation(ctx, "depth", _depth);
                         tracing::add_perfetto_annotation(ctx, "corr_id", _roct_cid);
-                        if(_compact_annotations)
-                        {
-                            tracing::add_perfetto_annotation(
-                                ctx, "args", hip_api_string(_api_id, data));
-                        }
-                        else
-                        {
-                            auto _args = std::string{ hip_api_string(_api_id, data) };
-                            if(!_args.empty())
-                            {
-                                for(auto itr : tim::delimit(_args, ","))
-                                {
-                                    if(itr.empty()) continue;
-                                    auto _bpos = itr.find_first_not_of(' ');
-                                    auto _epos = itr.find_last_not_of(' ');
-                                    if(_epos > _bpos)
-                                        itr = itr.substr(_bpos, (_epos - _bpos) + 1);
-                                    auto _pos = itr.find('=');
-                                    if(_pos != std::string::npos)
-                                        tracing::add_perfetto_annotation(
-                                            ctx, itr.substr(0, _pos),
-                                            itr.substr(_pos + 1));
-                                }
-                            }
-                        }
-
-                        if(_enable_backtraces && _bt_data && !_bt_data->empty())
-                        {
-                            const std::string _unk    = "??";
-                            size_t            _bt_cnt = 0;
-                            for(const auto& itr : *_bt_data)
-                            {
-                                const auto* _func =
-                                    (itr.name.empty()) ? &_unk : &itr.name;
-                                const auto* _loc =
-                                    (itr.location.empty()) ? &_unk : &itr.location;
-                                auto _line  = (itr.lineno == 0) ? std::string{ "?" }
-                                                                : join("", itr.lineno);
-                                auto _entry = join("", demangle(*_func), " @ ",
-                                                   join(':', *_loc, _line));
-                                if(_bt_cnt < 10)
-                                {
-                                    // Prepend zero for better ordering in UI.
-                                    // Only one zero is ever necessary since stack depth
-                                    // is limited to 16.
-                                    tracing::add_perfetto_annotation(
-                                        ctx, join("", "frame#0", _bt_cnt++), _entry);
-                                }
-                                else
-                                {
-                                    tracing::add_perfetto_annotation(
-                                        ctx, join("", "frame#", _bt_cnt++), _entry);
-                                }
-                            }
-                        }
+                        add_hip_api_args_annotations(ctx, _api_id, data);
+
+                        if(_stack_id != 0)
+                            tracing::add_perfetto_annotation(ctx, "stack_id",
+                                                             _stack_id);
                     }
                 });
         }
@@ -750,11 +1810,15 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
             if(itr.second)
             {
                 itr.first->second.start();
+                memory_footprint::track(memory_footprint::roctracer_subsystem,
+                                        hip_data_node_size);
             }
             else if(itr.first != get_roctracer_hip_data()->end())
             {
                 itr.first->second.stop();
                 get_roctracer_hip_data()->erase(itr.first);
+                memory_footprint::track(memory_footprint::roctracer_subsystem,
+                                        -hip_data_node_size);
             }
         }
 
@@ -762,9 +1826,14 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
     }
     else if(data->phase == ACTIVITY_API_PHASE_EXIT)
     {
+        get_hip_launch_correlation_id() = 0;
         hip_exec_activity_callbacks(_tid);
 
-        if(get_use_perfetto())
+        if(config::get_snapshot().critical_path)
+            critical_path::api_end(_roct_cid, op_name, std::max(_device_id - 1, 0),
+                                   is_synchronizing(cid), _ts);
+
+        if(get_use_perfetto() && !end_deferred_hip_api(op_name, cid, data, _ts))
         {
             tracing::pop_perfetto_ts(
                 category::rocm_hip{}, op_name, _ts, [&](::perfetto::EventContext ctx) {
@@ -783,6 +1852,8 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
                 {
                     itr->second.stop();
                     _data->erase(itr);
+                    memory_footprint::track(memory_footprint::roctracer_subsystem,
+                                            -hip_data_node_size);
                     return true;
                 }
                 return false;
@@ -799,6 +1870,166 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
     tim::consume_parameters(arg);
 }
 
+void
+hip_device_activity_callback(uint32_t _op, uint64_t _corr_id, const char* op_name,
+                             int32_t _devid, int64_t _queid, uint64_t _gpu_beg_ns,
+                             uint64_t _gpu_end_ns, uint64_t _bytes)
+{
+    auto _critical_path = config::get_snapshot().critical_path;
+    auto _rccl_timing   = config::get_snapshot().rcclp_device_timing;
+    auto _energy        = config::get_snapshot().energy;
+    auto _gpu_attr      = config::get_snapshot().gpu_attribution;
+    auto _causal        = config::get_snapshot().causal_kernels;
+    auto _roofline      = config::get_snapshot().rocm_roofline;
+    auto _hip_graphs    = config::get_snapshot().hip_graphs;
+    auto _launch        = config::get_snapshot().kernel_launch_latency;
+    auto _memcpy        = config::get_snapshot().memcpy_analysis;
+    auto _live          = config::get_snapshot().live_export;
+
+    uint64_t _beg_ns   = _gpu_beg_ns + get_clock_skew(_gpu_beg_ns);
+    uint64_t _end_ns   = _gpu_end_ns + get_clock_skew(_gpu_end_ns);
+    auto     _roct_cid = _corr_id;
+
+    int64_t     _tid   = 0;  // thread id
+    uintptr_t   _queue = 0;  // Host queue (stream)
+    uint64_t    _stack = 0;        // id of the call-stack of the launch
+    const char* _name  = nullptr;
+    bool        _found = get_roctracer_correlation(_roct_cid, _name, _tid, _stack);
+
+    if(!_found)
+    {
+        _name = nullptr;
+        _tid  = 0;
+    }
+
+    // the nodes of a graph launch are not kernel launches on the host
+    if(!_found && _hip_graphs && _op == HIP_OP_ID_DISPATCH)
+        _name = hip_graph::device_op(_roct_cid, _beg_ns, _end_ns);
+
+    if(_name == nullptr && op_name == nullptr) return;
+    if(_name == nullptr) _name = op_name;
+
+    static auto _op_id_names =
+        std::array<const char*, 3>{ "DISPATCH", "COPY", "BARRIER" };
+
+    // demangled once per distinct kernel and shared with the timemory output
+    const char* _kernel_name = rocm::get_kernel_symbol(_name).name.c_str();
+
+    if(_end_ns < _beg_ns)
+    {
+        auto          _verbose = []() { return get_verbose() >= 0 || get_debug(); };
+        static size_t _n       = 0;
+        static size_t _nmax = get_env<size_t>("OMNITRACE_ROCTRACER_DISCARD_INVALID", 0);
+        if(_nmax == 0) std::swap(_end_ns, _beg_ns);
+        OMNITRACE_WARNING_IF_F(
+            _n < _nmax && _verbose(),
+            "%4zu :: Discarding kernel roctracer activity record which ended before "
+            "it started :: %-20s :: %-20s :: cid=%lu, time_ns=(%12lu:%12lu) "
+            "delta=%li, device=%d, queue=%lu, tid=%lu, op=%s\n",
+            _n, op_name, _name, _roct_cid, _beg_ns, _end_ns,
+            (static_cast<int64_t>(_end_ns) - static_cast<int64_t>(_beg_ns)), _devid,
+            _queid, _tid, _op_id_names.at(_op));
+        OMNITRACE_WARNING_IF_F(
+            _nmax > 0 && _n == _nmax && _verbose(),
+            "Suppressing future messages about discarding kernel roctracer activity "
+            "record which ended before it started. Set "
+            "OMNITRACE_ROCTRACER_DISCARD_INVALID=N to increase/decrease the number "
+            "of messages. If N is set to 0, data will be included after swapping the "
+            "begin and end values\n");
+        if(_end_ns < _beg_ns)
+        {
+            ++_n;
+            return;
+        }
+    }
+
+    if(_critical_path)
+    {
+        static constexpr auto _op_kinds = std::array<critical_path::node_kind, 3>{
+            critical_path::kernel_node, critical_path::copy_node,
+            critical_path::barrier_node
+        };
+        critical_path::device_op(_op_kinds.at(_op), _roct_cid, _kernel_name, _devid,
+                                 _queid, _beg_ns, _end_ns);
+    }
+
+    if(_rccl_timing && _op == HIP_OP_ID_DISPATCH)
+        rccl_timing::device_op(_roct_cid, _beg_ns, _end_ns);
+
+    if(_energy && _op == HIP_OP_ID_DISPATCH)
+        energy::device_op(_kernel_name, _devid, _beg_ns, _end_ns);
+
+    if(_gpu_attr && _op == HIP_OP_ID_DISPATCH)
+        gpu_attribution::device_op(_devid, _beg_ns, _end_ns);
+
+    if(_launch && _op == HIP_OP_ID_DISPATCH)
+        kernel_launch::device_op(_roct_cid, _devid, _queid, _beg_ns, _end_ns);
+
+    if(_memcpy && _op == HIP_OP_ID_COPY)
+        memcpy_analysis::device_op(_roct_cid, _beg_ns, _end_ns, _bytes);
+
+    if(_live && _op == HIP_OP_ID_DISPATCH)
+        live_export::device_op(_devid, _beg_ns, _end_ns);
+
+    if(_causal && _op == HIP_OP_ID_DISPATCH)
+        causal::record_kernel(_kernel_name, _beg_ns, _end_ns);
+
+    if(_roofline && _op == HIP_OP_ID_DISPATCH)
+        rocm::roofline::record_duration(_devid, rocm::get_kernel_symbol(_name).id,
+                                        _end_ns - _beg_ns);
+
+    if(get_use_roctracer_aggregate())
+    {
+        update_aggregate(_devid, rocm::get_kernel_symbol(_name).id, _end_ns - _beg_ns,
+                         _bytes);
+        return;
+    }
+
+    // execute this on this thread bc of how perfetto visualization works
+    if(get_use_perfetto())
+    {
+        auto _track_desc = [](int32_t _device_id, int64_t _queue_id) {
+            if(config::get_perfetto_roctracer_per_stream())
+                return JOIN("", "HIP Activity Device ", _device_id, ", Queue ",
+                            _queue_id);
+            return JOIN("", "HIP Activity Device ", _device_id);
+        };
+
+        const auto _track = tracing::get_perfetto_track(
+            category::device_hip{}, _track_desc, _devid,
+            (get_perfetto_roctracer_per_stream()) ? _queid : 0);
+
+        assert(_end_ns >= _beg_ns);
+        tracing::push_perfetto_track(
+            category::device_hip{}, _kernel_name, _track, _beg_ns,
+            ::perfetto::Flow::ProcessScoped(_roct_cid),
+            [&](::perfetto::EventContext ctx) {
+                if(config::get_perfetto_annotations())
+                {
+                    tracing::add_perfetto_annotation(ctx, "begin_ns", _beg_ns);
+                    tracing::add_perfetto_annotation(ctx, "end_ns", _end_ns);
+                    tracing::add_perfetto_annotation(ctx, "corr_id", _roct_cid);
+                    tracing::add_perfetto_annotation(ctx, "device", _devid);
+                    tracing::add_perfetto_annotation(ctx, "queue", _queid);
+                    tracing::add_perfetto_annotation(ctx, "tid", _tid);
+                    tracing::add_perfetto_annotation(
+                        ctx, "stream", JOIN("", "0x", std::hex, _queue));
+                    tracing::add_perfetto_annotation(ctx, "op", _op_id_names.at(_op));
+                    if(_found && _stack != 0)
+                        tracing::add_perfetto_annotation(ctx, "stack_id", _stack);
+                }
+            });
+        tracing::pop_perfetto_track(category::device_hip{}, "", _track, _end_ns);
+    }
+
+    if(_found && _name != nullptr && get_use_timemory())
+    {
+        auto&                _async_ops = get_hip_activity_callbacks(_tid);
+        locking::atomic_lock _lk{ get_hip_activity_mutex(_tid) };
+        _async_ops->push(hip_activity_record{ _kernel_name, _beg_ns, _end_ns });
+    }
+}
+
 // Activity tracing callback
 void
 hip_activity_callback(const char* begin, const char* end, void* arg)
@@ -807,16 +2038,13 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
         return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SELF_PROFILE_SCOPE(roctracer);
 
     auto&& _protect = comp::roctracer::protect_flush_activity();
     (void) _protect;
 
     if(!trait::runtime_enabled<comp::roctracer>::get()) return;
-    static auto _kernel_names = std::unordered_map<const char*, std::string>{};
-    static auto _indexes      = std::unordered_map<uint64_t, int>{};
-    static auto _skip_barrier_packets =
-        config::get_setting_value<bool>("OMNITRACE_ROCTRACER_DISCARD_BARRIERS")
-            .value_or(false);
+    auto _skip_barrier_packets = config::get_snapshot().roctracer_discard_barriers;
     const roctracer_record_t* record = reinterpret_cast<const roctracer_record_t*>(begin);
     const roctracer_record_t* end_record =
         reinterpret_cast<const roctracer_record_t*>(end);
@@ -847,129 +2075,147 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
 
         const char* op_name =
             roctracer_op_string(record->domain, record->op, record->kind);
-        auto     _ns_skew  = get_clock_skew();
-        uint64_t _beg_ns   = record->begin_ns + _ns_skew;
-        uint64_t _end_ns   = record->end_ns + _ns_skew;
-        auto     _roct_cid = record->correlation_id;
+        auto _bytes = (record->op == HIP_OP_ID_COPY) ? record->bytes : 0;
 
-        auto& _keys = get_roctracer_key_data();
-        auto& _tids = get_roctracer_tid_data();
+        hip_device_activity_callback(record->op, record->correlation_id, op_name,
+                                     record->device_id, record->queue_id,
+                                     record->begin_ns, record->end_ns, _bytes);
+    }
 
-        int64_t     _tid   = 0;                  // thread id
-        int32_t     _devid = record->device_id;  // device id
-        int64_t     _queid = record->queue_id;   // queue id
-        uintptr_t   _queue = 0;                  // Host queue (stream)
-        const char* _name  = nullptr;
-        bool        _found = false;
+    // ensures that all the updates are written
+    if(get_use_perfetto()) ::perfetto::TrackEvent::Flush();
+}
 
-        {
-            locking::atomic_lock _lk{ roctracer_type_mutex<key_data_mutex_t>() };
-            if(_tids.find(_roct_cid) != _tids.end())
-            {
-                _found   = true;
-                _tid     = _tids.at(_roct_cid);
-                auto itr = _keys.find(_roct_cid);
-                if(itr != _keys.end()) _name = itr->second;
-            }
-        }
+void
+write_roctracer_aggregate()
+{
+    if(!get_use_roctracer_aggregate()) return;
 
-        if(_name == nullptr && op_name == nullptr) continue;
-        if(_name == nullptr) _name = op_name;
+    struct summary
+    {
+        uint32_t device = 0;
+        uint32_t id     = 0;
+        uint64_t count  = 0;
+        uint64_t total  = 0;
+        uint64_t min    = 0;
+        uint64_t max    = 0;
+        uint64_t bytes  = 0;
+        double   stddev = 0.0;
+    };
+
+    auto _data = std::vector<summary>{};
+    for(auto& itr : get_aggregate_table())
+    {
+        auto _key   = itr.key.load();
+        auto _count = itr.count.load();
+        if(_key == 0 || _count == 0) continue;
+        auto _mean = static_cast<double>(itr.total.load()) / _count;
+        auto _var  = std::max(itr.sumsq.load() / _count - (_mean * _mean), 0.0);
+        _data.emplace_back(summary{ static_cast<uint32_t>((_key - 1) >> 32),
+                                    static_cast<uint32_t>((_key - 1) & 0xFFFFFFFF),
+                                    _count, itr.total.load(), itr.min.load(),
+                                    itr.max.load(), itr.bytes.load(), std::sqrt(_var) });
+    }
 
-        static auto _op_id_names =
-            std::array<const char*, 3>{ "DISPATCH", "COPY", "BARRIER" };
+    std::sort(_data.begin(), _data.end(),
+              [](const summary& _lhs, const summary& _rhs) {
+                  return _lhs.total > _rhs.total;
+              });
 
-        if(_end_ns < _beg_ns)
+    auto          _fname = tim::settings::compose_output_filename("roctracer-aggregate",
+                                                                  ".txt");
+    std::ofstream ofs{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening roctracer aggregate output file: %s",
+                        _fname.c_str());
+    }
+
+    OMNITRACE_VERBOSE_F(0, "Outputting '%s'...\n", _fname.c_str());
+    ofs << "# device  count  total_ns  mean_ns  min_ns  max_ns  stddev_ns  bytes  name\n";
+    for(const auto& itr : _data)
+    {
+        ofs << itr.device << "  " << itr.count << "  " << itr.total << "  "
+            << (itr.total / itr.count) << "  " << itr.min << "  " << itr.max << "  "
+            << static_cast<uint64_t>(itr.stddev) << "  " << itr.bytes << "  "
+            << rocm::get_kernel_symbol(itr.id).name << "\n";
+    }
+
+    auto _dropped = get_aggregate_dropped().load();
+    OMNITRACE_WARNING_IF_F(_dropped > 0,
+                           "%lu roctracer activity records were not aggregated because "
+                           "the table of %zu (device, kernel) entries was full\n",
+                           _dropped, aggregate_table_size);
+}
+
+void
+write_hsa_api_sampling()
+{
+    if(get_hsa_api_limits() == nullptr || !hsa_api_counts_data::get()) return;
+
+    auto _calls  = std::array<uint64_t, HSA_API_ID_NUMBER>{};
+    auto _traced = std::array<uint64_t, HSA_API_ID_NUMBER>{};
+    for(const auto& itr : *hsa_api_counts_data::get())
+    {
+        if(!itr) continue;
+        for(size_t i = 0; i < HSA_API_ID_NUMBER; ++i)
         {
-            auto          _verbose = []() { return get_verbose() >= 0 || get_debug(); };
-            static size_t _n       = 0;
-            static size_t _nmax =
-                get_env<size_t>("OMNITRACE_ROCTRACER_DISCARD_INVALID", 0);
-            if(_nmax == 0) std::swap(_end_ns, _beg_ns);
-            OMNITRACE_WARNING_IF_F(
-                _n < _nmax && _verbose(),
-                "%4zu :: Discarding kernel roctracer activity record which ended before "
-                "it started :: %-20s :: %-20s :: cid=%lu, time_ns=(%12lu:%12lu) "
-                "delta=%li, device=%d, queue=%lu, pid=%u, tid=%lu, op=%s\n",
-                _n, op_name, _name, record->correlation_id, _beg_ns, _end_ns,
-                (static_cast<int64_t>(_end_ns) - static_cast<int64_t>(_beg_ns)), _devid,
-                _queid, record->process_id, _tid, _op_id_names.at(record->op));
-            OMNITRACE_WARNING_IF_F(
-                _nmax > 0 && _n == _nmax && _verbose(),
-                "Suppressing future messages about discarding kernel roctracer activity "
-                "record which ended before it started. Set "
-                "OMNITRACE_ROCTRACER_DISCARD_INVALID=N to increase/decrease the number "
-                "of messages. If N is set to 0, data will be included after swapping the "
-                "begin and end values\n");
-            if(_end_ns < _beg_ns)
-            {
-                ++_n;
-                continue;
-            }
+            _calls[i] += itr->calls[i];
+            _traced[i] += itr->traced[i];
         }
+    }
 
-        // execute this on this thread bc of how perfetto visualization works
-        if(get_use_perfetto())
-        {
-            if(_kernel_names.find(_name) == _kernel_names.end())
-                _kernel_names.emplace(_name, tim::demangle(_name));
+    auto _order = std::vector<uint32_t>{};
+    for(uint32_t i = 0; i < HSA_API_ID_NUMBER; ++i)
+        if(_calls[i] > 0) _order.emplace_back(i);
+    if(_order.empty()) return;
 
-            auto _track_desc = [](int32_t _device_id, int64_t _queue_id) {
-                if(config::get_perfetto_roctracer_per_stream())
-                    return JOIN("", "HIP Activity Device ", _device_id, ", Queue ",
-                                _queue_id);
-                return JOIN("", "HIP Activity Device ", _device_id);
-            };
+    std::sort(_order.begin(), _order.end(), [&_calls](uint32_t _lhs, uint32_t _rhs) {
+        return _calls[_lhs] > _calls[_rhs];
+    });
 
-            const auto _track = tracing::get_perfetto_track(
-                category::device_hip{}, _track_desc, _devid,
-                (get_perfetto_roctracer_per_stream()) ? _queid : 0);
+    auto          _fname = tim::settings::compose_output_filename("roctracer-hsa-api",
+                                                                  ".txt");
+    std::ofstream ofs{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening roctracer HSA API sampling output file: %s",
+                        _fname.c_str());
+    }
 
-            assert(_end_ns >= _beg_ns);
-            tracing::push_perfetto_track(
-                category::device_hip{}, _kernel_names.at(_name).c_str(), _track, _beg_ns,
-                ::perfetto::Flow::ProcessScoped(_roct_cid),
-                [&](::perfetto::EventContext ctx) {
-                    if(config::get_perfetto_annotations())
-                    {
-                        tracing::add_perfetto_annotation(ctx, "begin_ns", _beg_ns);
-                        tracing::add_perfetto_annotation(ctx, "end_ns", _end_ns);
-                        tracing::add_perfetto_annotation(ctx, "corr_id", _roct_cid);
-                        tracing::add_perfetto_annotation(ctx, "device", _devid);
-                        tracing::add_perfetto_annotation(ctx, "queue", _queid);
-                        tracing::add_perfetto_annotation(ctx, "tid", _tid);
-                        tracing::add_perfetto_annotation(
-                            ctx, "stream", JOIN("", "0x", std::hex, _queue));
-                        tracing::add_perfetto_annotation(ctx, "op",
-                                                         _op_id_names.at(record->op));
-                    }
-                });
-            tracing::pop_perfetto_track(category::device_hip{}, "", _track, _end_ns);
-        }
-
-        if(_found && _name != nullptr && get_use_timemory())
-        {
-            auto _func = [_beg_ns, _end_ns, _name]() {
-                roctracer_hip_bundle_t _bundle{ _name };
-                _bundle.start()
-                    .store(std::plus<double>{}, static_cast<double>(_end_ns - _beg_ns))
-                    .stop()
-                    .get<comp::wall_clock>([&](comp::wall_clock* wc) {
-                        wc->set_value(_end_ns - _beg_ns);
-                        wc->set_accum(_end_ns - _beg_ns);
-                        return wc;
-                    });
-                _bundle.pop();
-            };
+    OMNITRACE_VERBOSE_F(0, "Outputting '%s'...\n", _fname.c_str());
+    ofs << "# calls  traced  suppressed  name\n";
+    uint64_t _total      = 0;
+    uint64_t _suppressed = 0;
+    for(auto itr : _order)
+    {
+        _total += _calls[itr];
+        _suppressed += _calls[itr] - _traced[itr];
+        ofs << _calls[itr] << "  " << _traced[itr] << "  " << (_calls[itr] - _traced[itr])
+            << "  " << roctracer_op_string(ACTIVITY_DOMAIN_HSA_API, itr, 0) << "\n";
+    }
 
-            auto&                _async_ops = get_hip_activity_callbacks(_tid);
-            locking::atomic_lock _lk{ get_hip_activity_mutex(_tid) };
-            _async_ops->emplace_back(std::move(_func));
-        }
+    OMNITRACE_VERBOSE_F(1, "HSA API tracing suppressed %lu of %lu calls\n", _suppressed,
+                        _total);
+}
+
+void
+flush_deferred_hip_api_calls()
+{
+    if(!deferred_hip_api_data::get()) return;
+
+    size_t _pending = 0;
+    for(auto& itr : *deferred_hip_api_data::get())
+    {
+        if(!itr) continue;
+        auto _lk = locking::atomic_lock{ itr->mutex };
+        _pending += itr->open.size();
+        itr->open.clear();
+        submit_deferred_hip_api_calls(*itr);
     }
 
-    // ensures that all the updates are written
-    if(get_use_perfetto()) ::perfetto::TrackEvent::Flush();
+    OMNITRACE_VERBOSE_F(2, "Discarded %zu deferred HIP API calls which did not return\n",
+                        _pending);
 }
 
 bool&
@@ -72,15 +72,47 @@ roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, voi
 void
 hip_activity_callback(const char* begin, const char* end, void*);
 
+/// records a kernel, copy or barrier which completed on the device (op is the
+/// HIP_OP_ID_* value) in the perfetto, timemory, critical-path and aggregate output.
+/// The timestamps are in the GPU (HSA system) clock domain
+void
+hip_device_activity_callback(uint32_t op, uint64_t corr_id, const char* op_name,
+                             int32_t device_id, int64_t queue_id, uint64_t begin_ns,
+                             uint64_t end_ns, uint64_t bytes);
+
+/// correlation id of the HIP kernel launch function which the calling thread is
+/// executing, zero otherwise
+uint64_t&
+get_hip_launch_correlation_id();
+
 bool&
 roctracer_is_init();
 
 bool&
 roctracer_is_setup();
 
+/// writes the per-kernel statistics collected in OMNITRACE_ROCTRACER_AGGREGATE mode
+void
+write_roctracer_aggregate();
+
+/// writes the number of calls and traced calls of each HSA API function when the HSA
+/// API tracing is rate-limited (OMNITRACE_ROCTRACER_HSA_API_SAMPLING)
+void
+write_hsa_api_sampling();
+
+/// emits the HIP API calls of every thread which are still buffered in
+/// OMNITRACE_PERFETTO_DEFERRED_ROCTRACER_ANNOTATIONS mode
+void
+flush_deferred_hip_api_calls();
+
+/// CPU/GPU clock offset at the current GPU time
 int64_t
 get_clock_skew();
 
+/// CPU/GPU clock offset to add to the roctracer timestamp
+int64_t
+get_clock_skew(uint64_t _gpu_ts);
+
 roctracer_functions_t&
 roctracer_setup_routines();
 
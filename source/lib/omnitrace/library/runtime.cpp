@@ -92,13 +92,6 @@ sampling_on_child_threads()
 }
 }  // namespace
 
-std::atomic<uint64_t>&
-get_cpu_cid()
-{
-    static std::atomic<uint64_t> _v{ 0 };
-    return _v;
-}
-
 unique_ptr_t<std::vector<uint64_t>>&
 get_cpu_cid_stack(int64_t _tid, int64_t _parent)
 {
@@ -124,64 +117,33 @@ get_cpu_cid_stack(int64_t _tid, int64_t _parent)
     return _v_tid;
 }
 
-unique_ptr_t<cpu_cid_parent_map_t>&
-get_cpu_cid_parents(int64_t _tid)
-{
-    struct omnitrace_cpu_cid_stack
-    {};
-    using thread_data_t = thread_data<cpu_cid_parent_map_t, omnitrace_cpu_cid_stack>;
-    return thread_data_t::instance(construct_on_thread{ _tid }, cpu_cid_parent_map_t{});
-}
-
 std::tuple<uint64_t, uint64_t, uint32_t>
 create_cpu_cid_entry(int64_t _tid)
 {
-    using tim::auto_lock_t;
+    struct omnitrace_cpu_cid_counter
+    {};
+    using counter_data_t = thread_data<uint64_t, omnitrace_cpu_cid_counter>;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
-    // unique lock for _tid
-    auto&       _mtx = get_cpu_cid_stack_lock(_tid);
-    auto_lock_t _lk{ _mtx, std::defer_lock };
-    if(!_lk.owns_lock()) _lk.lock();
-
-    int64_t _p_idx = (get_cpu_cid_stack(_tid)->empty()) ? 0 : _tid;
+    // the counter and the stack are only modified by the owning thread (the stack of a
+    // child is copied before the child runs) so neither the generation of the cid nor
+    // the lookup of the parent requires synchronization. The parent and the depth are
+    // returned to the caller and stored with the event instead of being kept here
+    auto& _counter = counter_data_t::instance(construct_on_thread{ _tid }, 0);
+    auto  _cid     = make_cpu_cid(_tid, ++(*_counter));
 
-    auto&       _p_mtx = get_cpu_cid_stack_lock(_p_idx);
-    auto_lock_t _p_lk{ _p_mtx, std::defer_lock };
-    if(!_p_lk.owns_lock()) _p_lk.lock();
-
-    auto&& _cid = get_cpu_cid()++;
-    // auto&&     _parent_cid = get_cpu_cid_stack(_p_idx)->back();
     uint64_t _parent_cid = 0;
-    auto&    cid_stack   = get_cpu_cid_stack(_p_idx);
-
-    if(!cid_stack->empty())
+    uint32_t _depth      = 0;
+    if(const auto& _stack = get_cpu_cid_stack(_tid); _stack && !_stack->empty())
     {
-        _parent_cid = cid_stack->back();
+        _parent_cid = _stack->back();
+        _depth      = _stack->size() - 1;
     }
 
-    uint32_t&& _depth = get_cpu_cid_stack(_p_idx)->size() - ((_p_idx == _tid) ? 1 : 0);
-
-    get_cpu_cid_parents(_tid)->emplace(_cid, std::make_tuple(_parent_cid, _depth));
     return std::make_tuple(_cid, _parent_cid, _depth);
 }
 
-cpu_cid_pair_t
-get_cpu_cid_entry(uint64_t _cid, int64_t _tid)
-{
-    return get_cpu_cid_parents(_tid)->at(_cid);
-}
-
-tim::mutex_t&
-get_cpu_cid_stack_lock(int64_t _tid)
-{
-    struct cpu_cid_stack_s
-    {};
-    return tim::type_mutex<cpu_cid_stack_s, project::omnitrace, max_supported_threads>(
-        _tid);
-}
-
 namespace
 {
 void
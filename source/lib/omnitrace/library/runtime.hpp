@@ -30,9 +30,12 @@
 #include "library/causal/components/causal_gotcha.hpp"
 #include "library/components/exit_gotcha.hpp"
 #include "library/components/fork_gotcha.hpp"
+#include "library/components/io_gotcha.hpp"
+#include "library/components/malloc_gotcha.hpp"
 #include "library/components/mpi_gotcha.hpp"
 #include "library/components/numa_gotcha.hpp"
 #include "library/components/pthread_gotcha.hpp"
+#include "library/components/python_gil_gotcha.hpp"
 #include "library/components/roctracer.hpp"
 #include "library/thread_data.hpp"
 
@@ -52,8 +55,10 @@ using preinit_bundle_t =
     tim::lightweight_tuple<exit_gotcha_t, fork_gotcha_t, mpi_gotcha_t>;
 
 // started during init phase
-using init_bundle_t = tim::lightweight_tuple<causal::component::causal_gotcha,
-                                             pthread_gotcha, component::numa_gotcha>;
+using init_bundle_t =
+    tim::lightweight_tuple<causal::component::causal_gotcha, pthread_gotcha,
+                           component::numa_gotcha, component::malloc_gotcha,
+                           component::io_gotcha, component::python_gil_gotcha>;
 
 // bundle of components around omnitrace_init and omnitrace_finalize
 using main_bundle_t =
@@ -78,28 +83,38 @@ get_init_bundle();
 std::unique_ptr<preinit_bundle_t>&
 get_preinit_bundle();
 
-std::atomic<uint64_t>&
-get_cpu_cid() TIMEMORY_HOT;
+/// the CPU correlation ids are generated in per-thread blocks: the thread index (plus
+/// one so that zero is never a valid cid) is in the high bits and a counter incremented
+/// by the owning thread is in the low bits
+static constexpr uint64_t cpu_cid_thread_shift = 40;
+static constexpr uint64_t cpu_cid_counter_mask =
+    (uint64_t{ 1 } << cpu_cid_thread_shift) - 1;
+
+inline constexpr uint64_t
+make_cpu_cid(int64_t _tid, uint64_t _counter)
+{
+    return (static_cast<uint64_t>(_tid + 1) << cpu_cid_thread_shift) |
+           (_counter & cpu_cid_counter_mask);
+}
+
+/// the index of the thread which created the cid
+inline constexpr int64_t
+get_cpu_cid_thread(uint64_t _cid)
+{
+    return static_cast<int64_t>(_cid >> cpu_cid_thread_shift) - 1;
+}
 
 unique_ptr_t<std::vector<uint64_t>>&
 get_cpu_cid_stack(int64_t _tid = threading::get_id(), int64_t _parent = 0) TIMEMORY_HOT;
 
-using cpu_cid_data_t       = std::tuple<uint64_t, uint64_t, uint32_t>;
-using cpu_cid_pair_t       = std::tuple<uint64_t, uint32_t>;
-using cpu_cid_parent_map_t = std::unordered_map<uint64_t, cpu_cid_pair_t>;
-
-unique_ptr_t<cpu_cid_parent_map_t>&
-get_cpu_cid_parents(int64_t _tid = threading::get_id()) TIMEMORY_HOT;
+/// cid, parent cid, depth
+using cpu_cid_data_t = std::tuple<uint64_t, uint64_t, uint32_t>;
 
+/// returns a new cid along with its parent and depth. Must be called on the thread
+/// which owns _tid. Nothing is retained once the cid has been returned
 cpu_cid_data_t
 create_cpu_cid_entry(int64_t _tid = threading::get_id()) TIMEMORY_HOT;
 
-cpu_cid_pair_t
-get_cpu_cid_entry(uint64_t _cid, int64_t _tid = threading::get_id()) TIMEMORY_HOT;
-
-tim::mutex_t&
-get_cpu_cid_stack_lock(int64_t _tid = threading::get_id()) TIMEMORY_HOT;
-
 // query current value
 bool
 sampling_enabled_on_child_threads();
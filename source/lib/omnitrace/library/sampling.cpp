@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include "library/sampling.hpp"
+#include "binary/analysis.hpp"
+#include "binary/unwind_table.hpp"
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
@@ -33,8 +35,20 @@
 #include "library/components/backtrace_metrics.hpp"
 #include "library/components/backtrace_timestamp.hpp"
 #include "library/components/callchain.hpp"
+#include "library/branch_sampling.hpp"
+#include "library/coverage.hpp"
+#include "library/emergency_dump.hpp"
+#include "library/housekeeping.hpp"
+#include "library/memory_footprint.hpp"
+#include "library/memory_latency.hpp"
+#include "library/numa_locality.hpp"
+#include "library/offcpu.hpp"
 #include "library/perf.hpp"
 #include "library/ptl.hpp"
+#include "library/python_gil.hpp"
+#include "library/python_sampling.hpp"
+#include "library/raw_output.hpp"
+#include "library/region_rates.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
@@ -61,29 +75,49 @@
 #include <timemory/sampling/sampler.hpp>
 #include <timemory/sampling/timer.hpp>
 #include <timemory/storage.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
 #include <timemory/units.hpp>
 #include <timemory/unwind/processed_entry.hpp>
 #include <timemory/utility/backtrace.hpp>
 #include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
 #include <timemory/utility/procfs/maps.hpp>
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cerrno>
 #include <csignal>
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <initializer_list>
+#include <limits>
+#include <map>
 #include <mutex>
+#include <optional>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
 
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 namespace tim
 {
@@ -156,24 +190,135 @@ get_sampler_allocators()
     return _v;
 }
 
+// NUMA node of each entry in get_sampler_allocators() (-1 == any node)
+auto&
+get_sampler_allocator_nodes()
+{
+    static auto _v = std::vector<int>{};
+    return _v;
+}
+
 std::set<int>
 configure(bool _setup, int64_t _tid = threading::get_id());
 
+// parses the sysfs list format, e.g. "0-15,32-47". The CPUs must fit in a cpu_set_t
+// and a malformed list yields no CPUs so the NUMA-local allocators are not used
+std::vector<int>
+parse_cpu_list(const std::string& _v)
+{
+    auto _parse = [](const std::string& _str, int& _cpu) {
+        if(_str.empty() || _str.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        errno     = 0;
+        auto _val = std::strtol(_str.c_str(), nullptr, 10);
+        if(errno != 0 || _val >= CPU_SETSIZE) return false;
+        _cpu = static_cast<int>(_val);
+        return true;
+    };
+
+    auto _cpus = std::vector<int>{};
+    for(const auto& itr : tim::delimit(_v, ", \t\n"))
+    {
+        auto _range = tim::delimit(itr, "-");
+        auto _beg   = -1;
+        auto _end   = -1;
+        if(_range.empty() || _range.size() > 2 || !_parse(_range.front(), _beg) ||
+           !_parse(_range.back(), _end) || _end < _beg)
+        {
+            OMNITRACE_VERBOSE(1, "[sampling] Invalid NUMA node CPU list: '%s'\n",
+                              _v.c_str());
+            return std::vector<int>{};
+        }
+        for(int i = _beg; i <= _end; ++i)
+            _cpus.emplace_back(i);
+    }
+    return _cpus;
+}
+
+struct numa_topology
+{
+    std::vector<std::vector<int>> node_cpus = {};
+    std::vector<int>              cpu_node  = {};
+};
+
+const numa_topology&
+get_numa_topology()
+{
+    static auto _v = []() {
+        auto _topo = numa_topology{};
+        for(int i = 0;; ++i)
+        {
+            auto _ifs = std::ifstream{ JOIN("", "/sys/devices/system/node/node", i,
+                                            "/cpulist") };
+            if(!_ifs) break;
+
+            auto _line = std::string{};
+            std::getline(_ifs, _line);
+            _topo.node_cpus.emplace_back(parse_cpu_list(_line));
+            for(auto itr : _topo.node_cpus.back())
+            {
+                if(itr >= static_cast<int>(_topo.cpu_node.size()))
+                    _topo.cpu_node.resize(itr + 1, -1);
+                _topo.cpu_node.at(itr) = i;
+            }
+        }
+        return _topo;
+    }();
+    return _v;
+}
+
+// NUMA node of the CPU the calling thread is currently running on
+int
+get_numa_node()
+{
+    const auto& _topo = get_numa_topology();
+    if(_topo.node_cpus.size() < 2) return -1;
+
+    auto _cpu = sched_getcpu();
+    if(_cpu < 0 || _cpu >= static_cast<int>(_topo.cpu_node.size())) return -1;
+    return _topo.cpu_node.at(_cpu);
+}
+
 void
-configure_sampler_allocator(std::shared_ptr<sampler_allocator_t>& _v)
+configure_sampler_allocator(std::shared_ptr<sampler_allocator_t>& _v, int _node = -1)
 {
     if(_v) return;
 
     OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
+    // the allocator thread inherits the affinity of this thread so it runs on the CPUs
+    // of the given NUMA node
+    const auto& _topo     = get_numa_topology();
+    bool        _restore  = false;
+    cpu_set_t   _prev_set = {};
+    if(_node >= 0 && _node < static_cast<int>(_topo.node_cpus.size()) &&
+       pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &_prev_set) == 0)
+    {
+        cpu_set_t _node_set;
+        CPU_ZERO(&_node_set);
+        for(auto itr : _topo.node_cpus.at(_node))
+            CPU_SET(itr, &_node_set);
+        _restore =
+            (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &_node_set) == 0);
+    }
+
     _v = std::make_shared<sampler_allocator_t>();
     _v->reserve(config::get_sampling_allocator_size());
+
+    if(_restore) pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &_prev_set);
+
+    if(_node >= 0)
+        OMNITRACE_VERBOSE(2, "[sampling] Created sampler allocator on NUMA node %i...\n",
+                          _node);
 }
 
 void
 configure_sampler_allocators()
 {
+    // the NUMA-local allocators are created on demand
+    if(get_sampling_numa_allocators()) return;
+
     auto& _allocators = get_sampler_allocators();
     if(_allocators.empty())
     {
@@ -195,19 +340,25 @@ get_sampler_allocator()
     configure_sampler_allocators();
 
     auto& _allocators = get_sampler_allocators();
+    auto& _nodes      = get_sampler_allocator_nodes();
+    auto  _node       = (get_snapshot().sampling_numa_allocators) ? get_numa_node() : -1;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
     auto_lock_t _lk{ type_mutex<sampler_allocator_t>() };
 
-    for(auto& itr : _allocators)
+    _nodes.resize(_allocators.size(), -1);
+    for(size_t i = 0; i < _allocators.size(); ++i)
     {
-        if(!itr) configure_sampler_allocator(itr);
-        if(itr->size() < config::get_sampling_allocator_size()) return itr;
+        auto& itr = _allocators.at(i);
+        if(_nodes.at(i) != _node) continue;
+        if(!itr) configure_sampler_allocator(itr, _node);
+        if(itr->size() < get_snapshot().sampling_allocator_size) return itr;
     }
 
     auto& _v = _allocators.emplace_back();
-    configure_sampler_allocator(_v);
+    _nodes.emplace_back(_node);
+    configure_sampler_allocator(_v, _node);
     return _v;
 }
 
@@ -343,6 +494,7 @@ start_duration_thread()
         auto _func = [_end]() {
             thread_info::init(true);
             threading::set_thread_name("omni.samp.dur");
+            housekeeping::configure_thread();
             get_is_duration_thread() = true;
             bool _wait               = true;
             while(_wait)
@@ -386,6 +538,404 @@ start_duration_thread()
     }
 }
 
+// when OMNITRACE_SAMPLING_PERF_BACKEND is enabled, the timer-based samples are replaced
+// by callchains unwound by the kernel for a perf_event opened on each thread. The
+// perf_event ring buffers are drained by a background thread so neither a signal nor
+// an unwind happens in the sampled thread
+struct perf_collector_tag
+{};
+
+using perf_record_t         = component::callchain::record;
+using perf_record_instances = thread_data<std::vector<perf_record_t>, perf_collector_tag>;
+using perf_event_instances  = thread_data<perf::perf_event, perf_collector_tag>;
+
+auto&
+get_perf_collector_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_perf_collector_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_perf_collector_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_perf_collector_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+// requires the perf collector mutex to be held
+void
+drain_perf_collector(int64_t _tid)
+{
+    if(!perf_event_instances::get()) return;
+
+    auto& _event = perf_event_instances::get()->at(_tid);
+    if(!_event || !_event->is_open()) return;
+
+    auto& _records = perf_record_instances::instance(construct_on_thread{ _tid });
+    for(auto itr : *_event)
+    {
+        if(!itr.is_sample()) continue;
+
+        auto _ip        = itr.get_ip();
+        auto _data      = perf_record_t{};
+        _data.timestamp = itr.get_time();
+        _data.data.emplace_back(_ip);
+        bool _skip_ip = true;
+        for(auto ditr : itr.get_callchain())
+        {
+            // kernel context markers, e.g. PERF_CONTEXT_USER
+            if(ditr >= PERF_CONTEXT_MAX) continue;
+            // skip the first instance of current IP but allow after that since this
+            // might be a recursive call
+            if(ditr == _ip && _skip_ip)
+                _skip_ip = false;
+            else
+                _data.data.emplace_back(ditr);
+            if(_data.data.size() == _data.data.capacity()) break;
+        }
+        _records->emplace_back(_data);
+    }
+}
+
+void
+stop_perf_collector()
+{
+    if(!get_perf_collector_thread()) return;
+
+    get_perf_collector_active().store(false);
+    get_perf_collector_cv().notify_all();
+    get_perf_collector_thread()->join();
+    get_perf_collector_thread().reset();
+
+    // collect whatever remains in the ring buffers of the threads still running
+    std::unique_lock<std::mutex> _lk{ get_perf_collector_mutex() };
+    if(!perf_event_instances::get()) return;
+    for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
+    {
+        auto& _event = perf_event_instances::get()->at(i);
+        if(!_event || !_event->is_open()) continue;
+        _event->stop();
+        drain_perf_collector(i);
+        _event->close();
+    }
+}
+
+void
+start_perf_collector()
+{
+    std::unique_lock<std::mutex> _lk{ get_perf_collector_mutex() };
+    if(get_perf_collector_thread()) return;
+
+    // the data region of each ring buffer only needs to hold the samples generated
+    // within one collection interval
+    constexpr auto _interval = std::chrono::milliseconds{ 5 };
+
+    auto _func = [_interval]() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.samp.perf");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        while(get_perf_collector_active().load())
+        {
+            std::unique_lock<std::mutex> _lk{ get_perf_collector_mutex() };
+            get_perf_collector_cv().wait_for(_lk, _interval);
+            for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
+                drain_perf_collector(i);
+        }
+    };
+
+    get_perf_collector_active().store(true);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_perf_collector_thread() = std::make_unique<std::thread>(_func);
+}
+
+// opens the perf_event for the thread. Returns true if the timer signals should be
+// removed from the thread because the perf_event replaces them
+bool
+configure_perf_collector(bool _setup, int64_t _tid, std::set<int>& _signal_types)
+{
+    if(!get_sampling_perf_backend()) return false;
+
+    if(!_setup)
+    {
+        std::unique_lock<std::mutex> _lk{ get_perf_collector_mutex() };
+        if(perf_event_instances::get() && perf_event_instances::get()->at(_tid))
+        {
+            auto& _event = perf_event_instances::get()->at(_tid);
+            _event->stop();
+            drain_perf_collector(_tid);
+            _event->close();
+        }
+        return false;
+    }
+
+    auto _use_cputime  = _signal_types.count(get_sampling_cputime_signal()) > 0;
+    auto _use_realtime = _signal_types.count(get_sampling_realtime_signal()) > 0;
+    if(!_use_cputime && !_use_realtime) return false;
+
+    const auto& _info = thread_info::get(_tid, SequentTID);
+    if(!_info) return false;
+
+    if(perf_event_instances::get() && perf_event_instances::get()->at(_tid) &&
+       perf_event_instances::get()->at(_tid)->is_open())
+        return true;
+
+    auto _freq = (_use_cputime) ? get_sampling_cputime_freq()
+                                : get_sampling_realtime_freq();
+
+    struct perf_event_attr _pe;
+    memset(&_pe, 0, sizeof(_pe));
+
+    // the perf "clock" events only advance while the thread is scheduled
+    _pe.type   = PERF_TYPE_SOFTWARE;
+    _pe.config = (_use_cputime) ? PERF_COUNT_SW_TASK_CLOCK : PERF_COUNT_SW_CPU_CLOCK;
+    _pe.sample_type =
+        PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_TIME | PERF_SAMPLE_CALLCHAIN;
+    _pe.sample_period            = (1.0 / _freq) * units::sec;
+    _pe.wakeup_events            = 0;
+    _pe.exclude_idle             = 1;
+    _pe.exclude_kernel           = 1;
+    _pe.exclude_hv               = 1;
+    _pe.exclude_callchain_kernel = 1;
+    _pe.disabled                 = 1;
+    _pe.inherit                  = 0;
+    _pe.use_clockid              = 1;
+    _pe.clockid                  = CLOCK_REALTIME;
+
+    auto _event = std::make_unique<perf::perf_event>();
+    _event->set_num_pages(get_sampling_perf_buffer_pages());
+
+    auto _perf_open_error = _event->open(_pe, _info->index_data->system_value);
+    if(_perf_open_error)
+    {
+        OMNITRACE_WARNING_F(0,
+                            "perf backend for sampling failed to activate on thread %li "
+                            "(falling back to timers): %s\n",
+                            _tid, _perf_open_error->c_str());
+        return false;
+    }
+
+    OMNITRACE_VERBOSE(2,
+                      "[perf] Sampler for thread %li will be triggered %.1fx per second "
+                      "of %s-time via perf_event...\n",
+                      _tid, _freq, (_use_cputime) ? "CPU" : "wall");
+
+    // make sure the collector thread is running before the first samples
+    start_perf_collector();
+
+    {
+        std::unique_lock<std::mutex> _lk{ get_perf_collector_mutex() };
+        auto& _instance = perf_event_instances::instance(construct_on_thread{ _tid });
+        *_instance      = std::move(*_event);
+        _instance->start();
+    }
+
+    return true;
+}
+
+// when OMNITRACE_SAMPLING_THREAD_GROUP is enabled, the threads do not create a timer.
+// One background thread sends the timer signal to the sampled threads round-robin so
+// the number of timers and the signal rate do not grow with the number of threads
+struct thread_group_member
+{
+    int64_t   tid         = -1;
+    pid_t     sys_tid     = 0;
+    int       signal      = 0;
+    bool      cputime     = false;
+    clockid_t cpu_clock   = CLOCK_THREAD_CPUTIME_ID;
+    uint64_t  cpu_time_ns = 0;
+};
+
+auto&
+get_thread_group_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_thread_group_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_thread_group_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_thread_group_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+// requires the thread group mutex to be held
+auto&
+get_thread_group_members()
+{
+    static auto _v = std::vector<thread_group_member>{};
+    return _v;
+}
+
+// sum of the frequencies of the members. Requires the thread group mutex to be held
+auto&
+get_thread_group_members_freq()
+{
+    static auto _v = double{ 0.0 };
+    return _v;
+}
+
+// the frequency at which each thread of the group should be sampled
+double
+get_thread_group_freq(int _signal)
+{
+    return (_signal == get_sampling_realtime_signal()) ? get_sampling_realtime_freq()
+                                                       : get_sampling_cputime_freq();
+}
+
+void
+stop_thread_group()
+{
+    if(!get_thread_group_thread()) return;
+
+    get_thread_group_active().store(false);
+    get_thread_group_cv().notify_all();
+    get_thread_group_thread()->join();
+    get_thread_group_thread().reset();
+}
+
+void
+start_thread_group()
+{
+    std::unique_lock<std::mutex> _lk{ get_thread_group_mutex() };
+    if(get_thread_group_thread()) return;
+
+    auto _func = []() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.samp.group");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        using clock_type = std::chrono::steady_clock;
+
+        const auto _pid     = process::get_id();
+        const auto _max_hz  = get_sampling_thread_group_rate();
+        auto       _next    = size_t{ 0 };
+        auto       _wake    = clock_type::now();
+        auto&      _members = get_thread_group_members();
+
+        std::unique_lock<std::mutex> _lk{ get_thread_group_mutex() };
+        while(get_thread_group_active().load())
+        {
+            // each thread is sampled at its frequency until the number of threads
+            // would exceed the maximum rate of the group
+            auto _hz = std::max<double>(
+                std::min<double>(_max_hz, get_thread_group_members_freq()), 1.0);
+
+            // a late wakeup does not result in a burst of signals
+            _wake = std::max(_wake + std::chrono::nanoseconds{ static_cast<int64_t>(
+                                         units::sec / _hz) },
+                             clock_type::now());
+            if(get_thread_group_cv().wait_until(
+                   _lk, _wake, []() { return !get_thread_group_active().load(); }))
+                break;
+
+            // the CPU-time signal is only sent to the threads which ran since their
+            // previous signal, like the CPU-time timer of a thread
+            for(size_t i = 0; i < _members.size(); ++i)
+            {
+                auto& itr = _members.at((_next + i) % _members.size());
+                if(itr.cputime)
+                {
+                    struct timespec _ts = {};
+                    if(clock_gettime(itr.cpu_clock, &_ts) != 0) continue;
+                    auto _cpu_time_ns = static_cast<uint64_t>(_ts.tv_sec) * units::sec +
+                                        static_cast<uint64_t>(_ts.tv_nsec);
+                    if(_cpu_time_ns == itr.cpu_time_ns) continue;
+                    itr.cpu_time_ns = _cpu_time_ns;
+                }
+                _next = (_next + i + 1) % _members.size();
+                ::syscall(SYS_tgkill, _pid, itr.sys_tid, itr.signal);
+                break;
+            }
+        }
+    };
+
+    get_thread_group_active().store(true);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_thread_group_thread() = std::make_unique<std::thread>(_func);
+}
+
+// adds the calling thread to the group and returns the signal it will receive. The
+// real-time signal is used when both the real-time and CPU-time signals are enabled
+int
+add_thread_group_member(int64_t _tid, std::set<int>& _signal_types)
+{
+    auto _use_realtime = _signal_types.count(get_sampling_realtime_signal()) > 0;
+    auto _member       = thread_group_member{};
+    _member.tid        = _tid;
+    _member.sys_tid    = threading::get_sys_tid();
+    _member.signal     = (_use_realtime) ? get_sampling_realtime_signal()
+                                         : get_sampling_cputime_signal();
+    _member.cputime    = !_use_realtime;
+    if(_member.cputime) pthread_getcpuclockid(pthread_self(), &_member.cpu_clock);
+
+    _signal_types.erase((_use_realtime) ? get_sampling_cputime_signal()
+                                        : get_sampling_realtime_signal());
+
+    OMNITRACE_VERBOSE(2,
+                      "[SIG%i] Sampler for thread %li will be triggered up to %.1fx per "
+                      "second of %s-time by the sampling thread group...\n",
+                      _member.signal, _tid, get_thread_group_freq(_member.signal),
+                      (_use_realtime) ? "wall" : "CPU");
+
+    start_thread_group();
+
+    std::unique_lock<std::mutex> _lk{ get_thread_group_mutex() };
+    get_thread_group_members().emplace_back(_member);
+    get_thread_group_members_freq() += get_thread_group_freq(_member.signal);
+    return _member.signal;
+}
+
+void
+remove_thread_group_member(int64_t _tid)
+{
+    std::unique_lock<std::mutex> _lk{ get_thread_group_mutex() };
+    auto&                        _members = get_thread_group_members();
+    for(auto itr = _members.begin(); itr != _members.end(); ++itr)
+    {
+        if(itr->tid != _tid) continue;
+        get_thread_group_members_freq() -= get_thread_group_freq(itr->signal);
+        _members.erase(itr);
+        break;
+    }
+}
+
 auto&
 get_offload_file()
 {
@@ -416,10 +966,123 @@ using pos_type         = typename std::fstream::pos_type;
 
 auto offload_seq_data = std::unordered_map<int64_t, std::set<pos_type>>{};
 
+// the samples of an offloaded buffer no longer reside in memory (see track_sample)
+void
+release_samples(size_t _count)
+{
+    memory_footprint::track(memory_footprint::sampling_subsystem,
+                            -static_cast<int64_t>(_count * sizeof(sampler_bundle_t)));
+}
+
+// compact encoding of the offloaded samples (OMNITRACE_SAMPLING_COMPACT_OFFLOAD). Each
+// 64-bit word of a sample is stored as the zigzag varint of its difference with the same
+// word of the previous sample in the buffer: timestamps become small deltas, the frames
+// of similar call-stacks and the unused metric slots become zeros, and every run of
+// zeros within a sample is collapsed into a marker followed by the length of the run
+struct compact_codec
+{
+    static constexpr size_t num_words =
+        (sizeof(sampler_bundle_t) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    using words_t = std::array<uint64_t, num_words>;
+
+    void encode(const sampler_bundle_t&, std::string&);
+    bool decode(const char*& _beg, const char* _end, sampler_bundle_t&);
+
+private:
+    static void write_varint(uint64_t, std::string&);
+    static bool read_varint(const char*&, const char*, uint64_t&);
+
+    words_t m_prev = {};
+};
+
+void
+compact_codec::write_varint(uint64_t _v, std::string& _out)
+{
+    while(_v >= 0x80)
+    {
+        _out += static_cast<char>((_v & 0x7f) | 0x80);
+        _v >>= 7;
+    }
+    _out += static_cast<char>(_v);
+}
+
+bool
+compact_codec::read_varint(const char*& _beg, const char* _end, uint64_t& _v)
+{
+    _v = 0;
+    for(int _shift = 0; _beg < _end && _shift < 64; _shift += 7)
+    {
+        auto _byte = static_cast<uint8_t>(*_beg++);
+        _v |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+        if((_byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+void
+compact_codec::encode(const sampler_bundle_t& _v, std::string& _out)
+{
+    auto _curr = words_t{};
+    std::memcpy(_curr.data(), static_cast<const void*>(&_v), sizeof(sampler_bundle_t));
+
+    for(size_t i = 0; i < num_words;)
+    {
+        // zigzag so that small negative differences also encode in a few bytes
+        auto _diff = static_cast<int64_t>(_curr[i] - m_prev[i]);
+        auto _zz =
+            (static_cast<uint64_t>(_diff) << 1) ^ static_cast<uint64_t>(_diff >> 63);
+        if(_zz != 0)
+        {
+            write_varint(_zz, _out);
+            ++i;
+            continue;
+        }
+
+        size_t _run = 0;
+        while(i < num_words && _curr[i] == m_prev[i])
+        {
+            ++_run;
+            ++i;
+        }
+        write_varint(0, _out);
+        write_varint(_run, _out);
+    }
+
+    m_prev = _curr;
+}
+
+bool
+compact_codec::decode(const char*& _beg, const char* _end, sampler_bundle_t& _v)
+{
+    auto _curr = m_prev;
+    for(size_t i = 0; i < num_words;)
+    {
+        uint64_t _zz = 0;
+        if(!read_varint(_beg, _end, _zz)) return false;
+        if(_zz != 0)
+        {
+            auto _diff = static_cast<int64_t>((_zz >> 1) ^ (~(_zz & 1) + 1));
+            _curr[i]   = m_prev[i] + static_cast<uint64_t>(_diff);
+            ++i;
+            continue;
+        }
+
+        uint64_t _run = 0;
+        if(!read_varint(_beg, _end, _run) || _run == 0 || i + _run > num_words)
+            return false;
+        i += _run;
+    }
+
+    std::memcpy(static_cast<void*>(&_v), _curr.data(), sizeof(sampler_bundle_t));
+    m_prev = _curr;
+    return true;
+}
+
 void
 offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
 {
-    OMNITRACE_REQUIRE(get_use_tmp_files())
+    OMNITRACE_REQUIRE(get_snapshot().use_tmp_files)
         << "Error! sampling allocator tries to offload buffer of samples but "
            "omnitrace was configured to not use temporary files\n";
 
@@ -443,13 +1106,37 @@ offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
     offload_seq_data[_seq].emplace(_fs.tellg());
     _fs.write(reinterpret_cast<char*>(&_seq), sizeof(_seq));
     auto _data = std::move(_buf);
-    _data.save(_fs);
+    release_samples(_data.count());
+    if(get_snapshot().sampling_compact_offload)
+    {
+        auto _codec   = compact_codec{};
+        auto _encoded = std::string{};
+        auto _count   = static_cast<uint64_t>(_data.count());
+        while(!_data.is_empty())
+        {
+            auto _v = sampler_bundle_t{};
+            _data.read(&_v);
+            _codec.encode(_v, _encoded);
+        }
+        auto _nbytes = static_cast<uint64_t>(_encoded.size());
+        _fs.write(reinterpret_cast<char*>(&_count), sizeof(_count));
+        _fs.write(reinterpret_cast<char*>(&_nbytes), sizeof(_nbytes));
+        _fs.write(_encoded.data(), _encoded.size());
+        OMNITRACE_VERBOSE_F(3, "Encoded %zu samples for thread %li in %zu bytes...\n",
+                            static_cast<size_t>(_count), _seq, _encoded.size());
+    }
+    else
+    {
+        _data.save(_fs);
+    }
     _data.destroy();
     _buf.destroy();
 }
 
+// the samples stored with the compact encoding are decoded directly into _samples
+template <typename ContainerT>
 auto
-load_offload_buffer(int64_t _thread_idx)
+load_offload_buffer(int64_t _thread_idx, ContainerT& _samples)
 {
     auto _data = std::vector<sampler_buffer_t>{};
     if(!get_use_tmp_files())
@@ -482,6 +1169,11 @@ load_offload_buffer(int64_t _thread_idx)
 
     if(offload_seq_data.count(_thread_idx) == 0) return _data;
 
+    // the compact encodings are decoded in place from the mapping of the file
+    auto _view = (get_snapshot().sampling_compact_offload)
+                     ? _file->map()
+                     : std::pair<const char*, size_t>{ nullptr, 0 };
+
     size_t _count = 0;
     for(auto itr : offload_seq_data.at(_thread_idx))
     {
@@ -491,9 +1183,6 @@ load_offload_buffer(int64_t _thread_idx)
         _fs.read(reinterpret_cast<char*>(&_seq), sizeof(_seq));
         if(_fs.eof()) break;
 
-        sampler_buffer_t _buffer{};
-        _buffer.load(_fs);
-
         if(_seq != _thread_idx)
         {
             OMNITRACE_WARNING_F(
@@ -502,21 +1191,510 @@ load_offload_buffer(int64_t _thread_idx)
                 static_cast<uintptr_t>(itr), _seq, _thread_idx);
             continue;
         }
-        _count += _buffer.count();
-        _data.emplace_back(std::move(_buffer));
-    }
 
-    OMNITRACE_VERBOSE_F(2, "[sampling] Loaded %zu samples for thread %li...\n", _count,
-                        _thread_idx);
-
-    _file->close();
-
-    return _data;
-}
+        if(get_snapshot().sampling_compact_offload)
+        {
+            uint64_t _n      = 0;
+            uint64_t _nbytes = 0;
+            _fs.read(reinterpret_cast<char*>(&_n), sizeof(_n));
+            _fs.read(reinterpret_cast<char*>(&_nbytes), sizeof(_nbytes));
+
+            auto        _encoded = std::string{};
+            const char* _beg     = nullptr;
+            auto        _offset  = static_cast<std::streamoff>(_fs.tellg());
+            if(_view.first && _offset >= 0 &&
+               static_cast<size_t>(_offset) + _nbytes <= _view.second)
+            {
+                _beg = _view.first + _offset;
+            }
+            else
+            {
+                _encoded.resize(_nbytes);
+                _fs.read(_encoded.data(), _encoded.size());
+                _beg = _encoded.data();
+            }
 
-std::set<int>
-configure(bool _setup, int64_t _tid)
-{
+            auto        _codec = compact_codec{};
+            const auto* _end   = _beg + _nbytes;
+            _samples.reserve(_samples.size() + _n);
+            for(uint64_t i = 0; i < _n; ++i)
+            {
+                auto _v = sampler_bundle_t{};
+                if(!_codec.decode(_beg, _end, _v))
+                {
+                    OMNITRACE_WARNING_F(0,
+                                        "[sampling] corrupted compact offload data for "
+                                        "thread %zi at file position %zu\n",
+                                        _thread_idx, static_cast<uintptr_t>(itr));
+                    break;
+                }
+                _samples.emplace_back(std::move(_v));
+                ++_count;
+            }
+            continue;
+        }
+
+        sampler_buffer_t _buffer{};
+        _buffer.load(_fs);
+
+        _count += _buffer.count();
+        _data.emplace_back(std::move(_buffer));
+    }
+
+    OMNITRACE_VERBOSE_F(2, "[sampling] Loaded %zu samples for thread %li...\n", _count,
+                        _thread_idx);
+
+    _file->close();
+
+    return _data;
+}
+
+// per-thread offload of sampling buffers. Each thread gets its own memory-mapped
+// temporary file which is only ever written to by the allocator thread which handles
+// the sampler of that thread so no lock is required when appending samples
+struct offload_segment
+{
+    static constexpr size_t entry_size = sizeof(sampler_bundle_t);
+
+    offload_segment(int64_t _seq)
+    : m_compact{ get_snapshot().sampling_compact_offload }
+    , m_seq{ _seq }
+    {}
+
+    ~offload_segment() { destroy(); }
+
+    offload_segment(const offload_segment&) = delete;
+    offload_segment(offload_segment&&)      = delete;
+    offload_segment& operator=(const offload_segment&) = delete;
+    offload_segment& operator=(offload_segment&&) = delete;
+
+    bool   open(size_t _nbytes);
+    bool   reserve(size_t _nbytes);
+    bool   append(sampler_buffer_t&);
+    void   retain(sampler_buffer_t&&);
+    void   discard(size_t _n) { m_discarded += _n; }
+    void   destroy();
+    size_t count() const { return m_count; }
+    size_t discarded() const { return m_discarded; }
+    bool   is_open() const { return (m_data != nullptr); }
+    bool   is_failed() const { return m_failed; }
+
+    // the retained buffers are consumed by the load
+    template <typename ContainerT>
+    size_t load(ContainerT&);
+
+    // the samples in the segment as raw entries
+    static void dump_samples(emergency_dump::writer&, const void*, int64_t);
+
+private:
+    void close_file();
+    bool append_compact(sampler_buffer_t&);
+
+    // with OMNITRACE_SAMPLING_COMPACT_OFFLOAD, every appended buffer is a block of the
+    // number of samples and the number of bytes followed by the compact encoding
+    static constexpr size_t block_header_size = 2 * sizeof(uint64_t);
+
+    bool                          m_compact   = false;
+    bool                          m_failed    = false;
+    int64_t                       m_seq       = -1;
+    size_t                        m_count     = 0;
+    size_t                        m_discarded = 0;  // samples without any data
+    size_t                        m_size      = 0;
+    size_t                        m_capacity  = 0;
+    size_t                        m_source    = emergency_dump::invalid_source;
+    char*                         m_data      = nullptr;
+    std::shared_ptr<tmp_file>     m_file      = {};
+    std::vector<sampler_buffer_t> m_retained  = {};  // neither segment nor shared file
+};
+
+using offload_segment_instances = thread_data<offload_segment, offload_segment>;
+
+bool
+offload_segment::open(size_t _nbytes)
+{
+    if(m_data) return true;
+
+    // a segment which failed once is not retried for every buffer
+    if(m_failed) return false;
+    m_failed = true;
+
+    m_file = config::get_tmp_file(JOIN('-', "sampling", m_seq));
+    if(!m_file || !m_file->fopen("w+"))
+    {
+        OMNITRACE_WARNING_F(0,
+                            "[sampling] failed to open offload segment for thread %li\n",
+                            m_seq);
+        close_file();
+        return false;
+    }
+
+    auto _page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    _nbytes    = ((_nbytes + _page - 1) / _page) * _page;
+
+    if(ftruncate(m_file->fd, _nbytes) != 0)
+    {
+        OMNITRACE_WARNING_F(0, "[sampling] failed to size offload segment '%s': %s\n",
+                            m_file->filename.c_str(), strerror(errno));
+        close_file();
+        return false;
+    }
+
+    auto* _addr =
+        mmap(nullptr, _nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_file->fd, 0);
+    if(_addr == MAP_FAILED)
+    {
+        OMNITRACE_WARNING_F(0, "[sampling] failed to map offload segment '%s': %s\n",
+                            m_file->filename.c_str(), strerror(errno));
+        close_file();
+        return false;
+    }
+
+    m_failed   = false;
+    m_data     = static_cast<char*>(_addr);
+    m_capacity = _nbytes;
+    m_source   = emergency_dump::add_source(&offload_segment::dump_samples, this, m_seq);
+    return true;
+}
+
+bool
+offload_segment::reserve(size_t _nbytes)
+{
+    if(_nbytes <= m_capacity) return true;
+
+    auto _capacity = std::max<size_t>(2 * m_capacity, _nbytes);
+    if(ftruncate(m_file->fd, _capacity) != 0) return false;
+
+    auto* _addr = mremap(m_data, m_capacity, _capacity, MREMAP_MAYMOVE);
+    if(_addr == MAP_FAILED) return false;
+
+    m_data     = static_cast<char*>(_addr);
+    m_capacity = _capacity;
+    return true;
+}
+
+bool
+offload_segment::append(sampler_buffer_t& _buf)
+{
+    if(m_compact) return append_compact(_buf);
+
+    if(!reserve(m_size + (_buf.count() * entry_size))) return false;
+
+    while(!_buf.is_empty())
+    {
+        auto _v = sampler_bundle_t{};
+        _buf.read(&_v);
+        std::memcpy(m_data + m_size, static_cast<void*>(&_v), entry_size);
+        m_size += entry_size;
+        ++m_count;
+    }
+    return true;
+}
+
+bool
+offload_segment::append_compact(sampler_buffer_t& _buf)
+{
+    auto _samples = std::vector<sampler_bundle_t>{};
+    _samples.reserve(_buf.count());
+    while(!_buf.is_empty())
+    {
+        auto _v = sampler_bundle_t{};
+        _buf.read(&_v);
+        _samples.emplace_back(std::move(_v));
+    }
+
+    auto _codec   = compact_codec{};
+    auto _encoded = std::string{};
+    for(const auto& itr : _samples)
+        _codec.encode(itr, _encoded);
+
+    // the buffer is restored so that the caller can fall back to another offload
+    if(!reserve(m_size + block_header_size + _encoded.size()))
+    {
+        for(auto& itr : _samples)
+            _buf.write(&itr);
+        return false;
+    }
+
+    uint64_t _header[2] = { _samples.size(), _encoded.size() };
+    std::memcpy(m_data + m_size, _header, block_header_size);
+    std::memcpy(m_data + m_size + block_header_size, _encoded.data(), _encoded.size());
+    m_size += block_header_size + _encoded.size();
+    m_count += _samples.size();
+
+    OMNITRACE_VERBOSE_F(3, "Encoded %zu samples for thread %li in %zu bytes...\n",
+                        _samples.size(), m_seq, _encoded.size());
+    return true;
+}
+
+// the buffers which could not be written to the segment nor the shared offload file
+// stay in memory like the buffers of a sampler without an offload
+void
+offload_segment::retain(sampler_buffer_t&& _buf)
+{
+    m_retained.emplace_back(std::move(_buf));
+}
+
+template <typename ContainerT>
+size_t
+offload_segment::load(ContainerT& _data)
+{
+    size_t _n = 0;
+    _data.reserve(_data.size() + count());
+    if(m_compact)
+    {
+        for(size_t _pos = 0; _pos + block_header_size <= m_size;)
+        {
+            uint64_t _header[2] = { 0, 0 };
+            std::memcpy(_header, m_data + _pos, block_header_size);
+            _pos += block_header_size;
+            if(_pos + _header[1] > m_size) break;
+
+            auto        _codec = compact_codec{};
+            const auto* _beg   = m_data + _pos;
+            const auto* _end   = _beg + _header[1];
+            for(uint64_t i = 0; i < _header[0]; ++i)
+            {
+                auto _v = sampler_bundle_t{};
+                if(!_codec.decode(_beg, _end, _v))
+                {
+                    OMNITRACE_WARNING_F(0,
+                                        "[sampling] corrupted compact offload segment "
+                                        "for thread %li\n",
+                                        m_seq);
+                    break;
+                }
+                _data.emplace_back(std::move(_v));
+                ++_n;
+            }
+            _pos += _header[1];
+        }
+    }
+    else
+    {
+        for(; _n < count(); ++_n)
+        {
+            auto _v = sampler_bundle_t{};
+            std::memcpy(static_cast<void*>(&_v), m_data + (_n * entry_size), entry_size);
+            _data.emplace_back(std::move(_v));
+        }
+    }
+
+    for(auto& itr : m_retained)
+    {
+        while(!itr.is_empty())
+        {
+            auto _v = sampler_bundle_t{};
+            itr.read(&_v);
+            _data.emplace_back(std::move(_v));
+            ++_n;
+        }
+        itr.destroy();
+    }
+    m_retained.clear();
+    return _n;
+}
+
+void
+offload_segment::dump_samples(emergency_dump::writer& _writer, const void* _data,
+                              int64_t _tid)
+{
+    const auto& _segment = *static_cast<const offload_segment*>(_data);
+    auto        _size    = _segment.m_size;
+    if(!_segment.m_data || _size == 0) return;
+
+    if(!_segment.m_compact)
+    {
+        _writer.section(emergency_dump::sampling_section, _tid, _size, entry_size);
+        _writer.write(_segment.m_data, _size);
+        return;
+    }
+
+    // the dump holds raw samples so the blocks are decoded, without allocating, one
+    // sample at a time
+    _writer.section(emergency_dump::sampling_section, _tid, _segment.m_count * entry_size,
+                    entry_size);
+    auto   _v       = sampler_bundle_t{};
+    size_t _written = 0;
+    for(size_t _pos = 0; _pos + block_header_size <= _size;)
+    {
+        uint64_t _header[2] = { 0, 0 };
+        std::memcpy(_header, _segment.m_data + _pos, block_header_size);
+        _pos += block_header_size;
+        if(_pos + _header[1] > _size) break;
+
+        auto        _codec = compact_codec{};
+        const auto* _beg   = _segment.m_data + _pos;
+        const auto* _end   = _beg + _header[1];
+        for(uint64_t i = 0; i < _header[0] && _codec.decode(_beg, _end, _v); ++i)
+        {
+            _writer.write(&_v, entry_size);
+            ++_written;
+        }
+        _pos += _header[1];
+    }
+
+    // the section size was written up front so a corrupted block is padded with zeros
+    std::memset(static_cast<void*>(&_v), 0, entry_size);
+    for(; _written < _segment.m_count; ++_written)
+        _writer.write(&_v, entry_size);
+}
+
+void
+offload_segment::destroy()
+{
+    emergency_dump::remove_source(m_source);
+    m_source = emergency_dump::invalid_source;
+    if(m_data) munmap(m_data, m_capacity);
+    m_data     = nullptr;
+    m_count    = 0;
+    m_size     = 0;
+    m_capacity = 0;
+    close_file();
+    for(auto& itr : m_retained)
+        itr.destroy();
+    m_retained.clear();
+}
+
+// the temporary files are cached by name so the file is closed and removed here
+// rather than when the last reference is released
+void
+offload_segment::close_file()
+{
+    if(m_file) m_file->remove();
+    m_file.reset();
+}
+
+void
+offload_buffer_per_thread(int64_t _seq, sampler_buffer_t&& _buf)
+{
+    OMNITRACE_REQUIRE(get_snapshot().use_tmp_files)
+        << "Error! sampling allocator tries to offload buffer of samples but "
+           "omnitrace was configured to not use temporary files\n";
+
+    auto& _segment =
+        offload_segment_instances::instance(construct_on_thread{ _seq }, _seq);
+
+    if(!_segment->is_open() && !_segment->is_failed())
+    {
+        // pre-size the segment to hold several full buffers
+        constexpr size_t _nbuffers = 8;
+        _segment->open(_nbuffers * tim::trait::buffer_size<sampler_t>::value *
+                       offload_segment::entry_size);
+    }
+
+    OMNITRACE_VERBOSE_F(2, "Offloading %zu samples for thread %li to segment...\n",
+                        _buf.count(), _seq);
+
+    auto _data  = std::move(_buf);
+    auto _count = _data.count();
+    if(_segment->is_open() && _segment->append(_data))
+    {
+        release_samples(_count);
+        _data.destroy();
+        _buf.destroy();
+        return;
+    }
+
+    // append only consumes the buffer once the segment has the space for it
+    if(get_offload_file() && *get_offload_file())
+    {
+        OMNITRACE_WARNING_F(1,
+                            "[sampling] offload segment for thread %li is unavailable. "
+                            "Using shared offload file...\n",
+                            _seq);
+        offload_buffer(_seq, std::move(_data));
+    }
+    else
+    {
+        OMNITRACE_WARNING_F(1,
+                            "[sampling] offload segment and shared offload file are "
+                            "unavailable. Keeping %zu samples of thread %li in memory\n",
+                            _count, _seq);
+        _segment->retain(std::move(_data));
+    }
+    _buf.destroy();
+}
+
+// the samples of OMNITRACE_SAMPLING_AGGREGATE which were only counted in the call-stack
+// table have neither a call-stack nor a callchain and are discarded by the
+// post-processing so they are removed before the buffer reaches the offload, i.e. the
+// offloaded (or retained) data scales with the unique call-stacks and checkpoints
+using offload_func_t = void (*)(int64_t, sampler_buffer_t&&);
+
+offload_func_t aggregate_offload = nullptr;
+
+bool
+is_empty_sample(const sampler_bundle_t& _v)
+{
+    const auto* _bt = _v.get<backtrace>();
+    const auto* _cc = _v.get<callchain>();
+    return (!_bt || _bt->empty()) && (!_cc || _cc->empty());
+}
+
+void
+offload_buffer_aggregate(int64_t _seq, sampler_buffer_t&& _buf)
+{
+    auto& _segment =
+        offload_segment_instances::instance(construct_on_thread{ _seq }, _seq);
+
+    auto _data = std::move(_buf);
+    auto _kept = std::vector<sampler_bundle_t>{};
+    _kept.reserve(_data.count());
+    size_t _discarded = 0;
+    while(!_data.is_empty())
+    {
+        auto _v = sampler_bundle_t{};
+        _data.read(&_v);
+        if(is_empty_sample(_v))
+            ++_discarded;
+        else
+            _kept.emplace_back(std::move(_v));
+    }
+    _data.destroy();
+    _buf.destroy();
+
+    _segment->discard(_discarded);
+    release_samples(_discarded);
+
+    OMNITRACE_VERBOSE_F(3, "Discarded %zu of %zu aggregated samples for thread %li...\n",
+                        _discarded, _discarded + _kept.size(), _seq);
+
+    if(_kept.empty()) return;
+
+    auto _compact = sampler_buffer_t(_kept.size());
+    for(auto& itr : _kept)
+        _compact.write(&itr);
+
+    if(aggregate_offload)
+        aggregate_offload(_seq, std::move(_compact));
+    else
+        _segment->retain(std::move(_compact));
+}
+
+template <typename ContainerT>
+size_t
+load_offload_segment(int64_t _thread_idx, ContainerT& _data)
+{
+    if(!offload_segment_instances::get()) return 0;
+
+    auto& _segment = offload_segment_instances::get()->at(_thread_idx);
+    if(!_segment) return 0;
+
+    auto _count = _segment->load(_data);
+
+    OMNITRACE_VERBOSE_F(2,
+                        "[sampling] Loaded %zu samples for thread %li from segment...\n",
+                        _count, _thread_idx);
+
+    return _count;
+}
+
+void
+offload_buffer_streaming(int64_t, sampler_buffer_t&&);
+
+std::set<int>
+configure(bool _setup, int64_t _tid)
+{
     const auto& _info         = thread_info::get(_tid, SequentTID);
     auto&       _sampler      = sampling::get_sampler(_tid);
     auto&       _perf_sampler = perf::get_instance(_tid);
@@ -550,6 +1728,24 @@ configure(bool _setup, int64_t _tid)
     _erase_tid_signal(_realtime_tids, get_sampling_realtime_signal());
     _erase_tid_signal(_overflow_tids, get_sampling_overflow_signal());
 
+    // the perf backend is subject to the same constraints as the timers below
+    if(!_setup ||
+       (!_sampler && !_is_running && !get_duration_disabled() &&
+        !(_tid > 0 && _info && _info->is_offset) &&
+        !(_info && _info->index_data->sequent_value == _tid &&
+          get_thread_state() == ThreadState::Disabled)))
+    {
+        if(configure_perf_collector(_setup, _tid, *_signal_types))
+        {
+            _signal_types->erase(get_sampling_cputime_signal());
+            _signal_types->erase(get_sampling_realtime_signal());
+        }
+
+        offcpu::configure(_setup, _tid);
+        numa_locality::configure(_setup, _tid);
+        branch_sampling::configure(_setup, _tid);
+    }
+
     if(_setup && !_sampler && !_is_running && !_signal_types->empty())
     {
         if(get_duration_disabled()) return std::set<int>{};
@@ -564,11 +1760,17 @@ configure(bool _setup, int64_t _tid)
             return std::set<int>{};
 
         (void) get_debug_sampling();  // make sure query in sampler does not allocate
+        (void) get_sampling_deferred_symbols();
+        (void) get_sampling_aggregate();
+        (void) get_sampling_overhead_target();
         assert(_tid == threading::get_id());
 
         if(trait::runtime_enabled<backtrace_metrics>::get())
             backtrace_metrics::configure(_setup, _tid);
 
+        backtrace::configure(_setup, _tid);
+        python_sampling::configure(_setup, _tid);
+
         // NOTE: signals need to be unblocked by calling function
         sampling::block_signals(*_signal_types);
 
@@ -585,20 +1787,61 @@ configure(bool _setup, int64_t _tid)
         _sampler->set_flags(SA_RESTART);
         _sampler->set_verbose(_verbose);
 
-        if(_signal_types->count(get_sampling_realtime_signal()) > 0)
+        auto _use_timers = (_signal_types->count(get_sampling_realtime_signal()) > 0 ||
+                            _signal_types->count(get_sampling_cputime_signal()) > 0);
+
+        if(_use_timers && get_sampling_thread_group())
         {
-            _sampler->configure(timer{ get_sampling_realtime_signal(), CLOCK_REALTIME,
-                                       SIGEV_THREAD_ID, get_sampling_realtime_freq(),
-                                       get_sampling_realtime_delay(), _tid,
-                                       threading::get_sys_tid() });
-        }
+            // the signal is sent by the thread group so the trigger only needs to
+            // install the handler
+            if(_tid == 0 && region_rates::enabled())
+                OMNITRACE_WARNING_F(0, "OMNITRACE_SAMPLING_REGION_RATES is not supported "
+                                       "with OMNITRACE_SAMPLING_THREAD_GROUP\n");
 
-        if(_signal_types->count(get_sampling_cputime_signal()) > 0)
+            auto _signum = add_thread_group_member(_tid, *_signal_types);
+            _sampler->configure(overflow{
+                _signum, [](int, pid_t, long, int64_t) { return true; },
+                [](int, pid_t, long, int64_t) { return true; },
+                [](int, pid_t, long, int64_t) { return true; }, _tid,
+                threading::get_sys_tid() });
+        }
+        else if(_use_timers)
         {
-            _sampler->configure(
-                timer{ get_sampling_cputime_signal(), CLOCK_THREAD_CPUTIME_ID,
-                       SIGEV_THREAD_ID, get_sampling_cputime_freq(),
-                       get_sampling_cputime_delay(), _tid, threading::get_sys_tid() });
+            auto _realtime = _signal_types->count(get_sampling_realtime_signal()) > 0;
+            auto _cputime  = _signal_types->count(get_sampling_cputime_signal()) > 0;
+            auto _realtime_freq = get_sampling_realtime_freq();
+            auto _cputime_freq  = get_sampling_cputime_freq();
+
+            // the region rates apply to the real-time timer or the CPU-time timer
+            // without it and "*" replaces the frequency of that timer
+            auto _region_rates = region_rates::enabled();
+            if(_region_rates && _realtime)
+                _realtime_freq = region_rates::get_default_rate(_realtime_freq);
+            else if(_region_rates)
+                _cputime_freq = region_rates::get_default_rate(_cputime_freq);
+
+            if(_realtime)
+            {
+                _sampler->configure(timer{
+                    get_sampling_realtime_signal(), CLOCK_REALTIME, SIGEV_THREAD_ID,
+                    _realtime_freq, get_sampling_realtime_delay(), _tid,
+                    threading::get_sys_tid() });
+            }
+
+            if(_cputime)
+            {
+                _sampler->configure(timer{
+                    get_sampling_cputime_signal(), CLOCK_THREAD_CPUTIME_ID,
+                    SIGEV_THREAD_ID, _cputime_freq, get_sampling_cputime_delay(), _tid,
+                    threading::get_sys_tid() });
+            }
+
+            if(_region_rates && _realtime)
+                region_rates::configure(true, get_sampling_realtime_signal(),
+                                        CLOCK_REALTIME, _realtime_freq);
+            else if(_region_rates)
+                region_rates::configure(true, get_sampling_cputime_signal(),
+                                        CLOCK_THREAD_CPUTIME_ID, _cputime_freq);
         }
 
         if(_signal_types->count(get_sampling_overflow_signal()) > 0)
@@ -620,6 +1863,13 @@ configure(bool _setup, int64_t _tid)
 
             _pe.sample_type = PERF_SAMPLE_TIME | PERF_SAMPLE_IP | PERF_SAMPLE_CALLCHAIN;
 
+            // the PMU events are usually precise (e.g. IBS) and the memory operations
+            // they sample are attributed to the instructions
+            auto _pmu_event = perf::is_pmu_event(_overflow_event);
+            if(_pmu_event)
+                _pe.sample_type |=
+                    PERF_SAMPLE_ADDR | PERF_SAMPLE_WEIGHT | PERF_SAMPLE_DATA_SRC;
+
             _pe.wakeup_events            = 10;
             _pe.exclude_idle             = 1;
             _pe.exclude_kernel           = 1;
@@ -637,6 +1887,22 @@ configure(bool _setup, int64_t _tid)
             auto _perf_open_error =
                 _perf_sampler->open(_pe, _info->index_data->system_value);
 
+            // the precise events of the core PMU (e.g. PEBS) require a skid constraint
+            // and the older kernels reject the exclusion of the kernel for IBS: the
+            // kernel samples are dropped by the callchain component instead
+            for(int i = 3; _pmu_event && _perf_open_error && i >= 0; --i)
+            {
+                _pe.precise_ip = i;
+                if(i == 0)
+                {
+                    _pe.exclude_idle   = 0;
+                    _pe.exclude_kernel = 0;
+                    _pe.exclude_hv     = 0;
+                }
+                _perf_open_error =
+                    _perf_sampler->open(_pe, _info->index_data->system_value);
+            }
+
             OMNITRACE_REQUIRE(!_perf_open_error)
                 << "perf backend for overflow failed to activate: " << *_perf_open_error;
 
@@ -660,10 +1926,30 @@ configure(bool _setup, int64_t _tid)
                 _tid, threading::get_sys_tid() });
         }
 
-        if(get_use_tmp_files())
+        auto _offload = offload_func_t{ nullptr };
+        if(get_sampling_streaming())
+        {
+            _offload = &offload_buffer_streaming;
+        }
+        else if(get_use_tmp_files())
         {
             auto _file = get_offload_file();
-            if(_file && *_file) _sampler->set_offload(&offload_buffer);
+            if(get_sampling_offload_per_thread())
+                _offload = &offload_buffer_per_thread;
+            else if(_file && *_file)
+                _offload = &offload_buffer;
+        }
+
+        // the aggregated samples are compacted before the configured offload or, when
+        // there is none, kept in memory in place of the full buffers of the sampler
+        if(get_sampling_aggregate())
+        {
+            aggregate_offload = _offload;
+            _sampler->set_offload(&offload_buffer_aggregate);
+        }
+        else if(_offload)
+        {
+            _sampler->set_offload(_offload);
         }
 
         static_assert(tim::trait::buffer_size<sampling::sampler_t>::value > 0,
@@ -716,6 +2002,7 @@ configure(bool _setup, int64_t _tid)
         *_running = true;
         sampling::get_sampler_init(_tid)->sample();
         start_duration_thread();
+        start_snapshot_thread();
         _sampler->start();
     }
     else if(!_setup && _sampler && _is_running)
@@ -723,6 +2010,8 @@ configure(bool _setup, int64_t _tid)
         OMNITRACE_DEBUG("Stopping sampler for thread %lu...\n", _tid);
         *_running = false;
 
+        if(get_sampling_thread_group()) remove_thread_group_member(_tid);
+
         if(_tid == threading::get_id() && !_signal_types->empty())
         {
             sampling::block_signals(*_signal_types);
@@ -733,10 +2022,13 @@ configure(bool _setup, int64_t _tid)
         if(_tid == 0)
         {
             // this propagates to all threads
+            stop_thread_group();
+            region_rates::stop();
             block_samples();
             _sampler->ignore(*_signal_types);
         }
 
+        region_rates::configure(false, 0, CLOCK_REALTIME, 0.0);
         _sampler->stop();
         _sampler->reset();
         *_running = false;
@@ -775,71 +2067,410 @@ configure(bool _setup, int64_t _tid)
     return (_signal_types) ? *_signal_types : std::set<int>{};
 }
 
-struct timer_sampling_data
+// table of the unique instruction pointers sampled by all the threads when
+// OMNITRACE_SAMPLING_DEFERRED_SYMBOLS is enabled. Each address is symbolized and
+// patched exactly once and the call-stacks of the samples are rebuilt from the table.
+// The addresses are symbolized in the address space of this process unless a lookup
+// is provided (e.g. the addresses of a raw output). The count is the number of samples
+// of the call-stack for the sampling code coverage
+template <bool ExcludeInternal>
+struct symbol_table
 {
-    int64_t                                   m_tid     = -1;
-    uint64_t                                  m_beg     = 0;
-    uint64_t                                  m_end     = 0;
-    std::vector<tim::unwind::processed_entry> m_stack   = {};
-    backtrace_metrics                         m_metrics = {};
-};
+    using entry_type  = tim::unwind::processed_entry;
+    using lookup_type = raw_lookup_t;
 
-struct overflow_sampling_data
-{
-    int64_t                                   m_tid   = -1;
-    uint64_t                                  m_beg   = 0;
-    uint64_t                                  m_end   = 0;
-    std::vector<tim::unwind::processed_entry> m_stack = {};
-};
+    template <typename ContainerT>
+    std::vector<entry_type> resolve(const ContainerT&, const lookup_type& = {},
+                                    uint64_t _count = 1);
 
-std::vector<timer_sampling_data>
-post_process_timer_data(int64_t, const bundle_t*, const std::vector<bundle_t*>&);
+    size_t size() const;
+    void   clear();
 
-std::vector<overflow_sampling_data>
-post_process_overflow_data(int64_t, const bundle_t*, const std::vector<bundle_t*>&);
+private:
+    struct value_type
+    {
+        short      use   = 0;
+        entry_type entry = {};
+    };
 
-void
-post_process_perfetto(int64_t, const std::vector<timer_sampling_data>&,
-                      const std::vector<overflow_sampling_data>&);
+    // the threads post-processed in parallel mostly find the addresses which are
+    // already symbolized so the table is split into shards by address and the lookup
+    // of a new address happens outside of the lock of its shard. The entries are never
+    // modified once inserted and the nodes of the map do not move so they are read
+    // without the lock
+    struct shard
+    {
+        mutable locking::atomic_mutex             mutex   = {};
+        std::unordered_map<uintptr_t, value_type> entries = {};
+    };
 
-void
-post_process_timemory(int64_t, const std::vector<timer_sampling_data>&,
-                      const std::vector<overflow_sampling_data>&);
+    static constexpr size_t num_shards = 32;
 
-auto static_strings = std::set<std::string>{};
+    static value_type make_value(uintptr_t, const lookup_type&);
+    shard&            get_shard(uintptr_t);
 
-}  // namespace
+    std::array<shard, num_shards> m_shards = {};
+};
 
-unique_ptr_t<std::set<int>>&
-get_signal_types(int64_t _tid)
+template <bool ExcludeInternal>
+typename symbol_table<ExcludeInternal>::value_type
+symbol_table<ExcludeInternal>::make_value(uintptr_t _addr, const lookup_type& _lookup)
 {
-    return signal_type_instances::instance(construct_on_thread{ _tid },
-                                           omnitrace::get_sampling_signals(_tid));
+    auto _v = value_type{};
+    if(component::backtrace::is_gpu_wait(_addr))
+    {
+        _v.entry.name = component::backtrace::get_gpu_wait_name(_addr);
+        _v.use        = 1;
+    }
+    else if(auto _entry = (_lookup) ? _lookup(_addr)
+                                    : binary::lookup_ipaddr_entry<ExcludeInternal>(_addr))
+    {
+        _v.entry = std::move(*_entry);
+        _v.use   = component::backtrace::patch_entry(_v.entry);
+    }
+    return _v;
 }
 
-std::set<int>
-setup()
+template <bool ExcludeInternal>
+typename symbol_table<ExcludeInternal>::shard&
+symbol_table<ExcludeInternal>::get_shard(uintptr_t _addr)
 {
-    if(!get_use_sampling()) return std::set<int>{};
-    return configure(true);
+    // the low bits of neighboring instructions are mixed so the shards are balanced
+    auto _idx = ((_addr >> 4) * 0x9e3779b97f4a7c15ULL) >> 59;
+    return m_shards[_idx % num_shards];
 }
 
-std::set<int>
-shutdown()
+template <bool ExcludeInternal>
+template <typename ContainerT>
+std::vector<tim::unwind::processed_entry>
+symbol_table<ExcludeInternal>::resolve(const ContainerT& _addrs,
+                                       const lookup_type& _lookup, uint64_t _count)
 {
-    if(is_child_process())
+    // the addresses of another process (resolved with a lookup) are not covered here
+    if(!_lookup && config::get_sampling_coverage())
+        coverage::record_samples({ _addrs.begin(), _addrs.end() }, _count);
+
+    auto _vals = std::vector<const value_type*>{};
+    _vals.reserve(_addrs.size());
+    for(auto itr : _addrs)
     {
-        for(auto& itr : *sampler_instances::get())
-            itr.release();
-        return std::set<int>{};
+        auto& _shard = get_shard(itr);
+        {
+            auto _lk   = locking::atomic_lock{ _shard.mutex };
+            auto _iitr = _shard.entries.find(itr);
+            if(_iitr != _shard.entries.end())
+            {
+                _vals.emplace_back(&_iitr->second);
+                continue;
+            }
+        }
+
+        // another thread may symbolize the same address in the meantime, in which case
+        // the first insertion is kept
+        auto _v    = make_value(itr, _lookup);
+        auto _lk   = locking::atomic_lock{ _shard.mutex };
+        auto _iitr = _shard.entries.emplace(itr, std::move(_v)).first;
+        _vals.emplace_back(&_iitr->second);
     }
 
-    auto _v = configure(false);
-    if(utility::get_thread_index() == 0) stop_duration_thread();
-    return _v;
-}
+    // the addresses start at the innermost frame. Remove some known functions which
+    // are by-products of interrupts and then walk from the bottom of the call-stack
+    static const auto _known_excludes =
+        std::set<std::string>{ "funlockfile", "killpg", "__restore_rt" };
 
-void
+    size_t _inner = 0;
+    while(_inner < _vals.size())
+    {
+        const auto& _v = *_vals.at(_inner);
+        if(_v.use != 0 && _known_excludes.count(_v.entry.name) == 0) break;
+        ++_inner;
+    }
+
+    auto _ret = std::vector<entry_type>{};
+    _ret.reserve(_vals.size() - _inner);
+    for(size_t i = _vals.size(); i > _inner; --i)
+    {
+        const auto& _v = *_vals.at(i - 1);
+        if(_v.use == -1) break;
+        if(_v.use == 0) continue;
+        _ret.emplace_back(_v.entry);
+    }
+
+    return _ret;
+}
+
+template <bool ExcludeInternal>
+size_t
+symbol_table<ExcludeInternal>::size() const
+{
+    size_t _n = 0;
+    for(const auto& itr : m_shards)
+    {
+        auto _lk = locking::atomic_lock{ itr.mutex };
+        _n += itr.entries.size();
+    }
+    return _n;
+}
+
+template <bool ExcludeInternal>
+void
+symbol_table<ExcludeInternal>::clear()
+{
+    for(auto& itr : m_shards)
+    {
+        auto _lk = locking::atomic_lock{ itr.mutex };
+        itr.entries.clear();
+    }
+}
+
+template <bool ExcludeInternal>
+auto&
+get_symbol_table()
+{
+    static auto _v = symbol_table<ExcludeInternal>{};
+    return _v;
+}
+
+struct timer_sampling_data
+{
+    bool                                      m_aggregated = false;  // in stack table
+    int64_t                                   m_tid        = -1;
+    uint64_t                                  m_beg        = 0;
+    uint64_t                                  m_end        = 0;
+    uint32_t                                  m_weight     = 1;
+    std::vector<tim::unwind::processed_entry> m_stack      = {};
+    backtrace_metrics                         m_metrics    = {};
+};
+
+struct overflow_sampling_data
+{
+    int64_t                                   m_tid   = -1;
+    uint64_t                                  m_beg   = 0;
+    uint64_t                                  m_end   = 0;
+    std::vector<tim::unwind::processed_entry> m_stack = {};
+};
+
+// perf timestamps are relative so the offset between the first callchain timestamp and
+// the sample timestamp has to be carried between successive buffers
+struct overflow_sampling_state
+{
+    uint64_t m_last_call_ts   = 0;
+    uint64_t m_perf_ts_offset = 0;
+};
+
+// accumulated values of the samples of a call-stack node
+struct sampling_aggregate
+{
+    size_t                               m_count   = 0;
+    double                               m_wall    = 0.0;
+    double                               m_cpu     = 0.0;
+    bool                                 m_use_cpu = false;
+    bool                                 m_use_hw  = false;
+    backtrace_metrics::hw_counter_data_t m_hw      = {};
+
+    sampling_aggregate& operator+=(const sampling_aggregate&);
+    sampling_aggregate& operator+=(const timer_sampling_data&);
+    sampling_aggregate& operator+=(const overflow_sampling_data&);
+};
+
+// prefix tree of the call-stacks of a thread. Each sample is accumulated into every
+// node of its call-stack so the timemory call-graph is built with one insertion per
+// unique call-stack node instead of one per frame of every sample
+struct sampling_trie
+{
+    using stack_t = std::vector<tim::unwind::processed_entry>;
+
+    struct node
+    {
+        const std::string*            name     = nullptr;
+        sampling_aggregate            data     = {};
+        std::map<std::string, size_t> children = {};
+        std::vector<size_t>           order    = {};  // children in order of appearance
+    };
+
+    template <typename DataT>
+    void add(const stack_t&, const DataT&);
+
+    // _update(bundle, data) stops the bundle of a node and sets its values
+    template <typename BundleT, typename FuncT>
+    void insert(int64_t _tid, FuncT&& _update) const;
+
+    // adds the call-stacks and the values of another tree
+    void merge(const sampling_trie&);
+
+    // _func(name, depth, data) for every node in depth-first order
+    template <typename FuncT>
+    void for_each(FuncT&& _func) const;
+
+    size_t size() const { return m_nodes.size() - 1; }
+
+private:
+    template <typename BundleT, typename FuncT>
+    void insert_node(size_t _idx, int64_t _tid, FuncT& _update) const;
+
+    // the index of the child node of the name, which is added if it does not exist
+    size_t get_child(size_t _idx, const std::string& _name);
+
+    void merge_node(size_t _idx, const sampling_trie&, size_t _other);
+
+    template <typename FuncT>
+    void for_each_node(size_t _idx, size_t _depth, FuncT& _func) const;
+
+    // the first node is the root. The nodes are not moved when the tree grows
+    std::deque<node> m_nodes = std::deque<node>(1);
+};
+
+// per-thread state when the sampling buffers are post-processed as they are offloaded
+struct streaming_state
+{
+    bool                             m_init          = false;
+    size_t                           m_num_samples   = 0;
+    size_t                           m_num_valid     = 0;
+    int64_t                          m_num_entries   = 0;
+    sampler_bundle_t                 m_last          = {};
+    overflow_sampling_state          m_overflow      = {};
+    backtrace_metrics::valid_array_t m_valid_metrics = {};
+    sampling_trie                    m_timer_data    = {};
+    sampling_trie                    m_overflow_data = {};
+    // the call-graphs since the last snapshot (OMNITRACE_SAMPLING_SNAPSHOT_INTERVAL),
+    // which are swapped out by the snapshot thread
+    locking::atomic_mutex m_snapshot_mutex    = {};
+    sampling_trie         m_snapshot_timer    = {};
+    sampling_trie         m_snapshot_overflow = {};
+};
+
+// the thread of the samples emitted to perfetto
+struct thread_lifetime
+{
+    int64_t  tid     = -1;
+    int64_t  sequent = -1;
+    int64_t  system  = -1;
+    uint64_t beg     = 0;
+    uint64_t end     = std::numeric_limits<uint64_t>::max();
+};
+
+// the number of timer samples which a sample stands for
+struct sample_weight
+{
+    explicit sample_weight(int64_t _tid);
+
+    uint32_t operator()(uint64_t _beg, uint64_t _end) const;
+
+private:
+    // samples skipped by the rate controller are represented by the next sample
+    const backtrace::rate_controller* m_ctrl = nullptr;
+    // the samples sent by the thread group stand for the samples which the timer of
+    // the thread would have generated since the previous sample of the thread
+    double m_group_freq = 0.0;
+};
+
+using streaming_state_instances = thread_data<streaming_state, streaming_state>;
+
+std::vector<timer_sampling_data>
+post_process_timer_data(int64_t, const bundle_t*, const std::vector<bundle_t*>&);
+
+std::vector<overflow_sampling_data>
+post_process_overflow_data(int64_t, overflow_sampling_state&,
+                           const std::vector<bundle_t*>&);
+
+void
+post_process_perfetto(int64_t, const std::vector<timer_sampling_data>&,
+                      const std::vector<overflow_sampling_data>&, bool _finalize = true);
+
+void
+post_process_perfetto(const thread_lifetime&, const std::vector<timer_sampling_data>&,
+                      const std::vector<overflow_sampling_data>&, bool _finalize);
+
+void
+post_process_timemory(int64_t, const std::vector<timer_sampling_data>&,
+                      const std::vector<overflow_sampling_data>&);
+
+void
+post_process_timemory(int64_t, const sampling_trie&, const sampling_trie&, int64_t);
+
+template <typename ContainerT>
+size_t
+post_process_streaming(int64_t, ContainerT&);
+
+size_t
+post_process_streaming_finalize(int64_t);
+
+// the call-graphs of a thread retired by a snapshot
+struct snapshot_thread
+{
+    int64_t       tid      = -1;
+    sampling_trie timer    = {};
+    sampling_trie overflow = {};
+};
+
+void
+start_snapshot_thread();
+
+void
+stop_snapshot_thread();
+
+bool
+retire_snapshot(int64_t, snapshot_thread&);
+
+void
+write_snapshot(const std::vector<snapshot_thread>&);
+
+void
+post_process_stack_table(int64_t);
+
+std::vector<timer_sampling_data>
+post_process_perf_collector(int64_t);
+
+auto static_strings = std::set<std::string>{};
+
+}  // namespace
+
+unique_ptr_t<std::set<int>>&
+get_signal_types(int64_t _tid)
+{
+    return signal_type_instances::instance(construct_on_thread{ _tid },
+                                           omnitrace::get_sampling_signals(_tid));
+}
+
+std::set<int>
+setup()
+{
+    if(!get_use_sampling()) return std::set<int>{};
+    return configure(true);
+}
+
+std::set<int>
+shutdown()
+{
+    if(is_child_process())
+    {
+        for(auto& itr : *sampler_instances::get())
+            itr.release();
+        return std::set<int>{};
+    }
+
+    auto _v = configure(false);
+    if(utility::get_thread_index() == 0)
+    {
+        stop_duration_thread();
+        stop_snapshot_thread();
+        stop_perf_collector();
+        stop_thread_group();
+        offcpu::stop();
+        numa_locality::stop();
+        branch_sampling::stop();
+    }
+    return _v;
+}
+
+void
+track_sample()
+{
+    memory_footprint::track(memory_footprint::sampling_subsystem,
+                            sizeof(sampler_bundle_t));
+}
+
+void
 block_samples()
 {
     trait::runtime_enabled<sampler_t>::set(false);
@@ -899,12 +2530,30 @@ post_process()
 
     omnitrace::component::backtrace::stop();
     configure(false, 0);
+    stop_snapshot_thread();
+    stop_perf_collector();
+    offcpu::post_process();
+    numa_locality::post_process();
+    branch_sampling::post_process();
 
     for(auto& itr : get_sampler_allocators())
         if(itr) itr->flush();
 
-    for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
+    // the Python frames have to be resolved on this thread, which may hold the GIL
+    if(python_sampling::enabled()) python_sampling::resolve();
+
+    // per-thread results of loading, filtering, and symbolizing the samples. These
+    // are independent between threads and can be generated in parallel
+    struct thread_result
     {
+        bool                                skip          = true;
+        size_t                              num_valid     = 0;
+        std::vector<timer_sampling_data>    timer_data    = {};
+        std::vector<overflow_sampling_data> overflow_data = {};
+        std::vector<timer_sampling_data>    perf_data     = {};
+    };
+
+    auto _process_samples = [](size_t i, thread_result& _result) {
         auto& _sampler = get_sampler(i);
 
         if(!_sampler)
@@ -914,7 +2563,7 @@ post_process()
                 get_debug() && get_verbose() >= 2,
                 "Post-processing sampling entries for thread %lu skipped (no sampler)\n",
                 i);
-            continue;
+            return;
         }
 
         auto* _init = get_sampler_init(i).get();
@@ -925,7 +2574,7 @@ post_process()
             OMNITRACE_PRINT("Post-processing sampling entries for thread %lu skipped "
                             "(not initialized)\n",
                             i);
-            continue;
+            return;
         }
 
         const auto& _thread_info = thread_info::get(i, SequentTID);
@@ -934,7 +2583,7 @@ post_process()
                           "Getting sampler data for thread %lu...\n", i);
 
         auto _raw_data    = _sampler->get_data();
-        auto _loaded_data = load_offload_buffer(i);
+        auto _loaded_data = load_offload_buffer(i, _raw_data);
         for(auto litr : _loaded_data)
         {
             while(!litr.is_empty())
@@ -945,18 +2594,59 @@ post_process()
             }
             litr.destroy();
         }
+        load_offload_segment(i, _raw_data);
 
         OMNITRACE_VERBOSE(2 || get_debug_sampling(),
                           "Sampler data for thread %lu has %zu initial entries...\n", i,
                           _raw_data.size());
 
+        size_t _num_streamed = 0;
+        if(get_snapshot().sampling_streaming && streaming_state_instances::get())
+        {
+            const auto& _state = streaming_state_instances::get()->at(i);
+            if(_state) _num_streamed = _state->m_num_samples;
+        }
+
+        // the aggregated samples without any data were discarded during the offload
+        size_t _num_discarded = 0;
+        if(offload_segment_instances::get())
+        {
+            const auto& _segment = offload_segment_instances::get()->at(i);
+            if(_segment) _num_discarded = _segment->discarded();
+        }
+
         OMNITRACE_CI_THROW(
-            _sampler->get_sample_count() != _raw_data.size(),
+            _sampler->get_sample_count() !=
+                _raw_data.size() + _num_streamed + _num_discarded,
             "Error! sampler recorded %zu samples but %zu samples were returned\n",
-            _sampler->get_sample_count(), _raw_data.size());
+            _sampler->get_sample_count(),
+            _raw_data.size() + _num_streamed + _num_discarded);
         // single sample that is useless (backtrace to unblocking signals)
         if(_raw_data.size() == 1 && _raw_data.front().size() <= 1) _raw_data.clear();
 
+        _result.skip = false;
+
+        if(get_sampling_overhead_target() > 0.0 && backtrace::get_rate_controller(i))
+        {
+            const auto& _ctrl = backtrace::get_rate_controller(i);
+            OMNITRACE_VERBOSE(1 || get_debug_sampling(),
+                              "Sampling rate of thread %lu was adjusted %zu times to "
+                              "stay below %.2f%% overhead (final stride: %u)...\n",
+                              i, _ctrl->get_changes().size(),
+                              get_sampling_overhead_target(), _ctrl->get_stride());
+            for(const auto& itr : _ctrl->get_changes())
+                OMNITRACE_VERBOSE(3 || get_debug_sampling(),
+                                  "    [%lu] stride=%u at %lu ns\n", i, itr.stride,
+                                  itr.timestamp);
+        }
+
+        if(get_sampling_streaming())
+        {
+            // process the remaining samples. accumulated state is flushed serially
+            post_process_streaming(i, _raw_data);
+            return;
+        }
+
         std::vector<sampling::bundle_t*> _data{};
         for(auto& itr : _raw_data)
         {
@@ -970,8 +2660,36 @@ post_process()
             }
         }
 
-        _total_data += _data.size();
-        _total_threads += (!_data.empty()) ? 1 : 0;
+        if(raw_output::enabled())
+        {
+            // the instruction pointers are symbolized by omnitrace-process
+            auto _weight  = sample_weight{ static_cast<int64_t>(i) };
+            auto _samples = std::vector<raw_output::sample>{};
+            auto _beg     = _init->get<backtrace_timestamp>()->get_timestamp();
+            _samples.reserve(_data.size());
+            for(const auto* itr : _data)
+            {
+                const auto* _bt_data = itr->get<backtrace>();
+                const auto* _bt_time = itr->get<backtrace_timestamp>();
+                if(!_bt_data || _bt_data->get_addresses().empty() ||
+                   _bt_time->get_tid() != static_cast<int64_t>(i))
+                    continue;
+
+                const auto& _addrs = _bt_data->get_addresses();
+                auto        _v     = raw_output::sample{};
+                _v.timestamp       = _bt_time->get_timestamp();
+                _v.weight          = _weight(_beg, _v.timestamp) * _bt_time->get_weight();
+                _v.addresses.assign(_addrs.begin(), _addrs.end());
+                _beg = _v.timestamp;
+                _samples.emplace_back(std::move(_v));
+            }
+
+            _result.num_valid = raw_output::write_samples(
+                i, _init->get<backtrace_timestamp>()->get_timestamp(), _samples);
+            return;
+        }
+
+        _result.num_valid = _data.size();
 
         if(!_data.empty())
         {
@@ -979,11 +2697,9 @@ post_process()
                               "Sampler data for thread %lu has %zu valid entries...\n", i,
                               _data.size());
 
-            auto _timer_data    = post_process_timer_data(i, _init, _data);
-            auto _overflow_data = post_process_overflow_data(i, _init, _data);
-
-            if(get_use_perfetto()) post_process_perfetto(i, _timer_data, _overflow_data);
-            if(get_use_timemory()) post_process_timemory(i, _timer_data, _overflow_data);
+            auto _overflow_state  = overflow_sampling_state{};
+            _result.timer_data    = post_process_timer_data(i, _init, _data);
+            _result.overflow_data = post_process_overflow_data(i, _overflow_state, _data);
         }
         else
         {
@@ -992,13 +2708,148 @@ post_process()
                               "%zu... (skipped)\n",
                               i, _raw_data.size());
         }
+    };
+
+    auto _process_thread = [&_process_samples](size_t i, thread_result& _result) {
+        _process_samples(i, _result);
+
+        // samples collected by the perf backend do not require a sampler
+        _result.perf_data = post_process_perf_collector(i);
+        if(!_result.perf_data.empty())
+        {
+            _result.skip = false;
+            _result.num_valid += _result.perf_data.size();
+        }
+    };
+
+    // emitting the perfetto and timemory data is done serially in the order of the
+    // threads so that the output is deterministic
+    // the samples since the last snapshot are written as the final snapshot
+    auto _final_snapshot = std::vector<snapshot_thread>{};
+    auto _emit_thread    = [&_total_data, &_total_threads, &_final_snapshot](
+                            size_t i, thread_result& _value) {
+        auto _result = std::move(_value);
+        _value       = thread_result{};
+
+        if(_result.skip) return;
+
+        if(get_sampling_snapshot_interval() > 0.0)
+        {
+            auto _v = snapshot_thread{};
+            if(retire_snapshot(i, _v)) _final_snapshot.emplace_back(std::move(_v));
+        }
+
+        if(get_sampling_streaming())
+            _result.num_valid += post_process_streaming_finalize(i);
+
+        _total_data += _result.num_valid;
+        _total_threads += (_result.num_valid > 0) ? 1 : 0;
+
+        if(get_sampling_aggregate() && get_use_timemory()) post_process_stack_table(i);
+
+        for(auto& itr : _result.perf_data)
+            _result.timer_data.emplace_back(std::move(itr));
+        _result.perf_data.clear();
+
+        if(_result.timer_data.empty() && _result.overflow_data.empty()) return;
+
+        if(get_use_perfetto())
+            post_process_perfetto(i, _result.timer_data, _result.overflow_data);
+        if(get_use_timemory())
+        {
+            // the timer samples which were counted in the aggregated call-stack table
+            // are only a part of the timeline
+            _result.timer_data.erase(
+                std::remove_if(_result.timer_data.begin(), _result.timer_data.end(),
+                               [](const auto& itr) { return itr.m_aggregated; }),
+                _result.timer_data.end());
+            post_process_timemory(i, _result.timer_data, _result.overflow_data);
+        }
+    };
+
+    const size_t _num_threads = thread_info::get_peak_num_threads();
+    const bool   _parallel    = get_sampling_parallel_post_process() &&
+                           get_thread_pool_size() > 1 && _num_threads > 1;
+    // process the threads in batches to bound the amount of memory held by the
+    // symbolized data of threads which have not been emitted yet
+    const size_t _batch_size =
+        (_parallel) ? std::max<size_t>(2 * get_thread_pool_size(), 1) : 1;
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "Post-processing sampling data for %zu threads (%s)...\n",
+                      _num_threads, (_parallel) ? "parallel" : "serial");
+
+    auto _results = std::vector<thread_result>(std::min(_batch_size, _num_threads));
+    for(size_t _beg = 0; _beg < _num_threads; _beg += _batch_size)
+    {
+        auto _end = std::min(_beg + _batch_size, _num_threads);
+        if(_parallel)
+        {
+            auto& _tg = tasking::general::get_task_group();
+            for(size_t i = _beg; i < _end; ++i)
+                _tg.exec([&_process_thread, &_results, _beg, i]() {
+                    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+                    _process_thread(i, _results.at(i - _beg));
+                });
+            _tg.join();
+        }
+        else
+        {
+            for(size_t i = _beg; i < _end; ++i)
+                _process_thread(i, _results.at(i - _beg));
+        }
+
+        for(size_t i = _beg; i < _end; ++i)
+            _emit_thread(i, _results.at(i - _beg));
     }
 
+    if(get_sampling_snapshot_interval() > 0.0) write_snapshot(_final_snapshot);
+
+    if(raw_output::enabled()) raw_output::post_process();
+
     OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                       "Destroying samplers and allocators...\n");
 
     get_offload_file().reset();  // remove the temporary file
 
+    if(config::get_snapshot().sampling_unwinder == SamplingUnwinder::Auto)
+    {
+        OMNITRACE_VERBOSE(1 || get_debug_sampling(),
+                          "The call-stacks were unwound by %s...\n",
+                          (backtrace::get_unwinder() == SamplingUnwinder::FramePointer)
+                              ? "the frame pointers"
+                              : "libunwind");
+    }
+
+    memory_latency::post_process();
+
+    // the frame-pointer call-stacks are symbolized through the same table
+    if(get_sampling_deferred_symbols() || get_sampling_perf_backend() ||
+       config::get_snapshot().sampling_unwinder != SamplingUnwinder::LibUnwind)
+    {
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "Symbolized %zu unique instruction pointers...\n",
+                          get_symbol_table<false>().size() +
+                              get_symbol_table<true>().size());
+        get_symbol_table<false>().clear();
+        get_symbol_table<true>().clear();
+    }
+
+    // the samplers are stopped and the call-stacks are symbolized
+    if(get_sampling_shared_unwind_tables()) binary::release_unwind_tables();
+
+    if(offload_segment_instances::get())
+    {
+        for(auto& itr : *offload_segment_instances::get())
+            itr.reset();
+    }
+
+    if(streaming_state_instances::get())
+    {
+        for(auto& itr : *streaming_state_instances::get())
+            itr.reset();
+    }
+
     for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
         get_sampler(i).reset();
 
@@ -1020,13 +2871,86 @@ post_process()
                       (_internal_samples + _external_samples));
 }
 
+void
+post_process_raw(const raw_output::thread_entry&        _thread,
+                 const std::vector<raw_output::sample>& _samples,
+                 const raw_lookup_t&                    _lookup)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _data = std::vector<timer_sampling_data>{};
+    auto _beg  = _thread.init;
+    _data.reserve(_samples.size());
+    for(const auto& itr : _samples)
+    {
+        auto _ret     = timer_sampling_data{};
+        _ret.m_tid    = _thread.index;
+        _ret.m_beg    = _beg;
+        _ret.m_end    = itr.timestamp;
+        _ret.m_weight = itr.weight;
+        _ret.m_stack  = get_symbol_table<false>().resolve(itr.addresses, _lookup);
+        _beg          = itr.timestamp;
+        if(!_ret.m_stack.empty()) _data.emplace_back(std::move(_ret));
+    }
+
+    std::sort(_data.begin(), _data.end(),
+              [](const auto& _lhs, const auto& _rhs) { return _lhs.m_beg < _rhs.m_beg; });
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "Raw output of thread %li has %zu valid samples out of %zu...\n",
+                      _thread.index, _data.size(), _samples.size());
+
+    if(_data.empty()) return;
+
+    auto _lifetime    = thread_lifetime{};
+    _lifetime.tid     = _thread.index;
+    _lifetime.sequent = _thread.index;
+    _lifetime.system  = _thread.system;
+    _lifetime.beg     = _thread.start;
+    if(_thread.stop > 0) _lifetime.end = _thread.stop;
+
+    if(get_use_perfetto()) post_process_perfetto(_lifetime, _data, {}, true);
+    if(get_use_timemory()) post_process_timemory(_thread.index, _data, {});
+}
+
 namespace
 {
+sample_weight::sample_weight(int64_t _tid)
+: m_ctrl{ (get_sampling_overhead_target() > 0.0)
+              ? backtrace::get_rate_controller(_tid).get()
+              : nullptr }
+{
+    if(get_sampling_thread_group() && get_signal_types(_tid))
+    {
+        const auto& _signals = *get_signal_types(_tid);
+        if(_signals.count(get_sampling_realtime_signal()) > 0)
+            m_group_freq = get_sampling_realtime_freq();
+        else if(_signals.count(get_sampling_cputime_signal()) > 0)
+            m_group_freq = get_sampling_cputime_freq();
+    }
+}
+
+uint32_t
+sample_weight::operator()(uint64_t _beg, uint64_t _end) const
+{
+    uint32_t _weight = (m_ctrl) ? m_ctrl->get_stride(_end) : 1;
+    if(m_group_freq > 0.0 && _end > _beg)
+    {
+        auto _n = std::round((_end - _beg) * m_group_freq / units::sec);
+        _weight *= static_cast<uint32_t>(std::max<double>(_n, 1.0));
+    }
+    return _weight;
+}
+
 std::vector<timer_sampling_data>
 post_process_timer_data(int64_t _tid, const bundle_t* _init,
                         const std::vector<bundle_t*>& _data)
 {
     auto _results = std::vector<timer_sampling_data>{};
+    auto _weight  = sample_weight{ _tid };
+
+    // number of samples reduced to a frame by OMNITRACE_SAMPLING_COLLAPSE_GPU_WAIT
+    size_t _num_gpu_wait = 0;
 
     const auto* _last = _init;
     for(const auto& itr : _data)
@@ -1039,11 +2963,22 @@ post_process_timer_data(int64_t _tid, const bundle_t* _init,
         if(!_bt_data || !_bt_time || _bt_data->empty() || _bt_time->get_tid() != _tid)
             continue;
 
-        auto _ret    = timer_sampling_data{};
-        _ret.m_tid   = _bt_time->get_tid();
-        _ret.m_beg   = _last->get<backtrace_timestamp>()->get_timestamp();
-        _ret.m_end   = _bt_time->get_timestamp();
-        _ret.m_stack = backtrace::filter_and_patch(_bt_data->get());
+        auto _ret         = timer_sampling_data{};
+        _ret.m_aggregated = _bt_data->is_aggregated();
+        _ret.m_tid        = _bt_time->get_tid();
+        _ret.m_beg        = _last->get<backtrace_timestamp>()->get_timestamp();
+        _ret.m_end        = _bt_time->get_timestamp();
+        _ret.m_weight     = _weight(_ret.m_beg, _ret.m_end) * _bt_time->get_weight();
+        _ret.m_stack = (_bt_data->get_addresses().empty())
+                           ? backtrace::filter_and_patch(_bt_data->get())
+                           : get_symbol_table<false>().resolve(_bt_data->get_addresses());
+        if(_bt_data->get_addresses().size() == 1 &&
+           backtrace::is_gpu_wait(_bt_data->get_addresses().front()))
+            ++_num_gpu_wait;
+        if(config::get_python_gil())
+            python_gil::record_sample(_tid, _ret.m_beg, _ret.m_end, _ret.m_stack);
+        if(python_sampling::enabled())
+            python_sampling::merge(_tid, _ret.m_end, _ret.m_stack);
         if constexpr(tim::trait::is_available<hw_counters>::value)
         {
             auto _hw_counters_enabled = [](const auto* _bt_v) {
@@ -1066,17 +3001,39 @@ post_process_timer_data(int64_t _tid, const bundle_t* _init,
     std::sort(_results.begin(), _results.end(),
               [](const auto& _lhs, const auto& _rhs) { return _lhs.m_beg < _rhs.m_beg; });
 
+    OMNITRACE_VERBOSE(2 && _num_gpu_wait > 0,
+                      "Thread %li: %zu of %zu samples were taken while waiting for the "
+                      "GPU and were not unwound...\n",
+                      _tid, _num_gpu_wait, _results.size());
+
     return _results;
 }
 
 std::vector<overflow_sampling_data>
-post_process_overflow_data(int64_t                       _tid, const bundle_t*,
+post_process_overflow_data(int64_t _tid, overflow_sampling_state& _state,
                            const std::vector<bundle_t*>& _data)
 {
     auto _results = std::vector<overflow_sampling_data>{};
 
-    uint64_t _last_call_ts   = 0;
-    uint64_t _perf_ts_offset = 0;
+    auto& _last_call_ts   = _state.m_last_call_ts;
+    auto& _perf_ts_offset = _state.m_perf_ts_offset;
+
+    auto _get_callchain = [](const callchain* _v) {
+        if(!get_sampling_deferred_symbols())
+            return callchain::filter_and_patch(_v->get());
+
+        auto _records = _v->get_data();
+        std::sort(_records.begin(), _records.end());
+
+        auto _ret = std::vector<callchain::ts_entry_vec_t>{};
+        _ret.reserve(_records.size());
+        for(const auto& itr : _records)
+        {
+            auto _stack = get_symbol_table<true>().resolve(itr.data);
+            if(!_stack.empty()) _ret.emplace_back(itr.timestamp, std::move(_stack));
+        }
+        return _ret;
+    };
     for(const auto& itr : _data)
     {
         auto* _bt_call = itr->get<callchain>();
@@ -1085,7 +3042,14 @@ post_process_overflow_data(int64_t                       _tid, const bundle_t*,
         if(!_bt_call || !_bt_time || _bt_call->empty() || _bt_time->get_tid() != _tid)
             continue;
 
-        for(const auto& pitr : callchain::filter_and_patch(_bt_call->get()))
+        for(const auto& ritr : _bt_call->get_data())
+        {
+            if(ritr.data_src != 0)
+                memory_latency::record(ritr.data.front(), ritr.addr, ritr.weight,
+                                       ritr.data_src);
+        }
+
+        for(const auto& pitr : _get_callchain(_bt_call))
         {
             if(_last_call_ts == 0)
             {
@@ -1112,13 +3076,37 @@ post_process_overflow_data(int64_t                       _tid, const bundle_t*,
 
 void
 post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _timer_data,
-                      const std::vector<overflow_sampling_data>& _overflow_data)
+                      const std::vector<overflow_sampling_data>& _overflow_data,
+                      bool                                       _finalize)
 {
-    auto _valid_metrics = backtrace_metrics::valid_array_t{};
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+    OMNITRACE_CI_THROW(!_thread_info, "No valid thread info for tid=%li\n", _tid);
 
-    for(const auto& itr : _timer_data)
-    {
-        _valid_metrics |= itr.m_metrics.get_valid();
+    if(!_thread_info) return;
+
+    // when streaming, the thread may still be running and will not have a stop time
+    auto _lifetime    = thread_lifetime{};
+    _lifetime.tid     = _tid;
+    _lifetime.sequent = _thread_info->index_data->sequent_value;
+    _lifetime.system  = _thread_info->index_data->system_value;
+    _lifetime.beg     = _thread_info->get_start();
+    if(_thread_info->get_stop() > 0) _lifetime.end = _thread_info->get_stop();
+
+    post_process_perfetto(_lifetime, _timer_data, _overflow_data, _finalize);
+}
+
+void
+post_process_perfetto(const thread_lifetime&                     _lifetime,
+                      const std::vector<timer_sampling_data>&    _timer_data,
+                      const std::vector<overflow_sampling_data>& _overflow_data,
+                      bool                                       _finalize)
+{
+    const auto _tid           = _lifetime.tid;
+    auto       _valid_metrics = backtrace_metrics::valid_array_t{};
+
+    for(const auto& itr : _timer_data)
+    {
+        _valid_metrics |= itr.m_metrics.get_valid();
     }
 
     if(trait::runtime_enabled<backtrace_metrics>::get())
@@ -1128,24 +3116,25 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
         backtrace_metrics::init_perfetto(_tid, _valid_metrics);
         for(const auto& itr : _timer_data)
             itr.m_metrics.post_process_perfetto(_tid, 0.5 * (itr.m_beg + itr.m_end));
-        backtrace_metrics::fini_perfetto(_tid, _valid_metrics);
+        if(_finalize) backtrace_metrics::fini_perfetto(_tid, _valid_metrics);
     }
 
     OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                       "[%li] Post-processing backtraces for perfetto...\n", _tid);
 
-    const auto& _thread_info = thread_info::get(_tid, SequentTID);
-    OMNITRACE_CI_THROW(!_thread_info, "No valid thread info for tid=%li\n", _tid);
-
-    if(!_thread_info) return;
+    const auto _thread_beg  = _lifetime.beg;
+    const auto _thread_end  = _lifetime.end;
+    auto _is_valid_lifetime = [_thread_beg, _thread_end](uint64_t _beg, uint64_t _end) {
+        return (_beg >= _thread_beg && _end <= _thread_end);
+    };
 
     auto _overflow_event =
         get_setting_value<std::string>("OMNITRACE_SAMPLING_OVERFLOW_EVENT").value_or("");
 
     if(!_overflow_event.empty() && !_overflow_data.empty())
     {
-        auto _beg_ns = std::max(_overflow_data.front().m_beg, _thread_info->get_start());
-        auto _end_ns = std::min(_overflow_data.back().m_end, _thread_info->get_stop());
+        auto _beg_ns = std::max(_overflow_data.front().m_beg, _thread_beg);
+        auto _end_ns = std::min(_overflow_data.back().m_end, _thread_end);
 
         const auto _overflow_prefix = std::string_view{ "PERF_COUNT_" };
         const auto _overflow_pos    = _overflow_event.find(_overflow_prefix);
@@ -1162,8 +3151,7 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
             [](auto _seq_id, auto _sys_id) {
                 return TIMEMORY_JOIN(" ", "Thread", _seq_id, "Overflow", "(S)", _sys_id);
             },
-            _thread_info->index_data->sequent_value,
-            _thread_info->index_data->system_value);
+            _lifetime.sequent, _lifetime.system);
 
         tracing::push_perfetto_track(category::overflow_sampling{}, _main_name, _track,
                                      _beg_ns, [&](::perfetto::EventContext ctx) {
@@ -1179,7 +3167,7 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
             auto _beg = itr.m_beg;
             auto _end = itr.m_end;
 
-            if(!_thread_info->is_valid_lifetime({ _beg, _end })) continue;
+            if(!_is_valid_lifetime(_beg, _end)) continue;
 
             for(const auto& iitr : itr.m_stack)
             {
@@ -1228,16 +3216,15 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
 
     if(!_timer_data.empty())
     {
-        auto _beg_ns = std::max(_timer_data.front().m_beg, _thread_info->get_start());
-        auto _end_ns = std::min(_timer_data.back().m_end, _thread_info->get_stop());
+        auto _beg_ns = std::max(_timer_data.front().m_beg, _thread_beg);
+        auto _end_ns = std::min(_timer_data.back().m_end, _thread_end);
 
         auto _track = tracing::get_perfetto_track(
             category::timer_sampling{},
             [](auto _seq_id, auto _sys_id) {
                 return TIMEMORY_JOIN(" ", "Thread", _seq_id, "(S)", _sys_id);
             },
-            _thread_info->index_data->sequent_value,
-            _thread_info->index_data->system_value);
+            _lifetime.sequent, _lifetime.system);
 
         tracing::push_perfetto_track(category::timer_sampling{}, "samples [omnitrace]",
                                      _track, _beg_ns, [&](::perfetto::EventContext ctx) {
@@ -1254,7 +3241,7 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
             size_t   _ncount = 0;
             uint64_t _beg    = itr.m_beg;
             uint64_t _end    = itr.m_end;
-            if(!_thread_info->is_valid_lifetime({ _beg, _end })) continue;
+            if(!_is_valid_lifetime(_beg, _end)) continue;
 
             for(const auto& iitr : itr.m_stack)
             {
@@ -1366,6 +3353,141 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
     }
 }
 
+sampling_aggregate&
+sampling_aggregate::operator+=(const sampling_aggregate& _v)
+{
+    m_count += _v.m_count;
+    m_wall += _v.m_wall;
+    m_cpu += _v.m_cpu;
+    m_use_cpu = m_use_cpu || _v.m_use_cpu;
+    m_use_hw  = m_use_hw || _v.m_use_hw;
+    for(size_t i = 0; i < m_hw.size() && i < _v.m_hw.size(); ++i)
+        m_hw[i] += _v.m_hw[i];
+    return *this;
+}
+
+sampling_aggregate&
+sampling_aggregate::operator+=(const timer_sampling_data& _v)
+{
+    const auto& _metrics = _v.m_metrics;
+
+    m_count += _v.m_weight;
+    m_wall += (_v.m_end - _v.m_beg);
+
+    if(_metrics && _metrics(category::thread_cpu_time{}))
+    {
+        m_use_cpu = true;
+        m_cpu += _metrics.get_cpu_timestamp();
+    }
+
+    if constexpr(tim::trait::is_available<hw_counters>::value)
+    {
+        if(_metrics && _metrics(type_list<backtrace_metrics::hw_counters>{}) &&
+           _metrics(category::thread_hardware_counter{}))
+        {
+            const auto& _hw = _metrics.get_hw_counters();
+            m_use_hw        = true;
+            for(size_t i = 0; i < m_hw.size() && i < _hw.size(); ++i)
+                m_hw[i] += _hw[i];
+        }
+    }
+
+    return *this;
+}
+
+sampling_aggregate&
+sampling_aggregate::operator+=(const overflow_sampling_data& _v)
+{
+    m_count += 1;
+    m_wall += (_v.m_end - _v.m_beg);
+    return *this;
+}
+
+size_t
+sampling_trie::get_child(size_t _idx, const std::string& _name)
+{
+    auto& _node  = m_nodes.at(_idx);
+    auto  _child = _node.children.find(_name);
+    if(_child == _node.children.end())
+    {
+        _child = _node.children.emplace(_name, m_nodes.size()).first;
+        _node.order.emplace_back(_child->second);
+        m_nodes.emplace_back();
+        m_nodes.back().name = &_child->first;
+    }
+    return _child->second;
+}
+
+template <typename DataT>
+void
+sampling_trie::add(const stack_t& _stack, const DataT& _data)
+{
+    size_t _idx = 0;
+    for(const auto& itr : _stack)
+    {
+        _idx = get_child(_idx, itr.name);
+        m_nodes.at(_idx).data += _data;
+    }
+}
+
+void
+sampling_trie::merge(const sampling_trie& _other)
+{
+    for(auto itr : _other.m_nodes.front().order)
+        merge_node(0, _other, itr);
+}
+
+void
+sampling_trie::merge_node(size_t _idx, const sampling_trie& _other, size_t _other_idx)
+{
+    const auto& _node = _other.m_nodes.at(_other_idx);
+    auto        _dst  = get_child(_idx, *_node.name);
+    m_nodes.at(_dst).data += _node.data;
+    for(auto itr : _node.order)
+        merge_node(_dst, _other, itr);
+}
+
+template <typename FuncT>
+void
+sampling_trie::for_each(FuncT&& _func) const
+{
+    for(auto itr : m_nodes.front().order)
+        for_each_node(itr, 0, _func);
+}
+
+template <typename FuncT>
+void
+sampling_trie::for_each_node(size_t _idx, size_t _depth, FuncT& _func) const
+{
+    const auto& _node = m_nodes.at(_idx);
+    _func(*_node.name, _depth, _node.data);
+    for(auto itr : _node.order)
+        for_each_node(itr, _depth + 1, _func);
+}
+
+template <typename BundleT, typename FuncT>
+void
+sampling_trie::insert(int64_t _tid, FuncT&& _update) const
+{
+    for(auto itr : m_nodes.front().order)
+        insert_node<BundleT>(itr, _tid, _update);
+}
+
+template <typename BundleT, typename FuncT>
+void
+sampling_trie::insert_node(size_t _idx, int64_t _tid, FuncT& _update) const
+{
+    // the children are inserted while the bundle of their parent is on the call-stack
+    const auto& _node   = m_nodes.at(_idx);
+    auto        _bundle = BundleT{ tim::string_view_t{ *_node.name } };
+    _bundle.push(_tid);
+    _bundle.start();
+    for(auto itr : _node.order)
+        insert_node<BundleT>(itr, _tid, _update);
+    _update(_bundle, _node.data);
+    _bundle.pop();
+}
+
 void
 post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _timer_data,
                       const std::vector<overflow_sampling_data>& _overflow_data)
@@ -1373,166 +3495,616 @@ post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _tim
     OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                       "[%li] Post-processing data for timemory...\n", _tid);
 
-    // compute the total number of entries
-    int64_t _sum = 0;
+    // the samples are accumulated into the prefix trees of their call-stacks before
+    // they are inserted so the cost scales with the unique call-stack nodes
+    auto    _timer_trie    = sampling_trie{};
+    auto    _overflow_trie = sampling_trie{};
+    int64_t _sum           = 0;
+
     for(const auto& itr : _overflow_data)
+    {
+        _overflow_trie.add(itr.m_stack, itr);
         _sum += itr.m_stack.size();
+    }
+
     for(const auto& itr : _timer_data)
-        _sum += itr.m_stack.size();
+    {
+        _timer_trie.add(itr.m_stack, itr);
+        _sum += itr.m_weight * itr.m_stack.size();
+    }
 
-    for(const auto& itr : _overflow_data)
+    post_process_timemory(_tid, _timer_trie, _overflow_trie, _sum);
+}
+
+locking::atomic_mutex&
+get_streaming_mutex()
+{
+    static auto _v = locking::atomic_mutex{};
+    return _v;
+}
+
+void
+offload_buffer_streaming(int64_t _seq, sampler_buffer_t&& _buf)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _data     = std::move(_buf);
+    auto _raw_data = std::vector<sampler_bundle_t>{};
+    release_samples(_data.count());
+    _raw_data.reserve(_data.count());
+    while(!_data.is_empty())
     {
-        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock>;
+        auto _v = sampler_bundle_t{};
+        _data.read(&_v);
+        _raw_data.emplace_back(std::move(_v));
+    }
+    _data.destroy();
+    _buf.destroy();
+
+    auto _num_valid = post_process_streaming(_seq, _raw_data);
 
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
+    OMNITRACE_VERBOSE_F(2 || get_debug_sampling(),
+                        "[sampling] Streamed %zu of %zu samples for thread %li...\n",
+                        _num_valid, _raw_data.size(), _seq);
+}
+
+template <typename ContainerT>
+size_t
+post_process_streaming(int64_t _tid, ContainerT& _raw_data)
+{
+    auto& _state = streaming_state_instances::instance(construct_on_thread{ _tid });
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+    const auto* _init        = get_sampler_init(_tid).get();
+
+    _state->m_num_samples += _raw_data.size();
 
-        for(const auto& iitr : itr.m_stack)
+    if(!_state->m_init && _init)
+    {
+        _state->m_last = *_init;
+        _state->m_init = true;
+    }
+
+    if(!_thread_info || !_state->m_init) return 0;
+
+    // while running, the thread does not have a stop time yet
+    auto _is_valid_time = [&_thread_info](uint64_t _ts) {
+        return (_ts >= _thread_info->get_start() &&
+                (_thread_info->get_stop() == 0 || _ts <= _thread_info->get_stop()));
+    };
+
+    std::vector<sampling::bundle_t*> _data{};
+    for(auto& itr : _raw_data)
+    {
+        auto* _bt = itr.template get<backtrace>();
+        auto* _cc = itr.template get<callchain>();
+        auto* _ts = itr.template get<backtrace_timestamp>();
+        if(((_bt && !_bt->empty()) || (_cc && !_cc->empty())) && _ts &&
+           _is_valid_time(_ts->get_timestamp()))
         {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
+            _data.emplace_back(&itr);
         }
+    }
+
+    if(_data.empty()) return 0;
+
+    auto _timer_data    = post_process_timer_data(_tid, &_state->m_last, _data);
+    auto _overflow_data = post_process_overflow_data(_tid, _state->m_overflow, _data);
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
+    // the last timer sample provides the begin timestamp for the next buffer
+    for(auto itr = _data.rbegin(); itr != _data.rend(); ++itr)
+    {
+        auto* _bt_data = (*itr)->get<backtrace>();
+        auto* _bt_time = (*itr)->get<backtrace_timestamp>();
+        if(_bt_data && _bt_time && !_bt_data->empty() && _bt_time->get_tid() == _tid)
         {
-            auto& iitr = _data.at(_data.size() - i - 1);
-            iitr.stop();
-            if constexpr(tim::trait::is_available<sampling_wall_clock>::value)
-            {
-                auto* _sc = iitr.get<sampling_wall_clock>();
-                if(_sc)
-                {
-                    auto _value = static_cast<double>(itr.m_end - itr.m_beg) /
-                                  sampling_wall_clock::get_unit();
-                    _sc->set_value(_value);
-                    _sc->set_accum(_value);
-                }
-            }
-            iitr.pop();
+            _state->m_last = **itr;
+            break;
         }
     }
 
-    for(const auto& itr : _timer_data)
+    if(get_use_perfetto())
     {
-        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock,
-                                                sampling_cpu_clock, hw_counters>;
+        for(const auto& itr : _timer_data)
+            _state->m_valid_metrics |= itr.m_metrics.get_valid();
+
+        // perfetto track and string registration is shared between threads
+        auto _lk = locking::atomic_lock{ get_streaming_mutex() };
+        post_process_perfetto(_tid, _timer_data, _overflow_data, false);
+    }
+
+    // the snapshots accumulate the interval separately and merge it into the whole run
+    // when it is retired
+    const bool _snapshot = (get_sampling_snapshot_interval() > 0.0);
+    if(get_use_timemory() || _snapshot)
+    {
+        auto& _timer_trie = (_snapshot) ? _state->m_snapshot_timer : _state->m_timer_data;
+        auto& _overflow_trie =
+            (_snapshot) ? _state->m_snapshot_overflow : _state->m_overflow_data;
+        auto _lk = locking::atomic_lock{ _state->m_snapshot_mutex };
+
+        for(const auto& itr : _overflow_data)
+        {
+            _overflow_trie.add(itr.m_stack, itr);
+            _state->m_num_entries += itr.m_stack.size();
+        }
+
+        // the timer samples which are counted in the aggregated call-stack table
+        for(const auto& itr : _timer_data)
+        {
+            if(itr.m_aggregated) continue;
+
+            _timer_trie.add(itr.m_stack, itr);
+            _state->m_num_entries += itr.m_weight * itr.m_stack.size();
+        }
+    }
+
+    _state->m_num_valid += _data.size();
+    return _data.size();
+}
+
+size_t
+post_process_streaming_finalize(int64_t _tid)
+{
+    if(!streaming_state_instances::get()) return 0;
+
+    auto& _state = streaming_state_instances::get()->at(_tid);
+    if(!_state || _state->m_num_valid == 0) return 0;
+
+    if(get_use_perfetto() && trait::runtime_enabled<backtrace_metrics>::get())
+        backtrace_metrics::fini_perfetto(_tid, _state->m_valid_metrics);
+
+    if(get_use_timemory())
+        post_process_timemory(_tid, _state->m_timer_data, _state->m_overflow_data,
+                              _state->m_num_entries);
+
+    return _state->m_num_valid;
+}
+
+auto&
+get_snapshot_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_snapshot_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_snapshot_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_snapshot_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+// the wall-clock time (CLOCK_REALTIME) of the end of the previous snapshot
+auto&
+get_snapshot_begin()
+{
+    static auto _v = tim::get_clock_real_now<uint64_t, std::nano>();
+    return _v;
+}
+
+bool
+retire_snapshot(int64_t _tid, snapshot_thread& _out)
+{
+    if(!streaming_state_instances::get()) return false;
+
+    auto& _state = streaming_state_instances::get()->at(_tid);
+    if(!_state) return false;
+
+    // the offload of the next buffer only waits for the swap
+    _out.tid = _tid;
+    {
+        auto _lk = locking::atomic_lock{ _state->m_snapshot_mutex };
+        std::swap(_out.timer, _state->m_snapshot_timer);
+        std::swap(_out.overflow, _state->m_snapshot_overflow);
+    }
+
+    // the timemory output at finalization covers the whole run
+    if(get_use_timemory())
+    {
+        _state->m_timer_data.merge(_out.timer);
+        _state->m_overflow_data.merge(_out.overflow);
+    }
+
+    return (_out.timer.size() + _out.overflow.size()) > 0;
+}
+
+void
+write_snapshot_text(const std::string& _fname, size_t _index,
+                    const std::vector<snapshot_thread>& _data, uint64_t _beg,
+                    uint64_t _end)
+{
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+        OMNITRACE_THROW("Error opening sampling snapshot output file: %s",
+                        _fname.c_str());
+
+    ofs << std::setprecision(6) << std::fixed;
+    ofs << "snapshot " << _index << ": " << _beg << " - " << _end
+        << " ns (CLOCK_REALTIME), " << (static_cast<double>(_end - _beg) / units::sec)
+        << " sec\n\n";
+
+    auto _write = [&ofs](std::string_view _label, const sampling_trie& _trie) {
+        if(_trie.size() == 0) return;
+        ofs << "    " << _label << "\n"
+            << "    " << std::setw(12) << "SAMPLES" << std::setw(16) << "WALL (sec)"
+            << std::setw(16) << "CPU (sec)"
+            << "  LABEL\n";
+        _trie.for_each([&ofs](const std::string& _name, size_t _depth,
+                              const sampling_aggregate& _agg) {
+            ofs << "    " << std::setw(12) << _agg.m_count << std::setw(16)
+                << (_agg.m_wall / units::sec) << std::setw(16)
+                << ((_agg.m_use_cpu) ? (_agg.m_cpu / units::sec) : 0.0) << "  "
+                << std::string(2 * _depth, ' ') << "|_" << _name << "\n";
+        });
+    };
+
+    for(const auto& itr : _data)
+    {
+        ofs << "thread " << itr.tid << ":\n";
+        _write("timer samples", itr.timer);
+        _write("overflow samples", itr.overflow);
+        ofs << "\n";
+    }
+}
 
-        double _elapsed_wc = (itr.m_end - itr.m_beg);
+void
+write_snapshot_json(const std::string& _fname, size_t _index,
+                    const std::vector<snapshot_thread>& _data, uint64_t _beg,
+                    uint64_t _end)
+{
+    namespace cereal = tim::cereal;
 
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
+    auto ofs = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+        OMNITRACE_THROW("Error opening sampling snapshot output file: %s",
+                        _fname.c_str());
+
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(ofs);
+
+        auto _write = [&ar](const char* _label, const sampling_trie& _trie) {
+            ar->setNextName(_label);
+            ar->startNode();
+            ar->makeArray();
+            _trie.for_each([&ar](const std::string& _name, size_t _depth,
+                                 const sampling_aggregate& _agg) {
+                ar->startNode();
+                (*ar)(cereal::make_nvp("name", _name), cereal::make_nvp("depth", _depth),
+                      cereal::make_nvp("samples", _agg.m_count),
+                      cereal::make_nvp("wall_ns", _agg.m_wall));
+                if(_agg.m_use_cpu) (*ar)(cereal::make_nvp("cpu_ns", _agg.m_cpu));
+                ar->finishNode();
+            });
+            ar->finishNode();
+        };
 
-        // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("sampling_snapshot");
+        ar->startNode();
+        (*ar)(cereal::make_nvp("index", _index), cereal::make_nvp("begin_ns", _beg),
+              cereal::make_nvp("end_ns", _end));
+        ar->setNextName("threads");
+        ar->startNode();
+        ar->makeArray();
+        for(const auto& itr : _data)
         {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
+            ar->startNode();
+            (*ar)(cereal::make_nvp("thread", itr.tid));
+            _write("timer", itr.timer);
+            _write("overflow", itr.overflow);
+            ar->finishNode();
         }
+        ar->finishNode();
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    ofs << "\n";
+}
+
+// writes the call-graphs retired since the previous snapshot. Only invoked by the
+// snapshot thread and, once it is stopped, by the post-processing
+void
+write_snapshot(const std::vector<snapshot_thread>& _data)
+{
+    static size_t _index = 0;
+
+    auto  _end = tim::get_clock_real_now<uint64_t, std::nano>();
+    auto& _beg = get_snapshot_begin();
+    auto  _idx = _index++;
+
+    OMNITRACE_VERBOSE(1 || get_debug_sampling(),
+                      "[sampling] Writing snapshot %zu of the sampling profile (%zu "
+                      "threads, %.3f sec)...\n",
+                      _idx, _data.size(), static_cast<double>(_end - _beg) / units::sec);
+
+    auto _prefix = JOIN('-', "sampling-snapshot", _idx);
+    try
+    {
+        if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+            write_snapshot_text(tim::settings::compose_output_filename(_prefix, ".txt"),
+                                _idx, _data, _beg, _end);
+        if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+            write_snapshot_json(tim::settings::compose_output_filename(_prefix, ".json"),
+                                _idx, _data, _beg, _end);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "writing the sampling snapshot %zu failed: %s\n", _idx,
+                            _e.what());
+    }
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
+    _beg = _end;
+}
+
+void
+start_snapshot_thread()
+{
+    std::unique_lock<std::mutex> _lk{ get_snapshot_mutex() };
+    if(get_snapshot_thread() || get_sampling_snapshot_interval() <= 0.0) return;
+
+    auto _interval = std::chrono::nanoseconds{ static_cast<int64_t>(
+        get_sampling_snapshot_interval() * units::sec) };
+
+    auto _func = [_interval]() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.samp.snap");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        using clock_type = std::chrono::steady_clock;
+
+        auto _wake = clock_type::now();
+        while(get_snapshot_active().load())
         {
-            auto& iitr = _data.at(_data.size() - i - 1);
-            iitr.stop();
+            {
+                _wake += _interval;
+                std::unique_lock<std::mutex> _lk{ get_snapshot_mutex() };
+                if(get_snapshot_cv().wait_until(
+                       _lk, _wake, []() { return !get_snapshot_active().load(); }))
+                    break;
+            }
 
-            if constexpr(tim::trait::is_available<sampling_wall_clock>::value)
+            // the buffers are offloaded while the call-graphs are written
+            auto _data = std::vector<snapshot_thread>{};
+            for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
             {
-                auto* _sc = iitr.get<sampling_wall_clock>();
-                if(_sc)
-                {
-                    auto _value = _elapsed_wc / sampling_wall_clock::get_unit();
-                    _sc->set_value(_value);
-                    _sc->set_accum(_value);
-                }
+                auto _v = snapshot_thread{};
+                if(retire_snapshot(i, _v)) _data.emplace_back(std::move(_v));
             }
+            write_snapshot(_data);
+        }
+    };
 
-            const auto& _metrics = itr.m_metrics;
-            if constexpr(tim::trait::is_available<sampling_cpu_clock>::value)
+    OMNITRACE_VERBOSE(1, "[sampling] Writing a snapshot of the sampling profile every "
+                         "%.3f seconds...\n",
+                      get_sampling_snapshot_interval());
+
+    get_snapshot_begin() = tim::get_clock_real_now<uint64_t, std::nano>();
+    get_snapshot_active().store(true);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_snapshot_thread() = std::make_unique<std::thread>(_func);
+}
+
+void
+stop_snapshot_thread()
+{
+    if(!get_snapshot_thread()) return;
+
+    {
+        std::unique_lock<std::mutex> _lk{ get_snapshot_mutex() };
+        get_snapshot_active().store(false);
+        get_snapshot_cv().notify_all();
+    }
+    get_snapshot_thread()->join();
+    get_snapshot_thread().reset();
+}
+
+void
+post_process_timemory(int64_t _tid, const sampling_trie& _timer_data,
+                      const sampling_trie& _overflow_data, int64_t _sum)
+{
+    OMNITRACE_VERBOSE(3 || get_debug_sampling(),
+                      "[%li] Inserting %zu call-stack nodes into timemory...\n", _tid,
+                      _timer_data.size() + _overflow_data.size());
+
+    // each unique call-stack node is inserted once with the accumulated values and the
+    // number of samples as the number of laps
+    auto _set_count = [](auto& _bundle, size_t _count) {
+        auto  _laps = static_cast<int64_t>(_count);
+        auto* _tc   = _bundle.template get<comp::trip_count>();
+        if(_tc)
+        {
+            _tc->set_value(_laps);
+            _tc->set_accum(_laps);
+            _tc->set_laps(_laps);
+        }
+    };
+
+    auto _set_laps = [](auto* _obj, size_t _count) {
+        if(_obj) _obj->set_laps(static_cast<int64_t>(_count));
+    };
+
+    auto _set_wall = [](auto& _bundle, double _elapsed) {
+        if constexpr(tim::trait::is_available<sampling_wall_clock>::value)
+        {
+            auto* _sc = _bundle.template get<sampling_wall_clock>();
+            if(_sc)
             {
-                auto* _cc = iitr.get<sampling_cpu_clock>();
+                auto _value = _elapsed / sampling_wall_clock::get_unit();
+                _sc->set_value(_value);
+                _sc->set_accum(_value);
+            }
+        }
+    };
 
-                if(_cc && _metrics && _metrics(category::thread_cpu_time{}))
-                {
-                    double _elapsed_cc = _metrics.get_cpu_timestamp();
+    {
+        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock>;
+
+        _overflow_data.insert<bundle_t>(
+            _tid, [&](bundle_t& _bundle, const sampling_aggregate& _agg) {
+                _bundle.stop();
+                _set_count(_bundle, _agg.m_count);
+                _set_wall(_bundle, _agg.m_wall);
+                _set_laps(_bundle.get<sampling_wall_clock>(), _agg.m_count);
+            });
+    }
 
-                    _cc->set_value(_elapsed_cc / sampling_cpu_clock::get_unit());
-                    _cc->set_accum(_elapsed_cc / sampling_cpu_clock::get_unit());
+    {
+        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock,
+                                                sampling_cpu_clock, hw_counters>;
+
+        _timer_data.insert<bundle_t>(_tid, [&](bundle_t&                 _bundle,
+                                               const sampling_aggregate& _agg) {
+            _bundle.stop();
+            _set_count(_bundle, _agg.m_count);
+            _set_wall(_bundle, _agg.m_wall);
+            _set_laps(_bundle.get<sampling_wall_clock>(), _agg.m_count);
+            _set_laps(_bundle.get<sampling_cpu_clock>(), _agg.m_count);
+            _set_laps(_bundle.get<hw_counters>(), _agg.m_count);
+
+            if constexpr(tim::trait::is_available<sampling_cpu_clock>::value)
+            {
+                auto* _cc = _bundle.get<sampling_cpu_clock>();
+                if(_cc && _agg.m_use_cpu)
+                {
+                    _cc->set_value(_agg.m_cpu / sampling_cpu_clock::get_unit());
+                    _cc->set_accum(_agg.m_cpu / sampling_cpu_clock::get_unit());
                 }
             }
 
             if constexpr(tim::trait::is_available<hw_counters>::value)
             {
-                auto* _hw_counter = iitr.get<hw_counters>();
-
-                if(_hw_counter && _metrics &&
-                   _metrics(type_list<backtrace_metrics::hw_counters>{}) &&
-                   _metrics(category::thread_hardware_counter{}))
+                auto* _hw_counter = _bundle.get<hw_counters>();
+                if(_hw_counter && _agg.m_use_hw)
                 {
-                    _hw_counter->set_value(_metrics.get_hw_counters());
-                    _hw_counter->set_accum(_metrics.get_hw_counters());
+                    _hw_counter->set_value(_agg.m_hw);
+                    _hw_counter->set_accum(_agg.m_hw);
                 }
             }
-
-            iitr.pop();
-        }
+        });
     }
 
-    for(auto&& itr : _overflow_data)
+    for(const auto* _trie : { &_overflow_data, &_timer_data })
     {
         using bundle_t =
             tim::lightweight_tuple<sampling_percent, quirk::config<quirk::flat_scope>>;
 
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
+        _trie->insert<bundle_t>(
+            _tid, [_sum](bundle_t& _bundle, const sampling_aggregate& _agg) {
+                double _value = (static_cast<double>(_agg.m_count) / _sum) * 100.0;
+                _bundle.store(std::plus<double>{}, _value);
+                _bundle.stop();
+            });
+    }
+}
 
-        // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
-        {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
-        }
+std::vector<timer_sampling_data>
+post_process_perf_collector(int64_t _tid)
+{
+    auto _results = std::vector<timer_sampling_data>{};
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
-        {
-            auto&  iitr   = _data.at(_data.size() - i - 1);
-            double _value = (1.0 / _sum) * 100.0;
-            iitr.store(std::plus<double>{}, _value);
-            iitr.stop();
-            iitr.pop();
-        }
-    }
+    if(!perf_record_instances::get()) return _results;
 
-    for(auto&& itr : _timer_data)
+    auto& _records = perf_record_instances::get()->at(_tid);
+    if(!_records || _records->empty()) return _results;
+
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+    if(!_thread_info) return _results;
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "[%li] Post-processing %zu perf_event callchains...\n", _tid,
+                      _records->size());
+
+    std::sort(_records->begin(), _records->end());
+
+    // the first sample has no predecessor so it starts at the beginning of the thread
+    uint64_t _last_ts = _thread_info->get_start();
+    _results.reserve(_records->size());
+    for(const auto& itr : *_records)
     {
-        using bundle_t =
-            tim::lightweight_tuple<sampling_percent, quirk::config<quirk::flat_scope>>;
+        auto _beg = _last_ts;
+        _last_ts  = itr.timestamp;
+        if(itr.data.empty() || !_thread_info->is_valid_time(itr.timestamp)) continue;
 
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
+        auto _stack = get_symbol_table<true>().resolve(itr.data);
+        if(_stack.empty()) continue;
 
-        // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
-        {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
-        }
+        auto _ret    = timer_sampling_data{};
+        _ret.m_tid   = _tid;
+        _ret.m_beg   = std::max(_beg, _thread_info->get_start());
+        _ret.m_end   = itr.timestamp;
+        _ret.m_stack = std::move(_stack);
+        _results.emplace_back(std::move(_ret));
+    }
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
-        {
-            auto&  iitr   = _data.at(_data.size() - i - 1);
-            double _value = (1.0 / _sum) * 100.0;
-            iitr.store(std::plus<double>{}, _value);
-            iitr.stop();
-            iitr.pop();
-        }
+    _records.reset();
+
+    return _results;
+}
+
+void
+post_process_stack_table(int64_t _tid)
+{
+    auto& _table = backtrace::get_stack_table(_tid);
+    if(!_table || _table->size() == 0) return;
+
+    if(_table->dropped() > 0)
+    {
+        OMNITRACE_WARNING_F(0,
+                            "[sampling] %zu samples on thread %li were stored "
+                            "individually because the call-stack table (size=%zu) was "
+                            "full. Increase OMNITRACE_SAMPLING_AGGREGATE_TABLE_SIZE\n",
+                            _table->dropped(), _tid, _table->capacity());
     }
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "Sampler data for thread %li has %zu unique call-stacks...\n", _tid,
+                      _table->size());
+
+    // different call-stacks may be identical after they are filtered so the entries are
+    // merged by name
+    auto    _timer_data  = sampling_trie{};
+    int64_t _num_entries = 0;
+    for(const auto& itr : _table->get())
+    {
+        if(itr.count == 0) continue;
+
+        auto _stack = get_symbol_table<false>().resolve(itr.data, {}, itr.count);
+        if(_stack.empty()) continue;
+
+        _num_entries += itr.count * _stack.size();
+
+        auto _agg      = sampling_aggregate{};
+        _agg.m_count   = itr.count;
+        _agg.m_wall    = itr.elapsed;
+        _agg.m_cpu     = itr.cpu;
+        _agg.m_use_cpu = itr.use_cpu;
+        _agg.m_use_hw  = itr.use_hw;
+        for(size_t i = 0; i < _agg.m_hw.size() && i < itr.hw.size(); ++i)
+            _agg.m_hw[i] = itr.hw[i];
+        _timer_data.add(_stack, _agg);
+    }
+
+    post_process_timemory(_tid, _timer_data, sampling_trie{}, _num_entries);
+
+    _table.reset();
 }
 
 struct sampling_initialization
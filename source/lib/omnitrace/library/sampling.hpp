@@ -30,15 +30,20 @@
 #include "library/components/backtrace_metrics.hpp"
 #include "library/components/backtrace_timestamp.hpp"
 #include "library/components/callchain.hpp"
+#include "library/raw_output.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/macros/language.hpp>
+#include <timemory/unwind/processed_entry.hpp>
 #include <timemory/variadic/types.hpp>
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <set>
 #include <type_traits>
+#include <vector>
 
 namespace omnitrace
 {
@@ -53,6 +58,11 @@ setup();
 std::set<int>
 shutdown();
 
+/// accounts a sample stored in the buffer of the sampler for the memory footprint.
+/// Invoked from the signal handler
+void
+track_sample();
+
 void
 block_samples();
 
@@ -65,5 +75,16 @@ void unblock_signals(std::set<int> = {});
 
 void
 post_process();
+
+/// symbolizes an instruction pointer of a raw output
+using raw_lookup_t =
+    std::function<std::optional<tim::unwind::processed_entry>(uintptr_t)>;
+
+/// emits the samples of a thread of a raw output (see raw_output) to perfetto and
+/// timemory like the samples of the application. The instruction pointers are
+/// symbolized by the lookup. Used by omnitrace-process
+void
+post_process_raw(const raw_output::thread_entry&, const std::vector<raw_output::sample>&,
+                 const raw_lookup_t&);
 }  // namespace sampling
 }  // namespace omnitrace
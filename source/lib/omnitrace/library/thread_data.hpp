@@ -25,6 +25,7 @@
 #include "core/common.hpp"
 #include "core/concepts.hpp"
 #include "core/config.hpp"
+#include "core/containers/lifo_arena.hpp"
 #include "core/containers/stable_vector.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
@@ -51,9 +52,8 @@ using instrumentation_bundle_t =
     tim::component_bundle<project::omnitrace, comp::wall_clock*,
                           comp::user_global_bundle*>;
 
-// allocator for instrumentation_bundle_t
-using bundle_allocator_t = tim::data::ring_buffer_allocator<instrumentation_bundle_t>;
-
+// functors which increase the size of every thread_data instance to at least the
+// given number of threads (see grow_data). Returns the new size
 using grow_functor_t = int64_t (*)(int64_t);
 
 inline auto&
@@ -70,12 +70,8 @@ struct base_thread_data
     {
         auto _func = [](int64_t _sz) -> int64_t {
             decltype(auto) _v = Tp::private_instance();
-            if(_v && _v->capacity() < static_cast<size_t>(_sz + 1))
-            {
-                _v->reserve(_v->capacity() + 1);
-                _v->resize(_v->capacity());
-            }
-            return (_v) ? _v->capacity() : 0;
+            if(_v && _v->size() < static_cast<size_t>(_sz)) _v->resize(_sz);
+            return (_v) ? _v->size() : 0;
         };
         grow_functors().emplace_back(std::move(_func));
     }
@@ -375,11 +371,8 @@ thread_data<std::optional<Tp>, Tag, MaxThreads>::construct(construct_on_thread&&
     static auto _grow = []() {
         container::resize(_constructed, MaxThreads, false);
         grow_functors().emplace_back([](int64_t _n) -> int64_t {
-            if(static_cast<size_t>(_n) >= _constructed.size())
-            {
-                _constructed.reserve(_constructed.capacity() + 1);
-                container::resize(_constructed, _constructed.capacity(), false);
-            }
+            if(_constructed.size() < static_cast<size_t>(_n))
+                container::resize(_constructed, _n, false);
             return _constructed.size();
         });
         return true;
@@ -543,11 +536,8 @@ thread_data<identity<Tp>, Tag, MaxThreads>::construct(construct_on_thread&& _t,
     static auto _grow = []() {
         container::resize(_constructed, MaxThreads, false);
         grow_functors().emplace_back([](int64_t _n) -> int64_t {
-            if(static_cast<size_t>(_n) >= _constructed.size())
-            {
-                _constructed.reserve(_constructed.capacity() + 1);
-                container::resize(_constructed, _constructed.capacity(), false);
-            }
+            if(_constructed.size() < static_cast<size_t>(_n))
+                container::resize(_constructed, _n, false);
             return _constructed.size();
         });
         return true;
@@ -576,15 +566,18 @@ thread_data<identity<Tp>, Tag, MaxThreads>::instance(construct_on_thread&& _t,
 //--------------------------------------------------------------------------------------//
 
 // there are currently some strange things that happen with
-// vector<instrumentation_bundle_t> so using vector<instrumentation_bundle_t*> and
-// timemory's ring_buffer_allocator to create contiguous memory-page aligned instances of
-// the bundle
+// vector<instrumentation_bundle_t> so using vector<instrumentation_bundle_t*>. The
+// bundles are nested like the regions so they are constructed in a per-thread LIFO
+// arena: the storage is contiguous and, once the peak depth was reached, pushing and
+// popping a region does not call the allocator. Since the arena reuses the slot of a
+// popped bundle, every bundle is also given a serial number which is never reused by
+// the thread so that a stale reference to a slot is detected
 template <typename... Tp>
 struct component_bundle_cache_impl
 {
     using this_type      = component_bundle_cache_impl<Tp...>;
     using bundle_type    = tim::component_bundle<project::omnitrace, Tp...>;
-    using allocator_type = tim::data::ring_buffer_allocator<bundle_type>;
+    using arena_type     = container::lifo_arena<bundle_type>;
     using array_type     = std::vector<bundle_type*>;
 
     using iterator         = typename array_type::iterator;
@@ -623,27 +616,29 @@ struct component_bundle_cache_impl
     auto&       at(size_t _idx) { return m_bundles.at(_idx); }
     const auto& at(size_t _idx) const { return m_bundles.at(_idx); }
 
+    uint64_t serial(size_t _idx) const { return m_serials.at(_idx); }
+    bool     owns(const bundle_type* _v) const { return m_arena.owns(_v); }
+
     template <typename... Args>
     bundle_type* construct(Args&&... args)
     {
-        bundle_type* _v = m_allocator.allocate(1);
-        m_allocator.construct(_v, std::forward<Args>(args)...);
+        auto* _v = new(m_arena.allocate()) bundle_type(std::forward<Args>(args)...);
+        m_serials.emplace_back(++m_serial);
         return m_bundles.emplace_back(_v);
     }
 
     void destroy(bundle_type* _v, size_t _idx)
     {
-        m_allocator.destroy(_v);
-        m_allocator.deallocate(_v, 1);
+        release(_v);
         m_bundles.erase(m_bundles.begin() + _idx);
+        m_serials.erase(m_serials.begin() + _idx);
     }
 
     void pop_back()
     {
-        bundle_type* _v = m_bundles.back();
-        m_allocator.destroy(_v);
-        m_allocator.deallocate(_v, 1);
+        release(m_bundles.back());
         m_bundles.pop_back();
+        m_serials.pop_back();
     }
 
     template <typename IterT>
@@ -660,14 +655,22 @@ struct component_bundle_cache_impl
             if(_v == end()) return;
             itr = _v;
         }
-        m_allocator.destroy(*itr);
-        m_allocator.deallocate(*itr, 1);
+        release(*itr);
+        m_serials.erase(m_serials.begin() + std::distance(begin(), itr));
         m_bundles.erase(itr);
     }
 
 private:
-    allocator_type m_allocator = {};
-    array_type     m_bundles   = {};
+    void release(bundle_type* _v)
+    {
+        _v->~bundle_type();
+        m_arena.deallocate(_v);
+    }
+
+    uint64_t              m_serial  = 0;
+    arena_type            m_arena   = {};
+    array_type            m_bundles = {};
+    std::vector<uint64_t> m_serials = {};
 };
 
 template <typename... Tp>
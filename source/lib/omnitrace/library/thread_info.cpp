@@ -26,6 +26,7 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/state.hpp"
+#include "core/tsc.hpp"
 #include "core/utility.hpp"
 #include "library/causal/delay.hpp"
 #include "library/runtime.hpp"
@@ -35,6 +36,11 @@
 #include <timemory/components/timing/backends.hpp>
 #include <timemory/process/threading.hpp>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
 namespace omnitrace
 {
 namespace
@@ -105,8 +111,156 @@ init_index_data(int64_t _tid, bool _offset = false)
     return itr;
 }
 
-const auto unknown_thread   = std::optional<thread_info>{};
-int64_t    peak_num_threads = max_supported_threads;
+const auto           unknown_thread   = std::optional<thread_info>{};
+std::atomic<int64_t> peak_num_threads = { max_supported_threads };
+
+// lock-free open-addressing index from a thread identifier to the internal index of
+// the thread_info so that the lookups by thread identifier do not search every
+// thread_info. A key is never removed but its value is cleared when the identifier
+// may be reused by another thread. When the table is full, the keys which could
+// not be inserted are found via a linear search of the thread_info
+struct thread_index_table
+{
+    static constexpr size_t capacity = 4 * max_supported_threads;
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of 2");
+
+    struct entry
+    {
+        std::atomic<uint64_t> key   = {};  // identifier + 1, zero when unused
+        std::atomic<int64_t>  value = {};  // internal index + 1, zero when cleared
+    };
+
+    // returns the internal index, -1 if the identifier is not indexed, or -2 if it
+    // was not found but may be present in the thread_info
+    int64_t find(uint64_t _id) const
+    {
+        auto _key = _id + 1;
+        if(_key == 0) return -2;
+        for(size_t i = 0; i < capacity; ++i)
+        {
+            const auto& _entry = m_entries[slot(_key, i)];
+            auto        _cur   = _entry.key.load(std::memory_order_acquire);
+            if(_cur == _key) return _entry.value.load(std::memory_order_acquire) - 1;
+            if(_cur == 0) break;
+        }
+        return (m_overflow.load(std::memory_order_relaxed)) ? -2 : -1;
+    }
+
+    void insert(uint64_t _id, int64_t _index)
+    {
+        auto _key = _id + 1;
+        for(size_t i = 0; _key != 0 && i < capacity; ++i)
+        {
+            auto& _entry = m_entries[slot(_key, i)];
+            auto  _cur   = _entry.key.load(std::memory_order_acquire);
+            if(_cur == 0)
+                _entry.key.compare_exchange_strong(_cur, _key, std::memory_order_acq_rel);
+            if(_cur != 0 && _cur != _key) continue;
+            _entry.value.store(_index + 1, std::memory_order_release);
+            return;
+        }
+        m_overflow.store(true, std::memory_order_relaxed);
+    }
+
+    // clears the value unless the identifier has been reassigned to another thread
+    void erase(uint64_t _id, int64_t _index)
+    {
+        auto _key = _id + 1;
+        for(size_t i = 0; _key != 0 && i < capacity; ++i)
+        {
+            auto& _entry = m_entries[slot(_key, i)];
+            auto  _cur   = _entry.key.load(std::memory_order_acquire);
+            if(_cur == 0) return;
+            if(_cur != _key) continue;
+            auto _value = _index + 1;
+            _entry.value.compare_exchange_strong(_value, 0, std::memory_order_acq_rel);
+            return;
+        }
+    }
+
+private:
+    static size_t slot(uint64_t _key, size_t _n)
+    {
+        // the handles are addresses so the low bits of the key are not used directly
+        return (((_key * 0x9E3779B97F4A7C15ULL) >> 32) + _n) & (capacity - 1);
+    }
+
+    std::atomic<bool>           m_overflow = {};
+    std::array<entry, capacity> m_entries  = {};
+};
+
+template <ThreadIdType IdT>
+auto&
+get_index_table()
+{
+    static auto _v = thread_index_table{};
+    return _v;
+}
+
+uint64_t
+get_index_key(int64_t _tid)
+{
+    return static_cast<uint64_t>(_tid);
+}
+
+uint64_t
+get_index_key(std::thread::id _tid)
+{
+    return std::hash<std::thread::id>{}(_tid);
+}
+
+uint64_t
+get_index_key(pthread_t _tid)
+{
+    return static_cast<uint64_t>(_tid);
+}
+
+// the pthread and std::thread identifiers are reused after a thread exits whereas
+// the system and sequent values remain valid for the thread_info of exited threads
+void
+insert_index_keys(const thread_index_data& _data)
+{
+    auto _idx = _data.internal_value;
+    get_index_table<SystemTID>().insert(get_index_key(_data.system_value), _idx);
+    get_index_table<SequentTID>().insert(get_index_key(_data.sequent_value), _idx);
+    get_index_table<PthreadID>().insert(get_index_key(_data.pthread_value), _idx);
+    get_index_table<StlThreadID>().insert(get_index_key(_data.stl_value), _idx);
+}
+
+void
+erase_index_keys(const thread_index_data& _data)
+{
+    auto _idx = _data.internal_value;
+    get_index_table<PthreadID>().erase(get_index_key(_data.pthread_value), _idx);
+    get_index_table<StlThreadID>().erase(get_index_key(_data.stl_value), _idx);
+}
+
+// looks up the thread_info via the index table of the identifier type and falls
+// back to searching all the thread_info when the table is full
+template <ThreadIdType IdT, typename Tp, typename PredT>
+const std::optional<thread_info>&
+find_thread_info(Tp _tid, PredT&& _pred)
+{
+    const auto& _v = get_info_data();
+    if(!_v) return unknown_thread;
+
+    auto _idx = get_index_table<IdT>().find(get_index_key(_tid));
+    if(_idx >= 0 && static_cast<size_t>(_idx) < _v->size())
+    {
+        const auto& itr = _v->at(_idx);
+        if(itr && itr->index_data && _pred(*itr->index_data)) return itr;
+    }
+    else if(_idx == -1)
+    {
+        return unknown_thread;
+    }
+
+    for(const auto& itr : *_v)
+    {
+        if(itr && itr->index_data && _pred(*itr->index_data)) return itr;
+    }
+    return unknown_thread;
+}
 }  // namespace
 
 std::string
@@ -124,34 +278,36 @@ grow_data(int64_t _tid)
     struct data_growth
     {};
 
-    if(_tid >= peak_num_threads)
+    if(_tid >= peak_num_threads.load(std::memory_order_acquire))
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         auto_lock_t _lk{ type_mutex<data_growth>() };
 
         // check again after locking
-        if(_tid >= peak_num_threads)
+        auto _peak = peak_num_threads.load(std::memory_order_relaxed);
+        if(_tid >= _peak)
         {
-            TIMEMORY_PRINTF_WARNING(
-                stderr, "[%li] Growing thread data from %li to %li...\n", _tid,
-                peak_num_threads, peak_num_threads + max_supported_threads);
+            // the capacity is doubled so that the number of passes over the grow
+            // functors is logarithmic in the number of threads. The existing data is
+            // not relocated so the other threads are not blocked
+            auto _new_peak = _peak;
+            while(_new_peak <= _tid)
+                _new_peak *= 2;
+
+            TIMEMORY_PRINTF_WARNING(stderr,
+                                    "[%li] Growing thread data from %li to %li...\n",
+                                    _tid, _peak, _new_peak);
             fflush(stderr);
 
             for(auto itr : grow_functors())
             {
-                if(itr)
-                {
-                    int64_t _new_capacity = (*itr)(_tid + 1);
-                    TIMEMORY_PRINTF_WARNING(stderr,
-                                            "[%li] Grew thread data from %li to %li...\n",
-                                            _tid, peak_num_threads, _new_capacity);
-                }
+                if(itr) (*itr)(_new_peak);
             }
-            peak_num_threads += max_supported_threads;
+            peak_num_threads.store(_new_peak, std::memory_order_release);
         }
     }
 
-    return peak_num_threads;
+    return peak_num_threads.load(std::memory_order_acquire);
 }
 
 bool
@@ -163,7 +319,7 @@ thread_info::exists()
 size_t
 thread_info::get_peak_num_threads()
 {
-    return peak_num_threads;
+    return peak_num_threads.load(std::memory_order_acquire);
 }
 
 const std::optional<thread_info>&
@@ -188,8 +344,16 @@ thread_info::init(bool _offset)
         _info->is_offset      = threading::offset_this_id();
         _info->index_data     = init_index_data(_tid, _info->is_offset);
         _info->causal_count   = &causal::delay::get_local();
-        _info->lifetime.first = tim::get_clock_real_now<uint64_t, std::nano>();
+        _info->lifetime.first = tsc::get_clock_real_now();
         if(_info->is_offset) set_thread_state(ThreadState::Disabled);
+
+        insert_index_keys(*_info->index_data);
+        // the index tables are trivially destructible so this is safe after the
+        // static destructors have run
+        static thread_local auto _index_dtor = scope::destructor{
+            [_data = *_info->index_data]() { erase_index_keys(_data); }
+        };
+        (void) _index_dtor;
     }
 
     return _info_data->at(_tid);
@@ -215,35 +379,22 @@ thread_info::get(native_handle_t& _tid)
 const std::optional<thread_info>&
 thread_info::get(native_handle_t&& _tid)
 {
-    const auto& _v = get_info_data();
-    if(_v)
-    {
-        for(const auto& itr : *_v)
-        {
-            if(itr && itr->index_data &&
-               pthread_equal(itr->index_data->pthread_value, _tid) == 0)
-                return itr;
-        }
-    }
+    const auto& _v = find_thread_info<PthreadID>(_tid, [_tid](const auto& _data) {
+        return pthread_equal(_data.pthread_value, _tid) != 0;
+    });
 
     OMNITRACE_CI_THROW(unknown_thread, "Unknown thread has been assigned a value");
-    return unknown_thread;
+    return _v;
 }
 
 const std::optional<thread_info>&
 thread_info::get(std::thread::id _tid)
 {
-    const auto& _v = get_info_data();
-    if(_v)
-    {
-        for(const auto& itr : *_v)
-        {
-            if(itr && itr->index_data && itr->index_data->stl_value == _tid) return itr;
-        }
-    }
+    const auto& _v = find_thread_info<StlThreadID>(
+        _tid, [_tid](const auto& _data) { return _data.stl_value == _tid; });
 
     OMNITRACE_CI_THROW(unknown_thread, "Unknown thread has been assigned a value");
-    return unknown_thread;
+    return _v;
 }
 
 const std::optional<thread_info>&
@@ -253,27 +404,15 @@ thread_info::get(int64_t _tid, ThreadIdType _type)
         return get_info_data(_tid);
     else if(_type == ThreadIdType::SystemTID)
     {
-        const auto& _v = get_info_data();
-        if(_v)
-        {
-            for(const auto& itr : *_v)
-            {
-                if(itr && itr->index_data && itr->index_data->system_value == _tid)
-                    return itr;
-            }
-        }
+        const auto& _v = find_thread_info<SystemTID>(
+            _tid, [_tid](const auto& _data) { return _data.system_value == _tid; });
+        if(_v) return _v;
     }
     else if(_type == ThreadIdType::SequentTID)
     {
-        const auto& _v = get_info_data();
-        if(_v)
-        {
-            for(const auto& itr : *_v)
-            {
-                if(itr && itr->index_data && itr->index_data->sequent_value == _tid)
-                    return itr;
-            }
-        }
+        const auto& _v = find_thread_info<SequentTID>(
+            _tid, [_tid](const auto& _data) { return _data.sequent_value == _tid; });
+        if(_v) return _v;
     }
     else if(_type == ThreadIdType::PthreadID)
     {
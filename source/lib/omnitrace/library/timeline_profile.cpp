@@ -0,0 +1,267 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/timeline_profile.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace timeline_profile
+{
+namespace
+{
+struct instance_record
+{
+    uint64_t hash  = 0;
+    uint64_t start = 0;
+    uint64_t stop  = 0;  // zero while the instance is open
+    uint32_t depth = 0;
+};
+
+static_assert(sizeof(instance_record) == 32, "the records should be 32 bytes");
+
+// only accessed by the owning thread until finalization. The records are appended to
+// fixed-size chunks so appending never copies the previous records
+struct thread_timeline
+{
+    static constexpr size_t chunk_size = 4096;
+
+    using chunk_t = std::array<instance_record, chunk_size>;
+
+    instance_record& at(size_t _idx)
+    {
+        return (*chunks[_idx / chunk_size])[_idx % chunk_size];
+    }
+
+    size_t                                size   = 0;
+    std::vector<std::unique_ptr<chunk_t>> chunks = {};
+    std::vector<size_t>                   open   = {};  // the open instances
+};
+
+using thread_timeline_data = omnitrace::thread_data<thread_timeline, thread_timeline>;
+
+std::once_flag post_process_once{};
+
+auto&
+get_thread_timeline(int64_t _tid = tim::threading::get_id())
+{
+    return thread_timeline_data::instance(construct_on_thread{ _tid });
+}
+
+// the name of the records used in the file output messages
+struct timeline_records
+{};
+
+void
+write_text(const thread_timeline_data::array_type& _data, uint64_t _origin)
+{
+    auto _fname = tim::settings::compose_output_filename("timeline-profile", ".txt");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening timeline-profile output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<timeline_records>{}(
+            _fname, std::string{ "timeline-profile" });
+
+    ofs << std::setprecision(6) << std::fixed;
+    for(size_t i = 0; i < _data.size(); ++i)
+    {
+        const auto& _thread = _data.at(i);
+        if(!_thread || _thread->size == 0) continue;
+
+        ofs << "thread " << i << ": " << _thread->size << " instances\n"
+            << "    " << std::setw(16) << "START (sec)" << std::setw(16) << "WALL (sec)"
+            << "  LABEL\n";
+        for(size_t j = 0; j < _thread->size; ++j)
+        {
+            const auto& itr    = _thread->at(j);
+            auto        _start = static_cast<double>(itr.start - _origin) / units::sec;
+            auto        _wall  = static_cast<double>(itr.stop - itr.start) / units::sec;
+            ofs << "    " << std::setw(16) << _start << std::setw(16) << _wall << "  "
+                << std::string(2 * itr.depth, ' ') << "|_"
+                << tim::get_hash_identifier_fast(itr.hash) << "\n";
+        }
+        ofs << "\n";
+    }
+}
+
+// the archive writes to the file as the records are saved so the output of millions of
+// instances is never held in memory
+void
+write_json(const thread_timeline_data::array_type& _data)
+{
+    namespace cereal = tim::cereal;
+
+    auto _fname = tim::settings::compose_output_filename("timeline-profile", ".json");
+    auto ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening timeline-profile output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<timeline_records>{}(
+            _fname, std::string{ "timeline-profile" });
+
+    {
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(ofs);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        ar->setNextName("timeline_profile");
+        ar->startNode();
+        ar->makeArray();
+        for(size_t i = 0; i < _data.size(); ++i)
+        {
+            const auto& _thread = _data.at(i);
+            if(!_thread || _thread->size == 0) continue;
+
+            ar->startNode();
+            (*ar)(cereal::make_nvp("thread", i));
+            ar->setNextName("instances");
+            ar->startNode();
+            ar->makeArray();
+            for(size_t j = 0; j < _thread->size; ++j)
+            {
+                const auto& itr = _thread->at(j);
+                ar->startNode();
+                (*ar)(cereal::make_nvp(
+                          "name", std::string{ tim::get_hash_identifier_fast(itr.hash) }),
+                      cereal::make_nvp("depth", itr.depth),
+                      cereal::make_nvp("start_ns", itr.start),
+                      cereal::make_nvp("stop_ns", itr.stop));
+                ar->finishNode();
+            }
+            ar->finishNode();
+            ar->finishNode();
+        }
+        ar->finishNode();
+        ar->finishNode();
+    }
+
+    ofs << "\n";
+}
+}  // namespace
+
+void
+push(uint64_t _hash)
+{
+    static thread_local auto* _data = get_thread_timeline().get();
+
+    auto _idx = _data->size;
+    if(_idx / thread_timeline::chunk_size == _data->chunks.size())
+        _data->chunks.emplace_back(std::make_unique<thread_timeline::chunk_t>());
+
+    _data->at(_idx) = instance_record{ _hash, tracing::now<uint64_t>(), 0,
+                                       static_cast<uint32_t>(_data->open.size()) };
+    _data->open.emplace_back(_idx);
+    ++_data->size;
+}
+
+bool
+pop(uint64_t _hash)
+{
+    static thread_local auto* _data = get_thread_timeline().get();
+
+    auto& _open = _data->open;
+    for(size_t i = _open.size(); i > 0; --i)
+    {
+        auto& itr = _data->at(_open[i - 1]);
+        if(itr.hash != _hash) continue;
+
+        itr.stop = tracing::now<uint64_t>();
+        _open.erase(_open.begin() + (i - 1));
+        return true;
+    }
+    return false;
+}
+
+void
+post_process()
+{
+    if(!config::get_timeline_profile_compact()) return;
+
+    std::call_once(post_process_once, []() {
+        auto* _instances = thread_timeline_data::get();
+        if(!_instances) return;
+
+        // the instances which are still open end at finalization
+        auto   _now    = tracing::now<uint64_t>();
+        auto   _origin = _now;
+        size_t _count  = 0;
+        for(auto& itr : *_instances)
+        {
+            if(!itr) continue;
+            for(auto oitr : itr->open)
+                itr->at(oitr).stop = _now;
+            itr->open.clear();
+            if(itr->size > 0) _origin = std::min(_origin, itr->at(0).start);
+            _count += itr->size;
+        }
+
+        if(_count == 0) return;
+
+        OMNITRACE_VERBOSE_F(1, "Writing %zu timeline profile instances...\n", _count);
+
+        try
+        {
+            if(config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true))
+                write_text(*_instances, _origin);
+            if(config::get_setting_value<bool>("OMNITRACE_JSON_OUTPUT").value_or(true))
+                write_json(*_instances);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "writing the timeline profile failed: %s\n",
+                                _e.what());
+        }
+    });
+}
+}  // namespace timeline_profile
+}  // namespace omnitrace
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace omnitrace
+{
+/// compact storage of the timeline profile (see OMNITRACE_TIMELINE_PROFILE_COMPACT).
+/// With OMNITRACE_TIMELINE_PROFILE=ON, timemory creates a call-graph node for every
+/// instance of a region, which does not scale to iterative codes. Instead, each
+/// instance of a region pushed through category_region is appended as a 32-byte
+/// record (hash, start, stop, depth) to chunked arrays of the calling thread and the
+/// records are written to timeline-profile.{txt,json} at finalization. Only the
+/// wall-clock time of the instances is recorded
+namespace timeline_profile
+{
+/// opens an instance of the region on the calling thread
+void
+push(uint64_t _hash);
+
+/// closes the innermost open instance of the region on the calling thread. Returns
+/// false if the region is not open on the thread
+bool
+pop(uint64_t _hash);
+
+/// writes the records of every thread
+void
+post_process();
+}  // namespace timeline_profile
+}  // namespace omnitrace
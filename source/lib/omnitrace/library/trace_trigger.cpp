@@ -0,0 +1,589 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/trace_trigger.hpp"
+#include "core/categories.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/constraint.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "core/tsc.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/utility/delimit.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace trace_trigger
+{
+namespace
+{
+enum class trigger_type
+{
+    region = 0,
+    kernel,
+    memory,
+};
+
+// the window of a region or kernel trigger is open while remaining is non-zero. The
+// counts are updated without the lock and the window is opened and closed with it
+struct trigger
+{
+    trigger_type          type      = trigger_type::region;
+    std::string           spec      = {};
+    std::string           name      = {};
+    uint64_t              first     = 1;
+    uint64_t              length    = 1;
+    uint64_t              threshold = 0;
+    std::atomic<uint64_t> count     = { 0 };
+    std::atomic<uint64_t> remaining = { 0 };
+    std::atomic<bool>     above     = { false };
+};
+
+// the bits of the enabled categories. Only modified by setup()
+uint64_t&
+get_category_mask()
+{
+    static uint64_t _v = 0;
+    return _v;
+}
+
+// intentionally leaked. Only modified by setup() so the hooks read it without the lock
+auto&
+get_triggers()
+{
+    static auto* _v = new std::deque<trigger>{};
+    return *_v;
+}
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+// the number of open windows. Requires the mutex
+size_t&
+get_open_windows()
+{
+    static size_t _v = 0;
+    return _v;
+}
+
+// requires the mutex
+void
+open_window(const trigger& _trigger)
+{
+    OMNITRACE_VERBOSE_F(1, "Opening the trace window of '%s'...\n",
+                        _trigger.spec.c_str());
+    if(get_open_windows()++ == 0 && get_state() < State::Finalized)
+        categories::enable_categories(get_category_mask());
+}
+
+// requires the mutex. The categories are not disabled during the finalization since
+// it would disable the output of their data
+void
+close_window(const trigger& _trigger)
+{
+    OMNITRACE_VERBOSE_F(1, "Closing the trace window of '%s'...\n",
+                        _trigger.spec.c_str());
+    if(--get_open_windows() == 0 && get_state() < State::Finalized)
+        categories::disable_categories(get_category_mask());
+}
+
+// counts down the remaining events of the open window of the trigger
+void
+advance_window(trigger& _trigger)
+{
+    if(_trigger.remaining.load(std::memory_order_relaxed) == 0) return;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    if(_trigger.remaining > 0 && --_trigger.remaining == 0) close_window(_trigger);
+}
+
+// counts the event and opens the window of the trigger at the first-th event
+void
+count_event(trigger& _trigger)
+{
+    if(_trigger.count.fetch_add(1, std::memory_order_relaxed) + 1 != _trigger.first)
+        return;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    _trigger.remaining = _trigger.length;
+    open_window(_trigger);
+}
+
+std::string_view
+trim(std::string_view _v)
+{
+    auto _beg = _v.find_first_not_of(" \t");
+    if(_beg == std::string_view::npos) return std::string_view{};
+    auto _end = _v.find_last_not_of(" \t");
+    return _v.substr(_beg, _end - _beg + 1);
+}
+
+bool
+parse_number(std::string_view _v, uint64_t& _value)
+{
+    _v = trim(_v);
+    if(_v.empty() || !std::isdigit(_v.front())) return false;
+    try
+    {
+        size_t _n = 0;
+        _value    = std::stoull(std::string{ _v }, &_n);
+        _v        = _v.substr(_n);
+    } catch(std::exception&)
+    {
+        return false;
+    }
+
+    if(_v.empty()) return true;
+    if(_v.size() > 1) return false;
+
+    switch(std::toupper(_v.front()))
+    {
+        case 'K': _value <<= 10; break;
+        case 'M': _value <<= 20; break;
+        case 'G': _value <<= 30; break;
+        default: return false;
+    }
+    return true;
+}
+
+// region=NAME@N[+M], kernel=NAME@N[+M] or hip_memory>BYTES
+bool
+parse_trigger(std::string_view _v, trigger& _trigger)
+{
+    constexpr auto npos = std::string_view::npos;
+
+    _trigger.spec = std::string{ _v };
+
+    constexpr auto memory_prefix = std::string_view{ "hip_memory>" };
+    if(_v.substr(0, memory_prefix.size()) == memory_prefix)
+    {
+        _trigger.type = trigger_type::memory;
+        return parse_number(_v.substr(memory_prefix.size()), _trigger.threshold);
+    }
+
+    // the name may contain '@' so the count follows the last one
+    auto _eq = _v.find('=');
+    auto _at = _v.rfind('@');
+    if(_eq == npos || _at == npos || _at <= _eq + 1) return false;
+
+    auto _type = trim(_v.substr(0, _eq));
+    if(_type == "region")
+        _trigger.type = trigger_type::region;
+    else if(_type == "kernel")
+        _trigger.type = trigger_type::kernel;
+    else
+        return false;
+
+    _trigger.name = std::string{ _v.substr(_eq + 1, _at - _eq - 1) };
+
+    auto _count = _v.substr(_at + 1);
+    auto _plus  = _count.find('+');
+    if(!parse_number(_count.substr(0, _plus), _trigger.first)) return false;
+    if(_plus != npos && !parse_number(_count.substr(_plus + 1), _trigger.length))
+        return false;
+
+    return _trigger.first > 0 && _trigger.length > 0;
+}
+
+// a region of the primary thread which may be the iterative phase. The signature of an
+// iteration is its duration and the number of regions entered within it
+struct phase_candidate
+{
+    std::string name   = {};
+    uint64_t    stable = 0;  // consecutive iterations with the same signature
+    uint64_t    pushes = 0;  // nested entries of the first of them
+    double      mean   = 0;  // mean duration of them (nsec)
+};
+
+struct phase_frame
+{
+    size_t   hash   = 0;
+    uint64_t begin  = 0;  // nsec
+    uint64_t pushes = 0;  // value of phase_data::pushes at the entry
+};
+
+// only used by the primary thread, except the window which is opened and closed with
+// the mutex like the windows of the triggers
+struct phase_data
+{
+    bool     enabled    = false;
+    uint64_t warmup     = 3;
+    uint64_t iterations = 2;
+    uint64_t outliers   = 1;
+    double   threshold  = 0.5;
+    uint64_t pushes     = 0;  // region entries of the primary thread
+    size_t   hash       = 0;  // phase, zero until it is detected
+    size_t   depth      = 0;
+    uint64_t samples    = 0;  // iterations in the reference signature
+    uint64_t ref_pushes = 0;
+    double   ref_mean   = 0;
+    uint64_t remaining  = 0;  // representative iterations in the window
+    bool     outlier    = false;
+    trigger  window     = {};  // the spec names it in the logs
+
+    std::vector<phase_frame>                    stack      = {};
+    std::unordered_map<size_t, phase_candidate> candidates = {};
+};
+
+// intentionally leaked
+phase_data&
+get_phase()
+{
+    static auto* _v = new phase_data{};
+    return *_v;
+}
+
+bool
+is_similar(double _value, double _reference, double _threshold)
+{
+    return std::abs(_value - _reference) <= _threshold * _reference;
+}
+
+void
+open_phase_window(phase_data& _phase, std::string&& _spec)
+{
+    auto _lk            = std::unique_lock<std::mutex>{ get_mutex() };
+    _phase.window.spec  = std::move(_spec);
+    _phase.window.count = 1;
+    open_window(_phase.window);
+}
+
+void
+close_phase_window(phase_data& _phase)
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    if(_phase.window.count.exchange(0) == 0) return;
+    close_window(_phase.window);
+}
+
+// a window for the remainder of an iteration which exceeds the duration or the
+// number of nested regions of the phase. Called at the nested region entries so the
+// clock is not read at every entry once the outliers have been collected
+void
+check_phase_outlier(phase_data& _phase)
+{
+    if(_phase.outliers == 0 || _phase.window.count.load() > 0) return;
+    if(_phase.stack.size() <= _phase.depth) return;
+
+    const auto& _frame = _phase.stack.at(_phase.depth);
+    if(_frame.hash != _phase.hash) return;
+
+    auto _limit   = 1.0 + _phase.threshold;
+    auto _pushes  = _phase.pushes - _frame.pushes;
+    auto _elapsed = tsc::get_clock_real_now() - _frame.begin;
+    if(_pushes <= _limit * _phase.ref_pushes && _elapsed <= _limit * _phase.ref_mean)
+        return;
+
+    --_phase.outliers;
+    _phase.outlier = true;
+    open_phase_window(_phase, JOIN("", "outlier iteration of phase '",
+                                   _phase.candidates.at(_phase.hash).name, "'"));
+}
+
+// updates the signature of the candidate and selects it as the phase when it is stable
+// and shallower than the current phase, i.e. a loop which encloses the phase
+void
+update_phase_candidate(phase_data& _phase, phase_candidate& _candidate, size_t _hash,
+                       uint64_t _duration, uint64_t _pushes)
+{
+    if(_candidate.stable > 0 &&
+       is_similar(_pushes, _candidate.pushes, _phase.threshold) &&
+       is_similar(_duration, _candidate.mean, _phase.threshold))
+    {
+        ++_candidate.stable;
+        _candidate.mean += (_duration - _candidate.mean) / _candidate.stable;
+    }
+    else
+    {
+        _candidate.stable = 1;
+        _candidate.pushes = _pushes;
+        _candidate.mean   = _duration;
+    }
+
+    auto _depth = _phase.stack.size();
+    if(_candidate.stable < _phase.warmup || _hash == _phase.hash) return;
+    if(_phase.hash != 0 && _depth >= _phase.depth) return;
+
+    OMNITRACE_VERBOSE_F(1,
+                        "Detected the iterative phase '%s' (depth: %zu, %.3f msec and "
+                        "%zu nested regions per iteration)...\n",
+                        _candidate.name.c_str(), _depth, _candidate.mean / units::msec,
+                        static_cast<size_t>(_candidate.pushes));
+
+    close_phase_window(_phase);
+    _phase.hash       = _hash;
+    _phase.depth      = _depth;
+    _phase.samples    = _candidate.stable;
+    _phase.ref_pushes = _candidate.pushes;
+    _phase.ref_mean   = _candidate.mean;
+    _phase.remaining  = _phase.iterations;
+    _phase.outlier    = false;
+}
+
+void
+phase_begin(std::string_view _name)
+{
+    auto& _phase = get_phase();
+    auto  _hash  = std::hash<std::string_view>{}(_name);
+
+    if(_phase.hash != 0)
+    {
+        if(_hash == _phase.hash && _phase.stack.size() == _phase.depth)
+        {
+            if(_phase.remaining > 0 && _phase.window.count.load() == 0)
+            {
+                open_phase_window(_phase,
+                                  JOIN("", "representative iterations of phase '",
+                                       _phase.candidates.at(_hash).name, "'"));
+            }
+        }
+        else
+        {
+            check_phase_outlier(_phase);
+        }
+    }
+
+    // the entries of the regions within the phase are only counted
+    auto _inner = (_phase.hash != 0 && _phase.stack.size() > _phase.depth);
+    auto _begin = (_inner) ? uint64_t{ 0 } : tsc::get_clock_real_now();
+    _phase.stack.emplace_back(phase_frame{ _hash, _begin, _phase.pushes++ });
+}
+
+void
+phase_end(std::string_view _name)
+{
+    auto& _phase = get_phase();
+    auto  _hash  = std::hash<std::string_view>{}(_name);
+
+    // the regions which were entered before the initialization are not on the stack and
+    // the regions which were not exited are dropped
+    auto _pos = _phase.stack.size();
+    while(_pos > 0 && _phase.stack.at(_pos - 1).hash != _hash)
+        --_pos;
+    if(_pos == 0) return;
+
+    auto _frame = _phase.stack.at(_pos - 1);
+    _phase.stack.resize(_pos - 1);
+
+    if(_phase.hash != 0 && _phase.stack.size() > _phase.depth) return;
+
+    auto _duration = tsc::get_clock_real_now() - _frame.begin;
+    auto _pushes   = _phase.pushes - _frame.pushes - 1;
+
+    if(_hash == _phase.hash && _phase.stack.size() == _phase.depth)
+    {
+        if(_phase.outlier)
+        {
+            _phase.outlier = false;
+            close_phase_window(_phase);
+        }
+        else
+        {
+            if(_phase.window.count.load() > 0 && --_phase.remaining == 0)
+                close_phase_window(_phase);
+
+            // the reference follows the slow drift of the iterations
+            if(is_similar(_pushes, _phase.ref_pushes, _phase.threshold) &&
+               is_similar(_duration, _phase.ref_mean, _phase.threshold))
+            {
+                ++_phase.samples;
+                _phase.ref_mean += (_duration - _phase.ref_mean) / _phase.samples;
+            }
+        }
+    }
+
+    // only a shallower region may replace the phase once it is detected
+    if(_phase.hash != 0 && _phase.stack.size() == _phase.depth) return;
+
+    auto _itr = _phase.candidates.find(_hash);
+    if(_itr == _phase.candidates.end())
+        _itr = _phase.candidates.emplace(_hash, phase_candidate{ std::string{ _name } })
+                   .first;
+    update_phase_candidate(_phase, _itr->second, _hash, _duration, _pushes);
+}
+}  // namespace
+
+void
+setup()
+{
+    auto _spec = config::get_setting_value<std::string>("OMNITRACE_TRACE_TRIGGERS")
+                     .value_or(std::string{});
+
+    auto& _phase   = get_phase();
+    _phase.enabled = config::get_setting_value<bool>("OMNITRACE_TRACE_PHASE_DETECTION")
+                         .value_or(false);
+    if(_spec.empty() && !_phase.enabled) return;
+
+    auto& _triggers = get_triggers();
+    for(const auto& itr : tim::delimit(_spec, ";\n"))
+    {
+        auto _entry = trim(itr);
+        if(_entry.empty()) continue;
+        if(!parse_trigger(_entry, _triggers.emplace_back()))
+        {
+            OMNITRACE_WARNING_F(0, "Ignoring the invalid trace trigger '%s'\n",
+                                std::string{ _entry }.c_str());
+            _triggers.pop_back();
+        }
+    }
+
+    if(_triggers.empty() && !_phase.enabled) return;
+
+    if(!constraint::get_trace_specs().empty())
+    {
+        OMNITRACE_WARNING_F(0, "The time windows of OMNITRACE_TRACE_DELAY, "
+                               "OMNITRACE_TRACE_DURATION and OMNITRACE_TRACE_PERIODS "
+                               "enable and disable the same categories as the windows "
+                               "of OMNITRACE_TRACE_TRIGGERS and "
+                               "OMNITRACE_TRACE_PHASE_DETECTION\n");
+    }
+
+    auto _enabled = enabled_triggers{};
+    if(_phase.enabled)
+    {
+        auto _get = [](const char* _name, auto _default) {
+            return config::get_setting_value<decltype(_default)>(_name).value_or(
+                _default);
+        };
+
+        // a single iteration has no signature to compare with
+        _phase.warmup = std::max(_get("OMNITRACE_TRACE_PHASE_WARMUP", size_t{ 3 }),
+                                 size_t{ 2 });
+        _phase.iterations = _get("OMNITRACE_TRACE_PHASE_ITERATIONS", size_t{ 2 });
+        _phase.outliers   = _get("OMNITRACE_TRACE_PHASE_OUTLIERS", size_t{ 1 });
+        _phase.threshold  = std::max(_get("OMNITRACE_TRACE_PHASE_THRESHOLD", 0.5), 0.0);
+        _enabled.region   = true;
+        OMNITRACE_VERBOSE_F(1,
+                            "Trace phase detection: %zu warmup, %zu representative and "
+                            "%zu outlier iterations, threshold: %.2f\n",
+                            static_cast<size_t>(_phase.warmup),
+                            static_cast<size_t>(_phase.iterations),
+                            static_cast<size_t>(_phase.outliers), _phase.threshold);
+    }
+
+    for(const auto& itr : _triggers)
+    {
+        OMNITRACE_VERBOSE_F(1, "Trace trigger: %s\n", itr.spec.c_str());
+        switch(itr.type)
+        {
+            case trigger_type::region: _enabled.region = true; break;
+            case trigger_type::kernel: _enabled.kernel = true; break;
+            case trigger_type::memory: _enabled.memory = true; break;
+        }
+    }
+
+    if(_enabled.memory && !config::get_gpu_memory_tracking())
+    {
+        OMNITRACE_WARNING_F(0, "The hip_memory trace triggers require "
+                               "OMNITRACE_GPU_MEMORY_TRACKING=ON\n");
+    }
+
+    // nothing is recorded until a window opens
+    get_category_mask() = categories::get_mask(config::get_enabled_categories());
+    categories::disable_categories(get_category_mask());
+    get_enabled() = _enabled;
+}
+
+void
+region_begin(std::string_view _name)
+{
+    for(auto& itr : get_triggers())
+    {
+        if(itr.type == trigger_type::region && itr.name == _name) count_event(itr);
+    }
+
+    if(get_phase().enabled && tim::threading::get_id() == 0) phase_begin(_name);
+}
+
+void
+region_end(std::string_view _name)
+{
+    for(auto& itr : get_triggers())
+    {
+        if(itr.type == trigger_type::region && itr.name == _name) advance_window(itr);
+    }
+
+    if(get_phase().enabled && tim::threading::get_id() == 0) phase_end(_name);
+}
+
+void
+kernel_launch(const char* _name)
+{
+    if(_name == nullptr) return;
+
+    // the launch is counted by the open windows before it can open a window so the
+    // window which it opens holds it
+    for(auto& itr : get_triggers())
+    {
+        if(itr.type == trigger_type::kernel) advance_window(itr);
+    }
+
+    for(auto& itr : get_triggers())
+    {
+        if(itr.type == trigger_type::kernel && std::strstr(_name, itr.name.c_str()))
+            count_event(itr);
+    }
+}
+
+void
+memory_update(uint64_t _live_bytes)
+{
+    for(auto& itr : get_triggers())
+    {
+        if(itr.type != trigger_type::memory) continue;
+
+        bool _above = (_live_bytes > itr.threshold);
+        if(itr.above.load(std::memory_order_relaxed) == _above) continue;
+
+        auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+        if(itr.above.exchange(_above) == _above) continue;
+        if(_above)
+            open_window(itr);
+        else
+            close_window(itr);
+    }
+}
+}  // namespace trace_trigger
+}  // namespace omnitrace
@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+/// event-triggered trace windows (see OMNITRACE_TRACE_TRIGGERS). Unlike the time
+/// windows of OMNITRACE_TRACE_DELAY, OMNITRACE_TRACE_DURATION and
+/// OMNITRACE_TRACE_PERIODS, a window opens and closes on an event:
+///
+///     region=NAME@N[+M]   opens at the N-th entry of the region NAME and closes at the
+///                         M-th exit of the region afterwards (default: 1)
+///     kernel=NAME@N[+M]   opens at the N-th launch of a kernel whose name contains
+///                         NAME and holds M kernel launches (default: 1), i.e. closes
+///                         at the entry of the next launch
+///     hip_memory>BYTES    open while the live memory allocated through HIP on the
+///                         devices exceeds BYTES (K, M and G are powers of 1024)
+///
+/// The categories are disabled at startup and enabled while at least one window is
+/// open, the same way as the time windows, so nothing is recorded outside of the
+/// windows. The region, kernel and memory hooks are a single branch when no trigger
+/// of their type is configured.
+///
+/// OMNITRACE_TRACE_PHASE_DETECTION opens the windows without a trigger: the regions of
+/// the primary thread are candidates for the iterative phase of the application and
+/// the outermost region which recurs OMNITRACE_TRACE_PHASE_WARMUP times with a stable
+/// duration and number of nested regions is selected. A window holds the next
+/// OMNITRACE_TRACE_PHASE_ITERATIONS iterations and, afterwards, a window opens within
+/// an iteration once it exceeds the duration or the nested regions of the phase by
+/// OMNITRACE_TRACE_PHASE_THRESHOLD, up to OMNITRACE_TRACE_PHASE_OUTLIERS times
+namespace trace_trigger
+{
+/// whether a trigger of each type is configured. Only set by setup()
+struct enabled_triggers
+{
+    bool region = false;
+    bool kernel = false;
+    bool memory = false;
+};
+
+inline enabled_triggers&
+get_enabled()
+{
+    static auto _v = enabled_triggers{};
+    return _v;
+}
+
+/// parses OMNITRACE_TRACE_TRIGGERS and OMNITRACE_TRACE_PHASE_DETECTION and disables the
+/// categories until a window opens
+void
+setup();
+
+/// called at the entry and the exit of the user, instrumented, Kokkos, Python and ROCTx
+/// regions on every thread, before the category of the region is checked
+void
+region_begin(std::string_view _name);
+
+void
+region_end(std::string_view _name);
+
+/// called when a kernel is launched through HIP
+void
+kernel_launch(const char* _name);
+
+/// called with the live bytes of all the devices after every change (requires
+/// OMNITRACE_GPU_MEMORY_TRACKING)
+void
+memory_update(uint64_t _live_bytes);
+}  // namespace trace_trigger
+}  // namespace omnitrace
@@ -28,15 +28,19 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
+#include "core/hash_cache.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
 #include "core/timemory.hpp"
+#include "core/tsc.hpp"
 #include "core/utility.hpp"
 #include "library/causal/sampling.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
+#include "library/timeline_profile.hpp"
 #include "library/tracing/annotation.hpp"
+#include "library/tracing/deferred.hpp"
 
 #include <timemory/components/io/components.hpp>
 #include <timemory/components/network/types.hpp>
@@ -50,11 +54,14 @@
 #include <timemory/mpl/type_traits.hpp>
 #include <timemory/types.hpp>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <functional>
 #include <memory>
 #include <ratio>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -74,6 +81,25 @@ using perfetto_annotate_component_types = tim::mpl::available_t<type_list<
     comp::thread_cpu_clock, comp::thread_cpu_util, comp::user_clock, comp::user_mode_time,
     comp::virtual_memory>>;
 
+// a region name and its hash. A zero hash means the hash has not been computed yet,
+// otherwise the name must be the persistent string owned by the hash database.
+struct region_handle
+{
+    hash_value_t     hash = 0;
+    std::string_view name = {};
+};
+
+// returned from a push and passed to the matching pop so that the timemory bundle is
+// located without searching the per-thread stack. The serial identifies the bundle
+// since its slot is reused by a later push once it is popped
+struct region_token
+{
+    region_handle             region = {};
+    instrumentation_bundle_t* bundle = nullptr;
+    size_t                    index  = 0;
+    uint64_t                  serial = 0;
+};
+
 //
 //  declarations
 //
@@ -145,9 +171,9 @@ template <typename CategoryT, typename... Args>
 auto
 get_perfetto_category_uuid(Args&&... _args)
 {
-    return tim::hash::get_hash_id(
-        tim::hash::get_hash_id(JOIN('_', "omnitrace", trait::name<CategoryT>::value)),
-        std::forward<Args>(_args)...);
+    static const auto _category_uuid =
+        tim::hash::get_hash_id(JOIN('_', "omnitrace", trait::name<CategoryT>::value));
+    return tim::hash::get_hash_id(_category_uuid, std::forward<Args>(_args)...);
 }
 
 template <typename CategoryT, typename TrackT = ::perfetto::Track, typename FuncT,
@@ -155,7 +181,16 @@ template <typename CategoryT, typename TrackT = ::perfetto::Track, typename Func
 auto
 get_perfetto_track(CategoryT, FuncT&& _desc_generator, Args&&... _args)
 {
+    // direct-mapped table of the tracks which this thread has already described.
+    // once a track is known, resolving it is the uuid hash and a single load
+    constexpr size_t cache_size = 64;
+    static thread_local auto _known = std::array<hash_value_t, cache_size>{};
+
     auto  _uuid = get_perfetto_category_uuid<CategoryT>(std::forward<Args>(_args)...);
+    auto& _cached = _known[_uuid % cache_size];
+    if(OMNITRACE_LIKELY(_cached == _uuid && _uuid != 0))
+        return TrackT(_uuid, ::perfetto::ProcessTrack::Current());
+
     auto& _track_uuids = get_perfetto_track_uuids();
     if(_track_uuids.find(_uuid) == _track_uuids.end())
     {
@@ -183,6 +218,7 @@ get_perfetto_track(CategoryT, FuncT&& _desc_generator, Args&&... _args)
                        _uuid, _track_uuids.at(_uuid).c_str(), _name.c_str());
 #endif
 
+    _cached = _uuid;
     return TrackT(_uuid, ::perfetto::ProcessTrack::Current());
 }
 
@@ -190,6 +226,7 @@ template <typename Tp = uint64_t>
 OMNITRACE_INLINE auto
 now()
 {
+    if(tsc::enabled()) return static_cast<Tp>(tsc::to_ns(tsc::read()));
     return ::tim::get_clock_real_now<Tp, std::nano>();
 }
 
@@ -241,76 +278,116 @@ get_profile_stack()
     return get_category_stack<CategoryT>().profile;
 }
 
+// categories which are compiled out are always disabled and static categories are
+// never disabled (see category_compiled and category_static) so neither reads any
+// run-time state. The others read one bit of categories::enabled_mask
 template <typename CategoryT>
 auto
 category_push_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get();
+    if constexpr(!category_compiled<CategoryT>::value)
+        return true;
+    else if constexpr(category_static<CategoryT>::value)
+        return false;
+    else
+        return !categories::is_enabled<CategoryT>();
 }
 
 template <typename CategoryT>
 auto
 category_mark_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get();
+    return category_push_disabled<CategoryT>();
 }
 
 template <typename CategoryT>
 auto
 category_pop_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get() &&
-           (get_profile_stack<CategoryT>() + get_tracing_stack<CategoryT>()) <= 0;
+    if constexpr(!category_compiled<CategoryT>::value)
+        return true;
+    else if constexpr(category_static<CategoryT>::value)
+        return false;
+    else
+        return !categories::is_enabled<CategoryT>() &&
+               (get_profile_stack<CategoryT>() + get_tracing_stack<CategoryT>()) <= 0;
 }
 
 template <typename CategoryT>
 auto
 tracing_pop_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get() &&
-           get_tracing_stack<CategoryT>() <= 0;
+    if constexpr(!category_compiled<CategoryT>::value)
+        return true;
+    else if constexpr(category_static<CategoryT>::value)
+        return false;
+    else
+        return !categories::is_enabled<CategoryT>() &&
+               get_tracing_stack<CategoryT>() <= 0;
 }
 
 template <typename CategoryT>
 auto
 profile_pop_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get() &&
-           get_profile_stack<CategoryT>() <= 0;
+    if constexpr(!category_compiled<CategoryT>::value)
+        return true;
+    else if constexpr(category_static<CategoryT>::value)
+        return false;
+    else
+        return !categories::is_enabled<CategoryT>() &&
+               get_profile_stack<CategoryT>() <= 0;
 }
 
+// returns the bundle and its position in the stack
 template <typename CategoryT, typename... Args>
-inline void
-push_timemory(CategoryT, std::string_view name, Args&&... args)
+inline std::pair<instrumentation_bundle_t*, size_t>
+push_timemory(CategoryT, hash_value_t _hash, Args&&... args)
 {
+    using return_type = std::pair<instrumentation_bundle_t*, size_t>;
+
     // skip if category is disabled
-    if(category_push_disabled<CategoryT>()) return;
+    if(category_push_disabled<CategoryT>()) return return_type{ nullptr, 0 };
 
     auto& _data = tracing::get_instrumentation_bundles();
     if(OMNITRACE_LIKELY(_data != nullptr))
     {
-        // this generates a hash for the raw string array
-        auto _hash = tim::add_hash_id(name);
-        _data->construct(_hash)->start(std::forward<Args>(args)...);
+        auto* _v = _data->construct(_hash);
+        _v->start(std::forward<Args>(args)...);
         // increment the profile stack
         ++get_profile_stack<CategoryT>();
+        return return_type{ _v, _data->size() - 1 };
     }
+    return return_type{ nullptr, 0 };
+}
+
+template <typename CategoryT, typename... Args>
+inline std::pair<instrumentation_bundle_t*, size_t>
+push_timemory(CategoryT, std::string_view name, Args&&... args)
+{
+    using return_type = std::pair<instrumentation_bundle_t*, size_t>;
+
+    // skip if category is disabled
+    if(category_push_disabled<CategoryT>()) return return_type{ nullptr, 0 };
+
+    // this generates a hash for the raw string array
+    return push_timemory(CategoryT{}, hash_cache::add_hash_id(name),
+                         std::forward<Args>(args)...);
 }
 
 template <typename CategoryT>
 inline std::pair<instrumentation_bundle_t*, size_t>
-get_timemory(CategoryT, std::string_view name)
+get_timemory(CategoryT, hash_value_t _hash)
 {
     using return_type = std::pair<instrumentation_bundle_t*, size_t>;
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
 
-    auto  _hash = tim::hash::get_hash_id(name);
     auto& _data = tracing::get_instrumentation_bundles();
     if(OMNITRACE_UNLIKELY(_data == nullptr || _data->empty()))
     {
         OMNITRACE_DEBUG("[%s] skipped %s :: empty bundle stack\n", "omnitrace_pop_trace",
-                        name.data());
+                        tim::get_hash_identifier_fast(_hash).data());
         return return_type{ nullptr, -1 };
     }
 
@@ -334,16 +411,60 @@ get_timemory(CategoryT, std::string_view name)
     return return_type{ nullptr, -1 };
 }
 
-template <typename CategoryT, typename... Args>
+template <typename CategoryT>
+inline std::pair<instrumentation_bundle_t*, size_t>
+get_timemory(CategoryT, std::string_view name)
+{
+    using return_type = std::pair<instrumentation_bundle_t*, size_t>;
+    // skip if category is disabled and not pushed on this thread
+    if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
+
+    return get_timemory(CategoryT{}, tim::hash::get_hash_id(name));
+}
+
+template <typename CategoryT>
+inline std::pair<instrumentation_bundle_t*, size_t>
+get_timemory(CategoryT, const region_token& _token)
+{
+    using return_type = std::pair<instrumentation_bundle_t*, size_t>;
+    // skip if category is disabled and not pushed on this thread
+    if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
+
+    auto& _data = tracing::get_instrumentation_bundles();
+    if(_token.bundle && OMNITRACE_LIKELY(_data != nullptr && !_data->empty()))
+    {
+        // a bundle only moves towards the bottom of the stack when a bundle beneath it
+        // is popped out of order so the search starts at the position of the push
+        // and, in the common case, ends there
+        for(size_t i = std::min<size_t>(_token.index, _data->size() - 1) + 1; i > 0; --i)
+        {
+            auto* _v = _data->at(i - 1);
+            if(_v == _token.bundle && _data->serial(i - 1) == _token.serial &&
+               _v->get_hash() == _token.region.hash)
+                return std::make_pair(_v, i - 1);
+        }
+
+        // the bundle of the push on this thread was already popped, the slot may hold
+        // the bundle of a later push
+        if(_data->owns(_token.bundle)) return return_type{ nullptr, -1 };
+    }
+
+    // token was not produced by a push on this thread
+    if(_token.region.hash != 0) return get_timemory(CategoryT{}, _token.region.hash);
+    return get_timemory(CategoryT{}, _token.region.name);
+}
+
+// the key is either the name of the region or the hash of the name
+template <typename CategoryT, typename KeyT, typename... Args>
 inline auto
-stop_timemory(CategoryT, std::string_view name, Args&&... args)
+stop_timemory(CategoryT, KeyT&& _key, Args&&... args)
 {
     using return_type = std::pair<instrumentation_bundle_t*, size_t>;
 
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
 
-    auto&& _data = get_timemory(CategoryT{}, name);
+    auto&& _data = get_timemory(CategoryT{}, std::forward<KeyT>(_key));
     if(_data.first)
     {
         _data.first->stop(std::forward<Args>(args)...);
@@ -362,17 +483,53 @@ destroy_timemory(std::pair<instrumentation_bundle_t*, size_t> _data)
     }
 }
 
-template <typename CategoryT, typename... Args>
+// the key is either the name of the region or the hash of the name
+template <typename CategoryT, typename KeyT, typename... Args>
 inline void
-pop_timemory(CategoryT, std::string_view name, Args&&... args)
+pop_timemory(CategoryT, KeyT&& _key, Args&&... args)
 {
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return;
 
-    auto _data = stop_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+    auto _data = stop_timemory(CategoryT{}, std::forward<KeyT>(_key),
+                               std::forward<Args>(args)...);
     if(_data.first) destroy_timemory(std::move(_data));
 }
 
+// the compact timeline profile (see timeline_profile.hpp) which replaces the timemory
+// bundles of the regions. The profile stack is incremented in the same way so the
+// regions are still popped after the category is disabled
+template <typename CategoryT>
+inline void
+push_timeline(CategoryT, hash_value_t _hash)
+{
+    if(category_push_disabled<CategoryT>()) return;
+
+    timeline_profile::push(_hash);
+    ++get_profile_stack<CategoryT>();
+}
+
+template <typename CategoryT>
+inline void
+pop_timeline(CategoryT, hash_value_t _hash)
+{
+    if(profile_pop_disabled<CategoryT>()) return;
+
+    timeline_profile::pop(_hash);
+}
+
+// true if the arguments begin with the track or the timestamp of the event, i.e. the
+// event is forwarded to the *_track or *_ts variants
+template <typename... Args>
+constexpr bool
+perfetto_explicit_timestamp()
+{
+    using tuple_type = std::tuple<concepts::unqualified_type_t<Args>...>;
+    using arg0_type  = concepts::tuple_element_t<0, tuple_type>;
+    return std::is_same<arg0_type, ::perfetto::Track>::value ||
+           std::is_same<arg0_type, uint64_t>::value;
+}
+
 template <typename CategoryT, typename... Args>
 inline void
 push_perfetto(CategoryT, const char* name, Args&&... args)
@@ -380,6 +537,17 @@ push_perfetto(CategoryT, const char* name, Args&&... args)
     // skip if category is disabled
     if(category_push_disabled<CategoryT>()) return;
 
+    // the encoding is done by a background thread (see tracing/deferred.hpp)
+    if constexpr(!perfetto_explicit_timestamp<Args...>())
+    {
+        if(config::get_snapshot().perfetto_deferred_regions)
+        {
+            ++get_tracing_stack<CategoryT>();
+            deferred::begin(CategoryT{}, name, now());
+            return;
+        }
+    }
+
     if constexpr(sizeof...(Args) == 1 &&
                  std::is_invocable<Args..., ::perfetto::EventContext>::value)
     {
@@ -466,6 +634,16 @@ pop_perfetto(CategoryT, const char* name, Args&&... args)
     // skip if category is disabled and not pushed on this thread
     if(tracing_pop_disabled<CategoryT>()) return;
 
+    if constexpr(!perfetto_explicit_timestamp<Args...>())
+    {
+        if(config::get_snapshot().perfetto_deferred_regions)
+        {
+            --get_tracing_stack<CategoryT>();
+            deferred::end(CategoryT{}, name, now());
+            return;
+        }
+    }
+
     if constexpr(sizeof...(Args) == 1 &&
                  std::is_invocable<Args..., ::perfetto::EventContext>::value)
     {
@@ -22,10 +22,68 @@
 
 #include "library/tracing/annotation.hpp"
 
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace omnitrace
 {
 namespace tracing
 {
+namespace
+{
+struct interned_name
+{
+    std::string_view name  = {};
+    int64_t          index = -1;
+    const char*      value = nullptr;
+};
+
+auto&
+get_interned_name_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+// node-based so the addresses of the strings never change. Intentionally leaked so
+// that the names remain valid for perfetto during finalization
+auto&
+get_interned_name_storage()
+{
+    static auto* _v = new std::unordered_set<std::string>{};
+    return *_v;
+}
+}  // namespace
+
+const char*
+get_interned_annotation_name(std::string_view _name, int64_t _idx)
+{
+    static thread_local auto _cache = std::unordered_map<size_t, interned_name>{};
+
+    auto _hash = std::hash<std::string_view>{}(_name) ^
+                 (static_cast<size_t>(_idx + 1) * 0x9e3779b97f4a7c15ULL);
+    auto itr = _cache.find(_hash);
+    if(itr != _cache.end() && itr->second.index == _idx && itr->second.name == _name)
+        return itr->second.value;
+
+    auto _value = (_idx >= 0) ? JOIN("", "arg", _idx, "-", _name) : std::string{ _name };
+
+    const std::string* _entry = nullptr;
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_interned_name_mutex() };
+        _entry   = &(*get_interned_name_storage().emplace(std::move(_value)).first);
+    }
+
+    // the name is always the suffix of the stored value so the key of the
+    // thread-local cache can refer to the persistent copy
+    auto _key = std::string_view{ *_entry }.substr(_entry->length() - _name.length());
+    _cache[_hash] = interned_name{ _key, _idx, _entry->c_str() };
+    return _entry->c_str();
+}
+
 void
 add_perfetto_annotation(perfetto_event_context_t&     ctx,
                         const omnitrace_annotation_t& _annotation)
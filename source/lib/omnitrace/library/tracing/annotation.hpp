@@ -34,6 +34,8 @@
 #include <timemory/mpl/concepts.hpp>
 #include <timemory/operations/types/get.hpp>
 
+#include <cstdint>
+#include <string_view>
 #include <type_traits>
 
 namespace omnitrace
@@ -69,6 +71,12 @@ OMNITRACE_DEFINE_ANNOTATION_TYPE(OMNITRACE_VALUE_VOID_P, void*)
 
 #undef OMNITRACE_DEFINE_ANNOTATION_TYPE
 
+/// returns a persistent pointer to the annotation name (prefixed with "arg<idx>-"
+/// when the index is non-negative). Equal names always return the same address so
+/// the pointer can be used as the key for perfetto's debug annotation name interning
+const char*
+get_interned_annotation_name(std::string_view _name, int64_t _idx = -1);
+
 template <typename Np, typename Tp>
 auto
 add_perfetto_annotation(
@@ -84,17 +92,23 @@ add_perfetto_annotation(
     static_assert(concepts::is_string_type<named_type>::value,
                   "Error! name is not a string type");
 
+    // annotation names are emitted as interned iids. String literals have a stable
+    // address so perfetto can intern them directly; anything else is mapped to a
+    // persistent copy first
     auto _get_dbg = [&]() {
+        using interned_name_t = ::perfetto::internal::InternedDebugAnnotationName;
+
         auto* _dbg = ctx.event()->add_debug_annotations();
-        if(_idx >= 0)
+        if constexpr(std::is_array<std::remove_reference_t<Np>>::value)
         {
-            auto _arg_name = JOIN("", "arg", _idx, "-", std::forward<Np>(_name));
-            _dbg->set_name(_arg_name);
-        }
-        else
-        {
-            _dbg->set_name(std::string_view{ std::forward<Np>(_name) }.data());
+            if(_idx < 0)
+            {
+                _dbg->set_name_iid(interned_name_t::Get(&ctx, _name));
+                return _dbg;
+            }
         }
+        _dbg->set_name_iid(interned_name_t::Get(
+            &ctx, get_interned_annotation_name(std::string_view{ _name }, _idx)));
         return _dbg;
     };
 
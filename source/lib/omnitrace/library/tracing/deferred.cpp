@@ -0,0 +1,280 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/tracing/deferred.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "library/emergency_dump.hpp"
+#include "library/housekeeping.hpp"
+#include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace omnitrace
+{
+namespace tracing
+{
+namespace deferred
+{
+namespace
+{
+// the encoder wakes up at this interval. The rings are sized so that they do not
+// fill up in between at the event rates of fine-grained instrumentation
+constexpr auto encode_interval = std::chrono::milliseconds{ 2 };
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_cv()
+{
+    static auto _v = std::condition_variable{};
+    return _v;
+}
+
+auto&
+get_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_active()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+// the buffers are kept after the thread exits since the records may not have been
+// encoded yet. Intentionally leaked since the buffers are referenced by thread-locals
+auto&
+get_buffers()
+{
+    static auto* _v = new std::vector<std::unique_ptr<buffer>>{};
+    return *_v;
+}
+
+auto&
+get_num_stalls()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+
+// the begin functions of the categories. Constant-initialized since the functions are
+// registered during the static initialization
+constexpr size_t max_categories = 256;
+
+std::atomic<emit_func_t> begin_funcs[max_categories] = {};
+std::atomic<size_t>      num_begin_funcs             = { 0 };
+
+// the records which have not been encoded yet
+void
+dump_records(emergency_dump::writer& _writer, const void* _data, int64_t _tid)
+{
+    const auto& _buffer = *static_cast<const buffer*>(_data);
+    auto        _tail   = _buffer.tail.load(std::memory_order_acquire);
+    auto        _head   = _buffer.head.load(std::memory_order_acquire);
+    if(_tail >= _head) return;
+    _tail = std::max(_tail, _head - std::min(_head, _buffer.mask + 1));
+
+    uint64_t _nbytes = 0;
+    for(auto i = _tail; i < _head; ++i)
+    {
+        const auto& _record = _buffer.data[i & _buffer.mask];
+        _nbytes += sizeof(uint64_t) + sizeof(uint32_t) +
+                   emergency_dump::writer::string_size(_record.name);
+    }
+
+    _writer.section(emergency_dump::region_section, _tid, _nbytes);
+    for(auto i = _tail; i < _head; ++i)
+    {
+        const auto& _record = _buffer.data[i & _buffer.mask];
+        _writer.write(_record.timestamp);
+        _writer.write(static_cast<uint32_t>(is_begin(_record.emit) ? 1 : 0));
+        _writer.write_string(_record.name);
+    }
+}
+
+// the holder of the mutex is the consumer of every ring. Requires the mutex to be held
+size_t
+drain(buffer& _buffer)
+{
+    auto _tail = _buffer.tail.load(std::memory_order_relaxed);
+    auto _head = _buffer.head.load(std::memory_order_acquire);
+    if(_tail == _head) return 0;
+
+    const auto _track = ::perfetto::ThreadTrack::ForThread(
+        static_cast<::perfetto::base::PlatformThreadId>(_buffer.sys_tid));
+    for(auto i = _tail; i < _head; ++i)
+    {
+        const auto& _record = _buffer.data[i & _buffer.mask];
+        _record.emit(_record, _track);
+    }
+
+    _buffer.tail.store(_head, std::memory_order_release);
+    return (_head - _tail);
+}
+
+void
+start_encoder()
+{
+    if(get_thread()) return;
+
+    auto _func = []() {
+        thread_info::init(true);
+        threading::set_thread_name("omni.perfetto");
+        housekeeping::configure_thread();
+        sampling::block_signals();
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+        while(get_active().load())
+        {
+            std::unique_lock<std::mutex> _lk{ get_mutex() };
+            get_cv().wait_for(_lk, encode_interval);
+            for(auto& itr : get_buffers())
+                drain(*itr);
+        }
+    };
+
+    get_active().store(true);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    get_thread() = std::make_unique<std::thread>(_func);
+}
+}  // namespace
+
+buffer::buffer(size_t _capacity)
+: tid{ threading::get_id() }
+, sys_tid{ threading::get_sys_tid() }
+{
+    // power of two so that the position in the ring is a mask of the counters
+    size_t _n = 64;
+    while(_n < _capacity)
+        _n <<= 1;
+    mask = _n - 1;
+    data.resize(_n);
+}
+
+buffer*
+register_buffer()
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto  _buffer = std::make_unique<buffer>(config::get_perfetto_deferred_buffer_size());
+    auto* _v      = _buffer.get();
+
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    get_buffers().emplace_back(std::move(_buffer));
+    if(get_state() < State::Finalized) start_encoder();
+    emergency_dump::add_source(&dump_records, _v, _v->tid);
+    return _v;
+}
+
+void
+wait(buffer& _buffer)
+{
+    // the encoder fell behind: encode the records of this thread here instead of
+    // spinning until the encoder catches up
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    ++get_num_stalls();
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    drain(_buffer);
+    _buffer.cached_tail = _buffer.tail.load(std::memory_order_acquire);
+}
+
+bool
+register_begin(emit_func_t _func)
+{
+    auto _idx = num_begin_funcs.fetch_add(1);
+    if(_idx >= max_categories) return false;
+    begin_funcs[_idx].store(_func, std::memory_order_release);
+    return true;
+}
+
+bool
+is_begin(emit_func_t _func)
+{
+    auto _n = std::min(num_begin_funcs.load(std::memory_order_acquire), max_categories);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        if(begin_funcs[i].load(std::memory_order_relaxed) == _func) return true;
+    }
+    return false;
+}
+
+void
+flush()
+{
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    for(auto& itr : get_buffers())
+        drain(*itr);
+}
+
+void
+shutdown()
+{
+    auto& _thread = get_thread();
+    if(_thread)
+    {
+        get_active().store(false);
+        get_cv().notify_all();
+        _thread->join();
+        _thread.reset();
+    }
+
+    std::unique_lock<std::mutex> _lk{ get_mutex() };
+    size_t _n = 0;
+    for(auto& itr : get_buffers())
+        _n += drain(*itr);
+
+    if(!get_buffers().empty())
+        OMNITRACE_VERBOSE(1,
+                          "[perfetto] encoded the deferred regions of %zu threads (%zu "
+                          "remaining at shutdown). The encoder fell behind %zu times\n",
+                          get_buffers().size(), _n,
+                          static_cast<size_t>(get_num_stalls().load()));
+}
+}  // namespace deferred
+}  // namespace tracing
+}  // namespace omnitrace
@@ -0,0 +1,169 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "common/defines.h"
+#include "core/config.hpp"
+#include "core/huge_pages.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "library/tracing/annotation.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace omnitrace
+{
+namespace tracing
+{
+/// "record now, encode later" backend of push_perfetto/pop_perfetto (see
+/// OMNITRACE_PERFETTO_DEFERRED_REGIONS). The begin and end of a region only store a
+/// fixed-size record in a single-producer/single-consumer ring owned by the thread
+/// and a background thread encodes the records as perfetto slices on the track of
+/// the thread in batches. The arguments of the region and the timemory annotations
+/// are not recorded
+namespace deferred
+{
+struct record;
+
+using emit_func_t = void (*)(const record&, const ::perfetto::ThreadTrack&);
+
+struct record
+{
+    uint64_t    timestamp = 0;
+    const char* name      = nullptr;  ///< persistent, e.g. the timemory hash identifier
+    emit_func_t emit      = nullptr;  ///< encodes the category and begin/end
+};
+
+struct buffer
+{
+    explicit buffer(size_t _capacity);
+
+    // the producer fields are not on the same cache line as the consumer fields
+    alignas(64) std::atomic<uint64_t> head = { 0 };  ///< written by the owning thread
+    uint64_t cached_tail                   = 0;      ///< owning thread's copy of tail
+    alignas(64) std::atomic<uint64_t> tail = { 0 };  ///< written by the encoder
+
+    using allocator_t = huge_pages::allocator<record>;
+
+    int64_t                          tid     = 0;
+    int64_t                          sys_tid = 0;
+    uint64_t                         mask    = 0;
+    std::vector<record, allocator_t> data    = {};
+};
+
+/// creates, registers and returns the buffer of the calling thread and starts the
+/// encoder thread if it is not running
+buffer*
+register_buffer();
+
+/// blocks until the ring of the calling thread has room for a record
+void
+wait(buffer&);
+
+/// encodes the records of every thread on the calling thread. Used before the trace
+/// is written, e.g. by the flight recorder
+void
+flush();
+
+/// stops the encoder thread and encodes the remaining records
+void
+shutdown();
+
+/// registers the function which encodes the begin of a region of a category so the
+/// records can be told apart without invoking the function (e.g. in the emergency dump)
+bool
+register_begin(emit_func_t);
+
+/// true if the function was registered by register_begin. Async-signal-safe
+bool
+is_begin(emit_func_t);
+
+inline buffer&
+get_buffer()
+{
+    static thread_local auto* _v = register_buffer();
+    return *_v;
+}
+
+template <typename CategoryT>
+void
+emit_begin(const record& _v, const ::perfetto::ThreadTrack& _track)
+{
+    TRACE_EVENT_BEGIN(trait::name<CategoryT>::value, ::perfetto::StaticString(_v.name),
+                      _track, _v.timestamp, [&](::perfetto::EventContext ctx) {
+                          if(config::get_perfetto_annotations())
+                              add_perfetto_annotation(ctx, "begin_ns", _v.timestamp);
+                      });
+}
+
+template <typename CategoryT>
+void
+emit_end(const record& _v, const ::perfetto::ThreadTrack& _track)
+{
+    TRACE_EVENT_END(trait::name<CategoryT>::value, _track, _v.timestamp,
+                    [&](::perfetto::EventContext ctx) {
+                        if(config::get_perfetto_annotations())
+                            add_perfetto_annotation(ctx, "end_ns", _v.timestamp);
+                    });
+}
+
+inline void
+push_record(const char* _name, uint64_t _ts, emit_func_t _emit)
+{
+    auto& _buffer = get_buffer();
+    auto  _head   = _buffer.head.load(std::memory_order_relaxed);
+    if(OMNITRACE_UNLIKELY(_head - _buffer.cached_tail > _buffer.mask))
+    {
+        _buffer.cached_tail = _buffer.tail.load(std::memory_order_acquire);
+        if(_head - _buffer.cached_tail > _buffer.mask) wait(_buffer);
+    }
+    _buffer.data[_head & _buffer.mask] = record{ _ts, _name, _emit };
+    _buffer.head.store(_head + 1, std::memory_order_release);
+}
+
+// initialized during the static initialization of the instantiations of begin()
+template <typename CategoryT>
+inline const bool begin_registered = register_begin(&emit_begin<CategoryT>);
+
+template <typename CategoryT>
+inline void
+begin(CategoryT, const char* _name, uint64_t _ts)
+{
+    (void) begin_registered<CategoryT>;
+    push_record(_name, _ts, &emit_begin<CategoryT>);
+}
+
+template <typename CategoryT>
+inline void
+end(CategoryT, const char* _name, uint64_t _ts)
+{
+    push_record(_name, _ts, &emit_end<CategoryT>);
+}
+}  // namespace deferred
+}  // namespace tracing
+}  // namespace omnitrace
@@ -0,0 +1,232 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/user_counters.hpp"
+#include "api.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "core/tsc.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace user_counters
+{
+namespace
+{
+constexpr size_t max_counters = 1024;
+
+struct counter_info
+{
+    std::string name  = {};
+    std::string units = {};
+    int64_t     track = -1;  // index of the perfetto counter track. Requires the mutex
+};
+
+struct counter_record
+{
+    uint64_t timestamp = 0;
+    uint64_t id        = 0;
+    double   value     = 0.0;
+};
+
+// only the owning thread appends the records. The records before size are complete
+// and the records before emitted were written to perfetto, which happens when the
+// owning thread fills the buffer or at finalization so emitted requires the mutex
+struct thread_records
+{
+    static constexpr size_t capacity = 4096;
+
+    std::atomic<size_t>                  size    = { 0 };
+    size_t                               emitted = 0;
+    std::array<counter_record, capacity> data    = {};
+};
+
+using thread_records_data = omnitrace::thread_data<thread_records, thread_records>;
+
+auto&
+get_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+// the entries are never relocated since the tracks refer to the units
+auto&
+get_counters()
+{
+    static auto* _v = new std::array<counter_info, max_counters>{};
+    return *_v;
+}
+
+auto&
+get_counter_count()
+{
+    static auto _v = std::atomic<size_t>{ 0 };
+    return _v;
+}
+
+auto&
+get_thread_records(int64_t _tid = tim::threading::get_id())
+{
+    return thread_records_data::instance(construct_on_thread{ _tid });
+}
+
+size_t&
+get_total_records()
+{
+    static size_t _v = 0;
+    return _v;
+}
+
+// requires the mutex
+void
+emit(thread_records& _data, size_t _end)
+{
+    using track = perfetto_counter_track<category::user_counter>;
+
+    auto& _counters = get_counters();
+    for(size_t i = _data.emitted; i < _end; ++i)
+    {
+        const auto& itr   = _data.data[i];
+        auto&       _info = _counters.at(itr.id - 1);
+        if(_info.track < 0)
+        {
+            _info.track = track::size(0);
+            track::emplace(0, _info.name, _info.units.c_str());
+        }
+        TRACE_COUNTER(trait::name<category::user_counter>::value,
+                      track::at(0, _info.track), itr.timestamp, itr.value);
+    }
+    get_total_records() += (_end - _data.emitted);
+    _data.emitted = _end;
+}
+
+bool
+is_recording()
+{
+    return get_state() == State::Active &&
+           !tracing::category_push_disabled<category::user_counter>();
+}
+}  // namespace
+
+uint64_t
+register_counter(const char* _name, const char* _units)
+{
+    static auto _handles = std::unordered_map<std::string, uint64_t>{};
+
+    if(!_name) OMNITRACE_THROW("invalid arguments for counter registration\n");
+
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    if(auto itr = _handles.find(_name); itr != _handles.end()) return itr->second;
+
+    auto& _count = get_counter_count();
+    auto  _n     = _count.load(std::memory_order_relaxed);
+    if(_n >= max_counters)
+        OMNITRACE_THROW("cannot register counter '%s' :: maximum of %zu counters\n",
+                        _name, max_counters);
+
+    get_counters()[_n] = { _name, (_units) ? _units : "", -1 };
+    _count.store(_n + 1, std::memory_order_release);
+    return (_handles[_name] = _n + 1);
+}
+
+void
+record(uint64_t _id, double _value)
+{
+    static thread_local auto* _data = get_thread_records().get();
+
+    if(OMNITRACE_UNLIKELY(_id == 0 ||
+                          _id > get_counter_count().load(std::memory_order_acquire)))
+        OMNITRACE_THROW("invalid counter handle %lu\n", (unsigned long) _id);
+
+    if(!_data || !is_recording()) return;
+
+    auto _n         = _data->size.load(std::memory_order_relaxed);
+    _data->data[_n] = counter_record{ tsc::get_clock_real_now(), _id, _value };
+    _data->size.store(_n + 1, std::memory_order_release);
+
+    if(OMNITRACE_UNLIKELY(_n + 1 == thread_records::capacity))
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+        emit(*_data, thread_records::capacity);
+        _data->emitted = 0;
+        _data->size.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t
+size()
+{
+    return get_counter_count().load(std::memory_order_acquire);
+}
+
+void
+post_process()
+{
+    if(!get_use_perfetto()) return;
+
+    auto* _instances = thread_records_data::get();
+    if(!_instances) return;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_mutex() };
+    for(auto& itr : *_instances)
+    {
+        if(itr) emit(*itr, itr->size.load(std::memory_order_acquire));
+    }
+
+    OMNITRACE_VERBOSE(1, "Post-processed %zu records of %zu user counters...\n",
+                      get_total_records(), size());
+}
+}  // namespace user_counters
+}  // namespace omnitrace
+
+//--------------------------------------------------------------------------------------//
+
+namespace user_counters = omnitrace::user_counters;
+
+extern "C" void
+omnitrace_register_counter_hidden(const char* name, const char* units, uint64_t* _handle)
+{
+    if(!name || !_handle) OMNITRACE_THROW("invalid arguments for counter registration\n");
+    *_handle = user_counters::register_counter(name, units);
+}
+
+extern "C" void
+omnitrace_record_counter_hidden(uint64_t _handle, double _value)
+{
+    user_counters::record(_handle, _value);
+}
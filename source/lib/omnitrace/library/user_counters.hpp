@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+/// user-defined counters (see omnitrace_user_counter_register). A record only appends
+/// the timestamp, the counter handle, and the value to a fixed-size buffer of the
+/// calling thread. When the buffer is full it is written to the counter tracks in
+/// perfetto at once by the thread and the remaining records of every thread are
+/// written at finalization. Each counter has one track which is shared by the threads
+namespace user_counters
+{
+/// returns the handle of the counter, which is never zero. Registering the same name
+/// again returns the same handle
+uint64_t
+register_counter(const char* _name, const char* _units);
+
+/// appends the value of the counter to the buffer of the calling thread
+void
+record(uint64_t _id, double _value);
+
+/// returns the number of registered counters
+size_t
+size();
+
+/// writes the remaining records of every thread to the perfetto trace
+void
+post_process();
+}  // namespace user_counters
+}  // namespace omnitrace
@@ -23,6 +23,7 @@
 #include "api.hpp"
 #include "core/categories.hpp"
 #include "core/config.hpp"
+#include "library/causal/data.hpp"
 #include "library/components/category_region.hpp"
 #include "library/tracing.hpp"
 
@@ -43,3 +44,16 @@ omnitrace_annotated_progress_hidden(const char*             _name,
     omnitrace::component::category_region<omnitrace::category::causal>::mark<
         omnitrace::quirk::causal>(_name, _annotations, _annotation_count);
 }
+
+extern "C" void
+omnitrace_register_progress_hidden(const char* _name, uint64_t* _handle)
+{
+    *_handle = omnitrace::causal::register_progress_point(_name);
+}
+
+extern "C" void
+omnitrace_progress_id_hidden(uint64_t _handle)
+{
+    // mark the registered progress point without hashing the name
+    omnitrace::causal::mark_registered_progress_point(_handle);
+}
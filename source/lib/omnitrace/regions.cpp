@@ -24,8 +24,21 @@
 #include "core/categories.hpp"
 #include "core/config.hpp"
 #include "library/components/category_region.hpp"
+#include "library/flight_recorder.hpp"
+#include "library/fork_capture.hpp"
+#include "library/perf_counters.hpp"
 #include "library/tracing.hpp"
 
+#include <timemory/components/timing/backends.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ratio>
+#include <unordered_map>
+#include <vector>
+
 #if defined(__GNUC__) && (__GNUC__ == 7)
 #    pragma GCC diagnostic push
 #    pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
@@ -52,7 +65,7 @@ invoke_category_region_start(omnitrace_category_t _category, const char* name,
         using category_type = category_type_id_t<Idx>;
 
         // skip if category is disabled
-        if(!trait::runtime_enabled<category_type>::get()) return;
+        if(!categories::is_enabled<category_type>()) return;
 
         component::category_region<category_type>::start(
             name, [&](::perfetto::EventContext ctx) {
@@ -87,7 +100,7 @@ invoke_category_region_stop(omnitrace_category_t _category, const char* name,
         using category_type = category_type_id_t<Idx>;
 
         // skip if category is disabled
-        if(!trait::runtime_enabled<category_type>::get()) return;
+        if(!categories::is_enabled<category_type>()) return;
 
         component::category_region<category_type>::stop(
             name, [&](::perfetto::EventContext ctx) {
@@ -106,6 +119,135 @@ invoke_category_region_stop(omnitrace_category_t _category, const char* name,
                                         std::index_sequence<Tail...>{});
     }
 }
+
+// handles are one past the index into this array so that a zero-initialized handle
+// is always invalid. Entries are written once under the registration lock and
+// published by the release store of the count so push/pop by handle are lock-free.
+constexpr size_t max_registered_regions = 4096;
+
+auto&
+get_registered_regions()
+{
+    static auto _v = std::array<tracing::region_handle, max_registered_regions>{};
+    return _v;
+}
+
+auto&
+get_registered_region_count()
+{
+    static auto _v = std::atomic<size_t>{ 0 };
+    return _v;
+}
+
+tracing::region_handle
+get_registered_region(uint64_t _handle)
+{
+    auto _n = get_registered_region_count().load(std::memory_order_acquire);
+    if(OMNITRACE_UNLIKELY(_handle == 0 || _handle > _n))
+        OMNITRACE_THROW("invalid region handle: %lu (%zu registered regions)\n",
+                        static_cast<unsigned long>(_handle), _n);
+    return get_registered_regions()[_handle - 1];
+}
+
+// run-time throttling of instrumented functions which are called very frequently and
+// take very little time. Entries are keyed on the address of the name, which is stable
+// for the strings inserted by omnitrace-instrument, and only the outermost call of a
+// recursive function is timed.
+struct throttle_entry
+{
+    uint64_t count    = 0;
+    uint64_t elapsed  = 0;
+    uint64_t start    = 0;
+    uint32_t depth    = 0;
+    bool     disabled = false;
+};
+
+constexpr size_t max_throttle_entries = 65536;
+
+auto&
+get_throttle_table()
+{
+    static thread_local auto _v = std::unordered_map<const char*, throttle_entry>{};
+    return _v;
+}
+
+// returns true if the push should be skipped
+bool
+throttle_push(const char* name)
+{
+    if(config::get_throttle_count() == 0) return false;
+
+    auto& _table = get_throttle_table();
+    auto  itr    = _table.find(name);
+    if(itr == _table.end())
+    {
+        if(_table.size() >= max_throttle_entries) return false;
+        itr = _table.emplace(name, throttle_entry{}).first;
+    }
+
+    auto& _entry = itr->second;
+    if(_entry.disabled) return true;
+    if(_entry.depth++ == 0) _entry.start = tim::get_clock_real_now<uint64_t, std::nano>();
+    return false;
+}
+
+// returns true if the pop should be skipped. A function is only disabled when it
+// is no longer on the call-stack so every push which was not skipped gets its pop.
+bool
+throttle_pop(const char* name)
+{
+    if(config::get_throttle_count() == 0) return false;
+
+    auto& _table = get_throttle_table();
+    auto  itr    = _table.find(name);
+    if(itr == _table.end()) return false;
+
+    auto& _entry = itr->second;
+    if(_entry.depth == 0) return _entry.disabled;
+    if(--_entry.depth > 0) return false;
+
+    _entry.elapsed += tim::get_clock_real_now<uint64_t, std::nano>() - _entry.start;
+    ++_entry.count;
+
+    if(_entry.count >= config::get_throttle_count() &&
+       _entry.elapsed < _entry.count * config::get_throttle_per_call_ns())
+    {
+        _entry.disabled = true;
+        OMNITRACE_VERBOSE(1,
+                          "[throttle] disabling '%s' after %lu calls (%lu nsec per call "
+                          "on average)\n",
+                          name, static_cast<unsigned long>(_entry.count),
+                          static_cast<unsigned long>(_entry.elapsed / _entry.count));
+    }
+    return false;
+}
+
+// start times of the user regions on this thread when the flight recorder has a
+// latency threshold. A pop which exceeds the threshold requests a dump
+auto&
+get_latency_stack()
+{
+    static thread_local auto _v = std::vector<uint64_t>{};
+    return _v;
+}
+
+void
+latency_push()
+{
+    if(!flight_recorder::use_latency_threshold()) return;
+    get_latency_stack().emplace_back(tim::get_clock_real_now<uint64_t, std::nano>());
+}
+
+void
+latency_pop()
+{
+    auto& _stack = get_latency_stack();
+    if(_stack.empty()) return;
+
+    auto _elapsed = tim::get_clock_real_now<uint64_t, std::nano>() - _stack.back();
+    _stack.pop_back();
+    if(flight_recorder::exceeds_latency_threshold(_elapsed)) flight_recorder::trigger();
+}
 }  // namespace
 }  // namespace impl
 }  // namespace omnitrace
@@ -115,12 +257,18 @@ invoke_category_region_stop(omnitrace_category_t _category, const char* name,
 extern "C" void
 omnitrace_push_trace_hidden(const char* name)
 {
+    if(omnitrace::impl::throttle_push(name)) return;
     omnitrace::component::category_region<omnitrace::category::host>::start(name);
+    omnitrace::perf_counters::push_region();
+    omnitrace::fork_capture::push_region();
 }
 
 extern "C" void
 omnitrace_pop_trace_hidden(const char* name)
 {
+    if(omnitrace::impl::throttle_pop(name)) return;
+    omnitrace::fork_capture::pop_region(name);
+    omnitrace::perf_counters::pop_region(name);
     omnitrace::component::category_region<omnitrace::category::host>::stop(name);
 }
 
@@ -134,12 +282,74 @@ extern "C" void
 omnitrace_push_region_hidden(const char* name)
 {
     omnitrace::component::category_region<omnitrace::category::user>::start(name);
+    omnitrace::impl::latency_push();
+    omnitrace::perf_counters::push_region();
+    omnitrace::fork_capture::push_region();
 }
 
 extern "C" void
 omnitrace_pop_region_hidden(const char* name)
 {
+    omnitrace::fork_capture::pop_region(name);
+    omnitrace::perf_counters::pop_region(name);
     omnitrace::component::category_region<omnitrace::category::user>::stop(name);
+    omnitrace::impl::latency_pop();
+}
+
+//======================================================================================//
+///
+///
+///
+//======================================================================================//
+
+extern "C" void
+omnitrace_register_region_hidden(const char* name, uint64_t* _handle)
+{
+    using namespace omnitrace::impl;
+    using hash_value_t = omnitrace::tracing::hash_value_t;
+
+    static auto _mutex   = std::mutex{};
+    static auto _handles = std::unordered_map<hash_value_t, uint64_t>{};
+
+    if(!name || !_handle) OMNITRACE_THROW("invalid arguments for region registration\n");
+
+    auto _lk   = std::unique_lock<std::mutex>{ _mutex };
+    auto _hash = tim::add_hash_id(name);
+    if(auto itr = _handles.find(_hash); itr != _handles.end())
+    {
+        *_handle = itr->second;
+        return;
+    }
+
+    auto& _count = get_registered_region_count();
+    auto  _n     = _count.load(std::memory_order_relaxed);
+    if(_n >= max_registered_regions)
+        OMNITRACE_THROW("cannot register region '%s' :: maximum of %zu regions\n", name,
+                        max_registered_regions);
+
+    get_registered_regions()[_n] = { _hash, tim::get_hash_identifier_fast(_hash) };
+    _count.store(_n + 1, std::memory_order_release);
+    *_handle = _handles[_hash] = _n + 1;
+}
+
+extern "C" void
+omnitrace_push_region_id_hidden(uint64_t _handle)
+{
+    omnitrace::component::category_region<omnitrace::category::user>::start(
+        omnitrace::impl::get_registered_region(_handle));
+    omnitrace::impl::latency_push();
+    omnitrace::perf_counters::push_region();
+    omnitrace::fork_capture::push_region();
+}
+
+extern "C" void
+omnitrace_pop_region_id_hidden(uint64_t _handle)
+{
+    auto _region = omnitrace::impl::get_registered_region(_handle);
+    omnitrace::fork_capture::pop_region(_region.name);
+    omnitrace::perf_counters::pop_region(_region.name);
+    omnitrace::component::category_region<omnitrace::category::user>::stop(_region);
+    omnitrace::impl::latency_pop();
 }
 
 //======================================================================================//
@@ -165,106 +165,54 @@ class latency_point(object):
         return sum(self.get_difference()) / rate
 
 
-class line_speedup(object):
-    def __init__(self, _name="", _prog="", _exp_data=None, _exp_base=None):
-        self.name = _name
-        self.prog = _prog
-        self.data = _exp_data
-        self.base = _exp_base
-
-    def virtual_speedup(self):
-        if self.data is None or self.base is None:
-            return 0.0
-        return self.data.speedup
-
-    def compute_speedup(self):
-        if self.data is None or self.base is None:
-            return 0.0
-        return ((self.base.mean() - self.data.mean()) / self.base.mean()) * 100
-
-    def compute_speedup_stddev(self):
-        if self.data is None or self.base is None:
-            return 0.0
-        _data = []
-        _base = self.base.mean()
-        for ditr in self.data.get_data():
-            _data += [((_base - ditr) / _base) * 100]
-        return stddev(_data)
-
-    def get_name(self):
-        return ":".join(
-            [
-                os.path.basename(x) if os.path.isfile(x) else x
-                for x in self.name.split(":")
-            ]
-        )
+def is_summary_file(file):
+    return re.search(r"-summary(-[0-9]+)?\.json$", file) is not None
 
-    def __str__(self):
-        if self.data is None or self.base is None:
-            return f"{self.name}"
-        _line_speedup = self.compute_speedup()
-        _line_stddev = self.compute_speedup_stddev()  # 3 stddev == 99.87%
-        _name = self.get_name()
-        return f"[{_name}][{self.prog}][{self.data.speedup:3}] speedup: {_line_speedup:6.1f} +/- {_line_stddev:6.2f} %"
 
-    def __eq__(self, rhs):
-        return (
-            self.name == rhs.name
-            and self.prog == rhs.prog
-            and self.data == rhs.data
-            and self.base == rhs.base
-        )
+def get_experiments_filename(file):
+    """The name of the causal JSON file of a summary"""
+    return re.sub(r"-summary(-[0-9]+)?\.json$", r"\1.json", file)
 
-    def __neq__(self, rhs):
-        return not self == rhs
 
-    def __lt__(self, rhs):
-        if self.name != rhs.name:
-            return self.name < rhs.name
-        elif self.prog != rhs.prog:
-            return self.prog < rhs.prog
-        elif self.data != rhs.data:
-            return self.data < rhs.data
-        elif self.base != rhs.base:
-            return self.base < rhs.base
-        return False
-
-
-class experiment_progress(object):
-    def __init__(self, _data):
-        self.data = _data
-
-    def get_impact(self):
-        speedup_c = [x.compute_speedup() for x in self.data]
-        speedup_v = [x.virtual_speedup() for x in self.data]
-        impact = []
-        for i in range(len(self.data) - 1):
-            x = speedup_v[i + 1] - speedup_v[i]
-            y = [speedup_c[i], speedup_c[i + 1]]
-            y_min = min(y)
-            y_max = max(y)
-            a_low = x * y_min
-            a_upp = 0.5 * x * (y_max - y_min)
-            impact += [a_low + a_upp]
-        # impact = [x.compute_speedup() for x in self.data]
-        return [sum(impact), mean(impact), stddev(impact)]
+def get_summary_filenames(file):
+    """The potential names of the summary of a causal JSON file. With
+    OMNITRACE_USE_PID=ON, the PID suffix follows the summary suffix"""
+    _base = re.sub(r"\.json$", "", file)
+    return list(
+        dict.fromkeys(
+            [
+                f"{_base}-summary.json",
+                re.sub(r"(-[0-9]+)$", r"-summary\1", _base) + ".json",
+            ]
+        )
+    )
 
-    def __len__(self):
-        return len(self.data)
-
-    def __str__(self):
-        _impact_v = self.get_impact()
-        _name = self.data[0].get_name()
-        _prog = self.data[0].prog
-        _impact = [
-            f"[{_name}][{_prog}][sum]  impact: {_impact_v[0]:6.1f}",
-            f"[{_name}][{_prog}][avg]  impact: {_impact_v[1]:6.1f} +/- {_impact_v[2]:6.2f}",
+
+def read_summary(file):
+    """Returns the causal summary written by omnitrace with the causal JSON file (or
+    the summary itself when file is a summary) unless it is older than the JSON file.
+    The summary holds the program speedup, stddev, and 95% confidence interval of each
+    (selection, progress point, virtual speedup) so the experiments do not have to be
+    loaded"""
+    if is_summary_file(file):
+        candidates = [file]
+    else:
+        candidates = [
+            x
+            for x in get_summary_filenames(file)
+            if os.path.isfile(x) and os.path.getmtime(x) >= os.path.getmtime(file)
         ]
-        return "\n".join([f"{x}" for x in self.data] + _impact)
+    for itr in candidates:
+        with open(itr, "r") as f:
+            _data = json.load(f)
+        if "omnitrace" in _data and "causal_summary" in _data["omnitrace"]:
+            return _data["omnitrace"]["causal_summary"]
+    return None
 
-    def __lt__(self, rhs):
-        self.data.sort()
-        return self.get_impact()[0] < rhs.get_impact()[0]
+
+def process_summary_samples(_summary):
+    _samples = _summary["samples"]
+    return pd.DataFrame({"location": _samples["location"], "count": _samples["count"]})
 
 
 def process_samples(data, _data):
@@ -340,120 +288,210 @@ def process_data(data, _data, experiments, progress_points):
     return data
 
 
-def compute_speedups(runs, speedups=[], num_points=0, validate=[], debug=False):
-    out = pd.DataFrame()
-    data = {}
-    for workload in runs:
-        _data = runs[workload]
-        for selected, pitr in _data.items():
-            if selected not in data:
-                data[selected] = {}
-            for progpt, ditr in pitr.items():
-                data[selected][progpt] = OrderedDict(sorted(ditr.items()))
-
-        ret = []
-        for selected, pitr in _data.items():
-            for progpt, ditr in pitr.items():
-                if 0 not in ditr.keys():
-                    print(f"missing baseline data for {progpt} in {selected}...")
-                    continue
-                for speedup, itr in ditr.items():
-                    if len(speedups) > 0 and speedup not in speedups:
+def get_point_name(_name):
+    return ":".join(
+        [os.path.basename(x) if os.path.isfile(x) else x for x in _name.split(":")]
+    )
+
+
+# the per-speedup fields of the curves of the causal summary
+summary_columns = [
+    "virtual_speedup",
+    "program_speedup",
+    "speedup_stddev",
+    "speedup_ci95",
+    "experiments",
+]
+
+
+def get_impact(_virtual_speedup, _program_speedup):
+    """The area below each segment of the speedup curve"""
+    _x = np.diff(np.asarray(_virtual_speedup, dtype=float))
+    _y = np.asarray(_program_speedup, dtype=float)
+    _area = 0.5 * _x * (_y[:-1] + _y[1:])
+    if len(_area) == 0:
+        return [0.0, 0.0, 0.0]
+    return [
+        float(np.sum(_area)),
+        float(np.mean(_area)),
+        float(num_stddev) * float(np.std(_area)),
+    ]
+
+
+def summarize_data(data):
+    """Builds the curves of the causal summary (see read_summary) from the output of
+    process_data. Only used when there is no up-to-date summary"""
+    curves = []
+    for selected, pitr in data.items():
+        for progpt, ditr in pitr.items():
+            if 0 not in ditr.keys():
+                print(f"missing baseline data for {progpt} in {selected}...")
+                continue
+            _base = ditr[0].mean()
+            _curve = {
+                "selection": selected,
+                "progress_point": progpt,
+                "type": "latency" if isinstance(ditr[0], latency_point) else "throughput",
+                "virtual_speedup": sorted(ditr.keys()),
+                "program_speedup": [],
+                "speedup_stddev": [],
+                "speedup_ci95": [],
+                "experiments": [],
+            }
+            for speedup in _curve["virtual_speedup"]:
+                itr = ditr[speedup]
+                if speedup != itr.speedup:
+                    raise ValueError(f"in {selected}: {speedup} != {itr.speedup}")
+                _v = 100.0 * (_base - np.asarray(itr.get_data(), dtype=float)) / _base
+                _n = len(_v)
+                _curve["program_speedup"].append(100.0 * (_base - itr.mean()) / _base)
+                _curve["speedup_stddev"].append(float(np.std(_v)))
+                _curve["speedup_ci95"].append(
+                    1.96 * float(np.std(_v, ddof=1)) / math.sqrt(_n) if _n > 1 else 0.0
+                )
+                _curve["experiments"].append(_n)
+            curves.append(_curve)
+    return curves
+
+
+def filter_summary(curves, experiments=".*", progress_points=".*", speedups=[]):
+    """Applies the filters of process_data and compute_speedups to the curves"""
+    _selection_filter = re.compile(experiments)
+    _progresspt_filter = re.compile(progress_points)
+    result = []
+    for itr in curves:
+        if not re.search(_selection_filter, itr["selection"]) or not re.search(
+            _progresspt_filter, itr["progress_point"]
+        ):
+            continue
+        _curve = dict(itr)
+        for key in summary_columns:
+            _curve[key] = np.asarray(itr[key])
+        if len(speedups) > 0:
+            _mask = np.isin(_curve["virtual_speedup"], speedups)
+            for key in summary_columns:
+                _curve[key] = _curve[key][_mask]
+        if len(_curve["virtual_speedup"]) == 0:
+            continue
+        result.append(_curve)
+    # same order as the individual speedups were sorted when computed from the experiments
+    result.sort(key=lambda x: (x["selection"], x["progress_point"]))
+    return result
+
+
+def validate_summary(curves, validate):
+    validations = get_validations(validate)
+    expected_validations = len(validations)
+    correct_validations = 0
+    if expected_validations > 0:
+        print(f"\nPerforming {expected_validations} validations...\n")
+        for citr in curves:
+            _experiment = get_point_name(citr["selection"])
+            _progresspt = citr["progress_point"]
+            _stddev = float(num_stddev) * citr["speedup_stddev"]
+            _base_speedup_stddev = _stddev[0]
+            for _virt_speedup, _prog_speedup, _prog_speedup_stddev in zip(
+                citr["virtual_speedup"], citr["program_speedup"], _stddev
+            ):
+                for vitr in validations:
+                    _v = vitr.validate(
+                        _experiment,
+                        _progresspt,
+                        _virt_speedup,
+                        _prog_speedup,
+                        _prog_speedup_stddev,
+                        _base_speedup_stddev,
+                    )
+                    if _v is None:
                         continue
-                    if speedup != itr.speedup:
-                        raise ValueError(f"in {selected}: {speedup} != {itr.speedup}")
-                    _val = line_speedup(selected, progpt, itr, ditr[0])
-                    ret.append(_val)
-        ret.sort()
-        _last_name = None
-        _last_prog = None
-        result = []
-        for itr in ret:
-            if itr.name != _last_name or itr.prog != _last_prog:
-                result.append([])
-            result[-1].append(itr)
-            _last_name = itr.name
-            _last_prog = itr.prog
-            _data = []
-        for itr in result:
-            experiment_prog = experiment_progress(itr)
-            _data.append(experiment_prog)
-            if len(itr) != 0:
-                impact = experiment_prog.get_impact()
-                for itrx in itr:
-                    speedup = itrx.compute_speedup()
-                    line_stddev = itrx.compute_speedup_stddev()
-                    if speedup <= 200 and speedup >= -100:
-                        out = pd.concat(
-                            [
-                                out,
-                                pd.DataFrame(
-                                    {
-                                        "idx": [(itrx.prog, itrx.name)],
-                                        "progress points": [itrx.prog],
-                                        "point": [itrx.name],
-                                        "line speedup": [itrx.virtual_speedup()],
-                                        "program speedup": [speedup],
-                                        "speedup err": line_stddev,
-                                        "impact sum": impact[0],
-                                        "impact avg": impact[1],
-                                        "impact err": float(impact[2]),
-                                        "workload": workload,
-                                    }
-                                ),
-                            ],
-                            ignore_index=True,
+                    if _v is True:
+                        correct_validations += 1
+                    else:
+                        sys.stderr.write(
+                            f"  [{_experiment}][{_progresspt}][{_virt_speedup}] failed validation: {_prog_speedup:8.3f} != {vitr.program_speedup} +/- {vitr.tolerance}\n"
                         )
-        _data.sort()
+    if expected_validations != correct_validations:
+        sys.stderr.flush()
+        sys.stderr.write(
+            f"\nCausal profiling predictions not validated. Expected {expected_validations}, found {correct_validations}\n"
+        )
+        sys.stderr.flush()
+        sys.exit(-1)
+    elif expected_validations > 0:
+        print(f"Causal profiling predictions validated: {expected_validations}")
+
+
+def compute_summary_speedups(
+    summaries, speedups=[], num_points=0, validate=[], debug=False
+):
+    """Builds the speedup table of each workload from the (filtered) curves"""
+    frames = []
+    for workload, curves in summaries.items():
+        debug_curves = []
+        for citr in curves:
+            _virt = citr["virtual_speedup"]
+            _prog = citr["program_speedup"]
+            _err = float(num_stddev) * citr["speedup_stddev"]
+            _impact = get_impact(_virt, _prog)
+            if len(_virt) >= num_points:
+                debug_curves.append((_impact[0], citr, _err, _impact))
+            _mask = (_prog <= 200) & (_prog >= -100)
+            _num = int(np.count_nonzero(_mask))
+            if _num == 0:
+                continue
+            _idx = (citr["progress_point"], citr["selection"])
+            frames.append(
+                pd.DataFrame(
+                    {
+                        "idx": [_idx] * _num,
+                        "progress points": citr["progress_point"],
+                        "point": citr["selection"],
+                        "line speedup": _virt[_mask],
+                        "program speedup": _prog[_mask],
+                        "speedup err": _err[_mask],
+                        "impact sum": _impact[0],
+                        "impact avg": _impact[1],
+                        "impact err": _impact[2],
+                        "workload": workload,
+                    }
+                )
+            )
 
         if debug:
-            for itr in _data:
-                if len(itr) < num_points:
-                    continue
+            debug_curves.sort(key=lambda x: x[0])
+            for _, citr, _err, _impact in debug_curves:
+                _name = get_point_name(citr["selection"])
+                _prog = citr["progress_point"]
                 print("")
-                print(f"{itr}")
+                for _virt, _speedup, _stddev in zip(
+                    citr["virtual_speedup"], citr["program_speedup"], _err
+                ):
+                    print(
+                        f"[{_name}][{_prog}][{_virt:3}] speedup: {_speedup:6.1f} +/- {_stddev:6.2f} %"
+                    )
+                print(f"[{_name}][{_prog}][sum]  impact: {_impact[0]:6.1f}")
+                print(
+                    f"[{_name}][{_prog}][avg]  impact: {_impact[1]:6.1f} +/- {_impact[2]:6.2f}"
+                )
         sys.stdout.flush()
-        validations = get_validations(validate)
-        expected_validations = len(validations)
-        correct_validations = 0
-        if expected_validations > 0:
-            print(f"\nPerforming {expected_validations} validations...\n")
-            for eitr in _data:
-                _experiment = eitr.data[0].get_name()
-                _progresspt = eitr.data[0].prog
-                _base_speedup_stddev = eitr.data[0].compute_speedup_stddev()
-                for ditr in eitr.data:
-                    _virt_speedup = ditr.virtual_speedup()
-                    _prog_speedup = ditr.compute_speedup()
-                    _prog_speedup_stddev = ditr.compute_speedup_stddev()
-                    for vitr in validations:
-                        _v = vitr.validate(
-                            _experiment,
-                            _progresspt,
-                            _virt_speedup,
-                            _prog_speedup,
-                            _prog_speedup_stddev,
-                            _base_speedup_stddev,
-                        )
-                        if _v is None:
-                            continue
-                        if _v is True:
-                            correct_validations += 1
-                        else:
-                            sys.stderr.write(
-                                f"  [{_experiment}][{_progresspt}][{_virt_speedup}] failed validation: {_prog_speedup:8.3f} != {vitr.program_speedup} +/- {vitr.tolerance}\n"
-                            )
-        if expected_validations != correct_validations:
-            sys.stderr.flush()
-            sys.stderr.write(
-                f"\nCausal profiling predictions not validated. Expected {expected_validations}, found {correct_validations}\n"
-            )
-            sys.stderr.flush()
-            sys.exit(-1)
-        elif expected_validations > 0:
-            print(f"Causal profiling predictions validated: {expected_validations}")
+        validate_summary(curves, validate)
 
-    return out
+    if len(frames) == 0:
+        return pd.DataFrame()
+    return pd.concat(frames, ignore_index=True)
+
+
+def compute_speedups(runs, speedups=[], num_points=0, validate=[], debug=False):
+    return compute_summary_speedups(
+        {
+            workload: filter_summary(summarize_data(data), speedups=speedups)
+            for workload, data in runs.items()
+        },
+        speedups,
+        num_points,
+        validate,
+        debug,
+    )
 
 
 def get_validations(validate):
@@ -477,27 +515,16 @@ def get_validations(validate):
 
 
 def compute_sorts(_data):
-    Max_speedup_order = _data.sort_values(
-        by="program speedup", ascending=False
-    ).point.unique()
-    Min_speedup_order = _data.sort_values(
-        by="program speedup", ascending=True
-    ).point.unique()
-    point_counts = _data.point.value_counts()
-    # speedups = pd.DataFrame(_data["Line Speedup"].unique(), columns=["Line Speedup"])
-
-    _data["max speedup"] = np.nan
-    _data["min speedup"] = np.nan
-    _data["point count"] = np.nan
-
-    for index in _data.index:
-        _data.at[index, "max speedup"] = np.where(
-            Max_speedup_order == _data.at[index, "point"]
-        )[0][0]
-        _data.at[index, "min speedup"] = np.where(
-            Min_speedup_order == _data.at[index, "point"]
-        )[0][0]
-        _data.at[index, "point count"] = point_counts[_data.at[index, "point"]]
+    if _data.empty:
+        return _data
+
+    def get_order(_ascending):
+        _order = _data.sort_values(by="program speedup", ascending=_ascending)
+        return {x: float(i) for i, x in enumerate(_order.point.unique())}
+
+    _data["max speedup"] = _data.point.map(get_order(False))
+    _data["min speedup"] = _data.point.map(get_order(True))
+    _data["point count"] = _data.point.map(_data.point.value_counts()).astype(float)
     return _data
 
 
@@ -594,13 +621,22 @@ def parse_files(
     read_files = []
     file_names = []
 
+    # the summaries are read with their causal JSON file
+    json_files = [
+        x
+        for x in json_files
+        if not is_summary_file(x) or get_experiments_filename(x) not in json_files
+    ]
+
     # prefer JSON files first
     files = json_files + coz_files
     for file in files:
         if verbose >= 3:
             print(f"Potentially reading causal profile: '{file}'...")
 
-        _base_name = name_wo_ext(file)
+        _base_name = name_wo_ext(
+            get_experiments_filename(file) if is_summary_file(file) else file
+        )
         # do not read in a COZ file if the JSON already read
         if _base_name in read_files:
             continue
@@ -609,41 +645,46 @@ def parse_files(
             print(f"Reading causal profile: '{file}'...")
 
         if file.endswith(".json"):
-            with open(file, "r") as j:
-                _data = json.load(j)
-                dict_data = {}
+            # the experiments are only reprocessed when there is no up-to-date summary
+            _summary = read_summary(file)
+            if _summary is not None:
+                curves = filter_summary(
+                    _summary["curves"], experiments, progress_points, speedups
+                )
+                samps = process_summary_samples(_summary)
+            elif is_summary_file(file):
+                continue
+            else:
+                with open(file, "r") as j:
+                    _data = json.load(j)
                 # make sure the JSON is an omnitrace causal JSON
                 if "omnitrace" not in _data or "causal" not in _data["omnitrace"]:
                     continue
-                dict_data[file] = process_data({}, _data, experiments, progress_points)
-                samps = process_samples({}, _data)
-                sample_df = pd.concat(
+                _runs = process_data({}, _data, experiments, progress_points)
+                curves = filter_summary(summarize_data(_runs), speedups=speedups)
+                samps = pd.DataFrame(
                     [
-                        sample_df,
-                        pd.DataFrame(
-                            [
-                                {"location": loc, "count": count}
-                                for loc, count in sorted(samps.items())
-                            ]
-                        ),
+                        {"location": loc, "count": count}
+                        for loc, count in sorted(process_samples({}, _data).items())
                     ]
                 )
-                result_df = pd.concat(
-                    [
-                        result_df,
-                        compute_sorts(
-                            compute_speedups(
-                                dict_data,
-                                speedups,
-                                num_points,
-                                validate,
-                                verbose >= 3 or cli,
-                            )
-                        ),
-                    ]
-                )
-                read_files.append(_base_name)
-                file_names.append(file)
+            sample_df = pd.concat([sample_df, samps])
+            result_df = pd.concat(
+                [
+                    result_df,
+                    compute_sorts(
+                        compute_summary_speedups(
+                            {file: curves},
+                            speedups,
+                            num_points,
+                            validate,
+                            verbose >= 3 or cli,
+                        )
+                    ),
+                ]
+            )
+            read_files.append(_base_name)
+            file_names.append(file)
 
         elif file.endswith(".coz"):
             try:
@@ -716,6 +757,12 @@ def parse_uploaded_file(file_name, file, experiments=".*", progress_points=".*")
         dict_data = {}
         _data = json.loads(file)
 
+        if "omnitrace" in _data and "causal_summary" in _data["omnitrace"]:
+            _summary = _data["omnitrace"]["causal_summary"]
+            curves = filter_summary(_summary["curves"], experiments, progress_points)
+            data = compute_sorts(compute_summary_speedups({file_name: curves}))
+            return data, process_summary_samples(_summary)
+
         dict_data = {
             file_name: process_data(dict_data, _data, experiments, progress_points)
         }
@@ -828,6 +875,10 @@ def find_causal_files(workload_path, verbose, recursive):
         _input_files_tmp = []
         for itr in _files:
             if os.path.isfile(itr) and itr.endswith(".json"):
+                # avoid loading the experiments when there is a summary
+                if is_summary_file(itr) or read_summary(itr) is not None:
+                    _input_files_tmp += [itr]
+                    continue
                 with open(itr, "r") as f:
                     inp_data = json.load(f)
                     if (
@@ -45,13 +45,16 @@
 #include <pyerrors.h>
 
 #include <cctype>
+#include <atomic>
 #include <cstdint>
 #include <exception>
 #include <locale>
+#include <map>
 #include <regex>
 #include <set>
 #include <stdexcept>
 #include <unordered_map>
+#include <unordered_set>
 
 #define OMNITRACE_PYTHON_VERSION                                                         \
     ((10000 * PY_MAJOR_VERSION) + (100 * PY_MINOR_VERSION) + PY_MICRO_VERSION)
@@ -73,6 +76,11 @@ namespace pyuser
 py::module
 generate(py::module& _pymod);
 }
+namespace pysampling
+{
+void
+setup();
+}
 }  // namespace pyomnitrace
 
 template <typename... Tp>
@@ -113,6 +121,7 @@ PYBIND11_MODULE(libpyomnitrace, omni)
                 throw std::runtime_error("Error! omnitrace is already initialized");
             _is_initialized = true;
             omnitrace_set_mpi(_get_use_mpi(), false);
+            pysampling::setup();
             omnitrace_init("trace", false, _v.c_str());
         },
         "Initialize omnitrace");
@@ -126,6 +135,7 @@ PYBIND11_MODULE(libpyomnitrace, omni)
             omnitrace_set_instrumented(
                 static_cast<int>(omnitrace::dl::InstrumentMode::PythonProfile));
             omnitrace_set_mpi(_get_use_mpi(), false);
+            pysampling::setup();
             std::string _cmd      = {};
             std::string _cmd_line = {};
             for(auto&& itr : _v)
@@ -285,261 +295,438 @@ get_frame_lasti(PyFrameObject* frame)
 #endif
 }
 //
-auto
+// returns a borrowed reference, the frame holds a reference to its code object
+PyCodeObject*
 get_frame_code(PyFrameObject* frame)
 {
 #if OMNITRACE_PYTHON_VERSION >= 31100
-    return PyFrame_GetCode(frame);
+    auto* _code = PyFrame_GetCode(frame);
+    Py_XDECREF(_code);
+    return _code;
 #else
     return frame->f_code;
 #endif
 }
 //
-void
-profiler_function(py::object pframe, const char* swhat, py::object arg)
+// the decision and the label of a code object only depend on the configuration, its
+// name, and its filename so they are evaluated on the first event of the code object
+struct code_entry
 {
-    if(get_paused() > 0) return;
-
-    static thread_local auto& _config  = get_config();
-    static thread_local auto  _disable = false;
-
-    if(_disable) return;
-
-    _disable = true;
-    tim::scope::destructor _dtor{ []() { _disable= false; } };
-    (void) _dtor;
-
-    if(pframe.is_none() || pframe.ptr() == nullptr) return;
-
-    static auto _omnitrace_path = _config.base_module_path;
-
-    auto* frame = reinterpret_cast<PyFrameObject*>(pframe.ptr());
-
-    int what = (strcmp(swhat, "call") == 0)       ? PyTrace_CALL
-               : (strcmp(swhat, "c_call") == 0)   ? PyTrace_C_CALL
-               : (strcmp(swhat, "return") == 0)   ? PyTrace_RETURN
-               : (strcmp(swhat, "c_return") == 0) ? PyTrace_C_RETURN
-                                                  : -1;
-    // only support PyTrace_{CALL,C_CALL,RETURN,C_RETURN}
-    if(what < 0)
+    enum decision_t : uint8_t
     {
-        if(_config.verbose > 2)
-            TIMEMORY_PRINT_HERE("%s :: %s",
-                                "Ignoring what != {CALL,C_CALL,RETURN,C_RETURN}", swhat);
-        return;
-    }
-
-    auto _update_ignore_stack_depth = [what]() {
-        switch(what)
-        {
-            case PyTrace_CALL: ++_config.ignore_stack_depth; break;
-            case PyTrace_RETURN: --_config.ignore_stack_depth; break;
-            default: break;
-        }
+        RECORD = 0,
+        SKIP,
+        SKIP_AND_IGNORE,  // also skips everything called by the code object
     };
 
-    if(_config.ignore_stack_depth > 0)
+    decision_t                                   decision = RECORD;
+    std::string                                  func     = {};
+    std::string                                  file     = {};
+    std::string                                  full     = {};
+    const std::string*                           label    = nullptr;
+    std::unordered_map<int, const std::string*> lines    = {};  // see include_line
+};
+//
+// the code objects are referenced by the cache so that their address is not reused. The
+// cache of every thread is cleared when the profiler is initialized
+struct code_cache
+{
+    uint64_t                                       generation = 0;
+    std::unordered_map<PyCodeObject*, code_entry> entries    = {};
+};
+//
+auto&
+get_code_cache_generation()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+//
+auto&
+get_code_cache()
+{
+    static thread_local auto* _v = new code_cache{};
+    return *_v;
+}
+//
+// labels referred to by the records of the regions, never released
+const std::string*
+get_label_ref(std::string&& _label)
+{
+    static thread_local auto* _labels = new strset_t{};
+    return &(*_labels->emplace(std::move(_label)).first);
+}
+//
+// the callable passed to sys.setprofile and returned by sys.getprofile
+auto&
+get_profiler_object()
+{
+    static auto* _v = new py::object{};
+    return *_v;
+}
+//
+bool
+find_matching(const strset_t& _expr, const std::string& _name)
+{
+    const auto _rconstants = std::regex_constants::egrep | std::regex_constants::optimize;
+    for(const auto& itr : _expr)  // NOLINT
     {
-        if(_config.verbose > 2)
-            TIMEMORY_PRINT_HERE("%s :: %s :: %u", "Ignoring call/return", swhat,
-                                _config.ignore_stack_depth);
-        _update_ignore_stack_depth();
-        return;
+        if(std::regex_search(_name, std::regex(itr, _rconstants))) return true;
     }
-    else if(_config.ignore_stack_depth < 0)
+    return false;
+}
+//
+std::string
+get_args(PyFrameObject* frame)
+{
+    auto& _config = get_config();
+    auto  inspect = py::module::import("inspect");
+    try
     {
-        TIMEMORY_PRINT_HERE("WARNING! ignore_stack_depth is < 0 :: ",
-                            _config.ignore_stack_depth);
+        auto _pframe = py::reinterpret_borrow<py::object>(
+            reinterpret_cast<PyObject*>(frame));
+        return py::cast<std::string>(
+            inspect.attr("formatargvalues")(*inspect.attr("getargvalues")(_pframe)));
+    } catch(py::error_already_set& _exc)
+    {
+        TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 1, "Error! %s", _exc.what());
+        if(!_exc.matches(PyExc_AttributeError)) throw;
     }
-
-    // if PyTrace_C_{CALL,RETURN} is not enabled
-    if(!_config.trace_c && (what == PyTrace_C_CALL || what == PyTrace_C_RETURN))
+    return std::string{};
+}
+//
+std::string
+get_label(const code_entry& _entry, const std::string& _args, int _lineno)
+{
+    auto& _config   = get_config();
+    auto  _funcname = _entry.func;
+    auto  _bracket  = _config.include_filename;
+    if(_bracket) _funcname.insert(0, "[");
+    // append the arguments
+    if(_config.include_args) _funcname.append(_args);
+    if(_bracket) _funcname.append("]");
+    // append the filename
+    if(_config.include_filename)
     {
-        if(_config.verbose > 2)
-            TIMEMORY_PRINT_HERE("%s :: %s", "Ignoring C call/return", swhat);
-        return;
+        if(_config.full_filepath)
+            _funcname.append(TIMEMORY_JOIN("", '[', _entry.full));
+        else
+            _funcname.append(TIMEMORY_JOIN("", '[', _entry.file));
     }
+    // append the line number
+    if(_config.include_line && _config.include_filename)
+        _funcname.append(TIMEMORY_JOIN("", ':', _lineno, ']'));
+    else if(_config.include_line)
+        _funcname.append(TIMEMORY_JOIN("", ':', _lineno));
+    else if(_config.include_filename)
+        _funcname += "]";
+    return _funcname;
+}
+//
+code_entry
+make_code_entry(PyCodeObject* _code)
+{
+    static auto _omnitrace_path = get_config().base_module_path;
 
-    // get the arguments
-    auto _get_args = [&]() {
-        auto inspect = py::module::import("inspect");
-        try
-        {
-            return py::cast<std::string>(
-                inspect.attr("formatargvalues")(*inspect.attr("getargvalues")(pframe)));
-        } catch(py::error_already_set& _exc)
-        {
-            TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 1, "Error! %s",
-                                            _exc.what());
-            if(!_exc.matches(PyExc_AttributeError)) throw;
-        }
-        return std::string{};
-    };
-
-    // get the final label
-    auto _get_label = [&](auto& _funcname, auto& _filename, auto& _fullpath) {
-        auto _bracket = _config.include_filename;
-        if(_bracket) _funcname.insert(0, "[");
-        // append the arguments
-        if(_config.include_args) _funcname.append(_get_args());
-        if(_bracket) _funcname.append("]");
-        // append the filename
-        if(_config.include_filename)
-        {
-            if(_config.full_filepath)
-                _funcname.append(TIMEMORY_JOIN("", '[', std::move(_fullpath)));
-            else
-                _funcname.append(TIMEMORY_JOIN("", '[', std::move(_filename)));
-        }
-        // append the line number
-        if(_config.include_line && _config.include_filename)
-            _funcname.append(TIMEMORY_JOIN("", ':', get_frame_lineno(frame), ']'));
-        else if(_config.include_line)
-            _funcname.append(TIMEMORY_JOIN("", ':', get_frame_lineno(frame)));
-        else if(_config.include_filename)
-            _funcname += "]";
-        return _funcname;
-    };
+    auto& _config = get_config();
+    auto  _entry  = code_entry{};
+    _entry.func   = py::cast<std::string>(_code->co_name);
+    _entry.full   = py::cast<std::string>(_code->co_filename);
+    _entry.file   = (_entry.full.find('/') != std::string::npos)
+                        ? _entry.full.substr(_entry.full.find_last_of('/') + 1)
+                        : _entry.full;
 
-    auto _find_matching = [](const strset_t& _expr, const std::string& _name) {
-        const auto _rconstants =
-            std::regex_constants::egrep | std::regex_constants::optimize;
-        for(const auto& itr : _expr)  // NOLINT
-        {
-            if(std::regex_search(_name, std::regex(itr, _rconstants))) return true;
-        }
-        return false;
-    };
+    const auto& _func = _entry.func;
+    const auto& _full = _entry.full;
 
     bool  _force      = false;
     auto& _only_funcs = _config.restrict_functions;
     auto& _incl_funcs = _config.include_functions;
     auto& _skip_funcs = _config.exclude_functions;
-    auto  _func       = py::cast<std::string>(get_frame_code(frame)->co_name);
 
     if(!_only_funcs.empty())
     {
-        _force = _find_matching(_only_funcs, _func);
+        _force = find_matching(_only_funcs, _func);
         if(!_force)
         {
             if(_config.verbose > 2)
                 TIMEMORY_PRINT_HERE("Skipping non-restricted function: %s",
                                     _func.c_str());
-            return;
+            _entry.decision = code_entry::SKIP;
+            return _entry;
         }
     }
 
     if(!_force)
     {
-        if(_find_matching(_incl_funcs, _func))
+        if(find_matching(_incl_funcs, _func))
         {
             _force = true;
         }
-        else if(_find_matching(_skip_funcs, _func))
+        else if(find_matching(_skip_funcs, _func))
         {
             if(_config.verbose > 1)
                 TIMEMORY_PRINT_HERE("Skipping designated function: '%s'", _func.c_str());
-            if(!_find_matching(default_exclude_functions, _func))
-                _update_ignore_stack_depth();
-            return;
+            _entry.decision = (!find_matching(default_exclude_functions, _func))
+                                  ? code_entry::SKIP_AND_IGNORE
+                                  : code_entry::SKIP;
+            return _entry;
         }
     }
 
     auto& _only_files = _config.restrict_filenames;
     auto& _incl_files = _config.include_filenames;
     auto& _skip_files = _config.exclude_filenames;
-    auto  _full       = py::cast<std::string>(get_frame_code(frame)->co_filename);
-    auto  _file       = (_full.find('/') != std::string::npos)
-                            ? _full.substr(_full.find_last_of('/') + 1)
-                            : _full;
 
     if(!_config.include_internal &&
        strncmp(_full.c_str(), _omnitrace_path.c_str(), _omnitrace_path.length()) == 0)
     {
         if(_config.verbose > 2)
             TIMEMORY_PRINT_HERE("Skipping internal function: %s", _func.c_str());
-        return;
+        _entry.decision = code_entry::SKIP;
+        return _entry;
     }
 
     if(!_force && !_only_files.empty())
     {
-        _force = _find_matching(_only_files, _full);
+        _force = find_matching(_only_files, _full);
         if(!_force)
         {
             if(_config.verbose > 2)
                 TIMEMORY_PRINT_HERE("Skipping non-restricted file: %s", _full.c_str());
-            return;
+            _entry.decision = code_entry::SKIP;
+            return _entry;
         }
     }
 
     if(!_force)
     {
-        if(_find_matching(_incl_files, _full))
+        if(find_matching(_incl_files, _full))
         {
             _force = true;
         }
-        else if(_find_matching(_skip_files, _full))
+        else if(find_matching(_skip_files, _full))
         {
             if(_config.verbose > 2)
                 TIMEMORY_PRINT_HERE("Skipping non-included file: %s", _full.c_str());
-            return;
+            _entry.decision = code_entry::SKIP;
+            return _entry;
         }
     }
 
-    TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 3, "%8s | %s%s | %s | %s", swhat,
-                                    _func.c_str(), _get_args().c_str(), _file.c_str(),
-                                    _full.c_str());
+    if(!_config.include_args && !_config.include_line)
+    {
+        auto _label = get_label(_entry, std::string{}, 0);
+        if(_label.empty())
+            _entry.decision = code_entry::SKIP;
+        else
+            _entry.label = get_label_ref(std::move(_label));
+    }
 
-    auto _label = _get_label(_func, _file, _full);
-    if(_label.empty()) return;
+    return _entry;
+}
+//
+code_entry&
+get_code_entry(PyCodeObject* _code)
+{
+    auto& _cache      = get_code_cache();
+    auto  _generation = get_code_cache_generation().load(std::memory_order_relaxed);
+    if(_cache.generation != _generation)
+    {
+        for(auto& itr : _cache.entries)
+            Py_DECREF(itr.first);
+        _cache.entries.clear();
+        _cache.generation = _generation;
+    }
 
-    static thread_local strset_t _labels{};
-    const auto&                  _label_ref = *_labels.emplace(_label).first;
-    auto                         _annotate  = _config.annotate_trace;
+    auto itr = _cache.entries.find(_code);
+    if(itr != _cache.entries.end()) return itr->second;
 
-    // start function
-    auto _profiler_call = [&]() {
-        int _lineno = 0;
-        int _lasti  = 0;
-        if(_annotate)
+    auto _entry = make_code_entry(_code);
+    Py_INCREF(_code);
+    return _cache.entries.emplace(_code, std::move(_entry)).first->second;
+}
+//
+// the label of the event when it is not fully determined by the code object
+const std::string*
+get_label_ref(code_entry& _entry, PyFrameObject* frame)
+{
+    auto& _config = get_config();
+
+    if(_entry.label) return _entry.label;
+
+    if(_config.include_args)
+    {
+        auto _label = get_label(_entry, get_args(frame), get_frame_lineno(frame));
+        if(_label.empty()) return nullptr;
+        return get_label_ref(std::move(_label));
+    }
+
+    auto _lineno = get_frame_lineno(frame);
+    auto itr     = _entry.lines.find(_lineno);
+    if(itr != _entry.lines.end()) return itr->second;
+
+    auto _label = get_label(_entry, std::string{}, _lineno);
+    return _entry.lines
+        .emplace(_lineno, (_label.empty()) ? nullptr : get_label_ref(std::move(_label)))
+        .first->second;
+}
+//
+void
+profiler_event(PyFrameObject* frame, int what)
+{
+    if(get_paused() > 0) return;
+
+    static thread_local auto& _config  = get_config();
+    static thread_local auto  _disable = false;
+
+    if(_disable || frame == nullptr) return;
+
+    _disable = true;
+    tim::scope::destructor _dtor{ []() { _disable = false; } };
+    (void) _dtor;
+
+    // only support PyTrace_{CALL,C_CALL,RETURN,C_RETURN}. A C function which raises
+    // generates PyTrace_C_EXCEPTION instead of PyTrace_C_RETURN
+    if(what == PyTrace_C_EXCEPTION) what = PyTrace_C_RETURN;
+    if(what != PyTrace_CALL && what != PyTrace_C_CALL && what != PyTrace_RETURN &&
+       what != PyTrace_C_RETURN)
+    {
+        if(_config.verbose > 2)
+            TIMEMORY_PRINT_HERE("%s :: %i",
+                                "Ignoring what != {CALL,C_CALL,RETURN,C_RETURN}", what);
+        return;
+    }
+
+    auto _update_ignore_stack_depth = [what]() {
+        switch(what)
         {
-            _lineno                         = get_frame_lineno(frame);
-            _lasti                          = get_frame_lasti(frame);
-            _config.annotations.at(0).value = const_cast<char*>(_full.c_str());
-            _config.annotations.at(1).value = &_lineno;
-            _config.annotations.at(2).value = &_lasti;
-            _config.annotations.at(3).value = &get_frame_code(frame)->co_argcount;
-            _config.annotations.at(4).value = &get_frame_code(frame)->co_nlocals;
-            _config.annotations.at(5).value = &get_frame_code(frame)->co_stacksize;
+            case PyTrace_CALL: ++_config.ignore_stack_depth; break;
+            case PyTrace_RETURN: --_config.ignore_stack_depth; break;
+            default: break;
         }
-
-        _config.records.emplace_back([&_label_ref, _annotate]() {
-            omnitrace_pop_category_region(OMNITRACE_CATEGORY_PYTHON, _label_ref.c_str(),
-                                          (_annotate) ? _config.annotations.data()
-                                                      : nullptr,
-                                          _config.annotations.size());
-        });
-        omnitrace_push_category_region(OMNITRACE_CATEGORY_PYTHON, _label_ref.c_str(),
-                                       (_annotate) ? _config.annotations.data() : nullptr,
-                                       _config.annotations.size());
     };
 
+    if(_config.ignore_stack_depth > 0)
+    {
+        if(_config.verbose > 2)
+            TIMEMORY_PRINT_HERE("%s :: %i :: %u", "Ignoring call/return", what,
+                                _config.ignore_stack_depth);
+        _update_ignore_stack_depth();
+        return;
+    }
+    else if(_config.ignore_stack_depth < 0)
+    {
+        TIMEMORY_PRINT_HERE("WARNING! ignore_stack_depth is < 0 :: ",
+                            _config.ignore_stack_depth);
+    }
+
+    // if PyTrace_C_{CALL,RETURN} is not enabled
+    if(!_config.trace_c && (what == PyTrace_C_CALL || what == PyTrace_C_RETURN))
+    {
+        if(_config.verbose > 2)
+            TIMEMORY_PRINT_HERE("%s :: %i", "Ignoring C call/return", what);
+        return;
+    }
+
     // stop function
-    auto _profiler_return = [&]() {
+    if(what == PyTrace_RETURN || what == PyTrace_C_RETURN)
+    {
+        if(_config.records.empty()) return;
         _config.records.back()();
         _config.records.pop_back();
-    };
+        return;
+    }
 
-    // process what
-    switch(what)
+    auto* _code  = get_frame_code(frame);
+    auto& _entry = get_code_entry(_code);
+
+    switch(_entry.decision)
+    {
+        case code_entry::RECORD: break;
+        case code_entry::SKIP: return;
+        case code_entry::SKIP_AND_IGNORE: _update_ignore_stack_depth(); return;
+    }
+
+    TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 3, "%8i | %s%s | %s | %s", what,
+                                    _entry.func.c_str(), get_args(frame).c_str(),
+                                    _entry.file.c_str(), _entry.full.c_str());
+
+    const auto* _label_ref = get_label_ref(_entry, frame);
+    if(!_label_ref) return;
+
+    // start function
+    auto _annotate = _config.annotate_trace;
+    int  _lineno   = 0;
+    int  _lasti    = 0;
+    if(_annotate)
     {
-        case PyTrace_CALL:
-        case PyTrace_C_CALL: _profiler_call(); break;
-        case PyTrace_RETURN:
-        case PyTrace_C_RETURN: _profiler_return(); break;
-        default: break;
+        _lineno                         = get_frame_lineno(frame);
+        _lasti                          = get_frame_lasti(frame);
+        _config.annotations.at(0).value = const_cast<char*>(_entry.full.c_str());
+        _config.annotations.at(1).value = &_lineno;
+        _config.annotations.at(2).value = &_lasti;
+        _config.annotations.at(3).value = &_code->co_argcount;
+        _config.annotations.at(4).value = &_code->co_nlocals;
+        _config.annotations.at(5).value = &_code->co_stacksize;
     }
 
+    _config.records.emplace_back([_label_ref, _annotate]() {
+        omnitrace_pop_category_region(OMNITRACE_CATEGORY_PYTHON, _label_ref->c_str(),
+                                      (_annotate) ? _config.annotations.data() : nullptr,
+                                      _config.annotations.size());
+    });
+    omnitrace_push_category_region(OMNITRACE_CATEGORY_PYTHON, _label_ref->c_str(),
+                                   (_annotate) ? _config.annotations.data() : nullptr,
+                                   _config.annotations.size());
+}
+//
+// installed with PyEval_SetProfile so the events do not go through the Python call
+// machinery
+int
+profiler_callback(PyObject*, PyFrameObject* frame, int what, PyObject*)
+{
+    try
+    {
+        profiler_event(frame, what);
+    } catch(py::error_already_set& _exc)
+    {
+        _exc.restore();
+        return -1;
+    } catch(std::exception& _e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, _e.what());
+        return -1;
+    }
+    return 0;
+}
+//
+void
+set_profiler_callback()
+{
+    PyEval_SetProfile(&profiler_callback, get_profiler_object().ptr());
+}
+//
+// the callable passed to sys.setprofile and threading.setprofile. The first event on a
+// thread replaces it with the native callback, which sys.getprofile() keeps reporting as
+// this function
+void
+profiler_function(py::object pframe, const char* swhat, py::object arg)
+{
+    if(get_paused() > 0) return;
+    if(pframe.is_none() || pframe.ptr() == nullptr) return;
+
+    int what = (strcmp(swhat, "call") == 0)          ? PyTrace_CALL
+               : (strcmp(swhat, "c_call") == 0)      ? PyTrace_C_CALL
+               : (strcmp(swhat, "return") == 0)      ? PyTrace_RETURN
+               : (strcmp(swhat, "c_return") == 0)    ? PyTrace_C_RETURN
+               : (strcmp(swhat, "c_exception") == 0) ? PyTrace_C_EXCEPTION
+                                                     : -1;
+
+    if(get_profiler_object()) set_profiler_callback();
+
+    profiler_event(reinterpret_cast<PyFrameObject*>(pframe.ptr()), what);
+
     // don't do anything with arg
     tim::consume_parameters(arg);
 }
@@ -562,6 +749,8 @@ generate(py::module& _pymod)
             std::cerr << "[profiler_init]> " << e.what() << std::endl;
         }
         if(get_config().is_running) return;
+        // the configuration may have changed since the decisions were cached
+        ++get_code_cache_generation();
         get_config().records.clear();
         get_config().base_stack_depth = -1;
         get_config().is_running       = true;
@@ -578,6 +767,7 @@ generate(py::module& _pymod)
     auto _setprofile = _sys.attr("setprofile");
 
     _prof.def("profiler_function", &profiler_function, "Profiling function");
+    get_profiler_object() = _prof.attr("profiler_function");
     _prof.def("profiler_init", _init, "Initialize the profiler");
     _prof.def("profiler_finalize", _fini, "Finalize the profiler");
     _prof.def(
@@ -588,8 +778,8 @@ generate(py::module& _pymod)
         "Pause the profiler");
     _prof.def(
         "profiler_resume",
-        [_setprofile]() {
-            if(--get_paused() == 0) _setprofile(py::cpp_function{ profiler_function });
+        []() {
+            if(--get_paused() == 0) set_profiler_callback();
         },
         "Resume the profiler");
 
@@ -717,6 +907,9 @@ generate(py::module& _pymod)
                     "Number of times covered");
     DEFINE_PROPERTY(_pycov_summary, coverage::code_coverage, size_t, size,
                     "Total number of coverage entries");
+    DEFINE_PROPERTY(_pycov_summary, coverage::code_coverage, bool, approximate,
+                    "Derived from the samples (OMNITRACE_SAMPLING_COVERAGE) instead of "
+                    "the instrumentation");
     DEFINE_PROPERTY(_pycov_summary, coverage::code_coverage,
                     coverage::code_coverage::data, covered, "Covered information");
     DEFINE_PROPERTY(_pycov_summary, coverage::code_coverage,
@@ -828,23 +1021,26 @@ generate(py::module& _pymod)
                                coverage_data_vector_t* _rhs) {
         std::sort(_rhs->begin(), _rhs->end(), std::greater<coverage::coverage_data>{});
 
-        auto _find = [_lhs](const auto& _v) {
-            for(auto iitr = _lhs->begin(); iitr != _lhs->end(); ++iitr)
-            {
-                if(*iitr == _v) return std::make_pair(iitr, true);
-            }
-            return std::make_pair(_lhs->end(), false);
-        };
+        using data_tuple_t = coverage::coverage_data::data_tuple_t;
+
+        // the entries of the lhs by module, function, and address
+        auto _index = std::map<data_tuple_t, size_t>{};
+        for(size_t i = 0; i < _lhs->size(); ++i)
+        {
+            const auto& itr = _lhs->at(i);
+            _index.emplace(data_tuple_t{ itr.module, itr.function, itr.address }, i);
+        }
 
         std::vector<coverage::coverage_data*> _new_entries{};
         _new_entries.reserve(_rhs->size());
         for(auto& itr : *_rhs)
         {
-            auto litr = _find(itr);
-            if(!litr.second)
+            auto litr =
+                _index.find(data_tuple_t{ itr.module, itr.function, itr.address });
+            if(litr == _index.end())
                 _new_entries.emplace_back(&itr);
             else
-                *litr.first += itr;
+                _lhs->at(litr->second) += itr;
         }
 
         _lhs->reserve(_lhs->size() + _new_entries.size());
@@ -858,6 +1054,39 @@ generate(py::module& _pymod)
 
     _pycov.def("concat", _concat_coverage, "Combined code coverage details");
 
+    py::class_<coverage::coverage_bitmap> _pycov_bitmap{
+        _pycov, "bitmap",
+        "Compact code coverage: a deduplicated table of the coverage entities of every "
+        "module and a bitmap of the covered entities"
+    };
+
+    _pycov_bitmap.def(py::init([]() { return new coverage::coverage_bitmap{}; }),
+                      "Create a default instance");
+    _pycov_bitmap.def(py::init([](coverage_data_vector_t* _details) {
+                          return new coverage::coverage_bitmap{
+                              coverage::coverage_bitmap::from_details(*_details)
+                          };
+                      }),
+                      "Create from the code coverage details", py::arg("details"));
+    _pycov_bitmap.def_static("load", &coverage::coverage_bitmap::load,
+                             "Load a code coverage bitmap", py::arg("filename"));
+    _pycov_bitmap.def("save", &coverage::coverage_bitmap::save,
+                      "Save the code coverage bitmap", py::arg("filename"));
+    _pycov_bitmap.def("get_details", &coverage::coverage_bitmap::get_details,
+                      "Get the code coverage details. The count of a covered entity is "
+                      "one");
+    _pycov_bitmap.def("get_summary", &coverage::coverage_bitmap::get_summary,
+                      "Generate a code coverage summary");
+    _pycov_bitmap.def(py::self |= py::self);
+
+    auto _concat_bitmap = [](coverage::coverage_bitmap* _lhs,
+                             coverage::coverage_bitmap* _rhs) {
+        *_lhs |= *_rhs;
+        return _lhs;
+    };
+
+    _pycov.def("concat", _concat_bitmap, "Combined code coverage bitmaps");
+
     using coverage_data_map =
         uomap_t<std::string_view, uomap_t<std::string_view, std::map<size_t, size_t>>>;
 
@@ -922,11 +1151,88 @@ generate(py::module& _pymod)
 
 namespace pyuser
 {
+namespace
+{
+// user region whose label is converted once. The handle is registered on the first
+// push because the user API is only bound once omnitrace is initialized. Until then,
+// the region is pushed and popped by label
+struct region_handle
+{
+    explicit region_handle(std::string _label)
+    : label{ std::move(_label) }
+    {}
+
+    void push();
+    void pop() const;
+
+    std::string           label  = {};
+    std::atomic<uint64_t> handle = { 0 };
+};
+
+void
+region_handle::push()
+{
+    auto _handle = handle.load(std::memory_order_acquire);
+    if(_handle == 0)
+    {
+        if(omnitrace_user_register_region(label.c_str(), &_handle) !=
+               OMNITRACE_USER_SUCCESS ||
+           _handle == 0)
+        {
+            omnitrace_user_push_region(label.c_str());
+            return;
+        }
+        handle.store(_handle, std::memory_order_release);
+    }
+    omnitrace_user_push_region_id(_handle);
+}
+
+void
+region_handle::pop() const
+{
+    auto _handle = handle.load(std::memory_order_acquire);
+    if(_handle == 0)
+        omnitrace_user_pop_region(label.c_str());
+    else
+        omnitrace_user_pop_region_id(_handle);
+}
+}  // namespace
+
 py::module
 generate(py::module& _pymod)
 {
     py::module _pyuser = _pymod.def_submodule("user", "User instrumentation");
 
+    py::class_<region_handle> _pyregion{
+        _pyuser, "region_handle",
+        "User-defined region with a label which is only converted once. The region "
+        "holds no state between the push and the pop so it can be shared by threads "
+        "and recursive calls"
+    };
+    _pyregion.def(py::init<std::string>(), "Create a region", py::arg("label"));
+    _pyregion.def_property_readonly(
+        "label", [](const region_handle& _v) { return _v.label; }, "Label of the region");
+    _pyregion.def("push", &region_handle::push, "Start the region");
+    _pyregion.def("pop", &region_handle::pop, "Stop the region");
+    _pyregion.def(
+        "__enter__",
+        [](region_handle& _v) -> region_handle& {
+            _v.push();
+            return _v;
+        },
+        py::return_value_policy::reference, "Start the region");
+    _pyregion.def(
+        "__exit__",
+        [](const region_handle& _v, py::object _type, py::object _value,
+           py::object _tb) {
+            _v.pop();
+            if(!_type.is_none() && !_value.is_none() && !_tb.is_none())
+                py::module::import("traceback")
+                    .attr("print_exception")(_type, _value, _tb, "limit"_a = 5);
+            return false;
+        },
+        "Stop the region");
+
     _pyuser.def("start_trace", &omnitrace_user_start_trace,
                 "Enable tracing on this thread and all subsequently created threads");
     _pyuser.def("stop_trace", &omnitrace_user_stop_trace,
@@ -946,6 +1252,154 @@ generate(py::module& _pymod)
     return _pyuser;
 }
 }  // namespace pyuser
+
+namespace pysampling
+{
+namespace
+{
+#if OMNITRACE_PYTHON_VERSION < 31400
+#    define OMNITRACE_PYTHON_SAMPLING_SUPPORTED 1
+#endif
+
+#if OMNITRACE_PYTHON_VERSION >= 31100 && OMNITRACE_PYTHON_VERSION < 31400
+// leading fields of the _PyInterpreterFrame of the interpreter, which is not part of the
+// public headers
+struct interpreter_frame
+{
+#    if OMNITRACE_PYTHON_VERSION < 31200
+    PyObject*          f_func;
+    PyObject*          f_globals;
+    PyObject*          f_builtins;
+    PyObject*          f_locals;
+    PyObject*          f_code;
+    PyFrameObject*     frame_obj;
+    interpreter_frame* previous;
+    _Py_CODEUNIT*      prev_instr;
+    int                stacktop;
+    bool               is_entry;
+    char               owner;
+#    else
+    PyObject*          f_code;  // f_executable in 3.13
+    interpreter_frame* previous;
+    PyObject*          f_funcobj;
+    PyObject*          f_globals;
+    PyObject*          f_builtins;
+    PyObject*          f_locals;
+    PyFrameObject*     frame_obj;
+    _Py_CODEUNIT*      prev_instr;  // instr_ptr in 3.13
+    int                stacktop;
+    uint16_t           return_offset;
+    char               owner;
+#    endif
+};
+
+// owner of the frame pushed when the interpreter loop is invoked from C (3.12+)
+constexpr char frame_owned_by_cstack = 3;
+#endif
+
+// invoked in the signal handler of the sampler on the interrupted thread without the
+// GIL. Only this thread modifies its frames so the chain of frames is consistent
+size_t
+unwind(const void** _codes, int* _lasti, int* _entry, size_t _max)
+{
+    auto* _tstate = PyGILState_GetThisThreadState();
+    if(!_tstate) return 0;
+
+    size_t _n = 0;
+#if OMNITRACE_PYTHON_VERSION < 31100
+    // the offset is in code units since 3.10
+    constexpr int _units = (OMNITRACE_PYTHON_VERSION >= 31000) ? 2 : 1;
+    for(auto* itr = _tstate->frame; itr && _n < _max; itr = itr->f_back)
+    {
+        _codes[_n] = itr->f_code;
+        _lasti[_n] = itr->f_lasti * _units;
+        _entry[_n] = 1;
+        ++_n;
+    }
+#elif OMNITRACE_PYTHON_VERSION < 31400
+#    if OMNITRACE_PYTHON_VERSION < 31300
+    auto* itr = (_tstate->cframe)
+                    ? reinterpret_cast<interpreter_frame*>(_tstate->cframe->current_frame)
+                    : nullptr;
+#    else
+    auto* itr = reinterpret_cast<interpreter_frame*>(_tstate->current_frame);
+#    endif
+    for(; itr && _n < _max; itr = itr->previous)
+    {
+        if(itr->owner == frame_owned_by_cstack)
+        {
+            // the frame before the shim is the first frame of the invocation
+            if(_n > 0) _entry[_n - 1] = 1;
+            continue;
+        }
+
+        auto* _code = itr->f_code;
+        if(!_code || Py_TYPE(_code) != &PyCode_Type) continue;
+
+        auto* _instr = _PyCode_CODE(reinterpret_cast<PyCodeObject*>(_code));
+        auto  _units = itr->prev_instr - _instr;
+        _codes[_n]   = _code;
+        _lasti[_n]   = static_cast<int>(sizeof(_Py_CODEUNIT) * _units);
+#    if OMNITRACE_PYTHON_VERSION < 31200
+        _entry[_n] = (itr->is_entry) ? 1 : 0;
+#    else
+        _entry[_n] = 0;
+#    endif
+        ++_n;
+    }
+    if(_n > 0) _entry[_n - 1] = 1;
+#else
+    tim::consume_parameters(_codes, _lasti, _entry, _max);
+#endif
+    return _n;
+}
+
+// invoked during finalization on the finalizing thread. The code objects of the
+// samples are expected to be alive, i.e. they are not from code compiled at runtime and
+// released before the end of the program
+int
+resolve(const void* _code, int _lasti, const char** _func, const char** _file,
+        int* _line)
+{
+    static auto* _strings = new std::unordered_set<std::string>{};
+
+    if(!_code || !Py_IsInitialized()) return 0;
+
+    auto  _gil = PyGILState_Ensure();
+    auto* _obj = reinterpret_cast<PyObject*>(const_cast<void*>(_code));
+    int   _ret = 0;
+    if(Py_TYPE(_obj) == &PyCode_Type)
+    {
+        auto*       _co       = reinterpret_cast<PyCodeObject*>(_obj);
+        const auto* _name     = PyUnicode_AsUTF8(_co->co_name);
+        const auto* _filename = PyUnicode_AsUTF8(_co->co_filename);
+        if(_name && _filename)
+        {
+            *_func = _strings->emplace(_name).first->c_str();
+            *_file = _strings->emplace(_filename).first->c_str();
+            *_line = (_lasti >= 0) ? PyCode_Addr2Line(_co, _lasti) : _co->co_firstlineno;
+            _ret   = 1;
+        }
+        PyErr_Clear();
+    }
+    PyGILState_Release(_gil);
+    return _ret;
+}
+}  // namespace
+
+void
+setup()
+{
+#if defined(OMNITRACE_PYTHON_SAMPLING_SUPPORTED)
+    omnitrace_register_python_sampler(&unwind, &resolve);
+#else
+    if(tim::get_env<bool>("OMNITRACE_SAMPLING_PYTHON", false))
+        fprintf(stderr, "[omnitrace][pid=%i] Sampling the Python call-stacks is not "
+                        "supported for Python %s\n",
+                getpid(), PY_VERSION);
+#endif
+}
+}  // namespace pysampling
 }  // namespace pyomnitrace
 //
 //======================================================================================//
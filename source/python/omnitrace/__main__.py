@@ -220,6 +220,18 @@ def parse_args(args=None):
         default=_profiler_config.trace_c,
         help="Enable profiling C functions",
     )
+    parser.add_argument(
+        "--sample",
+        type=str2bool,
+        nargs="?",
+        metavar="BOOL",
+        const=True,
+        default=False,
+        help=(
+            "Periodically sample the Python call-stacks (OMNITRACE_SAMPLING_PYTHON) "
+            "instead of tracing every call and return"
+        ),
+    )
     parser.add_argument(
         "-a",
         "--annotate-trace",
@@ -312,6 +324,10 @@ def main(main_args=sys.argv):
             [os.environ.get("OMNITRACE_CONFIG_FILE", ""), opts.config]
         )
 
+    if opts.sample:
+        os.environ["OMNITRACE_USE_SAMPLING"] = "ON"
+        os.environ["OMNITRACE_SAMPLING_PYTHON"] = "ON"
+
     from .libpyomnitrace import initialize
 
     if os.path.isfile(argv[0]):
@@ -375,18 +391,19 @@ def main(main_args=sys.argv):
 
     try:
         try:
-            if not opts.builtin:
+            _trace = not opts.builtin and not opts.sample
+            if _trace:
                 prof.start()
             execfile_ = execfile
             ns = locals()
-            if opts.builtin:
+            if not _trace:
                 execfile(script_file, ns, ns)
             else:
                 prof.runctx("execfile_(%r, globals())" % (script_file,), ns, ns)
         except (KeyboardInterrupt, SystemExit):
             pass
         finally:
-            if not opts.builtin:
+            if _trace:
                 prof.stop()
             del prof
             del fake
@@ -0,0 +1,164 @@
+#!/usr/bin/env python@_VERSION@
+# MIT License
+#
+# Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+from __future__ import absolute_import
+
+__author__ = "AMD Research"
+__copyright__ = "Copyright 2022, Advanced Micro Devices, Inc."
+__license__ = "MIT"
+__version__ = "@PROJECT_VERSION@"
+__maintainer__ = "AMD Research"
+__status__ = "Development"
+
+"""
+Reader of the columnar binary output (OMNITRACE_COLUMNAR_OUTPUT=ON). The file is
+memory-mapped and the columns are views into the mapping so nothing is parsed or
+copied when a file is opened. The columns are numpy arrays when numpy is available
+and memoryview objects otherwise.
+
+    from omnitrace.columnar import ColumnarFile
+
+    with ColumnarFile("omnitrace-<exe>-output/<timestamp>/profile.columnar") as f:
+        wc = f["wall_clock"]
+        for name, depth, value in zip(wc.names(), wc["depth"], wc["value"]):
+            print("{}|_{} {}".format("  " * depth, name, value))
+"""
+
+import mmap
+import struct
+
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+MAGIC = b"OMNICOL\0"
+VERSION = 1
+
+# must match the layout in source/lib/omnitrace/library/columnar_output.cpp
+_HEADER = struct.Struct("<8sIIQQQ")
+_TABLE = struct.Struct("<IIQ5Q")
+_COLUMNS = (
+    ("name", "I"),
+    ("depth", "I"),
+    ("parent", "q"),
+    ("laps", "Q"),
+    ("value", "d"),
+)
+
+
+class ColumnarTable:
+    """The call-graph of one component. Rows are in depth-first order"""
+
+    def __init__(self, _file, _label, _unit, _num_rows, _offsets):
+        self.file = _file
+        self.label = _label
+        self.unit = _unit
+        self.num_rows = _num_rows
+        self.columns = {}
+        for (_name, _fmt), _offset in zip(_COLUMNS, _offsets):
+            self.columns[_name] = _file._column(_offset, _fmt, _num_rows)
+
+    def __len__(self):
+        return self.num_rows
+
+    def __getitem__(self, _column):
+        return self.columns[_column]
+
+    def names(self):
+        """The names of the nodes (decoded from the string table)"""
+        return [self.file.string(x) for x in self.columns["name"]]
+
+
+class ColumnarFile:
+    """A memory-mapped columnar output file"""
+
+    def __init__(self, _filename):
+        self.filename = _filename
+        self._fd = open(_filename, "rb")
+        self._mm = mmap.mmap(self._fd.fileno(), 0, access=mmap.ACCESS_READ)
+        self._view = memoryview(self._mm)
+
+        (
+            _magic,
+            self.version,
+            _num_tables,
+            _num_strings,
+            _strings_offset,
+            _tables_offset,
+        ) = _HEADER.unpack_from(self._mm, 0)
+        if _magic != MAGIC:
+            raise RuntimeError(f"{_filename} is not an omnitrace columnar file")
+        if self.version != VERSION:
+            raise RuntimeError(
+                f"{_filename} has version {self.version} (expected {VERSION})"
+            )
+
+        self._string_offsets = self._column(_strings_offset, "Q", _num_strings + 1)
+        self._string_data = _strings_offset + 8 * (_num_strings + 1)
+
+        self.tables = {}
+        for i in range(_num_tables):
+            _v = _TABLE.unpack_from(self._mm, _tables_offset + i * _TABLE.size)
+            _table = ColumnarTable(
+                self, self.string(_v[0]), self.string(_v[1]), _v[2], _v[3:]
+            )
+            self.tables[_table.label] = _table
+
+    def _column(self, _offset, _fmt, _num):
+        _size = struct.calcsize(_fmt) * _num
+        if _np is not None:
+            return _np.frombuffer(self._mm, dtype=_fmt, count=_num, offset=_offset)
+        return self._view[_offset : _offset + _size].cast(_fmt)
+
+    def string(self, _idx):
+        _beg = self._string_data + int(self._string_offsets[_idx])
+        _end = self._string_data + int(self._string_offsets[_idx + 1])
+        return bytes(self._view[_beg:_end]).decode("utf-8", errors="replace")
+
+    def __getitem__(self, _label):
+        return self.tables[_label]
+
+    def __contains__(self, _label):
+        return _label in self.tables
+
+    def __iter__(self):
+        return iter(self.tables.values())
+
+    def close(self):
+        self._fd.close()
+        self.tables = {}
+        self._string_offsets = None
+        # the columns which are still referenced keep the mapping open until they are
+        # released
+        try:
+            self._view.release()
+            self._mm.close()
+        except BufferError:
+            pass
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_args):
+        self.close()
@@ -0,0 +1,468 @@
+#!/usr/bin/env python@_VERSION@
+# MIT License
+#
+# Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+from __future__ import absolute_import
+
+__author__ = "AMD Research"
+__copyright__ = "Copyright 2022, Advanced Micro Devices, Inc."
+__license__ = "MIT"
+__version__ = "@PROJECT_VERSION@"
+__maintainer__ = "AMD Research"
+__status__ = "Development"
+
+"""
+Comparison of the timemory JSON or columnar output of two sets of runs (e.g. before and
+after a code change) for detecting performance regressions:
+
+    python -m omnitrace.compare -b <baseline output> [...] -c <current output> [...]
+
+The nodes of the call-graph of every component are aligned by their call-path and the
+value of a node in every run, rank, and thread is a sample of the node. A node is a
+regression when the mean of the samples increases by more than the threshold and by
+more than sigma standard errors of the difference. The exit status is 1 when there is
+a regression so the comparison can gate a CI pipeline:
+
+    from omnitrace.compare import compare
+
+    report = compare(["before/"], ["after/"], threshold=0.05)
+    for itr in report.regressions:
+        print(itr)
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import sys
+
+from omnitrace.columnar import ColumnarFile
+
+# the exclusive values are only meaningful for the components which are additive
+_TIME_UNITS = ("nsec", "usec", "msec", "sec", "min", "hr")
+_PREFIX = re.compile(r"^\|?(?P<tid>[0-9]*)>>> ?(?P<name>.*)$")
+
+
+def _split_prefix(_prefix):
+    """The thread and the name of a node in the timemory JSON output"""
+    _m = _PREFIX.match(_prefix)
+    if _m is None:
+        return (0, _prefix.strip())
+    _name = _m.group("name").lstrip()
+    if _name.startswith("|_"):
+        _name = _name[2:]
+    return (int(_m.group("tid") or 0), _name)
+
+
+def _entry_values(_entry):
+    """The values of a node in the display unit (one per element for array types)"""
+    for itr in ("repr_data", "accum", "value"):
+        if itr not in _entry:
+            continue
+        _v = _entry[itr]
+        _v = _v if isinstance(_v, (list, tuple)) else [_v]
+        try:
+            return [float(x) for x in _v]
+        except (TypeError, ValueError):
+            return None
+    return None
+
+
+class Profile:
+    """The samples of the nodes of a set of runs. The keys are (metric, kind, path)"""
+
+    def __init__(self):
+        self.samples = {}
+        self.hashes = {}
+        self.units = {}
+        self.files = []
+
+    def add(self, _label, _unit, _rows):
+        """Adds the (name, depth, hash, values) rows of one rank and thread. The rows
+        are in depth-first order"""
+        _totals = {}
+        _exclusive = []
+        _stack = []  # the (path, exclusive values) of the last row at each depth
+        for _name, _depth, _hash, _values in _rows:
+            del _stack[max(_depth, 0) :]
+            _path = (_stack[-1][0] if _stack else ()) + (_name,)
+            if _stack:
+                _parent = _stack[-1][1]
+                for i, itr in enumerate(_values[: len(_parent)]):
+                    _parent[i] -= itr
+            _stack.append((_path, list(_values)))
+            _exclusive.append(_stack[-1])
+            for i, itr in enumerate(_values):
+                _metric = _label if len(_values) == 1 else f"{_label}[{i}]"
+                self.units[_metric] = _unit
+                self.hashes[(_metric, _path)] = _hash
+                _key = (_metric, "inclusive", _path)
+                _totals[_key] = _totals.get(_key, 0.0) + itr
+
+        # the exclusive values are final once every child has been subtracted
+        if _unit in _TIME_UNITS:
+            for _path, _values in _exclusive:
+                for i, itr in enumerate(_values):
+                    _metric = _label if len(_values) == 1 else f"{_label}[{i}]"
+                    _key = (_metric, "exclusive", _path)
+                    _totals[_key] = _totals.get(_key, 0.0) + itr
+
+        for _key, _value in _totals.items():
+            self.samples.setdefault(_key, []).append(_value)
+
+    def load_json(self, _filename):
+        """Loads a timemory JSON file. Returns false if it is not a timemory output"""
+        try:
+            with open(_filename, "r") as f:
+                _data = json.load(f)
+        except (OSError, ValueError):
+            return False
+
+        if not isinstance(_data, dict) or not isinstance(_data.get("timemory"), dict):
+            return False
+
+        _found = False
+        for _label, _comp in _data["timemory"].items():
+            if not isinstance(_comp, dict) or not isinstance(_comp.get("ranks"), list):
+                continue
+            _unit = _comp.get("unit_repr", "")
+            for _rank in _comp["ranks"]:
+                _threads = {}
+                for itr in _rank.get("graph", []):
+                    if "prefix" not in itr or "entry" not in itr:
+                        continue
+                    _values = _entry_values(itr["entry"])
+                    if _values is None:
+                        continue
+                    _tid, _name = _split_prefix(itr["prefix"])
+                    _threads.setdefault(_tid, []).append(
+                        (_name, int(itr.get("depth", 0)), itr.get("hash", 0), _values)
+                    )
+                for _rows in _threads.values():
+                    self.add(_label, _unit, _rows)
+                    _found = True
+        if _found:
+            self.files.append(_filename)
+        return _found
+
+    def load_columnar(self, _filename):
+        """Loads a columnar file (one rank, the values are summed over the threads)"""
+        with ColumnarFile(_filename) as f:
+            for _table in f:
+                _rows = [
+                    (_name, int(_depth), 0, [float(_value)])
+                    for _name, _depth, _value in zip(
+                        _table.names(), _table["depth"], _table["value"]
+                    )
+                ]
+                self.add(_table.label, _table.unit, _rows)
+        self.files.append(_filename)
+        return True
+
+    def load(self, _path, _format="auto"):
+        """Loads a file or every output file below a folder. With the auto format, the
+        columnar files are only used when there is no timemory JSON output"""
+        _json = []
+        _columnar = []
+        _files = [_path]
+        if os.path.isdir(_path):
+            _files = [
+                os.path.join(_root, itr)
+                for _root, _, _names in os.walk(_path)
+                for itr in sorted(_names)
+            ]
+        for itr in _files:
+            if itr.endswith(".columnar"):
+                _columnar.append(itr)
+            elif itr.endswith(".json") and not itr.endswith(".tree.json"):
+                _json.append(itr)
+
+        _found = False
+        if _format in ("auto", "json"):
+            for itr in _json:
+                _found = self.load_json(itr) or _found
+        if _format == "columnar" or (_format == "auto" and not _found):
+            for itr in _columnar:
+                _found = self.load_columnar(itr) or _found
+        if not _found:
+            raise RuntimeError(f"no timemory or columnar output found in {_path}")
+        return self
+
+
+def _statistics(_values):
+    _n = len(_values)
+    _mean = sum(_values) / _n
+    _var = sum((x - _mean) ** 2 for x in _values) / (_n - 1) if _n > 1 else 0.0
+    return (_n, _mean, _var)
+
+
+class Delta:
+    """The change of a node between the baseline and the current runs"""
+
+    def __init__(self, _key, _unit, _hash, _baseline, _current):
+        self.metric, self.kind, self.path = _key
+        self.unit = _unit
+        self.hash = _hash
+        _bn, self.baseline, _bvar = _statistics(_baseline)
+        _cn, self.current, _cvar = _statistics(_current)
+        self.samples = (_bn, _cn)
+        self.stddev = (math.sqrt(_bvar), math.sqrt(_cvar))
+        self.delta = self.current - self.baseline
+        if self.baseline != 0.0:
+            self.relative = self.delta / abs(self.baseline)
+        else:
+            self.relative = math.copysign(math.inf, self.delta) if self.delta else 0.0
+
+        # without a variance on either side the relative threshold alone decides
+        self.zscore = None
+        if _bn > 1 or _cn > 1:
+            _stderr = math.sqrt(_bvar / _bn + _cvar / _cn)
+            if _stderr > 0.0:
+                self.zscore = self.delta / _stderr
+            else:
+                self.zscore = math.copysign(math.inf, self.delta) if self.delta else 0.0
+        self.status = "unchanged"
+
+    @property
+    def name(self):
+        return self.path[-1]
+
+    def significant(self, _sigma):
+        return self.zscore is None or abs(self.zscore) >= _sigma
+
+    def to_dict(self):
+        return {
+            "metric": self.metric,
+            "kind": self.kind,
+            "path": list(self.path),
+            "hash": self.hash,
+            "unit": self.unit,
+            "status": self.status,
+            "baseline": self.baseline,
+            "current": self.current,
+            "baseline_stddev": self.stddev[0],
+            "current_stddev": self.stddev[1],
+            "baseline_samples": self.samples[0],
+            "current_samples": self.samples[1],
+            "delta": self.delta,
+            "relative": self.relative if math.isfinite(self.relative) else None,
+            "zscore": (
+                self.zscore
+                if self.zscore is not None and math.isfinite(self.zscore)
+                else None
+            ),
+        }
+
+    def __str__(self):
+        _z = "-" if self.zscore is None else f"{self.zscore:.1f}"
+        return (
+            f"{self.metric} ({self.kind}) {self.name}: {self.baseline:.6g} -> "
+            f"{self.current:.6g} {self.unit} ({self.relative:+.1%}, z = {_z})"
+        )
+
+
+class Report:
+    """The result of a comparison"""
+
+    def __init__(self):
+        self.deltas = []
+        self.added = []  # (metric, kind, path) only in the current runs
+        self.removed = []  # (metric, kind, path) only in the baseline runs
+
+    @property
+    def regressions(self):
+        return [itr for itr in self.deltas if itr.status == "regression"]
+
+    @property
+    def improvements(self):
+        return [itr for itr in self.deltas if itr.status == "improvement"]
+
+    def to_dict(self):
+        return {
+            "regressions": len(self.regressions),
+            "improvements": len(self.improvements),
+            "deltas": [itr.to_dict() for itr in self.deltas],
+            "added": [list(itr[:2]) + [list(itr[2])] for itr in self.added],
+            "removed": [list(itr[:2]) + [list(itr[2])] for itr in self.removed],
+        }
+
+
+def compare(
+    baseline,
+    current,
+    threshold=0.05,
+    sigma=3.0,
+    min_fraction=0.01,
+    metrics=None,
+    exclude=None,
+    format="auto",
+):
+    """Compares the outputs (files or folders) of the baseline and the current runs.
+    Nodes below min_fraction of the largest inclusive value of their metric are not
+    flagged. metrics and exclude are regular expressions of the metrics to compare and
+    the names of the nodes to ignore"""
+
+    def _load(_paths):
+        _profile = Profile()
+        for itr in [_paths] if isinstance(_paths, str) else _paths:
+            _profile.load(itr, format)
+        return _profile
+
+    _base = baseline if isinstance(baseline, Profile) else _load(baseline)
+    _curr = current if isinstance(current, Profile) else _load(current)
+
+    def _selected(_key):
+        if metrics and not any(re.search(x, _key[0]) for x in metrics):
+            return False
+        if exclude and any(re.search(x, itr) for x in exclude for itr in _key[2]):
+            return False
+        return True
+
+    _report = Report()
+    _scale = {}
+    for _key in sorted(set(_base.samples) | set(_curr.samples)):
+        if not _selected(_key):
+            continue
+        if _key not in _curr.samples:
+            _report.removed.append(_key)
+            continue
+        if _key not in _base.samples:
+            _report.added.append(_key)
+            continue
+        _unit = _base.units.get(_key[0], _curr.units.get(_key[0], ""))
+        _hash = _curr.hashes.get((_key[0], _key[2]), 0)
+        _delta = Delta(_key, _unit, _hash, _base.samples[_key], _curr.samples[_key])
+        _report.deltas.append(_delta)
+        if _key[1] == "inclusive":
+            _size = max(abs(_delta.baseline), abs(_delta.current))
+            _scale[_key[0]] = max(_scale.get(_key[0], 0.0), _size)
+
+    for itr in _report.deltas:
+        _size = max(abs(itr.baseline), abs(itr.current))
+        if _size < min_fraction * _scale.get(itr.metric, 0.0):
+            continue
+        if not itr.significant(sigma):
+            continue
+        if itr.relative > threshold:
+            itr.status = "regression"
+        elif itr.relative < -threshold:
+            itr.status = "improvement"
+
+    _report.deltas.sort(key=lambda x: -abs(x.relative) if x.status != "unchanged" else 0)
+    return _report
+
+
+def main(_args=None):
+    parser = argparse.ArgumentParser(
+        prog="python -m omnitrace.compare",
+        description="Compare the omnitrace outputs of two sets of runs",
+    )
+    parser.add_argument(
+        "-b",
+        "--baseline",
+        nargs="+",
+        required=True,
+        help="Output files or folders of the baseline runs",
+    )
+    parser.add_argument(
+        "-c",
+        "--current",
+        nargs="+",
+        required=True,
+        help="Output files or folders of the runs to check",
+    )
+    parser.add_argument(
+        "-t",
+        "--threshold",
+        type=float,
+        default=0.05,
+        help="Relative change of a node which is flagged",
+    )
+    parser.add_argument(
+        "-s",
+        "--sigma",
+        type=float,
+        default=3.0,
+        help="Number of standard errors of a significant change",
+    )
+    parser.add_argument(
+        "-f",
+        "--min-fraction",
+        type=float,
+        default=0.01,
+        help="Ignore the nodes below this fraction of the largest value of the metric",
+    )
+    parser.add_argument(
+        "-m", "--metrics", nargs="*", default=None, help="Regex of the metrics"
+    )
+    parser.add_argument(
+        "-e", "--exclude", nargs="*", default=None, help="Regex of the nodes to ignore"
+    )
+    parser.add_argument(
+        "--format",
+        choices=("auto", "json", "columnar"),
+        default="auto",
+        help="Format of the outputs",
+    )
+    parser.add_argument("-o", "--output", default=None, help="JSON report")
+    parser.add_argument(
+        "-n", "--max-rows", type=int, default=20, help="Maximum number of nodes printed"
+    )
+    parser.add_argument(
+        "--no-fail", action="store_true", help="Exit status is zero with regressions"
+    )
+    args = parser.parse_args(_args)
+
+    _report = compare(
+        args.baseline,
+        args.current,
+        threshold=args.threshold,
+        sigma=args.sigma,
+        min_fraction=args.min_fraction,
+        metrics=args.metrics,
+        exclude=args.exclude,
+        format=args.format,
+    )
+
+    _changed = [itr for itr in _report.deltas if itr.status != "unchanged"]
+    for itr in _changed[: args.max_rows]:
+        print(f"[omnitrace] {itr.status:>11}: {itr}")
+    if len(_changed) > args.max_rows:
+        print(f"[omnitrace] ... {len(_changed) - args.max_rows} more")
+
+    print(
+        f"[omnitrace] {len(_report.regressions)} regressions, "
+        f"{len(_report.improvements)} improvements ({len(_report.deltas)} nodes "
+        f"compared, {len(_report.added)} added, {len(_report.removed)} removed)"
+    )
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(_report.to_dict(), f, indent=2)
+        print(f"[omnitrace] wrote the comparison to {args.output}")
+
+    return 1 if _report.regressions and not args.no_fail else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,218 @@
+#!/usr/bin/env python@_VERSION@
+# MIT License
+#
+# Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+from __future__ import absolute_import
+
+__author__ = "AMD Research"
+__copyright__ = "Copyright 2022, Advanced Micro Devices, Inc."
+__license__ = "MIT"
+__version__ = "@PROJECT_VERSION@"
+__maintainer__ = "AMD Research"
+__status__ = "Development"
+
+"""
+Reader of the emergency dump (OMNITRACE_EMERGENCY_DUMP=ON) which is written by the
+signal handler when the process is terminated by a fatal signal. The pending perfetto
+regions and HIP activity records are converted into a JSON trace which can be opened
+in ui.perfetto.dev and the offloaded samples are extracted as raw files:
+
+    python -m omnitrace.emergency omnitrace-<exe>-output/<timestamp>/emergency-dump.bin
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+
+MAGIC = b"OMNIDMP\0"
+VERSION = 1
+
+# must match the layout in source/lib/omnitrace/library/emergency_dump.hpp
+_HEADER = struct.Struct("<8sIiqQ")
+_SECTION = struct.Struct("<IIqQ")
+_U32 = struct.Struct("<I")
+_REGION = struct.Struct("<QI")
+_ACTIVITY = struct.Struct("<QQ")
+
+END_SECTION = 0
+REGION_SECTION = 1
+ACTIVITY_SECTION = 2
+SAMPLING_SECTION = 3
+
+
+class Section:
+    """A section of the dump: the raw payload of one source of one thread"""
+
+    def __init__(self, _kind, _entry_size, _tid, _data):
+        self.kind = _kind
+        self.entry_size = _entry_size
+        self.tid = _tid
+        self.data = _data
+
+    def _string(self, _offset):
+        (_len,) = _U32.unpack_from(self.data, _offset)
+        _offset += _U32.size
+        _name = bytes(self.data[_offset : _offset + _len])
+        return (_name.decode("utf-8", errors="replace"), _offset + _len)
+
+    def regions(self):
+        """The (timestamp, is_begin, name) of the pending regions"""
+        _offset = 0
+        while _offset < len(self.data):
+            _ts, _phase = _REGION.unpack_from(self.data, _offset)
+            _name, _offset = self._string(_offset + _REGION.size)
+            yield (_ts, _phase == 1, _name)
+
+    def activities(self):
+        """The (begin, end, name) of the pending HIP activity records"""
+        _offset = 0
+        while _offset < len(self.data):
+            _beg, _end = _ACTIVITY.unpack_from(self.data, _offset)
+            _name, _offset = self._string(_offset + _ACTIVITY.size)
+            yield (_beg, _end, _name)
+
+
+class EmergencyDump:
+    """An emergency dump. complete is false if the signal handler did not finish"""
+
+    def __init__(self, _filename):
+        self.filename = _filename
+        with open(_filename, "rb") as f:
+            _data = memoryview(f.read())
+
+        if len(_data) < _HEADER.size:
+            raise RuntimeError(f"{_filename} is empty (no fatal signal was received)")
+
+        (
+            _magic,
+            self.version,
+            self.signal,
+            self.pid,
+            self.timestamp,
+        ) = _HEADER.unpack_from(_data, 0)
+        if _magic != MAGIC:
+            raise RuntimeError(f"{_filename} is not an omnitrace emergency dump")
+        if self.version != VERSION:
+            raise RuntimeError(
+                f"{_filename} has version {self.version} (expected {VERSION})"
+            )
+
+        self.sections = []
+        self.complete = False
+        _offset = _HEADER.size
+        while _offset + _SECTION.size <= len(_data):
+            _kind, _entry_size, _tid, _nbytes = _SECTION.unpack_from(_data, _offset)
+            _offset += _SECTION.size
+            if _kind == END_SECTION:
+                self.complete = True
+                break
+            # the remainder of a truncated section is discarded
+            if _offset + _nbytes > len(_data):
+                break
+            _payload = _data[_offset : _offset + _nbytes]
+            self.sections.append(Section(_kind, _entry_size, _tid, _payload))
+            _offset += _nbytes
+
+    def __iter__(self):
+        return iter(self.sections)
+
+    def trace_events(self):
+        """The regions and activities in the Chrome JSON trace format"""
+        _events = []
+        for itr in self.sections:
+            if itr.kind == REGION_SECTION:
+                for _ts, _begin, _name in itr.regions():
+                    _events.append(
+                        {
+                            "name": _name,
+                            "ph": "B" if _begin else "E",
+                            "ts": _ts / 1000.0,
+                            "pid": self.pid,
+                            "tid": itr.tid,
+                        }
+                    )
+            elif itr.kind == ACTIVITY_SECTION:
+                for _beg, _end, _name in itr.activities():
+                    _events.append(
+                        {
+                            "name": _name,
+                            "cat": "device",
+                            "ph": "X",
+                            "ts": _beg / 1000.0,
+                            "dur": max(_end - _beg, 0) / 1000.0,
+                            "pid": self.pid,
+                            "tid": f"HIP activity (thread {itr.tid})",
+                        }
+                    )
+        return _events
+
+
+def main(_args=None):
+    parser = argparse.ArgumentParser(
+        prog="python -m omnitrace.emergency",
+        description="Convert an omnitrace emergency dump",
+    )
+    parser.add_argument("input", help="emergency-dump.bin file")
+    parser.add_argument(
+        "-o",
+        "--output",
+        default=None,
+        help="JSON trace of the regions and HIP activities "
+        "(default: <input without extension>.json)",
+    )
+    args = parser.parse_args(_args)
+
+    _dump = EmergencyDump(args.input)
+    _base = os.path.splitext(args.output or args.input)[0]
+    print(
+        f"[omnitrace] {args.input}: pid {_dump.pid}, signal {_dump.signal}, "
+        f"{len(_dump.sections)} sections"
+        + ("" if _dump.complete else " (incomplete)")
+    )
+
+    _events = _dump.trace_events()
+    if _events:
+        _output = args.output or f"{_base}.json"
+        with open(_output, "w") as f:
+            json.dump({"traceEvents": _events, "displayTimeUnit": "ns"}, f)
+        print(f"[omnitrace] wrote {len(_events)} events to {_output}")
+
+    # the layout of a sample depends on the build of omnitrace so the samples are
+    # only extracted
+    for itr in _dump:
+        if itr.kind != SAMPLING_SECTION:
+            continue
+        _output = f"{_base}-samples-{itr.tid}.bin"
+        with open(_output, "wb") as f:
+            f.write(itr.data)
+        _count = len(itr.data) // itr.entry_size if itr.entry_size > 0 else 0
+        print(
+            f"[omnitrace] wrote {_count} samples ({itr.entry_size} bytes each) of "
+            f"thread {itr.tid} to {_output}"
+        )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -33,13 +33,13 @@ __status__ = "Development"
 from functools import wraps
 
 from . import libpyomnitrace
-from .libpyomnitrace import user as _libuser
 from .libpyomnitrace.user import start_trace
 from .libpyomnitrace.user import start_thread_trace
 from .libpyomnitrace.user import stop_trace
 from .libpyomnitrace.user import stop_thread_trace
 from .libpyomnitrace.user import push_region
 from .libpyomnitrace.user import pop_region
+from .libpyomnitrace.user import region_handle as RegionHandle
 
 from .common import _initialize
 from .common import _file
@@ -48,6 +48,7 @@ from .common import _file
 __all__ = [
     "region",
     "Region",
+    "RegionHandle",
     "start_trace",
     "start_thread_trace",
     "stop_trace",
@@ -64,9 +65,10 @@ class Region:
     _counter = 0
 
     def __init__(self, _label):
-        """Stores the label"""
+        """Stores the label and the native region of the label"""
         self._active = False
         self._label = _label
+        self._region = RegionHandle(_label)
         self._count = 0
         self._file = _file() if Region._counter == 0 else None
 
@@ -83,7 +85,7 @@ class Region:
             if self._file is not None:
                 _initialize(self._file)
             Region._counter += 1
-            _libuser.push_region(self._label)
+            self._region.push()
 
     def stop(self):
         """Stop the region"""
@@ -96,20 +98,24 @@ class Region:
                 raise RuntimeError(
                     f"{self._label} was not popped in the order it was pushed. Current stack number: {_count}, expected stack number: {self._count}"
                 )
-            _libuser.pop_region(self._label)
+            self._region.pop()
 
     def __call__(self, func):
-        """Decorator"""
+        """Decorator. Every call of the wrapped function enters and exits the native
+        region of the label, which is created once, so the calls may be recursive or
+        on multiple threads"""
+
+        _region = self._region
+        _file = self._file
 
         @wraps(func)
         def function_wrapper(*args, **kwargs):
-            # start the region
-            self.start()
-            # execute the wrapped function
-            result = func(*args, **kwargs)
-            # stop the region
-            self.stop()
-            return result
+            nonlocal _file
+            if _file is not None:
+                _initialize(_file)
+                _file = None
+            with _region:
+                return func(*args, **kwargs)
 
         return function_wrapper
 
@@ -51,3 +51,22 @@ set_tests_properties(
                "Outputting.*(perfetto-trace.proto).*Outputting.*(wall_clock.txt)"
                FAIL_REGULAR_EXPRESSION
                "Dyninst was unable to attach to the specified process")
+
+add_test(
+    NAME parallel-overhead-sample-attach
+    COMMAND
+        ${CMAKE_CURRENT_LIST_DIR}/run-omnitrace-pid.sh $<TARGET_FILE:omnitrace-sample>
+        --duration 5 -f 200 -o omnitrace-tests-output/parallel-overhead-sample-attach --
+        $<TARGET_FILE:parallel-overhead> 30 8 1000
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+set_tests_properties(
+    parallel-overhead-sample-attach
+    PROPERTIES TIMEOUT
+               120
+               LABELS
+               "parallel-overhead;attach"
+               PASS_REGULAR_EXPRESSION
+               "Outputting.*(attach-[0-9]+.txt).*Outputting.*(attach-[0-9]+.json)"
+               FAIL_REGULAR_EXPRESSION
+               "unable to sample any thread")
@@ -33,6 +33,41 @@ omnitrace_add_causal_test(
         "Starting causal experiment #1(.*)causal/experiments.json(.*)causal/experiments.coz"
     )
 
+omnitrace_add_causal_test(
+    SKIP_BASELINE
+    NAME cpu-omni-func-jobs
+    TARGET causal-cpu-omni
+    RUN_ARGS 70 10 432525 1000000000
+    CAUSAL_MODE "function"
+    CAUSAL_ARGS -r -j 2 -s 0,10,25,50
+    CAUSAL_PASS_REGEX
+        "Starting causal experiment #1(.*)causal/experiments.json(.*)causal/experiments.coz"
+    )
+
+omnitrace_add_causal_test(
+    SKIP_BASELINE
+    NAME cpu-omni-func-adaptive
+    TARGET causal-cpu-omni
+    RUN_ARGS 70 10 432525 1000000000
+    CAUSAL_MODE "function"
+    CAUSAL_ARGS -n 2 -s 0,10,25,50
+    ENVIRONMENT "OMNITRACE_CAUSAL_ADAPTIVE=ON;OMNITRACE_VERBOSE=1"
+    CAUSAL_PASS_REGEX
+        "Causal experiment #1 (.*)selection reason: (explore|baseline)(.*)causal/experiments.coz"
+    )
+
+omnitrace_add_causal_test(
+    SKIP_BASELINE
+    NAME cpu-omni-func-log
+    TARGET causal-cpu-omni
+    RUN_ARGS 70 10 432525 1000000000
+    CAUSAL_MODE "function"
+    CAUSAL_ARGS -r -n 2 -s 0,10,25,50
+    ENVIRONMENT "OMNITRACE_CAUSAL_LOG=ON;OMNITRACE_CAUSAL_LOG_EXPORT=ON"
+    CAUSAL_PASS_REGEX
+        "Starting causal experiment #1(.*)causal/experiments.log(.*)causal/experiments.json(.*)causal/experiments.coz"
+    )
+
 omnitrace_add_causal_test(
     NAME both-omni-func
     TARGET causal-both-omni
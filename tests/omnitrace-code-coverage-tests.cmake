@@ -135,3 +135,88 @@ omnitrace_add_test(
     ENVIRONMENT "${_base_environment}"
     RUNTIME_PASS_REGEX "(\\\[[0-9]+\\\]) function coverage ::  66.67%"
     REWRITE_RUN_PASS_REGEX "(\\\[[0-9]+\\\]) function coverage ::  66.67%")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME code-coverage-counters
+    TARGET code-coverage
+    REWRITE_ARGS
+        -e
+        -v
+        2
+        --min-instructions=4
+        -E
+        ^std::
+        -M
+        coverage
+        --coverage
+        function
+        --coverage-counters
+    RUNTIME_ARGS
+        -e
+        -v
+        1
+        --min-instructions=4
+        -E
+        ^std::
+        -M
+        coverage
+        --coverage
+        function
+        --coverage-counters
+        --module-restrict
+        code.coverage
+    LABELS "coverage;function-coverage;counter-coverage"
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_base_environment}"
+    RUNTIME_PASS_REGEX "(\\\[[0-9]+\\\]) code coverage     ::  66.67%"
+    REWRITE_RUN_PASS_REGEX "(\\\[[0-9]+\\\]) code coverage     ::  66.67%")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME code-coverage-basic-blocks-counters
+    TARGET code-coverage
+    REWRITE_ARGS
+        -e
+        -v
+        2
+        --min-instructions=4
+        -E
+        ^std::
+        -M
+        coverage
+        --coverage
+        basic_block
+        --coverage-counters
+    RUNTIME_ARGS
+        -e
+        -v
+        1
+        --min-instructions=4
+        -E
+        ^std::
+        -M
+        coverage
+        --coverage
+        basic_block
+        --coverage-counters
+        --module-restrict
+        code.coverage
+    LABELS "coverage;bb-coverage;counter-coverage"
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_base_environment}"
+    RUNTIME_PASS_REGEX "(\\\[[0-9]+\\\]) function coverage ::  66.67%"
+    REWRITE_RUN_PASS_REGEX "(\\\[[0-9]+\\\]) function coverage ::  66.67%")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME code-coverage-sampling
+    TARGET code-coverage
+    LABELS "coverage;sampling-coverage"
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_SAMPLING_FREQ=500;OMNITRACE_SAMPLING_COVERAGE=ON"
+    SAMPLING_PASS_REGEX
+        "approximate code coverage     :: (.*)approximate function coverage :: (.*)Outputting '(.*)sampling-coverage.json'"
+    SAMPLING_FAIL_REGEX
+        "no samples|writing the sampling code coverage failed|OMNITRACE_ABORT_FAIL_REGEX")
@@ -0,0 +1,30 @@
+# -------------------------------------------------------------------------------------- #
+#
+# finalization scalability benchmarks
+#
+# -------------------------------------------------------------------------------------- #
+
+option(OMNITRACE_CI_FINALIZE_BENCHMARK_FULL
+       "Enable the full sweep of the finalization benchmark (up to 512 threads)" OFF)
+mark_as_advanced(OMNITRACE_CI_FINALIZE_BENCHMARK_FULL)
+
+# the results are written to omnitrace-tests-output/<name>/results.{csv,json}
+omnitrace_add_finalize_benchmark(
+    NAME finalize-scaling-benchmark
+    TARGET finalize-scaling
+    THREADS 1 4 16
+    DURATIONS 100 1000
+    BACKENDS none sampling sampling+perfetto sampling+timemory
+             sampling+perfetto+timemory+process-sampling
+    TIMEOUT 600)
+
+if(OMNITRACE_CI_FINALIZE_BENCHMARK_FULL)
+    omnitrace_add_finalize_benchmark(
+        NAME finalize-scaling-benchmark-full
+        TARGET finalize-scaling
+        THREADS 1 2 4 8 16 32 64 128 256 512
+        DURATIONS 100 1000 10000
+        BACKENDS sampling perfetto timemory sampling+perfetto+timemory
+                 sampling+perfetto+timemory+process-sampling
+        TIMEOUT 7200)
+endif()
@@ -17,3 +17,12 @@ omnitrace_add_test(
     SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})"
     RUNTIME_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})"
     REWRITE_RUN_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME fork-child-capture
+    TARGET fork-example
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_SAMPLING_FREQ=250;OMNITRACE_FORK_CHILD_CAPTURE=ON"
+    SAMPLING_PASS_REGEX "fork-child-profile"
+    SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
@@ -42,6 +42,123 @@ omnitrace_add_test(
     RUN_ARGS 10 ${NUM_THREADS} 1000
     ENVIRONMENT "${_base_environment}")
 
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_SAMPLING
+    NAME parallel-overhead-throttle
+    TARGET parallel-overhead
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_THROTTLE_COUNT=100;OMNITRACE_THROTTLE_PER_CALL_NS=1000000"
+    REWRITE_RUN_PASS_REGEX "\\[throttle\\] disabling 'fib")
+
+# the TSC is only used when the CPU reports an invariant TSC (constant_tsc and
+# nonstop_tsc) and the kernel clocksource is the TSC, otherwise the fallback is checked
+set(_tsc_clock_regex "(TSC is not invariant|kernel clocksource is '(.*)', not the TSC)")
+if(EXISTS "/sys/devices/system/clocksource/clocksource0/current_clocksource"
+   AND EXISTS "/proc/cpuinfo")
+    file(READ "/sys/devices/system/clocksource/clocksource0/current_clocksource"
+         _TSC_CLOCKSOURCE)
+    file(STRINGS "/proc/cpuinfo" _TSC_CPU_FLAGS REGEX "^flags" LIMIT_COUNT 1)
+    if(_TSC_CLOCKSOURCE MATCHES "^tsc"
+       AND _TSC_CPU_FLAGS MATCHES " constant_tsc"
+       AND _TSC_CPU_FLAGS MATCHES " nonstop_tsc")
+        set(_tsc_clock_regex
+            "TSC calibrated :: [0-9.]+ MHz \\(recalibrated every 0.250 sec\\)")
+    endif()
+endif()
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME
+    NAME parallel-overhead-tsc
+    TARGET parallel-overhead
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_TSC_CLOCK=ON;OMNITRACE_TSC_CLOCK_INTERVAL=0.25;OMNITRACE_USE_SAMPLING=ON;OMNITRACE_VERBOSE=1"
+    SAMPLING_PASS_REGEX "${_tsc_clock_regex}(.*)Outputting '(.*)wall_clock.txt'"
+    REWRITE_RUN_PASS_REGEX "${_tsc_clock_regex}(.*)Outputting '(.*)wall_clock.txt'")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME
+    NAME parallel-overhead-fast-start
+    TARGET parallel-overhead
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_FAST_START=ON;OMNITRACE_TSC_CLOCK=ON"
+    REWRITE_RUN_PASS_REGEX "Startup phases \\(msec\\): CONFIGURE=")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME
+    NAME parallel-overhead-self-profile
+    TARGET parallel-overhead
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_SELF_PROFILE=ON;OMNITRACE_USE_SAMPLING=ON"
+    REWRITE_RUN_PASS_REGEX
+        "Time spent inside omnitrace by [0-9]+ threads.*region +::.*sampling +::")
+
+# the TLB counters are not required since perf events may be unavailable on the runners
+set(_huge_pages_pass_regex
+    "Hot buffers of omnitrace \\(OMNITRACE_HUGE_PAGES=ON\\):(.*)regular +:: +[0-9.]+ MB(.*)hugetlb +:: +[0-9.]+ MB(.*)transparent +:: +[0-9.]+ MB"
+    )
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME
+    NAME parallel-overhead-huge-pages
+    TARGET parallel-overhead
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_HUGE_PAGES=ON;OMNITRACE_SELF_PROFILE=ON;OMNITRACE_USE_SAMPLING=ON;OMNITRACE_SAMPLING_FREQ=250"
+    SAMPLING_PASS_REGEX "${_huge_pages_pass_regex}"
+    REWRITE_RUN_PASS_REGEX "${_huge_pages_pass_regex}")
+
+# omnitrace-sample does not start a drain process so the files are moved at the end of
+# the finalization whereas omnitrace-run leaves them to its drain process
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME
+    NAME parallel-overhead-output-staging
+    TARGET parallel-overhead
+    REWRITE_ARGS -e -v 2 --min-instructions=8
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_OUTPUT_STAGING=${PROJECT_BINARY_DIR}/omnitrace-tests-staging"
+    SAMPLING_PASS_REGEX
+        "Outputting '(.*)/omnitrace-staging-[0-9]+(.*)wall_clock.txt'(.*)Moved [1-9][0-9]* staged output files"
+    REWRITE_RUN_PASS_REGEX "Outputting '(.*)/omnitrace-staging-[0-9]+(.*)wall_clock.txt'"
+    REWRITE_RUN_FAIL_REGEX
+        "Moving the staged output files|Staged output (.*) cannot be moved|OMNITRACE_ABORT_FAIL_REGEX"
+    )
+
+set(_output_compression_methods)
+if(OMNITRACE_USE_ZLIB)
+    list(APPEND _output_compression_methods "gzip:gz")
+endif()
+if(OMNITRACE_USE_ZSTD)
+    list(APPEND _output_compression_methods "zstd:zst")
+endif()
+
+foreach(_ENTRY ${_output_compression_methods})
+    string(REPLACE ":" ";" _ENTRY "${_ENTRY}")
+    list(GET _ENTRY 0 _METHOD)
+    list(GET _ENTRY 1 _EXT)
+
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+        NAME parallel-overhead-compression-${_METHOD}
+        TARGET parallel-overhead
+        LABELS "compression"
+        RUN_ARGS 10 4 1000
+        ENVIRONMENT
+            "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_OUTPUT_COMPRESSION=${_METHOD}"
+        SAMPLING_PASS_REGEX
+            "Outputting '(.*)perfetto-trace.proto.${_EXT}'(.*)Compressed '(.*)wall_clock.json' to '(.*)wall_clock.json.${_EXT}'"
+        SAMPLING_FAIL_REGEX "Error (writing|compressing)|OMNITRACE_ABORT_FAIL_REGEX")
+endforeach()
+
 omnitrace_add_test(
     SKIP_BASELINE SKIP_RUNTIME
     NAME parallel-overhead-locks-perfetto
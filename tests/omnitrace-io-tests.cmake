@@ -0,0 +1,16 @@
+# -------------------------------------------------------------------------------------- #
+#
+# POSIX I/O tracing tests
+#
+# -------------------------------------------------------------------------------------- #
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME io-trace
+    TARGET io-example
+    LABELS "io"
+    RUN_ARGS 4 256 65536
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_IO_TRACE=ON;OMNITRACE_IO_TRACE_THRESHOLD_NS=100000;OMNITRACE_VERBOSE=1"
+    SAMPLING_PASS_REGEX "Outputting '(.*)io-trace.txt'"
+    SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
@@ -56,6 +56,74 @@ omnitrace_add_test(
         "${_base_environment};OMNITRACE_USE_KOKKOSP=ON;OMNITRACE_COUT_OUTPUT=ON;OMNITRACE_SAMPLING_FREQ=50;OMNITRACE_KOKKOSP_PREFIX=[kokkos];KOKKOS_PROFILE_LIBRARY=libomnitrace-dl.so"
     BASELINE_PASS_REGEX "\\|_\\[kokkos\\] [a-zA-Z]")
 
+omnitrace_add_test(
+    SKIP_RUNTIME SKIP_REWRITE
+    NAME lulesh-baseline-kokkosp-kernel-summary
+    TARGET lulesh
+    MPI ${LULESH_USE_MPI}
+    GPU ${LULESH_USE_GPU}
+    NUM_PROCS 8
+    LABELS "kokkos;kokkos-profile-library"
+    RUN_ARGS -i 10 -s 20 -p
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_USE_KOKKOSP=ON;OMNITRACE_KOKKOSP_KERNEL_SUMMARY=ON;KOKKOS_PROFILE_LIBRARY=libomnitrace-dl.so"
+    BASELINE_PASS_REGEX "Outputting '(.*)kokkos-kernels.txt'")
+
+omnitrace_add_test(
+    SKIP_RUNTIME SKIP_REWRITE
+    NAME lulesh-baseline-kokkosp-memory-analysis
+    TARGET lulesh
+    MPI ${LULESH_USE_MPI}
+    GPU ${LULESH_USE_GPU}
+    NUM_PROCS 8
+    LABELS "kokkos;kokkos-profile-library"
+    RUN_ARGS -i 10 -s 20 -p
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_USE_KOKKOSP=ON;OMNITRACE_KOKKOSP_MEMORY_ANALYSIS=ON;KOKKOS_PROFILE_LIBRARY=libomnitrace-dl.so"
+    BASELINE_PASS_REGEX "Outputting '(.*)kokkos-memory.txt'")
+
+# a single rank so that one process saves the tuned configurations which the second
+# test reads. Kokkos only requests the team sizes when its internals are tuned
+set(_kokkosp_tuning_file
+    ${PROJECT_BINARY_DIR}/omnitrace-tests-output/lulesh-kokkosp-tuning/tuned.txt)
+set(_kokkosp_tuning_environment
+    "${_base_environment}" "OMNITRACE_USE_KOKKOSP=ON" "OMNITRACE_KOKKOSP_TUNING=ON"
+    "OMNITRACE_KOKKOSP_TUNING_TRIALS=8"
+    "OMNITRACE_KOKKOSP_TUNING_FILE=${_kokkosp_tuning_file}" "OMNITRACE_VERBOSE=1"
+    "KOKKOS_TUNE_INTERNALS=1" "KOKKOS_PROFILE_LIBRARY=libomnitrace-dl.so")
+
+omnitrace_add_test(
+    SKIP_RUNTIME SKIP_REWRITE SKIP_SAMPLING
+    NAME lulesh-kokkosp-tuning
+    TARGET lulesh
+    MPI ${LULESH_USE_MPI}
+    GPU ${LULESH_USE_GPU}
+    NUM_PROCS 1
+    LABELS "kokkos;kokkos-profile-library;kokkos-tuning"
+    RUN_ARGS -i 10 -s 20 -p
+    ENVIRONMENT "${_kokkosp_tuning_environment}"
+    BASELINE_PASS_REGEX
+        "Outputting '${_kokkosp_tuning_file}'(.*)Outputting '(.*)kokkos-tuning.txt'")
+
+omnitrace_add_test(
+    SKIP_RUNTIME SKIP_REWRITE SKIP_SAMPLING
+    NAME lulesh-kokkosp-tuning-persisted
+    TARGET lulesh
+    MPI ${LULESH_USE_MPI}
+    GPU ${LULESH_USE_GPU}
+    NUM_PROCS 1
+    LABELS "kokkos;kokkos-profile-library;kokkos-tuning"
+    RUN_ARGS -i 10 -s 20 -p
+    ENVIRONMENT "${_kokkosp_tuning_environment}"
+    BASELINE_PASS_REGEX
+        "\\[kokkos-tuning\\] read [1-9][0-9]* tuned configurations from '${_kokkosp_tuning_file}'"
+    )
+
+if(TEST lulesh-kokkosp-tuning-persisted-baseline)
+    set_tests_properties(lulesh-kokkosp-tuning-persisted-baseline
+                         PROPERTIES DEPENDS lulesh-kokkosp-tuning-baseline)
+endif()
+
 omnitrace_add_test(
     SKIP_BASELINE
     NAME lulesh-kokkosp
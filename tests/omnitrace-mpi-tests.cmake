@@ -77,6 +77,42 @@ omnitrace_add_test(
         ">>> mpi-flat.inst(.*\n.*)>>> MPI_Init_thread(.*\n.*)>>> pthread_create(.*\n.*)>>> MPI_Comm_size(.*\n.*)>>> MPI_Comm_rank(.*\n.*)>>> MPI_Barrier(.*\n.*)>>> MPI_Alltoall"
     )
 
+omnitrace_add_test(
+    SKIP_RUNTIME SKIP_SAMPLING
+    NAME "mpi-aggregate"
+    TARGET mpi-example
+    MPI ON
+    NUM_PROCS 2
+    REWRITE_ARGS -e -v 2 --min-instructions 0
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_PROFILE_AGGREGATE=ON"
+    REWRITE_RUN_PASS_REGEX "(/[A-Za-z-]+/wall_clock-aggregate(-[0-9]+)?.txt')"
+    REWRITE_RUN_FAIL_REGEX "wall_clock-[0-9]+.(json|txt)|OMNITRACE_ABORT_FAIL_REGEX")
+
+# the clock offsets are only estimated with full MPI support
+if(OMNITRACE_USE_MPI)
+    omnitrace_add_test(
+        SKIP_RUNTIME SKIP_SAMPLING
+        NAME "mpi-clock-sync"
+        TARGET mpi-example
+        MPI ON
+        NUM_PROCS 2
+        REWRITE_ARGS -e -v 2 --min-instructions 0
+        ENVIRONMENT
+            "${_base_environment};OMNITRACE_VERBOSE=2;OMNITRACE_PERFETTO_CLOCK_SYNC=ON"
+        REWRITE_RUN_PASS_REGEX "clock_sync\\] rank 1: offset from rank 0")
+endif()
+
+omnitrace_add_test(
+    SKIP_RUNTIME SKIP_SAMPLING
+    NAME "mpi-rank-selection"
+    TARGET mpi-example
+    MPI ON
+    NUM_PROCS 2
+    REWRITE_ARGS -e -v 2 --min-instructions 0
+    ENVIRONMENT "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_MPI_RANKS=0"
+    REWRITE_RUN_PASS_REGEX "rank 1 of 2 \\(local rank -?[0-9]+\\) is not in OMNITRACE_MPI_RANKS")
+
 set(_mpip_environment
     "OMNITRACE_TRACE=ON"
     "OMNITRACE_PROFILE=ON"
@@ -120,3 +156,32 @@ foreach(_EXAMPLE all2all allgather allreduce bcast reduce scatter-gather send-re
         RUN_ARGS 30
         ENVIRONMENT "${_mpip_${_EXAMPLE}_environment}")
 endforeach()
+
+# the wait-state analysis and the MPI_T variables require the full MPI support
+if(OMNITRACE_USE_MPI)
+    omnitrace_add_test(
+        SKIP_RUNTIME SKIP_SAMPLING
+        NAME "mpi-send-recv-wait-state"
+        TARGET mpi-send-recv
+        MPI ON
+        NUM_PROCS 2
+        LABELS "mpip"
+        REWRITE_ARGS -e -v 2 --label file line --min-instructions 0
+        RUN_ARGS 30
+        ENVIRONMENT "${_mpip_environment};OMNITRACE_MPI_WAIT_STATE=ON"
+        REWRITE_RUN_PASS_REGEX
+            "mpi_wait_state\\] matched the send time of [1-9][0-9]* of [0-9]+ receives")
+
+    omnitrace_add_test(
+        SKIP_RUNTIME SKIP_SAMPLING
+        NAME "mpi-send-recv-pvars"
+        TARGET mpi-send-recv
+        MPI ON
+        NUM_PROCS 2
+        LABELS "mpip"
+        REWRITE_ARGS -e -v 2 --label file line --min-instructions 0
+        RUN_ARGS 30
+        ENVIRONMENT
+            "${_mpip_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_PROCESS_SAMPLING=ON;OMNITRACE_MPI_PVARS=unexpected|posted|msgq|recvq"
+        REWRITE_RUN_PASS_REGEX "Sampling [1-9][0-9]* MPI_T performance variables")
+endif()
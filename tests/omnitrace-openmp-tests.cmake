@@ -23,6 +23,55 @@ omnitrace_add_test(
     RUNTIME_PASS_REGEX "${_OMPT_PASS_REGEX}"
     REWRITE_FAIL_REGEX "0 instrumented loops in procedure")
 
+omnitrace_add_test(
+    SKIP_RUNTIME
+    NAME openmp-cg-loop-trips
+    TARGET openmp-cg
+    LABELS "openmp;loops"
+    REWRITE_ARGS -e -v 2 --loop-trip-counts
+    REWRITE_TIMEOUT 180
+    ENVIRONMENT
+        "${_ompt_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_SAMPLING=ON;OMNITRACE_SAMPLING_FREQ=100"
+    REWRITE_RUN_PASS_REGEX "Post-processed [1-9][0-9]* loop trip count records"
+    REWRITE_FAIL_REGEX "0 instrumented loops in procedure")
+
+if(OMNITRACE_OPENMP_USING_LIBOMP_LIBRARY AND OMNITRACE_USE_OMPT)
+    omnitrace_add_test(
+        SKIP_RUNTIME
+        NAME openmp-cg-ompt-aggregate
+        TARGET openmp-cg
+        LABELS "openmp"
+        REWRITE_ARGS -e -v 2
+        REWRITE_TIMEOUT 180
+        ENVIRONMENT
+            "${_ompt_environment};OMNITRACE_USE_SAMPLING=OFF;OMNITRACE_OMPT_AGGREGATE=ON;OMNITRACE_OMPT_AGGREGATE_SAMPLE_INTERVAL=100"
+        REWRITE_RUN_PASS_REGEX "Outputting '(.*)ompt_summary.txt'")
+
+    omnitrace_add_test(
+        SKIP_RUNTIME
+        NAME openmp-cg-ompt-barrier
+        TARGET openmp-cg
+        LABELS "openmp"
+        REWRITE_ARGS -e -v 2
+        REWRITE_TIMEOUT 180
+        ENVIRONMENT
+            "${_ompt_environment};OMNITRACE_USE_SAMPLING=OFF;OMNITRACE_OMPT_BARRIER_ANALYSIS=ON"
+        REWRITE_RUN_PASS_REGEX "Outputting '(.*)ompt_barrier.txt'")
+
+    # the example does not offload so this only checks that enabling the device tracing
+    # on a host-only runtime is harmless
+    omnitrace_add_test(
+        SKIP_RUNTIME
+        NAME openmp-cg-ompt-device
+        TARGET openmp-cg
+        LABELS "openmp"
+        REWRITE_ARGS -e -v 2
+        REWRITE_TIMEOUT 180
+        ENVIRONMENT
+            "${_ompt_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_SAMPLING=OFF;OMNITRACE_OMPT_DEVICE_TRACING=ON"
+        REWRITE_RUN_PASS_REGEX "No OpenMP target regions were recorded")
+endif()
+
 omnitrace_add_test(
     SKIP_RUNTIME
     NAME openmp-lu
@@ -64,6 +113,168 @@ set(_ompt_sample_no_tmpfiles_environ
     "OMNITRACE_USE_TEMPORARY_FILES=OFF"
     "OMNITRACE_MONOCHROME=ON")
 
+set(_ompt_sample_per_thread_offload_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_OFFLOAD_PER_THREAD=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_streaming_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_STREAMING=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_deferred_symbols_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_DEFERRED_SYMBOLS=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_aggregate_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_AGGREGATE=ON"
+    "OMNITRACE_SAMPLING_AGGREGATE_CHECKPOINT=100"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_perf_backend_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_PERF_BACKEND=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_offcpu_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_OFFCPU=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_overhead_target_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=5000"
+    "OMNITRACE_SAMPLING_OVERHEAD_TARGET=1.0"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_numa_allocators_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_ALLOCATOR_SIZE=2"
+    "OMNITRACE_SAMPLING_NUMA_ALLOCATORS=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_compact_offload_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_COMPACT_OFFLOAD=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_thread_group_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_THREAD_GROUP=ON"
+    "OMNITRACE_SAMPLING_THREAD_GROUP_RATE=1000"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_frame_pointer_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_UNWINDER=frame-pointer"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_unwinder_auto_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_UNWINDER=auto"
+    "OMNITRACE_MONOCHROME=ON")
+
+set(_ompt_sample_memfd_tmp_environ
+    "${_ompt_environment}"
+    "OMNITRACE_VERBOSE=2"
+    "OMNITRACE_USE_OMPT=OFF"
+    "OMNITRACE_USE_SAMPLING=ON"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME=ON"
+    "OMNITRACE_SAMPLING_REALTIME=OFF"
+    "OMNITRACE_SAMPLING_CPUTIME_FREQ=700"
+    "OMNITRACE_SAMPLING_OFFLOAD_PER_THREAD=ON"
+    "OMNITRACE_SAMPLING_COMPACT_OFFLOAD=ON"
+    "OMNITRACE_TMP_BACKEND=memfd"
+    "OMNITRACE_TMP_SEAL=ON"
+    "OMNITRACE_MONOCHROME=ON")
+
 set(_ompt_sampling_samp_regex
     "Sampler for thread 0 will be triggered 1000.0x per second of CPU-time(.*)Sampler for thread 0 will be triggered 500.0x per second of wall-time(.*)Sampling will be disabled after 0.250000 seconds(.*)Sampling duration of 0.250000 seconds has elapsed. Shutting down sampling"
     )
@@ -73,6 +284,46 @@ set(_ompt_sampling_file_regex
 set(_notmp_sampling_file_regex
     "sampling-no-tmp-files-sampling/sampling_percent.(json|txt)(.*)sampling-no-tmp-files-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-no-tmp-files-sampling/sampling_wall_clock.(json|txt)"
     )
+set(_offload_sampling_file_regex
+    "sampling-offload-per-thread-sampling/sampling_percent.(json|txt)(.*)sampling-offload-per-thread-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-offload-per-thread-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_streaming_sampling_file_regex
+    "sampling-streaming-sampling/sampling_percent.(json|txt)(.*)sampling-streaming-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-streaming-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_deferred_symbols_sampling_file_regex
+    "sampling-deferred-symbols-sampling/sampling_percent.(json|txt)(.*)sampling-deferred-symbols-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-deferred-symbols-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_aggregate_sampling_file_regex
+    "sampling-aggregate-sampling/sampling_percent.(json|txt)(.*)sampling-aggregate-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_overhead_target_sampling_file_regex
+    "Sampling rate of thread 0 was adjusted (.*)sampling-overhead-target-sampling/sampling_percent.(json|txt)(.*)sampling-overhead-target-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-overhead-target-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_numa_allocators_sampling_file_regex
+    "sampling-numa-allocators-sampling/sampling_percent.(json|txt)(.*)sampling-numa-allocators-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-numa-allocators-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_compact_offload_sampling_file_regex
+    "sampling-compact-offload-sampling/sampling_percent.(json|txt)(.*)sampling-compact-offload-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-compact-offload-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_thread_group_sampling_file_regex
+    "Sampler for thread 0 will be triggered up to 700.0x per second of CPU-time by the sampling thread group(.*)sampling-thread-group-sampling/sampling_percent.(json|txt)(.*)sampling-thread-group-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_frame_pointer_sampling_file_regex
+    "sampling-frame-pointer-sampling/sampling_percent.(json|txt)(.*)sampling-frame-pointer-sampling/sampling_cpu_clock.(json|txt)(.*)sampling-frame-pointer-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_unwinder_auto_sampling_file_regex
+    "The call-stacks were unwound by (the frame pointers|libunwind)(.*)sampling-unwinder-auto-sampling/sampling_percent.(json|txt)(.*)sampling-unwinder-auto-sampling/sampling_wall_clock.(json|txt)"
+    )
+# the anonymous files are only named through their descriptors in /proc/self/fd
+set(_memfd_tmp_sampling_pass_regex "Removing temporary file '/proc/self/fd/[0-9]+'")
+set(_memfd_tmp_sampling_fail_regex
+    "memfd_create failed|Sealing temporary file (.*) failed|OMNITRACE_ABORT_FAIL_REGEX")
+set(_perf_backend_sampling_file_regex
+    "Sampler for thread 0 will be triggered 700.0x per second of CPU-time via perf_event(.*)sampling-perf-backend-sampling/sampling_percent.(json|txt)(.*)sampling-perf-backend-sampling/sampling_wall_clock.(json|txt)"
+    )
+set(_offcpu_sampling_file_regex
+    "Recording the context switches of thread 0(.*)sampling-offcpu-sampling/sampling-offcpu.(json|txt)"
+    )
 
 omnitrace_add_test(
     SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
@@ -97,3 +348,140 @@ omnitrace_add_test(
     LABELS "openmp;no-tmp-files"
     ENVIRONMENT "${_ompt_sample_no_tmpfiles_environ}"
     SAMPLING_PASS_REGEX "${_notmp_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-offload-per-thread
+    TARGET openmp-cg
+    LABELS "openmp;offload-per-thread"
+    ENVIRONMENT "${_ompt_sample_per_thread_offload_environ}"
+    SAMPLING_PASS_REGEX "${_offload_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-streaming
+    TARGET openmp-cg
+    LABELS "openmp;streaming"
+    ENVIRONMENT "${_ompt_sample_streaming_environ}"
+    SAMPLING_PASS_REGEX "${_streaming_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-deferred-symbols
+    TARGET openmp-cg
+    LABELS "openmp;deferred-symbols"
+    ENVIRONMENT "${_ompt_sample_deferred_symbols_environ}"
+    SAMPLING_PASS_REGEX "${_deferred_symbols_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-aggregate
+    TARGET openmp-cg
+    LABELS "openmp;aggregate"
+    ENVIRONMENT "${_ompt_sample_aggregate_environ}"
+    SAMPLING_PASS_REGEX "${_aggregate_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-overhead-target
+    TARGET openmp-cg
+    LABELS "openmp;overhead-target"
+    ENVIRONMENT "${_ompt_sample_overhead_target_environ}"
+    SAMPLING_PASS_REGEX "${_overhead_target_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-numa-allocators
+    TARGET openmp-cg
+    LABELS "openmp;numa-allocators"
+    ENVIRONMENT "${_ompt_sample_numa_allocators_environ}"
+    SAMPLING_PASS_REGEX "${_numa_allocators_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-compact-offload
+    TARGET openmp-cg
+    LABELS "openmp;compact-offload"
+    ENVIRONMENT "${_ompt_sample_compact_offload_environ}"
+    SAMPLING_PASS_REGEX "${_compact_offload_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-thread-group
+    TARGET openmp-cg
+    LABELS "openmp;thread-group"
+    ENVIRONMENT "${_ompt_sample_thread_group_environ}"
+    SAMPLING_PASS_REGEX "${_thread_group_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-frame-pointer
+    TARGET openmp-cg
+    LABELS "openmp;frame-pointer"
+    ENVIRONMENT "${_ompt_sample_frame_pointer_environ}"
+    SAMPLING_PASS_REGEX "${_frame_pointer_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-unwinder-auto
+    TARGET openmp-cg
+    LABELS "openmp;frame-pointer"
+    ENVIRONMENT "${_ompt_sample_unwinder_auto_environ}"
+    SAMPLING_PASS_REGEX "${_unwinder_auto_sampling_file_regex}")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-sampling-memfd-tmp
+    TARGET openmp-cg
+    LABELS "openmp;memfd-tmp"
+    ENVIRONMENT "${_ompt_sample_memfd_tmp_environ}"
+    SAMPLING_PASS_REGEX "${_memfd_tmp_sampling_pass_regex}"
+    SAMPLING_FAIL_REGEX "${_memfd_tmp_sampling_fail_regex}")
+
+if(omnitrace_perf_event_paranoid LESS_EQUAL 3
+   OR omnitrace_cap_sys_admin EQUAL 0
+   OR omnitrace_cap_perfmon EQUAL 0)
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME openmp-cg-sampling-perf-backend
+        TARGET openmp-cg
+        LABELS "openmp;perf;perf-backend"
+        ENVIRONMENT "${_ompt_sample_perf_backend_environ}"
+        SAMPLING_PASS_REGEX "${_perf_backend_sampling_file_regex}")
+endif()
+
+if(omnitrace_perf_event_paranoid LESS_EQUAL 1
+   OR omnitrace_cap_sys_admin EQUAL 0
+   OR omnitrace_cap_perfmon EQUAL 0)
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME openmp-cg-sampling-offcpu
+        TARGET openmp-cg
+        LABELS "openmp;perf;offcpu"
+        ENVIRONMENT "${_ompt_sample_offcpu_environ}"
+        SAMPLING_PASS_REGEX "${_offcpu_sampling_file_regex}")
+endif()
+
+# the memory controller PMUs are system-wide events
+if(omnitrace_perf_event_paranoid LESS_EQUAL 0
+   OR omnitrace_cap_sys_admin EQUAL 0
+   OR omnitrace_cap_perfmon EQUAL 0)
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+        NAME openmp-cg-memory-bandwidth
+        TARGET openmp-cg
+        LABELS "openmp;perf;memory-bandwidth"
+        ENVIRONMENT
+            "${_ompt_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_PROCESS_SAMPLING=ON;OMNITRACE_MEMORY_BANDWIDTH=ON"
+        SAMPLING_PASS_REGEX "memory-bandwidth.txt")
+endif()
+
+# the small budget of the process samplers makes them shed their samples
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_RUNTIME SKIP_REWRITE
+    NAME openmp-cg-memory-footprint
+    TARGET openmp-cg
+    LABELS "openmp;memory-footprint"
+    ENVIRONMENT
+        "${_ompt_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_PROCESS_SAMPLING=ON;OMNITRACE_MEMORY_FOOTPRINT=ON;OMNITRACE_MEMORY_FOOTPRINT_BUDGET=process_sampling=0.001"
+    SAMPLING_PASS_REGEX "memory-footprint.txt")
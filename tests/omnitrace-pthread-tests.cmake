@@ -32,3 +32,49 @@ omnitrace_add_test(
     REWRITE_RUN_PASS_REGEX
         "start_thread (.*) 4 (.*) pthread_mutex_lock (.*) 4000 (.*) pthread_mutex_unlock (.*) 4000"
     )
+
+omnitrace_add_test(
+    SKIP_RUNTIME
+    NAME parallel-overhead-locks-lazy-thread-setup
+    TARGET parallel-overhead-locks
+    LABELS "locks"
+    REWRITE_ARGS -e -v 2 --min-instructions=32 --dyninst-options InstrStackFrames SaveFPR
+                 TrampRecursive
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_lock_environment};OMNITRACE_FLAT_PROFILE=ON;OMNITRACE_PROFILE=ON;OMNITRACE_TRACE=OFF;OMNITRACE_LAZY_THREAD_SETUP=ON;OMNITRACE_SAMPLING_KEEP_INTERNAL=OFF"
+    REWRITE_RUN_PASS_REGEX
+        "pthread_mutex_lock (.*) 4000 (.*) pthread_mutex_unlock (.*) 4000")
+
+omnitrace_add_test(
+    SKIP_RUNTIME
+    NAME parallel-overhead-locks-contention
+    TARGET parallel-overhead-locks
+    LABELS "locks"
+    REWRITE_ARGS -e -i 256
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_lock_environment};OMNITRACE_PROFILE=OFF;OMNITRACE_TRACE=ON;OMNITRACE_TRACE_THREAD_LOCKS_CONTENTION_NS=1000;OMNITRACE_TRACE_THREAD_LOCKS_SAMPLE_INTERVAL=4;OMNITRACE_SAMPLING_KEEP_INTERNAL=OFF"
+    )
+
+omnitrace_add_test(
+    SKIP_RUNTIME
+    NAME parallel-overhead-locks-profile
+    TARGET parallel-overhead-locks
+    LABELS "locks"
+    REWRITE_ARGS -e -i 256
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_lock_environment};OMNITRACE_PROFILE=OFF;OMNITRACE_TRACE=OFF;OMNITRACE_TRACE_THREAD_LOCKS_PROFILE=ON;OMNITRACE_SAMPLING_KEEP_INTERNAL=OFF"
+    REWRITE_RUN_PASS_REGEX "Outputting '(.*)lock_profile.txt'")
+
+omnitrace_add_test(
+    SKIP_RUNTIME
+    NAME parallel-overhead-heap-profile
+    TARGET parallel-overhead-locks
+    LABELS "locks;heap-profile"
+    REWRITE_ARGS -e -i 256
+    RUN_ARGS 10 4 1000
+    ENVIRONMENT
+        "${_lock_environment};OMNITRACE_PROFILE=OFF;OMNITRACE_TRACE=ON;OMNITRACE_HEAP_PROFILE=ON;OMNITRACE_HEAP_PROFILE_SAMPLE_INTERVAL=64;OMNITRACE_SAMPLING_KEEP_INTERNAL=OFF"
+    REWRITE_RUN_PASS_REGEX "Outputting '(.*)heap-profile.txt'")
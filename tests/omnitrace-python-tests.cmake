@@ -57,6 +57,25 @@ foreach(_VERSION ${OMNITRACE_PYTHON_VERSIONS})
         RUN_ARGS -v 15 -n 5
         ENVIRONMENT "${_python_environment}")
 
+    omnitrace_add_python_test(
+        NAME python-external-sample
+        PYTHON_EXECUTABLE ${_PYTHON_EXECUTABLE}
+        PYTHON_VERSION ${_VERSION}
+        FILE ${CMAKE_SOURCE_DIR}/examples/python/external.py
+        PROFILE_ARGS "--sample"
+        RUN_ARGS -v 10 -n 5
+        ENVIRONMENT "${_python_environment};OMNITRACE_SAMPLING_FREQ=500")
+
+    omnitrace_add_python_test(
+        NAME python-external-gil
+        PYTHON_EXECUTABLE ${_PYTHON_EXECUTABLE}
+        PYTHON_VERSION ${_VERSION}
+        FILE ${CMAKE_SOURCE_DIR}/examples/python/external.py
+        PROFILE_ARGS "--sample"
+        RUN_ARGS -v 10 -n 5
+        ENVIRONMENT
+            "${_python_environment};OMNITRACE_SAMPLING_FREQ=500;OMNITRACE_PYTHON_GIL=ON")
+
     omnitrace_add_python_test(
         STANDALONE
         NAME python-source
@@ -138,6 +157,15 @@ foreach(_VERSION ${OMNITRACE_PYTHON_VERSIONS})
             FAIL_REGEX ".(fib|inefficient)..(noprofile.py).|OMNITRACE_ABORT_FAIL_REGEX"
             DEPENDS python-builtin-noprofile-${_VERSION}
             ENVIRONMENT "${_python_environment}")
+
+        omnitrace_add_python_test(
+            NAME python-external-sample-check
+            COMMAND ${OMNITRACE_CAT_COMMAND}
+            PYTHON_VERSION ${_VERSION}
+            FILE omnitrace-tests-output/python-external-sample/${_VERSION}/sampling_wall_clock.txt
+            PASS_REGEX "\\\|_(fib|inefficient)"
+            DEPENDS python-external-sample-${_VERSION}
+            ENVIRONMENT "${_python_environment}")
     else()
         omnitrace_message(
             WARNING
@@ -145,6 +173,28 @@ foreach(_VERSION ${OMNITRACE_PYTHON_VERSIONS})
             )
     endif()
 
+    omnitrace_add_python_test(
+        NAME python-external-compare
+        COMMAND ${_PYTHON_EXECUTABLE} -m omnitrace.compare -c
+                omnitrace-tests-output/python-external-annotated/${_VERSION} -b
+        PYTHON_VERSION ${_VERSION}
+        FILE omnitrace-tests-output/python-external/${_VERSION}
+        PASS_REGEX "nodes compared"
+        DEPENDS python-external-${_VERSION} python-external-${_VERSION}-annotated
+        ENVIRONMENT "${_python_environment}")
+
+    omnitrace_add_python_test(
+        NAME python-emergency-dump
+        COMMAND ${_PYTHON_EXECUTABLE} -m omnitrace.emergency -o
+                omnitrace-tests-output/emergency-dump/emergency-dump-${_VERSION}.json
+        PYTHON_VERSION ${_VERSION}
+        FILE omnitrace-tests-output/emergency-dump/emergency-dump.bin
+        PASS_REGEX "emergency-dump.bin: pid [0-9]+, signal 15, [0-9]+ sections"
+        FAIL_REGEX "\\(incomplete\\)|OMNITRACE_ABORT_FAIL_REGEX"
+        DEPENDS emergency-dump
+        LABELS "emergency-dump"
+        ENVIRONMENT "${_python_environment}")
+
     function(OMNITRACE_ADD_PYTHON_VALIDATION_TEST)
         cmake_parse_arguments(
             TEST "" "NAME;TIMEMORY_METRIC;TIMEMORY_FILE;PERFETTO_METRIC;PERFETTO_FILE"
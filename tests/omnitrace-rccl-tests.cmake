@@ -58,3 +58,33 @@ foreach(_TARGET ${RCCL_TEST_TARGETS})
                  1
         ENVIRONMENT "${_rccl_environment}")
 endforeach()
+
+if("rccl-tests::all_reduce_perf" IN_LIST RCCL_TEST_TARGETS)
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+        NAME rccl-test-all-reduce-perf-device-timing
+        TARGET rccl-tests::all_reduce_perf
+        LABELS "rccl-tests;rcclp"
+        MPI ON
+        GPU ON
+        NUM_PROCS 1
+        RUN_ARGS -t
+                 1
+                 -g
+                 1
+                 -i
+                 10
+                 -w
+                 2
+                 -m
+                 2
+                 -p
+                 -c
+                 1
+                 -z
+                 -s
+                 1
+        ENVIRONMENT
+            "${_rccl_environment};OMNITRACE_USE_ROCTRACER=ON;OMNITRACE_RCCLP_DEVICE_TIMING=ON"
+        SAMPLING_PASS_REGEX "rccl_timing.txt")
+endif()
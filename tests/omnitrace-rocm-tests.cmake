@@ -40,6 +40,122 @@ omnitrace_add_test(
         "${_base_environment};OMNITRACE_ROCTRACER_HSA_ACTIVITY=OFF;OMNITRACE_ROCTRACER_HSA_API=OFF"
     )
 
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-collapse-gpu-wait
+    TARGET transpose
+    LABELS "collapse-gpu-wait"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=2;OMNITRACE_USE_SAMPLING=ON;OMNITRACE_SAMPLING_REALTIME=ON;OMNITRACE_SAMPLING_REALTIME_FREQ=1000;OMNITRACE_SAMPLING_COLLAPSE_GPU_WAIT=ON"
+    SAMPLING_PASS_REGEX "samples were taken while waiting for the GPU")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-critical-path
+    TARGET transpose
+    LABELS "critical-path"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_CRITICAL_PATH=ON"
+    SAMPLING_PASS_REGEX "Critical path of .* msec over .* nodes")
+
+omnitrace_add_causal_test(
+    SKIP_BASELINE
+    NAME transpose-kernel-e2e
+    TARGET transpose
+    LABELS "causal-e2e;roctracer"
+    RUN_ARGS 1 2 2
+    CAUSAL_MODE "kernel"
+    CAUSAL_ARGS -e -s 50
+    CAUSAL_PASS_REGEX
+        "Starting causal experiment #1(.*)causal/experiments.json(.*)causal/experiments.coz"
+    ENVIRONMENT "OMNITRACE_USE_ROCTRACER=ON")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-gpu-memory
+    TARGET transpose
+    LABELS "roctracer"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_GPU_MEMORY_TRACKING=ON"
+    SAMPLING_PASS_REGEX "gpu-memory.txt")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-energy
+    TARGET transpose
+    LABELS "rocm-smi"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_PROCESS_SAMPLING=ON;OMNITRACE_USE_ROCM_SMI=ON;OMNITRACE_ENERGY=ON"
+    SAMPLING_PASS_REGEX "energy.txt")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-gpu-attribution
+    TARGET transpose
+    LABELS "rocm-smi;roctracer"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_PROCESS_SAMPLING=ON;OMNITRACE_USE_ROCM_SMI=ON;OMNITRACE_GPU_ATTRIBUTION=ON"
+    SAMPLING_PASS_REGEX "gpu-attribution.txt")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-trace-triggers
+    TARGET transpose
+    LABELS "roctracer"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_TRACE_TRIGGERS=kernel=transpose@2+2"
+    SAMPLING_PASS_REGEX "Opening the trace window of 'kernel=transpose@2")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-hsa-api-sampling
+    TARGET transpose
+    LABELS "roctracer"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_ROCTRACER_HSA_API=ON;OMNITRACE_ROCTRACER_HSA_API_SAMPLING=10:100"
+    SAMPLING_PASS_REGEX "HSA API tracing suppressed [0-9]+ of [0-9]+ calls")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME transpose-deferred-hip-api-args
+    TARGET transpose
+    LABELS "roctracer;perfetto"
+    MPI OFF
+    GPU ON
+    NUM_PROCS 1
+    RUN_ARGS 1 2 2
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=2;OMNITRACE_PERFETTO_ANNOTATIONS=ON;OMNITRACE_PERFETTO_DEFERRED_ROCTRACER_ANNOTATIONS=ON"
+    SAMPLING_PASS_REGEX "Discarded [0-9]+ deferred HIP API calls")
+
 omnitrace_add_test(
     SKIP_BASELINE SKIP_RUNTIME
     NAME transpose-loops
@@ -94,4 +210,89 @@ if(OMNITRACE_USE_ROCPROFILER)
         REWRITE_RUN_PASS_REGEX
             "rocprof-device-0-GRBM_COUNT.txt(.*)rocprof-device-0-GPUBusy.txt(.*)rocprof-device-0-SQ_WAVES.txt(.*)rocprof-device-0-SQ_INSTS_VALU.txt(.*)rocprof-device-0-VALUInsts.txt(.*)rocprof-device-0-TCC_HIT_sum.txt(.*)rocprof-device-0-TA_TA_BUSY_0.txt(.*)rocprof-device-0-TA_TA_BUSY_11.txt"
         REWRITE_RUN_FAIL_REGEX "roctracer.txt|OMNITRACE_ABORT_FAIL_REGEX")
+
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+        NAME transpose-roofline
+        TARGET transpose
+        LABELS "rocprofiler"
+        MPI OFF
+        GPU ON
+        NUM_PROCS 1
+        RUN_ARGS 1 2 2
+        ENVIRONMENT
+            "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_ROCPROFILER=ON;OMNITRACE_ROCM_ROOFLINE=ON"
+        SAMPLING_PASS_REGEX "roofline.txt(.*)roofline.json")
+endif()
+
+if(OMNITRACE_USE_ROCPROFILER_SDK)
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+        NAME transpose-pc-sampling
+        TARGET transpose
+        LABELS "pc-sampling"
+        MPI OFF
+        GPU ON
+        NUM_PROCS 1
+        RUN_ARGS 1 2 2
+        ENVIRONMENT
+            "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_USE_PC_SAMPLING=ON;OMNITRACE_PC_SAMPLING_INTERVAL=10"
+        SAMPLING_PASS_REGEX "pc-sampling.txt(.*)pc-sampling.json")
+endif()
+
+# -------------------------------------------------------------------------------------- #
+#
+# GPU tracing overhead benchmarks
+#
+# -------------------------------------------------------------------------------------- #
+
+# the results are written to omnitrace-tests-output/<name>/results.{csv,json}. The
+# maximum overhead only catches severe regressions of the dispatch paths since the CI
+# machines are shared
+omnitrace_add_gpu_overhead_benchmark(
+    NAME transpose-gpu-overhead-benchmark
+    TARGET transpose-benchmark
+    LABELS "roctracer;rocprofiler;rocm-smi"
+    SIZES 32 1024
+    STREAMS 1 4
+    INTERVALS 0 100
+    LAUNCHES 5000
+    BACKENDS none roctracer roctracer+perfetto rocm-smi
+    MAX_OVERHEAD 50000
+    TIMEOUT 900)
+
+if(OMNITRACE_USE_ROCPROFILER)
+    omnitrace_add_gpu_overhead_benchmark(
+        NAME transpose-gpu-overhead-benchmark-rocprofiler
+        TARGET transpose-benchmark
+        LABELS "rocprofiler"
+        SIZES 32
+        STREAMS 1
+        LAUNCHES 5000
+        BACKENDS rocprofiler roctracer+rocprofiler
+        TIMEOUT 600)
+endif()
+
+if(OMNITRACE_USE_ROCPROFILER_SDK)
+    omnitrace_add_gpu_overhead_benchmark(
+        NAME transpose-gpu-overhead-benchmark-pc-sampling
+        TARGET transpose-benchmark
+        LABELS "pc-sampling"
+        SIZES 1024
+        STREAMS 1
+        LAUNCHES 5000
+        BACKENDS pc-sampling
+        TIMEOUT 600)
+endif()
+
+if("rccl-tests::all_reduce_perf" IN_LIST RCCL_TEST_TARGETS)
+    omnitrace_add_gpu_overhead_benchmark(
+        NAME rccl-all-reduce-gpu-overhead-benchmark
+        TARGET rccl-tests::all_reduce_perf
+        LABELS "rccl-tests;rcclp"
+        FORMAT rccl-tests
+        SIZES 8 1048576
+        LAUNCHES 1000
+        BACKENDS none rcclp roctracer roctracer+rcclp
+        TIMEOUT 900)
 endif()
@@ -0,0 +1,126 @@
+# -------------------------------------------------------------------------------------- #
+#
+# sampling tests
+#
+# -------------------------------------------------------------------------------------- #
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME parallel-overhead-raw-output
+    TARGET parallel-overhead
+    LABELS "raw-output"
+    RUN_ARGS 30 2 200
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_SAMPLING_FREQ=250;OMNITRACE_RAW_OUTPUT=ON;OMNITRACE_VERBOSE=2"
+    SAMPLING_PASS_REGEX "\\[raw_output\\] Wrote [0-9]+ samples of thread 0"
+    SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
+
+if(TEST parallel-overhead-raw-output-sampling)
+    add_test(
+        NAME parallel-overhead-raw-output-process
+        COMMAND
+            $<TARGET_FILE:omnitrace-process> -v 1 -j 2 -i
+            ${PROJECT_BINARY_DIR}/omnitrace-tests-output/parallel-overhead-raw-output-sampling
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+    set_tests_properties(
+        parallel-overhead-raw-output-process
+        PROPERTIES ENVIRONMENT
+                   "${_test_library_path}"
+                   TIMEOUT
+                   120
+                   LABELS
+                   "parallel-overhead;raw-output"
+                   DEPENDS
+                   parallel-overhead-raw-output-sampling
+                   PASS_REGULAR_EXPRESSION
+                   "Converting the [0-9]+ threads of process.*Outputting '(.*)samples-perfetto-trace(.*).proto'"
+                   FAIL_REGULAR_EXPRESSION
+                   "none of the binaries|(${OMNITRACE_ABORT_FAIL_REGEX})")
+endif()
+
+set(_live_export_environment
+    "${_base_environment}" "OMNITRACE_SAMPLING_FREQ=250" "OMNITRACE_LIVE_EXPORT=ON"
+    "OMNITRACE_LIVE_EXPORT_INTERVAL=0.1" "OMNITRACE_VERBOSE=1")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME parallel-overhead-live-export
+    TARGET parallel-overhead
+    LABELS "live-export"
+    RUN_ARGS 30 2 1000
+    ENVIRONMENT
+        "${_live_export_environment};OMNITRACE_LIVE_EXPORT_NAME=/omnitrace-live-tests-%pid%"
+    SAMPLING_PASS_REGEX
+        "Publishing the live export to the shared memory segment '/omnitrace-live-tests-[0-9]+'.*Removing the shared memory segment '/omnitrace-live-tests-[0-9]+' \\([1-9][0-9]* updates"
+    SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
+
+if(TARGET parallel-overhead AND TARGET omnitrace-live)
+    add_test(
+        NAME parallel-overhead-live-export-reader
+        COMMAND
+            ${CMAKE_CURRENT_LIST_DIR}/run-omnitrace-live.sh
+            $<TARGET_FILE:omnitrace-live> -n omnitrace-live-tests-reader --wait -i 0.25 --
+            $<TARGET_FILE:omnitrace-sample> -- $<TARGET_FILE:parallel-overhead> 30 2 1000
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+    set(_live_export_reader_environment
+        "${_live_export_environment}"
+        "OMNITRACE_LIVE_EXPORT_NAME=/omnitrace-live-tests-reader" "OMNITRACE_CI=ON"
+        "OMNITRACE_OUTPUT_PATH=omnitrace-tests-output"
+        "OMNITRACE_OUTPUT_PREFIX=parallel-overhead-live-export-reader/")
+
+    set_tests_properties(
+        parallel-overhead-live-export-reader
+        PROPERTIES ENVIRONMENT
+                   "${_live_export_reader_environment}"
+                   TIMEOUT
+                   120
+                   LABELS
+                   "parallel-overhead;live-export"
+                   RUN_SERIAL
+                   ON
+                   PASS_REGULAR_EXPRESSION
+                   "omnitrace_live_updates_total\\{pid=\"[0-9]+\"\\} [1-9][0-9]*.*omnitrace_live_finished\\{pid=\"[0-9]+\"\\} 1"
+                   FAIL_REGULAR_EXPRESSION
+                   "unable to read a consistent update|(${OMNITRACE_ABORT_FAIL_REGEX})")
+endif()
+
+# the call-stacks of the samples are merged into a call-graph so the fib frames follow
+# the run frame which called them
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME parallel-overhead-sampling-call-graph
+    TARGET parallel-overhead
+    LABELS "sampling-call-graph"
+    RUN_ARGS 30 2 200
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_TRACE=OFF;OMNITRACE_SAMPLING_FREQ=250;OMNITRACE_COUT_OUTPUT=ON;OMNITRACE_SAMPLING_KEEP_INTERNAL=OFF"
+    SAMPLING_PASS_REGEX ">>> (.*)\\|_run(.*)>>> (.*)\\|_fib(.*)>>> (.*)\\|_fib"
+    SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME parallel-overhead-parallel-merge
+    TARGET parallel-overhead
+    LABELS "parallel-finalize"
+    RUN_ARGS 30 4 200
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_SAMPLING_FREQ=250;OMNITRACE_COLLAPSE_THREADS=ON;OMNITRACE_PARALLEL_FINALIZE=ON;OMNITRACE_THREAD_POOL_SIZE=4;OMNITRACE_VERBOSE=1"
+    SAMPLING_PASS_REGEX
+        "Merging the thread data of [1-9][0-9]* timemory components(.*)Outputting '(.*)sampling_wall_clock.txt'"
+    SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
+
+# the remainder of the samples is written as the last snapshot during the finalization
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME parallel-overhead-sampling-snapshot
+    TARGET parallel-overhead
+    LABELS "sampling-snapshot"
+    RUN_ARGS 30 2 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_SAMPLING_FREQ=250;OMNITRACE_SAMPLING_SNAPSHOT_INTERVAL=0.1;OMNITRACE_VERBOSE=1"
+    SAMPLING_PASS_REGEX
+        "Writing a snapshot of the sampling profile every 0.100 seconds(.*)Writing snapshot 0 of the sampling profile \\([1-9][0-9]* threads(.*)Writing snapshot 1 of the sampling profile"
+    SAMPLING_FAIL_REGEX
+        "writing the sampling snapshot [0-9]+ failed|OMNITRACE_ABORT_FAIL_REGEX")
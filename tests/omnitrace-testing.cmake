@@ -1030,3 +1030,143 @@ function(OMNITRACE_ADD_VALIDATION_TEST)
                        ${TEST_PROPERTIES})
     endforeach()
 endfunction()
+
+# -------------------------------------------------------------------------------------- #
+#
+# Finalization benchmark test function
+#
+# -------------------------------------------------------------------------------------- #
+
+function(OMNITRACE_ADD_FINALIZE_BENCHMARK)
+
+    if(NOT OMNITRACE_VALIDATION_PYTHON)
+        return()
+    endif()
+
+    cmake_parse_arguments(
+        TEST "" "NAME;TARGET;TIMEOUT;SAMPLING_FREQ"
+        "THREADS;DURATIONS;BACKENDS;ENVIRONMENT;LABELS;PROPERTIES;RUN_ARGS" ${ARGN})
+
+    if(NOT TARGET ${TEST_TARGET})
+        return()
+    endif()
+
+    if(NOT TEST_TIMEOUT)
+        set(TEST_TIMEOUT 600)
+    endif()
+
+    if(NOT TEST_SAMPLING_FREQ)
+        set(TEST_SAMPLING_FREQ 100)
+    endif()
+
+    omnitrace_adjust_timeout_for_sanitizer(TEST_TIMEOUT)
+
+    # threads beyond the maximum number of supported threads are not recorded
+    set(_THREADS)
+    foreach(_NUM ${TEST_THREADS})
+        if(_NUM LESS OMNITRACE_MAX_THREADS)
+            list(APPEND _THREADS ${_NUM})
+        endif()
+    endforeach()
+
+    add_test(
+        NAME ${TEST_NAME}
+        COMMAND
+            ${OMNITRACE_VALIDATION_PYTHON}
+            ${CMAKE_CURRENT_LIST_DIR}/run-finalize-benchmark.py -p
+            $<TARGET_FILE:omnitrace-dl-library> -t ${_THREADS} -d ${TEST_DURATIONS} -b
+            ${TEST_BACKENDS} -f ${TEST_SAMPLING_FREQ} -T ${TEST_TIMEOUT} -o
+            ${PROJECT_BINARY_DIR}/omnitrace-tests-output/${TEST_NAME} --
+            $<TARGET_FILE:${TEST_TARGET}> ${TEST_RUN_ARGS}
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+    set_tests_properties(
+        ${TEST_NAME}
+        PROPERTIES ENVIRONMENT
+                   "${_test_library_path};${TEST_ENVIRONMENT}"
+                   TIMEOUT
+                   ${TEST_TIMEOUT}
+                   LABELS
+                   "finalize;benchmark;${TEST_LABELS}"
+                   PASS_REGULAR_EXPRESSION
+                   "Outputting '.*/results.json'.*[0-9]+ runs completed"
+                   RUN_SERIAL
+                   ON
+                   ${TEST_PROPERTIES})
+endfunction()
+
+# -------------------------------------------------------------------------------------- #
+#
+# GPU tracing overhead benchmark test function
+#
+# -------------------------------------------------------------------------------------- #
+
+function(OMNITRACE_ADD_GPU_OVERHEAD_BENCHMARK)
+
+    if(NOT OMNITRACE_VALIDATION_PYTHON OR NOT _VALID_GPU)
+        return()
+    endif()
+
+    cmake_parse_arguments(
+        TEST "" "NAME;TARGET;TIMEOUT;FORMAT;LAUNCHES;REPEAT;MAX_OVERHEAD"
+        "SIZES;STREAMS;INTERVALS;BACKENDS;ENVIRONMENT;LABELS;PROPERTIES;RUN_ARGS"
+        ${ARGN})
+
+    if(NOT TARGET ${TEST_TARGET})
+        return()
+    endif()
+
+    if(NOT TEST_TIMEOUT)
+        set(TEST_TIMEOUT 600)
+    endif()
+
+    if(NOT TEST_FORMAT)
+        set(TEST_FORMAT transpose)
+    endif()
+
+    if(NOT TEST_LAUNCHES)
+        set(TEST_LAUNCHES 10000)
+    endif()
+
+    if(NOT TEST_REPEAT)
+        set(TEST_REPEAT 3)
+    endif()
+
+    omnitrace_adjust_timeout_for_sanitizer(TEST_TIMEOUT)
+
+    set(_ARGS -F ${TEST_FORMAT} -l ${TEST_LAUNCHES} -r ${TEST_REPEAT})
+    foreach(_OPT SIZES STREAMS INTERVALS BACKENDS)
+        string(TOLOWER "${_OPT}" _LOPT)
+        if(TEST_${_OPT})
+            list(APPEND _ARGS --${_LOPT} ${TEST_${_OPT}})
+        endif()
+    endforeach()
+
+    if(TEST_MAX_OVERHEAD)
+        list(APPEND _ARGS -m ${TEST_MAX_OVERHEAD})
+    endif()
+
+    add_test(
+        NAME ${TEST_NAME}
+        COMMAND
+            ${OMNITRACE_VALIDATION_PYTHON}
+            ${CMAKE_CURRENT_LIST_DIR}/run-gpu-overhead-benchmark.py -p
+            $<TARGET_FILE:omnitrace-dl-library> ${_ARGS} -T ${TEST_TIMEOUT} -o
+            ${PROJECT_BINARY_DIR}/omnitrace-tests-output/${TEST_NAME} --
+            $<TARGET_FILE:${TEST_TARGET}> ${TEST_RUN_ARGS}
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+    set_tests_properties(
+        ${TEST_NAME}
+        PROPERTIES ENVIRONMENT
+                   "${_test_library_path};${TEST_ENVIRONMENT}"
+                   TIMEOUT
+                   ${TEST_TIMEOUT}
+                   LABELS
+                   "gpu;benchmark;${TEST_LABELS}"
+                   PASS_REGULAR_EXPRESSION
+                   "Outputting '.*/results.json'.*[0-9]+ runs completed"
+                   RUN_SERIAL
+                   ON
+                   ${TEST_PROPERTIES})
+endfunction()
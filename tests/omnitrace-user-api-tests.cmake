@@ -29,3 +29,144 @@ omnitrace_add_test(
     SAMPLING_PASS_REGEX "Pushing custom region :: run.10. x 1000"
     BASELINE_FAIL_REGEX "Pushing custom region"
     REWRITE_FAIL_REGEX "0 instrumented loops in procedure")
+
+set(_flight_recorder_environment
+    "${_base_environment}"
+    "OMNITRACE_FLIGHT_RECORDER=ON"
+    "OMNITRACE_FLIGHT_RECORDER_LATENCY_THRESHOLD=0.001")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME user-api-flight-recorder
+    TARGET user-api
+    LABELS "loops;perfetto"
+    REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+    RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_flight_recorder_environment}"
+    REWRITE_RUN_PASS_REGEX "perfetto-trace-dump-0.proto"
+    RUNTIME_PASS_REGEX "perfetto-trace-dump-0.proto")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME user-api-counters
+    TARGET user-api
+    LABELS "loops;perfetto"
+    REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+    RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_base_environment};OMNITRACE_VERBOSE=1"
+    REWRITE_RUN_PASS_REGEX "Post-processed [0-9]+ records of 1 user counters"
+    RUNTIME_PASS_REGEX "Post-processed [0-9]+ records of 1 user counters")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME user-api-timeline-profile
+    TARGET user-api
+    LABELS "loops;timemory"
+    REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+    RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_TIMELINE_PROFILE=ON;OMNITRACE_TIMELINE_PROFILE_COMPACT=ON"
+    REWRITE_RUN_PASS_REGEX "Writing [0-9]+ timeline profile instances"
+    RUNTIME_PASS_REGEX "Writing [0-9]+ timeline profile instances")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME user-api-columnar-output
+    TARGET user-api
+    LABELS "loops;timemory"
+    REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+    RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_COLUMNAR_OUTPUT=ON"
+    REWRITE_RUN_PASS_REGEX "Outputting '(.*)profile.columnar'"
+    RUNTIME_PASS_REGEX "Outputting '(.*)profile.columnar'")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME user-api-perfetto-deferred
+    TARGET user-api
+    LABELS "loops;perfetto"
+    REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+    RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_VERBOSE=1;OMNITRACE_PERFETTO_DEFERRED_REGIONS=ON"
+    REWRITE_RUN_PASS_REGEX "encoded the deferred regions of [0-9]+ threads"
+    RUNTIME_PASS_REGEX "encoded the deferred regions of [0-9]+ threads")
+
+set(_perfetto_streaming_environment
+    "${_base_environment}" "OMNITRACE_PERFETTO_STREAMING=ON"
+    "OMNITRACE_PERFETTO_FLUSH_PERIOD=100")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING
+    NAME user-api-perfetto-streaming
+    TARGET user-api
+    LABELS "loops;perfetto"
+    REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+    RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_perfetto_streaming_environment}"
+    REWRITE_RUN_PASS_REGEX "perfetto-trace.proto' \\(streamed\\)"
+    RUNTIME_PASS_REGEX "perfetto-trace.proto' \\(streamed\\)")
+
+set(_perf_events_environment
+    "${_base_environment}" "OMNITRACE_PERF_EVENTS=PERF_COUNT_SW_TASK_CLOCK"
+    "OMNITRACE_PERF_EVENTS_REGIONS=ON")
+
+if(omnitrace_perf_event_paranoid LESS_EQUAL 3
+   OR omnitrace_cap_sys_admin EQUAL 0
+   OR omnitrace_cap_perfmon EQUAL 0)
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_SAMPLING
+        NAME user-api-perf-events
+        TARGET user-api
+        LABELS "loops;perf"
+        REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+        RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+        RUN_ARGS 10 ${NUM_THREADS} 1000
+        ENVIRONMENT "${_perf_events_environment}"
+        REWRITE_RUN_PASS_REGEX "perf_counters.txt"
+        RUNTIME_PASS_REGEX "perf_counters.txt")
+
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_SAMPLING
+        NAME user-api-perf-events-rotation
+        TARGET user-api
+        LABELS "loops;perf"
+        REWRITE_ARGS -e -v 2 -l --min-instructions=8 -E custom_push_region
+        RUNTIME_ARGS -e -v 1 -l --min-instructions=8 -E custom_push_region
+        RUN_ARGS 10 ${NUM_THREADS} 1000
+        ENVIRONMENT
+            "${_base_environment}"
+            "OMNITRACE_PERF_EVENTS=PERF_COUNT_SW_TASK_CLOCK PERF_COUNT_SW_CPU_CLOCK PERF_COUNT_SW_PAGE_FAULTS"
+            "OMNITRACE_PERF_EVENTS_REGIONS=ON"
+            "OMNITRACE_PERF_EVENTS_GROUP_SIZE=1"
+            "OMNITRACE_PERF_EVENTS_ROTATION_INTERVAL=1"
+        REWRITE_RUN_PASS_REGEX "perf_counters.txt"
+        RUNTIME_PASS_REGEX "perf_counters.txt")
+endif()
+
+set(_dl_lazy_environment "${_base_environment}" "OMNITRACE_DL_LAZY=ON"
+                         "OMNITRACE_DL_VERBOSE=1")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME user-api-dl-lazy
+    TARGET user-api
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_dl_lazy_environment}"
+    SAMPLING_PASS_REGEX "loading libomnitrace is deferred"
+    SAMPLING_FAIL_REGEX "Outputting|(${OMNITRACE_ABORT_FAIL_REGEX})")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_REWRITE SKIP_RUNTIME
+    NAME user-api-dl-lazy-command
+    TARGET user-api
+    RUN_ARGS 10 ${NUM_THREADS} 1000
+    ENVIRONMENT "${_dl_lazy_environment};OMNITRACE_DL_LAZY_COMMAND=user-api"
+    SAMPLING_PASS_REGEX "matches OMNITRACE_DL_LAZY_COMMAND"
+    SAMPLING_FAIL_REGEX "(${OMNITRACE_ABORT_FAIL_REGEX})")
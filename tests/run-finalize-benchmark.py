@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+
+import os
+import re
+import sys
+import json
+import shutil
+import argparse
+import tempfile
+import threading
+import itertools
+import subprocess
+
+# maps the backend names of --backends to the setting which enables them
+backend_settings = {
+    "sampling": "OMNITRACE_USE_SAMPLING",
+    "perfetto": "OMNITRACE_TRACE",
+    "timemory": "OMNITRACE_PROFILE",
+    "process-sampling": "OMNITRACE_USE_PROCESS_SAMPLING",
+}
+
+phases_regex = re.compile(r"Finalize phases \(msec\): (.*) \(total: ([0-9.]+)\)")
+
+
+def parse_phases(output):
+    """returns the duration of each finalization phase and the total or None if the
+    finalization phases were not reported"""
+    _match = None
+    for _match in phases_regex.finditer(output):
+        pass
+    if _match is None:
+        return None
+
+    phases = {}
+    for itr in _match.group(1).split(", "):
+        name, value = itr.split("=")
+        # overlapping post-processing phases with the same name are accumulated
+        phases[name] = phases.get(name, 0.0) + float(value)
+    return phases, float(_match.group(2))
+
+
+def run(args, nthreads, duration, backends, output_path):
+    env = dict(os.environ)
+    env.update(
+        {
+            "LD_PRELOAD": ":".join(
+                [args.preload] + ([env["LD_PRELOAD"]] if "LD_PRELOAD" in env else [])
+            ),
+            "OMNITRACE_VERBOSE": "1",
+            "OMNITRACE_CI": "OFF",
+            "OMNITRACE_TIME_OUTPUT": "OFF",
+            "OMNITRACE_USE_PID": "OFF",
+            "OMNITRACE_SAMPLING_FREQ": f"{args.sampling_freq}",
+            "OMNITRACE_OUTPUT_PATH": output_path,
+        }
+    )
+    for name, setting in backend_settings.items():
+        env[setting] = "ON" if name in backends else "OFF"
+
+    cmd = args.command + [f"{nthreads}", f"{duration}"]
+    if args.verbose:
+        print(" ".join(cmd), flush=True)
+
+    # the child is reaped with wait4 to obtain its peak RSS
+    with tempfile.TemporaryFile(mode="w+") as log:
+        proc = subprocess.Popen(cmd, env=env, stdout=log, stderr=subprocess.STDOUT)
+        timer = threading.Timer(args.timeout, proc.kill)
+        timer.start()
+        try:
+            _, status, rusage = os.wait4(proc.pid, 0)
+        finally:
+            timer.cancel()
+        if os.WIFSIGNALED(status):
+            proc.returncode = -os.WTERMSIG(status)
+        else:
+            proc.returncode = os.WEXITSTATUS(status)
+        log.seek(0)
+        output = log.read()
+
+    if args.verbose > 1:
+        print(output, flush=True)
+
+    result = {
+        "threads": nthreads,
+        "duration_msec": duration,
+        "samples_per_thread": int(duration * args.sampling_freq / 1000),
+        "backends": "+".join(backends) if backends else "none",
+        "returncode": proc.returncode,
+        "peak_rss_mb": rusage.ru_maxrss / 1024.0,
+    }
+
+    phases = parse_phases(output)
+    if phases is not None:
+        result["phases_msec"] = phases[0]
+        result["total_msec"] = phases[1]
+    elif proc.returncode == 0:
+        result["returncode"] = -1
+        print(output, file=sys.stderr, flush=True)
+        print(
+            "[run-finalize-benchmark] finalization phases were not reported",
+            file=sys.stderr,
+        )
+    else:
+        print(output, file=sys.stderr, flush=True)
+
+    return result
+
+
+def write_results(results, prefix):
+    phases = []
+    for itr in results:
+        for name in itr.get("phases_msec", {}).keys():
+            if name not in phases:
+                phases.append(name)
+
+    columns = [
+        "threads",
+        "duration_msec",
+        "samples_per_thread",
+        "backends",
+        "returncode",
+        "peak_rss_mb",
+        "total_msec",
+    ]
+
+    with open(f"{prefix}.csv", "w") as ofs:
+        ofs.write(",".join(columns + [f"{itr}_msec" for itr in phases]) + "\n")
+        for itr in results:
+            row = [f"{itr.get(c, '')}" for c in columns]
+            row += [f"{itr.get('phases_msec', {}).get(p, '')}" for p in phases]
+            ofs.write(",".join(row) + "\n")
+    print(f"[run-finalize-benchmark] Outputting '{prefix}.csv'...")
+
+    with open(f"{prefix}.json", "w") as ofs:
+        json.dump({"finalize_benchmark": results}, ofs, indent=2)
+    print(f"[run-finalize-benchmark] Outputting '{prefix}.json'...")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Measures the duration of each phase of the finalization for "
+        "every combination of the thread counts, durations and backends. The command "
+        "is invoked with the number of threads and the duration in milliseconds "
+        "appended to the arguments, e.g. finalize-scaling"
+    )
+    parser.add_argument(
+        "-p", "--preload", type=str, help="Path to libomnitrace-dl.so", required=True
+    )
+    parser.add_argument(
+        "-t", "--threads", nargs="+", type=int, help="Thread counts", default=[1, 8]
+    )
+    parser.add_argument(
+        "-d",
+        "--durations",
+        nargs="+",
+        type=int,
+        help="Durations of the work of each thread in milliseconds",
+        default=[500],
+    )
+    parser.add_argument(
+        "-b",
+        "--backends",
+        nargs="+",
+        type=str,
+        help="Combinations of {} joined with '+', e.g. sampling+perfetto".format(
+            ", ".join(backend_settings.keys())
+        ),
+        default=["sampling+perfetto+timemory"],
+    )
+    parser.add_argument(
+        "-f", "--sampling-freq", type=int, help="Sampling frequency", default=100
+    )
+    parser.add_argument(
+        "-o",
+        "--output",
+        type=str,
+        help="Output directory of the results. The output of the tool for each run "
+        "is written to subdirectories",
+        default="finalize-benchmark",
+    )
+    parser.add_argument(
+        "-T", "--timeout", type=int, help="Timeout of each run in seconds", default=600
+    )
+    parser.add_argument("-v", "--verbose", action="count", default=0)
+    parser.add_argument("command", nargs="+", help="Command to execute")
+
+    args = parser.parse_args()
+
+    backends = []
+    for itr in args.backends:
+        _backends = [] if itr == "none" else itr.split("+")
+        for bitr in _backends:
+            if bitr not in backend_settings:
+                raise ValueError(f"Unknown backend '{bitr}' in '{itr}'")
+        backends.append(_backends)
+
+    os.makedirs(args.output, exist_ok=True)
+
+    results = []
+    for nthreads, duration, _backends in itertools.product(
+        args.threads, args.durations, backends
+    ):
+        _name = "{}-threads-{}-msec-{}".format(
+            nthreads, duration, "+".join(_backends) if _backends else "none"
+        )
+        _output_path = os.path.join(args.output, _name)
+        shutil.rmtree(_output_path, ignore_errors=True)
+
+        result = run(args, nthreads, duration, _backends, _output_path)
+        results.append(result)
+        print(
+            "[run-finalize-benchmark] {:>4} threads :: {:>6} msec :: {:<40} :: "
+            "finalize = {} msec :: peak RSS = {:.1f} MB".format(
+                nthreads,
+                duration,
+                result["backends"],
+                result.get("total_msec", "?"),
+                result["peak_rss_mb"],
+            ),
+            flush=True,
+        )
+
+    write_results(results, os.path.join(args.output, "results"))
+
+    nfailed = len([itr for itr in results if itr["returncode"] != 0])
+    if nfailed > 0:
+        print(f"[run-finalize-benchmark] {nfailed} of {len(results)} runs failed")
+        sys.exit(1)
+
+    print(f"[run-finalize-benchmark] {len(results)} runs completed")
@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+
+import os
+import re
+import sys
+import json
+import shutil
+import argparse
+import statistics
+import subprocess
+
+# maps the backend names of --backends to the settings which enable them. Every
+# setting of every backend is OFF unless the backend is in the combination
+backend_settings = {
+    "roctracer": {"OMNITRACE_USE_ROCTRACER": "ON"},
+    "rocprofiler": {
+        "OMNITRACE_USE_ROCPROFILER": "ON",
+        "OMNITRACE_ROCM_EVENTS": "GRBM_COUNT",
+    },
+    "rocm-smi": {"OMNITRACE_USE_PROCESS_SAMPLING": "ON", "OMNITRACE_USE_ROCM_SMI": "ON"},
+    "rcclp": {"OMNITRACE_USE_RCCLP": "ON"},
+    "pc-sampling": {"OMNITRACE_USE_PC_SAMPLING": "ON"},
+    "perfetto": {"OMNITRACE_TRACE": "ON"},
+    "timemory": {"OMNITRACE_PROFILE": "ON"},
+}
+
+transpose_regex = re.compile(
+    r"\[transpose-benchmark\] Dispatches: ([0-9]+), elapsed: ([0-9.]+) nsec"
+)
+
+
+def parse_transpose(output, args, size):
+    """returns the number of dispatches and the elapsed nsec printed by
+    transpose-benchmark"""
+    _match = None
+    for _match in transpose_regex.finditer(output):
+        pass
+    if _match is None:
+        return None
+    return int(_match.group(1)), float(_match.group(2))
+
+
+def parse_rccl_tests(output, args, size):
+    """returns the number of collectives and the elapsed nsec of the out-of-place
+    collectives of the row of the message size in the table of rccl-tests"""
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) < 6 or fields[0] != f"{size}":
+            continue
+        # the columns between the type and the time depend on the collective
+        for itr in fields[3:]:
+            if re.match(r"^[0-9]+\.[0-9]+$", itr):
+                return args.launches, float(itr) * 1000.0 * args.launches
+    return None
+
+
+formats = {
+    "transpose": parse_transpose,
+    "rccl-tests": parse_rccl_tests,
+}
+
+
+def get_command(args, size, streams, interval):
+    if args.format == "rccl-tests":
+        # the collectives of rccl-tests are not launched at an interval or on
+        # multiple streams
+        return args.command + [
+            "-b",
+            f"{size}",
+            "-e",
+            f"{size}",
+            "-g",
+            "1",
+            "-n",
+            f"{args.launches}",
+            "-w",
+            "5",
+        ]
+    return args.command + [f"{size}", f"{streams}", f"{args.launches}", f"{interval}"]
+
+
+def run(args, cmd, size, backends, output_path):
+    """returns the median of the dispatches and elapsed nsec of the repetitions or
+    None if a run failed. None of the backends means without omnitrace"""
+    env = dict(os.environ)
+    if backends is not None:
+        env.update(
+            {
+                "LD_PRELOAD": ":".join(
+                    [args.preload]
+                    + ([env["LD_PRELOAD"]] if "LD_PRELOAD" in env else [])
+                ),
+                "OMNITRACE_VERBOSE": "0",
+                "OMNITRACE_CI": "OFF",
+                "OMNITRACE_TIME_OUTPUT": "OFF",
+                "OMNITRACE_USE_PID": "OFF",
+                "OMNITRACE_USE_SAMPLING": "OFF",
+                "OMNITRACE_OUTPUT_PATH": output_path,
+            }
+        )
+        for name, settings in backend_settings.items():
+            for key, value in settings.items():
+                if name in backends:
+                    env[key] = value
+                elif value == "ON":
+                    env[key] = "OFF"
+                else:
+                    env.pop(key, None)
+
+    if args.verbose:
+        print(" ".join(cmd), flush=True)
+
+    results = []
+    for _ in range(args.repeat):
+        try:
+            proc = subprocess.run(
+                cmd,
+                env=env,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.STDOUT,
+                universal_newlines=True,
+                timeout=args.timeout,
+            )
+        except subprocess.TimeoutExpired:
+            print(f"[run-gpu-overhead-benchmark] '{' '.join(cmd)}' timed out")
+            return None
+
+        if args.verbose > 1:
+            print(proc.stdout, flush=True)
+
+        _result = formats[args.format](proc.stdout, args, size)
+        if proc.returncode != 0 or _result is None:
+            print(proc.stdout, file=sys.stderr, flush=True)
+            print(
+                "[run-gpu-overhead-benchmark] run failed with exit code {}{}".format(
+                    proc.returncode, "" if _result else " (no timing in the output)"
+                ),
+                file=sys.stderr,
+            )
+            return None
+        results.append(_result)
+
+    return results[0][0], statistics.median([itr[1] for itr in results])
+
+
+def write_results(results, prefix):
+    columns = [
+        "size",
+        "streams",
+        "interval_usec",
+        "backends",
+        "dispatches",
+        "elapsed_nsec",
+        "nsec_per_dispatch",
+        "overhead_nsec_per_dispatch",
+        "throughput_loss_percent",
+    ]
+
+    with open(f"{prefix}.csv", "w") as ofs:
+        ofs.write(",".join(columns) + "\n")
+        for itr in results:
+            ofs.write(",".join([f"{itr.get(c, '')}" for c in columns]) + "\n")
+    print(f"[run-gpu-overhead-benchmark] Outputting '{prefix}.csv'...")
+
+    with open(f"{prefix}.json", "w") as ofs:
+        json.dump({"gpu_overhead_benchmark": results}, ofs, indent=2)
+    print(f"[run-gpu-overhead-benchmark] Outputting '{prefix}.json'...")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Measures the overhead of the GPU backends of omnitrace on a "
+        "launch-bound application for every combination of the kernel sizes, stream "
+        "counts, launch intervals and backends. Every combination is compared with a "
+        "run without omnitrace. With the transpose format, the command is invoked with "
+        "the size, the number of streams, the number of launches per stream and the "
+        "launch interval in microseconds appended to the arguments, e.g. "
+        "transpose-benchmark. With the rccl-tests format, the arguments of the "
+        "message size and the number of iterations of rccl-tests are appended instead"
+    )
+    parser.add_argument(
+        "-p", "--preload", type=str, help="Path to libomnitrace-dl.so", required=True
+    )
+    parser.add_argument(
+        "-F",
+        "--format",
+        type=str,
+        choices=list(formats.keys()),
+        help="Format of the output of the command",
+        default="transpose",
+    )
+    parser.add_argument(
+        "-s",
+        "--sizes",
+        nargs="+",
+        type=int,
+        help="Sizes of the kernels (rows of the matrix) or of the messages (bytes)",
+        default=[32, 1024],
+    )
+    parser.add_argument(
+        "-n", "--streams", nargs="+", type=int, help="Stream counts", default=[1, 4]
+    )
+    parser.add_argument(
+        "-i",
+        "--intervals",
+        nargs="+",
+        type=int,
+        help="Intervals between the launches in microseconds (launch rates), zero "
+        "launches back-to-back",
+        default=[0],
+    )
+    parser.add_argument(
+        "-l",
+        "--launches",
+        type=int,
+        help="Launches per stream (iterations of rccl-tests)",
+        default=10000,
+    )
+    parser.add_argument(
+        "-b",
+        "--backends",
+        nargs="+",
+        type=str,
+        help="Combinations of {} joined with '+', e.g. roctracer+perfetto. 'none' "
+        "preloads omnitrace with every backend disabled".format(
+            ", ".join(backend_settings.keys())
+        ),
+        default=["none", "roctracer", "rocprofiler", "rocm-smi"],
+    )
+    parser.add_argument(
+        "-r", "--repeat", type=int, help="Repetitions of each run (median)", default=3
+    )
+    parser.add_argument(
+        "-m",
+        "--max-overhead",
+        type=float,
+        help="Fail when the overhead of a back-to-back dispatch exceeds this many "
+        "nanoseconds",
+        default=None,
+    )
+    parser.add_argument(
+        "-o",
+        "--output",
+        type=str,
+        help="Output directory of the results. The output of the tool for each run "
+        "is written to subdirectories",
+        default="gpu-overhead-benchmark",
+    )
+    parser.add_argument(
+        "-T", "--timeout", type=int, help="Timeout of each run in seconds", default=600
+    )
+    parser.add_argument("-v", "--verbose", action="count", default=0)
+    parser.add_argument("command", nargs="+", help="Command to execute")
+
+    args = parser.parse_args()
+
+    backends = []
+    for itr in args.backends:
+        _backends = [] if itr == "none" else itr.split("+")
+        for bitr in _backends:
+            if bitr not in backend_settings:
+                raise ValueError(f"Unknown backend '{bitr}' in '{itr}'")
+        backends.append(_backends)
+
+    # rccl-tests only sweeps the message sizes
+    if args.format == "rccl-tests":
+        args.streams = [1]
+        args.intervals = [0]
+
+    os.makedirs(args.output, exist_ok=True)
+
+    results = []
+    nfailed = 0
+    nexceeded = 0
+    for size in args.sizes:
+        for streams in args.streams:
+            for interval in args.intervals:
+                cmd = get_command(args, size, streams, interval)
+                baseline = run(args, cmd, size, None, None)
+                if baseline is None:
+                    nfailed += 1
+                    continue
+
+                for _backends in [None] + backends:
+                    _label = (
+                        "baseline"
+                        if _backends is None
+                        else ("+".join(_backends) if _backends else "none")
+                    )
+                    _name = f"{size}-size-{streams}-streams-{interval}-usec-{_label}"
+                    _output_path = os.path.join(args.output, _name)
+                    shutil.rmtree(_output_path, ignore_errors=True)
+
+                    _timing = (
+                        baseline
+                        if _backends is None
+                        else run(args, cmd, size, _backends, _output_path)
+                    )
+                    if _timing is None:
+                        nfailed += 1
+                        continue
+
+                    dispatches, elapsed = _timing
+                    overhead = (elapsed - baseline[1]) / max(dispatches, 1)
+                    loss = 100.0 * (1.0 - baseline[1] / elapsed) if elapsed > 0 else 0.0
+                    results.append(
+                        {
+                            "size": size,
+                            "streams": streams,
+                            "interval_usec": interval,
+                            "backends": _label,
+                            "dispatches": dispatches,
+                            "elapsed_nsec": elapsed,
+                            "nsec_per_dispatch": elapsed / max(dispatches, 1),
+                            "overhead_nsec_per_dispatch": overhead,
+                            "throughput_loss_percent": loss,
+                        }
+                    )
+                    print(
+                        "[run-gpu-overhead-benchmark] size = {:>8} :: streams = {:>3} "
+                        ":: interval = {:>5} usec :: {:<32} :: {:>10.1f} nsec/dispatch "
+                        ":: overhead = {:>10.1f} nsec/dispatch :: throughput loss = "
+                        "{:>6.2f}%".format(
+                            size,
+                            streams,
+                            interval,
+                            _label,
+                            elapsed / max(dispatches, 1),
+                            overhead,
+                            loss,
+                        ),
+                        flush=True,
+                    )
+
+                    if (
+                        args.max_overhead is not None
+                        and interval == 0
+                        and overhead > args.max_overhead
+                    ):
+                        nexceeded += 1
+                        print(
+                            "[run-gpu-overhead-benchmark] overhead of {} exceeds {} "
+                            "nsec/dispatch".format(_label, args.max_overhead)
+                        )
+
+    write_results(results, os.path.join(args.output, "results"))
+
+    if nfailed > 0:
+        print(f"[run-gpu-overhead-benchmark] {nfailed} runs failed")
+        sys.exit(1)
+
+    if nexceeded > 0:
+        print(f"[run-gpu-overhead-benchmark] {nexceeded} runs exceeded the overhead")
+        sys.exit(1)
+
+    print(f"[run-gpu-overhead-benchmark] {len(results)} runs completed")
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# usage: run-omnitrace-emergency-dump.sh <emergency-dump.bin> -- <application>
+#
+# runs the application, which is expected to be terminated by a fatal signal, and
+# checks that the emergency dump was written
+
+DUMP_FILE=${1}
+shift
+
+if [ "${1}" == "--" ]; then
+    shift
+fi
+
+rm -f ${DUMP_FILE}
+
+${@}
+RET=$?
+
+echo "Application exited with code: ${RET}"
+
+if [ ! -s "${DUMP_FILE}" ]; then
+    echo "Error! '${DUMP_FILE}' was not written"
+    exit 1
+fi
+
+if [ "$(head -c 7 ${DUMP_FILE})" != "OMNIDMP" ]; then
+    echo "Error! '${DUMP_FILE}' is not an emergency dump"
+    exit 1
+fi
+
+echo "Emergency dump: ${DUMP_FILE} ($(stat -c %s ${DUMP_FILE}) bytes)"
+exit 0
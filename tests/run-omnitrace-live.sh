@@ -0,0 +1,49 @@
+#!/bin/bash
+
+# usage: run-omnitrace-live.sh <omnitrace-live> <options> -- <application>
+#
+# launches the application in the background and reads its live export with
+# omnitrace-live until the application publishes its final update
+
+cleanup()
+{
+    kill -s 9 ${_PID}
+}
+
+trap cleanup SIGABRT SIGQUIT
+
+LIVE_COMMAND=""
+
+while [[ $# -gt 0 ]]
+do
+    if [ "${1}" == "--" ]; then
+        shift
+        break
+    else
+        LIVE_COMMAND="${LIVE_COMMAND}${1} "
+        shift
+    fi
+done
+
+${@} &
+_PID=$!
+
+if [ "${_PID}" = "" ]; then
+    echo "Error! No PID for \"${@}\""
+    exit -1
+fi
+
+echo "PID: ${_PID}"
+echo ""
+
+${LIVE_COMMAND}
+RET=$?
+
+wait ${_PID}
+APP_RET=$?
+
+echo "Exiting with code: ${RET} (application: ${APP_RET})"
+if [ "${RET}" -ne 0 ]; then
+    exit ${RET}
+fi
+exit ${APP_RET}
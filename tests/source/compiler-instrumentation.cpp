@@ -0,0 +1,37 @@
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" __attribute__((noinline)) long
+ci_inner(long n)
+{
+    return (n < 2) ? n : ci_inner(n - 1) + ci_inner(n - 2);
+}
+
+extern "C" __attribute__((noinline)) long
+ci_outer(long n, long nitr)
+{
+    long _v = 0;
+    for(long i = 0; i < nitr; ++i)
+        _v += ci_inner(n);
+    return _v;
+}
+
+int
+main(int argc, char** argv)
+{
+    long nfib = 10;
+    long nitr = 100;
+    long nrep = 4;
+
+    if(argc > 1) nfib = atol(argv[1]);
+    if(argc > 2) nitr = atol(argv[2]);
+    if(argc > 3) nrep = atol(argv[3]);
+
+    long _v = 0;
+    for(long i = 0; i < nrep; ++i)
+        _v += ci_outer(nfib, nitr);
+
+    printf("[compiler-instrumentation] fibonacci(%li) x %li x %li = %li\n", nfib, nitr,
+           nrep, _v);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+long
+fib(long n)
+{
+    return (n < 2) ? n : fib(n - 1) + fib(n - 2);
+}
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    long nfib    = 35;
+    long nthread = 2;
+    int  signum  = SIGTERM;
+
+    if(argc > 1) nfib = atol(argv[1]);
+    if(argc > 2) nthread = atol(argv[2]);
+    if(argc > 3) signum = atoi(argv[3]);
+
+    auto threads = std::vector<std::thread>{};
+    for(long i = 0; i < nthread; ++i)
+        threads.emplace_back([nfib]() { (void) fib(nfib); });
+    for(auto& itr : threads)
+        itr.join();
+
+    // the process is terminated before omnitrace is finalized
+    printf("[%s] raising signal %i...\n", _name.c_str(), signum);
+    fflush(stdout);
+    raise(signum);
+
+    return EXIT_SUCCESS;
+}
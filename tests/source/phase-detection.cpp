@@ -0,0 +1,49 @@
+#include <omnitrace/user.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace
+{
+void
+compute(long nmsec)
+{
+    omnitrace_user_push_region("compute");
+    std::this_thread::sleep_for(std::chrono::milliseconds{ nmsec });
+    omnitrace_user_pop_region("compute");
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    long nstep    = 20;
+    long ncompute = 4;
+    long nmsec    = 5;
+
+    if(argc > 1) nstep = atol(argv[1]);
+    if(argc > 2) ncompute = atol(argv[2]);
+    if(argc > 3) nmsec = atol(argv[3]);
+
+    // the step before the last few does four times the work of the other steps so that
+    // it is an outlier iteration of the phase
+    for(long i = 0; i < nstep; ++i)
+    {
+        auto _ncompute = (i == nstep - 4) ? 4 * ncompute : ncompute;
+
+        omnitrace_user_push_region("timestep");
+        for(long j = 0; j < _ncompute; ++j)
+            compute(nmsec);
+        omnitrace_user_pop_region("timestep");
+    }
+
+    printf("[%s] completed %li steps\n", _name.c_str(), nstep);
+    return EXIT_SUCCESS;
+}